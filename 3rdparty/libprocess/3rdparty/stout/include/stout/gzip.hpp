@@ -23,7 +23,6 @@
 #include "try.hpp"
 
 // Compression utilities.
-// TODO(bmahler): Provide streaming compression / decompression as well.
 namespace gzip {
 
 // We use a 16KB buffer with zlib compression / decompression.
@@ -96,6 +95,105 @@ inline Try<std::string> compress(
 }
 
 
+// Compresses a stream of data in pieces, e.g., for compressing a
+// response that gets streamed. The concatenation of the results of
+// all calls to 'compress' followed by 'finish' is a single gzip
+// compressed stream. Note that 'compress' might return an empty
+// string, i.e., when zlib has not produced any output yet.
+class Compressor
+{
+public:
+  explicit Compressor(int level = Z_DEFAULT_COMPRESSION)
+    : finished(false)
+  {
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    // NOTE: An invalid level makes the initialization (and hence
+    // all subsequent calls) fail.
+    initialized = deflateInit2(
+        &stream,
+        level,          // Compression level.
+        Z_DEFLATED,     // Compression method.
+        MAX_WBITS + 16, // Zlib magic for gzip compression / decompression.
+        8,              // Default memLevel value.
+        Z_DEFAULT_STRATEGY) == Z_OK;
+  }
+
+  ~Compressor()
+  {
+    if (initialized) {
+      deflateEnd(&stream);
+    }
+  }
+
+  // Returns the compressed output (if any) for the next piece of
+  // the stream.
+  Try<std::string> compress(const std::string& decompressed)
+  {
+    return deflate(decompressed, Z_NO_FLUSH);
+  }
+
+  // Returns the remaining compressed output, after which no more
+  // data can be compressed.
+  Try<std::string> finish()
+  {
+    Try<std::string> result = deflate("", Z_FINISH);
+    finished = true;
+    return result;
+  }
+
+private:
+  // Not copyable, not assignable.
+  Compressor(const Compressor&);
+  Compressor& operator = (const Compressor&);
+
+  Try<std::string> deflate(const std::string& decompressed, int flush)
+  {
+    if (!initialized) {
+      return Error("Failed to initialize zlib");
+    }
+
+    if (finished) {
+      return Error("Compression has already finished");
+    }
+
+    stream.next_in =
+      const_cast<Bytef*>(reinterpret_cast<const Bytef*>(decompressed.data()));
+    stream.avail_in = decompressed.length();
+
+    // Consume all of the input (and, when finishing, produce all of
+    // the output) one buffer at a time.
+    Bytef buffer[GZIP_BUFFER_SIZE];
+    std::string result = "";
+    int code = Z_OK;
+    do {
+      stream.next_out = buffer;
+      stream.avail_out = GZIP_BUFFER_SIZE;
+      code = ::deflate(&stream, flush);
+
+      if (code != Z_OK && code != Z_STREAM_END && code != Z_BUF_ERROR) {
+        return Error(std::string(stream.msg != NULL ? stream.msg : ""));
+      }
+
+      result.append(
+          reinterpret_cast<char*>(buffer),
+          GZIP_BUFFER_SIZE - stream.avail_out);
+    } while (stream.avail_out == 0 ||
+             (flush == Z_FINISH && code != Z_STREAM_END));
+
+    return result;
+  }
+
+  z_stream_s stream;
+  bool initialized;
+  bool finished;
+};
+
+
 // Returns a gzip decompressed version of the provided string.
 inline Try<std::string> decompress(const std::string& compressed)
 {
@@ -144,6 +242,89 @@ inline Try<std::string> decompress(const std::string& compressed)
   return result;
 }
 
+
+
+// Decompresses a gzip compressed stream in pieces, e.g., for
+// decompressing a response while it is being streamed. Note that
+// 'decompress' might return an empty string, i.e., when zlib has not
+// produced any output yet.
+class Decompressor
+{
+public:
+  Decompressor() : done(false)
+  {
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    initialized = inflateInit2(
+        &stream,
+        MAX_WBITS + 16) == Z_OK; // Zlib magic for gzip decompression.
+  }
+
+  ~Decompressor()
+  {
+    if (initialized) {
+      inflateEnd(&stream);
+    }
+  }
+
+  // Returns the decompressed output (if any) for the next piece of
+  // the compressed stream.
+  Try<std::string> decompress(const std::string& compressed)
+  {
+    if (!initialized) {
+      return Error("Failed to initialize zlib");
+    }
+
+    if (done) {
+      return Error("Decompression has already finished");
+    }
+
+    stream.next_in =
+      const_cast<Bytef*>(reinterpret_cast<const Bytef*>(compressed.data()));
+    stream.avail_in = compressed.length();
+
+    Bytef buffer[GZIP_BUFFER_SIZE];
+    std::string result = "";
+    int code = Z_OK;
+    do {
+      stream.next_out = buffer;
+      stream.avail_out = GZIP_BUFFER_SIZE;
+      code = inflate(&stream, Z_NO_FLUSH);
+
+      if (code != Z_OK && code != Z_STREAM_END && code != Z_BUF_ERROR) {
+        return Error(std::string(stream.msg != NULL ? stream.msg : ""));
+      }
+
+      result.append(
+          reinterpret_cast<char*>(buffer),
+          GZIP_BUFFER_SIZE - stream.avail_out);
+    } while (code != Z_STREAM_END && stream.avail_out == 0);
+
+    done = code == Z_STREAM_END;
+
+    return result;
+  }
+
+  // Returns whether the end of the compressed stream was reached.
+  bool finished() const
+  {
+    return done;
+  }
+
+private:
+  // Not copyable, not assignable.
+  Decompressor(const Decompressor&);
+  Decompressor& operator = (const Decompressor&);
+
+  z_stream_s stream;
+  bool initialized;
+  bool done;
+};
+
 } // namespace gzip {
 
 #endif // __STOUT_GZIP_HPP__
@@ -72,8 +72,14 @@ public:
   // if the key is already present.
   void put(const Key& key, const Value& value)
   {
-    boost::unordered_map<Key, Value>::erase(key);
-    boost::unordered_map<Key, Value>::insert(std::pair<Key, Value>(key, value));
+    // Look the key up only once, rather than erasing and inserting,
+    // since this is called on hot paths (e.g., the master's maps).
+    auto it = boost::unordered_map<Key, Value>::find(key);
+    if (it != boost::unordered_map<Key, Value>::end()) {
+      it->second = value;
+    } else {
+      boost::unordered_map<Key, Value>::emplace(key, value);
+    }
   }
 
   // Returns an Option for the binding to the key.
@@ -14,12 +14,17 @@
 #ifndef __STOUT_JSON__
 #define __STOUT_JSON__
 
-#include <picojson.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -31,6 +36,7 @@
 #include <stout/foreach.hpp>
 #include <stout/numify.hpp>
 #include <stout/result.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 #include <stout/unreachable.hpp>
@@ -496,142 +502,703 @@ inline bool operator != (const Value& lhs, const Value& rhs)
 }
 
 
-inline std::ostream& operator << (std::ostream& out, const String& string)
+namespace internal {
+
+// The bytes which are written as is within a JSON string, all others
+// are escaped (see RFC4627 for these ranges). Note that we also
+// escape all bytes > 0x7F since they imply more than 1 byte in UTF-8,
+// which is why we don't escape UTF-8 properly.
+struct Unescaped
+{
+  Unescaped()
+  {
+    for (int c = 0; c < 256; c++) {
+      bytes[c] = (c >= 0x20 && c <= 0x21) ||
+                 (c >= 0x23 && c <= 0x5B && c != '/') ||
+                 (c >= 0x5D && c < 0x7F);
+    }
+  }
+
+  bool bytes[256];
+};
+
+
+// Appends the quoted and escaped JSON string for 's' to 'out'. Runs
+// of bytes that need no escaping (i.e., most of them) are looked up
+// in a table and appended at once.
+// TODO(benh): This escaping DOES NOT handle unicode, it encodes as
+// ASCII. See RFC4627 for the JSON string specificiation.
+inline void escape(const std::string& s, std::string* out)
 {
-  // TODO(benh): This escaping DOES NOT handle unicode, it encodes as ASCII.
-  // See RFC4627 for the JSON string specificiation.
-  out << "\"";
-  foreach (unsigned char c, string.value) {
+  static const Unescaped unescaped;
+
+  out->reserve(out->size() + s.size() + 2);
+  out->push_back('"');
+
+  size_t run = 0; // Start of the current run of unescaped bytes.
+
+  for (size_t i = 0; i < s.size(); i++) {
+    const unsigned char c = s[i];
+
+    if (unescaped.bytes[c]) {
+      continue;
+    }
+
+    out->append(s, run, i - run);
+    run = i + 1;
+
     switch (c) {
-      case '"':  out << "\\\""; break;
-      case '\\': out << "\\\\"; break;
-      case '/':  out << "\\/";  break;
-      case '\b': out << "\\b";  break;
-      case '\f': out << "\\f";  break;
-      case '\n': out << "\\n";  break;
-      case '\r': out << "\\r";  break;
-      case '\t': out << "\\t";  break;
-      default:
-        // See RFC4627 for these ranges.
-        if ((c >= 0x20 && c <= 0x21) ||
-            (c >= 0x23 && c <= 0x5B) ||
-            (c >= 0x5D && c < 0x7F)) {
-          out << c;
-        } else {
-          // NOTE: We also escape all bytes > 0x7F since they imply more than
-          // 1 byte in UTF-8. This is why we don't escape UTF-8 properly.
-          // See RFC4627 for the escaping format: \uXXXX (X is a hex digit).
-          // Each byte here will be of the form: \u00XX (this is why we need
-          // setw and the cast to unsigned int).
-          out << "\\u" << std::setfill('0') << std::setw(4)
-              << std::hex << std::uppercase << (unsigned int) c;
-        }
+      case '"':  out->append("\\\""); break;
+      case '\\': out->append("\\\\"); break;
+      case '/':  out->append("\\/");  break;
+      case '\b': out->append("\\b");  break;
+      case '\f': out->append("\\f");  break;
+      case '\n': out->append("\\n");  break;
+      case '\r': out->append("\\r");  break;
+      case '\t': out->append("\\t");  break;
+      default: {
+        // See RFC4627 for the escaping format: \uXXXX (X is a hex
+        // digit). Each byte here will be of the form: \u00XX.
+        static const char digits[] = "0123456789ABCDEF";
+        const char escaped[] =
+          {'\\', 'u', '0', '0', digits[c >> 4], digits[c & 0xF]};
+        out->append(escaped, sizeof(escaped));
         break;
+      }
     }
   }
-  out << "\"";
-  return out;
+
+  out->append(s, run, std::string::npos);
+  out->push_back('"');
 }
 
 
-inline std::ostream& operator << (std::ostream& out, const Number& number)
+// Appends the JSON number for 'value' to 'out', using the guaranteed
+// accurate precision, see:
+// http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2006/n2005.pdf
+inline void format(double value, std::string* out)
 {
-  // Use the guaranteed accurate precision, see:
-  // http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2006/n2005.pdf
-  return out << std::setprecision(std::numeric_limits<double>::digits10)
-             << number.value;
+  // Integral values (e.g., ids, sizes and counters), which "%.*g"
+  // writes without an exponent as long as they do not have more
+  // digits than the precision, are converted without 'snprintf'.
+  if (value > -1e15 && value < 1e15 &&
+      value == static_cast<double>(static_cast<int64_t>(value)) &&
+      !(value == 0 && std::signbit(value))) {
+    int64_t integer = static_cast<int64_t>(value);
+
+    char digits[20];
+    char* end = digits + sizeof(digits);
+    char* begin = end;
+
+    uint64_t magnitude = integer < 0 ? -integer : integer;
+    do {
+      *--begin = '0' + magnitude % 10;
+      magnitude /= 10;
+    } while (magnitude != 0);
+
+    if (integer < 0) {
+      *--begin = '-';
+    }
+
+    out->append(begin, end - begin);
+    return;
+  }
+
+  // This is what an output stream does given the precision.
+  char formatted[32];
+  snprintf(formatted,
+           sizeof(formatted),
+           "%.*g",
+           std::numeric_limits<double>::digits10,
+           value);
+  out->append(formatted);
 }
 
+} // namespace internal {
 
-inline std::ostream& operator << (std::ostream& out, const Object& object)
+
+// A streaming JSON writer which appends the JSON to a string as it is
+// being written, as opposed to first building a JSON::Value (which
+// for large documents can be both slow and memory intensive). It's
+// the caller's responsibility to properly nest the calls, e.g.:
+//
+//   std::string out;
+//   JSON::Writer writer(&out);
+//   writer.startObject();
+//   writer.field("name", "value");
+//   writer.key("array");
+//   writer.startArray();
+//   writer.value(1);
+//   writer.endArray();
+//   writer.endObject();
+//
+// results in '{"name":"value","array":[1]}'. Note that unlike a
+// JSON::Object the fields are written in the order given and it's up
+// to the caller to not write the same field twice.
+class Writer
 {
-  out << "{";
-  std::map<std::string, Value>::const_iterator iterator;
-  iterator = object.values.begin();
-  while (iterator != object.values.end()) {
-    out << String((*iterator).first) << ":" << (*iterator).second;
-    if (++iterator != object.values.end()) {
-      out << ",";
+public:
+  explicit Writer(std::string* _out) : out(_out), separator(false) {}
+
+  void startObject()
+  {
+    separate();
+    out->push_back('{');
+    separator = false;
+  }
+
+  void endObject()
+  {
+    out->push_back('}');
+    separator = true;
+  }
+
+  void startArray()
+  {
+    separate();
+    out->push_back('[');
+    separator = false;
+  }
+
+  void endArray()
+  {
+    out->push_back(']');
+    separator = true;
+  }
+
+  // Writes the key of the next field of an object, must be followed
+  // by a value (or an object or an array).
+  void key(const std::string& key)
+  {
+    separate();
+    internal::escape(key, out);
+    out->push_back(':');
+    separator = false;
+  }
+
+  void value(const std::string& value)
+  {
+    separate();
+    internal::escape(value, out);
+    separator = true;
+  }
+
+  void value(const char* value)
+  {
+    separate();
+    internal::escape(value, out);
+    separator = true;
+  }
+
+  void value(bool value)
+  {
+    separate();
+    out->append(value ? "true" : "false");
+    separator = true;
+  }
+
+  template <typename T>
+  typename boost::enable_if<boost::is_arithmetic<T>, void>::type
+  value(T value)
+  {
+    separate();
+    internal::format(static_cast<double>(value), out);
+    separator = true;
+  }
+
+  // Writes an already built JSON::Value, e.g., for small parts of an
+  // otherwise streamed document.
+  void value(const Value& value);
+
+  void null()
+  {
+    separate();
+    out->append("null");
+    separator = true;
+  }
+
+  template <typename T>
+  void field(const std::string& key, const T& value)
+  {
+    this->key(key);
+    this->value(value);
+  }
+
+private:
+  void separate()
+  {
+    if (separator) {
+      out->push_back(',');
     }
   }
-  out << "}";
-  return out;
-}
 
+  std::string* out;
 
-inline std::ostream& operator << (std::ostream& out, const Array& array)
+  // Whether a ',' needs to be written before the next value.
+  bool separator;
+};
+
+
+namespace internal {
+
+// Writes each type of JSON value using a Writer, which is also how
+// they are output to a stream (see below).
+struct Printer : boost::static_visitor<>
 {
-  out << "[";
-  std::vector<Value>::const_iterator iterator;
-  iterator = array.values.begin();
-  while (iterator != array.values.end()) {
-    out << *iterator;
-    if (++iterator != array.values.end()) {
-      out << ",";
+  explicit Printer(Writer* _writer) : writer(_writer) {}
+
+  void operator () (const String& string) const
+  {
+    writer->value(string.value);
+  }
+
+  void operator () (const Number& number) const
+  {
+    writer->value(number.value);
+  }
+
+  void operator () (const Object& object) const
+  {
+    writer->startObject();
+    foreachpair (const std::string& key, const Value& value, object.values) {
+      writer->key(key);
+      boost::apply_visitor(*this, value);
     }
+    writer->endObject();
   }
-  out << "]";
-  return out;
+
+  void operator () (const Array& array) const
+  {
+    writer->startArray();
+    foreach (const Value& value, array.values) {
+      boost::apply_visitor(*this, value);
+    }
+    writer->endArray();
+  }
+
+  void operator () (const Boolean& boolean) const
+  {
+    writer->value(boolean.value);
+  }
+
+  void operator () (const Null&) const
+  {
+    writer->null();
+  }
+
+  Writer* writer;
+};
+
+
+template <typename T>
+std::ostream& print(std::ostream& out, const T& t)
+{
+  std::string s;
+  Writer writer(&s);
+  Printer printer(&writer);
+  printer(t);
+  return out << s;
 }
 
+} // namespace internal {
 
-inline std::ostream& operator << (std::ostream& out, const Boolean& boolean)
+
+inline void Writer::value(const Value& value)
 {
-  return out << (boolean.value ? "true" : "false");
+  boost::apply_visitor(internal::Printer(this), value);
 }
 
 
-inline std::ostream& operator << (std::ostream& out, const Null&)
+inline std::ostream& operator << (std::ostream& out, const String& string)
 {
-  return out << "null";
+  return internal::print(out, string);
 }
 
-namespace internal {
 
-inline Value convert(const picojson::value& value)
-{
-  if (value.is<picojson::null>()) {
-    return Null();
-  } else if (value.is<bool>()) {
-    return Boolean(value.get<bool>());
-  } else if (value.is<picojson::value::object>()) {
-    Object object;
-    foreachpair (const std::string& name,
-                 const picojson::value& value,
-                 value.get<picojson::value::object>()) {
-      object.values[name] = convert(value);
-    }
-    return object;
-  } else if (value.is<picojson::value::array>()) {
-    Array array;
-    foreach (const picojson::value& value,
-             value.get<picojson::value::array>()) {
-      array.values.push_back(convert(value));
-    }
-    return array;
-  } else if (value.is<double>()) {
-    return Number(value.get<double>());
-  } else if (value.is<std::string>()) {
-    return String(value.get<std::string>());
-  }
-  return Null();
+inline std::ostream& operator << (std::ostream& out, const Number& number)
+{
+  return internal::print(out, number);
 }
 
-} // namespace internal {
+
+inline std::ostream& operator << (std::ostream& out, const Object& object)
+{
+  return internal::print(out, object);
+}
 
 
-inline Try<Value> parse(const std::string& s)
+inline std::ostream& operator << (std::ostream& out, const Array& array)
 {
-  picojson::value value;
-  std::string error;
+  return internal::print(out, array);
+}
+
+
+inline std::ostream& operator << (std::ostream& out, const Boolean& boolean)
+{
+  return internal::print(out, boolean);
+}
+
+
+inline std::ostream& operator << (std::ostream& out, const Null& null)
+{
+  return internal::print(out, null);
+}
+
+
+namespace internal {
+
+// A recursive descent parser for JSON (see RFC4627) which builds the
+// JSON::Value in place as it goes, i.e., without an intermediate
+// representation, and appends runs of unescaped bytes of strings at
+// once.
+class Parser
+{
+public:
+  // The maximum nesting of arrays and objects, which bounds the depth
+  // of the recursion (and hence the stack used) for untrusted input.
+  static const size_t MAX_DEPTH = 1000;
+
+  Parser(const char* _begin, const char* _end)
+    : begin(_begin), current(_begin), end(_end), depth(0) {}
+
+  Try<Value> parse()
+  {
+    Value value;
+
+    if (!parse(&value)) {
+      return Error(error);
+    }
+
+    whitespace();
+
+    if (current != end) {
+      fail("Unexpected trailing characters");
+      return Error(error);
+    }
+
+    return value;
+  }
+
+private:
+  bool parse(Value* value)
+  {
+    whitespace();
+
+    if (current == end) {
+      return fail("Unexpected end of input");
+    }
+
+    switch (*current) {
+      case '{': {
+        if (depth == MAX_DEPTH) {
+          return fail("Exceeded the maximum nesting depth");
+        }
+        *value = Object();
+        ++depth;
+        const bool parsed = object(&boost::get<Object>(*value));
+        --depth;
+        return parsed;
+      }
+      case '[': {
+        if (depth == MAX_DEPTH) {
+          return fail("Exceeded the maximum nesting depth");
+        }
+        *value = Array();
+        ++depth;
+        const bool parsed = array(&boost::get<Array>(*value));
+        --depth;
+        return parsed;
+      }
+      case '"': {
+        *value = String();
+        return string(&boost::get<String>(*value).value);
+      }
+      case 't': {
+        *value = true;
+        return literal("true");
+      }
+      case 'f': {
+        *value = false;
+        return literal("false");
+      }
+      case 'n': {
+        *value = Null();
+        return literal("null");
+      }
+      default: {
+        double number;
+        if (!this->number(&number)) {
+          return false;
+        }
+        *value = number;
+        return true;
+      }
+    }
+  }
+
+  bool object(Object* object)
+  {
+    ++current; // Skip '{'.
+
+    whitespace();
+    if (current != end && *current == '}') {
+      ++current;
+      return true;
+    }
+
+    while (true) {
+      whitespace();
+
+      std::string key;
+      if (current == end || *current != '"') {
+        return fail("Expecting a string as the key of an object");
+      } else if (!string(&key)) {
+        return false;
+      }
+
+      whitespace();
+      if (current == end || *current != ':') {
+        return fail("Expecting ':' after the key of an object");
+      }
+      ++current;
+
+      if (!parse(&object->values[key])) {
+        return false;
+      }
+
+      whitespace();
+      if (current == end) {
+        return fail("Unexpected end of input within an object");
+      } else if (*current == ',') {
+        ++current;
+      } else if (*current == '}') {
+        ++current;
+        return true;
+      } else {
+        return fail("Expecting ',' or '}' within an object");
+      }
+    }
+  }
+
+  bool array(Array* array)
+  {
+    ++current; // Skip '['.
+
+    whitespace();
+    if (current != end && *current == ']') {
+      ++current;
+      return true;
+    }
+
+    while (true) {
+      array->values.push_back(Value());
+
+      if (!parse(&array->values.back())) {
+        return false;
+      }
+
+      whitespace();
+      if (current == end) {
+        return fail("Unexpected end of input within an array");
+      } else if (*current == ',') {
+        ++current;
+      } else if (*current == ']') {
+        ++current;
+        return true;
+      } else {
+        return fail("Expecting ',' or ']' within an array");
+      }
+    }
+  }
+
+  bool string(std::string* s)
+  {
+    ++current; // Skip '"'.
+
+    while (true) {
+      const char* run = current;
+      while (current != end && *current != '"' && *current != '\\') {
+        ++current;
+      }
+
+      s->append(run, current - run);
+
+      if (current == end) {
+        return fail("Unexpected end of input within a string");
+      } else if (*current == '"') {
+        ++current;
+        return true;
+      }
+
+      ++current; // Skip '\\'.
+
+      if (current == end) {
+        return fail("Unexpected end of input within a string");
+      }
+
+      switch (*current++) {
+        case '"':  s->push_back('"');  break;
+        case '\\': s->push_back('\\'); break;
+        case '/':  s->push_back('/');  break;
+        case 'b':  s->push_back('\b'); break;
+        case 'f':  s->push_back('\f'); break;
+        case 'n':  s->push_back('\n'); break;
+        case 'r':  s->push_back('\r'); break;
+        case 't':  s->push_back('\t'); break;
+        case 'u': {
+          if (!unicode(s)) {
+            return false;
+          }
+          break;
+        }
+        default:
+          return fail("Invalid escape sequence within a string");
+      }
+    }
+  }
+
+  // Parses the 4 hex digits of a '\u' escape sequence.
+  bool hex(unsigned int* code)
+  {
+    if (end - current < 4) {
+      return fail("Unexpected end of input within a string");
+    }
+
+    *code = 0;
+    for (int i = 0; i < 4; i++) {
+      const char c = *current++;
+      *code <<= 4;
+      if (c >= '0' && c <= '9') {
+        *code |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        *code |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        *code |= c - 'A' + 10;
+      } else {
+        return fail("Invalid '\\u' escape sequence within a string");
+      }
+    }
+
+    return true;
+  }
+
+  // Appends the UTF-8 encoding of the code point of a '\u' escape
+  // sequence, including the ones spanning a UTF-16 surrogate pair.
+  bool unicode(std::string* s)
+  {
+    unsigned int code;
+    if (!hex(&code)) {
+      return false;
+    }
 
-  picojson::parse(value, s.c_str(), s.c_str() + s.size(), &error);
+    if (code >= 0xD800 && code <= 0xDBFF) {
+      unsigned int low;
+      if (end - current < 2 || current[0] != '\\' || current[1] != 'u') {
+        return fail("Expecting the low surrogate of a '\\u' escape sequence");
+      }
+      current += 2;
+      if (!hex(&low)) {
+        return false;
+      } else if (low < 0xDC00 || low > 0xDFFF) {
+        return fail("Invalid low surrogate of a '\\u' escape sequence");
+      }
+      code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+    } else if (code >= 0xDC00 && code <= 0xDFFF) {
+      return fail("Unexpected low surrogate of a '\\u' escape sequence");
+    }
+
+    if (code < 0x80) {
+      s->push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+      s->push_back(static_cast<char>(0xC0 | (code >> 6)));
+      s->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+      s->push_back(static_cast<char>(0xE0 | (code >> 12)));
+      s->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+      s->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else {
+      s->push_back(static_cast<char>(0xF0 | (code >> 18)));
+      s->push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+      s->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+      s->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
 
-  if (!error.empty()) {
-    return Error(error);
+    return true;
   }
 
-  return internal::convert(value);
+  bool number(double* number)
+  {
+    const char* start = current;
+    while (current != end &&
+           ((*current >= '0' && *current <= '9') ||
+            *current == '-' || *current == '+' ||
+            *current == '.' || *current == 'e' || *current == 'E')) {
+      ++current;
+    }
+
+    if (current == start) {
+      return fail("Unexpected character");
+    }
+
+    // NOTE: The characters are copied since 'strtod' needs them to be
+    // NUL terminated.
+    const std::string s(start, current - start);
+
+    char* last;
+    *number = strtod(s.c_str(), &last);
+
+    if (last != s.c_str() + s.size()) {
+      current = start;
+      return fail("Invalid number");
+    }
+
+    return true;
+  }
+
+  bool literal(const char* literal)
+  {
+    const size_t size = strlen(literal);
+
+    if (static_cast<size_t>(end - current) < size ||
+        strncmp(current, literal, size) != 0) {
+      return fail("Unexpected character");
+    }
+
+    current += size;
+    return true;
+  }
+
+  void whitespace()
+  {
+    while (current != end &&
+           (*current == ' ' || *current == '\t' ||
+            *current == '\n' || *current == '\r')) {
+      ++current;
+    }
+  }
+
+  bool fail(const std::string& message)
+  {
+    error = message + " at offset " + stringify(current - begin);
+    return false;
+  }
+
+  const char* const begin;
+  const char* current;
+  const char* const end;
+
+  // The number of arrays and objects being parsed.
+  size_t depth;
+
+  std::string error;
+};
+
+} // namespace internal {
+
+
+inline Try<Value> parse(const std::string& s)
+{
+  return internal::Parser(s.data(), s.data() + s.size()).parse();
 }
 
 
@@ -150,13 +150,49 @@ inline Try<Bytes> contentLength(const std::string& url)
 }
 
 
+// Returns the HTTP response code resulting from attempting to
+// download the specified HTTP or FTP URL into the specified file
+// handle, which may also be a pipe (e.g., to stream the content into
+// another process). The file handle is not closed.
+// NOTE: The body of an error response (i.e., a response code of 400
+// or above) is not written to the file handle, so that a consumer of
+// the content never sees an error page in place of the content.
+inline Try<int> download(const std::string& url, FILE* file)
+{
+  initialize();
+
+  CURL* curl = curl_easy_init();
+
+  if (curl == NULL) {
+    curl_easy_cleanup(curl);
+    return Error("Failed to initialize libcurl");
+  }
+
+  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
+  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, true);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, file);
+  curl_easy_setopt(curl, CURLOPT_FAILONERROR, true);
+
+  CURLcode curlErrorCode = curl_easy_perform(curl);
+  if (curlErrorCode != 0 && curlErrorCode != CURLE_HTTP_RETURNED_ERROR) {
+    curl_easy_cleanup(curl);
+    return Error(curl_easy_strerror(curlErrorCode));
+  }
+
+  long code;
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+  curl_easy_cleanup(curl);
+
+  return Try<int>::some(code);
+}
+
+
 // Returns the HTTP response code resulting from attempting to
 // download the specified HTTP or FTP URL into a file at the specified
 // path.
 inline Try<int> download(const std::string& url, const std::string& path)
 {
-  initialize();
-
   Try<int> fd = os::open(
       path,
       O_CREAT | O_WRONLY | O_CLOEXEC,
@@ -166,6 +202,55 @@ inline Try<int> download(const std::string& url, const std::string& path)
     return Error(fd.error());
   }
 
+  FILE* file = fdopen(fd.get(), "w");
+  if (file == NULL) {
+    os::close(fd.get());
+    return ErrnoError("Failed to open file handle of '" + path + "'");
+  }
+
+  Try<int> code = download(url, file);
+
+  if (fclose(file) != 0 && code.isSome()) {
+    return ErrnoError("Failed to close file handle of '" + path + "'");
+  }
+
+  return code;
+}
+
+
+// Like 'download' above, but if 'resume' is true and the file at the
+// specified path already holds a prefix of the content (e.g., from a
+// failed download) only the rest of the content is requested (with a
+// range request) and appended to the file. Falls back to downloading
+// all of the content if the server does not support range requests.
+// NOTE: A partial content response (206) to a range request is
+// returned as 200.
+inline Try<int> download(
+    const std::string& url,
+    const std::string& path,
+    bool resume)
+{
+  if (!resume || !os::exists(path)) {
+    return download(url, path);
+  }
+
+  Try<Bytes> size = os::stat::size(path);
+  if (size.isError()) {
+    return Error(size.error());
+  }
+
+  if (size.get() == 0) {
+    return download(url, path);
+  }
+
+  initialize();
+
+  Try<int> fd = os::open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+
+  if (fd.isError()) {
+    return Error(fd.error());
+  }
+
   CURL* curl = curl_easy_init();
 
   if (curl == NULL) {
@@ -177,21 +262,21 @@ inline Try<int> download(const std::string& url, const std::string& path)
   curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
   curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
   curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, true);
+  curl_easy_setopt(
+      curl, CURLOPT_RESUME_FROM_LARGE, (curl_off_t) size.get().bytes());
 
-  FILE* file = fdopen(fd.get(), "w");
+  FILE* file = fdopen(fd.get(), "a");
   if (file == NULL) {
-    return ErrnoError("Failed to open file handle of '" + path + "'");
+    ErrnoError error("Failed to open file handle of '" + path + "'");
+    curl_easy_cleanup(curl);
+    os::close(fd.get());
+    return error;
   }
   curl_easy_setopt(curl, CURLOPT_WRITEDATA, file);
 
   CURLcode curlErrorCode = curl_easy_perform(curl);
-  if (curlErrorCode != 0) {
-    curl_easy_cleanup(curl);
-    fclose(file);
-    return Error(curl_easy_strerror(curlErrorCode));
-  }
 
-  long code;
+  long code = 0;
   curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
   curl_easy_cleanup(curl);
 
@@ -199,7 +284,20 @@ inline Try<int> download(const std::string& url, const std::string& path)
     return ErrnoError("Failed to close file handle of '" + path + "'");
   }
 
-  return Try<int>::some(code);
+  // Start over if the server does not support range requests or if
+  // the range is not satisfiable (e.g., the content has changed).
+  if (curlErrorCode == CURLE_RANGE_ERROR || code == 416) {
+    Try<Nothing> rm = os::rm(path);
+    if (rm.isError()) {
+      return Error(rm.error());
+    }
+
+    return download(url, path);
+  } else if (curlErrorCode != 0) {
+    return Error(curl_easy_strerror(curlErrorCode));
+  }
+
+  return Try<int>::some(code == 206 ? 200 : code);
 }
 
 
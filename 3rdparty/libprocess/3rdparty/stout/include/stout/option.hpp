@@ -17,6 +17,8 @@
 #include <assert.h>
 
 #include <algorithm>
+#include <type_traits>
+#include <utility>
 
 #include <stout/none.hpp>
 #include <stout/some.hpp>
@@ -39,6 +41,8 @@ public:
 
   Option(const T& _t) : state(SOME), t(_t) {}
 
+  Option(T&& _t) : state(SOME), t(std::move(_t)) {}
+
   template <typename U>
   Option(const U& u) : state(SOME), t(u) {}
 
@@ -54,6 +58,15 @@ public:
     }
   }
 
+  // Moving leaves 'that' in the SOME state (when it was) but with a
+  // moved-from value, as is the case for the standard containers.
+  Option(Option<T>&& that) : state(that.state)
+  {
+    if (that.isSome()) {
+      new (&t) T(std::move(that.t));
+    }
+  }
+
   ~Option()
   {
     if (isSome()) {
@@ -76,6 +89,21 @@ public:
     return *this;
   }
 
+  Option<T>& operator = (Option<T>&& that)
+  {
+    if (this != &that) {
+      if (isSome()) {
+        t.~T();
+      }
+      state = that.state;
+      if (that.isSome()) {
+        new (&t) T(std::move(that.t));
+      }
+    }
+
+    return *this;
+  }
+
   bool operator == (const Option<T>& that) const
   {
     return (isNone() && that.isNone()) ||
@@ -1146,6 +1146,13 @@ inline std::set<pid_t> children(
     const std::list<Process>& processes,
     bool recursive = true)
 {
+  // Index the processes by their parents once, rather than searching
+  // all processes for the children of each descendant.
+  hashmap<pid_t, std::list<pid_t>> children;
+  foreach (const Process& process, processes) {
+    children[process.parent].push_back(process.pid);
+  }
+
   // Perform a breadth first search for descendants.
   std::set<pid_t> descendants;
   std::queue<pid_t> parents;
@@ -1155,13 +1162,14 @@ inline std::set<pid_t> children(
     pid_t parent = parents.front();
     parents.pop();
 
-    // Search for children of parent.
-    foreach (const Process& process, processes) {
-      if (process.parent == parent) {
-        // Have we seen this child yet?
-        if (descendants.insert(process.pid).second) {
-          parents.push(process.pid);
-        }
+    if (!children.contains(parent)) {
+      continue;
+    }
+
+    foreach (pid_t child, children[parent]) {
+      // Have we seen this child yet?
+      if (descendants.insert(child).second) {
+        parents.push(child);
       }
     }
   } while (recursive && !parents.empty());
@@ -121,70 +121,86 @@ inline Try<std::list<ProcessTree> > killtree(
   }
 
   while (!queue.empty()) {
-    pid_t pid = queue.front();
-    queue.pop();
+    // Stop all the processes that are queued for visiting before
+    // refreshing the process list, so that we only need to refresh it
+    // once for each "level" of the traversal rather than once for
+    // each process (which is expensive on hosts with many processes).
+    std::list<Process> stopped;
+
+    while (!queue.empty()) {
+      pid_t pid = queue.front();
+      queue.pop();
+
+      if (visited.pids.count(pid) != 0) {
+        continue;
+      }
 
-    if (visited.pids.count(pid) != 0) {
-      continue;
-    }
+      // Make sure this process still exists.
+      process = os::process(pid);
 
-    // Make sure this process still exists.
-    process = os::process(pid);
+      if (process.isError()) {
+        return Error(process.error());
+      } else if (process.isNone()) {
+        continue;
+      }
 
-    if (process.isError()) {
-      return Error(process.error());
-    } else if (process.isNone()) {
-      continue;
-    }
+      // Stop the process to keep it from forking while we are killing
+      // it since a forked child might get re-parented by init and
+      // become impossible to find.
+      kill(pid, SIGSTOP);
 
-    // Stop the process to keep it from forking while we are killing
-    // it since a forked child might get re-parented by init and
-    // become impossible to find.
-    kill(pid, SIGSTOP);
+      visited.pids.insert(pid);
+      visited.processes.push_back(process.get());
 
-    visited.pids.insert(pid);
-    visited.processes.push_back(process.get());
+      stopped.push_back(process.get());
+    }
 
-    // Now refresh the process list knowing that the current process
-    // can't fork any more children (since it's stopped).
+    if (stopped.empty()) {
+      break;
+    }
+
+    // Now refresh the process list knowing that the stopped processes
+    // can't fork any more children.
     processes = os::processes();
 
     if (processes.isError()) {
       return Error(processes.error());
     }
 
-    // Enqueue the children for visiting.
-    foreach (pid_t child, os::children(pid, processes.get(), false)) {
-      queue.push(child);
-    }
+    foreach (const Process& process, stopped) {
+      // Enqueue the children for visiting.
+      foreach (pid_t child, os::children(process.pid, processes.get(), false)) {
+        queue.push(child);
+      }
 
-    // Now "visit" the group and/or session of the current process.
-    if (groups) {
-      pid_t group = process.get().group;
-      if (visited.groups.count(group) == 0) {
-        foreach (const Process& process, processes.get()) {
-          if (process.group == group) {
-            queue.push(process.pid);
+      // Now "visit" the group and/or session of the current process.
+      if (groups) {
+        pid_t group = process.group;
+        if (visited.groups.count(group) == 0) {
+          foreach (const Process& process, processes.get()) {
+            if (process.group == group) {
+              queue.push(process.pid);
+            }
           }
+          visited.groups.insert(group);
         }
-        visited.groups.insert(group);
       }
-    }
 
-    // If we do not have a session for the process, it's likely
-    // because the process is a zombie on OS X. This implies it has
-    // not been reaped and thus is located somewhere in the tree we
-    // are trying to kill. Therefore, we should discover it from our
-    // tree traversal, or through its group (which is always present).
-    if (sessions && process.get().session.isSome()) {
-      pid_t session = process.get().session.get();
-      if (visited.sessions.count(session) == 0) {
-        foreach (const Process& process, processes.get()) {
-          if (process.session.isSome() && process.session.get() == session) {
-            queue.push(process.pid);
+      // If we do not have a session for the process, it's likely
+      // because the process is a zombie on OS X. This implies it has
+      // not been reaped and thus is located somewhere in the tree we
+      // are trying to kill. Therefore, we should discover it from our
+      // tree traversal, or through its group (which is always present).
+      if (sessions && process.session.isSome()) {
+        pid_t session = process.session.get();
+        if (visited.sessions.count(session) == 0) {
+          foreach (const Process& process, processes.get()) {
+            if (process.session.isSome() && process.session.get() == session) {
+              queue.push(process.pid);
+            }
           }
+          visited.sessions.insert(session);
         }
-        visited.sessions.insert(session);
       }
     }
   }
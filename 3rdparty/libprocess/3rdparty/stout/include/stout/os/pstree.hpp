@@ -14,11 +14,13 @@
 #ifndef __STOUT_OS_PSTREE_HPP__
 #define __STOUT_OS_PSTREE_HPP__
 
+#include <functional>
 #include <list>
 #include <set>
 
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
@@ -39,24 +41,40 @@ inline Try<ProcessTree> pstree(
     pid_t pid,
     const std::list<Process>& processes)
 {
-  std::list<ProcessTree> children;
-  foreach (const Process& process, processes) {
-    if (process.parent == pid) {
-      Try<ProcessTree> tree = pstree(process.pid, processes);
-      if (tree.isError()) {
-        return Error(tree.error());
-      }
-      children.push_back(tree.get());
-    }
-  }
+  // Index the processes by their parents once (rather than looking
+  // for the children of each process in the tree in all processes,
+  // which is quadratic in the number of processes for large trees).
+  const Process* root = NULL;
+  hashmap<pid_t, std::list<const Process*>> children;
 
   foreach (const Process& process, processes) {
     if (process.pid == pid) {
-      return ProcessTree(process, children);
+      root = &process;
     }
+
+    // NOTE: Some systems report processes which are their own parent
+    // (e.g., 'kernel_task' on OS X), which would lead to a cycle.
+    if (process.parent != process.pid) {
+      children[process.parent].push_back(&process);
+    }
+  }
+
+  if (root == NULL) {
+    return Error("No process found at " + stringify(pid));
   }
 
-  return Error("No process found at " + stringify(pid));
+  std::function<ProcessTree(const Process&)> tree =
+    [&](const Process& process) {
+      std::list<ProcessTree> trees;
+      if (children.contains(process.pid)) {
+        foreach (const Process* child, children[process.pid]) {
+          trees.push_back(tree(*child));
+        }
+      }
+      return ProcessTree(process, trees);
+    };
+
+  return tree(*root);
 }
 
 
@@ -29,7 +29,11 @@
 
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 
+#include <algorithm>
+#include <map>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <boost/lexical_cast.hpp>
 
@@ -40,7 +44,9 @@
 #include "os.hpp"
 #include "result.hpp"
 #include "stringify.hpp"
+#include "synchronized.hpp"
 #include "try.hpp"
+#include "unreachable.hpp"
 
 namespace protobuf {
 
@@ -720,6 +726,178 @@ private:
   JSON::Object object;
 };
 
+
+namespace internal {
+
+// Returns the fields of messages with the given descriptor in the
+// order in which they are written, i.e., sorted by name so that the
+// output matches that of 'JSON::Protobuf'. The result is cached per
+// descriptor, which assumes that descriptors outlive the program (as
+// is the case for all generated messages).
+inline const std::vector<const google::protobuf::FieldDescriptor*>& fields(
+    const google::protobuf::Descriptor* descriptor)
+{
+  typedef std::vector<const google::protobuf::FieldDescriptor*> Fields;
+
+  static std::mutex* mutex = new std::mutex();
+  static std::map<const google::protobuf::Descriptor*, Fields>* plans =
+    new std::map<const google::protobuf::Descriptor*, Fields>();
+
+  synchronized (mutex) {
+    if (plans->count(descriptor) == 0) {
+      Fields fields;
+      for (int i = 0; i < descriptor->field_count(); i++) {
+        fields.push_back(descriptor->field(i));
+      }
+
+      std::sort(
+          fields.begin(),
+          fields.end(),
+          [](const google::protobuf::FieldDescriptor* left,
+             const google::protobuf::FieldDescriptor* right) {
+            return left->name() < right->name();
+          });
+
+      (*plans)[descriptor] = fields;
+    }
+
+    // Entries are never removed so the reference remains valid
+    // after the lock is released.
+    return plans->at(descriptor);
+  }
+
+  UNREACHABLE();
+}
+
+} // namespace internal {
+
+
+// Writes the message directly using the writer, without first
+// building a 'JSON::Object'. The output is the same as that of
+// stringifying 'JSON::Protobuf(message)'.
+inline void protobuf(Writer* writer, const google::protobuf::Message& message)
+{
+  const google::protobuf::Reflection* reflection = message.GetReflection();
+
+  writer->startObject();
+
+  foreach (const google::protobuf::FieldDescriptor* field,
+           internal::fields(message.GetDescriptor())) {
+    if (field->is_repeated()) {
+      int size = reflection->FieldSize(message, field);
+      if (size == 0) {
+        continue;
+      }
+
+      writer->key(field->name());
+      writer->startArray();
+      for (int i = 0; i < size; ++i) {
+        switch (field->type()) {
+          case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+            writer->value(reflection->GetRepeatedDouble(message, field, i));
+            break;
+          case google::protobuf::FieldDescriptor::TYPE_FLOAT:
+            writer->value(reflection->GetRepeatedFloat(message, field, i));
+            break;
+          case google::protobuf::FieldDescriptor::TYPE_INT64:
+          case google::protobuf::FieldDescriptor::TYPE_SINT64:
+          case google::protobuf::FieldDescriptor::TYPE_SFIXED64:
+            writer->value(reflection->GetRepeatedInt64(message, field, i));
+            break;
+          case google::protobuf::FieldDescriptor::TYPE_UINT64:
+          case google::protobuf::FieldDescriptor::TYPE_FIXED64:
+            writer->value(reflection->GetRepeatedUInt64(message, field, i));
+            break;
+          case google::protobuf::FieldDescriptor::TYPE_INT32:
+          case google::protobuf::FieldDescriptor::TYPE_SINT32:
+          case google::protobuf::FieldDescriptor::TYPE_SFIXED32:
+            writer->value(reflection->GetRepeatedInt32(message, field, i));
+            break;
+          case google::protobuf::FieldDescriptor::TYPE_UINT32:
+          case google::protobuf::FieldDescriptor::TYPE_FIXED32:
+            writer->value(reflection->GetRepeatedUInt32(message, field, i));
+            break;
+          case google::protobuf::FieldDescriptor::TYPE_BOOL:
+            writer->value(reflection->GetRepeatedBool(message, field, i));
+            break;
+          case google::protobuf::FieldDescriptor::TYPE_STRING:
+          case google::protobuf::FieldDescriptor::TYPE_BYTES:
+            writer->value(reflection->GetRepeatedString(message, field, i));
+            break;
+          case google::protobuf::FieldDescriptor::TYPE_MESSAGE:
+            protobuf(writer, reflection->GetRepeatedMessage(message, field, i));
+            break;
+          case google::protobuf::FieldDescriptor::TYPE_ENUM:
+            writer->value(
+                reflection->GetRepeatedEnum(message, field, i)->name());
+            break;
+          case google::protobuf::FieldDescriptor::TYPE_GROUP:
+            // Deprecated!
+          default:
+            ABORT("Unhandled protobuf field type: " +
+                  stringify(field->type()));
+        }
+      }
+      writer->endArray();
+    } else {
+      // See the comment in 'JSON::Protobuf' for why optional fields
+      // with a default are written even when unset.
+      if (!reflection->HasField(message, field) &&
+          !field->has_default_value()) {
+        continue;
+      }
+
+      writer->key(field->name());
+      switch (field->type()) {
+        case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+          writer->value(reflection->GetDouble(message, field));
+          break;
+        case google::protobuf::FieldDescriptor::TYPE_FLOAT:
+          writer->value(reflection->GetFloat(message, field));
+          break;
+        case google::protobuf::FieldDescriptor::TYPE_INT64:
+        case google::protobuf::FieldDescriptor::TYPE_SINT64:
+        case google::protobuf::FieldDescriptor::TYPE_SFIXED64:
+          writer->value(reflection->GetInt64(message, field));
+          break;
+        case google::protobuf::FieldDescriptor::TYPE_UINT64:
+        case google::protobuf::FieldDescriptor::TYPE_FIXED64:
+          writer->value(reflection->GetUInt64(message, field));
+          break;
+        case google::protobuf::FieldDescriptor::TYPE_INT32:
+        case google::protobuf::FieldDescriptor::TYPE_SINT32:
+        case google::protobuf::FieldDescriptor::TYPE_SFIXED32:
+          writer->value(reflection->GetInt32(message, field));
+          break;
+        case google::protobuf::FieldDescriptor::TYPE_UINT32:
+        case google::protobuf::FieldDescriptor::TYPE_FIXED32:
+          writer->value(reflection->GetUInt32(message, field));
+          break;
+        case google::protobuf::FieldDescriptor::TYPE_BOOL:
+          writer->value(reflection->GetBool(message, field));
+          break;
+        case google::protobuf::FieldDescriptor::TYPE_STRING:
+        case google::protobuf::FieldDescriptor::TYPE_BYTES:
+          writer->value(reflection->GetString(message, field));
+          break;
+        case google::protobuf::FieldDescriptor::TYPE_MESSAGE:
+          protobuf(writer, reflection->GetMessage(message, field));
+          break;
+        case google::protobuf::FieldDescriptor::TYPE_ENUM:
+          writer->value(reflection->GetEnum(message, field)->name());
+          break;
+        case google::protobuf::FieldDescriptor::TYPE_GROUP:
+          // Deprecated!
+        default:
+          ABORT("Unhandled protobuf field type: " +
+                stringify(field->type()));
+      }
+    }
+  }
+
+  writer->endObject();
+}
+
 } // namespace JSON {
 
 #endif // __STOUT_PROTOBUF_HPP__
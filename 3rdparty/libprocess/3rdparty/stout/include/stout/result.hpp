@@ -18,6 +18,7 @@
 
 #include <iostream>
 #include <string>
+#include <utility>
 
 #include <stout/abort.hpp>
 #include <stout/error.hpp>
@@ -59,6 +60,9 @@ public:
   Result(const T& _t)
     : data(Some(_t)) {}
 
+  Result(T&& _t)
+    : data(Option<T>(std::move(_t))) {}
+
   template <typename U>
   Result(const U& u)
     : data(Some(u)) {}
@@ -89,8 +93,10 @@ public:
   // We don't need to implement these because we are leveraging
   // Try<Option<T>>.
   Result(const Result<T>& that) = default;
+  Result(Result<T>&& that) = default;
   ~Result() = default;
   Result<T>& operator = (const Result<T>& that) = default;
+  Result<T>& operator = (Result<T>&& that) = default;
 
   // 'isSome', 'isNone', and 'isError' are mutually exclusive. They
   // correspond to the underlying unioned state of the Option and Try.
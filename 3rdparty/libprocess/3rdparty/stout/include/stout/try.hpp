@@ -18,6 +18,7 @@
 
 #include <iostream>
 #include <string>
+#include <utility>
 
 #include <stout/abort.hpp>
 #include <stout/error.hpp>
@@ -48,6 +49,9 @@ public:
   Try(const T& t)
     : data(Some(t)) {}
 
+  Try(T&& t)
+    : data(std::move(t)) {}
+
   template <typename U>
   Try(const U& u)
     : data(Some(u)) {}
@@ -58,13 +62,13 @@ public:
   Try(const ErrnoError& error)
     : message(error.message) {}
 
-  // TODO(bmahler): Add move constructor.
-
   // We don't need to implement these because we are leveraging
   // Option<T>.
   Try(const Try<T>& that) = default;
+  Try(Try<T>&& that) = default;
   ~Try() = default;
   Try<T>& operator = (const Try<T>& that) = default;
+  Try<T>& operator = (Try<T>&& that) = default;
 
   // 'isSome' and 'isError' are mutually exclusive. They correspond
   // to the underlying state of the Option.
@@ -50,4 +50,73 @@ TEST(GzipTest, CompressDecompressString)
   ASSERT_SOME(decompressed);
   ASSERT_EQ(s, decompressed.get());
 }
+
+
+TEST(GzipTest, Streaming)
+{
+  // Compress a 1MB random string in pieces of various sizes.
+  string s = "";
+  while (s.length() < (1024 * 1024)) {
+    s.append(1, ' ' + (rand() % ('~' - ' ')));
+  }
+
+  gzip::Compressor compressor;
+
+  string compressed = "";
+  size_t offset = 0;
+  size_t length = 1;
+  while (offset < s.length()) {
+    Try<string> piece = compressor.compress(s.substr(offset, length));
+    ASSERT_SOME(piece);
+    compressed += piece.get();
+
+    offset += length;
+    length *= 2;
+  }
+
+  Try<string> piece = compressor.finish();
+  ASSERT_SOME(piece);
+  compressed += piece.get();
+
+  Try<string> decompressed = gzip::decompress(compressed);
+  ASSERT_SOME(decompressed);
+  ASSERT_EQ(s, decompressed.get());
+
+  // Decompress the stream in pieces as well.
+  gzip::Decompressor decompressor;
+
+  string result = "";
+  for (size_t i = 0; i < compressed.length(); i += 1000) {
+    EXPECT_FALSE(decompressor.finished());
+
+    Try<string> piece = decompressor.decompress(compressed.substr(i, 1000));
+    ASSERT_SOME(piece);
+    result += piece.get();
+  }
+
+  EXPECT_TRUE(decompressor.finished());
+  ASSERT_EQ(s, result);
+
+  // No more data can be compressed once finished.
+  EXPECT_ERROR(compressor.compress(s));
+  EXPECT_ERROR(compressor.finish());
+
+  // An empty stream is still a valid gzip stream.
+  gzip::Compressor empty;
+
+  Try<string> finished = empty.finish();
+  ASSERT_SOME(finished);
+
+  decompressed = gzip::decompress(finished.get());
+  ASSERT_SOME(decompressed);
+  EXPECT_EQ("", decompressed.get());
+
+  // Invalid compression levels should result in errors.
+  gzip::Compressor invalid(Z_BEST_COMPRESSION + 1);
+  EXPECT_ERROR(invalid.compress(s));
+
+  // Invalid data should result in errors.
+  gzip::Decompressor corrupt;
+  EXPECT_ERROR(corrupt.decompress(s));
+}
 #endif // HAVE_LIBZ
@@ -45,6 +45,58 @@ TEST(JsonTest, NumberFormat)
 
   // Expect at least 15 digits of precision.
   EXPECT_EQ("1234567890.12345", stringify(JSON::Number(1234567890.12345)));
+
+  // Integers with more digits than the precision use an exponent.
+  EXPECT_EQ("123456789012345", stringify(JSON::Number(123456789012345.0)));
+  EXPECT_EQ("1e+15", stringify(JSON::Number(1e15)));
+  EXPECT_EQ("-0", stringify(JSON::Number(-0.0)));
+}
+
+
+TEST(JsonTest, Writer)
+{
+  string s;
+  JSON::Writer writer(&s);
+
+  writer.startObject();
+  writer.field("array", JSON::Array());
+  writer.key("numbers");
+  writer.startArray();
+  writer.value(0);
+  writer.value(-1);
+  writer.value(1234567890.12345);
+  writer.endArray();
+  writer.key("object");
+  writer.startObject();
+  writer.field("false", false);
+  writer.key("null");
+  writer.null();
+  writer.field("true", true);
+  writer.endObject();
+  writer.field("string", string("\"\\/\b\f\n\r\t\x00\x19 !#[]\x7F\xFF", 17));
+  writer.endObject();
+
+  // The fields were written in order, so the result should be the
+  // same as for the equivalent JSON::Object.
+  JSON::Object object;
+  object.values["array"] = JSON::Array();
+
+  JSON::Array numbers;
+  numbers.values.push_back(0);
+  numbers.values.push_back(-1);
+  numbers.values.push_back(1234567890.12345);
+  object.values["numbers"] = numbers;
+
+  JSON::Object nested;
+  nested.values["false"] = false;
+  nested.values["null"] = JSON::Null();
+  nested.values["true"] = true;
+  object.values["object"] = nested;
+
+  object.values["string"] =
+    string("\"\\/\b\f\n\r\t\x00\x19 !#[]\x7F\xFF", 17);
+
+  EXPECT_EQ(stringify(object), s);
 }
 
 
@@ -177,6 +229,75 @@ TEST(JsonTest, parse)
 }
 
 
+TEST(JsonTest, ParseWhitespaceAndEscapes)
+{
+  Try<JSON::Value> value = JSON::parse(
+      " {\n\t\"array\" : [ 1 , -2.5e3 , true , false , null ] ,\r\n"
+      "  \"string\" : \"\\\"\\\\\\/\\b\\f\\n\\r\\t\\u0041\\u00e9\\ud83d\\ude00\""
+      " } ");
+
+  ASSERT_SOME(value);
+
+  JSON::Array array;
+  array.values.push_back(1);
+  array.values.push_back(-2500);
+  array.values.push_back(true);
+  array.values.push_back(false);
+  array.values.push_back(JSON::Null());
+
+  JSON::Object object;
+  object.values["array"] = array;
+  object.values["string"] =
+    "\"\\/\b\f\n\r\t" "A" "\xC3\xA9" "\xF0\x9F\x98\x80";
+
+  EXPECT_EQ(JSON::Value(object), value.get());
+}
+
+
+TEST(JsonTest, ParseError)
+{
+  EXPECT_ERROR(JSON::parse(""));
+  EXPECT_ERROR(JSON::parse("{"));
+  EXPECT_ERROR(JSON::parse("{\"key\" 1}"));
+  EXPECT_ERROR(JSON::parse("{key: 1}"));
+  EXPECT_ERROR(JSON::parse("[1,]"));
+  EXPECT_ERROR(JSON::parse("[1 2]"));
+  EXPECT_ERROR(JSON::parse("\"unterminated"));
+  EXPECT_ERROR(JSON::parse("\"\\q\""));
+  EXPECT_ERROR(JSON::parse("\"\\u12\""));
+  EXPECT_ERROR(JSON::parse("\"\\ud83d\""));
+  EXPECT_ERROR(JSON::parse("1.2.3"));
+  EXPECT_ERROR(JSON::parse("tru"));
+
+  // Only whitespace may follow the value.
+  EXPECT_ERROR(JSON::parse("{} {}"));
+  EXPECT_SOME(JSON::parse("{} \n"));
+}
+
+
+TEST(JsonTest, ParseDepth)
+{
+  const size_t depth = JSON::internal::Parser::MAX_DEPTH;
+
+  // Arrays and objects may be nested up to the maximum depth ...
+  EXPECT_SOME(JSON::parse(string(depth, '[') + string(depth, ']')));
+
+  string object;
+  for (size_t i = 0; i < depth - 1; i++) {
+    object += "{\"a\":";
+  }
+  object += "{}" + string(depth - 1, '}');
+
+  EXPECT_SOME(JSON::parse(object));
+
+  // ... but not any deeper, even if the input is cut off (i.e., the
+  // error is returned before running out of stack).
+  EXPECT_ERROR(JSON::parse(string(depth + 1, '[') + string(depth + 1, ']')));
+  EXPECT_ERROR(JSON::parse("{\"a\":" + object + "}"));
+  EXPECT_ERROR(JSON::parse(string(1000000, '[')));
+}
+
+
 TEST(JsonTest, Find)
 {
   JSON::Object object;
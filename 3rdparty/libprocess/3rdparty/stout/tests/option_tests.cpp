@@ -1,9 +1,13 @@
 #include <gmock/gmock.h>
 
+#include <memory>
 #include <string>
+#include <utility>
+
 #include <stout/gtest.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
+#include <stout/try.hpp>
 
 using std::string;
 
@@ -101,3 +105,25 @@ TEST(OptionTest, NonConstReference)
   s.get() += " world";
   EXPECT_EQ("hello world", s.get());
 }
+
+
+// Move-only types can be stored, and moving an Option (or a Try)
+// moves the value rather than copying it.
+TEST(OptionTest, Move)
+{
+  Option<std::unique_ptr<int>> option(std::unique_ptr<int>(new int(42)));
+  ASSERT_SOME(option);
+
+  Option<std::unique_ptr<int>> moved = std::move(option);
+  ASSERT_SOME(moved);
+  EXPECT_EQ(42, *moved.get());
+
+  option = std::move(moved);
+  ASSERT_SOME(option);
+  EXPECT_EQ(42, *option.get());
+
+  Try<std::unique_ptr<int>> t = std::move(option.get());
+  ASSERT_SOME(t);
+  EXPECT_EQ(42, *t.get());
+  EXPECT_TRUE(option.get() == NULL);
+}
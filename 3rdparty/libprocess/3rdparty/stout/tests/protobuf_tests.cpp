@@ -99,6 +99,13 @@ TEST(ProtobufTest, JSON)
 
   EXPECT_EQ(expected, stringify(object));
 
+  // Writing the message directly must produce the same output.
+  string json;
+  JSON::Writer writer(&json);
+  JSON::protobuf(&writer, message);
+
+  EXPECT_EQ(expected, json);
+
   // Test parsing too.
   Try<tests::Message> parse = protobuf::parse<tests::Message>(object);
   ASSERT_SOME(parse);
@@ -1,12 +1,12 @@
 #ifndef __ASYNC_HPP__
 #define __ASYNC_HPP__
 
+#include <functional>
+#include <memory>
+
 #include <boost/type_traits.hpp> // TODO(benh): Use C++11 type_traits.
 
-#include <process/dispatch.hpp>
 #include <process/future.hpp>
-#include <process/id.hpp>
-#include <process/process.hpp>
 
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
@@ -14,238 +14,87 @@
 
 namespace process {
 
-// Provides an abstraction for asynchronously executing a function
-// (note the declarations are here and definitions below since
-// defining and declaring below will require defining the default
-// argument when declaring these as friends in AsyncExecutor which is
-// brittle).
+namespace internal {
 
-template <typename F>
-Future<typename lambda::result_of<F(void)>::type> async(
-    const F& f,
-    typename boost::disable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type* = NULL); // NOLINT(whitespace/line_length)
+// Runs 'f' on one of a bounded pool of threads that is reserved for
+// blocking work (see LIBPROCESS_NUM_BLOCKING_THREADS) and kept
+// separate from the threads that run processes, so that functions
+// which block (e.g., on disk I/O) can't starve the processes. If all
+// of the threads are busy 'f' gets queued.
+void blocking(const std::function<void()>& f);
 
+} // namespace internal {
 
+
+// Provides an abstraction for asynchronously executing a (possibly
+// blocking) function, see 'internal::blocking' above.
 template <typename F>
-Future<Nothing> async(
+Future<typename lambda::result_of<F(void)>::type> async(
     const F& f,
-    typename boost::enable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type* = NULL); // NOLINT(whitespace/line_length)
+    typename boost::disable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type* = NULL) // NOLINT(whitespace/line_length)
+{
+  typedef typename lambda::result_of<F(void)>::type R;
 
+  std::shared_ptr<Promise<R>> promise = std::make_shared<Promise<R>>();
+  Future<R> future = promise->future();
 
-#define TEMPLATE(Z, N, DATA)                                            \
-  template <typename F, ENUM_PARAMS(N, typename A)>                     \
-  Future<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> async( \
-      const F& f,                                                       \
-      ENUM_BINARY_PARAMS(N, A, a),                                      \
-      typename boost::disable_if<boost::is_void<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> >::type* = NULL); /* NOLINT(whitespace/line_length) */ \
-                                                                        \
-                                                                        \
-  template <typename F, ENUM_PARAMS(N, typename A)>                     \
-  Future<Nothing> async(                                                \
-      const F& f,                                                       \
-      ENUM_BINARY_PARAMS(N, A, a),                                      \
-      typename boost::enable_if<boost::is_void<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> >::type* = NULL); // NOLINT(whitespace/line_length)
+  internal::blocking([=]() { promise->set(f()); });
 
-  REPEAT_FROM_TO(1, 11, TEMPLATE, _) // Args A0 -> A9.
-#undef TEMPLATE
+  return future;
+}
 
 
-// TODO(vinod): Merge this into ExecutorProcess.
-class AsyncExecutorProcess : public Process<AsyncExecutorProcess>
+template <typename F>
+Future<Nothing> async(
+    const F& f,
+    typename boost::enable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type* = NULL) // NOLINT(whitespace/line_length)
 {
-private:
-  friend class AsyncExecutor;
-
-  AsyncExecutorProcess() : ProcessBase(ID::generate("__async_executor__")) {}
-  virtual ~AsyncExecutorProcess() {}
+  std::shared_ptr<Promise<Nothing>> promise =
+    std::make_shared<Promise<Nothing>>();
+  Future<Nothing> future = promise->future();
 
-  // Not copyable, not assignable.
-  AsyncExecutorProcess(const AsyncExecutorProcess&);
-  AsyncExecutorProcess& operator = (const AsyncExecutorProcess&);
+  internal::blocking([=]() {
+    f();
+    promise->set(Nothing());
+  });
 
-  template <typename F>
-  typename lambda::result_of<F(void)>::type execute(
-      const F& f,
-      typename boost::disable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type* = NULL) // NOLINT(whitespace/line_length)
-  {
-    terminate(self()); // Terminate process after function returns.
-    return f();
-  }
+  return future;
+}
 
-  template <typename F>
-  Nothing execute(
-      const F& f,
-      typename boost::enable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type* = NULL) // NOLINT(whitespace/line_length)
-  {
-    terminate(self()); // Terminate process after function returns.
-    f();
-    return Nothing();
-  }
 
 #define TEMPLATE(Z, N, DATA)                                            \
   template <typename F, ENUM_PARAMS(N, typename A)>                     \
-  typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type execute(       \
+  Future<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> async( \
       const F& f,                                                       \
       ENUM_BINARY_PARAMS(N, A, a),                                      \
       typename boost::disable_if<boost::is_void<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> >::type* = NULL) /* NOLINT(whitespace/line_length) */ \
   {                                                                     \
-    terminate(self()); /* Terminate process after function returns. */  \
-    return f(ENUM_PARAMS(N, a));                                        \
-  }                                                                     \
+    typedef typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type R;   \
                                                                         \
-  template <typename F, ENUM_PARAMS(N, typename A)>                     \
-  Nothing execute(                                                      \
-      const F& f,                                                       \
-      ENUM_BINARY_PARAMS(N, A, a),                                      \
-      typename boost::enable_if<boost::is_void<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> >::type* = NULL) /* NOLINT(whitespace/line_length) */ \
-  {                                                                     \
-    terminate(self()); /* Terminate process after function returns. */  \
-    f(ENUM_PARAMS(N, a));                                               \
-    return Nothing();                                                   \
-  }
-
-  REPEAT_FROM_TO(1, 11, TEMPLATE, _) // Args A0 -> A9.
-#undef TEMPLATE
-};
-
-
-// This is a wrapper around AsyncExecutorProcess.
-class AsyncExecutor
-{
-private:
-  // Declare async functions as friends.
-  template <typename F>
-  friend Future<typename lambda::result_of<F(void)>::type> async(
-      const F& f,
-      typename boost::disable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type*); // NOLINT(whitespace/line_length)
-
-  template <typename F>
-  friend Future<Nothing> async(
-      const F& f,
-      typename boost::enable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type*); // NOLINT(whitespace/line_length)
-
-#define TEMPLATE(Z, N, DATA)                                            \
-  template <typename F, ENUM_PARAMS(N, typename A)>                     \
-  friend Future<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> async( \
-      const F& f,                                                       \
-      ENUM_BINARY_PARAMS(N, A, a),                                      \
-      typename boost::disable_if<boost::is_void<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> >::type*); /* NOLINT(whitespace/line_length) */ \
+    std::shared_ptr<Promise<R>> promise = std::make_shared<Promise<R>>(); \
+    Future<R> future = promise->future();                               \
                                                                         \
-  template <typename F, ENUM_PARAMS(N, typename A)>                     \
-  friend Future<Nothing> async(                                         \
-      const F& f,                                                       \
-      ENUM_BINARY_PARAMS(N, A, a),                                      \
-      typename boost::enable_if<boost::is_void<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> >::type*); // NOLINT(whitespace/line_length)
-
-  REPEAT_FROM_TO(1, 11, TEMPLATE, _) // Args A0 -> A9.
-#undef TEMPLATE
-
-  AsyncExecutor()
-  {
-    process = new AsyncExecutorProcess();
-    spawn(process, true); // Automatically GC.
-  }
-
-  virtual ~AsyncExecutor() {}
-
-  // Not copyable, not assignable.
-  AsyncExecutor(const AsyncExecutor&);
-  AsyncExecutor& operator = (const AsyncExecutor&);
-
-  template <typename F>
-  Future<typename lambda::result_of<F(void)>::type> execute(
-      const F& f,
-      typename boost::disable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type* = NULL) // NOLINT(whitespace/line_length)
-  {
-    // Need to disambiguate overloaded method.
-    typename lambda::result_of<F(void)>::type(AsyncExecutorProcess::*method)(const F&, typename boost::disable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type*) = // NOLINT(whitespace/line_length)
-      &AsyncExecutorProcess::execute<F>;
-
-    return dispatch(process, method, f, (void*) NULL);
-  }
-
-  template <typename F>
-  Future<Nothing> execute(
-      const F& f,
-      typename boost::enable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type* = NULL) // NOLINT(whitespace/line_length)
-  {
-    // Need to disambiguate overloaded method.
-    Nothing(AsyncExecutorProcess::*method)(const F&, typename boost::enable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type*) = // NOLINT(whitespace/line_length)
-      &AsyncExecutorProcess::execute<F>;
-
-    return dispatch(process, method, f, (void*) NULL);
-  }
-
-#define TEMPLATE(Z, N, DATA)                                            \
-  template <typename F, ENUM_PARAMS(N, typename A)>                     \
-  Future<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> execute( \
-      const F& f,                                                       \
-      ENUM_BINARY_PARAMS(N, A, a),                                      \
-      typename boost::disable_if<boost::is_void<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> >::type* = NULL) /* NOLINT(whitespace/line_length) */ \
-  {                                                                     \
-    /* Need to disambiguate overloaded method. */                       \
-    typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type(AsyncExecutorProcess::*method)(const F&, ENUM_PARAMS(N, A), typename boost::disable_if<boost::is_void<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> >::type*) = /* NOLINT(whitespace/line_length) */ \
-      &AsyncExecutorProcess::execute<F, ENUM_PARAMS(N, A)>;             \
+    internal::blocking([=]() { promise->set(f(ENUM_PARAMS(N, a))); });  \
                                                                         \
-    return dispatch(process, method, f, ENUM_PARAMS(N, a), (void*) NULL); \
+    return future;                                                      \
   }                                                                     \
                                                                         \
   template <typename F, ENUM_PARAMS(N, typename A)>                     \
-  Future<Nothing> execute(                                              \
+  Future<Nothing> async(                                                \
       const F& f,                                                       \
       ENUM_BINARY_PARAMS(N, A, a),                                      \
       typename boost::enable_if<boost::is_void<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> >::type* = NULL) /* NOLINT(whitespace/line_length) */ \
   {                                                                     \
-    /* Need to disambiguate overloaded method. */                       \
-    Nothing(AsyncExecutorProcess::*method)(const F&, ENUM_PARAMS(N, A), typename boost::enable_if<boost::is_void<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> >::type*) = /* NOLINT(whitespace/line_length) */ \
-      &AsyncExecutorProcess::execute<F, ENUM_PARAMS(N, A)>;             \
+    std::shared_ptr<Promise<Nothing>> promise =                         \
+      std::make_shared<Promise<Nothing>>();                             \
+    Future<Nothing> future = promise->future();                         \
                                                                         \
-    return dispatch(process, method, f, ENUM_PARAMS(N, a), (void*) NULL); \
-  }
-
-  REPEAT_FROM_TO(1, 11, TEMPLATE, _) // Args A0 -> A9.
-#undef TEMPLATE
-
-  AsyncExecutorProcess* process;
-};
-
-
-// Provides an abstraction for asynchronously executing a function.
-template <typename F>
-Future<typename lambda::result_of<F(void)>::type> async(
-    const F& f,
-    typename boost::disable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type*) // NOLINT(whitespace/line_length)
-{
-  return AsyncExecutor().execute(f);
-}
-
-
-template <typename F>
-Future<Nothing> async(
-    const F& f,
-    typename boost::enable_if<boost::is_void<typename lambda::result_of<F(void)>::type> >::type*) // NOLINT(whitespace/line_length)
-{
-  return AsyncExecutor().execute(f);
-}
-
-
-#define TEMPLATE(Z, N, DATA)                                            \
-  template <typename F, ENUM_PARAMS(N, typename A)>                     \
-  Future<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> async( \
-      const F& f,                                                       \
-      ENUM_BINARY_PARAMS(N, A, a),                                      \
-      typename boost::disable_if<boost::is_void<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> >::type*) /* NOLINT(whitespace/line_length) */ \
-  {                                                                     \
-    return AsyncExecutor().execute(f, ENUM_PARAMS(N, a));               \
-  }                                                                     \
+    internal::blocking([=]() {                                          \
+      f(ENUM_PARAMS(N, a));                                             \
+      promise->set(Nothing());                                          \
+    });                                                                 \
                                                                         \
-  template <typename F, ENUM_PARAMS(N, typename A)>                     \
-  Future<Nothing> async(                                                \
-      const F& f,                                                       \
-      ENUM_BINARY_PARAMS(N, A, a),                                      \
-      typename boost::enable_if<boost::is_void<typename lambda::result_of<F(ENUM_PARAMS(N, A))>::type> >::type*) /* NOLINT(whitespace/line_length) */ \
-  {                                                                     \
-    return AsyncExecutor().execute(f, ENUM_PARAMS(N, a));               \
+    return future;                                                      \
   }
 
   REPEAT_FROM_TO(1, 11, TEMPLATE, _) // Args A0 -> A9.
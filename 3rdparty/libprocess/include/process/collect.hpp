@@ -1,7 +1,9 @@
 #ifndef __PROCESS_COLLECT_HPP__
 #define __PROCESS_COLLECT_HPP__
 
+#include <atomic>
 #include <list>
+#include <memory>
 #include <tuple>
 
 #include <process/check.hpp>
@@ -10,7 +12,9 @@
 #include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
+#include <stout/synchronized.hpp>
 
 // TODO(bmahler): Move these into a futures.hpp header to group Future
 // related utilities.
@@ -49,118 +53,128 @@ Future<std::tuple<Future<T1>, Future<T2>, Future<T3>>> await(
 
 namespace internal {
 
+// Rather than spawning a process to serialize handling the results
+// of the futures (which costs a process per call and a dispatch per
+// future) the futures complete a shared 'Collect' or 'Await' directly
+// from their callbacks, counting down the futures that are pending
+// with an atomic. Completing the promise more than once is safe (and
+// a no-op) so a failure can race with the last future becoming ready.
+//
+// NOTE: The callbacks on the futures keep the state alive, so the
+// state drops its futures once its promise is completed (or
+// discarded). Otherwise the state and the futures that never
+// complete would keep each other alive.
 template <typename T>
-class CollectProcess : public Process<CollectProcess<T>>
+struct Collect
 {
-public:
-  CollectProcess(
-      const std::list<Future<T>>& _futures,
-      Promise<std::list<T>>* _promise)
+  explicit Collect(const std::list<Future<T>>& _futures)
     : futures(_futures),
-      promise(_promise),
-      ready(0) {}
-
-  virtual ~CollectProcess()
-  {
-    delete promise;
-  }
-
-  virtual void initialize()
-  {
-    // Stop this nonsense if nobody cares.
-    promise->future().onDiscard(defer(this, &CollectProcess::discarded));
-
-    typename std::list<Future<T>>::const_iterator iterator;
-    for (iterator = futures.begin(); iterator != futures.end(); ++iterator) {
-      (*iterator).onAny(defer(this, &CollectProcess::waited, lambda::_1));
-    }
-  }
-
-private:
-  void discarded()
-  {
-    promise->discard();
-    terminate(this);
-  }
+      pending(_futures.size()),
+      lock(ATOMIC_FLAG_INIT) {}
 
   void waited(const Future<T>& future)
   {
     if (future.isFailed()) {
-      promise->fail("Collect failed: " + future.failure());
-      terminate(this);
+      promise.fail("Collect failed: " + future.failure());
+      done();
     } else if (future.isDiscarded()) {
-      promise->fail("Collect failed: future discarded");
-      terminate(this);
+      promise.fail("Collect failed: future discarded");
+      done();
     } else {
       CHECK_READY(future);
-      ready += 1;
-      if (ready == futures.size()) {
+      if (pending.fetch_sub(1) == 1) {
+        // NOTE: There are no futures left if the promise has been
+        // discarded, in which case setting it is a no-op.
         std::list<T> values;
-        foreach (const Future<T>& future, futures) {
-          values.push_back(future.get());
+        synchronized (lock) {
+          foreach (const Future<T>& future, futures) {
+            values.push_back(future.get());
+          }
         }
-        promise->set(values);
-        terminate(this);
+
+        promise.set(std::move(values));
+        done();
       }
     }
   }
 
-  const std::list<Future<T>> futures;
-  Promise<std::list<T>>* promise;
-  size_t ready;
+  void done()
+  {
+    synchronized (lock) {
+      futures.clear();
+    }
+  }
+
+  std::list<Future<T>> futures;
+  std::atomic<size_t> pending;
+  std::atomic_flag lock;
+  Promise<std::list<T>> promise;
 };
 
 
 template <typename T>
-class AwaitProcess : public Process<AwaitProcess<T>>
+struct Await
 {
-public:
-  AwaitProcess(
-      const std::list<Future<T>>& _futures,
-      Promise<std::list<Future<T>>>* _promise)
+  explicit Await(const std::list<Future<T>>& _futures)
     : futures(_futures),
-      promise(_promise),
-      ready(0) {}
+      pending(_futures.size()),
+      lock(ATOMIC_FLAG_INIT) {}
 
-  virtual ~AwaitProcess()
+  void waited(const Future<T>& future)
   {
-    delete promise;
-  }
+    CHECK(!future.isPending());
 
-  virtual void initialize()
-  {
-    // Stop this nonsense if nobody cares.
-    promise->future().onDiscard(defer(this, &AwaitProcess::discarded));
+    if (pending.fetch_sub(1) == 1) {
+      std::list<Future<T>> futures_;
+      synchronized (lock) {
+        futures_ = futures;
+      }
 
-    typename std::list<Future<T>>::const_iterator iterator;
-    for (iterator = futures.begin(); iterator != futures.end(); ++iterator) {
-      (*iterator).onAny(defer(this, &AwaitProcess::waited, lambda::_1));
+      promise.set(futures_);
+      done();
     }
   }
 
-private:
-  void discarded()
+  void done()
   {
-    promise->discard();
-    terminate(this);
+    synchronized (lock) {
+      futures.clear();
+    }
   }
 
-  void waited(const Future<T>& future)
-  {
-    CHECK(!future.isPending());
+  std::list<Future<T>> futures;
+  std::atomic<size_t> pending;
+  std::atomic_flag lock;
+  Promise<std::list<Future<T>>> promise;
+};
 
-    ready += 1;
-    if (ready == futures.size()) {
-      promise->set(futures);
-      terminate(this);
+
+// Registers 'state' to be notified as each of its futures completes
+// and to discard its promise if the caller discards the result.
+template <typename T, typename State>
+void watch(const std::shared_ptr<State>& state)
+{
+  // Stop this nonsense if nobody cares. We only hold a weak reference
+  // to the state so the callback doesn't keep the state alive.
+  std::weak_ptr<State> weak = state;
+  state->promise.future().onDiscard([weak]() {
+    std::shared_ptr<State> state = weak.lock();
+    if (state) {
+      state->promise.discard();
+      state->done();
     }
-  }
+  });
 
-  const std::list<Future<T>> futures;
-  Promise<std::list<Future<T>>>* promise;
-  size_t ready;
-};
+  // NOTE: We iterate over a copy of the futures since the state drops
+  // them as soon as one of the (already completed) futures fails it.
+  const std::list<Future<T>> futures = state->futures;
 
+  foreach (const Future<T>& future, futures) {
+    future.onAny([state](const Future<T>& future) {
+      state->waited(future);
+    });
+  }
+}
 
 } // namespace internal {
 
@@ -173,9 +187,11 @@ inline Future<std::list<T>> collect(
     return std::list<T>();
   }
 
-  Promise<std::list<T>>* promise = new Promise<std::list<T>>();
-  Future<std::list<T>> future = promise->future();
-  spawn(new internal::CollectProcess<T>(futures, promise), true);
+  std::shared_ptr<internal::Collect<T>> state(
+      new internal::Collect<T>(futures));
+
+  Future<std::list<T>> future = state->promise.future();
+  internal::watch<T>(state);
   return future;
 }
 
@@ -188,10 +204,11 @@ inline Future<std::list<Future<T>>> await(
     return futures;
   }
 
-  Promise<std::list<Future<T>>>* promise =
-    new Promise<std::list<Future<T>>>();
-  Future<std::list<Future<T>>> future = promise->future();
-  spawn(new internal::AwaitProcess<T>(futures, promise), true);
+  std::shared_ptr<internal::Await<T>> state(
+      new internal::Await<T>(futures));
+
+  Future<std::list<Future<T>>> future = state->promise.future();
+  internal::watch<T>(state);
   return future;
 }
 
@@ -0,0 +1,194 @@
+#ifndef __PROCESS_COROUTINE_HPP__
+#define __PROCESS_COROUTINE_HPP__
+
+#include <functional>
+#include <memory>
+
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/future.hpp>
+#include <process/pid.hpp>
+
+namespace process {
+
+// Provides stackless coroutines for writing multi-stage asynchronous
+// flows without splitting them into a chain of '.then(defer(...))'
+// continuations. All of the state of the flow lives in the coroutine
+// object (the "frame"), which is allocated once, rather than being
+// copied into the bound arguments of each continuation.
+//
+// A coroutine is a subclass of Coroutine<R> whose 'run' method is
+// written between COROUTINE_BEGIN and COROUTINE_END. Each await
+// stores the future in a member of the frame and suspends until the
+// future is no longer pending, after which 'run' is re-entered right
+// after the await (within the execution context of the process). Any
+// state that must live across an await must be a member of the frame
+// since the locals of 'run' do not survive a suspension. If an
+// awaited future fails or is discarded the coroutine is abandoned
+// and its result is failed or discarded accordingly, just like a
+// '.then' chain.
+//
+//   struct Launch : Coroutine<bool>
+//   {
+//     Launch(const ContainerID& _containerId) : containerId(_containerId) {}
+//
+//     virtual void run()
+//     {
+//       COROUTINE_BEGIN();
+//
+//       COROUTINE_AWAIT(prepared, prepare(containerId));
+//       COROUTINE_AWAIT(forked, fork(containerId, prepared.get()));
+//
+//       COROUTINE_RETURN(forked.get() > 0);
+//
+//       COROUTINE_END();
+//     }
+//
+//     const ContainerID containerId;
+//     Future<Option<CommandInfo>> prepared;
+//     Future<pid_t> forked;
+//   };
+//
+//   Future<bool> launched = coroutine(self(), new Launch(containerId));
+//
+// Discarding the returned future discards the future that the
+// coroutine is currently awaiting (if any).
+template <typename R>
+class Coroutine : public std::enable_shared_from_this<Coroutine<R>>
+{
+public:
+  virtual ~Coroutine() {}
+
+protected:
+  Coroutine() : __state(0) {}
+
+  // The body of the coroutine, see above.
+  virtual void run() = 0;
+
+  // Completes the coroutine, see COROUTINE_RETURN.
+  Promise<R> promise;
+
+  // The following are only meant to be used by the macros below.
+
+  // Where to resume 'run', i.e., the line of the last await.
+  int __state;
+
+  // Returns true if the coroutine must suspend until 'future' is no
+  // longer pending, in which case 'run' will be re-entered from the
+  // process that started the coroutine.
+  template <typename T>
+  bool __suspend(Future<T>* future)
+  {
+    if (!future->isPending()) {
+      return false;
+    }
+
+    std::shared_ptr<Coroutine<R>> self = this->shared_from_this();
+
+    __awaiting = [future]() { future->discard(); };
+
+    future->onAny(defer(pid, [self](const Future<T>&) {
+      self->__awaiting = std::function<void()>();
+      self->run();
+    }));
+
+    // Propagate a discard that happened before we suspended.
+    if (promise.future().hasDiscard()) {
+      future->discard();
+    }
+
+    return true;
+  }
+
+  // Returns true if the coroutine must be abandoned because 'future'
+  // failed or was discarded, in which case the result is completed.
+  template <typename T>
+  bool __abandon(const Future<T>& future)
+  {
+    if (future.isFailed()) {
+      promise.fail(future.failure());
+      return true;
+    } else if (future.isDiscarded()) {
+      promise.discard();
+      return true;
+    }
+    return false;
+  }
+
+private:
+  template <typename T>
+  friend Future<T> coroutine(const UPID& pid, Coroutine<T>* coroutine);
+
+  void discard()
+  {
+    if (__awaiting) {
+      __awaiting();
+    }
+  }
+
+  // The process within which the coroutine runs.
+  UPID pid;
+
+  // Discards the future that the coroutine is awaiting, if any.
+  std::function<void()> __awaiting;
+};
+
+
+// Starts the coroutine within the execution context of the specified
+// process, taking ownership of it. The coroutine is deleted once it
+// is complete (or abandoned).
+template <typename R>
+Future<R> coroutine(const UPID& pid, Coroutine<R>* coroutine)
+{
+  std::shared_ptr<Coroutine<R>> self(coroutine);
+  self->pid = pid;
+
+  Future<R> future = self->promise.future();
+
+  // Use a weak pointer so that the callback doesn't keep the
+  // coroutine (which holds the promise) alive.
+  std::weak_ptr<Coroutine<R>> weak = self;
+
+  future.onDiscard(defer(pid, [weak]() {
+    std::shared_ptr<Coroutine<R>> self = weak.lock();
+    if (self) {
+      self->discard();
+    }
+  }));
+
+  dispatch(pid, std::function<void()>([self]() { self->run(); }));
+
+  return future;
+}
+
+} // namespace process {
+
+
+#define COROUTINE_BEGIN()                                               \
+  switch (this->__state) {                                              \
+    case 0:
+
+
+// Awaits 'expression' (a future) by storing it in 'future' (a member
+// of the coroutine), see above.
+#define COROUTINE_AWAIT(future, expression)                             \
+      future = (expression);                                            \
+      this->__state = __LINE__;                                         \
+      if (this->__suspend(&(future))) {                                 \
+        return;                                                         \
+      }                                                                 \
+    case __LINE__:                                                      \
+      if (this->__abandon(future)) {                                    \
+        return;                                                         \
+      }
+
+
+#define COROUTINE_RETURN(value)                                         \
+      this->promise.set(value);                                         \
+      return;
+
+
+#define COROUTINE_END()                                                 \
+  }
+
+#endif // __PROCESS_COROUTINE_HPP__
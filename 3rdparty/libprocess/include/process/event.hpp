@@ -10,6 +10,7 @@
 
 #include <stout/abort.hpp>
 #include <stout/lambda.hpp>
+#include <stout/stopwatch.hpp>
 
 namespace process {
 
@@ -35,6 +36,11 @@ struct EventVisitor
 
 struct Event
 {
+  Event()
+  {
+    queued.start();
+  }
+
   virtual ~Event() {}
 
   virtual void visit(EventVisitor* visitor) const = 0;
@@ -69,6 +75,10 @@ struct Event
     }
     return *result;
   }
+
+  // Started when the event is created, i.e., tells how long the
+  // event has been waiting to be handled (for instrumentation).
+  Stopwatch queued;
 };
 
 
@@ -78,7 +88,8 @@ struct MessageEvent : Event
     : message(_message) {}
 
   MessageEvent(const MessageEvent& that)
-    : message(that.message == NULL ? NULL : new Message(*that.message)) {}
+    : Event(that),
+      message(that.message == NULL ? NULL : new Message(*that.message)) {}
 
   virtual ~MessageEvent()
   {
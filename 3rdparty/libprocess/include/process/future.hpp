@@ -10,6 +10,7 @@
 #include <memory> // TODO(benh): Replace shared_ptr with unique_ptr.
 #include <set>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <glog/logging.h>
@@ -80,6 +81,7 @@ public:
   Future();
 
   /*implicit*/ Future(const T& _t);
+  /*implicit*/ Future(T&& _t);
 
   template <typename U>
   /*implicit*/ Future(const U& u);
@@ -400,6 +402,11 @@ private:
   // Sets the value for this future, unless the future is already set,
   // failed, or discarded, in which case it returns false.
   bool set(const T& _t);
+  bool set(T&& _t);
+
+  // Helper for 'set' above that copies or moves the value into place.
+  template <typename U>
+  bool _set(U&& u);
 
   // Sets this future as failed, unless the future is already set,
   // failed, or discarded, in which case it returns false.
@@ -489,6 +496,7 @@ public:
 
   bool discard();
   bool set(const T& _t);
+  bool set(T&& _t);
   bool set(const Future<T>& future); // Alias for associate.
   bool associate(const Future<T>& future);
   bool fail(const std::string& message);
@@ -587,6 +595,16 @@ bool Promise<T>::set(const T& t)
 }
 
 
+template <typename T>
+bool Promise<T>::set(T&& t)
+{
+  if (!f.data->associated) {
+    return f.set(std::move(t));
+  }
+  return false;
+}
+
+
 template <typename T>
 bool Promise<T>::set(const Future<T>& future)
 {
@@ -631,8 +649,11 @@ bool Promise<T>::associate(const Future<T>& future)
     // associated.
     f.onDiscard(lambda::bind(&internal::discard<T>, WeakFuture<T>(future)));
 
+    // Need to disambiguate for the compiler.
+    bool (Future<T>::*set)(const T&) = &Future<T>::set;
+
     future
-      .onReady(lambda::bind(&Future<T>::set, f, lambda::_1))
+      .onReady(lambda::bind(set, f, lambda::_1))
       .onFailed(lambda::bind(&Future<T>::fail, f, lambda::_1))
       .onDiscarded(lambda::bind(&internal::discarded<T>, f));
   }
@@ -834,6 +855,14 @@ Future<T>::Future(const T& _t)
 }
 
 
+template <typename T>
+Future<T>::Future(T&& _t)
+  : data(new Data())
+{
+  set(std::move(_t));
+}
+
+
 template <typename T>
 template <typename U>
 Future<T>::Future(const U& u)
@@ -1339,12 +1368,27 @@ Future<T> Future<T>::after(
 
 template <typename T>
 bool Future<T>::set(const T& _t)
+{
+  return _set(_t);
+}
+
+
+template <typename T>
+bool Future<T>::set(T&& _t)
+{
+  return _set(std::move(_t));
+}
+
+
+template <typename T>
+template <typename U>
+bool Future<T>::_set(U&& u)
 {
   bool result = false;
 
   synchronized (data->lock) {
     if (data->state == PENDING) {
-      data->t = new T(_t);
+      data->t = new T(std::forward<U>(u));
       data->state = READY;
       result = true;
     }
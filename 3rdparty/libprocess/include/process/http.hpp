@@ -45,37 +45,6 @@ extern hashmap<uint16_t, std::string> statuses;
 void initialize();
 
 
-struct Request
-{
-  // Contains the client's address. Note that this may
-  // correspond to a proxy or load balancer address.
-  network::Address client;
-
-  // TODO(benh): Add major/minor version.
-  // TODO(bmahler): Header names are not case sensitive! Either make these
-  // case-insensitive, or add a variable for each header in HTTP 1.0/1.1 (like
-  // we've done here with keepAlive).
-  // Tracked by: https://issues.apache.org/jira/browse/MESOS-328.
-  hashmap<std::string, std::string> headers;
-  std::string method;
-
-  // TODO(benh): Replace 'url', 'path', 'query', and 'fragment' with URL.
-  std::string url; // (path?query#fragment)
-  std::string path;
-  hashmap<std::string, std::string> query;
-  std::string fragment;
-
-  std::string body;
-
-  bool keepAlive;
-
-  // Returns whether the encoding is considered acceptable in the request.
-  // TODO(bmahler): Consider this logic being in decoder.hpp, and having the
-  // Request contain a member variable for each popular HTTP 1.0/1.1 header.
-  bool accepts(const std::string& encoding) const;
-};
-
-
 // Represents an asynchronous in-memory unbuffered Pipe, currently
 // used for streaming HTTP responses via chunked encoding. Note that
 // being an in-memory pipe means that this cannot be used across OS
@@ -94,7 +63,8 @@ struct Request
 // No buffering means that each non-empty write to the pipe will
 // correspond to to an equivalent read from the pipe, and the
 // reader must "keep up" with the writer in order to avoid
-// unbounded memory growth.
+// unbounded memory growth (a bounded pipe lets the writer wait
+// for the reader, see 'Writer::writable').
 //
 // TODO(bmahler): The writer needs to be able to induce a failure
 // on the reader to signal an error has occurred. For example, if
@@ -169,6 +139,13 @@ public:
     // was unable to continue reading!
     Future<Nothing> readerClosed();
 
+    // Returns Nothing once the unread data in the pipe is below the
+    // capacity of the pipe (right away if the pipe is unbounded),
+    // or once either end of the pipe is closed or failed. Writers
+    // that want to be flow controlled by the reader should wait on
+    // this before writing more data.
+    Future<Nothing> writable();
+
   private:
     friend class Pipe;
 
@@ -184,7 +161,12 @@ public:
     std::shared_ptr<Data> data;
   };
 
-  Pipe() : data(new Data()) {}
+  // A pipe may be bounded by a 'capacity' (in bytes) of unread
+  // data, in which case 'Writer::writable' can be used to wait for
+  // the reader to catch up. Note that writes beyond the capacity are
+  // still accepted, i.e., the capacity is advisory.
+  explicit Pipe(const Option<size_t>& capacity = None())
+    : data(new Data(capacity)) {}
 
   Reader reader() const;
   Writer writer() const;
@@ -192,10 +174,12 @@ public:
 private:
   struct Data
   {
-    Data()
+    explicit Data(const Option<size_t>& _capacity)
       : lock(ATOMIC_FLAG_INIT),
         readEnd(Reader::OPEN),
-        writeEnd(Writer::OPEN) {}
+        writeEnd(Writer::OPEN),
+        capacity(_capacity),
+        size(0) {}
 
     // Rather than use a process to serialize access to the pipe's
     // internal data we use a 'std::atomic_flag'.
@@ -211,6 +195,14 @@ private:
     // empty strings as they serve as a signal for end-of-file.
     std::queue<std::string> writes;
 
+    // Maximum number of unread bytes, if bounded, and the number of
+    // bytes currently in 'writes'.
+    const Option<size_t> capacity;
+    size_t size;
+
+    // Represents writers waiting for the pipe to be writable.
+    std::queue<Owned<Promise<Nothing>>> writables;
+
     // Signals when the read-end is closed before the write-end.
     Promise<Nothing> readerClosure;
 
@@ -222,6 +214,47 @@ private:
 };
 
 
+struct Request
+{
+  // Contains the client's address. Note that this may
+  // correspond to a proxy or load balancer address.
+  network::Address client;
+
+  // TODO(benh): Add major/minor version.
+  // TODO(bmahler): Header names are not case sensitive! Either make these
+  // case-insensitive, or add a variable for each header in HTTP 1.0/1.1 (like
+  // we've done here with keepAlive).
+  // Tracked by: https://issues.apache.org/jira/browse/MESOS-328.
+  hashmap<std::string, std::string> headers;
+  std::string method;
+
+  // TODO(benh): Replace 'url', 'path', 'query', and 'fragment' with URL.
+  std::string url; // (path?query#fragment)
+  std::string path;
+  hashmap<std::string, std::string> query;
+  std::string fragment;
+
+  std::string body;
+
+  // Set (instead of 'body') for requests whose body is streamed,
+  // i.e., handed to a route installed with 'streaming' (see
+  // ProcessBase::route) while it is still being received. Requests
+  // with a chunked body or a body larger than a threshold are
+  // streamed, unless they are libprocess messages or gzip encoded.
+  // The handler must read the body until end-of-file or close the
+  // reader, since the connection stops receiving data while the
+  // unread data in the pipe is at the pipe's capacity.
+  Option<Pipe::Reader> reader;
+
+  bool keepAlive;
+
+  // Returns whether the encoding is considered acceptable in the request.
+  // TODO(bmahler): Consider this logic being in decoder.hpp, and having the
+  // Request contain a member variable for each popular HTTP 1.0/1.1 header.
+  bool accepts(const std::string& encoding) const;
+};
+
+
 struct Response
 {
   Response()
@@ -248,7 +281,9 @@ struct Response
   // already specified.
   //
   // PATH: Attempts to perform a 'sendfile' operation on the file
-  // found at 'path'.
+  // found at 'path'. A single byte range of the file is sent (with
+  // status '206 Partial Content') if the request has a 'Range'
+  // header and the response status is '200 OK'.
   //
   // PIPE: Splices data from the Pipe 'reader' using a "chunked"
   // 'Transfer-Encoding'. The writer uses a Pipe::Writer to
@@ -331,6 +366,15 @@ struct Accepted : Response
 };
 
 
+struct NotModified : Response
+{
+  NotModified()
+  {
+    status = "304 Not Modified";
+  }
+};
+
+
 struct TemporaryRedirect : Response
 {
   explicit TemporaryRedirect(const std::string& url)
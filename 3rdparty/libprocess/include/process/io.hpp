@@ -71,6 +71,11 @@ Future<Nothing> write(int fd, const std::string& data);
 // redirect output we duplicate the 'from' and 'to' file descriptors
 // so we can control their lifetimes. Returns after EOF has been hit
 // on 'from' or some form of failure has occured.
+//
+// NOTE: On Linux the data is moved with the splice system call (i.e.,
+// without copying it through user space) if either file descriptor
+// is a pipe. Otherwise it is copied in chunks of at least 'chunk'
+// bytes, which grow up to BUFFERED_READ_SIZE while they are filled.
 Future<Nothing> redirect(int from, Option<int> to, size_t chunk = 4096);
 
 } // namespace io {
@@ -1,18 +1,48 @@
 #ifndef __PROCESS_MESSAGE_HPP__
 #define __PROCESS_MESSAGE_HPP__
 
+#include <memory>
 #include <string>
 
+#include <process/address.hpp>
 #include <process/pid.hpp>
 
+#include <stout/option.hpp>
+
 namespace process {
 
 struct Message
 {
+  // The in-memory form of the body of a message sent to a process
+  // within this OS process, which spares the sender serializing it
+  // and the receiver parsing it again (see ProtobufProcess). Those
+  // that need the serialized form should use 'encode' below.
+  struct Payload
+  {
+    virtual ~Payload() {}
+    virtual std::string serialize() const = 0;
+  };
+
+  // Serializes the payload, if any, into the body.
+  void encode()
+  {
+    if (payload && body.empty()) {
+      body = payload->serialize();
+    }
+  }
+
   std::string name;
   UPID from;
   UPID to;
+
+  // The address of the peer the message was actually received from,
+  // i.e., this OS process for local messages or the remote end of the
+  // connection, which unlike 'from' cannot be made up by the sender.
+  // None if it is not known (e.g., messages sent via HTTP).
+  Option<network::Address> peer;
+
   std::string body;
+  std::shared_ptr<const Payload> payload;
 };
 
 } // namespace process {
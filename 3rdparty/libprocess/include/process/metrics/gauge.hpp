@@ -1,13 +1,21 @@
 #ifndef __PROCESS_METRICS_GAUGE_HPP__
 #define __PROCESS_METRICS_GAUGE_HPP__
 
+#include <atomic>
 #include <memory>
 #include <string>
 
+#include <process/clock.hpp>
 #include <process/defer.hpp>
+#include <process/future.hpp>
+#include <process/time.hpp>
 
 #include <process/metrics/metric.hpp>
 
+#include <stout/duration.hpp>
+#include <stout/option.hpp>
+#include <stout/synchronized.hpp>
+
 namespace process {
 namespace metrics {
 
@@ -19,22 +27,58 @@ public:
   // 'name' is the unique name for the instance of Gauge being constructed.
   // It will be the key exposed in the JSON endpoint.
   // 'f' is the deferred object called when the Metric value is requested.
+  // 'ttl', if positive, is how long a value is cached for, i.e., 'f' is
+  // called at most once per 'ttl' and the requests meanwhile (including
+  // concurrent ones while 'f' is pending) share that value. This is
+  // meant for gauges that are expensive to evaluate.
   Gauge(const std::string& name,
-        const Deferred<Future<double> (void)>& f)
+        const Deferred<Future<double> (void)>& f,
+        const Duration& ttl = Duration::zero())
     : Metric(name, None()),
-      data(new Data(f)) {}
+      data(new Data(f, ttl)) {}
 
   virtual ~Gauge() {}
 
-  virtual Future<double> value() const { return data->f(); }
+  virtual Future<double> value() const
+  {
+    if (data->ttl <= Duration::zero()) {
+      return data->f();
+    }
+
+    Future<double> value;
+
+    const Time now = Clock::now();
+
+    synchronized (data->lock) {
+      if (data->value.isNone() ||
+          data->value.get().isFailed() ||
+          data->value.get().isDiscarded() ||
+          now - data->evaluated >= data->ttl) {
+        data->value = data->f();
+        data->evaluated = now;
+      }
+
+      value = data->value.get();
+    }
+
+    return value;
+  }
 
 private:
   struct Data
   {
-    explicit Data(const Deferred<Future<double> (void)>& _f)
-      : f(_f) {}
+    Data(const Deferred<Future<double> (void)>& _f, const Duration& _ttl)
+      : f(_f),
+        ttl(_ttl),
+        lock(ATOMIC_FLAG_INIT) {}
 
     const Deferred<Future<double> (void)> f;
+    const Duration ttl;
+
+    // The cached value, if 'ttl' is positive.
+    std::atomic_flag lock;
+    Option<Future<double>> value;
+    Time evaluated;
   };
 
   std::shared_ptr<Data> data;
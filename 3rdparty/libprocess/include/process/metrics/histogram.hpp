@@ -0,0 +1,229 @@
+#ifndef __PROCESS_METRICS_HISTOGRAM_HPP__
+#define __PROCESS_METRICS_HISTOGRAM_HPP__
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <process/future.hpp>
+#include <process/statistics.hpp>
+
+#include <process/metrics/metric.hpp>
+
+#include <stout/none.hpp>
+#include <stout/option.hpp>
+
+namespace process {
+namespace metrics {
+
+// A Metric that represents the distribution of the recorded values,
+// e.g., of the latencies of a hot path. Unlike a Metric that keeps a
+// window of history, recording a value does not take a lock and the
+// memory used does not depend on how many values are recorded: the
+// values are counted in buckets whose width grows with the value
+// (16 per power of two, i.e., percentiles are within ~3% of the
+// recorded values), and the counts are sharded by thread so that
+// threads recording concurrently do not contend. The shards are
+// merged when the statistics are read. Negative values are recorded
+// as zero.
+class Histogram : public Metric
+{
+public:
+  // 'name' is the unique name for the instance of Histogram being
+  // constructed. This is what will be used as the key in the JSON
+  // endpoint.
+  explicit Histogram(const std::string& name)
+    : Metric(name, None()),
+      data(new Data()) {}
+
+  virtual ~Histogram() {}
+
+  // Returns the number of recorded values.
+  virtual Future<double> value() const
+  {
+    uint64_t count = 0;
+    for (size_t i = 0; i < SHARDS; i++) {
+      for (size_t j = 0; j < BUCKETS; j++) {
+        count += data->shards[i].counts[j].load(std::memory_order_relaxed);
+      }
+    }
+
+    return static_cast<double>(count);
+  }
+
+  virtual Option<Statistics<double>> statistics() const
+  {
+    // Merge the shards.
+    uint64_t counts[BUCKETS] = {};
+    uint64_t count = 0;
+    double min = INFINITY;
+    double max = -INFINITY;
+
+    for (size_t i = 0; i < SHARDS; i++) {
+      const Shard& shard = data->shards[i];
+      for (size_t j = 0; j < BUCKETS; j++) {
+        const uint64_t n = shard.counts[j].load(std::memory_order_relaxed);
+        counts[j] += n;
+        count += n;
+      }
+
+      min = std::min(min, shard.min.load(std::memory_order_relaxed));
+      max = std::max(max, shard.max.load(std::memory_order_relaxed));
+    }
+
+    if (count == 0) {
+      return None();
+    }
+
+    Statistics<double> statistics;
+    statistics.count = count;
+    statistics.min = min;
+    statistics.max = max;
+    statistics.p50 = percentile(counts, count, min, max, 0.5);
+    statistics.p90 = percentile(counts, count, min, max, 0.90);
+    statistics.p95 = percentile(counts, count, min, max, 0.95);
+    statistics.p99 = percentile(counts, count, min, max, 0.99);
+    statistics.p999 = percentile(counts, count, min, max, 0.999);
+    statistics.p9999 = percentile(counts, count, min, max, 0.9999);
+
+    return statistics;
+  }
+
+  void record(double value)
+  {
+    if (!(value > 0.0)) {
+      value = 0.0;
+    }
+
+    Shard& shard =
+      data->shards[std::hash<std::thread::id>()(std::this_thread::get_id()) %
+                   SHARDS];
+
+    shard.counts[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+
+    double min = shard.min.load(std::memory_order_relaxed);
+    while (value < min &&
+           !shard.min.compare_exchange_weak(
+               min, value, std::memory_order_relaxed)) {}
+
+    double max = shard.max.load(std::memory_order_relaxed);
+    while (value > max &&
+           !shard.max.compare_exchange_weak(
+               max, value, std::memory_order_relaxed)) {}
+  }
+
+  // NOTE: Values recorded concurrently might be lost.
+  void reset()
+  {
+    for (size_t i = 0; i < SHARDS; i++) {
+      data->shards[i].reset();
+    }
+  }
+
+private:
+  // Values below 2^(MIN_EXPONENT - 1) are counted in the first
+  // bucket, values of 2^MAX_EXPONENT and above in the last.
+  static const int MIN_EXPONENT = -10;
+  static const int MAX_EXPONENT = 53;
+  static const size_t SUB_BUCKETS = 16;
+  static const size_t BUCKETS =
+    (MAX_EXPONENT - MIN_EXPONENT + 1) * SUB_BUCKETS + 2;
+
+  static const size_t SHARDS = 8;
+
+  // Returns the bucket of 'value', which is not negative.
+  static size_t bucket(double value)
+  {
+    int exponent;
+    const double mantissa = frexp(value, &exponent); // [0.5, 1).
+
+    if (value == 0.0 || exponent < MIN_EXPONENT) {
+      return 0;
+    } else if (exponent > MAX_EXPONENT) {
+      return BUCKETS - 1;
+    }
+
+    const size_t sub = static_cast<size_t>((mantissa - 0.5) * 2 * SUB_BUCKETS);
+
+    return 1 + (exponent - MIN_EXPONENT) * SUB_BUCKETS +
+      std::min(sub, SUB_BUCKETS - 1);
+  }
+
+  // Returns the middle of the values counted in 'bucket'.
+  static double middle(size_t bucket)
+  {
+    if (bucket == 0) {
+      return 0.0;
+    } else if (bucket == BUCKETS - 1) {
+      return ldexp(1.0, MAX_EXPONENT);
+    }
+
+    const int exponent = static_cast<int>((bucket - 1) / SUB_BUCKETS) +
+      MIN_EXPONENT;
+    const size_t sub = (bucket - 1) % SUB_BUCKETS;
+
+    const double mantissa = 0.5 + (sub + 0.5) / (2 * SUB_BUCKETS);
+
+    return ldexp(mantissa, exponent);
+  }
+
+  static double percentile(
+      const uint64_t* counts,
+      uint64_t count,
+      double min,
+      double max,
+      double percentile)
+  {
+    // Like 'Statistics::from', the percentile is the value of rank
+    // 'percentile * (count - 1)' in the sorted values.
+    const uint64_t rank =
+      static_cast<uint64_t>(floor(percentile * (count - 1)));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+      seen += counts[i];
+      if (seen > rank) {
+        return std::max(min, std::min(max, middle(i)));
+      }
+    }
+
+    return max;
+  }
+
+  struct Shard
+  {
+    Shard() { reset(); }
+
+    void reset()
+    {
+      for (size_t i = 0; i < BUCKETS; i++) {
+        counts[i].store(0, std::memory_order_relaxed);
+      }
+
+      min.store(INFINITY, std::memory_order_relaxed);
+      max.store(-INFINITY, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> counts[BUCKETS];
+    std::atomic<double> min;
+    std::atomic<double> max;
+  };
+
+  struct Data
+  {
+    Shard shards[SHARDS];
+  };
+
+  std::shared_ptr<Data> data;
+};
+
+} // namespace metrics {
+} // namespace process {
+
+#endif // __PROCESS_METRICS_HISTOGRAM_HPP__
@@ -1,7 +1,10 @@
 #ifndef __PROCESS_METRICS_METRICS_HPP__
 #define __PROCESS_METRICS_METRICS_HPP__
 
+#include <map>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -12,6 +15,7 @@
 #include <process/metrics/metric.hpp>
 
 #include <stout/hashmap.hpp>
+#include <stout/json.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
 
@@ -25,6 +29,9 @@ class MetricsProcess : public Process<MetricsProcess>
 public:
   static MetricsProcess* instance();
 
+  // NOTE: These can be called from any thread (rather than being
+  // dispatched), since the metrics are kept in a registry that is
+  // synchronized separately from the process (see 'Shard' below).
   Future<Nothing> add(Owned<Metric> metric);
 
   Future<Nothing> remove(const std::string& name);
@@ -48,17 +55,47 @@ private:
   Future<http::Response> _snapshot(const http::Request& request);
   static std::list<Future<double> > _snapshotTimeout(
       const std::list<Future<double> >& futures);
-  static Future<http::Response> __snapshot(
-      const http::Request& request,
+  static JSON::Object __snapshot(
       const Option<Duration>& timeout,
       const hashmap<std::string, Future<double> >& metrics,
       const hashmap<std::string, Option<Statistics<double> > >& statistics);
 
-  // The Owned<Metric> is an explicit copy of the Metric passed to 'add'.
-  hashmap<std::string, Owned<Metric> > metrics;
+  // Evaluates the metrics whose names start with 'prefix' (all if
+  // none), waiting at most 'timeout' for the values.
+  Future<JSON::Object> evaluate(
+      const Option<Duration>& timeout,
+      const Option<std::string>& prefix);
+
+  // The metrics are partitioned into shards by the hash of their
+  // names, each with its own lock, so that adding and removing
+  // metrics from different threads rarely contends, and a snapshot
+  // only holds the lock of one shard at a time. The metrics of a
+  // shard are sorted by name so that the metrics with a given prefix
+  // can be looked up without visiting all of them.
+  struct Shard
+  {
+    std::mutex mutex;
+
+    // The Owned<Metric> is an explicit copy of the Metric passed to
+    // 'add'.
+    std::map<std::string, Owned<Metric>> metrics;
+  };
+
+  static const size_t SHARDS = 16;
+
+  Shard& shard(const std::string& name);
+
+  // Returns the metrics whose names start with 'prefix' (all if none).
+  std::vector<Owned<Metric>> find(const Option<std::string>& prefix);
+
+  Shard shards[SHARDS];
 
   // Used to rate limit the endpoint.
   RateLimiter limiter;
+
+  // The last evaluation of the metrics without a timeout, which is
+  // shared by the requests while it is pending.
+  Option<Future<JSON::Object>> snapshotting;
 };
 
 }  // namespace internal {
@@ -69,19 +106,14 @@ Future<Nothing> add(const T& metric)
 {
   // There is an explicit copy in this call to ensure we end up owning
   // the last copy of a Metric when we remove it.
-  return dispatch(
-      internal::MetricsProcess::instance(),
-      &internal::MetricsProcess::add,
+  return internal::MetricsProcess::instance()->add(
       Owned<Metric>(new T(metric)));
 }
 
 
 inline Future<Nothing> remove(const Metric& metric)
 {
-  return dispatch(
-      internal::MetricsProcess::instance(),
-      &internal::MetricsProcess::remove,
-      metric.name());
+  return internal::MetricsProcess::instance()->remove(metric.name());
 }
 
 }  // namespace metrics {
@@ -75,6 +75,20 @@ public:
     return t;
   }
 
+  // Record the duration of an event timed elsewhere (e.g., the round
+  // trip of a message).
+  void record(const Duration& duration)
+  {
+    double value;
+
+    synchronized (data->lock) {
+      data->lastValue = T(duration).value();
+      value = data->lastValue.get();
+    }
+
+    push(value);
+  }
+
   // Time an asynchronous event.
   template<typename U>
   Future<U> time(const Future<U>& future)
@@ -97,16 +111,7 @@ private:
 
   static void _time(Time start, Timer that)
   {
-    const Time stop = Clock::now();
-
-    double value;
-
-    synchronized (that.data->lock) {
-      that.data->lastValue = T(stop - start).value();
-      value = that.data->lastValue.get();
-    }
-
-    that.push(value);
+    that.record(Clock::now() - start);
   }
 
   std::shared_ptr<Data> data;
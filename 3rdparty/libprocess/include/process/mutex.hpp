@@ -4,10 +4,12 @@
 #include <atomic>
 #include <memory>
 #include <queue>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/owned.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/nothing.hpp>
 #include <stout/synchronized.hpp>
 
@@ -39,12 +41,20 @@ public:
   {
     // NOTE: We need to grab the promise 'date->promises.front()' but
     // set it outside of the critical section because setting it might
-    // trigger callbacks that try to reacquire the lock.
+    // trigger callbacks that try to reacquire the lock. Likewise for
+    // the promises of the waiters that have been discarded, which are
+    // skipped rather than handed the lock.
     Owned<Promise<Nothing>> promise;
+    std::vector<Owned<Promise<Nothing>>> discarded;
 
     synchronized (data->lock) {
+      while (!data->promises.empty() &&
+             data->promises.front()->future().hasDiscard()) {
+        discarded.push_back(data->promises.front());
+        data->promises.pop();
+      }
+
       if (!data->promises.empty()) {
-        // TODO(benh): Skip a future that has been discarded?
         promise = data->promises.front();
         data->promises.pop();
       } else {
@@ -52,6 +62,10 @@ public:
       }
     }
 
+    foreach (const Owned<Promise<Nothing>>& promise, discarded) {
+      promise->discard();
+    }
+
     if (promise.get() != NULL) {
       promise->set(Nothing());
     }
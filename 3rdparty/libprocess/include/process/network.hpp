@@ -92,6 +92,20 @@ inline Try<Address> address(int s)
   return Address::create(storage);
 }
 
+
+// Returns the address of the remote end of the connected socket 's'.
+inline Try<Address> peer(int s)
+{
+  struct sockaddr_storage storage;
+  socklen_t storagelen = sizeof(storage);
+
+  if(::getpeername(s, (struct sockaddr*) &storage, &storagelen) < 0) {
+    return ErrnoError("Failed to getpeername");
+  }
+
+  return Address::create(storage);
+}
+
 } // namespace network {
 } // namespace process {
 
@@ -4,8 +4,11 @@
 #include <stdint.h>
 #include <pthread.h>
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <queue>
+#include <set>
 
 #include <process/address.hpp>
 #include <process/clock.hpp>
@@ -19,10 +22,14 @@
 #include <stout/duration.hpp>
 #include <stout/lambda.hpp>
 #include <stout/option.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/thread.hpp>
 
 namespace process {
 
+// Forward declaration.
+class EventQueue;
+
 class ProcessBase : public EventVisitor
 {
 public:
@@ -72,6 +79,14 @@ protected:
       const char* data = NULL,
       size_t length = 0);
 
+  // Sends a message with an in-memory payload to PID, which is only
+  // serialized if PID is not within this OS process (or if anything
+  // else than the receiver needs the body, see Message::encode).
+  void send(
+      const UPID& to,
+      const std::string& name,
+      const std::shared_ptr<const Message::Payload>& payload);
+
   // Links with the specified PID. Linking with a process from within
   // the same "operating system process" is guaranteed to give you
   // perfect monitoring of that process. However, linking with a
@@ -121,24 +136,29 @@ protected:
   typedef lambda::function<Future<http::Response>(const http::Request&)>
   HttpRequestHandler;
 
-  // Setup a handler for an HTTP request.
+  // Setup a handler for an HTTP request. A 'streaming' handler
+  // may be handed a request whose body is still being received
+  // (see 'http::Request::reader'), while the body is read in full
+  // before invoking any other handler.
   void route(
       const std::string& name,
       const Option<std::string>& help,
-      const HttpRequestHandler& handler);
+      const HttpRequestHandler& handler,
+      bool streaming = false);
 
   template <typename T>
   void route(
       const std::string& name,
       const Option<std::string>& help,
-      Future<http::Response> (T::*method)(const http::Request&))
+      Future<http::Response> (T::*method)(const http::Request&),
+      bool streaming = false)
   {
     // Note that we use dynamic_cast here so a process can use
     // multiple inheritance if it sees so fit (e.g., to implement
     // multiple callback interfaces).
     HttpRequestHandler handler =
       lambda::bind(method, dynamic_cast<T*>(this), lambda::_1);
-    route(name, help, handler);
+    route(name, help, handler, streaming);
   }
 
   // Provide the static asset(s) at the specified _absolute_ path for
@@ -173,18 +193,21 @@ protected:
     pthread_mutex_unlock(&m);
   }
 
+  // Returns the number of events of the specified type that are
+  // waiting to be serviced. Since the events of a process can only be
+  // inspected by the thread running the process this must be called
+  // from within the process (e.g., via 'defer' in a Gauge).
   template<typename T>
   size_t eventCount()
   {
-    size_t count = 0U;
-
-    lock();
-    count = std::count_if(events.begin(), events.end(), isEventType<T>);
-    unlock();
-
-    return count;
+    return eventCount(isEventType<T>);
   }
 
+  // Returns how long the oldest event waiting to be serviced has been
+  // queued (zero if there are none), i.e., how far behind the process
+  // is. Like 'eventCount' this must be called from within the process.
+  Duration eventAge();
+
 private:
   friend class SocketManager;
   friend class ProcessManager;
@@ -192,14 +215,20 @@ private:
   friend void* schedule(void*);
 
   // Process states.
-  enum {
+  enum State
+  {
     BOTTOM,
     READY,
     RUNNING,
     BLOCKED,
     TERMINATING,
     TERMINATED
-  } state;
+  };
+
+  // The state can be read without holding the lock. Transitions into
+  // and out of BLOCKED are done while holding the lock, all other
+  // transitions are done by the thread running the process.
+  std::atomic<State> state;
 
   template<typename T>
   static bool isEventType(const Event* event)
@@ -214,6 +243,10 @@ private:
   // Enqueue the specified message, request, or function call.
   void enqueue(Event* event, bool inject = false);
 
+  // Returns the number of (injected or regular) events that satisfy
+  // the predicate, see 'eventCount' above.
+  size_t eventCount(bool (*predicate)(const Event*));
+
   // Delegates for messages.
   std::map<std::string, UPID> delegates;
 
@@ -221,6 +254,9 @@ private:
   struct {
     std::map<std::string, MessageHandler> message;
     std::map<std::string, HttpRequestHandler> http;
+
+    // The HTTP handlers that stream request bodies.
+    std::set<std::string> streaming;
   } handlers;
 
   // Definition of a static asset.
@@ -233,14 +269,51 @@ private:
   // Static assets(s) to provide.
   std::map<std::string, Asset> assets;
 
-  // Queue of received events, requires lock()ed access!
-  std::deque<Event*> events;
+  // Queues of received events; injected events are serviced before
+  // any regular events. Any thread can enqueue but only the thread
+  // running the process can dequeue or inspect (see EventQueue).
+  EventQueue* events;
+  EventQueue* injected;
 
   // Active references.
   int refs;
 
+  // Index of the worker thread (and its run queue) that this process
+  // last ran on, or -1 if it has not yet run. The ProcessManager uses
+  // this to resume a process on the same thread when possible.
+  // NOTE: This is atomic since it's written by the worker thread that
+  // dequeues the process while any thread might be enqueuing it.
+  std::atomic<int> affinity;
+
   // Process PID.
   UPID pid;
+
+  // Accounting of where the time of this process goes, exposed at
+  // /__processes__. Only the thread running the process updates it.
+  struct Accounting
+  {
+    Accounting()
+      : resumes(0),
+        events(0),
+        running(0),
+        queued(0),
+        runnable(0) {}
+
+    uint64_t resumes;
+
+    // The number of events handled, how long handling them took and
+    // how long they were queued, in nanoseconds.
+    uint64_t events;
+    uint64_t running;
+    uint64_t queued;
+
+    // How long the process waited for a worker thread once it had
+    // events to handle, in nanoseconds.
+    uint64_t runnable;
+  } accounting;
+
+  // Started when the process is put on a run queue, see 'runnable'.
+  Stopwatch readied;
 };
 
 
@@ -21,11 +21,13 @@ protected:
   {
     route("/start", START_HELP(), &Profiler::start);
     route("/stop", STOP_HELP(), &Profiler::stop);
+    route("/heap", HEAP_HELP(), &Profiler::heap);
   }
 
 private:
   static const std::string START_HELP();
   static const std::string STOP_HELP();
+  static const std::string HEAP_HELP();
 
   // HTTP endpoints.
 
@@ -37,6 +39,12 @@ private:
   // in the working directory.
   Future<http::Response> stop(const http::Request& request);
 
+  // Returns a sample of the heap allocations. There are no request
+  // parameters. This requires the process to be started with
+  // TCMALLOC_SAMPLE_PARAMETER set in the environment, otherwise the
+  // sample is empty.
+  Future<http::Response> heap(const http::Request& request);
+
   bool started;
 };
 
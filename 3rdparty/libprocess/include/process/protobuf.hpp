@@ -3,18 +3,33 @@
 
 #include <glog/logging.h>
 
+#include <google/protobuf/descriptor.h>
 #include <google/protobuf/message.h>
 #include <google/protobuf/repeated_field.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/wire_format_lite_inl.h>
 
+#include <google/protobuf/io/coded_stream.h>
+
+#include <memory>
 #include <set>
+#include <string>
+#include <typeinfo>
 #include <vector>
 
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/process.hpp>
 
+#include <process/metrics/histogram.hpp>
+#include <process/metrics/metrics.hpp>
+
+#include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
+#include <stout/stopwatch.hpp>
 
 
 // Provides an implementation of process::post that for a protobuf.
@@ -38,6 +53,150 @@ inline void post(const process::UPID& from,
   post(from, to, message.GetTypeName(), data.data(), data.size());
 }
 
+
+// The payload of a protobuf message sent in memory to a process
+// within this OS process (see ProtobufProcess::send).
+struct ProtobufPayload : Message::Payload
+{
+  explicit ProtobufPayload(
+      const std::shared_ptr<const google::protobuf::Message>& _message)
+    : message(_message) {}
+
+  virtual std::string serialize() const
+  {
+    std::string data;
+    message->SerializeToString(&data);
+    return data;
+  }
+
+  const std::shared_ptr<const google::protobuf::Message> message;
+};
+
+
+// A protobuf message which is only parsed when it is first accessed,
+// passed to the handlers installed for it as such (see
+// ProtobufProcess::install). This lets a handler drop a message based
+// on its sender or a field it peeks at without parsing all of it.
+// NOTE: It refers to the message being handled, so it must not be
+// used after the handler returns.
+template <typename M>
+class Lazy
+{
+public:
+  explicit Lazy(Message* _message)
+    : message(_message), parsed(false), m(NULL) {}
+
+  // Returns the message, parsing it on the first call, or NULL if it
+  // could not be parsed.
+  const M* get() const
+  {
+    if (parsed) {
+      return m;
+    }
+
+    parsed = true;
+
+    const ProtobufPayload* payload =
+      dynamic_cast<const ProtobufPayload*>(message->payload.get());
+
+    if (payload != NULL && typeid(*payload->message) == typeid(M)) {
+      m = static_cast<const M*>(payload->message.get());
+    } else {
+      message->encode();
+      storage.reset(new M());
+      storage->ParseFromString(message->body);
+      m = storage.get();
+    }
+
+    if (!m->IsInitialized()) {
+      LOG(WARNING) << "Initialization errors: "
+                   << m->InitializationErrorString();
+      m = NULL;
+    }
+
+    return m;
+  }
+
+  // Returns the (non repeated) message field 'number' of the message
+  // while skipping over all the other fields, or None if the message
+  // does not have the field or it could not be parsed.
+  template <typename F>
+  Option<F> peek(int number) const
+  {
+    // There is nothing to save if the message is parsed already or
+    // was sent in memory (see ProtobufProcess::send).
+    if (parsed || message->payload) {
+      const M* message = get();
+      if (message == NULL) {
+        return None();
+      }
+
+      const google::protobuf::FieldDescriptor* field =
+        M::descriptor()->FindFieldByNumber(number);
+
+      CHECK(field != NULL && !field->is_repeated() &&
+            field->message_type() == F::descriptor())
+        << "Message " << M::descriptor()->full_name()
+        << " does not have a field " << number << " of type "
+        << F::descriptor()->full_name();
+
+      const google::protobuf::Reflection* reflection =
+        message->GetReflection();
+
+      if (!reflection->HasField(*message, field)) {
+        return None();
+      }
+
+      F f;
+      f.CopyFrom(reflection->GetMessage(*message, field));
+      return f;
+    }
+
+    using google::protobuf::internal::WireFormatLite;
+
+    google::protobuf::io::CodedInputStream stream(
+        reinterpret_cast<const google::protobuf::uint8*>(
+            message->body.data()),
+        message->body.size());
+
+    // NOTE: A message field might be split across occurrences of its
+    // tag, which are merged as the full parse would.
+    F f;
+    bool found = false;
+
+    for (google::protobuf::uint32 tag = stream.ReadTag();
+         tag != 0;
+         tag = stream.ReadTag()) {
+      if (WireFormatLite::GetTagFieldNumber(tag) == number &&
+          WireFormatLite::GetTagWireType(tag) ==
+            WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+        if (!WireFormatLite::ReadMessageNoVirtual(&stream, &f)) {
+          return None();
+        }
+        found = true;
+      } else if (!WireFormatLite::SkipField(&stream, tag)) {
+        return None();
+      }
+    }
+
+    if (!found || !f.IsInitialized()) {
+      return None();
+    }
+
+    return f;
+  }
+
+private:
+  Lazy(const Lazy&);
+  Lazy& operator=(const Lazy&);
+
+  Message* message;
+
+  mutable bool parsed;
+  mutable const M* m;
+  mutable std::unique_ptr<M> storage;
+};
+
 } // namespace process {
 
 
@@ -80,24 +239,60 @@ template <typename T>
 class ProtobufProcess : public process::Process<T>
 {
 public:
-  virtual ~ProtobufProcess() {}
+  ProtobufProcess() : sampling(0) {}
+
+  virtual ~ProtobufProcess()
+  {
+    foreachvalue (const Instrumentation& instrumentation, instrumentations) {
+      process::metrics::remove(instrumentation.queued);
+      process::metrics::remove(instrumentation.handled);
+    }
+  }
 
 protected:
   virtual void visit(const process::MessageEvent& event)
   {
-    if (protobufHandlers.count(event.message->name) > 0) {
+    if (protobufHandlers.count(event.message->name) > 0 ||
+        lazyHandlers.count(event.message->name) > 0) {
       from = event.message->from; // For 'reply'.
-      protobufHandlers[event.message->name](
-          event.message->from, event.message->body);
+      if (sampling > 0) {
+        instrumented(event);
+      } else {
+        handle(event);
+      }
       from = process::UPID();
     } else {
       process::Process<T>::visit(event);
     }
   }
 
+  // Instruments the handlers of the protobuf messages: for one in
+  // 'sampling' messages of each type, records how long the message
+  // was queued and how long its handler took in the histograms
+  // '<prefix><message>/queued_us' and '<prefix><message>/handled_us'.
+  void instrument(const std::string& _prefix, size_t _sampling)
+  {
+    prefix = _prefix;
+    sampling = _sampling;
+  }
+
   void send(const process::UPID& to,
             const google::protobuf::Message& message)
   {
+    // A message to a process within this OS process is handed over
+    // in memory, which saves serializing and parsing it (a copy is
+    // still needed as the caller might change the message later).
+    if (to.address == this->self().address) {
+      std::shared_ptr<google::protobuf::Message> copy(message.New());
+      copy->CopyFrom(message);
+
+      process::Process<T>::send(
+          to,
+          message.GetTypeName(),
+          std::make_shared<const process::ProtobufPayload>(copy));
+      return;
+    }
+
     std::string data;
     message.SerializeToString(&data);
     process::Process<T>::send(to, message.GetTypeName(),
@@ -109,11 +304,22 @@ protected:
   void reply(const google::protobuf::Message& message)
   {
     CHECK(from) << "Attempting to reply without a sender";
-    std::string data;
-    message.SerializeToString(&data);
     send(from, message);
   }
 
+  // Installs a handler which is passed the message unparsed (see
+  // process::Lazy), to let it drop messages without parsing them.
+  template <typename M>
+  void install(
+      void (T::*method)(const process::UPID&, const process::Lazy<M>&))
+  {
+    T* t = static_cast<T*>(this);
+    lazyHandlers[M().GetTypeName()] =
+      lambda::bind(&lazyHandlerM<M>,
+                   t, method,
+                   lambda::_1, lambda::_2);
+  }
+
   // TODO(vinod): Use ENUM_PARAMS for the overloads.
   // Installs that take the sender as the first argument.
   template <typename M>
@@ -125,7 +331,7 @@ protected:
       lambda::bind(&handlerM<M>,
                    t, method,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M>
@@ -137,7 +343,7 @@ protected:
       lambda::bind(&handler0,
                    t, method,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M,
@@ -152,7 +358,7 @@ protected:
       lambda::bind(&handler1<M, P1, P1C>,
                    t, method, param1,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M,
@@ -169,7 +375,7 @@ protected:
       lambda::bind(&handler2<M, P1, P1C, P2, P2C>,
                    t, method, p1, p2,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M,
@@ -188,7 +394,7 @@ protected:
       lambda::bind(&handler3<M, P1, P1C, P2, P2C, P3, P3C>,
                    t, method, p1, p2, p3,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M,
@@ -209,7 +415,7 @@ protected:
       lambda::bind(&handler4<M, P1, P1C, P2, P2C, P3, P3C, P4, P4C>,
                    t, method, p1, p2, p3, p4,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M,
@@ -232,7 +438,7 @@ protected:
       lambda::bind(&handler5<M, P1, P1C, P2, P2C, P3, P3C, P4, P4C, P5, P5C>,
                    t, method, p1, p2, p3, p4, p5,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M,
@@ -258,7 +464,7 @@ protected:
                                 P4, P4C, P5, P5C, P6, P6C>,
                    t, method, p1, p2, p3, p4, p5, p6,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   // Installs that do not take the sender.
@@ -271,7 +477,7 @@ protected:
       lambda::bind(&_handlerM<M>,
                    t, method,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M>
@@ -283,7 +489,7 @@ protected:
       lambda::bind(&_handler0,
                    t, method,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M,
@@ -298,7 +504,7 @@ protected:
       lambda::bind(&_handler1<M, P1, P1C>,
                    t, method, param1,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M,
@@ -315,7 +521,7 @@ protected:
       lambda::bind(&_handler2<M, P1, P1C, P2, P2C>,
                    t, method, p1, p2,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M,
@@ -334,7 +540,7 @@ protected:
       lambda::bind(&_handler3<M, P1, P1C, P2, P2C, P3, P3C>,
                    t, method, p1, p2, p3,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M,
@@ -355,7 +561,7 @@ protected:
       lambda::bind(&_handler4<M, P1, P1C, P2, P2C, P3, P3C, P4, P4C>,
                    t, method, p1, p2, p3, p4,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M,
@@ -378,7 +584,7 @@ protected:
       lambda::bind(&_handler5<M, P1, P1C, P2, P2C, P3, P3C, P4, P4C, P5, P5C>,
                    t, method, p1, p2, p3, p4, p5,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   template <typename M,
@@ -404,7 +610,7 @@ protected:
                                  P4, P4C, P5, P5C, P6, P6C>,
                    t, method, p1, p2, p3, p4, p5, p6,
                    lambda::_1, lambda::_2);
-    delete m;
+    prototypes[m->GetTypeName()].reset(m);
   }
 
   using process::Process<T>::install;
@@ -416,23 +622,27 @@ private:
       T* t,
       void (T::*method)(const process::UPID&, const M&),
       const process::UPID& sender,
-      const std::string& data)
+      const google::protobuf::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(sender, m);
-    } else {
-      LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
-    }
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(sender, m);
+  }
+
+  template <typename M>
+  static void lazyHandlerM(
+      T* t,
+      void (T::*method)(const process::UPID&, const process::Lazy<M>&),
+      const process::UPID& sender,
+      process::Message* message)
+  {
+    (t->*method)(sender, process::Lazy<M>(message));
   }
 
   static void handler0(
       T* t,
       void (T::*method)(const process::UPID&),
       const process::UPID& sender,
-      const std::string& data)
+      const google::protobuf::Message&)
   {
     (t->*method)(sender);
   }
@@ -444,16 +654,10 @@ private:
       void (T::*method)(const process::UPID&, P1C),
       P1 (M::*p1)() const,
       const process::UPID& sender,
-      const std::string& data)
+      const google::protobuf::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(sender, google::protobuf::convert((&m->*p1)()));
-    } else {
-      LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
-    }
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(sender, google::protobuf::convert((&m->*p1)()));
   }
 
   template <typename M,
@@ -465,18 +669,12 @@ private:
       P1 (M::*p1)() const,
       P2 (M::*p2)() const,
       const process::UPID& sender,
-      const std::string& data)
-  {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()));
-    } else {
-      LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
-    }
+      const google::protobuf::Message& message)
+  {
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(sender,
+                 google::protobuf::convert((&m->*p1)()),
+                 google::protobuf::convert((&m->*p2)()));
   }
 
   template <typename M,
@@ -490,19 +688,13 @@ private:
       P2 (M::*p2)() const,
       P3 (M::*p3)() const,
       const process::UPID& sender,
-      const std::string& data)
-  {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()));
-    } else {
-      LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
-    }
+      const google::protobuf::Message& message)
+  {
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(sender,
+                 google::protobuf::convert((&m->*p1)()),
+                 google::protobuf::convert((&m->*p2)()),
+                 google::protobuf::convert((&m->*p3)()));
   }
 
   template <typename M,
@@ -518,20 +710,14 @@ private:
       P3 (M::*p3)() const,
       P4 (M::*p4)() const,
       const process::UPID& sender,
-      const std::string& data)
-  {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()));
-    } else {
-      LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
-    }
+      const google::protobuf::Message& message)
+  {
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(sender,
+                 google::protobuf::convert((&m->*p1)()),
+                 google::protobuf::convert((&m->*p2)()),
+                 google::protobuf::convert((&m->*p3)()),
+                 google::protobuf::convert((&m->*p4)()));
   }
 
   template <typename M,
@@ -549,21 +735,15 @@ private:
       P4 (M::*p4)() const,
       P5 (M::*p5)() const,
       const process::UPID& sender,
-      const std::string& data)
-  {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()),
-                   google::protobuf::convert((&m->*p5)()));
-    } else {
-      LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
-    }
+      const google::protobuf::Message& message)
+  {
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(sender,
+                 google::protobuf::convert((&m->*p1)()),
+                 google::protobuf::convert((&m->*p2)()),
+                 google::protobuf::convert((&m->*p3)()),
+                 google::protobuf::convert((&m->*p4)()),
+                 google::protobuf::convert((&m->*p5)()));
   }
 
   template <typename M,
@@ -583,22 +763,16 @@ private:
       P5 (M::*p5)() const,
       P6 (M::*p6)() const,
       const process::UPID& sender,
-      const std::string& data)
-  {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(sender,
-                   google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()),
-                   google::protobuf::convert((&m->*p5)()),
-                   google::protobuf::convert((&m->*p6)()));
-    } else {
-      LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
-    }
+      const google::protobuf::Message& message)
+  {
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(sender,
+                 google::protobuf::convert((&m->*p1)()),
+                 google::protobuf::convert((&m->*p2)()),
+                 google::protobuf::convert((&m->*p3)()),
+                 google::protobuf::convert((&m->*p4)()),
+                 google::protobuf::convert((&m->*p5)()),
+                 google::protobuf::convert((&m->*p6)()));
   }
 
 
@@ -608,23 +782,17 @@ private:
       T* t,
       void (T::*method)(const M&),
       const process::UPID&,
-      const std::string& data)
+      const google::protobuf::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(m);
-    } else {
-      LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
-    }
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(m);
   }
 
   static void _handler0(
       T* t,
       void (T::*method)(),
       const process::UPID&,
-      const std::string& data)
+      const google::protobuf::Message&)
   {
     (t->*method)();
   }
@@ -636,16 +804,10 @@ private:
       void (T::*method)(P1C),
       P1 (M::*p1)() const,
       const process::UPID&,
-      const std::string& data)
+      const google::protobuf::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()));
-    } else {
-      LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
-    }
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(google::protobuf::convert((&m->*p1)()));
   }
 
   template <typename M,
@@ -657,17 +819,11 @@ private:
       P1 (M::*p1)() const,
       P2 (M::*p2)() const,
       const process::UPID&,
-      const std::string& data)
+      const google::protobuf::Message& message)
   {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()));
-    } else {
-      LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
-    }
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(google::protobuf::convert((&m->*p1)()),
+                 google::protobuf::convert((&m->*p2)()));
   }
 
   template <typename M,
@@ -681,18 +837,12 @@ private:
       P2 (M::*p2)() const,
       P3 (M::*p3)() const,
       const process::UPID&,
-      const std::string& data)
-  {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()));
-    } else {
-      LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
-    }
+      const google::protobuf::Message& message)
+  {
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(google::protobuf::convert((&m->*p1)()),
+                 google::protobuf::convert((&m->*p2)()),
+                 google::protobuf::convert((&m->*p3)()));
   }
 
   template <typename M,
@@ -708,19 +858,13 @@ private:
       P3 (M::*p3)() const,
       P4 (M::*p4)() const,
       const process::UPID&,
-      const std::string& data)
-  {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()));
-    } else {
-      LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
-    }
+      const google::protobuf::Message& message)
+  {
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(google::protobuf::convert((&m->*p1)()),
+                 google::protobuf::convert((&m->*p2)()),
+                 google::protobuf::convert((&m->*p3)()),
+                 google::protobuf::convert((&m->*p4)()));
   }
 
   template <typename M,
@@ -738,20 +882,14 @@ private:
       P4 (M::*p4)() const,
       P5 (M::*p5)() const,
       const process::UPID&,
-      const std::string& data)
-  {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()),
-                   google::protobuf::convert((&m->*p5)()));
-    } else {
-      LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
-    }
+      const google::protobuf::Message& message)
+  {
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(google::protobuf::convert((&m->*p1)()),
+                 google::protobuf::convert((&m->*p2)()),
+                 google::protobuf::convert((&m->*p3)()),
+                 google::protobuf::convert((&m->*p4)()),
+                 google::protobuf::convert((&m->*p5)()));
   }
 
   template <typename M,
@@ -771,27 +909,117 @@ private:
       P5 (M::*p5)() const,
       P6 (M::*p6)() const,
       const process::UPID&,
-      const std::string& data)
-  {
-    M m;
-    m.ParseFromString(data);
-    if (m.IsInitialized()) {
-      (t->*method)(google::protobuf::convert((&m->*p1)()),
-                   google::protobuf::convert((&m->*p2)()),
-                   google::protobuf::convert((&m->*p3)()),
-                   google::protobuf::convert((&m->*p4)()),
-                   google::protobuf::convert((&m->*p5)()),
-                   google::protobuf::convert((&m->*p6)()));
+      const google::protobuf::Message& message)
+  {
+    const M& m = static_cast<const M&>(message);
+    (t->*method)(google::protobuf::convert((&m->*p1)()),
+                 google::protobuf::convert((&m->*p2)()),
+                 google::protobuf::convert((&m->*p3)()),
+                 google::protobuf::convert((&m->*p4)()),
+                 google::protobuf::convert((&m->*p5)()),
+                 google::protobuf::convert((&m->*p6)()));
+  }
+
+  // Parses the message of the event (unless it was sent in memory,
+  // see 'send', or its handler parses it lazily) and invokes its
+  // handler.
+  void handle(const process::MessageEvent& event)
+  {
+    const std::string& name = event.message->name;
+
+    if (lazyHandlers.contains(name)) {
+      lazyHandlers[name](event.message->from, event.message);
+      return;
+    }
+    const google::protobuf::Message& prototype = *prototypes[name];
+
+    const google::protobuf::Message* message = NULL;
+    std::unique_ptr<google::protobuf::Message> parsed;
+
+    const process::ProtobufPayload* payload =
+      dynamic_cast<const process::ProtobufPayload*>(
+          event.message->payload.get());
+
+    if (payload != NULL && typeid(*payload->message) == typeid(prototype)) {
+      message = payload->message.get();
     } else {
+      event.message->encode();
+      parsed.reset(prototype.New());
+      parsed->ParseFromString(event.message->body);
+      message = parsed.get();
+    }
+
+    if (!message->IsInitialized()) {
       LOG(WARNING) << "Initialization errors: "
-                   << m.InitializationErrorString();
+                   << message->InitializationErrorString();
+      return;
     }
+
+    protobufHandlers[name](event.message->from, *message);
   }
 
   typedef lambda::function<
-      void(const process::UPID&, const std::string&)> handler;
+      void(const process::UPID&, const google::protobuf::Message&)> handler;
   hashmap<std::string, handler> protobufHandlers;
 
+  typedef lambda::function<
+      void(const process::UPID&, process::Message*)> lazyHandler;
+  hashmap<std::string, lazyHandler> lazyHandlers;
+
+  // An instance of each message type with a handler, to parse them.
+  hashmap<std::string, std::shared_ptr<google::protobuf::Message>> prototypes;
+
+  struct Instrumentation
+  {
+    explicit Instrumentation(const std::string& name)
+      : queued(name + "/queued_us"),
+        handled(name + "/handled_us"),
+        messages(0) {}
+
+    process::metrics::Histogram queued;
+    process::metrics::Histogram handled;
+
+    // The number of messages, to sample one in 'sampling'.
+    size_t messages;
+  };
+
+  void instrumented(const process::MessageEvent& event)
+  {
+    const std::string& name = event.message->name;
+
+    typename hashmap<std::string, Instrumentation>::iterator iterator =
+      instrumentations.find(name);
+
+    if (iterator == instrumentations.end()) {
+      iterator = instrumentations.insert(
+          std::make_pair(name, Instrumentation(prefix + name))).first;
+
+      process::metrics::add(iterator->second.queued);
+      process::metrics::add(iterator->second.handled);
+    }
+
+    Instrumentation& instrumentation = iterator->second;
+
+    if (instrumentation.messages++ % sampling != 0) {
+      handle(event);
+      return;
+    }
+
+    instrumentation.queued.record(
+        event.queued.elapsed().ns() / 1000.0);
+
+    Stopwatch stopwatch;
+    stopwatch.start();
+
+    handle(event);
+
+    instrumentation.handled.record(stopwatch.elapsed().ns() / 1000.0);
+  }
+
+  std::string prefix;
+  size_t sampling;
+  hashmap<std::string, Instrumentation> instrumentations;
+
   // Sender of "current" message, inaccessible by subclasses.
   // This is only used for reply().
   process::UPID from;
@@ -5,45 +5,69 @@
 #include <deque>
 #include <memory>
 #include <queue>
+#include <utility>
 
 #include <process/future.hpp>
 #include <process/owned.hpp>
 
+#include <stout/none.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/synchronized.hpp>
 
 namespace process {
 
+// An asynchronous queue. A queue may be bounded by a 'capacity', in
+// which case a 'put' into a full queue is held back (i.e., the
+// returned future stays pending) until a 'get' makes room for it,
+// which lets a consumer push back on a faster producer.
 template <typename T>
 class Queue
 {
 public:
-  Queue() : data(new Data()) {}
+  explicit Queue(const Option<size_t>& capacity = None())
+    : data(new Data(capacity)) {}
 
-  void put(const T& t)
+  // Returns a future that is satisfied once the element is in the
+  // queue (or has been handed to a waiting 'get'), which is right
+  // away unless the queue is bounded and full.
+  Future<Nothing> put(const T& t)
   {
     // NOTE: We need to grab the promise 'date->promises.front()' but
     // set it outside of the critical section because setting it might
     // trigger callbacks that try to reacquire the lock.
     Owned<Promise<T>> promise;
 
+    Future<Nothing> future = Nothing();
+
     synchronized (data->lock) {
-      if (data->promises.empty()) {
-        data->elements.push(t);
-      } else {
+      if (!data->promises.empty()) {
         promise = data->promises.front();
         data->promises.pop_front();
+      } else if (data->capacity.isSome() &&
+                 data->elements.size() >= data->capacity.get()) {
+        Owned<Promise<Nothing>> put(new Promise<Nothing>());
+        data->puts.push_back(std::make_pair(t, put));
+        future = put->future();
+      } else {
+        data->elements.push(t);
       }
     }
 
     if (promise.get() != NULL) {
       promise->set(t);
     }
+
+    return future;
   }
 
   Future<T> get()
   {
     Future<T> future;
 
+    // A held back 'put' that got room in the queue.
+    Owned<Promise<Nothing>> put;
+
     synchronized (data->lock) {
       if (data->elements.empty()) {
         data->promises.push_back(Owned<Promise<T>>(new Promise<T>()));
@@ -51,16 +75,27 @@ public:
       } else {
         future = Future<T>(data->elements.front());
         data->elements.pop();
+
+        if (!data->puts.empty()) {
+          data->elements.push(data->puts.front().first);
+          put = data->puts.front().second;
+          data->puts.pop_front();
+        }
       }
     }
 
+    if (put.get() != NULL) {
+      put->set(Nothing());
+    }
+
     return future;
   }
 
 private:
   struct Data
   {
-    Data() : lock(ATOMIC_FLAG_INIT) {}
+    explicit Data(const Option<size_t>& _capacity)
+      : lock(ATOMIC_FLAG_INIT), capacity(_capacity) {}
 
     ~Data()
     {
@@ -71,11 +106,17 @@ private:
     // internal data we use a 'std::atomic_flag'.
     std::atomic_flag lock;
 
+    // Maximum number of elements in the queue, if bounded.
+    const Option<size_t> capacity;
+
     // Represents "waiters" for elements from the queue.
     std::deque<Owned<Promise<T>>> promises;
 
     // Represents elements already put in the queue.
     std::queue<T> elements;
+
+    // Represents elements held back because the queue is full.
+    std::deque<std::pair<T, Owned<Promise<Nothing>>>> puts;
   };
 
   std::shared_ptr<Data> data;
@@ -0,0 +1,117 @@
+#ifndef __PROCESS_SEMAPHORE_HPP__
+#define __PROCESS_SEMAPHORE_HPP__
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <queue>
+
+#include <process/future.hpp>
+#include <process/owned.hpp>
+
+#include <stout/nothing.hpp>
+#include <stout/synchronized.hpp>
+
+namespace process {
+
+// An asynchronous counting semaphore, i.e., a Mutex (see mutex.hpp)
+// that can be held by up to 'permits' callers at the same time. This
+// is useful for bounding the number of outstanding asynchronous
+// operations of a fan out, e.g., the number of concurrent usage
+// requests to a containerizer:
+//
+//   Semaphore semaphore(16);
+//
+//   foreach (const ContainerID& containerId, containerIds) {
+//     futures.push_back(
+//         semaphore.run([=]() { return containerizer->usage(containerId); }));
+//   }
+class Semaphore
+{
+public:
+  explicit Semaphore(size_t permits) : data(new Data(permits)) {}
+
+  // Returns a future that becomes ready once a permit is acquired.
+  Future<Nothing> acquire()
+  {
+    Future<Nothing> future = Nothing();
+
+    synchronized (data->lock) {
+      if (data->permits > 0) {
+        data->permits--;
+      } else {
+        Owned<Promise<Nothing>> promise(new Promise<Nothing>());
+        data->promises.push(promise);
+        future = promise->future();
+      }
+    }
+
+    return future;
+  }
+
+  void release()
+  {
+    // NOTE: We need to grab the promise 'data->promises.front()' but
+    // set it outside of the critical section because setting it might
+    // trigger callbacks that try to reacquire the lock.
+    Owned<Promise<Nothing>> promise;
+
+    synchronized (data->lock) {
+      if (!data->promises.empty()) {
+        promise = data->promises.front();
+        data->promises.pop();
+      } else {
+        data->permits++;
+      }
+    }
+
+    if (promise.get() != NULL) {
+      promise->set(Nothing());
+    }
+  }
+
+  // Invokes 'f' once a permit is acquired and releases the permit
+  // once the future returned by 'f' is no longer pending.
+  template <typename T>
+  Future<T> run(const std::function<Future<T>()>& f)
+  {
+    // Hold a reference to the data (rather than this semaphore) in
+    // case the semaphore is destructed before 'f' completes.
+    std::shared_ptr<Data> data = this->data;
+
+    return acquire()
+      .then([f]() { return f(); })
+      .onAny([data]() { Semaphore(data).release(); });
+  }
+
+  template <typename F>
+  auto run(const F& f) -> decltype(f())
+  {
+    return run(std::function<decltype(f())()>(f));
+  }
+
+private:
+  struct Data
+  {
+    explicit Data(size_t _permits)
+      : lock(ATOMIC_FLAG_INIT), permits(_permits) {}
+
+    // Rather than use a process to serialize access to the
+    // semaphore's internal data we use a 'std::atomic_flag'.
+    std::atomic_flag lock;
+
+    // The number of permits that are currently available.
+    size_t permits;
+
+    // Represents "waiters" for a permit.
+    std::queue<Owned<Promise<Nothing>>> promises;
+  };
+
+  explicit Semaphore(const std::shared_ptr<Data>& _data) : data(_data) {}
+
+  std::shared_ptr<Data> data;
+};
+
+} // namespace process {
+
+#endif // __PROCESS_SEMAPHORE_HPP__
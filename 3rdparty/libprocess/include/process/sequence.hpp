@@ -1,27 +1,42 @@
 #ifndef __PROCESS_SEQUENCE_HPP__
 #define __PROCESS_SEQUENCE_HPP__
 
+#include <atomic>
+
 #include <glog/logging.h>
 
 #include <process/future.hpp>
 #include <process/owned.hpp>
-#include <process/process.hpp>
 
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
+#include <stout/synchronized.hpp>
 
 namespace process {
 
-// Forward declaration.
-class SequenceProcess;
-
 // Provides an abstraction that serializes the execution of a sequence
 // of callbacks.
+//
+// NOTE: Rather than use a process to serialize access to the
+// sequence we use a 'std::atomic_flag' (like Mutex), so adding a
+// callback does not require a dispatch. As a consequence, a callback
+// that can be invoked right away (i.e., the futures returned by the
+// previously registered callbacks are already in non-pending status)
+// is invoked within 'add', so callbacks that need to run within a
+// process should be deferred (e.g., 'defer(self(), ...)').
 class Sequence
 {
 public:
-  Sequence();
-  ~Sequence();
+  Sequence() : lock(ATOMIC_FLAG_INIT), last(Nothing()) {}
+
+  ~Sequence()
+  {
+    // Discard all the pending callbacks.
+    last.discard();
+
+    // TODO(jieyu): Do we need to wait for the future of the last
+    // callback to be in DISCARDED state?
+  }
 
   // Registers a callback that will be invoked when all the futures
   // returned by the previously registered callbacks are in
@@ -35,23 +50,6 @@ public:
   // returned future. Other callbacks in this sequence will NOT be
   // affected. The subsequent callbacks will not be invoked until the
   // future is actually DISCARDED.
-  template <typename T>
-  Future<T> add(const lambda::function<Future<T>(void)>& callback);
-
-private:
-  // Not copyable, not assignable.
-  Sequence(const Sequence&);
-  Sequence& operator = (const Sequence&);
-
-  SequenceProcess* process;
-};
-
-
-class SequenceProcess : public Process<SequenceProcess>
-{
-public:
-  SequenceProcess() : last(Nothing()) {}
-
   template <typename T>
   Future<T> add(const lambda::function<Future<T>(void)>& callback)
   {
@@ -88,14 +86,9 @@ public:
     // callback is done, signal the notifier ('N').
     promise->future().onAny(lambda::bind(&completed, notifier));
 
-    // Setup the "notification" from previous 'N' to 'F' so that when
-    // a notifier ('N') is set (indicating the previous callback has
-    // completed), invoke the next callback ('F') in the sequence.
-    last.onAny(lambda::bind(&notified<T>, promise, callback));
-
     // In the following, we setup the hooks so that if this sequence
-    // process is being terminated, all pending callbacks will be
-    // discarded. We use weak futures here to avoid cyclic dependencies.
+    // is being destructed, all pending callbacks will be discarded.
+    // We use weak futures here to avoid cyclic dependencies.
 
     // Discard the future associated with this notifier.
     notifier->future().onDiscard(
@@ -103,28 +96,37 @@ public:
             &internal::discard<T>,
             WeakFuture<T>(promise->future())));
 
+    // Update the 'last'. The callbacks are ordered by the order in
+    // which they replace 'last', which is the only thing that needs
+    // to be done atomically.
+    Future<Nothing> previous;
+
+    synchronized (lock) {
+      previous = last;
+      last = notifier->future();
+    }
+
     // Discard the notifier associated with the previous future.
     notifier->future().onDiscard(
         lambda::bind(
             &internal::discard<Nothing>,
-            WeakFuture<Nothing>(last)));
+            WeakFuture<Nothing>(previous)));
 
-    // Update the 'last'.
-    last = notifier->future();
+    // Setup the "notification" from previous 'N' to 'F' so that when
+    // a notifier ('N') is set (indicating the previous callback has
+    // completed), invoke the next callback ('F') in the sequence.
+    // NOTE: This is done outside of the critical section because the
+    // callback might get invoked right away and add to this sequence.
+    previous.onAny(lambda::bind(&notified<T>, promise, callback));
 
     return promise->future();
   }
 
-protected:
-  virtual void finalize()
-  {
-    last.discard();
-
-    // TODO(jieyu): Do we need to wait for the future of the last
-    // callback to be in DISCARDED state?
-  }
-
 private:
+  // Not copyable, not assignable.
+  Sequence(const Sequence&);
+  Sequence& operator = (const Sequence&);
+
   // Invoked when a callback is done.
   static void completed(Owned<Promise<Nothing> > notifier)
   {
@@ -147,31 +149,12 @@ private:
     }
   }
 
+  std::atomic_flag lock;
+
+  // The notifier of the last registered callback.
   Future<Nothing> last;
 };
 
-
-inline Sequence::Sequence()
-{
-  process = new SequenceProcess();
-  process::spawn(process);
-}
-
-
-inline Sequence::~Sequence()
-{
-  process::terminate(process);
-  process::wait(process);
-  delete process;
-}
-
-
-template <typename T>
-Future<T> Sequence::add(const lambda::function<Future<T>(void)>& callback)
-{
-  return dispatch(process, &SequenceProcess::add<T>, callback);
-}
-
 } // namespace process {
 
 #endif // __PROCESS_SEQUENCE_HPP__
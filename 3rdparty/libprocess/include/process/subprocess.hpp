@@ -44,6 +44,11 @@ public:
     bool isPath() const { return mode == PATH; }
     bool isFd() const { return mode == FD; }
 
+    // The file descriptor (FD mode) or the file (PATH mode) to
+    // redirect to, if any.
+    const Option<int>& descriptor() const { return fd; }
+    const Option<std::string>& filename() const { return path; }
+
   private:
     friend class Subprocess;
 
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <glog/logging.h>
+
+#include <process/async.hpp>
+
+#include <stout/numify.hpp>
+#include <stout/try.hpp>
+
+namespace process {
+namespace internal {
+
+// A fixed number of threads that run the functions passed to
+// 'blocking' in the order they were added. Unlike the worker threads
+// these threads are expected to block, so a busy pool only delays
+// other blocking work rather than the execution of processes.
+class BlockingPool
+{
+public:
+  explicit BlockingPool(size_t threads)
+  {
+    CHECK_GT(threads, 0u);
+
+    // The threads are never joined, the pool lives as long as the
+    // program (just like the worker threads).
+    for (size_t i = 0; i < threads; i++) {
+      std::thread(&BlockingPool::run, this).detach();
+    }
+  }
+
+  void add(const std::function<void()>& f)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    functions.push_back(f);
+    notEmpty.notify_one();
+  }
+
+private:
+  void run()
+  {
+    while (true) {
+      std::function<void()> f;
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (functions.empty()) {
+          notEmpty.wait(lock);
+        }
+
+        f = functions.front();
+        functions.pop_front();
+      }
+
+      f();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable notEmpty;
+  std::deque<std::function<void()>> functions;
+};
+
+
+// Returns the number of blocking threads, which defaults to the
+// number of worker threads unless overridden by the environment.
+static size_t threads()
+{
+  const char* value = getenv("LIBPROCESS_NUM_BLOCKING_THREADS");
+  if (value != NULL) {
+    Try<size_t> threads = numify<size_t>(value);
+    if (threads.isError() || threads.get() == 0) {
+      LOG(FATAL) << "LIBPROCESS_NUM_BLOCKING_THREADS=" << value
+                 << " is not a positive number";
+    }
+    return threads.get();
+  }
+
+  return std::max(8L, sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+
+void blocking(const std::function<void()>& f)
+{
+  // Created on first use, never deleted (see above).
+  static BlockingPool* pool = new BlockingPool(threads());
+
+  pool->add(f);
+}
+
+} // namespace internal {
+} // namespace process {
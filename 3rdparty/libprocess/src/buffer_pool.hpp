@@ -0,0 +1,93 @@
+#ifndef __BUFFER_POOL_HPP__
+#define __BUFFER_POOL_HPP__
+
+#include <stddef.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <process/metrics/counter.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/synchronized.hpp>
+
+namespace process {
+
+// A pool of fixed size buffers, used for the buffers we receive data
+// into on sockets so that buffers get reused across connections
+// rather than allocated (and freed) per connection. At most
+// 'capacity' released buffers are kept around, anything beyond that
+// gets freed.
+//
+// The hit rate of the pool can be derived from the '<name>/hits' and
+// '<name>/misses' counters. NOTE: The counters are not added to the
+// metrics by the pool since a pool might be needed before the
+// metrics process is running (see process::initialize).
+class BufferPool
+{
+public:
+  BufferPool(const std::string& name, size_t _size, size_t _capacity)
+    : hits(name + "/hits"),
+      misses(name + "/misses"),
+      size(_size),
+      capacity(_capacity) {}
+
+  ~BufferPool()
+  {
+    foreach (char* buffer, buffers) {
+      delete[] buffer;
+    }
+  }
+
+  // Returns a buffer of 'size' bytes, the contents of the buffer are
+  // undefined.
+  char* allocate()
+  {
+    synchronized (mutex) {
+      if (!buffers.empty()) {
+        char* buffer = buffers.back();
+        buffers.pop_back();
+        ++hits;
+        return buffer;
+      }
+    }
+
+    ++misses;
+    return new char[size];
+  }
+
+  // Returns a buffer (obtained via 'allocate') to the pool.
+  void release(char* buffer)
+  {
+    synchronized (mutex) {
+      if (buffers.size() < capacity) {
+        buffers.push_back(buffer);
+        return;
+      }
+    }
+
+    delete[] buffer;
+  }
+
+  metrics::Counter hits;
+  metrics::Counter misses;
+
+  // The size of each buffer.
+  const size_t size;
+
+private:
+  // Not copyable, not assignable.
+  BufferPool(const BufferPool&);
+  BufferPool& operator = (const BufferPool&);
+
+  const size_t capacity;
+
+  std::vector<char*> buffers;
+
+  std::mutex mutex;
+};
+
+} // namespace process {
+
+#endif // __BUFFER_POOL_HPP__
@@ -1,35 +1,65 @@
 #ifndef __DECODER_HPP__
 #define __DECODER_HPP__
 
+#include <arpa/inet.h>
 #include <http_parser.h>
+#include <limits.h>
+#include <string.h>
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <deque>
 #include <string>
 #include <vector>
 
 #include <process/http.hpp>
+#include <process/message.hpp>
+#include <process/owned.hpp>
 #include <process/socket.hpp>
 
 #include <stout/foreach.hpp>
 #include <stout/gzip.hpp>
 #include <stout/option.hpp>
+#include <stout/strings.hpp>
 #include <stout/try.hpp>
 
+#include "encoder.hpp"
+
 
 // TODO(bmahler): Switch to joyent/http-parser now that it is no
 // longer being hosted under ry/http-parser.
 
 namespace process {
 
+// The largest (remaining) chunk or body length that the DataDecoder
+// reserves memory for upfront.
+const uint64_t DECODER_RESERVE_LIMIT = 64 * 1024 * 1024;
+
+// The largest message frame that the MessageDecoder accepts by
+// default (see LIBPROCESS_MAX_MESSAGE_SIZE).
+const size_t DEFAULT_MAX_MESSAGE_SIZE = 256 * 1024 * 1024;
+
+// Request bodies larger than this (or chunked ones) are streamed to
+// the handler (see 'http::Request::reader'), through a pipe with
+// this capacity.
+const uint64_t DECODER_STREAMING_THRESHOLD = 64 * 1024;
+
 // TODO(benh): Make DataDecoder abstract and make RequestDecoder a
 // concrete subclass.
 class DataDecoder
 {
 public:
-  explicit DataDecoder(const network::Socket& _s)
-    : s(_s), failure(false), request(NULL)
+  // Request bodies larger than 'maxBodySize' (if any) are rejected
+  // as a decoding failure.
+  explicit DataDecoder(
+      const network::Socket& _s,
+      const Option<size_t>& _maxBodySize = None())
+    : s(_s),
+      maxBodySize(_maxBodySize),
+      failure(false),
+      request(NULL),
+      length(0)
   {
     settings.on_message_begin = &DataDecoder::on_message_begin;
 
@@ -51,6 +81,17 @@ public:
     parser.data = this;
   }
 
+  ~DataDecoder()
+  {
+    // Let the handler of a partially received body know that the
+    // rest of it is not coming.
+    if (writer.isSome()) {
+      writer.get().fail("Connection closed");
+    }
+
+    delete request;
+  }
+
   std::deque<http::Request*> decode(const char* data, size_t length)
   {
     size_t parsed = http_parser_execute(&parser, &settings, data, length);
@@ -79,6 +120,18 @@ public:
     return s;
   }
 
+  // Returns a future that is satisfied once the handler of the
+  // request whose body is being streamed (if any) has caught up,
+  // i.e., when more data can be received.
+  Future<Nothing> writable()
+  {
+    if (writer.isSome()) {
+      return writer.get().writable();
+    }
+
+    return Nothing();
+  }
+
 private:
   static int on_message_begin(http_parser* p)
   {
@@ -90,6 +143,9 @@ private:
     decoder->field.clear();
     decoder->value.clear();
     decoder->query.clear();
+    decoder->length = 0;
+
+    CHECK(decoder->writer.isNone());
 
     CHECK(decoder->request == NULL);
 
@@ -209,14 +265,103 @@ private:
 
     decoder->request->keepAlive = http_should_keep_alive(&decoder->parser);
 
+    if (decoder->streamable()) {
+      // The request is handed off before its body, so the query is
+      // parsed now (if it can't be, we let 'on_message_complete'
+      // fail the request as usual).
+      Try<hashmap<std::string, std::string>> decoded =
+        http::query::decode(decoder->query);
+
+      if (decoded.isSome()) {
+        http::Pipe pipe(DECODER_STREAMING_THRESHOLD);
+
+        decoder->request->query = decoded.get();
+        decoder->request->reader = pipe.reader();
+        decoder->writer = pipe.writer();
+
+        decoder->requests.push_back(decoder->request);
+        decoder->request = NULL;
+      }
+    }
+
     return 0;
   }
 
+  // Returns whether the body of the current request should be
+  // streamed, see 'http::Request::reader'.
+  bool streamable()
+  {
+    CHECK_NOTNULL(request);
+
+    // Libprocess messages are delivered as a whole.
+    Option<std::string> agent = request->headers.get("User-Agent");
+    if (request->headers.contains("Libprocess-From") ||
+        (agent.isSome() && agent.get().find("libprocess/") == 0)) {
+      return false;
+    }
+
+    // We decompress the body as a whole.
+    Option<std::string> encoding = request->headers.get("Content-Encoding");
+    if (encoding.isSome() && encoding.get() == "gzip") {
+      return false;
+    }
+
+    Option<std::string> transfer = request->headers.get("Transfer-Encoding");
+    if (transfer.isSome() && strings::lower(transfer.get()) == "chunked") {
+      return true;
+    }
+
+    // NOTE: The 'content_length' is -1 (or ULLONG_MAX, depending on
+    // the version of the parser) if there is no 'Content-Length'.
+    return parser.content_length > 0 &&
+      static_cast<uint64_t>(parser.content_length) != ULLONG_MAX &&
+      static_cast<uint64_t>(parser.content_length) >
+        DECODER_STREAMING_THRESHOLD;
+  }
+
   static int on_body(http_parser* p, const char* data, size_t length)
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
+
+    decoder->length += length;
+
+    if (decoder->maxBodySize.isSome() &&
+        decoder->length > decoder->maxBodySize.get()) {
+      LOG(WARNING) << "Rejecting request with a body larger than "
+                   << decoder->maxBodySize.get() << " bytes";
+
+      if (decoder->writer.isSome()) {
+        decoder->writer.get().fail("Request body is too large");
+        decoder->writer = None();
+      }
+
+      return 1;
+    }
+
+    if (decoder->writer.isSome()) {
+      // NOTE: The write fails (and the data is dropped) if the
+      // handler has closed the reader, i.e., lost interest.
+      decoder->writer.get().write(std::string(data, length));
+      return 0;
+    }
+
     CHECK_NOTNULL(decoder->request);
-    decoder->request->body.append(data, length);
+
+    std::string& body = decoder->request->body;
+
+    // Grow the body only once per chunk (or content length) rather
+    // than repeatedly while a large body is received in pieces.
+    // NOTE: While in 'on_body' the parser's 'content_length' is the
+    // remaining length of the chunk (or body) including 'length'.
+    // We do not trust a sender with exceptionally large reservations.
+    if (p->content_length > 0 &&
+        static_cast<uint64_t>(p->content_length) > length &&
+        static_cast<uint64_t>(p->content_length) <= DECODER_RESERVE_LIMIT &&
+        body.capacity() < body.size() + p->content_length) {
+      body.reserve(body.size() + p->content_length);
+    }
+
+    body.append(data, length);
     return 0;
   }
 
@@ -224,6 +369,13 @@ private:
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
 
+    // The request of a streamed body has already been handed off.
+    if (decoder->writer.isSome()) {
+      decoder->writer.get().close();
+      decoder->writer = None();
+      return 0;
+    }
+
     // Parse the query key/values.
     Try<hashmap<std::string, std::string>> decoded =
       http::query::decode(decoder->query);
@@ -256,6 +408,8 @@ private:
 
   const network::Socket s; // The socket this decoder is associated with.
 
+  const Option<size_t> maxBodySize;
+
   bool failure;
 
   http_parser parser;
@@ -272,10 +426,123 @@ private:
 
   http::Request* request;
 
+  // The length of the body of the current request so far.
+  size_t length;
+
+  // The write-end of the pipe of the body being streamed, if any.
+  Option<http::Pipe::Writer> writer;
+
   std::deque<http::Request*> requests;
 };
 
 
+// Decodes messages framed by the BinaryMessageEncoder. Receivers
+// determine whether a peer uses the binary framing (rather than
+// HTTP) from the first byte it sends on a connection, since an HTTP
+// request can never start with 'BinaryMessageEncoder::MAGIC'.
+class MessageDecoder
+{
+public:
+  // Frames larger than 'maxSize' fail the decoder, the lengths in a
+  // frame header being whatever the (unauthenticated) peer sent.
+  explicit MessageDecoder(size_t _maxSize = DEFAULT_MAX_MESSAGE_SIZE)
+    : maxSize(_maxSize),
+      failure(false) {}
+
+  std::deque<Message*> decode(const char* data, size_t length)
+  {
+    std::deque<Message*> messages;
+
+    if (failure) {
+      return messages;
+    }
+
+    buffer.append(data, length);
+
+    size_t offset = 0;
+
+    while (buffer.size() - offset >= BinaryMessageEncoder::HEADER_SIZE) {
+      const char* header = buffer.data() + offset;
+
+      if (header[0] != BinaryMessageEncoder::MAGIC ||
+          header[1] != BinaryMessageEncoder::FORMAT) {
+        failure = true;
+        break;
+      }
+
+      const size_t name = decode16(header + 2);
+      const size_t from = decode16(header + 4);
+      const size_t to = decode16(header + 6);
+      const size_t body = decode32(header + 8);
+
+      const size_t size =
+        BinaryMessageEncoder::HEADER_SIZE + name + from + to + body;
+
+      if (size > maxSize) {
+        VLOG(1) << "Message frame of " << size << " bytes exceeds the "
+                << "maximum of " << maxSize << " bytes";
+        failure = true;
+        break;
+      }
+
+      if (buffer.size() - offset < size) {
+        // Make sure the remainder of the frame fits without growing
+        // the buffer repeatedly, but only reserve so much upfront as
+        // the peer may never send the rest (like the DataDecoder).
+        buffer.reserve(
+            offset + std::min<size_t>(size, DECODER_RESERVE_LIMIT));
+        break;
+      }
+
+      const char* strings = header + BinaryMessageEncoder::HEADER_SIZE;
+
+      Message* message = new Message();
+      message->name.assign(strings, name);
+      message->from = UPID(std::string(strings + name, from));
+      // NOTE: Only the ID of the receiver is sent, the receiving
+      // side fills in its own address.
+      message->to.id.assign(strings + name + from, to);
+      message->body.assign(strings + name + from + to, body);
+
+      messages.push_back(message);
+
+      offset += size;
+    }
+
+    buffer.erase(0, offset);
+
+    return messages;
+  }
+
+  bool failed() const
+  {
+    return failure;
+  }
+
+private:
+  static uint16_t decode16(const char* data)
+  {
+    uint16_t value;
+    memcpy(&value, data, sizeof(value));
+    return ntohs(value);
+  }
+
+  static uint32_t decode32(const char* data)
+  {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return ntohl(value);
+  }
+
+  const size_t maxSize;
+
+  bool failure;
+
+  // Data received but not yet decoded (i.e., a partial frame).
+  std::string buffer;
+};
+
+
 class ResponseDecoder
 {
 public:
@@ -634,12 +901,14 @@ private:
       return 1;
     }
 
-    // We cannot provide streaming gzip decompression!
+    // We can only provide the gzip encoding, which gets decompressed
+    // while the body is being streamed.
     Option<std::string> encoding =
       decoder->response->headers.get("Content-Encoding");
     if (encoding.isSome() && encoding.get() == "gzip") {
-      decoder->failure = true;
-      return 1;
+      decoder->decompressor.reset(new gzip::Decompressor());
+    } else {
+      decoder->decompressor.reset();
     }
 
     CHECK(decoder->writer.isNone());
@@ -663,7 +932,23 @@ private:
     CHECK_SOME(decoder->writer);
 
     http::Pipe::Writer writer = decoder->writer.get(); // Remove const.
-    writer.write(std::string(data, length));
+
+    if (decoder->decompressor.get() != NULL) {
+      Try<std::string> decompressed =
+        decoder->decompressor->decompress(std::string(data, length));
+
+      // NOTE: Failing here makes the parser fail, which in turn fails
+      // the writer (see 'decode').
+      if (decompressed.isError()) {
+        return 1;
+      }
+
+      if (!decompressed.get().empty()) {
+        writer.write(decompressed.get());
+      }
+    } else {
+      writer.write(std::string(data, length));
+    }
 
     return 0;
   }
@@ -698,6 +983,9 @@ private:
   http::Response* response;
   Option<http::Pipe::Writer> writer;
 
+  // Decompresses the body of the current response, if compressed.
+  Owned<gzip::Decompressor> decompressor;
+
   std::deque<http::Response*> responses;
 };
 
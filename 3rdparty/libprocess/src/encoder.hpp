@@ -1,11 +1,19 @@
 #ifndef __ENCODER_HPP__
 #define __ENCODER_HPP__
 
+#include <arpa/inet.h>
 #include <stdint.h>
+#include <string.h>
 #include <time.h>
 
+#include <glog/logging.h>
+
+#include <limits>
 #include <map>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <process/http.hpp>
 #include <process/process.hpp>
@@ -21,6 +29,10 @@ namespace process {
 
 const uint32_t GZIP_MINIMUM_BODY_LENGTH = 1024;
 
+// Message bodies up to this size get copied into a single buffer
+// along with the headers (see MessageEncoder).
+const size_t MESSAGE_BODY_COPY_LIMIT = 16 * 1024;
+
 // Forward declarations.
 class Encoder;
 
@@ -91,11 +103,96 @@ private:
 };
 
 
-class MessageEncoder : public DataEncoder
+// Sends data in (possibly) several segments rather than copying them
+// into a single buffer, e.g., headers followed by a large body that
+// is sent straight out of where it lives. Subclasses add at least one
+// segment and must keep the data of their segments alive.
+class SegmentedEncoder : public DataEncoder
+{
+public:
+  explicit SegmentedEncoder(const network::Socket& s)
+    : DataEncoder(s, std::string()),
+      current(0),
+      offset(0) {}
+
+  virtual ~SegmentedEncoder() {}
+
+  virtual const char* next(size_t* length)
+  {
+    CHECK(!segments.empty());
+
+    // Move on to the next segment once the current one has been sent.
+    while (offset == segments[current].second &&
+           current + 1 < segments.size()) {
+      current++;
+      offset = 0;
+    }
+
+    const char* data = segments[current].first + offset;
+    *length = segments[current].second - offset;
+    offset = segments[current].second;
+    return data;
+  }
+
+  virtual void backup(size_t length)
+  {
+    if (offset >= length) {
+      offset -= length;
+    }
+  }
+
+  virtual size_t remaining() const
+  {
+    CHECK(!segments.empty());
+
+    size_t remaining = segments[current].second - offset;
+    for (size_t i = current + 1; i < segments.size(); i++) {
+      remaining += segments[i].second;
+    }
+    return remaining;
+  }
+
+protected:
+  // A pointer to (and the length of) a piece of the data.
+  typedef std::pair<const char*, size_t> Segment;
+
+  std::vector<Segment> segments;
+
+private:
+  size_t current; // Index of the segment currently being sent.
+  size_t offset; // Offset into the current segment.
+};
+
+
+// Encodes a message as an HTTP POST request. To avoid copying large
+// message bodies the request is sent in (up to) three pieces: the
+// headers (including the chunk size), the body itself (sent straight
+// out of the message) and the trailer. Bodies of up to
+// 'MESSAGE_BODY_COPY_LIMIT' bytes get copied along with the headers
+// instead since a single send is cheaper than copying a small body.
+class MessageEncoder : public SegmentedEncoder
 {
 public:
   MessageEncoder(const network::Socket& s, Message* _message)
-    : DataEncoder(s, encode(_message)), message(_message) {}
+    : SegmentedEncoder(s),
+      message(_message)
+  {
+    if (message == NULL) {
+      segments.push_back(Segment(NULL, 0));
+      return;
+    }
+
+    if (message->body.size() <= MESSAGE_BODY_COPY_LIMIT) {
+      header = encode(message);
+      segments.push_back(Segment(header.data(), header.size()));
+      return;
+    }
+
+    header = headers(message);
+    segments.push_back(Segment(header.data(), header.size()));
+    segments.push_back(Segment(message->body.data(), message->body.size()));
+    segments.push_back(Segment(trailer(), strlen(trailer())));
+  }
 
   virtual ~MessageEncoder()
   {
@@ -105,58 +202,188 @@ public:
   }
 
   static std::string encode(Message* message)
+  {
+    if (message == NULL) {
+      return std::string();
+    }
+
+    std::string out = headers(message);
+
+    if (message->body.size() > 0) {
+      out.reserve(out.size() + message->body.size() + strlen(trailer()));
+      out.append(message->body);
+      out.append(trailer());
+    }
+
+    return out;
+  }
+
+private:
+  // Ends the (only) chunk of the body as well as the request.
+  static const char* trailer()
+  {
+    return "\r\n0\r\n\r\n";
+  }
+
+  // Returns the request line and headers of the message, including
+  // the size of the (single) chunk of the body if there is a body.
+  static std::string headers(Message* message)
   {
     std::ostringstream out;
 
-    if (message != NULL) {
-      out << "POST ";
-      // Nothing keeps the 'id' component of a PID from being an empty
-      // string which would create a malformed path that has two
-      // '//' unless we check for it explicitly.
-      // TODO(benh): Make the 'id' part of a PID optional so when it's
-      // missing it's clear that we're simply addressing an ip:port.
-      if (message->to.id != "") {
-        out << "/" << message->to.id;
-      }
+    out << "POST ";
+    // Nothing keeps the 'id' component of a PID from being an empty
+    // string which would create a malformed path that has two
+    // '//' unless we check for it explicitly.
+    // TODO(benh): Make the 'id' part of a PID optional so when it's
+    // missing it's clear that we're simply addressing an ip:port.
+    if (message->to.id != "") {
+      out << "/" << message->to.id;
+    }
 
-      out << "/" << message->name << " HTTP/1.1\r\n"
-          << "User-Agent: libprocess/" << message->from << "\r\n"
-          << "Libprocess-From: " << message->from << "\r\n"
-          << "Connection: Keep-Alive\r\n"
-          << "Host: \r\n";
-
-      if (message->body.size() > 0) {
-        out << "Transfer-Encoding: chunked\r\n\r\n"
-            << std::hex << message->body.size() << "\r\n";
-        out.write(message->body.data(), message->body.size());
-        out << "\r\n"
-            << "0\r\n"
-            << "\r\n";
-      } else {
-        out << "\r\n";
-      }
+    out << "/" << message->name << " HTTP/1.1\r\n"
+        << "User-Agent: libprocess/" << message->from << "\r\n"
+        << "Libprocess-From: " << message->from << "\r\n"
+        << "Connection: Keep-Alive\r\n"
+        << "Host: \r\n";
+
+    if (message->body.size() > 0) {
+      out << "Transfer-Encoding: chunked\r\n\r\n"
+          << std::hex << message->body.size() << "\r\n";
+    } else {
+      out << "\r\n";
     }
 
     return out.str();
   }
 
-private:
   Message* message;
+  std::string header;
+};
+
+
+// Encodes a message using the compact binary framing that peers
+// understand in addition to HTTP (see MessageDecoder). A frame
+// consists of a fixed size header (all integers in network byte
+// order) followed by the name, the sender, the receiver's ID and the
+// body of the message:
+//
+//   uint8_t  magic;     // Always 0, which can not start an HTTP request.
+//   uint8_t  format;    // Currently 1.
+//   uint16_t name;      // Length of the name.
+//   uint16_t from;      // Length of the sender (i.e., 'id@ip:port').
+//   uint16_t to;        // Length of the receiver's ID.
+//   uint32_t body;      // Length of the body.
+//   uint32_t reserved;  // Always 0.
+class BinaryMessageEncoder : public DataEncoder
+{
+public:
+  static const uint8_t MAGIC = 0;
+  static const uint8_t FORMAT = 1;
+  static const size_t HEADER_SIZE = 16;
+
+  BinaryMessageEncoder(const network::Socket& s, Message* message)
+    : DataEncoder(s, encode(message))
+  {
+    delete message;
+  }
+
+  static std::string encode(Message* message)
+  {
+    if (message == NULL) {
+      return std::string();
+    }
+
+    const std::string from = message->from;
+
+    CHECK_LE(message->name.size(), std::numeric_limits<uint16_t>::max());
+    CHECK_LE(from.size(), std::numeric_limits<uint16_t>::max());
+    CHECK_LE(message->to.id.size(), std::numeric_limits<uint16_t>::max());
+    CHECK_LE(message->body.size(), std::numeric_limits<uint32_t>::max());
+
+    char header[HEADER_SIZE];
+    header[0] = MAGIC;
+    header[1] = FORMAT;
+    encode16(header + 2, message->name.size());
+    encode16(header + 4, from.size());
+    encode16(header + 6, message->to.id.size());
+    encode32(header + 8, message->body.size());
+    encode32(header + 12, 0);
+
+    std::string out;
+    out.reserve(
+        HEADER_SIZE +
+        message->name.size() +
+        from.size() +
+        message->to.id.size() +
+        message->body.size());
+
+    out.append(header, HEADER_SIZE);
+    out.append(message->name);
+    out.append(from);
+    out.append(message->to.id);
+    out.append(message->body);
+
+    return out;
+  }
+
+private:
+  static void encode16(char* data, uint16_t value)
+  {
+    value = htons(value);
+    memcpy(data, &value, sizeof(value));
+  }
+
+  static void encode32(char* data, uint32_t value)
+  {
+    value = htonl(value);
+    memcpy(data, &value, sizeof(value));
+  }
 };
 
 
-class HttpResponseEncoder : public DataEncoder
+// Encodes an HTTP response. Like the MessageEncoder, the headers and
+// a body larger than 'MESSAGE_BODY_COPY_LIMIT' bytes are sent as
+// separate segments rather than copied into a single buffer.
+class HttpResponseEncoder : public SegmentedEncoder
 {
 public:
   HttpResponseEncoder(
       const network::Socket& s,
       const http::Response& response,
       const http::Request& request)
-    : DataEncoder(s, encode(response, request)) {}
+    : SegmentedEncoder(s)
+  {
+    header = headers(response, request, &body);
+
+    if (body.size() <= MESSAGE_BODY_COPY_LIMIT) {
+      header.append(body);
+      body.clear();
+      segments.push_back(Segment(header.data(), header.size()));
+      return;
+    }
+
+    segments.push_back(Segment(header.data(), header.size()));
+    segments.push_back(Segment(body.data(), body.size()));
+  }
 
   static std::string encode(
       const http::Response& response,
       const http::Request& request)
+  {
+    std::string body;
+    std::string out = headers(response, request, &body);
+    out.append(body);
+    return out;
+  }
+
+private:
+  // Returns the status line and headers of the response, and sets
+  // 'body' to the body to send (if any), which may be compressed.
+  static std::string headers(
+      const http::Response& response,
+      const http::Request& request,
+      std::string* body)
   {
     std::ostringstream out;
 
@@ -183,19 +410,23 @@ public:
 
     headers["Date"] = date;
 
-    // Should we compress this response?
-    std::string body = response.body;
+    body->clear();
 
+    if (response.type == http::Response::BODY) {
+      *body = response.body;
+    }
+
+    // Should we compress this response?
     if (response.type == http::Response::BODY &&
         response.body.length() >= GZIP_MINIMUM_BODY_LENGTH &&
         !headers.contains("Content-Encoding") &&
         request.accepts("gzip")) {
-      Try<std::string> compressed = gzip::compress(body);
+      Try<std::string> compressed = gzip::compress(*body);
       if (compressed.isError()) {
         LOG(WARNING) << "Failed to gzip response body: " << compressed.error();
       } else {
-        body = compressed.get();
-        headers["Content-Length"] = stringify(body.length());
+        *body = compressed.get();
+        headers["Content-Length"] = stringify(body->length());
         headers["Content-Encoding"] = "gzip";
       }
     }
@@ -211,34 +442,39 @@ public:
       out << "Content-Length: 0\r\n";
     } else if (response.type == http::Response::BODY &&
                !headers.contains("Content-Length")) {
-      out << "Content-Length: " << body.size() << "\r\n";
+      out << "Content-Length: " << body->size() << "\r\n";
     }
 
     // Use a CRLF to mark end of headers.
     out << "\r\n";
 
-    // Add the body if necessary.
+    // If the Content-Length header was supplied, only send as much
+    // of the body as the length specifies.
     if (response.type == http::Response::BODY) {
-      // If the Content-Length header was supplied, only write as much data
-      // as the length specifies.
       Result<uint32_t> length = numify<uint32_t>(headers.get("Content-Length"));
-      if (length.isSome() && length.get() <= body.length()) {
-        out.write(body.data(), length.get());
-      } else {
-        out.write(body.data(), body.size());
+      if (length.isSome() && length.get() <= body->length()) {
+        body->resize(length.get());
       }
     }
 
     return out.str();
   }
+
+  std::string header;
+  std::string body;
 };
 
 
 class FileEncoder : public Encoder
 {
 public:
-  FileEncoder(const network::Socket& s, int _fd, size_t _size)
-    : Encoder(s), fd(_fd), size(_size), index(0) {}
+  // Sends 'size' bytes of the file starting at 'offset'.
+  FileEncoder(
+      const network::Socket& s,
+      int _fd,
+      size_t _size,
+      off_t _offset = 0)
+    : Encoder(s), fd(_fd), size(_offset + _size), index(_offset) {}
 
   virtual ~FileEncoder()
   {
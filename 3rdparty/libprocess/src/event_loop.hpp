@@ -27,6 +27,10 @@ public:
 
   // Runs the event loop.
   static void* run(void*);
+
+  // Stops any threads the event loop has started (other than the one
+  // running 'run').
+  static void finalize();
 };
 
 } // namespace process {
@@ -0,0 +1,132 @@
+#ifndef __EVENT_QUEUE_HPP__
+#define __EVENT_QUEUE_HPP__
+
+#include <stddef.h>
+
+#include <atomic>
+
+#include <process/event.hpp>
+
+namespace process {
+
+// A multiple-producer/single-consumer queue of events used as the
+// mailbox of a process. Any thread can enqueue an event without
+// acquiring a lock (a producer only does a single atomic exchange)
+// while only the thread currently running the process (the consumer)
+// may dequeue, count or otherwise inspect events.
+//
+// The implementation is the (non-intrusive) MPSC queue described by
+// Dmitry Vyukov. Note that a producer that has been preempted between
+// swapping the tail and linking its node will make the queue
+// temporarily appear empty to the consumer (and hide any events
+// enqueued after it). That is fine for our purposes as the producer
+// will (re)schedule the process after it has linked its node.
+class EventQueue
+{
+public:
+  EventQueue() : head(new Node(NULL)), tail(head) {}
+
+  ~EventQueue()
+  {
+    // Delete any events that were never dequeued (e.g., events that
+    // got enqueued while the process was terminating).
+    while (Event* event = dequeue()) {
+      delete event;
+    }
+
+    delete head;
+  }
+
+  // Enqueues an event, can be called concurrently from any thread.
+  void enqueue(Event* event)
+  {
+    Node* node = new Node(event);
+    Node* prev = tail.exchange(node);
+    prev->next.store(node);
+  }
+
+  // Returns the next event or NULL if the queue is empty, must only
+  // be called by the consumer.
+  Event* dequeue()
+  {
+    Node* next = head->next.load();
+
+    if (next == NULL) {
+      return NULL;
+    }
+
+    // The dequeued node becomes the new (empty) head.
+    Event* event = next->event;
+    next->event = NULL;
+
+    delete head;
+    head = next;
+
+    return event;
+  }
+
+  // Must only be called by the consumer.
+  bool empty() const
+  {
+    return head->next.load() == NULL;
+  }
+
+  // Returns the next event (without dequeuing it) or NULL if the
+  // queue is empty, must only be called by the consumer.
+  const Event* front() const
+  {
+    Node* next = head->next.load();
+    return next != NULL ? next->event : NULL;
+  }
+
+  // Returns the number of events in the queue that satisfy the
+  // predicate, must only be called by the consumer.
+  size_t count(bool (*predicate)(const Event*)) const
+  {
+    size_t count = 0;
+
+    for (Node* node = head->next.load();
+         node != NULL;
+         node = node->next.load()) {
+      if (predicate(node->event)) {
+        count++;
+      }
+    }
+
+    return count;
+  }
+
+  // Invokes the visitor on each event in the queue (in order), must
+  // only be called by the consumer.
+  void visit(EventVisitor* visitor) const
+  {
+    for (Node* node = head->next.load();
+         node != NULL;
+         node = node->next.load()) {
+      node->event->visit(visitor);
+    }
+  }
+
+private:
+  struct Node
+  {
+    explicit Node(Event* _event) : event(_event), next(NULL) {}
+
+    Event* event;
+    std::atomic<Node*> next;
+  };
+
+  // Not copyable, not assignable.
+  EventQueue(const EventQueue&);
+  EventQueue& operator = (const EventQueue&);
+
+  // Only accessed by the consumer.
+  Node* head;
+
+  // Accessed by all the producers.
+  std::atomic<Node*> tail;
+};
+
+} // namespace process {
+
+#endif // __EVENT_QUEUE_HPP__
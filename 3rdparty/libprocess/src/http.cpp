@@ -16,11 +16,24 @@
 #include <sstream>
 #include <vector>
 
+#include <process/clock.hpp>
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/http.hpp>
+#include <process/id.hpp>
+#include <process/once.hpp>
 #include <process/owned.hpp>
+#include <process/process.hpp>
 #include <process/socket.hpp>
+#include <process/timer.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/gauge.hpp>
+#include <process/metrics/metrics.hpp>
+
+#include <stout/duration.hpp>
 #include <stout/foreach.hpp>
 #include <stout/ip.hpp>
 #include <stout/lambda.hpp>
@@ -178,13 +191,20 @@ Pipe::Writer Pipe::writer() const
 Future<string> Pipe::Reader::read()
 {
   Future<string> future;
+  queue<Owned<Promise<Nothing>>> writables;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::CLOSED) {
       future = Failure("closed");
     } else if (!data->writes.empty()) {
       future = data->writes.front();
+      data->size -= data->writes.front().size();
       data->writes.pop();
+
+      // Let the writer know that there is room in the pipe again.
+      if (data->capacity.isSome() && data->size < data->capacity.get()) {
+        std::swap(data->writables, writables);
+      }
     } else if (data->writeEnd == Writer::CLOSED) {
       future = ""; // End-of-file.
     } else if (data->writeEnd == Writer::FAILED) {
@@ -196,6 +216,13 @@ Future<string> Pipe::Reader::read()
     }
   }
 
+  // NOTE: We set the promises outside the critical section to avoid
+  // triggering callbacks that try to reacquire the lock.
+  while (!writables.empty()) {
+    writables.front()->set(Nothing());
+    writables.pop();
+  }
+
   return future;
 }
 
@@ -205,6 +232,7 @@ bool Pipe::Reader::close()
   bool closed = false;
   bool notify = false;
   queue<Owned<Promise<string>>> reads;
+  queue<Owned<Promise<Nothing>>> writables;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::OPEN) {
@@ -212,9 +240,12 @@ bool Pipe::Reader::close()
       while (!data->writes.empty()) {
         data->writes.pop();
       }
+      data->size = 0;
 
-      // Extract the pending reads so we can fail them.
+      // Extract the pending reads so we can fail them, and the
+      // waiting writers which can find out that the read-end closed.
       std::swap(data->reads, reads);
+      std::swap(data->writables, writables);
 
       closed = true;
       data->readEnd = Reader::CLOSED;
@@ -232,6 +263,11 @@ bool Pipe::Reader::close()
       reads.pop();
     }
 
+    while (!writables.empty()) {
+      writables.front()->set(Nothing());
+      writables.pop();
+    }
+
     if (notify) {
       data->readerClosure.set(Nothing());
     }
@@ -253,6 +289,7 @@ bool Pipe::Writer::write(const string& s)
       if (!s.empty()) {
         if (data->reads.empty()) {
           data->writes.push(s);
+          data->size += s.size();
         } else {
           read = data->reads.front();
           data->reads.pop();
@@ -276,11 +313,13 @@ bool Pipe::Writer::close()
 {
   bool closed = false;
   queue<Owned<Promise<string>>> reads;
+  queue<Owned<Promise<Nothing>>> writables;
 
   synchronized (data->lock) {
     if (data->writeEnd == Writer::OPEN) {
       // Extract all the pending reads so we can complete them.
       std::swap(data->reads, reads);
+      std::swap(data->writables, writables);
 
       data->writeEnd = Writer::CLOSED;
       closed = true;
@@ -294,6 +333,11 @@ bool Pipe::Writer::close()
     reads.pop();
   }
 
+  while (!writables.empty()) {
+    writables.front()->set(Nothing());
+    writables.pop();
+  }
+
   return closed;
 }
 
@@ -302,11 +346,13 @@ bool Pipe::Writer::fail(const string& message)
 {
   bool failed = false;
   queue<Owned<Promise<string>>> reads;
+  queue<Owned<Promise<Nothing>>> writables;
 
   synchronized (data->lock) {
     if (data->writeEnd == Writer::OPEN) {
       // Extract all the pending reads so we can fail them.
       std::swap(data->reads, reads);
+      std::swap(data->writables, writables);
 
       data->writeEnd = Writer::FAILED;
       data->failure = Failure(message);
@@ -321,6 +367,11 @@ bool Pipe::Writer::fail(const string& message)
     reads.pop();
   }
 
+  while (!writables.empty()) {
+    writables.front()->set(Nothing());
+    writables.pop();
+  }
+
   return failed;
 }
 
@@ -331,6 +382,24 @@ Future<Nothing> Pipe::Writer::readerClosed()
 }
 
 
+Future<Nothing> Pipe::Writer::writable()
+{
+  Future<Nothing> future = Nothing();
+
+  synchronized (data->lock) {
+    if (data->writeEnd == Writer::OPEN &&
+        data->readEnd == Reader::OPEN &&
+        data->capacity.isSome() &&
+        data->size >= data->capacity.get()) {
+      data->writables.push(Owned<Promise<Nothing>>(new Promise<Nothing>()));
+      future = data->writables.back()->future();
+    }
+  }
+
+  return future;
+}
+
+
 namespace path {
 
 Try<hashmap<string, string>> parse(const string& pattern, const string& path)
@@ -539,59 +608,6 @@ ostream& operator << (
 
 namespace internal {
 
-// Forward declarations.
-Future<string> _convert(
-    Pipe::Reader reader,
-    const std::shared_ptr<string>& buffer,
-    const string& read);
-Response __convert(
-    const Response& pipeResponse,
-    const string& body);
-
-
-// Returns a 'BODY' response once the body of the provided
-// 'PIPE' response can be read completely.
-Future<Response> convert(const Response& pipeResponse)
-{
-  std::shared_ptr<string> buffer(new string());
-
-  CHECK_EQ(Response::PIPE, pipeResponse.type);
-  CHECK_SOME(pipeResponse.reader);
-
-  Pipe::Reader reader = pipeResponse.reader.get();
-
-  return reader.read()
-    .then(lambda::bind(&_convert, reader, buffer, lambda::_1))
-    .then(lambda::bind(&__convert, pipeResponse, lambda::_1));
-}
-
-
-Future<string> _convert(
-    Pipe::Reader reader,
-    const std::shared_ptr<string>& buffer,
-    const string& read)
-{
-  if (read.empty()) { // EOF.
-    return *buffer;
-  }
-
-  buffer->append(read);
-
-  return reader.read()
-    .then(lambda::bind(&_convert, reader, buffer, lambda::_1));
-}
-
-
-Response __convert(const Response& pipeResponse, const string& body)
-{
-  Response bodyResponse = pipeResponse;
-  bodyResponse.type = Response::BODY;
-  bodyResponse.body = body;
-  bodyResponse.reader = None(); // Remove the reader.
-  return bodyResponse;
-}
-
-
 // Forward declaration.
 void _decode(
     Socket socket,
@@ -669,76 +685,13 @@ void _decode(
 }
 
 
-// Forward declaration.
-Future<Response> _request(
-    Socket socket,
+// Returns the encoded request, asking the server to keep the
+// connection open after the response if 'persistent' is set.
+string encode(
     const Address& address,
     const URL& url,
     const string& method,
-    bool streamingResponse,
-    const Option<hashmap<string, string>>& _headers,
-    const Option<string>& body,
-    const Option<string>& contentType);
-
-
-Future<Response> request(
-    const URL& url,
-    const string& method,
-    bool streamedResponse,
-    const Option<hashmap<string, string>>& headers,
-    const Option<string>& body,
-    const Option<string>& contentType)
-{
-  if (url.scheme != "http") {
-    return Failure("Unsupported URL scheme");
-  }
-
-  Try<Socket> create = Socket::create();
-
-  if (create.isError()) {
-    return Failure("Failed to create socket: " + create.error());
-  }
-
-  Socket socket = create.get();
-
-  Address address;
-
-  if (url.ip.isSome()) {
-    address.ip = url.ip.get();
-  } else if (url.domain.isNone()) {
-    return Failure("Missing URL domain or IP");
-  } else {
-    Try<net::IP> ip = net::getIP(url.domain.get(), AF_INET);
-
-    if (ip.isError()) {
-      return Failure("Failed to determine IP of domain '" +
-                     url.domain.get() + "': " + ip.error());
-    }
-
-    address.ip = ip.get();
-  }
-
-  address.port = url.port;
-
-  return socket.connect(address)
-    .then(lambda::bind(&_request,
-                       socket,
-                       address,
-                       url,
-                       method,
-                       streamedResponse,
-                       headers,
-                       body,
-                       contentType));
-}
-
-
-Future<Response> _request(
-    Socket socket,
-    const Address& address,
-    const URL& url,
-    const string& method,
-    bool streamedResponse,
+    bool persistent,
     const Option<hashmap<string, string>>& _headers,
     const Option<string>& body,
     const Option<string>& contentType)
@@ -774,8 +727,8 @@ Future<Response> _request(
   // Need to specify the 'Host' header.
   headers["Host"] = stringify(address);
 
-  // Tell the server to close the connection when it's done.
-  headers["Connection"] = "close";
+  // Tell the server whether to close the connection when it's done.
+  headers["Connection"] = persistent ? "keep-alive" : "close";
 
   // Overwrite Content-Type if necessary.
   if (contentType.isSome()) {
@@ -789,10 +742,9 @@ Future<Response> _request(
 
   // TODO(bmahler): Use a 'Request' and a 'RequestEncoder' here!
   // Currently this does not handle 'gzip' content encoding,
-  // unless the caller manually compresses the 'body'. For
-  // streaming requests we must wipe 'gzip' as an acceptable
-  // encoding as we don't currently have streaming gzip utilities
-  // to support decoding a streaming gzip response!
+  // unless the caller manually compresses the 'body'. Note that
+  // gzip encoded responses (including streamed ones) get
+  // decompressed by the response decoders.
 
   // Emit the headers.
   foreachpair (const string& key, const string& value, headers) {
@@ -805,22 +757,484 @@ Future<Response> _request(
     out << body.get();
   }
 
+  return out.str();
+}
+
+
+// The maximum number of persistent connections the pool opens to a
+// server, once reached further requests get pipelined on the open
+// connections.
+const size_t MAX_CONNECTIONS_PER_SERVER = 4;
+
+
+// The maximum number of connections the pool keeps open in total.
+// Once reached, an idle connection (to any server) gets closed to
+// make room for a new one, and connections that become idle while
+// there are more open (i.e., all of them were busy) get closed.
+const size_t MAX_CONNECTIONS = 256;
+
+
+// How long the pool keeps an idle connection open.
+const Duration CONNECTION_IDLE_TIMEOUT = Seconds(30);
+
+
+// Keeps the connections used for requests without a streamed
+// response open so that they get reused by subsequent requests to
+// the same server. Requests are pipelined, i.e., a request gets sent
+// without waiting for the responses to the requests sent before it
+// on the connection, since the responses arrive in the order of the
+// requests. A connection is closed (and dropped from the pool) once
+// the server closes it (or asks to via 'Connection: close') or on any
+// failure, the outstanding GET requests then get retried (once) on
+// another connection while all other requests fail.
+class ConnectionPoolProcess : public Process<ConnectionPoolProcess>
+{
+public:
+  ConnectionPoolProcess()
+    : ProcessBase(ID::generate("__http_connection_pool__")),
+      count(0),
+      metrics(self()) {}
+
+  virtual ~ConnectionPoolProcess() {}
+
+  Future<Response> request(
+      const Address& address,
+      const string& method,
+      const string& data)
+  {
+    Owned<Request> request(new Request(address, method, data));
+    send(request);
+    return request->promise.future();
+  }
+
+private:
+  // A request sent (or to be sent) on a connection.
+  struct Request
+  {
+    Request(
+        const Address& _address,
+        const string& _method,
+        const string& _data)
+      : address(_address), method(_method), data(_data), retried(false) {}
+
+    const Address address;
+    const string method;
+    const string data; // The encoded request.
+    bool retried;
+    Promise<Response> promise;
+  };
+
+  struct Connection
+  {
+    Connection(const Address& _address, const Socket& _socket)
+      : address(_address), socket(_socket), closed(false) {}
+
+    const Address address;
+    Socket socket;
+    ResponseDecoder decoder;
+
+    // Completes once the data queued on the connection so far has
+    // been sent (starting with the connect), used to sequence the
+    // sends.
+    Future<Nothing> sending;
+
+    Future<string> receiving;
+
+    // The requests awaiting a response, in the order they were sent.
+    deque<Owned<Request>> requests;
+
+    // Closes the connection once it has been idle for too long.
+    Option<Timer> timer;
+
+    bool closed;
+  };
+
+  void send(const Owned<Request>& request)
+  {
+    Try<Owned<Connection>> connection = select(request->address);
+
+    if (connection.isError()) {
+      request->promise.fail(connection.error());
+      return;
+    }
+
+    if (!connection.get()->requests.empty()) {
+      ++metrics.requests_pipelined;
+    }
+
+    connection.get()->requests.push_back(request);
+
+    // Need to disambiguate the Socket::send for binding below.
+    Future<Nothing> (Socket::*send)(const string&) = &Socket::send;
+
+    connection.get()->sending = connection.get()->sending
+      .then(lambda::function<Future<Nothing>(void)>(
+                lambda::bind(send, connection.get()->socket, request->data)));
+
+    connection.get()->sending
+      .onFailed(defer(self(),
+                      &Self::failed,
+                      connection.get(),
+                      lambda::_1));
+  }
+
+  // Returns an idle connection to the server if there is one, a new
+  // connection if the limit has not been reached yet or else the
+  // connection with the fewest outstanding requests.
+  Try<Owned<Connection>> select(const Address& address)
+  {
+    vector<Owned<Connection>>& open = connections[address];
+
+    Option<Owned<Connection>> selected = None();
+
+    foreach (const Owned<Connection>& connection, open) {
+      if (connection->requests.empty()) {
+        if (connection->timer.isSome()) {
+          Clock::cancel(connection->timer.get());
+          connection->timer = None();
+        }
+
+        ++metrics.connections_reused;
+        return connection;
+      }
+
+      if (selected.isNone() ||
+          connection->requests.size() < selected.get()->requests.size()) {
+        selected = connection;
+      }
+    }
+
+    if (selected.isSome() && open.size() >= MAX_CONNECTIONS_PER_SERVER) {
+      return selected.get();
+    }
+
+    if (count >= MAX_CONNECTIONS) {
+      if (!evict() && selected.isSome()) {
+        return selected.get();
+      }
+    }
+
+    Try<Socket> create = Socket::create();
+
+    if (create.isError()) {
+      return Error("Failed to create socket: " + create.error());
+    }
+
+    Owned<Connection> connection(new Connection(address, create.get()));
+
+    connection->sending = connection->socket.connect(address);
+
+    connection->sending
+      .onReady(defer(self(), &Self::receive, connection));
+
+    open.push_back(connection);
+
+    ++count;
+    ++metrics.connections_opened;
+
+    return connection;
+  }
+
+  // Closes an idle connection, returns false if there is none.
+  bool evict()
+  {
+    foreachvalue (const vector<Owned<Connection>>& open, connections) {
+      foreach (const Owned<Connection>& connection, open) {
+        if (connection->requests.empty()) {
+          // NOTE: We copy the connection since closing it removes it
+          // from the vector we're iterating over.
+          close(Owned<Connection>(connection), "Too many open connections");
+          return true;
+        }
+      }
+    }
+
+    return false;
+  }
+
+  // Invoked when the connection has been idle for too long.
+  void expire(const Owned<Connection>& connection)
+  {
+    // The connection might have been reused (or closed) after the
+    // timer fired but before we got here.
+    if (!connection->closed && connection->requests.empty()) {
+      ++metrics.connections_expired;
+      close(connection, "Connection idle for too long");
+    }
+  }
+
+  void receive(const Owned<Connection>& connection)
+  {
+    if (connection->closed) {
+      return;
+    }
+
+    connection->receiving = connection->socket.recv(None());
+
+    connection->receiving
+      .onAny(defer(self(), &Self::_receive, connection, lambda::_1));
+  }
+
+  void _receive(const Owned<Connection>& connection, const Future<string>& data)
+  {
+    if (connection->closed) {
+      return;
+    }
+
+    if (!data.isReady()) {
+      close(connection,
+            data.isFailed() ? data.failure() : "Receive discarded");
+      return;
+    }
+
+    // NOTE: Decoding no data tells the decoder about EOF, which
+    // completes a response whose body is delimited by EOF.
+    deque<Response*> responses =
+      connection->decoder.decode(data.get().data(), data.get().length());
+
+    bool persistent = true;
+    bool unexpected = false;
+
+    foreach (Response* response, responses) {
+      if (connection->requests.empty()) {
+        unexpected = true;
+      } else {
+        Option<string> header = response->headers.get("Connection");
+        if (header.isSome() && strings::lower(header.get()) == "close") {
+          persistent = false;
+        }
+
+        Owned<Request> request = connection->requests.front();
+        connection->requests.pop_front();
+        request->promise.set(*response);
+      }
+
+      delete response;
+    }
+
+    if (connection->decoder.failed()) {
+      close(connection, "Failed to decode HTTP response");
+    } else if (unexpected) {
+      close(connection, "Received an unexpected HTTP response");
+    } else if (data.get().empty()) {
+      close(connection, "Connection closed by server");
+    } else if (!persistent) {
+      close(connection, "Connection closed by server (Connection: close)");
+    } else if (connection->requests.empty() && count > MAX_CONNECTIONS) {
+      close(connection, "Too many open connections");
+    } else {
+      if (connection->requests.empty() && !responses.empty()) {
+        connection->timer = delay(
+            CONNECTION_IDLE_TIMEOUT, self(), &Self::expire, connection);
+      }
+
+      receive(connection);
+    }
+  }
+
+  void failed(const Owned<Connection>& connection, const string& message)
+  {
+    close(connection, "Failed to send HTTP request: " + message);
+  }
+
+  void close(const Owned<Connection>& connection, const string& message)
+  {
+    if (connection->closed) {
+      return;
+    }
+
+    connection->closed = true;
+    connection->receiving.discard();
+
+    if (connection->timer.isSome()) {
+      Clock::cancel(connection->timer.get());
+      connection->timer = None();
+    }
+
+    --count;
+
+    vector<Owned<Connection>>& open = connections[connection->address];
+    open.erase(std::remove(open.begin(), open.end(), connection), open.end());
+
+    if (open.empty()) {
+      connections.erase(connection->address);
+    }
+
+    // GET requests get retried since the server might have closed
+    // the connection just before getting the request, e.g., due to
+    // an idle timeout.
+    while (!connection->requests.empty()) {
+      Owned<Request> request = connection->requests.front();
+      connection->requests.pop_front();
+
+      if (request->method == "GET" && !request->retried) {
+        request->retried = true;
+        send(request);
+      } else {
+        request->promise.fail(message);
+      }
+    }
+  }
+
+  Future<double> _connections()
+  {
+    return count;
+  }
+
+  hashmap<Address, vector<Owned<Connection>>> connections;
+
+  // The number of open connections (to all servers).
+  size_t count;
+
+  struct Metrics
+  {
+    explicit Metrics(const PID<ConnectionPoolProcess>& pool)
+      : connections(
+            "libprocess/http_client/connections",
+            defer(pool, &ConnectionPoolProcess::_connections)),
+        connections_opened("libprocess/http_client/connections_opened"),
+        connections_reused("libprocess/http_client/connections_reused"),
+        connections_expired("libprocess/http_client/connections_expired"),
+        requests_pipelined("libprocess/http_client/requests_pipelined")
+    {
+      process::metrics::add(connections);
+      process::metrics::add(connections_opened);
+      process::metrics::add(connections_reused);
+      process::metrics::add(connections_expired);
+      process::metrics::add(requests_pipelined);
+    }
+
+    ~Metrics()
+    {
+      process::metrics::remove(connections);
+      process::metrics::remove(connections_opened);
+      process::metrics::remove(connections_reused);
+      process::metrics::remove(connections_expired);
+      process::metrics::remove(requests_pipelined);
+    }
+
+    process::metrics::Gauge connections;
+
+    process::metrics::Counter connections_opened;
+
+    // Requests sent on an idle connection opened for an earlier
+    // request.
+    process::metrics::Counter connections_reused;
+
+    // Connections closed after being idle for too long.
+    process::metrics::Counter connections_expired;
+
+    // Requests sent on a connection with outstanding requests, i.e.,
+    // once the limit of connections to the server has been reached.
+    process::metrics::Counter requests_pipelined;
+  } metrics;
+};
+
+
+// Global connection pool process.
+static ConnectionPoolProcess* pool = NULL;
+
+
+// Forward declaration.
+Future<Response> _request(
+    Socket socket,
+    const Address& address,
+    const URL& url,
+    const string& method,
+    const Option<hashmap<string, string>>& headers,
+    const Option<string>& body,
+    const Option<string>& contentType);
+
+
+Future<Response> request(
+    const URL& url,
+    const string& method,
+    bool streamedResponse,
+    const Option<hashmap<string, string>>& headers,
+    const Option<string>& body,
+    const Option<string>& contentType)
+{
+  if (url.scheme != "http") {
+    return Failure("Unsupported URL scheme");
+  }
+
+  Address address;
+
+  if (url.ip.isSome()) {
+    address.ip = url.ip.get();
+  } else if (url.domain.isNone()) {
+    return Failure("Missing URL domain or IP");
+  } else {
+    Try<net::IP> ip = net::getIP(url.domain.get(), AF_INET);
+
+    if (ip.isError()) {
+      return Failure("Failed to determine IP of domain '" +
+                     url.domain.get() + "': " + ip.error());
+    }
+
+    address.ip = ip.get();
+  }
+
+  address.port = url.port;
+
+  // A streamed response is read until EOF, hence it gets a
+  // connection of its own.
+  if (!streamedResponse) {
+    static Once* initialized = new Once();
+
+    if (!initialized->once()) {
+      pool = new ConnectionPoolProcess();
+      spawn(pool);
+      initialized->done();
+    }
+
+    return dispatch(
+        pool,
+        &ConnectionPoolProcess::request,
+        address,
+        method,
+        encode(address, url, method, true, headers, body, contentType));
+  }
+
+  Try<Socket> create = Socket::create();
+
+  if (create.isError()) {
+    return Failure("Failed to create socket: " + create.error());
+  }
+
+  Socket socket = create.get();
+
+  return socket.connect(address)
+    .then(lambda::bind(&_request,
+                       socket,
+                       address,
+                       url,
+                       method,
+                       headers,
+                       body,
+                       contentType));
+}
+
+
+Future<Response> _request(
+    Socket socket,
+    const Address& address,
+    const URL& url,
+    const string& method,
+    const Option<hashmap<string, string>>& headers,
+    const Option<string>& body,
+    const Option<string>& contentType)
+{
   // Need to disambiguate the Socket::recv for binding below.
   Future<string> (Socket::*recv)(const Option<ssize_t>&) = &Socket::recv;
 
   Owned<StreamingResponseDecoder> decoder(new StreamingResponseDecoder());
 
-  Future<Response> pipeResponse = socket.send(out.str())
+  return socket.send(
+      encode(address, url, method, false, headers, body, contentType))
     .then(lambda::function<Future<string>(void)>(
               lambda::bind(recv, socket, None())))
     .then(lambda::bind(&internal::decode, socket, decoder, lambda::_1));
-
-  if (streamedResponse) {
-    return pipeResponse;
-  } else {
-    return pipeResponse
-      .then(lambda::bind(&internal::convert, lambda::_1));
-  }
 }
 
 } // namespace internal {
@@ -1,3 +1,8 @@
+#ifdef __linux__
+#include <fcntl.h>
+#endif // __linux__
+
+#include <algorithm>
 #include <memory>
 #include <string>
 
@@ -264,10 +269,15 @@ Future<Nothing> _write(
 }
 
 
+// Copies from 'from' to 'to' through user space, reading up to
+// 'chunk' bytes at a time. Whenever a read fills the chunk the chunk
+// is doubled, up to 'limit' bytes (the size of 'data'), so that fewer
+// reads and writes are needed for chatty file descriptors.
 void _splice(
     int from,
     int to,
     size_t chunk,
+    size_t limit,
     boost::shared_array<char> data,
     std::shared_ptr<Promise<Nothing>> promise)
 {
@@ -300,8 +310,10 @@ void _splice(
         // discard has occured on our future, in order to provide
         // semantics where everything read is written. The promise
         // will eventually be discarded in the next read.
+        const size_t next = size == chunk ? std::min(chunk * 2, limit) : chunk;
+
         io::write(to, string(data.get(), size))
-          .onReady([=]() { _splice(from, to, chunk, data, promise); })
+          .onReady([=]() { _splice(from, to, next, limit, data, promise); })
           .onFailed([=](const string& message) { promise->fail(message); })
           .onDiscarded([=]() { promise->discard(); });
       }
@@ -313,7 +325,9 @@ void _splice(
 
 Future<Nothing> splice(int from, int to, size_t chunk)
 {
-  boost::shared_array<char> data(new char[chunk]);
+  const size_t limit = std::max(chunk, BUFFERED_READ_SIZE);
+
+  boost::shared_array<char> data(new char[limit]);
 
   // Rather than having internal::_splice return a future and
   // implementing internal::_splice as a chain of io::read and
@@ -323,10 +337,80 @@ Future<Nothing> splice(int from, int to, size_t chunk)
 
   Future<Nothing> future = promise->future();
 
-  _splice(from, to, chunk, data, promise);
+  _splice(from, to, chunk, limit, data, promise);
+
+  return future;
+}
+
+
+#ifdef __linux__
+// Moves data from 'from' to 'to' with the splice system call, i.e.,
+// without copying it through user space, which requires one of the
+// file descriptors to be a pipe. Falls back to 'splice' above if the
+// file descriptors do not support this.
+void _zerocopy(
+    int from,
+    int to,
+    size_t chunk,
+    bool spliced,
+    std::shared_ptr<Promise<Nothing>> promise)
+{
+  // Stop splicing if a discard occured on our future.
+  if (promise->future().hasDiscard()) {
+    promise->discard();
+    return;
+  }
+
+  // Splice a bounded number of chunks before polling again so that
+  // a continuously written 'from' does not monopolize the caller.
+  ssize_t length;
+  size_t chunks = 0;
+
+  do {
+    length = ::splice(
+        from, NULL, to, NULL, chunk, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+    if (length > 0) {
+      spliced = true;
+    }
+  } while ((length > 0 && ++chunks < 16) || (length < 0 && errno == EINTR));
+
+  if (length == 0) { // EOF.
+    promise->set(Nothing());
+  } else if (length > 0 || errno == EAGAIN || errno == EWOULDBLOCK) {
+    // Either 'from' has no data or 'to' has no room (or we yield
+    // after splicing), so wait for both before continuing.
+    Future<short> poll = io::poll(to, io::WRITE)
+      .then([=]() { return io::poll(from, io::READ); });
+
+    poll
+      .onReady([=]() { _zerocopy(from, to, chunk, spliced, promise); })
+      .onFailed([=](const string& message) { promise->fail(message); })
+      .onDiscarded([=]() { promise->discard(); });
+
+    // Stop polling if a discard occurs on our future.
+    promise->future().onDiscard(
+        lambda::bind(&process::internal::discard<short>,
+                     WeakFuture<short>(poll)));
+  } else if (errno == EINVAL && !spliced) {
+    promise->associate(splice(from, to, chunk));
+  } else {
+    promise->fail(strerror(errno));
+  }
+}
+
+
+Future<Nothing> zerocopy(int from, int to, size_t chunk)
+{
+  std::shared_ptr<Promise<Nothing>> promise(new Promise<Nothing>());
+
+  Future<Nothing> future = promise->future();
+
+  _zerocopy(from, to, std::max(chunk, BUFFERED_READ_SIZE), false, promise);
 
   return future;
 }
+#endif // __linux__
 
 } // namespace internal {
 
@@ -482,7 +566,11 @@ Future<Nothing> redirect(int from, Option<int> to, size_t chunk)
     return Failure("Failed to make 'to' non-blocking: " + nonblock.error());
   }
 
+#ifdef __linux__
+  return internal::zerocopy(from, to.get(), chunk)
+#else
   return internal::splice(from, to.get(), chunk)
+#endif // __linux__
     .onAny(lambda::bind(&os::close, from))
     .onAny(lambda::bind(&os::close, to.get()));
 }
@@ -1,11 +1,19 @@
 #include <ev.h>
+#include <pthread.h>
+#include <stdlib.h>
 
 #include <mutex>
 #include <queue>
+#include <vector>
+
+#include <glog/logging.h>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
+#include <stout/numify.hpp>
+#include <stout/try.hpp>
 
 #include "event_loop.hpp"
 #include "libev.hpp"
@@ -27,6 +35,10 @@ std::queue<lambda::function<void(void)>>* functions =
 
 ThreadLocal<bool>* _in_event_loop_ = new ThreadLocal<bool>();
 
+std::vector<IOLoop*>* io_loops = new std::vector<IOLoop*>();
+
+ThreadLocal<IOLoop>* __io_loop__ = new ThreadLocal<IOLoop>();
+
 
 void handle_async(struct ev_loop* loop, ev_async* _, int revents)
 {
@@ -46,12 +58,69 @@ void handle_async(struct ev_loop* loop, ev_async* _, int revents)
 }
 
 
+void handle_io_async(struct ev_loop* loop, ev_async* watcher, int revents)
+{
+  IOLoop* io = reinterpret_cast<IOLoop*>(watcher->data);
+
+  std::queue<lambda::function<void(void)>> functions;
+
+  synchronized (io->mutex) {
+    std::swap(functions, io->functions);
+  }
+
+  while (!functions.empty()) {
+    (functions.front())();
+    functions.pop();
+  }
+}
+
+
+void* run_io_loop(void* arg)
+{
+  IOLoop* io = reinterpret_cast<IOLoop*>(arg);
+
+  *__io_loop__ = io;
+
+  ev_loop(io->loop, 0);
+
+  *__io_loop__ = NULL;
+
+  return NULL;
+}
+
+
 void EventLoop::initialize()
 {
   loop = ev_default_loop(EVFLAG_AUTO);
 
   ev_async_init(&async_watcher, handle_async);
   ev_async_start(loop, &async_watcher);
+
+  // Check environment for the number of (additional) threads to
+  // shard the polling of file descriptors across.
+  const char* value = getenv("LIBPROCESS_IO_THREADS");
+  if (value != NULL) {
+    Try<size_t> threads = numify<size_t>(value);
+    if (threads.isError()) {
+      LOG(FATAL) << "LIBPROCESS_IO_THREADS=" << value
+                 << " is not a valid number of threads: " << threads.error();
+    }
+
+    for (size_t i = 0; i < threads.get(); i++) {
+      IOLoop* io = new IOLoop();
+      io->loop = ev_loop_new(EVFLAG_AUTO);
+
+      if (io->loop == NULL) {
+        LOG(FATAL) << "Failed to create an I/O loop";
+      }
+
+      ev_async_init(&io->async_watcher, handle_io_async);
+      io->async_watcher.data = io;
+      ev_async_start(io->loop, &io->async_watcher);
+
+      io_loops->push_back(io);
+    }
+  }
 }
 
 
@@ -115,6 +184,18 @@ double EventLoop::time()
 
 void* EventLoop::run(void*)
 {
+  // Start the threads running the I/O loops (if any).
+  foreach (IOLoop* io, *io_loops) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, &run_io_loop, io) != 0) {
+      LOG(FATAL) << "Failed to start an I/O thread, pthread_create";
+    }
+
+    synchronized (io->mutex) {
+      io->thread = thread;
+    }
+  }
+
   __in_event_loop__ = true;
 
   ev_loop(loop, 0);
@@ -124,4 +205,34 @@ void* EventLoop::run(void*)
   return NULL;
 }
 
+
+void EventLoop::finalize()
+{
+  // Stop the I/O loops (if any) and wait for their threads to exit.
+  // NOTE: The loops themselves are not destroyed, just like the
+  // event loop, since file descriptors might still be polled.
+  foreach (IOLoop* io, *io_loops) {
+    Option<pthread_t> thread;
+    synchronized (io->mutex) {
+      thread = io->thread;
+      io->thread = None();
+    }
+
+    if (thread.isNone() || pthread_equal(thread.get(), pthread_self())) {
+      continue;
+    }
+
+    struct ev_loop* loop = io->loop;
+
+    run_in_io_loop<Nothing>(io, [=]() -> Future<Nothing> {
+      ev_break(loop, EVBREAK_ALL);
+      return Nothing();
+    });
+
+    if (pthread_join(thread.get(), NULL) != 0) {
+      LOG(ERROR) << "Failed to join an I/O thread, pthread_join";
+    }
+  }
+}
+
 } // namespace process {
@@ -2,14 +2,17 @@
 #define __LIBEV_HPP__
 
 #include <ev.h>
+#include <pthread.h>
 
 #include <mutex>
 #include <queue>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/owned.hpp>
 
 #include <stout/lambda.hpp>
+#include <stout/option.hpp>
 #include <stout/synchronized.hpp>
 #include <stout/thread.hpp>
 
@@ -43,6 +46,35 @@ extern ThreadLocal<bool>* _in_event_loop_;
   *_in_event_loop_ = new bool(false) : *_in_event_loop_)
 
 
+// An additional event loop, run by its own thread, that the polling
+// of file descriptors gets sharded across (see io::poll).
+struct IOLoop
+{
+  struct ev_loop* loop;
+
+  // Asynchronous watcher for interrupting the loop to invoke the
+  // queued functions (via run_in_io_loop).
+  ev_async async_watcher;
+
+  // Queue of functions to be invoked asynchronously within the loop
+  // (protected by 'mutex').
+  std::queue<lambda::function<void(void)>> functions;
+  std::mutex mutex;
+
+  // The thread running the loop, once started (see EventLoop::run),
+  // to be joined when the loop is stopped (see EventLoop::finalize).
+  Option<pthread_t> thread;
+};
+
+// The I/O loops, empty unless LIBPROCESS_IO_THREADS is set, in which
+// case file descriptor 'fd' gets polled in I/O loop
+// 'fd % io_loops->size()' rather than in the event loop.
+extern std::vector<IOLoop*>* io_loops;
+
+// Per thread pointer to the I/O loop run by the thread, if any.
+extern ThreadLocal<IOLoop>* __io_loop__;
+
+
 // Wrapper around function we want to run in the event loop.
 template <typename T>
 void _run_in_event_loop(
@@ -82,6 +114,33 @@ Future<T> run_in_event_loop(const lambda::function<Future<T>(void)>& f)
   return future;
 }
 
+
+// Helper for running a function in an I/O loop.
+template <typename T>
+Future<T> run_in_io_loop(
+    IOLoop* io,
+    const lambda::function<Future<T>(void)>& f)
+{
+  // If this is already the I/O loop then just run the function.
+  if (static_cast<IOLoop*>(*__io_loop__) == io) {
+    return f();
+  }
+
+  Owned<Promise<T>> promise(new Promise<T>());
+
+  Future<T> future = promise->future();
+
+  // Enqueue the function.
+  synchronized (io->mutex) {
+    io->functions.push(lambda::bind(&_run_in_event_loop<T>, f, promise));
+  }
+
+  // Interrupt the loop.
+  ev_async_send(io->loop, &io->async_watcher);
+
+  return future;
+}
+
 } // namespace process {
 
 #endif // __LIBEV_HPP__
@@ -78,13 +78,13 @@ namespace io {
 namespace internal {
 
 // Helper/continuation of 'poll' on future discard.
-void _poll(const std::shared_ptr<ev_async>& async)
+void _poll(struct ev_loop* loop, const std::shared_ptr<ev_async>& async)
 {
   ev_async_send(loop, async.get());
 }
 
 
-Future<short> poll(int fd, short events)
+Future<short> poll(struct ev_loop* loop, int fd, short events)
 {
   Poll* poll = new Poll();
 
@@ -105,7 +105,7 @@ Future<short> poll(int fd, short events)
   // in this case while we will interrupt the event loop since the
   // async watcher has already been stopped we won't cause
   // 'discard_poll' to get invoked.
-  future.onDiscard(lambda::bind(&_poll, poll->watcher.async));
+  future.onDiscard(lambda::bind(&_poll, loop, poll->watcher.async));
 
   // Initialize and start the I/O watcher.
   ev_io_init(poll->watcher.io.get(), polled, fd, events);
@@ -123,7 +123,17 @@ Future<short> poll(int fd, short events)
 
   // TODO(benh): Check if the file descriptor is non-blocking?
 
-  return run_in_event_loop<short>(lambda::bind(&internal::poll, fd, events));
+  if (io_loops->empty()) {
+    return run_in_event_loop<short>(
+        lambda::bind(&internal::poll, loop, fd, events));
+  }
+
+  // Shard the polling across the I/O loops by file descriptor.
+  IOLoop* io = (*io_loops)[fd % io_loops->size()];
+
+  return run_in_io_loop<short>(
+      io,
+      lambda::bind(&internal::poll, io->loop, fd, events));
 }
 
 } // namespace io {
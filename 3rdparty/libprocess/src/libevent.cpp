@@ -105,4 +105,10 @@ void EventLoop::initialize()
   }
 }
 
+
+void EventLoop::finalize()
+{
+  // Nothing to stop, 'run' doesn't start any threads.
+}
+
 } // namespace process {
@@ -1,7 +1,11 @@
 #include <glog/logging.h>
 
+#include <functional>
 #include <list>
+#include <map>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <process/collect.hpp>
 #include <process/dispatch.hpp>
@@ -13,9 +17,14 @@
 
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/strings.hpp>
+#include <stout/synchronized.hpp>
 
 using std::list;
+using std::map;
 using std::string;
+using std::vector;
 
 namespace process {
 namespace metrics {
@@ -63,33 +72,80 @@ string MetricsProcess::help()
           "amount of time the endpoint will take to respond. If the timeout ",
           "is exceeded, some metrics may not be included in the response.",
           "",
+          "The optional query parameter 'prefix' restricts the response to ",
+          "the metrics whose names start with the given prefix, e.g., ",
+          "'prefix=master/'.",
+          "",
           "The key is the metric name, and the value is a double-type."));
 }
 
 
 Future<Nothing> MetricsProcess::add(Owned<Metric> metric)
 {
-  if (metrics.contains(metric->name())) {
-    return Failure("Metric '" + metric->name() + "' was already added.");
+  Shard& shard = this->shard(metric->name());
+
+  synchronized (shard.mutex) {
+    if (!shard.metrics.insert(std::make_pair(metric->name(), metric)).second) {
+      return Failure("Metric '" + metric->name() + "' was already added.");
+    }
   }
 
-  metrics[metric->name()] = metric;
   return Nothing();
 }
 
 
 Future<Nothing> MetricsProcess::remove(const std::string& name)
 {
-  if (!metrics.contains(name)) {
-    return Failure("Metric '" + name + "' not found.");
-  }
+  Shard& shard = this->shard(name);
 
-  metrics.erase(name);
+  // The metric is destroyed outside of the lock, in case it is the
+  // last copy of the metric.
+  Owned<Metric> metric;
+
+  synchronized (shard.mutex) {
+    map<string, Owned<Metric>>::iterator it = shard.metrics.find(name);
+    if (it == shard.metrics.end()) {
+      return Failure("Metric '" + name + "' not found.");
+    }
+
+    metric = it->second;
+    shard.metrics.erase(it);
+  }
 
   return Nothing();
 }
 
 
+MetricsProcess::Shard& MetricsProcess::shard(const string& name)
+{
+  return shards[std::hash<string>()(name) % SHARDS];
+}
+
+
+vector<Owned<Metric>> MetricsProcess::find(const Option<string>& prefix)
+{
+  vector<Owned<Metric>> metrics;
+
+  for (size_t i = 0; i < SHARDS; i++) {
+    synchronized (shards[i].mutex) {
+      map<string, Owned<Metric>>::const_iterator it = prefix.isSome()
+        ? shards[i].metrics.lower_bound(prefix.get())
+        : shards[i].metrics.begin();
+
+      for (; it != shards[i].metrics.end(); ++it) {
+        if (prefix.isSome() && !strings::startsWith(it->first, prefix.get())) {
+          break;
+        }
+
+        metrics.push_back(it->second);
+      }
+    }
+  }
+
+  return metrics;
+}
+
+
 Future<http::Response> MetricsProcess::snapshot(const http::Request& request)
 {
   return limiter.acquire()
@@ -115,23 +171,54 @@ Future<http::Response> MetricsProcess::_snapshot(const http::Request& request)
     timeout = duration.get();
   }
 
+  const Option<string> prefix = request.query.get("prefix");
+  const Option<string> jsonp = request.query.get("jsonp");
+
+  Future<JSON::Object> object;
+
+  // Requests for all metrics without a timeout share a pending
+  // evaluation of the metrics, rather than each waiting for all
+  // gauges themselves.
+  if (timeout.isNone() && prefix.isNone()) {
+    if (snapshotting.isNone() || !snapshotting.get().isPending()) {
+      snapshotting = evaluate(None(), None());
+    }
+    object = snapshotting.get();
+  } else {
+    object = evaluate(timeout, prefix);
+  }
+
+  return object
+    .then([jsonp](const JSON::Object& object) -> http::Response {
+      return http::OK(object, jsonp);
+    });
+}
+
+
+Future<JSON::Object> MetricsProcess::evaluate(
+    const Option<Duration>& timeout,
+    const Option<string>& prefix)
+{
   hashmap<string, Future<double> > futures;
   hashmap<string, Option<Statistics<double> > > statistics;
 
-  foreachkey (const string& metric, metrics) {
-    CHECK_NOTNULL(metrics[metric].get());
-    futures[metric] = metrics[metric]->value();
+  // NOTE: The metrics are evaluated outside of the locks of the
+  // shards, the copies keep them alive even if they get removed
+  // meanwhile.
+  foreach (const Owned<Metric>& metric, find(prefix)) {
+    CHECK_NOTNULL(metric.get());
+    futures[metric->name()] = metric->value();
     // TODO(dhamon): It would be nice to compute these asynchronously.
-    statistics[metric] = metrics[metric]->statistics();
+    statistics[metric->name()] = metric->statistics();
   }
 
   if (timeout.isSome()) {
     return await(futures.values())
       .after(timeout.get(), lambda::bind(_snapshotTimeout, futures.values()))
-      .then(lambda::bind(__snapshot, request, timeout, futures, statistics));
+      .then(lambda::bind(__snapshot, timeout, futures, statistics));
   } else {
     return await(futures.values())
-      .then(lambda::bind(__snapshot, request, timeout, futures, statistics));
+      .then(lambda::bind(__snapshot, timeout, futures, statistics));
   }
 }
 
@@ -145,8 +232,7 @@ list<Future<double> > MetricsProcess::_snapshotTimeout(
 }
 
 
-Future<http::Response> MetricsProcess::__snapshot(
-    const http::Request& request,
+JSON::Object MetricsProcess::__snapshot(
     const Option<Duration>& timeout,
     const hashmap<string, Future<double> >& metrics,
     const hashmap<string, Option<Statistics<double> > >& statistics)
@@ -179,7 +265,7 @@ Future<http::Response> MetricsProcess::__snapshot(
     }
   }
 
-  return http::OK(object, request.query.get("jsonp"));
+  return object;
 }
 
 }  // namespace internal {
@@ -54,8 +54,15 @@ Future<Socket> accept(int fd)
   }
 
   // Turn off Nagle (TCP_NODELAY) so pipelined requests don't wait.
+  // This does not apply to unix domain sockets, which libprocess also
+  // accepts peers on (see LIBPROCESS_UNIX_SOCKETS).
+  struct sockaddr_storage storage;
+  socklen_t storagelen = sizeof(storage);
+
   int on = 1;
-  if (setsockopt(s, SOL_TCP, TCP_NODELAY, &on, sizeof(on)) < 0) {
+  if ((getsockname(s, (struct sockaddr*) &storage, &storagelen) < 0 ||
+       storage.ss_family != AF_UNIX) &&
+      setsockopt(s, SOL_TCP, TCP_NODELAY, &on, sizeof(on)) < 0) {
     const char* error = strerror(errno);
     VLOG(1) << "Failed to turn off the Nagle algorithm: " << error;
     os::close(s);
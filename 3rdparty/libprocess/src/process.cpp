@@ -5,6 +5,7 @@
 #include <pthread.h>
 #include <signal.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -25,6 +26,7 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/uio.h>
+#include <sys/un.h>
 
 #include <algorithm>
 #include <deque>
@@ -45,6 +47,7 @@
 #include <process/address.hpp>
 #include <process/check.hpp>
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
@@ -57,6 +60,8 @@
 #include <process/io.hpp>
 #include <process/logging.hpp>
 #include <process/mime.hpp>
+#include <process/network.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/profiler.hpp>
 #include <process/socket.hpp>
@@ -65,23 +70,30 @@
 #include <process/time.hpp>
 #include <process/timer.hpp>
 
+#include <process/metrics/counter.hpp>
 #include <process/metrics/metrics.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
+#include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/result.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/synchronized.hpp>
 #include <stout/thread.hpp>
 #include <stout/unreachable.hpp>
 
+#include "buffer_pool.hpp"
 #include "config.hpp"
 #include "decoder.hpp"
 #include "encoder.hpp"
 #include "event_loop.hpp"
+#include "event_queue.hpp"
 #include "gate.hpp"
 #include "process_reference.hpp"
 
@@ -94,6 +106,7 @@ using process::http::BadRequest;
 using process::http::InternalServerError;
 using process::http::NotFound;
 using process::http::OK;
+using process::http::Pipe;
 using process::http::Request;
 using process::http::Response;
 using process::http::ServiceUnavailable;
@@ -109,6 +122,7 @@ using std::ostream;
 using std::pair;
 using std::queue;
 using std::set;
+using std::shared_ptr;
 using std::stack;
 using std::string;
 using std::stringstream;
@@ -202,6 +216,9 @@ private:
   queue<Item*> items;
 
   Option<http::Pipe::Reader> pipe; // Current pipe, if streaming.
+
+  // Compresses the current stream, if the client accepts gzip.
+  Owned<gzip::Compressor> compressor;
 };
 
 
@@ -275,6 +292,13 @@ public:
 
   Encoder* next(int s);
 
+  // Enables coalescing of the data queued for a socket (e.g., many
+  // small messages) into batches of up to 'bytes' bytes that get
+  // written with a single send. Note that data only gets queued
+  // while a previous send on the socket is in progress, so no
+  // latency is added to sends on idle sockets.
+  void coalesce(size_t bytes);
+
   void close(int s);
 
   void exited(const Address& address);
@@ -323,15 +347,68 @@ private:
   // HTTP proxies.
   map<int, HttpProxy*> proxies;
 
+  // Returns an encoder for the data of the encoder followed by as
+  // much of the data queued for the socket as fits into a batch.
+  // Must be called with the mutex held.
+  Encoder* coalesce(int s, Encoder* encoder);
+
+  // Maximum number of bytes per batch, 0 if coalescing is disabled.
+  size_t coalescing;
+
+  struct Metrics
+  {
+    Metrics()
+      : batches("libprocess/socket_manager/batches"),
+        batched_encoders("libprocess/socket_manager/batched_encoders"),
+        batched_bytes("libprocess/socket_manager/batched_bytes")
+    {
+      metrics::add(batches);
+      metrics::add(batched_encoders);
+      metrics::add(batched_bytes);
+    }
+
+    ~Metrics()
+    {
+      metrics::remove(batches);
+      metrics::remove(batched_encoders);
+      metrics::remove(batched_bytes);
+    }
+
+    // The average batch size and bytes per send can be derived by
+    // dividing by the number of batches.
+    metrics::Counter batches;
+    metrics::Counter batched_encoders;
+    metrics::Counter batched_bytes;
+  };
+
+  Owned<Metrics> metrics;
+
   // Protects instance variables.
   std::recursive_mutex mutex;
 };
 
 
+// A queue of runnable processes that is owned by a single worker
+// thread. A worker runs processes from the front of its own queue and
+// when that is empty steals processes from the back of the queues of
+// the other workers.
+struct RunQueue
+{
+  explicit RunQueue(size_t _index) : index(_index) {}
+
+  // Index of the owning worker thread.
+  const size_t index;
+
+  // Queue of runnable processes (implemented using list).
+  list<ProcessBase*> processes;
+  std::mutex mutex;
+};
+
+
 class ProcessManager
 {
 public:
-  explicit ProcessManager(const string& delegate);
+  ProcessManager(const string& delegate, size_t workers);
   ~ProcessManager();
 
   ProcessReference use(const UPID& pid);
@@ -357,11 +434,19 @@ public:
   void terminate(const UPID& pid, bool inject, ProcessBase* sender = NULL);
   bool wait(const UPID& pid);
 
+  // Associates the calling (worker) thread with the run queue at
+  // 'index', must be invoked by each worker before calling 'dequeue'.
+  void attach(size_t index);
+
   void enqueue(ProcessBase* process);
   ProcessBase* dequeue();
 
   void settle();
 
+  // Returns a JSON description of the process and its pending
+  // events, must be invoked from within the process.
+  JSON::Object describe(ProcessBase* process);
+
   // The /__processes__ route.
   Future<Response> __processes__(const Request&);
 
@@ -376,9 +461,12 @@ private:
   // Gates for waiting threads (protected by processes_mutex).
   map<ProcessBase*, Gate*> gates;
 
-  // Queue of runnable processes (implemented using list).
-  list<ProcessBase*> runq;
-  std::recursive_mutex runq_mutex;
+  // Run queues, one per worker thread.
+  vector<RunQueue*> runqs;
+
+  // Used to distribute processes among the run queues when they are
+  // enqueued by a non-worker thread and haven't run before.
+  size_t next;
 
   // Number of running processes, to support Clock::settle operation.
   int running;
@@ -394,15 +482,47 @@ static const int LISTEN_BACKLOG = 500000;
 // Local server socket.
 static Socket* __s__ = NULL;
 
+// Local server socket for the peers on this host, see
+// LIBPROCESS_UNIX_SOCKETS.
+static Socket* __u__ = NULL;
+
+// Whether the peers on this host are reached through their unix
+// domain sockets when they listen on one (LIBPROCESS_UNIX_SOCKETS).
+static bool unix_sockets = false;
+
 // Local socket address.
 static Address __address__;
 
+// Whether messages get sent using the binary framing rather than as
+// HTTP requests (see BinaryMessageEncoder), which only peers that
+// understand the binary framing can receive.
+static bool binary_messages = false;
+
+// The maximum size of an HTTP request body, if limited.
+static Option<size_t> max_body_size = None();
+
+// The maximum size of a message received using the binary framing.
+static size_t max_message_size = DEFAULT_MAX_MESSAGE_SIZE;
+
+// How long the /__processes__ endpoint waits for a process to
+// describe itself (unless a 'timeout' is given in the query).
+static const Duration PROCESSES_TIMEOUT = Seconds(5);
+
 // Active SocketManager (eventually will probably be thread-local).
 static SocketManager* socket_manager = NULL;
 
 // Active ProcessManager (eventually will probably be thread-local).
 static ProcessManager* process_manager = NULL;
 
+// Size of the buffers data gets received into on sockets.
+static const size_t RECEIVE_BUFFER_SIZE = 80 * 1024;
+
+// Maximum number of (released) receive buffers kept for reuse.
+static const size_t RECEIVE_BUFFER_POOL_CAPACITY = 128;
+
+// Pool of the buffers data gets received into on sockets.
+static BufferPool* receive_buffers = NULL;
+
 // Scheduling gate that threads wait at when there is nothing to run.
 static Gate* gate = new Gate();
 
@@ -424,6 +544,9 @@ ThreadLocal<ProcessBase>* _process_ = new ThreadLocal<ProcessBase>();
 // Per thread executor pointer.
 ThreadLocal<Executor>* _executor_ = new ThreadLocal<Executor>();
 
+// Per thread run queue pointer (only set for worker threads).
+static ThreadLocal<RunQueue>* _runq_ = new ThreadLocal<RunQueue>();
+
 // TODO(dhamon): Reintroduce this when it is plumbed through to Statistics.
 // const Duration LIBPROCESS_STATISTICS_WINDOW = Days(1);
 
@@ -455,6 +578,7 @@ static void transport(Message* message, ProcessBase* sender = NULL)
 {
   if (message->to.address == __address__) {
     // Local message.
+    message->peer = __address__;
     process_manager->deliver(message->to, new MessageEvent(message), sender);
   } else {
     // Remote message.
@@ -523,7 +647,10 @@ static Message* parse(Request* request)
   message->name = name;
   message->from = from.get();
   message->to = to;
-  message->body = request->body;
+
+  // NOTE: The body is moved rather than copied as the request is not
+  // needed for anything but the headers once it has been parsed.
+  message->body.swap(request->body);
 
   return message;
 }
@@ -531,6 +658,44 @@ static Message* parse(Request* request)
 
 namespace internal {
 
+// Reads the pipe (of a streamed request body) until end-of-file.
+Future<string> read(
+    Pipe::Reader reader,
+    const std::shared_ptr<string>& buffer = std::make_shared<string>())
+{
+  return reader.read()
+    .then([=](const string& data) -> Future<string> {
+      if (data.empty()) {
+        return *buffer; // End-of-file.
+      }
+
+      buffer->append(data);
+      return read(reader, buffer);
+    });
+}
+
+
+// Closes the read-end of the pipe of a streamed request body that
+// is not going to be handled, so that the body gets dropped rather
+// than hold up the connection.
+void ignore(const Request& request)
+{
+  if (request.reader.isSome()) {
+    Pipe::Reader reader = request.reader.get();
+    reader.close();
+  }
+}
+
+
+// Forward declaration.
+void _decode_recv(
+    const Future<Nothing>& writable,
+    char* data,
+    size_t size,
+    Socket* socket,
+    DataDecoder* decoder);
+
+
 void decode_recv(
     const Future<size_t>& length,
     char* data,
@@ -544,7 +709,7 @@ void decode_recv(
     }
 
     socket_manager->close(*socket);
-    delete[] data;
+    receive_buffers->release(data);
     delete decoder;
     delete socket;
     return;
@@ -552,7 +717,7 @@ void decode_recv(
 
   if (length.get() == 0) {
     socket_manager->close(*socket);
-    delete[] data;
+    receive_buffers->release(data);
     delete decoder;
     delete socket;
     return;
@@ -565,29 +730,130 @@ void decode_recv(
     foreach (Request* request, requests) {
       // Augment each Request with the client's address. This should
       // never fail since there remains a reference to this Socket!
+      // The exception are unix domain sockets, whose clients are on
+      // this host.
       Try<Address> address = socket->address();
-      CHECK_SOME(address);
-      request->client = address.get();
+      CHECK(address.isSome() || unix_sockets) << address.error();
+      request->client = address.isSome() ? address.get() : __address__;
       process_manager->handle(decoder->socket(), request);
     }
   } else if (requests.empty() && decoder->failed()) {
     VLOG(1) << "Decoder error while receiving";
     socket_manager->close(*socket);
-    delete[] data;
+    receive_buffers->release(data);
     delete decoder;
     delete socket;
     return;
   }
 
+  // Hold off receiving while the handler of a streamed request body
+  // is behind, which pushes back on the client.
+  decoder->writable()
+    .onAny(lambda::bind(
+        &_decode_recv, lambda::_1, data, size, socket, decoder));
+}
+
+
+void _decode_recv(
+    const Future<Nothing>& writable,
+    char* data,
+    size_t size,
+    Socket* socket,
+    DataDecoder* decoder)
+{
   socket->recv(data, size)
     .onAny(lambda::bind(&decode_recv, lambda::_1, data, size, socket, decoder));
 }
 
+
+void decode_message_recv(
+    const Future<size_t>& length,
+    char* data,
+    size_t size,
+    Socket* socket,
+    MessageDecoder* decoder)
+{
+  if (length.isDiscarded() || length.isFailed() || length.get() == 0) {
+    if (length.isFailed()) {
+      VLOG(1) << "Decode failure: " << length.failure();
+    }
+
+    socket_manager->close(*socket);
+    receive_buffers->release(data);
+    delete decoder;
+    delete socket;
+    return;
+  }
+
+  // Decode as much of the data as possible into messages.
+  const deque<Message*> messages = decoder->decode(data, length.get());
+
+  // Record where the messages actually come from. The peers of unix
+  // domain sockets are on this host.
+  Option<Address> peer = None();
+  if (!messages.empty()) {
+    Try<Address> address = network::peer(*socket);
+    if (address.isSome()) {
+      peer = address.get();
+    } else if (unix_sockets) {
+      peer = __address__;
+    }
+  }
+
+  foreach (Message* message, messages) {
+    // Only the ID of the receiver gets sent, see MessageDecoder.
+    message->to.address = __address__;
+    message->peer = peer;
+    process_manager->deliver(message->to, new MessageEvent(message));
+  }
+
+  if (decoder->failed()) {
+    VLOG(1) << "Decoder error while receiving";
+    socket_manager->close(*socket);
+    receive_buffers->release(data);
+    delete decoder;
+    delete socket;
+    return;
+  }
+
+  socket->recv(data, size)
+    .onAny(lambda::bind(
+        &decode_message_recv,
+        lambda::_1,
+        data,
+        size,
+        socket,
+        decoder));
+}
+
+
+// Continues with the appropriate decoder once the first data has
+// been received on an accepted socket: a peer either sends messages
+// using the binary framing (see BinaryMessageEncoder) or sends HTTP.
+void decode_first_recv(
+    const Future<size_t>& length,
+    char* data,
+    size_t size,
+    Socket* socket)
+{
+  if (length.isReady() &&
+      length.get() > 0 &&
+      data[0] == BinaryMessageEncoder::MAGIC) {
+    decode_message_recv(
+        length, data, size, socket, new MessageDecoder(max_message_size));
+  } else {
+    decode_recv(
+        length, data, size, socket, new DataDecoder(*socket, max_body_size));
+  }
+}
+
 } // namespace internal {
 
 
 void* schedule(void* arg)
 {
+  process_manager->attach(reinterpret_cast<intptr_t>(arg));
+
   do {
     ProcessBase* process = process_manager->dequeue();
     if (process == NULL) {
@@ -645,30 +911,207 @@ void timedout(const list<Timer>& timers)
 
 namespace internal {
 
-void on_accept(const Future<Socket>& socket)
+#ifdef __linux__
+// Fills in the unix domain socket address at which the libprocess
+// instance with the specified address listens for the peers on this
+// host. The address is in the abstract namespace, so it does not
+// exist in the file system and goes away with the process.
+socklen_t unix_socket_address(const Address& address, struct sockaddr_un* addr)
+{
+  const string name = "libprocess/" + stringify(address);
+
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+
+  // NOTE: The leading NUL byte of 'sun_path' denotes the abstract
+  // namespace, hence the name is copied after it.
+  CHECK_LT(name.size(), sizeof(addr->sun_path) - 1);
+  memcpy(addr->sun_path + 1, name.data(), name.size());
+
+  return offsetof(struct sockaddr_un, sun_path) + 1 + name.size();
+}
+
+
+// Returns the ID of the user running the process that listens on the
+// specified TCP address on this host, as listed in /proc/net/tcp, or
+// None if no process listens on it.
+Result<uid_t> tcp_listener(const Address& address)
+{
+  Try<string> read = os::read("/proc/net/tcp");
+  if (read.isError()) {
+    return Error("Failed to read /proc/net/tcp: " + read.error());
+  }
+
+  foreach (const string& line, strings::tokenize(read.get(), "\n")) {
+    // The fields are: sl, local_address, rem_address, st, tx_queue:
+    // rx_queue, tr:tm->when, retrnsmt, uid, timeout, inode, ...
+    const vector<string> fields = strings::tokenize(line, " ");
+    if (fields.size() < 8 || fields[3] != "0A") { // TCP_LISTEN.
+      continue;
+    }
+
+    // The local address is the IP, as stored (i.e., in network
+    // order), and the port, both in hex.
+    const vector<string> local = strings::split(fields[1], ":");
+    if (local.size() != 2) {
+      continue;
+    }
+
+    struct in_addr ip;
+    ip.s_addr = strtoul(local[0].c_str(), NULL, 16);
+
+    const unsigned long port = strtoul(local[1].c_str(), NULL, 16);
+
+    if (port == address.port &&
+        (ip.s_addr == INADDR_ANY || net::IP(ip) == address.ip)) {
+      Try<uid_t> uid = numify<uid_t>(fields[7]);
+      if (uid.isError()) {
+        return Error("Failed to parse the uid in /proc/net/tcp: " +
+                     uid.error());
+      }
+
+      return uid.get();
+    }
+  }
+
+  return None();
+}
+
+
+// Verifies that the peer of the connected unix domain socket 's' is
+// run by the same user as the process listening on the TCP address
+// 'address', whose unix domain socket we meant to connect to. Anybody
+// on this host could listen on the (abstract) unix domain socket
+// address first, e.g., if the process at 'address' does not.
+Try<Nothing> unix_verify(int s, const Address& address)
+{
+  struct ucred credentials;
+  socklen_t length = sizeof(credentials);
+
+  if (::getsockopt(s, SOL_SOCKET, SO_PEERCRED, &credentials, &length) < 0) {
+    return ErrnoError("Failed to get the credentials of the peer");
+  }
+
+  Result<uid_t> uid = tcp_listener(address);
+  if (uid.isError()) {
+    return Error(uid.error());
+  } else if (uid.isNone()) {
+    return Error("Nobody listens on " + stringify(address) + " via TCP");
+  } else if (uid.get() != credentials.uid) {
+    return Error(
+        "The peer is run by user " + stringify(credentials.uid) +
+        " rather than user " + stringify(uid.get()) + " listening on " +
+        stringify(address) + " via TCP");
+  }
+
+  return Nothing();
+}
+
+
+// Returns a server socket for the peers on this host that listens on
+// the unix domain socket address of 'address'.
+Try<Socket> unix_listen(const Address& address)
+{
+  Try<int> s =
+    network::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+  if (s.isError()) {
+    return Error("Failed to create socket: " + s.error());
+  }
+
+  struct sockaddr_un addr;
+  socklen_t size = unix_socket_address(address, &addr);
+
+  if (::bind(s.get(), (struct sockaddr*) &addr, size) < 0) {
+    ErrnoError error("Failed to bind");
+    os::close(s.get());
+    return error;
+  }
+
+  Try<Socket> socket = Socket::create(Socket::DEFAULT_KIND(), s.get());
+  if (socket.isError()) {
+    os::close(s.get());
+    return Error(socket.error());
+  }
+
+  Try<Nothing> listen = socket.get().listen(LISTEN_BACKLOG);
+  if (listen.isError()) {
+    return Error("Failed to listen: " + listen.error());
+  }
+
+  return socket.get();
+}
+#endif // __linux__
+
+
+// Returns a socket for sending to the specified address. A peer on
+// this host is connected to through its unix domain socket if it
+// listens on one (LIBPROCESS_UNIX_SOCKETS), in which case the socket
+// is returned already connected, as indicated by 'connected'.
+// Otherwise the socket still needs to be connected using TCP.
+Try<Socket> create(const Address& address, bool* connected)
+{
+  *connected = false;
+
+#ifdef __linux__
+  if (unix_sockets && address.ip == __address__.ip) {
+    Try<int> s =
+      network::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (s.isSome()) {
+      struct sockaddr_un addr;
+      socklen_t size = unix_socket_address(address, &addr);
+
+      // NOTE: Connecting a unix domain socket does not wait for the
+      // peer to accept, it either succeeds or fails right away (e.g.,
+      // if the peer does not listen on a unix domain socket, or its
+      // backlog is full), in which case we fall back to TCP. The same
+      // goes if the peer is not who it should be (see 'unix_verify').
+      if (::connect(s.get(), (struct sockaddr*) &addr, size) == 0) {
+        Try<Nothing> verify = unix_verify(s.get(), address);
+        if (verify.isError()) {
+          LOG(WARNING) << "Not using the unix domain socket of " << address
+                       << ": " << verify.error();
+        } else {
+          Try<Socket> socket =
+            Socket::create(Socket::DEFAULT_KIND(), s.get());
+
+          if (socket.isSome()) {
+            *connected = true;
+            return socket;
+          }
+        }
+      }
+
+      os::close(s.get());
+    }
+  }
+#endif // __linux__
+
+  return Socket::create();
+}
+
+
+void on_accept(const Future<Socket>& socket, Socket* server)
 {
   if (socket.isReady()) {
     // Inform the socket manager for proper bookkeeping.
     socket_manager->accepted(socket.get());
 
-    const size_t size = 80 * 1024;
-    char* data = new char[size];
-    memset(data, 0, size);
-
-    DataDecoder* decoder = new DataDecoder(socket.get());
+    const size_t size = receive_buffers->size;
+    char* data = receive_buffers->allocate();
 
     socket.get().recv(data, size)
       .onAny(lambda::bind(
-          &internal::decode_recv,
+          &internal::decode_first_recv,
           lambda::_1,
           data,
           size,
-          new Socket(socket.get()),
-          decoder));
+          new Socket(socket.get())));
   }
 
-  __s__->accept()
-    .onAny(lambda::bind(&on_accept, lambda::_1));
+  server->accept()
+    .onAny(lambda::bind(&on_accept, lambda::_1, server));
 }
 
 } // namespace internal {
@@ -725,14 +1168,9 @@ void initialize(const string& delegate)
   signal(SIGPIPE, SIG_IGN);
 #endif // __sun__
 
-  // Create a new ProcessManager and SocketManager.
-  process_manager = new ProcessManager(delegate);
-  socket_manager = new SocketManager();
-
-  // Setup processing threads.
-  // We create no fewer than 8 threads because some tests require
-  // more worker threads than 'sysconf(_SC_NPROCESSORS_ONLN)' on
-  // computers with fewer cores.
+  // We create no fewer than 8 processing threads because some tests
+  // require more worker threads than 'sysconf(_SC_NPROCESSORS_ONLN)'
+  // on computers with fewer cores.
   // e.g. https://issues.apache.org/jira/browse/MESOS-818
   //
   // TODO(xujyan): Use a smarter algorithm to allocate threads.
@@ -741,9 +1179,19 @@ void initialize(const string& delegate)
   // threads.
   long cpus = std::max(8L, sysconf(_SC_NPROCESSORS_ONLN));
 
-  for (int i = 0; i < cpus; i++) {
+  // Create a new ProcessManager and SocketManager.
+  process_manager = new ProcessManager(delegate, cpus);
+  socket_manager = new SocketManager();
+  receive_buffers = new BufferPool(
+      "libprocess/receive_buffers",
+      RECEIVE_BUFFER_SIZE,
+      RECEIVE_BUFFER_POOL_CAPACITY);
+
+  // Setup processing threads, each thread gets its own run queue.
+  for (intptr_t i = 0; i < cpus; i++) {
     pthread_t thread; // For now, not saving handles on our threads.
-    if (pthread_create(&thread, NULL, schedule, NULL) != 0) {
+    if (pthread_create(&thread, NULL, schedule, reinterpret_cast<void*>(i))
+        != 0) {
       LOG(FATAL) << "Failed to initialize, pthread_create";
     }
   }
@@ -844,12 +1292,37 @@ void initialize(const string& delegate)
     PLOG(FATAL) << "Failed to initialize: " << listen.error();
   }
 
+  // Check environment for also accepting the peers on this host on
+  // a unix domain socket, and using theirs, which avoids the overhead
+  // of TCP over the loopback interface (e.g., between an executor and
+  // its slave).
+  value = getenv("LIBPROCESS_UNIX_SOCKETS");
+  if (value != NULL && strcmp(value, "0") != 0) {
+#ifdef __linux__
+    Try<Socket> socket = internal::unix_listen(__address__);
+    if (socket.isError()) {
+      LOG(WARNING) << "Failed to listen on a unix domain socket, only"
+                   << " using TCP: " << socket.error();
+    } else {
+      __u__ = new Socket(socket.get());
+      unix_sockets = true;
+    }
+#else
+    LOG(WARNING) << "LIBPROCESS_UNIX_SOCKETS is only supported on Linux";
+#endif // __linux__
+  }
+
   // Need to set initialzing here so that we can actually invoke
   // 'spawn' below for the garbage collector.
   initializing = false;
 
   __s__->accept()
-    .onAny(lambda::bind(&internal::on_accept, lambda::_1));
+    .onAny(lambda::bind(&internal::on_accept, lambda::_1, __s__));
+
+  if (__u__ != NULL) {
+    __u__->accept()
+      .onAny(lambda::bind(&internal::on_accept, lambda::_1, __u__));
+  }
 
   // TODO(benh): Make sure creating the garbage collector, logging
   // process, and profiler always succeeds and use supervisors to make
@@ -893,6 +1366,48 @@ void initialize(const string& delegate)
   MetricsProcess* metricsProcess = MetricsProcess::instance();
   CHECK_NOTNULL(metricsProcess);
 
+  // The pool of receive buffers is already in use (we're accepting
+  // sockets), hence its counters only get added now.
+  metrics::add(receive_buffers->hits);
+  metrics::add(receive_buffers->misses);
+
+  // Check environment for coalescing the data sent on sockets.
+  value = getenv("LIBPROCESS_COALESCE_BYTES");
+  if (value != NULL) {
+    Try<Bytes> bytes = Bytes::parse(value);
+    if (bytes.isError()) {
+      LOG(FATAL) << "LIBPROCESS_COALESCE_BYTES=" << value
+                 << " is not a valid size: " << bytes.error();
+    }
+    socket_manager->coalesce(bytes.get().bytes());
+  }
+
+  // Check environment for sending messages using the binary framing.
+  value = getenv("LIBPROCESS_BINARY_MESSAGES");
+  binary_messages = value != NULL && strcmp(value, "0") != 0;
+
+  // Check environment for limiting the size of HTTP request bodies.
+  value = getenv("LIBPROCESS_HTTP_MAX_BODY_SIZE");
+  if (value != NULL) {
+    Try<Bytes> bytes = Bytes::parse(value);
+    if (bytes.isError()) {
+      LOG(FATAL) << "LIBPROCESS_HTTP_MAX_BODY_SIZE=" << value
+                 << " is not a valid size: " << bytes.error();
+    }
+    max_body_size = bytes.get().bytes();
+  }
+
+  // Check environment for limiting the size of binary messages.
+  value = getenv("LIBPROCESS_MAX_MESSAGE_SIZE");
+  if (value != NULL) {
+    Try<Bytes> bytes = Bytes::parse(value);
+    if (bytes.isError()) {
+      LOG(FATAL) << "LIBPROCESS_MAX_MESSAGE_SIZE=" << value
+                 << " is not a valid size: " << bytes.error();
+    }
+    max_message_size = bytes.get().bytes();
+  }
+
   // Initialize the mime types.
   mime::initialize();
 
@@ -914,6 +1429,10 @@ void finalize()
 {
   delete process_manager;
 
+  // Stop the threads of the event loop (e.g., for the I/O loops of
+  // LIBPROCESS_IO_THREADS).
+  EventLoop::finalize();
+
   // TODO(benh): Finialize/shutdown Clock so that it doesn't attempt
   // to dereference 'process_manager' in the 'timedout' callback.
 }
@@ -984,10 +1503,29 @@ void HttpProxy::handle(Future<Response>* future, const Request& request)
 
 void HttpProxy::next()
 {
-  if (items.size() > 0) {
-    // Wait for any transition of the future.
-    items.front()->future->onAny(
-        defer(self(), &HttpProxy::waited, lambda::_1));
+  // Send the responses of pipelined requests in order. The handlers
+  // were dispatched as the requests were decoded so their responses
+  // may well be ready by now, in which case we send them right away
+  // rather than paying for a dispatch per response.
+  while (items.size() > 0) {
+    Item* item = items.front();
+
+    if (item->future->isPending()) {
+      // Wait for any transition of the future.
+      item->future->onAny(defer(self(), &HttpProxy::waited, lambda::_1));
+      return;
+    }
+
+    // Process the item and determine if we're done or not (so we know
+    // whether to continue with the next responses).
+    bool processed = process(*item->future, item->request);
+
+    items.pop();
+    delete item;
+
+    if (!processed) {
+      return;
+    }
   }
 }
 
@@ -995,20 +1533,69 @@ void HttpProxy::next()
 void HttpProxy::waited(const Future<Response>& future)
 {
   CHECK(items.size() > 0);
-  Item* item = items.front();
+  CHECK(future == *items.front()->future);
 
-  CHECK(future == *item->future);
+  next();
+}
 
-  // Process the item and determine if we're done or not (so we know
-  // whether to start waiting on the next responses).
-  bool processed = process(*item->future, item->request);
 
-  items.pop();
-  delete item;
+// Parses the value of a 'Range' request header against a file of the
+// given size. Only a single byte range is supported: returns None if
+// the header is malformed or asks for multiple ranges (in which case
+// the whole file is sent, see RFC 7233), an Error if the range cannot
+// be satisfied, and the offset and length of the range otherwise.
+static Result<std::pair<off_t, size_t>> parseRange(
+    const string& value,
+    size_t size)
+{
+  if (!strings::startsWith(value, "bytes=")) {
+    return None();
+  }
 
-  if (processed) {
-    next();
+  const string spec = strings::trim(value.substr(strlen("bytes=")));
+
+  size_t dash = spec.find('-');
+  if (dash == string::npos || spec.find(',') != string::npos) {
+    return None();
   }
+
+  const string first = strings::trim(spec.substr(0, dash));
+  const string last = strings::trim(spec.substr(dash + 1));
+
+  if (first.empty()) {
+    // A suffix range, i.e., the last 'N' bytes of the file.
+    Try<size_t> suffix = numify<size_t>(last);
+    if (suffix.isError()) {
+      return None();
+    } else if (suffix.get() == 0 || size == 0) {
+      return Error("Unsatisfiable range");
+    }
+
+    size_t length = std::min(suffix.get(), size);
+    return std::make_pair(static_cast<off_t>(size - length), length);
+  }
+
+  Try<size_t> start = numify<size_t>(first);
+  if (start.isError()) {
+    return None();
+  }
+
+  size_t end = size - 1;
+  if (!last.empty()) {
+    Try<size_t> _end = numify<size_t>(last);
+    if (_end.isError() || _end.get() < start.get()) {
+      return None();
+    }
+    end = std::min(_end.get(), size - 1);
+  }
+
+  if (start.get() >= size) {
+    return Error("Unsatisfiable range");
+  }
+
+  return std::make_pair(
+      static_cast<off_t>(start.get()),
+      end - start.get() + 1);
 }
 
 
@@ -1050,18 +1637,54 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
         VLOG(1) << "Returning '404 Not Found' for directory '" << path << "'";
         socket_manager->send(NotFound(), request, socket);
       } else {
+        // Honor a single byte 'Range' of the file, if requested, so
+        // that clients can fetch parts of (large) files without us
+        // copying the data through user space.
+        off_t offset = 0;
+        size_t length = s.st_size;
+
+        response.headers["Accept-Ranges"] = "bytes";
+
+        Option<string> header = request.headers.get("Range");
+        if (header.isSome() && response.status == http::statuses[200]) {
+          Result<std::pair<off_t, size_t>> range =
+            parseRange(header.get(), s.st_size);
+
+          if (range.isError()) {
+            VLOG(1) << "Returning '416 Requested range not satisfiable' for"
+                    << " range '" << header.get() << "' of file at '"
+                    << path << "'";
+            os::close(fd);
+
+            Response unsatisfiable;
+            unsatisfiable.status = http::statuses[416];
+            unsatisfiable.headers["Content-Range"] =
+              "bytes */" + stringify(s.st_size);
+            socket_manager->send(unsatisfiable, request, socket);
+            return true; // All done, can process next request.
+          } else if (range.isSome()) {
+            offset = range.get().first;
+            length = range.get().second;
+
+            response.status = http::statuses[206];
+            response.headers["Content-Range"] =
+              "bytes " + stringify(offset) + "-" +
+              stringify(offset + length - 1) + "/" + stringify(s.st_size);
+          }
+        }
+
         // While the user is expected to properly set a 'Content-Type'
         // header, we fill in (or overwrite) 'Content-Length' header.
-        stringstream out;
-        out << s.st_size;
-        response.headers["Content-Length"] = out.str();
+        response.headers["Content-Length"] = stringify(length);
 
-        if (s.st_size == 0) {
+        if (length == 0) {
+          os::close(fd);
           socket_manager->send(response, request, socket);
           return true; // All done, can process next request.
         }
 
-        VLOG(1) << "Sending file at '" << path << "' with length " << s.st_size;
+        VLOG(1) << "Sending file at '" << path << "' with length " << length
+                << " from offset " << offset;
 
         // TODO(benh): Consider a way to have the socket manager turn
         // on TCP_CORK for both sends and then turn it off.
@@ -1071,7 +1694,7 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
 
         // Note the file descriptor gets closed by FileEncoder.
         socket_manager->send(
-            new FileEncoder(socket, fd, s.st_size),
+            new FileEncoder(socket, fd, length, offset),
             request.keepAlive);
       }
     }
@@ -1084,6 +1707,14 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
     // header, we fill in (or overwrite) 'Transfer-Encoding' header.
     response.headers["Transfer-Encoding"] = "chunked";
 
+    // Compress the stream if the client accepts it (and the response
+    // has not already been encoded).
+    if (!response.headers.contains("Content-Encoding") &&
+        request.accepts("gzip")) {
+      response.headers["Content-Encoding"] = "gzip";
+      compressor.reset(new gzip::Compressor());
+    }
+
     VLOG(3) << "Starting \"chunked\" streaming";
 
     socket_manager->send(
@@ -1117,27 +1748,47 @@ void HttpProxy::stream(
 
   bool finished = false; // Whether we're done streaming.
 
-  if (chunk.isReady()) {
+  // Compress the chunk (or finish compressing once done reading) if
+  // the stream is being compressed. Note that the compressor might
+  // not produce any output for a chunk, in which case there is
+  // nothing to send (an empty chunk would end the stream).
+  Try<string> data = chunk.isReady() ? chunk.get() : string();
+  if (chunk.isReady() && compressor.get() != NULL) {
+    data = chunk.get().empty()
+      ? compressor->finish()
+      : compressor->compress(chunk.get());
+  }
+
+  if (chunk.isReady() && data.isError()) {
+    VLOG(1) << "Failed to compress stream: " << data.error();
+    // TODO(bmahler): Have to close connection if headers were sent!
+    socket_manager->send(InternalServerError(), request, socket);
+    finished = true;
+  } else if (chunk.isReady()) {
     std::ostringstream out;
 
+    if (!data.get().empty()) {
+      out << std::hex << data.get().size() << "\r\n";
+      out << data.get();
+      out << "\r\n";
+    }
+
     if (chunk.get().empty()) {
       // Finished reading.
       out << "0\r\n" << "\r\n";
       finished = true;
     } else {
-      out << std::hex << chunk.get().size() << "\r\n";
-      out << chunk.get();
-      out << "\r\n";
-
       // Keep reading.
       reader.read()
         .onAny(defer(self(), &Self::stream, request, lambda::_1));
     }
 
     // Always persist the connection when streaming is not finished.
-    socket_manager->send(
-        new DataEncoder(socket, out.str()),
-        finished ? request.keepAlive : true);
+    if (!out.str().empty()) {
+      socket_manager->send(
+          new DataEncoder(socket, out.str()),
+          finished ? request.keepAlive : true);
+    }
   } else if (chunk.isFailed()) {
     VLOG(1) << "Failed to read from stream: " << chunk.failure();
     // TODO(bmahler): Have to close connection if headers were sent!
@@ -1153,12 +1804,13 @@ void HttpProxy::stream(
   if (finished) {
     reader.close();
     pipe = None();
+    compressor.reset();
     next();
   }
 }
 
 
-SocketManager::SocketManager() {}
+SocketManager::SocketManager() : coalescing(0) {}
 
 
 SocketManager::~SocketManager() {}
@@ -1182,14 +1834,14 @@ void ignore_recv_data(
 {
   if (length.isDiscarded() || length.isFailed()) {
     socket_manager->close(*socket);
-    delete[] data;
+    receive_buffers->release(data);
     delete socket;
     return;
   }
 
   if (length.get() == 0) {
     socket_manager->close(*socket);
-    delete[] data;
+    receive_buffers->release(data);
     delete socket;
     return;
   }
@@ -1214,8 +1866,8 @@ void link_connect(const Future<Nothing>& future, Socket* socket)
     return;
   }
 
-  size_t size = 80 * 1024;
-  char* data = new char[size];
+  size_t size = receive_buffers->size;
+  char* data = receive_buffers->allocate();
 
   socket->recv(data, size)
     .onAny(lambda::bind(
@@ -1261,12 +1913,13 @@ void SocketManager::link(ProcessBase* process, const UPID& to)
 
   Option<Socket> socket = None();
   bool connect = false;
+  bool connected = false;
 
   synchronized (mutex) {
     // Check if the socket address is remote and there isn't a persistant link.
     if (to.address != __address__  && persists.count(to.address) == 0) {
       // Okay, no link, let's create a socket.
-      Try<Socket> create = Socket::create();
+      Try<Socket> create = internal::create(to.address, &connected);
       if (create.isError()) {
         VLOG(1) << "Failed to link, create socket: " << create.error();
         return;
@@ -1298,7 +1951,11 @@ void SocketManager::link(ProcessBase* process, const UPID& to)
 
   if (connect) {
     CHECK_SOME(socket);
-    Socket(socket.get()).connect(to.address) // Copy to drop const.
+    Future<Nothing> connecting = connected
+      ? Future<Nothing>(Nothing())
+      : Socket(socket.get()).connect(to.address); // Copy to drop const.
+
+    connecting
       .onAny(lambda::bind(
           &internal::link_connect,
           lambda::_1,
@@ -1353,7 +2010,7 @@ void send(Encoder* encoder, Socket* socket)
   switch (encoder->kind()) {
     case Encoder::DATA: {
       size_t size;
-      const char* data = reinterpret_cast<DataEncoder*>(encoder)->next(&size);
+      const char* data = static_cast<DataEncoder*>(encoder)->next(&size);
       socket->send(data, size)
         .onAny(lambda::bind(
             &internal::_send,
@@ -1366,7 +2023,7 @@ void send(Encoder* encoder, Socket* socket)
     case Encoder::FILE: {
       off_t offset;
       size_t size;
-      int fd = reinterpret_cast<FileEncoder*>(encoder)->next(&offset, &size);
+      int fd = static_cast<FileEncoder*>(encoder)->next(&offset, &size);
       socket->sendfile(fd, offset, size)
         .onAny(lambda::bind(
             &internal::_send,
@@ -1468,6 +2125,17 @@ void SocketManager::send(
 
 namespace internal {
 
+// Returns an encoder for sending the message on the socket.
+Encoder* encode(const Socket& socket, Message* message)
+{
+  if (binary_messages) {
+    return new BinaryMessageEncoder(socket, message);
+  }
+
+  return new MessageEncoder(socket, message);
+}
+
+
 void send_connect(
     const Future<Nothing>& future,
     Socket* socket,
@@ -1484,13 +2152,13 @@ void send_connect(
     return;
   }
 
-  Encoder* encoder = new MessageEncoder(*socket, message);
+  Encoder* encoder = encode(*socket, message);
 
   // Receive and ignore data from this socket. Note that we don't
   // expect to receive anything other than HTTP '202 Accepted'
   // responses which we just ignore.
-  size_t size = 80 * 1024;
-  char* data = new char[size];
+  size_t size = receive_buffers->size;
+  char* data = receive_buffers->allocate();
 
   socket->recv(data, size)
     .onAny(lambda::bind(
@@ -1514,6 +2182,7 @@ void SocketManager::send(Message* message)
 
   Option<Socket> socket = None();
   bool connect = false;
+  bool connected = false;
 
   synchronized (mutex) {
     // Check if there is already a socket.
@@ -1531,7 +2200,8 @@ void SocketManager::send(Message* message)
       }
 
       if (outgoing.count(socket.get()) > 0) {
-        outgoing[socket.get()].push(new MessageEncoder(socket.get(), message));
+        outgoing[socket.get()].push(
+            internal::encode(socket.get(), message));
         return;
       } else {
         // Initialize the outgoing queue.
@@ -1541,7 +2211,7 @@ void SocketManager::send(Message* message)
     } else {
       // No peristent or temporary socket to the socket address
       // currently exists, so we create a temporary one.
-      Try<Socket> create = Socket::create();
+      Try<Socket> create = internal::create(address, &connected);
       if (create.isError()) {
         VLOG(1) << "Failed to send, create socket: " << create.error();
         delete message;
@@ -1565,7 +2235,11 @@ void SocketManager::send(Message* message)
 
   if (connect) {
     CHECK_SOME(socket);
-    Socket(socket.get()).connect(address) // Copy to drop const.
+    Future<Nothing> connecting = connected
+      ? Future<Nothing>(Nothing())
+      : Socket(socket.get()).connect(address); // Copy to drop const.
+
+    connecting
       .onAny(lambda::bind(
           &internal::send_connect,
           lambda::_1,
@@ -1575,7 +2249,7 @@ void SocketManager::send(Message* message)
     // If we're not connecting and we haven't added the encoder to
     // the 'outgoing' queue then schedule it to be sent.
     internal::send(
-        new MessageEncoder(socket.get(), message),
+        internal::encode(socket.get(), message),
         new Socket(socket.get()));
   }
 }
@@ -1606,6 +2280,11 @@ Encoder* SocketManager::next(int s)
         // More messages!
         Encoder* encoder = outgoing[s].front();
         outgoing[s].pop();
+
+        if (coalescing > 0) {
+          encoder = coalesce(s, encoder);
+        }
+
         return encoder;
       } else {
         // No more messages ... erase the outgoing queue.
@@ -1653,6 +2332,69 @@ Encoder* SocketManager::next(int s)
 }
 
 
+void SocketManager::coalesce(size_t bytes)
+{
+  synchronized (mutex) {
+    coalescing = bytes;
+
+    if (coalescing > 0 && metrics.get() == NULL) {
+      metrics.reset(new Metrics());
+    }
+  }
+}
+
+
+Encoder* SocketManager::coalesce(int s, Encoder* encoder)
+{
+  queue<Encoder*>& encoders = outgoing[s];
+
+  // Only data (i.e., not files) can be coalesced.
+  if (encoder->kind() != Encoder::DATA ||
+      encoder->remaining() >= coalescing ||
+      encoders.empty() ||
+      encoders.front()->kind() != Encoder::DATA) {
+    return encoder;
+  }
+
+  const Socket socket = encoder->socket();
+
+  string data;
+  data.reserve(coalescing);
+
+  size_t count = 0;
+
+  while (true) {
+    // NOTE: An encoder might return its data in several pieces
+    // (e.g., see MessageEncoder).
+    while (encoder->remaining() > 0) {
+      size_t size;
+      const char* piece = static_cast<DataEncoder*>(encoder)->next(&size);
+      data.append(piece, size);
+    }
+
+    delete encoder;
+    count++;
+
+    if (encoders.empty() ||
+        encoders.front()->kind() != Encoder::DATA ||
+        data.size() + encoders.front()->remaining() > coalescing) {
+      break;
+    }
+
+    encoder = encoders.front();
+    encoders.pop();
+  }
+
+  CHECK_NOTNULL(metrics.get());
+
+  ++metrics->batches;
+  metrics->batched_encoders += count;
+  metrics->batched_bytes += data.size();
+
+  return new DataEncoder(socket, data);
+}
+
+
 void SocketManager::close(int s)
 {
   HttpProxy* proxy = NULL; // Non-null if needs to be terminated.
@@ -1838,9 +2580,16 @@ void SocketManager::exited(ProcessBase* process)
 }
 
 
-ProcessManager::ProcessManager(const string& _delegate)
-  : delegate(_delegate)
+ProcessManager::ProcessManager(const string& _delegate, size_t workers)
+  : delegate(_delegate),
+    next(0)
 {
+  CHECK_GT(workers, 0u);
+
+  for (size_t i = 0; i < workers; i++) {
+    runqs.push_back(new RunQueue(i));
+  }
+
   running = 0;
   __sync_synchronize(); // Ensure write to 'running' visible in other threads.
 }
@@ -1935,6 +2684,8 @@ bool ProcessManager::handle(
   if (request->path.find('/') != 0) {
     VLOG(1) << "Returning '400 Bad Request' for '" << request->path << "'";
 
+    internal::ignore(*request);
+
     // Get the HttpProxy pid for this socket.
     PID<HttpProxy> proxy = socket_manager->proxy(socket);
 
@@ -1952,6 +2703,8 @@ bool ProcessManager::handle(
     VLOG(1) << "Returning '404 Not Found' for '" << request->path
             << "' (ignoring requests with relative paths)";
 
+    internal::ignore(*request);
+
     // Get the HttpProxy pid for this socket.
     PID<HttpProxy> proxy = socket_manager->proxy(socket);
 
@@ -1998,6 +2751,8 @@ bool ProcessManager::handle(
   // This has no receiver, send error response.
   VLOG(1) << "Returning '404 Not Found' for '" << request->path << "'";
 
+  internal::ignore(*request);
+
   // Get the HttpProxy pid for this socket.
   PID<HttpProxy> proxy = socket_manager->proxy(socket);
 
@@ -2095,29 +2850,47 @@ void ProcessManager::resume(ProcessBase* process)
   CHECK(process->state == ProcessBase::BOTTOM ||
         process->state == ProcessBase::READY);
 
+  process->accounting.resumes++;
+  process->accounting.runnable += process->readied.elapsed().ns();
+
   if (process->state == ProcessBase::BOTTOM) {
     process->state = ProcessBase::RUNNING;
     try { process->initialize(); }
     catch (...) { terminate = true; }
   }
 
+  process->state = ProcessBase::RUNNING;
+
+  // Drain the events of the process without taking any locks, we only
+  // need to synchronize with the producers when we run out of events.
   while (!terminate && !blocked) {
-    Event* event = NULL;
+    Event* event = process->injected->dequeue();
 
-    process->lock();
-    {
-      if (process->events.size() > 0) {
-        event = process->events.front();
-        process->events.pop_front();
-        process->state = ProcessBase::RUNNING;
-      } else {
+    if (event == NULL) {
+      event = process->events->dequeue();
+    }
+
+    if (event == NULL) {
+      // Block the process and then check for events again since a
+      // producer that enqueued an event before it could see the
+      // process as BLOCKED will not make the process runnable. We
+      // hold the lock so that a producer can't make the process
+      // runnable (and another thread start running it) until we're
+      // done looking at the event queues.
+      process->lock();
+      {
         process->state = ProcessBase::BLOCKED;
         blocked = true;
+
+        if (!process->injected->empty() || !process->events->empty()) {
+          process->state = ProcessBase::RUNNING;
+          blocked = false;
+        }
       }
+      process->unlock();
     }
-    process->unlock();
 
-    if (!blocked) {
+    if (event != NULL) {
       CHECK(event != NULL);
 
       // Determine if we should filter this event.
@@ -2130,6 +2903,8 @@ void ProcessManager::resume(ProcessBase* process)
 
             virtual void visit(const MessageEvent& event)
             {
+              // Filters expect a serialized body.
+              event.message->encode();
               *filter = filterer->filter(event);
             }
 
@@ -2163,6 +2938,12 @@ void ProcessManager::resume(ProcessBase* process)
       // Determine if we should terminate.
       terminate = event->is<TerminateEvent>();
 
+      process->accounting.events++;
+      process->accounting.queued += event->queued.elapsed().ns();
+
+      Stopwatch stopwatch;
+      stopwatch.start();
+
       // Now service the event.
       try {
         process->serve(*event);
@@ -2177,6 +2958,8 @@ void ProcessManager::resume(ProcessBase* process)
         terminate = true;
       }
 
+      process->accounting.running += stopwatch.elapsed().ns();
+
       delete event;
 
       if (terminate) {
@@ -2206,20 +2989,19 @@ void ProcessManager::cleanup(ProcessBase* process)
   // the process we are cleaning up will get dropped (since it's
   // terminating) and eliminates the potential of enqueueing them on
   // another process that gets spawned with the same PID.
-  deque<Event*> events;
+  //
+  // NOTE: a producer that checked the state of the process before we
+  // set it to TERMINATING might still enqueue an event after we have
+  // deleted the pending events, any such event gets deleted along
+  // with the event queues when the process is destructed.
+  process->state = ProcessBase::TERMINATING;
 
-  process->lock();
-  {
-    process->state = ProcessBase::TERMINATING;
-    events = process->events;
-    process->events.clear();
+  // Delete pending events.
+  while (Event* event = process->injected->dequeue()) {
+    delete event;
   }
-  process->unlock();
 
-  // Delete pending events.
-  while (!events.empty()) {
-    Event* event = events.front();
-    events.pop_front();
+  while (Event* event = process->events->dequeue()) {
     delete event;
   }
 
@@ -2238,8 +3020,6 @@ void ProcessManager::cleanup(ProcessBase* process)
 
     process->lock();
     {
-      CHECK(process->events.empty());
-
       processes.erase(process->pid.id);
 
       // Lookup gate to wake up waiting threads.
@@ -2366,24 +3146,35 @@ bool ProcessManager::wait(const UPID& pid)
       // Check if it is runnable in order to donate this thread.
       if (process->state == ProcessBase::BOTTOM ||
           process->state == ProcessBase::READY) {
-        synchronized (runq_mutex) {
-          list<ProcessBase*>::iterator it =
-            find(runq.begin(), runq.end(), process);
-          if (it != runq.end()) {
-            // Found it! Remove it from the run queue since we'll be
-            // donating our thread and also increment 'running' before
-            // leaving this 'runq' protected critical section so that
-            // everyone that is waiting for the processes to settle
-            // continue to wait (otherwise they could see nothing in
-            // 'runq' and 'running' equal to 0 between when we exit
-            // this critical section and increment 'running').
-            runq.erase(it);
-            __sync_fetch_and_add(&running, 1);
-          } else {
-            // Another thread has resumed the process ...
-            process = NULL;
+        bool found = false;
+        foreach (RunQueue* runq, runqs) {
+          synchronized (runq->mutex) {
+            list<ProcessBase*>::iterator it = find(
+                runq->processes.begin(), runq->processes.end(), process);
+            if (it != runq->processes.end()) {
+              // Found it! Remove it from the run queue since we'll be
+              // donating our thread and also increment 'running'
+              // before leaving this 'runq' protected critical section
+              // so that everyone that is waiting for the processes to
+              // settle continue to wait (otherwise they could see
+              // nothing in 'runq' and 'running' equal to 0 between
+              // when we exit this critical section and increment
+              // 'running').
+              runq->processes.erase(it);
+              __sync_fetch_and_add(&running, 1);
+              found = true;
+            }
+          }
+
+          if (found) {
+            break;
           }
         }
+
+        if (!found) {
+          // Another thread has resumed the process ...
+          process = NULL;
+        }
       } else {
         // Process is not runnable, so no need to donate ...
         process = NULL;
@@ -2416,18 +3207,38 @@ bool ProcessManager::wait(const UPID& pid)
 }
 
 
+void ProcessManager::attach(size_t index)
+{
+  CHECK_LT(index, runqs.size());
+  *_runq_ = runqs[index];
+}
+
+
 void ProcessManager::enqueue(ProcessBase* process)
 {
   CHECK(process != NULL);
 
-  // TODO(benh): Check and see if this process has it's own thread. If
-  // it does, push it on that threads runq, and wake up that thread if
-  // it's not running. Otherwise, check and see which thread this
-  // process was last running on, and put it on that threads runq.
+  // Put the process on the run queue of the thread it last ran on so
+  // that it's likely to be resumed there (and benefit from a warm
+  // cache). If it has never run then keep it on the current worker
+  // thread (if any), otherwise distribute it among the run queues.
+  // An idle worker will steal the process if its owner is busy.
+  RunQueue* runq = *_runq_;
+
+  const int affinity = process->affinity.load();
 
-  synchronized (runq_mutex) {
-    CHECK(find(runq.begin(), runq.end(), process) == runq.end());
-    runq.push_back(process);
+  if (affinity >= 0) {
+    runq = runqs[affinity];
+  } else if (runq == NULL) {
+    runq = runqs[__sync_fetch_and_add(&next, 1) % runqs.size()];
+  }
+
+  process->readied.start();
+
+  synchronized (runq->mutex) {
+    CHECK(find(runq->processes.begin(), runq->processes.end(), process) ==
+          runq->processes.end());
+    runq->processes.push_back(process);
   }
 
   // Wake up the processing thread if necessary.
@@ -2437,24 +3248,44 @@ void ProcessManager::enqueue(ProcessBase* process)
 
 ProcessBase* ProcessManager::dequeue()
 {
-  // TODO(benh): Remove a process from this thread's runq. If there
-  // are no processes to run, and this is not a dedicated thread, then
-  // steal one from another threads runq.
+  RunQueue* self = *_runq_;
 
-  ProcessBase* process = NULL;
+  CHECK(self != NULL) << "Only worker threads can dequeue processes";
+
+  // Remove a process from the front of this thread's run queue. If
+  // there are no processes to run then try and steal one from the
+  // back of another thread's run queue, starting with our neighbor
+  // so that the threads don't all pick on the same victim.
+  for (size_t i = 0; i < runqs.size(); i++) {
+    RunQueue* runq = runqs[(self->index + i) % runqs.size()];
+
+    synchronized (runq->mutex) {
+      if (!runq->processes.empty()) {
+        ProcessBase* process = NULL;
+
+        if (runq == self) {
+          process = runq->processes.front();
+          runq->processes.pop_front();
+        } else {
+          process = runq->processes.back();
+          runq->processes.pop_back();
+        }
 
-  synchronized (runq_mutex) {
-    if (!runq.empty()) {
-      process = runq.front();
-      runq.pop_front();
-      // Increment the running count of processes in order to support
-      // the Clock::settle() operation (this must be done atomically
-      // with removing the process from the runq).
-      __sync_fetch_and_add(&running, 1);
+        // Increment the running count of processes in order to
+        // support the Clock::settle() operation (this must be done
+        // atomically with removing the process from the runq).
+        __sync_fetch_and_add(&running, 1);
+
+        // Remember where the process ran so it gets enqueued here
+        // the next time around.
+        process->affinity.store(self->index);
+
+        return process;
+      }
     }
   }
 
-  return process;
+  return NULL;
 }
 
 
@@ -2478,110 +3309,231 @@ void ProcessManager::settle()
 
     done = true; // Assume to start that we are settled.
 
-    synchronized (runq_mutex) {
-      if (!runq.empty()) {
+    // We must hold the locks of all the run queues at the same time
+    // in order to get a consistent view of the run queues and
+    // 'running'. Otherwise a running process could enqueue another
+    // process on a run queue that we have already checked and then
+    // finish before we read 'running'. The locks are always acquired
+    // in the same order and 'enqueue' and 'dequeue' only ever hold a
+    // single run queue lock so this can't deadlock.
+    foreach (RunQueue* runq, runqs) {
+      runq->mutex.lock();
+    }
+
+    foreach (RunQueue* runq, runqs) {
+      if (!runq->processes.empty()) {
         done = false;
-        continue;
+        break;
       }
+    }
 
-      // Read barrier for 'running'.
-      __sync_synchronize();
+    // Read barrier for 'running'.
+    __sync_synchronize();
 
-      if (running > 0) {
-        done = false;
-        continue;
-      }
+    if (done && running > 0) {
+      done = false;
+    }
 
-      if (!Clock::settled()) {
-        done = false;
-        continue;
-      }
+    if (done && !Clock::settled()) {
+      done = false;
+    }
+
+    foreach (RunQueue* runq, runqs) {
+      runq->mutex.unlock();
     }
   } while (!done);
 }
 
 
-Future<Response> ProcessManager::__processes__(const Request&)
+JSON::Object ProcessManager::describe(ProcessBase* process)
 {
-  JSON::Array array;
+  JSON::Object object;
+  object.values["id"] = process->pid.id;
 
-  synchronized (processes_mutex) {
-    foreachvalue (ProcessBase* process, process_manager->processes) {
+  JSON::Array events;
+
+  struct JSONVisitor : EventVisitor
+  {
+    explicit JSONVisitor(JSON::Array* _events) : events(_events) {}
+
+    virtual void visit(const MessageEvent& event)
+    {
       JSON::Object object;
-      object.values["id"] = process->pid.id;
+      object.values["type"] = "MESSAGE";
 
-      JSON::Array events;
+      const Message& message = *event.message;
 
-      struct JSONVisitor : EventVisitor
-      {
-        explicit JSONVisitor(JSON::Array* _events) : events(_events) {}
+      object.values["name"] = message.name;
+      object.values["from"] = string(message.from);
+      object.values["to"] = string(message.to);
+      // NOTE: The message is not ours to encode, the process it is
+      // queued for might be visiting it concurrently.
+      if (message.payload && message.body.empty()) {
+        object.values["body"] = message.payload->serialize();
+      } else {
+        object.values["body"] = message.body;
+      }
 
-        virtual void visit(const MessageEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "MESSAGE";
+      events->values.push_back(object);
+    }
 
-          const Message& message = *event.message;
+    virtual void visit(const HttpEvent& event)
+    {
+      JSON::Object object;
+      object.values["type"] = "HTTP";
 
-          object.values["name"] = message.name;
-          object.values["from"] = string(message.from);
-          object.values["to"] = string(message.to);
-          object.values["body"] = message.body;
+      const Request& request = *event.request;
 
-          events->values.push_back(object);
-        }
+      object.values["method"] = request.method;
+      object.values["url"] = request.url;
 
-        virtual void visit(const HttpEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "HTTP";
+      events->values.push_back(object);
+    }
 
-          const Request& request = *event.request;
+    virtual void visit(const DispatchEvent& event)
+    {
+      JSON::Object object;
+      object.values["type"] = "DISPATCH";
+      events->values.push_back(object);
+    }
 
-          object.values["method"] = request.method;
-          object.values["url"] = request.url;
+    virtual void visit(const ExitedEvent& event)
+    {
+      JSON::Object object;
+      object.values["type"] = "EXITED";
+      events->values.push_back(object);
+    }
 
-          events->values.push_back(object);
-        }
+    virtual void visit(const TerminateEvent& event)
+    {
+      JSON::Object object;
+      object.values["type"] = "TERMINATE";
+      events->values.push_back(object);
+    }
 
-        virtual void visit(const DispatchEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "DISPATCH";
-          events->values.push_back(object);
-        }
+    JSON::Array* events;
+  } visitor(&events);
 
-        virtual void visit(const ExitedEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "EXITED";
-          events->values.push_back(object);
-        }
+  process->injected->visit(&visitor);
+  process->events->visit(&visitor);
 
-        virtual void visit(const TerminateEvent& event)
-        {
-          JSON::Object object;
-          object.values["type"] = "TERMINATE";
-          events->values.push_back(object);
-        }
+  object.values["events"] = events;
 
-        JSON::Array* events;
-      } visitor(&events);
+  const ProcessBase::Accounting& accounting = process->accounting;
+
+  JSON::Object statistics;
+  statistics.values["resumes"] = accounting.resumes;
+  statistics.values["events"] = accounting.events;
+  statistics.values["running_secs"] = Nanoseconds(accounting.running).secs();
+  statistics.values["queued_secs"] = Nanoseconds(accounting.queued).secs();
+  statistics.values["runnable_secs"] = Nanoseconds(accounting.runnable).secs();
+
+  object.values["statistics"] = statistics;
+
+  return object;
+}
+
+
+// Describes a process that did not service the dispatch of the
+// /__processes__ endpoint in time.
+static Future<JSON::Object> unresponsive(
+    const string& id,
+    const Future<JSON::Object>& future)
+{
+  future.discard();
+
+  JSON::Object object;
+  object.values["id"] = id;
+  object.values["unresponsive"] = true;
+  return object;
+}
 
-      process->lock();
-      {
-        foreach (Event* event, process->events) {
-          event->visit(&visitor);
-        }
-      }
-      process->unlock();
 
-      object.values["events"] = events;
-      array.values.push_back(object);
+Future<Response> ProcessManager::__processes__(const Request& request)
+{
+  // Only the thread running a process is allowed to look at the
+  // events of that process so we dispatch to each process in order
+  // to describe it. If a process terminates before it services the
+  // dispatch then its promise is discarded once the dispatch gets
+  // deleted so we don't wait forever. A process that is busy (or
+  // stuck) for longer than the timeout gets reported as unresponsive
+  // rather than holding up the response.
+  Duration timeout = PROCESSES_TIMEOUT;
+
+  Option<string> value = request.query.get("timeout");
+  if (value.isSome()) {
+    Try<Duration> parse = Duration::parse(value.get());
+    if (parse.isError()) {
+      return BadRequest("Invalid timeout '" + value.get() + "': " +
+                        parse.error() + ".\n");
+    }
+    timeout = parse.get();
+  }
+
+  list<Future<JSON::Object>> futures;
+
+  synchronized (processes_mutex) {
+    foreachvalue (ProcessBase* process, processes) {
+      std::shared_ptr<Promise<JSON::Object>> promise(
+          new Promise<JSON::Object>(),
+          [](Promise<JSON::Object>* promise) {
+            promise->discard();
+            delete promise;
+          });
+
+      futures.push_back(promise->future()
+        .after(timeout,
+               lambda::bind(&unresponsive, process->pid.id, lambda::_1)));
+
+      std::shared_ptr<lambda::function<void(ProcessBase*)>> f(
+          new lambda::function<void(ProcessBase*)>(
+              [this, promise](ProcessBase* process) {
+                promise->set(describe(process));
+              }));
+
+      internal::dispatch(process->self(), f);
     }
   }
 
-  return OK(array);
+  // With 'format=folded' respond with the time each process spent
+  // running in the "folded stacks" format of flame graph tools, i.e.,
+  // a line of 'libprocess;<id> <microseconds>' per process.
+  const bool folded = request.query.get("format") == string("folded");
+
+  return await(futures)
+    .then([folded](const list<Future<JSON::Object>>& futures) -> Response {
+      if (folded) {
+        std::ostringstream out;
+        foreach (const Future<JSON::Object>& future, futures) {
+          if (future.isReady() &&
+              future.get().values.count("unresponsive") == 0) {
+            const JSON::Object& object = future.get();
+            const JSON::Object& statistics =
+              object.values.find("statistics")->second.as<JSON::Object>();
+
+            out << "libprocess;"
+                << object.values.find("id")->second.as<JSON::String>().value
+                << " "
+                << static_cast<uint64_t>(
+                       statistics.values.find("running_secs")
+                         ->second.as<JSON::Number>().value * 1000000)
+                << "\n";
+          }
+        }
+
+        OK response(out.str());
+        response.headers["Content-Type"] = "text/plain";
+        return response;
+      }
+
+      JSON::Array array;
+      foreach (const Future<JSON::Object>& future, futures) {
+        if (future.isReady()) {
+          array.values.push_back(future.get());
+        }
+      }
+      return OK(array);
+    });
 }
 
 
@@ -2597,8 +3549,13 @@ ProcessBase::ProcessBase(const string& id)
   pthread_mutex_init(&m, &attr);
   pthread_mutexattr_destroy(&attr);
 
+  events = new EventQueue();
+  injected = new EventQueue();
+
   refs = 0;
 
+  affinity = -1;
+
   pid.id = id != "" ? id : ID::generate();
   pid.address = __address__;
 
@@ -2611,35 +3568,67 @@ ProcessBase::ProcessBase(const string& id)
 }
 
 
-ProcessBase::~ProcessBase() {}
+ProcessBase::~ProcessBase()
+{
+  delete events;
+  delete injected;
+}
 
 
 void ProcessBase::enqueue(Event* event, bool inject)
 {
   CHECK(event != NULL);
 
-  lock();
-  {
-    if (state != TERMINATING && state != TERMINATED) {
-      if (!inject) {
-        events.push_back(event);
-      } else {
-        events.push_front(event);
-      }
+  State old = state;
+
+  if (old == TERMINATING || old == TERMINATED) {
+    delete event;
+    return;
+  }
+
+  if (!inject) {
+    events->enqueue(event);
+  } else {
+    injected->enqueue(event);
+  }
 
+  // If the process is blocked then we need to make it runnable. This
+  // is the only time a producer needs the lock, in order to
+  // synchronize with other producers and with the thread that was
+  // running the process (see ProcessManager::resume).
+  if (state == BLOCKED) {
+    lock();
+    {
       if (state == BLOCKED) {
         state = READY;
         process_manager->enqueue(this);
       }
+    }
+    unlock();
+  }
+}
 
-      CHECK(state == BOTTOM ||
-            state == READY ||
-            state == RUNNING);
-    } else {
-      delete event;
+
+size_t ProcessBase::eventCount(bool (*predicate)(const Event*))
+{
+  return injected->count(predicate) + events->count(predicate);
+}
+
+
+Duration ProcessBase::eventAge()
+{
+  Duration age = Duration::zero();
+
+  // NOTE: The oldest event is at the front of either queue.
+  const Event* fronts[] = { injected->front(), events->front() };
+
+  foreach (const Event* event, fronts) {
+    if (event != NULL && event->queued.elapsed() > age) {
+      age = event->queued.elapsed();
     }
   }
-  unlock();
+
+  return age;
 }
 
 
@@ -2673,8 +3662,34 @@ void ProcessBase::send(
 }
 
 
+void ProcessBase::send(
+    const UPID& to,
+    const string& name,
+    const shared_ptr<const Message::Payload>& payload)
+{
+  if (!to) {
+    return;
+  }
+
+  Message* message = encode(pid, to, name);
+
+  // Only local messages are delivered without serializing them.
+  if (to.address == __address__) {
+    message->payload = payload;
+  } else {
+    message->body = payload->serialize();
+  }
+
+  transport(message, this);
+}
+
+
 void ProcessBase::visit(const MessageEvent& event)
 {
+  // Message handlers and delegates (which might be remote) expect a
+  // serialized body.
+  event.message->encode();
+
   if (handlers.message.count(event.message->name) > 0) {
     handlers.message[event.message->name](
         event.message->from,
@@ -2707,7 +3722,19 @@ void ProcessBase::visit(const HttpEvent& event)
   CHECK(tokens.size() >= 1);
   CHECK_EQ(pid.id, http::decode(tokens[0]).get());
 
-  const string name = tokens.size() > 1 ? tokens[1] : "";
+  string name = tokens.size() > 1 ? tokens[1] : "";
+
+  // Routes may span several path components (e.g., '/api/v1/call'),
+  // in which case the longest route that prefixes the path is used.
+  for (size_t i = tokens.size(); i > 2; i--) {
+    const string route = strings::join(
+        "/", vector<string>(tokens.begin() + 1, tokens.begin() + i));
+
+    if (handlers.http.count(route) > 0) {
+      name = route;
+      break;
+    }
+  }
 
   if (handlers.http.count(name) > 0) {
     // Create the promise to link with whatever gets returned, as well
@@ -2723,7 +3750,23 @@ void ProcessBase::visit(const HttpEvent& event)
     dispatch(proxy, &HttpProxy::handle, future, *event.request);
 
     // Now call the handler and associate the response with the promise.
-    promise->associate(handlers.http[name](*event.request));
+    if (event.request->reader.isSome() &&
+        handlers.streaming.count(name) == 0) {
+      // The handler expects the whole body, so read it first.
+      const HttpRequestHandler handler = handlers.http[name];
+      const Request request = *event.request;
+
+      promise->associate(
+          internal::read(request.reader.get())
+            .then(defer(self(), [=](const string& body) {
+              Request request_ = request;
+              request_.body = body;
+              request_.reader = None();
+              return handler(request_);
+            })));
+    } else {
+      promise->associate(handlers.http[name](*event.request));
+    }
   } else if (assets.count(name) > 0) {
     OK response;
     response.type = Response::PATH;
@@ -2750,6 +3793,8 @@ void ProcessBase::visit(const HttpEvent& event)
     // extension or we don't have a mapping for? It might be better to
     // just let the browser guess (or do it's own default).
 
+    internal::ignore(*event.request);
+
     // Get the HttpProxy pid for this socket.
     PID<HttpProxy> proxy = socket_manager->proxy(event.socket);
 
@@ -2759,6 +3804,8 @@ void ProcessBase::visit(const HttpEvent& event)
   } else {
     VLOG(1) << "Returning '404 Not Found' for '" << event.request->path << "'";
 
+    internal::ignore(*event.request);
+
     // Get the HttpProxy pid for this socket.
     PID<HttpProxy> proxy = socket_manager->proxy(event.socket);
 
@@ -2796,11 +3843,18 @@ UPID ProcessBase::link(const UPID& to)
 void ProcessBase::route(
     const string& name,
     const Option<string>& help_,
-    const HttpRequestHandler& handler)
+    const HttpRequestHandler& handler,
+    bool streaming)
 {
   // Routes must start with '/'.
   CHECK(name.find('/') == 0);
   handlers.http[name.substr(1)] = handler;
+
+  if (streaming) {
+    handlers.streaming.insert(name.substr(1));
+  } else {
+    handlers.streaming.erase(name.substr(1));
+  }
   dispatch(help, &Help::add, pid.id, name, help_);
 }
 
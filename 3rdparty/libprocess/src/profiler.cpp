@@ -6,6 +6,10 @@
 #include <gperftools/profiler.h>
 #endif
 
+#ifdef HAS_TCMALLOC
+#include <gperftools/malloc_extension.h>
+#endif
+
 #include "process/future.hpp"
 #include "process/help.hpp"
 #include "process/http.hpp"
@@ -54,6 +58,25 @@ const std::string Profiler::STOP_HELP()
 }
 
 
+const std::string Profiler::HEAP_HELP()
+{
+  return HELP(
+    TLDR(
+        "Returns a sample of the heap allocations."),
+    USAGE(
+        "/profiler/heap"),
+    DESCRIPTION(
+        "Returns a sample of the live heap allocations in the format of",
+        "the heap profiles of tcmalloc, e.g., to be read with pprof.",
+        "",
+        "Requires libprocess to be configured with --enable-tcmalloc",
+        "and started with LIBPROCESS_ENABLE_PROFILER=1 in the",
+        "environment. The allocations are only sampled if the process",
+        "is started with TCMALLOC_SAMPLE_PARAMETER (e.g., 524288) in",
+        "the environment, otherwise the sample is empty."));
+}
+
+
 Future<http::Response> Profiler::start(const http::Request& request)
 {
 #ifdef HAS_GPERFTOOLS
@@ -122,4 +145,33 @@ Future<http::Response> Profiler::stop(const http::Request& request)
 #endif
 }
 
+
+Future<http::Response> Profiler::heap(const http::Request& request)
+{
+#ifdef HAS_TCMALLOC
+  if (os::getenv("LIBPROCESS_ENABLE_PROFILER", false) != "1") {
+    return http::BadRequest(
+        "The profiler is not enabled. To enable the profiler, libprocess "
+        "must be started with LIBPROCESS_ENABLE_PROFILER=1 in the "
+        "environment.\n");
+  }
+
+  LOG(INFO) << "Sampling the heap";
+
+  std::string sample;
+  MallocExtension::instance()->GetHeapSample(&sample);
+
+  http::OK response(sample);
+  response.headers["Content-Type"] = "application/octet-stream";
+  response.headers["Content-Disposition"] =
+    "attachment; filename=heap.prof";
+
+  return response;
+#else
+  return http::BadRequest(
+      "Tcmalloc is disabled. To enable tcmalloc, "
+      "configure libprocess with --enable-tcmalloc.\n");
+#endif
+}
+
 } // namespace process {
@@ -1,9 +1,14 @@
+#include <errno.h>
+
 #include <glog/logging.h>
 
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <thread>
+
 #include <process/delay.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/id.hpp>
 #include <process/once.hpp>
@@ -12,6 +17,7 @@
 
 #include <stout/check.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/multihashmap.hpp>
 #include <stout/none.hpp>
 #include <stout/os.hpp>
@@ -21,11 +27,10 @@
 namespace process {
 
 
-// TODO(bmahler): This can be optimized to use a thread per pid, where
-// each thread makes a blocking call to waitpid. This eliminates the
-// unfortunate poll delay.
-//
-// Simple bounded linear model for computing the poll interval.
+// Our children are waited for by a thread per pid which makes a
+// blocking call to waitpid, so their termination is noticed without
+// delay. All other processes are polled for, for which we use a
+// simple bounded linear model for computing the poll interval.
 // Values were chosen such that at (50 pids, 100 ms) the CPU usage is
 // less than approx. 0.5% of a single core, and at (500 pids, 1000 ms)
 // less than approx. 1.0% of single core. Tested on Linux 3.10 with
@@ -55,13 +60,28 @@ public:
   Future<Option<int> > reap(pid_t pid)
   {
     // Check to see if this pid exists.
-    if (os::exists(pid)) {
-      Owned<Promise<Option<int> > > promise(new Promise<Option<int> >());
-      promises.put(pid, promise);
-      return promise->future();
-    } else {
+    if (!os::exists(pid)) {
       return None();
     }
+
+    // Start waiting for the pid if it is our child (and we're not
+    // waiting for it already), see 'await' below.
+    if (!promises.contains(pid)) {
+      int status;
+      pid_t result = waitpid(pid, &status, WNOHANG);
+
+      if (result > 0) {
+        // We have reaped a child.
+        return Option<int>(status);
+      } else if (result == 0) {
+        children.insert(pid);
+        std::thread(&ReaperProcess::await, self(), pid).detach();
+      }
+    }
+
+    Owned<Promise<Option<int> > > promise(new Promise<Option<int> >());
+    promises.put(pid, promise);
+    return promise->future();
   }
 
 protected:
@@ -79,7 +99,17 @@ protected:
     // NOTE: A child can only be reaped by us, the parent. If a child exits
     // between waitpid and the (!exists) conditional it will still exist as a
     // zombie; it will be reaped by us on the next loop.
+    //
+    // NOTE: The children we're waiting for in 'await' are skipped.
+    size_t count = 0;
+
     foreach (pid_t pid, promises.keys()) {
+      if (children.contains(pid)) {
+        continue;
+      }
+
+      count++;
+
       int status;
       if (waitpid(pid, &status, WNOHANG) > 0) {
         // We have reaped a child.
@@ -90,7 +120,13 @@ protected:
       }
     }
 
-    delay(interval(), self(), &ReaperProcess::wait); // Reap forever!
+    delay(interval(count), self(), &ReaperProcess::wait); // Reap forever!
+  }
+
+  void reaped(pid_t pid, const Result<int>& status)
+  {
+    children.erase(pid);
+    notify(pid, status);
   }
 
   void notify(pid_t pid, Result<int> status)
@@ -108,10 +144,27 @@ protected:
   }
 
 private:
-  const Duration interval()
+  // Blocks (on a thread of its own) until the child 'pid' terminates.
+  static void await(const PID<ReaperProcess>& reaper, pid_t pid)
   {
-    size_t count = promises.size();
+    int status;
+    pid_t result;
+
+    do {
+      result = waitpid(pid, &status, 0);
+    } while (result == -1 && errno == EINTR);
 
+    // If the child was reaped by someone else we can't know the exit
+    // status, just like for the processes that aren't our children.
+    if (result == pid) {
+      dispatch(reaper, &ReaperProcess::reaped, pid, Result<int>(status));
+    } else {
+      dispatch(reaper, &ReaperProcess::reaped, pid, Result<int>::none());
+    }
+  }
+
+  const Duration interval(size_t count)
+  {
     if (count <= LOW_PID_COUNT) {
       return MIN_REAP_INTERVAL();
     } else if (count >= HIGH_PID_COUNT) {
@@ -127,6 +180,9 @@ private:
   }
 
   multihashmap<pid_t, Owned<Promise<Option<int> > > > promises;
+
+  // The children that are being waited for in 'await'.
+  hashset<pid_t> children;
 };
 
 
@@ -1,3 +1,6 @@
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
@@ -16,6 +19,7 @@
 #include <stout/foreach.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 #include <stout/unreachable.hpp>
@@ -102,16 +106,12 @@ static pid_t defaultClone(const lambda::function<int()>& func)
 }
 
 
-// The main entry of the child process. Note that this function has to
-// be async singal safe.
-static int childMain(
-    const string& path,
-    char** argv,
+// Redirects the I/O of the child process. Note that this function has
+// to be async signal safe.
+static void redirect(
     const Subprocess::IO& in,
     const Subprocess::IO& out,
     const Subprocess::IO& err,
-    os::ExecEnv* envp,
-    const Option<lambda::function<int()>>& setup,
     int stdinFd[2],
     int stdoutFd[2],
     int stderrFd[2])
@@ -152,6 +152,24 @@ static int childMain(
       stderrFd[1] != STDERR_FILENO) {
     while (::close(stderrFd[1]) == -1 && errno == EINTR);
   }
+}
+
+
+// The main entry of the child process. Note that this function has to
+// be async singal safe.
+static int childMain(
+    const string& path,
+    char** argv,
+    const Subprocess::IO& in,
+    const Subprocess::IO& out,
+    const Subprocess::IO& err,
+    os::ExecEnv* envp,
+    const Option<lambda::function<int()>>& setup,
+    int stdinFd[2],
+    int stdoutFd[2],
+    int stderrFd[2])
+{
+  redirect(in, out, err, stdinFd, stdoutFd, stderrFd);
 
   if (setup.isSome()) {
     int status = setup.get()();
@@ -166,6 +184,105 @@ static int childMain(
 }
 
 
+// Returns the executable that 'os::execvpe' would run for 'file' in
+// the given environment, i.e., 'file' itself if it contains a slash,
+// otherwise the first executable file named 'file' in the PATH.
+static Option<string> executable(
+    const string& file,
+    const Option<map<string, string>>& environment)
+{
+  if (strings::contains(file, "/")) {
+    return file;
+  }
+
+  string paths = os::getenv("PATH", false);
+  if (environment.isSome() && environment.get().count("PATH") > 0) {
+    paths = environment.get().at("PATH");
+  }
+
+  foreach (const string& directory, strings::tokenize(paths, ":")) {
+    const string path = path::join(directory, file);
+    if (os::exists(path) &&
+        !os::stat::isdir(path) &&
+        ::access(path.c_str(), X_OK) == 0) {
+      return path;
+    }
+  }
+
+  return None();
+}
+
+
+// Creates the child process with 'vfork', which (unlike 'fork') does
+// not copy the page tables of the parent and is therefore much faster
+// for large parents. Since the child shares the memory of the parent
+// until it execs, it only redirects its I/O and execs the (already
+// resolved, see 'executable' above) executable with the given
+// environment, which must not allocate memory or modify the state of
+// the parent (hence 'execve' rather than 'os::execvpe', which
+// temporarily replaces 'environ').
+//
+// All signals are blocked across the 'vfork' so that no signal
+// handler of the parent runs in the child (on the parent's stack and
+// memory) before it execs. The child resets the handlers to their
+// defaults and restores the signal mask right before the 'execve'.
+static pid_t vforkChild(
+    const string& executable,
+    char** argv,
+    const Subprocess::IO& in,
+    const Subprocess::IO& out,
+    const Subprocess::IO& err,
+    os::ExecEnv* envp,
+    int stdinFd[2],
+    int stdoutFd[2],
+    int stderrFd[2])
+{
+  sigset_t all;
+  sigset_t mask;
+  ::sigfillset(&all);
+  ::pthread_sigmask(SIG_BLOCK, &all, &mask);
+
+  pid_t pid = ::vfork();
+  if (pid == 0) {
+    // Child.
+    redirect(in, out, err, stdinFd, stdoutFd, stderrFd);
+
+    // NOTE: Changing the dispositions only affects the child, they
+    // are not part of the memory shared with the parent. Ignored
+    // signals stay ignored across the 'execve' as they would with
+    // 'fork'.
+    for (int signal = 1; signal < NSIG; signal++) {
+      struct sigaction action;
+      if (::sigaction(signal, NULL, &action) == 0 &&
+          action.sa_handler != SIG_IGN &&
+          action.sa_handler != SIG_DFL) {
+        action.sa_handler = SIG_DFL;
+        action.sa_flags = 0;
+        ::sigaction(signal, &action, NULL);
+      }
+    }
+
+    ::pthread_sigmask(SIG_SETMASK, &mask, NULL);
+
+    ::execve(executable.c_str(), argv, (*envp)());
+
+    const char message[] = "Failed to execve in vforkChild\n";
+    while (::write(STDERR_FILENO, message, sizeof(message) - 1) == -1 &&
+           errno == EINTR);
+
+    ::_exit(127);
+  }
+
+  // Parent (or -1 if 'vfork' failed). Save the errno as restoring
+  // the signal mask might overwrite it.
+  int errno_ = errno;
+  ::pthread_sigmask(SIG_SETMASK, &mask, NULL);
+  errno = errno_;
+
+  return pid;
+}
+
+
 Try<Subprocess> subprocess(
     const string& path,
     vector<string> argv,
@@ -329,24 +446,50 @@ Try<Subprocess> subprocess(
   // execle once we have no user supplied environment.
   os::ExecEnv envp(environment.get(map<string, string>()));
 
-  // Determine the function to clone the child process. If the user
-  // does not specify the clone function, we will use the default.
-  lambda::function<pid_t(const lambda::function<int()>&)> clone =
-    (_clone.isSome() ? _clone.get() : defaultClone);
-
-  // Now, clone the child process.
-  pid_t pid = clone(lambda::bind(
-      &childMain,
-      path,
-      _argv,
-      in,
-      out,
-      err,
-      &envp,
-      setup,
-      stdinFd,
-      stdoutFd,
-      stderrFd));
+  // If nothing but the I/O redirection needs to happen in the child,
+  // i.e., there is no setup function and no clone function (which is
+  // used to enter new namespaces), we can 'vfork' the child rather
+  // than copy the parent, see 'vforkChild'. This requires resolving
+  // the executable beforehand, so we fall back to cloning the child
+  // if it can't be found (for the error to surface in the child).
+  Option<string> executable_ = None();
+  if (setup.isNone() && _clone.isNone()) {
+    executable_ = executable(path, environment);
+  }
+
+  pid_t pid = -1;
+
+  if (executable_.isSome()) {
+    pid = vforkChild(
+        executable_.get(),
+        _argv,
+        in,
+        out,
+        err,
+        &envp,
+        stdinFd,
+        stdoutFd,
+        stderrFd);
+  } else {
+    // Determine the function to clone the child process. If the user
+    // does not specify the clone function, we will use the default.
+    lambda::function<pid_t(const lambda::function<int()>&)> clone =
+      (_clone.isSome() ? _clone.get() : defaultClone);
+
+    // Now, clone the child process.
+    pid = clone(lambda::bind(
+        &childMain,
+        path,
+        _argv,
+        in,
+        out,
+        err,
+        &envp,
+        setup,
+        stdinFd,
+        stdoutFd,
+        stderrFd));
+  }
 
   delete[] _argv;
 
@@ -29,8 +29,10 @@
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
+#include <process/mutex.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/sequence.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
@@ -219,7 +221,9 @@ private:
 // or have the ability to disable local messages in libprocess.
 
 // Launches many clients against a central server and measures
-// client throughput.
+// client throughput and latency. The measurements are also recorded
+// as properties of the test, i.e., written to the XML output of the
+// test (see '--gtest_output').
 TEST(Process, Process_BENCHMARK_ClientServer)
 {
   const size_t numRequests = 10000;
@@ -259,6 +263,7 @@ TEST(Process, Process_BENCHMARK_ClientServer)
   Duration elapsed = watch.elapsed();
 
   // Print the throughput of each client.
+  Duration latency = Duration::zero();
   size_t i = 0;
   foreach (const http::Response& response, responses.get()) {
     ASSERT_EQ(http::statuses[200], response.status);
@@ -269,12 +274,21 @@ TEST(Process, Process_BENCHMARK_ClientServer)
 
     cout << "Client " << i << ": " << throughput << " rpcs / sec" << endl;
 
+    // Each client keeps 'concurrency' requests outstanding.
+    latency += elapsed.get() * concurrency / numRequests;
+
     i++;
   }
 
   double throughput = (numRequests * numClients) / elapsed.secs();
   cout << "Estimated Total: " << throughput << " rpcs / sec" << endl;
 
+  latency = latency / numClients;
+  cout << "Estimated Latency: " << latency << endl;
+
+  RecordProperty("rpcs_per_sec", stringify(throughput));
+  RecordProperty("latency_us", stringify(latency.us()));
+
   foreach (const Owned<ClientProcess>& client, clients) {
     terminate(*client);
     wait(*client);
@@ -361,6 +375,7 @@ TEST(Process, Process_BENCHMARK_LargeNumberOfLinks)
   }
 
   cout << "Elapsed: " << watch.elapsed() << endl;
+  RecordProperty("elapsed_ms", stringify(watch.elapsed().ms()));
 
   foreach (ProcessBase* process, processes) {
     terminate(process);
@@ -368,3 +383,68 @@ TEST(Process, Process_BENCHMARK_LargeNumberOfLinks)
     delete process;
   }
 }
+
+
+// Measures the overhead of serializing callbacks through a Sequence,
+// for callbacks that complete right away.
+TEST(Sequence, Sequence_BENCHMARK_Add)
+{
+  const int callbacks = 100000;
+
+  Sequence sequence;
+
+  lambda::function<Future<Nothing>(void)> callback = []() {
+    return Future<Nothing>(Nothing());
+  };
+
+  Stopwatch watch;
+  watch.start();
+
+  Future<Nothing> last;
+  for (int i = 0; i < callbacks; i++) {
+    last = sequence.add(callback);
+  }
+
+  AWAIT_READY(last);
+
+  cout << "Sequenced " << callbacks << " callbacks in "
+       << watch.elapsed() << endl;
+}
+
+
+// Measures the overhead of acquiring and releasing a Mutex, with and
+// without waiters.
+TEST(Mutex, Mutex_BENCHMARK_LockUnlock)
+{
+  const int iterations = 100000;
+
+  Mutex mutex;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (int i = 0; i < iterations; i++) {
+    AWAIT_READY(mutex.lock());
+    mutex.unlock();
+  }
+
+  cout << "Uncontended: " << iterations << " locks in "
+       << watch.elapsed() << endl;
+
+  vector<Future<Nothing>> locks;
+
+  watch.start();
+
+  for (int i = 0; i < iterations; i++) {
+    locks.push_back(mutex.lock());
+  }
+
+  for (int i = 0; i < iterations; i++) {
+    mutex.unlock();
+  }
+
+  AWAIT_READY(locks.back());
+
+  cout << "Contended: " << iterations << " locks in "
+       << watch.elapsed() << endl;
+}
@@ -0,0 +1,123 @@
+#include <gmock/gmock.h>
+
+#include <process/coroutine.hpp>
+#include <process/future.hpp>
+#include <process/gtest.hpp>
+#include <process/process.hpp>
+
+#include <stout/nothing.hpp>
+
+using namespace process;
+
+
+class CoroutineProcess : public Process<CoroutineProcess>
+{
+public:
+  Promise<int> first;
+  Promise<int> second;
+};
+
+
+// Awaits the two promises of the process and returns the sum of their
+// values, counting how many times the coroutine was (re-)entered.
+struct Sum : Coroutine<int>
+{
+  Sum(CoroutineProcess* _process, int* _entered)
+    : process(_process), entered(_entered) {}
+
+  virtual void run()
+  {
+    (*entered)++;
+
+    COROUTINE_BEGIN();
+
+    COROUTINE_AWAIT(first, process->first.future());
+
+    // Already ready futures don't suspend the coroutine.
+    COROUTINE_AWAIT(ready, Future<int>(1));
+
+    COROUTINE_AWAIT(second, process->second.future());
+
+    COROUTINE_RETURN(first.get() + ready.get() + second.get());
+
+    COROUTINE_END();
+  }
+
+  CoroutineProcess* process;
+  int* entered;
+
+  Future<int> first;
+  Future<int> ready;
+  Future<int> second;
+};
+
+
+TEST(Coroutine, Ready)
+{
+  CoroutineProcess process;
+  spawn(process);
+
+  int entered = 0;
+
+  Future<int> sum = coroutine(process.self(), new Sum(&process, &entered));
+
+  process.first.set(2);
+  process.second.set(3);
+
+  AWAIT_EXPECT_EQ(6, sum);
+
+  // Started and resumed once for each pending future.
+  EXPECT_EQ(3, entered);
+
+  terminate(process);
+  wait(process);
+}
+
+
+TEST(Coroutine, Failed)
+{
+  CoroutineProcess process;
+  spawn(process);
+
+  int entered = 0;
+
+  Future<int> sum = coroutine(process.self(), new Sum(&process, &entered));
+
+  process.first.fail("Failure");
+
+  AWAIT_EXPECT_FAILED(sum);
+  EXPECT_EQ("Failure", sum.failure());
+
+  terminate(process);
+  wait(process);
+}
+
+
+TEST(Coroutine, Discard)
+{
+  CoroutineProcess process;
+  spawn(process);
+
+  int entered = 0;
+
+  Future<int> sum = coroutine(process.self(), new Sum(&process, &entered));
+
+  process.first.set(2);
+
+  // Discarding the result is propagated to the awaited future, which
+  // we discard in turn, after which the coroutine is abandoned.
+  Promise<Nothing> discarded;
+  process.second.future()
+    .onDiscard([&discarded]() { discarded.set(Nothing()); });
+
+  sum.discard();
+
+  AWAIT_READY(discarded.future());
+
+  process.second.discard();
+
+  AWAIT_DISCARDED(sum);
+
+  terminate(process);
+  wait(process);
+}
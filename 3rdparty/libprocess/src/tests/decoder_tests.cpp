@@ -3,6 +3,7 @@
 #include <deque>
 #include <string>
 
+#include <process/gtest.hpp>
 #include <process/socket.hpp>
 
 #include <stout/gtest.hpp>
@@ -80,6 +81,74 @@ TEST(Decoder, RequestHeaderContinuation)
 }
 
 
+TEST(Decoder, StreamingRequest)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+  DataDecoder decoder(socket.get());
+
+  const string headers =
+    "POST /path/file.json?key=value HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n";
+
+  // The request is handed off once the headers are decoded.
+  deque<Request*> requests = decoder.decode(headers.data(), headers.length());
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1, requests.size());
+
+  Request* request = requests[0];
+  EXPECT_EQ("POST", request->method);
+  EXPECT_SOME_EQ("value", request->query.get("key"));
+  EXPECT_TRUE(request->body.empty());
+  ASSERT_SOME(request->reader);
+
+  Pipe::Reader reader = request->reader.get();
+
+  Future<string> read = reader.read();
+  EXPECT_TRUE(read.isPending());
+
+  // The body is written to the pipe as it is decoded.
+  const string chunk = "5\r\nhello\r\n";
+
+  requests = decoder.decode(chunk.data(), chunk.length());
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_TRUE(requests.empty());
+
+  AWAIT_EXPECT_EQ("hello", read);
+
+  const string last = "0\r\n\r\n";
+
+  requests = decoder.decode(last.data(), last.length());
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_TRUE(requests.empty());
+
+  AWAIT_EXPECT_EQ("", reader.read()); // End-of-file.
+
+  delete request;
+}
+
+
+TEST(Decoder, RequestBodyTooLarge)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+  DataDecoder decoder(socket.get(), 4);
+
+  const string data =
+    "POST /path/file.json HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "Content-Length: 5\r\n"
+    "\r\n"
+    "hello";
+
+  deque<Request*> requests = decoder.decode(data.data(), data.length());
+  EXPECT_TRUE(decoder.failed());
+  EXPECT_TRUE(requests.empty());
+}
+
+
 // This is expected to fail for now, see my TODO(bmahler) on http::Request.
 TEST(Decoder, DISABLED_RequestHeaderCaseInsensitive)
 {
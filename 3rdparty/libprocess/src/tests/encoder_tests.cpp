@@ -1,5 +1,6 @@
 #include <gmock/gmock.h>
 
+#include <algorithm>
 #include <deque>
 #include <string>
 #include <vector>
@@ -7,6 +8,7 @@
 #include <process/http.hpp>
 #include <process/socket.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 
 #include "encoder.hpp"
@@ -47,6 +49,207 @@ TEST(Encoder, Response)
 }
 
 
+// Tests that a response gets encoded correctly when its body gets
+// sent separately from its headers, even if only parts of it get
+// sent at a time.
+TEST(Encoder, LargeResponse)
+{
+  Try<network::Socket> socket = network::Socket::create();
+  ASSERT_SOME(socket);
+
+  Request request;
+
+  string body;
+  for (size_t i = 0; i < 1024 * 1024; i++) {
+    body.push_back('a' + (i % 26));
+  }
+
+  const OK response(body);
+
+  HttpResponseEncoder encoder(socket.get(), response, request);
+
+  // Pretend that only half of the data gets sent each time.
+  string encoded;
+  while (encoder.remaining() > 0) {
+    size_t length;
+    const char* data = encoder.next(&length);
+    size_t sent = std::max<size_t>(length / 2, 1);
+    encoded.append(data, sent);
+    encoder.backup(length - sent);
+  }
+
+  EXPECT_EQ(HttpResponseEncoder::encode(response, request).size(),
+            encoded.size());
+
+  ResponseDecoder decoder;
+  deque<Response*> responses = decoder.decode(encoded.data(), encoded.length());
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1u, responses.size());
+
+  Response* decoded = responses[0];
+  EXPECT_EQ("200 OK", decoded->status);
+  EXPECT_EQ(body, decoded->body);
+
+  delete decoded;
+}
+
+
+// Tests that a message gets encoded correctly (both when its body
+// gets copied and when it gets sent in pieces) even if only parts of
+// it get sent at a time.
+TEST(Encoder, Message)
+{
+  Try<network::Socket> socket = network::Socket::create();
+  ASSERT_SOME(socket);
+
+  vector<size_t> sizes;
+  sizes.push_back(0);
+  sizes.push_back(100);
+  sizes.push_back(1024 * 1024);
+
+  foreach (size_t size, sizes) {
+    Message* message = new Message();
+    message->name = "name";
+    message->from = UPID("from", net::IP(INADDR_LOOPBACK), 1);
+    message->to = UPID("to", net::IP(INADDR_LOOPBACK), 2);
+    for (size_t i = 0; i < size; i++) {
+      message->body.push_back('a' + (i % 26));
+    }
+
+    const string body = message->body;
+
+    MessageEncoder encoder(socket.get(), message);
+
+    // Pretend that only half of the data gets sent each time.
+    string encoded;
+    while (encoder.remaining() > 0) {
+      size_t length;
+      const char* data = encoder.next(&length);
+      size_t sent = std::max<size_t>(length / 2, 1);
+      encoded.append(data, sent);
+      encoder.backup(length - sent);
+    }
+
+    DataDecoder decoder(socket.get());
+
+    // Decode the request in pieces as if it was received in pieces.
+    deque<Request*> requests;
+    for (size_t i = 0; i < encoded.length(); i += 4096) {
+      deque<Request*> decoded = decoder.decode(
+          encoded.data() + i,
+          std::min<size_t>(4096, encoded.length() - i));
+      requests.insert(requests.end(), decoded.begin(), decoded.end());
+    }
+
+    ASSERT_FALSE(decoder.failed());
+    ASSERT_EQ(1u, requests.size());
+
+    Request* request = requests[0];
+    EXPECT_EQ("POST", request->method);
+    EXPECT_EQ("/to/name", request->path);
+    EXPECT_SOME_EQ(
+        "libprocess/" + stringify(message->from),
+        request->headers.get("User-Agent"));
+    EXPECT_EQ(body, request->body);
+
+    delete request;
+  }
+}
+
+
+TEST(Encoder, BinaryMessage)
+{
+  Try<network::Socket> socket = network::Socket::create();
+  ASSERT_SOME(socket);
+
+  const UPID from("from", net::IP(INADDR_LOOPBACK), 1);
+  const UPID to("to", net::IP(INADDR_LOOPBACK), 2);
+
+  // Encode two messages back to back, as if sent on one socket.
+  string encoded;
+  for (size_t size = 0; size <= 100; size += 100) {
+    Message* message = new Message();
+    message->name = "name" + stringify(size);
+    message->from = from;
+    message->to = to;
+    message->body = string(size, 'a');
+
+    BinaryMessageEncoder encoder(socket.get(), message);
+
+    while (encoder.remaining() > 0) {
+      size_t length;
+      const char* data = encoder.next(&length);
+      encoded.append(data, length);
+    }
+  }
+
+  ASSERT_EQ(static_cast<char>(BinaryMessageEncoder::MAGIC), encoded[0]);
+
+  MessageDecoder decoder;
+
+  // Decode the messages in small pieces so that both the header and
+  // the rest of a frame get split.
+  deque<Message*> messages;
+  for (size_t i = 0; i < encoded.length(); i += 7) {
+    deque<Message*> decoded = decoder.decode(
+        encoded.data() + i,
+        std::min<size_t>(7, encoded.length() - i));
+    messages.insert(messages.end(), decoded.begin(), decoded.end());
+  }
+
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(2u, messages.size());
+
+  EXPECT_EQ("name0", messages[0]->name);
+  EXPECT_EQ(from, messages[0]->from);
+  EXPECT_EQ("to", messages[0]->to.id);
+  EXPECT_EQ("", messages[0]->body);
+
+  EXPECT_EQ("name100", messages[1]->name);
+  EXPECT_EQ(from, messages[1]->from);
+  EXPECT_EQ("to", messages[1]->to.id);
+  EXPECT_EQ(string(100, 'a'), messages[1]->body);
+
+  foreach (Message* message, messages) {
+    delete message;
+  }
+
+  // Anything but a frame (e.g., HTTP) fails the decoder.
+  const string request = "POST /to/name HTTP/1.1\r\n\r\n";
+  EXPECT_TRUE(decoder.decode(request.data(), request.length()).empty());
+  EXPECT_TRUE(decoder.failed());
+}
+
+
+// A frame whose header claims more than the maximum size fails the
+// decoder rather than having it wait for (and reserve memory for)
+// the rest of the frame.
+TEST(Encoder, BinaryMessageTooLarge)
+{
+  Try<network::Socket> socket = network::Socket::create();
+  ASSERT_SOME(socket);
+
+  Message* message = new Message();
+  message->name = "name";
+  message->from = UPID("from", net::IP(INADDR_LOOPBACK), 1);
+  message->to = UPID("to", net::IP(INADDR_LOOPBACK), 2);
+  message->body = string(100, 'a');
+
+  BinaryMessageEncoder encoder(socket.get(), message);
+
+  // Only the header gets decoded.
+  const size_t header = BinaryMessageEncoder::HEADER_SIZE;
+
+  size_t length;
+  const char* data = encoder.next(&length);
+  ASSERT_LE(header, length);
+
+  MessageDecoder decoder(100);
+  EXPECT_TRUE(decoder.decode(data, header).empty());
+  EXPECT_TRUE(decoder.failed());
+}
+
+
 TEST(Encoder, AcceptableEncodings)
 {
   // Create requests that do not accept gzip encoding.
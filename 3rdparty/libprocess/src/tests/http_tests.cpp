@@ -8,6 +8,7 @@
 #include <string>
 
 #include <process/address.hpp>
+#include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -16,11 +17,14 @@
 #include <process/socket.hpp>
 
 #include <stout/base64.hpp>
+#include <stout/duration.hpp>
 #include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 
 #include "encoder.hpp"
 
@@ -49,6 +53,7 @@ public:
   MOCK_METHOD1(pipe, Future<http::Response>(const http::Request&));
   MOCK_METHOD1(get, Future<http::Response>(const http::Request&));
   MOCK_METHOD1(post, Future<http::Response>(const http::Request&));
+  MOCK_METHOD1(stream, Future<http::Response>(const http::Request&));
 
 protected:
   virtual void initialize()
@@ -58,6 +63,7 @@ protected:
     route("/pipe", None(), &HttpProcess::pipe);
     route("/get", None(), &HttpProcess::get);
     route("/post", None(), &HttpProcess::post);
+    route("/stream", None(), &HttpProcess::stream, true);
   }
 
   Future<http::Response> auth(const http::Request& request)
@@ -181,6 +187,49 @@ TEST(HTTP, Endpoints)
 }
 
 
+// Tests that a streamed response gets compressed when the client
+// accepts gzip.
+TEST(HTTP, PipeGzip)
+{
+  Http http;
+
+  http::Pipe pipe;
+  http::OK ok;
+  ok.type = http::Response::PIPE;
+  ok.reader = pipe.reader();
+
+  Future<Nothing> request;
+  EXPECT_CALL(*http.process, pipe(_))
+    .WillOnce(DoAll(FutureSatisfy(&request),
+                    Return(ok)));
+
+  hashmap<string, string> headers;
+  headers["Accept-Encoding"] = "gzip";
+
+  Future<http::Response> future =
+    http::get(http.process->self(), "pipe", None(), headers);
+
+  AWAIT_READY(request);
+
+  // Write the response in a few chunks, note that the response
+  // decoder decompresses the body.
+  string body;
+  http::Pipe::Writer writer = pipe.writer();
+  for (int i = 0; i < 100; i++) {
+    const string line = "Hello World " + stringify(i) + "\n";
+    EXPECT_TRUE(writer.write(line));
+    body += line;
+  }
+  EXPECT_TRUE(writer.close());
+
+  AWAIT_READY(future);
+  EXPECT_EQ(http::statuses[200], future.get().status);
+  EXPECT_SOME_EQ("chunked", future.get().headers.get("Transfer-Encoding"));
+  EXPECT_SOME_EQ("gzip", future.get().headers.get("Content-Encoding"));
+  EXPECT_EQ(body, future.get().body);
+}
+
+
 TEST(HTTP, PipeEOF)
 {
   http::Pipe pipe;
@@ -297,6 +346,36 @@ TEST(HTTP, PipeReaderCloses)
 }
 
 
+TEST(HTTP, PipeCapacity)
+{
+  http::Pipe pipe(10);
+  http::Pipe::Reader reader = pipe.reader();
+  http::Pipe::Writer writer = pipe.writer();
+
+  // The pipe is writable until the unread data reaches the capacity.
+  EXPECT_TRUE(writer.write("hello"));
+  AWAIT_READY(writer.writable());
+
+  EXPECT_TRUE(writer.write("world"));
+
+  Future<Nothing> writable = writer.writable();
+  EXPECT_TRUE(writable.isPending());
+
+  // Reading makes room in the pipe.
+  AWAIT_EQ("hello", reader.read());
+  AWAIT_READY(writable);
+
+  // Closing the read end unblocks the writer as well.
+  EXPECT_TRUE(writer.write("!!!!!"));
+
+  writable = writer.writable();
+  EXPECT_TRUE(writable.isPending());
+
+  EXPECT_TRUE(reader.close());
+  AWAIT_READY(writable);
+}
+
+
 TEST(HTTP, Encode)
 {
   string unencoded = "a$&+,/:;=?@ \"<>#%{}|\\^~[]`\x19\x80\xFF";
@@ -417,6 +496,71 @@ TEST(HTTP, Get)
 }
 
 
+TEST(HTTP, PathRange)
+{
+  Http http;
+
+  Try<string> path = os::mktemp();
+  ASSERT_SOME(path);
+  ASSERT_SOME(os::write(path.get(), "0123456789"));
+
+  http::OK ok;
+  ok.type = http::Response::PATH;
+  ok.path = path.get();
+  ok.headers["Content-Type"] = "application/octet-stream";
+
+  EXPECT_CALL(*http.process, body(_))
+    .WillRepeatedly(Return(ok));
+
+  // Without a 'Range' header the whole file is sent.
+  Future<http::Response> response = http::get(http.process->self(), "body");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("0123456789", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes", "Accept-Ranges", response);
+
+  hashmap<string, string> headers;
+
+  // A bounded range.
+  headers["Range"] = "bytes=2-5";
+  response = http::get(http.process->self(), "body", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::statuses[206], response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("2345", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 2-5/10", "Content-Range", response);
+
+  // An open ended range.
+  headers["Range"] = "bytes=7-";
+  response = http::get(http.process->self(), "body", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::statuses[206], response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("789", response);
+
+  // A suffix range.
+  headers["Range"] = "bytes=-3";
+  response = http::get(http.process->self(), "body", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::statuses[206], response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("789", response);
+
+  // A range past the end of the file cannot be satisfied.
+  headers["Range"] = "bytes=10-";
+  response = http::get(http.process->self(), "body", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::statuses[416], response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes */10", "Content-Range", response);
+
+  // Multiple ranges are not supported, the whole file is sent.
+  headers["Range"] = "bytes=0-1,4-5";
+  response = http::get(http.process->self(), "body", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("0123456789", response);
+
+  ASSERT_SOME(os::rm(path.get()));
+}
+
+
 TEST(HTTP, StreamingGetComplete)
 {
   Http http;
@@ -551,6 +695,245 @@ TEST(HTTP, Post)
 }
 
 
+// Reads the pipe until end-of-file.
+Future<string> readAll(http::Pipe::Reader reader, const string& read = "")
+{
+  return reader.read()
+    .then([=](const string& data) -> Future<string> {
+      if (data.empty()) {
+        return read;
+      }
+
+      return readAll(reader, read + data);
+    });
+}
+
+
+TEST(HTTP, StreamingPost)
+{
+  Http http;
+
+  // Large enough for the body to be streamed.
+  const string body(1024 * 1024, 'x');
+
+  // A streaming handler reads the body from the request's pipe.
+  Promise<string> streamed;
+
+  EXPECT_CALL(*http.process, stream(_))
+    .WillOnce(Invoke([&streamed](const http::Request& request) {
+      EXPECT_TRUE(request.body.empty());
+      EXPECT_SOME(request.reader);
+
+      streamed.associate(readAll(request.reader.get()));
+      return http::OK();
+    }));
+
+  Future<http::Response> response =
+    http::post(http.process->self(), "stream", None(), body, "text/plain");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_EQ(body, streamed.future());
+
+  // Any other handler gets the whole body.
+  EXPECT_CALL(*http.process, post(_))
+    .WillOnce(Invoke([&body](const http::Request& request) {
+      EXPECT_EQ(body, request.body);
+      EXPECT_NONE(request.reader);
+
+      return http::OK();
+    }));
+
+  response =
+    http::post(http.process->self(), "post", None(), body, "text/plain");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+}
+
+
+// Forward declaration.
+Future<string> _receiveRequest(
+    Socket socket,
+    const string& received,
+    const string& data);
+
+
+// Receives from the socket until the headers of a request (without
+// a body) are complete.
+Future<string> receiveRequest(Socket socket, const string& received = "")
+{
+  if (strings::contains(received, "\r\n\r\n")) {
+    return received;
+  }
+
+  return socket.recv(None())
+    .then(lambda::bind(&_receiveRequest, socket, received, lambda::_1));
+}
+
+
+Future<string> _receiveRequest(
+    Socket socket,
+    const string& received,
+    const string& data)
+{
+  if (data.empty()) {
+    return Failure("Socket closed");
+  }
+
+  return receiveRequest(socket, received + data);
+}
+
+
+TEST(HTTP, PersistentConnection)
+{
+  Try<Socket> create = Socket::create();
+  ASSERT_SOME(create);
+
+  Socket server = create.get();
+
+  Try<network::Address> address =
+    server.bind(network::Address(net::IP(INADDR_LOOPBACK), 0));
+  ASSERT_SOME(address);
+  ASSERT_SOME(server.listen(8));
+
+  URL url("http", address.get().ip, address.get().port, "first");
+
+  Future<Socket> accept = server.accept();
+
+  Future<http::Response> response = http::get(url);
+
+  AWAIT_READY(accept);
+
+  Socket connection = accept.get();
+
+  Future<string> request = receiveRequest(connection);
+  AWAIT_READY(request);
+  EXPECT_TRUE(strings::startsWith(request.get(), "GET /first HTTP/1.1\r\n"));
+  EXPECT_TRUE(strings::contains(request.get(), "Connection: keep-alive\r\n"));
+
+  AWAIT_READY(connection.send(
+      "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nfirst"));
+
+  AWAIT_READY(response);
+  EXPECT_EQ(http::statuses[200], response.get().status);
+  EXPECT_EQ("first", response.get().body);
+
+  // The next request should be sent on the same connection.
+  accept = server.accept();
+
+  url.path = "second";
+  response = http::get(url);
+
+  request = receiveRequest(connection);
+  AWAIT_READY(request);
+  EXPECT_TRUE(strings::startsWith(request.get(), "GET /second HTTP/1.1\r\n"));
+
+  // Ask the client to close the connection after this response.
+  AWAIT_READY(connection.send(
+      "HTTP/1.1 200 OK\r\nConnection: close\r\n"
+      "Content-Length: 6\r\n\r\nsecond"));
+
+  AWAIT_READY(response);
+  EXPECT_EQ("second", response.get().body);
+  EXPECT_TRUE(accept.isPending());
+
+  // Hence the next request needs a new connection.
+  url.path = "third";
+  response = http::get(url);
+
+  AWAIT_READY(accept);
+
+  request = receiveRequest(accept.get());
+  AWAIT_READY(request);
+  EXPECT_TRUE(strings::startsWith(request.get(), "GET /third HTTP/1.1\r\n"));
+
+  AWAIT_READY(accept.get().send(
+      "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nthird"));
+
+  AWAIT_READY(response);
+  EXPECT_EQ("third", response.get().body);
+}
+
+
+// Tests that an idle persistent connection gets closed after a while.
+TEST(HTTP, PersistentConnectionIdleTimeout)
+{
+  // Must be kept in sync with CONNECTION_IDLE_TIMEOUT in http.cpp.
+  const Duration timeout = Seconds(30);
+
+  Clock::pause();
+
+  Try<Socket> create = Socket::create();
+  ASSERT_SOME(create);
+
+  Socket server = create.get();
+
+  Try<network::Address> address =
+    server.bind(network::Address(net::IP(INADDR_LOOPBACK), 0));
+  ASSERT_SOME(address);
+  ASSERT_SOME(server.listen(8));
+
+  URL url("http", address.get().ip, address.get().port, "first");
+
+  Future<Socket> accept = server.accept();
+
+  Future<http::Response> response = http::get(url);
+
+  AWAIT_READY(accept);
+
+  Socket connection = accept.get();
+
+  Future<string> request = receiveRequest(connection);
+  AWAIT_READY(request);
+
+  AWAIT_READY(connection.send(
+      "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nfirst"));
+
+  AWAIT_READY(response);
+  EXPECT_EQ("first", response.get().body);
+
+  // The connection is still open just before the timeout ...
+  Clock::advance(timeout - Milliseconds(1));
+  Clock::settle();
+
+  accept = server.accept();
+
+  url.path = "second";
+  response = http::get(url);
+
+  request = receiveRequest(connection);
+  AWAIT_READY(request);
+  EXPECT_TRUE(strings::startsWith(request.get(), "GET /second HTTP/1.1\r\n"));
+
+  AWAIT_READY(connection.send(
+      "HTTP/1.1 200 OK\r\nContent-Length: 6\r\n\r\nsecond"));
+
+  AWAIT_READY(response);
+  EXPECT_EQ("second", response.get().body);
+  EXPECT_TRUE(accept.isPending());
+
+  // ... but gets closed once it has been idle for that long.
+  Clock::advance(timeout);
+  Clock::settle();
+
+  url.path = "third";
+  response = http::get(url);
+
+  AWAIT_READY(accept);
+
+  request = receiveRequest(accept.get());
+  AWAIT_READY(request);
+  EXPECT_TRUE(strings::startsWith(request.get(), "GET /third HTTP/1.1\r\n"));
+
+  AWAIT_READY(accept.get().send(
+      "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nthird"));
+
+  AWAIT_READY(response);
+  EXPECT_EQ("third", response.get().body);
+
+  Clock::resume();
+}
+
+
 TEST(HTTP, QueryEncodeDecode)
 {
   // If we use Type<a, b> directly inside a macro without surrounding
@@ -1,11 +1,15 @@
 #include <gmock/gmock.h>
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/gtest.hpp>
 #include <process/io.hpp>
+#include <process/subprocess.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/os.hpp>
 
@@ -13,7 +17,9 @@
 
 using namespace process;
 
+using std::map;
 using std::string;
+using std::vector;
 
 
 TEST(IO, Poll)
@@ -40,6 +46,88 @@ TEST(IO, Poll)
 }
 
 
+// Polls file descriptors that are sharded across different I/O loops
+// (the tests set LIBPROCESS_IO_THREADS, see main.cpp).
+TEST(IO, PollAcrossLoops)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  // Consecutive file descriptors are polled in different I/O loops.
+  const size_t count = 16;
+
+  vector<int> pipes(2 * count);
+  vector<Future<short>> futures;
+
+  for (size_t i = 0; i < count; i++) {
+    ASSERT_NE(-1, pipe(&pipes[2 * i]));
+    futures.push_back(io::poll(pipes[2 * i], io::READ));
+  }
+
+  // Discard every other poll before any of them is ready.
+  for (size_t i = 0; i < count; i += 2) {
+    EXPECT_TRUE(futures[i].isPending());
+    futures[i].discard();
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    ASSERT_EQ(3, write(pipes[2 * i + 1], "hi", 3));
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    if (i % 2 == 0) {
+      AWAIT_DISCARDED(futures[i]);
+    } else {
+      AWAIT_EXPECT_EQ(io::READ, futures[i]);
+    }
+  }
+
+  foreach (int fd, pipes) {
+    ASSERT_SOME(os::close(fd));
+  }
+}
+
+
+#ifdef __linux__
+// Tests that the I/O threads are stopped when libprocess is
+// finalized, by running 'IO.PollAcrossLoops' in a separate instance
+// of the tests (which finalizes libprocess before exiting).
+TEST(IO, FinalizeIOThreads)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  Result<string> path = os::realpath("/proc/self/exe");
+  ASSERT_SOME(path);
+
+  map<string, string> environment;
+  foreachpair (const string& key, const string& value, os::environment()) {
+    environment[key] = value;
+  }
+
+  environment["LIBPROCESS_IO_THREADS"] = "4";
+
+  vector<string> argv;
+  argv.push_back(path.get());
+  argv.push_back("--gtest_filter=IO.PollAcrossLoops");
+
+  Try<Subprocess> s = subprocess(
+      path.get(),
+      argv,
+      Subprocess::PATH("/dev/null"),
+      Subprocess::PATH("/dev/null"),
+      Subprocess::FD(STDERR_FILENO),
+      None(),
+      environment);
+
+  ASSERT_SOME(s);
+
+  // The instance hangs if it waits for an I/O thread that is still
+  // running.
+  AWAIT_READY_FOR(s.get().status(), Seconds(60));
+  EXPECT_SOME_EQ(0, s.get().status().get());
+}
+#endif // __linux__
+
+
 TEST(IO, Read)
 {
   ASSERT_TRUE(GTEST_IS_THREADSAFE);
@@ -346,3 +434,43 @@ TEST(IO, redirect)
   ASSERT_SOME(read);
   EXPECT_EQ(data, read.get());
 }
+
+
+// Tests redirecting between file descriptors that are not pipes,
+// which cannot be done with the splice system call on Linux.
+TEST(IO, redirectFile)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  string data = "Lorem ipsum dolor sit amet, consectetur adipisicing elit. ";
+
+  while (Bytes(data.size()) < Megabytes(1)) {
+    data.append(data);
+  }
+
+  Try<string> from = os::mktemp();
+  ASSERT_SOME(from);
+  ASSERT_SOME(os::write(from.get(), data));
+
+  Try<string> to = os::mktemp();
+  ASSERT_SOME(to);
+
+  Try<int> in = os::open(from.get(), O_RDONLY | O_CLOEXEC);
+  ASSERT_SOME(in);
+
+  Try<int> out = os::open(
+      to.get(),
+      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  ASSERT_SOME(out);
+
+  AWAIT_READY(io::redirect(in.get(), out.get()));
+
+  ASSERT_SOME(os::close(in.get()));
+  ASSERT_SOME(os::close(out.get()));
+
+  EXPECT_SOME_EQ(data, os::read(to.get()));
+
+  ASSERT_SOME(os::rm(from.get()));
+  ASSERT_SOME(os::rm(to.get()));
+}
@@ -10,6 +10,7 @@
 #include <process/gtest.hpp>
 #include <process/process.hpp>
 
+#include <stout/os.hpp>
 #include <stout/os/signals.hpp>
 
 int main(int argc, char** argv)
@@ -17,6 +18,14 @@ int main(int argc, char** argv)
   // Initialize Google Mock/Test.
   testing::InitGoogleMock(&argc, argv);
 
+  // Use unix domain sockets between the peers on this host (see,
+  // e.g., 'Process.UnixSocket').
+  os::setenv("LIBPROCESS_UNIX_SOCKETS", "1");
+
+  // Shard the polling of file descriptors across I/O threads (see,
+  // e.g., 'IO.PollAcrossLoops'), unless set otherwise.
+  os::setenv("LIBPROCESS_IO_THREADS", "4", false);
+
   // Initialize libprocess.
   process::initialize();
 
@@ -2,9 +2,13 @@
 
 #include <map>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
+#include <stout/stringify.hpp>
 
 #include <process/clock.hpp>
 #include <process/future.hpp>
@@ -16,6 +20,7 @@
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
+#include <process/metrics/histogram.hpp>
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/timer.hpp>
 
@@ -27,19 +32,29 @@ using process::http::Response;
 
 using process::metrics::Counter;
 using process::metrics::Gauge;
+using process::metrics::Histogram;
 using process::metrics::Timer;
 
 using std::map;
 using std::string;
+using std::thread;
+using std::vector;
 
 class GaugeProcess : public Process<GaugeProcess>
 {
 public:
+  GaugeProcess() : evaluations(0) {}
+
   double get()
   {
     return 42.0;
   }
 
+  double count()
+  {
+    return ++evaluations;
+  }
+
   Future<double> fail()
   {
     return Failure("failure");
@@ -49,6 +64,9 @@ public:
   {
     return Future<double>();
   }
+
+private:
+  double evaluations;
 };
 
 
@@ -109,6 +127,37 @@ TEST(Metrics, Gauge)
 }
 
 
+// Tests that a gauge with a TTL is only evaluated once per TTL.
+TEST(Metrics, CachedGauge)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  GaugeProcess process;
+  PID<GaugeProcess> pid = spawn(&process);
+  ASSERT_TRUE(pid);
+
+  Clock::pause();
+
+  Gauge gauge("test/cachedgauge", defer(pid, &GaugeProcess::count), Seconds(1));
+
+  AWAIT_READY(metrics::add(gauge));
+
+  AWAIT_EXPECT_EQ(1.0, gauge.value());
+  AWAIT_EXPECT_EQ(1.0, gauge.value());
+
+  Clock::advance(Seconds(1));
+
+  AWAIT_EXPECT_EQ(2.0, gauge.value());
+
+  AWAIT_READY(metrics::remove(gauge));
+
+  Clock::resume();
+
+  terminate(process);
+  wait(process);
+}
+
+
 TEST(Metrics, Statistics)
 {
   Counter counter("test/counter", process::TIME_SERIES_WINDOW);
@@ -215,6 +264,38 @@ TEST(Metrics, Snapshot)
 }
 
 
+TEST(Metrics, ReceiveBuffers)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  UPID upid("metrics", process::address());
+
+  Clock::pause();
+
+  // Advance the clock to avoid rate limit.
+  Clock::advance(Seconds(1));
+
+  Future<Response> response = http::get(upid, "snapshot");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Object> responseJSON =
+      JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(responseJSON);
+
+  map<string, JSON::Value> values = responseJSON.get().values;
+
+  ASSERT_EQ(1u, values.count("libprocess/receive_buffers/hits"));
+  ASSERT_EQ(1u, values.count("libprocess/receive_buffers/misses"));
+
+  // At least the buffer for receiving the request for the snapshot
+  // has been allocated from the pool.
+  EXPECT_LE(
+      1.0,
+      values["libprocess/receive_buffers/hits"].as<JSON::Number>().value +
+      values["libprocess/receive_buffers/misses"].as<JSON::Number>().value);
+}
+
+
 TEST(Metrics, SnapshotTimeout)
 {
   ASSERT_TRUE(GTEST_IS_THREADSAFE);
@@ -381,6 +462,73 @@ TEST(Metrics, SnapshotStatistics)
 }
 
 
+// Ensures that a snapshot can be restricted to the metrics with a
+// given prefix.
+TEST(Metrics, SnapshotPrefix)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  UPID upid("metrics", process::address());
+
+  Clock::pause();
+
+  Counter counter1("test/prefix/counter1");
+  Counter counter2("test/prefix/counter2");
+  Counter counter3("test/prefixes/counter3");
+
+  AWAIT_READY(metrics::add(counter1));
+  AWAIT_READY(metrics::add(counter2));
+  AWAIT_READY(metrics::add(counter3));
+
+  // Advance the clock to avoid rate limit.
+  Clock::advance(Seconds(1));
+
+  Future<Response> response =
+    http::get(upid, "snapshot", "prefix=test/prefix/");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Object> responseJSON =
+      JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(responseJSON);
+
+  map<string, JSON::Value> values = responseJSON.get().values;
+
+  EXPECT_EQ(2u, values.size());
+  EXPECT_EQ(1u, values.count("test/prefix/counter1"));
+  EXPECT_EQ(1u, values.count("test/prefix/counter2"));
+
+  AWAIT_READY(metrics::remove(counter1));
+  AWAIT_READY(metrics::remove(counter2));
+  AWAIT_READY(metrics::remove(counter3));
+
+  Clock::resume();
+}
+
+
+// Ensures that metrics can be added and removed from several threads
+// at once.
+TEST(Metrics, ConcurrentAddRemove)
+{
+  vector<thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.push_back(thread([=]() {
+      for (int j = 0; j < 1000; j++) {
+        Counter counter(
+            "test/concurrent/" + stringify(i) + "/" + stringify(j));
+
+        EXPECT_TRUE(metrics::add(counter).isReady());
+        EXPECT_TRUE(metrics::add(counter).isFailed());
+        EXPECT_TRUE(metrics::remove(counter).isReady());
+      }
+    }));
+  }
+
+  foreach (thread& thread, threads) {
+    thread.join();
+  }
+}
+
+
 TEST(Metrics, Timer)
 {
   metrics::Timer<Nanoseconds> timer("test/timer");
@@ -404,6 +552,13 @@ TEST(Metrics, Timer)
   // It is not an error to stop a timer that has already been stopped.
   timer.stop();
 
+  // Record a duration that was timed elsewhere.
+  timer.record(Milliseconds(2));
+
+  value = timer.value();
+  AWAIT_READY(value);
+  EXPECT_FLOAT_EQ(value.get(), Milliseconds(2).ns());
+
   AWAIT_READY(metrics::remove(timer));
 }
 
@@ -439,3 +594,50 @@ TEST(Metrics, AsyncTimer)
 
   AWAIT_READY(metrics::remove(t));
 }
+
+
+TEST(Metrics, Histogram)
+{
+  Histogram histogram("test/histogram");
+
+  AWAIT_READY(metrics::add(histogram));
+
+  AWAIT_EXPECT_EQ(0.0, histogram.value());
+  EXPECT_NONE(histogram.statistics());
+
+  // Record 1, 2, ..., 1000 from several threads.
+  vector<thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.push_back(thread([=]() mutable {
+      for (int value = i + 1; value <= 1000; value += 4) {
+        histogram.record(value);
+      }
+    }));
+  }
+
+  foreach (thread& thread, threads) {
+    thread.join();
+  }
+
+  AWAIT_EXPECT_EQ(1000.0, histogram.value());
+
+  Option<Statistics<double>> statistics = histogram.statistics();
+  ASSERT_SOME(statistics);
+
+  EXPECT_EQ(1000u, statistics.get().count);
+  EXPECT_EQ(1.0, statistics.get().min);
+  EXPECT_EQ(1000.0, statistics.get().max);
+
+  // The percentiles are within the width of a bucket.
+  EXPECT_NEAR(500.0, statistics.get().p50, 500.0 * 0.04);
+  EXPECT_NEAR(900.0, statistics.get().p90, 900.0 * 0.04);
+  EXPECT_NEAR(990.0, statistics.get().p99, 990.0 * 0.04);
+  EXPECT_GE(1000.0, statistics.get().p9999);
+
+  histogram.reset();
+
+  AWAIT_EXPECT_EQ(0.0, histogram.value());
+  EXPECT_NONE(histogram.statistics());
+
+  AWAIT_READY(metrics::remove(histogram));
+}
@@ -63,3 +63,26 @@ TEST(Mutex, queue)
 
   EXPECT_TRUE(locked2.isReady());
 }
+
+
+TEST(Mutex, discard)
+{
+  Mutex mutex;
+
+  // We should be able to acquire the mutex immediately.
+  EXPECT_TRUE(mutex.lock().isReady());
+
+  Future<Nothing> locked1 = mutex.lock();
+  Future<Nothing> locked2 = mutex.lock();
+
+  EXPECT_TRUE(locked1.isPending());
+  EXPECT_TRUE(locked2.isPending());
+
+  // A waiter that gave up should be skipped when releasing the mutex.
+  locked1.discard();
+
+  mutex.unlock();
+
+  EXPECT_TRUE(locked1.isDiscarded());
+  EXPECT_TRUE(locked2.isReady());
+}
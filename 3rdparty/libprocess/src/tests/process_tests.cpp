@@ -4,7 +4,12 @@
 
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
+#include <stddef.h>
 
+#include <sys/un.h>
+
+#include <atomic>
 #include <string>
 #include <sstream>
 #include <tuple>
@@ -21,6 +26,7 @@
 #include <process/gc.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
+#include <process/io.hpp>
 #include <process/network.hpp>
 #include <process/process.hpp>
 #include <process/run.hpp>
@@ -28,13 +34,16 @@
 #include <process/time.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/json.hpp>
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
 #include <stout/stringify.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 #include "encoder.hpp"
@@ -1051,6 +1060,92 @@ TEST(Process, donate)
 }
 
 
+class CounterProcess : public Process<CounterProcess>
+{
+public:
+  CounterProcess() : count(0) {}
+
+  void increment() { count++; }
+
+  int get() { return count; }
+
+  size_t pending() { return eventCount<DispatchEvent>(); }
+
+  Duration age() { return eventAge(); }
+
+  void block(const Duration& duration) { os::sleep(duration); }
+
+private:
+  int count;
+};
+
+
+static void* incrementer(void* arg)
+{
+  const PID<CounterProcess>& pid = *static_cast<PID<CounterProcess>*>(arg);
+
+  for (int i = 0; i < 1000; i++) {
+    dispatch(pid, &CounterProcess::increment);
+  }
+
+  return NULL;
+}
+
+
+// Tests that events enqueued concurrently from many threads (the
+// event queue of a process doesn't use a lock) all get serviced.
+TEST(Process, concurrentDispatch)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  CounterProcess process;
+  PID<CounterProcess> pid = spawn(process);
+
+  pthread_t threads[8];
+
+  for (int i = 0; i < 8; i++) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, incrementer, &pid));
+  }
+
+  for (int i = 0; i < 8; i++) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+
+  AWAIT_EXPECT_EQ(8000, dispatch(pid, &CounterProcess::get));
+
+  // Nothing is left in the event queue (the dispatch that is doing
+  // the counting has already been dequeued).
+  AWAIT_EXPECT_EQ(0u, dispatch(pid, &CounterProcess::pending));
+
+  terminate(process);
+  wait(process);
+}
+
+
+// Tests that the age of the oldest queued event reflects how long it
+// has been waiting for the process.
+TEST(Process, eventAge)
+{
+  CounterProcess process;
+  PID<CounterProcess> pid = spawn(process);
+
+  AWAIT_EXPECT_EQ(Duration::zero(), dispatch(pid, &CounterProcess::age));
+
+  // While the process is blocked the increment is queued behind the
+  // age request, so it has been waiting for (about) as long as the
+  // process was blocked once the age is determined.
+  dispatch(pid, &CounterProcess::block, Milliseconds(100));
+  Future<Duration> age = dispatch(pid, &CounterProcess::age);
+  dispatch(pid, &CounterProcess::increment);
+
+  AWAIT_READY(age);
+  EXPECT_LE(Milliseconds(50), age.get());
+
+  terminate(process);
+  wait(process);
+}
+
+
 class ExitedProcess : public Process<ExitedProcess>
 {
 public:
@@ -1473,6 +1568,267 @@ TEST(Process, remote)
 }
 
 
+#ifdef __linux__
+// Listens on the unix domain socket address at which libprocess
+// looks for a peer at 'address' on this host, see
+// LIBPROCESS_UNIX_SOCKETS (which the tests set, see main.cpp).
+static Try<int> unixListen(const Address& address)
+{
+  const string name = "libprocess/" + stringify(address);
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path + 1, name.data(), name.size());
+
+  Try<int> s = network::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (s.isError()) {
+    return Error(s.error());
+  }
+
+  const socklen_t size =
+    offsetof(struct sockaddr_un, sun_path) + 1 + name.size();
+
+  if (::bind(s.get(), (struct sockaddr*) &addr, size) < 0 ||
+      ::listen(s.get(), 1) < 0) {
+    ErrnoError error;
+    os::close(s.get());
+    return error;
+  }
+
+  return s.get();
+}
+
+
+// Messages to a peer on this host are sent through its unix domain
+// socket, if it listens on one.
+TEST(Process, UnixSocket)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  UPID pid = spawn(new ProcessBase(), true);
+
+  // The peer listens on both TCP and a unix domain socket.
+  Try<Socket> server = Socket::create();
+  ASSERT_SOME(server);
+
+  Try<Address> address = server.get().bind(Address(pid.address.ip, 0));
+  ASSERT_SOME(address);
+  ASSERT_SOME(server.get().listen(1));
+
+  Try<int> listener = unixListen(address.get());
+  ASSERT_SOME(listener);
+
+  Future<Socket> accepted = server.get().accept();
+
+  Future<short> readable = io::poll(listener.get(), io::READ);
+
+  post(UPID("peer", address.get()), "hello");
+
+  AWAIT_READY(readable);
+
+  int s = ::accept(listener.get(), NULL, NULL);
+  ASSERT_LE(0, s);
+  ASSERT_SOME(os::nonblock(s));
+
+  char data[1024];
+  Future<size_t> length = io::read(s, data, sizeof(data));
+  AWAIT_READY(length);
+  EXPECT_TRUE(strings::contains(string(data, length.get()), "hello"));
+
+  EXPECT_TRUE(accepted.isPending());
+  accepted.discard();
+
+  os::close(s);
+  os::close(listener.get());
+
+  terminate(pid);
+}
+
+
+// Messages to a peer on this host that does not listen on a unix
+// domain socket are sent via TCP.
+TEST(Process, UnixSocketFallback)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  UPID pid = spawn(new ProcessBase(), true);
+
+  Try<Socket> server = Socket::create();
+  ASSERT_SOME(server);
+
+  Try<Address> address = server.get().bind(Address(pid.address.ip, 0));
+  ASSERT_SOME(address);
+  ASSERT_SOME(server.get().listen(1));
+
+  Future<Socket> accepted = server.get().accept();
+
+  post(UPID("peer", address.get()), "hello");
+
+  AWAIT_READY(accepted);
+
+  Socket socket = accepted.get();
+
+  Future<string> data = socket.recv(None());
+  AWAIT_READY(data);
+  EXPECT_TRUE(strings::contains(data.get(), "hello"));
+
+  terminate(pid);
+}
+
+
+// Messages and HTTP requests from a peer on this host are accepted
+// on the unix domain socket that libprocess listens on, which is in
+// the abstract namespace and hence leaves nothing behind in the file
+// system.
+TEST(Process, UnixSocketServer)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  RemoteProcess process;
+  spawn(process);
+
+  const string name = "libprocess/" + stringify(process.self().address);
+
+  // The socket is listed (with a leading '@' for the abstract
+  // namespace) but does not exist in the file system.
+  Try<string> sockets = os::read("/proc/net/unix");
+  ASSERT_SOME(sockets);
+  EXPECT_TRUE(strings::contains(sockets.get(), "@" + name));
+  EXPECT_FALSE(os::exists(name));
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path + 1, name.data(), name.size());
+
+  const socklen_t size =
+    offsetof(struct sockaddr_un, sun_path) + 1 + name.size();
+
+  Try<int> s = network::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_SOME(s);
+
+  ASSERT_EQ(0, ::connect(s.get(), (struct sockaddr*) &addr, size));
+
+  Future<string> body;
+  EXPECT_CALL(process, handler(_, _))
+    .WillOnce(FutureArg<1>(&body));
+
+  // Send a message, followed by an HTTP request on the same
+  // connection. Only the latter gets a response.
+  const string message =
+    "POST /" + process.self().id + "/handler HTTP/1.1\r\n"
+    "User-Agent: libprocess/\r\n"
+    "Connection: Keep-Alive\r\n"
+    "Content-Length: 11\r\n"
+    "\r\n"
+    "hello world";
+
+  const string request =
+    "GET /__processes__ HTTP/1.1\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+  ASSERT_SOME(os::write(s.get(), message));
+
+  AWAIT_READY(body);
+  EXPECT_EQ("hello world", body.get());
+
+  ASSERT_SOME(os::write(s.get(), request));
+  ASSERT_SOME(os::nonblock(s.get()));
+
+  // Read the response until the connection is closed.
+  string response;
+  char data[1024];
+  while (true) {
+    Future<size_t> length = io::read(s.get(), data, sizeof(data));
+    AWAIT_READY(length);
+    if (length.get() == 0) {
+      break;
+    }
+    response.append(data, length.get());
+  }
+
+  EXPECT_TRUE(strings::startsWith(response, "HTTP/1.1 200 OK"));
+  EXPECT_TRUE(strings::contains(response, process.self().id));
+
+  os::close(s.get());
+
+  terminate(process);
+  wait(process);
+
+  // A name in the abstract namespace is released together with the
+  // socket, so that it can be reused right away (e.g., by a restarted
+  // process with the same address).
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+
+  Try<Address> address =
+    socket.get().bind(Address(process.self().address.ip, 0));
+  ASSERT_SOME(address);
+
+  Try<int> listener = unixListen(address.get());
+  ASSERT_SOME(listener);
+  os::close(listener.get());
+
+  listener = unixListen(address.get());
+  ASSERT_SOME(listener);
+  os::close(listener.get());
+
+  sockets = os::read("/proc/net/unix");
+  ASSERT_SOME(sockets);
+  EXPECT_FALSE(strings::contains(
+      sockets.get(), "@libprocess/" + stringify(address.get()) + "\n"));
+}
+
+
+// A unix domain socket listened on by somebody other than the user
+// running the peer at the corresponding TCP address (here nobody, as
+// nothing listens on the TCP address) is not connected to.
+TEST(Process, UnixSocketSquatted)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  // Reserve a port on which nothing listens.
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+
+  UPID pid = spawn(new ProcessBase(), true);
+
+  Try<Address> address = socket.get().bind(Address(pid.address.ip, 0));
+  ASSERT_SOME(address);
+
+  Try<int> listener = unixListen(address.get());
+  ASSERT_SOME(listener);
+
+  const UPID peer("peer", address.get());
+
+  ExitedProcess process(peer);
+
+  Future<Nothing> exited;
+  EXPECT_CALL(process, exited(peer))
+    .WillOnce(FutureSatisfy(&exited));
+
+  spawn(process);
+
+  // Connecting via TCP fails since nothing listens on the port.
+  AWAIT_READY(exited);
+
+  struct pollfd pfd;
+  pfd.fd = listener.get();
+  pfd.events = POLLIN;
+  EXPECT_EQ(0, ::poll(&pfd, 1, 0));
+
+  os::close(listener.get());
+
+  terminate(process);
+  wait(process);
+
+  terminate(pid);
+}
+#endif // __linux__
+
+
 // Like the 'remote' test but uses http::post.
 TEST(Process, http1)
 {
@@ -1880,3 +2236,135 @@ TEST(Process, PercentEncodedURLs)
   terminate(process);
   wait(process);
 }
+
+
+class AccountingProcess : public Process<AccountingProcess>
+{
+public:
+  AccountingProcess() : ProcessBase("accounting") {}
+
+  Nothing noop() { return Nothing(); }
+};
+
+
+// Tests that /__processes__ accounts for the events each process
+// handled, also in the flame graph friendly format.
+TEST(Process, Accounting)
+{
+  AccountingProcess process;
+  PID<AccountingProcess> pid = spawn(process);
+
+  for (int i = 0; i < 3; i++) {
+    AWAIT_READY(dispatch(pid, &AccountingProcess::noop));
+  }
+
+  UPID processes("__processes__", pid.address);
+
+  Future<http::Response> response = http::get(processes);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Array> array = JSON::parse<JSON::Array>(response.get().body);
+  ASSERT_SOME(array);
+
+  Option<JSON::Object> statistics;
+  foreach (const JSON::Value& value, array.get().values) {
+    const JSON::Object& object = value.as<JSON::Object>();
+    if (object.values.find("id")->second.as<JSON::String>().value ==
+        "accounting") {
+      statistics =
+        object.values.find("statistics")->second.as<JSON::Object>();
+    }
+  }
+
+  ASSERT_SOME(statistics);
+
+  // At least the dispatches (and the dispatch describing the process)
+  // have been handled.
+  EXPECT_LE(4, statistics.get().values["events"].as<JSON::Number>().value);
+  EXPECT_LE(1, statistics.get().values["resumes"].as<JSON::Number>().value);
+  EXPECT_EQ(1u, statistics.get().values.count("running_secs"));
+  EXPECT_EQ(1u, statistics.get().values.count("queued_secs"));
+  EXPECT_EQ(1u, statistics.get().values.count("runnable_secs"));
+
+  response = http::get(processes, None(), "format=folded");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("text/plain", "Content-Type", response);
+  EXPECT_TRUE(strings::contains(response.get().body, "libprocess;accounting "));
+
+  terminate(process);
+  wait(process);
+}
+
+
+class BusyProcess : public Process<BusyProcess>
+{
+public:
+  BusyProcess() : ProcessBase("busy"), busy(false), released(false) {}
+
+  // Keeps the thread running this process busy until released.
+  void block()
+  {
+    busy.store(true);
+    while (!released.load()) {
+      os::sleep(Milliseconds(10));
+    }
+  }
+
+  std::atomic_bool busy;
+  std::atomic_bool released;
+};
+
+
+// Tests that /__processes__ reports a process that doesn't get to
+// describe itself in time as unresponsive, rather than waiting for it.
+TEST(Process, Unresponsive)
+{
+  BusyProcess process;
+  PID<BusyProcess> pid = spawn(process);
+
+  dispatch(pid, &BusyProcess::block);
+
+  while (!process.busy.load()) {
+    os::sleep(Milliseconds(10));
+  }
+
+  UPID processes("__processes__", pid.address);
+
+  Future<http::Response> response =
+    http::get(processes, None(), "timeout=abc");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::BadRequest().status, response);
+
+  response = http::get(processes, None(), "timeout=100ms");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Array> array = JSON::parse<JSON::Array>(response.get().body);
+  ASSERT_SOME(array);
+
+  Option<JSON::Object> busy;
+  foreach (const JSON::Value& value, array.get().values) {
+    const JSON::Object& object = value.as<JSON::Object>();
+    if (object.values.find("id")->second.as<JSON::String>().value ==
+        "busy") {
+      busy = object;
+    }
+  }
+
+  ASSERT_SOME(busy);
+  EXPECT_EQ(1u, busy.get().values.count("unresponsive"));
+  EXPECT_EQ(0u, busy.get().values.count("statistics"));
+
+  // The flame graph friendly format leaves it out.
+  response = http::get(processes, None(), "format=folded&timeout=100ms");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  EXPECT_FALSE(strings::contains(response.get().body, "libprocess;busy "));
+
+  process.released.store(true);
+
+  terminate(process);
+  wait(process);
+}
@@ -76,3 +76,28 @@ TEST(Queue, queue)
   EXPECT_EQ("pretty", get2.get());
   EXPECT_EQ("world", get3.get());
 }
+
+
+TEST(Queue, bounded)
+{
+  Queue<string> q(2);
+
+  // Puts should complete right away until the queue is full.
+  EXPECT_TRUE(q.put("hello").isReady());
+  EXPECT_TRUE(q.put("world").isReady());
+
+  Future<Nothing> put = q.put("!");
+
+  EXPECT_TRUE(put.isPending());
+
+  // A 'get' should make room for the held back 'put'.
+  Future<string> get = q.get();
+
+  EXPECT_TRUE(get.isReady());
+  EXPECT_EQ("hello", get.get());
+  EXPECT_TRUE(put.isReady());
+
+  // And the held back element should be queued in order.
+  EXPECT_EQ("world", q.get().get());
+  EXPECT_EQ("!", q.get().get());
+}
@@ -129,6 +129,36 @@ TEST(Reap, ChildProcess)
 }
 
 
+// Check that the termination of a child process is noticed without
+// waiting for the reaper to poll for it.
+TEST(Reap, ChildProcessWithoutPolling)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  Try<ProcessTree> tree = Fork(None(),
+                               Exec("sleep 10"))();
+
+  ASSERT_SOME(tree);
+  pid_t child = tree.get();
+
+  // Pause the clock so the reaper never polls.
+  Clock::pause();
+
+  Future<Option<int> > status = process::reap(child);
+
+  EXPECT_EQ(0, kill(child, SIGKILL));
+
+  AWAIT_READY(status);
+
+  ASSERT_SOME(status.get());
+  int status_ = status.get().get();
+  ASSERT_TRUE(WIFSIGNALED(status_));
+  ASSERT_EQ(SIGKILL, WTERMSIG(status_));
+
+  Clock::resume();
+}
+
+
 // Check that we can reap a child process that is already exited.
 TEST(Reap, TerminatedChildProcess)
 {
@@ -0,0 +1,72 @@
+#include <gmock/gmock.h>
+
+#include <process/future.hpp>
+#include <process/semaphore.hpp>
+
+using namespace process;
+
+TEST(Semaphore, acquire)
+{
+  Semaphore semaphore(2);
+
+  // We should be able to acquire both permits immediately.
+  EXPECT_TRUE(semaphore.acquire().isReady());
+  EXPECT_TRUE(semaphore.acquire().isReady());
+
+  // Subsequent calls should "block" and get queued.
+  Future<Nothing> acquired1 = semaphore.acquire();
+  Future<Nothing> acquired2 = semaphore.acquire();
+
+  EXPECT_TRUE(acquired1.isPending());
+  EXPECT_TRUE(acquired2.isPending());
+
+  // Each release should satisfy the next waiter in order.
+  semaphore.release();
+
+  EXPECT_TRUE(acquired1.isReady());
+  EXPECT_TRUE(acquired2.isPending());
+
+  semaphore.release();
+
+  EXPECT_TRUE(acquired2.isReady());
+
+  // After all permits are released we should be able to acquire
+  // again immediately.
+  semaphore.release();
+  semaphore.release();
+
+  EXPECT_TRUE(semaphore.acquire().isReady());
+}
+
+
+TEST(Semaphore, run)
+{
+  Semaphore semaphore(1);
+
+  Promise<int> promise1;
+  Promise<int> promise2;
+
+  bool invoked2 = false;
+
+  Future<int> future1 = semaphore.run([&]() { return promise1.future(); });
+  Future<int> future2 = semaphore.run([&]() {
+    invoked2 = true;
+    return promise2.future();
+  });
+
+  // The second function should not be invoked until the future
+  // returned by the first one is no longer pending.
+  EXPECT_FALSE(invoked2);
+
+  promise1.set(1);
+
+  EXPECT_TRUE(invoked2);
+  EXPECT_EQ(1, future1.get());
+
+  promise2.fail("Failure");
+
+  EXPECT_TRUE(future2.isFailed());
+
+  // The permit is released even if the future failed.
+  EXPECT_TRUE(semaphore.acquire().isReady());
+}
@@ -2,6 +2,8 @@
 
 #include <gmock/gmock.h>
 
+#include <list>
+
 #include <process/clock.hpp>
 #include <process/time.hpp>
 
@@ -9,8 +11,12 @@
 #include <stout/gtest.hpp>
 #include <stout/os.hpp>
 
+#include "timer_wheel.hpp"
+
 using namespace process;
 
+using std::list;
+
 
 TEST(TimeTest, Arithmetic)
 {
@@ -46,3 +52,94 @@ TEST(TimeTest, Output)
   EXPECT_EQ("1989-03-02 00:00:00.000001000+00:00",
             stringify(Time::epoch() + Weeks(1000) + Microseconds(1)));
 }
+
+
+TEST(TimerWheelTest, Expire)
+{
+  TimerWheel<int> wheel;
+
+  const Time now = Time::epoch() + Weeks(1000);
+
+  // Timers within the same tick, within the first level and far
+  // enough in the future to be cascaded through several levels.
+  wheel.insert(1, now + Days(3), 5);
+  wheel.insert(2, now + Nanoseconds(2), 2);
+  wheel.insert(3, now + Nanoseconds(1), 1);
+  wheel.insert(4, now + Milliseconds(50), 3);
+  wheel.insert(5, now + Milliseconds(50), 4);
+  wheel.insert(6, now + Weeks(100), 6);
+
+  EXPECT_EQ(6u, wheel.size());
+  EXPECT_SOME_EQ(now + Nanoseconds(1), wheel.next());
+
+  // Nothing expires before its exact time.
+  EXPECT_TRUE(wheel.expire(now).empty());
+
+  list<int> expired = wheel.expire(now + Nanoseconds(1));
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(1, expired.front());
+  EXPECT_SOME_EQ(now + Nanoseconds(2), wheel.next());
+
+  // Timers expire in the order of their time and then their ID.
+  expired = wheel.expire(now + Hours(1));
+  ASSERT_EQ(3u, expired.size());
+  EXPECT_EQ(2, expired.front());
+  expired.pop_front();
+  EXPECT_EQ(3, expired.front());
+  expired.pop_front();
+  EXPECT_EQ(4, expired.front());
+
+  EXPECT_SOME_EQ(now + Days(3), wheel.next());
+
+  expired = wheel.expire(now + Days(3) - Nanoseconds(1));
+  EXPECT_TRUE(expired.empty());
+
+  expired = wheel.expire(now + Days(3));
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(5, expired.front());
+
+  // A timer that is already due expires with the next expiration.
+  wheel.insert(7, now, 7);
+  EXPECT_SOME_EQ(now, wheel.next());
+
+  expired = wheel.expire(now + Days(3));
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(7, expired.front());
+
+  expired = wheel.expire(now + Weeks(200));
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(6, expired.front());
+
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_NONE(wheel.next());
+}
+
+
+TEST(TimerWheelTest, Cancel)
+{
+  TimerWheel<int> wheel;
+
+  const Time now = Time::epoch() + Weeks(1000);
+
+  wheel.insert(1, now + Seconds(1), 1);
+  wheel.insert(2, now + Days(3), 2);
+  wheel.insert(3, now + Days(2), 3);
+
+  EXPECT_TRUE(wheel.cancel(1));
+  EXPECT_FALSE(wheel.cancel(1));
+  EXPECT_SOME_EQ(now + Days(2), wheel.next());
+
+  // Cancel a timer after it got cascaded into a lower level.
+  EXPECT_TRUE(wheel.expire(now + Days(2) - Seconds(1)).empty());
+  EXPECT_TRUE(wheel.cancel(3));
+  EXPECT_SOME_EQ(now + Days(3), wheel.next());
+
+  EXPECT_EQ(1u, wheel.size());
+
+  list<int> expired = wheel.expire(now + Days(3));
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(2, expired.front());
+
+  EXPECT_FALSE(wheel.cancel(2));
+  EXPECT_TRUE(wheel.empty());
+}
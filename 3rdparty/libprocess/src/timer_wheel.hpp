@@ -0,0 +1,343 @@
+#ifndef __TIMER_WHEEL_HPP__
+#define __TIMER_WHEEL_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+
+#include <glog/logging.h>
+
+#include <process/time.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
+
+namespace process {
+
+// A hierarchical timing wheel holding the pending timers of the
+// clock, each identified by a unique (non-zero) ID. Inserting and
+// canceling a timer takes constant time, as opposed to keeping the
+// timers sorted.
+//
+// Time is divided into ticks of 'RESOLUTION' and every level of the
+// wheel has 'SLOTS' slots. A timer is kept in the level of the most
+// significant (base 'SLOTS') digit in which its tick differs from
+// the current tick (the 'cursor') and in the slot for the value of
+// that digit in its tick. As the cursor moves into the range of
+// ticks covered by a slot the timers of that slot get redistributed
+// into the lower levels ("cascaded"), i.e., a timer moves down at
+// most once per level before it expires. The levels cover all 64 bit
+// ticks so no timer falls outside of the wheel.
+//
+// Timers expire at their exact time, the resolution only determines
+// which timers share a slot.
+//
+// NOTE: Not thread-safe, the clock protects the wheel.
+template <typename T>
+class TimerWheel
+{
+public:
+  TimerWheel() : cursor(0), count(0) {}
+
+  void insert(uint64_t id, const Time& time, const T& t)
+  {
+    CHECK(!index.contains(id));
+
+    Entry entry;
+    entry.id = id;
+    entry.time = time;
+    entry.tick = tick(time);
+    entry.t = t;
+
+    std::list<Entry> inserting;
+    inserting.push_back(entry);
+    place(&inserting, inserting.begin());
+
+    count++;
+
+    // NOTE: If there is no cached earliest time it gets determined
+    // (again) on demand, see 'next'.
+    if (count == 1 || (earliest.isSome() && time < earliest.get())) {
+      earliest = time;
+    }
+  }
+
+  // Returns false if the timer is not pending (e.g., it has already
+  // expired or been canceled).
+  bool cancel(uint64_t id)
+  {
+    if (!index.contains(id)) {
+      return false;
+    }
+
+    typename std::list<Entry>::iterator entry = index[id];
+
+    if (earliest.isSome() && entry->time == earliest.get()) {
+      earliest = None();
+    }
+
+    remove(entry);
+
+    return true;
+  }
+
+  // Removes and returns the timers that expire at or before 'now',
+  // in the order of their time (ties in the order of their IDs).
+  std::list<T> expire(const Time& now)
+  {
+    std::list<Entry> expired;
+
+    const uint64_t target = tick(now);
+
+    while (true) {
+      // Expire the timers of the current tick that have elapsed.
+      std::list<Entry>& slot = slots[0][digit(cursor, 0)];
+
+      typename std::list<Entry>::iterator entry = slot.begin();
+      while (entry != slot.end()) {
+        typename std::list<Entry>::iterator next = entry;
+        ++next;
+        if (entry->time <= now) {
+          index.erase(entry->id);
+          expired.splice(expired.end(), slot, entry);
+          count--;
+        }
+        entry = next;
+      }
+
+      if (slot.empty()) {
+        occupied[0] &= ~(uint64_t(1) << digit(cursor, 0));
+      }
+
+      if (cursor >= target) {
+        break;
+      }
+
+      // Move the cursor to the next tick at which a slot needs to be
+      // expired or cascaded, or to the target if there is none.
+      Option<Location> location = first();
+
+      if (location.isNone() || location.get().tick > target) {
+        cursor = target;
+        continue;
+      }
+
+      cursor = location.get().tick;
+
+      if (location.get().level > 0) {
+        cascade(location.get().level, location.get().slot);
+      }
+    }
+
+    if (!expired.empty()) {
+      earliest = None();
+    }
+
+    expired.sort(&Entry::before);
+
+    std::list<T> result;
+    for (typename std::list<Entry>::const_iterator entry = expired.begin();
+         entry != expired.end();
+         ++entry) {
+      result.push_back(entry->t);
+    }
+
+    return result;
+  }
+
+  // Returns the time of the earliest pending timer, if any.
+  Option<Time> next() const
+  {
+    if (earliest.isNone() && count > 0) {
+      Option<Location> location = first();
+      CHECK_SOME(location);
+
+      const std::list<Entry>& slot =
+        slots[location.get().level][location.get().slot];
+
+      CHECK(!slot.empty());
+
+      Time time = slot.front().time;
+      for (typename std::list<Entry>::const_iterator entry = slot.begin();
+           entry != slot.end();
+           ++entry) {
+        if (entry->time < time) {
+          time = entry->time;
+        }
+      }
+
+      earliest = time;
+    }
+
+    return earliest;
+  }
+
+  bool empty() const
+  {
+    return count == 0;
+  }
+
+  size_t size() const
+  {
+    return count;
+  }
+
+  static const int64_t RESOLUTION = 1000000; // Nanoseconds, i.e., 1ms.
+
+private:
+  static const size_t BITS = 6; // Per level, hence 64 slots.
+  static const size_t SLOTS = 1 << BITS;
+  static const size_t LEVELS = (64 + BITS - 1) / BITS;
+
+  struct Entry
+  {
+    static bool before(const Entry& left, const Entry& right)
+    {
+      return left.time < right.time ||
+        (left.time == right.time && left.id < right.id);
+    }
+
+    uint64_t id;
+    Time time;
+    uint64_t tick;
+    T t;
+
+    // Where the entry is currently kept.
+    size_t level;
+    size_t slot;
+  };
+
+  // The first slot that needs to be expired or cascaded and the tick
+  // at which that happens.
+  struct Location
+  {
+    size_t level;
+    size_t slot;
+    uint64_t tick;
+  };
+
+  // Not copyable, not assignable.
+  TimerWheel(const TimerWheel&);
+  TimerWheel& operator = (const TimerWheel&);
+
+  static uint64_t tick(const Time& time)
+  {
+    const int64_t ns = time.duration().ns();
+    return ns > 0 ? ns / RESOLUTION : 0;
+  }
+
+  static size_t digit(uint64_t tick, size_t level)
+  {
+    return (tick >> (level * BITS)) & (SLOTS - 1);
+  }
+
+  // Moves the entry from 'from' into the slot it belongs to given
+  // the current cursor.
+  void place(std::list<Entry>* from, typename std::list<Entry>::iterator entry)
+  {
+    // Timers that are already due (e.g., the time of the creating
+    // process lags behind while the clock is paused) belong to the
+    // current tick.
+    const uint64_t tick = entry->tick > cursor ? entry->tick : cursor;
+
+    const uint64_t difference = tick ^ cursor;
+
+    entry->level = difference == 0
+      ? 0
+      : (63 - __builtin_clzll(difference)) / BITS;
+    entry->slot = digit(tick, entry->level);
+
+    std::list<Entry>& slot = slots[entry->level][entry->slot];
+    slot.splice(slot.end(), *from, entry);
+
+    occupied[entry->level] |= uint64_t(1) << entry->slot;
+
+    index[entry->id] = entry;
+  }
+
+  void remove(typename std::list<Entry>::iterator entry)
+  {
+    const size_t level = entry->level;
+    const size_t slot = entry->slot;
+
+    index.erase(entry->id);
+    slots[level][slot].erase(entry);
+    count--;
+
+    if (slots[level][slot].empty()) {
+      occupied[level] &= ~(uint64_t(1) << slot);
+    }
+  }
+
+  // Redistributes the timers of the slot into the lower levels, must
+  // be called once the cursor has moved into the slot's range.
+  void cascade(size_t level, size_t slot)
+  {
+    std::list<Entry> cascading;
+    cascading.swap(slots[level][slot]);
+    occupied[level] &= ~(uint64_t(1) << slot);
+
+    while (!cascading.empty()) {
+      place(&cascading, cascading.begin());
+    }
+  }
+
+  // Returns the first non-empty slot (from the cursor on), if any.
+  // The lowest non-empty level holds the earliest timers since every
+  // level only holds timers beyond the range of the levels below it.
+  Option<Location> first() const
+  {
+    for (size_t level = 0; level < LEVELS; level++) {
+      // The current slot of a level above the lowest one is always
+      // empty (it has been cascaded when the cursor moved into it).
+      const size_t current = digit(cursor, level);
+      const uint64_t mask = ~uint64_t(0) << current;
+
+      const uint64_t candidates = occupied[level] & mask;
+
+      if (candidates != 0) {
+        Location location;
+        location.level = level;
+        location.slot = __builtin_ctzll(candidates);
+
+        // The tick at which the cursor moves into the slot, i.e., the
+        // cursor with the digit of this level replaced by the slot
+        // and all the lower digits zeroed.
+        const size_t shift = level * BITS;
+        const uint64_t high = shift + BITS >= 64
+          ? 0
+          : (cursor >> (shift + BITS)) << (shift + BITS);
+
+        location.tick = level == 0
+          ? high | location.slot
+          : high | (uint64_t(location.slot) << shift);
+
+        return location;
+      }
+    }
+
+    return None();
+  }
+
+  // The current tick, all timers of earlier ticks have expired.
+  uint64_t cursor;
+
+  size_t count;
+
+  std::list<Entry> slots[LEVELS][SLOTS];
+
+  // A bit per slot of each level, set if the slot is non-empty.
+  uint64_t occupied[LEVELS] = {};
+
+  // Where each pending timer is kept, by ID.
+  hashmap<uint64_t, typename std::list<Entry>::iterator> index;
+
+  // The cached time of the earliest timer (see 'next').
+  mutable Option<Time> earliest;
+};
+
+} // namespace process {
+
+#endif // __TIMER_WHEEL_HPP__
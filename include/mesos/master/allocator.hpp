@@ -134,8 +134,14 @@ public:
 
   // Whenever a framework that has filtered resources wants to revive
   // offers for those resources the master invokes this callback.
+  // This also ends any suppression of offers for the framework.
   virtual void reviveOffers(
       const FrameworkID& frameworkId) = 0;
+
+  // Informs the Allocator to stop allocating resources to the
+  // framework until the framework revives offers.
+  virtual void suppressOffers(
+      const FrameworkID& frameworkId) = 0;
 };
 
 } // namespace allocator {
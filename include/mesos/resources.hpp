@@ -89,6 +89,14 @@ public:
   static Option<Error> validate(
       const google::protobuf::RepeatedPtrField<Resource>& resources);
 
+  // Returns the Resources for the given protobufs, which must have
+  // already been validated (e.g., the resources of a task that the
+  // master validated when accepting it). Unlike the constructor this
+  // skips the validity check of each Resource object, but the objects
+  // are still combined and the empty ones ignored.
+  static Resources trusted(
+      const google::protobuf::RepeatedPtrField<Resource>& resources);
+
   // NOTE: The following predicate functions assume that the given
   // resource is validated.
   //
@@ -301,6 +309,13 @@ private:
   // ensure this is warranted.
   bool _contains(const Resource& that) const;
 
+  // Similar to 'operator += (const Resource&)' and
+  // 'operator -= (const Resource&)' but skip the validity (and
+  // emptiness) check of 'that', which must be valid and non-empty
+  // (e.g., it's inside a Resources).
+  void _add(const Resource& that);
+  void _subtract(const Resource& that);
+
   // Similar to the public 'find', but only for a single Resource
   // object. The target resource may span multiple roles, so this
   // returns Resources.
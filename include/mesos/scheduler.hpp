@@ -244,6 +244,10 @@ public:
   // will be dropped (these semantics may be changed in the future).
   virtual Status killTask(const TaskID& taskId) = 0;
 
+  // Kills the specified tasks, like killTask() but with a single
+  // message to the master.
+  virtual Status killTasks(const std::vector<TaskID>& taskIds) = 0;
+
   // Accepts the given offers and performs a sequence of operations on
   // those accepted offers. See Offer.Operation in mesos.proto for the
   // set of available operations. Available resources are aggregated
@@ -265,11 +269,25 @@ public:
       const OfferID& offerId,
       const Filters& filters = Filters()) = 0;
 
+  // Declines the specified offers, like declineOffer() but with a
+  // single message to the master. Unlike with acceptOffers(), the
+  // offers may belong to different slaves.
+  virtual Status declineOffers(
+      const std::vector<OfferID>& offerIds,
+      const Filters& filters = Filters()) = 0;
+
   // Removes all filters previously set by the framework (via
   // launchTasks()). This enables the framework to receive offers from
-  // those filtered slaves.
+  // those filtered slaves. This also ends any suppression of offers
+  // (see suppressOffers()).
   virtual Status reviveOffers() = 0;
 
+  // Informs Mesos to stop sending offers to the framework until
+  // reviveOffers() is called, e.g., because the framework has no
+  // more work to do. This saves the framework from declining
+  // offers it does not need and lets the allocator skip it.
+  virtual Status suppressOffers() = 0;
+
   // Acknowledges the status update. This should only be called
   // once the status update is processed durably by the scheduler.
   // Not that explicit acknowledgements must be requested via the
@@ -278,6 +296,11 @@ public:
   virtual Status acknowledgeStatusUpdate(
       const TaskStatus& status) = 0;
 
+  // Acknowledges the status updates, like acknowledgeStatusUpdate()
+  // but with a single message to the master.
+  virtual Status acknowledgeStatusUpdates(
+      const std::vector<TaskStatus>& statuses) = 0;
+
   // Sends a message from the framework to one of its executors. These
   // messages are best effort; do not expect a framework message to be
   // retransmitted in any reliable fashion.
@@ -407,6 +430,8 @@ public:
 
   virtual Status killTask(const TaskID& taskId);
 
+  virtual Status killTasks(const std::vector<TaskID>& taskIds);
+
   virtual Status acceptOffers(
       const std::vector<OfferID>& offerIds,
       const std::vector<Offer::Operation>& operations,
@@ -416,11 +441,20 @@ public:
       const OfferID& offerId,
       const Filters& filters = Filters());
 
+  virtual Status declineOffers(
+      const std::vector<OfferID>& offerIds,
+      const Filters& filters = Filters());
+
   virtual Status reviveOffers();
 
+  virtual Status suppressOffers();
+
   virtual Status acknowledgeStatusUpdate(
       const TaskStatus& status);
 
+  virtual Status acknowledgeStatusUpdates(
+      const std::vector<TaskStatus>& statuses);
+
   virtual Status sendFrameworkMessage(
       const ExecutorID& executorId,
       const SlaveID& slaveId,
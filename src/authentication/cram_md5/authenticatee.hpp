@@ -23,6 +23,7 @@
 
 #include <sasl/sasl.h>
 
+#include <mutex>
 #include <string>
 
 #include <mesos/mesos.hpp>
@@ -36,9 +37,11 @@
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 
+#include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 
-
 #include "messages/messages.hpp"
 
 namespace mesos {
@@ -49,6 +52,44 @@ namespace cram_md5 {
 class CRAMMD5AuthenticateeProcess;
 
 
+// The tickets handed out by authenticators (see
+// 'AuthenticationCompletedMessage'), kept across authenticatees
+// since one is created per authentication attempt. A ticket is only
+// presented once, by the same client with the same principal.
+class Tickets
+{
+public:
+  static void put(const std::string& key, const std::string& ticket)
+  {
+    std::lock_guard<std::mutex> lock(mutex());
+    tickets()[key] = ticket;
+  }
+
+  // Removes and returns the ticket, if any.
+  static Option<std::string> take(const std::string& key)
+  {
+    std::lock_guard<std::mutex> lock(mutex());
+    Option<std::string> ticket = tickets().get(key);
+    tickets().erase(key);
+    return ticket;
+  }
+
+private:
+  static hashmap<std::string, std::string>& tickets()
+  {
+    static hashmap<std::string, std::string>* tickets =
+      new hashmap<std::string, std::string>();
+    return *tickets;
+  }
+
+  static std::mutex& mutex()
+  {
+    static std::mutex* mutex = new std::mutex();
+    return *mutex;
+  }
+};
+
+
 class CRAMMD5Authenticatee : public Authenticatee
 {
 public:
@@ -181,6 +222,9 @@ public:
       return promise.future();
     }
 
+    key = stringify(pid) + " " + stringify(client) + " " +
+          credential.principal();
+
     AuthenticateMessage message;
     message.set_pid(client);
     send(pid, message);
@@ -206,7 +250,8 @@ protected:
         &AuthenticationStepMessage::data);
 
     install<AuthenticationCompletedMessage>(
-        &CRAMMD5AuthenticateeProcess::completed);
+        &CRAMMD5AuthenticateeProcess::completed,
+        &AuthenticationCompletedMessage::ticket);
 
     install<AuthenticationFailedMessage>(
         &CRAMMD5AuthenticateeProcess::failed);
@@ -218,12 +263,32 @@ protected:
 
   void mechanisms(const std::vector<std::string>& mechanisms)
   {
-    if (status != STARTING) {
+    // The mechanisms are sent again if a ticket gets refused.
+    if (status != STARTING && status != REDEEMING) {
       status = ERROR;
       promise.fail("Unexpected authentication 'mechanisms' received");
       return;
     }
 
+    // Present the ticket of a previous authentication, if any, to
+    // skip the SASL exchange.
+    if (status == STARTING) {
+      Option<std::string> ticket = Tickets::take(key);
+
+      if (ticket.isSome()) {
+        LOG(INFO) << "Attempting to authenticate with a ticket";
+
+        AuthenticationStartMessage message;
+        message.set_mechanism("TICKET");
+        message.set_ticket(ticket.get());
+
+        reply(message);
+
+        status = REDEEMING;
+        return;
+      }
+    }
+
     // TODO(benh): Store 'from' in order to ensure we only communicate
     // with the same Authenticator.
 
@@ -305,9 +370,9 @@ protected:
     }
   }
 
-  void completed()
+  void completed(const std::string& ticket)
   {
-    if (status != STEPPING) {
+    if (status != STEPPING && status != REDEEMING) {
       status = ERROR;
       promise.fail("Unexpected authentication 'completed' received");
       return;
@@ -315,6 +380,10 @@ protected:
 
     LOG(INFO) << "Authentication success";
 
+    if (!ticket.empty()) {
+      Tickets::put(key, ticket);
+    }
+
     status = COMPLETED;
     promise.set(true);
   }
@@ -368,6 +437,9 @@ private:
   // PID of the client that needs to be authenticated.
   const process::UPID client;
 
+  // Identifies the ticket of the authenticator, client and principal.
+  std::string key;
+
   sasl_secret_t* secret;
 
   sasl_callback_t callbacks[5];
@@ -375,6 +447,7 @@ private:
   enum {
     READY,
     STARTING,
+    REDEEMING,
     STEPPING,
     COMPLETED,
     FAILED,
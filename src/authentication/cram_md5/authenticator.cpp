@@ -26,12 +26,16 @@
 
 #include <mesos/mesos.hpp>
 
+#include <process/clock.hpp>
 #include <process/defer.hpp>
+#include <process/delay.hpp>
 #include <process/once.hpp>
 #include <process/owned.hpp>
 #include <process/protobuf.hpp>
+#include <process/time.hpp>
 
 #include <stout/check.hpp>
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 
@@ -39,6 +43,8 @@
 
 #include "authentication/cram_md5/auxprop.hpp"
 
+#include "common/token.hpp"
+
 #include "messages/messages.hpp"
 
 namespace mesos {
@@ -48,14 +54,42 @@ namespace cram_md5 {
 using namespace process;
 using std::string;
 
+// How long the ticket handed out on a successful authentication can
+// be used to re-authenticate without a SASL exchange, e.g., when a
+// slave re-registers after a transient disconnection.
+static const Duration TICKET_TIMEOUT = Minutes(10);
+
+
+// Hands out a ticket for the authenticated principal to the given
+// peer, i.e., the one the authentication messages were received from
+// (see Message::peer).
+typedef lambda::function<
+  void(const string&, const string&, const Option<network::Address>&)>
+  Issue;
+
+
+// Redeems a ticket presented from the given peer, returning the
+// principal the ticket was handed out for, if valid.
+typedef lambda::function<
+  Future<Option<string>>(const string&, const Option<network::Address>&)>
+  Redeem;
+
+
 class CRAMMD5AuthenticatorSessionProcess :
   public ProtobufProcess<CRAMMD5AuthenticatorSessionProcess>
 {
 public:
-  explicit CRAMMD5AuthenticatorSessionProcess(const UPID& _pid)
+  CRAMMD5AuthenticatorSessionProcess(
+      const UPID& _pid,
+      const Option<string>& _ticket,
+      const Issue& _issue,
+      const Redeem& _redeem)
     : ProcessBase(ID::generate("crammd5_authenticator_session")),
       status(READY),
       pid(_pid),
+      ticket(_ticket),
+      issue(_issue),
+      redeem(_redeem),
       connection(NULL) {}
 
   virtual ~CRAMMD5AuthenticatorSessionProcess()
@@ -145,12 +179,11 @@ public:
     std::vector<string> mechanisms = strings::tokenize(output, ",");
 
     // Send authentication mechanisms.
-    AuthenticationMechanismsMessage message;
     foreach (const string& mechanism, mechanisms) {
-      message.add_mechanisms(mechanism);
+      this->mechanisms.add_mechanisms(mechanism);
     }
 
-    send(pid, message);
+    send(pid, this->mechanisms);
 
     status = STARTING;
 
@@ -168,13 +201,23 @@ public:
     install<AuthenticationStartMessage>(
         &CRAMMD5AuthenticatorSessionProcess::start,
         &AuthenticationStartMessage::mechanism,
-        &AuthenticationStartMessage::data);
+        &AuthenticationStartMessage::data,
+        &AuthenticationStartMessage::ticket);
 
     install<AuthenticationStepMessage>(
         &CRAMMD5AuthenticatorSessionProcess::step,
         &AuthenticationStepMessage::data);
   }
 
+  virtual void visit(const MessageEvent& event)
+  {
+    // Remember the peer the authenticatee's messages actually come
+    // from, which tickets get bound to.
+    peer = event.message->peer;
+
+    ProtobufProcess<CRAMMD5AuthenticatorSessionProcess>::visit(event);
+  }
+
   virtual void exited(const UPID& _pid)
   {
     if (pid == _pid) {
@@ -183,7 +226,10 @@ public:
     }
   }
 
-  void start(const string& mechanism, const string& data)
+  void start(
+      const string& mechanism,
+      const string& data,
+      const string& ticket)
   {
     if (status != STARTING) {
       AuthenticationErrorMessage message;
@@ -194,6 +240,24 @@ public:
       return;
     }
 
+    if (mechanism == "TICKET") {
+      LOG(INFO) << "Received authentication ticket";
+
+      if (this->ticket.isNone()) {
+        // Let the authenticatee fall back to the SASL exchange.
+        LOG(INFO) << "Refused authentication ticket, tickets are disabled";
+        send(pid, mechanisms);
+        return;
+      }
+
+      status = REDEEMING;
+
+      redeem(ticket, peer)
+        .onAny(defer(self(), &Self::redeemed, lambda::_1));
+
+      return;
+    }
+
     LOG(INFO) << "Received SASL authentication start";
 
     // Start the server.
@@ -237,6 +301,25 @@ public:
     handle(result, output, length);
   }
 
+  void redeemed(const Future<Option<string>>& principal)
+  {
+    if (status != REDEEMING) {
+      return; // The authentication has been discarded.
+    }
+
+    if (principal.isReady() && principal.get().isSome()) {
+      this->principal = principal.get();
+      completed();
+      return;
+    }
+
+    // Let the authenticatee fall back to the SASL exchange.
+    LOG(INFO) << "Refused authentication ticket";
+
+    send(pid, mechanisms);
+    status = STARTING;
+  }
+
   void discarded()
   {
     status = DISCARDED;
@@ -308,13 +391,10 @@ private:
       // Principal must have been set if authentication succeeded.
       CHECK_SOME(principal);
 
-      LOG(INFO) << "Authentication success";
       // Note that we're not using SASL_SUCCESS_DATA which means that
       // we should not have any data to send when we get a SASL_OK.
       CHECK(output == NULL);
-      send(pid, AuthenticationCompletedMessage());
-      status = COMPLETED;
-      promise.set(principal);
+      completed();
     } else if (result == SASL_CONTINUE) {
       LOG(INFO) << "Authentication requires more steps";
       AuthenticationStepMessage message;
@@ -339,9 +419,29 @@ private:
     }
   }
 
+  void completed()
+  {
+    CHECK_SOME(principal);
+
+    LOG(INFO) << "Authentication success";
+
+    status = COMPLETED;
+    promise.set(principal);
+
+    // The ticket is issued before it is sent so that the
+    // authenticator knows it by the time it gets presented.
+    AuthenticationCompletedMessage message;
+    if (ticket.isSome() && peer.isSome()) {
+      issue(ticket.get(), principal.get(), peer);
+      message.set_ticket(ticket.get());
+    }
+    send(pid, message);
+  }
+
   enum {
     READY,
     STARTING,
+    REDEEMING,
     STEPPING,
     COMPLETED,
     FAILED,
@@ -353,6 +453,18 @@ private:
 
   const UPID pid;
 
+  // The ticket handed out if the authentication succeeds, unless
+  // tickets are disabled.
+  const Option<string> ticket;
+
+  const Issue issue;
+  const Redeem redeem;
+
+  // The peer of the last message received (see 'visit').
+  Option<network::Address> peer;
+
+  AuthenticationMechanismsMessage mechanisms;
+
   sasl_conn_t* connection;
 
   Promise<Option<string>> promise;
@@ -364,9 +476,14 @@ private:
 class CRAMMD5AuthenticatorSession
 {
 public:
-  explicit CRAMMD5AuthenticatorSession(const UPID& pid)
+  CRAMMD5AuthenticatorSession(
+      const UPID& pid,
+      const Option<string>& ticket,
+      const Issue& issue,
+      const Redeem& redeem)
   {
-    process = new CRAMMD5AuthenticatorSessionProcess(pid);
+    process =
+      new CRAMMD5AuthenticatorSessionProcess(pid, ticket, issue, redeem);
     spawn(process);
   }
 
@@ -396,11 +513,19 @@ class CRAMMD5AuthenticatorProcess :
   public Process<CRAMMD5AuthenticatorProcess>
 {
 public:
-  CRAMMD5AuthenticatorProcess() :
-    ProcessBase(ID::generate("crammd5_authenticator")) {}
+  explicit CRAMMD5AuthenticatorProcess(bool _tickets) :
+    ProcessBase(ID::generate("crammd5_authenticator")),
+    tickets_(_tickets) {}
 
   virtual ~CRAMMD5AuthenticatorProcess() {}
 
+  virtual void initialize()
+  {
+    if (tickets_) {
+      delay(TICKET_TIMEOUT, self(), &Self::expire);
+    }
+  }
+
   Future<Option<string>> authenticate(const UPID& pid)
   {
     VLOG(1) << "Starting authentication session for " << pid;
@@ -409,8 +534,26 @@ public:
       return Failure("Authentication session already active");
     }
 
+    // A ticket is a bearer credential (though bound to the peer it
+    // is handed out to, see 'redeem'), hence it must not be guessable
+    // from the ones handed out before.
+    Option<string> ticket = None();
+    if (tickets_) {
+      Try<string> token = generateToken(32);
+      if (token.isError()) {
+        LOG(WARNING) << "Not handing out an authentication ticket: "
+                     << token.error();
+      } else {
+        ticket = token.get();
+      }
+    }
+
     Owned<CRAMMD5AuthenticatorSession> session(
-        new CRAMMD5AuthenticatorSession(pid));
+        new CRAMMD5AuthenticatorSession(
+            pid,
+            ticket,
+            defer(self(), &Self::issue, lambda::_1, lambda::_2, lambda::_3),
+            defer(self(), &Self::redeem, lambda::_1, lambda::_2)));
 
     sessions.put(pid, session);
 
@@ -423,11 +566,79 @@ public:
     if (sessions.contains(pid)){
       VLOG(1) << "Authentication session cleanup for " << pid;
       sessions.erase(pid);
+    }
+  }
+
+  void issue(
+      const string& ticket,
+      const string& principal,
+      const Option<network::Address>& peer)
+  {
+    CHECK_SOME(peer);
+
+    tickets.put(
+        ticket,
+        Ticket(principal, peer.get().ip, Clock::now() + TICKET_TIMEOUT));
+  }
+
+  // Returns the principal of a valid ticket presented from the host
+  // it was handed out to. The host is that of the connection the
+  // ticket was received on rather than the one of the PID claimed by
+  // the authenticatee, so that a ticket which got overheard can't be
+  // redeemed from another host. Tickets are used up when redeemed
+  // (the authenticatee gets a new one once authenticated).
+  Option<string> redeem(
+      const string& ticket,
+      const Option<network::Address>& peer)
+  {
+    Option<Ticket> ticket_ = tickets.get(ticket);
+    tickets.erase(ticket);
+
+    if (ticket_.isNone() ||
+        peer.isNone() ||
+        ticket_.get().ip != peer.get().ip ||
+        ticket_.get().expiry < Clock::now()) {
+      return None();
+    }
+
+    return ticket_.get().principal;
+  }
+
+  void expire()
+  {
+    const Time now = Clock::now();
+
+    std::vector<string> expired;
+    foreachpair (const string& ticket, const Ticket& ticket_, tickets) {
+      if (ticket_.expiry < now) {
+        expired.push_back(ticket);
+      }
+    }
+
+    foreach (const string& ticket, expired) {
+      tickets.erase(ticket);
+    }
+
+    delay(TICKET_TIMEOUT, self(), &Self::expire);
   }
-}
 
 private:
+  struct Ticket
+  {
+    Ticket(const string& _principal, const net::IP& _ip, const Time& _expiry)
+      : principal(_principal), ip(_ip), expiry(_expiry) {}
+
+    string principal;
+    net::IP ip;
+    Time expiry;
+  };
+
+  // Whether tickets are handed out (see CRAMMD5Authenticator).
+  const bool tickets_;
+
   hashmap <UPID, Owned<CRAMMD5AuthenticatorSession>> sessions;
+
+  hashmap<string, Ticket> tickets;
 };
 
 
@@ -468,7 +679,9 @@ Try<Authenticator*> CRAMMD5Authenticator::create()
 }
 
 
-CRAMMD5Authenticator::CRAMMD5Authenticator() : process(NULL) {}
+CRAMMD5Authenticator::CRAMMD5Authenticator(bool _tickets)
+  : tickets(_tickets),
+    process(NULL) {}
 
 
 CRAMMD5Authenticator::~CRAMMD5Authenticator()
@@ -535,7 +748,7 @@ Try<Nothing> CRAMMD5Authenticator::initialize(
     return error->get();
   }
 
-  process = new CRAMMD5AuthenticatorProcess();
+  process = new CRAMMD5AuthenticatorProcess(tickets);
   spawn(process);
 
   return Nothing();
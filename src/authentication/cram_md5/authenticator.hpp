@@ -42,7 +42,11 @@ public:
   // Factory to allow for typed tests.
   static Try<Authenticator*> create();
 
-  CRAMMD5Authenticator();
+  // Re-authentications can skip the SASL exchange by presenting the
+  // ticket handed out by the previous authentication, if 'tickets'
+  // is set. The tickets are sent in the clear, bound only to the host
+  // they are handed out to, hence they are disabled by default.
+  explicit CRAMMD5Authenticator(bool tickets = false);
 
   virtual ~CRAMMD5Authenticator();
 
@@ -52,6 +56,8 @@ public:
       const process::UPID& pid);
 
 private:
+  const bool tickets;
+
   CRAMMD5AuthenticatorProcess* process;
 };
 
@@ -28,9 +28,11 @@
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 
+#include <stout/cache.hpp>
 #include <stout/check.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/option.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/try.hpp>
 
@@ -48,60 +50,127 @@ using std::vector;
 namespace mesos {
 namespace internal {
 
+// Maximum number of authorization decisions cached by the local
+// authorizer. The decisions are cached for the lifetime of the
+// authorizer since its ACLs can not change.
+static const size_t MAX_CACHED_DECISIONS = 4096;
+
+
 class LocalAuthorizerProcess : public ProtobufProcess<LocalAuthorizerProcess>
 {
 public:
   LocalAuthorizerProcess(const ACLs& _acls)
-    : ProcessBase(process::ID::generate("authorizer")), acls(_acls) {}
-
-  Future<bool> authorize(const ACL::RegisterFramework& request)
+    : ProcessBase(process::ID::generate("authorizer")),
+      permissive(_acls.permissive()),
+      decisions(MAX_CACHED_DECISIONS)
   {
-    foreach (const ACL::RegisterFramework& acl, acls.register_frameworks()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.roles(), acl.roles())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.roles(), acl.roles());
-      }
+    // Compile the ACLs upfront so that the values of the entities
+    // are looked up in a hashset rather than matched linearly.
+    foreach (const ACL::RegisterFramework& acl, _acls.register_frameworks()) {
+      registerFrameworks.push_back(Rule(acl.principals(), acl.roles()));
+    }
+
+    foreach (const ACL::RunTask& acl, _acls.run_tasks()) {
+      runTasks.push_back(Rule(acl.principals(), acl.users()));
+    }
+
+    foreach (const ACL::ShutdownFramework& acl, _acls.shutdown_frameworks()) {
+      shutdownFrameworks.push_back(
+          Rule(acl.principals(), acl.framework_principals()));
     }
+  }
 
-    return acls.permissive(); // None of the ACLs match.
+  Future<bool> authorize(const ACL::RegisterFramework& request)
+  {
+    return authorize(
+        "RegisterFramework",
+        registerFrameworks,
+        request,
+        request.principals(),
+        request.roles());
   }
 
   Future<bool> authorize(const ACL::RunTask& request)
   {
-    foreach (const ACL::RunTask& acl, acls.run_tasks()) {
-      // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.users(), acl.users())) {
-        // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.users(), acl.users());
+    return authorize(
+        "RunTask",
+        runTasks,
+        request,
+        request.principals(),
+        request.users());
+  }
+
+  Future<bool> authorize(const ACL::ShutdownFramework& request)
+  {
+    return authorize(
+        "ShutdownFramework",
+        shutdownFrameworks,
+        request,
+        request.principals(),
+        request.framework_principals());
+  }
+
+private:
+  // An ACL entity with its values in a hashset.
+  struct Entity
+  {
+    explicit Entity(const ACL::Entity& entity)
+      : type(entity.type())
+    {
+      foreach (const string& value, entity.values()) {
+        values.insert(value);
       }
     }
 
-    return acls.permissive(); // None of the ACLs match.
-  }
+    ACL::Entity::Type type;
+    hashset<string> values;
+  };
 
-  Future<bool> authorize(const ACL::ShutdownFramework& request)
+  // An ACL, i.e., the entity of its subjects and of its objects.
+  struct Rule
+  {
+    Rule(const ACL::Entity& _subjects, const ACL::Entity& _objects)
+      : subjects(_subjects), objects(_objects) {}
+
+    Entity subjects;
+    Entity objects;
+  };
+
+  // Returns the decision of the first rule that matches the request,
+  // and caches it since the same requests (e.g., the launches of the
+  // tasks of a framework as the same user) tend to repeat.
+  Future<bool> authorize(
+      const string& action,
+      const vector<Rule>& rules,
+      const google::protobuf::Message& request,
+      const ACL::Entity& subjects,
+      const ACL::Entity& objects)
   {
-    foreach (const ACL::ShutdownFramework& acl, acls.shutdown_frameworks()) {
+    const string key = action + ":" + request.SerializeAsString();
+
+    Option<bool> decision = decisions.get(key);
+    if (decision.isSome()) {
+      return decision.get();
+    }
+
+    decision = permissive; // In case none of the ACLs match.
+
+    foreach (const Rule& rule, rules) {
       // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.framework_principals(),
-                  acl.framework_principals())) {
+      if (matches(subjects, rule.subjects) &&
+          matches(objects, rule.objects)) {
         // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.framework_principals(),
-                      acl.framework_principals());
+        decision = allows(subjects, rule.subjects) &&
+                   allows(objects, rule.objects);
+        break;
       }
     }
 
-    return acls.permissive(); // None of the ACLs match.
+    decisions.put(key, decision.get());
+
+    return decision.get();
   }
 
-private:
   // Match matrix:
   //
   //                  -----------ACL----------
@@ -114,40 +183,27 @@ private:
   //  |       -------|-------|-------|-------
   //  |        ANY   |  No   |  Yes  |   Yes
   //          -------|-------|-------|-------
-  bool matches(const ACL::Entity& request, const ACL::Entity& acl)
+  bool matches(const ACL::Entity& request, const Entity& acl)
   {
     // NONE only matches with NONE.
     if (request.type() == ACL::Entity::NONE) {
-      return acl.type() == ACL::Entity::NONE;
+      return acl.type == ACL::Entity::NONE;
     }
 
     // ANY matches with ANY or NONE.
     if (request.type() == ACL::Entity::ANY) {
-      return acl.type() == ACL::Entity::ANY || acl.type() == ACL::Entity::NONE;
+      return acl.type == ACL::Entity::ANY || acl.type == ACL::Entity::NONE;
     }
 
     if (request.type() == ACL::Entity::SOME) {
       // SOME matches with ANY or NONE.
-      if (acl.type() == ACL::Entity::ANY || acl.type() == ACL::Entity::NONE) {
+      if (acl.type == ACL::Entity::ANY || acl.type == ACL::Entity::NONE) {
         return true;
       }
 
       // SOME is allowed if the request values are a subset of ACL
       // values.
-      foreach (const string& value, request.values()) {
-        bool found = false;
-        foreach (const string& value_, acl.values()) {
-          if (value == value_) {
-            found = true;
-            break;
-          }
-        }
-
-        if (!found) {
-          return false;
-        }
-      }
-      return true;
+      return subset(request, acl);
     }
 
     return false;
@@ -165,51 +221,56 @@ private:
   //  |       -------|-------|-------|-------
   //  |        ANY   |  No   |  No   |   Yes
   //          -------|-------|-------|-------
-  bool allows(const ACL::Entity& request, const ACL::Entity& acl)
+  bool allows(const ACL::Entity& request, const Entity& acl)
   {
     // NONE is only allowed by NONE.
     if (request.type() == ACL::Entity::NONE) {
-      return acl.type() == ACL::Entity::NONE;
+      return acl.type == ACL::Entity::NONE;
     }
 
     // ANY is only allowed by ANY.
     if (request.type() == ACL::Entity::ANY) {
-      return acl.type() == ACL::Entity::ANY;
+      return acl.type == ACL::Entity::ANY;
     }
 
     if (request.type() == ACL::Entity::SOME) {
       // SOME is allowed by ANY.
-      if (acl.type() == ACL::Entity::ANY) {
+      if (acl.type == ACL::Entity::ANY) {
         return true;
       }
 
       // SOME is not allowed by NONE.
-      if (acl.type() == ACL::Entity::NONE) {
+      if (acl.type == ACL::Entity::NONE) {
         return false;
       }
 
       // SOME is allowed if the request values are a subset of ACL
       // values.
-      foreach (const string& value, request.values()) {
-        bool found = false;
-        foreach (const string& value_, acl.values()) {
-          if (value == value_) {
-            found = true;
-            break;
-          }
-        }
-
-        if (!found) {
-          return false;
-        }
-      }
-      return true;
+      return subset(request, acl);
     }
 
     return false;
   }
 
-  ACLs acls;
+  // Returns whether the request values are a subset of ACL values.
+  bool subset(const ACL::Entity& request, const Entity& acl)
+  {
+    foreach (const string& value, request.values()) {
+      if (!acl.values.contains(value)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  const bool permissive;
+
+  vector<Rule> registerFrameworks;
+  vector<Rule> runTasks;
+  vector<Rule> shutdownFrameworks;
+
+  Cache<string, bool> decisions;
 };
 
 
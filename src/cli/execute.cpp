@@ -32,6 +32,7 @@
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/stringify.hpp>
 
 #include "common/parse.hpp"
 #include "common/protobuf_utils.hpp"
@@ -81,6 +82,16 @@ public:
         "Resources for the command",
         "cpus:1;mem:128");
 
+    add(&instances,
+        "instances",
+        "Number of instances of the command to launch as an array of\n"
+        "tasks named '<name>-<index>', with the index of each instance\n"
+        "in its MESOS_TASK_INDEX environment variable. The instances\n"
+        "are packed into the offers, i.e., an offer is used for as many\n"
+        "instances as its resources allow, and the framework stops once\n"
+        "every instance has terminated",
+        1);
+
     add(&hadoop,
         "hadoop",
         "Path to `hadoop' script (used for copying packages)",
@@ -117,6 +128,7 @@ public:
   Option<string> command;
   Option<hashmap<string, string>> environment;
   string resources;
+  size_t instances;
   string hadoop;
   string hdfs;
   Option<string> package;
@@ -134,15 +146,19 @@ public:
       const string& _command,
       const Option<hashmap<string, string>>& _environment,
       const string& _resources,
+      size_t _instances,
       const Option<string>& _uri,
       const Option<string>& _dockerImage)
     : name(_name),
       command(_command),
       environment(_environment),
       resources(_resources),
+      instances(_instances),
       uri(_uri),
       dockerImage(_dockerImage),
-      launched(false) {}
+      launched(0),
+      terminated(0),
+      failed(0) {}
 
   virtual ~CommandScheduler() {}
 
@@ -176,55 +192,35 @@ public:
     }
 
     foreach (const Offer& offer, offers) {
-      if (!launched &&
-          Resources(offer.resources()).contains(TASK_RESOURCES.get())) {
-        TaskInfo task;
-        task.set_name(name);
-        task.mutable_task_id()->set_value(name);
-        task.mutable_slave_id()->MergeFrom(offer.slave_id());
-        task.mutable_resources()->CopyFrom(TASK_RESOURCES.get());
-
-        CommandInfo* commandInfo = task.mutable_command();
-        commandInfo->set_value(command);
-        if (environment.isSome()) {
-          Environment* environment_ = commandInfo->mutable_environment();
-          foreachpair (const std::string& name,
-                       const std::string& value,
-                       environment.get()) {
-            Environment_Variable* environmentVariable =
-              environment_->add_variables();
-            environmentVariable->set_name(name);
-            environmentVariable->set_value(value);
-          }
-        }
-
-        if (uri.isSome()) {
-          task.mutable_command()->add_uris()->set_value(uri.get());
-        }
-
-        if (dockerImage.isSome()) {
-          ContainerInfo containerInfo;
-          containerInfo.set_type(ContainerInfo::DOCKER);
-
-          ContainerInfo::DockerInfo dockerInfo;
-          dockerInfo.set_image(dockerImage.get());
+      // Pack as many of the remaining instances into the offer as its
+      // resources allow.
+      Resources remaining = offer.resources();
+      vector<TaskInfo> tasks;
+
+      while (launched < instances &&
+             remaining.contains(TASK_RESOURCES.get())) {
+        tasks.push_back(createTask(offer.slave_id(), TASK_RESOURCES.get()));
+        remaining -= TASK_RESOURCES.get();
+        launched++;
+      }
 
-          containerInfo.mutable_docker()->CopyFrom(dockerInfo);
-          task.mutable_container()->CopyFrom(containerInfo);
-        }
+      if (tasks.empty()) {
+        driver->declineOffer(offer.id());
+        continue;
+      }
 
-        vector<TaskInfo> tasks;
-        tasks.push_back(task);
+      driver->launchTasks(offer.id(), tasks);
 
-        driver->launchTasks(offer.id(), tasks);
-        cout << "task " << name << " submitted to slave "
+      foreach (const TaskInfo& task, tasks) {
+        cout << "task " << task.task_id() << " submitted to slave "
              << offer.slave_id() << endl;
-
-        launched = true;
-      } else {
-        driver->declineOffer(offer.id());
       }
     }
+
+    // No more offers are needed once every instance is launched.
+    if (launched == instances) {
+      driver->suppressOffers();
+    }
   }
 
   virtual void offerRescinded(
@@ -235,11 +231,24 @@ public:
       SchedulerDriver* driver,
       const TaskStatus& status)
   {
-    CHECK_EQ(name, status.task_id().value());
     cout << "Received status update " << status.state()
          << " for task " << status.task_id() << endl;
+
     if (mesos::internal::protobuf::isTerminalState(status.state())) {
-      driver->stop();
+      terminated++;
+
+      if (status.state() != TASK_FINISHED) {
+        failed++;
+      }
+
+      if (terminated == instances) {
+        if (instances > 1) {
+          cout << instances - failed << " of " << instances
+               << " tasks finished" << endl;
+        }
+
+        driver->stop();
+      }
     }
   }
 
@@ -264,13 +273,71 @@ public:
       const string& message) {}
 
 private:
+  // Returns the task of the next instance to launch.
+  TaskInfo createTask(const SlaveID& slaveId, const Resources& resources)
+  {
+    // A single instance keeps the name of the command as its ID.
+    const string id = instances > 1 ? name + "-" + stringify(launched) : name;
+
+    TaskInfo task;
+    task.set_name(id);
+    task.mutable_task_id()->set_value(id);
+    task.mutable_slave_id()->MergeFrom(slaveId);
+    task.mutable_resources()->CopyFrom(resources);
+
+    CommandInfo* commandInfo = task.mutable_command();
+    commandInfo->set_value(command);
+
+    if (environment.isSome() || instances > 1) {
+      Environment* environment_ = commandInfo->mutable_environment();
+
+      if (environment.isSome()) {
+        foreachpair (const std::string& name,
+                     const std::string& value,
+                     environment.get()) {
+          Environment_Variable* environmentVariable =
+            environment_->add_variables();
+          environmentVariable->set_name(name);
+          environmentVariable->set_value(value);
+        }
+      }
+
+      if (instances > 1) {
+        Environment_Variable* environmentVariable =
+          environment_->add_variables();
+        environmentVariable->set_name("MESOS_TASK_INDEX");
+        environmentVariable->set_value(stringify(launched));
+      }
+    }
+
+    if (uri.isSome()) {
+      task.mutable_command()->add_uris()->set_value(uri.get());
+    }
+
+    if (dockerImage.isSome()) {
+      ContainerInfo containerInfo;
+      containerInfo.set_type(ContainerInfo::DOCKER);
+
+      ContainerInfo::DockerInfo dockerInfo;
+      dockerInfo.set_image(dockerImage.get());
+
+      containerInfo.mutable_docker()->CopyFrom(dockerInfo);
+      task.mutable_container()->CopyFrom(containerInfo);
+    }
+
+    return task;
+  }
+
   const string name;
   const string command;
   const Option<hashmap<string, string>> environment;
   const string resources;
+  const size_t instances;
   const Option<string> uri;
   const Option<string> dockerImage;
-  bool launched;
+  size_t launched;
+  size_t terminated;
+  size_t failed;
 };
 
 
@@ -317,6 +384,11 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
+  if (flags.instances == 0) {
+    cerr << flags.usage("Expecting --instances to be positive") << endl;
+    return EXIT_FAILURE;
+  }
+
   Result<string> user = os::user();
   if (!user.isSome()) {
     if (user.isError()) {
@@ -387,6 +459,7 @@ int main(int argc, char** argv)
       flags.command.get(),
       environment,
       flags.resources,
+      flags.instances,
       uri,
       dockerImage);
 
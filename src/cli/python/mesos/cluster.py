@@ -0,0 +1,130 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Helpers for the CLI tools to gather information from the cluster:
+# the master is only asked for what a tool needs (using the filters
+# of its endpoints) and the slaves are contacted concurrently.
+
+import json
+
+from mesos import http
+from mesos.futures import *
+
+
+# The default number of slaves that are contacted concurrently.
+PARALLELISM = 32
+
+# The default timeout (in seconds) of a request to the master or to
+# a slave.
+TIMEOUT = 30.0
+
+# The 'limit' of the tasks endpoint of the master is an int.
+TASKS_LIMIT = 2 ** 31 - 1
+
+TERMINAL_STATES = ['TASK_FINISHED',
+                   'TASK_FAILED',
+                   'TASK_KILLED',
+                   'TASK_LOST',
+                   'TASK_ERROR']
+
+
+# Helper for doing an HTTP GET of a JSON endpoint, see 'http.get'.
+def get(pid, path, query=None, timeout=TIMEOUT):
+    return json.loads(http.get(pid, path, query, timeout))
+
+
+# Returns a dict from slave ID to the slaves registered with the
+# master.
+def slaves(master):
+    return dict((slave['id'], slave)
+                for slave in get(master, '/master/slaves')['slaves'])
+
+
+# Returns a dict from framework ID to the (summarized) frameworks
+# registered with the master.
+def frameworks(master):
+    return dict((framework['id'], framework)
+                for framework in get(master, '/master/state-summary')
+                                    ['frameworks'])
+
+
+# Returns the tasks known to the master (including the completed
+# ones), optionally only those of the given framework and/or only
+# the given 'fields' of each task.
+def tasks(master, framework=None, fields=None):
+    query = {'limit': TASKS_LIMIT}
+
+    if framework is not None:
+        query['framework_id'] = framework
+
+    if fields is not None:
+        query['fields'] = ','.join(fields)
+
+    return get(master, '/master/tasks.json', query)['tasks']
+
+
+# Returns the slave that the task of the framework with the given ID
+# runs (or ran) on along with the task, or None if the master does not
+# know the task or its slave.
+def task(master, framework, id):
+    for task in tasks(master, framework):
+        if task['id'] == id:
+            slave = slaves(master).get(task['slave_id'])
+            return (slave, task) if slave is not None else None
+
+    return None
+
+
+# Returns the directory of the executor of the task on the slave, or
+# None if the slave does not know the executor.
+def directory(slave, task):
+    executor_id = task['executor_id']
+
+    # An executorless task has an empty executor ID in the master but
+    # uses the same executor ID as task ID in the slave.
+    if executor_id == '': executor_id = task['id']
+
+    state = get(slave['pid'], '/state.json')
+
+    for framework in state['frameworks'] + state['completed_frameworks']:
+        if framework['id'] == task['framework_id']:
+            for executor in (framework['executors'] +
+                             framework['completed_executors']):
+                if executor['id'] == executor_id:
+                    return executor['directory']
+
+    return None
+
+
+# Calls 'fn' with each of the slaves, at most 'parallelism' of them at
+# a time, and yields '(slave, result, error)' as the calls complete,
+# where either 'result' is what 'fn' returned or 'error' what it
+# raised. Raises a TimeoutError if the calls don't all complete within
+# 'timeout' seconds (if given).
+def scatter(fn, slaves, parallelism=PARALLELISM, timeout=None):
+    with ThreadingExecutor(parallelism) as executor:
+        futures = dict((executor.submit(fn, slave), slave)
+                       for slave in slaves)
+
+        for future in as_completed(futures, timeout):
+            try:
+                result, error = future.result(), None
+            except Exception as e:
+                result, error = None, e
+
+            yield futures[future], result, error
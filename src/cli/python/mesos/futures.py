@@ -16,13 +16,15 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+import threading
+
+from Queue import Queue
+
 try:
     from concurrent.futures import *
 except ImportError:
-    import threading
     import time
 
-    from Queue import Queue
     from Queue import Empty
 
     class TimeoutError(Exception):
@@ -161,9 +163,14 @@ except ImportError:
                 finished += 1
 
 
+# An executor that runs the submitted calls on threads, at most
+# 'max_workers' of them at a time if given, otherwise each call on a
+# thread of its own.
 class ThreadingExecutor(Executor):
-    def __init__(self):
+    def __init__(self, max_workers=None):
+        self._max_workers = max_workers
         self._threads = []
+        self._queue = Queue()
 
     def submit(self, fn, *args, **kwargs):
         future = Future()
@@ -172,9 +179,16 @@ class ThreadingExecutor(Executor):
                 future.set_result(fn(*args, **kwargs))
             except Exception as e:
                 future.set_exception(e)
-        thread = threading.Thread(target=run)
-        thread.start()
-        self._threads.append(thread)
+
+        if self._max_workers is None:
+            self._start(run)
+        else:
+            # The calls are queued for the workers, which are started
+            # as needed.
+            self._queue.put(run)
+            if len(self._threads) < self._max_workers:
+                self._start(self._work)
+
         return future
 
     def map(self, func, iterables, timeout=None):
@@ -182,7 +196,29 @@ class ThreadingExecutor(Executor):
         raise NotImplementedError()
 
     def shutdown(self, wait=True):
+        # Tell the workers to stop once the queued calls are done.
+        if self._max_workers is not None:
+            for thread in self._threads:
+                self._queue.put(None)
+
         if wait:
             for thread in self._threads:
                 thread.join()
         self._threads = []
+
+    def _start(self, target):
+        thread = threading.Thread(target=target)
+
+        # Don't keep a tool from exiting (e.g., after a timeout) while
+        # calls are still running.
+        thread.daemon = True
+
+        thread.start()
+        self._threads.append(thread)
+
+    def _work(self):
+        while True:
+            run = self._queue.get()
+            if run is None:
+                return
+            run()
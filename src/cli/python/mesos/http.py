@@ -28,7 +28,10 @@
 #
 # Note that you can also pass an IP:port (or hostname:port) for 'pid'
 # (i.e., you can omit the ID component of the PID, e.g., 'foo@').
-def get(pid, path, query=None):
+#
+# The request fails if it does not complete within 'timeout' seconds
+# (if given).
+def get(pid, path, query=None, timeout=None):
     import urllib2
 
     from contextlib import closing
@@ -40,5 +43,10 @@ def get(pid, path, query=None):
             ['%s=%s' % (urllib2.quote(str(key)), urllib2.quote(str(value)))
              for (key, value) in query.items()])
 
-    with closing(urllib2.urlopen(url)) as file:
+    if timeout is None:
+        file = urllib2.urlopen(url)
+    else:
+        file = urllib2.urlopen(url, timeout=timeout)
+
+    with closing(file) as file:
         return file.read()
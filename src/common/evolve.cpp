@@ -0,0 +1,189 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <process/pid.hpp>
+
+#include <stout/foreach.hpp>
+
+#include "common/evolve.hpp"
+#include "common/protobuf_utils.hpp"
+
+using std::vector;
+
+using process::UPID;
+
+using mesos::scheduler::Event;
+
+namespace mesos {
+namespace internal {
+
+static Event subscribed(const FrameworkID& frameworkId)
+{
+  Event event;
+  event.set_type(Event::SUBSCRIBED);
+
+  event.mutable_subscribed()->mutable_framework_id()->CopyFrom(frameworkId);
+
+  return event;
+}
+
+
+Event evolve(const FrameworkRegisteredMessage& message)
+{
+  return subscribed(message.framework_id());
+}
+
+
+Event evolve(const FrameworkReregisteredMessage& message)
+{
+  return subscribed(message.framework_id());
+}
+
+
+Event evolve(const ResourceOffersMessage& message)
+{
+  Event event;
+  event.set_type(Event::OFFERS);
+
+  Event::Offers* offers = event.mutable_offers();
+
+  foreach (const Offer& offer, protobuf::getOffers(message)) {
+    offers->add_offers()->CopyFrom(offer);
+  }
+
+  return event;
+}
+
+
+vector<Event> evolve(const RescindResourceOfferMessage& message)
+{
+  vector<Event> events;
+
+  Event event;
+  event.set_type(Event::RESCIND);
+
+  event.mutable_rescind()->mutable_offer_id()->CopyFrom(message.offer_id());
+  events.push_back(event);
+
+  foreach (const OfferID& offerId, message.offer_ids()) {
+    event.mutable_rescind()->mutable_offer_id()->CopyFrom(offerId);
+    events.push_back(event);
+  }
+
+  return events;
+}
+
+
+Event evolve(const StatusUpdateMessage& message)
+{
+  Event event;
+  event.set_type(Event::UPDATE);
+
+  TaskStatus* status = event.mutable_update()->mutable_status();
+
+  status->CopyFrom(message.update().status());
+
+  if (message.update().has_slave_id()) {
+    status->mutable_slave_id()->CopyFrom(message.update().slave_id());
+  }
+
+  if (message.update().has_executor_id()) {
+    status->mutable_executor_id()->CopyFrom(message.update().executor_id());
+  }
+
+  status->set_timestamp(message.update().timestamp());
+
+  // If the update is generated by the master it doesn't need to be
+  // acknowledged; so we unset the UUID inside TaskStatus.
+  if (UPID(message.pid()) == UPID()) {
+    status->clear_uuid();
+  } else {
+    status->set_uuid(message.update().uuid());
+  }
+
+  return event;
+}
+
+
+vector<Event> evolve(const StatusUpdatesMessage& message)
+{
+  vector<Event> events;
+
+  foreach (const StatusUpdateMessage& update, message.updates()) {
+    events.push_back(evolve(update));
+  }
+
+  return events;
+}
+
+
+Event evolve(const LostSlaveMessage& message)
+{
+  Event event;
+  event.set_type(Event::FAILURE);
+
+  event.mutable_failure()->mutable_slave_id()->CopyFrom(message.slave_id());
+
+  return event;
+}
+
+
+Event evolve(const ExitedExecutorMessage& message)
+{
+  Event event;
+  event.set_type(Event::FAILURE);
+
+  Event::Failure* failure = event.mutable_failure();
+
+  failure->mutable_slave_id()->CopyFrom(message.slave_id());
+  failure->mutable_executor_id()->CopyFrom(message.executor_id());
+  failure->set_status(message.status());
+
+  return event;
+}
+
+
+Event evolve(const ExecutorToFrameworkMessage& _message)
+{
+  Event event;
+  event.set_type(Event::MESSAGE);
+
+  Event::Message* message = event.mutable_message();
+
+  message->mutable_slave_id()->CopyFrom(_message.slave_id());
+  message->mutable_executor_id()->CopyFrom(_message.executor_id());
+  message->set_data(_message.data());
+
+  return event;
+}
+
+
+Event evolve(const FrameworkErrorMessage& message)
+{
+  Event event;
+  event.set_type(Event::ERROR);
+
+  event.mutable_error()->set_message(message.message());
+
+  return event;
+}
+
+} // namespace internal {
+} // namespace mesos {
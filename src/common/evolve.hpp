@@ -0,0 +1,55 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __COMMON_EVOLVE_HPP__
+#define __COMMON_EVOLVE_HPP__
+
+#include <vector>
+
+#include <mesos/scheduler/scheduler.hpp>
+
+#include "messages/messages.hpp"
+
+namespace mesos {
+namespace internal {
+
+// Helpers for converting the internal messages that the master sends
+// to a scheduler into the corresponding scheduler events, e.g., for
+// the schedulers that subscribe over HTTP.
+scheduler::Event evolve(const FrameworkRegisteredMessage& message);
+scheduler::Event evolve(const FrameworkReregisteredMessage& message);
+scheduler::Event evolve(const ResourceOffersMessage& message);
+scheduler::Event evolve(const StatusUpdateMessage& message);
+scheduler::Event evolve(const LostSlaveMessage& message);
+scheduler::Event evolve(const ExitedExecutorMessage& message);
+scheduler::Event evolve(const ExecutorToFrameworkMessage& message);
+scheduler::Event evolve(const FrameworkErrorMessage& message);
+
+// A RESCIND event names a single offer, so a message that rescinds
+// several offers becomes several events.
+std::vector<scheduler::Event> evolve(
+    const RescindResourceOfferMessage& message);
+
+// Likewise, a batch of status updates becomes an UPDATE event per
+// status update.
+std::vector<scheduler::Event> evolve(const StatusUpdatesMessage& message);
+
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __COMMON_EVOLVE_HPP__
@@ -16,25 +16,118 @@
  * limitations under the License.
  */
 
+#include <functional>
+#include <sstream>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include <glog/logging.h>
+
 #include <mesos/resources.hpp>
 
 #include <stout/foreach.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 
 #include "common/attributes.hpp"
 #include "common/http.hpp"
 
 #include "messages/messages.hpp"
 
+using process::http::NotModified;
+using process::http::OK;
+using process::http::Response;
+
+using std::string;
 using std::vector;
 
 namespace mesos {
 namespace internal {
 
+const char APPLICATION_JSON[] = "application/json";
+const char APPLICATION_PROTOBUF[] = "application/x-protobuf";
+
+
+Option<Response> notModified(
+    const process::http::Request& request,
+    const string& etag)
+{
+  Option<string> match = request.headers.get("If-None-Match");
+  if (match.isNone()) {
+    return None();
+  }
+
+  foreach (string tag, strings::tokenize(match.get(), ",")) {
+    tag = strings::trim(tag);
+
+    // A weak comparison suffices for a conditional GET.
+    if (strings::startsWith(tag, "W/")) {
+      tag = tag.substr(2);
+    }
+
+    if (tag == "*" || tag == etag) {
+      NotModified notModified;
+      notModified.headers["ETag"] = etag;
+      return notModified;
+    }
+  }
+
+  return None();
+}
+
+
+Response cacheable(
+    const process::http::Request& request,
+    const string& body,
+    const string& etag)
+{
+  Option<Response> unmodified = notModified(request, etag);
+  if (unmodified.isSome()) {
+    return unmodified.get();
+  }
+
+  Option<string> jsonp = request.query.get("jsonp");
+
+  OK ok(jsonp.isSome() ? jsonp.get() + "(" + body + ");" : body);
+  ok.headers["Content-Type"] =
+    jsonp.isSome() ? "text/javascript" : APPLICATION_JSON;
+  ok.headers["ETag"] = etag;
+
+  return ok;
+}
+
+
+Response cacheable(const process::http::Request& request, const string& body)
+{
+  // NOTE: The body gets hashed without the JSONP padding, which is
+  // fine as the padding is part of the URL the ETag belongs to.
+  std::ostringstream etag;
+  etag << "\"" << std::hex << std::hash<string>()(body)
+       << "-" << body.size() << "\"";
+
+  return cacheable(request, body, etag.str());
+}
+
+
+string serialize(
+    const string& contentType,
+    const google::protobuf::Message& message)
+{
+  if (contentType == APPLICATION_PROTOBUF) {
+    return message.SerializeAsString();
+  }
+
+  CHECK_EQ(APPLICATION_JSON, contentType);
+
+  string json;
+  JSON::Writer writer(&json);
+  JSON::protobuf(&writer, message);
+  return json;
+}
+
+
 // TODO(bmahler): Kill these in favor of automatic Proto->JSON
 // Conversion (when it becomes available).
 
@@ -206,5 +299,94 @@ JSON::Object model(
 }
 
 
+// Writes the statuses of a task, see 'model' above.
+template <typename Iterable>
+static void jsonStatuses(JSON::Writer* writer, const Iterable& statuses)
+{
+  writer->key("statuses");
+  writer->startArray();
+  foreach (const TaskStatus& status, statuses) {
+    writer->startObject();
+    writer->field("state", TaskState_Name(status.state()));
+    writer->field("timestamp", status.timestamp());
+    writer->endObject();
+  }
+  writer->endArray();
+}
+
+
+// Writes the labels and discovery of a task, see 'model' above.
+template <typename T>
+static void jsonLabels(JSON::Writer* writer, const T& task)
+{
+  writer->key("labels");
+  writer->startArray();
+  if (task.has_labels()) {
+    foreach (const Label& label, task.labels().labels()) {
+      JSON::protobuf(writer, label);
+    }
+  }
+  writer->endArray();
+
+  if (task.has_discovery()) {
+    writer->key("discovery");
+    JSON::protobuf(writer, task.discovery());
+  }
+}
+
+
+void json(JSON::Writer* writer, const Task& task)
+{
+  writer->startObject();
+  writer->field("id", task.task_id().value());
+  writer->field("name", task.name());
+  writer->field("framework_id", task.framework_id().value());
+
+  if (task.has_executor_id()) {
+    writer->field("executor_id", task.executor_id().value());
+  } else {
+    writer->field("executor_id", "");
+  }
+
+  writer->field("slave_id", task.slave_id().value());
+  writer->field("state", TaskState_Name(task.state()));
+  writer->field("resources", model(task.resources()));
+
+  jsonStatuses(writer, task.statuses());
+  jsonLabels(writer, task);
+
+  writer->endObject();
+}
+
+
+void json(
+    JSON::Writer* writer,
+    const TaskInfo& task,
+    const FrameworkID& frameworkId,
+    const TaskState& state,
+    const vector<TaskStatus>& statuses)
+{
+  writer->startObject();
+  writer->field("id", task.task_id().value());
+  writer->field("name", task.name());
+  writer->field("framework_id", frameworkId.value());
+
+  if (task.has_executor()) {
+    writer->field("executor_id", task.executor().executor_id().value());
+  } else {
+    writer->field("executor_id", "");
+  }
+
+  writer->field("slave_id", task.slave_id().value());
+  writer->field("state", TaskState_Name(state));
+  writer->field("resources", model(task.resources()));
+
+  jsonStatuses(writer, statuses);
+  jsonLabels(writer, task);
+
+  writer->endObject();
+}
+
+
 }  // namespace internal {
 }  // namespace mesos {
@@ -19,11 +19,20 @@
 #ifndef __COMMON_HTTP_HPP__
 #define __COMMON_HTTP_HPP__
 
+#include <string>
 #include <vector>
 
+#include <google/protobuf/message.h>
+
 #include <mesos/mesos.hpp>
 
+#include <process/http.hpp>
+
+#include <stout/error.hpp>
 #include <stout/json.hpp>
+#include <stout/option.hpp>
+#include <stout/protobuf.hpp>
+#include <stout/try.hpp>
 
 namespace mesos {
 
@@ -35,6 +44,71 @@ class Attributes;
 class Task;
 
 
+// Media types of the requests and responses of the HTTP APIs (e.g.,
+// the scheduler calls and events).
+extern const char APPLICATION_JSON[];
+extern const char APPLICATION_PROTOBUF[];
+
+
+// Serializes the message in the given media type, which must be
+// either APPLICATION_JSON or APPLICATION_PROTOBUF.
+std::string serialize(
+    const std::string& contentType,
+    const google::protobuf::Message& message);
+
+
+// Deserializes a message from the body of the given media type.
+template <typename Message>
+Try<Message> deserialize(
+    const std::string& contentType,
+    const std::string& body)
+{
+  if (contentType == APPLICATION_PROTOBUF) {
+    Message message;
+    if (!message.ParseFromString(body)) {
+      return Error("Failed to parse body into " + message.GetTypeName());
+    }
+    return message;
+  } else if (contentType == APPLICATION_JSON) {
+    Try<JSON::Value> value = JSON::parse(body);
+    if (value.isError()) {
+      return Error("Failed to parse body into JSON: " + value.error());
+    }
+    return ::protobuf::parse<Message>(value.get());
+  }
+
+  return Error("Unsupported media type '" + contentType + "'");
+}
+
+
+// Returns a '304 Not Modified' if the 'If-None-Match' header of the
+// request matches 'etag', i.e., if the client already has the current
+// version of the resource, otherwise none. This allows a handler that
+// knows the version of its resource to answer a poll without
+// serializing the resource.
+Option<process::http::Response> notModified(
+    const process::http::Request& request,
+    const std::string& etag);
+
+
+// Returns the (serialized) JSON 'body' as a response, padded as
+// JSONP if requested (see the JSON variant of http::OK), along with
+// 'etag' as the ETag of the response. If the 'If-None-Match' header
+// of the request matches that ETag, i.e., the client already has the
+// body, returns a '304 Not Modified' without the body instead.
+process::http::Response cacheable(
+    const process::http::Request& request,
+    const std::string& body,
+    const std::string& etag);
+
+
+// As above, for a resource without a version, using a hash of the
+// body as the ETag.
+process::http::Response cacheable(
+    const process::http::Request& request,
+    const std::string& body);
+
+
 JSON::Object model(const Resources& resources);
 JSON::Object model(const Attributes& attributes);
 
@@ -47,6 +121,17 @@ JSON::Object model(
     const TaskState& state,
     const std::vector<TaskStatus>& statuses);
 
+// Write the same JSON as the respective 'model' directly into the
+// writer, i.e., without building a JSON::Object first. These are
+// used for streaming large responses.
+void json(JSON::Writer* writer, const Task& task);
+void json(
+    JSON::Writer* writer,
+    const TaskInfo& task,
+    const FrameworkID& frameworkId,
+    const TaskState& state,
+    const std::vector<TaskStatus>& statuses);
+
 } // namespace internal {
 } // namespace mesos {
 
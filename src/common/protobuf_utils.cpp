@@ -16,11 +16,14 @@
  * limitations under the License.
  */
 
+#include <vector>
+
 #include <mesos/type_utils.hpp>
 
 #include <process/clock.hpp>
 #include <process/pid.hpp>
 
+#include <stout/check.hpp>
 #include <stout/net.hpp>
 #include <stout/stringify.hpp>
 #include <stout/uuid.hpp>
@@ -28,6 +31,7 @@
 #include "messages/messages.hpp"
 
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -121,6 +125,32 @@ Task createTask(
 }
 
 
+TaskStatus createTaskStatusSummary(const TaskStatus& status)
+{
+  TaskStatus summary;
+  summary.mutable_task_id()->CopyFrom(status.task_id());
+  summary.set_state(status.state());
+
+  if (status.has_source()) {
+    summary.set_source(status.source());
+  }
+
+  if (status.has_reason()) {
+    summary.set_reason(status.reason());
+  }
+
+  if (status.has_timestamp()) {
+    summary.set_timestamp(status.timestamp());
+  }
+
+  if (status.has_healthy()) {
+    summary.set_healthy(status.healthy());
+  }
+
+  return summary;
+}
+
+
 Option<bool> getTaskHealth(const Task& task)
 {
   Option<bool> healthy = None();
@@ -158,6 +188,28 @@ MasterInfo createMasterInfo(const process::UPID& pid)
   return info;
 }
 
+
+vector<Offer> getOffers(const ResourceOffersMessage& message)
+{
+  vector<Offer> offers(message.offers().begin(), message.offers().end());
+
+  if (message.attributes_indices_size() == 0) {
+    return offers;
+  }
+
+  CHECK_EQ(message.offers_size(), message.attributes_indices_size());
+
+  for (size_t i = 0; i < offers.size(); i++) {
+    const uint32_t index = message.attributes_indices(i);
+    CHECK_LT(index, (uint32_t) message.attributes_size());
+
+    offers[i].mutable_attributes()->CopyFrom(
+        message.attributes(index).attributes());
+  }
+
+  return offers;
+}
+
 } // namespace protobuf {
 } // namespace internal {
 } // namespace mesos {
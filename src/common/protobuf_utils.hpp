@@ -20,6 +20,7 @@
 #define __PROTOBUF_UTILS_HPP__
 
 #include <string>
+#include <vector>
 
 #include <stout/ip.hpp>
 #include <stout/option.hpp>
@@ -56,12 +57,27 @@ Task createTask(
     const FrameworkID& frameworkId);
 
 
+// Returns the status with only the fields that the master uses from
+// the statuses of a task, i.e., the state and timestamp (exposed by
+// the endpoints), the health (see 'getTaskHealth') and the source
+// and reason. The other fields are either potentially large, e.g.,
+// the data (see MESOS-1746) and the message, or duplicate fields of
+// the task, while the master keeps the statuses of all its tasks.
+TaskStatus createTaskStatusSummary(const TaskStatus& status);
+
+
 Option<bool> getTaskHealth(const Task& task);
 
 
 // Helper function that creates a MasterInfo from UPID.
 MasterInfo createMasterInfo(const process::UPID& pid);
 
+
+// Returns the offers of the message, with the attributes of the
+// slaves added back to the offers of a compact message (see the
+// COMPACT_OFFERS framework capability).
+std::vector<Offer> getOffers(const ResourceOffersMessage& message);
+
 } // namespace protobuf {
 } // namespace internal {
 } // namespace mesos {
@@ -0,0 +1,129 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __COMMON_RECORDIO_HPP__
+#define __COMMON_RECORDIO_HPP__
+
+#include <algorithm>
+#include <deque>
+#include <string>
+
+#include <stout/error.hpp>
+#include <stout/numify.hpp>
+#include <stout/stringify.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace recordio {
+
+// The "recordio" format frames each record with its length in bytes,
+// in decimal, followed by a newline:
+//
+//   <length>\n<record><length>\n<record>...
+//
+// This is used to delimit the records (e.g., scheduler events) that
+// are streamed as the chunked body of an HTTP response. Note that the
+// chunk boundaries need not align with the record boundaries.
+inline std::string encode(const std::string& record)
+{
+  return stringify(record.size()) + "\n" + record;
+}
+
+
+// Incrementally decodes the records from the data as it arrives.
+class Decoder
+{
+public:
+  Decoder() : state(HEADER), length(0) {}
+
+  // Returns the records that were completed by 'data', or an Error
+  // if the data is not in the recordio format, after which the
+  // decoder is no longer usable.
+  Try<std::deque<std::string>> decode(const std::string& data)
+  {
+    if (state == FAILED) {
+      return Error("Decoder is in a failed state");
+    }
+
+    std::deque<std::string> records;
+
+    size_t position = 0;
+
+    while (position < data.size()) {
+      if (state == HEADER) {
+        size_t newline = data.find('\n', position);
+
+        if (newline == std::string::npos) {
+          buffer.append(data, position, std::string::npos);
+          break;
+        }
+
+        buffer.append(data, position, newline - position);
+        position = newline + 1;
+
+        Try<size_t> numify = ::numify<size_t>(buffer);
+        if (numify.isError()) {
+          state = FAILED;
+          return Error("Failed to decode length '" + buffer + "': " +
+                       numify.error());
+        }
+
+        buffer.clear();
+        length = numify.get();
+        state = RECORD;
+      }
+
+      if (state == RECORD) {
+        size_t remaining = length - buffer.size();
+        size_t available = std::min(remaining, data.size() - position);
+
+        buffer.append(data, position, available);
+        position += available;
+
+        if (buffer.size() == length) {
+          records.push_back(buffer);
+          buffer.clear();
+          state = HEADER;
+        }
+      }
+    }
+
+    return records;
+  }
+
+private:
+  enum
+  {
+    HEADER,
+    RECORD,
+    FAILED
+  } state;
+
+  // The partial length (HEADER) or record (RECORD) read so far.
+  std::string buffer;
+
+  // The length of the record being read (RECORD).
+  size_t length;
+};
+
+} // namespace recordio {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __COMMON_RECORDIO_HPP__
@@ -140,8 +140,10 @@ bool operator != (const Resource& left, const Resource& right)
 // different name, type or role are not addable.
 static bool addable(const Resource& left, const Resource& right)
 {
-  if (left.name() != right.name() ||
-      left.type() != right.type() ||
+  // NOTE: We compare the type first as it's cheaper than comparing
+  // the name or the role.
+  if (left.type() != right.type() ||
+      left.name() != right.name() ||
       left.role() != right.role()) {
     return false;
   }
@@ -191,8 +193,10 @@ static bool addable(const Resource& left, const Resource& right)
 // contain "right".
 static bool subtractable(const Resource& left, const Resource& right)
 {
-  if (left.name() != right.name() ||
-      left.type() != right.type() ||
+  // NOTE: We compare the type first as it's cheaper than comparing
+  // the name or the role.
+  if (left.type() != right.type() ||
+      left.name() != right.name() ||
       left.role() != right.role()) {
     return false;
   }
@@ -482,6 +486,21 @@ Option<Error> Resources::validate(
 }
 
 
+Resources Resources::trusted(
+    const google::protobuf::RepeatedPtrField<Resource>& _resources)
+{
+  Resources result;
+
+  foreach (const Resource& resource, _resources) {
+    if (!isEmpty(resource)) {
+      result._add(resource);
+    }
+  }
+
+  return result;
+}
+
+
 bool Resources::isEmpty(const Resource& resource)
 {
   if (resource.type() == Value::SCALAR) {
@@ -564,17 +583,43 @@ Resources::Resources(
 
 bool Resources::contains(const Resources& that) const
 {
+  // Resource objects are kept combined whenever possible, so unless
+  // 'that' has persistent volumes (which never get combined) no two
+  // Resource objects in 'that' can be subtracted from the same
+  // Resource object in these Resources. In that case we can check
+  // each one individually and avoid copying these Resources.
+  bool combined = true;
+  foreach (const Resource& resource, that.resources) {
+    if (isPersistentVolume(resource)) {
+      combined = false;
+      break;
+    }
+  }
+
+  if (combined) {
+    foreach (const Resource& resource, that.resources) {
+      // NOTE: We use _contains because Resources only contain valid
+      // Resource objects, and we don't want the performance hit of
+      // the validity check.
+      if (!_contains(resource)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   Resources remaining = *this;
 
   foreach (const Resource& resource, that.resources) {
-    // NOTE: We use _contains because Resources only contain valid
-    // Resource objects, and we don't want the performance hit of the
-    // validity check.
+    // NOTE: We use _contains and _subtract because Resources only
+    // contain valid Resource objects, and we don't want the
+    // performance hit of the validity check.
     if (!remaining._contains(resource)) {
       return false;
     }
 
-    remaining -= resource;
+    remaining._subtract(resource);
   }
 
   return true;
@@ -1036,19 +1081,7 @@ Resources Resources::operator + (const Resources& that) const
 Resources& Resources::operator += (const Resource& that)
 {
   if (validate(that).isNone() && !isEmpty(that)) {
-    bool found = false;
-    foreach (Resource& resource, resources) {
-      if (addable(resource, that)) {
-        resource += that;
-        found = true;
-        break;
-      }
-    }
-
-    // Cannot be combined with any existing Resource object.
-    if (!found) {
-      resources.Add()->CopyFrom(that);
-    }
+    _add(that);
   }
 
   return *this;
@@ -1057,8 +1090,10 @@ Resources& Resources::operator += (const Resource& that)
 
 Resources& Resources::operator += (const Resources& that)
 {
+  // NOTE: The Resource objects in 'that' are already known to be
+  // valid and non-empty so we skip the validity check.
   foreach (const Resource& resource, that.resources) {
-    *this += resource;
+    _add(resource);
   }
 
   return *this;
@@ -1084,22 +1119,7 @@ Resources Resources::operator - (const Resources& that) const
 Resources& Resources::operator -= (const Resource& that)
 {
   if (validate(that).isNone() && !isEmpty(that)) {
-    for (int i = 0; i < resources.size(); i++) {
-      Resource* resource = resources.Mutable(i);
-
-      if (subtractable(*resource, that)) {
-        *resource -= that;
-
-        // Remove the resource if it becomes invalid or zero. We need
-        // to do the validation because we want to strip negative
-        // scalar Resource object.
-        if (validate(*resource).isSome() || isEmpty(*resource)) {
-          resources.DeleteSubrange(i, 1);
-        }
-
-        break;
-      }
-    }
+    _subtract(that);
   }
 
   return *this;
@@ -1108,14 +1128,57 @@ Resources& Resources::operator -= (const Resource& that)
 
 Resources& Resources::operator -= (const Resources& that)
 {
+  // NOTE: The Resource objects in 'that' are already known to be
+  // valid and non-empty so we skip the validity check.
   foreach (const Resource& resource, that.resources) {
-    *this -= resource;
+    _subtract(resource);
   }
 
   return *this;
 }
 
 
+void Resources::_add(const Resource& that)
+{
+  foreach (Resource& resource, resources) {
+    if (addable(resource, that)) {
+      resource += that;
+      return;
+    }
+  }
+
+  // Cannot be combined with any existing Resource object.
+  resources.Add()->CopyFrom(that);
+}
+
+
+void Resources::_subtract(const Resource& that)
+{
+  for (int i = 0; i < resources.size(); i++) {
+    Resource* resource = resources.Mutable(i);
+
+    if (subtractable(*resource, that)) {
+      *resource -= that;
+
+      // Remove the resource if it becomes invalid or zero. We need
+      // to do the validation because we want to strip negative
+      // scalar Resource object. For scalars (by far the most common
+      // case) that is equivalent to checking the value, which saves
+      // us the cost of a full validation.
+      if (resource->type() == Value::SCALAR) {
+        if (resource->scalar().value() <= 0) {
+          resources.DeleteSubrange(i, 1);
+        }
+      } else if (validate(*resource).isSome() || isEmpty(*resource)) {
+        resources.DeleteSubrange(i, 1);
+      }
+
+      break;
+    }
+  }
+}
+
+
 ostream& operator << (ostream& stream, const Volume& volume) {
   string volumeConfig = volume.container_path();
 
@@ -0,0 +1,65 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/result.hpp>
+
+#include "common/token.hpp"
+
+using std::string;
+
+namespace mesos {
+namespace internal {
+
+Try<string> generateToken(size_t size)
+{
+  Try<int> fd = os::open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+  if (fd.isError()) {
+    return Error("Failed to open /dev/urandom: " + fd.error());
+  }
+
+  Result<string> bytes = os::read(fd.get(), size);
+
+  os::close(fd.get());
+
+  if (!bytes.isSome() || bytes.get().size() != size) {
+    return Error(
+        "Failed to read /dev/urandom: " +
+        (bytes.isError() ? bytes.error() : "unexpected end of file"));
+  }
+
+  std::ostringstream out;
+  out << std::hex << std::setfill('0');
+
+  foreach (unsigned char c, bytes.get()) {
+    out << std::setw(2) << static_cast<int>(c);
+  }
+
+  return out.str();
+}
+
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,40 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TOKEN_HPP__
+#define __TOKEN_HPP__
+
+#include <stddef.h>
+
+#include <string>
+
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+
+// Returns 'size' random bytes, hex encoded, read from /dev/urandom.
+// Unlike a UUID::random(), which comes from a seeded Mersenne Twister,
+// such a token can't be predicted from the ones seen before, i.e., it
+// can be handed out as a credential (e.g., a session ID).
+Try<std::string> generateToken(size_t size = 16);
+
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __TOKEN_HPP__
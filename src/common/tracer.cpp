@@ -0,0 +1,179 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+#include <process/clock.hpp>
+
+#include <stout/foreach.hpp>
+
+#include "common/tracer.hpp"
+
+using std::string;
+
+using process::Clock;
+using process::Time;
+
+namespace mesos {
+namespace internal {
+
+Tracer::Tracer(double _samplingRate, size_t _capacity)
+  : samplingRate(_samplingRate),
+    capacity(_capacity),
+    generator(std::random_device()()),
+    distribution(0.0, 1.0),
+    traced(0),
+    spans(_capacity) {}
+
+
+Option<uint64_t> Tracer::sample()
+{
+  if (samplingRate <= 0.0 || distribution(generator) >= samplingRate) {
+    return None();
+  }
+
+  // Zero is never used as a trace ID, so it can't be mistaken for an
+  // unset one.
+  uint64_t id;
+  do {
+    id = generator();
+  } while (id == 0);
+
+  return id;
+}
+
+
+void Tracer::start(
+    const FrameworkID& frameworkId,
+    const TaskID& taskId,
+    uint64_t traceId,
+    const Time& time)
+{
+  if (traced >= capacity || get(frameworkId, taskId).isSome()) {
+    return;
+  }
+
+  Trace trace;
+  trace.id = traceId;
+  trace.time = time;
+
+  traces[frameworkId][taskId] = trace;
+  traced++;
+}
+
+
+void Tracer::record(
+    const FrameworkID& frameworkId,
+    const TaskID& taskId,
+    const string& name)
+{
+  auto framework = traces.find(frameworkId);
+  if (framework == traces.end()) {
+    return;
+  }
+
+  auto it = framework->second.find(taskId);
+  if (it == framework->second.end()) {
+    return;
+  }
+
+  Trace& trace = it->second;
+
+  Span span;
+  span.traceId = trace.id;
+  span.name = name;
+  span.frameworkId = frameworkId;
+  span.taskId = taskId;
+  span.start = trace.time;
+  span.end = Clock::now();
+
+  trace.time = span.end;
+
+  spans.push_back(std::move(span));
+}
+
+
+void Tracer::stop(const FrameworkID& frameworkId, const TaskID& taskId)
+{
+  if (traces.contains(frameworkId) &&
+      traces[frameworkId].erase(taskId) > 0) {
+    traced--;
+
+    if (traces[frameworkId].empty()) {
+      traces.erase(frameworkId);
+    }
+  }
+}
+
+
+void Tracer::stop(const FrameworkID& frameworkId)
+{
+  if (traces.contains(frameworkId)) {
+    traced -= traces[frameworkId].size();
+    traces.erase(frameworkId);
+  }
+}
+
+
+Option<uint64_t> Tracer::get(
+    const FrameworkID& frameworkId,
+    const TaskID& taskId) const
+{
+  auto framework = traces.find(frameworkId);
+  if (framework == traces.end()) {
+    return None();
+  }
+
+  auto trace = framework->second.find(taskId);
+  if (trace == framework->second.end()) {
+    return None();
+  }
+
+  return trace->second.id;
+}
+
+
+JSON::Object Tracer::json() const
+{
+  JSON::Array array;
+
+  foreach (const Span& span, spans) {
+    std::ostringstream traceId;
+    traceId << std::hex << std::setw(16) << std::setfill('0') << span.traceId;
+
+    JSON::Object object;
+    object.values["trace_id"] = traceId.str();
+    object.values["name"] = span.name;
+    object.values["framework_id"] = span.frameworkId.value();
+    object.values["task_id"] = span.taskId.value();
+    object.values["start"] = span.start.secs();
+    object.values["duration_ns"] = (span.end - span.start).ns();
+
+    array.values.push_back(std::move(object));
+  }
+
+  JSON::Object object;
+  object.values["spans"] = std::move(array);
+
+  return object;
+}
+
+} // namespace internal {
+} // namespace mesos {
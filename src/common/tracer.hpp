@@ -0,0 +1,121 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TRACER_HPP__
+#define __TRACER_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <random>
+#include <string>
+
+#include <boost/circular_buffer.hpp>
+
+#include <mesos/mesos.hpp>
+#include <mesos/type_utils.hpp>
+
+#include <process/time.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/option.hpp>
+
+namespace mesos {
+namespace internal {
+
+// Follows a sample of the task launches through the master and the
+// slave. A trace is started for a task by the master, which passes
+// its ID on to the slave along with the task. Both then record the
+// stages of the launch as spans of the trace, until the task is
+// running (or terminal).
+//
+// The spans of a task follow each other, i.e., a span starts when
+// the previous one (or the trace) started and is named after what
+// happened in between. The most recent spans are kept in a ring
+// buffer of 'capacity' spans.
+class Tracer
+{
+public:
+  struct Span
+  {
+    uint64_t traceId;
+    std::string name;
+    FrameworkID frameworkId;
+    TaskID taskId;
+    process::Time start;
+    process::Time end;
+  };
+
+  // Traces are sampled with probability 'samplingRate' (see
+  // 'sample()'). No more than 'capacity' tasks are traced at once.
+  explicit Tracer(double samplingRate = 0.0, size_t capacity = 10000);
+
+  // Returns the ID of a new trace if the next launch is sampled.
+  Option<uint64_t> sample();
+
+  // Starts tracing the task with the given trace ID, unless the task
+  // is traced already.
+  void start(
+      const FrameworkID& frameworkId,
+      const TaskID& taskId,
+      uint64_t traceId,
+      const process::Time& time);
+
+  // Records the span of the traced task that ends now, if the task
+  // is traced.
+  void record(
+      const FrameworkID& frameworkId,
+      const TaskID& taskId,
+      const std::string& name);
+
+  // Stops tracing the task, or all the tasks of the framework.
+  void stop(const FrameworkID& frameworkId, const TaskID& taskId);
+  void stop(const FrameworkID& frameworkId);
+
+  // Returns the ID of the trace of the task, if the task is traced.
+  Option<uint64_t> get(
+      const FrameworkID& frameworkId,
+      const TaskID& taskId) const;
+
+  // Returns the recorded spans, oldest first.
+  JSON::Object json() const;
+
+private:
+  struct Trace
+  {
+    uint64_t id;
+    process::Time time; // The end of the last span.
+  };
+
+  const double samplingRate;
+  const size_t capacity;
+
+  std::mt19937_64 generator;
+  std::uniform_real_distribution<double> distribution;
+
+  hashmap<FrameworkID, hashmap<TaskID, Trace>> traces;
+  size_t traced; // The number of traced tasks.
+
+  boost::circular_buffer<Span> spans;
+};
+
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __TRACER_HPP__
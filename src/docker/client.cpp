@@ -0,0 +1,792 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <queue>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
+#include <process/io.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/json.hpp>
+#include <stout/lambda.hpp>
+#include <stout/multihashmap.hpp>
+#include <stout/none.hpp>
+#include <stout/nothing.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/strings.hpp>
+
+#include "docker/client.hpp"
+
+using namespace process;
+
+using std::queue;
+using std::string;
+using std::vector;
+
+
+// The size of the buffer used to read responses.
+static const size_t BUFFER_SIZE = 64 * 1024;
+
+
+// Connects to the daemon listening on 'socket', returning a
+// non-blocking file descriptor for the connection.
+static Try<int> connect(const string& socket)
+{
+  struct sockaddr_un address;
+  if (socket.size() >= sizeof(address.sun_path)) {
+    return Error("Socket path '" + socket + "' is too long");
+  }
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, socket.c_str(), sizeof(address.sun_path) - 1);
+
+  int s = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (s == -1) {
+    return ErrnoError("Failed to create socket");
+  }
+
+  // Connecting to a UNIX socket does not block (unless the backlog
+  // of the daemon is full), hence we connect before setting the
+  // socket non-blocking.
+  if (::connect(s, (struct sockaddr*) &address, sizeof(address)) == -1) {
+    ErrnoError error("Failed to connect to '" + socket + "'");
+    os::close(s);
+    return error;
+  }
+
+  Try<Nothing> nonblock = os::nonblock(s);
+  if (nonblock.isError()) {
+    os::close(s);
+    return Error("Failed to set socket non-blocking: " + nonblock.error());
+  }
+
+  Try<Nothing> cloexec = os::cloexec(s);
+  if (cloexec.isError()) {
+    os::close(s);
+    return Error("Failed to cloexec socket: " + cloexec.error());
+  }
+
+  return s;
+}
+
+
+class DockerClientProcess : public Process<DockerClientProcess>
+{
+public:
+  explicit DockerClientProcess(const string& _socket)
+    : ProcessBase(ID::generate("docker-client")),
+      socket(_socket),
+      busy(false),
+      reused(false),
+      retried(false),
+      buffer(new char[BUFFER_SIZE]) {}
+
+  virtual ~DockerClientProcess()
+  {
+    delete[] buffer;
+  }
+
+  Future<http::Response> send(const string& request)
+  {
+    Owned<Request> pending(new Request(request));
+    requests.push(pending);
+
+    if (!busy) {
+      next();
+    }
+
+    return pending->promise.future();
+  }
+
+protected:
+  virtual void finalize()
+  {
+    disconnect();
+
+    while (!requests.empty()) {
+      requests.front()->promise.fail("Docker client terminated");
+      requests.pop();
+    }
+  }
+
+private:
+  struct Request
+  {
+    explicit Request(const string& _data) : data(_data) {}
+
+    const string data;
+    Promise<http::Response> promise;
+  };
+
+  // Sends the next request, if any.
+  void next()
+  {
+    // Skip the requests nobody is interested in any longer.
+    while (!requests.empty() &&
+           requests.front()->promise.future().hasDiscard()) {
+      requests.front()->promise.discard();
+      requests.pop();
+    }
+
+    if (requests.empty()) {
+      busy = false;
+      return;
+    }
+
+    busy = true;
+
+    if (fd.isNone()) {
+      Try<int> connected = connect(socket);
+      if (connected.isError()) {
+        fail(connected.error());
+        return;
+      }
+
+      fd = connected.get();
+      reused = false;
+    }
+
+    writing = io::write(fd.get(), requests.front()->data);
+    writing.onAny(defer(self(), &Self::written, lambda::_1));
+  }
+
+  void written(const Future<Nothing>& future)
+  {
+    if (!future.isReady()) {
+      retry("Failed to send request: " +
+            (future.isFailed() ? future.failure() : "discarded"));
+      return;
+    }
+
+    read();
+  }
+
+  void read()
+  {
+    reading = io::read(fd.get(), buffer, BUFFER_SIZE);
+    reading.onAny(defer(self(), &Self::_read, lambda::_1));
+  }
+
+  void _read(const Future<size_t>& length)
+  {
+    if (!length.isReady()) {
+      retry("Failed to receive response: " +
+            (length.isFailed() ? length.failure() : "discarded"));
+      return;
+    }
+
+    bool eof = length.get() == 0;
+
+    if (eof && data.empty()) {
+      // The daemon might have closed an idle connection before
+      // receiving the request.
+      retry("Connection closed by the docker daemon");
+      return;
+    }
+
+    data.append(buffer, length.get());
+
+    Result<http::Response> response = DockerClient::parse(&data, eof);
+
+    if (response.isError()) {
+      disconnect();
+      fail("Failed to parse response: " + response.error());
+      return;
+    } else if (response.isNone()) {
+      read();
+      return;
+    }
+
+    // Keep the connection unless the daemon asked us to close it.
+    Option<string> connection = response.get().headers.get("Connection");
+    if (eof ||
+        (connection.isSome() &&
+         strings::lower(connection.get()) == "close")) {
+      disconnect();
+    } else {
+      reused = true;
+    }
+
+    retried = false;
+
+    requests.front()->promise.set(response.get());
+    requests.pop();
+
+    next();
+  }
+
+  // Retries the current request on a new connection if the failure
+  // might have been caused by reusing a connection that the daemon
+  // has closed meanwhile, otherwise fails it.
+  void retry(const string& message)
+  {
+    bool retry = reused && !retried && data.empty();
+
+    disconnect();
+
+    if (retry) {
+      retried = true;
+      next();
+    } else {
+      fail(message);
+    }
+  }
+
+  // Fails the current request and continues with the next one.
+  void fail(const string& message)
+  {
+    retried = false;
+
+    requests.front()->promise.fail(message);
+    requests.pop();
+
+    next();
+  }
+
+  void disconnect()
+  {
+    // Make sure nothing is written to (or read into 'buffer') once
+    // the file descriptor is closed (and possibly reused).
+    writing.discard();
+    reading.discard();
+
+    if (fd.isSome()) {
+      os::close(fd.get());
+      fd = None();
+    }
+
+    data.clear();
+  }
+
+  const string socket;
+
+  queue<Owned<Request>> requests;
+
+  // Whether a request is outstanding.
+  bool busy;
+
+  // The connection to the daemon, if any.
+  Option<int> fd;
+
+  // Whether the connection has already served a response.
+  bool reused;
+
+  // Whether the current request has been retried.
+  bool retried;
+
+  // The outstanding I/O on the connection, if any.
+  Future<Nothing> writing;
+  Future<size_t> reading;
+
+  // The received data that has not been parsed yet.
+  string data;
+
+  char* buffer;
+};
+
+
+// The process that receives the events of the daemon and notifies
+// those waiting for events of specific containers.
+class DockerEventsProcess : public Process<DockerEventsProcess>
+{
+public:
+  explicit DockerEventsProcess(const string& _socket)
+    : ProcessBase(ID::generate("docker-events")),
+      socket(_socket),
+      headers(false),
+      chunked(false),
+      buffer(new char[BUFFER_SIZE]) {}
+
+  virtual ~DockerEventsProcess()
+  {
+    delete[] buffer;
+  }
+
+  Future<Nothing> changed(const string& container)
+  {
+    if (fd.isNone()) {
+      Try<int> connected = connect(socket);
+      if (connected.isError()) {
+        return Failure("Failed to subscribe to events: " + connected.error());
+      }
+
+      fd = connected.get();
+
+      writing = io::write(
+          fd.get(),
+          "GET /events HTTP/1.1\r\n"
+          "Host: docker\r\n"
+          "\r\n");
+
+      writing.onAny(defer(self(), &Self::written, lambda::_1));
+    }
+
+    // Forget about those that are no longer interested.
+    foreach (const Owned<Promise<Nothing>>& promise, waiters.get(container)) {
+      if (promise->future().hasDiscard()) {
+        promise->discard();
+        waiters.remove(container, promise);
+      }
+    }
+
+    Owned<Promise<Nothing>> promise(new Promise<Nothing>());
+    waiters.put(container, promise);
+
+    return promise->future();
+  }
+
+protected:
+  virtual void finalize()
+  {
+    close(false, "Docker client terminated");
+  }
+
+private:
+  void written(const Future<Nothing>& future)
+  {
+    if (!future.isReady()) {
+      close(false, "Failed to subscribe to events: " +
+            (future.isFailed() ? future.failure() : "discarded"));
+      return;
+    }
+
+    read();
+  }
+
+  void read()
+  {
+    reading = io::read(fd.get(), buffer, BUFFER_SIZE);
+    reading.onAny(defer(self(), &Self::_read, lambda::_1));
+  }
+
+  void _read(const Future<size_t>& length)
+  {
+    if (!length.isReady()) {
+      close(false, "Failed to receive events: " +
+            (length.isFailed() ? length.failure() : "discarded"));
+      return;
+    } else if (length.get() == 0) {
+      // We might have missed events once the stream is closed, so
+      // everyone waiting should check again.
+      close(true, "Events stream closed");
+      return;
+    }
+
+    data.append(buffer, length.get());
+
+    Try<Nothing> decoded = decode();
+    if (decoded.isError()) {
+      close(false, "Failed to receive events: " + decoded.error());
+      return;
+    }
+
+    notify();
+
+    read();
+  }
+
+  // Decodes the received data into 'events'.
+  Try<Nothing> decode()
+  {
+    if (!headers) {
+      size_t end = data.find("\r\n\r\n");
+      if (end == string::npos) {
+        return Nothing();
+      }
+
+      vector<string> lines = strings::tokenize(data.substr(0, end), "\r\n");
+      if (lines.empty() || strings::split(lines[0], " ").size() < 2) {
+        return Error("Malformed status line");
+      } else if (strings::split(lines[0], " ")[1] != "200") {
+        return Error("Unexpected status line '" + lines[0] + "'");
+      }
+
+      for (size_t i = 1; i < lines.size(); i++) {
+        if (strings::startsWith(strings::lower(lines[i]), "transfer-encoding:")) {
+          chunked = strings::contains(strings::lower(lines[i]), "chunked");
+        }
+      }
+
+      data.erase(0, end + 4);
+      headers = true;
+    }
+
+    if (!chunked) {
+      events.append(data);
+      data.clear();
+      return Nothing();
+    }
+
+    while (true) {
+      size_t crlf = data.find("\r\n");
+      if (crlf == string::npos) {
+        return Nothing();
+      }
+
+      const string line = data.substr(0, crlf);
+      char* last;
+      unsigned long size = ::strtoul(line.c_str(), &last, 16);
+      if (last == line.c_str()) {
+        return Error("Malformed chunk size '" + line + "'");
+      }
+
+      // Wait for the daemon to close the connection after the last
+      // chunk.
+      if (size == 0 || data.size() < crlf + 2 + size + 2) {
+        return Nothing();
+      }
+
+      events.append(data, crlf + 2, size);
+      data.erase(0, crlf + 2 + size + 2);
+    }
+  }
+
+  // Notifies those waiting for the containers of the complete events
+  // received so far. The events are a sequence of JSON objects.
+  void notify()
+  {
+    size_t depth = 0;
+    bool quoted = false;
+    bool escaped = false;
+    size_t start = 0;
+    size_t consumed = 0;
+
+    for (size_t i = 0; i < events.size(); i++) {
+      const char c = events[i];
+
+      if (quoted) {
+        if (escaped) {
+          escaped = false;
+        } else if (c == '\\') {
+          escaped = true;
+        } else if (c == '"') {
+          quoted = false;
+        }
+      } else if (c == '"') {
+        quoted = true;
+      } else if (c == '{') {
+        if (depth++ == 0) {
+          start = i;
+        }
+      } else if (c == '}' && depth > 0 && --depth == 0) {
+        notify(events.substr(start, i - start + 1));
+        consumed = i + 1;
+      }
+    }
+
+    events.erase(0, consumed);
+  }
+
+  void notify(const string& event)
+  {
+    Try<JSON::Object> object = JSON::parse<JSON::Object>(event);
+    if (object.isError()) {
+      LOG(WARNING) << "Ignoring malformed docker event '" << event << "': "
+                   << object.error();
+      return;
+    }
+
+    // Depending on the version of the daemon the container is either
+    // 'id' or the 'Actor', which also includes the name.
+    const char* keys[] = { "id", "Actor.ID", "Actor.Attributes.name" };
+
+    foreach (const char* key, keys) {
+      Result<JSON::String> container = object.get().find<JSON::String>(key);
+      if (container.isSome()) {
+        foreach (const Owned<Promise<Nothing>>& promise,
+                 waiters.get(container.get().value)) {
+          promise->set(Nothing());
+        }
+        waiters.remove(container.get().value);
+      }
+    }
+  }
+
+  // Closes the events stream and either satisfies or fails the
+  // futures of everyone waiting.
+  void close(bool satisfy, const string& message)
+  {
+    writing.discard();
+    reading.discard();
+
+    if (fd.isSome()) {
+      os::close(fd.get());
+      fd = None();
+    }
+
+    headers = false;
+    chunked = false;
+    data.clear();
+    events.clear();
+
+    foreachvalue (const Owned<Promise<Nothing>>& promise, waiters) {
+      if (satisfy) {
+        promise->set(Nothing());
+      } else {
+        promise->fail(message);
+      }
+    }
+
+    waiters.clear();
+  }
+
+  const string socket;
+
+  // Those waiting for events, by container name or id.
+  multihashmap<string, Owned<Promise<Nothing>>> waiters;
+
+  // The connection receiving the events, if any.
+  Option<int> fd;
+
+  // The outstanding I/O on the connection, if any.
+  Future<Nothing> writing;
+  Future<size_t> reading;
+
+  // Whether the headers of the response have been received and
+  // whether the body is chunked.
+  bool headers;
+  bool chunked;
+
+  // The received data that has not been decoded yet.
+  string data;
+
+  // The decoded events that have not been handled yet.
+  string events;
+
+  char* buffer;
+};
+
+
+DockerClient::DockerClient(const string& socket)
+{
+  process = new DockerClientProcess(socket);
+  spawn(process);
+
+  events = new DockerEventsProcess(socket);
+  spawn(events);
+}
+
+
+DockerClient::~DockerClient()
+{
+  terminate(events);
+  wait(events);
+  delete events;
+
+  terminate(process);
+  wait(process);
+  delete process;
+}
+
+
+Future<http::Response> DockerClient::get(const string& path) const
+{
+  return send("GET", path);
+}
+
+
+Future<http::Response> DockerClient::post(const string& path) const
+{
+  return send("POST", path);
+}
+
+
+Future<http::Response> DockerClient::del(const string& path) const
+{
+  return send("DELETE", path);
+}
+
+
+Future<Nothing> DockerClient::changed(const string& container) const
+{
+  return dispatch(events, &DockerEventsProcess::changed, container);
+}
+
+
+Future<http::Response> DockerClient::send(
+    const string& method,
+    const string& path) const
+{
+  string request =
+    method + " " + path + " HTTP/1.1\r\n"
+    "Host: docker\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+  return dispatch(process, &DockerClientProcess::send, request);
+}
+
+
+Result<http::Response> DockerClient::parse(string* data, bool eof)
+{
+  size_t end = data->find("\r\n\r\n");
+  if (end == string::npos) {
+    if (eof) {
+      return Error("Connection closed while receiving headers");
+    }
+    return None();
+  }
+
+  vector<string> lines = strings::tokenize(data->substr(0, end), "\r\n");
+  if (lines.empty()) {
+    return Error("Missing status line");
+  }
+
+  // The status line, e.g., 'HTTP/1.1 200 OK'.
+  vector<string> status = strings::split(lines[0], " ", 2);
+  if (status.size() != 2 || !strings::startsWith(status[0], "HTTP/")) {
+    return Error("Malformed status line '" + lines[0] + "'");
+  }
+
+  http::Response response;
+  response.type = http::Response::BODY;
+  response.status = status[1];
+
+  Try<int> code = numify<int>(strings::split(status[1], " ")[0]);
+  if (code.isError()) {
+    return Error("Malformed status line '" + lines[0] + "'");
+  }
+
+  Option<string> contentLength;
+  bool chunked = false;
+
+  for (size_t i = 1; i < lines.size(); i++) {
+    size_t colon = lines[i].find(':');
+    if (colon == string::npos) {
+      return Error("Malformed header '" + lines[i] + "'");
+    }
+
+    const string name = strings::trim(lines[i].substr(0, colon));
+    const string value = strings::trim(lines[i].substr(colon + 1));
+
+    response.headers[name] = value;
+
+    if (strings::lower(name) == "content-length") {
+      contentLength = value;
+    } else if (strings::lower(name) == "transfer-encoding") {
+      chunked = strings::lower(value) == "chunked";
+    }
+  }
+
+  // The offset of the body.
+  size_t offset = end + 4;
+
+  if (chunked) {
+    string body;
+
+    while (true) {
+      size_t crlf = data->find("\r\n", offset);
+      if (crlf == string::npos) {
+        break;
+      }
+
+      // Ignore any chunk extensions.
+      const string line = data->substr(offset, crlf - offset);
+      char* last;
+      unsigned long size = ::strtoul(line.c_str(), &last, 16);
+      if (last == line.c_str()) {
+        return Error("Malformed chunk size '" + line + "'");
+      }
+
+      if (size == 0) {
+        // Skip any trailers.
+        size_t trailers = data->find("\r\n", crlf + 2);
+        while (trailers != string::npos && trailers != crlf + 2) {
+          crlf = trailers;
+          trailers = data->find("\r\n", crlf + 2);
+        }
+
+        if (trailers == string::npos) {
+          break;
+        }
+
+        response.body = body;
+        data->erase(0, trailers + 2);
+        return response;
+      }
+
+      if (data->size() < crlf + 2 + size + 2) {
+        break;
+      }
+
+      body.append(*data, crlf + 2, size);
+      offset = crlf + 2 + size + 2;
+    }
+
+    if (eof) {
+      return Error("Connection closed while receiving chunks");
+    }
+
+    return None();
+  }
+
+  if (contentLength.isSome()) {
+    Try<size_t> length = numify<size_t>(contentLength.get());
+    if (length.isError()) {
+      return Error("Malformed Content-Length '" + contentLength.get() + "'");
+    }
+
+    if (data->size() < offset + length.get()) {
+      if (eof) {
+        return Error("Connection closed while receiving body");
+      }
+      return None();
+    }
+
+    response.body = data->substr(offset, length.get());
+    data->erase(0, offset + length.get());
+    return response;
+  }
+
+  // These responses never have a body.
+  if ((code.get() >= 100 && code.get() < 200) ||
+      code.get() == 204 ||
+      code.get() == 304) {
+    data->erase(0, offset);
+    return response;
+  }
+
+  // Otherwise the body is delimited by the end of the connection.
+  if (!eof) {
+    return None();
+  }
+
+  response.body = data->substr(offset);
+  data->clear();
+
+  // There is no more connection to keep alive.
+  response.headers["Connection"] = "close";
+
+  return response;
+}
@@ -0,0 +1,80 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __DOCKER_CLIENT_HPP__
+#define __DOCKER_CLIENT_HPP__
+
+#include <string>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
+
+#include <stout/nothing.hpp>
+#include <stout/result.hpp>
+
+// Forward declarations.
+class DockerClientProcess;
+class DockerEventsProcess;
+
+
+// A client for the remote API of the Docker daemon, which is served
+// over HTTP on a UNIX socket. The client keeps a single connection
+// to the daemon open and sends the requests over it one at a time
+// (HTTP/1.1 keep-alive), reconnecting when the daemon closes it.
+// Events are received over a second connection, which is opened
+// once someone waits for an event.
+class DockerClient
+{
+public:
+  explicit DockerClient(const std::string& socket);
+  ~DockerClient();
+
+  // Sends a request with an empty body for the given 'path' (which
+  // may include a query) and returns the response, whatever its
+  // status. The response body is always of type BODY.
+  process::Future<process::http::Response> get(const std::string& path) const;
+  process::Future<process::http::Response> post(const std::string& path) const;
+  process::Future<process::http::Response> del(const std::string& path) const;
+
+  // Returns a future that is satisfied once the daemon reports an
+  // event (e.g., 'create', 'start' or 'die') for the container with
+  // the given name or id, or once the events stream has been closed,
+  // i.e., when the container should be inspected again. The future
+  // fails if the events can not be received. Discard the future if
+  // no longer interested.
+  process::Future<Nothing> changed(const std::string& container) const;
+
+  // Parses a single HTTP response from the front of 'data', removing
+  // it from 'data'. Returns None if more data is needed, where 'eof'
+  // tells whether the connection has been closed (i.e., no more data
+  // will arrive). Exposed for testing.
+  static Result<process::http::Response> parse(std::string* data, bool eof);
+
+private:
+  DockerClient(const DockerClient&);
+  DockerClient& operator = (const DockerClient&);
+
+  process::Future<process::http::Response> send(
+      const std::string& method,
+      const std::string& path) const;
+
+  DockerClientProcess* process;
+  DockerEventsProcess* events;
+};
+
+#endif // __DOCKER_CLIENT_HPP__
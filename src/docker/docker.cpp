@@ -20,6 +20,7 @@
 #include <vector>
 
 #include <stout/lambda.hpp>
+#include <stout/numify.hpp>
 #include <stout/os.hpp>
 #include <stout/result.hpp>
 #include <stout/strings.hpp>
@@ -28,6 +29,7 @@
 
 #include <process/check.hpp>
 #include <process/collect.hpp>
+#include <process/http.hpp>
 #include <process/io.hpp>
 
 #include "common/status_utils.hpp"
@@ -87,6 +89,34 @@ static Future<Nothing> _checkError(const string& cmd, const Subprocess& s)
 }
 
 
+// Returns the status code of a response from the remote API.
+static int code(const http::Response& response)
+{
+  Try<int> code = numify<int>(strings::split(response.status, " ")[0]);
+  return code.isSome() ? code.get() : 0;
+}
+
+
+// Returns a failure describing an unexpected response from the
+// remote API for the given request.
+template <typename T>
+static Future<T> unexpected(
+    const string& request,
+    const http::Response& response)
+{
+  return Failure(
+      "Failed to '" + request + "': status = " + response.status +
+      " message = " + strings::trim(response.body));
+}
+
+
+// Returns the path of a container in the remote API.
+static string containerPath(const string& containerName)
+{
+  return "/containers/" + http::encode(containerName);
+}
+
+
 // Returns a failure if no status or non-zero status returned from
 // subprocess.
 static Future<Nothing> checkError(const string& cmd, const Subprocess& s)
@@ -96,9 +126,14 @@ static Future<Nothing> checkError(const string& cmd, const Subprocess& s)
 }
 
 
-Try<Docker*> Docker::create(const string& path, bool validate)
+Try<Docker*> Docker::create(
+    const string& path,
+    bool validate,
+    const Option<string>& socket)
 {
-  Docker* docker = new Docker(path);
+  Docker* docker = socket.isSome()
+    ? new Docker(path, socket.get())
+    : new Docker(path);
   if (!validate) {
     return docker;
   }
@@ -569,6 +604,23 @@ Future<Nothing> Docker::stop(
                    stringify(timeoutSecs));
   }
 
+  if (client.get() != NULL) {
+    const string request = "POST " + containerPath(containerName) +
+      "/stop?t=" + stringify(timeoutSecs);
+
+    VLOG(1) << "Requesting " << request;
+
+    return client->post(containerPath(containerName) +
+                        "/stop?t=" + stringify(timeoutSecs))
+      .then(lambda::bind(
+          &Docker::__stop,
+          *this,
+          containerName,
+          request,
+          lambda::_1,
+          remove));
+  }
+
   string cmd = path + " stop -t " + stringify(timeoutSecs) +
                " " + containerName;
 
@@ -612,10 +664,47 @@ Future<Nothing> Docker::_stop(
 }
 
 
+Future<Nothing> Docker::__stop(
+    const Docker& docker,
+    const string& containerName,
+    const string& request,
+    const http::Response& response,
+    bool remove)
+{
+  // A container that is not running has been "stopped" already.
+  bool stopped = code(response) == 204 || code(response) == 304;
+
+  if (remove) {
+    return docker.rm(containerName, !stopped);
+  }
+
+  if (!stopped) {
+    return unexpected<Nothing>(request, response);
+  }
+
+  return Nothing();
+}
+
+
 Future<Nothing> Docker::rm(
     const string& containerName,
     bool force) const
 {
+  if (client.get() != NULL) {
+    const string request = "DELETE " + containerPath(containerName) +
+      (force ? "?force=1" : "");
+
+    VLOG(1) << "Requesting " << request;
+
+    return client->del(containerPath(containerName) + (force ? "?force=1" : ""))
+      .then([=](const http::Response& response) -> Future<Nothing> {
+        if (code(response) != 204) {
+          return unexpected<Nothing>(request, response);
+        }
+        return Nothing();
+      });
+  }
+
   const string cmd = path + (force ? " rm -f " : " rm ") + containerName;
 
   VLOG(1) << "Running " << cmd;
@@ -640,6 +729,11 @@ Future<Docker::Container> Docker::inspect(
 {
   Owned<Promise<Docker::Container>> promise(new Promise<Docker::Container>());
 
+  if (client.get() != NULL) {
+    _inspect(client, containerName, promise, retryInterval);
+    return promise->future();
+  }
+
   const string cmd =  path + " inspect " + containerName;
   _inspect(cmd, promise, retryInterval);
 
@@ -647,6 +741,103 @@ Future<Docker::Container> Docker::inspect(
 }
 
 
+void Docker::_inspect(
+    const Shared<DockerClient>& client,
+    const string& containerName,
+    const Owned<Promise<Docker::Container>>& promise,
+    const Option<Duration>& retryInterval)
+{
+  if (promise->future().hasDiscard()) {
+    promise->discard();
+    return;
+  }
+
+  const string request = "GET " + containerPath(containerName) + "/json";
+
+  // When retrying, subscribe to the events of the container before
+  // inspecting it so that we don't miss it being started.
+  Future<Nothing> changed;
+  if (retryInterval.isSome()) {
+    changed = client->changed(containerName);
+  }
+
+  // Inspects again once the container has changed, or after the retry
+  // interval in case an event was missed. If the events can not be
+  // received (e.g., an older daemon), falls back to only the interval.
+  auto retry = [=]() {
+    changed
+      .after(retryInterval.get(), [](const Future<Nothing>& future) {
+        Future<Nothing> _future = future;
+        _future.discard();
+        return Nothing();
+      })
+      .onAny([=](const Future<Nothing>& future) {
+        if (future.isFailed()) {
+          Clock::timer(retryInterval.get(), [=]() {
+            _inspect(client, containerName, promise, retryInterval);
+          });
+          return;
+        }
+
+        _inspect(client, containerName, promise, retryInterval);
+      });
+  };
+
+  VLOG(1) << "Requesting " << request;
+
+  client->get(containerPath(containerName) + "/json")
+    .onAny([=](const Future<http::Response>& response) {
+      if (promise->future().hasDiscard()) {
+        Future<Nothing>(changed).discard();
+        promise->discard();
+        return;
+      }
+
+      if (!response.isReady()) {
+        Future<Nothing>(changed).discard();
+        promise->fail("Failed to '" + request + "': " +
+                      (response.isFailed() ? response.failure()
+                                           : "future discarded"));
+        return;
+      }
+
+      if (code(response.get()) != 200) {
+        if (retryInterval.isSome()) {
+          VLOG(1) << "Retrying inspect with status '"
+                  << response.get().status << "'. request: '" << request
+                  << "', interval: " << stringify(retryInterval.get());
+          retry();
+          return;
+        }
+
+        promise->fail(unexpected<Nothing>(request, response.get()).failure());
+        return;
+      }
+
+      // Like 'docker inspect', return an array of containers.
+      Try<Docker::Container> container =
+        Docker::Container::create("[" + response.get().body + "]");
+
+      if (container.isError()) {
+        Future<Nothing>(changed).discard();
+        promise->fail("Unable to create container: " + container.error());
+        return;
+      }
+
+      if (retryInterval.isSome() && !container.get().started) {
+        VLOG(1) << "Retrying inspect since container not yet started. "
+                << "request: '" << request << "', interval: "
+                << stringify(retryInterval.get());
+        retry();
+        return;
+      }
+
+      Future<Nothing>(changed).discard();
+      promise->set(container.get());
+    });
+}
+
+
 void Docker::_inspect(
     const string& cmd,
     const Owned<Promise<Docker::Container>>& promise,
@@ -765,6 +956,17 @@ Future<list<Docker::Container>> Docker::ps(
     bool all,
     const Option<string>& prefix) const
 {
+  if (client.get() != NULL) {
+    const string request =
+      string("GET /containers/json") + (all ? "?all=1" : "");
+
+    VLOG(1) << "Requesting " << request;
+
+    return client->get(string("/containers/json") + (all ? "?all=1" : ""))
+      .then(lambda::bind(
+          &Docker::___ps, *this, request, prefix, lambda::_1));
+  }
+
   string cmd = path + (all ? " ps -a" : " ps");
 
   VLOG(1) << "Running " << cmd;
@@ -847,6 +1049,54 @@ Future<list<Docker::Container>> Docker::__ps(
 }
 
 
+Future<list<Docker::Container>> Docker::___ps(
+    const Docker& docker,
+    const string& request,
+    const Option<string>& prefix,
+    const http::Response& response)
+{
+  if (code(response) != 200) {
+    return unexpected<list<Docker::Container>>(request, response);
+  }
+
+  Try<JSON::Array> parse = JSON::parse<JSON::Array>(response.body);
+  if (parse.isError()) {
+    return Failure("Failed to parse JSON: " + parse.error());
+  }
+
+  list<Future<Docker::Container>> futures;
+
+  foreach (const JSON::Value& value, parse.get().values) {
+    if (!value.is<JSON::Object>()) {
+      return Failure("Unexpected container in '" + request + "'");
+    }
+
+    Result<JSON::Array> names =
+      value.as<JSON::Object>().find<JSON::Array>("Names");
+
+    if (!names.isSome() ||
+        names.get().values.empty() ||
+        !names.get().values.front().is<JSON::String>()) {
+      return Failure("Unable to find Names in container");
+    }
+
+    // Like in 'docker ps', use the first name without the leading '/'.
+    string name = names.get().values.front().as<JSON::String>().value;
+    if (strings::startsWith(name, "/")) {
+      name = name.substr(1);
+    }
+
+    // Inspect the containers that we are interested in depending on
+    // whether or not a 'prefix' was specified.
+    if (prefix.isNone() || strings::startsWith(name, prefix.get())) {
+      futures.push_back(docker.inspect(name));
+    }
+  }
+
+  return collect(futures);
+}
+
+
 Future<Docker::Image> Docker::pull(
     const string& directory,
     const string& image,
@@ -23,6 +23,7 @@
 #include <string>
 
 #include <process/future.hpp>
+#include <process/shared.hpp>
 #include <process/subprocess.hpp>
 
 #include <stout/duration.hpp>
@@ -32,6 +33,8 @@
 #include <stout/option.hpp>
 #include <stout/version.hpp>
 
+#include "docker/client.hpp"
+
 #include "mesos/resources.hpp"
 
 
@@ -41,8 +44,14 @@
 class Docker
 {
 public:
-  // Create Docker abstraction and optionally validate docker.
-  static Try<Docker*> create(const std::string& path, bool validate = true);
+  // Create Docker abstraction and optionally validate docker. If a
+  // 'socket' is specified then 'inspect', 'ps', 'stop' and 'rm' use
+  // the remote API of the Docker daemon listening on it rather than
+  // the Docker CLI.
+  static Try<Docker*> create(
+      const std::string& path,
+      bool validate = true,
+      const Option<std::string>& socket = None());
 
   virtual ~Docker() {}
 
@@ -143,6 +152,9 @@ protected:
   // Uses the specified path to the Docker CLI tool.
   Docker(const std::string& _path) : path(_path) {};
 
+  Docker(const std::string& _path, const std::string& socket)
+    : path(_path), client(new DockerClient(socket)) {};
+
 private:
   static process::Future<Nothing> _run(
       const Option<int>& status);
@@ -161,6 +173,13 @@ private:
       const process::Subprocess& s,
       bool remove);
 
+  static process::Future<Nothing> __stop(
+      const Docker& docker,
+      const std::string& containerName,
+      const std::string& request,
+      const process::http::Response& response,
+      bool remove);
+
   static void _inspect(
       const std::string& cmd,
       const process::Owned<process::Promise<Container>>& promise,
@@ -178,6 +197,12 @@ private:
       const Option<Duration>& retryInterval,
       const process::Future<std::string>& output);
 
+  static void _inspect(
+      const process::Shared<DockerClient>& client,
+      const std::string& containerName,
+      const process::Owned<process::Promise<Container>>& promise,
+      const Option<Duration>& retryInterval);
+
   static process::Future<std::list<Container>> _ps(
       const Docker& docker,
       const std::string& cmd,
@@ -190,6 +215,12 @@ private:
       const Option<std::string>& prefix,
       const std::string& output);
 
+  static process::Future<std::list<Container>> ___ps(
+      const Docker& docker,
+      const std::string& request,
+      const Option<std::string>& prefix,
+      const process::http::Response& response);
+
   static process::Future<Image> _pull(
       const Docker& docker,
       const process::Subprocess& s,
@@ -218,6 +249,9 @@ private:
       const std::string& cmd);
 
   const std::string path;
+
+  // The client for the remote API, if used. Shared by all copies.
+  const process::Shared<DockerClient> client;
 };
 
 #endif // __DOCKER_HPP__
@@ -25,6 +25,8 @@
 #include <mesos/module/authenticatee.hpp>
 #include <mesos/module/authenticator.hpp>
 
+#include <stout/foreach.hpp>
+
 #include "authentication/cram_md5/authenticatee.hpp"
 #include "authentication/cram_md5/authenticator.hpp"
 
@@ -57,7 +59,14 @@ mesos::modules::Module<Authenticatee> org_apache_mesos_TestCRAMMD5Authenticatee(
 
 static Authenticator* createCRAMMD5Authenticator(const Parameters& parameters)
 {
-  return new mesos::internal::cram_md5::CRAMMD5Authenticator();
+  bool tickets = false;
+  foreach (const Parameter& parameter, parameters.parameter()) {
+    if (parameter.key() == "tickets") {
+      tickets = parameter.value() == "true";
+    }
+  }
+
+  return new mesos::internal::cram_md5::CRAMMD5Authenticator(tickets);
 }
 
 
@@ -26,6 +26,7 @@
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/foreach.hpp>
 #include <stout/os.hpp>
 #include <stout/try.hpp>
@@ -41,6 +42,7 @@ using process::Future;
 const char* testLabelKey = "MESOS_Test_Label";
 const char* testLabelValue = "ApacheMesos";
 const char* testRemoveLabelKey = "MESOS_Test_Remove_Label";
+const char* testSleepEnvironmentVariableName = "MESOS_TEST_HOOK_SLEEP";
 
 class HookProcess : public ProtobufProcess<HookProcess>
 {
@@ -121,6 +123,20 @@ public:
       environment.CopyFrom(executorInfo.command().environment());
     }
 
+    // Stall for as long as the executor asks us to, which lets the
+    // tests exercise a slow hook.
+    foreach (const Environment::Variable& variable,
+             environment.variables()) {
+      if (variable.name() == testSleepEnvironmentVariableName) {
+        Try<Duration> duration = Duration::parse(variable.value());
+        if (duration.isError()) {
+          return Error(duration.error());
+        }
+
+        os::sleep(duration.get());
+      }
+    }
+
     Environment::Variable* variable = environment.add_variables();
     variable->set_name("FOO");
     variable->set_value("bar");
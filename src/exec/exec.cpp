@@ -127,22 +127,18 @@ public:
       cond(_cond),
       directory(_directory),
       checkpoint(_checkpoint),
-      recoveryTimeout(_recoveryTimeout)
+      recoveryTimeout(_recoveryTimeout),
+      statusUpdateBatchSize(1)
   {
     LOG(INFO) << "Version: " << MESOS_VERSION;
 
-    install<ExecutorRegisteredMessage>(
-        &ExecutorProcess::registered,
-        &ExecutorRegisteredMessage::executor_info,
-        &ExecutorRegisteredMessage::framework_id,
-        &ExecutorRegisteredMessage::framework_info,
-        &ExecutorRegisteredMessage::slave_id,
-        &ExecutorRegisteredMessage::slave_info);
+    install<ExecutorRegisteredMessage>(&ExecutorProcess::registered);
 
     install<ExecutorReregisteredMessage>(
         &ExecutorProcess::reregistered,
         &ExecutorReregisteredMessage::slave_id,
-        &ExecutorReregisteredMessage::slave_info);
+        &ExecutorReregisteredMessage::slave_info,
+        &ExecutorReregisteredMessage::status_update_batch_size);
 
     install<ReconnectExecutorMessage>(
         &ExecutorProcess::reconnect,
@@ -177,6 +173,15 @@ public:
   virtual ~ExecutorProcess() {}
 
 protected:
+  virtual void finalize()
+  {
+    // Do not lose the updates that are still batched, e.g., when the
+    // executor stops the driver right after sending its last update.
+    if (!aborted) {
+      flushStatusUpdates();
+    }
+  }
+
   virtual void initialize()
   {
     VLOG(1) << "Executor started at: " << self()
@@ -188,37 +193,49 @@ protected:
     RegisterExecutorMessage message;
     message.mutable_framework_id()->MergeFrom(frameworkId);
     message.mutable_executor_id()->MergeFrom(executorId);
+    message.set_accepts_queued_tasks(true);
     send(slave, message);
   }
 
-  void registered(const ExecutorInfo& executorInfo,
-                  const FrameworkID& frameworkId,
-                  const FrameworkInfo& frameworkInfo,
-                  const SlaveID& slaveId,
-                  const SlaveInfo& slaveInfo)
+  void registered(
+      const UPID& from,
+      const ExecutorRegisteredMessage& message)
   {
     if (aborted) {
-      VLOG(1) << "Ignoring registered message from slave " << slaveId
-              << " because the driver is aborted!";
+      VLOG(1) << "Ignoring registered message from slave "
+              << message.slave_id() << " because the driver is aborted!";
       return;
     }
 
-    LOG(INFO) << "Executor registered on slave " << slaveId;
+    LOG(INFO) << "Executor registered on slave " << message.slave_id();
 
     connected = true;
     connection = UUID::random();
+    statusUpdateBatchSize = message.status_update_batch_size();
 
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
     }
 
-    executor->registered(driver, executorInfo, frameworkInfo, slaveInfo);
+    executor->registered(
+        driver,
+        message.executor_info(),
+        message.framework_info(),
+        message.slave_info());
 
     VLOG(1) << "Executor::registered took " << stopwatch.elapsed();
+
+    // Launch the tasks that were queued while we were registering.
+    foreach (const TaskInfo& task, message.tasks()) {
+      runTask(task);
+    }
   }
 
-  void reregistered(const SlaveID& slaveId, const SlaveInfo& slaveInfo)
+  void reregistered(
+      const SlaveID& slaveId,
+      const SlaveInfo& slaveInfo,
+      uint32_t _statusUpdateBatchSize)
   {
     if (aborted) {
       VLOG(1) << "Ignoring re-registered message from slave " << slaveId
@@ -230,6 +247,7 @@ protected:
 
     connected = true;
     connection = UUID::random();
+    statusUpdateBatchSize = _statusUpdateBatchSize;
 
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
@@ -509,7 +527,62 @@ protected:
     // Capture the status update.
     updates[UUID::fromBytes(update->uuid())] = *update;
 
-    send(slave, message);
+    if (statusUpdateBatchSize <= 1) {
+      send(slave, message);
+      return;
+    }
+
+    // A batched update that was not sent yet is superseded by this
+    // update if it is for the same task and is not terminal, in which
+    // case it is never sent (nor resent) to the slave.
+    for (int i = 0; i < batchedUpdates.updates_size(); i++) {
+      const StatusUpdate& batched = batchedUpdates.updates(i).update();
+
+      if (batched.status().task_id() == status.task_id() &&
+          !protobuf::isTerminalState(batched.status().state())) {
+        VLOG(1) << "Coalescing status update " << batched
+                << " superseded by " << *update;
+
+        updates.erase(UUID::fromBytes(batched.uuid()));
+        batchedUpdates.mutable_updates()->DeleteSubrange(i, 1);
+        break;
+      }
+    }
+
+    // Batch the updates that are sent before the dispatched flush,
+    // i.e., the ones already queued for the executor. This bounds
+    // the added latency by the length of the queue of the executor
+    // when it sends updates in bursts, and adds none otherwise.
+    if (batchedUpdates.updates_size() == 0) {
+      dispatch(self(), &Self::flushStatusUpdates);
+    }
+
+    batchedUpdates.add_updates()->CopyFrom(message);
+
+    if (batchedUpdates.updates_size() >=
+        static_cast<int>(statusUpdateBatchSize)) {
+      flushStatusUpdates();
+    }
+  }
+
+  void flushStatusUpdates()
+  {
+    if (batchedUpdates.updates_size() == 0) {
+      return;
+    }
+
+    VLOG(1) << "Executor sending " << batchedUpdates.updates_size()
+            << " status updates";
+
+    // NOTE: The updates are resent when re-registering with the slave
+    // if they are not acknowledged, see 'reconnect'.
+    if (batchedUpdates.updates_size() == 1) {
+      send(slave, batchedUpdates.updates(0));
+    } else {
+      send(slave, batchedUpdates);
+    }
+
+    batchedUpdates.Clear();
   }
 
   void sendFrameworkMessage(const string& data)
@@ -541,6 +614,13 @@ private:
   bool checkpoint;
   Duration recoveryTimeout;
 
+  // The maximum number of status updates sent to the slave in a
+  // single message, as supported by the slave.
+  uint32_t statusUpdateBatchSize;
+
+  // Status updates batched for the slave.
+  StatusUpdatesMessage batchedUpdates;
+
   LinkedHashMap<UUID, StatusUpdate> updates; // Unacknowledged updates.
 
   // We store tasks that have not been acknowledged
@@ -1,3 +1,4 @@
+#include <string.h>
 #include <unistd.h>
 
 #include <sys/stat.h>
@@ -9,14 +10,18 @@
 
 #include <boost/shared_array.hpp>
 
+#include <process/defer.hpp>
 #include <process/deferred.hpp> // TODO(benh): This is required by Clang.
+#include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/http.hpp>
 #include <process/io.hpp>
 #include <process/mime.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/json.hpp>
@@ -43,6 +48,7 @@ using process::http::BadRequest;
 using process::http::InternalServerError;
 using process::http::NotFound;
 using process::http::OK;
+using process::http::Pipe;
 using process::http::Response;
 using process::http::Request;
 
@@ -54,6 +60,76 @@ using std::vector;
 namespace mesos {
 namespace internal {
 
+// How often a followed file is checked for new data.
+static const Duration FOLLOW_INTERVAL = Milliseconds(500);
+
+// The amount of unread data (in bytes) a follower can fall behind by
+// before we stop reading the followed file.
+static const size_t FOLLOW_PIPE_CAPACITY = 1024 * 1024;
+
+// The distance (in bytes) between the lines recorded in a file's
+// line index.
+static const off_t LINE_INDEX_INTERVAL = 1024 * 1024;
+
+// Searches only match the first bytes of longer lines, which bounds
+// the memory used by a search.
+static const size_t MAXIMUM_SEARCH_LINE_LENGTH = 64 * 1024;
+
+// The default maximum number of lines a search returns.
+static const size_t DEFAULT_SEARCH_LIMIT = 1000;
+
+
+// A sparse index of the lines of a file, so that the line number of
+// an offset can be found without scanning the file from the start.
+// The index is extended as searches scan past its end, i.e., as the
+// file gets appended to.
+struct LineIndex
+{
+  LineIndex() : inode(0), end(0), lines(0) {}
+
+  ino_t inode;
+
+  // The offset up to which all (complete) lines have been indexed,
+  // and the number of lines before it.
+  off_t end;
+  size_t lines;
+
+  // The offset and number of the first line after every
+  // LINE_INDEX_INTERVAL bytes, in increasing order of offsets.
+  vector<std::pair<off_t, size_t>> checkpoints;
+};
+
+
+// The state of an (incremental) search through a file.
+struct Search
+{
+  Search(const Pipe::Writer& _writer) : writer(_writer) {}
+
+  int fd;
+  ino_t inode;
+  string path;
+  string pattern;
+
+  // Only lines starting at or after 'offset' are matched.
+  off_t offset;
+
+  size_t limit;
+  size_t matches;
+
+  // The offset of the next byte to read.
+  off_t position;
+
+  // The (possibly partial) line being scanned, its offset, its
+  // complete length so far, and the number of lines before it.
+  string line;
+  off_t start;
+  size_t length;
+  size_t lines;
+
+  Pipe::Writer writer;
+};
+
+
 class FilesProcess : public Process<FilesProcess>
 {
 public:
@@ -85,6 +161,14 @@ private:
 
   // Reads data from a file at a given offset and for a given length.
   // See the jquery pailer for the expected behavior.
+  // Requests can also have the following parameters:
+  //   raw: If 'true', returns the raw file contents rather than JSON.
+  //        A byte range can be requested using a 'Range' header, in
+  //        which case the data is sent without being copied through
+  //        user space.
+  //   follow: If 'true', streams the raw file contents from 'offset'
+  //        (by default the end of the file) as the file grows, until
+  //        the client closes the connection.
   Future<Response> read(const Request& request);
 
   // Returns the raw file contents for a given path.
@@ -92,10 +176,37 @@ private:
   //   path: The directory to browse. Required.
   Future<Response> download(const Request& request);
 
+  // Streams the lines of a file that contain a pattern, one JSON
+  // object per line, e.g.:
+  //   {"data":"error: ...","line":42,"offset":1337}
+  // Requests have the following parameters:
+  //   path: The file to search. Required.
+  //   pattern: The (fixed) string to search for. Required.
+  //   offset: Only lines starting at or after this offset are
+  //           searched. Optional, defaults to 0.
+  //   limit: The maximum number of lines to return. Optional,
+  //          defaults to DEFAULT_SEARCH_LIMIT.
+  Future<Response> search(const Request& request);
+
   // Returns the internal virtual path mapping.
   Future<Response> debug(const Request& request);
 
+  // Writes the data appended to the file after 'offset' to 'writer'
+  // and reschedules itself until the reader closes the pipe.
+  void follow(int fd, off_t offset, Pipe::Writer writer);
+
+  // Scans the next chunk of the file being searched and reschedules
+  // itself until the end of the file or the limit has been reached.
+  void _search(const Owned<Search>& search);
+
+  // Matches (and indexes) the line that was just scanned. Returns
+  // false if the search is done.
+  bool __search(const Owned<Search>& search, bool terminated);
+
   hashmap<string, string> paths;
+
+  // Line indexes, keyed by the real path of the files.
+  hashmap<string, LineIndex> indexes;
 };
 
 
@@ -109,6 +220,7 @@ void FilesProcess::initialize()
   route("/browse.json", None(), &FilesProcess::browse);
   route("/read.json", None(), &FilesProcess::read);
   route("/download.json", None(), &FilesProcess::download);
+  route("/search.json", None(), &FilesProcess::search);
   route("/debug.json", None(), &FilesProcess::debug);
 }
 
@@ -145,6 +257,15 @@ Future<Nothing> FilesProcess::attach(const string& path, const string& name)
 
 void FilesProcess::detach(const string& name)
 {
+  if (paths.contains(name)) {
+    // Drop the line indexes of the files under the detached path.
+    foreach (const string& path, indexes.keys()) {
+      if (strings::startsWith(path, paths[name])) {
+        indexes.erase(path);
+      }
+    }
+  }
+
   paths.erase(name);
 }
 
@@ -237,6 +358,15 @@ Future<Response> FilesProcess::read(const Request& request)
     length = result.get();
   }
 
+  bool raw = request.query.get("raw").get("false") == "true";
+  bool follow = request.query.get("follow").get("false") == "true";
+
+  if (raw && (offset != -1 || length != -1)) {
+    return BadRequest(
+        "Expecting a 'Range' header rather than 'offset' or 'length'"
+        " when reading raw data.\n");
+  }
+
   Result<string> resolvedPath = resolve(path.get());
 
   if (resolvedPath.isError()) {
@@ -250,6 +380,15 @@ Future<Response> FilesProcess::read(const Request& request)
     return BadRequest("Cannot read a directory.\n");
   }
 
+  // Let libprocess 'sendfile' the (requested range of the) file.
+  if (raw && !follow) {
+    OK response;
+    response.type = response.PATH;
+    response.path = resolvedPath.get();
+    response.headers["Content-Type"] = "text/plain; charset=utf-8";
+    return response;
+  }
+
   // TODO(benh): Cache file descriptors so we aren't constantly
   // opening them and paging the data in from disk.
   Try<int> fd = os::open(resolvedPath.get(), O_RDONLY | O_CLOEXEC);
@@ -275,6 +414,19 @@ Future<Response> FilesProcess::read(const Request& request)
     offset = size;
   }
 
+  if (follow) {
+    Pipe pipe(FOLLOW_PIPE_CAPACITY);
+
+    OK response;
+    response.type = response.PIPE;
+    response.reader = pipe.reader();
+    response.headers["Content-Type"] = "text/plain; charset=utf-8";
+
+    FilesProcess::follow(fd.get(), std::min(offset, size), pipe.writer());
+
+    return response;
+  }
+
   if (length == -1) {
     length = size - offset;
   }
@@ -369,6 +521,299 @@ Future<Response> FilesProcess::download(const Request& request)
 }
 
 
+void FilesProcess::follow(int fd, off_t offset, Pipe::Writer writer)
+{
+  // Stop following once the client has gone away.
+  if (writer.readerClosed().isReady()) {
+    os::close(fd);
+    return;
+  }
+
+  struct stat s;
+  if (fstat(fd, &s) < 0) {
+    writer.fail("Failed to stat file: " + string(strerror(errno)));
+    os::close(fd);
+    return;
+  }
+
+  // Start over if the file was truncated (e.g., rotated).
+  if (s.st_size < offset) {
+    offset = 0;
+  }
+
+  // Cap each read at 16 pages so that we don't block the process
+  // while catching up with a quickly growing file.
+  size_t length = std::min<off_t>(
+      s.st_size - offset,
+      sysconf(_SC_PAGE_SIZE) * 16);
+
+  if (length > 0) {
+    boost::shared_array<char> data(new char[length]);
+
+    ssize_t read = ::pread(fd, data.get(), length, offset);
+    if (read < 0) {
+      writer.fail("Failed to read file: " + string(strerror(errno)));
+      os::close(fd);
+      return;
+    }
+
+    if (!writer.write(string(data.get(), read))) {
+      os::close(fd);
+      return;
+    }
+
+    offset += read;
+  }
+
+  // Hold off until the client has caught up rather than buffering
+  // the file in memory.
+  Future<Nothing> writable = writer.writable();
+  if (!writable.isReady()) {
+    writable.onAny(
+        defer(self(), &FilesProcess::follow, fd, offset, writer));
+  } else if (offset < s.st_size) {
+    dispatch(self(), &FilesProcess::follow, fd, offset, writer);
+  } else {
+    delay(FOLLOW_INTERVAL, self(), &FilesProcess::follow, fd, offset, writer);
+  }
+}
+
+
+Future<Response> FilesProcess::search(const Request& request)
+{
+  Option<string> path = request.query.get("path");
+
+  if (!path.isSome() || path.get().empty()) {
+    return BadRequest("Expecting 'path=value' in query.\n");
+  }
+
+  Option<string> pattern = request.query.get("pattern");
+
+  if (!pattern.isSome() || pattern.get().empty()) {
+    return BadRequest("Expecting 'pattern=value' in query.\n");
+  }
+
+  off_t offset = 0;
+
+  if (request.query.get("offset").isSome()) {
+    Try<off_t> result = numify<off_t>(request.query.get("offset").get());
+    if (result.isError()) {
+      return BadRequest("Failed to parse offset: " + result.error() + ".\n");
+    }
+    offset = result.get();
+  }
+
+  size_t limit = DEFAULT_SEARCH_LIMIT;
+
+  if (request.query.get("limit").isSome()) {
+    Try<size_t> result = numify<size_t>(request.query.get("limit").get());
+    if (result.isError()) {
+      return BadRequest("Failed to parse limit: " + result.error() + ".\n");
+    }
+    limit = result.get();
+  }
+
+  Result<string> resolvedPath = resolve(path.get());
+
+  if (resolvedPath.isError()) {
+    return BadRequest(resolvedPath.error() + ".\n");
+  } else if (!resolvedPath.isSome()) {
+    return NotFound();
+  }
+
+  // Don't search directories.
+  if (os::stat::isdir(resolvedPath.get())) {
+    return BadRequest("Cannot search a directory.\n");
+  }
+
+  Try<int> fd = os::open(resolvedPath.get(), O_RDONLY | O_CLOEXEC);
+
+  if (fd.isError()) {
+    string error = strings::format("Failed to open file at '%s': %s",
+        resolvedPath.get(), fd.error()).get();
+    LOG(WARNING) << error;
+    return InternalServerError(error + ".\n");
+  }
+
+  struct stat s;
+  if (fstat(fd.get(), &s) < 0) {
+    string error = strings::format("Failed to stat file at '%s': %s",
+        resolvedPath.get(), strerror(errno)).get();
+    LOG(WARNING) << error;
+    os::close(fd.get());
+    return InternalServerError(error + ".\n");
+  }
+
+  // Start over if the file was replaced or truncated since it was
+  // indexed (e.g., rotated).
+  LineIndex& index = indexes[resolvedPath.get()];
+  if (index.inode != s.st_ino || index.end > s.st_size) {
+    index = LineIndex();
+    index.inode = s.st_ino;
+  }
+
+  Pipe pipe;
+
+  Owned<Search> search(new Search(pipe.writer()));
+  search->fd = fd.get();
+  search->inode = s.st_ino;
+  search->path = resolvedPath.get();
+  search->pattern = pattern.get();
+  search->offset = offset;
+  search->limit = limit;
+  search->matches = 0;
+  search->length = 0;
+
+  // Start scanning at the closest indexed line before 'offset'.
+  search->start = 0;
+  search->lines = 0;
+
+  if (offset >= index.end) {
+    search->start = index.end;
+    search->lines = index.lines;
+  } else {
+    typedef std::pair<off_t, size_t> Checkpoint;
+    foreach (const Checkpoint& checkpoint, index.checkpoints) {
+      if (checkpoint.first > offset) {
+        break;
+      }
+      search->start = checkpoint.first;
+      search->lines = checkpoint.second;
+    }
+  }
+
+  search->position = search->start;
+
+  OK response;
+  response.type = response.PIPE;
+  response.reader = pipe.reader();
+  response.headers["Content-Type"] = "application/json";
+
+  if (limit == 0) {
+    pipe.writer().close();
+    os::close(fd.get());
+  } else {
+    dispatch(self(), &FilesProcess::_search, search);
+  }
+
+  return response;
+}
+
+
+void FilesProcess::_search(const Owned<Search>& search)
+{
+  // Stop searching once the client has gone away.
+  if (search->writer.readerClosed().isReady()) {
+    os::close(search->fd);
+    return;
+  }
+
+  size_t size = sysconf(_SC_PAGE_SIZE) * 16;
+  boost::shared_array<char> buffer(new char[size]);
+
+  ssize_t length = ::pread(search->fd, buffer.get(), size, search->position);
+  if (length < 0) {
+    search->writer.fail("Failed to read file: " + string(strerror(errno)));
+    os::close(search->fd);
+    return;
+  }
+
+  if (length == 0) {
+    // Match the last line even if it is not terminated (yet), but
+    // don't index it since the file may still get appended to.
+    if (search->length == 0 || __search(search, false)) {
+      search->writer.close();
+      os::close(search->fd);
+    }
+    return;
+  }
+
+  search->position += length;
+
+  const char* data = buffer.get();
+  const char* end = data + length;
+
+  while (data < end) {
+    const char* newline = (const char*) memchr(data, '\n', end - data);
+
+    size_t count = (newline != NULL ? newline : end) - data;
+
+    // Only keep the beginning of long lines.
+    if (search->line.size() < MAXIMUM_SEARCH_LINE_LENGTH) {
+      search->line.append(
+          data,
+          std::min(count, MAXIMUM_SEARCH_LINE_LENGTH - search->line.size()));
+    }
+
+    search->length += count;
+
+    if (newline == NULL) {
+      break;
+    }
+
+    data = newline + 1;
+
+    if (!__search(search, true)) {
+      return;
+    }
+  }
+
+  dispatch(self(), &FilesProcess::_search, search);
+}
+
+
+bool FilesProcess::__search(const Owned<Search>& search, bool terminated)
+{
+  if (search->start >= search->offset &&
+      strings::contains(search->line, search->pattern)) {
+    JSON::Object object;
+    object.values["offset"] = search->start;
+    object.values["line"] = search->lines + 1;
+    object.values["data"] = search->line;
+
+    if (!search->writer.write(stringify(object) + "\n")) {
+      os::close(search->fd);
+      return false;
+    }
+
+    if (++search->matches >= search->limit) {
+      search->writer.close();
+      os::close(search->fd);
+      return false;
+    }
+  }
+
+  // The offset of the next line (including the newline).
+  off_t next = search->start + search->length + 1;
+
+  // Extend the index if this line directly follows its end.
+  if (terminated && indexes.contains(search->path)) {
+    LineIndex& index = indexes[search->path];
+
+    if (index.inode == search->inode && index.end == search->start) {
+      off_t last = index.checkpoints.empty()
+        ? 0
+        : index.checkpoints.back().first;
+
+      if (search->start >= last + LINE_INDEX_INTERVAL) {
+        index.checkpoints.push_back(
+            std::make_pair(search->start, search->lines));
+      }
+
+      index.end = next;
+      index.lines = search->lines + 1;
+    }
+  }
+
+  search->line.clear();
+  search->start = next;
+  search->length = 0;
+  search->lines++;
+
+  return true;
+}
+
+
 Future<Response> FilesProcess::debug(const Request& request)
 {
   JSON::Object object;
@@ -0,0 +1,338 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/socket.hpp>
+#include <process/subprocess.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/ip.hpp>
+#include <stout/lambda.hpp>
+#include <stout/numify.hpp>
+#include <stout/option.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "common/status_utils.hpp"
+
+#include "health-check/health_checker.hpp"
+
+#include "messages/messages.hpp"
+
+using namespace process;
+
+using process::network::Address;
+using process::network::Socket;
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+
+HealthCheckerProcess::HealthCheckerProcess(
+    const HealthCheck& _check,
+    const UPID& _executor,
+    const TaskID& _taskID)
+  : check(_check),
+    initializing(true),
+    executor(_executor),
+    taskID(_taskID),
+    consecutiveFailures(0) {}
+
+
+Future<Nothing> HealthCheckerProcess::healthCheck()
+{
+  VLOG(2) << "Health checks starting in "
+    << Seconds(check.delay_seconds()) << ", grace period "
+    << Seconds(check.grace_period_seconds());
+
+  startTime = Clock::now();
+
+  delay(Seconds(check.delay_seconds()), self(), &Self::_healthCheck);
+  return promise.future();
+}
+
+
+void HealthCheckerProcess::failure(const string& message)
+{
+  if (check.grace_period_seconds() > 0 &&
+      (Clock::now() - startTime).secs() <= check.grace_period_seconds()) {
+    LOG(INFO) << "Ignoring failure as health check still in grace period";
+    reschedule();
+    return;
+  }
+
+  consecutiveFailures++;
+  VLOG(1) << "#" << consecutiveFailures << " check failed: " << message;
+
+  bool killTask = consecutiveFailures >= check.consecutive_failures();
+
+  TaskHealthStatus taskHealthStatus;
+  taskHealthStatus.set_healthy(false);
+  taskHealthStatus.set_consecutive_failures(consecutiveFailures);
+  taskHealthStatus.set_kill_task(killTask);
+  taskHealthStatus.mutable_task_id()->CopyFrom(taskID);
+  send(executor, taskHealthStatus);
+
+  if (killTask) {
+    promise.fail(message);
+  } else {
+    reschedule();
+  }
+}
+
+
+void HealthCheckerProcess::success()
+{
+  VLOG(1) << "Check passed";
+
+  // Send a healthy status update on the first success,
+  // and on the first success following failure(s).
+  if (initializing || consecutiveFailures > 0) {
+    TaskHealthStatus taskHealthStatus;
+    taskHealthStatus.set_healthy(true);
+    taskHealthStatus.mutable_task_id()->CopyFrom(taskID);
+    send(executor, taskHealthStatus);
+    initializing = false;
+  }
+  consecutiveFailures = 0;
+  reschedule();
+}
+
+
+void HealthCheckerProcess::_healthCheck()
+{
+  if (check.has_http()) {
+    httpHealthCheck();
+  } else if (check.has_tcp()) {
+    tcpHealthCheck();
+  } else if (check.has_command()) {
+    commandHealthCheck();
+  } else {
+    promise.fail("No check found in health check");
+  }
+}
+
+
+void HealthCheckerProcess::commandHealthCheck()
+{
+  const CommandInfo& command = check.command();
+
+  map<string, string> environment;
+  foreach (const Environment_Variable& variable,
+           command.environment().variables()) {
+    environment[variable.name()] = variable.value();
+  }
+
+  // Launch the subprocess.
+  Option<Try<Subprocess> > external;
+
+  if (command.shell()) {
+    // Use the shell variant.
+    if (!command.has_value()) {
+      promise.fail("Shell command is not specified");
+      return;
+    }
+
+    VLOG(2) << "Launching health command '" << command.value() << "'";
+
+    external = process::subprocess(
+        command.value(),
+        Subprocess::PATH("/dev/null"),
+        Subprocess::FD(STDERR_FILENO),
+        Subprocess::FD(STDERR_FILENO),
+        environment);
+  } else {
+    // Use the exec variant.
+    if (!command.has_value()) {
+      promise.fail("Executable path is not specified");
+      return;
+    }
+
+    vector<string> argv;
+    foreach (const string& arg, command.arguments()) {
+      argv.push_back(arg);
+    }
+
+    VLOG(2) << "Launching health command [" << command.value() << ", "
+            << strings::join(", ", argv) << "]";
+
+    external = process::subprocess(
+        command.value(),
+        argv,
+        Subprocess::PATH("/dev/null"),
+        Subprocess::FD(STDERR_FILENO),
+        Subprocess::FD(STDERR_FILENO),
+        None(),
+        environment);
+  }
+
+  CHECK_SOME(external);
+
+  if (external.get().isError()) {
+    promise.fail("Error creating subprocess for healthcheck");
+    return;
+  }
+
+  Future<Option<int> > status = external.get().get().status();
+  status.await(Seconds(check.timeout_seconds()));
+
+  if (!status.isReady()) {
+    string msg = "Command check failed with reason: ";
+    if (status.isFailed()) {
+      msg += "failed with error: " + status.failure();
+    } else if (status.isDiscarded()) {
+      msg += "status future discarded";
+    } else {
+      msg += "status still pending after timeout " +
+             stringify(Seconds(check.timeout_seconds()));
+    }
+
+    promise.fail(msg);
+    return;
+  }
+
+  int statusCode = status.get().get();
+  if (statusCode != 0) {
+    string message = "Health command check " + WSTRINGIFY(statusCode);
+    failure(message);
+  } else {
+    success();
+  }
+}
+
+
+// Fails 'future' with a timeout (after discarding it) if it is still
+// pending after 'timeout'.
+template <typename T>
+static Future<T> timedout(Future<T> future, const Duration& timeout)
+{
+  future.discard();
+  return Failure("Timed out after " + stringify(timeout));
+}
+
+
+// NOTE: The TCP and HTTP checks connect to the task on the loopback
+// interface, i.e., they assume the task shares the network namespace
+// of the checker.
+void HealthCheckerProcess::httpHealthCheck()
+{
+  const HealthCheck::HTTP& http = check.http();
+  const Duration timeout = Seconds(check.timeout_seconds());
+
+  VLOG(2) << "Sending HTTP health check request to port " << http.port()
+          << " path '" << http.path() << "'";
+
+  http::get(http::URL("http", net::IP(INADDR_LOOPBACK), http.port(), http.path()))
+    .after(timeout, lambda::bind(&timedout<http::Response>, lambda::_1, timeout))
+    .onAny(defer(self(), &Self::__httpHealthCheck, lambda::_1));
+}
+
+
+void HealthCheckerProcess::__httpHealthCheck(
+    const Future<http::Response>& response)
+{
+  if (!response.isReady()) {
+    failure("HTTP check failed: " +
+            (response.isFailed() ? response.failure() : "discarded"));
+    return;
+  }
+
+  // Any status is acceptable if none are specified.
+  if (check.http().statuses().size() == 0) {
+    success();
+    return;
+  }
+
+  // The status is of the form '200 OK'.
+  Try<uint32_t> code =
+    numify<uint32_t>(strings::tokenize(response.get().status, " ")[0]);
+
+  if (code.isSome()) {
+    foreach (uint32_t status, check.http().statuses()) {
+      if (status == code.get()) {
+        success();
+        return;
+      }
+    }
+  }
+
+  failure("HTTP check returned unexpected status '" +
+          response.get().status + "'");
+}
+
+
+void HealthCheckerProcess::tcpHealthCheck()
+{
+  const uint32_t port = check.tcp().port();
+  const Duration timeout = Seconds(check.timeout_seconds());
+
+  VLOG(2) << "Connecting to port " << port << " for TCP health check";
+
+  Try<Socket> socket = Socket::create();
+  if (socket.isError()) {
+    failure("Failed to create socket for TCP check: " + socket.error());
+    return;
+  }
+
+  // NOTE: We hold on to a copy of the socket until the connect
+  // completes, the socket is closed once the last copy is gone.
+  Socket _socket = socket.get();
+
+  _socket.connect(Address(net::IP(INADDR_LOOPBACK), port))
+    .after(timeout, lambda::bind(&timedout<Nothing>, lambda::_1, timeout))
+    .onAny([_socket]() {})
+    .onAny(defer(self(), &Self::__tcpHealthCheck, lambda::_1));
+}
+
+
+void HealthCheckerProcess::__tcpHealthCheck(const Future<Nothing>& connect)
+{
+  if (!connect.isReady()) {
+    failure("TCP check failed: " +
+            (connect.isFailed() ? connect.failure() : "discarded"));
+    return;
+  }
+
+  success();
+}
+
+
+void HealthCheckerProcess::reschedule()
+{
+  VLOG(1) << "Rescheduling health check in "
+    << Seconds(check.interval_seconds());
+
+  delay(Seconds(check.interval_seconds()), self(), &Self::_healthCheck);
+}
+
+} // namespace internal {
+} // namespace mesos {
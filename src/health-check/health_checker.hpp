@@ -0,0 +1,83 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HEALTH_CHECK_HEALTH_CHECKER_HPP__
+#define __HEALTH_CHECK_HEALTH_CHECKER_HPP__
+
+#include <string>
+
+#include <mesos/mesos.hpp>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/pid.hpp>
+#include <process/protobuf.hpp>
+#include <process/time.hpp>
+
+#include <stout/nothing.hpp>
+
+namespace mesos {
+namespace internal {
+
+// Periodically performs the health check 'check' of the task
+// 'taskID' and sends the results as 'TaskHealthStatus' messages to
+// 'executor'. This is used by the 'mesos-health-check' program as
+// well as in-process by the command executor for TCP and HTTP
+// checks, which do not need to fork a command per check.
+class HealthCheckerProcess : public ProtobufProcess<HealthCheckerProcess>
+{
+public:
+  HealthCheckerProcess(
+      const HealthCheck& check,
+      const process::UPID& executor,
+      const TaskID& taskID);
+
+  virtual ~HealthCheckerProcess() {}
+
+  // Starts the health checks. The returned future fails once the
+  // health check fails permanently (i.e., the task should be killed)
+  // or can not be performed.
+  process::Future<Nothing> healthCheck();
+
+private:
+  void failure(const std::string& message);
+  void success();
+
+  void _healthCheck();
+  void commandHealthCheck();
+  void httpHealthCheck();
+  void tcpHealthCheck();
+
+  void __httpHealthCheck(const process::Future<process::http::Response>& r);
+  void __tcpHealthCheck(const process::Future<Nothing>& connect);
+
+  void reschedule();
+
+  process::Promise<Nothing> promise;
+  HealthCheck check;
+  bool initializing;
+  process::UPID executor;
+  TaskID taskID;
+  uint32_t consecutiveFailures;
+  process::Time startTime;
+};
+
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __HEALTH_CHECK_HEALTH_CHECKER_HPP__
@@ -18,16 +18,31 @@
 
 #include <pthread.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include <mesos/hook.hpp>
 
 #include <mesos/module/hook.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/metrics.hpp>
+
 #include <stout/check.hpp>
+#include <stout/duration.hpp>
 #include <stout/foreach.hpp>
+#include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 
@@ -40,11 +55,165 @@ using std::vector;
 
 using mesos::modules::ModuleManager;
 
+using process::metrics::Counter;
+
 namespace mesos {
 namespace internal {
 
+// How long the decorator hooks of a module are waited for before
+// their result is ignored, which bounds how long a slow (or stuck)
+// hook can stall the master or slave.
+static const Duration HOOK_TIMEOUT = Seconds(1);
+
+
+// The metrics of a hook module.
+struct HookMetrics
+{
+  explicit HookMetrics(const string& name)
+    : abandoned("hooks/" + name + "/abandoned"),
+      errors("hooks/" + name + "/errors")
+  {
+    process::metrics::add(abandoned);
+    process::metrics::add(errors);
+  }
+
+  ~HookMetrics()
+  {
+    process::metrics::remove(abandoned);
+    process::metrics::remove(errors);
+  }
+
+  // Invocations whose result was not waited for (see HOOK_TIMEOUT).
+  Counter abandoned;
+  Counter errors;
+};
+
+
+// Runs the hooks of a single module, one after another, on a
+// long-lived thread. The worker shares ownership of its state with
+// that thread so that a stuck hook can outlive the worker (e.g., when
+// the module is unloaded) without blocking anyone on a join.
+class HookWorker
+{
+public:
+  explicit HookWorker(const string& name)
+    : state(new State()),
+      metrics(new HookMetrics(name))
+  {
+    std::thread(&HookWorker::run, state).detach();
+  }
+
+  ~HookWorker()
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->stopped = true;
+    state->condition.notify_one();
+  }
+
+  // Queues a hook invocation. Invocations that are abandoned before
+  // they get to run are skipped.
+  void enqueue(
+      const lambda::function<void(void)>& f,
+      const std::shared_ptr<std::atomic_bool>& abandoned =
+        std::shared_ptr<std::atomic_bool>(new std::atomic_bool(false)))
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->queue.push_back(std::make_pair(f, abandoned));
+    state->condition.notify_one();
+  }
+
+  const std::shared_ptr<HookMetrics> metrics;
+
+private:
+  typedef std::pair<
+      lambda::function<void(void)>,
+      std::shared_ptr<std::atomic_bool>> Invocation;
+
+  struct State
+  {
+    State() : stopped(false) {}
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Invocation> queue;
+    bool stopped;
+  };
+
+  static void run(const std::shared_ptr<State>& state)
+  {
+    while (true) {
+      Invocation invocation;
+
+      {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        while (!state->stopped && state->queue.empty()) {
+          state->condition.wait(lock);
+        }
+
+        if (state->stopped) {
+          return;
+        }
+
+        invocation = state->queue.front();
+        state->queue.pop_front();
+      }
+
+      if (!invocation.second->load()) {
+        invocation.first();
+      }
+    }
+  }
+
+  const std::shared_ptr<State> state;
+};
+
+
 static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 static hashmap<string, Hook*> availableHooks;
+static hashmap<string, std::shared_ptr<HookWorker>> workers;
+
+
+// Invokes a hook on the worker of the named module and waits at most
+// HOOK_TIMEOUT for its result. The result of a hook that times out is
+// ignored: the hook keeps running in the background if it already
+// started, and is skipped otherwise.
+template <typename T>
+static Option<T> invoke(
+    const string& name,
+    const lambda::function<T(void)>& hook)
+{
+  CHECK(workers.contains(name));
+  const std::shared_ptr<HookWorker>& worker = workers[name];
+
+  std::shared_ptr<std::promise<T>> promise(new std::promise<T>());
+  std::future<T> future = promise->get_future();
+
+  std::shared_ptr<std::atomic_bool> abandoned(new std::atomic_bool(false));
+
+  worker->enqueue([=]() { promise->set_value(hook()); }, abandoned);
+
+  if (future.wait_for(std::chrono::nanoseconds(HOOK_TIMEOUT.ns())) !=
+      std::future_status::ready) {
+    LOG(WARNING) << "Hook module '" << name << "' did not return within "
+                 << HOOK_TIMEOUT << ", ignoring its result";
+
+    abandoned->store(true);
+    ++worker->metrics->abandoned;
+
+    return None();
+  }
+
+  return future.get();
+}
+
+
+// Counts the failure of a hook of the named module.
+static void failed(const string& name)
+{
+  if (workers.contains(name)) {
+    ++workers[name]->metrics->errors;
+  }
+}
 
 
 Try<Nothing> HookManager::initialize(const string& hookList)
@@ -71,6 +240,7 @@ Try<Nothing> HookManager::initialize(const string& hookList)
 
     // Add the hook module to the list of available hooks.
     availableHooks[hook] = module.get();
+    workers[hook] = std::shared_ptr<HookWorker>(new HookWorker(hook));
   }
   return Nothing();
 }
@@ -86,6 +256,7 @@ Try<Nothing> HookManager::unload(const std::string& hookName)
 
   // Now remove the hook from the list of available hooks.
   availableHooks.erase(hookName);
+  workers.erase(hookName);
   return Nothing();
 }
 
@@ -103,16 +274,25 @@ Labels HookManager::masterLaunchTaskLabelDecorator(
   TaskInfo taskInfo_ = taskInfo;
 
   foreachpair (const string& name, Hook* hook, availableHooks) {
-    const Result<Labels>& result =
-      hook->masterLaunchTaskLabelDecorator(taskInfo_, frameworkInfo, slaveInfo);
-
-    // NOTE: If the hook returns None(), the task labels won't be
-    // changed.
-    if (result.isSome()) {
-      taskInfo_.mutable_labels()->CopyFrom(result.get());
-    } else if (result.isError()) {
+    const Option<Result<Labels>> result = invoke<Result<Labels>>(
+        name,
+        lambda::bind(
+            &Hook::masterLaunchTaskLabelDecorator,
+            hook,
+            taskInfo_,
+            frameworkInfo,
+            slaveInfo));
+
+    // NOTE: If the hook returns None() (or times out), the task
+    // labels won't be changed.
+    if (result.isNone()) {
+      continue;
+    } else if (result.get().isSome()) {
+      taskInfo_.mutable_labels()->CopyFrom(result.get().get());
+    } else if (result.get().isError()) {
       LOG(WARNING) << "Master label decorator hook failed for module '"
-                   << name << "': " << result.error();
+                   << name << "': " << result.get().error();
+      failed(name);
     }
   }
 
@@ -130,16 +310,25 @@ Labels HookManager::slaveRunTaskLabelDecorator(
   TaskInfo taskInfo_ = taskInfo;
 
   foreachpair (const string& name, Hook* hook, availableHooks) {
-    const Result<Labels>& result =
-      hook->slaveRunTaskLabelDecorator(taskInfo_, frameworkInfo, slaveInfo);
-
-    // NOTE: If the hook returns None(), the task labels won't be
-    // changed.
-    if (result.isSome()) {
-      taskInfo_.mutable_labels()->CopyFrom(result.get());
-    } else if (result.isError()) {
+    const Option<Result<Labels>> result = invoke<Result<Labels>>(
+        name,
+        lambda::bind(
+            &Hook::slaveRunTaskLabelDecorator,
+            hook,
+            taskInfo_,
+            frameworkInfo,
+            slaveInfo));
+
+    // NOTE: If the hook returns None() (or times out), the task
+    // labels won't be changed.
+    if (result.isNone()) {
+      continue;
+    } else if (result.get().isSome()) {
+      taskInfo_.mutable_labels()->CopyFrom(result.get().get());
+    } else if (result.get().isError()) {
       LOG(WARNING) << "Slave label decorator hook failed for module '"
-                   << name << "': " << result.error();
+                   << name << "': " << result.get().error();
+      failed(name);
     }
   }
 
@@ -153,17 +342,24 @@ Environment HookManager::slaveExecutorEnvironmentDecorator(
   Lock lock(&mutex);
 
   foreachpair (const string& name, Hook* hook, availableHooks) {
-    const Result<Environment>& result =
-      hook->slaveExecutorEnvironmentDecorator(executorInfo);
-
-    // NOTE: If the hook returns None(), the environment won't be
-    // changed.
-    if (result.isSome()) {
+    const Option<Result<Environment>> result = invoke<Result<Environment>>(
+        name,
+        lambda::bind(
+            &Hook::slaveExecutorEnvironmentDecorator,
+            hook,
+            executorInfo));
+
+    // NOTE: If the hook returns None() (or times out), the
+    // environment won't be changed.
+    if (result.isNone()) {
+      continue;
+    } else if (result.get().isSome()) {
       executorInfo.mutable_command()->mutable_environment()->CopyFrom(
-          result.get());
-    } else if (result.isError()) {
+          result.get().get());
+    } else if (result.get().isError()) {
       LOG(WARNING) << "Slave environment decorator hook failed for module '"
-                   << name << "': " << result.error();
+                   << name << "': " << result.get().error();
+      failed(name);
     }
   }
 
@@ -171,17 +367,45 @@ Environment HookManager::slaveExecutorEnvironmentDecorator(
 }
 
 
+// Runs the hook of a module on the worker of the module.
+static void _slaveRemoveExecutorHook(
+    const string& name,
+    Hook* hook,
+    const std::shared_ptr<HookMetrics>& metrics,
+    const FrameworkInfo& frameworkInfo,
+    const ExecutorInfo& executorInfo)
+{
+  const Try<Nothing>& result =
+    hook->slaveRemoveExecutorHook(frameworkInfo, executorInfo);
+
+  if (result.isError()) {
+    LOG(WARNING) << "Slave remove executor hook failed for module '"
+                 << name << "': " << result.error();
+
+    ++metrics->errors;
+  }
+}
+
+
 void HookManager::slaveRemoveExecutorHook(
     const FrameworkInfo& frameworkInfo,
     const ExecutorInfo& executorInfo)
 {
+  Lock lock(&mutex);
+
+  // The slave does not depend on the result of this hook, so it is
+  // not waited for at all.
   foreachpair (const string& name, Hook* hook, availableHooks) {
-    const Try<Nothing>& result =
-      hook->slaveRemoveExecutorHook(frameworkInfo, executorInfo);
-    if (result.isError()) {
-      LOG(WARNING) << "Slave remove executor hook failed for module '"
-                   << name << "': " << result.error();
-    }
+    CHECK(workers.contains(name));
+    const std::shared_ptr<HookWorker>& worker = workers[name];
+
+    worker->enqueue(lambda::bind(
+        &_slaveRemoveExecutorHook,
+        name,
+        hook,
+        worker->metrics,
+        frameworkInfo,
+        executorInfo));
   }
 }
 
@@ -29,6 +29,12 @@
 namespace mesos {
 namespace internal {
 
+// NOTE: The hooks of a module are invoked one after another on a
+// thread of its own. The decorator hooks of a module are waited for
+// for a bounded amount of time, after which their result is ignored
+// (see 'hooks/<module>/abandoned'), and the remove executor hooks are
+// not waited for at all. Hence a module must not expect its hooks to
+// be invoked on the thread of the master or slave.
 class HookManager
 {
 public:
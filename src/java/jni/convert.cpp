@@ -19,10 +19,16 @@
 #include <jni.h>
 
 #include <string>
+#include <vector>
 #include <assert.h>
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
 #include <mesos/mesos.hpp>
 
+#include <stout/foreach.hpp>
+
 #include <stout/result.hpp>
 #include <stout/strings.hpp>
 
@@ -36,6 +42,7 @@
 using namespace mesos;
 
 using std::string;
+using std::vector;
 
 // Facilities for loading Mesos-related classes with the correct
 // ClassLoader. Unfortunately, JNI's FindClass uses the system
@@ -472,6 +479,43 @@ jobject convert(JNIEnv* env, const Offer& offer)
 }
 
 
+jobject convert(JNIEnv* env, const vector<Offer>& offers, string* buffer)
+{
+  // The offers are serialized one after the other, each preceded by
+  // its size, into a buffer that Java reads in place (a direct
+  // ByteBuffer) to parse them all in one call.
+  buffer->clear();
+
+  {
+    google::protobuf::io::StringOutputStream output(buffer);
+    google::protobuf::io::CodedOutputStream stream(&output);
+
+    foreach (const Offer& offer, offers) {
+      stream.WriteVarint32(offer.ByteSize());
+      offer.SerializeWithCachedSizes(&stream);
+    }
+  }
+
+  jobject jbuffer = env->NewDirectByteBuffer(
+      const_cast<char*>(buffer->data()), buffer->size());
+
+  // List offers = MesosSchedulerDriver.parseOffers(buffer);
+  jclass clazz = FindMesosClass(env, "org/apache/mesos/MesosSchedulerDriver");
+
+  jmethodID parseOffers =
+    env->GetStaticMethodID(clazz, "parseOffers",
+                           "(Ljava/nio/ByteBuffer;)Ljava/util/List;");
+
+  jobject joffers = env->CallStaticObjectMethod(clazz, parseOffers, jbuffer);
+
+  if (env->ExceptionCheck()) {
+    return NULL;
+  }
+
+  return joffers;
+}
+
+
 template <>
 jobject convert(JNIEnv* env, const ExecutorInfo& executor)
 {
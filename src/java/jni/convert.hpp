@@ -21,11 +21,24 @@
 
 #include <jni.h>
 
+#include <string>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+
 #include <stout/result.hpp>
 
 template <typename T>
 jobject convert(JNIEnv* env, const T& t);
 
+// Converts all the offers into a java.util.List at once, rather than
+// one by one, using 'buffer' (which can be reused across calls) to
+// hand them over to Java. Returns NULL if a Java exception is thrown.
+jobject convert(
+    JNIEnv* env,
+    const std::vector<mesos::Offer>& offers,
+    std::string* buffer);
+
 Result<jfieldID> getFieldID(
     JNIEnv* env,
     jclass clazz,
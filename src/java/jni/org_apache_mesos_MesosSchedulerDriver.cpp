@@ -73,6 +73,10 @@ public:
   JavaVM* jvm;
   JNIEnv* env;
   jweak jdriver;
+
+  // Reused to serialize the offers handed over to Java in one batch
+  // (see 'resourceOffers').
+  string buffer;
 };
 
 
@@ -202,18 +206,15 @@ void JNIScheduler::resourceOffers(SchedulerDriver* driver,
 		     "(Lorg/apache/mesos/SchedulerDriver;"
 		     "Ljava/util/List;)V");
 
-  // List offers = new ArrayList();
-  clazz = env->FindClass("java/util/ArrayList");
-
-  jmethodID _init_ = env->GetMethodID(clazz, "<init>", "()V");
-  jobject joffers = env->NewObject(clazz, _init_);
-
-  jmethodID add = env->GetMethodID(clazz, "add", "(Ljava/lang/Object;)Z");
+  // List offers = ..;
+  jobject joffers = convert(env, offers, &buffer);
 
-  // Loop through C++ vector and add each offer to the Java list.
-  foreach (const Offer& offer, offers) {
-    jobject joffer = convert<Offer>(env, offer);
-    env->CallBooleanMethod(joffers, add, joffer);
+  if (joffers == NULL) {
+    env->ExceptionDescribe();
+    env->ExceptionClear();
+    jvm->DetachCurrentThread();
+    driver->abort();
+    return;
   }
 
   env->ExceptionClear();
@@ -986,6 +987,26 @@ JNIEXPORT jobject JNICALL Java_org_apache_mesos_MesosSchedulerDriver_reviveOffer
 }
 
 
+/*
+ * Class:     org_apache_mesos_MesosSchedulerDriver
+ * Method:    suppressOffers
+ * Signature: ()Lorg/apache/mesos/Protos/Status;
+ */
+JNIEXPORT jobject JNICALL Java_org_apache_mesos_MesosSchedulerDriver_suppressOffers
+  (JNIEnv* env, jobject thiz)
+{
+  jclass clazz = env->GetObjectClass(thiz);
+
+  jfieldID __driver = env->GetFieldID(clazz, "__driver", "J");
+  MesosSchedulerDriver* driver =
+    (MesosSchedulerDriver*) env->GetLongField(thiz, __driver);
+
+  Status status = driver->suppressOffers();
+
+  return convert<Status>(env, status);
+}
+
+
 /*
  * Class:     org_apache_mesos_MesosSchedulerDriver
  * Method:    requestResources
@@ -1073,4 +1094,142 @@ JNIEXPORT jobject JNICALL Java_org_apache_mesos_MesosSchedulerDriver_reconcileTa
   return convert<Status>(env, status);
 }
 
+
+/*
+ * Class:     org_apache_mesos_MesosSchedulerDriver
+ * Method:    killTasks
+ * Signature: (Ljava/util/Collection;)Lorg/apache/mesos/Protos/Status;
+ */
+JNIEXPORT jobject JNICALL Java_org_apache_mesos_MesosSchedulerDriver_killTasks
+  (JNIEnv* env, jobject thiz, jobject jtaskIds)
+{
+  // Construct a C++ TaskID from each Java TaskID.
+  vector<TaskID> taskIds;
+
+  jclass clazz = env->GetObjectClass(jtaskIds);
+
+  // Iterator iterator = taskIds.iterator();
+  jmethodID iterator =
+    env->GetMethodID(clazz, "iterator", "()Ljava/util/Iterator;");
+  jobject jiterator = env->CallObjectMethod(jtaskIds, iterator);
+
+  clazz = env->GetObjectClass(jiterator);
+
+  // while (iterator.hasNext()) {
+  jmethodID hasNext = env->GetMethodID(clazz, "hasNext", "()Z");
+
+  jmethodID next = env->GetMethodID(clazz, "next", "()Ljava/lang/Object;");
+
+  while (env->CallBooleanMethod(jiterator, hasNext)) {
+    // Object taskId = iterator.next();
+    jobject jtaskId = env->CallObjectMethod(jiterator, next);
+    const TaskID& taskId = construct<TaskID>(env, jtaskId);
+    taskIds.push_back(taskId);
+  }
+
+  // Now invoke the underlying driver.
+  clazz = env->GetObjectClass(thiz);
+
+  jfieldID __driver = env->GetFieldID(clazz, "__driver", "J");
+  MesosSchedulerDriver* driver =
+    (MesosSchedulerDriver*) env->GetLongField(thiz, __driver);
+
+  Status status = driver->killTasks(taskIds);
+
+  return convert<Status>(env, status);
+}
+
+
+/*
+ * Class:     org_apache_mesos_MesosSchedulerDriver
+ * Method:    declineOffers
+ * Signature: (Ljava/util/Collection;Lorg/apache/mesos/Protos/Filters;)Lorg/apache/mesos/Protos/Status;
+ */
+JNIEXPORT jobject JNICALL Java_org_apache_mesos_MesosSchedulerDriver_declineOffers
+  (JNIEnv* env, jobject thiz, jobject jofferIds, jobject jfilters)
+{
+  // Construct a C++ OfferID from each Java OfferID.
+  vector<OfferID> offerIds;
+
+  jclass clazz = env->GetObjectClass(jofferIds);
+
+  // Iterator iterator = offerIds.iterator();
+  jmethodID iterator =
+    env->GetMethodID(clazz, "iterator", "()Ljava/util/Iterator;");
+  jobject jiterator = env->CallObjectMethod(jofferIds, iterator);
+
+  clazz = env->GetObjectClass(jiterator);
+
+  // while (iterator.hasNext()) {
+  jmethodID hasNext = env->GetMethodID(clazz, "hasNext", "()Z");
+
+  jmethodID next = env->GetMethodID(clazz, "next", "()Ljava/lang/Object;");
+
+  while (env->CallBooleanMethod(jiterator, hasNext)) {
+    // Object offerId = iterator.next();
+    jobject jofferId = env->CallObjectMethod(jiterator, next);
+    const OfferID& offerId = construct<OfferID>(env, jofferId);
+    offerIds.push_back(offerId);
+  }
+
+  // Construct a C++ Filters from the Java Filters.
+  const Filters& filters = construct<Filters>(env, jfilters);
+
+  // Now invoke the underlying driver.
+  clazz = env->GetObjectClass(thiz);
+
+  jfieldID __driver = env->GetFieldID(clazz, "__driver", "J");
+  MesosSchedulerDriver* driver =
+    (MesosSchedulerDriver*) env->GetLongField(thiz, __driver);
+
+  Status status = driver->declineOffers(offerIds, filters);
+
+  return convert<Status>(env, status);
+}
+
+
+/*
+ * Class:     org_apache_mesos_MesosSchedulerDriver
+ * Method:    acknowledgeStatusUpdates
+ * Signature: (Ljava/util/Collection;)Lorg/apache/mesos/Protos/Status;
+ */
+JNIEXPORT jobject JNICALL Java_org_apache_mesos_MesosSchedulerDriver_acknowledgeStatusUpdates
+  (JNIEnv* env, jobject thiz, jobject jstatuses)
+{
+  // Construct a C++ TaskStatus from each Java TaskStatus.
+  vector<TaskStatus> statuses;
+
+  jclass clazz = env->GetObjectClass(jstatuses);
+
+  // Iterator iterator = statuses.iterator();
+  jmethodID iterator =
+    env->GetMethodID(clazz, "iterator", "()Ljava/util/Iterator;");
+  jobject jiterator = env->CallObjectMethod(jstatuses, iterator);
+
+  clazz = env->GetObjectClass(jiterator);
+
+  // while (iterator.hasNext()) {
+  jmethodID hasNext = env->GetMethodID(clazz, "hasNext", "()Z");
+
+  jmethodID next = env->GetMethodID(clazz, "next", "()Ljava/lang/Object;");
+
+  while (env->CallBooleanMethod(jiterator, hasNext)) {
+    // Object status = iterator.next();
+    jobject jstatus = env->CallObjectMethod(jiterator, next);
+    const TaskStatus& status = construct<TaskStatus>(env, jstatus);
+    statuses.push_back(status);
+  }
+
+  // Now invoke the underlying driver.
+  clazz = env->GetObjectClass(thiz);
+
+  jfieldID __driver = env->GetFieldID(clazz, "__driver", "J");
+  MesosSchedulerDriver* driver =
+    (MesosSchedulerDriver*) env->GetLongField(thiz, __driver);
+
+  Status status = driver->acknowledgeStatusUpdates(statuses);
+
+  return convert<Status>(env, status);
+}
+
 } // extern "C" {
@@ -20,6 +20,11 @@ package org.apache.mesos;
 
 import org.apache.mesos.Protos.*;
 
+import java.io.IOException;
+import java.io.InputStream;
+
+import java.nio.ByteBuffer;
+
 import java.util.ArrayList;
 import java.util.Collection;
 import java.util.Collections;
@@ -276,6 +281,8 @@ public class MesosSchedulerDriver implements SchedulerDriver {
 
   public native Status killTask(TaskID taskId);
 
+  public native Status killTasks(Collection<TaskID> taskIds);
+
   public native Status acceptOffers(Collection<OfferID> offerIds,
                                     Collection<Offer.Operation> operations,
                                     Filters filters);
@@ -286,10 +293,18 @@ public class MesosSchedulerDriver implements SchedulerDriver {
 
   public native Status declineOffer(OfferID offerId, Filters filters);
 
+  public native Status declineOffers(Collection<OfferID> offerIds,
+                                     Filters filters);
+
   public native Status reviveOffers();
 
+  public native Status suppressOffers();
+
   public native Status acknowledgeStatusUpdate(TaskStatus status);
 
+  public native Status acknowledgeStatusUpdates(
+      Collection<TaskStatus> statuses);
+
   public native Status sendFrameworkMessage(ExecutorID executorId,
                                             SlaveID slaveId,
                                             byte[] data);
@@ -299,6 +314,41 @@ public class MesosSchedulerDriver implements SchedulerDriver {
   protected native void initialize();
   protected native void finalize();
 
+  // Parses the offers which the native library serialized one after
+  // the other (each preceded by its size, like 'writeDelimitedTo'),
+  // so that all the offers of a callback are handed over at once. The
+  // buffer refers to native memory which is only valid during the
+  // call, so it must not be kept.
+  private static List<Offer> parseOffers(final ByteBuffer buffer)
+      throws IOException {
+    InputStream input = new InputStream() {
+      @Override
+      public int read() {
+        return buffer.hasRemaining() ? buffer.get() & 0xFF : -1;
+      }
+
+      @Override
+      public int read(byte[] bytes, int offset, int length) {
+        if (!buffer.hasRemaining()) {
+          return -1;
+        }
+
+        length = Math.min(length, buffer.remaining());
+        buffer.get(bytes, offset, length);
+        return length;
+      }
+    };
+
+    List<Offer> offers = new ArrayList<Offer>();
+
+    Offer offer;
+    while ((offer = Offer.parseDelimitedFrom(input)) != null) {
+      offers.add(offer);
+    }
+
+    return offers;
+  }
+
   private final Scheduler scheduler;
   private final FrameworkInfo framework;
   private final String master;
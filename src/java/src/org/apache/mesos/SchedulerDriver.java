@@ -185,6 +185,16 @@ public interface SchedulerDriver {
    */
   Status killTask(TaskID taskId);
 
+  /**
+   * Kills the specified tasks, like {@link #killTask} but with a
+   * single message to the master.
+   *
+   * @param taskIds The IDs of the tasks to be killed.
+   *
+   * @return        The state of the driver after the call.
+   */
+  Status killTasks(Collection<TaskID> taskIds);
+
   /**
    * Accepts the given offers and performs a sequence of operations on
    * those accepted offers. See Offer.Operation in mesos.proto for the
@@ -239,6 +249,22 @@ public interface SchedulerDriver {
    */
   Status declineOffer(OfferID offerId);
 
+  /**
+   * Declines the specified offers, like {@link #declineOffer} but
+   * with a single message to the master. The offers may belong to
+   * different slaves.
+   *
+   * @param offerIds  The IDs of the offers to be declined.
+   * @param filters   The filters to set for any remaining resources.
+   *
+   * @return          The state of the driver after the call.
+   *
+   * @see OfferID
+   * @see Filters
+   * @see Status
+   */
+  Status declineOffers(Collection<OfferID> offerIds, Filters filters);
+
   /**
    * Removes all filters, previously set by the framework (via {@link
    * #launchTasks}). This enables the framework to receive offers
@@ -250,6 +276,17 @@ public interface SchedulerDriver {
    */
   Status reviveOffers();
 
+  /**
+   * Informs Mesos to stop sending offers to the framework until
+   * {@link #reviveOffers} is called, e.g., because the framework
+   * has no more work to do.
+   *
+   * @return    The state of the driver after the call.
+   *
+   * @see Status
+   */
+  Status suppressOffers();
+
   /**
    * Acknowledges the status update. This should only be called
    * once the status update is processed durably by the scheduler.
@@ -265,6 +302,19 @@ public interface SchedulerDriver {
    */
   Status acknowledgeStatusUpdate(TaskStatus status);
 
+  /**
+   * Acknowledges the status updates, like {@link
+   * #acknowledgeStatusUpdate} but with a single message to the
+   * master.
+   *
+   * @param statuses  The statuses to acknowledge.
+   *
+   * @return          The state of the driver after the call.
+   *
+   * @see TaskStatus
+   */
+  Status acknowledgeStatusUpdates(Collection<TaskStatus> statuses);
+
   /**
    * Sends a message from the framework to one of its executors. These
    * messages are best effort; do not expect a framework message to be
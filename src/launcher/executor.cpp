@@ -23,6 +23,7 @@
 
 #include <iostream>
 #include <list>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -41,6 +42,7 @@
 
 #include <stout/duration.hpp>
 #include <stout/flags.hpp>
+#include <stout/fs.hpp>
 #include <stout/path.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/lambda.hpp>
@@ -51,6 +53,8 @@
 #include "common/http.hpp"
 #include "common/status_utils.hpp"
 
+#include "health-check/health_checker.hpp"
+
 #include "logging/logging.hpp"
 
 #include "messages/messages.hpp"
@@ -72,16 +76,43 @@ namespace internal {
 
 using namespace process;
 
+// Returns the words of the shell command 'command' if it can be
+// executed directly rather than via 'sh -c', i.e., if it is just a
+// list of words without any quoting, variables, redirections,
+// globbing, etc. This saves forking a shell for every simple task.
+static Option<vector<string>> words(const string& command)
+{
+  foreach (char c, command) {
+    if (!isalnum(c) && string(" -_./,:@+").find(c) == string::npos) {
+      return None();
+    }
+  }
+
+  vector<string> tokens = strings::tokenize(command, " ");
+  if (tokens.empty()) {
+    return None();
+  }
+
+  return tokens;
+}
+
+
 class CommandExecutorProcess : public ProtobufProcess<CommandExecutorProcess>
 {
 public:
-  CommandExecutorProcess(Option<char**> override, const string& _healthCheckDir)
+  CommandExecutorProcess(
+      Option<char**> override,
+      const string& _healthCheckDir,
+      const Option<Duration>& _idleTimeout)
     : launched(false),
       killed(false),
       killedByHealthCheck(false),
+      shuttingDown(false),
       pid(-1),
       healthPid(-1),
+      checker(NULL),
       escalationTimeout(slave::EXECUTOR_SIGNAL_ESCALATION_TIMEOUT),
+      idleTimeout(_idleTimeout),
       driver(None()),
       healthCheckDir(_healthCheckDir),
       override(override) {}
@@ -143,6 +174,34 @@ public:
       }
     }
 
+    // A reusable executor runs each task in a directory of its own
+    // so that a task neither sees nor removes what the previous ones
+    // left behind, see 'createTaskDirectory()'.
+    Option<string> directory = None();
+    if (idleTimeout.isSome()) {
+      Try<string> create = createTaskDirectory(task.task_id());
+      if (create.isError()) {
+        cerr << "Failed to create the directory of task " << task.task_id()
+             << ": " << create.error() << endl;
+
+        TaskStatus status;
+        status.mutable_task_id()->MergeFrom(task.task_id());
+        status.set_state(TASK_FAILED);
+        status.set_message(
+            "Failed to create the task directory: " + create.error());
+
+        driver->sendStatusUpdate(status);
+
+        Clock::cancel(idleTimer);
+        idle(driver);
+        return;
+      }
+
+      directory = create.get();
+    }
+
+    Clock::cancel(idleTimer);
+
     cout << "Starting task " << task.task_id() << endl;
 
     // TODO(benh): Clean this up with the new 'Fork' abstraction.
@@ -168,12 +227,25 @@ public:
       abort();
     }
 
+    // A shell command that does not need a shell is executed
+    // directly (see 'words()' above).
+    Option<vector<string>> direct = None();
+    if (override.isNone() && task.command().shell()) {
+      direct = words(task.command().value());
+    }
+
+    const vector<string> arguments = direct.isSome()
+      ? direct.get()
+      : vector<string>(
+            task.command().arguments().begin(),
+            task.command().arguments().end());
+
     // Prepare the argv before fork as it's not async signal safe.
-    char **argv = new char*[task.command().arguments().size() + 1];
-    for (int i = 0; i < task.command().arguments().size(); i++) {
-      argv[i] = (char*) task.command().arguments(i).c_str();
+    char **argv = new char*[arguments.size() + 1];
+    for (size_t i = 0; i < arguments.size(); i++) {
+      argv[i] = (char*) arguments[i].c_str();
     }
-    argv[task.command().arguments().size()] = NULL;
+    argv[arguments.size()] = NULL;
 
     // Prepare the command log message.
     string command;
@@ -184,6 +256,8 @@ public:
       for (int i = 0; argv[i] != NULL; i++) {
         command += string(argv[i]) + " ";
       }
+    } else if (direct.isSome()) {
+      command = "[" + strings::join(", ", direct.get()) + "]";
     } else if (task.command().shell()) {
       command = "sh -c '" + task.command().value() + "'";
     } else {
@@ -230,11 +304,23 @@ public:
 
       os::close(pipes[1]);
 
+      if (directory.isSome() && chdir(directory.get().c_str()) < 0) {
+        perror("Failed to change into the task directory");
+        abort();
+      }
+
       cout << command << endl;
 
       // The child has successfully setsid, now run the command.
       if (override.isNone()) {
         if (task.command().shell()) {
+          // If the direct exec fails (e.g., the first word is a shell
+          // builtin like 'cd' or 'exit') we fall back to the shell,
+          // which then also reports any errors as usual.
+          if (direct.isSome()) {
+            execvp(argv[0], argv);
+          }
+
           execl(
               "/bin/sh",
               "sh",
@@ -290,11 +376,10 @@ public:
 
   void killTask(ExecutorDriver* driver, const TaskID& taskId)
   {
-    shutdown(driver);
-    if (healthPid != -1) {
-      // Cleanup health check process.
-      ::kill(healthPid, SIGKILL);
-    }
+    cout << "Killing task " << taskId << endl;
+
+    kill();
+    stopHealthCheck();
   }
 
   void frameworkMessage(ExecutorDriver* driver, const string& data) {}
@@ -303,6 +388,50 @@ public:
   {
     cout << "Shutting down" << endl;
 
+    shuttingDown = true;
+
+    // An idle executor (see 'idle()') has nothing to wait for.
+    if (!launched && idleTimeout.isSome()) {
+      Clock::cancel(idleTimer);
+      driver->stop();
+      return;
+    }
+
+    kill();
+  }
+
+  virtual void error(ExecutorDriver* driver, const string& message) {}
+
+protected:
+  virtual void initialize()
+  {
+    install<TaskHealthStatus>(
+        &CommandExecutorProcess::taskHealthUpdated,
+        &TaskHealthStatus::task_id,
+        &TaskHealthStatus::healthy,
+        &TaskHealthStatus::kill_task);
+
+    // Remember what the sandbox contains before the first task, see
+    // 'createTaskDirectory()'.
+    if (idleTimeout.isSome()) {
+      Try<std::list<string>> entries = os::ls(os::getcwd());
+      if (entries.isError()) {
+        cerr << "Failed to list the sandbox: " << entries.error() << endl;
+      } else {
+        sandbox.insert(entries.get().begin(), entries.get().end());
+      }
+    }
+  }
+
+  virtual void finalize()
+  {
+    stopHealthCheck();
+  }
+
+  // Kills the process tree of the task (if any), escalating to
+  // SIGKILL after 'escalationTimeout'.
+  void kill()
+  {
     if (pid > 0 && !killed) {
       cout << "Sending SIGTERM to process tree at pid "
            << pid << endl;
@@ -333,18 +462,6 @@ public:
     }
   }
 
-  virtual void error(ExecutorDriver* driver, const string& message) {}
-
-protected:
-  virtual void initialize()
-  {
-    install<TaskHealthStatus>(
-        &CommandExecutorProcess::taskHealthUpdated,
-        &TaskHealthStatus::task_id,
-        &TaskHealthStatus::healthy,
-        &TaskHealthStatus::kill_task);
-  }
-
   void taskHealthUpdated(
       const TaskID& taskID,
       const bool& healthy,
@@ -382,6 +499,8 @@ private:
 
     Clock::cancel(escalationTimer);
 
+    stopHealthCheck();
+
     if (!status_.isReady()) {
       state = TASK_FAILED;
       message =
@@ -419,12 +538,83 @@ private:
 
     driver->sendStatusUpdate(taskStatus);
 
+    if (idleTimeout.isSome() && !shuttingDown) {
+      idle(driver);
+      return;
+    }
+
     // A hack for now ... but we need to wait until the status update
     // is sent to the slave before we shut ourselves down.
     os::sleep(Seconds(1));
     driver->stop();
   }
 
+  // Prepares the executor for the next task once its task terminated
+  // and shuts it down if no task is launched within 'idleTimeout'.
+  void idle(ExecutorDriver* driver)
+  {
+    launched = false;
+    killed = false;
+    killedByHealthCheck = false;
+    pid = -1;
+
+    cout << "Waiting up to " << idleTimeout.get()
+         << " for another task" << endl;
+
+    idleTimer = delay(idleTimeout.get(), self(), &Self::idled, driver);
+  }
+
+  void idled(ExecutorDriver* driver)
+  {
+    if (launched) {
+      return;
+    }
+
+    cout << "No task launched within " << idleTimeout.get()
+         << ", shutting down" << endl;
+
+    driver->stop();
+  }
+
+  // Creates 'tasks/<task id>' in the sandbox for a task to run in,
+  // with links to what the sandbox contained before the first task
+  // (i.e., the fetched URIs and the stdout and stderr of the
+  // executor). Nothing gets removed, the directories of all tasks
+  // are garbage collected along with the sandbox.
+  Try<string> createTaskDirectory(const TaskID& taskId)
+  {
+    // The master makes sure that a task ID does not contain a '/'.
+    if (taskId.value() == "." || taskId.value() == "..") {
+      return Error("Invalid task ID '" + taskId.value() + "'");
+    }
+
+    const string sandbox_ = os::getcwd();
+    const string directory = path::join(sandbox_, "tasks", taskId.value());
+
+    Try<Nothing> mkdir = os::mkdir(directory);
+    if (mkdir.isError()) {
+      return Error(
+          "Failed to create '" + directory + "': " + mkdir.error());
+    }
+
+    foreach (const string& entry, sandbox) {
+      const string link = path::join(directory, entry);
+
+      // The task ID might have been used before.
+      if (os::exists(link)) {
+        continue;
+      }
+
+      Try<Nothing> symlink = fs::symlink(path::join(sandbox_, entry), link);
+      if (symlink.isError()) {
+        return Error(
+            "Failed to link '" + link + "': " + symlink.error());
+      }
+    }
+
+    return directory;
+  }
+
   void escalated()
   {
     cout << "Process " << pid << " did not terminate after "
@@ -454,7 +644,19 @@ private:
 
   void launchHealthCheck(const TaskInfo& task)
   {
-    if (task.has_health_check()) {
+    // TCP and HTTP checks do not run any commands so we perform them
+    // in-process rather than launching 'mesos-health-check'.
+    if (task.has_health_check() && !task.health_check().has_command()) {
+      cout << "Starting in-process health check" << endl;
+
+      checker = new HealthCheckerProcess(
+          task.health_check(),
+          self(),
+          task.task_id());
+
+      spawn(checker);
+      dispatch(checker, &HealthCheckerProcess::healthCheck);
+    } else if (task.has_health_check()) {
       JSON::Object json = JSON::Protobuf(task.health_check());
 
       // Launch the subprocess using 'exec' style so that quotes can
@@ -490,13 +692,34 @@ private:
     }
   }
 
+  void stopHealthCheck()
+  {
+    if (healthPid != -1) {
+      // Cleanup health check process.
+      ::kill(healthPid, SIGKILL);
+      healthPid = -1;
+    }
+
+    if (checker != NULL) {
+      terminate(checker);
+      wait(checker);
+      delete checker;
+      checker = NULL;
+    }
+  }
+
   bool launched;
   bool killed;
   bool killedByHealthCheck;
+  bool shuttingDown;
   pid_t pid;
   pid_t healthPid;
+  HealthCheckerProcess* checker;
   Duration escalationTimeout;
   Timer escalationTimer;
+  Option<Duration> idleTimeout;
+  Timer idleTimer;
+  std::set<string> sandbox;
   Option<ExecutorDriver*> driver;
   string healthCheckDir;
   Option<char**> override;
@@ -506,9 +729,13 @@ private:
 class CommandExecutor: public Executor
 {
 public:
-  CommandExecutor(Option<char**> override, string healthCheckDir)
+  CommandExecutor(
+      Option<char**> override,
+      string healthCheckDir,
+      const Option<Duration>& idleTimeout)
   {
-    process = new CommandExecutorProcess(override, healthCheckDir);
+    process =
+      new CommandExecutorProcess(override, healthCheckDir, idleTimeout);
     spawn(process);
   }
 
@@ -594,11 +821,18 @@ public:
         "subsequent 'argv' to be used with 'execvp'",
         false);
 
+    add(&idle_timeout,
+        "idle_timeout",
+        "If set, the executor keeps running for this long after its task\n"
+        "terminated in order to run another task (see the slave flag\n"
+        "--command_executor_idle_timeout), rather than shutting down.");
+
     // TODO(nnielsen): Add 'prefix' option to enable replacing
     // 'sh -c' with user specified wrapper.
   }
 
   bool override;
+  Option<Duration> idle_timeout;
 };
 
 
@@ -635,7 +869,10 @@ int main(int argc, char** argv)
   if (path.empty()) {
     path = os::realpath(dirname(argv[0])).get();
   }
-  mesos::internal::CommandExecutor executor(override, path);
+  mesos::internal::CommandExecutor executor(
+      override,
+      path,
+      flags.idle_timeout);
   mesos::MesosExecutorDriver driver(&executor);
   return driver.run() == mesos::DRIVER_STOPPED ? EXIT_SUCCESS : EXIT_FAILURE;
 }
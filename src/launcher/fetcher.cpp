@@ -16,12 +16,29 @@
  * limitations under the License.
  */
 
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <mesos/mesos.hpp>
 
 #include <mesos/fetcher/fetcher.hpp>
 
+#include <process/future.hpp>
+#include <process/subprocess.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/json.hpp>
 #include <stout/net.hpp>
 #include <stout/option.hpp>
@@ -29,6 +46,8 @@
 #include <stout/protobuf.hpp>
 #include <stout/strings.hpp>
 
+#include "common/status_utils.hpp"
+
 #include "hdfs/hdfs.hpp"
 
 #include "logging/flags.hpp"
@@ -45,47 +64,17 @@ using mesos::fetcher::FetcherInfo;
 
 using mesos::internal::slave::Fetcher;
 
-using std::string;
-
+using process::Future;
+using process::Subprocess;
+using process::subprocess;
 
-// Try to extract sourcePath into directory. If sourcePath is
-// recognized as an archive it will be extracted and true returned;
-// if not recognized then false will be returned. An Error is
-// returned if the extraction command fails.
-static Try<bool> extract(
-    const string& sourcePath,
-    const string& destinationDirectory)
-{
-  string command;
-  // Extract any .tgz, tar.gz, tar.bz2 or zip files.
-  if (strings::endsWith(sourcePath, ".tgz") ||
-      strings::endsWith(sourcePath, ".tar.gz") ||
-      strings::endsWith(sourcePath, ".tbz2") ||
-      strings::endsWith(sourcePath, ".tar.bz2") ||
-      strings::endsWith(sourcePath, ".txz") ||
-      strings::endsWith(sourcePath, ".tar.xz")) {
-    command = "tar -C '" + destinationDirectory + "' -xf";
-  } else if (strings::endsWith(sourcePath, ".zip")) {
-    command = "unzip -d '" + destinationDirectory + "'";
-  } else {
-    return false;
-  }
-
-  command += " '" + sourcePath + "'";
-
-  LOG(INFO) << "Extracting with command: " << command;
-
-  int status = os::system(command);
-  if (status != 0) {
-    return Error("Failed to extract: command " + command +
-                 " exited with status: " + stringify(status));
-  }
+using std::string;
+using std::vector;
 
-  LOG(INFO) << "Extracted '" << sourcePath << "' into '"
-            << destinationDirectory << "'";
 
-  return true;
-}
+// Number of attempts to download a URI with libcurl. Attempts after
+// the first one resume the download where the previous one failed.
+static const int DOWNLOAD_ATTEMPTS = 3;
 
 
 // Attempt to get the uri using the hadoop client.
@@ -121,6 +110,15 @@ static Try<string> downloadWithNet(
             << "' to '" << destinationPath << "'";
 
   Try<int> code = net::download(sourceUri, destinationPath);
+
+  for (int attempt = 1; attempt < DOWNLOAD_ATTEMPTS && code.isError();
+       attempt++) {
+    LOG(WARNING) << "Failed to download resource from '" << sourceUri
+                 << "': " << code.error() << "; resuming the download";
+
+    code = net::download(sourceUri, destinationPath, true);
+  }
+
   if (code.isError()) {
     return Error("Error downloading resource: " + code.error());
   } else if (code.get() != 200) {
@@ -132,25 +130,91 @@ static Try<string> downloadWithNet(
 }
 
 
-static Try<string> copyFile(
-    const string& sourcePath,
-    const string& destinationPath)
+// Returns the output of 'sha256sum' for the file at 'path'. The
+// command is executed directly rather than through a shell since the
+// path is derived from the URI.
+static Try<string> sha256sum(const string& path)
 {
-  const string command = "cp '" + sourcePath + "' '" + destinationPath + "'";
+  int pipes[2];
+  if (::pipe(pipes) < 0) {
+    return ErrnoError("Failed to create a pipe");
+  }
 
-  LOG(INFO) << "Copying resource with command:" << command;
+  pid_t pid = ::fork();
 
-  int status = os::system(command);
-  if (status != 0) {
-    return Error("Failed to copy with command '" + command +
-                 "', exit status: " + stringify(status));
+  if (pid < 0) {
+    ErrnoError error("Failed to fork");
+    os::close(pipes[0]);
+    os::close(pipes[1]);
+    return error;
   }
 
-  return destinationPath;
+  if (pid == 0) {
+    ::close(pipes[0]);
+
+    if (::dup2(pipes[1], STDOUT_FILENO) < 0) {
+      ::_exit(EXIT_FAILURE);
+    }
+
+    ::execlp("sha256sum", "sha256sum", "--", path.c_str(), (char*) NULL);
+    ::_exit(EXIT_FAILURE);
+  }
+
+  os::close(pipes[1]);
+
+  string out;
+  char buffer[BUFSIZ];
+  ssize_t length;
+
+  while ((length = ::read(pipes[0], buffer, sizeof(buffer))) != 0) {
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    out.append(buffer, length);
+  }
+
+  os::close(pipes[0]);
+
+  int status;
+  while (::waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      return ErrnoError("Failed to wait for sha256sum");
+    }
+  }
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return Error("sha256sum exited with status " + stringify(status));
+  }
+
+  return out;
 }
 
 
-static Try<string> download(
+// Verifies that the SHA-256 digest of the file at 'path' is
+// 'checksum'.
+static Try<Nothing> verify(const string& path, const string& checksum)
+{
+  Try<string> out = sha256sum(path);
+  if (out.isError()) {
+    return Error("Failed to compute checksum: " + out.error());
+  }
+
+  const vector<string> tokens = strings::tokenize(out.get(), " ");
+
+  if (tokens.empty() || tokens[0] != strings::lower(checksum)) {
+    return Error("Checksum mismatch: expected " + checksum + " but got " +
+                 (tokens.empty() ? "nothing" : tokens[0]));
+  }
+
+  return Nothing();
+}
+
+
+static Try<string> _download(
     const string& sourceUri,
     const string& destinationPath,
     const Option<string>& frameworksHome)
@@ -169,7 +233,7 @@ static Try<string> download(
   if (sourcePath.isError()) {
     return Error(sourcePath.error());
   } else if (sourcePath.isSome()) {
-    return copyFile(sourcePath.get(), destinationPath);
+    return Fetcher::copy(sourcePath.get(), destinationPath);
   }
 
   // 2. Try to fetch URI using os::net / libcurl implementation.
@@ -194,110 +258,242 @@ static Try<string> download(
 }
 
 
-// TODO(bernd-mesos): Refactor this into stout so that we can more easily
-// chmod an exectuable. For example, we could define some static flags
-// so that someone can do: os::chmod(path, EXECUTABLE_CHMOD_FLAGS).
-static Try<string> chmodExecutable(const string& filePath)
+// Attempts to download a URI with a checksum from the cache of one
+// of the peers, starting with a random one to spread the load.
+static Try<string> downloadFromPeers(
+    const CommandInfo::URI& uri,
+    const string& destinationPath,
+    const vector<string>& peers)
 {
-  Try<Nothing> chmod = os::chmod(
-      filePath, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH);
-  if (chmod.isError()) {
-    return Error("Failed to chmod executable '" +
-                 filePath + "': " + chmod.error());
+  std::random_device random;
+  const size_t start = random() % peers.size();
+
+  for (size_t i = 0; i < peers.size(); i++) {
+    const string url = peers[(start + i) % peers.size()] +
+      "?checksum=" + strings::lower(uri.checksum());
+
+    LOG(INFO) << "Downloading from peer '" << url << "'";
+
+    Try<int> code = net::download(url, destinationPath);
+    if (code.isError()) {
+      LOG(WARNING) << "Failed to download from peer: " << code.error();
+    } else if (code.get() != 200) {
+      LOG(INFO) << "Peer does not have the file (HTTP response code: "
+                << code.get() << ")";
+    } else {
+      Try<Nothing> verified = verify(destinationPath, uri.checksum());
+      if (verified.isSome()) {
+        return destinationPath;
+      }
+
+      LOG(WARNING) << "Discarding download from peer: " << verified.error();
+    }
+
+    os::rm(destinationPath);
   }
 
-  return filePath;
+  return Error("None of the " + stringify(peers.size()) +
+               " peers has the file");
 }
 
 
-// Returns the resulting file or in case of extraction the destination
-// directory (for logging).
-static Try<string> fetchBypassingCache(
+static Try<string> download(
     const CommandInfo::URI& uri,
-    const string& sandboxDirectory,
-    const Option<string>& frameworksHome)
+    const string& destinationPath,
+    const Option<string>& frameworksHome,
+    const vector<string>& peers)
 {
-  LOG(INFO) << "Fetching directly into the sandbox directory";
+  if (uri.has_checksum() && !peers.empty()) {
+    Try<string> downloaded = downloadFromPeers(uri, destinationPath, peers);
+    if (downloaded.isSome()) {
+      return downloaded;
+    }
 
-  Try<string> basename = Fetcher::basename(uri.value());
-  if (basename.isError()) {
-    return Error("Failed to determine the basename of the URI '" +
-                 uri.value() + "' with error: " + basename.error());
+    LOG(INFO) << downloaded.error() << ", downloading from the origin";
   }
 
-  string path = path::join(sandboxDirectory, basename.get());
+  Try<string> downloaded =
+    _download(uri.value(), destinationPath, frameworksHome);
 
-  Try<string> downloaded = download(uri.value(), path, frameworksHome);
-  if (downloaded.isError()) {
-    return Error(downloaded.error());
+  if (downloaded.isError() || !uri.has_checksum()) {
+    return downloaded;
   }
 
-  if (uri.executable()) {
-    return chmodExecutable(downloaded.get());
-  } else if (uri.extract()) {
-    Try<bool> extracted = extract(path, sandboxDirectory);
-    if (extracted.isError()) {
-      return Error(extracted.error());
-    } else {
-      LOG(WARNING) << "Copying instead of extracting resource from URI with "
-                   << "'extract' flag, because it does not seem to be an "
-                   << "archive: " << uri.value();
-    }
+  Try<Nothing> verified = verify(downloaded.get(), uri.checksum());
+  if (verified.isError()) {
+    // Do not leave a corrupt file behind for a later resumption or
+    // for the cache to hand out.
+    os::rm(downloaded.get());
+
+    return Error("Failed to verify '" + downloaded.get() + "': " +
+                 verified.error());
   }
 
   return downloaded;
 }
 
 
-// Returns the resulting file or in case of extraction the destination
-// directory (for logging).
-static Try<string> fetchFromCache(
-    const FetcherInfo::Item& item,
-    const string& cacheDirectory,
-    const string& sandboxDirectory)
+// Returns the 'tar' decompression option for a tar archive that can be
+// extracted while it is being downloaded, i.e., without first writing
+// the archive to the sandbox. This excludes archives that have to be
+// verified against a checksum (or may come from peers) and zip
+// archives, which 'unzip' cannot read from a pipe.
+static Option<string> streamable(const CommandInfo::URI& uri)
 {
-  LOG(INFO) << "Fetching from cache";
+  if (!uri.extract() || uri.executable() || uri.has_checksum() ||
+      !Fetcher::isNetUri(uri.value())) {
+    return None();
+  }
 
-  Try<string> basename = Fetcher::basename(item.uri().value());
-  if (basename.isError()) {
-    return Error(basename.error());
+  const string& value = uri.value();
+
+  if (strings::endsWith(value, ".tgz") ||
+      strings::endsWith(value, ".tar.gz")) {
+    return string("z");
+  } else if (strings::endsWith(value, ".tbz2") ||
+             strings::endsWith(value, ".tar.bz2")) {
+    return string("j");
+  } else if (strings::endsWith(value, ".txz") ||
+             strings::endsWith(value, ".tar.xz")) {
+    return string("J");
   }
 
-  string destinationPath = path::join(sandboxDirectory, basename.get());
+  return None();
+}
+
 
-  string sourcePath = path::join(cacheDirectory, item.cache_filename());
+// Extracts a tar archive into the sandbox directory while it is
+// being downloaded by piping the download into 'tar', so that the
+// archive is only read and written once.
+static Try<string> downloadAndExtract(
+    const CommandInfo::URI& uri,
+    const string& option,
+    const string& sandboxDirectory)
+{
+  // NOTE: The sandbox directory is passed as an argument rather than
+  // through a shell (see Fetcher::extract).
+  const vector<string> argv =
+    {"tar", "-C", sandboxDirectory, "-x" + option + "f", "-"};
+
+  const string command = "[" + strings::join(", ", argv) + "]";
+
+  LOG(INFO) << "Downloading resource from '" << uri.value()
+            << "' and extracting with command: " << command;
+
+  Future<Option<int>> status;
+  int fd;
+
+  {
+    Try<Subprocess> tar = subprocess(
+        argv[0],
+        argv,
+        Subprocess::PIPE(),
+        Subprocess::FD(STDOUT_FILENO),
+        Subprocess::FD(STDERR_FILENO));
 
-  if (item.uri().executable()) {
-    Try<string> copied = copyFile(sourcePath, destinationPath);
-    if (copied.isError()) {
-      return Error(copied.error());
+    if (tar.isError()) {
+      return Error("Failed to run command " + command + ": " + tar.error());
     }
 
-    return chmodExecutable(copied.get());
-  } else if (item.uri().extract()) {
-    Try<bool> extracted = extract(sourcePath, sandboxDirectory);
+    status = tar.get().status();
+
+    // NOTE: We write to a duplicate of the pipe, since the subprocess
+    // closes its end of the pipe only when it gets destructed (here).
+    fd = ::dup(tar.get().in().get());
+  }
+
+  FILE* file = fd < 0 ? NULL : fdopen(fd, "w");
+  if (file == NULL) {
+    ErrnoError error("Failed to open the pipe to command " + command);
+    if (fd >= 0) {
+      os::close(fd);
+    }
+    status.await();
+    return error;
+  }
+
+  // 'tar' exits early on a corrupt archive, after which writing to
+  // the pipe raises SIGPIPE (which aborts us, see the signal handlers
+  // of 'logging::initialize'). With SIGPIPE suppressed the write
+  // fails with EPIPE instead, which fails the download.
+  // NOTE: An error response of the server (e.g., a 404 page) is not
+  // written to the pipe at all, see 'net::download'.
+  Try<int> code = Error("Not downloaded");
+  suppress (SIGPIPE) {
+    code = net::download(uri.value(), file);
+    fclose(file);
+  }
+
+  // NOTE: This blocks the calling thread, like 'os::system' would.
+  status.await();
+
+  if (code.isError()) {
+    return Error("Error downloading resource: " + code.error());
+  } else if (code.get() != 200) {
+    return Error("Error downloading resource, received HTTP/FTP return code " +
+                 stringify(code.get()));
+  } else if (!status.isReady() || status.get().isNone()) {
+    return Error("Failed to reap command " + command);
+  } else if (status.get().get() != 0) {
+    return Error("Failed to extract: command " + command + " " +
+                 WSTRINGIFY(status.get().get()));
+  }
+
+  return sandboxDirectory;
+}
+
+
+// Downloads the URI of a cache bypassing item straight into the
+// sandbox directory. Returns the downloaded file.
+static Try<string> downloadBypassingCache(
+    const CommandInfo::URI& uri,
+    const string& sandboxDirectory,
+    const Option<string>& frameworksHome,
+    const vector<string>& peers)
+{
+  LOG(INFO) << "Fetching directly into the sandbox directory";
+
+  Try<string> basename = Fetcher::basename(uri.value());
+  if (basename.isError()) {
+    return Error("Failed to determine the basename of the URI '" +
+                 uri.value() + "' with error: " + basename.error());
+  }
+
+  return download(
+      uri,
+      path::join(sandboxDirectory, basename.get()),
+      frameworksHome,
+      peers);
+}
+
+
+// Returns the resulting file or in case of extraction the destination
+// directory (for logging).
+static Try<string> fetchBypassingCache(
+    const CommandInfo::URI& uri,
+    const string& downloaded,
+    const string& sandboxDirectory)
+{
+  if (uri.executable()) {
+    return Fetcher::chmodExecutable(downloaded);
+  } else if (uri.extract()) {
+    Try<bool> extracted = Fetcher::extract(downloaded, sandboxDirectory);
     if (extracted.isError()) {
       return Error(extracted.error());
-    } else if (extracted.get()) {
-      return sandboxDirectory;
-    } else {
+    } else if (!extracted.get()) {
       LOG(WARNING) << "Copying instead of extracting resource from URI with "
                    << "'extract' flag, because it does not seem to be an "
-                   << "archive: " << item.uri().value();
+                   << "archive: " << uri.value();
     }
   }
 
-  return copyFile(sourcePath, destinationPath);
+  return downloaded;
 }
 
 
-// Returns the resulting file or in case of extraction the destination
-// directory (for logging).
-static Try<string> fetchThroughCache(
+static Try<Nothing> validateCacheItem(
     const FetcherInfo::Item& item,
-    const Option<string>& cacheDirectory,
-    const string& sandboxDirectory,
-    const Option<string>& frameworksHome)
+    const Option<string>& cacheDirectory)
 {
   if (cacheDirectory.isNone() || cacheDirectory.get().empty()) {
     return Error("Cache directory not specified");
@@ -309,29 +505,72 @@ static Try<string> fetchThroughCache(
     return Error("No cache file name for: " + item.uri().value());
   }
 
-  if (item.action() != FetcherInfo::Item::RETRIEVE_FROM_CACHE) {
-    CHECK_EQ(FetcherInfo::Item::DOWNLOAD_AND_CACHE, item.action())
-      << "Unexpected fetcher action selector";
+  return Nothing();
+}
 
-    LOG(INFO) << "Downloading into cache";
 
-    Try<Nothing> mkdir = os::mkdir(cacheDirectory.get());
-    if (mkdir.isError()) {
-      return Error("Failed to create fetcher cache directory '" +
-                   cacheDirectory.get() + "': " + mkdir.error());
+// Downloads the URI of the item into the sandbox directory or into
+// the cache, unless it is retrieved from the cache. Returns the
+// downloaded file, if any. This is the part of fetching that is done
+// concurrently for the items.
+static Try<Option<string>> download(
+    const FetcherInfo::Item& item,
+    const Option<string>& cacheDirectory,
+    const string& sandboxDirectory,
+    const Option<string>& frameworksHome,
+    const vector<string>& peers)
+{
+  if (item.action() == FetcherInfo::Item::BYPASS_CACHE) {
+    // Streamable archives are downloaded while they are extracted,
+    // which has to happen in order (see 'fetch' below).
+    if (streamable(item.uri()).isSome()) {
+      return None();
     }
 
-    Try<string> downloaded = download(
-        item.uri().value(),
-        path::join(cacheDirectory.get(), item.cache_filename()),
-        frameworksHome);
+    Try<string> downloaded = downloadBypassingCache(
+        item.uri(),
+        sandboxDirectory,
+        frameworksHome,
+        peers);
 
     if (downloaded.isError()) {
       return Error(downloaded.error());
     }
+
+    return Some(downloaded.get());
   }
 
-  return fetchFromCache(item, cacheDirectory.get(), sandboxDirectory);
+  Try<Nothing> validated = validateCacheItem(item, cacheDirectory);
+  if (validated.isError()) {
+    return Error(validated.error());
+  }
+
+  if (item.action() == FetcherInfo::Item::RETRIEVE_FROM_CACHE) {
+    return None();
+  }
+
+  CHECK_EQ(FetcherInfo::Item::DOWNLOAD_AND_CACHE, item.action())
+    << "Unexpected fetcher action selector";
+
+  LOG(INFO) << "Downloading into cache";
+
+  Try<Nothing> mkdir = os::mkdir(cacheDirectory.get());
+  if (mkdir.isError()) {
+    return Error("Failed to create fetcher cache directory '" +
+                 cacheDirectory.get() + "': " + mkdir.error());
+  }
+
+  Try<string> downloaded = download(
+      item.uri(),
+      path::join(cacheDirectory.get(), item.cache_filename()),
+      frameworksHome,
+      peers);
+
+  if (downloaded.isError()) {
+    return Error(downloaded.error());
+  }
+
+  return Some(downloaded.get());
 }
 
 
@@ -339,27 +578,56 @@ static Try<string> fetchThroughCache(
 // directory (for logging).
 static Try<string> fetch(
     const FetcherInfo::Item& item,
+    const Option<string>& downloaded,
     const Option<string>& cacheDirectory,
     const string& sandboxDirectory,
-    const Option<string>& frameworksHome)
+    const Option<string>& frameworksHome,
+    const vector<string>& peers,
+    bool link)
 {
-  LOG(INFO) << "Fetching URI '" << item.uri().value() << "'";
-
   if (item.action() == FetcherInfo::Item::BYPASS_CACHE) {
-    return fetchBypassingCache(
+    if (downloaded.isSome()) {
+      return fetchBypassingCache(
+          item.uri(),
+          downloaded.get(),
+          sandboxDirectory);
+    }
+
+    Option<string> option = streamable(item.uri());
+    CHECK_SOME(option);
+
+    Try<string> extracted =
+      downloadAndExtract(item.uri(), option.get(), sandboxDirectory);
+
+    if (extracted.isSome()) {
+      return extracted;
+    }
+
+    // Fall back to downloading the archive into the sandbox (which
+    // resumes failed downloads) and extracting it from there.
+    LOG(WARNING) << "Failed to extract while downloading: "
+                 << extracted.error() << "; retrying without streaming";
+
+    Try<string> downloaded_ = downloadBypassingCache(
         item.uri(),
         sandboxDirectory,
-        frameworksHome);
+        frameworksHome,
+        peers);
+
+    if (downloaded_.isError()) {
+      return Error(downloaded_.error());
+    }
+
+    return fetchBypassingCache(
+        item.uri(),
+        downloaded_.get(),
+        sandboxDirectory);
   }
 
-  return fetchThroughCache(
-      item,
-      cacheDirectory,
-      sandboxDirectory,
-      frameworksHome);
+  return Fetcher::retrieve(
+      item, cacheDirectory.get(), sandboxDirectory, link);
 }
 
-
 // This "fetcher program" is invoked by the slave's fetcher actor
 // (Fetcher, FetcherProcess) to "fetch" URIs into the sandbox directory
 // of a given task. Its parameters are provided in the form of the env
@@ -412,10 +680,84 @@ int main(int argc, char* argv[])
       Option<string>::some(fetcherInfo.get().frameworks_home()) :
         Option<string>::none();
 
-  // Fetch each URI to a local file, chmod, then chown if a user is provided.
-  foreach (const FetcherInfo::Item& item, fetcherInfo.get().items()) {
+  const vector<string> peers(
+      fetcherInfo.get().peers().begin(),
+      fetcherInfo.get().peers().end());
+
+  const vector<FetcherInfo::Item> items(
+      fetcherInfo.get().items().begin(),
+      fetcherInfo.get().items().end());
+
+  // Items that bypass the cache are downloaded into the sandbox under
+  // their basename. If two of them share a basename the later one has
+  // to overwrite the earlier one, so we do not download concurrently.
+  size_t workers = std::min<size_t>(
+      std::max<uint32_t>(fetcherInfo.get().concurrent_downloads(), 1),
+      items.size());
+
+  hashset<string> basenames;
+  foreach (const FetcherInfo::Item& item, items) {
+    if (item.action() == FetcherInfo::Item::BYPASS_CACHE) {
+      Try<string> basename = Fetcher::basename(item.uri().value());
+      if (basename.isSome()) {
+        if (basenames.contains(basename.get())) {
+          workers = 1;
+          break;
+        }
+        basenames.insert(basename.get());
+      }
+    }
+  }
+
+  // First download all URIs, using up to 'workers' threads, ...
+  vector<Option<Try<Option<string>>>> downloads(items.size());
+
+  std::atomic<size_t> next(0);
+
+  auto worker = [&]() {
+    for (size_t i = next++; i < items.size(); i = next++) {
+      downloads[i] =
+        download(
+            items[i], cacheDirectory, sandboxDirectory, frameworksHome, peers);
+    }
+  };
+
+  if (workers <= 1) {
+    worker();
+  } else {
+    LOG(INFO) << "Downloading " << items.size() << " URIs with "
+              << workers << " concurrent downloads";
+
+    vector<std::thread> threads;
+    for (size_t i = 0; i < workers; i++) {
+      threads.push_back(std::thread(worker));
+    }
+
+    foreach (std::thread& thread, threads) {
+      thread.join();
+    }
+  }
+
+  // ... then chmod, extract or copy from the cache in order.
+  for (size_t i = 0; i < items.size(); i++) {
+    const FetcherInfo::Item& item = items[i];
+
+    CHECK_SOME(downloads[i]);
+
+    const Try<Option<string>>& downloaded = downloads[i].get();
+    if (downloaded.isError()) {
+      EXIT(1) << "Failed to fetch '" << item.uri().value()
+              << "': " + downloaded.error();
+    }
+
     Try<string> fetched =
-      fetch(item, cacheDirectory, sandboxDirectory, frameworksHome);
+      fetch(item,
+            downloaded.get(),
+            cacheDirectory,
+            sandboxDirectory,
+            frameworksHome,
+            peers,
+            fetcherInfo.get().link_from_cache());
     if (fetched.isError()) {
       EXIT(1) << "Failed to fetch '" << item.uri().value()
               << "': " + fetched.error();
@@ -427,9 +769,11 @@ int main(int argc, char* argv[])
 
   // Recursively chown the sandbox directory if a user is provided.
   if (fetcherInfo.get().has_user()) {
-    Try<Nothing> chowned = os::chown(
+    Try<Nothing> chowned = Fetcher::chown(
         fetcherInfo.get().user(),
-        sandboxDirectory);
+        sandboxDirectory,
+        fetcherInfo.get().link_from_cache() ?
+          cacheDirectory : Option<string>::none());
     if (chowned.isError()) {
       EXIT(1) << "Failed to chown " << sandboxDirectory
               << ": " << chowned.error();
@@ -23,11 +23,13 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include <sys/epoll.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <fstream>
 #include <list>
 #include <map>
@@ -39,13 +41,17 @@
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
+#include <process/id.hpp>
 #include <process/io.hpp>
+#include <process/once.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/reap.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
@@ -59,6 +65,7 @@
 
 #include "linux/cgroups.hpp"
 #include "linux/fs.hpp"
+#include "linux/numa.hpp"
 
 using namespace process;
 
@@ -1193,125 +1200,285 @@ static Try<Nothing> unregisterNotifier(int fd)
 }
 
 
-// The process listening on an event notifier. This class is internal
-// to the cgroup code and assumes parameters are valid. See the
-// comments of the public interface 'listen' for its usage.
-class Listener : public Process<Listener>
+// The process listening on all the event notifiers of this process.
+// The eventfds of the notifiers are added to a single epoll set which
+// is polled by this process, rather than polling each eventfd from a
+// process per notifier. This class is internal to the cgroup code and
+// assumes parameters are valid. See the comments of the public
+// interface 'listen' for its usage.
+class Multiplexer : public Process<Multiplexer>
 {
 public:
-  Listener(const string& _hierarchy,
-           const string& _cgroup,
-           const string& _control,
-           const Option<string>& _args)
-    : hierarchy(_hierarchy),
-      cgroup(_cgroup),
-      control(_control),
-      args(_args),
-      data(0) {}
+  static Multiplexer* instance()
+  {
+    static Multiplexer* singleton = NULL;
+    static Once* initialized = new Once();
 
-  virtual ~Listener() {}
+    if (!initialized->once()) {
+      singleton = new Multiplexer();
+      spawn(singleton);
+      initialized->done();
+    }
 
-  // Waits for the next event to occur, at which point the future
-  // becomes ready. Returns a failure if error occurs. If any previous
-  // call to 'listen' returns a failure, all subsequent calls to
-  // 'listen' will return failures as well (in that case, the user
-  // should consider terminate this process and create a new one if
-  // he/she still wants to monitor the events).
-  // TODO(chzhcn): If the user discards the returned future, currently
-  // we do not do anything. Consider a better discard semantics here.
-  Future<uint64_t> listen()
+    return singleton;
+  }
+
+  virtual ~Multiplexer() {}
+
+  // Registers an eventfd "notifier" for the given control and returns
+  // its ID, which can be used to wait for its events until the
+  // notifier gets removed.
+  Future<uint64_t> add(
+      const string& hierarchy,
+      const string& cgroup,
+      const string& control,
+      const Option<string>& args)
   {
     if (error.isSome()) {
       return Failure(error.get());
     }
 
-    if (promise.isNone()) {
-      promise = Owned<Promise<uint64_t>>(new Promise<uint64_t>());
+    Try<int> fd = registerNotifier(hierarchy, cgroup, control, args);
+    if (fd.isError()) {
+      return Failure(
+          "Failed to register notification eventfd: " + fd.error());
+    }
 
-      // Perform nonblocking read on the event file. The nonblocking
-      // read will start polling on the event file until it becomes
-      // readable. If we can successfully read 8 bytes (sizeof
-      // uint64_t) from the event file, it indicates that an event has
-      // occurred.
-      reading = io::read(eventfd.get(), &data, sizeof(data));
-      reading.onAny(defer(self(), &Listener::_listen));
+    // The notifiers are identified by a number rather than by their
+    // eventfd, since an eventfd gets reused once it is closed.
+    const uint64_t id = nextId++;
+
+    // The eventfd is only polled while its next event is waited for,
+    // see 'next'.
+    struct epoll_event event;
+    event.events = 0;
+    event.data.u64 = id;
+
+    if (::epoll_ctl(epollfd, EPOLL_CTL_ADD, fd.get(), &event) < 0) {
+      ErrnoError error("Failed to add eventfd to the epoll set");
+      unregisterNotifier(fd.get());
+      return Failure(error);
     }
 
-    return promise.get()->future();
+    notifiers[id].eventfd = fd.get();
+
+    return id;
+  }
+
+  // Waits for the next event to occur, at which point the future
+  // becomes ready. Returns a failure if error occurs. If any previous
+  // call to 'next' returns a failure, all subsequent calls to 'next'
+  // will return failures as well (in that case, the user should
+  // consider removing the notifier and adding a new one if he/she
+  // still wants to monitor the events).
+  Future<uint64_t> next(uint64_t id)
+  {
+    if (!notifiers.contains(id)) {
+      return Failure("Event listener is removed");
+    }
+
+    Notifier& notifier = notifiers[id];
+
+    if (notifier.error.isSome()) {
+      return Failure(notifier.error.get());
+    }
+
+    if (notifier.promise.isNone()) {
+      Try<Nothing> arm = this->arm(id, notifier.eventfd);
+      if (arm.isError()) {
+        notifier.error = Error(arm.error());
+        return Failure(notifier.error.get());
+      }
+
+      notifier.promise = Owned<Promise<uint64_t>>(new Promise<uint64_t>());
+
+      if (!polling.isPending()) {
+        poll();
+      }
+    }
+
+    return notifier.promise.get()->future();
+  }
+
+  // Unregisters the notifier. An event that is still waited for gets
+  // discarded.
+  void remove(uint64_t id)
+  {
+    if (!notifiers.contains(id)) {
+      return;
+    }
+
+    Notifier& notifier = notifiers[id];
+
+    if (notifier.promise.isSome()) {
+      notifier.promise.get()->discard();
+    }
+
+    if (::epoll_ctl(epollfd, EPOLL_CTL_DEL, notifier.eventfd, NULL) < 0) {
+      PLOG(ERROR) << "Failed to remove eventfd from the epoll set";
+    }
+
+    Try<Nothing> unregister = unregisterNotifier(notifier.eventfd);
+    if (unregister.isError()) {
+      LOG(ERROR) << "Failed to unregister eventfd: " << unregister.error();
+    }
+
+    notifiers.erase(id);
   }
 
 protected:
   virtual void initialize()
   {
-    // Register an eventfd "notifier" for the given control.
-    Try<int> fd = registerNotifier(hierarchy, cgroup, control, args);
-    if (fd.isError()) {
-      error = Error("Failed to register notification eventfd: " + fd.error());
-    } else {
-      // Remember the opened event file descriptor.
-      eventfd = fd.get();
+    epollfd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epollfd < 0) {
+      error = ErrnoError("Failed to create an epoll set");
     }
   }
 
   virtual void finalize()
   {
-    // Discard the nonblocking read.
-    reading.discard();
-
-    // Unregister the eventfd if needed.
-    if (eventfd.isSome()) {
-      Try<Nothing> unregister = unregisterNotifier(eventfd.get());
-      if (unregister.isError()) {
-        LOG(ERROR) << "Failed to unregister eventfd: " << unregister.error();
-      }
+    // Discard the nonblocking poll.
+    polling.discard();
+
+    foreach (uint64_t id, notifiers.keys()) {
+      remove(id);
     }
 
-    // TODO(chzhcn): Fail our promise only after 'reading' has
-    // completed (ready, failed or discarded).
-    if (promise.isSome()) {
-      promise.get()->fail("Event listener is terminating");
+    if (epollfd >= 0) {
+      os::close(epollfd);
     }
   }
 
 private:
-  // This function is called when the nonblocking read on the eventfd has
-  // result, either because the event has happened, or an error has occurred.
-  void _listen()
+  struct Notifier
+  {
+    int eventfd;
+    Option<Owned<Promise<uint64_t>>> promise;
+    Option<Error> error;
+  };
+
+  Multiplexer()
+    : ProcessBase(ID::generate("cgroups-event-multiplexer")),
+      epollfd(-1),
+      nextId(0) {}
+
+  // Enables the eventfd in the epoll set until it is readable next,
+  // i.e., the epoll set only reports it once per call to 'next'.
+  Try<Nothing> arm(uint64_t id, int eventfd)
+  {
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = id;
+
+    if (::epoll_ctl(epollfd, EPOLL_CTL_MOD, eventfd, &event) < 0) {
+      return ErrnoError("Failed to poll eventfd");
+    }
+
+    return Nothing();
+  }
+
+  void poll()
   {
-    CHECK_SOME(promise);
+    // The epoll set becomes readable once any of the eventfds in it
+    // does, i.e., once an event has occurred.
+    polling = io::poll(epollfd, io::READ);
+    polling.onAny(defer(self(), &Self::_poll));
+  }
 
-    if (reading.isReady() && reading.get() == sizeof(data)) {
-      promise.get()->set(data);
+  // This function is called when the epoll set is readable, or an
+  // error has occurred.
+  void _poll()
+  {
+    if (!polling.isReady()) {
+      error = Error(
+          "Failed to poll the epoll set: " +
+          (polling.isFailed() ? polling.failure() : "discarded"));
+
+      // Inform failure and not listen again.
+      foreachvalue (Notifier& notifier, notifiers) {
+        notifier.error = error;
+
+        if (notifier.promise.isSome()) {
+          notifier.promise.get()->fail(error.get().message);
+          notifier.promise = None();
+        }
+      }
 
-      // After fulfilling the promise, reset to get ready for the next one.
-      promise = None();
       return;
     }
 
-    if (reading.isDiscarded()) {
-      error = Error("Reading eventfd stopped unexpectedly");
-    } else if (reading.isFailed()) {
-      error = Error("Failed to read eventfd: " + reading.failure());
-    } else {
-      error = Error("Read less than expected. Expect " +
-                    stringify(sizeof(data)) + " bytes; actual " +
-                    stringify(reading.get()) + " bytes");
+    // NOTE: If more eventfds are readable than fit into 'events' the
+    // epoll set stays readable, i.e., the next poll completes right
+    // away.
+    struct epoll_event events[64];
+
+    int count = ::epoll_wait(epollfd, events, 64, 0);
+    if (count < 0 && errno != EINTR) {
+      PLOG(ERROR) << "Failed to wait on the epoll set";
     }
 
-    // Inform failure and not listen again.
-    promise.get()->fail(error.get().message);
-  }
+    for (int i = 0; i < count; i++) {
+      const uint64_t id = events[i].data.u64;
 
-  const string hierarchy;
-  const string cgroup;
-  const string control;
-  const Option<string> args;
+      if (!notifiers.contains(id)) {
+        continue;
+      }
+
+      Notifier& notifier = notifiers[id];
+
+      if (notifier.promise.isNone()) {
+        continue;
+      }
+
+      // If we can successfully read 8 bytes (sizeof uint64_t) from
+      // the eventfd, it indicates that an event has occurred.
+      uint64_t data;
+      ssize_t length = ::read(notifier.eventfd, &data, sizeof(data));
+
+      if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        // Spurious wakeup, poll the eventfd again.
+        Try<Nothing> arm = this->arm(id, notifier.eventfd);
+        if (arm.isSome()) {
+          continue;
+        }
+
+        notifier.error = Error(arm.error());
+        notifier.promise.get()->fail(notifier.error.get().message);
+      } else if (length == sizeof(data)) {
+        notifier.promise.get()->set(data);
+      } else {
+        if (length < 0) {
+          notifier.error = ErrnoError("Failed to read eventfd");
+        } else {
+          notifier.error = Error(
+              "Read less than expected. Expect " +
+              stringify(sizeof(data)) + " bytes; actual " +
+              stringify(length) + " bytes");
+        }
 
-  Option<Owned<Promise<uint64_t>>> promise;
-  Future<size_t> reading;
+        // Inform failure and not listen again.
+        notifier.promise.get()->fail(notifier.error.get().message);
+      }
+
+      // After fulfilling the promise, reset to get ready for the next
+      // one.
+      notifier.promise = None();
+    }
+
+    // Keep polling as long as there are notifiers, even if none of
+    // them is waited for, in which case the poll just stays pending.
+    if (!notifiers.empty()) {
+      poll();
+    }
+  }
+
+  int epollfd;
   Option<Error> error;
-  Option<int> eventfd;
-  uint64_t data;                // The data read from the eventfd last time.
+
+  Future<short> polling;
+
+  uint64_t nextId;
+  hashmap<uint64_t, Notifier> notifiers;
 };
 
 
@@ -1326,25 +1493,29 @@ Future<uint64_t> listen(
     return Failure(error.get());
   }
 
-  Listener* listener = new Listener(hierarchy, cgroup, control, args);
-
-  spawn(listener, true);
+  return dispatch(
+      Multiplexer::instance(),
+      &Multiplexer::add,
+      hierarchy,
+      cgroup,
+      control,
+      args)
+    .then([](uint64_t id) {
+      Future<uint64_t> future =
+        dispatch(Multiplexer::instance(), &Multiplexer::next, id);
 
-  Future<uint64_t> future = dispatch(listener, &Listener::listen);
+      // If the user doesn't care any more, or listening has had a
+      // result, remove the notifier.
+      auto remove = [id]() {
+        dispatch(Multiplexer::instance(), &Multiplexer::remove, id);
+      };
 
-  // If the user doesn't care any more, or listening has had a result,
-  // terminate the listener.
-  future
-    .onDiscard(lambda::bind(
-        static_cast<void (*)(const UPID&, bool)>(terminate),
-        listener->self(),
-        true))
-    .onAny(lambda::bind(
-        static_cast<void (*)(const UPID&, bool)>(terminate),
-        listener->self(),
-        true));
+      future
+        .onDiscard(remove)
+        .onAny(remove);
 
-  return future;
+      return future;
+    });
 }
 
 } // namespace event {
@@ -1387,6 +1558,21 @@ Try<Nothing> state(
 
 } // namespace freezer {
 
+
+// The freezer does not notify about state changes, so the processes
+// below poll for them. A cgroup usually freezes, thaws or empties
+// within a few milliseconds, hence we start polling at a short
+// interval and back off exponentially up to a maximum interval.
+const Duration MIN_POLL_INTERVAL = Milliseconds(1);
+const Duration MAX_POLL_INTERVAL = Milliseconds(100);
+
+
+static Duration backoff(const Duration& interval)
+{
+  return std::min(interval * 2, MAX_POLL_INTERVAL);
+}
+
+
 class Freezer : public Process<Freezer>
 {
 public:
@@ -1395,7 +1581,8 @@ public:
       const string& _cgroup)
     : hierarchy(_hierarchy),
       cgroup(_cgroup),
-      start(Clock::now()) {}
+      start(Clock::now()),
+      interval(MIN_POLL_INTERVAL) {}
 
   virtual ~Freezer() {}
 
@@ -1426,7 +1613,8 @@ public:
     }
 
     // Attempt to freeze the freezer cgroup again.
-    delay(Milliseconds(100), self(), &Self::freeze);
+    delay(interval, self(), &Self::freeze);
+    interval = backoff(interval);
   }
 
   void thaw()
@@ -1455,7 +1643,8 @@ public:
     }
 
     // Attempt to thaw the freezer cgroup again.
-    delay(Milliseconds(100), self(), &Self::thaw);
+    delay(interval, self(), &Self::thaw);
+    interval = backoff(interval);
   }
 
   Future<Nothing> future() { return promise.future(); }
@@ -1484,6 +1673,7 @@ private:
   const string hierarchy;
   const string cgroup;
   const Time start;
+  Duration interval; // The interval until the next attempt.
   Promise<Nothing> promise;
 };
 
@@ -1493,7 +1683,9 @@ class TasksKiller : public Process<TasksKiller>
 {
 public:
   TasksKiller(const string& _hierarchy, const string& _cgroup)
-    : hierarchy(_hierarchy), cgroup(_cgroup) {}
+    : hierarchy(_hierarchy),
+      cgroup(_cgroup),
+      interval(MIN_POLL_INTERVAL) {}
 
   virtual ~TasksKiller() {}
 
@@ -1515,6 +1707,7 @@ protected:
   virtual void finalize()
   {
     chain.discard();
+    emptied.discard();
 
     // TODO(jieyu): Wait until 'chain' is in DISCARDED state before
     // discarding 'promise'.
@@ -1543,11 +1736,27 @@ private:
   }
 
   void killTasks() {
+    // Don't bother freezing a cgroup whose processes have all exited
+    // already, which is common when destroying a container.
+    Try<set<pid_t> > processes = cgroups::processes(hierarchy, cgroup);
+    if (processes.isError()) {
+      promise.fail(processes.error());
+      terminate(self());
+      return;
+    }
+
+    if (processes.get().empty()) {
+      promise.set(Nothing());
+      terminate(self());
+      return;
+    }
+
     // Chain together the steps needed to kill all tasks in the cgroup.
     chain = freeze()                     // Freeze the cgroup.
       .then(defer(self(), &Self::kill))  // Send kill signal.
       .then(defer(self(), &Self::thaw))  // Thaw cgroup to deliver signal.
-      .then(defer(self(), &Self::reap)); // Wait until all pids are reaped.
+      .then(defer(self(), &Self::empty)) // Wait until all pids exited.
+      .then(defer(self(), &Self::reap)); // Wait until our pids are reaped.
 
     chain.onAny(defer(self(), &Self::finished, lambda::_1));
   }
@@ -1569,14 +1778,23 @@ private:
     }
 
     // Reaping the frozen pids before we kill (and thaw) ensures we reap the
-    // correct pids.
+    // correct pids. We only reap our own children since the others are
+    // reaped by their parents (or init) and we instead wait for them to
+    // leave the cgroup, see 'empty()'.
     foreach (const pid_t pid, processes.get()) {
-      statuses.push_back(process::reap(pid));
+      Result<os::Process> process = os::process(pid);
+      if (process.isSome() && process.get().parent == ::getpid()) {
+        statuses.push_back(process::reap(pid));
+      }
     }
 
-    Try<Nothing> kill = cgroups::kill(hierarchy, cgroup, SIGKILL);
-    if (kill.isError()) {
-      return Failure(kill.error());
+    // The processes can't fork while the cgroup is frozen, so we
+    // signal the ones read above rather than reading them again.
+    foreach (const pid_t pid, processes.get()) {
+      if (::kill(pid, SIGKILL) == -1 && errno != ESRCH) {
+        return Failure(
+            ErrnoError("Failed to kill process " + stringify(pid)));
+      }
     }
 
     return Nothing();
@@ -1587,9 +1805,41 @@ private:
     return cgroups::freezer::thaw(hierarchy, cgroup);
   }
 
+  // Waits until the cgroup is empty. Unlike reaping the pids of all
+  // processes, whose poll interval grows with the number of pids
+  // being reaped across all cgroups, this lets many cgroups that are
+  // destroyed together finish as soon as their processes exit.
+  Future<Nothing> empty()
+  {
+    poll();
+    return emptied.future();
+  }
+
+  void poll()
+  {
+    if (emptied.future().hasDiscard()) {
+      emptied.discard();
+      return;
+    }
+
+    Try<set<pid_t> > processes = cgroups::processes(hierarchy, cgroup);
+    if (processes.isError()) {
+      emptied.fail(processes.error());
+      return;
+    }
+
+    if (processes.get().empty()) {
+      emptied.set(Nothing());
+      return;
+    }
+
+    delay(interval, self(), &Self::poll);
+    interval = backoff(interval);
+  }
+
   Future<list<Option<int> > > reap()
   {
-    // Wait until we've reaped all processes.
+    // Wait until we've reaped all our processes.
     return collect(statuses);
   }
 
@@ -1622,7 +1872,9 @@ private:
   const string hierarchy;
   const string cgroup;
   Promise<Nothing> promise;
-  list<Future<Option<int> > > statuses; // List of statuses for processes.
+  Promise<Nothing> emptied; // Set once the cgroup is empty.
+  Duration interval; // The interval until the next poll.
+  list<Future<Option<int> > > statuses; // List of statuses for our processes.
   Future<list<Option<int> > > chain; // Used to discard all operations.
 };
 
@@ -1997,6 +2249,56 @@ Try<Nothing> cfs_quota_us(
 } // namespace cpu {
 
 
+namespace cpuset {
+
+Try<Nothing> cpus(
+    const string& hierarchy,
+    const string& cgroup,
+    const set<int>& cpus)
+{
+  return cgroups::write(hierarchy, cgroup, "cpuset.cpus", numa::format(cpus));
+}
+
+
+Try<set<int>> cpus(
+    const string& hierarchy,
+    const string& cgroup)
+{
+  Try<string> read = cgroups::read(hierarchy, cgroup, "cpuset.cpus");
+
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  return numa::parse(read.get());
+}
+
+
+Try<Nothing> mems(
+    const string& hierarchy,
+    const string& cgroup,
+    const set<int>& mems)
+{
+  return cgroups::write(hierarchy, cgroup, "cpuset.mems", numa::format(mems));
+}
+
+
+Try<set<int>> mems(
+    const string& hierarchy,
+    const string& cgroup)
+{
+  Try<string> read = cgroups::read(hierarchy, cgroup, "cpuset.mems");
+
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  return numa::parse(read.get());
+}
+
+} // namespace cpuset {
+
+
 namespace memory {
 
 Result<string> cgroup(pid_t pid)
@@ -2258,21 +2560,19 @@ ostream& operator << (ostream& stream, Level level)
 }
 
 
-// The process drives the event::Listener to keep listening on cgroups
-// memory pressure counters.
+// The process keeps listening on cgroups memory pressure counters
+// through the event::Multiplexer, registering the counter only once.
 class CounterProcess : public Process<CounterProcess>
 {
 public:
-  CounterProcess(const string& hierarchy,
-                 const string& cgroup,
-                 Level level)
-    : value_(0),
-      error(None()),
-      process(new event::Listener(
-          hierarchy,
-          cgroup,
-          "memory.pressure_level",
-          stringify(level))) {}
+  CounterProcess(const string& _hierarchy,
+                 const string& _cgroup,
+                 Level _level)
+    : hierarchy(_hierarchy),
+      cgroup(_cgroup),
+      level(_level),
+      value_(0),
+      error(None()) {}
 
   virtual ~CounterProcess() {}
 
@@ -2288,20 +2588,38 @@ public:
 protected:
   virtual void initialize()
   {
-    spawn(CHECK_NOTNULL(process.get()));
-    listen();
+    notifier = dispatch(
+        event::Multiplexer::instance(),
+        &event::Multiplexer::add,
+        hierarchy,
+        cgroup,
+        "memory.pressure_level",
+        Option<string>(stringify(level)));
+
+    notifier.onAny(defer(self(), &CounterProcess::listen));
   }
 
   virtual void finalize()
   {
-    terminate(process.get());
-    wait(process.get());
+    notifier.onReady([](uint64_t id) {
+      dispatch(event::Multiplexer::instance(), &event::Multiplexer::remove, id);
+    });
   }
 
 private:
   void listen()
   {
-    dispatch(process.get(), &event::Listener::listen)
+    if (!notifier.isReady()) {
+      error = Error(
+          "Failed to register notifier: " +
+          (notifier.isFailed() ? notifier.failure() : "discarded"));
+      return;
+    }
+
+    dispatch(
+        event::Multiplexer::instance(),
+        &event::Multiplexer::next,
+        notifier.get())
       .onAny(defer(self(), &CounterProcess::_listen, lambda::_1));
   }
 
@@ -2319,9 +2637,13 @@ private:
     }
   }
 
+  const string hierarchy;
+  const string cgroup;
+  const Level level;
+
   uint64_t value_;
   Option<Error> error;
-  process::Owned<event::Listener> process;
+  Future<uint64_t> notifier;
 };
 
 
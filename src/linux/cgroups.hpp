@@ -432,6 +432,37 @@ Try<Nothing> cfs_quota_us(
 } // namespace cpu {
 
 
+// Cpuset controls.
+namespace cpuset {
+
+// Sets the cpus using cpuset.cpus.
+Try<Nothing> cpus(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const std::set<int>& cpus);
+
+
+// Returns the cpus from cpuset.cpus.
+Try<std::set<int>> cpus(
+    const std::string& hierarchy,
+    const std::string& cgroup);
+
+
+// Sets the memory nodes using cpuset.mems.
+Try<Nothing> mems(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const std::set<int>& mems);
+
+
+// Returns the memory nodes from cpuset.mems.
+Try<std::set<int>> mems(
+    const std::string& hierarchy,
+    const std::string& cgroup);
+
+} // namespace cpuset {
+
+
 // Memory controls.
 namespace memory {
 
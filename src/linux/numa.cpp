@@ -0,0 +1,160 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "linux/numa.hpp"
+
+using std::list;
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace numa {
+
+static const string NODES = "/sys/devices/system/node";
+static const string ONLINE_CPUS = "/sys/devices/system/cpu/online";
+
+
+Try<set<int>> parse(const string& list)
+{
+  set<int> result;
+
+  foreach (const string& token, strings::tokenize(strings::trim(list), ",")) {
+    vector<string> bounds = strings::split(token, "-");
+
+    if (bounds.size() == 1) {
+      Try<int> id = numify<int>(bounds[0]);
+      if (id.isError() || id.get() < 0) {
+        return Error("Invalid id '" + bounds[0] + "' in '" + list + "'");
+      }
+
+      result.insert(id.get());
+    } else if (bounds.size() == 2) {
+      Try<int> begin = numify<int>(bounds[0]);
+      Try<int> end = numify<int>(bounds[1]);
+      if (begin.isError() || end.isError() ||
+          begin.get() < 0 || begin.get() > end.get()) {
+        return Error("Invalid range '" + token + "' in '" + list + "'");
+      }
+
+      for (int id = begin.get(); id <= end.get(); id++) {
+        result.insert(id);
+      }
+    } else {
+      return Error("Invalid range '" + token + "' in '" + list + "'");
+    }
+  }
+
+  return result;
+}
+
+
+string format(const set<int>& list)
+{
+  vector<string> ranges;
+
+  set<int>::const_iterator iterator = list.begin();
+  while (iterator != list.end()) {
+    int begin = *iterator;
+    int end = begin;
+
+    // Extend the range for as long as the ids are consecutive.
+    while (++iterator != list.end() && *iterator == end + 1) {
+      end = *iterator;
+    }
+
+    ranges.push_back(
+        begin == end ? stringify(begin) : stringify(begin) + "-" +
+                                          stringify(end));
+  }
+
+  return strings::join(",", ranges);
+}
+
+
+Try<map<int, set<int>>> nodes()
+{
+  map<int, set<int>> result;
+
+  if (os::exists(NODES)) {
+    Try<list<string>> entries = os::ls(NODES);
+    if (entries.isError()) {
+      return Error("Failed to list '" + NODES + "': " + entries.error());
+    }
+
+    foreach (const string& entry, entries.get()) {
+      if (!strings::startsWith(entry, "node")) {
+        continue;
+      }
+
+      Try<int> node = numify<int>(entry.substr(4));
+      if (node.isError()) {
+        continue; // Not a node, e.g., 'node_states'.
+      }
+
+      const string path = path::join(NODES, entry, "cpulist");
+
+      Try<string> read = os::read(path);
+      if (read.isError()) {
+        return Error("Failed to read '" + path + "': " + read.error());
+      }
+
+      Try<set<int>> cpus = parse(read.get());
+      if (cpus.isError()) {
+        return Error("Failed to parse '" + path + "': " + cpus.error());
+      }
+
+      // Skip memory only nodes.
+      if (!cpus.get().empty()) {
+        result[node.get()] = cpus.get();
+      }
+    }
+  }
+
+  if (result.empty()) {
+    Try<string> read = os::read(ONLINE_CPUS);
+    if (read.isError()) {
+      return Error("Failed to read '" + ONLINE_CPUS + "': " + read.error());
+    }
+
+    Try<set<int>> cpus = parse(read.get());
+    if (cpus.isError()) {
+      return Error("Failed to parse '" + ONLINE_CPUS + "': " + cpus.error());
+    }
+
+    result[0] = cpus.get();
+  }
+
+  return result;
+}
+
+} // namespace numa {
@@ -0,0 +1,48 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LINUX_NUMA_HPP__
+#define __LINUX_NUMA_HPP__
+
+#include <map>
+#include <set>
+#include <string>
+
+#include <stout/try.hpp>
+
+namespace numa {
+
+// Parses a list in the format the kernel uses for sets of cpus and
+// memory nodes (e.g., "0-3,8,10-11" in cpuset.cpus or in the
+// 'cpulist' of a node).
+Try<std::set<int>> parse(const std::string& list);
+
+
+// Formats a set of cpus or memory nodes in the kernel list format,
+// collapsing consecutive ids into ranges (e.g., "0-3,8,10-11").
+std::string format(const std::set<int>& list);
+
+
+// Returns the cpus of each NUMA node, keyed by node id, as reported
+// under /sys/devices/system/node. Machines (or kernels) without NUMA
+// support are reported as a single node 0 with all online cpus.
+Try<std::map<int, std::set<int>>> nodes();
+
+} // namespace numa {
+
+#endif // __LINUX_NUMA_HPP__
@@ -16,11 +16,16 @@
  * limitations under the License.
  */
 
+#include <fcntl.h>
 #include <signal.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#include <linux/perf_event.h>
+
 #include <sys/prctl.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
@@ -429,6 +434,306 @@ Future<hashmap<string, mesos::PerfStatistics>> sample(
 }
 
 
+namespace internal {
+
+// A generic event as understood by perf_event_open(2).
+struct Event
+{
+  uint32_t type;
+  uint64_t config;
+
+  // The field of PerfStatistics for the event.
+  string field;
+};
+
+
+// Looks up the normalized name of a generic event, as used by
+// `perf list`. Returns None for events that are not generic.
+static Option<Event> event(const string& name)
+{
+  static const hashmap<string, Event> events = {
+    {"cycles", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"}},
+    {"cpu_cycles", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"}},
+    {"stalled_cycles_frontend",
+     {PERF_TYPE_HARDWARE,
+      PERF_COUNT_HW_STALLED_CYCLES_FRONTEND,
+      "stalled_cycles_frontend"}},
+    {"stalled_cycles_backend",
+     {PERF_TYPE_HARDWARE,
+      PERF_COUNT_HW_STALLED_CYCLES_BACKEND,
+      "stalled_cycles_backend"}},
+    {"instructions",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions"}},
+    {"cache_references",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES, "cache_references"}},
+    {"cache_misses",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "cache_misses"}},
+    {"branches",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS, "branches"}},
+    {"branch_instructions",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS, "branches"}},
+    {"branch_misses",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch_misses"}},
+    {"bus_cycles",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES, "bus_cycles"}},
+    {"ref_cycles",
+     {PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES, "ref_cycles"}},
+    {"cpu_clock",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK, "cpu_clock"}},
+    {"task_clock",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, "task_clock"}},
+    {"page_faults",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, "page_faults"}},
+    {"faults",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, "page_faults"}},
+    {"minor_faults",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN, "minor_faults"}},
+    {"major_faults",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ, "major_faults"}},
+    {"context_switches",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "context_switches"}},
+    {"cs",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "context_switches"}},
+    {"cpu_migrations",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS, "cpu_migrations"}},
+    {"migrations",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS, "cpu_migrations"}},
+    {"alignment_faults",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_ALIGNMENT_FAULTS, "alignment_faults"}},
+    {"emulation_faults",
+     {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_EMULATION_FAULTS, "emulation_faults"}},
+  };
+
+  if (events.contains(name)) {
+    return events.get(name).get();
+  }
+
+  // Hardware cache events are named '<cache>_<operation>[_misses]',
+  // e.g., 'l1_dcache_load_misses' or 'llc_stores'.
+  static const hashmap<string, uint64_t> caches = {
+    {"l1_dcache", PERF_COUNT_HW_CACHE_L1D},
+    {"l1_icache", PERF_COUNT_HW_CACHE_L1I},
+    {"llc", PERF_COUNT_HW_CACHE_LL},
+    {"dtlb", PERF_COUNT_HW_CACHE_DTLB},
+    {"itlb", PERF_COUNT_HW_CACHE_ITLB},
+    {"branch", PERF_COUNT_HW_CACHE_BPU},
+    {"node", PERF_COUNT_HW_CACHE_NODE},
+  };
+
+  static const hashmap<string, std::pair<uint64_t, uint64_t>> operations = {
+    {"loads",
+     {PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_ACCESS}},
+    {"load_misses",
+     {PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS}},
+    {"stores",
+     {PERF_COUNT_HW_CACHE_OP_WRITE, PERF_COUNT_HW_CACHE_RESULT_ACCESS}},
+    {"store_misses",
+     {PERF_COUNT_HW_CACHE_OP_WRITE, PERF_COUNT_HW_CACHE_RESULT_MISS}},
+    {"prefetches",
+     {PERF_COUNT_HW_CACHE_OP_PREFETCH, PERF_COUNT_HW_CACHE_RESULT_ACCESS}},
+    {"prefetch_misses",
+     {PERF_COUNT_HW_CACHE_OP_PREFETCH, PERF_COUNT_HW_CACHE_RESULT_MISS}},
+  };
+
+  foreachpair (const string& cache, uint64_t id, caches) {
+    if (!strings::startsWith(name, cache + "_")) {
+      continue;
+    }
+
+    Option<std::pair<uint64_t, uint64_t>> operation =
+      operations.get(name.substr(cache.size() + 1));
+
+    if (operation.isNone() ||
+        mesos::PerfStatistics::descriptor()->FindFieldByName(name) == NULL) {
+      return None();
+    }
+
+    Event event;
+    event.type = PERF_TYPE_HW_CACHE;
+    event.config =
+      id | (operation.get().first << 8) | (operation.get().second << 16);
+    event.field = name;
+
+    return event;
+  }
+
+  return None();
+}
+
+} // namespace internal {
+
+
+Try<Owned<Counters>> Counters::open(
+    const set<string>& events,
+    const string& cgroup)
+{
+  long cpus = ::sysconf(_SC_NPROCESSORS_ONLN);
+  if (cpus <= 0) {
+    return ErrnoError("Failed to get the number of online CPUs");
+  }
+
+  Try<int> cgroupFd = os::open(cgroup, O_RDONLY | O_CLOEXEC);
+  if (cgroupFd.isError()) {
+    return Error("Failed to open cgroup '" + cgroup + "': " +
+                 cgroupFd.error());
+  }
+
+  vector<Counter> counters;
+
+  Option<Error> error;
+
+  foreach (const string& name, events) {
+    Option<internal::Event> event = internal::event(internal::normalize(name));
+    if (event.isNone()) {
+      error = Error("Event '" + name + "' cannot be counted");
+      break;
+    }
+
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = event.get().type;
+    attr.config = event.get().config;
+    attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    Counter counter;
+    counter.field = event.get().field;
+    counter.previous = 0;
+
+    for (long cpu = 0; cpu < cpus; cpu++) {
+      int fd = ::syscall(
+          __NR_perf_event_open,
+          &attr,
+          cgroupFd.get(),
+          cpu,
+          -1,
+          PERF_FLAG_PID_CGROUP | PERF_FLAG_FD_CLOEXEC);
+
+      if (fd < 0) {
+        error = ErrnoError(
+            "Failed to open a counter for event '" + name + "' on CPU " +
+            stringify(cpu));
+        break;
+      }
+
+      counter.fds.push_back(fd);
+    }
+
+    counters.push_back(counter);
+
+    if (error.isSome()) {
+      break;
+    }
+  }
+
+  os::close(cgroupFd.get());
+
+  if (error.isSome()) {
+    foreach (const Counter& counter, counters) {
+      foreach (int fd, counter.fds) {
+        os::close(fd);
+      }
+    }
+
+    return error.get();
+  }
+
+  return Owned<Counters>(new Counters(counters));
+}
+
+
+Counters::Counters(const vector<Counter>& _counters)
+  : counters(_counters),
+    previous(Clock::now()) {}
+
+
+Counters::~Counters()
+{
+  foreach (const Counter& counter, counters) {
+    foreach (int fd, counter.fds) {
+      os::close(fd);
+    }
+  }
+}
+
+
+Try<mesos::PerfStatistics> Counters::read()
+{
+  const Time now = Clock::now();
+
+  mesos::PerfStatistics statistics;
+  statistics.set_timestamp(previous.secs());
+  statistics.set_duration((now - previous).secs());
+
+  const google::protobuf::Reflection* reflection =
+    statistics.GetReflection();
+
+  foreach (Counter& counter, counters) {
+    uint64_t total = 0;
+
+    foreach (int fd, counter.fds) {
+      // The value, the time enabled and the time running, as
+      // requested with 'read_format'.
+      uint64_t values[3];
+
+      ssize_t length = ::read(fd, values, sizeof(values));
+      if (length != sizeof(values)) {
+        return ErrnoError("Failed to read a counter for " + counter.field);
+      }
+
+      // Scale up if the counter was multiplexed out for some of the
+      // time it was enabled.
+      if (values[2] > 0) {
+        total += (uint64_t) ((double) values[0] * values[1] / values[2]);
+      }
+    }
+
+    // Scaling might make the total drift backwards a little.
+    const uint64_t delta =
+      total > counter.previous ? total - counter.previous : 0;
+
+    counter.previous = total;
+
+    const google::protobuf::FieldDescriptor* field =
+      statistics.GetDescriptor()->FindFieldByName(counter.field);
+
+    CHECK_NOTNULL(field);
+
+    switch (field->type()) {
+      case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+        // The clocks count nanoseconds but are reported in
+        // milliseconds, as by `perf stat`.
+        reflection->SetDouble(
+            &statistics, field, Nanoseconds(delta).ms());
+        break;
+      case google::protobuf::FieldDescriptor::TYPE_UINT64:
+        reflection->SetUInt64(&statistics, field, delta);
+        break;
+      default:
+        return Error("Unsupported perf field type for " + counter.field);
+    }
+  }
+
+  previous = now;
+
+  return statistics;
+}
+
+
+bool countable(const set<string>& events)
+{
+  foreach (const string& event, events) {
+    if (internal::event(internal::normalize(event)).isNone()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
 bool valid(const set<string>& events)
 {
   ostringstream command;
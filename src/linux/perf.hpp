@@ -23,11 +23,15 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
+#include <process/owned.hpp>
+#include <process/time.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/try.hpp>
 
 // For PerfStatistics protobuf.
 #include "mesos/mesos.hpp"
@@ -65,6 +69,53 @@ process::Future<mesos::PerfStatistics> sample(
     const Duration& duration);
 
 
+// Event counters for the process(es) in a perf_event cgroup, opened
+// with perf_event_open(2) on every online CPU. Unlike sample(), which
+// runs `perf stat` for a duration, the counters keep counting until
+// they are destroyed and are read without forking.
+class Counters
+{
+public:
+  // Opens counters for the events in the perf_event cgroup at the
+  // absolute path 'cgroup'. All events must be countable().
+  static Try<process::Owned<Counters>> open(
+      const std::set<std::string>& events,
+      const std::string& cgroup);
+
+  ~Counters();
+
+  // Returns the counts since the previous read, or since open() for
+  // the first read. Counts are scaled up for the time the kernel had
+  // multiplexed the counters out.
+  Try<mesos::PerfStatistics> read();
+
+private:
+  struct Counter
+  {
+    // The field of PerfStatistics the event is reported in.
+    std::string field;
+
+    // One per online CPU.
+    std::vector<int> fds;
+
+    // The (scaled) total count at the previous read.
+    uint64_t previous;
+  };
+
+  Counters(const std::vector<Counter>& counters);
+
+  std::vector<Counter> counters;
+
+  // The time of the previous read.
+  process::Time previous;
+};
+
+
+// Returns whether all events can be counted with Counters, i.e.,
+// they are generic hardware, software or hardware cache events.
+bool countable(const std::set<std::string>& events);
+
+
 // Validate a set of events are accepted by `perf stat`.
 bool valid(const std::set<std::string>& events);
 
@@ -273,11 +273,13 @@ inline Try<Nothing> attach(
 }
 
 
-// Generates the handle for the given filter on the link. Returns none
-// if we decide to let the kernel choose the handle.
+// Generates the handle for the given filter using the libnl filters
+// (rtnl_cls) that are currently attached to the same parent on the
+// link (see 'getClses' below). Returns none if we decide to let the
+// kernel choose the handle.
 template <typename Classifier>
 Result<U32Handle> generateU32Handle(
-    const Netlink<struct rtnl_link>& link,
+    const std::vector<Netlink<struct rtnl_cls>>& clses,
     const Filter<Classifier>& filter)
 {
   // If the user does not specify a priority, we have no choice but
@@ -287,45 +289,19 @@ Result<U32Handle> generateU32Handle(
     return None();
   }
 
-  // Scan all the filters attached to the given parent on the link.
-  Try<Netlink<struct nl_sock>> socket = routing::socket();
-  if (socket.isError()) {
-    return Error(socket.error());
-  }
-
-  // Dump all the libnl filters (i.e., rtnl_cls) attached to the given
-  // parent on the link.
-  struct nl_cache* c = NULL;
-  int error = rtnl_cls_alloc_cache(
-      socket.get().get(),
-      rtnl_link_get_ifindex(link.get()),
-      filter.parent().get(),
-      &c);
-
-  if (error != 0) {
-    return Error(
-        "Failed to get filter info from kernel: " +
-        std::string(nl_geterror(error)));
-  }
-
-  Netlink<struct nl_cache> cache(c);
-
   // A map from priority to the corresponding 'htid'.
   hashmap<uint16_t, uint32_t> htids;
 
   // A map from 'htid' to a set of already used nodes.
   hashmap<uint32_t, hashset<uint32_t>> nodes;
 
-  for (struct nl_object* o = nl_cache_get_first(cache.get());
-       o != NULL; o = nl_cache_get_next(o)) {
-    struct rtnl_cls* cls = (struct rtnl_cls*) o;
-
+  foreach (const Netlink<struct rtnl_cls>& cls, clses) {
     // Only look at u32 filters. For other type of filters, their
     // handles are generated by the kernel correctly.
-    if (rtnl_tc_get_kind(TC_CAST(cls)) == std::string("u32")) {
-      U32Handle handle(rtnl_tc_get_handle(TC_CAST(cls)));
+    if (rtnl_tc_get_kind(TC_CAST(cls.get())) == std::string("u32")) {
+      U32Handle handle(rtnl_tc_get_handle(TC_CAST(cls.get())));
 
-      htids[rtnl_cls_get_prio(cls)] = handle.htid();
+      htids[rtnl_cls_get_prio(cls.get())] = handle.htid();
       nodes[handle.htid()].insert(handle.node());
     }
   }
@@ -353,11 +329,14 @@ Result<U32Handle> generateU32Handle(
 
 
 // Encodes a filter (in our representation) to a libnl filter
-// (rtnl_cls). We use template here so that it works for any type of
+// (rtnl_cls). The libnl filters that are currently attached to the
+// same parent on the link ('clses') are used to pick an unused handle
+// if needed. We use template here so that it works for any type of
 // classifier.
 template <typename Classifier>
 Try<Netlink<struct rtnl_cls>> encodeFilter(
     const Netlink<struct rtnl_link>& link,
+    const std::vector<Netlink<struct rtnl_cls>>& clses,
     const Filter<Classifier>& filter)
 {
   struct rtnl_cls* c = rtnl_cls_alloc();
@@ -402,7 +381,7 @@ Try<Netlink<struct rtnl_cls>> encodeFilter(
     // handle of the filter by picking an unused handle.
     // TODO(jieyu): Revisit this once the kernel bug is fixed.
     if (rtnl_tc_get_kind(TC_CAST(cls.get())) == std::string("u32")) {
-      Result<U32Handle> handle = generateU32Handle(link, filter);
+      Result<U32Handle> handle = generateU32Handle(clses, filter);
       if (handle.isError()) {
         return Error("Failed to find an unused u32 handle: " + handle.error());
       }
@@ -529,22 +508,15 @@ inline Try<std::vector<Netlink<struct rtnl_cls>>> getClses(
 }
 
 
-// Returns the libnl filter (rtnl_cls) attached to the given parent
-// that matches the specified classifier on the link. Returns None if
-// no match has been found. We use template here so that it works for
-// any type of classifier.
+// Returns the libnl filter (rtnl_cls) among 'clses' that matches the
+// specified classifier. Returns None if no match has been found. We
+// use template here so that it works for any type of classifier.
 template <typename Classifier>
 Result<Netlink<struct rtnl_cls>> getCls(
-    const Netlink<struct rtnl_link>& link,
-    const Handle& parent,
+    const std::vector<Netlink<struct rtnl_cls>>& clses,
     const Classifier& classifier)
 {
-  Try<std::vector<Netlink<struct rtnl_cls>>> clses = getClses(link, parent);
-  if (clses.isError()) {
-    return Error(clses.error());
-  }
-
-  foreach (const Netlink<struct rtnl_cls>& cls, clses.get()) {
+  foreach (const Netlink<struct rtnl_cls>& cls, clses) {
     // The decode function will return None if 'cls' does not match
     // the classifier type. In that case, we just move on to the next
     // libnl filter.
@@ -559,6 +531,25 @@ Result<Netlink<struct rtnl_cls>> getCls(
   return None();
 }
 
+
+// Returns the libnl filter (rtnl_cls) attached to the given parent
+// that matches the specified classifier on the link. Returns None if
+// no match has been found. We use template here so that it works for
+// any type of classifier.
+template <typename Classifier>
+Result<Netlink<struct rtnl_cls>> getCls(
+    const Netlink<struct rtnl_link>& link,
+    const Handle& parent,
+    const Classifier& classifier)
+{
+  Try<std::vector<Netlink<struct rtnl_cls>>> clses = getClses(link, parent);
+  if (clses.isError()) {
+    return Error(clses.error());
+  }
+
+  return getCls(clses.get(), classifier);
+}
+
 /////////////////////////////////////////////////
 // Internal filter APIs.
 /////////////////////////////////////////////////
@@ -596,26 +587,41 @@ Try<bool> exists(
 template <typename Classifier>
 Try<bool> create(const std::string& _link, const Filter<Classifier>& filter)
 {
+  Result<Netlink<struct rtnl_link>> link = link::internal::get(_link);
+  if (link.isError()) {
+    return Error(link.error());
+  } else if (link.isNone()) {
+    return Error("Link '" + _link + "' is not found");
+  }
+
+  // NOTE: We dump the filters attached to the parent only once and
+  // use them for both the existence check and picking an unused u32
+  // handle. Each dump (and decoding) is linear in the number of
+  // filters on the link, which grows with the number of containers.
+  Try<std::vector<Netlink<struct rtnl_cls>>> clses =
+    getClses(link.get(), filter.parent());
+
+  if (clses.isError()) {
+    return Error("Check filter existence failed: " + clses.error());
+  }
+
   // TODO(jieyu): Currently, we're not able to guarantee the atomicity
   // between the existence check and the following add operation. So
   // if two threads try to create the same filter, both of them may
   // succeed and end up with two filters in the kernel.
-  Try<bool> _exists = exists(_link, filter.parent(), filter.classifier());
-  if (_exists.isError()) {
-    return Error("Check filter existence failed: " + _exists.error());
-  } else if (_exists.get()) {
+  Result<Netlink<struct rtnl_cls>> existing =
+    getCls(clses.get(), filter.classifier());
+
+  if (existing.isError()) {
+    return Error("Check filter existence failed: " + existing.error());
+  } else if (existing.isSome()) {
     // The filter already exists.
     return false;
   }
 
-  Result<Netlink<struct rtnl_link>> link = link::internal::get(_link);
-  if (link.isError()) {
-    return Error(link.error());
-  } else if (link.isNone()) {
-    return Error("Link '" + _link + "' is not found");
-  }
+  Try<Netlink<struct rtnl_cls>> cls =
+    encodeFilter(link.get(), clses.get(), filter);
 
-  Try<Netlink<struct rtnl_cls>> cls = encodeFilter(link.get(), filter);
   if (cls.isError()) {
     return Error("Failed to encode the filter: " + cls.error());
   }
@@ -698,9 +704,16 @@ Try<bool> update(const std::string& _link, const Filter<Classifier>& filter)
     return false;
   }
 
+  Try<std::vector<Netlink<struct rtnl_cls>>> clses =
+    getClses(link.get(), filter.parent());
+
+  if (clses.isError()) {
+    return Error(clses.error());
+  }
+
   // Get the old libnl classifier (to-be-updated) from kernel.
   Result<Netlink<struct rtnl_cls>> oldCls =
-    getCls(link.get(), filter.parent(), filter.classifier());
+    getCls(clses.get(), filter.classifier());
 
   if (oldCls.isError()) {
     return Error(oldCls.error());
@@ -731,7 +744,9 @@ Try<bool> update(const std::string& _link, const Filter<Classifier>& filter)
         stringify(filter.handle().get().get()));
   }
 
-  Try<Netlink<struct rtnl_cls>> newCls = encodeFilter(link.get(), filter);
+  Try<Netlink<struct rtnl_cls>> newCls =
+    encodeFilter(link.get(), clses.get(), filter);
+
   if (newCls.isError()) {
     return Error("Failed to encode the new filter: " + newCls.error());
   }
@@ -0,0 +1,248 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/dqblk_xfs.h>
+#include <linux/fs.h>
+#include <linux/magic.h>
+
+#include <sys/ioctl.h>
+#include <sys/quota.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+
+#include <mutex>
+#include <string>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
+
+#include "linux/fs.hpp"
+#include "linux/xfs.hpp"
+
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace xfs {
+
+// The quota subsystem counts disk usage in "basic blocks".
+static const uint64_t BASIC_BLOCK_SIZE = 512;
+
+
+Try<bool> isXfs(const string& path)
+{
+  struct statfs buf;
+  if (::statfs(path.c_str(), &buf) < 0) {
+    return ErrnoError("Failed to statfs '" + path + "'");
+  }
+
+  return buf.f_type == XFS_SUPER_MAGIC;
+}
+
+
+// Reads the extended attributes of 'path' into 'attr'. Returns the
+// opened file descriptor, which the caller must close.
+static Try<int> getAttributes(const string& path, struct fsxattr* attr)
+{
+  Try<int> fd = os::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  if (::ioctl(fd.get(), FS_IOC_FSGETXATTR, attr) < 0) {
+    ErrnoError error("Failed to get the attributes of '" + path + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  return fd.get();
+}
+
+
+Result<uint32_t> getProjectId(const string& path)
+{
+  struct fsxattr attr;
+
+  Try<int> fd = getAttributes(path, &attr);
+  if (fd.isError()) {
+    return Error(fd.error());
+  }
+
+  os::close(fd.get());
+
+  if (attr.fsx_projid == 0) {
+    return None();
+  }
+
+  return attr.fsx_projid;
+}
+
+
+static Try<Nothing> setAttributes(
+    const string& path,
+    uint32_t projectId,
+    bool inherit)
+{
+  struct fsxattr attr;
+
+  Try<int> fd = getAttributes(path, &attr);
+  if (fd.isError()) {
+    return Error(fd.error());
+  }
+
+  attr.fsx_projid = projectId;
+
+  if (inherit) {
+    attr.fsx_xflags |= FS_XFLAG_PROJINHERIT;
+  } else {
+    attr.fsx_xflags &= ~FS_XFLAG_PROJINHERIT;
+  }
+
+  if (::ioctl(fd.get(), FS_IOC_FSSETXATTR, &attr) < 0) {
+    ErrnoError error("Failed to set the attributes of '" + path + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  os::close(fd.get());
+
+  return Nothing();
+}
+
+
+Try<Nothing> setProjectId(const string& directory, uint32_t projectId)
+{
+  if (!os::stat::isdir(directory)) {
+    return Error("'" + directory + "' is not a directory");
+  }
+
+  return setAttributes(directory, projectId, true);
+}
+
+
+// The callback of nftw() has no user data argument, so the first
+// error is recorded here. Only one tree walk may happen at a time.
+static Option<Error>* walkError = NULL;
+
+
+static int clear(
+    const char* path,
+    const struct stat* s,
+    int type,
+    struct FTW* ftw)
+{
+  // Symbolic links and special files do not carry project IDs that
+  // can be changed through a file descriptor.
+  if (type != FTW_F && type != FTW_D && type != FTW_DP) {
+    return 0;
+  }
+
+  if (!S_ISREG(s->st_mode) && !S_ISDIR(s->st_mode)) {
+    return 0;
+  }
+
+  Try<Nothing> cleared = setAttributes(path, 0, false);
+  if (cleared.isError()) {
+    *walkError = Error(cleared.error());
+    return 1;
+  }
+
+  return 0;
+}
+
+
+Try<Nothing> clearProjectId(const string& path)
+{
+  static std::mutex mutex;
+
+  synchronized (mutex) {
+    Option<Error> error;
+    walkError = &error;
+
+    int result = ::nftw(path.c_str(), clear, 32, FTW_PHYS | FTW_MOUNT);
+
+    walkError = NULL;
+
+    if (error.isSome()) {
+      return error.get();
+    } else if (result < 0) {
+      return ErrnoError("Failed to walk '" + path + "'");
+    }
+  }
+
+  return Nothing();
+}
+
+
+// Returns the block device of the filesystem on which 'path' resides,
+// as needed by quotactl().
+static Try<string> getDevice(const string& path)
+{
+  struct stat s;
+  if (::stat(path.c_str(), &s) < 0) {
+    return ErrnoError("Failed to stat '" + path + "'");
+  }
+
+  Try<fs::MountInfoTable> table = fs::MountInfoTable::read();
+  if (table.isError()) {
+    return Error("Failed to read the mount table: " + table.error());
+  }
+
+  foreach (const fs::MountInfoTable::Entry& entry, table.get().entries) {
+    if (entry.devno == s.st_dev) {
+      return entry.source;
+    }
+  }
+
+  return Error("Failed to find the device of '" + path + "'");
+}
+
+
+Try<Bytes> getProjectUsage(const string& path, uint32_t projectId)
+{
+  Try<string> device = getDevice(path);
+  if (device.isError()) {
+    return Error(device.error());
+  }
+
+  struct fs_disk_quota quota;
+  memset(&quota, 0, sizeof(quota));
+
+  if (::quotactl(
+          QCMD(Q_XGETQUOTA, PRJQUOTA),
+          device.get().c_str(),
+          projectId,
+          reinterpret_cast<caddr_t>(&quota)) < 0) {
+    return ErrnoError("Failed to get the quota of project " +
+                      stringify(projectId) + " on '" + device.get() + "'");
+  }
+
+  return Bytes(quota.d_bcount * BASIC_BLOCK_SIZE);
+}
+
+} // namespace xfs {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,70 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __XFS_HPP__
+#define __XFS_HPP__
+
+#include <stdint.h>
+
+#include <string>
+
+#include <stout/bytes.hpp>
+#include <stout/nothing.hpp>
+#include <stout/result.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace xfs {
+
+// Helpers for XFS project quotas, which account the disk usage of
+// every file tagged with a project ID to that project. A directory
+// whose project ID is set (with the inherit flag) passes it on to all
+// files created below it, so the disk usage of the directory can then
+// be read from the quota subsystem instead of walking the tree.
+//
+// NOTE: Usage is only accounted if the filesystem is mounted with
+// project quota accounting enabled (the 'prjquota' mount option).
+
+// Returns whether 'path' resides on an XFS filesystem.
+Try<bool> isXfs(const std::string& path);
+
+
+// Returns the project ID of 'path', or None if it has none (zero).
+Result<uint32_t> getProjectId(const std::string& path);
+
+
+// Sets the project ID of the directory 'directory' and marks it so
+// that files and directories created below it inherit the ID.
+Try<Nothing> setProjectId(const std::string& directory, uint32_t projectId);
+
+
+// Recursively resets the project ID of 'path' and everything below
+// it, so that the project ID can be reused for another directory.
+Try<Nothing> clearProjectId(const std::string& path);
+
+
+// Returns the disk usage accounted to the project with the given ID
+// on the filesystem on which 'path' resides.
+Try<Bytes> getProjectUsage(const std::string& path, uint32_t projectId);
+
+} // namespace xfs {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __XFS_HPP__
@@ -27,6 +27,7 @@
 
 #include <mesos/module/anonymous.hpp>
 
+#include <mesos/slave/qos_controller.hpp>
 #include <mesos/slave/resource_estimator.hpp>
 
 #include <process/limiter.hpp>
@@ -93,6 +94,7 @@ using mesos::internal::slave::StatusUpdateManager;
 using mesos::modules::Anonymous;
 using mesos::modules::ModuleManager;
 
+using mesos::slave::QoSController;
 using mesos::slave::ResourceEstimator;
 
 using process::Owned;
@@ -128,6 +130,7 @@ static vector<GarbageCollector*>* garbageCollectors = NULL;
 static vector<StatusUpdateManager*>* statusUpdateManagers = NULL;
 static vector<Fetcher*>* fetchers = NULL;
 static vector<ResourceEstimator*>* resourceEstimators = NULL;
+static vector<QoSController*>* qosControllers = NULL;
 
 
 PID<Master> launch(const Flags& flags, Allocator* _allocator)
@@ -293,6 +296,7 @@ PID<Master> launch(const Flags& flags, Allocator* _allocator)
   statusUpdateManagers = new vector<StatusUpdateManager*>();
   fetchers = new vector<Fetcher*>();
   resourceEstimators = new vector<ResourceEstimator*>();
+  qosControllers = new vector<QoSController*>();
 
   vector<UPID> pids;
 
@@ -308,9 +312,9 @@ PID<Master> launch(const Flags& flags, Allocator* _allocator)
     // Use a different work directory for each slave.
     flags.work_dir = path::join(flags.work_dir, stringify(i));
 
-    garbageCollectors->push_back(new GarbageCollector());
+    garbageCollectors->push_back(new GarbageCollector(flags));
     statusUpdateManagers->push_back(new StatusUpdateManager(flags));
-    fetchers->push_back(new Fetcher());
+    fetchers->push_back(new Fetcher(flags));
 
     Try<ResourceEstimator*> resourceEstimator =
       ResourceEstimator::create(flags.resource_estimator);
@@ -322,6 +326,16 @@ PID<Master> launch(const Flags& flags, Allocator* _allocator)
 
     resourceEstimators->push_back(resourceEstimator.get());
 
+    Try<QoSController*> qosController =
+      QoSController::create(flags.qos_controller);
+
+    if (qosController.isError()) {
+      EXIT(1) << "Failed to create QoS Controller: "
+              << qosController.error();
+    }
+
+    qosControllers->push_back(qosController.get());
+
     Try<Containerizer*> containerizer =
       Containerizer::create(flags, true, fetchers->back());
 
@@ -338,7 +352,8 @@ PID<Master> launch(const Flags& flags, Allocator* _allocator)
         files,
         garbageCollectors->back(),
         statusUpdateManagers->back(),
-        resourceEstimators->back());
+        resourceEstimators->back(),
+        qosControllers->back());
 
     slaves[containerizer.get()] = slave;
 
@@ -415,6 +430,13 @@ void shutdown()
     delete resourceEstimators;
     resourceEstimators = NULL;
 
+    foreach (QoSController* controller, *qosControllers) {
+      delete controller;
+    }
+
+    delete qosControllers;
+    qosControllers = NULL;
+
     delete registrar;
     registrar = NULL;
 
@@ -18,18 +18,24 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <list>
+#include <map>
+#include <set>
 
 #include <process/collect.hpp>
 #include <process/id.hpp>
 #include <process/process.hpp>
 #include <process/timer.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 #include <stout/stringify.hpp>
 
 #include "log/catchup.hpp"
 #include "log/consensus.hpp"
+#include "log/replica.hpp"
 
 #include "messages/log.hpp"
 
@@ -167,10 +173,23 @@ static Future<uint64_t> catchup(
 }
 
 
-// TODO(jieyu): Our current implementation catches-up each position in
-// the set sequentially. In the future, we may want to parallelize it
-// to improve the performance. Also, we may want to implement rate
-// control here so that we don't saturate the network or disk.
+// The number of positions we ask the other replicas for (learned
+// actions) in one fetch request.
+static const uint64_t FETCH_BATCH_SIZE = 1024;
+
+// The maximum number of positions we catch-up concurrently (using
+// Paxos) after fetching, see BulkCatchUpProcess.
+static const size_t MAX_CATCH_UP_WINDOW = 64;
+
+
+// Catches-up an interval of positions in two steps: first the learned
+// actions are fetched (in batches) from the other replicas, which
+// only takes a round trip per batch, and then the positions that are
+// still missing (e.g., positions the other replicas have not learned
+// either) get caught-up using Paxos. The latter happens concurrently
+// within an adaptive window: the window grows with every position
+// that got caught-up and shrinks (by half) with every position that
+// timed out so we don't saturate the network or disk.
 class BulkCatchUpProcess : public Process<BulkCatchUpProcess>
 {
 public:
@@ -187,7 +206,9 @@ public:
       network(_network),
       positions(_positions),
       timeout(_timeout),
-      proposal(_proposal) {}
+      proposal(_proposal),
+      window(1),
+      received(0) {}
 
   virtual ~BulkCatchUpProcess() {}
 
@@ -200,18 +221,32 @@ protected:
     promise.future().onDiscard(lambda::bind(
         static_cast<void(*)(const UPID&, bool)>(terminate), self(), true));
 
-    // Catch-up sequentially.
+    if (positions.lower() >= positions.upper()) {
+      // Nothing to catch-up (i.e., the input interval is empty).
+      promise.set(Nothing());
+      terminate(self());
+      return;
+    }
+
+    // Fetch sequentially.
     current = positions.lower();
 
-    catchup();
+    fetch();
   }
 
   virtual void finalize()
   {
-    catching.discard();
+    fetching.discard();
+    process::discard(responses);
+    learning.discard();
+    checking.discard();
 
-    // TODO(benh): Discard our promise only after 'catching' has
-    // completed (ready, failed, or discarded).
+    foreachvalue (Future<uint64_t> future, catching) {
+      future.discard();
+    }
+
+    // TODO(benh): Discard our promise only after all of the above
+    // have completed (ready, failed, or discarded).
     promise.discard();
   }
 
@@ -221,54 +256,236 @@ private:
     catching.discard();
   }
 
-  void catchup()
+  static Future<Nothing> expired(Future<Nothing> fetching)
+  {
+    // Use the responses we've received so far.
+    fetching.discard();
+    return Nothing();
+  }
+
+  void fetch()
   {
     if (current >= positions.upper()) {
-      // Stop the process if there is nothing left to catch-up. This
-      // also handles the case where the input interval is empty.
-      promise.set(Nothing());
+      check();
+      return;
+    }
+
+    FetchRequest request;
+    request.set_from(current);
+    request.set_to(std::min(current + FETCH_BATCH_SIZE, positions.upper()) - 1);
+
+    // No need to ask the local replica.
+    std::set<UPID> filter;
+    filter.insert(replica->pid());
+
+    fetching = network->broadcast(protocol::fetch, request, filter)
+      .then(defer(self(), &Self::broadcasted, lambda::_1))
+      .after(timeout, lambda::bind(&Self::expired, lambda::_1));
+
+    fetching.onAny(defer(self(), &Self::fetched, request));
+  }
+
+  Future<Nothing> broadcasted(
+      const std::set<Future<FetchResponse> >& _responses)
+  {
+    responses = _responses;
+    received = 0;
+    fetches.clear();
+
+    return receive();
+  }
+
+  Future<Nothing> receive()
+  {
+    // Any replica that learned an action can tell us about it but we
+    // don't wait for more than a quorum (including the local
+    // replica) of responses so we don't wait for replicas that are
+    // down.
+    if (responses.empty() || received + 1 >= quorum) {
+      process::discard(responses);
+      return Nothing();
+    }
+
+    // Instead of using a for loop here, we use select to process
+    // responses one after another so that we can ignore the rest if
+    // we have received enough responses.
+    return select(responses)
+      .then(defer(self(), &Self::_receive, lambda::_1));
+  }
+
+  Future<Nothing> _receive(const Future<FetchResponse>& response)
+  {
+    // Ignore responses for a previous fetch request (e.g., one that
+    // timed out).
+    if (responses.erase(response) == 0) {
+      return Nothing();
+    }
+
+    if (response.isReady()) {
+      received++;
+      fetches.push_back(response.get());
+    }
+
+    return receive();
+  }
+
+  void fetched(const FetchRequest& request)
+  {
+    // The future 'fetching' can only be discarded in 'finalize'.
+    CHECK(!fetching.isDiscarded());
+
+    if (fetching.isFailed()) {
+      promise.fail("Failed to fetch learned actions: " + fetching.failure());
       terminate(self());
       return;
     }
 
-    // Store the future so that we can discard it if the user wants to
-    // cancel the catch-up operation.
-    catching = log::catchup(quorum, replica, network, proposal, current)
-      .onDiscarded(defer(self(), &Self::discarded))
-      .onFailed(defer(self(), &Self::failed))
-      .onReady(defer(self(), &Self::succeeded));
+    process::discard(responses);
+    responses.clear();
+
+    // Positions that none of the responses covers are left to Paxos.
+    uint64_t to = request.to();
+
+    // The learned actions by position (different replicas reply with
+    // the same learned action for a position).
+    std::map<uint64_t, Action> actions;
+
+    for (list<FetchResponse>::const_iterator response = fetches.begin();
+         response != fetches.end();
+         ++response) {
+      if (response == fetches.begin()) {
+        to = response->to();
+      } else {
+        to = std::min(to, response->to());
+      }
+
+      foreach (const Action& action, response->actions()) {
+        if (action.position() >= request.from() &&
+            action.position() <= request.to()) {
+          actions[action.position()] = action;
+        }
+      }
+    }
+
+    fetches.clear();
+
+    to = std::max(to, request.from()); // Always make progress.
+
+    list<Action> learned;
+
+    foreachvalue (const Action& action, actions) {
+      if (action.position() <= to) {
+        learned.push_back(action);
+      }
+    }
+
+    VLOG(2) << "Fetched " << learned.size() << " learned actions from "
+            << request.from() << " to " << to;
+
+    current = to + 1;
+
+    if (learned.empty()) {
+      fetch();
+      return;
+    }
+
+    learning = replica->learn(learned);
+    learning.onAny(defer(self(), &Self::_fetched));
+  }
+
+  void _fetched()
+  {
+    // The future 'learning' can only be discarded in 'finalize'.
+    CHECK(!learning.isDiscarded());
 
-    Clock::timer(timeout, lambda::bind(&Self::timedout, catching));
+    if (learning.isFailed() || !learning.get()) {
+      promise.fail(
+          "Failed to persist the fetched actions" +
+          (learning.isFailed() ? ": " + learning.failure() : ""));
+      terminate(self());
+      return;
+    }
+
+    fetch();
   }
 
+  void check()
+  {
+    checking = replica->missing(positions.lower(), positions.upper() - 1);
+    checking.onAny(defer(self(), &Self::checked));
+  }
 
-  void discarded()
+  void checked()
   {
-    LOG(INFO) << "Unable to catch-up position " << current
-              << " in " << timeout << ", retrying";
+    // The future 'checking' can only be discarded in 'finalize'.
+    CHECK(!checking.isDiscarded());
+
+    if (checking.isFailed()) {
+      promise.fail("Failed to get missing positions: " + checking.failure());
+      terminate(self());
+      return;
+    }
+
+    missing = checking.get();
 
     catchup();
   }
 
-  void failed()
+  void catchup()
   {
-    promise.fail(
-        "Failed to catch-up position " + stringify(current) +
-        ": " + catching.failure());
+    while (catching.size() < window && !missing.empty()) {
+      const uint64_t position = missing.begin()->lower();
+      missing -= position;
 
-    terminate(self());
+      // Store the future so that we can discard it if the user wants
+      // to cancel the catch-up operation.
+      Future<uint64_t> future =
+        log::catchup(quorum, replica, network, proposal, position);
+
+      catching.put(position, future);
+
+      future.onAny(defer(self(), &Self::caught, position));
+
+      Clock::timer(timeout, lambda::bind(&Self::timedout, future));
+    }
+
+    if (catching.empty()) {
+      // Stop the process if there is nothing left to catch-up.
+      promise.set(Nothing());
+      terminate(self());
+    }
   }
 
-  void succeeded()
+  void caught(uint64_t position)
   {
-    ++current;
+    CHECK(catching.contains(position));
+
+    Future<uint64_t> future = catching[position];
+    catching.erase(position);
 
-    // The single position catch-up function: 'log::catchup' will
-    // return the highest proposal number seen so far. We use this
-    // proposal number for the next 'catchup' as it is highly likely
-    // that this number is high enough, saving potentially unnecessary
-    // proposal number bumps.
-    proposal = catching.get();
+    if (future.isDiscarded()) {
+      LOG(INFO) << "Unable to catch-up position " << position
+                << " in " << timeout << ", retrying";
+
+      missing += position;
+      window = std::max<size_t>(window / 2, 1);
+    } else if (future.isFailed()) {
+      promise.fail(
+          "Failed to catch-up position " + stringify(position) +
+          ": " + future.failure());
+
+      terminate(self());
+      return;
+    } else {
+      // The single position catch-up function: 'log::catchup' will
+      // return the highest proposal number seen so far. We use this
+      // proposal number for the next 'catchup' as it is highly likely
+      // that this number is high enough, saving potentially
+      // unnecessary proposal number bumps.
+      proposal = std::max(proposal, future.get());
+
+      window = std::min(window + 1, MAX_CATCH_UP_WINDOW);
+    }
 
     catchup();
   }
@@ -280,10 +497,26 @@ private:
   const Duration timeout;
 
   uint64_t proposal;
+
+  // The next position to fetch.
   uint64_t current;
 
+  // The positions left to catch-up (using Paxos) and the number of
+  // positions we catch-up concurrently.
+  IntervalSet<uint64_t> missing;
+  size_t window;
+
+  // The pending and the received responses to the current fetch
+  // request.
+  std::set<Future<FetchResponse> > responses;
+  list<FetchResponse> fetches;
+  size_t received;
+
   process::Promise<Nothing> promise;
-  Future<uint64_t> catching;
+  Future<Nothing> fetching;
+  Future<bool> learning;
+  Future<IntervalSet<uint64_t> > checking;
+  hashmap<uint64_t, Future<uint64_t> > catching;
 };
 
 
@@ -19,14 +19,17 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <deque>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/none.hpp>
 
 #include "log/catchup.hpp"
@@ -37,6 +40,7 @@
 
 using namespace process;
 
+using std::deque;
 using std::string;
 
 namespace mesos {
@@ -70,10 +74,17 @@ protected:
   virtual void finalize()
   {
     electing.discard();
-    writing.discard();
+
+    foreach (Write& write, writes) {
+      write.writing.discard();
+      write.promise->discard();
+    }
   }
 
 private:
+  // NOTE: Disambiguates from the 'Promise' message of the log.
+  typedef process::Promise<Option<uint64_t> > WritePromise;
+
   /////////////////////////////////
   // Election related functions. //
   /////////////////////////////////
@@ -101,10 +112,13 @@ private:
       const WriteResponse& response);
   Future<Nothing> runLearnPhase(const Action& action);
   Future<bool> checkLearnPhase(const Action& action);
-  Future<Option<uint64_t> > updateIndexAfterWritten(bool missing);
+  Future<Option<uint64_t> > getPositionAfterWritten(
+      const Action& action,
+      bool missing);
   void writingFinished();
-  void writingFailed();
-  void writingAborted();
+  void writingAborted(
+      const Future<Option<uint64_t> >& writing,
+      deque<Owned<WritePromise> > promises);
 
   const size_t quorum;
   const Shared<Replica> replica;
@@ -117,7 +131,9 @@ private:
   // coordinator does not declare itself as elected until it wins the
   // election and has filled all existing positions. A coordinator is
   // put in electing state after it decides to go for an election and
-  // before it is elected.
+  // before it is elected. The coordinator is in writing state while
+  // writes are in progress, further writes can be started while in
+  // that state (i.e., writes are pipelined).
   enum {
     INITIAL,
     ELECTING,
@@ -132,10 +148,30 @@ private:
   uint64_t index;
 
   Future<Option<uint64_t> > electing;
-  Future<Option<uint64_t> > writing;
+
+  // A write in progress. Writes to consecutive positions are run
+  // concurrently but complete in the order of their positions, i.e.,
+  // once a write completes all preceding positions have been written
+  // (and learned).
+  struct Write
+  {
+    Future<Option<uint64_t> > writing;
+    Owned<WritePromise> promise;
+  };
+
+  // The writes in progress, in the order of their positions.
+  deque<Write> writes;
 };
 
 
+// Helper for discarding the write of which the caller discarded the
+// result.
+static void discardWriting(Future<Option<uint64_t> > writing)
+{
+  writing.discard();
+}
+
+
 /////////////////////////////////////////////////
 // Handles elect/demote in CoordinatorProcess.
 /////////////////////////////////////////////////
@@ -299,12 +335,10 @@ Future<Option<uint64_t> > CoordinatorProcess::append(const string& bytes)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
-  action.set_position(index);
+  action.set_position(index++);
   action.set_promised(proposal);
   action.set_performed(proposal);
   action.set_type(Action::APPEND);
@@ -319,12 +353,10 @@ Future<Option<uint64_t> > CoordinatorProcess::truncate(uint64_t to)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
-  action.set_position(index);
+  action.set_position(index++);
   action.set_promised(proposal);
   action.set_performed(proposal);
   action.set_type(Action::TRUNCATE);
@@ -340,18 +372,27 @@ Future<Option<uint64_t> > CoordinatorProcess::write(const Action& action)
   LOG(INFO) << "Coordinator attempting to write " << action.type()
             << " action at position " << action.position();
 
-  CHECK_EQ(state, ELECTED);
+  CHECK(state == ELECTED || state == WRITING);
   CHECK(action.has_performed() && action.has_type());
 
   state = WRITING;
 
-  writing = runWritePhase(action)
-    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1))
-    .onReady(defer(self(), &Self::writingFinished))
-    .onFailed(defer(self(), &Self::writingFailed))
-    .onDiscarded(defer(self(), &Self::writingAborted));
+  Write write;
+  write.writing = runWritePhase(action)
+    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1));
+  write.promise.reset(new WritePromise());
+
+  write.writing
+    .onAny(defer(self(), &Self::writingFinished));
+
+  // Discarding the result discards the write (which demotes the
+  // coordinator, see 'writingFinished').
+  write.promise->future()
+    .onDiscard(lambda::bind(&discardWriting, write.writing));
+
+  writes.push_back(write);
 
-  return writing;
+  return write.promise->future();
 }
 
 
@@ -375,7 +416,7 @@ Future<Option<uint64_t> > CoordinatorProcess::checkWritePhase(
 
   return runLearnPhase(action)
     .then(defer(self(), &Self::checkLearnPhase, action))
-    .then(defer(self(), &Self::updateIndexAfterWritten, lambda::_1));
+    .then(defer(self(), &Self::getPositionAfterWritten, action, lambda::_1));
 }
 
 
@@ -394,39 +435,78 @@ Future<bool> CoordinatorProcess::checkLearnPhase(const Action& action)
 }
 
 
-Future<Option<uint64_t> > CoordinatorProcess::updateIndexAfterWritten(
+Future<Option<uint64_t> > CoordinatorProcess::getPositionAfterWritten(
+    const Action& action,
     bool missing)
 {
   CHECK(!missing) << "Not expecting local replica to be missing position "
-                  << index << " after the writing is done";
+                  << action.position() << " after the writing is done";
 
-  return index++;
+  return action.position();
 }
 
 
 void CoordinatorProcess::writingFinished()
 {
-  CHECK_EQ(state, WRITING);
-  state = ELECTED;
-}
+  // Complete the writes in the order of their positions.
+  while (!writes.empty() && !writes.front().writing.isPending()) {
+    const Write write = writes.front();
+    writes.pop_front();
 
+    if (write.writing.isReady() && write.writing.get().isSome()) {
+      write.promise->set(write.writing.get());
+      continue;
+    }
 
-void CoordinatorProcess::writingFailed()
-{
-  CHECK_EQ(state, WRITING);
-  state = INITIAL;
+    CHECK_EQ(state, WRITING);
+
+    // The coordinator gets demoted if a write is NACKed, fails or is
+    // discarded. The writes that are still in progress get aborted
+    // since the positions preceding them might not have been written.
+    state = INITIAL;
+
+    deque<Owned<WritePromise> > promises;
+    foreach (Write& aborted, writes) {
+      aborted.writing.discard();
+      promises.push_back(aborted.promise);
+    }
+    writes.clear();
+
+    promises.push_front(write.promise);
+    writingAborted(write.writing, promises);
+    return;
+  }
+
+  if (writes.empty() && state == WRITING) {
+    state = ELECTED;
+  }
 }
 
 
-void CoordinatorProcess::writingAborted()
+void CoordinatorProcess::writingAborted(
+    const Future<Option<uint64_t> >& writing,
+    deque<Owned<WritePromise> > promises)
 {
-  CHECK_EQ(state, WRITING);
+  // NOTE: A discarded write demotes the coordinator since we don't
+  // actually know the write was successful or not and we really need
+  // to "catch-up" that position before we try and do another write
+  // (see MESOS-1038 for more details). The writes after a discarded
+  // (or NACKed) write return none since the coordinator was demoted.
+  if (writing.isFailed()) {
+    foreach (const Owned<WritePromise>& promise, promises) {
+      promise->fail(writing.failure());
+    }
+    return;
+  }
 
-  // Demote the coordinator if a write operation is discarded since we
-  // don't actually know the write was successful or not and we really
-  // need to "catch-up" that position before we try and do another
-  // write (see MESOS-1038 for more details).
-  state = INITIAL;
+  if (writing.isDiscarded()) {
+    promises.front()->discard();
+    promises.pop_front();
+  }
+
+  foreach (const Owned<WritePromise>& promise, promises) {
+    promise->set(Option<uint64_t>::none());
+  }
 }
 
 
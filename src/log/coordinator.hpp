@@ -63,6 +63,11 @@ public:
   // Appends the specified bytes to the end of the log. Returns the
   // position of the appended entry if the operation succeeds or none
   // if the coordinator was demoted.
+  //
+  // NOTE: Appends (and truncates) can be started while others are in
+  // progress, they complete in the order they were started. Once a
+  // write fails (or the coordinator gets demoted) the subsequent
+  // writes in progress fail (or return none) as well.
   process::Future<Option<uint64_t> > append(const std::string& bytes);
 
   // Removes all log entries preceding the log entry at the given
@@ -25,8 +25,11 @@
 
 #include <stdint.h>
 
+#include <list>
+
 #include <stout/check.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/numify.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
@@ -34,6 +37,7 @@
 
 #include "log/leveldb.hpp"
 
+using std::list;
 using std::string;
 
 namespace mesos {
@@ -128,8 +132,18 @@ static string encode(uint64_t position, bool adjust = true)
 // }
 
 
-LevelDBStorage::LevelDBStorage()
-  : db(NULL), first(None())
+// The number of files in level 0 from which on leveldb slows down
+// writes (see 'config::kL0_SlowdownWritesTrigger' in leveldb, which
+// is not part of its public interface).
+static const uint64_t LEVEL0_SLOWDOWN_WRITES_TRIGGER = 8;
+
+
+LevelDBStorage::LevelDBStorage(const Options& _options)
+  : options(_options),
+    db(NULL),
+    cache(NULL),
+    filter(NULL),
+    first(None())
 {
   // Nothing to see here.
 }
@@ -138,13 +152,29 @@ LevelDBStorage::LevelDBStorage()
 LevelDBStorage::~LevelDBStorage()
 {
   delete db; // Might be null if open failed in LevelDBStorage::restore.
+
+  // NOTE: The cache and the filter policy must outlive the db.
+  delete cache;
+  delete filter;
 }
 
 
 Try<Storage::State> LevelDBStorage::restore(const string& path)
 {
+  metrics.reset(new Metrics(strings::trim(path, "/")));
+
+  cache = leveldb::NewLRUCache(this->options.blockCacheSize.bytes());
+
+  if (this->options.bloomFilterBitsPerKey > 0) {
+    filter = leveldb::NewBloomFilterPolicy(
+        this->options.bloomFilterBitsPerKey);
+  }
+
   leveldb::Options options;
   options.create_if_missing = true;
+  options.block_cache = cache;
+  options.filter_policy = filter;
+  options.write_buffer_size = this->options.writeBufferSize.bytes();
 
   // TODO(benh): Can't use varint comparator until bug discussed at
   // groups.google.com/group/leveldb/browse_thread/thread/17eac39168909ba7
@@ -175,12 +205,14 @@ Try<Storage::State> LevelDBStorage::restore(const string& path)
 
   LOG(INFO) << "Opened db in " << stopwatch.elapsed();
 
-  stopwatch.start(); // Restart the stopwatch.
-
   // TODO(benh): Conditionally compact to avoid long recovery times?
-  db->CompactRange(NULL, NULL);
+  if (this->options.compactOnRestore) {
+    stopwatch.start(); // Restart the stopwatch.
 
-  LOG(INFO) << "Compacted db in " << stopwatch.elapsed();
+    db->CompactRange(NULL, NULL);
+
+    LOG(INFO) << "Compacted db in " << stopwatch.elapsed();
+  }
 
   State state;
   state.begin = 0;
@@ -311,24 +343,49 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
 
 
 Try<Nothing> LevelDBStorage::persist(const Action& action)
+{
+  list<Action> actions;
+  actions.push_back(action);
+  return persist(actions);
+}
+
+
+Try<Nothing> LevelDBStorage::persist(const list<Action>& actions)
 {
   Stopwatch stopwatch;
   stopwatch.start();
 
-  Record record;
-  record.set_type(Record::ACTION);
-  record.mutable_action()->MergeFrom(action);
+  leveldb::WriteBatch batch;
 
-  string value;
+  size_t size = 0;
 
-  if (!record.SerializeToString(&value)) {
-    return Error("Failed to serialize record");
+  foreach (const Action& action, actions) {
+    Record record;
+    record.set_type(Record::ACTION);
+    record.mutable_action()->MergeFrom(action);
+
+    string value;
+
+    if (!record.SerializeToString(&value)) {
+      return Error("Failed to serialize record");
+    }
+
+    batch.Put(encode(action.position()), value);
+    size += value.size();
   }
 
   leveldb::WriteOptions options;
   options.sync = true;
 
-  leveldb::Status status = db->Put(options, encode(action.position()), value);
+  if (stalling()) {
+    ++metrics->write_stalls;
+  }
+
+  metrics->write.start();
+
+  leveldb::Status status = db->Write(options, &batch);
+
+  metrics->write.stop();
 
   if (!status.ok()) {
     return Error(status.ToString());
@@ -338,73 +395,103 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
   // of checking 'isNone()' because it's likely that log entries are
   // written out of order during catch-up (e.g. if a random bulk
   // catch-up policy is used).
-  first = min(first, action.position());
+  foreach (const Action& action, actions) {
+    first = min(first, action.position());
+  }
 
-  LOG(INFO) << "Persisting action (" << value.size()
-            << " bytes) to leveldb took " << stopwatch.elapsed();
+  if (actions.size() == 1) {
+    LOG(INFO) << "Persisting action (" << size
+              << " bytes) to leveldb took " << stopwatch.elapsed();
+  } else {
+    LOG(INFO) << "Persisting " << actions.size() << " actions (" << size
+              << " bytes) to leveldb took " << stopwatch.elapsed();
+  }
 
   // Delete positions if a truncate action has been *learned*. Note
   // that we do this in a best-effort fashion (i.e., we ignore any
   // failures to the database since we can always try again).
-  if (action.has_type() && action.type() == Action::TRUNCATE &&
-      action.has_learned() && action.learned()) {
-    CHECK(action.has_truncate());
+  foreach (const Action& action, actions) {
+    if (action.has_type() && action.type() == Action::TRUNCATE &&
+        action.has_learned() && action.learned()) {
+      truncate(action);
+    }
+  }
 
-    stopwatch.start(); // Restart the stopwatch.
+  return Nothing();
+}
 
-    // To actually perform the truncation in leveldb we need to remove
-    // all the keys that represent positions no longer in the log. We
-    // do this by attempting to delete all keys that represent the
-    // first position we know is still in leveldb up to (but
-    // excluding) the truncate position. Note that this works because
-    // the semantics of WriteBatch are such that even if the position
-    // doesn't exist (which is possible because this replica has some
-    // holes), we can attempt to delete the key that represents it and
-    // it will just ignore that key. This is *much* cheaper than
-    // actually iterating through the entire database instead (which
-    // was, for posterity, the original implementation). In addition,
-    // caching the "first" position we know is in the database is
-    // cheaper than using an iterator to determine the first position
-    // (which was, for posterity, the second implementation).
-
-    leveldb::WriteBatch batch;
-
-    CHECK_SOME(first);
-
-    // Add positions up to (but excluding) the truncate position to
-    // the batch starting at the first position still in leveldb. It's
-    // likely that the first position is greater than the truncate
-    // position (e.g., during catch-up). In that case, we do nothing
-    // because there is nothing we can truncate.
-    // TODO(jieyu): We might miss a truncation if we do random (i.e.,
-    // out of order) bulk catch-up and the truncate operation is
-    // caught up first.
-    uint64_t index = 0;
-    while ((first.get() + index) < action.truncate().to()) {
-      batch.Delete(encode(first.get() + index));
-      index++;
-    }
 
-    // If we added any positions, attempt to delete them!
-    if (index > 0) {
-      // We do this write asynchronously (e.g., using default options).
-      leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
-
-      if (!status.ok()) {
-        LOG(WARNING) << "Ignoring leveldb batch delete failure: "
-                     << status.ToString();
-      } else {
-        // Save the new first position!
-        CHECK_LT(first.get(), action.truncate().to());
-        first = action.truncate().to();
-
-        LOG(INFO) << "Deleting ~" << index
-                  << " keys from leveldb took " << stopwatch.elapsed();
-      }
+void LevelDBStorage::truncate(const Action& action)
+{
+  CHECK(action.has_truncate());
+
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  // To actually perform the truncation in leveldb we need to remove
+  // all the keys that represent positions no longer in the log. We
+  // do this by attempting to delete all keys that represent the
+  // first position we know is still in leveldb up to (but
+  // excluding) the truncate position. Note that this works because
+  // the semantics of WriteBatch are such that even if the position
+  // doesn't exist (which is possible because this replica has some
+  // holes), we can attempt to delete the key that represents it and
+  // it will just ignore that key. This is *much* cheaper than
+  // actually iterating through the entire database instead (which
+  // was, for posterity, the original implementation). In addition,
+  // caching the "first" position we know is in the database is
+  // cheaper than using an iterator to determine the first position
+  // (which was, for posterity, the second implementation).
+
+  leveldb::WriteBatch batch;
+
+  CHECK_SOME(first);
+
+  // Add positions up to (but excluding) the truncate position to
+  // the batch starting at the first position still in leveldb. It's
+  // likely that the first position is greater than the truncate
+  // position (e.g., during catch-up). In that case, we do nothing
+  // because there is nothing we can truncate.
+  // TODO(jieyu): We might miss a truncation if we do random (i.e.,
+  // out of order) bulk catch-up and the truncate operation is
+  // caught up first.
+  uint64_t index = 0;
+  while ((first.get() + index) < action.truncate().to()) {
+    batch.Delete(encode(first.get() + index));
+    index++;
+  }
+
+  // If we added any positions, attempt to delete them!
+  if (index > 0) {
+    // We do this write asynchronously (e.g., using default options).
+    leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+
+    if (!status.ok()) {
+      LOG(WARNING) << "Ignoring leveldb batch delete failure: "
+                   << status.ToString();
+    } else {
+      // Save the new first position!
+      CHECK_LT(first.get(), action.truncate().to());
+      first = action.truncate().to();
+
+      LOG(INFO) << "Deleting ~" << index
+                << " keys from leveldb took " << stopwatch.elapsed();
     }
   }
+}
 
-  return Nothing();
+
+bool LevelDBStorage::stalling()
+{
+  string value;
+
+  if (!db->GetProperty("leveldb.num-files-at-level0", &value)) {
+    return false;
+  }
+
+  Try<uint64_t> files = numify<uint64_t>(value);
+
+  return files.isSome() && files.get() >= LEVEL0_SLOWDOWN_WRITES_TRIGGER;
 }
 
 
@@ -440,6 +527,63 @@ Try<Action> LevelDBStorage::read(uint64_t position)
   return record.action();
 }
 
+
+Try<list<Action> > LevelDBStorage::read(uint64_t from, uint64_t to)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  leveldb::ReadOptions options;
+
+  // Don't let a (potentially long) scan evict the recently used
+  // blocks from the leveldb block cache.
+  options.fill_cache = false;
+
+  leveldb::Iterator* iterator = db->NewIterator(options);
+
+  // NOTE: The encoded positions sort in the same order as the
+  // positions themselves (see 'encode') so we can scan the range
+  // with a single iterator rather than a lookup per position.
+  const string last = encode(to);
+
+  list<Action> actions;
+
+  for (iterator->Seek(encode(from));
+       iterator->Valid() && iterator->key().compare(last) <= 0;
+       iterator->Next()) {
+    const leveldb::Slice& slice = iterator->value();
+
+    google::protobuf::io::ArrayInputStream stream(slice.data(), slice.size());
+
+    Record record;
+
+    if (!record.ParseFromZeroCopyStream(&stream)) {
+      delete iterator;
+      return Error("Failed to deserialize record");
+    }
+
+    if (record.type() != Record::ACTION) {
+      delete iterator;
+      return Error("Bad record");
+    }
+
+    actions.push_back(record.action());
+  }
+
+  leveldb::Status status = iterator->status();
+
+  delete iterator;
+
+  if (!status.ok()) {
+    return Error(status.ToString());
+  }
+
+  LOG(INFO) << "Reading " << actions.size() << " positions from leveldb took "
+            << stopwatch.elapsed();
+
+  return actions;
+}
+
 } // namespace log {
 } // namespace internal {
 } // namespace mesos {
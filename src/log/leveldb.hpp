@@ -19,10 +19,23 @@
 #ifndef __LOG_LEVELDB_HPP__
 #define __LOG_LEVELDB_HPP__
 
+#include <leveldb/cache.h>
 #include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
 
 #include <stdint.h>
 
+#include <list>
+#include <string>
+
+#include <process/owned.hpp>
+
+#include <process/metrics/counter.hpp>
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/duration.hpp>
 #include <stout/option.hpp>
 
 #include "log/storage.hpp"
@@ -35,19 +48,89 @@ namespace log {
 class LevelDBStorage : public Storage
 {
 public:
-  LevelDBStorage();
+  // Tuning options for leveldb (see leveldb/options.h).
+  struct Options
+  {
+    Options()
+      : blockCacheSize(Megabytes(8)),
+        writeBufferSize(Megabytes(4)),
+        bloomFilterBitsPerKey(0),
+        compactOnRestore(true) {}
+
+    // Size of the cache of (uncompressed) blocks read from disk.
+    Bytes blockCacheSize;
+
+    // Amount of data buffered in memory before it gets written out
+    // to a sorted file on disk. Larger values mean fewer (but
+    // longer) compactions.
+    Bytes writeBufferSize;
+
+    // Number of bits per key of the bloom filters used to avoid disk
+    // reads of keys that are not in a file, 0 disables the filters.
+    int bloomFilterBitsPerKey;
+
+    // Whether to compact the whole database when restoring (i.e.,
+    // opening) it.
+    bool compactOnRestore;
+  };
+
+  explicit LevelDBStorage(const Options& options = Options());
   virtual ~LevelDBStorage();
 
   virtual Try<State> restore(const std::string& path);
   virtual Try<Nothing> persist(const Metadata& metadata);
   virtual Try<Nothing> persist(const Action& action);
+  virtual Try<Nothing> persist(const std::list<Action>& actions);
   virtual Try<Action> read(uint64_t position);
+  virtual Try<std::list<Action> > read(uint64_t from, uint64_t to);
 
 private:
+  // Deletes the positions before the position the specified (learned)
+  // truncate action truncates to.
+  void truncate(const Action& action);
+
+  // Returns true if leveldb is likely to delay writes because too
+  // many files are waiting to be compacted.
+  bool stalling();
+
+  const Options options;
+
   leveldb::DB* db;
+  leveldb::Cache* cache;
+  const leveldb::FilterPolicy* filter;
 
   // First position still in leveldb, used during truncation.
   Option<uint64_t> first;
+
+  // The metrics are qualified with the path of the database (e.g.,
+  // 'log/leveldb/var/lib/mesos/replicated_log/write') since there
+  // can be multiple replicas (and hence databases) in a process.
+  struct Metrics
+  {
+    explicit Metrics(const std::string& path)
+      : write("log/leveldb/" + path + "/write"),
+        write_stalls("log/leveldb/" + path + "/write_stalls")
+    {
+      process::metrics::add(write);
+      process::metrics::add(write_stalls);
+    }
+
+    ~Metrics()
+    {
+      process::metrics::remove(write);
+      process::metrics::remove(write_stalls);
+    }
+
+    // Time it takes to (synchronously) write a batch of records.
+    process::metrics::Timer<Milliseconds> write;
+
+    // Number of writes that (likely) have been delayed by leveldb
+    // because of pending compactions.
+    process::metrics::Counter write_stalls;
+  };
+
+  // Created once the path of the database is known (see 'restore').
+  process::Owned<Metrics> metrics;
 };
 
 } // namespace log {
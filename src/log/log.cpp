@@ -37,6 +37,7 @@
 #include "log/log.hpp"
 #include "log/network.hpp"
 #include "log/recover.hpp"
+#include "log/repair.hpp"
 #include "log/replica.hpp"
 
 using namespace process;
@@ -56,7 +57,8 @@ public:
       size_t _quorum,
       const string& path,
       const set<UPID>& pids,
-      bool _autoInitialize);
+      bool _autoInitialize,
+      const LevelDBStorage::Options& options);
 
   LogProcess(
       size_t _quorum,
@@ -65,7 +67,8 @@ public:
       const Duration& timeout,
       const string& znode,
       const Option<zookeeper::Authentication>& auth,
-      bool _autoInitialize);
+      bool _autoInitialize,
+      const LevelDBStorage::Options& options);
 
   // Recovers the log by catching up if needed. Returns a shared
   // pointer to the local replica if the recovery succeeds.
@@ -95,6 +98,9 @@ private:
   Shared<Network> network;
   const bool autoInitialize;
 
+  // Repairs the local replica in the background once recovered.
+  Repairer* repairer;
+
   // For replica recovery.
   Option<Future<Owned<Replica> > > recovering;
   process::Promise<Nothing> recovered;
@@ -201,12 +207,14 @@ LogProcess::LogProcess(
     size_t _quorum,
     const string& path,
     const set<UPID>& pids,
-    bool _autoInitialize)
+    bool _autoInitialize,
+    const LevelDBStorage::Options& options)
   : ProcessBase(ID::generate("log")),
     quorum(_quorum),
-    replica(new Replica(path)),
+    replica(new Replica(path, options)),
     network(new Network(pids + (UPID) replica->pid())),
     autoInitialize(_autoInitialize),
+    repairer(NULL),
     group(NULL) {}
 
 
@@ -217,10 +225,11 @@ LogProcess::LogProcess(
     const Duration& timeout,
     const string& znode,
     const Option<zookeeper::Authentication>& auth,
-    bool _autoInitialize)
+    bool _autoInitialize,
+    const LevelDBStorage::Options& options)
   : ProcessBase(ID::generate("log")),
     quorum(_quorum),
-    replica(new Replica(path)),
+    replica(new Replica(path, options)),
     network(new ZooKeeperNetwork(
         servers,
         timeout,
@@ -228,6 +237,7 @@ LogProcess::LogProcess(
         auth,
         Set<UPID>((UPID) replica->pid()))),
     autoInitialize(_autoInitialize),
+    repairer(NULL),
     group(new zookeeper::Group(servers, timeout, znode, auth)) {}
 
 
@@ -272,6 +282,7 @@ void LogProcess::finalize()
   promises.clear();
 
   delete group;
+  delete repairer;
 
   // Wait for the shared pointers 'network' and 'replica' to become
   // unique (i.e., no other reference to them). These calls should not
@@ -361,6 +372,8 @@ void LogProcess::_recover()
     // 'const &' from 'Try::get'.
     replica = Owned<Replica>(future.get()).share();
 
+    repairer = new Repairer(replica, network);
+
     // Mark the success of the recovery.
     recovered.set(Nothing());
 
@@ -743,7 +756,8 @@ Log::Log(
     int quorum,
     const string& path,
     const set<UPID>& pids,
-    bool autoInitialize)
+    bool autoInitialize,
+    const LevelDBStorage::Options& options)
 {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
@@ -752,7 +766,8 @@ Log::Log(
         quorum,
         path,
         pids,
-        autoInitialize);
+        autoInitialize,
+        options);
 
   spawn(process);
 }
@@ -764,7 +779,8 @@ Log::Log(
     const Duration& timeout,
     const string& znode,
     const Option<zookeeper::Authentication>& auth,
-    bool autoInitialize)
+    bool autoInitialize,
+    const LevelDBStorage::Options& options)
 {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
@@ -776,7 +792,8 @@ Log::Log(
         timeout,
         znode,
         auth,
-        autoInitialize);
+        autoInitialize,
+        options);
 
   spawn(process);
 }
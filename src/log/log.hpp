@@ -35,6 +35,8 @@
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 
+#include "log/leveldb.hpp"
+
 #include "zookeeper/group.hpp"
 
 namespace mesos {
@@ -123,6 +125,12 @@ public:
       : position(_position), data(_data) {}
   };
 
+  // NOTE: Reads are served by the local replica once it has been
+  // recovered, i.e., they do not involve a round trip to a quorum of
+  // replicas. Only learned entries can be read, so a reader collocated
+  // with the (elected) writer sees all of that writer's successful
+  // appends and truncates, while a reader collocated with any other
+  // replica may lag behind until its replica learns of them.
   class Reader
   {
   public:
@@ -171,7 +179,9 @@ public:
     // Attempts to append the specified data to the log. Returns the
     // new ending position of the log or 'none' if this writer has
     // lost it's promise to exclusively write (which can be reacquired
-    // by invoking Writer::start).
+    // by invoking Writer::start). Appends (and truncates) can be
+    // issued without waiting for the preceding ones to complete, in
+    // which case they are pipelined and complete in order.
     process::Future<Option<Position> > append(const std::string& data);
 
     // Attempts to truncate the log up to but not including the
@@ -186,11 +196,13 @@ public:
 
   // Creates a new replicated log that assumes the specified quorum
   // size, is backed by a file at the specified path, and coordinates
-  // with other replicas via the set of process PIDs.
+  // with other replicas via the set of process PIDs. The options are
+  // used to tune the storage of the local replica.
   Log(int quorum,
       const std::string& path,
       const std::set<process::UPID>& pids,
-      bool autoInitialize = false);
+      bool autoInitialize = false,
+      const LevelDBStorage::Options& options = LevelDBStorage::Options());
 
   // Creates a new replicated log that assumes the specified quorum
   // size, is backed by a file at the specified path, and coordinates
@@ -202,7 +214,8 @@ public:
       const Duration& timeout,
       const std::string& znode,
       const Option<zookeeper::Authentication>& auth = None(),
-      bool autoInitialize = false);
+      bool autoInitialize = false,
+      const LevelDBStorage::Options& options = LevelDBStorage::Options());
 
   ~Log();
 
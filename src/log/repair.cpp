@@ -0,0 +1,364 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <set>
+
+#include <process/collect.hpp>
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/id.hpp>
+#include <process/process.hpp>
+
+#include <stout/check.hpp>
+#include <stout/foreach.hpp>
+#include <stout/interval.hpp>
+#include <stout/lambda.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+
+#include "log/repair.hpp"
+
+#include "messages/log.hpp"
+
+using namespace process;
+
+using std::list;
+using std::map;
+using std::set;
+
+namespace mesos {
+namespace internal {
+namespace log {
+
+// The number of positions we ask the source replica for (learned
+// actions) in one fetch request.
+static const uint64_t REPAIR_BATCH_SIZE = 1024;
+
+// The timeout of the requests to the other replicas.
+static const Duration REPAIR_TIMEOUT = Seconds(10);
+
+
+class RepairerProcess : public Process<RepairerProcess>
+{
+public:
+  RepairerProcess(
+      const Shared<Replica>& _replica,
+      const Shared<Network>& _network,
+      const Bytes& _bandwidth,
+      const Duration& _interval)
+    : ProcessBase(ID::generate("log-repairer")),
+      replica(_replica),
+      network(_network),
+      bandwidth(_bandwidth),
+      interval(_interval) {}
+
+  virtual ~RepairerProcess() {}
+
+protected:
+  virtual void initialize()
+  {
+    // NOTE: The first round is delayed as well as the replica has
+    // just been recovered (or caught-up) when the repairer starts.
+    schedule();
+  }
+
+  virtual void finalize()
+  {
+    probing.discard();
+
+    foreachvalue (Future<RecoverResponse> response, responses) {
+      response.discard();
+    }
+
+    checking.discard();
+    fetching.discard();
+    learning.discard();
+  }
+
+private:
+  static Future<Nothing> expired(Future<Nothing> probing)
+  {
+    // Use the responses we've received so far.
+    probing.discard();
+    return Nothing();
+  }
+
+  static Future<FetchResponse> timedout(Future<FetchResponse> fetching)
+  {
+    fetching.discard();
+    return Failure("Timed out");
+  }
+
+  static Nothing ignore(const list<Future<RecoverResponse> >&)
+  {
+    return Nothing();
+  }
+
+  void schedule()
+  {
+    delay(interval, self(), &Self::probe);
+  }
+
+  // Starts a round of repair by asking the other replicas for the
+  // range of their logs.
+  void probe()
+  {
+    probing = replica->status()
+      .then(defer(self(), &Self::_probe, lambda::_1))
+      .after(REPAIR_TIMEOUT, lambda::bind(&Self::expired, lambda::_1));
+
+    probing.onAny(defer(self(), &Self::probed));
+  }
+
+  Future<Nothing> _probe(const Metadata::Status& status)
+  {
+    if (status != Metadata::VOTING) {
+      return Nothing();
+    }
+
+    return network->members()
+      .then(defer(self(), &Self::__probe, lambda::_1));
+  }
+
+  Future<Nothing> __probe(const set<UPID>& members)
+  {
+    list<Future<RecoverResponse> > futures;
+
+    foreach (const UPID& pid, members) {
+      if (pid != replica->pid()) {
+        Future<RecoverResponse> future =
+          protocol::recover(pid, RecoverRequest());
+
+        responses[pid] = future;
+        futures.push_back(future);
+      }
+    }
+
+    return await(futures)
+      .then(lambda::bind(&Self::ignore, lambda::_1));
+  }
+
+  void probed()
+  {
+    // The future 'probing' can only be discarded in 'finalize'.
+    CHECK(!probing.isDiscarded());
+
+    if (probing.isFailed()) {
+      LOG(WARNING) << "Failed to probe the replicas for repair: "
+                   << probing.failure();
+    }
+
+    // We repair from the VOTING replica that knows the longest log.
+    Option<UPID> pid;
+    RecoverResponse longest;
+
+    foreachpair (const UPID& _pid,
+                 Future<RecoverResponse> response,
+                 responses) {
+      if (response.isReady() &&
+          response.get().status() == Metadata::VOTING &&
+          response.get().has_end() &&
+          (pid.isNone() || response.get().end() > longest.end())) {
+        pid = _pid;
+        longest = response.get();
+      }
+
+      response.discard();
+    }
+
+    responses.clear();
+
+    if (pid.isNone()) {
+      schedule();
+      return;
+    }
+
+    source = pid.get();
+
+    checking = replica->beginning()
+      .then(defer(self(),
+                  &Self::check,
+                  longest.has_begin() ? longest.begin() : 0,
+                  longest.end(),
+                  lambda::_1));
+
+    checking.onAny(defer(self(), &Self::checked));
+  }
+
+  Future<IntervalSet<uint64_t> > check(
+      uint64_t begin,
+      uint64_t end,
+      uint64_t beginning)
+  {
+    // The positions truncated by either replica need no repair.
+    return replica->missing(std::max(begin, beginning), end);
+  }
+
+  void checked()
+  {
+    // The future 'checking' can only be discarded in 'finalize'.
+    CHECK(!checking.isDiscarded());
+
+    if (checking.isFailed()) {
+      LOG(WARNING) << "Failed to get missing positions for repair: "
+                   << checking.failure();
+      schedule();
+      return;
+    }
+
+    missing = checking.get();
+
+    if (!missing.empty()) {
+      LOG(INFO) << "Repairing " << missing.size() << " missing positions "
+                << missing << " from replica " << source;
+    }
+
+    fetch();
+  }
+
+  void fetch()
+  {
+    if (missing.empty()) {
+      schedule();
+      return;
+    }
+
+    const uint64_t from = missing.begin()->lower();
+
+    FetchRequest request;
+    request.set_from(from);
+    request.set_to(std::min(from + REPAIR_BATCH_SIZE,
+                            missing.begin()->upper()) - 1);
+
+    fetching = protocol::fetch(source, request)
+      .after(REPAIR_TIMEOUT, lambda::bind(&Self::timedout, lambda::_1));
+
+    fetching.onAny(defer(self(), &Self::fetched, request));
+  }
+
+  void fetched(const FetchRequest& request)
+  {
+    // The future 'fetching' can only be discarded in 'finalize'.
+    CHECK(!fetching.isDiscarded());
+
+    if (fetching.isFailed()) {
+      LOG(WARNING) << "Failed to fetch positions " << request.from()
+                   << " to " << request.to() << " from replica " << source
+                   << " for repair: " << fetching.failure();
+      schedule();
+      return;
+    }
+
+    // Always make progress (see FetchResponse).
+    const uint64_t to = std::max(
+        std::min(fetching.get().to(), request.to()),
+        request.from());
+
+    list<Action> learned;
+    Bytes size = 0;
+
+    foreach (const Action& action, fetching.get().actions()) {
+      if (action.position() >= request.from() &&
+          action.position() <= to &&
+          action.has_learned() &&
+          action.learned()) {
+        learned.push_back(action);
+        size += action.ByteSize();
+      }
+    }
+
+    // The positions the source replica has not learned either are
+    // not retried (until the next round).
+    missing -=
+      (Bound<uint64_t>::closed(request.from()), Bound<uint64_t>::closed(to));
+
+    // Throttle the repair by waiting for as long as it takes to
+    // transfer the fetched actions at the configured bandwidth.
+    const Duration pause =
+      Seconds(1) * (static_cast<double>(size.bytes()) / bandwidth.bytes());
+
+    if (learned.empty()) {
+      delay(pause, self(), &Self::fetch);
+      return;
+    }
+
+    learning = replica->learn(learned);
+    learning.onAny(defer(self(), &Self::_fetched, pause));
+  }
+
+  void _fetched(const Duration& pause)
+  {
+    // The future 'learning' can only be discarded in 'finalize'.
+    CHECK(!learning.isDiscarded());
+
+    if (learning.isFailed() || !learning.get()) {
+      LOG(WARNING) << "Failed to persist the repaired actions"
+                   << (learning.isFailed() ? ": " + learning.failure() : "");
+      schedule();
+      return;
+    }
+
+    delay(pause, self(), &Self::fetch);
+  }
+
+  const Shared<Replica> replica;
+  const Shared<Network> network;
+  const Bytes bandwidth;
+  const Duration interval;
+
+  // The replica we repair from and the positions left to repair in
+  // the current round.
+  UPID source;
+  IntervalSet<uint64_t> missing;
+
+  Future<Nothing> probing;
+  map<UPID, Future<RecoverResponse> > responses;
+  Future<IntervalSet<uint64_t> > checking;
+  Future<FetchResponse> fetching;
+  Future<bool> learning;
+};
+
+
+Repairer::Repairer(
+    const Shared<Replica>& replica,
+    const Shared<Network>& network,
+    const Bytes& bandwidth,
+    const Duration& interval)
+{
+  CHECK(bandwidth > 0) << "The bandwidth of the repair must be positive";
+
+  process = new RepairerProcess(replica, network, bandwidth, interval);
+  spawn(process);
+}
+
+
+Repairer::~Repairer()
+{
+  terminate(process);
+  process::wait(process);
+  delete process;
+}
+
+} // namespace log {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,73 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LOG_REPAIR_HPP__
+#define __LOG_REPAIR_HPP__
+
+#include <process/shared.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/duration.hpp>
+
+#include "log/network.hpp"
+#include "log/replica.hpp"
+
+namespace mesos {
+namespace internal {
+namespace log {
+
+// Forward declaration.
+class RepairerProcess;
+
+
+// Repairs the local replica in the background so that its health
+// does not depend on the next election (whose catch-up only covers
+// the positions the new coordinator needs). Every 'interval' the
+// repairer asks the other replicas for the range of their logs and,
+// if the local replica is missing positions (e.g., holes left by
+// writes it did not vote on) within the log of the VOTING replica
+// that knows the longest log, fetches the actions that replica has
+// learned. The fetches are throttled to 'bandwidth' bytes per second
+// so that the repair does not disturb the writes of the coordinator.
+//
+// NOTE: Only learned actions get copied (which have been agreed upon)
+// and no Paxos round is run, i.e., the repairer never bumps the
+// proposal number and hence never demotes the coordinator. Positions
+// that no replica has learned are left to the next coordinator. Also,
+// a replica that is not VOTING (e.g., one that lost its storage) is
+// not repaired, it gets recovered as a whole by the RecoverProcess.
+class Repairer
+{
+public:
+  Repairer(
+      const process::Shared<Replica>& replica,
+      const process::Shared<Network>& network,
+      const Bytes& bandwidth = Megabytes(8),
+      const Duration& interval = Minutes(1));
+
+  ~Repairer();
+
+private:
+  RepairerProcess* process;
+};
+
+} // namespace log {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __LOG_REPAIR_HPP__
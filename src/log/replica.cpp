@@ -19,17 +19,21 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <map>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
 
+#include <stout/cache.hpp>
+#include <stout/bytes.hpp>
 #include <stout/check.hpp>
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/result.hpp>
 #include <stout/try.hpp>
 #include <stout/utils.hpp>
@@ -53,16 +57,29 @@ namespace protocol {
 Protocol<PromiseRequest, PromiseResponse> promise;
 Protocol<WriteRequest, WriteResponse> write;
 Protocol<RecoverRequest, RecoverResponse> recover;
+Protocol<FetchRequest, FetchResponse> fetch;
 
 } // namespace protocol {
 
 
+// The number of recently written or learned actions that a replica
+// keeps in memory so that reads of the tail of the log (e.g., by a
+// catching-up replica or a reader replaying after a failover) don't
+// have to go to the storage.
+static const size_t READ_CACHE_CAPACITY = 256;
+
+
+// The maximum (approximate) size of the actions a replica replies
+// with to a fetch request.
+static const Bytes MAX_FETCH_RESPONSE_SIZE = Megabytes(4);
+
+
 class ReplicaProcess : public ProtobufProcess<ReplicaProcess>
 {
 public:
   // Constructs a new replica process using specified path to a
   // directory for storing the underlying log.
-  explicit ReplicaProcess(const string& path);
+  ReplicaProcess(const string& path, const LevelDBStorage::Options& options);
 
   virtual ~ReplicaProcess();
 
@@ -102,17 +119,46 @@ public:
   // the disk. Returns true on success and false otherwise.
   bool update(const Metadata::Status& status);
 
+  // Persists the specified learned actions (e.g., fetched from other
+  // replicas during catch-up) at once. Returns true on success and
+  // false otherwise.
+  bool learn(const list<Action>& actions);
+
+protected:
+  // Write requests received back to back (e.g., from a pipelining
+  // coordinator) are persisted in a single (synchronous) batch, any
+  // other event first persists the pending writes (see 'flush') so
+  // that it observes their effects.
+  virtual void visit(const MessageEvent& event)
+  {
+    if (event.message->name != WriteRequest().GetTypeName()) {
+      flush();
+    }
+
+    ProtobufProcess<ReplicaProcess>::visit(event);
+  }
+
+  virtual void visit(const DispatchEvent& event)
+  {
+    flush();
+
+    ProcessBase::visit(event);
+  }
+
 private:
   // Handles a request from a proposer to promise not to accept writes
   // from any other proposer with lower proposal number.
   void promise(const PromiseRequest& request);
 
   // Handles a request from a proposer to write an action.
-  void write(const WriteRequest& request);
+  void write(const UPID& from, const WriteRequest& request);
 
   // Handles a request from a recover process.
   void recover(const RecoverRequest& request);
 
+  // Handles a request from a catch-up process for learned actions.
+  void fetch(const FetchRequest& request);
+
   // Handles a message notifying of a learned action.
   void learned(const Action& action);
 
@@ -120,6 +166,21 @@ private:
   // specified argument. Returns true on success and false otherwise.
   bool persist(const Action& action);
 
+  // Helper routine that adds an accepted write to the pending writes
+  // which get persisted (and replied to) on the next 'flush'.
+  void buffer(
+      const UPID& from,
+      const Action& action,
+      const WriteResponse& response);
+
+  // Persists all the pending writes at once and sends the responses
+  // for them. No response is sent if persisting fails.
+  void flush();
+
+  // Helper routine that updates the in-memory state of the log after
+  // the specified action has been persisted.
+  void record(const Action& action);
+
   // Helper routines that update metadata corresponding to the
   // specified argument. The update will be persisted on the disk.
   // Returns true on success and false otherwise.
@@ -146,16 +207,39 @@ private:
 
   // Unlearned positions in the log.
   IntervalSet<uint64_t> unlearned;
+
+  // Recently persisted actions, by position. NOTE: Truncated
+  // positions are not removed but they are never read (see 'read')
+  // and eventually get evicted.
+  Cache<uint64_t, Action> cache;
+
+  // Accepted writes that are not yet persisted.
+  struct Write
+  {
+    Write(const UPID& _from,
+          const Action& _action,
+          const WriteResponse& _response)
+      : from(_from), action(_action), response(_response) {}
+
+    UPID from;
+    Action action;
+    WriteResponse response;
+  };
+
+  list<Write> writes;
 };
 
 
-ReplicaProcess::ReplicaProcess(const string& path)
+ReplicaProcess::ReplicaProcess(
+    const string& path,
+    const LevelDBStorage::Options& options)
   : ProcessBase(ID::generate("log-replica")),
     begin(0),
-    end(0)
+    end(0),
+    cache(READ_CACHE_CAPACITY)
 {
   // TODO(benh): Factor out and expose storage.
-  storage = new LevelDBStorage();
+  storage = new LevelDBStorage(options);
 
   restore(path);
 
@@ -169,6 +253,9 @@ ReplicaProcess::ReplicaProcess(const string& path)
   install<RecoverRequest>(
       &ReplicaProcess::recover);
 
+  install<FetchRequest>(
+      &ReplicaProcess::fetch);
+
   install<LearnedMessage>(
       &ReplicaProcess::learned,
       &LearnedMessage::action);
@@ -191,6 +278,12 @@ Result<Action> ReplicaProcess::read(uint64_t position)
     return None();
   }
 
+  Option<Action> cached = cache.get(position);
+
+  if (cached.isSome()) {
+    return cached.get();
+  }
+
   // Must exist in storage ...
   Try<Action> action = storage->read(position);
 
@@ -225,18 +318,63 @@ Future<list<Action> > ReplicaProcess::read(uint64_t from, uint64_t to)
   VLOG(2) << "Starting read from '" << stringify(from) << "' to '"
           << stringify(to) << "'";
 
+  // Take what we can from the cache and read the rest of the range
+  // (between the first and the last position that is not cached)
+  // from the storage in one go rather than position by position.
+  std::map<uint64_t, Action> found;
+  Option<uint64_t> first = None();
+  Option<uint64_t> last = None();
+
+  for (uint64_t position = from; position <= to; position++) {
+    if (holes.contains(position)) {
+      continue;
+    }
+
+    Option<Action> cached = cache.get(position);
+
+    if (cached.isSome()) {
+      found[position] = cached.get();
+    } else {
+      first = min(first, position);
+      last = max(last, position);
+    }
+  }
+
+  if (first.isSome()) {
+    CHECK_SOME(last);
+
+    Try<list<Action> > stored = storage->read(first.get(), last.get());
+
+    if (stored.isError()) {
+      process::Promise<list<Action> > promise;
+      promise.fail(stored.error());
+      return promise.future();
+    }
+
+    foreach (const Action& action, stored.get()) {
+      if (!holes.contains(action.position())) {
+        found.insert(std::make_pair(action.position(), action));
+      }
+    }
+  }
+
   list<Action> actions;
 
+  // Every position that is not a hole must exist in storage ...
   for (uint64_t position = from; position <= to; position++) {
-    Result<Action> result = read(position);
+    if (holes.contains(position)) {
+      continue;
+    }
 
-    if (result.isError()) {
+    std::map<uint64_t, Action>::iterator iterator = found.find(position);
+
+    if (iterator == found.end()) {
       process::Promise<list<Action> > promise;
-      promise.fail(result.error());
+      promise.fail("Missing position " + stringify(position) + " in storage");
       return promise.future();
-    } else if (result.isSome()) {
-      actions.push_back(result.get());
     }
+
+    actions.push_back(iterator->second);
   }
 
   return actions;
@@ -499,7 +637,7 @@ void ReplicaProcess::promise(const PromiseRequest& request)
 }
 
 
-void ReplicaProcess::write(const WriteRequest& request)
+void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
 {
   // Ignore write requests if this replica is not in VOTING status.
   if (status() != Metadata::VOTING) {
@@ -511,6 +649,15 @@ void ReplicaProcess::write(const WriteRequest& request)
   LOG(INFO) << "Replica received write request for position "
             << request.position();
 
+  // A write to a position that has a pending write needs to see the
+  // result of the latter.
+  foreach (const Write& write, writes) {
+    if (write.action.position() == request.position()) {
+      flush();
+      break;
+    }
+  }
+
   Result<Action> result = read(request.position());
 
   if (result.isError()) {
@@ -548,13 +695,11 @@ void ReplicaProcess::write(const WriteRequest& request)
           LOG(FATAL) << "Unknown Action::Type!";
       }
 
-      if (persist(action)) {
-        WriteResponse response;
-        response.set_okay(true);
-        response.set_proposal(request.proposal());
-        response.set_position(request.position());
-        reply(response);
-      }
+      WriteResponse response;
+      response.set_okay(true);
+      response.set_proposal(request.proposal());
+      response.set_position(request.position());
+      buffer(from, action, response);
     }
   } else if (result.isSome()) {
     Action action = result.get();
@@ -623,13 +768,11 @@ void ReplicaProcess::write(const WriteRequest& request)
             LOG(FATAL) << "Unknown Action::Type!";
         }
 
-        if (persist(action)) {
-          WriteResponse response;
-          response.set_okay(true);
-          response.set_proposal(request.proposal());
-          response.set_position(request.position());
-          reply(response);
-        }
+        WriteResponse response;
+        response.set_okay(true);
+        response.set_proposal(request.proposal());
+        response.set_position(request.position());
+        buffer(from, action, response);
       }
     }
   }
@@ -653,6 +796,53 @@ void ReplicaProcess::recover(const RecoverRequest& request)
 }
 
 
+void ReplicaProcess::fetch(const FetchRequest& request)
+{
+  LOG(INFO) << "Replica received fetch request for positions "
+            << request.from() << " to " << request.to();
+
+  FetchResponse response;
+  response.set_to(request.to());
+
+  // NOTE: Learned actions have been agreed upon, hence we reply
+  // independent of the status of this replica (a replica that is not
+  // VOTING just doesn't know many learned actions).
+  const uint64_t from = std::max(request.from(), begin);
+  const uint64_t to = std::min(request.to(), end);
+
+  if (from <= to) {
+    Future<list<Action> > actions = read(from, to);
+
+    if (!actions.isReady()) {
+      LOG(ERROR) << "Error reading log positions " << from << " to " << to
+                 << ": " << (actions.isFailed()
+                             ? actions.failure()
+                             : "discarded");
+      reply(response); // Without any actions.
+      return;
+    }
+
+    Bytes size = 0;
+
+    foreach (const Action& action, actions.get()) {
+      if (size >= MAX_FETCH_RESPONSE_SIZE) {
+        // Only the positions up to (and including) the last included
+        // one have been covered by this response.
+        response.set_to(action.position() - 1);
+        break;
+      }
+
+      if (action.has_learned() && action.learned()) {
+        response.add_actions()->CopyFrom(action);
+        size += action.ByteSize();
+      }
+    }
+  }
+
+  reply(response);
+}
+
+
 void ReplicaProcess::learned(const Action& action)
 {
   LOG(INFO) << "Replica received learned notice for position "
@@ -678,6 +868,97 @@ bool ReplicaProcess::persist(const Action& action)
 
   LOG(INFO) << "Persisted action at " << action.position();
 
+  record(action);
+
+  return true;
+}
+
+
+bool ReplicaProcess::learn(const list<Action>& actions)
+{
+  list<Action> learning;
+
+  foreach (const Action& action, actions) {
+    CHECK(action.has_learned() && action.learned());
+
+    // Skip the positions that have been truncated in the meantime.
+    if (action.position() >= begin) {
+      learning.push_back(action);
+    }
+  }
+
+  if (learning.empty()) {
+    return true;
+  }
+
+  Try<Nothing> persisted = storage->persist(learning);
+
+  if (persisted.isError()) {
+    LOG(ERROR) << "Error writing to log: " << persisted.error();
+    return false;
+  }
+
+  LOG(INFO) << "Persisted " << learning.size() << " learned actions from "
+            << learning.front().position() << " to "
+            << learning.back().position();
+
+  foreach (const Action& action, learning) {
+    record(action);
+  }
+
+  return true;
+}
+
+
+void ReplicaProcess::buffer(
+    const UPID& from,
+    const Action& action,
+    const WriteResponse& response)
+{
+  // NOTE: Flushing when the process gets to this dispatch (at the
+  // latest) bounds the latency that batching adds to a write.
+  if (writes.empty()) {
+    dispatch(self(), &ReplicaProcess::flush);
+  }
+
+  writes.push_back(Write(from, action, response));
+}
+
+
+void ReplicaProcess::flush()
+{
+  if (writes.empty()) {
+    return;
+  }
+
+  list<Write> flushing;
+  std::swap(flushing, writes);
+
+  list<Action> actions;
+  foreach (const Write& write, flushing) {
+    actions.push_back(write.action);
+  }
+
+  Try<Nothing> persisted = storage->persist(actions);
+
+  if (persisted.isError()) {
+    LOG(ERROR) << "Error writing to log: " << persisted.error();
+    return;
+  }
+
+  LOG(INFO) << "Persisted " << actions.size() << " written actions";
+
+  foreach (const Write& write, flushing) {
+    record(write.action);
+    send(write.from, write.response);
+  }
+}
+
+
+void ReplicaProcess::record(const Action& action)
+{
+  cache.put(action.position(), action);
+
   // No longer a hole here (if there even was one).
   holes -= action.position();
 
@@ -712,8 +993,6 @@ bool ReplicaProcess::persist(const Action& action)
 
   // And update the end position.
   end = std::max(end, action.position());
-
-  return true;
 }
 
 
@@ -748,9 +1027,9 @@ void ReplicaProcess::restore(const string& path)
 }
 
 
-Replica::Replica(const string& path)
+Replica::Replica(const string& path, const LevelDBStorage::Options& options)
 {
-  process = new ReplicaProcess(path);
+  process = new ReplicaProcess(path, options);
   spawn(process);
 }
 
@@ -816,6 +1095,12 @@ Future<bool> Replica::update(const Metadata::Status& status)
 }
 
 
+Future<bool> Replica::learn(const list<Action>& actions) const
+{
+  return dispatch(process, &ReplicaProcess::learn, actions);
+}
+
+
 PID<ReplicaProcess> Replica::pid() const
 {
   return process->self();
@@ -30,6 +30,8 @@
 
 #include <stout/interval.hpp>
 
+#include "log/leveldb.hpp"
+
 #include "messages/log.hpp"
 
 namespace mesos {
@@ -42,6 +44,7 @@ namespace protocol {
 extern Protocol<PromiseRequest, PromiseResponse> promise;
 extern Protocol<WriteRequest, WriteResponse> write;
 extern Protocol<RecoverRequest, RecoverResponse> recover;
+extern Protocol<FetchRequest, FetchResponse> fetch;
 
 } // namespace protocol {
 
@@ -58,8 +61,11 @@ public:
   // with an empty log, it will not be allowed to vote (i.e., cannot
   // reply to any request except the recover request). The recover
   // process will later decide if this replica can be re-allowed to
-  // vote depending on the status of other replicas.
-  explicit Replica(const std::string& path);
+  // vote depending on the status of other replicas. The options are
+  // used to tune the underlying storage.
+  explicit Replica(
+      const std::string& path,
+      const LevelDBStorage::Options& options = LevelDBStorage::Options());
   ~Replica();
 
   // Returns all the actions between the specified positions, unless
@@ -94,6 +100,10 @@ public:
   // Updates the status of this replica.
   process::Future<bool> update(const Metadata::Status& status);
 
+  // Persists the specified learned actions (e.g., fetched from other
+  // replicas during catch-up).
+  process::Future<bool> learn(const std::list<Action>& actions) const;
+
   // Returns the PID associated with this replica.
   process::PID<ReplicaProcess> pid() const;
 
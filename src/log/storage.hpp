@@ -21,6 +21,7 @@
 
 #include <stdint.h>
 
+#include <list>
 #include <string>
 
 #include <stout/interval.hpp>
@@ -55,7 +56,16 @@ public:
   virtual Try<State> restore(const std::string& path) = 0;
   virtual Try<Nothing> persist(const Metadata& metadata) = 0;
   virtual Try<Nothing> persist(const Action& action) = 0;
+
+  // Persists the actions in one (atomic) write, e.g., during a bulk
+  // catch-up where writing each action separately is expensive.
+  virtual Try<Nothing> persist(const std::list<Action>& actions) = 0;
   virtual Try<Action> read(uint64_t position) = 0;
+
+  // Returns the actions stored for the positions in [from, to] in
+  // the order of their positions. Positions that are not stored
+  // (e.g., holes) are skipped.
+  virtual Try<std::list<Action> > read(uint64_t from, uint64_t to) = 0;
 };
 
 } // namespace log {
@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <deque>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -26,11 +27,14 @@
 #include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/process.hpp>
+#include <process/statistics.hpp>
 #include <process/time.hpp>
+#include <process/timeseries.hpp>
 
 #include <stout/bytes.hpp>
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
+#include <stout/numify.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
 #include <stout/os/read.hpp>
@@ -44,6 +48,7 @@
 using namespace process;
 
 using std::cout;
+using std::deque;
 using std::endl;
 using std::ifstream;
 using std::ofstream;
@@ -76,7 +81,10 @@ Benchmark::Flags::Flags()
   add(&Flags::input,
       "input",
       "Path to the input trace file. Each line in the trace file\n"
-      "specifies the size of the append (e.g. 100B, 2MB, etc.)");
+      "specifies an operation:\n"
+      "  [append] SIZE: append SIZE (e.g. 100B, 2MB, etc.) of data\n"
+      "  read N:        read the last N appended entries\n"
+      "  truncate N:    truncate all but the last N appended entries");
 
   add(&Flags::output,
       "output",
@@ -90,6 +98,12 @@ Benchmark::Flags::Flags()
       "  random: all bits are randomly chosen\n",
       "random");
 
+  add(&Flags::concurrency,
+      "concurrency",
+      "Maximum number of outstanding operations. Appends and truncates\n"
+      "are pipelined by the writer, reads are done concurrently",
+      1);
+
   add(&Flags::initialize,
       "initialize",
       "Whether to initialize the log",
@@ -97,16 +111,96 @@ Benchmark::Flags::Flags()
 }
 
 
+namespace {
+
+// An operation of the trace file.
+struct Operation
+{
+  enum Type
+  {
+    APPEND,
+    READ,
+    TRUNCATE
+  };
+
+  static string name(Type type)
+  {
+    switch (type) {
+      case APPEND: return "append";
+      case READ: return "read";
+      case TRUNCATE: return "truncate";
+    }
+
+    UNREACHABLE();
+  }
+
+  Type type;
+  Bytes size;   // The size of the data to append.
+  size_t count; // The number of entries to read or to keep.
+};
+
+
+// An operation that has been issued but not waited for.
+struct Outstanding
+{
+  size_t index;
+  Future<Duration> latency;
+
+  // The result of an append or truncate.
+  Option<Future<Option<Log::Position>>> position;
+};
+
+
+Try<Operation> parse(const string& line)
+{
+  const vector<string> tokens = strings::tokenize(line, " ");
+
+  Operation operation;
+
+  if (tokens.size() == 1 ||
+      (tokens.size() == 2 && tokens[0] == "append")) {
+    Try<Bytes> size = Bytes::parse(tokens.back());
+    if (size.isError()) {
+      return Error("Invalid append '" + line + "': " + size.error());
+    }
+
+    operation.type = Operation::APPEND;
+    operation.size = size.get();
+    operation.count = 0;
+
+    return operation;
+  } else if (tokens.size() == 2 &&
+             (tokens[0] == "read" || tokens[0] == "truncate")) {
+    Try<size_t> count = numify<size_t>(tokens[1]);
+    if (count.isError()) {
+      return Error("Invalid " + tokens[0] + " '" + line + "': " +
+                   count.error());
+    }
+
+    operation.type =
+      tokens[0] == "read" ? Operation::READ : Operation::TRUNCATE;
+    operation.count = count.get();
+
+    return operation;
+  }
+
+  return Error("Invalid operation '" + line + "'");
+}
+
+} // namespace {
+
+
 Try<Nothing> Benchmark::execute(int argc, char** argv)
 {
   flags.setUsageMessage(
       "Usage: " + name() + " [options]\n"
       "\n"
       "This command is used to do performance test on the\n"
-      "replicated log. It takes a trace file of write sizes\n"
-      "and replay that trace to measure the latency of each\n"
-      "write. The data to be written for each write can be\n"
-      "specified using the --type flag.\n"
+      "replicated log. It takes a trace file of appends, reads\n"
+      "and truncates and replays that trace (with up to\n"
+      "--concurrency outstanding operations) to measure the\n"
+      "latency of each operation. The data to be written for\n"
+      "each append can be specified using the --type flag.\n"
       "\n");
 
   // Configure the tool by parsing command line arguments.
@@ -181,12 +275,11 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
                   : "Discarded future"));
   }
 
-  // Statistics to output.
-  vector<Bytes> sizes;
-  vector<Duration> durations;
-  vector<Time> timestamps;
+  Log::Reader reader(&log);
+
+  // Read the operations from the input trace file.
+  vector<Operation> operations;
 
-  // Read sizes from the input trace file.
   ifstream input(flags.input.get().c_str());
   if (!input.is_open()) {
     return Error("Failed to open the trace file " + flags.input.get());
@@ -194,66 +287,199 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
 
   string line;
   while (getline(input, line)) {
-    Try<Bytes> size = Bytes::parse(strings::trim(line));
-    if (size.isError()) {
+    Try<Operation> operation = parse(strings::trim(line));
+    if (operation.isError()) {
       input.close();
-      return Error("Failed to parse the trace file: " + size.error());
+      return Error("Failed to parse the trace file: " + operation.error());
     }
 
-    sizes.push_back(size.get());
+    operations.push_back(operation.get());
   }
 
   input.close();
 
   // Generate the data to be written.
   vector<string> data;
-  for (size_t i = 0; i < sizes.size(); i++) {
-    if (flags.type == "one") {
-      data.push_back(string(sizes[i].bytes(), 255));
+  foreach (const Operation& operation, operations) {
+    if (operation.type != Operation::APPEND) {
+      data.push_back(string());
+    } else if (flags.type == "one") {
+      data.push_back(string(operation.size.bytes(), 255));
     } else if (flags.type == "random") {
-      data.push_back(string(sizes[i].bytes(), ::random() % 256));
+      data.push_back(string(operation.size.bytes(), ::random() % 256));
     } else {
-      data.push_back(string(sizes[i].bytes(), 0));
+      data.push_back(string(operation.size.bytes(), 0));
     }
   }
 
+  // Statistics to output.
+  vector<Duration> durations(operations.size());
+  vector<Time> timestamps(operations.size());
+
+  // The positions of the completed appends, which reads and
+  // truncates refer to.
+  vector<Log::Position> positions;
+
+  // The outstanding operations, oldest first.
+  deque<Outstanding> outstanding;
+
+  // Waits for the oldest outstanding operation.
+  auto complete = [&]() -> Try<Nothing> {
+    CHECK(!outstanding.empty());
+
+    Outstanding oldest = outstanding.front();
+    outstanding.pop_front();
+
+    const string name = Operation::name(operations[oldest.index].type);
+
+    if (!oldest.latency.await(Seconds(10))) {
+      return Error("Failed to " + name + ": timed out");
+    } else if (!oldest.latency.isReady()) {
+      return Error("Failed to " + name + ": " +
+                   (oldest.latency.isFailed()
+                    ? oldest.latency.failure()
+                    : "Discarded future"));
+    }
+
+    if (oldest.position.isSome()) {
+      CHECK(oldest.position.get().isReady());
+
+      if (oldest.position.get().get().isNone()) {
+        return Error("Failed to " + name + ": exclusive write promise lost");
+      }
+
+      if (operations[oldest.index].type == Operation::APPEND) {
+        positions.push_back(oldest.position.get().get().get());
+      }
+    }
+
+    durations[oldest.index] = oldest.latency.get();
+    timestamps[oldest.index] = Clock::now();
+
+    return Nothing();
+  };
+
   Stopwatch stopwatch;
   stopwatch.start();
 
-  for (size_t i = 0; i < sizes.size(); i++) {
-    Stopwatch stopwatch;
-    stopwatch.start();
+  for (size_t i = 0; i < operations.size(); i++) {
+    const Operation& operation = operations[i];
+
+    while (outstanding.size() >= std::max<size_t>(flags.concurrency, 1)) {
+      Try<Nothing> completed = complete();
+      if (completed.isError()) {
+        return Error(completed.error());
+      }
+    }
 
-    position = writer.append(data[i]);
+    // Reads and truncates refer to completed appends, so we wait for
+    // the outstanding operations if there are none yet.
+    if (operation.type != Operation::APPEND) {
+      while (positions.empty() && !outstanding.empty()) {
+        Try<Nothing> completed = complete();
+        if (completed.isError()) {
+          return Error(completed.error());
+        }
+      }
+
+      if (positions.empty()) {
+        return Error("Failed to " + Operation::name(operation.type) +
+                     ": nothing has been appended");
+      }
+    }
 
-    if (!position.await(Seconds(10))) {
-      return Error("Failed to append: timed out");
-    } else if (!position.isReady()) {
-      return Error("Failed to append: " +
-                   (position.isFailed()
-                    ? position.failure()
-                    : "Discarded future"));
-    } else if (position.get().isNone()) {
-      return Error("Failed to append: exclusive write promise lost");
+    Stopwatch watch;
+    watch.start();
+
+    Outstanding next;
+    next.index = i;
+
+    switch (operation.type) {
+      case Operation::APPEND:
+        next.position = writer.append(data[i]);
+        next.latency = next.position.get()
+          .then([=]() -> Duration { return watch.elapsed(); });
+        break;
+      case Operation::READ: {
+        const size_t count = std::min(operation.count, positions.size());
+
+        next.latency =
+          reader.read(positions[positions.size() - count], positions.back())
+            .then([=]() -> Duration { return watch.elapsed(); });
+        break;
+      }
+      case Operation::TRUNCATE: {
+        const size_t count = std::min(operation.count, positions.size());
+
+        next.position =
+          writer.truncate(positions[positions.size() - count]);
+        next.latency = next.position.get()
+          .then([=]() -> Duration { return watch.elapsed(); });
+        break;
+      }
     }
 
-    durations.push_back(stopwatch.elapsed());
-    timestamps.push_back(Clock::now());
+    outstanding.push_back(next);
+  }
+
+  while (!outstanding.empty()) {
+    Try<Nothing> completed = complete();
+    if (completed.isError()) {
+      return Error(completed.error());
+    }
   }
 
-  cout << "Total number of appends: " << sizes.size() << endl;
+  cout << "Total number of operations: " << operations.size() << endl;
   cout << "Total time used: " << stopwatch.elapsed() << endl;
 
+  // Output the latency percentiles of each type of operation.
+  const vector<Operation::Type> types =
+    {Operation::APPEND, Operation::READ, Operation::TRUNCATE};
+
+  foreach (Operation::Type type, types) {
+    TimeSeries<double> latencies(Duration::max(), operations.size() + 1);
+
+    for (size_t i = 0; i < operations.size(); i++) {
+      if (operations[i].type == type) {
+        latencies.set(durations[i].ms(), timestamps[i]);
+      }
+    }
+
+    Option<Statistics<double>> statistics =
+      Statistics<double>::from(latencies);
+
+    if (statistics.isSome()) {
+      cout << Operation::name(type) << " latency (ms):"
+           << " count " << statistics.get().count
+           << ", p50 " << statistics.get().p50
+           << ", p99 " << statistics.get().p99
+           << ", p999 " << statistics.get().p999
+           << ", max " << statistics.get().max << endl;
+    }
+  }
+
   // Ouput statistics.
   ofstream output(flags.output.get().c_str());
   if (!output.is_open()) {
     return Error("Failed to open the output file " + flags.output.get());
   }
 
-  for (size_t i = 0; i < sizes.size(); i++) {
-    output << timestamps[i]
-           << " Appended " << sizes[i].bytes() << " bytes"
-           << " in " << durations[i].ms() << " ms" << endl;
+  for (size_t i = 0; i < operations.size(); i++) {
+    output << timestamps[i];
+
+    switch (operations[i].type) {
+      case Operation::APPEND:
+        output << " Appended " << operations[i].size.bytes() << " bytes";
+        break;
+      case Operation::READ:
+        output << " Read " << operations[i].count << " entries";
+        break;
+      case Operation::TRUNCATE:
+        output << " Truncated to " << operations[i].count << " entries";
+        break;
+    }
+
+    output << " in " << durations[i].ms() << " ms" << endl;
   }
 
   output.close();
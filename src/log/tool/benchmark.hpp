@@ -46,6 +46,7 @@ public:
     Option<std::string> input;
     Option<std::string> output;
     std::string type;
+    size_t concurrency;
     bool initialize;
     bool help;
   };
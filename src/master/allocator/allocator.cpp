@@ -28,6 +28,7 @@
 
 using std::string;
 
+using mesos::internal::master::allocator::HierarchicalBucketedDRFAllocator;
 using mesos::internal::master::allocator::HierarchicalDRFAllocator;
 
 namespace mesos {
@@ -36,12 +37,14 @@ namespace allocator {
 
 Try<Allocator*> Allocator::create(const string& name)
 {
-  // Create an instance of the default allocator. If other than the
-  // default allocator is requested, search for it in loaded modules.
+  // Create an instance of a built-in allocator. If other than the
+  // built-in allocators is requested, search for it in loaded modules.
   // NOTE: We do not need an extra not-null check, because both
   // ModuleManager and built-in allocator factory do that already.
   if (name == mesos::internal::master::DEFAULT_ALLOCATOR) {
     return HierarchicalDRFAllocator::create();
+  } else if (name == mesos::internal::master::BUCKETED_DRF_ALLOCATOR) {
+    return HierarchicalBucketedDRFAllocator::create();
   }
 
   return modules::ModuleManager::create<Allocator>(name);
@@ -107,6 +107,9 @@ public:
   void reviveOffers(
       const FrameworkID& frameworkId);
 
+  void suppressOffers(
+      const FrameworkID& frameworkId);
+
 private:
   MesosAllocator();
   MesosAllocator(const MesosAllocator&); // Not copyable.
@@ -188,6 +191,9 @@ public:
 
   virtual void reviveOffers(
       const FrameworkID& frameworkId) = 0;
+
+  virtual void suppressOffers(
+      const FrameworkID& frameworkId) = 0;
 };
 
 
@@ -411,6 +417,17 @@ inline void MesosAllocator<AllocatorProcess>::reviveOffers(
       frameworkId);
 }
 
+
+template <typename AllocatorProcess>
+inline void MesosAllocator<AllocatorProcess>::suppressOffers(
+    const FrameworkID& frameworkId)
+{
+  process::dispatch(
+      process,
+      &MesosAllocatorProcess::suppressOffers,
+      frameworkId);
+}
+
 } // namespace allocator {
 } // namespace master {
 } // namespace internal {
@@ -20,22 +20,33 @@
 #define __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <list>
 #include <vector>
 
 #include <mesos/resources.hpp>
 #include <mesos/type_utils.hpp>
 
+#include <process/defer.hpp>
 #include <process/delay.hpp>
+#include <process/dispatch.hpp>
 #include <process/id.hpp>
 #include <process/timeout.hpp>
 
+#include <process/metrics/gauge.hpp>
+#include <process/metrics/metrics.hpp>
+
 #include <stout/check.hpp>
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+#include <stout/option.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 
 #include "master/allocator/mesos/allocator.hpp"
+#include "master/allocator/sorter/bucketed/sorter.hpp"
 #include "master/allocator/sorter/drf/sorter.hpp"
 
 #include "master/constants.hpp"
@@ -60,6 +71,14 @@ HierarchicalDRFAllocatorProcess;
 typedef MesosAllocator<HierarchicalDRFAllocatorProcess>
 HierarchicalDRFAllocator;
 
+// Sorts the roles exactly but the frameworks within a role only
+// approximately, for roles with a large number of frameworks.
+typedef HierarchicalAllocatorProcess<DRFSorter, BucketedDRFSorter>
+HierarchicalBucketedDRFAllocatorProcess;
+
+typedef MesosAllocator<HierarchicalBucketedDRFAllocatorProcess>
+HierarchicalBucketedDRFAllocator;
+
 
 // Implements the basic allocator algorithm - first pick a role by
 // some criteria, then pick one of their frameworks to allocate to.
@@ -134,6 +153,9 @@ public:
   void reviveOffers(
       const FrameworkID& frameworkId);
 
+  void suppressOffers(
+      const FrameworkID& frameworkId);
+
 protected:
   // Useful typedefs for dispatch/delay/defer to self()/this.
   typedef HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter> Self;
@@ -142,20 +164,34 @@ protected:
   // Callback for doing batch allocations.
   void batch();
 
-  // Allocate any allocatable resources.
+  // Requests an allocation of any allocatable resources from all
+  // slaves, see 'trigger()'.
   void allocate();
 
-  // Allocate resources just from the specified slave.
+  // Requests an allocation of the resources of just the specified
+  // slave, see 'trigger()'.
   void allocate(const SlaveID& slaveId);
 
+  // Schedules an allocation of the requested slaves, unless one is
+  // already scheduled or the allocator is falling behind.
+  void trigger();
+
+  // Allocates the resources of the requested slaves, i.e., the
+  // 'allocationCandidates' or all slaves if 'allocateAll' is set.
+  void allocatePending();
+
   // Allocate resources from the specified slaves.
   void allocate(const hashset<SlaveID>& slaveIds);
 
   // Remove a filter for the specified framework.
-  void expire(const FrameworkID& frameworkId, Filter* filter);
+  void expire(
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId,
+      Filter* filter);
 
-  // Checks whether the slave is whitelisted.
-  bool isWhitelisted(const SlaveID& slaveId);
+  // Checks whether the host is whitelisted. This is evaluated when a
+  // slave is added or the whitelist changes, see 'Slave::whitelisted'.
+  bool isWhitelisted(const std::string& hostname);
 
   // Returns true if there is a filter for this framework
   // on this slave.
@@ -166,6 +202,47 @@ protected:
 
   bool allocatable(const Resources& resources);
 
+  // Returns the resources to offer to a framework with the specified
+  // task shapes, i.e., the largest multiple of the first shape that
+  // fits in 'resources', or none if no shape fits.
+  Option<Resources> shape(
+      const Resources& resources,
+      const std::vector<Resources>& shapes);
+
+  // Returns whether the attributes of the slave satisfy the
+  // constraints of the framework, see 'FrameworkInfo.constraints'.
+  bool satisfies(const FrameworkID& frameworkId, const SlaveID& slaveId);
+
+  // The resources of a slave that can be allocated to frameworks of
+  // a particular role are the unreserved resources and the resources
+  // reserved for that role.
+  struct Offerable
+  {
+    Offerable() {}
+
+    explicit Offerable(const Resources& available)
+      : unreserved(available.unreserved()),
+        reserved(available.reserved()) {}
+
+    Resources unreserved;
+    hashmap<std::string, Resources> reserved;
+  };
+
+  // Computes the offerable resources for each of the available
+  // resources.
+  std::vector<Offerable> offerables(
+      const std::vector<const Resources*>& available);
+
+  // Gauge handler, returns the number of dispatches (i.e., allocator
+  // calls) waiting in the event queue of the allocator.
+  double _event_queue_dispatches()
+  {
+    return static_cast<double>(
+        eventCount<process::DispatchEvent>());
+  }
+
+  process::metrics::Gauge event_queue_dispatches;
+
   bool initialized;
 
   Duration allocationInterval;
@@ -182,11 +259,33 @@ protected:
     // Whether the framework desires revocable resources.
     bool revocable;
 
-    hashset<Filter*> filters; // Active filters for the framework.
+    // Whether the framework asked not to get offers until it revives
+    // them, in which case it is deactivated in its sorter.
+    bool suppressed;
+
+    // Active filters for the framework, indexed by the slave they
+    // apply to so that checking the filters of a slave does not
+    // need to go through the filters for all the other slaves.
+    hashmap<SlaveID, hashset<Filter*>> filters;
+
+    std::vector<FrameworkInfo::Constraint> constraints;
+
+    // The slaves whose attributes satisfy the constraints, which is
+    // maintained as frameworks and slaves are added so that the
+    // constraints are not evaluated during allocations. None if the
+    // framework has no constraints.
+    Option<hashset<SlaveID>> satisfying;
+
+    // The task shapes of the framework, see 'FrameworkInfo.task_shapes'.
+    std::vector<Resources> shapes;
   };
 
   hashmap<FrameworkID, Framework> frameworks;
 
+  // The number of frameworks with task shapes. While there are any,
+  // the slaves that are in use get allocated first.
+  size_t shapedFrameworks;
+
   struct Slave
   {
     // Total amount of regular *and* oversubscribed resources.
@@ -195,14 +294,45 @@ protected:
     // Available regular *and* oversubscribed resources.
     Resources available;
 
-    bool activated;  // Whether to offer resources.
-    bool checkpoint; // Whether slave supports checkpointing.
+    bool activated;   // Whether to offer resources.
+    bool checkpoint;  // Whether slave supports checkpointing.
+    bool whitelisted; // Whether the slave's host is whitelisted.
 
     std::string hostname;
+
+    // The attributes of the slave along with their values for text
+    // attributes, see 'satisfies'.
+    hashmap<std::string, Option<std::string>> attributes;
   };
 
   hashmap<SlaveID, Slave> slaves;
 
+  // Slaves that need to be considered during the next batch
+  // allocation because their (allocatable) resources might have
+  // changed since they were last considered, e.g., resources were
+  // recovered or a filter expired. Only these slaves are considered
+  // in a batch allocation, so that the cost of a batch allocation
+  // scales with the churn in the cluster rather than with its size.
+  // Changes that can affect all slaves (e.g., adding or reviving a
+  // framework) trigger an allocation across all slaves instead.
+  hashset<SlaveID> allocationCandidates;
+
+  // Allocations requested by events (e.g., adding a slave) are not
+  // performed right away but coalesced: the first request dispatches
+  // an allocation to the end of the event queue of the allocator and
+  // the requests queued before it get served by that allocation. So
+  // under churn there is an allocation per batch of events rather
+  // than per event, while a lone event is still served right away.
+  //
+  // An allocation that takes longer than 'allocationInterval' means
+  // the allocator is falling behind. Until an allocation is fast
+  // enough again the requests are then left to the batch allocation,
+  // which in turn is delayed by the duration of the last allocation
+  // so that the allocator spends at most half of its time allocating.
+  bool allocateAll; // Whether all slaves have been requested.
+  bool allocationTriggered; // Whether an allocation is dispatched.
+  Duration allocationDuration; // The duration of the last allocation.
+
   hashmap<std::string, mesos::master::RoleInfo> roles;
 
   // Slaves to send offers for.
@@ -261,12 +391,24 @@ public:
 template <class RoleSorter, class FrameworkSorter>
 HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::HierarchicalAllocatorProcess() // NOLINT(whitespace/line_length)
   : ProcessBase(process::ID::generate("hierarchical-allocator")),
-    initialized(false) {}
+    event_queue_dispatches(
+        "allocator/event_queue_dispatches",
+        process::defer(self(), &Self::_event_queue_dispatches)),
+    initialized(false),
+    shapedFrameworks(0),
+    allocateAll(false),
+    allocationTriggered(false),
+    allocationDuration(Duration::zero())
+{
+  process::metrics::add(event_queue_dispatches);
+}
 
 
 template <class RoleSorter, class FrameworkSorter>
 HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::~HierarchicalAllocatorProcess() // NOLINT(whitespace/line_length)
-{}
+{
+  process::metrics::remove(event_queue_dispatches);
+}
 
 
 template <class RoleSorter, class FrameworkSorter>
@@ -337,6 +479,7 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::addFramework(
   frameworks[frameworkId] = Framework();
   frameworks[frameworkId].role = frameworkInfo.role();
   frameworks[frameworkId].checkpoint = frameworkInfo.checkpoint();
+  frameworks[frameworkId].suppressed = false;
 
   // Check if the framework desires revocable resources.
   frameworks[frameworkId].revocable = false;
@@ -347,6 +490,29 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::addFramework(
     }
   }
 
+  if (frameworkInfo.constraints_size() > 0) {
+    frameworks[frameworkId].constraints.assign(
+        frameworkInfo.constraints().begin(),
+        frameworkInfo.constraints().end());
+
+    frameworks[frameworkId].satisfying = hashset<SlaveID>();
+
+    foreachkey (const SlaveID& slaveId, slaves) {
+      if (satisfies(frameworkId, slaveId)) {
+        frameworks[frameworkId].satisfying.get().insert(slaveId);
+      }
+    }
+  }
+
+  foreach (const FrameworkInfo::TaskShape& shape,
+           frameworkInfo.task_shapes()) {
+    frameworks[frameworkId].shapes.push_back(shape.resources());
+  }
+
+  if (!frameworks[frameworkId].shapes.empty()) {
+    ++shapedFrameworks;
+  }
+
   LOG(INFO) << "Added framework " << frameworkId;
 
   allocate();
@@ -378,6 +544,10 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::removeFramework(
     frameworkSorters[role]->remove(frameworkId.value());
   }
 
+  if (!frameworks[frameworkId].shapes.empty()) {
+    --shapedFrameworks;
+  }
+
   // Do not delete the filters contained in this
   // framework's 'filters' hashset yet, see comments in
   // HierarchicalAllocatorProcess::reviveOffers and
@@ -399,6 +569,7 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::activateFramework(
   const std::string& role = frameworks[frameworkId].role;
 
   frameworkSorters[role]->activate(frameworkId.value());
+  frameworks[frameworkId].suppressed = false;
 
   LOG(INFO) << "Activated framework " << frameworkId;
 
@@ -430,6 +601,10 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::deactivateFramework(
   // HierarchicalAllocatorProcess::expire.
   frameworks[frameworkId].filters.clear();
 
+  // The suppression of offers does not outlive the framework being
+  // active, i.e., a failed over scheduler gets offers again.
+  frameworks[frameworkId].suppressed = false;
+
   LOG(INFO) << "Deactivated framework " << frameworkId;
 }
 
@@ -469,6 +644,22 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::addSlave(
   slaves[slaveId].activated = true;
   slaves[slaveId].checkpoint = slaveInfo.checkpoint();
   slaves[slaveId].hostname = slaveInfo.hostname();
+  slaves[slaveId].whitelisted = isWhitelisted(slaveInfo.hostname());
+
+  foreach (const Attribute& attribute, slaveInfo.attributes()) {
+    slaves[slaveId].attributes[attribute.name()] =
+      attribute.type() == Value::TEXT
+        ? attribute.text().value()
+        : Option<std::string>::none();
+  }
+
+  foreachpair (const FrameworkID& frameworkId,
+               Framework& framework,
+               frameworks) {
+    if (framework.satisfying.isSome() && satisfies(frameworkId, slaveId)) {
+      framework.satisfying.get().insert(slaveId);
+    }
+  }
 
   LOG(INFO) << "Added slave " << slaveId << " (" << slaves[slaveId].hostname
             << ") with " << slaves[slaveId].total
@@ -495,6 +686,13 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::removeSlave(
   roleSorter->remove(slaveId, slaves[slaveId].total.unreserved());
 
   slaves.erase(slaveId);
+  allocationCandidates.erase(slaveId);
+
+  foreachvalue (Framework& framework, frameworks) {
+    if (framework.satisfying.isSome()) {
+      framework.satisfying.get().erase(slaveId);
+    }
+  }
 
   // Note that we DO NOT actually delete any filters associated with
   // this slave, that will occur when the delayed
@@ -563,6 +761,8 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::activateSlave(
 
   slaves[slaveId].activated = true;
 
+  allocationCandidates.insert(slaveId);
+
   LOG(INFO)<< "Slave " << slaveId << " reactivated";
 }
 
@@ -590,6 +790,18 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::updateWhitelist(
 
   whitelist = _whitelist;
 
+  // Only the slaves that have become whitelisted need to be
+  // considered during the next allocation.
+  foreachpair (const SlaveID& slaveId, Slave& slave, slaves) {
+    const bool whitelisted = isWhitelisted(slave.hostname);
+
+    if (whitelisted && !slave.whitelisted) {
+      allocationCandidates.insert(slaveId);
+    }
+
+    slave.whitelisted = whitelisted;
+  }
+
   if (whitelist.isSome()) {
     LOG(INFO) << "Updated slave whitelist: " << stringify(whitelist.get());
 
@@ -715,6 +927,8 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::recoverResources(
   if (slaves.contains(slaveId)) {
     slaves[slaveId].available += resources;
 
+    allocationCandidates.insert(slaveId);
+
     LOG(INFO) << "Recovered " << resources
               << " (total allocatable: " << slaves[slaveId].available
               << ") on slave " << slaveId
@@ -761,9 +975,14 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::recoverResources(
         resources,
         process::Timeout::in(seconds.get()));
 
-    frameworks[frameworkId].filters.insert(filter);
+    frameworks[frameworkId].filters[slaveId].insert(filter);
 
-    delay(seconds.get(), self(), &Self::expire, frameworkId, filter);
+    delay(seconds.get(),
+          self(),
+          &Self::expire,
+          frameworkId,
+          slaveId,
+          filter);
   }
 }
 
@@ -786,30 +1005,65 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::reviveOffers(
 
   LOG(INFO) << "Removed filters for framework " << frameworkId;
 
+  if (frameworks[frameworkId].suppressed) {
+    frameworks[frameworkId].suppressed = false;
+
+    const std::string& role = frameworks[frameworkId].role;
+    frameworkSorters[role]->activate(frameworkId.value());
+
+    LOG(INFO) << "Stopped suppressing offers for framework " << frameworkId;
+  }
+
   allocate();
 }
 
 
 template <class RoleSorter, class FrameworkSorter>
 void
-HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::batch()
+HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::suppressOffers(
+    const FrameworkID& frameworkId)
 {
-  allocate();
-  delay(allocationInterval, self(), &Self::batch);
+  CHECK(initialized);
+
+  CHECK(frameworks.contains(frameworkId));
+
+  if (frameworks[frameworkId].suppressed) {
+    return;
+  }
+
+  frameworks[frameworkId].suppressed = true;
+
+  // Deactivating the framework in its sorter keeps it from being
+  // considered in allocations until it revives offers, while (as for
+  // a deactivated framework) its allocation still counts towards
+  // the shares.
+  const std::string& role = frameworks[frameworkId].role;
+  frameworkSorters[role]->deactivate(frameworkId.value());
+
+  LOG(INFO) << "Suppressed offers for framework " << frameworkId;
 }
 
 
 template <class RoleSorter, class FrameworkSorter>
 void
-HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::allocate()
+HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::batch()
 {
-  Stopwatch stopwatch;
-  stopwatch.start();
+  allocatePending();
+
+  // Back off if the allocator is falling behind, see
+  // 'allocationDuration'.
+  delay(std::max(allocationInterval, allocationDuration),
+        self(),
+        &Self::batch);
+}
 
-  allocate(slaves.keys());
 
-  VLOG(1) << "Performed allocation for " << slaves.size() << " slaves in "
-            << stopwatch.elapsed();
+template <class RoleSorter, class FrameworkSorter>
+void
+HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::allocate()
+{
+  allocateAll = true;
+  trigger();
 }
 
 
@@ -818,16 +1072,51 @@ void
 HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::allocate(
     const SlaveID& slaveId)
 {
+  allocationCandidates.insert(slaveId);
+  trigger();
+}
+
+
+template <class RoleSorter, class FrameworkSorter>
+void
+HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::trigger()
+{
+  if (allocationTriggered || allocationDuration > allocationInterval) {
+    return;
+  }
+
+  allocationTriggered = true;
+
+  dispatch(self(), &Self::allocatePending);
+}
+
+
+template <class RoleSorter, class FrameworkSorter>
+void
+HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::allocatePending()
+{
+  allocationTriggered = false;
+
+  if (!allocateAll && allocationCandidates.empty()) {
+    return;
+  }
+
   Stopwatch stopwatch;
   stopwatch.start();
 
-  // TODO(bmahler): Add initializer list constructor for hashset.
-  hashset<SlaveID> slaves;
-  slaves.insert(slaveId);
-  allocate(slaves);
+  // NOTE: We copy the candidates since 'allocate' removes the
+  // slaves it considers from 'allocationCandidates'.
+  const hashset<SlaveID> candidates =
+    allocateAll ? slaves.keys() : allocationCandidates;
+
+  allocateAll = false;
+
+  allocate(candidates);
+
+  allocationDuration = stopwatch.elapsed();
 
-  VLOG(1) << "Performed allocation for slave " << slaveId << " in "
-          << stopwatch.elapsed();
+  VLOG(1) << "Performed allocation for " << candidates.size()
+          << " of " << slaves.size() << " slaves in " << allocationDuration;
 }
 
 
@@ -850,26 +1139,86 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::allocate(
 
   // Randomize the order in which slaves' resources are allocated.
   // TODO(vinod): Implement a smarter sorting algorithm.
-  std::vector<SlaveID> slaveIds(slaveIds_.begin(), slaveIds_.end());
-  std::random_shuffle(slaveIds.begin(), slaveIds.end());
+  std::vector<SlaveID> slaveIds;
+  std::vector<const Resources*> available;
+
+  std::vector<SlaveID> shuffled(slaveIds_.begin(), slaveIds_.end());
+  std::random_shuffle(shuffled.begin(), shuffled.end());
+
+  // Frameworks with task shapes only get part of a slave, so pack
+  // the allocations onto the slaves that are already in use to keep
+  // the unused slaves whole.
+  if (shapedFrameworks > 0) {
+    std::stable_partition(
+        shuffled.begin(),
+        shuffled.end(),
+        [this](const SlaveID& slaveId) {
+          return slaves[slaveId].available != slaves[slaveId].total;
+        });
+  }
+
+  foreach (const SlaveID& slaveId, shuffled) {
+    // This slave is being taken care of by this allocation.
+    allocationCandidates.erase(slaveId);
 
-  foreach (const SlaveID& slaveId, slaveIds) {
     // Don't send offers for non-whitelisted and deactivated slaves.
-    if (!isWhitelisted(slaveId) || !slaves[slaveId].activated) {
+    if (!slaves[slaveId].whitelisted || !slaves[slaveId].activated) {
       continue;
     }
 
-    foreach (const std::string& role, roleSorter->sort()) {
-      foreach (const std::string& frameworkId_,
-               frameworkSorters[role]->sort()) {
+    // Nothing to allocate from this slave if its available resources
+    // are not allocatable, since neither are any subset of them.
+    if (!allocatable(slaves[slaveId].available)) {
+      continue;
+    }
+
+    slaveIds.push_back(slaveId);
+    available.push_back(&slaves[slaveId].available);
+  }
+
+  // Splitting the available resources of each slave by role is
+  // independent of the other slaves (and of the sorting below) so we
+  // do it upfront rather than for every framework. The actual
+  // allocation (i.e., walking the sorted roles and frameworks) is
+  // inherently sequential and updates the offerable resources of a
+  // slave as resources on it get allocated.
+  std::vector<Offerable> offerables_ = offerables(available);
+
+  // The order of the roles (and of the frameworks within a role) can
+  // only change when we allocate resources (to a role), so rather
+  // than sorting for every slave we only sort again after an
+  // allocation has been made.
+  Option<std::list<std::string>> roleOrder;
+  hashmap<std::string, std::list<std::string>> frameworkOrders;
+
+  for (size_t i = 0; i < slaveIds.size(); i++) {
+    const SlaveID& slaveId = slaveIds[i];
+
+    if (roleOrder.isNone()) {
+      roleOrder = roleSorter->sort();
+    }
+
+    // NOTE: We iterate over copies of the orders since they get
+    // invalidated when we allocate resources on this slave.
+    const std::list<std::string> sortedRoles = roleOrder.get();
+
+    foreach (const std::string& role, sortedRoles) {
+      if (!frameworkOrders.contains(role)) {
+        frameworkOrders[role] = frameworkSorters[role]->sort();
+      }
+
+      const std::list<std::string> sortedFrameworks = frameworkOrders[role];
+
+      foreach (const std::string& frameworkId_, sortedFrameworks) {
         FrameworkID frameworkId;
         frameworkId.set_value(frameworkId_);
 
         // NOTE: Currently, frameworks are allowed to have '*' role.
-        // Calling reserved('*') returns an empty Resources object.
-        Resources resources =
-          slaves[slaveId].available.unreserved() +
-          slaves[slaveId].available.reserved(role);
+        // There are never any resources reserved for '*'.
+        Resources resources = offerables_[i].unreserved;
+        if (offerables_[i].reserved.contains(role)) {
+          resources += offerables_[i].reserved[role];
+        }
 
         // Remove revocable resources if the framework has not opted
         // for them.
@@ -877,6 +1226,19 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::allocate(
           resources -= resources.revocable();
         }
 
+        // Only offer whole multiples of a task shape of the framework,
+        // if it has any.
+        if (!frameworks[frameworkId].shapes.empty()) {
+          Option<Resources> shaped =
+            shape(resources, frameworks[frameworkId].shapes);
+
+          if (shaped.isNone()) {
+            continue;
+          }
+
+          resources = shaped.get();
+        }
+
         // If the resources are not allocatable, ignore.
         if (!allocatable(resources)) {
           continue;
@@ -892,9 +1254,12 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::allocate(
 
         // Note that we perform "coarse-grained" allocation,
         // meaning that we always allocate the entire remaining
-        // slave resources to a single framework.
+        // slave resources to a single framework (unless it has task
+        // shapes, in which case the rest remains for the frameworks
+        // after it).
         offerable[frameworkId][slaveId] = resources;
         slaves[slaveId].available -= resources;
+        offerables_[i] = Offerable(slaves[slaveId].available);
 
         // Reserved resources are only accounted for in the framework
         // sorter, since the reserved resources are not shared across
@@ -902,6 +1267,11 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::allocate(
         frameworkSorters[role]->add(slaveId, resources);
         frameworkSorters[role]->allocated(frameworkId_, slaveId, resources);
         roleSorter->allocated(role, slaveId, resources.unreserved());
+
+        // The shares have changed so we need to sort again (starting
+        // with the next slave, as if we sorted for each slave).
+        roleOrder = None();
+        frameworkOrders.erase(role);
       }
     }
   }
@@ -917,10 +1287,28 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::allocate(
 }
 
 
+template <class RoleSorter, class FrameworkSorter>
+std::vector<
+    typename HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::Offerable> // NOLINT(whitespace/line_length)
+HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::offerables(
+    const std::vector<const Resources*>& available)
+{
+  std::vector<Offerable> result;
+  result.reserve(available.size());
+
+  foreach (const Resources* resources, available) {
+    result.push_back(Offerable(*resources));
+  }
+
+  return result;
+}
+
+
 template <class RoleSorter, class FrameworkSorter>
 void
 HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::expire(
     const FrameworkID& frameworkId,
+    const SlaveID& slaveId,
     Filter* filter)
 {
   // The filter might have already been removed (e.g., if the
@@ -929,8 +1317,18 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::expire(
   // keep the address from getting reused possibly causing premature
   // expiration).
   if (frameworks.contains(frameworkId) &&
-      frameworks[frameworkId].filters.contains(filter)) {
-    frameworks[frameworkId].filters.erase(filter);
+      frameworks[frameworkId].filters.contains(slaveId) &&
+      frameworks[frameworkId].filters[slaveId].contains(filter)) {
+    frameworks[frameworkId].filters[slaveId].erase(filter);
+
+    if (frameworks[frameworkId].filters[slaveId].empty()) {
+      frameworks[frameworkId].filters.erase(slaveId);
+    }
+
+    // The filtered resources can now be allocated to the framework.
+    if (slaves.contains(slaveId)) {
+      allocationCandidates.insert(slaveId);
+    }
   }
 
   delete filter;
@@ -940,12 +1338,9 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::expire(
 template <class RoleSorter, class FrameworkSorter>
 bool
 HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::isWhitelisted(
-    const SlaveID& slaveId)
+    const std::string& hostname)
 {
-  CHECK(slaves.contains(slaveId));
-
-  return whitelist.isNone() ||
-         whitelist.get().contains(slaves[slaveId].hostname);
+  return whitelist.isNone() || whitelist.get().contains(hostname);
 }
 
 
@@ -969,18 +1364,65 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::isFiltered(
     return true;
   }
 
-  foreach (Filter* filter, frameworks[frameworkId].filters) {
-    if (filter->filter(slaveId, resources)) {
-      VLOG(1) << "Filtered " << resources
-              << " on slave " << slaveId
-              << " for framework " << frameworkId;
-      return true;
+  if (frameworks[frameworkId].satisfying.isSome() &&
+      !frameworks[frameworkId].satisfying.get().contains(slaveId)) {
+    VLOG(1) << "Filtered " << resources
+            << " on slave " << slaveId
+            << " not satisfying the constraints of framework " << frameworkId;
+    return true;
+  }
+
+  if (frameworks[frameworkId].filters.contains(slaveId)) {
+    foreach (Filter* filter, frameworks[frameworkId].filters[slaveId]) {
+      if (filter->filter(slaveId, resources)) {
+        VLOG(1) << "Filtered " << resources
+                << " on slave " << slaveId
+                << " for framework " << frameworkId;
+        return true;
+      }
     }
   }
+
   return false;
 }
 
 
+template <class RoleSorter, class FrameworkSorter>
+bool
+HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::satisfies(
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId)
+{
+  CHECK(frameworks.contains(frameworkId));
+  CHECK(slaves.contains(slaveId));
+
+  const hashmap<std::string, Option<std::string>>& attributes =
+    slaves[slaveId].attributes;
+
+  foreach (const FrameworkInfo::Constraint& constraint,
+           frameworks[frameworkId].constraints) {
+    if (!attributes.contains(constraint.attribute())) {
+      return false;
+    }
+
+    if (constraint.values_size() == 0) {
+      continue;
+    }
+
+    const Option<std::string>& value = attributes.at(constraint.attribute());
+
+    if (value.isNone() ||
+        std::find(constraint.values().begin(),
+                  constraint.values().end(),
+                  value.get()) == constraint.values().end()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
 template <class RoleSorter, class FrameworkSorter>
 bool
 HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::allocatable(
@@ -993,6 +1435,88 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::allocatable(
          (mem.isSome() && mem.get() >= MIN_MEM);
 }
 
+
+template <class RoleSorter, class FrameworkSorter>
+Option<Resources>
+HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::shape(
+    const Resources& resources,
+    const std::vector<Resources>& shapes)
+{
+  // Only the plain scalar resources get split, persistent volumes
+  // and revocable resources are offered whole.
+  const Resources splittable = resources.filter([](const Resource& resource) {
+    return resource.type() == Value::SCALAR &&
+      !resource.has_disk() &&
+      !resource.has_revocable();
+  });
+
+  // Reserved resources are taken first since they can't be used by
+  // the frameworks of other roles anyway.
+  const Resources unreserved = splittable.unreserved();
+  const std::vector<Resources> pools = {splittable - unreserved, unreserved};
+
+  foreach (const Resources& shape, shapes) {
+    // The number of copies of the shape that fit.
+    double copies = std::numeric_limits<double>::max();
+
+    foreach (const Resource& resource, shape) {
+      Option<Value::Scalar> available =
+        splittable.get<Value::Scalar>(resource.name());
+
+      // NOTE: The epsilon guards against, e.g., 1.0 / 0.1 < 10.
+      copies = std::min(
+          copies,
+          available.isNone()
+            ? 0.0
+            : std::floor(
+                  available.get().value() / resource.scalar().value() + 1e-6));
+    }
+
+    if (copies < 1) {
+      continue;
+    }
+
+    Resources shaped = resources - splittable;
+    hashset<std::string> names;
+
+    foreach (const Resource& resource, shape) {
+      names.insert(resource.name());
+
+      double remaining = copies * resource.scalar().value();
+
+      foreach (const Resources& pool, pools) {
+        foreach (const Resource& available, pool) {
+          if (remaining <= 0) {
+            break;
+          }
+
+          if (available.name() != resource.name()) {
+            continue;
+          }
+
+          Resource taken = available;
+          taken.mutable_scalar()->set_value(
+              std::min(remaining, available.scalar().value()));
+
+          shaped += taken;
+          remaining -= taken.scalar().value();
+        }
+      }
+    }
+
+    // The resources not named in the shape are offered whole.
+    foreach (const Resource& resource, splittable) {
+      if (!names.contains(resource.name())) {
+        shaped += resource;
+      }
+    }
+
+    return shaped;
+  }
+
+  return None();
+}
+
 } // namespace allocator {
 } // namespace master {
 } // namespace internal {
@@ -0,0 +1,380 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include <stout/foreach.hpp>
+
+#include "logging/logging.hpp"
+
+#include "master/allocator/sorter/bucketed/sorter.hpp"
+
+using std::list;
+using std::string;
+using std::vector;
+
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+// Clients with a (weighted) share of at least 'MAX_SHARE' are all
+// kept in the last bucket. Shares above 1 only arise for clients
+// with a weight below 1, which is why this is not 1.
+static const double MAX_SHARE = 10.0;
+
+
+// Adds the quantities of the scalar resources in 'resources' to
+// 'scalars'.
+static void addScalars(
+    hashmap<string, double>* scalars,
+    const Resources& resources)
+{
+  foreach (const Resource& resource, resources) {
+    if (resource.type() == Value::SCALAR) {
+      (*scalars)[resource.name()] += resource.scalar().value();
+    }
+  }
+}
+
+
+// Subtracts the quantities of the scalar resources in 'resources'
+// from 'scalars'.
+static void subtractScalars(
+    hashmap<string, double>* scalars,
+    const Resources& resources)
+{
+  foreach (const Resource& resource, resources) {
+    if (resource.type() == Value::SCALAR) {
+      (*scalars)[resource.name()] -= resource.scalar().value();
+    }
+  }
+}
+
+
+BucketedDRFSorter::BucketedDRFSorter(size_t _resolution)
+  : resolution(std::max<size_t>(_resolution, 1)),
+    dirty(false) {}
+
+
+void BucketedDRFSorter::add(const string& name, double weight)
+{
+  Client& client = clients[name];
+  client.weight = weight;
+  client.active = false;
+
+  // Like the DRFSorter, which orders new clients before the clients
+  // with the same share that have been allocated to, new clients
+  // are put at the front of their bucket.
+  insert(name, &client, 0, true);
+}
+
+
+void BucketedDRFSorter::remove(const string& name)
+{
+  deactivate(name);
+
+  clients.erase(name);
+}
+
+
+void BucketedDRFSorter::activate(const string& name)
+{
+  CHECK(clients.contains(name));
+
+  Client& client = clients[name];
+
+  if (!client.active) {
+    insert(name, &client, bucket(client), true);
+  }
+}
+
+
+void BucketedDRFSorter::deactivate(const string& name)
+{
+  if (!clients.contains(name)) {
+    return;
+  }
+
+  Client& client = clients[name];
+
+  if (client.active) {
+    buckets[client.bucket].erase(client.position);
+    client.active = false;
+  }
+}
+
+
+void BucketedDRFSorter::allocated(
+    const string& name,
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  CHECK(clients.contains(name));
+
+  Client& client = clients[name];
+
+  client.allocation[slaveId] += resources;
+  addScalars(&client.scalars, resources);
+
+  // NOTE: If the total resources have changed the bucket gets
+  // recalculated in sort(), but the client is still moved to the
+  // back of the clients with the same share.
+  place(name, &client, true);
+}
+
+
+void BucketedDRFSorter::update(
+    const string& name,
+    const SlaveID& slaveId,
+    const Resources& oldAllocation,
+    const Resources& newAllocation)
+{
+  CHECK(clients.contains(name));
+
+  Client& client = clients[name];
+
+  CHECK(resources[slaveId].contains(oldAllocation));
+
+  resources[slaveId] -= oldAllocation;
+  resources[slaveId] += newAllocation;
+
+  CHECK(client.allocation[slaveId].contains(oldAllocation));
+
+  client.allocation[slaveId] -= oldAllocation;
+  if (client.allocation[slaveId].empty()) {
+    client.allocation.erase(slaveId);
+  }
+
+  client.allocation[slaveId] += newAllocation;
+
+  subtractScalars(&totalScalars, oldAllocation);
+  addScalars(&totalScalars, newAllocation);
+
+  subtractScalars(&client.scalars, oldAllocation);
+  addScalars(&client.scalars, newAllocation);
+
+  // See DRFSorter::update().
+  Scalars oldScalars;
+  addScalars(&oldScalars, oldAllocation);
+
+  Scalars newScalars;
+  addScalars(&newScalars, newAllocation);
+
+  if (oldScalars != newScalars) {
+    dirty = true;
+  } else if (!dirty) {
+    place(name, &client, false);
+  }
+}
+
+
+void BucketedDRFSorter::unallocated(
+    const string& name,
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  CHECK(clients.contains(name));
+
+  Client& client = clients[name];
+
+  client.allocation[slaveId] -= resources;
+  if (client.allocation[slaveId].empty()) {
+    client.allocation.erase(slaveId);
+  }
+
+  subtractScalars(&client.scalars, resources);
+
+  if (!dirty) {
+    place(name, &client, false);
+  }
+}
+
+
+hashmap<SlaveID, Resources> BucketedDRFSorter::allocation(const string& name)
+{
+  if (!clients.contains(name)) {
+    return hashmap<SlaveID, Resources>();
+  }
+
+  return clients[name].allocation;
+}
+
+
+void BucketedDRFSorter::add(
+    const SlaveID& slaveId,
+    const Resources& _resources)
+{
+  resources[slaveId] += _resources;
+  addScalars(&totalScalars, _resources);
+
+  // As in the DRFSorter, the shares are only recalculated once
+  // sort() is called.
+  dirty = true;
+}
+
+
+void BucketedDRFSorter::remove(
+    const SlaveID& slaveId,
+    const Resources& _resources)
+{
+  CHECK(resources.contains(slaveId));
+
+  resources[slaveId] -= _resources;
+  subtractScalars(&totalScalars, _resources);
+
+  if (resources[slaveId].empty()) {
+    resources.erase(slaveId);
+  }
+
+  dirty = true;
+}
+
+
+void BucketedDRFSorter::update(
+    const SlaveID& slaveId,
+    const Resources& _resources)
+{
+  CHECK(resources.contains(slaveId));
+
+  subtractScalars(&totalScalars, resources[slaveId]);
+  addScalars(&totalScalars, _resources);
+
+  resources[slaveId] = _resources;
+
+  if (resources[slaveId].empty()) {
+    resources.erase(slaveId);
+  }
+
+  dirty = true;
+}
+
+
+list<string> BucketedDRFSorter::sort()
+{
+  if (dirty) {
+    // Redistribute the clients over new buckets. Going through the
+    // old buckets in order keeps the clients that end up in the
+    // same bucket in the order they had.
+    vector<list<string>> old;
+    old.swap(buckets);
+
+    foreach (const list<string>& names, old) {
+      foreach (const string& name, names) {
+        Client& client = clients[name];
+        insert(name, &client, bucket(client), false);
+      }
+    }
+
+    dirty = false;
+  }
+
+  list<string> result;
+
+  foreach (const list<string>& names, buckets) {
+    result.insert(result.end(), names.begin(), names.end());
+  }
+
+  return result;
+}
+
+
+bool BucketedDRFSorter::contains(const string& name)
+{
+  return clients.contains(name);
+}
+
+
+int BucketedDRFSorter::count()
+{
+  return clients.size();
+}
+
+
+size_t BucketedDRFSorter::bucket(const Client& client)
+{
+  // The dominant share, see DRFSorter::calculateShare().
+  double share = 0;
+
+  foreachpair (const string& scalar, double total, totalScalars) {
+    if (total > 0) {
+      Scalars::const_iterator it = client.scalars.find(scalar);
+
+      if (it != client.scalars.end()) {
+        share = std::max(share, it->second / total);
+      }
+    }
+  }
+
+  share = std::min(share / client.weight, MAX_SHARE);
+
+  return static_cast<size_t>(share * resolution);
+}
+
+
+void BucketedDRFSorter::place(
+    const string& name,
+    Client* client,
+    bool allocated)
+{
+  if (!client->active) {
+    return;
+  }
+
+  const size_t _bucket = bucket(*client);
+
+  if (_bucket == client->bucket && !allocated) {
+    return;
+  }
+
+  buckets[client->bucket].erase(client->position);
+  client->active = false;
+
+  insert(name, client, _bucket, false);
+}
+
+
+void BucketedDRFSorter::insert(
+    const string& name,
+    Client* client,
+    size_t _bucket,
+    bool front)
+{
+  // NOTE: Growing 'buckets' moves the lists, which leaves the
+  // positions of the clients in them valid.
+  if (_bucket >= buckets.size()) {
+    buckets.resize(_bucket + 1);
+  }
+
+  if (front) {
+    buckets[_bucket].push_front(name);
+    client->position = buckets[_bucket].begin();
+  } else {
+    buckets[_bucket].push_back(name);
+    client->position = --buckets[_bucket].end();
+  }
+
+  client->bucket = _bucket;
+  client->active = true;
+}
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
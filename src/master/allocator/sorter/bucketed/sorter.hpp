@@ -0,0 +1,159 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MASTER_ALLOCATOR_SORTER_BUCKETED_SORTER_HPP__
+#define __MASTER_ALLOCATOR_SORTER_BUCKETED_SORTER_HPP__
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <mesos/resources.hpp>
+
+#include <stout/hashmap.hpp>
+
+#include "master/allocator/sorter/sorter.hpp"
+
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+// An approximation of the DRFSorter for a large number of clients
+// (e.g., a role with tens of thousands of frameworks). Rather than
+// keeping the clients ordered by their exact (weighted) dominant
+// share, the shares are rounded down to a multiple of 1/'resolution'
+// and the clients are kept in a bucket per rounded share. Within a
+// bucket the clients are ordered by when they were last allocated
+// to, which approximates the DRFSorter ordering clients with the
+// same share by their number of allocations.
+//
+// Moving a client between buckets takes constant time, so updating
+// the share of a client after an allocation is O(1) (rather than
+// O(log n)), and recalculating all shares after the total resources
+// changed is O(n) (rather than O(n log n)). The price is that the
+// clients whose shares differ by less than 1/'resolution' may be
+// sorted in any order.
+class BucketedDRFSorter : public Sorter
+{
+public:
+  explicit BucketedDRFSorter(size_t resolution = 1000);
+
+  virtual ~BucketedDRFSorter() {}
+
+  virtual void add(const std::string& name, double weight = 1);
+
+  virtual void remove(const std::string& name);
+
+  virtual void activate(const std::string& name);
+
+  virtual void deactivate(const std::string& name);
+
+  virtual void allocated(
+      const std::string& name,
+      const SlaveID& slaveId,
+      const Resources& resources);
+
+  virtual void update(
+      const std::string& name,
+      const SlaveID& slaveId,
+      const Resources& oldAllocation,
+      const Resources& newAllocation);
+
+  virtual void unallocated(
+      const std::string& name,
+      const SlaveID& slaveId,
+      const Resources& resources);
+
+  virtual hashmap<SlaveID, Resources> allocation(const std::string& name);
+
+  virtual void add(const SlaveID& slaveId, const Resources& resources);
+
+  virtual void remove(const SlaveID& slaveId, const Resources& resources);
+
+  virtual void update(const SlaveID& slaveId, const Resources& resources);
+
+  virtual std::list<std::string> sort();
+
+  virtual bool contains(const std::string& name);
+
+  virtual int count();
+
+private:
+  // Quantities of scalar resources keyed by resource name, see the
+  // DRFSorter.
+  typedef hashmap<std::string, double> Scalars;
+
+  struct Client
+  {
+    double weight;
+
+    // Whether the client is active, i.e., in a bucket.
+    bool active;
+
+    // The bucket of an active client and its position in it.
+    size_t bucket;
+    std::list<std::string>::iterator position;
+
+    hashmap<SlaveID, Resources> allocation;
+
+    // The scalar quantities allocated to the client, i.e., the sum
+    // of 'allocation' for scalar resources.
+    Scalars scalars;
+  };
+
+  // Returns the bucket of the (weighted) dominant share of the client.
+  size_t bucket(const Client& client);
+
+  // Moves an active client to the back of the bucket of its current
+  // share. If 'allocated' is false the client keeps its position if
+  // its bucket did not change.
+  void place(const std::string& name, Client* client, bool allocated);
+
+  // Adds the client to the front or the back of the specified bucket.
+  void insert(
+      const std::string& name,
+      Client* client,
+      size_t bucket,
+      bool front);
+
+  const size_t resolution;
+
+  // If true, sort() will recalculate the buckets of all clients.
+  bool dirty;
+
+  hashmap<std::string, Client> clients;
+
+  // The names of the active clients by the bucket of their share.
+  std::vector<std::list<std::string>> buckets;
+
+  // Total resources.
+  hashmap<SlaveID, Resources> resources;
+
+  // Total scalar quantities, i.e., the sum of 'resources' for scalar
+  // resources.
+  Scalars totalScalars;
+};
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_ALLOCATOR_SORTER_BUCKETED_SORTER_HPP__
@@ -16,6 +16,8 @@
  * limitations under the License.
  */
 
+#include <stout/foreach.hpp>
+
 #include "logging/logging.hpp"
 
 #include "master/allocator/sorter/drf/sorter.hpp"
@@ -30,6 +32,34 @@ namespace internal {
 namespace master {
 namespace allocator {
 
+// Adds the quantities of the scalar resources in 'resources' to
+// 'scalars'.
+static void addScalars(
+    hashmap<string, double>* scalars,
+    const Resources& resources)
+{
+  foreach (const Resource& resource, resources) {
+    if (resource.type() == Value::SCALAR) {
+      (*scalars)[resource.name()] += resource.scalar().value();
+    }
+  }
+}
+
+
+// Subtracts the quantities of the scalar resources in 'resources'
+// from 'scalars'.
+static void subtractScalars(
+    hashmap<string, double>* scalars,
+    const Resources& resources)
+{
+  foreach (const Resource& resource, resources) {
+    if (resource.type() == Value::SCALAR) {
+      (*scalars)[resource.name()] -= resource.scalar().value();
+    }
+  }
+}
+
+
 bool DRFComparator::operator () (const Client& client1, const Client& client2)
 {
   if (client1.share == client2.share) {
@@ -45,9 +75,10 @@ bool DRFComparator::operator () (const Client& client1, const Client& client2)
 void DRFSorter::add(const string& name, double weight)
 {
   Client client(name, 0, 0);
-  clients.insert(client);
+  insert(client);
 
   allocations[name] = hashmap<SlaveID, Resources>();
+  allocatedScalars[name] = Scalars();
   weights[name] = weight;
 }
 
@@ -57,10 +88,11 @@ void DRFSorter::remove(const string& name)
   set<Client, DRFComparator>::iterator it = find(name);
 
   if (it != clients.end()) {
-    clients.erase(it);
+    erase(it);
   }
 
   allocations.erase(name);
+  allocatedScalars.erase(name);
   weights.erase(name);
 }
 
@@ -70,7 +102,7 @@ void DRFSorter::activate(const string& name)
   CHECK(allocations.contains(name));
 
   Client client(name, calculateShare(name), 0);
-  clients.insert(client);
+  insert(client);
 }
 
 
@@ -83,7 +115,7 @@ void DRFSorter::deactivate(const string& name)
     // because we lose information such as the number of allocations
     // for this client which means the fairness can be gamed by a
     // framework disconnecting and reconnecting.
-    clients.erase(it);
+    erase(it);
   }
 }
 
@@ -103,11 +135,12 @@ void DRFSorter::allocated(
     client.allocations++;
 
     // Remove and reinsert it to update the ordering appropriately.
-    clients.erase(it);
-    clients.insert(client);
+    erase(it);
+    insert(client);
   }
 
   allocations[name][slaveId] += resources;
+  addScalars(&allocatedScalars[name], resources);
 
   // If the total resources have changed, we're going to
   // recalculate all the shares, so don't bother just
@@ -145,8 +178,26 @@ void DRFSorter::update(
 
   allocations[name][slaveId] += newAllocation;
 
-  // Just assume the total has changed, per the TODO above.
-  dirty = true;
+  subtractScalars(&totalScalars, oldAllocation);
+  addScalars(&totalScalars, newAllocation);
+
+  subtractScalars(&allocatedScalars[name], oldAllocation);
+  addScalars(&allocatedScalars[name], newAllocation);
+
+  // The shares of the other clients only change if the scalar
+  // quantities change (which is not the case when, e.g., reserving
+  // resources or creating persistent volumes).
+  Scalars oldScalars;
+  addScalars(&oldScalars, oldAllocation);
+
+  Scalars newScalars;
+  addScalars(&newScalars, newAllocation);
+
+  if (oldScalars != newScalars) {
+    dirty = true;
+  } else if (!dirty) {
+    update(name);
+  }
 }
 
 
@@ -166,6 +217,8 @@ void DRFSorter::unallocated(
     allocations[name].erase(slaveId);
   }
 
+  subtractScalars(&allocatedScalars[name], resources);
+
   if (!dirty) {
     update(name);
   }
@@ -175,6 +228,7 @@ void DRFSorter::unallocated(
 void DRFSorter::add(const SlaveID& slaveId, const Resources& _resources)
 {
   resources[slaveId] += _resources;
+  addScalars(&totalScalars, _resources);
 
   // We have to recalculate all shares when the total resources
   // change, but we put it off until sort is called
@@ -189,6 +243,8 @@ void DRFSorter::remove(const SlaveID& slaveId, const Resources& _resources)
   CHECK(resources.contains(slaveId));
 
   resources[slaveId] -= _resources;
+  subtractScalars(&totalScalars, _resources);
+
   if (resources[slaveId].empty()) {
     resources.erase(slaveId);
   }
@@ -201,6 +257,9 @@ void DRFSorter::update(const SlaveID& slaveId, const Resources& _resources)
 {
   CHECK(resources.contains(slaveId));
 
+  subtractScalars(&totalScalars, resources[slaveId]);
+  addScalars(&totalScalars, _resources);
+
   resources[slaveId] = _resources;
 
   if (resources[slaveId].empty()) {
@@ -226,7 +285,14 @@ list<string> DRFSorter::sort()
       temp.insert(client);
     }
 
-    clients = temp;
+    clients.swap(temp);
+
+    index.clear();
+    for (it = clients.begin(); it != clients.end(); it++) {
+      index[(*it).name] = it;
+    }
+
+    dirty = false;
   }
 
   list<string> result;
@@ -263,8 +329,8 @@ void DRFSorter::update(const string& name)
     client.share = calculateShare(client.name);
 
     // Remove and reinsert it to update the ordering appropriately.
-    clients.erase(it);
-    clients.insert(client);
+    erase(it);
+    insert(client);
   }
 }
 
@@ -277,33 +343,18 @@ double DRFSorter::calculateShare(const string& name)
   // currently does not take into account resources that are not
   // scalars.
 
-  // NOTE: Summation is incorrect for non-scalars, but since we
-  // only care about scalar resources, this is safe.
-  Resources totalResources = Resources::sum(resources);
-  Resources clientAllocation = Resources::sum(allocations[name]);
-
-  // Scalar resources may be spread across multiple 'Resource'
-  // objects. E.g. persistent volumes. So we first collect the names
-  // of the scalar resources, before computing the totals.
-  hashset<string> scalars;
-  foreach (const Resource& resource, totalResources) {
-    if (resource.type() == Value::SCALAR) {
-      scalars.insert(resource.name());
-    }
-  }
-
-  foreach (const string& scalar, scalars) {
-    Option<Value::Scalar> total = totalResources.get<Value::Scalar>(scalar);
+  // NOTE: Scalar resources may be spread across multiple 'Resource'
+  // objects (e.g., persistent volumes) which is why we keep track of
+  // the (summed) quantity per resource name.
+  const Scalars& allocation = allocatedScalars[name];
 
-    if (total.isSome() && total.get().value() > 0) {
-      Option<Value::Scalar> allocation =
-        clientAllocation.get<Value::Scalar>(scalar);
+  foreachpair (const string& scalar, double total, totalScalars) {
+    if (total > 0) {
+      Scalars::const_iterator it = allocation.find(scalar);
 
-      if (allocation.isNone()) {
-        allocation = Value::Scalar();
+      if (it != allocation.end()) {
+        share = std::max(share, it->second / total);
       }
-
-      share = std::max(share, allocation.get().value() / total.get().value());
     }
   }
 
@@ -313,14 +364,24 @@ double DRFSorter::calculateShare(const string& name)
 
 set<Client, DRFComparator>::iterator DRFSorter::find(const string& name)
 {
-  set<Client, DRFComparator>::iterator it;
-  for (it = clients.begin(); it != clients.end(); it++) {
-    if (name == (*it).name) {
-      break;
-    }
+  if (!index.contains(name)) {
+    return clients.end();
   }
 
-  return it;
+  return index[name];
+}
+
+
+void DRFSorter::insert(const Client& client)
+{
+  index[client.name] = clients.insert(client).first;
+}
+
+
+void DRFSorter::erase(set<Client, DRFComparator>::iterator it)
+{
+  index.erase((*it).name);
+  clients.erase(it);
 }
 
 } // namespace allocator {
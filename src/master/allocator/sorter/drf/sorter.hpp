@@ -63,6 +63,8 @@ struct DRFComparator
 class DRFSorter : public Sorter
 {
 public:
+  DRFSorter() : dirty(false) {}
+
   virtual ~DRFSorter() {}
 
   virtual void add(const std::string& name, double weight = 1);
@@ -104,6 +106,11 @@ public:
   virtual int count();
 
 private:
+  // Quantities of scalar resources keyed by resource name. Shares are
+  // computed from these (rather than from 'Resources') so that we
+  // don't have to do any resource vector arithmetic when sorting.
+  typedef hashmap<std::string, double> Scalars;
+
   // Recalculates the share for the client and moves
   // it in 'clients' accordingly.
   void update(const std::string& name);
@@ -115,20 +122,38 @@ private:
   // it exists in this Sorter.
   std::set<Client, DRFComparator>::iterator find(const std::string& name);
 
-  // If true, start() will recalculate all shares.
+  // Inserts the client into 'clients' and indexes it by name.
+  void insert(const Client& client);
+
+  // Removes the client pointed to by 'it' from 'clients'.
+  void erase(std::set<Client, DRFComparator>::iterator it);
+
+  // If true, sort() will recalculate all shares.
   bool dirty;
 
   // A set of Clients (names and shares) sorted by share.
   std::set<Client, DRFComparator> clients;
 
+  // Maps (active) client names to their position in 'clients' so
+  // that we don't have to scan 'clients' to find a client.
+  hashmap<std::string, std::set<Client, DRFComparator>::iterator> index;
+
   // Maps client names to the resources they have been allocated.
   hashmap<std::string, hashmap<SlaveID, Resources>> allocations;
 
+  // Maps client names to the scalar quantities they have been
+  // allocated, i.e., the sum of 'allocations' for scalar resources.
+  hashmap<std::string, Scalars> allocatedScalars;
+
   // Maps client names to the weights that should be applied to their shares.
   hashmap<std::string, double> weights;
 
   // Total resources.
   hashmap<SlaveID, Resources> resources;
+
+  // Total scalar quantities, i.e., the sum of 'resources' for scalar
+  // resources.
+  Scalars totalScalars;
 };
 
 } // namespace allocator {
@@ -33,17 +33,23 @@ const double MIN_CPUS = 0.01;
 const Bytes MIN_MEM = Megabytes(32);
 const Duration SLAVE_PING_TIMEOUT = Seconds(15);
 const uint32_t MAX_SLAVE_PING_TIMEOUTS = 5;
+const Duration SLAVE_PING_BATCH_WINDOW = Milliseconds(100);
 const Duration MIN_SLAVE_REREGISTER_TIMEOUT = Minutes(10);
 const double RECOVERY_SLAVE_REMOVAL_PERCENT_LIMIT = 1.0; // 100%.
+const double REGISTRY_DELTAS_COMPACTION_RATIO = 0.5;
+const size_t MAX_REGISTRY_DELTAS = 1000;
 const size_t MAX_REMOVED_SLAVES = 100000;
 const uint32_t MAX_COMPLETED_FRAMEWORKS = 50;
 const uint32_t MAX_COMPLETED_TASKS_PER_FRAMEWORK = 1000;
 const Duration WHITELIST_WATCH_INTERVAL = Seconds(5);
 const uint32_t TASK_LIMIT = 100;
+const size_t MESSAGE_LATENCY_SAMPLING = 16;
+const size_t MAX_RECONCILIATION_BATCH_SIZE = 1000;
 const std::string MASTER_INFO_LABEL = "info";
 const Duration ZOOKEEPER_SESSION_TIMEOUT = Seconds(10);
 const std::string DEFAULT_AUTHENTICATOR = "crammd5";
 const std::string DEFAULT_ALLOCATOR = "HierarchicalDRF";
+const std::string BUCKETED_DRF_ALLOCATOR = "HierarchicalBucketedDRF";
 
 } // namespace master {
 } // namespace internal {
@@ -65,6 +65,10 @@ extern const Duration SLAVE_PING_TIMEOUT;
 // Maximum number of ping timeouts until slave is considered failed.
 extern const uint32_t MAX_SLAVE_PING_TIMEOUTS;
 
+// Slaves whose pings are due within this window of each other get
+// pinged together (i.e., a ping may be sent up to this much early).
+extern const Duration SLAVE_PING_BATCH_WINDOW;
+
 // The minimum timeout that can be used by a newly elected leader to
 // allow re-registration of slaves. Any slaves that do not re-register
 // within this timeout will be shutdown.
@@ -81,6 +85,13 @@ extern const Duration MIN_SLAVE_REREGISTER_TIMEOUT;
 // production use-cases.
 extern const double RECOVERY_SLAVE_REMOVAL_PERCENT_LIMIT;
 
+// When the Registrar stores deltas of the registry, the whole registry
+// gets stored (and the deltas expunged) once the size of the stored
+// deltas exceeds this fraction of the size of the registry, or once
+// there are more than MAX_REGISTRY_DELTAS deltas.
+extern const double REGISTRY_DELTAS_COMPACTION_RATIO;
+extern const size_t MAX_REGISTRY_DELTAS;
+
 // Maximum number of removed slaves to store in the cache.
 extern const size_t MAX_REMOVED_SLAVES;
 
@@ -98,6 +109,14 @@ extern const Duration WHITELIST_WATCH_INTERVAL;
 // Default number of tasks (limit) for /master/tasks.json endpoint.
 extern const uint32_t TASK_LIMIT;
 
+// The latencies of handling one in this many messages of each type
+// are recorded (see 'ProtobufProcess::instrument').
+extern const size_t MESSAGE_LATENCY_SAMPLING;
+
+// Maximum number of status updates sent in one message to a framework
+// with the BATCHED_RECONCILIATION capability during reconciliation.
+extern const size_t MAX_RECONCILIATION_BATCH_SIZE;
+
 // Label used by the Leader Contender and Detector.
 extern const std::string MASTER_INFO_LABEL;
 
@@ -111,6 +130,10 @@ extern const std::string DEFAULT_AUTHENTICATOR;
 // Name of the default, HierarchicalDRF authenticator.
 extern const std::string DEFAULT_ALLOCATOR;
 
+// Name of the built-in allocator that sorts the frameworks within a
+// role by their approximate share, see BucketedDRFSorter.
+extern const std::string BUCKETED_DRF_ALLOCATOR;
+
 } // namespace master {
 } // namespace internal {
 } // namespace mesos {
@@ -17,6 +17,8 @@
  * limitations under the License.
  */
 
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 
@@ -30,7 +32,9 @@
 
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
+#include <stout/stringify.hpp>
 
 #include "common/protobuf_utils.hpp"
 
@@ -196,7 +200,9 @@ private:
 };
 
 
-Try<MasterDetector*> MasterDetector::create(const string& mechanism)
+Try<MasterDetector*> MasterDetector::create(
+    const string& mechanism,
+    bool shared)
 {
   if (mechanism == "") {
     return new StandaloneMasterDetector();
@@ -209,7 +215,7 @@ Try<MasterDetector*> MasterDetector::create(const string& mechanism)
       return Error(
           "Expecting a (chroot) path for ZooKeeper ('/' is not supported)");
     }
-    return new ZooKeeperMasterDetector(url.get());
+    return new ZooKeeperMasterDetector(url.get(), shared);
   } else if (strings::startsWith(mechanism, "file://")) {
     // Load the configuration out of a file. While Mesos and related
     // programs always use <stout/flags> to process the command line
@@ -234,7 +240,7 @@ Try<MasterDetector*> MasterDetector::create(const string& mechanism)
       return Error("Failed to read from file at '" + path + "'");
     }
 
-    return create(strings::trim(read.get()));
+    return create(strings::trim(read.get()), shared);
   }
 
   CHECK(!strings::startsWith(mechanism, "file://"));
@@ -456,32 +462,70 @@ void ZooKeeperMasterDetectorProcess::fetched(
 }
 
 
-ZooKeeperMasterDetector::ZooKeeperMasterDetector(const zookeeper::URL& url)
+// Spawns the specified process and returns a pointer which
+// terminates and deletes the process once the last reference is gone.
+static std::shared_ptr<ZooKeeperMasterDetectorProcess> start(
+    ZooKeeperMasterDetectorProcess* process)
 {
-  process = new ZooKeeperMasterDetectorProcess(url);
-  spawn(process);
+  process::spawn(process);
+
+  return std::shared_ptr<ZooKeeperMasterDetectorProcess>(
+      process,
+      [](ZooKeeperMasterDetectorProcess* process) {
+        terminate(process);
+        process::wait(process);
+        delete process;
+      });
 }
 
 
-ZooKeeperMasterDetector::ZooKeeperMasterDetector(Owned<Group> group)
+ZooKeeperMasterDetector::ZooKeeperMasterDetector(
+    const zookeeper::URL& url,
+    bool shared)
 {
-  process = new ZooKeeperMasterDetectorProcess(group);
-  spawn(process);
+  if (!shared) {
+    process = start(new ZooKeeperMasterDetectorProcess(url));
+    return;
+  }
+
+  // The processes of the shared detectors, keyed by URL. A process
+  // is not kept alive by this map, i.e., it goes away with the last
+  // detector using it.
+  static std::mutex mutex;
+  static hashmap<string, std::weak_ptr<ZooKeeperMasterDetectorProcess>>
+    processes;
+
+  const string key = stringify(url);
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if (processes.contains(key)) {
+    process = processes[key].lock();
+  }
+
+  if (!process) {
+    VLOG(1) << "Creating a shared ZooKeeper master detector for " << url;
+
+    process = start(new ZooKeeperMasterDetectorProcess(url));
+    processes[key] = process;
+  }
 }
 
 
-ZooKeeperMasterDetector::~ZooKeeperMasterDetector()
+ZooKeeperMasterDetector::ZooKeeperMasterDetector(Owned<Group> group)
 {
-  terminate(process);
-  process::wait(process);
-  delete process;
+  process = start(new ZooKeeperMasterDetectorProcess(group));
 }
 
 
+ZooKeeperMasterDetector::~ZooKeeperMasterDetector() {}
+
+
 Future<Option<MasterInfo> > ZooKeeperMasterDetector::detect(
     const Option<MasterInfo>& previous)
 {
-  return dispatch(process, &ZooKeeperMasterDetectorProcess::detect, previous);
+  return dispatch(
+      process.get(), &ZooKeeperMasterDetectorProcess::detect, previous);
 }
 
 } // namespace internal {
@@ -19,6 +19,7 @@
 #ifndef __MASTER_DETECTOR_HPP__
 #define __MASTER_DETECTOR_HPP__
 
+#include <memory>
 #include <string>
 
 #include <process/future.hpp>
@@ -55,7 +56,12 @@ public:
   //   - host:port
   //   - zk://host1:port1,host2:port2,.../path
   //   - zk://username:password@host1:port1,host2:port2,.../path
-  static Try<MasterDetector*> create(const std::string& mechanism);
+  // If 'shared' is true, ZooKeeper based detectors created for the
+  // same URL within this process share a single ZooKeeper session
+  // (see ZooKeeperMasterDetector).
+  static Try<MasterDetector*> create(
+      const std::string& mechanism,
+      bool shared = false);
   virtual ~MasterDetector() = 0;
 
   // Returns MasterInfo after an election has occurred and the elected
@@ -110,9 +116,18 @@ class ZooKeeperMasterDetector : public MasterDetector
 {
 public:
   // Creates a detector which uses ZooKeeper to determine (i.e.,
-  // elect) a leading master.
-  explicit ZooKeeperMasterDetector(const zookeeper::URL& url);
-  // Used for testing purposes.
+  // elect) a leading master. If 'shared' is true, the detector
+  // subscribes to the leading master through a process which is
+  // shared by all the shared detectors for the same URL (within this
+  // OS process), so that they use a single ZooKeeper session and
+  // fetch the leading master's MasterInfo only once per election,
+  // instead of once per detector.
+  explicit ZooKeeperMasterDetector(
+      const zookeeper::URL& url,
+      bool shared = false);
+  // Creates a detector which uses the specified group, e.g., a group
+  // shared with the master's contender (and thus its ZooKeeper
+  // session).
   explicit ZooKeeperMasterDetector(process::Owned<zookeeper::Group> group);
   virtual ~ZooKeeperMasterDetector();
 
@@ -124,7 +139,7 @@ public:
       const Option<MasterInfo>& previous = None());
 
 private:
-  ZooKeeperMasterDetectorProcess* process;
+  std::shared_ptr<ZooKeeperMasterDetectorProcess> process;
 };
 
 } // namespace internal {
@@ -0,0 +1,694 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <stout/check.hpp>
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "master/event_history.hpp"
+
+using std::list;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// The prefix of the names of the files of a history.
+static const string PREFIX = "events.";
+
+// The number of files the capacity of a history is split into.
+static const uint64_t FILES = 8;
+
+
+// A file of the history, which gets removed when the last reference
+// to it goes away (i.e., once it has been retired from the history
+// and no cursor needs it anymore).
+struct EventHistory::File
+{
+  File(const string& _path, int _fd) : path(_path), fd(_fd), size(0) {}
+
+  ~File()
+  {
+    os::close(fd);
+
+    Try<Nothing> rm = os::rm(path);
+    if (rm.isError()) {
+      LOG(WARNING) << "Failed to remove event history file '" << path
+                   << "': " << rm.error();
+    }
+  }
+
+  const string path;
+  const int fd;
+  uint64_t size;
+};
+
+
+namespace {
+
+void encode(uint64_t value, string* data)
+{
+  while (value >= 0x80) {
+    data->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  data->push_back(static_cast<char>(value));
+}
+
+
+// Maps signed values of small magnitude to small unsigned values
+// so that they make for short varints.
+uint64_t zigzag(int64_t value)
+{
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+
+int64_t unzigzag(uint64_t value)
+{
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+
+// Appends a column, prefixed with its length.
+void column(const string& column, string* data)
+{
+  encode(column.size(), data);
+  data->append(column);
+}
+
+
+// Dictionary-encodes the given values.
+string dictionary(const vector<string>& values)
+{
+  hashmap<string, uint64_t> indices;
+  vector<const string*> entries;
+  string indexes;
+
+  foreach (const string& value, values) {
+    if (!indices.contains(value)) {
+      indices[value] = entries.size();
+      entries.push_back(&value);
+    }
+    encode(indices[value], &indexes);
+  }
+
+  string data;
+  encode(entries.size(), &data);
+  foreach (const string* entry, entries) {
+    encode(entry->size(), &data);
+    data.append(*entry);
+  }
+  data.append(indexes);
+
+  return data;
+}
+
+
+// Reads from a block, failing once the data is exhausted or found
+// to be malformed.
+class Decoder
+{
+public:
+  Decoder(const char* _data, size_t _size)
+    : data(_data), size(_size), offset(0) {}
+
+  Try<uint64_t> varint()
+  {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (offset >= size) {
+        return Error("Truncated varint");
+      }
+
+      uint8_t byte = static_cast<uint8_t>(data[offset++]);
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+
+    return Error("Malformed varint");
+  }
+
+  Try<string> bytes(uint64_t length)
+  {
+    if (length > size - offset) {
+      return Error("Truncated data");
+    }
+
+    string bytes(data + offset, length);
+    offset += length;
+    return bytes;
+  }
+
+  // Returns a decoder for the next column.
+  Try<Decoder> column()
+  {
+    Try<uint64_t> length = varint();
+    if (length.isError()) {
+      return Error(length.error());
+    } else if (length.get() > size - offset) {
+      return Error("Truncated column");
+    }
+
+    Decoder column(data + offset, length.get());
+    offset += length.get();
+    return column;
+  }
+
+  Try<string> string_()
+  {
+    Try<uint64_t> length = varint();
+    if (length.isError()) {
+      return Error(length.error());
+    }
+
+    return bytes(length.get());
+  }
+
+  Try<vector<string>> dictionary(size_t count)
+  {
+    Try<uint64_t> entries = varint();
+    if (entries.isError()) {
+      return Error(entries.error());
+    } else if (entries.get() > size - offset) {
+      return Error("Malformed dictionary");
+    }
+
+    vector<string> dictionary;
+    for (uint64_t i = 0; i < entries.get(); i++) {
+      Try<string> entry = string_();
+      if (entry.isError()) {
+        return Error(entry.error());
+      }
+      dictionary.push_back(entry.get());
+    }
+
+    vector<string> values;
+    for (size_t i = 0; i < count; i++) {
+      Try<uint64_t> index = varint();
+      if (index.isError()) {
+        return Error(index.error());
+      } else if (index.get() >= dictionary.size()) {
+        return Error("Malformed dictionary index");
+      }
+      values.push_back(dictionary[index.get()]);
+    }
+
+    return values;
+  }
+
+private:
+  const char* data;
+  size_t size;
+  size_t offset;
+};
+
+
+Try<string> read(const EventHistory::Block& block)
+{
+  string data(block.length, '\0');
+
+  size_t offset = 0;
+  while (offset < data.size()) {
+    ssize_t length = ::pread(
+        block.file->fd,
+        &data[offset],
+        data.size() - offset,
+        block.offset + offset);
+
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return ErrnoError("Failed to read from '" + block.file->path + "'");
+    } else if (length == 0) {
+      return Error("Failed to read from '" + block.file->path + "': EOF");
+    }
+
+    offset += length;
+  }
+
+  return data;
+}
+
+} // namespace {
+
+
+const size_t EventHistory::EVENTS_PER_BLOCK;
+
+
+Try<shared_ptr<EventHistory>> EventHistory::create(
+    const string& directory,
+    const Bytes& capacity)
+{
+  Try<Nothing> mkdir = os::mkdir(directory);
+  if (mkdir.isError()) {
+    return Error(
+        "Failed to create directory '" + directory + "': " + mkdir.error());
+  }
+
+  Try<list<string>> entries = os::ls(directory);
+  if (entries.isError()) {
+    return Error(
+        "Failed to list directory '" + directory + "': " + entries.error());
+  }
+
+  // Remove the files left behind by a previous master.
+  foreach (const string& entry, entries.get()) {
+    if (strings::startsWith(entry, PREFIX)) {
+      Try<Nothing> rm = os::rm(path::join(directory, entry));
+      if (rm.isError()) {
+        return Error(
+            "Failed to remove '" + path::join(directory, entry) + "': " +
+            rm.error());
+      }
+    }
+  }
+
+  return shared_ptr<EventHistory>(new EventHistory(directory, capacity));
+}
+
+
+EventHistory::EventHistory(const string& _directory, const Bytes& _capacity)
+  : directory(_directory),
+    capacity(_capacity),
+    started(0) {}
+
+
+EventHistory::~EventHistory()
+{
+  Try<Nothing> flush = this->flush();
+  if (flush.isError()) {
+    LOG(WARNING) << "Failed to write out the event history: " << flush.error();
+  }
+}
+
+
+void EventHistory::append(const Event& event)
+{
+  buffered.push_back(event);
+
+  if (buffered.size() >= EVENTS_PER_BLOCK) {
+    Try<Nothing> flush = this->flush();
+    if (flush.isError()) {
+      LOG(WARNING) << "Dropping " << EVENTS_PER_BLOCK << " events of the "
+                   << "event history: " << flush.error();
+    }
+  }
+}
+
+
+Try<Nothing> EventHistory::flush()
+{
+  if (buffered.empty()) {
+    return Nothing();
+  }
+
+  Block block;
+  block.first = buffered.front().timestamp;
+  block.last = buffered.back().timestamp;
+
+  const string data = encode(buffered);
+  buffered.clear();
+
+  if (files.empty() || files.back()->size >= capacity.bytes() / FILES) {
+    const string path = path::join(directory, PREFIX + stringify(started++));
+
+    Try<int> fd = os::open(
+        path,
+        O_CREAT | O_TRUNC | O_RDWR | O_APPEND | O_CLOEXEC,
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+    if (fd.isError()) {
+      return Error("Failed to open '" + path + "': " + fd.error());
+    }
+
+    files.push_back(shared_ptr<File>(new File(path, fd.get())));
+  }
+
+  shared_ptr<File> file = files.back();
+
+  Try<Nothing> write = os::write(file->fd, data);
+  if (write.isError()) {
+    // The size of the file is unknown after a partial write, so
+    // the next block gets written to a new file.
+    files.pop_back();
+    while (!blocks.empty() && blocks.back().file == file) {
+      blocks.pop_back();
+    }
+    size -= Bytes(file->size);
+
+    return Error("Failed to write to '" + file->path + "': " + write.error());
+  }
+
+  block.file = file;
+  block.offset = file->size;
+  block.length = data.size();
+  blocks.push_back(block);
+
+  file->size += data.size();
+  size += Bytes(data.size());
+
+  // Retire the oldest files until the history fits its capacity.
+  while (size > capacity && files.size() > 1) {
+    shared_ptr<File> oldest = files.front();
+    files.pop_front();
+
+    while (!blocks.empty() && blocks.front().file == oldest) {
+      blocks.pop_front();
+    }
+
+    size -= Bytes(oldest->size);
+  }
+
+  return Nothing();
+}
+
+
+shared_ptr<EventHistory::Cursor> EventHistory::events(
+    int64_t from,
+    int64_t to) const
+{
+  shared_ptr<Cursor> cursor(new Cursor(from, to));
+
+  // NOTE: The timestamps only grow (modulo adjustments of the system
+  // clock), so blocks entirely outside of the range can be skipped
+  // without reading them.
+  foreach (const Block& block, blocks) {
+    if (block.last >= from && block.first <= to) {
+      cursor->blocks.push_back(block);
+    }
+  }
+
+  foreach (const Event& event, buffered) {
+    if (event.timestamp >= from && event.timestamp <= to) {
+      cursor->buffered.push_back(event);
+    }
+  }
+
+  return cursor;
+}
+
+
+string EventHistory::encode(const vector<Event>& events)
+{
+  string types;
+  string timestamps;
+  vector<string> frameworkIds;
+  vector<string> slaveIds;
+  string ids;
+  string cpus;
+  string mem;
+  string states;
+
+  int64_t previous = events.empty() ? 0 : events.front().timestamp;
+
+  foreach (const Event& event, events) {
+    types.push_back(static_cast<char>(event.type));
+
+    mesos::internal::master::encode(
+        zigzag(event.timestamp - previous), &timestamps);
+    previous = event.timestamp;
+
+    frameworkIds.push_back(event.frameworkId);
+    slaveIds.push_back(event.slaveId);
+
+    mesos::internal::master::encode(event.id.size(), &ids);
+    ids.append(event.id);
+
+    // CPUs are kept with a precision of a thousandth of a CPU, and
+    // memory with a precision of a megabyte.
+    mesos::internal::master::encode(
+        static_cast<uint64_t>(std::llround(std::max(event.cpus, 0.0) * 1000)),
+        &cpus);
+    mesos::internal::master::encode(
+        static_cast<uint64_t>(std::llround(std::max(event.mem, 0.0))),
+        &mem);
+
+    states.push_back(static_cast<char>(event.state));
+  }
+
+  string data;
+  mesos::internal::master::encode(events.size(), &data);
+  mesos::internal::master::encode(
+      zigzag(events.empty() ? 0 : events.front().timestamp), &data);
+
+  column(types, &data);
+  column(timestamps, &data);
+  column(dictionary(frameworkIds), &data);
+  column(dictionary(slaveIds), &data);
+  column(ids, &data);
+  column(cpus, &data);
+  column(mem, &data);
+  column(states, &data);
+
+  return data;
+}
+
+
+Try<vector<EventHistory::Event>> EventHistory::decode(const string& data)
+{
+  Decoder decoder(data.data(), data.size());
+
+  Try<uint64_t> count = decoder.varint();
+  if (count.isError()) {
+    return Error("Failed to decode block: " + count.error());
+  } else if (count.get() > data.size()) {
+    return Error("Failed to decode block: Malformed count");
+  }
+
+  Try<uint64_t> first = decoder.varint();
+  if (first.isError()) {
+    return Error("Failed to decode block: " + first.error());
+  }
+
+  vector<Event> events(count.get());
+
+  // Decodes a column of varints into the events.
+  auto varints = [&events, &decoder](
+      const std::function<void(Event*, uint64_t)>& set) -> Try<Nothing> {
+    Try<Decoder> column = decoder.column();
+    if (column.isError()) {
+      return Error(column.error());
+    }
+
+    Decoder reader = column.get();
+
+    foreach (Event& event, events) {
+      Try<uint64_t> value = reader.varint();
+      if (value.isError()) {
+        return Error(value.error());
+      }
+      set(&event, value.get());
+    }
+
+    return Nothing();
+  };
+
+  // Decodes a column of bytes into the events.
+  auto bytes = [&events, &decoder](
+      const std::function<void(Event*, uint8_t)>& set) -> Try<Nothing> {
+    Try<Decoder> column = decoder.column();
+    if (column.isError()) {
+      return Error(column.error());
+    }
+
+    Decoder reader = column.get();
+
+    Try<string> bytes = reader.bytes(events.size());
+    if (bytes.isError()) {
+      return Error(bytes.error());
+    }
+
+    for (size_t i = 0; i < events.size(); i++) {
+      set(&events[i], static_cast<uint8_t>(bytes.get()[i]));
+    }
+
+    return Nothing();
+  };
+
+  // Decodes a dictionary-encoded column of strings into the events.
+  auto strings = [&events, &decoder](
+      const std::function<void(Event*, const string&)>& set) -> Try<Nothing> {
+    Try<Decoder> column = decoder.column();
+    if (column.isError()) {
+      return Error(column.error());
+    }
+
+    Decoder reader = column.get();
+
+    Try<vector<string>> values = reader.dictionary(events.size());
+    if (values.isError()) {
+      return Error(values.error());
+    }
+
+    for (size_t i = 0; i < events.size(); i++) {
+      set(&events[i], values.get()[i]);
+    }
+
+    return Nothing();
+  };
+
+  // Decodes a column of strings into the events. The IDs are not
+  // dictionary-encoded as they tend to be unique.
+  auto ids = [&events, &decoder]() -> Try<Nothing> {
+    Try<Decoder> column = decoder.column();
+    if (column.isError()) {
+      return Error(column.error());
+    }
+
+    Decoder reader = column.get();
+
+    foreach (Event& event, events) {
+      Try<string> id = reader.string_();
+      if (id.isError()) {
+        return Error(id.error());
+      }
+      event.id = id.get();
+    }
+
+    return Nothing();
+  };
+
+  int64_t timestamp = unzigzag(first.get());
+
+  // The columns, in the order in which they are encoded.
+  vector<std::function<Try<Nothing>()>> columns;
+
+  columns.push_back([&bytes]() {
+    return bytes([](Event* event, uint8_t type) {
+      event->type = static_cast<Type>(type);
+    });
+  });
+
+  columns.push_back([&varints, &timestamp]() {
+    return varints([&timestamp](Event* event, uint64_t delta) {
+      timestamp += unzigzag(delta);
+      event->timestamp = timestamp;
+    });
+  });
+
+  columns.push_back([&strings]() {
+    return strings([](Event* event, const string& frameworkId) {
+      event->frameworkId = frameworkId;
+    });
+  });
+
+  columns.push_back([&strings]() {
+    return strings([](Event* event, const string& slaveId) {
+      event->slaveId = slaveId;
+    });
+  });
+
+  columns.push_back(ids);
+
+  columns.push_back([&varints]() {
+    return varints([](Event* event, uint64_t cpus) {
+      event->cpus = cpus / 1000.0;
+    });
+  });
+
+  columns.push_back([&varints]() {
+    return varints([](Event* event, uint64_t mem) {
+      event->mem = static_cast<double>(mem);
+    });
+  });
+
+  columns.push_back([&bytes]() {
+    return bytes([](Event* event, uint8_t state) {
+      event->state = state;
+    });
+  });
+
+  foreach (const std::function<Try<Nothing>()>& column, columns) {
+    Try<Nothing> decoded = column();
+    if (decoded.isError()) {
+      return Error("Failed to decode block: " + decoded.error());
+    }
+  }
+
+  return events;
+}
+
+
+Try<Option<vector<EventHistory::Event>>> EventHistory::Cursor::next()
+{
+  while (!blocks.empty()) {
+    Block block = blocks.front();
+    blocks.pop_front();
+
+    Try<string> data = read(block);
+    if (data.isError()) {
+      return Error(data.error());
+    }
+
+    Try<vector<Event>> decoded = decode(data.get());
+    if (decoded.isError()) {
+      return Error(decoded.error());
+    }
+
+    vector<Event> events;
+    foreach (const Event& event, decoded.get()) {
+      if (event.timestamp >= from && event.timestamp <= to) {
+        events.push_back(event);
+      }
+    }
+
+    if (!events.empty()) {
+      return events;
+    }
+  }
+
+  if (!buffered.empty()) {
+    vector<Event> events;
+    events.swap(buffered);
+    return events;
+  }
+
+  return None();
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
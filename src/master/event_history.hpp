@@ -0,0 +1,165 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MASTER_EVENT_HISTORY_HPP__
+#define __MASTER_EVENT_HISTORY_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stout/bytes.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// A history of the allocation decisions of the master (the offers it
+// makes and what becomes of them) and of the tasks it launches, kept
+// on disk for post-hoc analysis of the utilization of the cluster.
+//
+// The events are buffered in memory and written out in blocks of up
+// to 'EVENTS_PER_BLOCK' events. A block is stored column by column,
+// i.e., all the types of its events, followed by all the timestamps,
+// etc, with the timestamps delta-encoded, the framework and slave IDs
+// dictionary-encoded and the numbers written as varints. This keeps
+// the history compact as consecutive events tend to be close in time
+// and to refer to the same frameworks and slaves.
+//
+// The blocks are appended to the current file of the history until
+// it holds an eighth of 'capacity' bytes, after which a new file is
+// started. Once the files hold more than 'capacity' bytes in total
+// the oldest file is removed, i.e., the history is retained by size.
+//
+// NOTE: Like the TaskStore, the history is not meant to survive the
+// master: the files are not synced to disk and any files left behind
+// by a previous master get removed when the history is created.
+class EventHistory
+{
+public:
+  enum Type
+  {
+    OFFER = 1,     // Resources of a slave offered to a framework.
+    RESCIND = 2,   // An offer rescinded by the master.
+    DECLINE = 3,   // An offer declined by the framework.
+    LAUNCH = 4,    // A task launched using offered resources.
+    TERMINAL = 5,  // A task that transitioned to a terminal state.
+  };
+
+  struct Event
+  {
+    Event()
+      : type(OFFER), timestamp(0), cpus(0.0), mem(0.0), state(0) {}
+
+    Type type;
+    int64_t timestamp; // In microseconds since the epoch.
+    std::string frameworkId;
+    std::string slaveId;
+    std::string id; // The ID of the offer or of the task.
+    double cpus;
+    double mem; // In megabytes.
+    int state; // The TaskState of a TERMINAL event, otherwise 0.
+  };
+
+  struct File;
+
+  // The location of a block in the history.
+  struct Block
+  {
+    std::shared_ptr<File> file;
+    uint64_t offset;
+    uint32_t length;
+    int64_t first; // The timestamp of the first event in the block.
+    int64_t last; // The timestamp of the last event in the block.
+  };
+
+  // Iterates over the events in a range of time, a block at a time.
+  // A cursor holds on to the files it still has to read, i.e., it is
+  // not affected by subsequent appends to or removals from the
+  // history and can be used without synchronizing with it.
+  class Cursor
+  {
+  public:
+    // Returns the next (non-empty) batch of events, or none once all
+    // the events in the range have been returned.
+    Try<Option<std::vector<Event>>> next();
+
+  private:
+    friend class EventHistory;
+
+    Cursor(int64_t _from, int64_t _to) : from(_from), to(_to) {}
+
+    const int64_t from;
+    const int64_t to;
+
+    std::deque<Block> blocks;
+    std::vector<Event> buffered; // Events not yet written to disk.
+  };
+
+  static const size_t EVENTS_PER_BLOCK = 4096;
+
+  static Try<std::shared_ptr<EventHistory>> create(
+      const std::string& directory,
+      const Bytes& capacity);
+
+  // Writes out the buffered events.
+  ~EventHistory();
+
+  // Failures to write to disk are logged and the events of the
+  // affected block get dropped, i.e., the history is best effort.
+  void append(const Event& event);
+
+  // Returns a cursor over the events with a timestamp in the
+  // (inclusive) range ['from', 'to'].
+  std::shared_ptr<Cursor> events(int64_t from, int64_t to) const;
+
+  // Encoding and decoding of a block, exposed for testing.
+  static std::string encode(const std::vector<Event>& events);
+  static Try<std::vector<Event>> decode(const std::string& data);
+
+private:
+  EventHistory(const std::string& directory, const Bytes& capacity);
+
+  Try<Nothing> flush();
+
+  EventHistory(const EventHistory&);
+  EventHistory& operator = (const EventHistory&);
+
+  const std::string directory;
+  const Bytes capacity;
+
+  std::deque<std::shared_ptr<File>> files; // Oldest first.
+  std::deque<Block> blocks; // Oldest first.
+  std::vector<Event> buffered;
+
+  Bytes size; // The total size of the files.
+  uint64_t started; // The number of files started so far.
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_EVENT_HISTORY_HPP__
@@ -93,6 +93,17 @@ mesos::internal::master::Flags::Flags()
       "after which the operation is considered a failure.",
       Seconds(5));
 
+  add(&Flags::registry_store_deltas,
+      "registry_store_deltas",
+      "Whether the Registrar stores only the changes to the registry for\n"
+      "an update (as a delta). The whole registry then only gets stored\n"
+      "once the stored deltas add up to a fraction of its size, which\n"
+      "makes updates to large registries cheaper.\n"
+      "NOTE: Masters of versions that do not know about deltas ignore\n"
+      "them. Restart the master without this flag (which stores the\n"
+      "whole registry on the next update) before downgrading.",
+      false);
+
   add(&Flags::log_auto_initialize,
       "log_auto_initialize",
       "Whether to automatically initialize the replicated log used for the\n"
@@ -100,6 +111,34 @@ mesos::internal::master::Flags::Flags()
       "initialized when used for the very first time.",
       true);
 
+  add(&Flags::log_leveldb_block_cache_size,
+      "log_leveldb_block_cache_size",
+      "Size of the cache of uncompressed leveldb blocks read by the\n"
+      "replicated log used for the registry.",
+      Megabytes(8));
+
+  add(&Flags::log_leveldb_write_buffer_size,
+      "log_leveldb_write_buffer_size",
+      "Amount of data the replicated log used for the registry buffers\n"
+      "in memory before leveldb writes it out to a sorted file on disk.\n"
+      "Larger values mean fewer but longer compactions.",
+      Megabytes(4));
+
+  add(&Flags::log_leveldb_bloom_filter_bits_per_key,
+      "log_leveldb_bloom_filter_bits_per_key",
+      "Number of bits per key of the leveldb bloom filters which let\n"
+      "the replicated log used for the registry avoid disk reads of keys\n"
+      "that are not in a file. A value of 10 is a good choice, 0 disables\n"
+      "the filters.",
+      0);
+
+  add(&Flags::log_leveldb_compact_on_restore,
+      "log_leveldb_compact_on_restore",
+      "Whether to compact the leveldb of the replicated log used for the\n"
+      "registry when the master starts. Compacting makes reads faster\n"
+      "but may take a while for large logs.",
+      true);
+
   add(&Flags::slave_reregister_timeout,
       "slave_reregister_timeout",
       "The timeout within which all slaves are expected to re-register\n"
@@ -137,6 +176,16 @@ mesos::internal::master::Flags::Flags()
       "slaves will be removed as soon as they fail the health checks.\n"
       "The value is of the form <Number of slaves>/<Duration>.");
 
+  add(&Flags::slave_registration_rate_limit,
+      "slave_registration_rate_limit",
+      "The maximum rate (e.g., 100/1secs, 1000/1mins, etc) at which slaves\n"
+      "that are not registered with the master are allowed to (re-)register,\n"
+      "e.g., after a master failover. The slaves exceeding the rate are told\n"
+      "when to retry. The rate needs to let all the slaves re-register\n"
+      "within --slave_reregister_timeout after a failover. By default the\n"
+      "(re-)registration of slaves is not rate limited.\n"
+      "The value is of the form <Number of slaves>/<Duration>.");
+
   add(&Flags::webui_dir,
       "webui_dir",
       "Directory path of the webui files/assets",
@@ -200,6 +249,15 @@ mesos::internal::master::Flags::Flags()
       "If 'false' unauthenticated slaves are also allowed to register.",
       false);
 
+  add(&Flags::authentication_tickets,
+      "authentication_tickets",
+      "If 'true' the default '" + DEFAULT_AUTHENTICATOR + "' authenticator\n"
+      "hands out a ticket on a successful authentication, which lets the\n"
+      "next authentication from the same host within 10 minutes skip the\n"
+      "SASL exchange. NOTE: Tickets are sent in the clear, so anybody\n"
+      "who can overhear them and connect from that host can use them.",
+      false);
+
   add(&Flags::credentials,
       "credentials",
       "Either a path to a text file with a list of credentials,\n"
@@ -292,6 +350,57 @@ mesos::internal::master::Flags::Flags()
       "This helps fairness when running frameworks that hold on to offers,\n"
       "or frameworks that accidentally drop offers.");
 
+  add(&Flags::http_snapshot_interval,
+      "http_snapshot_interval",
+      "If set, the read-only HTTP endpoints of the master (/state.json,\n"
+      "/state-summary, /slaves and /tasks.json) are served from a\n"
+      "snapshot of the master that is taken at most once per interval\n"
+      "(e.g., 1secs), i.e., responses may be stale by up to the interval.\n"
+      "This keeps expensive endpoints from delaying the master when they\n"
+      "are polled frequently in large clusters.");
+
+  add(&Flags::max_event_queue_age,
+      "max_event_queue_age",
+      "If set, the master sheds low priority work while the oldest event\n"
+      "in its queue has been waiting for longer than this (e.g., 5secs):\n"
+      "task reconciliation requests are dropped (frameworks retry them)\n"
+      "and /state.json requests not served from a snapshot (see\n"
+      "--http_snapshot_interval) get a '503 Service Unavailable'.");
+
+  add(&Flags::completed_tasks_dir,
+      "completed_tasks_dir",
+      "If set, the completed tasks of the frameworks are kept in files in\n"
+      "this directory and only a summary of each completed task is kept\n"
+      "in memory, i.e., the memory used by the master does not depend on\n"
+      "the size of the completed tasks. The tasks are read back when\n"
+      "/state.json or /tasks.json is requested. The files do not survive\n"
+      "the master, i.e., any files left in the directory by a previous\n"
+      "master are removed.");
+
+  add(&Flags::event_history_dir,
+      "event_history_dir",
+      "If set, the master keeps a history of the offers it makes, of\n"
+      "the offers that get declined or rescinded, and of the tasks that\n"
+      "get launched and that terminate in compact files in this\n"
+      "directory. The history can be read back through the\n"
+      "/master/events endpoint. The files do not survive the master,\n"
+      "i.e., any files left in the directory by a previous master are\n"
+      "removed.");
+
+  add(&Flags::event_history_capacity,
+      "event_history_capacity",
+      "Amount of disk space used for the history of events (see\n"
+      "--event_history_dir) after which the oldest events are removed.",
+      Megabytes(256));
+
+  add(&Flags::trace_sampling_rate,
+      "trace_sampling_rate",
+      "Fraction of the task launches that are traced through the master\n"
+      "and the slave, from the framework accepting the offer until the\n"
+      "task is running. The spans of the most recent traces can be read\n"
+      "from the /trace endpoints of the master and the slaves.",
+      0.0);
+
   // This help message for --modules flag is the same for
   // {master,slave,tests}/flags.hpp and should always be kept in
   // sync.
@@ -349,8 +458,11 @@ mesos::internal::master::Flags::Flags()
   add(&Flags::allocator,
       "allocator",
       "Allocator to use for resource allocation to frameworks.\n"
-      "Use the default '" + DEFAULT_ALLOCATOR + "' allocator, or\n"
-      "load an alternate allocator module using --modules.",
+      "Use the default '" + DEFAULT_ALLOCATOR + "' allocator, the\n"
+      "'" + BUCKETED_DRF_ALLOCATOR + "' allocator (which approximates\n"
+      "the shares of the frameworks within a role to scale to roles with\n"
+      "many frameworks), or load an alternate allocator module using\n"
+      "--modules.",
       DEFAULT_ALLOCATOR);
 
   add(&Flags::hooks,
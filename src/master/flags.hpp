@@ -21,6 +21,7 @@
 
 #include <string>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/option.hpp>
 #include <stout/path.hpp>
@@ -48,10 +49,16 @@ public:
   bool registry_strict;
   Duration registry_fetch_timeout;
   Duration registry_store_timeout;
+  bool registry_store_deltas;
   bool log_auto_initialize;
+  Bytes log_leveldb_block_cache_size;
+  Bytes log_leveldb_write_buffer_size;
+  int log_leveldb_bloom_filter_bits_per_key;
+  bool log_leveldb_compact_on_restore;
   Duration slave_reregister_timeout;
   std::string recovery_slave_removal_limit;
   Option<std::string> slave_removal_rate_limit;
+  Option<std::string> slave_registration_rate_limit;
   std::string webui_dir;
   Option<Path> whitelist;
   std::string user_sorter;
@@ -62,10 +69,17 @@ public:
   Option<std::string> weights;
   bool authenticate_frameworks;
   bool authenticate_slaves;
+  bool authentication_tickets;
   Option<Path> credentials;
   Option<ACLs> acls;
   Option<RateLimits> rate_limits;
   Option<Duration> offer_timeout;
+  Option<Duration> http_snapshot_interval;
+  Option<Duration> max_event_queue_age;
+  Option<std::string> completed_tasks_dir;
+  Option<std::string> event_history_dir;
+  Bytes event_history_capacity;
+  double trace_sampling_rate;
   Option<Modules> modules;
   std::string authenticators;
   std::string allocator;
@@ -16,7 +16,10 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <functional>
 #include <iomanip>
+#include <limits>
 #include <map>
 #include <memory>
 #include <sstream>
@@ -28,19 +31,24 @@
 
 #include <mesos/type_utils.hpp>
 
+#include <process/dispatch.hpp>
 #include <process/help.hpp>
+#include <process/http.hpp>
 
 #include <process/metrics/metrics.hpp>
 
 #include <stout/base64.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/json.hpp>
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
 #include <stout/numify.hpp>
 #include <stout/os.hpp>
+#include <stout/protobuf.hpp>
 #include <stout/result.hpp>
 #include <stout/strings.hpp>
+#include <stout/stringify.hpp>
 
 #include "authorizer/authorizer.hpp"
 
@@ -48,10 +56,13 @@
 #include "common/build.hpp"
 #include "common/http.hpp"
 #include "common/protobuf_utils.hpp"
+#include "common/token.hpp"
 
 #include "logging/logging.hpp"
 
 #include "master/master.hpp"
+#include "master/repairer.hpp"
+#include "master/snapshot.hpp"
 
 #include "mesos/mesos.hpp"
 #include "mesos/resources.hpp"
@@ -63,10 +74,14 @@ using process::HELP;
 using process::TLDR;
 using process::USAGE;
 
+using process::http::Accepted;
 using process::http::BadRequest;
+using process::http::Forbidden;
 using process::http::InternalServerError;
 using process::http::NotFound;
 using process::http::OK;
+using process::http::Pipe;
+using process::http::ServiceUnavailable;
 using process::http::TemporaryRedirect;
 using process::http::Unauthorized;
 
@@ -81,7 +96,8 @@ namespace mesos {
 namespace internal {
 namespace master {
 
-// Pull in model overrides from common.
+// Pull in model (and json) overrides from common.
+using mesos::internal::json;
 using mesos::internal::model;
 
 // Pull in definitions from process.
@@ -112,6 +128,7 @@ JSON::Object summarize(const Framework& framework)
   JSON::Object object;
   object.values["id"] = framework.id().value();
   object.values["name"] = framework.info.name();
+  object.values["user"] = framework.info.user();
   object.values["pid"] = string(framework.pid);
 
   // TODO(bmahler): Use these in the webui.
@@ -131,7 +148,6 @@ JSON::Object model(const Framework& framework)
   // Add additional fields to those generated by 'summarize'.
   JSON::Object object = summarize(framework);
 
-  object.values["user"] = framework.info.user();
   object.values["failover_timeout"] = framework.info.failover_timeout();
   object.values["checkpoint"] = framework.info.checkpoint();
   object.values["role"] = framework.info.role();
@@ -173,8 +189,16 @@ JSON::Object model(const Framework& framework)
     JSON::Array array;
     array.values.reserve(framework.completedTasks.size()); // MESOS-2353.
 
-    foreach (const std::shared_ptr<Task>& task, framework.completedTasks) {
-      array.values.push_back(model(*task));
+    foreach (const std::shared_ptr<CompletedTask>& completed,
+             framework.completedTasks) {
+      Try<std::shared_ptr<const Task>> task = completed->get();
+      if (task.isError()) {
+        LOG(WARNING) << "Failed to get completed task "
+                     << completed->task_id() << ": " << task.error();
+        continue;
+      }
+
+      array.values.push_back(model(*task.get()));
     }
 
     object.values["completed_tasks"] = std::move(array);
@@ -196,6 +220,76 @@ JSON::Object model(const Framework& framework)
 }
 
 
+// Writes the same JSON as 'model(framework)' directly into the writer.
+static void json(JSON::Writer* writer, const Framework& framework)
+{
+  writer->startObject();
+  writer->field("id", framework.id().value());
+  writer->field("name", framework.info.name());
+  writer->field("pid", string(framework.pid));
+  writer->field("used_resources", model(framework.totalUsedResources));
+  writer->field("offered_resources", model(framework.totalOfferedResources));
+  writer->field("hostname", framework.info.hostname());
+  writer->field("webui_url", framework.info.webui_url());
+  writer->field("user", framework.info.user());
+  writer->field("failover_timeout", framework.info.failover_timeout());
+  writer->field("checkpoint", framework.info.checkpoint());
+  writer->field("role", framework.info.role());
+  writer->field("registered_time", framework.registeredTime.secs());
+  writer->field("unregistered_time", framework.unregisteredTime.secs());
+  writer->field("active", framework.active);
+  writer->field(
+      "resources",
+      model(framework.totalUsedResources + framework.totalOfferedResources));
+
+  if (framework.registeredTime != framework.reregisteredTime) {
+    writer->field("reregistered_time", framework.reregisteredTime.secs());
+  }
+
+  writer->key("tasks");
+  writer->startArray();
+
+  foreachvalue (const TaskInfo& task, framework.pendingTasks) {
+    vector<TaskStatus> statuses;
+    json(writer, task, framework.id(), TASK_STAGING, statuses);
+  }
+
+  foreachvalue (Task* task, framework.tasks) {
+    json(writer, *task);
+  }
+
+  writer->endArray();
+
+  writer->key("completed_tasks");
+  writer->startArray();
+
+  foreach (const std::shared_ptr<CompletedTask>& completed,
+           framework.completedTasks) {
+    Try<std::shared_ptr<const Task>> task = completed->get();
+    if (task.isError()) {
+      LOG(WARNING) << "Failed to get completed task "
+                   << completed->task_id() << ": " << task.error();
+      continue;
+    }
+
+    json(writer, *task.get());
+  }
+
+  writer->endArray();
+
+  writer->key("offers");
+  writer->startArray();
+
+  foreach (Offer* offer, framework.offers) {
+    writer->value(model(*offer));
+  }
+
+  writer->endArray();
+
+  writer->endObject();
+}
+
+
 // Forward declaration for 'summarize(Slave)'.
 JSON::Object model(const Slave& slave);
 
@@ -240,6 +334,7 @@ JSON::Object model(const Role& role)
   object.values["name"] = role.info.name();
   object.values["weight"] = role.info.weight();
   object.values["resources"] = model(role.resources());
+  object.values["reserved_resources"] = model(role.reserved);
 
   {
     JSON::Array array;
@@ -255,6 +350,36 @@ JSON::Object model(const Role& role)
 }
 
 
+// Returns whether the framework matches the (optional) framework ID
+// and role, i.e., the 'framework_id' and 'role' query parameters.
+static bool matches(
+    const Framework& framework,
+    const Option<string>& frameworkId,
+    const Option<string>& role)
+{
+  if (frameworkId.isSome() && framework.id().value() != frameworkId.get()) {
+    return false;
+  }
+
+  if (role.isSome() && framework.info.role() != role.get()) {
+    return false;
+  }
+
+  return true;
+}
+
+
+// Returns whether the request asks for a filtered (or projected)
+// response, which is never served from a snapshot.
+static bool filtered(const Request& request)
+{
+  return request.query.contains("framework_id") ||
+    request.query.contains("role") ||
+    request.query.contains("state") ||
+    request.query.contains("fields");
+}
+
+
 void Master::Http::log(const Request& request)
 {
   Option<string> userAgent = request.headers.get("User-Agent");
@@ -271,6 +396,150 @@ void Master::Http::log(const Request& request)
 }
 
 
+// The amount of data buffered for a slow reader of /master/events
+// after which reading the event history is held off.
+static const size_t EVENTS_PIPE_CAPACITY = 1024 * 1024;
+
+
+const string Master::Http::EVENTS_HELP = HELP(
+    TLDR(
+        "History of the offers and tasks of the master."),
+    USAGE(
+        "/master/events"),
+    DESCRIPTION(
+        "Streams the events kept in the history of the master (see the",
+        "--event_history_dir flag) as JSON objects, one per line, oldest",
+        "first. Each event has a 'type' (OFFER, RESCIND, DECLINE, LAUNCH",
+        "or TERMINAL), a 'timestamp' (in seconds since the epoch), the",
+        "'framework_id' and 'slave_id', an 'offer_id' or 'task_id', and",
+        "the 'cpus' and 'mem' of the offer or task. TERMINAL events also",
+        "have the 'state' of the task.",
+        "",
+        "Query parameters:",
+        "",
+        ">        from=VALUE           Only streams the events at or after",
+        "this time (in seconds since the epoch).",
+        ">        to=VALUE             Only streams the events at or before",
+        "this time (in seconds since the epoch)."));
+
+
+namespace {
+
+JSON::Object toJSON(const EventHistory::Event& event)
+{
+  JSON::Object object;
+
+  switch (event.type) {
+    case EventHistory::OFFER:    object.values["type"] = "OFFER";    break;
+    case EventHistory::RESCIND:  object.values["type"] = "RESCIND";  break;
+    case EventHistory::DECLINE:  object.values["type"] = "DECLINE";  break;
+    case EventHistory::LAUNCH:   object.values["type"] = "LAUNCH";   break;
+    case EventHistory::TERMINAL: object.values["type"] = "TERMINAL"; break;
+  }
+
+  object.values["timestamp"] = event.timestamp / 1000000.0;
+  object.values["framework_id"] = event.frameworkId;
+  object.values["slave_id"] = event.slaveId;
+
+  if (event.type == EventHistory::LAUNCH ||
+      event.type == EventHistory::TERMINAL) {
+    object.values["task_id"] = event.id;
+  } else {
+    object.values["offer_id"] = event.id;
+  }
+
+  object.values["cpus"] = event.cpus;
+  object.values["mem"] = event.mem;
+
+  if (event.type == EventHistory::TERMINAL) {
+    object.values["state"] =
+      TaskState_Name(static_cast<TaskState>(event.state));
+  }
+
+  return object;
+}
+
+
+// Writes the events of the cursor into the pipe a block at a time,
+// waiting for the reader to catch up whenever the pipe is full. The
+// cursor does not refer to the master so this runs wherever the
+// pipe becomes writable rather than on the master.
+void stream(
+    const std::shared_ptr<EventHistory::Cursor>& cursor,
+    Pipe::Writer writer)
+{
+  while (true) {
+    Try<Option<vector<EventHistory::Event>>> events = cursor->next();
+
+    if (events.isError()) {
+      writer.fail("Failed to read the event history: " + events.error());
+      return;
+    } else if (events.get().isNone()) {
+      writer.close();
+      return;
+    }
+
+    string data;
+    foreach (const EventHistory::Event& event, events.get().get()) {
+      data += stringify(toJSON(event)) + "\n";
+    }
+
+    // NOTE: Writing fails if the reader has closed the pipe.
+    if (!writer.write(data)) {
+      return;
+    }
+
+    Future<Nothing> writable = writer.writable();
+    if (!writable.isReady()) {
+      writable.onAny([cursor, writer]() { stream(cursor, writer); });
+      return;
+    }
+  }
+}
+
+} // namespace {
+
+
+Future<Response> Master::Http::events(const Request& request) const
+{
+  if (master->eventHistory.get() == NULL) {
+    return NotFound(
+        "The event history is not enabled (see --event_history_dir flag)");
+  }
+
+  int64_t from = std::numeric_limits<int64_t>::min();
+  int64_t to = std::numeric_limits<int64_t>::max();
+
+  if (request.query.contains("from")) {
+    Try<double> seconds = numify<double>(request.query.get("from").get());
+    if (seconds.isError()) {
+      return BadRequest("Failed to parse 'from': " + seconds.error());
+    }
+    from = static_cast<int64_t>(seconds.get() * 1000000);
+  }
+
+  if (request.query.contains("to")) {
+    Try<double> seconds = numify<double>(request.query.get("to").get());
+    if (seconds.isError()) {
+      return BadRequest("Failed to parse 'to': " + seconds.error());
+    }
+    to = static_cast<int64_t>(seconds.get() * 1000000);
+  }
+
+  // Bound the events buffered on behalf of slow readers.
+  Pipe pipe(EVENTS_PIPE_CAPACITY);
+
+  OK response;
+  response.type = response.PIPE;
+  response.reader = pipe.reader();
+  response.headers["Content-Type"] = "application/json";
+
+  stream(master->eventHistory->events(from, to), pipe.writer());
+
+  return response;
+}
+
+
 const string Master::Http::HEALTH_HELP = HELP(
     TLDR(
         "Health check of the Master."),
@@ -302,7 +571,26 @@ const string Master::Http::OBSERVE_HELP = HELP(
         "The following fields should be supplied in a POST:",
         "1. " + MONITOR_KEY + " - name of the monitor that is being reported",
         "2. " + HOSTS_KEY + " - comma separated list of hosts",
-        "3. " + LEVEL_KEY + " - OK for healthy, anything else for unhealthy"));
+        "3. " + LEVEL_KEY + " - OK for healthy, anything else for unhealthy",
+        "",
+        "Alternatively, a batch of observations can be POSTed with a",
+        "'Content-Type' of 'application/json' as a JSON object of the",
+        "form {\"observations\": [{\"" + MONITOR_KEY + "\": ..., \"" +
+        HOSTS_KEY + "\": [...],",
+        "\"" + LEVEL_KEY + "\": ...}, ...]}, i.e., with an array of hosts.",
+        "",
+        "A host is unhealthy as long as any monitor last observed it as",
+        "unhealthy. The resources of the slaves on unhealthy hosts are not",
+        "offered to frameworks."));
+
+
+// An observation of the health of hosts by a monitor.
+struct Observation
+{
+  string monitor;
+  vector<string> hosts;
+  bool isHealthy;
+};
 
 
 Try<string> getFormValue(
@@ -330,53 +618,143 @@ Try<string> getFormValue(
 }
 
 
-Future<Response> Master::Http::observe(const Request& request) const
+// Parses a batch of observations, see OBSERVE_HELP.
+Try<vector<Observation>> parseObservations(const string& body)
 {
-  Try<hashmap<string, string>> decode =
-    process::http::query::decode(request.body);
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(body);
+  if (parse.isError()) {
+    return Error("Failed to parse observations: " + parse.error());
+  }
 
-  if (decode.isError()) {
-    return BadRequest("Unable to decode query string: " + decode.error());
+  Result<JSON::Array> array = parse.get().find<JSON::Array>("observations");
+  if (!array.isSome()) {
+    return Error("Expecting an array of 'observations'.");
   }
 
-  hashmap<string, string> values = decode.get();
+  vector<Observation> observations;
+
+  foreach (const JSON::Value& value, array.get().values) {
+    if (!value.is<JSON::Object>()) {
+      return Error("Expecting observations to be objects.");
+    }
+
+    const JSON::Object& object = value.as<JSON::Object>();
+
+    Result<JSON::String> monitor = object.find<JSON::String>(MONITOR_KEY);
+    if (!monitor.isSome() || monitor.get().value.empty()) {
+      return Error("Missing value for '" + MONITOR_KEY + "'.");
+    }
+
+    Result<JSON::Array> hosts = object.find<JSON::Array>(HOSTS_KEY);
+    if (!hosts.isSome()) {
+      return Error("Missing value for '" + HOSTS_KEY + "'.");
+    }
+
+    Result<JSON::String> level = object.find<JSON::String>(LEVEL_KEY);
+    if (!level.isSome() || level.get().value.empty()) {
+      return Error("Missing value for '" + LEVEL_KEY + "'.");
+    }
+
+    Observation observation;
+    observation.monitor = monitor.get().value;
+    observation.isHealthy = strings::upper(level.get().value) == "OK";
+
+    foreach (const JSON::Value& host, hosts.get().values) {
+      if (!host.is<JSON::String>()) {
+        return Error("Expecting '" + HOSTS_KEY + "' to be strings.");
+      }
+
+      observation.hosts.push_back(host.as<JSON::String>().value);
+    }
+
+    observations.push_back(observation);
+  }
+
+  return observations;
+}
+
+
+Future<Response> Master::Http::observe(const Request& request) const
+{
+  vector<Observation> observations;
 
   // Build up a JSON object of the values we recieved and send them back
-  // down the wire as JSON for validation / confirmation.
+  // down the wire as JSON for validation / confirmation. For a batch
+  // of observations only their number is sent back.
   JSON::Object response;
 
-  // TODO(ccarson):  As soon as RepairCoordinator is introduced it will
-  // consume these values. We should revisit if we still want to send the
-  // JSON down the wire at that point.
+  Option<string> contentType = request.headers.get("Content-Type");
 
-  // Add 'monitor'.
-  Try<string> monitor = getFormValue(MONITOR_KEY, values);
-  if (monitor.isError()) {
-    return BadRequest(monitor.error());
-  }
-  response.values[MONITOR_KEY] = monitor.get();
+  if (contentType.isSome() && contentType.get() == APPLICATION_JSON) {
+    Try<vector<Observation>> parse = parseObservations(request.body);
+    if (parse.isError()) {
+      return BadRequest(parse.error());
+    }
 
-  // Add 'hosts'.
-  Try<string> hostsString = getFormValue(HOSTS_KEY, values);
-  if (hostsString.isError()) {
-    return BadRequest(hostsString.error());
-  }
+    observations = parse.get();
+
+    response.values["observations"] = observations.size();
+  } else {
+    Try<hashmap<string, string>> decode =
+      process::http::query::decode(request.body);
+
+    if (decode.isError()) {
+      return BadRequest("Unable to decode query string: " + decode.error());
+    }
 
-  vector<string> hosts = strings::split(hostsString.get(), ",");
-  JSON::Array hostArray;
-  hostArray.values.assign(hosts.begin(), hosts.end());
+    hashmap<string, string> values = decode.get();
+
+    // Add 'monitor'.
+    Try<string> monitor = getFormValue(MONITOR_KEY, values);
+    if (monitor.isError()) {
+      return BadRequest(monitor.error());
+    }
+    response.values[MONITOR_KEY] = monitor.get();
+
+    // Add 'hosts'.
+    Try<string> hostsString = getFormValue(HOSTS_KEY, values);
+    if (hostsString.isError()) {
+      return BadRequest(hostsString.error());
+    }
 
-  response.values[HOSTS_KEY] = hostArray;
+    vector<string> hosts = strings::split(hostsString.get(), ",");
+    JSON::Array hostArray;
+    hostArray.values.assign(hosts.begin(), hosts.end());
 
-  // Add 'isHealthy'.
-  Try<string> level = getFormValue(LEVEL_KEY, values);
-  if (level.isError()) {
-    return BadRequest(level.error());
+    response.values[HOSTS_KEY] = hostArray;
+
+    // Add 'isHealthy'.
+    Try<string> level = getFormValue(LEVEL_KEY, values);
+    if (level.isError()) {
+      return BadRequest(level.error());
+    }
+
+    bool isHealthy = strings::upper(level.get()) == "OK";
+
+    response.values["isHealthy"] = isHealthy;
+
+    Observation observation;
+    observation.monitor = monitor.get();
+    observation.hosts = hosts;
+    observation.isHealthy = isHealthy;
+
+    observations.push_back(observation);
   }
 
-  bool isHealthy = strings::upper(level.get()) == "OK";
+  hashset<string> hosts;
+
+  foreach (const Observation& observation, observations) {
+    foreach (const string& host, observation.hosts) {
+      master->repairer->observe(
+          host,
+          observation.monitor,
+          observation.isHealthy);
+
+      hosts.insert(host);
+    }
+  }
 
-  response.values["isHealthy"] = isHealthy;
+  master->updateHealth(hosts);
 
   return OK(response);
 }
@@ -432,6 +810,24 @@ const string Master::Http::SLAVES_HELP = HELP(
 
 
 Future<Response> Master::Http::slaves(const Request& request) const
+{
+  if (master->snapshots != NULL) {
+    return process::dispatch(
+        master->snapshots, &SnapshotProcess::slaves, request);
+  }
+
+  const string etag = master->etag();
+
+  Option<Response> unmodified = notModified(request, etag);
+  if (unmodified.isSome()) {
+    return unmodified.get();
+  }
+
+  return cacheable(request, stringify(_slaves()), etag);
+}
+
+
+JSON::Object Master::Http::_slaves() const
 {
   JSON::Object object;
 
@@ -446,8 +842,7 @@ Future<Response> Master::Http::slaves(const Request& request) const
     object.values["slaves"] = std::move(array);
   }
 
-
-  return OK(object, request.query.get("jsonp"));
+  return object;
 }
 
 
@@ -458,144 +853,362 @@ const string Master::Http::STATE_HELP = HELP(
         "/master/state"),
     DESCRIPTION(
         "This endpoint shows information about the frameworks, tasks,",
-        "executors and slaves running in the cluster as a JSON object."));
-
-
-Future<Response> Master::Http::state(const Request& request) const
+        "executors and slaves running in the cluster as a JSON object.",
+        "",
+        "Query parameters:",
+        "",
+        ">        framework_id=VALUE   Only include the framework with this ID.",
+        ">        role=VALUE           Only include frameworks of this role."));
+
+
+// Streams the state of the master as JSON into a pipe. Serializing
+// the state of a large cluster can take seconds, so rather than
+// writing it all at once (and blocking the master for that long) it
+// gets written in steps of roughly 'CHUNK_SIZE' bytes, each of which
+// is dispatched to the master separately so that the master can
+// process other events in between. Since the state can change in
+// between steps, slaves and frameworks are looked up when they are
+// written, i.e., slaves and frameworks that get removed while
+// streaming are omitted and those added in the meantime are not
+// included.
+class Master::Http::StateStream
 {
-  JSON::Object object;
-  object.values["version"] = MESOS_VERSION;
+public:
+  StateStream(
+      Master* _master,
+      const Pipe::Writer& _pipe,
+      const Option<string>& _jsonp,
+      const Option<string>& frameworkId = None(),
+      const Option<string>& role = None())
+    : master(_master),
+      pipe(_pipe),
+      jsonp(_jsonp),
+      writer(&buffer),
+      phase(HEADER),
+      next(0)
+  {
+    foreachkey (const SlaveID& slaveId, master->slaves.registered) {
+      slaveIds.push_back(slaveId);
+    }
 
-  if (build::GIT_SHA.isSome()) {
-    object.values["git_sha"] = build::GIT_SHA.get();
-  }
+    foreachvalue (const Framework* framework, master->frameworks.registered) {
+      if (matches(*framework, frameworkId, role)) {
+        frameworkIds.push_back(framework->id());
+      }
+    }
 
-  if (build::GIT_BRANCH.isSome()) {
-    object.values["git_branch"] = build::GIT_BRANCH.get();
+    foreach (const std::shared_ptr<Framework>& framework,
+             master->frameworks.completed) {
+      if (matches(*framework, frameworkId, role)) {
+        completed.push_back(framework);
+      }
+    }
   }
 
-  if (build::GIT_TAG.isSome()) {
-    object.values["git_tag"] = build::GIT_TAG.get();
+  ~StateStream()
+  {
+    // Fail the reader if the stream got abandoned (e.g., because the
+    // master terminated). This is a no-op once the pipe is closed.
+    pipe.fail("Failed to stream the state");
   }
 
-  object.values["build_date"] = build::DATE;
-  object.values["build_time"] = build::TIME;
-  object.values["build_user"] = build::USER;
-  object.values["start_time"] = master->startTime.secs();
+  // Writes the next chunk of the state into the pipe and, unless the
+  // state has been written completely or the reader has gone away,
+  // dispatches writing the following chunk to the master.
+  static void resume(const std::shared_ptr<StateStream>& stream)
+  {
+    // Writing the state leaves the version of the master unchanged.
+    stream->master->reading = true;
 
-  if (master->electedTime.isSome()) {
-    object.values["elected_time"] = master->electedTime.get().secs();
+    if (stream->step()) {
+      process::dispatch(
+          stream->master->self(),
+          std::function<void()>(std::bind(&StateStream::resume, stream)));
+    }
   }
 
-  object.values["id"] = master->info().id();
-  object.values["pid"] = string(master->self());
-  object.values["hostname"] = master->info().hostname();
-  object.values["activated_slaves"] = master->_slaves_active();
-  object.values["deactivated_slaves"] = master->_slaves_inactive();
+  // Writes the entire state at once (without JSONP padding), e.g.,
+  // when taking a snapshot of the master.
+  static string serialize(Master* master)
+  {
+    Pipe pipe;
+    StateStream stream(master, pipe.writer(), None());
 
-  if (master->flags.cluster.isSome()) {
-    object.values["cluster"] = master->flags.cluster.get();
+    while (stream.phase != DONE) {
+      stream.advance();
+    }
+
+    return stream.buffer;
   }
 
-  if (master->leader.isSome()) {
-    object.values["leader"] = master->leader.get().pid();
+private:
+  enum Phase
+  {
+    HEADER,
+    SLAVES,
+    FRAMEWORKS,
+    COMPLETED_FRAMEWORKS,
+    ORPHAN_TASKS,
+    UNREGISTERED_FRAMEWORKS,
+    DONE
+  };
+
+  // Returns false if there is nothing left to write.
+  bool step()
+  {
+    while (phase != DONE && buffer.size() < CHUNK_SIZE) {
+      advance();
+    }
+
+    // NOTE: Writing fails if the reader has closed the pipe, in
+    // which case there is no point in continuing.
+    if (!buffer.empty()) {
+      if (!pipe.write(buffer)) {
+        return false;
+      }
+      buffer.clear();
+    }
+
+    if (phase == DONE) {
+      pipe.close();
+      return false;
+    }
+
+    return true;
   }
 
-  if (master->flags.log_dir.isSome()) {
-    object.values["log_dir"] = master->flags.log_dir.get();
+  // Writes the next piece of the state, i.e., the header, a single
+  // slave or framework or the transition to the next phase.
+  void advance()
+  {
+    switch (phase) {
+      case HEADER:
+        header();
+        writer.key("slaves");
+        writer.startArray();
+        phase = SLAVES;
+        break;
+
+      case SLAVES:
+        if (next < slaveIds.size()) {
+          Slave* slave = master->slaves.registered.get(slaveIds[next++]);
+          if (slave != NULL) {
+            writer.value(model(*slave));
+          }
+        } else {
+          transition("frameworks", FRAMEWORKS);
+        }
+        break;
+
+      case FRAMEWORKS:
+        if (next < frameworkIds.size()) {
+          Framework* framework = master->getFramework(frameworkIds[next++]);
+          if (framework != NULL) {
+            json(&writer, *framework);
+          }
+        } else {
+          transition("completed_frameworks", COMPLETED_FRAMEWORKS);
+        }
+        break;
+
+      case COMPLETED_FRAMEWORKS:
+        if (next < completed.size()) {
+          json(&writer, *completed[next++]);
+        } else {
+          transition("orphan_tasks", ORPHAN_TASKS);
+        }
+        break;
+
+      case ORPHAN_TASKS:
+        if (next < slaveIds.size()) {
+          Slave* slave = master->slaves.registered.get(slaveIds[next++]);
+          if (slave != NULL) {
+            typedef hashmap<TaskID, Task*> TaskMap;
+            foreachvalue (const TaskMap& tasks, slave->tasks) {
+              foreachvalue (const Task* task, tasks) {
+                CHECK_NOTNULL(task);
+                if (!master->frameworks.registered.contains(
+                        task->framework_id())) {
+                  json(&writer, *task);
+                }
+              }
+            }
+          }
+        } else {
+          transition("unregistered_frameworks", UNREGISTERED_FRAMEWORKS);
+        }
+        break;
+
+      case UNREGISTERED_FRAMEWORKS:
+        if (next < slaveIds.size()) {
+          Slave* slave = master->slaves.registered.get(slaveIds[next++]);
+          if (slave != NULL) {
+            foreachkey (const FrameworkID& frameworkId, slave->tasks) {
+              if (!master->frameworks.registered.contains(frameworkId)) {
+                writer.value(frameworkId.value());
+              }
+            }
+          }
+        } else {
+          writer.endArray();
+          writer.endObject();
+
+          if (jsonp.isSome()) {
+            buffer.append(");");
+          }
+
+          phase = DONE;
+        }
+        break;
+
+      case DONE:
+        break;
+    }
   }
 
-  if (master->flags.external_log_file.isSome()) {
-    object.values["external_log_file"] = master->flags.external_log_file.get();
+  // Ends the array of the current phase and starts the array (with
+  // the specified key) of the next phase.
+  void transition(const string& key, Phase _phase)
+  {
+    writer.endArray();
+    writer.key(key);
+    writer.startArray();
+
+    phase = _phase;
+    next = 0;
   }
 
+  void header()
   {
-    JSON::Object flags;
+    if (jsonp.isSome()) {
+      buffer.append(jsonp.get() + "(");
+    }
+
+    writer.startObject();
+    writer.field("version", MESOS_VERSION);
+
+    if (build::GIT_SHA.isSome()) {
+      writer.field("git_sha", build::GIT_SHA.get());
+    }
+
+    if (build::GIT_BRANCH.isSome()) {
+      writer.field("git_branch", build::GIT_BRANCH.get());
+    }
+
+    if (build::GIT_TAG.isSome()) {
+      writer.field("git_tag", build::GIT_TAG.get());
+    }
+
+    writer.field("build_date", build::DATE);
+    writer.field("build_time", build::TIME);
+    writer.field("build_user", build::USER);
+    writer.field("start_time", master->startTime.secs());
+
+    if (master->electedTime.isSome()) {
+      writer.field("elected_time", master->electedTime.get().secs());
+    }
+
+    writer.field("id", master->info().id());
+    writer.field("pid", string(master->self()));
+    writer.field("hostname", master->info().hostname());
+    writer.field("activated_slaves", master->_slaves_active());
+    writer.field("deactivated_slaves", master->_slaves_inactive());
+
+    if (master->flags.cluster.isSome()) {
+      writer.field("cluster", master->flags.cluster.get());
+    }
+
+    if (master->leader.isSome()) {
+      writer.field("leader", master->leader.get().pid());
+    }
+
+    if (master->flags.log_dir.isSome()) {
+      writer.field("log_dir", master->flags.log_dir.get());
+    }
+
+    if (master->flags.external_log_file.isSome()) {
+      writer.field(
+          "external_log_file", master->flags.external_log_file.get());
+    }
+
+    writer.key("flags");
+    writer.startObject();
     foreachpair (const string& name, const flags::Flag& flag, master->flags) {
       Option<string> value = flag.stringify(master->flags);
       if (value.isSome()) {
-        flags.values[name] = value.get();
+        writer.field(name, value.get());
       }
     }
-    object.values["flags"] = std::move(flags);
-  }
-
-  // Model all of the slaves.
-  {
-    JSON::Array array;
-    array.values.reserve(master->slaves.registered.size()); // MESOS-2353.
-
-    foreachvalue (Slave* slave, master->slaves.registered) {
-      array.values.push_back(model(*slave));
-    }
-
-    object.values["slaves"] = std::move(array);
+    writer.endObject();
   }
 
-  // Model all of the frameworks.
-  {
-    JSON::Array array;
-    array.values.reserve(master->frameworks.registered.size()); // MESOS-2353.
+  // The (approximate) amount of data written per step.
+  static const size_t CHUNK_SIZE = 64 * 1024;
 
-    foreachvalue (Framework* framework, master->frameworks.registered) {
-      array.values.push_back(model(*framework));
-    }
+  Master* master;
+  Pipe::Writer pipe;
+  const Option<string> jsonp;
 
-    object.values["frameworks"] = std::move(array);
-  }
+  string buffer;
+  JSON::Writer writer;
 
-  // Model all of the completed frameworks.
-  {
-    JSON::Array array;
-    array.values.reserve(master->frameworks.completed.size()); // MESOS-2353.
+  Phase phase;
+  size_t next; // Index of the next slave or framework to write.
+
+  vector<SlaveID> slaveIds;
+  vector<FrameworkID> frameworkIds;
+  vector<std::shared_ptr<Framework>> completed;
+};
 
-    foreach (const std::shared_ptr<Framework>& framework,
-             master->frameworks.completed) {
-      array.values.push_back(model(*framework));
-    }
 
-    object.values["completed_frameworks"] = std::move(array);
+Future<Response> Master::Http::state(const Request& request) const
+{
+  if (master->snapshots != NULL && !filtered(request)) {
+    return process::dispatch(
+        master->snapshots, &SnapshotProcess::state, request);
   }
 
-  // Model all of the orphan tasks.
-  {
-    JSON::Array array;
+  // NOTE: The state gets streamed over several events of the master,
+  // but these leave the version unchanged, i.e., the state written is
+  // the state of this ETag unless the master changes meanwhile, in
+  // which case the ETag won't match the next poll anyway.
+  const string etag = master->etag();
 
-    // Find those orphan tasks.
-    foreachvalue (const Slave* slave, master->slaves.registered) {
-      typedef hashmap<TaskID, Task*> TaskMap;
-      foreachvalue (const TaskMap& tasks, slave->tasks) {
-        foreachvalue (const Task* task, tasks) {
-          CHECK_NOTNULL(task);
-          if (!master->frameworks.registered.contains(task->framework_id())) {
-            array.values.push_back(model(*task));
-          }
-        }
-      }
-    }
+  Option<Response> unmodified = notModified(request, etag);
+  if (unmodified.isSome()) {
+    return unmodified.get();
+  }
 
-    object.values["orphan_tasks"] = std::move(array);
+  if (master->overloaded()) {
+    ++master->metrics->shed_requests;
+    return ServiceUnavailable("The master is overloaded, retry later");
   }
 
-  // Model all currently unregistered frameworks.
-  // This could happen when the framework has yet to re-register
-  // after master failover.
-  {
-    JSON::Array array;
+  Option<string> jsonp = request.query.get("jsonp");
 
-    // Find unregistered frameworks.
-    foreachvalue (const Slave* slave, master->slaves.registered) {
-      foreachkey (const FrameworkID& frameworkId, slave->tasks) {
-        if (!master->frameworks.registered.contains(frameworkId)) {
-          array.values.push_back(frameworkId.value());
-        }
-      }
-    }
+  Pipe pipe;
 
-    object.values["unregistered_frameworks"] = std::move(array);
+  OK ok;
+  ok.type = Response::PIPE;
+  ok.reader = pipe.reader();
+
+  if (jsonp.isSome()) {
+    ok.headers["Content-Type"] = "text/javascript";
+  } else {
+    ok.headers["Content-Type"] = "application/json";
   }
 
-  return OK(object, request.query.get("jsonp"));
+  ok.headers["ETag"] = etag;
+
+  StateStream::resume(std::shared_ptr<StateStream>(
+      new StateStream(
+          master,
+          pipe.writer(),
+          jsonp,
+          request.query.get("framework_id"),
+          request.query.get("role"))));
+
+  return ok;
 }
 
 
@@ -621,7 +1234,8 @@ public:
         slavesToFrameworks[task->slave_id()].insert(frameworkId);
       }
 
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
+      foreach (const std::shared_ptr<CompletedTask>& task,
+               framework->completedTasks) {
         frameworksToSlaves[frameworkId].insert(task->slave_id());
         slavesToFrameworks[task->slave_id()].insert(frameworkId);
       }
@@ -667,9 +1281,9 @@ struct TaskStateSummary
       error(0) {}
 
   // Account for the state of the given task.
-  void count(const Task& task)
+  void count(TaskState state)
   {
-    switch (task.state()) {
+    switch (state) {
       case TASK_STAGING: { ++staging; break; }
       case TASK_STARTING: { ++starting; break; }
       case TASK_RUNNING: { ++running; break; }
@@ -715,13 +1329,14 @@ public:
       }
 
       foreachvalue (const Task* task, framework->tasks) {
-        frameworkTaskSummaries[frameworkId].count(*task);
-        slaveTaskSummaries[task->slave_id()].count(*task);
+        frameworkTaskSummaries[frameworkId].count(task->state());
+        slaveTaskSummaries[task->slave_id()].count(task->state());
       }
 
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-        frameworkTaskSummaries[frameworkId].count(*task);
-        slaveTaskSummaries[task->slave_id()].count(*task);
+      foreach (const std::shared_ptr<CompletedTask>& task,
+               framework->completedTasks) {
+        frameworkTaskSummaries[frameworkId].count(task->state());
+        slaveTaskSummaries[task->slave_id()].count(task->state());
       }
     }
   }
@@ -756,6 +1371,24 @@ const string Master::Http::STATESUMMARY_HELP = HELP(
 
 
 Future<Response> Master::Http::stateSummary(const Request& request) const
+{
+  if (master->snapshots != NULL) {
+    return process::dispatch(
+        master->snapshots, &SnapshotProcess::stateSummary, request);
+  }
+
+  const string etag = master->etag();
+
+  Option<Response> unmodified = notModified(request, etag);
+  if (unmodified.isSome()) {
+    return unmodified.get();
+  }
+
+  return cacheable(request, stringify(_stateSummary()), etag);
+}
+
+
+JSON::Object Master::Http::_stateSummary() const
 {
   JSON::Object object;
 
@@ -765,6 +1398,34 @@ Future<Response> Master::Http::stateSummary(const Request& request) const
     object.values["cluster"] = master->flags.cluster.get();
   }
 
+  // The fields of the header of /master/state.json that the webui
+  // shows, so that the webui can poll this endpoint instead.
+  object.values["version"] = MESOS_VERSION;
+  object.values["build_time"] = build::TIME;
+  object.values["build_user"] = build::USER;
+  object.values["start_time"] = master->startTime.secs();
+
+  if (master->electedTime.isSome()) {
+    object.values["elected_time"] = master->electedTime.get().secs();
+  }
+
+  object.values["id"] = master->info().id();
+  object.values["pid"] = string(master->self());
+  object.values["activated_slaves"] = master->_slaves_active();
+  object.values["deactivated_slaves"] = master->_slaves_inactive();
+
+  if (master->leader.isSome()) {
+    object.values["leader"] = master->leader.get().pid();
+  }
+
+  if (master->flags.log_dir.isSome()) {
+    object.values["log_dir"] = master->flags.log_dir.get();
+  }
+
+  if (master->flags.external_log_file.isSome()) {
+    object.values["external_log_file"] = master->flags.external_log_file.get();
+  }
+
   // We use the tasks in the 'Frameworks' struct to compute summaries
   // for this endpoint. This is done 1) for consistency between the
   // 'slaves' and 'frameworks' subsections below 2) because we want to
@@ -859,7 +1520,7 @@ Future<Response> Master::Http::stateSummary(const Request& request) const
     object.values["frameworks"] = std::move(array);
   }
 
-  return OK(object, request.query.get("jsonp"));
+  return object;
 }
 
 
@@ -875,6 +1536,13 @@ const string Master::Http::ROLES_HELP = HELP(
 
 Future<Response> Master::Http::roles(const Request& request) const
 {
+  const string etag = master->etag();
+
+  Option<Response> unmodified = notModified(request, etag);
+  if (unmodified.isSome()) {
+    return unmodified.get();
+  }
+
   JSON::Object object;
 
   // Model all of the roles.
@@ -887,7 +1555,136 @@ Future<Response> Master::Http::roles(const Request& request) const
     object.values["roles"] = std::move(array);
   }
 
-  return OK(object, request.query.get("jsonp"));
+  return cacheable(request, stringify(object), etag);
+}
+
+
+const string Master::Http::SCHEDULER_HELP = HELP(
+    TLDR(
+        "Endpoint for schedulers to make calls against the master."),
+    USAGE(
+        "/master/api/v1/scheduler"),
+    DESCRIPTION(
+        "Expects a POST of a serialized scheduler Call, with a",
+        "'Content-Type' of either 'application/json' or",
+        "'application/x-protobuf'.",
+        "A SUBSCRIBE call is answered with a 200 OK whose chunked body",
+        "streams the events for the framework in the recordio format,",
+        "for as long as the connection stays open. The response has a",
+        "'Mesos-Stream-Id' header identifying the subscription.",
+        "All other calls must come from a subscribed framework, carry",
+        "the 'Mesos-Stream-Id' of its subscription and are answered",
+        "with a 202 Accepted."));
+
+
+Future<Response> Master::Http::scheduler(const Request& request) const
+{
+  if (request.method != "POST") {
+    return BadRequest("Expecting POST");
+  }
+
+  // Calls are only processed by the leading master, schedulers are
+  // expected to (re-)detect the leader and retry.
+  if (!master->elected()) {
+    return ServiceUnavailable("Not the leading master");
+  }
+
+  Option<string> contentType = request.headers.get("Content-Type");
+
+  if (contentType.isNone()) {
+    return BadRequest("Expecting 'Content-Type' to be present");
+  }
+
+  Try<scheduler::Call> call =
+    deserialize<scheduler::Call>(contentType.get(), request.body);
+
+  if (call.isError()) {
+    return BadRequest("Failed to parse call: " + call.error());
+  }
+
+  Result<Credential> credential = authenticate(request);
+
+  if (credential.isError()) {
+    return Unauthorized("Mesos master", credential.error());
+  }
+
+  FrameworkInfo frameworkInfo = call.get().framework_info();
+
+  if (master->flags.authenticate_frameworks) {
+    if (credential.isNone()) {
+      return Unauthorized("Mesos master", "Framework is not authenticated");
+    }
+
+    if (frameworkInfo.has_principal() &&
+        frameworkInfo.principal() != credential.get().principal()) {
+      return Forbidden(
+          "Framework principal '" + frameworkInfo.principal() +
+          "' does not match authenticated principal '" +
+          credential.get().principal() + "'");
+    }
+
+    // The framework is subscribed with the principal it authenticated
+    // as, which is what a failover is checked against (see
+    // 'Master::_subscribe').
+    frameworkInfo.set_principal(credential.get().principal());
+  }
+
+  if (call.get().type() == scheduler::Call::SUBSCRIBE) {
+    Try<string> streamId = generateToken();
+    if (streamId.isError()) {
+      return InternalServerError(
+          "Failed to generate a stream ID: " + streamId.error());
+    }
+
+    Pipe pipe;
+    OK ok;
+    ok.headers["Content-Type"] = contentType.get();
+    ok.headers["Mesos-Stream-Id"] = streamId.get();
+    ok.type = Response::PIPE;
+    ok.reader = pipe.reader();
+
+    master->subscribe(
+        HttpConnection(pipe.writer(), contentType.get(), streamId.get()),
+        frameworkInfo);
+
+    return ok;
+  }
+
+  Framework* framework = master->getFramework(frameworkInfo.id());
+
+  if (framework == NULL) {
+    return BadRequest("Framework cannot be found");
+  }
+
+  // Frameworks that are subscribed through the scheduler driver must
+  // keep making their calls through it, see 'Master::receive'.
+  if (framework->http.isNone()) {
+    return Forbidden("Framework is not subscribed over HTTP");
+  }
+
+  if (master->flags.authenticate_frameworks &&
+      credential.get().principal() != framework->info.principal()) {
+    return Forbidden(
+        "Authenticated principal '" + credential.get().principal() +
+        "' does not match the principal of the framework");
+  }
+
+  // The calls are tied to the subscription of the framework, i.e.,
+  // knowing the ID of the framework does not suffice to make calls
+  // on its behalf.
+  Option<string> streamId = request.headers.get("Mesos-Stream-Id");
+
+  if (streamId.isNone()) {
+    return BadRequest("Expecting 'Mesos-Stream-Id' to be present");
+  }
+
+  if (streamId.get() != framework->http.get().streamId) {
+    return Forbidden("'Mesos-Stream-Id' does not match the subscription");
+  }
+
+  master->receive(framework, call.get());
+
+  return Accepted();
 }
 
 
@@ -1015,7 +1812,14 @@ const string Master::Http::TASKS_HELP = HELP(
       "(default is " + stringify(TASK_LIMIT) + ").",
       ">        offset=VALUE         Starts task list at offset.",
       ">        order=(asc|desc)     Ascending or descending sort order "
-      "(default is descending)."
+      "(default is descending).",
+      ">        framework_id=VALUE   Only lists tasks of this framework.",
+      ">        role=VALUE           Only lists tasks of frameworks of this "
+      "role.",
+      ">        state=VALUE          Only lists tasks in this state "
+      "(e.g., TASK_RUNNING).",
+      ">        fields=VALUE         Comma separated list of the fields "
+      "to include for each task (e.g., id,state,slave_id)."
       ""));
 
 
@@ -1065,6 +1869,18 @@ struct TaskComparator
 
 Future<Response> Master::Http::tasks(const Request& request) const
 {
+  if (master->snapshots != NULL && !filtered(request)) {
+    return process::dispatch(
+        master->snapshots, &SnapshotProcess::tasks, request);
+  }
+
+  const string etag = master->etag();
+
+  Option<Response> unmodified = notModified(request, etag);
+  if (unmodified.isSome()) {
+    return unmodified.get();
+  }
+
   // Get list options (limit and offset).
   Result<int> result = numify<int>(request.query.get("limit"));
   size_t limit = result.isSome() ? result.get() : TASK_LIMIT;
@@ -1075,14 +1891,109 @@ Future<Response> Master::Http::tasks(const Request& request) const
   // TODO(nnielsen): Currently, formatting errors in offset and/or limit
   // will silently be ignored. This could be reported to the user instead.
 
+  Option<TaskState> state;
+  if (request.query.contains("state")) {
+    TaskState state_;
+    if (!TaskState_Parse(request.query.get("state").get(), &state_)) {
+      return BadRequest(
+          "Invalid task state '" + request.query.get("state").get() + "'");
+    }
+    state = state_;
+  }
+
+  Option<hashset<string>> fields;
+  if (request.query.contains("fields")) {
+    fields = hashset<string>();
+    foreach (const string& field,
+             strings::tokenize(request.query.get("fields").get(), ",")) {
+      fields.get().insert(field);
+    }
+  }
+
+  vector<std::shared_ptr<const Task>> completed;
+  vector<const Task*> tasks = _tasks(
+      request.query.get("framework_id"),
+      request.query.get("role"),
+      &completed);
+
+  if (state.isSome()) {
+    vector<const Task*> tasks_;
+    foreach (const Task* task, tasks) {
+      if (task->state() == state.get()) {
+        tasks_.push_back(task);
+      }
+    }
+    std::swap(tasks, tasks_);
+  }
+
+  // Sort tasks by task status timestamp. Default order is descending.
+  // The earliest timestamp is chosen for comparison when multiple are present.
+  // NOTE: Only the requested page (and the tasks before it) needs to
+  // be sorted.
+  const size_t end = std::min(offset + limit, tasks.size());
+
+  Option<string> order = request.query.get("order");
+  if (order.isSome() && (order.get() == "asc")) {
+    std::partial_sort(
+        tasks.begin(),
+        tasks.begin() + end,
+        tasks.end(),
+        TaskComparator::ascending);
+  } else {
+    std::partial_sort(
+        tasks.begin(),
+        tasks.begin() + end,
+        tasks.end(),
+        TaskComparator::descending);
+  }
+
+  JSON::Object object;
+
+  {
+    JSON::Array array;
+    for (size_t i = offset; i < end; i++) {
+      const Task* task = tasks[i];
+
+      if (fields.isNone()) {
+        array.values.push_back(model(*task));
+        continue;
+      }
+
+      JSON::Object task_ = model(*task);
+      JSON::Object projected;
+      foreach (const string& field, fields.get()) {
+        if (task_.values.count(field) > 0) {
+          projected.values[field] = task_.values[field];
+        }
+      }
+
+      array.values.push_back(std::move(projected));
+    }
+
+    object.values["tasks"] = std::move(array);
+  }
+
+  return cacheable(request, stringify(object), etag);
+}
+
+
+vector<const Task*> Master::Http::_tasks(
+    const Option<string>& frameworkId,
+    const Option<string>& role,
+    vector<std::shared_ptr<const Task>>* completed) const
+{
   // Construct framework list with both active and completed framwworks.
   vector<const Framework*> frameworks;
   foreachvalue (Framework* framework, master->frameworks.registered) {
-    frameworks.push_back(framework);
+    if (matches(*framework, frameworkId, role)) {
+      frameworks.push_back(framework);
+    }
   }
   foreach (const std::shared_ptr<Framework>& framework,
            master->frameworks.completed) {
-    frameworks.push_back(framework.get());
+    if (matches(*framework, frameworkId, role)) {
+      frameworks.push_back(framework.get());
+    }
   }
 
   // Construct task list with both running and finished tasks.
@@ -1092,37 +2003,239 @@ Future<Response> Master::Http::tasks(const Request& request) const
       CHECK_NOTNULL(task);
       tasks.push_back(task);
     }
-    foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-      tasks.push_back(task.get());
+    foreach (const std::shared_ptr<CompletedTask>& completedTask,
+             framework->completedTasks) {
+      Try<std::shared_ptr<const Task>> task = completedTask->get();
+      if (task.isError()) {
+        LOG(WARNING) << "Failed to get completed task "
+                     << completedTask->task_id() << ": " << task.error();
+        continue;
+      }
+
+      completed->push_back(task.get());
+      tasks.push_back(task.get().get());
     }
   }
 
-  // Sort tasks by task status timestamp. Default order is descending.
-  // The earliest timestamp is chosen for comparison when multiple are present.
-  Option<string> order = request.query.get("order");
-  if (order.isSome() && (order.get() == "asc")) {
-    sort(tasks.begin(), tasks.end(), TaskComparator::ascending);
-  } else {
-    sort(tasks.begin(), tasks.end(), TaskComparator::descending);
+  return tasks;
+}
+
+
+const string Master::Http::UTILIZATION_HELP = HELP(
+    TLDR(
+        "Resource usage of the cluster."),
+    USAGE(
+        "/master/utilization"),
+    DESCRIPTION(
+        "This endpoint shows the resource usage of the executors in the",
+        "cluster as a JSON object, both in total and per slave.",
+        "",
+        "The usage of each slave is the sum of the usage of its executors",
+        "as last reported by the slave along with its pongs, i.e., it can",
+        "be as old as the ping timeout. Slaves that have not reported",
+        "their usage yet are omitted."));
+
+
+Future<Response> Master::Http::utilization(const Request& request) const
+{
+  // NOTE: The usage reports do not bump the version of the master
+  // (see 'Master::updateUsage'), hence this endpoint is not cached.
+  ResourceStatistics total;
+  total.set_timestamp(Clock::now().secs());
+  total.set_cpus_limit(0.0);
+  total.set_cpus_user_time_secs(0.0);
+  total.set_cpus_system_time_secs(0.0);
+  total.set_mem_rss_bytes(0);
+  total.set_mem_limit_bytes(0);
+
+  JSON::Array array;
+
+  foreachvalue (const Slave* slave, master->slaves.registered) {
+    if (slave->usage.isNone()) {
+      continue;
+    }
+
+    const ResourceStatistics& usage = slave->usage.get();
+
+    total.set_cpus_limit(total.cpus_limit() + usage.cpus_limit());
+    total.set_cpus_user_time_secs(
+        total.cpus_user_time_secs() + usage.cpus_user_time_secs());
+    total.set_cpus_system_time_secs(
+        total.cpus_system_time_secs() + usage.cpus_system_time_secs());
+    total.set_mem_rss_bytes(total.mem_rss_bytes() + usage.mem_rss_bytes());
+    total.set_mem_limit_bytes(
+        total.mem_limit_bytes() + usage.mem_limit_bytes());
+
+    JSON::Object object;
+    object.values["id"] = slave->id.value();
+    object.values["hostname"] = slave->info.hostname();
+    object.values["statistics"] = JSON::Protobuf(usage);
+
+    array.values.push_back(std::move(object));
   }
 
   JSON::Object object;
+  object.values["total"] = JSON::Protobuf(total);
+  object.values["slaves"] = std::move(array);
 
-  {
-    JSON::Array array;
-    size_t end = std::min(offset + limit, tasks.size());
-    for (size_t i = offset; i < end; i++) {
-      const Task* task = tasks[i];
-      array.values.push_back(model(*task));
+  return OK(object, request.query.get("jsonp"));
+}
+
+
+const string Master::Http::MEMORY_HELP = HELP(
+    TLDR(
+        "Approximate memory used by the major structures of the master."),
+    USAGE(
+        "/master/memory"),
+    DESCRIPTION(
+        "This endpoint shows the number of frameworks, tasks, completed",
+        "tasks, completed frameworks, offers and slaves kept by the",
+        "master, along with the approximate number of bytes they use.",
+        "",
+        "The bytes are estimated from the protobufs that make up the",
+        "objects, i.e., the overhead of the containers holding them is",
+        "not included. A sample of the heap allocations of the whole",
+        "process can be obtained from /profiler/heap if libprocess is",
+        "configured with --enable-tcmalloc."));
+
+
+Future<Response> Master::Http::memory(const Request& request) const
+{
+  // Returns the number of objects and their bytes as a JSON object.
+  auto json = [](size_t count, size_t bytes) {
+    JSON::Object object;
+    object.values["count"] = count;
+    object.values["bytes"] = bytes;
+    return object;
+  };
+
+  size_t frameworks = 0;
+  size_t tasks = 0;
+  size_t tasksCount = 0;
+  size_t completedTasks = 0;
+  size_t completedTasksCount = 0;
+
+  foreachvalue (const Framework* framework, master->frameworks.registered) {
+    frameworks += framework->info.SpaceUsed();
+
+    tasksCount += framework->tasks.size();
+    foreachvalue (const Task* task, framework->tasks) {
+      tasks += task->SpaceUsed();
     }
 
-    object.values["tasks"] = std::move(array);
+    foreach (const std::shared_ptr<CompletedTask>& task,
+             framework->completedTasks) {
+      completedTasks += task->bytes();
+      completedTasksCount++;
+    }
+  }
+
+  // The tasks of the completed frameworks are accounted to them.
+  size_t completedFrameworks = 0;
+
+  foreach (const std::shared_ptr<Framework>& framework,
+           master->frameworks.completed) {
+    completedFrameworks += framework->info.SpaceUsed();
+
+    foreachvalue (const Task* task, framework->tasks) {
+      completedFrameworks += task->SpaceUsed();
+    }
+
+    foreach (const std::shared_ptr<CompletedTask>& task,
+             framework->completedTasks) {
+      completedFrameworks += task->bytes();
+    }
+  }
+
+  size_t offers = 0;
+
+  foreachvalue (const Offer* offer, master->offers) {
+    offers += offer->SpaceUsed();
+  }
+
+  // The tasks of the slaves are the ones of the frameworks.
+  size_t slaves = 0;
+
+  foreachvalue (const Slave* slave, master->slaves.registered) {
+    slaves += slave->info.SpaceUsed();
+
+    if (slave->usage.isSome()) {
+      slaves += slave->usage.get().SpaceUsed();
+    }
   }
 
+  JSON::Object object;
+  object.values["frameworks"] =
+    json(master->frameworks.registered.size(), frameworks);
+  object.values["tasks"] = json(tasksCount, tasks);
+  object.values["completed_tasks"] =
+    json(completedTasksCount, completedTasks);
+  object.values["completed_frameworks"] =
+    json(master->frameworks.completed.size(), completedFrameworks);
+  object.values["offers"] = json(master->offers.size(), offers);
+  object.values["slaves"] =
+    json(master->slaves.registered.size(), slaves);
+  object.values["total_bytes"] =
+    frameworks + tasks + completedTasks + completedFrameworks + offers +
+    slaves;
+
   return OK(object, request.query.get("jsonp"));
 }
 
 
+const string Master::Http::TRACE_HELP = HELP(
+    TLDR(
+        "Spans of the most recently traced task launches."),
+    USAGE(
+        "/master/trace"),
+    DESCRIPTION(
+        "This endpoint shows the spans the master recorded for a sample",
+        "of the task launches (see --trace_sampling_rate) as a JSON",
+        "object, oldest first. Spans with the same 'trace_id' belong to",
+        "the same launch, also across the /trace endpoints of the slaves.",
+        "",
+        "The 'master/accept' span lasts until the task is sent to the",
+        "slave, which includes the authorization and the validation of",
+        "the task. The 'task/launch' span lasts until the master learns",
+        "that the task is running."));
+
+
+Future<Response> Master::Http::trace(const Request& request) const
+{
+  return OK(master->tracer.json(), request.query.get("jsonp"));
+}
+
+
+std::shared_ptr<const Snapshot> Master::Http::snapshot() const
+{
+  // Taking a snapshot leaves the version of the master unchanged.
+  master->reading = true;
+
+  std::shared_ptr<Snapshot> snapshot(new Snapshot());
+
+  snapshot->time = Clock::now();
+  snapshot->etag = master->etag();
+  snapshot->state = StateStream::serialize(master);
+  snapshot->stateSummary = stringify(_stateSummary());
+  snapshot->slaves = stringify(_slaves());
+
+  vector<std::shared_ptr<const Task>> completed;
+  vector<const Task*> tasks = _tasks(None(), None(), &completed);
+  sort(tasks.begin(), tasks.end(), TaskComparator::descending);
+
+  snapshot->tasks.reserve(tasks.size());
+  foreach (const Task* task, tasks) {
+    string serialized;
+    JSON::Writer writer(&serialized);
+    json(&writer, *task);
+
+    snapshot->tasks.push_back(std::move(serialized));
+  }
+
+  return snapshot;
+}
+
+
 Result<Credential> Master::Http::authenticate(const Request& request) const
 {
   // By default, assume everyone is authenticated if no credentials
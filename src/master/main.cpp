@@ -41,6 +41,7 @@
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
@@ -72,6 +73,8 @@
 
 
 #include "zookeeper/detector.hpp"
+#include "zookeeper/group.hpp"
+#include "zookeeper/url.hpp"
 
 using namespace mesos::internal;
 using namespace mesos::internal::log;
@@ -145,6 +148,11 @@ int main(int argc, char** argv)
     return EXIT_SUCCESS;
   }
 
+  // The phases of the startup are timed, and logged once logging is
+  // initialized.
+  Stopwatch stopwatch;
+  stopwatch.start();
+
   // Initialize modules. Note that since other subsystems may depend
   // upon modules, we should initialize modules before anything else.
   if (flags.modules.isSome()) {
@@ -162,6 +170,8 @@ int main(int argc, char** argv)
     }
   }
 
+  const Duration modules = stopwatch.elapsed();
+
   // Initialize libprocess.
   if (ip.isSome()) {
     os::setenv("LIBPROCESS_IP", ip.get());
@@ -185,6 +195,57 @@ int main(int argc, char** argv)
     LOG(INFO) << "Git SHA: " << build::GIT_SHA.get();
   }
 
+  LOG(INFO) << "Loaded modules and hooks in " << modules;
+  LOG(INFO) << "Initialized libprocess in " << stopwatch.elapsed() - modules;
+
+  // The contender and the detector are created first so that the
+  // ZooKeeper session gets established while the allocator and the
+  // registry storage (e.g., the replicated log) are set up.
+  MasterContender* contender;
+  MasterDetector* detector;
+
+  if (zk.isSome() && strings::startsWith(zk.get(), "zk://")) {
+    Try<zookeeper::URL> url = zookeeper::URL::parse(zk.get());
+    if (url.isError()) {
+      EXIT(EXIT_FAILURE) << "Error parsing ZooKeeper URL: " << url.error();
+    }
+
+    if (url.get().path == "/") {
+      EXIT(EXIT_FAILURE)
+        << "Expecting a (chroot) path for ZooKeeper ('/' is not supported)";
+    }
+
+    // The contender and the detector share a group, i.e., a single
+    // ZooKeeper session (and its heartbeats and watches) rather than
+    // one session each, which also means that they recover from a
+    // session expiration together.
+    Owned<zookeeper::Group> group(
+        new zookeeper::Group(url.get(), MASTER_CONTENDER_ZK_SESSION_TIMEOUT));
+
+    contender = new ZooKeeperMasterContender(group);
+    detector = new ZooKeeperMasterDetector(group);
+  } else {
+    // TODO(vinod): 'MasterContender::create()' should take
+    // Option<string>.
+    Try<MasterContender*> contender_ = MasterContender::create(zk.get(""));
+    if (contender_.isError()) {
+      EXIT(EXIT_FAILURE)
+        << "Failed to create a master contender: " << contender_.error();
+    }
+    contender = contender_.get();
+
+    // TODO(vinod): 'MasterDetector::create()' should take
+    // Option<string>.
+    Try<MasterDetector*> detector_ = MasterDetector::create(zk.get(""));
+    if (detector_.isError()) {
+      EXIT(EXIT_FAILURE)
+        << "Failed to create a master detector: " << detector_.error();
+    }
+    detector = detector_.get();
+  }
+
+  stopwatch.start();
+
   // Create an instance of allocator.
   const std::string allocatorName = flags.allocator;
   Try<Allocator*> allocator = Allocator::create(allocatorName);
@@ -224,6 +285,13 @@ int main(int argc, char** argv)
         << "': " << mkdir.error();
     }
 
+    LevelDBStorage::Options options;
+    options.blockCacheSize = flags.log_leveldb_block_cache_size;
+    options.writeBufferSize = flags.log_leveldb_write_buffer_size;
+    options.bloomFilterBitsPerKey =
+      flags.log_leveldb_bloom_filter_bits_per_key;
+    options.compactOnRestore = flags.log_leveldb_compact_on_restore;
+
     if (zk.isSome()) {
       // Use replicated log with ZooKeeper.
       if (flags.quorum.isNone()) {
@@ -244,14 +312,16 @@ int main(int argc, char** argv)
           flags.zk_session_timeout,
           path::join(url.get().path, "log_replicas"),
           url.get().authentication,
-          flags.log_auto_initialize);
+          flags.log_auto_initialize,
+          options);
     } else {
       // Use replicated log without ZooKeeper.
       log = new Log(
           1,
           path::join(flags.work_dir.get(), "replicated_log"),
           set<UPID>(),
-          flags.log_auto_initialize);
+          flags.log_auto_initialize,
+          options);
     }
     storage = new state::LogStorage(log);
   } else {
@@ -266,28 +336,10 @@ int main(int argc, char** argv)
   Registrar* registrar = new Registrar(flags, state);
   Repairer* repairer = new Repairer();
 
-  Files files;
-
-  MasterContender* contender;
-  MasterDetector* detector;
-
-  // TODO(vinod): 'MasterContender::create()' should take
-  // Option<string>.
-  Try<MasterContender*> contender_ = MasterContender::create(zk.get(""));
-  if (contender_.isError()) {
-    EXIT(EXIT_FAILURE)
-      << "Failed to create a master contender: " << contender_.error();
-  }
-  contender = contender_.get();
+  LOG(INFO) << "Created the allocator and the registry in "
+            << stopwatch.elapsed();
 
-  // TODO(vinod): 'MasterDetector::create()' should take
-  // Option<string>.
-  Try<MasterDetector*> detector_ = MasterDetector::create(zk.get(""));
-  if (detector_.isError()) {
-    EXIT(EXIT_FAILURE)
-      << "Failed to create a master detector: " << detector_.error();
-  }
-  detector = detector_.get();
+  Files files;
 
   Option<Authorizer*> authorizer = None();
   if (flags.acls.isSome()) {
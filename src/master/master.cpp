@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <deque>
 #include <fstream>
 #include <iomanip>
 #include <list>
@@ -57,9 +58,11 @@
 #include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 #include <stout/utils.hpp>
 #include <stout/uuid.hpp>
+#include <stout/version.hpp>
 
 #include "authentication/cram_md5/authenticator.hpp"
 
@@ -79,6 +82,8 @@
 
 #include "master/flags.hpp"
 #include "master/master.hpp"
+#include "master/repairer.hpp"
+#include "master/snapshot.hpp"
 
 #include "module/manager.hpp"
 
@@ -92,9 +97,12 @@ using std::vector;
 using process::await;
 using process::wait; // Necessary on some OS's to disambiguate.
 using process::Clock;
+using process::Event;
 using process::ExitedEvent;
 using process::Failure;
 using process::Future;
+using process::HttpEvent;
+using process::Lazy;
 using process::MessageEvent;
 using process::Owned;
 using process::PID;
@@ -107,6 +115,7 @@ using process::Timer;
 using process::UPID;
 
 using process::metrics::Counter;
+using process::metrics::Histogram;
 
 namespace mesos {
 namespace internal {
@@ -118,120 +127,251 @@ using mesos::master::RoleInfo;
 using mesos::master::allocator::Allocator;
 
 
+// Checks the health of all the registered slaves from a single
+// process (rather than a process and a timer per slave). Each slave
+// gets pinged every SLAVE_PING_TIMEOUT and is shut down (rate
+// limited) after MAX_SLAVE_PING_TIMEOUTS consecutive pings without a
+// pong. Since every slave is pinged at the same interval the next
+// pings are due in the order the previous pings were sent, hence the
+// due pings are simply queued and a single timer is used for the
+// earliest of them. All pings that are due within the
+// SLAVE_PING_BATCH_WINDOW get sent together.
 class SlaveObserver : public Process<SlaveObserver>
 {
 public:
-  SlaveObserver(const UPID& _slave,
-                const SlaveInfo& _slaveInfo,
-                const SlaveID& _slaveId,
-                const PID<Master>& _master,
+  SlaveObserver(const PID<Master>& _master,
                 const Option<shared_ptr<RateLimiter>>& _limiter,
                 const shared_ptr<Metrics> _metrics)
     : ProcessBase(process::ID::generate("slave-observer")),
-      slave(_slave),
-      slaveInfo(_slaveInfo),
-      slaveId(_slaveId),
       master(_master),
       limiter(_limiter),
-      metrics(_metrics),
-      timeouts(0),
-      pinged(false),
-      connected(true)
+      metrics(_metrics)
   {
     // TODO(vinod): Deprecate this handler in 0.22.0 in favor of a
     // new PongSlaveMessage handler.
     install("PONG", &SlaveObserver::pong);
   }
 
-  void reconnect()
+  void add(const SlaveID& slaveId, const UPID& pid)
   {
-    connected = true;
+    // Start over if the slave is already observed.
+    remove(slaveId);
+
+    Observed slave;
+    slave.slaveId = slaveId;
+    slave.pid = pid;
+    slave.timeouts = 0;
+    slave.pinged = false;
+    slave.connected = true;
+
+    indices[slaveId] = slaves.size();
+    pids[pid] = slaves.size();
+    slaves.push_back(slave);
+
+    ping(slaves.size() - 1, Clock::now());
+    schedule();
+  }
+
+  void remove(const SlaveID& slaveId)
+  {
+    if (!indices.contains(slaveId)) {
+      return;
+    }
+
+    // Fill the gap with the last slave to keep 'slaves' compact.
+    // NOTE: Any due ping of the removed slave is skipped once it
+    // reaches the front of the queue.
+    const size_t index = indices[slaveId];
+
+    indices.erase(slaveId);
+    pids.erase(slaves[index].pid);
+
+    if (index != slaves.size() - 1) {
+      slaves[index] = slaves.back();
+      indices[slaves[index].slaveId] = index;
+      pids[slaves[index].pid] = index;
+    }
+
+    slaves.pop_back();
   }
 
-  void disconnect()
+  void reconnect(const SlaveID& slaveId)
   {
-    connected = false;
+    if (indices.contains(slaveId)) {
+      slaves[indices[slaveId]].connected = true;
+    }
   }
 
-protected:
-  virtual void initialize()
+  void disconnect(const SlaveID& slaveId)
   {
-    ping();
+    if (indices.contains(slaveId)) {
+      slaves[indices[slaveId]].connected = false;
+    }
   }
 
-  void ping()
+private:
+  struct Observed
   {
+    SlaveID slaveId;
+    UPID pid;
+    Time sent; // When the last ping was sent.
+    Time due;  // When the next ping is due.
+    Option<Future<Nothing>> shuttingDown;
+    uint32_t timeouts;
+    bool pinged;
+    bool connected;
+  };
+
+  void ping(size_t index, const Time& now)
+  {
+    Observed& slave = slaves[index];
+
     // TODO(vinod): In 0.22.0, master should send the PingSlaveMessage
     // instead of sending "PING" with the encoded PingSlaveMessage.
     // Currently we do not do this for backwards compatibility with
     // slaves on 0.20.0.
     PingSlaveMessage message;
-    message.set_connected(connected);
+    message.set_connected(slave.connected);
     string data;
     CHECK(message.SerializeToString(&data));
-    send(slave, "PING", data.data(), data.size());
+    send(slave.pid, "PING", data.data(), data.size());
 
-    pinged = true;
-    delay(SLAVE_PING_TIMEOUT, self(), &SlaveObserver::timeout);
+    slave.pinged = true;
+    slave.sent = now;
+    slave.due = now + SLAVE_PING_TIMEOUT;
+
+    due.push_back(std::make_pair(slave.due, slave.slaveId));
   }
 
   void pong(const UPID& from, const string& body)
   {
-    timeouts = 0;
-    pinged = false;
+    if (!pids.contains(from)) {
+      return;
+    }
+
+    Observed& slave = slaves[pids[from]];
+
+    if (slave.pinged) {
+      metrics->slave_ping_rtt.record(Clock::now() - slave.sent);
+    }
+
+    slave.timeouts = 0;
+    slave.pinged = false;
+
+    if (!body.empty()) {
+      // The pong of a slave that summarizes the resource usage of
+      // its executors, see 'Slave::summarize()'.
+      PongSlaveMessage message;
+      if (!message.ParseFromString(body)) {
+        LOG(WARNING) << "Ignoring invalid pong from " << from;
+      } else if (message.has_usage()) {
+        dispatch(master, &Master::updateUsage, slave.slaveId, message.usage());
+      }
+    }
 
     // Cancel any pending shutdown.
-    if (shuttingDown.isSome()) {
+    if (slave.shuttingDown.isSome()) {
       // Need a copy for non-const access.
-      Future<Nothing> future = shuttingDown.get();
+      Future<Nothing> future = slave.shuttingDown.get();
       future.discard();
     }
   }
 
+  // Returns true if the due ping is for a slave that has since been
+  // removed or pinged.
+  bool stale(const std::pair<Time, SlaveID>& ping)
+  {
+    return !indices.contains(ping.second) ||
+      slaves[indices[ping.second]].due != ping.first;
+  }
+
+  // Sets the timer for the earliest due ping, if necessary.
+  void schedule()
+  {
+    while (!due.empty() && stale(due.front())) {
+      due.pop_front();
+    }
+
+    if (timer.isNone() && !due.empty()) {
+      timer = delay(
+          due.front().first - Clock::now(), self(), &SlaveObserver::timeout);
+    }
+  }
+
   void timeout()
   {
-    if (pinged) {
-      timeouts++; // No pong has been received before the timeout.
-      if (timeouts >= MAX_SLAVE_PING_TIMEOUTS) {
-        // No pong has been received for the last
-        // 'MAX_SLAVE_PING_TIMEOUTS' pings.
-        shutdown();
+    timer = None();
+
+    const Time now = Clock::now();
+
+    while (!due.empty() &&
+           due.front().first <= now + SLAVE_PING_BATCH_WINDOW) {
+      const std::pair<Time, SlaveID> ping = due.front();
+      due.pop_front();
+
+      if (stale(ping)) {
+        continue;
       }
+
+      const size_t index = indices[ping.second];
+
+      if (slaves[index].pinged) {
+        // No pong has been received before the timeout.
+        if (++slaves[index].timeouts >= MAX_SLAVE_PING_TIMEOUTS) {
+          // No pong has been received for the last
+          // 'MAX_SLAVE_PING_TIMEOUTS' pings.
+          shutdown(index);
+        }
+      }
+
+      // NOTE: We keep pinging even if we schedule a shutdown. This is
+      // because if the slave eventually responds to a ping, we can
+      // cancel the shutdown.
+      this->ping(index, now);
     }
 
-    // NOTE: We keep pinging even if we schedule a shutdown. This is
-    // because if the slave eventually responds to a ping, we can
-    // cancel the shutdown.
-    ping();
+    schedule();
   }
 
   // NOTE: The shutdown of the slave is rate limited and can be
   // canceled if a pong was received before the actual shutdown is
   // called.
-  void shutdown()
+  void shutdown(size_t index)
   {
-    if (shuttingDown.isSome()) {
+    Observed& slave = slaves[index];
+
+    if (slave.shuttingDown.isSome()) {
       return;  // Shutdown is already in progress.
     }
 
     Future<Nothing> acquire = Nothing();
 
     if (limiter.isSome()) {
-      LOG(INFO) << "Scheduling shutdown of slave " << slaveId
+      LOG(INFO) << "Scheduling shutdown of slave " << slave.slaveId
                 << " due to health check timeout";
 
       acquire = limiter.get()->acquire();
     }
 
-    shuttingDown = acquire.onAny(defer(self(), &Self::_shutdown));
+    slave.shuttingDown = acquire.onAny(
+        defer(self(), &Self::_shutdown, slave.slaveId, lambda::_1));
+
     ++metrics->slave_shutdowns_scheduled;
   }
 
-  void _shutdown()
+  void _shutdown(const SlaveID& slaveId, const Future<Nothing>& future)
   {
-    CHECK_SOME(shuttingDown);
+    // The slave might have been removed (and even added again) in
+    // the mean time.
+    if (!indices.contains(slaveId)) {
+      return;
+    }
+
+    Observed& slave = slaves[indices[slaveId]];
 
-    const Future<Nothing>& future = shuttingDown.get();
+    if (slave.shuttingDown.isNone() || slave.shuttingDown.get() != future) {
+      return;
+    }
 
     CHECK(!future.isFailed());
 
@@ -252,20 +392,22 @@ protected:
       ++metrics->slave_shutdowns_canceled;
     }
 
-    shuttingDown = None();
+    slave.shuttingDown = None();
   }
 
-private:
-  const UPID slave;
-  const SlaveInfo slaveInfo;
-  const SlaveID slaveId;
   const PID<Master> master;
   const Option<shared_ptr<RateLimiter>> limiter;
   shared_ptr<Metrics> metrics;
-  Option<Future<Nothing>> shuttingDown;
-  uint32_t timeouts;
-  bool pinged;
-  bool connected;
+
+  // The observed slaves, indexed by ID and by PID (for pongs).
+  vector<Observed> slaves;
+  hashmap<SlaveID, size_t> indices;
+  hashmap<UPID, size_t> pids;
+
+  // The due pings (in the order they are due) and the timer for the
+  // earliest of them, if any.
+  std::deque<std::pair<Time, SlaveID>> due;
+  Option<Timer> timer;
 };
 
 
@@ -290,7 +432,12 @@ Master::Master(
     authorizer(_authorizer),
     authenticator(None()),
     metrics(new Metrics(*this)),
-    electedTime(None())
+    electedTime(None()),
+    version(0),
+    reading(false),
+    snapshots(NULL),
+    observer(NULL),
+    tracer(_flags.trace_sampling_rate)
 {
   slaves.limiter = _slaveRemovalLimiter;
 
@@ -343,14 +490,41 @@ Master::~Master() {}
 // capacity is reached.
 struct BoundedRateLimiter
 {
-  BoundedRateLimiter(double qps, Option<uint64_t> _capacity)
+  BoundedRateLimiter(
+      double qps,
+      Option<uint64_t> _capacity,
+      const google::protobuf::RepeatedPtrField<RateLimit::Weight>& _weights)
     : limiter(new process::RateLimiter(qps)),
       capacity(_capacity),
-      messages(0) {}
+      messages(0)
+  {
+    foreach (const RateLimit::Weight& weight, _weights) {
+      weights[weight.message()] = weight.weight();
+    }
+  }
+
+  // Returns a future that becomes ready once as many permits as the
+  // weight of the message named 'name' are acquired. Since permits
+  // are given out in order, the messages are still processed in the
+  // order they were received.
+  process::Future<Nothing> acquire(const string& name)
+  {
+    const uint32_t weight = weights.contains(name) ? weights[name] : 1;
+
+    process::Future<Nothing> acquired = limiter->acquire();
+    for (uint32_t i = 1; i < weight; i++) {
+      acquired = limiter->acquire();
+    }
+
+    return acquired;
+  }
 
   process::Owned<process::RateLimiter> limiter;
   const Option<uint64_t> capacity;
 
+  // Weights of the messages by their names, see 'RateLimit.weights'.
+  hashmap<string, uint32_t> weights;
+
   // Number of outstanding messages for this RateLimiter.
   // NOTE: ExitedEvents are throttled but not counted towards
   // the capacity here.
@@ -364,6 +538,9 @@ void Master::initialize()
             << " started on " << string(self()).substr(7);
   LOG(INFO) << "Flags at startup: " << flags;
 
+  // Sample the latencies of the message handlers, see 'Metrics'.
+  instrument("master/messages/", MESSAGE_LATENCY_SAMPLING);
+
   if (process::address().ip.isLoopback()) {
     LOG(WARNING) << "\n**************************************************\n"
                  << "Master bound to loopback interface!"
@@ -405,6 +582,32 @@ void Master::initialize()
             << "Must be within [0%-100%]";
   }
 
+  if (flags.completed_tasks_dir.isSome()) {
+    Try<shared_ptr<TaskStore>> store = TaskStore::create(
+        flags.completed_tasks_dir.get(),
+        MAX_COMPLETED_TASKS_PER_FRAMEWORK);
+
+    if (store.isError()) {
+      EXIT(1) << "Failed to create the completed tasks store: "
+              << store.error() << " (see --completed_tasks_dir flag)";
+    }
+
+    completedTaskStore = store.get();
+  }
+
+  if (flags.event_history_dir.isSome()) {
+    Try<shared_ptr<EventHistory>> history = EventHistory::create(
+        flags.event_history_dir.get(),
+        flags.event_history_capacity);
+
+    if (history.isError()) {
+      EXIT(1) << "Failed to create the event history: "
+              << history.error() << " (see --event_history_dir flag)";
+    }
+
+    eventHistory = history.get();
+  }
+
   // Log authentication state.
   if (flags.authenticate_frameworks) {
     LOG(INFO) << "Master only allowing authenticated frameworks to register";
@@ -453,7 +656,8 @@ void Master::initialize()
   if (authenticatorNames[0] == DEFAULT_AUTHENTICATOR) {
     LOG(INFO) << "Using default '" << DEFAULT_AUTHENTICATOR
               << "' authenticator";
-    authenticator = new cram_md5::CRAMMD5Authenticator();
+    authenticator =
+      new cram_md5::CRAMMD5Authenticator(flags.authentication_tickets);
   } else {
     Try<Authenticator*> module =
       modules::ModuleManager::create<Authenticator>(authenticatorNames[0]);
@@ -504,6 +708,13 @@ void Master::initialize()
                 << ". It must be a positive number";
       }
 
+      foreach (const RateLimit::Weight& weight, limit_.weights()) {
+        if (weight.weight() == 0) {
+          EXIT(1) << "Invalid weight for " << weight.message()
+                  << ". It must be a positive number";
+        }
+      }
+
       if (limit_.has_qps()) {
         Option<uint64_t> capacity;
         if (limit_.has_capacity()) {
@@ -512,7 +723,8 @@ void Master::initialize()
         frameworks.limiters.put(
             limit_.principal(),
             Owned<BoundedRateLimiter>(
-                new BoundedRateLimiter(limit_.qps(), capacity)));
+                new BoundedRateLimiter(
+                    limit_.qps(), capacity, limit_.weights())));
       } else {
         frameworks.limiters.put(limit_.principal(), None());
       }
@@ -525,6 +737,14 @@ void Master::initialize()
               << ". It must be a positive number";
     }
 
+    foreach (const RateLimit::Weight& weight,
+             flags.rate_limits.get().aggregate_default_weights()) {
+      if (weight.weight() == 0) {
+        EXIT(1) << "Invalid weight for " << weight.message()
+                << ". It must be a positive number";
+      }
+    }
+
     if (flags.rate_limits.get().has_aggregate_default_qps()) {
       Option<uint64_t> capacity;
       if (flags.rate_limits.get().has_aggregate_default_capacity()) {
@@ -532,7 +752,9 @@ void Master::initialize()
       }
       frameworks.defaultLimiter = Owned<BoundedRateLimiter>(
           new BoundedRateLimiter(
-              flags.rate_limits.get().aggregate_default_qps(), capacity));
+              flags.rate_limits.get().aggregate_default_qps(),
+              capacity,
+              flags.rate_limits.get().aggregate_default_weights()));
     }
 
     LOG(INFO) << "Framework rate limiting enabled";
@@ -545,6 +767,39 @@ void Master::initialize()
               << flags.slave_removal_rate_limit.get();
   }
 
+  if (flags.slave_registration_rate_limit.isSome()) {
+    const string& limit = flags.slave_registration_rate_limit.get();
+
+    vector<string> tokens = strings::tokenize(limit, "/");
+    if (tokens.size() != 2) {
+      EXIT(1) << "Invalid slave_registration_rate_limit: " << limit
+              << ". Format is <Number of slaves>/<Duration>";
+    }
+
+    Try<int> permits = numify<int>(tokens[0]);
+    if (permits.isError() || permits.get() <= 0) {
+      EXIT(1) << "Invalid slave_registration_rate_limit: " << limit
+              << ". Format is <Number of slaves>/<Duration>"
+              << (permits.isError() ? ": " + permits.error() : "");
+    }
+
+    Try<Duration> duration = Duration::parse(tokens[1]);
+    if (duration.isError()) {
+      EXIT(1) << "Invalid slave_registration_rate_limit: " << limit
+              << ". Format is <Number of slaves>/<Duration>"
+              << ": " << duration.error();
+    }
+
+    Slaves::Admission admission;
+    admission.interval = duration.get() / permits.get();
+    admission.window = duration.get();
+    admission.next = Clock::now();
+
+    slaves.admission = admission;
+
+    LOG(INFO) << "Slave (re-)registration is rate limited to " << limit;
+  }
+
   hashmap<string, RoleInfo> roleInfos;
 
   // Add the default role.
@@ -617,6 +872,9 @@ void Master::initialize()
       lambda::bind(&Allocator::updateWhitelist, allocator, lambda::_1));
   spawn(whitelistWatcher);
 
+  observer = new SlaveObserver(self(), slaves.limiter, metrics);
+  spawn(observer);
+
   nextFrameworkId = 0;
   nextSlaveId = 0;
   nextOfferId = 0;
@@ -663,11 +921,20 @@ void Master::initialize()
       &Master::reviveOffers,
       &ReviveOffersMessage::framework_id);
 
+  install<SuppressOffersMessage>(
+      &Master::suppressOffers,
+      &SuppressOffersMessage::framework_id);
+
   install<KillTaskMessage>(
       &Master::killTask,
       &KillTaskMessage::framework_id,
       &KillTaskMessage::task_id);
 
+  install<KillTasksMessage>(
+      &Master::killTasks,
+      &KillTasksMessage::framework_id,
+      &KillTasksMessage::task_ids);
+
   install<StatusUpdateAcknowledgementMessage>(
       &Master::statusUpdateAcknowledgement,
       &StatusUpdateAcknowledgementMessage::slave_id,
@@ -675,6 +942,17 @@ void Master::initialize()
       &StatusUpdateAcknowledgementMessage::task_id,
       &StatusUpdateAcknowledgementMessage::uuid);
 
+  install<StatusUpdateAcknowledgementsMessage>(
+      &Master::statusUpdateAcknowledgements,
+      &StatusUpdateAcknowledgementsMessage::acknowledgements);
+
+  install<ExecutorToFrameworkMessage>(
+      &Master::executorMessage,
+      &ExecutorToFrameworkMessage::slave_id,
+      &ExecutorToFrameworkMessage::framework_id,
+      &ExecutorToFrameworkMessage::executor_id,
+      &ExecutorToFrameworkMessage::data);
+
   install<FrameworkToExecutorMessage>(
       &Master::schedulerMessage,
       &FrameworkToExecutorMessage::slave_id,
@@ -688,14 +966,7 @@ void Master::initialize()
       &RegisterSlaveMessage::checkpointed_resources,
       &RegisterSlaveMessage::version);
 
-  install<ReregisterSlaveMessage>(
-      &Master::reregisterSlave,
-      &ReregisterSlaveMessage::slave,
-      &ReregisterSlaveMessage::checkpointed_resources,
-      &ReregisterSlaveMessage::executor_infos,
-      &ReregisterSlaveMessage::tasks,
-      &ReregisterSlaveMessage::completed_frameworks,
-      &ReregisterSlaveMessage::version);
+  install<ReregisterSlaveMessage>(&Master::reregisterSlave);
 
   install<UnregisterSlaveMessage>(
       &Master::unregisterSlave,
@@ -706,6 +977,10 @@ void Master::initialize()
       &StatusUpdateMessage::update,
       &StatusUpdateMessage::pid);
 
+  install<StatusUpdatesMessage>(
+      &Master::statusUpdates,
+      &StatusUpdatesMessage::updates);
+
   install<ReconcileTasksMessage>(
       &Master::reconcileTasks,
       &ReconcileTasksMessage::framework_id,
@@ -730,6 +1005,29 @@ void Master::initialize()
   // Setup HTTP routes.
   Http http = Http(this);
 
+  if (flags.http_snapshot_interval.isSome()) {
+    const PID<Master> pid = self();
+
+    // NOTE: Snapshots are taken by the master, but rendering the
+    // responses from a snapshot is left to the snapshot process.
+    snapshots = new SnapshotProcess(
+        flags.http_snapshot_interval.get(),
+        [pid, http]() {
+          return dispatch(
+              pid,
+              std::function<shared_ptr<const Snapshot>()>(
+                  [http]() { return http.snapshot(); }));
+        });
+
+    spawn(snapshots);
+  }
+
+  route("/events",
+        Http::EVENTS_HELP,
+        [http](const http::Request& request) {
+          Http::log(request);
+          return http.events(request);
+        });
   route("/health",
         Http::HEALTH_HELP,
         [http](const http::Request& request) {
@@ -752,6 +1050,12 @@ void Master::initialize()
           Http::log(request);
           return http.roles(request);
         });
+  route("/api/v1/scheduler",
+        Http::SCHEDULER_HELP,
+        [http](const http::Request& request) {
+          Http::log(request);
+          return http.scheduler(request);
+        });
 
   // TODO(vinod): "/shutdown" endpoint is deprecated in favor of
   // "/teardown". Remove this endpoint in 0.24.0.
@@ -792,6 +1096,24 @@ void Master::initialize()
           Http::log(request);
           return http.tasks(request);
         });
+  route("/utilization",
+        Http::UTILIZATION_HELP,
+        [http](const http::Request& request) {
+          Http::log(request);
+          return http.utilization(request);
+        });
+  route("/memory",
+        Http::MEMORY_HELP,
+        [http](const http::Request& request) {
+          Http::log(request);
+          return http.memory(request);
+        });
+  route("/trace",
+        Http::TRACE_HELP,
+        [http](const http::Request& request) {
+          Http::log(request);
+          return http.trace(request);
+        });
 
   // Provide HTTP assets from a "webui" directory. This is either
   // specified via flags (which is necessary for running out of the
@@ -869,11 +1191,6 @@ void Master::finalize()
       removeOffer(offer);
     }
 
-    // Terminate the slave observer.
-    terminate(slave->observer);
-    wait(slave->observer);
-
-    delete slave->observer;
     delete slave;
   }
   slaves.registered.clear();
@@ -928,6 +1245,17 @@ void Master::finalize()
     Clock::cancel(slaves.recoveredTimer.get());
   }
 
+  terminate(observer);
+  wait(observer);
+  delete observer;
+
+  if (snapshots != NULL) {
+    terminate(snapshots);
+    wait(snapshots);
+    delete snapshots;
+    snapshots = NULL;
+  }
+
   terminate(whitelistWatcher);
   wait(whitelistWatcher);
   delete whitelistWatcher;
@@ -938,42 +1266,65 @@ void Master::finalize()
 }
 
 
-void Master::exited(const UPID& pid)
+void Master::exited(const FrameworkID& frameworkId, const HttpConnection& http)
 {
-  foreachvalue (Framework* framework, frameworks.registered) {
-    if (framework->pid == pid) {
-      LOG(INFO) << "Framework " << *framework << " disconnected";
-
-      // Disconnect the framework.
-      disconnect(framework);
-
-      // Set 'failoverTimeout' to the default and update only if the
-      // input is valid.
-      Try<Duration> failoverTimeout_ =
-        Duration::create(FrameworkInfo().failover_timeout());
-      CHECK_SOME(failoverTimeout_);
-      Duration failoverTimeout = failoverTimeout_.get();
-
-      failoverTimeout_ =
-        Duration::create(framework->info.failover_timeout());
-      if (failoverTimeout_.isSome()) {
-        failoverTimeout = failoverTimeout_.get();
-      } else {
-        LOG(WARNING) << "Using the default value for 'failover_timeout' because"
-                     << "the input value is invalid: "
-                     << failoverTimeout_.error();
-      }
+  Framework* framework = getFramework(frameworkId);
 
-      LOG(INFO) << "Giving framework " << *framework << " "
-                << failoverTimeout << " to failover";
+  // Ignore the closure of a connection that the framework already
+  // replaced (i.e., failed over) or of a removed framework.
+  if (framework == NULL ||
+      framework->http.isNone() ||
+      framework->http.get().streamId != http.streamId) {
+    return;
+  }
 
-      // Delay dispatching a message to ourselves for the timeout.
-      delay(failoverTimeout,
-          self(),
-          &Master::frameworkFailoverTimeout,
-          framework->id(),
-          framework->reregisteredTime);
+  _exited(framework);
+}
+
+
+void Master::_exited(Framework* framework)
+{
+  CHECK_NOTNULL(framework);
+
+  LOG(INFO) << "Framework " << *framework << " disconnected";
+
+  // Disconnect the framework.
+  disconnect(framework);
+
+  // Set 'failoverTimeout' to the default and update only if the
+  // input is valid.
+  Try<Duration> failoverTimeout_ =
+    Duration::create(FrameworkInfo().failover_timeout());
+  CHECK_SOME(failoverTimeout_);
+  Duration failoverTimeout = failoverTimeout_.get();
+
+  failoverTimeout_ =
+    Duration::create(framework->info.failover_timeout());
+  if (failoverTimeout_.isSome()) {
+    failoverTimeout = failoverTimeout_.get();
+  } else {
+    LOG(WARNING) << "Using the default value for 'failover_timeout' because"
+                 << "the input value is invalid: "
+                 << failoverTimeout_.error();
+  }
+
+  LOG(INFO) << "Giving framework " << *framework << " "
+            << failoverTimeout << " to failover";
 
+  // Delay dispatching a message to ourselves for the timeout.
+  delay(failoverTimeout,
+      self(),
+      &Master::frameworkFailoverTimeout,
+      framework->id(),
+      framework->reregisteredTime);
+}
+
+
+void Master::exited(const UPID& pid)
+{
+  foreachvalue (Framework* framework, frameworks.registered) {
+    if (framework->http.isNone() && framework->pid == pid) {
+      _exited(framework);
       return;
     }
   }
@@ -1106,7 +1457,7 @@ void Master::visit(const MessageEvent& event)
     if (limiter->capacity.isNone() ||
         limiter->messages < limiter->capacity.get()) {
       limiter->messages++;
-      limiter->limiter->acquire()
+      limiter->acquire(event.message->name)
         .onReady(defer(self(), &Self::throttled, event, principal));
     } else {
       exceededCapacity(
@@ -1122,7 +1473,7 @@ void Master::visit(const MessageEvent& event)
         frameworks.defaultLimiter.get()->messages <
           frameworks.defaultLimiter.get()->capacity.get()) {
       frameworks.defaultLimiter.get()->messages++;
-      frameworks.defaultLimiter.get()->limiter->acquire()
+      frameworks.defaultLimiter.get()->acquire(event.message->name)
         .onReady(defer(self(), &Self::throttled, event, None()));
     } else {
       exceededCapacity(
@@ -1136,6 +1487,29 @@ void Master::visit(const MessageEvent& event)
 }
 
 
+void Master::serve(const Event& event)
+{
+  reading = false;
+
+  Process<Master>::serve(event);
+
+  if (!reading) {
+    ++version;
+  }
+}
+
+
+void Master::visit(const HttpEvent& event)
+{
+  // A request with a safe method only reads the state: the handlers
+  // that do change it (e.g., /master/teardown) require a POST, or do
+  // so in a continuation, which is an event of its own.
+  reading = event.request->method == "GET" || event.request->method == "HEAD";
+
+  Process<Master>::visit(event);
+}
+
+
 void Master::visit(const ExitedEvent& event)
 {
   // See comments in 'visit(const MessageEvent& event)' for which
@@ -1241,6 +1615,12 @@ void Master::_visit(const ExitedEvent& event)
 }
 
 
+string Master::etag() const
+{
+  return "\"" + info_.id() + "-" + stringify(version) + "\"";
+}
+
+
 void fail(const string& message, const string& failure)
 {
   LOG(FATAL) << message << ": " << failure;
@@ -1266,8 +1646,12 @@ Future<Nothing> Master::recover()
 
 Future<Nothing> Master::_recover(const Registry& registry)
 {
+  const int total = registry.slaves().slaves().size();
+
+  slaves.recovered.reserve(total);
+
   foreach (const Registry::Slave& slave, registry.slaves().slaves()) {
-    slaves.recovered.insert(slave.info().id());
+    slaves.recovered[slave.info().id()] = slave.info().hostname();
   }
 
   // Set up a timeout for slaves to re-register. This timeout is based
@@ -1278,10 +1662,10 @@ Future<Nothing> Master::_recover(const Registry& registry)
     delay(flags.slave_reregister_timeout,
           self(),
           &Self::recoveredSlavesTimeout,
-          registry);
+          total);
 
   // Recovery is now complete!
-  LOG(INFO) << "Recovered " << registry.slaves().slaves().size() << " slaves"
+  LOG(INFO) << "Recovered " << total << " slaves"
             << " from the Registry (" << Bytes(registry.ByteSize()) << ")"
             << " ; allowing " << flags.slave_reregister_timeout
             << " for slaves to re-register";
@@ -1290,7 +1674,7 @@ Future<Nothing> Master::_recover(const Registry& registry)
 }
 
 
-void Master::recoveredSlavesTimeout(const Registry& registry)
+void Master::recoveredSlavesTimeout(int total)
 {
   CHECK(elected());
 
@@ -1309,7 +1693,7 @@ void Master::recoveredSlavesTimeout(const Registry& registry)
   // safety-net limit, bail!
   double removalPercentage =
     (1.0 * slaves.recovered.size()) /
-    (1.0 * registry.slaves().slaves().size());
+    (1.0 * total);
 
   if (removalPercentage > limit) {
     EXIT(1) << "Post-recovery slave removal limit exceeded! After "
@@ -1317,18 +1701,20 @@ void Master::recoveredSlavesTimeout(const Registry& registry)
             << " there were " << slaves.recovered.size()
             << " (" << removalPercentage * 100 << "%) slaves recovered from the"
             << " registry that did not re-register: \n"
-            << stringify(slaves.recovered) << "\n "
+            << stringify(slaves.recovered.keys()) << "\n "
             << " The configured removal limit is " << limit * 100 << "%. Please"
             << " investigate or increase this limit to proceed further";
   }
 
   // Remove the slaves in a rate limited manner, similar to how the
-  // SlaveObserver removes slaves.
-  foreach (const Registry::Slave& slave, registry.slaves().slaves()) {
-    // The slave is removed from 'recovered' when it re-registers.
-    if (!slaves.recovered.contains(slave.info().id())) {
-      continue;
-    }
+  // SlaveObserver removes slaves. The removals are dispatched, so the
+  // slaves are only removed from 'recovered' once we're done here.
+  foreachpair (const SlaveID& slaveId,
+               const string& hostname,
+               slaves.recovered) {
+    Registry::Slave slave;
+    slave.mutable_info()->mutable_id()->CopyFrom(slaveId);
+    slave.mutable_info()->set_hostname(hostname);
 
     Future<Nothing> acquire = Nothing();
 
@@ -1407,6 +1793,13 @@ Nothing Master::removeSlave(const Registry::Slave& slave)
 }
 
 
+bool Master::overloaded()
+{
+  return flags.max_event_queue_age.isSome() &&
+         eventAge() > flags.max_event_queue_age.get();
+}
+
+
 void Master::fileAttached(const Future<Nothing>& result, const string& path)
 {
   if (result.isReady()) {
@@ -1540,11 +1933,37 @@ Future<Option<Error>> Master::validate(
     }
   }
 
+  return validate(frameworkInfo);
+}
+
+
+Future<Option<Error>> Master::validate(const FrameworkInfo& frameworkInfo)
+{
   // TODO(vinod): Deprecate this in favor of ACLs.
   if (!roles.contains(frameworkInfo.role())) {
     return Error("Role '" + frameworkInfo.role() + "' is invalid");
   }
 
+  foreach (const FrameworkInfo::TaskShape& shape,
+           frameworkInfo.task_shapes()) {
+    if (shape.resources().size() == 0) {
+      return Error("Task shapes must not be empty");
+    }
+
+    Option<Error> error = Resources::validate(shape.resources());
+    if (error.isSome()) {
+      return Error("Invalid task shape: " + error.get().message);
+    }
+
+    foreach (const Resource& resource, shape.resources()) {
+      if (resource.type() != Value::SCALAR ||
+          resource.scalar().value() <= 0) {
+        return Error(
+            "Task shapes must consist of positive scalar resources");
+      }
+    }
+  }
+
   if (authorizer.isNone()) {
     // Authorization is disabled.
     return None();
@@ -1584,6 +2003,18 @@ void Master::drop(
 }
 
 
+void Master::drop(
+    Framework* framework,
+    const scheduler::Call& call,
+    const string& message)
+{
+  // TODO(bmahler): Increment a metric.
+
+  LOG(ERROR) << "Dropping " << call.type() << " call"
+             << " from framework " << *framework << ": " << message;
+}
+
+
 void Master::drop(
     Framework* framework,
     const Offer::Operation& operation,
@@ -1634,19 +2065,42 @@ void Master::receive(
     return;
   }
 
+  receive(framework, call);
+}
+
+
+void Master::receive(
+    Framework* framework,
+    const scheduler::Call& call)
+{
+  CHECK_NOTNULL(framework);
+
   // TODO(jieyu): Validate frameworkInfo to make sure it's the same as
   // the one that the framework used during registration and that the
   // framework id is set and non-empty except for SUBSCRIBE call.
 
   switch (call.type()) {
     case scheduler::Call::REVIVE:
+      LOG(INFO) << "Reviving offers for framework " << *framework;
+      allocator->reviveOffers(framework->id());
+      break;
+
+    case scheduler::Call::SUPPRESS:
+      LOG(INFO) << "Suppressing offers for framework " << *framework;
+      allocator->suppressOffers(framework->id());
+      break;
+
     case scheduler::Call::DECLINE:
-      drop(from, call, "Unimplemented");
+      if (!call.has_decline()) {
+        drop(framework, call, "Expecting 'decline' to be present");
+        return;
+      }
+      decline(framework, call.decline());
       break;
 
     case scheduler::Call::ACCEPT:
       if (!call.has_accept()) {
-        drop(from, call, "Expecting 'accept' to be present");
+        drop(framework, call, "Expecting 'accept' to be present");
         return;
       }
       accept(framework, call.accept());
@@ -1654,7 +2108,7 @@ void Master::receive(
 
     case scheduler::Call::RECONCILE:
       if (!call.has_reconcile()) {
-        drop(from, call, "Expecting 'reconcile' to be present");
+        drop(framework, call, "Expecting 'reconcile' to be present");
         return;
       }
       reconcile(framework, call.reconcile());
@@ -1662,21 +2116,44 @@ void Master::receive(
 
     case scheduler::Call::SHUTDOWN:
       if (!call.has_shutdown()) {
-        drop(from, call, "Expecting 'shutdown' to be present");
+        drop(framework, call, "Expecting 'shutdown' to be present");
+        return;
       }
       shutdown(framework, call.shutdown());
       break;
 
     case scheduler::Call::KILL:
       if (!call.has_kill()) {
-        drop(from, call, "Expecting 'kill' to be present");
+        drop(framework, call, "Expecting 'kill' to be present");
+        return;
       }
       kill(framework, call.kill());
       break;
 
     case scheduler::Call::ACKNOWLEDGE:
+      if (!call.has_acknowledge()) {
+        drop(framework, call, "Expecting 'acknowledge' to be present");
+        return;
+      }
+      metrics->messages_status_update_acknowledgement++;
+      acknowledge(
+          framework,
+          call.acknowledge().slave_id(),
+          call.acknowledge().task_id(),
+          call.acknowledge().uuid());
+      break;
+
     case scheduler::Call::MESSAGE:
-      drop(from, call, "Unimplemented");
+      if (!call.has_message()) {
+        drop(framework, call, "Expecting 'message' to be present");
+        return;
+      }
+      ++metrics->messages_framework_to_executor;
+      message(
+          framework,
+          call.message().slave_id(),
+          call.message().executor_id(),
+          call.message().data());
       break;
 
     case scheduler::Call::TEARDOWN:
@@ -1684,59 +2161,213 @@ void Master::receive(
       break;
 
     default:
-      drop(from, call, "Unknown call type");
+      drop(framework, call, "Unknown call type");
       break;
   }
 }
 
 
-void Master::registerFramework(
-    const UPID& from,
+void Master::subscribe(
+    const HttpConnection& http,
     const FrameworkInfo& frameworkInfo)
 {
-  ++metrics->messages_register_framework;
-
-  if (authenticating.contains(from)) {
-    // TODO(vinod): Consider dropping this request and fix the tests
-    // to deal with the drop. Currently there is a race between master
-    // realizing the framework is authenticated and framework sending
-    // a registration request. Dropping this message will cause the
-    // framework to retry slowing down the tests.
-    LOG(INFO) << "Queuing up registration request for"
-              << " framework '" << frameworkInfo.name() << "' at " << from
-              << " because authentication is still in progress";
-
-    authenticating[from]
-      .onReady(defer(self(), &Self::registerFramework, from, frameworkInfo));
-    return;
-  }
-
-  LOG(INFO) << "Received registration request for"
-            << " framework '" << frameworkInfo.name() << "' at " << from;
+  // TODO(vinod): Add metrics for calls.
+  LOG(INFO) << "Received subscription request over HTTP for framework '"
+            << frameworkInfo.name() << "'";
 
-  validate(frameworkInfo, from)
+  validate(frameworkInfo)
     .onAny(defer(self(),
-                 &Master::_registerFramework,
-                 from,
+                 &Master::_subscribe,
+                 http,
                  frameworkInfo,
                  lambda::_1));
 }
 
 
-void Master::_registerFramework(
-    const UPID& from,
+void Master::_subscribe(
+    const HttpConnection& http,
     const FrameworkInfo& frameworkInfo,
     const Future<Option<Error>>& validationError)
 {
   CHECK_READY(validationError);
   if (validationError.get().isSome()) {
-    LOG(INFO) << "Refusing registration of framework '"
-              << frameworkInfo.name() << "' at " << from
-              << ": " << validationError.get().get().message;
+    LOG(INFO) << "Refusing subscription of framework '"
+              << frameworkInfo.name() << "': "
+              << validationError.get().get().message;
 
     FrameworkErrorMessage message;
     message.set_message(validationError.get().get().message);
-    send(from, message);
+
+    HttpConnection connection = http;
+    connection.send(message);
+    connection.close();
+    return;
+  }
+
+  if (!frameworkInfo.has_id() || frameworkInfo.id() == "") {
+    // TODO(vinod): Deprecate this in favor of authorization.
+    if (frameworkInfo.user() == "root" && !flags.root_submissions) {
+      LOG(INFO) << "Framework '" << frameworkInfo.name() << "' subscribing"
+                << " as root, but root submissions are disabled on this"
+                << " cluster";
+
+      FrameworkErrorMessage message;
+      message.set_message("User 'root' is not allowed to run frameworks");
+
+      HttpConnection connection = http;
+      connection.send(message);
+      connection.close();
+      return;
+    }
+
+    // Assign a new FrameworkID.
+    FrameworkInfo frameworkInfo_ = frameworkInfo;
+    frameworkInfo_.mutable_id()->CopyFrom(newFrameworkId());
+
+    Framework* framework = new Framework(this, frameworkInfo_, http);
+
+    LOG(INFO) << "Subscribing framework " << *framework;
+
+    addFramework(framework);
+
+    FrameworkRegisteredMessage message;
+    message.mutable_framework_id()->MergeFrom(framework->id());
+    message.mutable_master_info()->MergeFrom(info_);
+    framework->send(message);
+    return;
+  }
+
+  foreach (const shared_ptr<Framework>& framework, frameworks.completed) {
+    if (framework->id() == frameworkInfo.id()) {
+      LOG(WARNING) << "Completed framework " << *framework
+                   << " attempted to re-subscribe";
+
+      FrameworkErrorMessage message;
+      message.set_message("Completed framework attempted to re-subscribe");
+
+      HttpConnection connection = http;
+      connection.send(message);
+      connection.close();
+      return;
+    }
+  }
+
+  if (frameworks.registered.contains(frameworkInfo.id())) {
+    Framework* framework =
+      CHECK_NOTNULL(frameworks.registered[frameworkInfo.id()]);
+
+    // Only the principal of the framework may fail it over, otherwise
+    // anybody knowing the ID could take over the framework.
+    if (framework->info.principal() != frameworkInfo.principal()) {
+      LOG(WARNING) << "Refusing failover of framework " << *framework
+                   << " by principal '" << frameworkInfo.principal()
+                   << "' (expected '" << framework->info.principal() << "')";
+
+      FrameworkErrorMessage message;
+      message.set_message(
+          "Framework principal does not match the principal of the framework");
+
+      HttpConnection connection = http;
+      connection.send(message);
+      connection.close();
+      return;
+    }
+
+    // Update the framework's info fields based on those passed during
+    // re-subscription.
+    framework->updateFrameworkInfo(frameworkInfo);
+
+    framework->reregisteredTime = Clock::now();
+
+    // Unlike with a pid, every subscription is a new connection, so
+    // there are no duplicate subscriptions to be told apart.
+    LOG(INFO) << "Framework " << *framework << " failed over";
+    failoverFramework(framework, http);
+  } else {
+    // We must be a newly elected master to which either an existing
+    // scheduler or a failed-over one is connecting, see
+    // '_reregisterFramework'.
+    Framework* framework = new Framework(this, frameworkInfo, http);
+
+    // Add active tasks and executors to the framework.
+    foreachvalue (Slave* slave, slaves.registered) {
+      foreachvalue (Task* task, slave->tasks[framework->id()]) {
+        framework->addTask(task);
+      }
+      foreachvalue (const ExecutorInfo& executor,
+                    slave->executors[framework->id()]) {
+        framework->addExecutor(slave->id, executor);
+      }
+    }
+
+    LOG(INFO) << "Re-subscribing framework " << *framework;
+
+    addFramework(framework);
+
+    FrameworkRegisteredMessage message;
+    message.mutable_framework_id()->MergeFrom(framework->id());
+    message.mutable_master_info()->MergeFrom(info_);
+    framework->send(message);
+  }
+
+  // Have the slaves send the framework messages of the framework's
+  // executors to the master, which forwards them over the connection.
+  foreachvalue (Slave* slave, slaves.registered) {
+    UpdateFrameworkMessage message;
+    message.mutable_framework_id()->MergeFrom(frameworkInfo.id());
+    message.set_pid(self());
+    send(slave->pid, message);
+  }
+}
+
+
+void Master::registerFramework(
+    const UPID& from,
+    const FrameworkInfo& frameworkInfo)
+{
+  ++metrics->messages_register_framework;
+
+  if (authenticating.contains(from)) {
+    // TODO(vinod): Consider dropping this request and fix the tests
+    // to deal with the drop. Currently there is a race between master
+    // realizing the framework is authenticated and framework sending
+    // a registration request. Dropping this message will cause the
+    // framework to retry slowing down the tests.
+    LOG(INFO) << "Queuing up registration request for"
+              << " framework '" << frameworkInfo.name() << "' at " << from
+              << " because authentication is still in progress";
+
+    authenticating[from]
+      .onReady(defer(self(), &Self::registerFramework, from, frameworkInfo));
+    return;
+  }
+
+  LOG(INFO) << "Received registration request for"
+            << " framework '" << frameworkInfo.name() << "' at " << from;
+
+  validate(frameworkInfo, from)
+    .onAny(defer(self(),
+                 &Master::_registerFramework,
+                 from,
+                 frameworkInfo,
+                 lambda::_1));
+}
+
+
+void Master::_registerFramework(
+    const UPID& from,
+    const FrameworkInfo& frameworkInfo,
+    const Future<Option<Error>>& validationError)
+{
+  CHECK_READY(validationError);
+  if (validationError.get().isSome()) {
+    LOG(INFO) << "Refusing registration of framework '"
+              << frameworkInfo.name() << "' at " << from
+              << ": " << validationError.get().get().message;
+
+    FrameworkErrorMessage message;
+    message.set_message(validationError.get().get().message);
+    send(from, message);
     return;
   }
 
@@ -1776,7 +2407,7 @@ void Master::_registerFramework(
   FrameworkInfo frameworkInfo_ = frameworkInfo;
   frameworkInfo_.mutable_id()->CopyFrom(newFrameworkId());
 
-  Framework* framework = new Framework(frameworkInfo_, from);
+  Framework* framework = new Framework(this, frameworkInfo_, from);
 
   LOG(INFO) << "Registering framework " << *framework;
 
@@ -1798,7 +2429,7 @@ void Master::_registerFramework(
   FrameworkRegisteredMessage message;
   message.mutable_framework_id()->MergeFrom(framework->id());
   message.mutable_master_info()->MergeFrom(info_);
-  send(framework->pid, message);
+  framework->send(message);
 }
 
 
@@ -1921,6 +2552,18 @@ void Master::_reregisterFramework(
     Framework* framework =
       CHECK_NOTNULL(frameworks.registered[frameworkInfo.id()]);
 
+    // TODO: Allow a framework that subscribed over HTTP to
+    // fail over to a scheduler driver.
+    if (framework->http.isSome()) {
+      LOG(ERROR)
+        << "Disallowing re-registration attempt of framework " << *framework
+        << " at " << from << " because it is subscribed over HTTP";
+      FrameworkErrorMessage message;
+      message.set_message("Framework is subscribed over HTTP");
+      send(from, message);
+      return;
+    }
+
     // Update the framework's info fields based on those passed during
     // re-registration.
     LOG(INFO) << "Updating info for framework " << framework->id();
@@ -1956,14 +2599,8 @@ void Master::_reregisterFramework(
       // NOTE: We need to do this because the scheduler might have
       // replied to the offers but the driver might have dropped
       // those messages since it wasn't connected to the master.
-      foreach (Offer* offer, utils::copy(framework->offers)) {
-        allocator->recoverResources(
-            offer->framework_id(),
-            offer->slave_id(),
-            offer->resources(),
-            None());
-        removeOffer(offer, true); // Rescind.
-      }
+      rescindOffers(vector<Offer*>(
+          framework->offers.begin(), framework->offers.end()));
 
       framework->connected = true;
 
@@ -1986,7 +2623,7 @@ void Master::_reregisterFramework(
     // elected Mesos master to which either an existing scheduler or a
     // failed-over one is connecting. Create a Framework object and add
     // any tasks it has that have been reported by reconnecting slaves.
-    Framework* framework = new Framework(frameworkInfo, from);
+    Framework* framework = new Framework(this, frameworkInfo, from);
 
     // TODO(benh): Check for root submissions like above!
 
@@ -2013,7 +2650,7 @@ void Master::_reregisterFramework(
     FrameworkRegisteredMessage message;
     message.mutable_framework_id()->MergeFrom(framework->id());
     message.mutable_master_info()->MergeFrom(info_);
-    send(framework->pid, message);
+    framework->send(message);
   }
 
   CHECK(frameworks.registered.contains(frameworkInfo.id()))
@@ -2111,11 +2748,8 @@ void Master::deactivate(Framework* framework)
   allocator->deactivateFramework(framework->id());
 
   // Remove the framework's offers.
-  foreach (Offer* offer, utils::copy(framework->offers)) {
-    allocator->recoverResources(
-        offer->framework_id(), offer->slave_id(), offer->resources(), None());
-    removeOffer(offer, true); // Rescind.
-  }
+  rescindOffers(vector<Offer*>(
+      framework->offers.begin(), framework->offers.end()));
 }
 
 
@@ -2128,7 +2762,7 @@ void Master::disconnect(Slave* slave)
   slave->connected = false;
 
   // Inform the slave observer.
-  dispatch(slave->observer, &SlaveObserver::disconnect);
+  dispatch(observer, &SlaveObserver::disconnect, slave->id);
 
   // Remove the slave from authenticated. This is safe because
   // a slave will always reauthenticate before (re-)registering.
@@ -2149,12 +2783,7 @@ void Master::deactivate(Slave* slave)
   allocator->deactivateSlave(slave->id);
 
   // Remove and rescind offers.
-  foreach (Offer* offer, utils::copy(slave->offers)) {
-    allocator->recoverResources(
-        offer->framework_id(), slave->id, offer->resources(), None());
-
-    removeOffer(offer, true); // Rescind!
-  }
+  rescindOffers(vector<Offer*>(slave->offers.begin(), slave->offers.end()));
 }
 
 
@@ -2238,6 +2867,19 @@ void Master::launchTasks(
 }
 
 
+// Returns the user the task will be launched as.
+static string user(const TaskInfo& task, Framework* framework)
+{
+  if (task.has_command() && task.command().has_user()) {
+    return task.command().user();
+  } else if (task.has_executor() && task.executor().command().has_user()) {
+    return task.executor().command().user();
+  }
+
+  return framework->info.user(); // Default user.
+}
+
+
 Future<bool> Master::authorizeTask(
     const TaskInfo& task,
     Framework* framework)
@@ -2248,12 +2890,7 @@ Future<bool> Master::authorizeTask(
   }
 
   // Authorize the task.
-  string user = framework->info.user(); // Default user.
-  if (task.has_command() && task.command().has_user()) {
-    user = task.command().user();
-  } else if (task.has_executor() && task.executor().command().has_user()) {
-    user = task.executor().command().user();
-  }
+  const string user = master::user(task, framework);
 
   LOG(INFO)
     << "Authorizing framework principal '" << framework->info.principal()
@@ -2282,8 +2919,9 @@ Resources Master::addTask(
   CHECK(slave->connected) << "Adding task " << task.task_id()
                           << " to disconnected slave " << *slave;
 
-  // The resources consumed.
-  Resources resources = task.resources();
+  // The resources consumed, which have been validated when the task
+  // was accepted.
+  Resources resources = Resources::trusted(task.resources());
 
   // Determine if this task launches an executor, and if so make sure
   // the slave and framework state has been updated accordingly.
@@ -2300,7 +2938,7 @@ Resources Master::addTask(
       slave->addExecutor(framework->id(), task.executor());
       framework->addExecutor(slave->id, task.executor());
 
-      resources += task.executor().resources();
+      resources += Resources::trusted(task.executor().resources());
     }
 
     executorId = task.executor().executor_id();
@@ -2327,6 +2965,12 @@ Resources Master::addTask(
   slave->addTask(t);
   framework->addTask(t);
 
+  record(EventHistory::LAUNCH,
+         framework->id(),
+         slave->id,
+         task.task_id().value(),
+         resources);
+
   return resources;
 }
 
@@ -2347,8 +2991,13 @@ void Master::accept(
     error = Error("No offers specified");
   } else {
     // Validate the offers.
+    Stopwatch stopwatch;
+    stopwatch.start();
+
     error = validation::offer::validate(accept.offer_ids(), this, framework);
 
+    metrics->accept_offer_validation.record(stopwatch.elapsed().ns() / 1000.0);
+
     // Compute offered resources and remove the offers. If the
     // validation failed, return resources to the allocator.
     foreach (const OfferID& offerId, accept.offer_ids()) {
@@ -2423,6 +3072,12 @@ void Master::accept(
   //
   // TODO(mpark): Add authorization logic for RESERVE and UNRESERVE
   // when "reserve" and "unreserve" ACLs are being introduced.
+  //
+  // NOTE: The result of the authorization only depends on the
+  // framework's principal and the user the task is launched as, so
+  // we send a single request for all the tasks that are launched as
+  // the same user (typically all the tasks of the ACCEPT call).
+  hashmap<string, Future<bool>> authorizations;
   list<Future<bool>> futures;
   foreach (const Offer::Operation& operation, accept.operations()) {
     if (operation.type() != Offer::Operation::LAUNCH) {
@@ -2430,7 +3085,11 @@ void Master::accept(
     }
 
     foreach (const TaskInfo& task, operation.launch().task_infos()) {
-      futures.push_back(authorizeTask(task, framework));
+      const string user = master::user(task, framework);
+      if (!authorizations.contains(user)) {
+        authorizations[user] = authorizeTask(task, framework);
+        futures.push_back(authorizations[user]);
+      }
 
       // Add to pending tasks.
       //
@@ -2441,19 +3100,33 @@ void Master::accept(
       // will not be launched.
       if (!framework->pendingTasks.contains(task.task_id())) {
         framework->pendingTasks[task.task_id()] = task;
+
+        Option<uint64_t> traceId = tracer.sample();
+        if (traceId.isSome()) {
+          tracer.start(
+              framework->id(), task.task_id(), traceId.get(), Clock::now());
+        }
       }
     }
   }
 
   // Wait for all the tasks to be authorized.
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  Histogram authorization = metrics->accept_authorization;
+
   await(futures)
+    .onAny([=]() mutable {
+      authorization.record(stopwatch.elapsed().ns() / 1000.0);
+    })
     .onAny(defer(self(),
                  &Master::_accept,
                  framework->id(),
                  slaveId.get(),
                  offeredResources,
                  accept,
-                 lambda::_1));
+                 authorizations));
 }
 
 
@@ -2462,7 +3135,7 @@ void Master::_accept(
     const SlaveID& slaveId,
     const Resources& offeredResources,
     const scheduler::Call::Accept& accept,
-    const Future<list<Future<bool>>>& _authorizations)
+    const hashmap<string, Future<bool>>& authorizations)
 {
   Framework* framework = getFramework(frameworkId);
 
@@ -2512,6 +3185,8 @@ void Master::_accept(
             reason);
 
         forward(update, UPID(), framework);
+
+        tracer.stop(framework->id(), task.task_id());
       }
     }
 
@@ -2530,8 +3205,12 @@ void Master::_accept(
   // launched, we remove its resource from offered resources.
   Resources _offeredResources = offeredResources;
 
-  CHECK_READY(_authorizations);
-  list<Future<bool>> authorizations = _authorizations.get();
+  // The reservation and volume operations are applied to the slave
+  // right away (so that subsequent operations are validated against
+  // them) but committed in batches, i.e., the allocator gets a single
+  // update and the slave a single CheckpointResourcesMessage for all
+  // the operations preceding a launch (or the end of the call).
+  vector<Offer::Operation> applied;
 
   foreach (const Offer::Operation& operation, accept.operations()) {
     switch (operation.type()) {
@@ -2560,7 +3239,8 @@ void Master::_accept(
                   << operation.reserve().resources() << " from framework "
                   << *framework << " to slave " << *slave;
 
-        applyOfferOperation(framework, slave, operation);
+        applyOfferOperation(slave, operation);
+        applied.push_back(operation);
         break;
       }
 
@@ -2585,7 +3265,8 @@ void Master::_accept(
                   << operation.unreserve().resources() << " from framework "
                   << *framework << " to slave " << *slave;
 
-        applyOfferOperation(framework, slave, operation);
+        applyOfferOperation(slave, operation);
+        applied.push_back(operation);
         break;
       }
 
@@ -2611,7 +3292,8 @@ void Master::_accept(
                   << operation.create().volumes() << " from framework "
                   << *framework << " to slave " << *slave;
 
-        applyOfferOperation(framework, slave, operation);
+        applyOfferOperation(slave, operation);
+        applied.push_back(operation);
         break;
       }
 
@@ -2637,14 +3319,24 @@ void Master::_accept(
                   << operation.create().volumes() << " from framework "
                   << *framework << " to slave " << *slave;
 
-        applyOfferOperation(framework, slave, operation);
+        applyOfferOperation(slave, operation);
+        applied.push_back(operation);
         break;
       }
 
       case Offer::Operation::LAUNCH: {
+        // The tasks might use the resources of the preceding
+        // operations, which the slave must have checkpointed first.
+        commitOfferOperations(framework, slave, applied);
+        applied.clear();
+
+        vector<RunTaskMessage> messages;
+
         foreach (const TaskInfo& task, operation.launch().task_infos()) {
-          Future<bool> authorization = authorizations.front();
-          authorizations.pop_front();
+          const string user = master::user(task, framework);
+
+          CHECK(authorizations.contains(user));
+          const Future<bool>& authorization = authorizations.get(user).get();
 
           // NOTE: The task will not be in 'pendingTasks' if
           // 'killTask()' for the task was called before we are here.
@@ -2658,16 +3350,11 @@ void Master::_accept(
           framework->pendingTasks.erase(task.task_id());
 
           // Check authorization result.
+          CHECK(!authorization.isPending());
           CHECK(!authorization.isDiscarded());
 
           if (authorization.isFailed() || !authorization.get()) {
-            string user = framework->info.user(); // Default user.
-            if (task.has_command() && task.command().has_user()) {
-              user = task.command().user();
-            } else if (task.has_executor() &&
-                       task.executor().command().has_user()) {
-              user = task.executor().command().user();
-            }
+            tracer.stop(framework->id(), task.task_id());
 
             const StatusUpdate& update = protobuf::createStatusUpdate(
                 framework->id(),
@@ -2693,13 +3380,21 @@ void Master::_accept(
           }
 
           // Validate the task.
+          Stopwatch stopwatch;
+          stopwatch.start();
+
           const Option<Error>& validationError = validation::task::validate(
               task,
               framework,
               slave,
               _offeredResources);
 
+          metrics->accept_task_validation.record(
+              stopwatch.elapsed().ns() / 1000.0);
+
           if (validationError.isSome()) {
+            tracer.stop(framework->id(), task.task_id());
+
             const StatusUpdate& update = protobuf::createStatusUpdate(
                 framework->id(),
                 task.slave_id(),
@@ -2735,9 +3430,13 @@ void Master::_accept(
             RunTaskMessage message;
             message.mutable_framework()->MergeFrom(framework->info);
             message.mutable_framework_id()->MergeFrom(framework->id());
-            message.set_pid(framework->pid);
             message.mutable_task()->MergeFrom(task);
 
+            // The framework messages of the executors of a framework
+            // that subscribed over HTTP are sent via the master.
+            message.set_pid(
+                framework->http.isSome() ? self() : framework->pid);
+
             // Set labels retrieved from label-decorator hooks.
             message.mutable_task()->mutable_labels()->CopyFrom(
                 HookManager::masterLaunchTaskLabelDecorator(
@@ -2745,9 +3444,15 @@ void Master::_accept(
                     framework->info,
                     slave->info));
 
-            send(slave->pid, message);
+            messages.push_back(message);
+
+            tracer.record(framework->id(), task.task_id(), "master/accept");
+          } else {
+            tracer.stop(framework->id(), task.task_id());
           }
         }
+
+        sendRunTaskMessages(slave, messages);
         break;
       }
 
@@ -2757,6 +3462,8 @@ void Master::_accept(
     }
   }
 
+  commitOfferOperations(framework, slave, applied);
+
   if (!_offeredResources.empty()) {
     // Tell the allocator about the unused (e.g., refused) resources.
     allocator->recoverResources(
@@ -2768,6 +3475,107 @@ void Master::_accept(
 }
 
 
+void Master::sendRunTaskMessages(
+    Slave* slave,
+    const vector<RunTaskMessage>& messages)
+{
+  CHECK_NOTNULL(slave);
+
+  if (messages.empty()) {
+    return;
+  }
+
+  // Only a 'RunTasksMessage' carries traces.
+  vector<RunTasksMessage::Trace> traces;
+  foreach (const RunTaskMessage& message, messages) {
+    Option<uint64_t> traceId =
+      tracer.get(message.framework().id(), message.task().task_id());
+
+    if (traceId.isSome()) {
+      RunTasksMessage::Trace trace;
+      trace.mutable_task_id()->CopyFrom(message.task().task_id());
+      trace.set_trace_id(traceId.get());
+      traces.push_back(trace);
+    }
+  }
+
+  // Slaves >= 0.23.0 get all the tasks in a single message so that
+  // they can launch them together.
+  bool batch = false;
+  if ((messages.size() > 1 || !traces.empty()) && slave->version.isSome()) {
+    Try<Version> version = Version::parse(slave->version.get());
+    batch = version.isSome() && version.get() >= Version(0, 23, 0);
+  }
+
+  if (!batch) {
+    foreach (const RunTaskMessage& message, messages) {
+      send(slave->pid, message);
+    }
+    return;
+  }
+
+  RunTasksMessage message;
+  message.mutable_framework_id()->CopyFrom(messages.front().framework_id());
+  message.mutable_framework()->CopyFrom(messages.front().framework());
+  message.set_pid(messages.front().pid());
+
+  foreach (const RunTaskMessage& _message, messages) {
+    message.add_tasks()->CopyFrom(_message.task());
+  }
+
+  foreach (const RunTasksMessage::Trace& trace, traces) {
+    message.add_traces()->CopyFrom(trace);
+  }
+
+  send(slave->pid, message);
+}
+
+
+void Master::decline(
+    Framework* framework,
+    const scheduler::Call::Decline& decline)
+{
+  CHECK_NOTNULL(framework);
+
+  ++metrics->messages_decline_offers;
+
+  // NOTE: Unlike when accepting offers, the declined offers need not
+  // belong to the same slave.
+  foreach (const OfferID& offerId, decline.offer_ids()) {
+    Offer* offer = getOffer(offerId);
+
+    if (offer == NULL) {
+      LOG(WARNING) << "Ignoring decline of offer " << offerId
+                   << " of framework " << *framework
+                   << " because the offer is no longer valid";
+      continue;
+    }
+
+    if (!(offer->framework_id() == framework->id())) {
+      LOG(WARNING) << "Ignoring decline of offer " << offerId
+                   << " by framework " << *framework
+                   << " because it was made to framework "
+                   << offer->framework_id();
+      continue;
+    }
+
+    allocator->recoverResources(
+        offer->framework_id(),
+        offer->slave_id(),
+        offer->resources(),
+        decline.filters());
+
+    record(EventHistory::DECLINE,
+           offer->framework_id(),
+           offer->slave_id(),
+           offer->id().value(),
+           offer->resources());
+
+    removeOffer(offer);
+  }
+}
+
+
 void Master::reviveOffers(const UPID& from, const FrameworkID& frameworkId)
 {
   ++metrics->messages_revive_offers;
@@ -2793,6 +3601,31 @@ void Master::reviveOffers(const UPID& from, const FrameworkID& frameworkId)
 }
 
 
+void Master::suppressOffers(const UPID& from, const FrameworkID& frameworkId)
+{
+  ++metrics->messages_suppress_offers;
+
+  Framework* framework = getFramework(frameworkId);
+
+  if (framework == NULL) {
+    LOG(WARNING)
+      << "Ignoring suppress offers message for framework " << frameworkId
+      << " because the framework cannot be found";
+    return;
+  }
+
+  if (from != framework->pid) {
+    LOG(WARNING)
+      << "Ignoring suppress offers message for framework " << *framework
+      << " because it is not expected from " << from;
+    return;
+  }
+
+  LOG(INFO) << "Suppressing offers for framework " << *framework;
+  allocator->suppressOffers(framework->id());
+}
+
+
 void Master::killTask(
     const UPID& from,
     const FrameworkID& frameworkId,
@@ -2826,6 +3659,47 @@ void Master::killTask(
 }
 
 
+void Master::killTasks(
+    const UPID& from,
+    const FrameworkID& frameworkId,
+    const vector<TaskID>& taskIds)
+{
+  LOG(INFO) << "Asked to kill " << taskIds.size() << " tasks"
+            << " of framework " << frameworkId;
+
+  ++metrics->messages_kill_tasks;
+
+  Framework* framework = getFramework(frameworkId);
+
+  if (framework == NULL) {
+    LOG(WARNING)
+      << "Ignoring kill tasks message for " << taskIds.size() << " tasks"
+      << " of framework " << frameworkId
+      << " because the framework cannot be found";
+    return;
+  }
+
+  if (from != framework->pid) {
+    LOG(WARNING)
+      << "Ignoring kill tasks message for " << taskIds.size() << " tasks"
+      << " of framework " << *framework
+      << " because it is not expected from " << from;
+    return;
+  }
+
+  scheduler::Call::Kill call;
+
+  foreach (const TaskID& taskId, taskIds) {
+    VLOG(1) << "Asked to kill task " << taskId
+            << " of framework " << *framework;
+
+    call.mutable_task_id()->CopyFrom(taskId);
+
+    kill(framework, call);
+  }
+}
+
+
 void Master::kill(Framework* framework, const scheduler::Call::Kill& kill)
 {
   CHECK_NOTNULL(framework);
@@ -2913,6 +3787,35 @@ void Master::statusUpdateAcknowledgement(
 {
   metrics->messages_status_update_acknowledgement++;
 
+  _statusUpdateAcknowledgement(from, slaveId, frameworkId, taskId, uuid);
+}
+
+
+void Master::statusUpdateAcknowledgements(
+    const UPID& from,
+    const vector<StatusUpdateAcknowledgementMessage>& acknowledgements)
+{
+  metrics->messages_status_update_acknowledgements++;
+
+  foreach (const StatusUpdateAcknowledgementMessage& acknowledgement,
+           acknowledgements) {
+    _statusUpdateAcknowledgement(
+        from,
+        acknowledgement.slave_id(),
+        acknowledgement.framework_id(),
+        acknowledgement.task_id(),
+        acknowledgement.uuid());
+  }
+}
+
+
+void Master::_statusUpdateAcknowledgement(
+    const UPID& from,
+    const SlaveID& slaveId,
+    const FrameworkID& frameworkId,
+    const TaskID& taskId,
+    const string& uuid)
+{
   // TODO(bmahler): Consider adding a message validator abstraction
   // for the master that takes care of all this boilerplate. Ideally
   // by the time we process messages in the critical master code, we
@@ -2940,6 +3843,20 @@ void Master::statusUpdateAcknowledgement(
     return;
   }
 
+  acknowledge(framework, slaveId, taskId, uuid);
+}
+
+
+void Master::acknowledge(
+    Framework* framework,
+    const SlaveID& slaveId,
+    const TaskID& taskId,
+    const string& uuid)
+{
+  CHECK_NOTNULL(framework);
+
+  const FrameworkID& frameworkId = framework->id();
+
   Slave* slave = slaves.registered.get(slaveId);
 
   if (slave == NULL) {
@@ -3001,12 +3918,56 @@ void Master::statusUpdateAcknowledgement(
   message.mutable_task_id()->CopyFrom(taskId);
   message.set_uuid(uuid);
 
-  send(slave->pid, message);
+  if (slave->batchesStatusUpdates) {
+    // Batch the acknowledgements that are processed before the
+    // dispatched flush, i.e., the ones already queued for the master.
+    StatusUpdateAcknowledgementsMessage& batch = acknowledgements[slaveId];
+
+    if (batch.acknowledgements_size() == 0) {
+      dispatch(self(), &Master::flushAcknowledgements, slaveId);
+    }
+
+    batch.add_acknowledgements()->CopyFrom(message);
+  } else {
+    send(slave->pid, message);
+  }
 
   metrics->valid_status_update_acknowledgements++;
 }
 
 
+void Master::flushAcknowledgements(const SlaveID& slaveId)
+{
+  if (!acknowledgements.contains(slaveId)) {
+    return;
+  }
+
+  const StatusUpdateAcknowledgementsMessage batch = acknowledgements[slaveId];
+  acknowledgements.erase(slaveId);
+
+  Slave* slave = slaves.registered.get(slaveId);
+
+  // NOTE: The slave retries the updates whose acknowledgements are
+  // dropped here.
+  if (slave == NULL || !slave->connected) {
+    LOG(WARNING) << "Dropping " << batch.acknowledgements_size()
+                 << " status update acknowledgements for slave " << slaveId
+                 << " because the slave is "
+                 << (slave == NULL ? "not registered" : "disconnected");
+    return;
+  }
+
+  VLOG(1) << "Forwarding " << batch.acknowledgements_size()
+          << " status update acknowledgements to slave " << *slave;
+
+  if (batch.acknowledgements_size() == 1) {
+    send(slave->pid, batch.acknowledgements(0));
+  } else {
+    send(slave->pid, batch);
+  }
+}
+
+
 void Master::schedulerMessage(
     const UPID& from,
     const SlaveID& slaveId,
@@ -3036,6 +3997,18 @@ void Master::schedulerMessage(
     return;
   }
 
+  message(framework, slaveId, executorId, data);
+}
+
+
+void Master::message(
+    Framework* framework,
+    const SlaveID& slaveId,
+    const ExecutorID& executorId,
+    const string& data)
+{
+  CHECK_NOTNULL(framework);
+
   Slave* slave = slaves.registered.get(slaveId);
 
   if (slave == NULL) {
@@ -3059,7 +4032,7 @@ void Master::schedulerMessage(
 
   FrameworkToExecutorMessage message;
   message.mutable_slave_id()->MergeFrom(slaveId);
-  message.mutable_framework_id()->MergeFrom(frameworkId);
+  message.mutable_framework_id()->MergeFrom(framework->id());
   message.mutable_executor_id()->MergeFrom(executorId);
   message.set_data(data);
   send(slave->pid, message);
@@ -3068,6 +4041,40 @@ void Master::schedulerMessage(
 }
 
 
+void Master::executorMessage(
+    const UPID& from,
+    const SlaveID& slaveId,
+    const FrameworkID& frameworkId,
+    const ExecutorID& executorId,
+    const string& data)
+{
+  Slave* slave = slaves.registered.get(slaveId);
+
+  if (slave == NULL || slave->pid != from) {
+    LOG(WARNING) << "Ignoring framework message from executor " << executorId
+                 << " of framework " << frameworkId << " on slave " << slaveId
+                 << " because it is not expected from " << from;
+    return;
+  }
+
+  Framework* framework = getFramework(frameworkId);
+
+  if (framework == NULL || framework->http.isNone()) {
+    LOG(WARNING) << "Ignoring framework message from executor " << executorId
+                 << " of framework " << frameworkId << " on slave " << *slave
+                 << " because the framework is not subscribed over HTTP";
+    return;
+  }
+
+  ExecutorToFrameworkMessage message;
+  message.mutable_slave_id()->MergeFrom(slaveId);
+  message.mutable_framework_id()->MergeFrom(frameworkId);
+  message.mutable_executor_id()->MergeFrom(executorId);
+  message.set_data(data);
+  framework->send(message);
+}
+
+
 void Master::registerSlave(
     const UPID& from,
     const SlaveInfo& slaveInfo,
@@ -3138,6 +4145,10 @@ void Master::registerSlave(
     return;
   }
 
+  if (throttle(from)) {
+    return;
+  }
+
   slaves.registering.insert(from);
 
   // Create and add the slave id.
@@ -3158,6 +4169,67 @@ void Master::registerSlave(
 }
 
 
+bool Master::throttle(const UPID& pid)
+{
+  if (slaves.admission.isNone()) {
+    return false;
+  }
+
+  Slaves::Admission& admission = slaves.admission.get();
+
+  const Time now = Clock::now();
+
+  // Forget about the slots of the slaves that did not come back.
+  while (!admission.expirations.empty() &&
+         admission.expirations.front().first + admission.window <= now) {
+    const UPID& expired = admission.expirations.front().second;
+    if (admission.slots.get(expired) ==
+        admission.expirations.front().first) {
+      admission.slots.erase(expired);
+    }
+    admission.expirations.pop_front();
+  }
+
+  Time slot;
+
+  if (admission.slots.contains(pid)) {
+    slot = admission.slots[pid];
+
+    if (slot <= now) {
+      admission.slots.erase(pid);
+      return false;
+    }
+  } else {
+    // Up to the number of slaves per window are admitted right away
+    // while the others are handed out slots that are spaced by the
+    // interval, i.e., as the slaves admitted in the last window drop
+    // out of it.
+    admission.next = std::max(admission.next, now);
+
+    slot = admission.next - admission.window + admission.interval;
+    admission.next += admission.interval;
+
+    if (slot <= now) {
+      return false;
+    }
+
+    admission.slots[pid] = slot;
+    admission.expirations.push_back(std::make_pair(slot, pid));
+  }
+
+  ++metrics->slave_registrations_throttled;
+
+  VLOG(1) << "Throttling (re-)registration of slave at " << pid
+          << ", retry in " << slot - now;
+
+  SlaveRegistrationThrottledMessage message;
+  message.set_retry_after((slot - now).secs());
+  send(pid, message);
+
+  return true;
+}
+
+
 void Master::_registerSlave(
     const SlaveInfo& slaveInfo,
     const UPID& pid,
@@ -3207,6 +4279,58 @@ void Master::_registerSlave(
 }
 
 
+void Master::reregisterSlave(
+    const UPID& from,
+    const Lazy<ReregisterSlaveMessage>& message)
+{
+  // Slaves whose authentication is in progress are queued up (see
+  // below), which requires the parsed message.
+  if (!authenticating.contains(from)) {
+    if (flags.authenticate_slaves && !authenticated.contains(from)) {
+      ++metrics->messages_reregister_slave;
+
+      LOG(WARNING) << "Refusing re-registration of slave at " << from
+                   << " because it is not authenticated";
+      ShutdownMessage shutdown;
+      shutdown.set_message("Slave is not authenticated");
+      send(from, shutdown);
+      return;
+    }
+
+    const Option<SlaveInfo> slaveInfo =
+      message.peek<SlaveInfo>(ReregisterSlaveMessage::kSlaveFieldNumber);
+
+    if (slaveInfo.isSome() &&
+        slaves.removed.get(slaveInfo.get().id()).isSome()) {
+      ++metrics->messages_reregister_slave;
+
+      LOG(WARNING) << "Slave " << slaveInfo.get().id() << " at " << from
+                   << " (" << slaveInfo.get().hostname() << ") attempted to "
+                   << "re-register after removal; shutting it down";
+
+      ShutdownMessage shutdown;
+      shutdown.set_message("Slave attempted to re-register after removal");
+      send(from, shutdown);
+      return;
+    }
+  }
+
+  const ReregisterSlaveMessage* reregister = message.get();
+  if (reregister == NULL) {
+    return;
+  }
+
+  reregisterSlave(
+      from,
+      reregister->slave(),
+      google::protobuf::convert(reregister->checkpointed_resources()),
+      google::protobuf::convert(reregister->executor_infos()),
+      google::protobuf::convert(reregister->tasks()),
+      google::protobuf::convert(reregister->completed_frameworks()),
+      reregister->version());
+}
+
+
 void Master::reregisterSlave(
     const UPID& from,
     const SlaveInfo& slaveInfo,
@@ -3287,6 +4411,10 @@ void Master::reregisterSlave(
     slave->pid = from;
     link(slave->pid);
 
+    // The restarted slave may not batch its status updates anymore.
+    flushAcknowledgements(slave->id);
+    slave->batchesStatusUpdates = false;
+
     // Reconcile tasks between master and the slave.
     // NOTE: This sends the re-registered message, including tasks
     // that need to be reconciled by the slave.
@@ -3298,9 +4426,12 @@ void Master::reregisterSlave(
     // slave.
     if (!slave->connected) {
       slave->connected = true;
-      dispatch(slave->observer, &SlaveObserver::reconnect);
+      dispatch(observer, &SlaveObserver::reconnect, slave->id);
       slave->active = true;
-      allocator->activateSlave(slave->id);
+
+      if (slave->healthy) {
+        allocator->activateSlave(slave->id);
+      }
     }
 
     CHECK(slave->active)
@@ -3312,6 +4443,18 @@ void Master::reregisterSlave(
     return;
   }
 
+  if (!slaves.reregistering.contains(slaveInfo.id()) && throttle(from)) {
+    return;
+  }
+
+  // If the slave was recovered from the registry (and has not been
+  // removed since, see 'removeSlave'), it is known to be in the
+  // registry and readmitting it would not change the registry, so
+  // there is no need to ask the registrar. This is the case for all
+  // the slaves that re-register after a master failover, which would
+  // otherwise have to wait for each other's (no-op) registry updates.
+  const bool recovered = slaves.recovered.contains(slaveInfo.id());
+
   // Ensure we don't remove the slave for not re-registering after
   // we've recovered it from the registry.
   slaves.recovered.erase(slaveInfo.id());
@@ -3331,6 +4474,25 @@ void Master::reregisterSlave(
 
   slaves.reregistering.insert(slaveInfo.id());
 
+  // NOTE: We still dispatch rather than re-register the slave right
+  // away, so that the messages the master got in the meantime are
+  // handled while the slave is re-registering, as when readmitting
+  // the slave through the registrar.
+  if (recovered) {
+    dispatch(self(),
+             &Self::_reregisterSlave,
+             slaveInfo,
+             from,
+             checkpointedResources,
+             executorInfos,
+             tasks,
+             completedFrameworks,
+             version,
+             Future<bool>(true));
+
+    return;
+  }
+
   // This handles the case when the slave tries to re-register with
   // a failed over master, in which case we must consult the
   // registrar.
@@ -3409,17 +4571,18 @@ void Master::__reregisterSlave(Slave* slave, const vector<Task>& tasks)
 {
   CHECK_NOTNULL(slave);
 
-  // Send the latest framework pids to the slave.
-  hashset<UPID> pids;
+  // Send the latest framework pids to the slave (the master's pid
+  // for the frameworks that subscribed over HTTP, see 'runTask').
+  hashset<FrameworkID> frameworkIds;
   foreach (const Task& task, tasks) {
     Framework* framework = getFramework(task.framework_id());
-    if (framework != NULL && !pids.contains(framework->pid)) {
+    if (framework != NULL && !frameworkIds.contains(framework->id())) {
       UpdateFrameworkMessage message;
       message.mutable_framework_id()->MergeFrom(framework->id());
-      message.set_pid(framework->pid);
+      message.set_pid(framework->http.isSome() ? self() : framework->pid);
       send(slave->pid, message);
 
-      pids.insert(framework->pid);
+      frameworkIds.insert(framework->id());
     }
   }
 
@@ -3491,22 +4654,20 @@ void Master::updateSlave(
             << " oversubscribed resources " <<  oversubscribedResources;
 
   // First, rescind any oustanding offers with revocable resources.
-  // NOTE: Need a copy of offers because the offers are removed inside
-  // the loop.
-  foreach (Offer* offer, utils::copy(slave->offers)) {
+  vector<Offer*> revocable;
+  foreach (Offer* offer, slave->offers) {
     const Resources offered = offer->resources();
     if (!offered.revocable().empty()) {
       LOG(INFO) << "Removing offer " << offer->id()
                 << " with revocable resources " << offered
                 << " on slave " << *slave;
 
-      allocator->recoverResources(
-          offer->framework_id(), offer->slave_id(), offer->resources(), None());
-
-      removeOffer(offer, true); // Rescind.
+      revocable.push_back(offer);
     }
   }
 
+  rescindOffers(revocable);
+
   // Now, update the allocator with the new estimate.
   allocator->updateSlave(slaveId, oversubscribedResources);
 }
@@ -3577,7 +4738,30 @@ void Master::statusUpdate(const StatusUpdate& update, const UPID& pid)
     removeTask(task);
   }
 
-  metrics->valid_status_updates++;
+  metrics->valid_status_updates++;
+}
+
+
+void Master::statusUpdates(
+    const UPID& from,
+    const vector<StatusUpdateMessage>& updates)
+{
+  ++metrics->messages_status_updates;
+
+  if (updates.empty()) {
+    return;
+  }
+
+  // Batch the acknowledgements for the slave from now on.
+  Slave* slave = slaves.registered.get(updates.front().update().slave_id());
+
+  if (slave != NULL && slave->pid == from) {
+    slave->batchesStatusUpdates = true;
+  }
+
+  foreach (const StatusUpdateMessage& update, updates) {
+    statusUpdate(update.update(), update.pid());
+  }
 }
 
 
@@ -3597,10 +4781,11 @@ void Master::forward(
     LOG(INFO) << "Forwarding status update " << update;
   }
 
-  StatusUpdateMessage message;
-  message.mutable_update()->MergeFrom(update);
+  StatusUpdateMessage& message = statusUpdateMessage;
+  message.Clear();
+  message.mutable_update()->CopyFrom(update);
   message.set_pid(acknowledgee);
-  send(framework->pid, message);
+  framework->send(message);
 }
 
 
@@ -3671,7 +4856,7 @@ void Master::exitedExecutor(
   message.mutable_slave_id()->CopyFrom(slaveId);
   message.set_status(status);
 
-  send(framework->pid, message);
+  framework->send(message);
 }
 
 
@@ -3698,6 +4883,24 @@ void Master::shutdown(
 }
 
 
+void Master::updateUsage(
+    const SlaveID& slaveId,
+    const ResourceStatistics& usage)
+{
+  // The usage is not part of the state of the read-only endpoints
+  // (the utilization endpoint is not cached), so reporting it at the
+  // ping rate does not invalidate their cached responses.
+  reading = true;
+
+  Slave* slave = slaves.registered.get(slaveId);
+  if (slave == NULL) {
+    return;
+  }
+
+  slave->usage = usage;
+}
+
+
 void Master::shutdownSlave(const SlaveID& slaveId, const string& message)
 {
   if (!slaves.registered.contains(slaveId)) {
@@ -3758,6 +4961,15 @@ void Master::reconcileTasks(
     return;
   }
 
+  // Frameworks are expected to retry reconciliation until they have
+  // received the updates for all their tasks, so it can be shed.
+  if (overloaded()) {
+    LOG(WARNING) << "Dropping reconcile tasks message for framework "
+                 << *framework << " since the master is overloaded";
+    ++metrics->shed_requests;
+    return;
+  }
+
   if (from != framework->pid) {
     LOG(WARNING)
       << "Ignoring reconcile tasks message for framework " << *framework
@@ -3769,12 +4981,36 @@ void Master::reconcileTasks(
 }
 
 
+// Returns whether the framework has the BATCHED_RECONCILIATION
+// capability.
+static bool batchedReconciliation(const FrameworkInfo& frameworkInfo)
+{
+  foreach (const FrameworkInfo::Capability& capability,
+           frameworkInfo.capabilities()) {
+    if (capability.type() ==
+        FrameworkInfo::Capability::BATCHED_RECONCILIATION) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
 void Master::_reconcileTasks(
     Framework* framework,
     const vector<TaskStatus>& statuses)
 {
   CHECK_NOTNULL(framework);
 
+  // The updates for a framework with the BATCHED_RECONCILIATION
+  // capability are sent in batches, which saves a message (and its
+  // encoding and dispatch on both ends) per reconciled task.
+  Owned<StatusUpdatesMessage> batch;
+  if (batchedReconciliation(framework->info)) {
+    batch.reset(new StatusUpdatesMessage());
+  }
+
   if (statuses.empty()) {
     // Implicit reconciliation.
     LOG(INFO) << "Performing implicit task state reconciliation"
@@ -3795,11 +5031,7 @@ void Master::_reconcileTasks(
               << " for task " << update.status().task_id()
               << " of framework " << *framework;
 
-      // TODO(bmahler): Consider using forward(); might lead to too
-      // much logging.
-      StatusUpdateMessage message;
-      message.mutable_update()->CopyFrom(update);
-      send(framework->pid, message);
+      sendReconciliation(framework, update, batch.get());
     }
 
     foreachvalue (Task* task, framework->tasks) {
@@ -3827,11 +5059,11 @@ void Master::_reconcileTasks(
               << " for task " << update.status().task_id()
               << " of framework " << *framework;
 
-      // TODO(bmahler): Consider using forward(); might lead to too
-      // much logging.
-      StatusUpdateMessage message;
-      message.mutable_update()->CopyFrom(update);
-      send(framework->pid, message);
+      sendReconciliation(framework, update, batch.get());
+    }
+
+    if (batch.get() != NULL && batch->updates_size() > 0) {
+      framework->send(*batch);
     }
 
     return;
@@ -3927,13 +5159,38 @@ void Master::_reconcileTasks(
               << " for task " << update.get().status().task_id()
               << " of framework " << *framework;
 
-      // TODO(bmahler): Consider using forward(); might lead to too
-      // much logging.
-      StatusUpdateMessage message;
-      message.mutable_update()->CopyFrom(update.get());
-      send(framework->pid, message);
+      sendReconciliation(framework, update.get(), batch.get());
     }
   }
+
+  if (batch.get() != NULL && batch->updates_size() > 0) {
+    framework->send(*batch);
+  }
+}
+
+
+void Master::sendReconciliation(
+    Framework* framework,
+    const StatusUpdate& update,
+    StatusUpdatesMessage* batch)
+{
+  CHECK_NOTNULL(framework);
+
+  // TODO(bmahler): Consider using forward(); might lead to too
+  // much logging.
+  if (batch == NULL) {
+    StatusUpdateMessage message;
+    message.mutable_update()->CopyFrom(update);
+    framework->send(message);
+    return;
+  }
+
+  batch->add_updates()->mutable_update()->CopyFrom(update);
+
+  if ((size_t) batch->updates_size() >= MAX_RECONCILIATION_BATCH_SIZE) {
+    framework->send(*batch);
+    batch->Clear();
+  }
 }
 
 
@@ -3954,6 +5211,20 @@ void Master::frameworkFailoverTimeout(const FrameworkID& frameworkId,
 }
 
 
+// Returns whether the framework has the COMPACT_OFFERS capability.
+static bool compactOffers(const FrameworkInfo& frameworkInfo)
+{
+  foreach (const FrameworkInfo::Capability& capability,
+           frameworkInfo.capabilities()) {
+    if (capability.type() == FrameworkInfo::Capability::COMPACT_OFFERS) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
 void Master::offer(const FrameworkID& frameworkId,
                    const hashmap<SlaveID, Resources>& resources)
 {
@@ -3970,9 +5241,16 @@ void Master::offer(const FrameworkID& frameworkId,
   }
 
   // Create an offer for each slave and add it to the message.
-  ResourceOffersMessage message;
+  ResourceOffersMessage& message = offersMessage;
+  message.Clear();
 
   Framework* framework = CHECK_NOTNULL(frameworks.registered[frameworkId]);
+
+  const bool compact = compactOffers(framework->info);
+
+  // The index of each distinct set of slave attributes in a compact
+  // message, keyed by the serialized attributes.
+  hashmap<string, uint32_t> attributesIndices;
   foreachpair (const SlaveID& slaveId, const Resources& offered, resources) {
     if (!slaves.registered.contains(slaveId)) {
       LOG(WARNING)
@@ -4051,29 +5329,57 @@ void Master::offer(const FrameworkID& frameworkId,
     framework->addOffer(offer);
     slave->addOffer(offer);
 
+    record(EventHistory::OFFER,
+           framework->id(),
+           slave->id,
+           offer->id().value(),
+           offered);
+
     if (flags.offer_timeout.isSome()) {
       // Rescind the offer after the timeout elapses.
-      offerTimers[offer->id()] =
-        delay(flags.offer_timeout.get(),
-              self(),
-              &Self::offerTimeout,
-              offer->id());
+      offerExpirations.push_back(
+          std::make_pair(Clock::now() + flags.offer_timeout.get(),
+                         offer->id()));
+
+      if (offerTimer.isNone()) {
+        offerTimer =
+          delay(flags.offer_timeout.get(), self(), &Self::expireOffers);
+      }
     }
 
     // TODO(jieyu): For now, we strip 'ephemeral_ports' resource from
     // offers so that frameworks do not see this resource. This is a
     // short term workaround. Revisit this once we resolve MESOS-1654.
-    Offer offer_ = *offer;
-    offer_.clear_resources();
+    // NOTE: The offer is built in place in the (reused) message.
+    Offer* offer_ = message.add_offers();
+    offer_->CopyFrom(*offer);
+    offer_->clear_resources();
 
     foreach (const Resource& resource, offered) {
       if (resource.name() != "ephemeral_ports") {
-        offer_.add_resources()->CopyFrom(resource);
+        offer_->add_resources()->CopyFrom(resource);
+      }
+    }
+
+    // Send each distinct set of attributes only once to frameworks
+    // that asked for compact offers.
+    if (compact) {
+      offer_->clear_attributes();
+
+      ResourceOffersMessage::Attributes attributes;
+      attributes.mutable_attributes()->CopyFrom(slave->info.attributes());
+
+      const string key = attributes.SerializeAsString();
+
+      if (!attributesIndices.contains(key)) {
+        attributesIndices[key] = message.attributes_size();
+        message.add_attributes()->Swap(&attributes);
       }
+
+      message.add_attributes_indices(attributesIndices[key]);
     }
 
-    // Add the offer *AND* the corresponding slave's PID.
-    message.add_offers()->MergeFrom(offer_);
+    // Add the corresponding slave's PID.
     message.add_pids(slave->pid);
   }
 
@@ -4084,7 +5390,7 @@ void Master::offer(const FrameworkID& frameworkId,
   LOG(INFO) << "Sending " << message.offers().size()
             << " offers to framework " << *framework;
 
-  send(framework->pid, message);
+  framework->send(message);
 }
 
 
@@ -4392,7 +5698,19 @@ void Master::addFramework(Framework* framework)
 
   frameworks.registered[framework->id()] = framework;
 
-  link(framework->pid);
+  framework->completedTaskStore = completedTaskStore;
+
+  if (framework->http.isSome()) {
+    // Notice when the framework closes its connection, like we do
+    // by linking to the pid of other frameworks.
+    framework->http.get().closed()
+      .onAny(defer(self(),
+                   &Self::exited,
+                   framework->id(),
+                   framework->http.get()));
+  } else {
+    link(framework->pid);
+  }
 
   // Enforced by Master::registerFramework.
   CHECK(roles.contains(framework->info.role()))
@@ -4409,7 +5727,12 @@ void Master::addFramework(Framework* framework)
       framework->info,
       framework->usedResources);
 
-  // Export framework metrics.
+  // Export framework metrics. These count the messages from the
+  // framework's pid, hence there are none for a framework that
+  // subscribed over HTTP.
+  if (framework->http.isSome()) {
+    return;
+  }
 
   // If the framework is authenticated, its principal should be in
   // 'authenticated'. Otherwise look if it's supplied in
@@ -4469,6 +5792,63 @@ void Master::failoverFramework(Framework* framework, const UPID& newPid)
   message.mutable_master_info()->MergeFrom(info_);
   send(newPid, message);
 
+  _failoverFramework(framework);
+
+  // 'Failover' the framework's metrics. i.e., change the lookup key
+  // for its metrics to 'newPid'.
+  if (oldPid != newPid && frameworks.principals.contains(oldPid)) {
+    frameworks.principals[newPid] = frameworks.principals[oldPid];
+    frameworks.principals.erase(oldPid);
+  }
+}
+
+
+void Master::failoverFramework(Framework* framework, const HttpConnection& http)
+{
+  // Shut down the older scheduler, be it on another HTTP connection
+  // or at a pid (i.e., the scheduler switched to the HTTP API).
+  FrameworkErrorMessage error;
+  error.set_message("Framework failed over");
+  framework->send(error);
+
+  if (framework->http.isSome()) {
+    framework->http.get().close();
+  } else {
+    // TODO(benh): unlink(framework->pid);
+
+    // Remove the framework's message counters, which are not kept
+    // for frameworks that subscribed over HTTP (see 'addFramework').
+    authenticated.erase(framework->pid);
+
+    CHECK(frameworks.principals.contains(framework->pid));
+    const Option<string> principal = frameworks.principals[framework->pid];
+
+    frameworks.principals.erase(framework->pid);
+
+    if (principal.isSome() &&
+        !frameworks.principals.containsValue(principal.get())) {
+      CHECK(metrics->frameworks.contains(principal.get()));
+      metrics->frameworks.erase(principal.get());
+    }
+  }
+
+  framework->pid = UPID();
+  framework->http = http;
+
+  framework->http.get().closed()
+    .onAny(defer(self(), &Self::exited, framework->id(), http));
+
+  FrameworkRegisteredMessage message;
+  message.mutable_framework_id()->MergeFrom(framework->id());
+  message.mutable_master_info()->MergeFrom(info_);
+  framework->send(message);
+
+  _failoverFramework(framework);
+}
+
+
+void Master::_failoverFramework(Framework* framework)
+{
   // Remove the framework's offers (if they weren't removed before).
   // We do this after we have updated the pid and sent the framework
   // registered message so that the allocator can immediately re-offer
@@ -4488,13 +5868,6 @@ void Master::failoverFramework(Framework* framework, const UPID& newPid)
     framework->active = true;
     allocator->activateFramework(framework->id());
   }
-
-  // 'Failover' the framework's metrics. i.e., change the lookup key
-  // for its metrics to 'newPid'.
-  if (oldPid != newPid && frameworks.principals.contains(oldPid)) {
-    frameworks.principals[newPid] = frameworks.principals[oldPid];
-    frameworks.principals.erase(oldPid);
-  }
 }
 
 
@@ -4504,6 +5877,8 @@ void Master::removeFramework(Framework* framework)
 
   LOG(INFO) << "Removing framework " << *framework;
 
+  tracer.stop(framework->id());
+
   if (framework->active) {
     // Tell the allocator to stop allocating resources to this framework.
     // TODO(vinod): Consider setting  framework->active to false here
@@ -4594,21 +5969,27 @@ void Master::removeFramework(Framework* framework)
 
   roles[framework->info.role()]->removeFramework(framework);
 
-  // Remove the framework from authenticated.
-  authenticated.erase(framework->pid);
+  if (framework->http.isSome()) {
+    // Close the connection of a framework that subscribed over HTTP,
+    // which has no message counters (see 'addFramework').
+    framework->http.get().close();
+  } else {
+    // Remove the framework from authenticated.
+    authenticated.erase(framework->pid);
 
-  CHECK(frameworks.principals.contains(framework->pid));
-  const Option<string> principal = frameworks.principals[framework->pid];
+    CHECK(frameworks.principals.contains(framework->pid));
+    const Option<string> principal = frameworks.principals[framework->pid];
 
-  frameworks.principals.erase(framework->pid);
+    frameworks.principals.erase(framework->pid);
 
-  // Remove the framework's message counters.
-  if (principal.isSome()) {
-    // Remove the metrics for the principal if this framework is the
-    // last one with this principal.
-    if (!frameworks.principals.containsValue(principal.get())) {
-      CHECK(metrics->frameworks.contains(principal.get()));
-      metrics->frameworks.erase(principal.get());
+    // Remove the framework's message counters.
+    if (principal.isSome()) {
+      // Remove the metrics for the principal if this framework is the
+      // last one with this principal.
+      if (!frameworks.principals.containsValue(principal.get())) {
+        CHECK(metrics->frameworks.contains(principal.get()));
+        metrics->frameworks.erase(principal.get());
+      }
     }
   }
 
@@ -4672,13 +6053,15 @@ void Master::addSlave(
   slaves.removed.erase(slave->id);
   slaves.registered.put(slave);
 
-  link(slave->pid);
+  totals.add(*slave);
+  slave->totals = &totals;
+
+  updateReservations(slave->totalResources, Resources());
 
-  // Set up an observer for the slave.
-  slave->observer = new SlaveObserver(
-      slave->pid, slave->info, slave->id, self(), slaves.limiter, metrics);
+  link(slave->pid);
 
-  spawn(slave->observer);
+  // Start observing the health of the slave.
+  dispatch(observer, &SlaveObserver::add, slave->id, slave->pid);
 
   // Add the slave's executors to the frameworks.
   foreachkey (const FrameworkID& frameworkId, slave->executors) {
@@ -4722,7 +6105,7 @@ void Master::addSlave(
         VLOG(2) << "Re-adding completed task " << task.task_id()
                 << " of framework " << *framework
                 << " that ran on slave " << *slave;
-        framework->addCompletedTask(task);
+        framework->addCompletedTask(summarize(task));
       } else {
         // We could be here if the framework hasn't registered yet.
         // TODO(vinod): Revisit these semantics when we store frameworks'
@@ -4739,6 +6122,16 @@ void Master::addSlave(
       slave->info,
       slave->totalResources,
       slave->usedResources);
+
+  // The host of the slave might have been observed as unhealthy
+  // already, e.g., before the slave (re-)registered.
+  if (!repairer->isHealthy(slave->info.hostname())) {
+    LOG(INFO) << "Not offering slave " << *slave << " since its host is"
+              << " unhealthy";
+
+    slave->healthy = false;
+    allocator->deactivateSlave(slave->id);
+  }
 }
 
 
@@ -4793,26 +6186,24 @@ void Master::removeSlave(
     }
   }
 
-  foreach (Offer* offer, utils::copy(slave->offers)) {
-    // TODO(vinod): We don't need to call 'Allocator::recoverResources'
-    // once MESOS-621 is fixed.
-    allocator->recoverResources(
-        offer->framework_id(), slave->id, offer->resources(), None());
-
-    // Remove and rescind offers.
-    removeOffer(offer, true); // Rescind!
-  }
+  // Remove and rescind offers.
+  // TODO(vinod): We don't need to call 'Allocator::recoverResources'
+  // once MESOS-621 is fixed.
+  rescindOffers(vector<Offer*>(slave->offers.begin(), slave->offers.end()));
 
   // Mark the slave as being removed.
   slaves.removing.insert(slave->id);
   slaves.registered.remove(slave);
+
+  totals.remove(*slave);
+  slave->totals = NULL;
+
+  updateReservations(Resources(), slave->totalResources);
   slaves.removed.put(slave->id, Nothing());
   authenticated.erase(slave->pid);
 
-  // Kill the slave observer.
-  terminate(slave->observer);
-  wait(slave->observer);
-  delete slave->observer;
+  // Stop observing the health of the slave.
+  dispatch(observer, &SlaveObserver::remove, slave->id);
 
   // TODO(benh): unlink(slave->pid);
 
@@ -4881,7 +6272,7 @@ void Master::_removeSlave(
               << "after recovering";
     LostSlaveMessage message;
     message.mutable_slave_id()->MergeFrom(slaveInfo.id());
-    send(framework->pid, message);
+    framework->send(message);
   }
 }
 
@@ -4905,6 +6296,18 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
     return;
   }
 
+  // A traced launch ends once the task is running (or terminal).
+  if (status.state() == TASK_RUNNING) {
+    tracer.record(task->framework_id(), task->task_id(), "task/launch");
+    tracer.stop(task->framework_id(), task->task_id());
+  } else if (protobuf::isTerminalState(status.state())) {
+    tracer.stop(task->framework_id(), task->task_id());
+  }
+
+  // The slave owns the Task object and cannot be NULL.
+  Slave* slave = slaves.registered.get(task->slave_id());
+  CHECK_NOTNULL(slave);
+
   // Get the latest state.
   Option<TaskState> latestState;
   if (update.has_latest_state()) {
@@ -4919,34 +6322,27 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
     terminated = !protobuf::isTerminalState(task->state()) &&
                  protobuf::isTerminalState(latestState.get());
 
-    task->set_state(latestState.get());
+    slave->updateTaskState(task, latestState.get());
   } else {
     // This update must be from a pre 0.21.0 slave or generated by the
     // master.
     terminated = !protobuf::isTerminalState(task->state()) &&
                  protobuf::isTerminalState(status.state());
 
-    task->set_state(status.state());
+    slave->updateTaskState(task, status.state());
   }
 
   // Set the status update state and uuid for the task.
   task->set_status_update_state(status.state());
   task->set_status_update_uuid(update.uuid());
 
-  // TODO(brenden) Consider wiping the `message` field?
   if (task->statuses_size() > 0 &&
       task->statuses(task->statuses_size() - 1).state() == status.state()) {
     task->mutable_statuses()->RemoveLast();
   }
-  task->add_statuses()->CopyFrom(status);
 
-  // Delete data (maybe very large since it's stored by on-top framework) we
-  // are not interested in to avoid OOM.
-  // For example: mesos-master is running on a machine with 4GB free memory,
-  // if every task stores 10MB data into TaskStatus, then mesos-master will be
-  // killed by OOM killer after have 400 tasks finished.
-  // MESOS-1746.
-  task->mutable_statuses(task->statuses_size() - 1)->clear_data();
+  task->add_statuses()->CopyFrom(
+      protobuf::createTaskStatusSummary(status));
 
   LOG(INFO) << "Updating the latest state of task " << task->task_id()
             << " of framework " << task->framework_id()
@@ -4974,6 +6370,13 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
       framework->taskTerminated(task);
     }
 
+    record(EventHistory::TERMINAL,
+           task->framework_id(),
+           task->slave_id(),
+           task->task_id().value(),
+           task->resources(),
+           task->state());
+
     switch (status.state()) {
       case TASK_FINISHED: ++metrics->tasks_finished; break;
       case TASK_FAILED:   ++metrics->tasks_failed;   break;
@@ -5061,20 +6464,60 @@ void Master::removeExecutor(
 }
 
 
+void Master::updateReservations(
+    const Resources& added,
+    const Resources& removed)
+{
+  foreachpair (const string& role,
+               const Resources& resources,
+               added.reserved()) {
+    if (roles.contains(role)) {
+      roles[role]->reserved += resources;
+    }
+  }
+
+  foreachpair (const string& role,
+               const Resources& resources,
+               removed.reserved()) {
+    if (roles.contains(role)) {
+      roles[role]->reserved -= resources;
+    }
+  }
+}
+
+
 void Master::applyOfferOperation(
-    Framework* framework,
     Slave* slave,
     const Offer::Operation& operation)
+{
+  CHECK_NOTNULL(slave);
+
+  const Resources totalResources = slave->totalResources;
+
+  slave->apply(operation);
+
+  updateReservations(
+      slave->totalResources - totalResources,
+      totalResources - slave->totalResources);
+}
+
+
+void Master::commitOfferOperations(
+    Framework* framework,
+    Slave* slave,
+    const vector<Offer::Operation>& operations)
 {
   CHECK_NOTNULL(framework);
   CHECK_NOTNULL(slave);
 
+  if (operations.empty()) {
+    return;
+  }
+
   allocator->updateAllocation(
       framework->id(),
       slave->id,
-      {operation});
-
-  slave->apply(operation);
+      operations);
 
   LOG(INFO) << "Sending checkpointed resources "
             << slave->checkpointedResources
@@ -5087,13 +6530,104 @@ void Master::applyOfferOperation(
 }
 
 
-void Master::offerTimeout(const OfferID& offerId)
+void Master::expireOffers()
+{
+  offerTimer = None();
+
+  const Time now = Clock::now();
+
+  vector<Offer*> expired;
+  while (!offerExpirations.empty() && offerExpirations.front().first <= now) {
+    Offer* offer = getOffer(offerExpirations.front().second);
+    if (offer != NULL) {
+      expired.push_back(offer);
+    }
+    offerExpirations.pop_front();
+  }
+
+  rescindOffers(expired);
+
+  if (!offerExpirations.empty()) {
+    offerTimer = delay(
+        offerExpirations.front().first - now, self(), &Self::expireOffers);
+  }
+}
+
+
+void Master::rescindOffers(const vector<Offer*>& offers)
 {
-  Offer* offer = getOffer(offerId);
-  if (offer != NULL) {
+  // The offers to rescind with a single message, per framework.
+  hashmap<FrameworkID, RescindResourceOfferMessage> messages;
+
+  foreach (Offer* offer, offers) {
     allocator->recoverResources(
         offer->framework_id(), offer->slave_id(), offer->resources(), None());
-    removeOffer(offer, true);
+
+    Framework* framework = getFramework(offer->framework_id());
+    CHECK(framework != NULL)
+      << "Unknown framework " << offer->framework_id()
+      << " in the offer " << offer->id();
+
+    if (!compactOffers(framework->info)) {
+      removeOffer(offer, true); // Rescind.
+      continue;
+    }
+
+    if (!messages.contains(framework->id())) {
+      messages[framework->id()].mutable_offer_id()->CopyFrom(offer->id());
+    } else {
+      messages[framework->id()].add_offer_ids()->CopyFrom(offer->id());
+    }
+
+    removeOffer(offer);
+  }
+
+  foreachpair (const FrameworkID& frameworkId,
+               const RescindResourceOfferMessage& message,
+               messages) {
+    Framework* framework = CHECK_NOTNULL(getFramework(frameworkId));
+    framework->send(message);
+  }
+}
+
+
+void Master::updateHealth(const hashset<string>& hosts)
+{
+  if (hosts.empty()) {
+    return;
+  }
+
+  foreachvalue (Slave* slave, slaves.registered) {
+    if (!hosts.contains(slave->info.hostname())) {
+      continue;
+    }
+
+    const bool healthy = repairer->isHealthy(slave->info.hostname());
+
+    if (slave->healthy == healthy) {
+      continue;
+    }
+
+    LOG(INFO) << (healthy ? "Resuming" : "Stopping")
+              << " offers for slave " << *slave << " since its host is "
+              << (healthy ? "healthy again" : "unhealthy");
+
+    slave->healthy = healthy;
+
+    // An inactive slave gets activated in the allocator only once it
+    // reconnects, and only if it is healthy by then.
+    if (!slave->active) {
+      continue;
+    }
+
+    if (healthy) {
+      allocator->activateSlave(slave->id);
+    } else {
+      allocator->deactivateSlave(slave->id);
+
+      rescindOffers(
+          vector<Offer*>(slave->offers.begin(), slave->offers.end()));
+    }
   }
 }
 
@@ -5122,14 +6656,13 @@ void Master::removeOffer(Offer* offer, bool rescind)
   if (rescind) {
     RescindResourceOfferMessage message;
     message.mutable_offer_id()->MergeFrom(offer->id());
-    send(framework->pid, message);
-  }
+    framework->send(message);
 
-  // Remove and cancel offer removal timers. Canceling the Timers is
-  // only done to avoid having too many active Timers in libprocess.
-  if (offerTimers.contains(offer->id())) {
-    Clock::cancel(offerTimers[offer->id()]);
-    offerTimers.erase(offer->id());
+    record(EventHistory::RESCIND,
+           offer->framework_id(),
+           offer->slave_id(),
+           offer->id().value(),
+           offer->resources());
   }
 
   // Delete it.
@@ -5138,6 +6671,32 @@ void Master::removeOffer(Offer* offer, bool rescind)
 }
 
 
+void Master::record(
+    EventHistory::Type type,
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId,
+    const string& id,
+    const Resources& resources,
+    int state)
+{
+  if (eventHistory.get() == NULL) {
+    return;
+  }
+
+  EventHistory::Event event;
+  event.type = type;
+  event.timestamp = Clock::now().duration().ns() / 1000;
+  event.frameworkId = frameworkId.value();
+  event.slaveId = slaveId.value();
+  event.id = id;
+  event.cpus = resources.cpus().get(0.0);
+  event.mem = resources.mem().get(Bytes(0)).megabytes();
+  event.state = state;
+
+  eventHistory->append(event);
+}
+
+
 // TODO(bmahler): Consider killing this.
 Framework* Master::getFramework(const FrameworkID& frameworkId)
 {
@@ -5292,90 +6851,31 @@ double Master::_tasks_staging()
     count += framework->pendingTasks.size();
   }
 
-  foreachvalue (Slave* slave, slaves.registered) {
-    typedef hashmap<TaskID, Task*> TaskMap;
-    foreachvalue (const TaskMap& tasks, slave->tasks) {
-      foreachvalue (const Task* task, tasks) {
-        if (task->state() == TASK_STAGING) {
-          count++;
-        }
-      }
-    }
-  }
-
-  return count;
+  return count + totals.taskStates.get(TASK_STAGING).get(0);
 }
 
 
 double Master::_tasks_starting()
 {
-  double count = 0.0;
-
-  foreachvalue (Slave* slave, slaves.registered) {
-    typedef hashmap<TaskID, Task*> TaskMap;
-    foreachvalue (const TaskMap& tasks, slave->tasks) {
-      foreachvalue (const Task* task, tasks) {
-        if (task->state() == TASK_STARTING) {
-          count++;
-        }
-      }
-    }
-  }
-
-  return count;
+  return totals.taskStates.get(TASK_STARTING).get(0);
 }
 
 
 double Master::_tasks_running()
 {
-  double count = 0.0;
-
-  foreachvalue (Slave* slave, slaves.registered) {
-    typedef hashmap<TaskID, Task*> TaskMap;
-    foreachvalue (const TaskMap& tasks, slave->tasks) {
-      foreachvalue (const Task* task, tasks) {
-        if (task->state() == TASK_RUNNING) {
-          count++;
-        }
-      }
-    }
-  }
-
-  return count;
+  return totals.taskStates.get(TASK_RUNNING).get(0);
 }
 
 
 double Master::_resources_total(const std::string& name)
 {
-  double total = 0.0;
-
-  foreachvalue (Slave* slave, slaves.registered) {
-    foreach (const Resource& resource, slave->info.resources()) {
-      if (resource.name() == name && resource.type() == Value::SCALAR) {
-        total += resource.scalar().value();
-      }
-    }
-  }
-
-  return total;
+  return totals.totalResources.get(name).get(0.0);
 }
 
 
 double Master::_resources_used(const std::string& name)
 {
-  double used = 0.0;
-
-  foreachvalue (Slave* slave, slaves.registered) {
-    foreachvalue (const Resources& resources, slave->usedResources) {
-      foreach (const Resource& resource, resources - resources.revocable()) {
-        if (resource.name() == name && resource.type() == Value::SCALAR) {
-          used += resource.scalar().value();
-        }
-      }
-    }
-  }
-
-  return used;
+  return totals.usedResources.get(name).get(0.0);
 }
 
 
@@ -21,6 +21,7 @@
 
 #include <stdint.h>
 
+#include <deque>
 #include <list>
 #include <memory>
 #include <string>
@@ -50,20 +51,28 @@
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/json.hpp>
 #include <stout/multihashmap.hpp>
 #include <stout/option.hpp>
+#include <stout/uuid.hpp>
 
+#include "common/evolve.hpp"
+#include "common/http.hpp"
 #include "common/protobuf_utils.hpp"
+#include "common/recordio.hpp"
 #include "common/resources_utils.hpp"
+#include "common/tracer.hpp"
 
 #include "files/files.hpp"
 
 #include "master/constants.hpp"
 #include "master/contender.hpp"
 #include "master/detector.hpp"
+#include "master/event_history.hpp"
 #include "master/flags.hpp"
 #include "master/metrics.hpp"
 #include "master/registrar.hpp"
+#include "master/task_store.hpp"
 #include "master/validation.hpp"
 
 #include "messages/messages.hpp"
@@ -85,10 +94,67 @@ class WhitelistWatcher;
 
 namespace master {
 
+class Master;
 class Repairer;
 class SlaveObserver;
+class SnapshotProcess;
 
 struct BoundedRateLimiter;
+struct Snapshot;
+
+
+// Returns the task with only the parts of its statuses that the
+// master keeps (see 'protobuf::createTaskStatusSummary'), e.g., for
+// the tasks reported by a slave, which keeps the entire statuses.
+inline Task summarize(const Task& task)
+{
+  Task summary = task;
+  summary.clear_statuses();
+
+  foreach (const TaskStatus& status, task.statuses()) {
+    summary.add_statuses()->CopyFrom(
+        protobuf::createTaskStatusSummary(status));
+  }
+
+  return summary;
+}
+
+
+struct Slave;
+
+
+// Cluster wide totals of the registered slaves, which the slaves keep
+// up to date as their tasks and resources change (see 'Slave::totals')
+// so that the master's gauges do not need to walk all the slaves.
+struct SlaveTotals
+{
+  // Adds (removes) a registered slave.
+  void add(const Slave& slave);
+  void remove(const Slave& slave);
+
+  // Adds the non-revocable scalar resources, multiplied by 'sign', to
+  // 'scalars'.
+  static void add(
+      const Resources& resources,
+      hashmap<std::string, double>* scalars,
+      double sign = 1.0)
+  {
+    foreach (const Resource& resource, resources) {
+      if (resource.type() == Value::SCALAR && !resource.has_revocable()) {
+        (*scalars)[resource.name()] += sign * resource.scalar().value();
+      }
+    }
+  }
+
+  // The number of tasks in each state.
+  hashmap<TaskState, size_t> taskStates;
+
+  // The scalar resources of the slaves ('SlaveInfo' resources).
+  hashmap<std::string, double> totalResources;
+
+  // The scalar resources used by tasks and executors.
+  hashmap<std::string, double> usedResources;
+};
 
 
 struct Slave
@@ -109,8 +175,10 @@ struct Slave
       registeredTime(_registeredTime),
       connected(true),
       active(true),
-      checkpointedResources(_checkpointedResources),
-      observer(NULL)
+      healthy(true),
+      batchesStatusUpdates(false),
+      totals(NULL),
+      checkpointedResources(_checkpointedResources)
   {
     CHECK(_info.has_id());
 
@@ -128,7 +196,7 @@ struct Slave
     }
 
     foreach (const Task& task, tasks) {
-      addTask(new Task(task));
+      addTask(new Task(summarize(task)));
     }
   }
 
@@ -151,9 +219,14 @@ struct Slave
       << "Duplicate task " << taskId << " of framework " << frameworkId;
 
     tasks[frameworkId][taskId] = task;
+    taskStates[task->state()]++;
+
+    if (totals != NULL) {
+      totals->taskStates[task->state()]++;
+    }
 
     if (!protobuf::isTerminalState(task->state())) {
-      usedResources[frameworkId] += task->resources();
+      used(frameworkId, task->resources());
     }
 
     LOG(INFO) << "Adding task " << taskId
@@ -161,6 +234,26 @@ struct Slave
               << " on slave " << id << " (" << info.hostname() << ")";
   }
 
+  // Transitions the task to 'state', see 'taskStates'.
+  void updateTaskState(Task* task, const TaskState& state)
+  {
+    CHECK(tasks[task->framework_id()].contains(task->task_id()))
+      << "Unknown task " << task->task_id()
+      << " of framework " << task->framework_id();
+
+    taskStates[task->state()]--;
+    if (totals != NULL) {
+      totals->taskStates[task->state()]--;
+    }
+
+    task->set_state(state);
+
+    taskStates[task->state()]++;
+    if (totals != NULL) {
+      totals->taskStates[task->state()]++;
+    }
+  }
+
   // Notification of task termination, for resource accounting.
   // TODO(bmahler): This is a hack for performance. We need to
   // maintain resource counters because computing task resources
@@ -174,7 +267,7 @@ struct Slave
     CHECK(tasks[frameworkId].contains(taskId))
       << "Unknown task " << taskId << " of framework " << frameworkId;
 
-    usedResources[frameworkId] -= task->resources();
+    used(frameworkId, task->resources(), -1.0);
     if (!tasks.contains(frameworkId) && !executors.contains(frameworkId)) {
       usedResources.erase(frameworkId);
     }
@@ -189,7 +282,7 @@ struct Slave
       << "Unknown task " << taskId << " of framework " << frameworkId;
 
     if (!protobuf::isTerminalState(task->state())) {
-      usedResources[frameworkId] -= task->resources();
+      used(frameworkId, task->resources(), -1.0);
       if (!tasks.contains(frameworkId) && !executors.contains(frameworkId)) {
         usedResources.erase(frameworkId);
       }
@@ -200,6 +293,14 @@ struct Slave
       tasks.erase(frameworkId);
     }
 
+    if (--taskStates[task->state()] == 0) {
+      taskStates.erase(task->state());
+    }
+
+    if (totals != NULL) {
+      totals->taskStates[task->state()]--;
+    }
+
     killedTasks.remove(frameworkId, taskId);
   }
 
@@ -234,7 +335,7 @@ struct Slave
       << " of framework " << frameworkId;
 
     executors[frameworkId][executorInfo.executor_id()] = executorInfo;
-    usedResources[frameworkId] += executorInfo.resources();
+    used(frameworkId, executorInfo.resources());
   }
 
   void removeExecutor(const FrameworkID& frameworkId,
@@ -243,8 +344,7 @@ struct Slave
     CHECK(hasExecutor(frameworkId, executorId))
       << "Unknown executor " << executorId << " of framework " << frameworkId;
 
-    usedResources[frameworkId] -=
-      executors[frameworkId][executorId].resources();
+    used(frameworkId, executors[frameworkId][executorId].resources(), -1.0);
 
     // XXX Remove.
 
@@ -254,6 +354,24 @@ struct Slave
     }
   }
 
+  // Adds (or with 'sign' -1.0 removes) resources used by the given
+  // framework, see 'usedResources'.
+  void used(
+      const FrameworkID& frameworkId,
+      const Resources& resources,
+      double sign = 1.0)
+  {
+    if (sign > 0) {
+      usedResources[frameworkId] += resources;
+    } else {
+      usedResources[frameworkId] -= resources;
+    }
+
+    if (totals != NULL) {
+      SlaveTotals::add(resources, &totals->usedResources, sign);
+    }
+  }
+
   void apply(const Offer::Operation& operation)
   {
     Try<Resources> resources = totalResources.apply(operation);
@@ -284,6 +402,21 @@ struct Slave
   // No offers will be made for a deactivated slave.
   bool active;
 
+  // Slave becomes unhealthy when a monitor observes its host as
+  // unhealthy (see Repairer). No offers will be made for an unhealthy
+  // slave either, i.e., the allocator only activates a slave that is
+  // both active and healthy.
+  bool healthy;
+
+  // Whether the slave batches its status updates, in which case the
+  // master batches the acknowledgements it forwards to the slave.
+  // Reset when the slave re-registers (it might have restarted with
+  // batching disabled).
+  bool batchesStatusUpdates;
+
+  // The totals of the master this slave is registered with, if any.
+  SlaveTotals* totals;
+
   // Executors running on this slave.
   hashmap<FrameworkID, hashmap<ExecutorID, ExecutorInfo>> executors;
 
@@ -293,6 +426,11 @@ struct Slave
   // We should find a way to eliminate this.
   hashmap<FrameworkID, hashmap<TaskID, Task*>> tasks;
 
+  // The number of tasks in each state, maintained as the tasks are
+  // added, updated (see 'updateTaskState') and removed so that the
+  // task gauges of the master don't need to walk all tasks.
+  hashmap<TaskState, size_t> taskStates;
+
   // Tasks that were asked to kill by frameworks.
   // This is used for reconciliation when the slave re-registers.
   multihashmap<FrameworkID, TaskID> killedTasks;
@@ -303,6 +441,10 @@ struct Slave
   hashmap<FrameworkID, Resources> usedResources;  // Active task / executors.
   Resources offeredResources; // Offers.
 
+  // The resource usage of all executors on this slave, as last
+  // reported by the slave in a pong (see 'Master::updateUsage').
+  Option<ResourceStatistics> usage;
+
   // Resources that should be checkpointed by the slave (e.g.,
   // persistent volumes, dynamic reservations, etc). These are either
   // in use by a task/executor, or are available for use and will be
@@ -314,8 +456,6 @@ struct Slave
   // operations (e.g., CREATE, RESERVE) that have been applied.
   Resources totalResources;
 
-  SlaveObserver* observer;
-
 private:
   Slave(const Slave&);              // No copying.
   Slave& operator = (const Slave&); // No assigning.
@@ -329,21 +469,172 @@ inline std::ostream& operator << (std::ostream& stream, const Slave& slave)
 }
 
 
+inline void SlaveTotals::add(const Slave& slave)
+{
+  foreachpair (const TaskState& state, size_t count, slave.taskStates) {
+    taskStates[state] += count;
+  }
+
+  add(slave.info.resources(), &totalResources);
+
+  foreachvalue (const Resources& resources, slave.usedResources) {
+    add(resources, &usedResources);
+  }
+}
+
+
+inline void SlaveTotals::remove(const Slave& slave)
+{
+  foreachpair (const TaskState& state, size_t count, slave.taskStates) {
+    taskStates[state] -= count;
+  }
+
+  add(slave.info.resources(), &totalResources, -1.0);
+
+  foreachvalue (const Resources& resources, slave.usedResources) {
+    add(resources, &usedResources, -1.0);
+  }
+}
+
+
+// The streaming connection of a framework that subscribed over HTTP,
+// i.e., the chunked response to its SUBSCRIBE call, over which the
+// master sends the events to the framework.
+struct HttpConnection
+{
+  HttpConnection(const process::http::Pipe::Writer& _writer,
+                 const std::string& _contentType,
+                 const std::string& _streamId)
+    : writer(_writer),
+      contentType(_contentType),
+      streamId(_streamId) {}
+
+  // Converts the message into the corresponding event(s) and writes
+  // them to the stream. Returns false if the connection is closed.
+  template <typename Message>
+  bool send(const Message& message)
+  {
+    return write(evolve(message));
+  }
+
+  bool send(const RescindResourceOfferMessage& message)
+  {
+    foreach (const scheduler::Event& event, evolve(message)) {
+      if (!write(event)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool send(const StatusUpdatesMessage& message)
+  {
+    foreach (const scheduler::Event& event, evolve(message)) {
+      if (!write(event)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool write(const scheduler::Event& event)
+  {
+    return writer.write(recordio::encode(serialize(contentType, event)));
+  }
+
+  bool close()
+  {
+    return writer.close();
+  }
+
+  // Satisfied when the framework closes the connection.
+  process::Future<Nothing> closed()
+  {
+    return writer.readerClosed();
+  }
+
+  process::http::Pipe::Writer writer;
+
+  // The media type of the events, see common/http.hpp.
+  std::string contentType;
+
+  // Distinguishes the connections of a framework across failovers.
+  // It is returned to the framework when it subscribes, and the other
+  // calls of the framework must carry it (see 'Mesos-Stream-Id' in
+  // master/http.cpp), so it is not guessable, see 'generateToken'.
+  std::string streamId;
+};
+
+
+struct Framework;
+
+
+// Information about an active role. The resources of the role are
+// rolled up as the resources of its frameworks change (see
+// 'Framework::role') rather than summed up on every request.
+struct Role
+{
+  explicit Role(const mesos::master::RoleInfo& _info)
+    : info(_info) {}
+
+  void addFramework(Framework* framework);
+  void removeFramework(Framework* framework);
+
+  Resources resources() const
+  {
+    return used + offered;
+  }
+
+  mesos::master::RoleInfo info;
+
+  hashmap<FrameworkID, Framework*> frameworks;
+
+  // Resources used by the tasks and executors of the frameworks.
+  Resources used;
+
+  // Resources offered to the frameworks.
+  Resources offered;
+
+  // Resources reserved for the role on the registered slaves, see
+  // 'Master::updateReservations'.
+  Resources reserved;
+};
+
+
 // Information about a connected or completed framework.
 // TODO(bmahler): Keeping the task and executor information in sync
 // across the Slave and Framework structs is error prone!
 struct Framework
 {
-  Framework(const FrameworkInfo& _info,
+  Framework(Master* const _master,
+            const FrameworkInfo& _info,
             const process::UPID& _pid,
             const process::Time& time = process::Clock::now())
-    : info(_info),
+    : master(_master),
+      info(_info),
       pid(_pid),
       connected(true),
       active(true),
       registeredTime(time),
       reregisteredTime(time),
-      completedTasks(MAX_COMPLETED_TASKS_PER_FRAMEWORK) {}
+      completedTasks(MAX_COMPLETED_TASKS_PER_FRAMEWORK),
+      role(NULL) {}
+
+  Framework(Master* const _master,
+            const FrameworkInfo& _info,
+            const HttpConnection& _http,
+            const process::Time& time = process::Clock::now())
+    : master(_master),
+      info(_info),
+      http(_http),
+      connected(true),
+      active(true),
+      registeredTime(time),
+      reregisteredTime(time),
+      completedTasks(MAX_COMPLETED_TASKS_PER_FRAMEWORK),
+      role(NULL) {}
 
   ~Framework() {}
 
@@ -365,8 +656,15 @@ struct Framework
     tasks[task->task_id()] = task;
 
     if (!protobuf::isTerminalState(task->state())) {
-      totalUsedResources += task->resources();
-      usedResources[task->slave_id()] += task->resources();
+      // Validate (and combine) the resources once.
+      const Resources resources = task->resources();
+
+      totalUsedResources += resources;
+      usedResources[task->slave_id()] += resources;
+
+      if (role != NULL) {
+        role->used += resources;
+      }
     }
   }
 
@@ -381,17 +679,29 @@ struct Framework
       << "Unknown task " << task->task_id()
       << " of framework " << task->framework_id();
 
-    totalUsedResources -= task->resources();
-    usedResources[task->slave_id()] -= task->resources();
+    const Resources resources = task->resources();
+
+    totalUsedResources -= resources;
+    usedResources[task->slave_id()] -= resources;
     if (usedResources[task->slave_id()].empty()) {
       usedResources.erase(task->slave_id());
     }
+
+    if (role != NULL) {
+      role->used -= resources;
+    }
   }
 
   void addCompletedTask(const Task& task)
   {
     // TODO(adam-mesos): Check if completed task already exists.
-    completedTasks.push_back(std::shared_ptr<Task>(new Task(task)));
+    if (completedTaskStore.get() != NULL) {
+      completedTasks.push_back(std::shared_ptr<CompletedTask>(
+          new CompletedTask(task, completedTaskStore)));
+    } else {
+      completedTasks.push_back(
+          std::shared_ptr<CompletedTask>(new CompletedTask(task)));
+    }
   }
 
   void removeTask(Task* task)
@@ -401,11 +711,17 @@ struct Framework
       << " of framework " << task->framework_id();
 
     if (!protobuf::isTerminalState(task->state())) {
-      totalUsedResources -= task->resources();
-      usedResources[task->slave_id()] -= task->resources();
+      const Resources resources = task->resources();
+
+      totalUsedResources -= resources;
+      usedResources[task->slave_id()] -= resources;
       if (usedResources[task->slave_id()].empty()) {
         usedResources.erase(task->slave_id());
       }
+
+      if (role != NULL) {
+        role->used -= resources;
+      }
     }
 
     addCompletedTask(*task);
@@ -419,6 +735,10 @@ struct Framework
     offers.insert(offer);
     totalOfferedResources += offer->resources();
     offeredResources[offer->slave_id()] += offer->resources();
+
+    if (role != NULL) {
+      role->offered += offer->resources();
+    }
   }
 
   void removeOffer(Offer* offer)
@@ -432,6 +752,10 @@ struct Framework
       offeredResources.erase(offer->slave_id());
     }
 
+    if (role != NULL) {
+      role->offered -= offer->resources();
+    }
+
     offers.erase(offer);
   }
 
@@ -450,8 +774,15 @@ struct Framework
       << " on slave " << slaveId;
 
     executors[slaveId][executorInfo.executor_id()] = executorInfo;
-    totalUsedResources += executorInfo.resources();
-    usedResources[slaveId] += executorInfo.resources();
+
+    const Resources resources = executorInfo.resources();
+
+    totalUsedResources += resources;
+    usedResources[slaveId] += resources;
+
+    if (role != NULL) {
+      role->used += resources;
+    }
   }
 
   void removeExecutor(const SlaveID& slaveId,
@@ -468,6 +799,10 @@ struct Framework
       usedResources.erase(slaveId);
     }
 
+    if (role != NULL) {
+      role->used -= executors[slaveId][executorId].resources();
+    }
+
     executors[slaveId].erase(executorId);
     if (executors[slaveId].empty()) {
       executors.erase(slaveId);
@@ -476,6 +811,11 @@ struct Framework
 
   const FrameworkID id() const { return info.id(); }
 
+  // Sends the message to the scheduler, either to its 'pid' or, if
+  // the framework subscribed over HTTP, as an event on its stream.
+  template <typename Message>
+  void send(const Message& message);
+
   // Update fields in 'info' using those in 'source'. Currently this
   // only updates 'name', 'failover_timeout', 'hostname', and
   // 'webui_url'.
@@ -531,10 +871,17 @@ struct Framework
     }
   }
 
+  Master* const master;
+
   FrameworkInfo info;
 
+  // Only one of 'pid' and 'http' is set, depending on whether the
+  // framework is driven by libprocess messages or subscribed over
+  // HTTP (in which case 'pid' is empty).
   process::UPID pid;
 
+  Option<HttpConnection> http;
+
   // Framework becomes disconnected when the socket closes.
   bool connected;
 
@@ -553,10 +900,14 @@ struct Framework
 
   hashmap<TaskID, Task*> tasks;
 
-  // NOTE: We use a shared pointer for Task because clang doesn't like
-  // Boost's implementation of circular_buffer with Task (Boost
-  // attempts to do some memset's which are unsafe).
-  boost::circular_buffer<std::shared_ptr<Task>> completedTasks;
+  // NOTE: We use a shared pointer for CompletedTask because clang
+  // doesn't like Boost's implementation of circular_buffer with
+  // protobufs (Boost attempts to do some memset's which are unsafe).
+  boost::circular_buffer<std::shared_ptr<CompletedTask>> completedTasks;
+
+  // Where the completed tasks are kept if '--completed_tasks_dir'
+  // is set, otherwise NULL (i.e., they are kept in memory).
+  std::shared_ptr<TaskStore> completedTaskStore;
 
   hashset<Offer*> offers; // Active offers for framework.
 
@@ -592,6 +943,10 @@ struct Framework
   Resources totalOfferedResources;
   hashmap<SlaveID, Resources> offeredResources;
 
+  // The role of the framework while it is registered, whose resources
+  // are kept up to date along with the totals above.
+  Role* role;
+
 private:
   Framework(const Framework&);              // No copying.
   Framework& operator = (const Framework&); // No assigning.
@@ -604,42 +959,38 @@ inline std::ostream& operator << (
 {
   // TODO(vinod): Also log the hostname once FrameworkInfo is properly
   // updated on framework failover (MESOS-1784).
-  return stream << framework.id() << " (" << framework.info.name()
-                << ") at " << framework.pid;
+  stream << framework.id() << " (" << framework.info.name() << ")";
+
+  if (framework.http.isSome()) {
+    return stream << " over HTTP";
+  }
+
+  return stream << " at " << framework.pid;
 }
 
 
-// Information about an active role.
-struct Role
+inline void Role::addFramework(Framework* framework)
 {
-  explicit Role(const mesos::master::RoleInfo& _info)
-    : info(_info) {}
+  CHECK(framework->role == NULL);
 
-  void addFramework(Framework* framework)
-  {
-    frameworks[framework->id()] = framework;
-  }
+  frameworks[framework->id()] = framework;
+  framework->role = this;
 
-  void removeFramework(Framework* framework)
-  {
-    frameworks.erase(framework->id());
-  }
+  used += framework->totalUsedResources;
+  offered += framework->totalOfferedResources;
+}
 
-  Resources resources() const
-  {
-    Resources resources;
-    foreachvalue (Framework* framework, frameworks) {
-      resources += framework->totalUsedResources;
-      resources += framework->totalOfferedResources;
-    }
 
-    return resources;
-  }
+inline void Role::removeFramework(Framework* framework)
+{
+  CHECK(framework->role == this);
 
-  mesos::master::RoleInfo info;
+  frameworks.erase(framework->id());
+  framework->role = NULL;
 
-  hashmap<FrameworkID, Framework*> frameworks;
-};
+  used -= framework->totalUsedResources;
+  offered -= framework->totalOfferedResources;
+}
 
 
 class Master : public ProtobufProcess<Master>
@@ -696,11 +1047,20 @@ public:
       const process::UPID& from,
       const FrameworkID& frameworkId);
 
+  void suppressOffers(
+      const process::UPID& from,
+      const FrameworkID& frameworkId);
+
   void killTask(
       const process::UPID& from,
       const FrameworkID& frameworkId,
       const TaskID& taskId);
 
+  void killTasks(
+      const process::UPID& from,
+      const FrameworkID& frameworkId,
+      const std::vector<TaskID>& taskIds);
+
   void statusUpdateAcknowledgement(
       const process::UPID& from,
       const SlaveID& slaveId,
@@ -708,6 +1068,18 @@ public:
       const TaskID& taskId,
       const std::string& uuid);
 
+  void statusUpdateAcknowledgements(
+      const process::UPID& from,
+      const std::vector<StatusUpdateAcknowledgementMessage>& acknowledgements);
+
+  // Handles an acknowledgement of either of the above messages.
+  void _statusUpdateAcknowledgement(
+      const process::UPID& from,
+      const SlaveID& slaveId,
+      const FrameworkID& frameworkId,
+      const TaskID& taskId,
+      const std::string& uuid);
+
   void schedulerMessage(
       const process::UPID& from,
       const SlaveID& slaveId,
@@ -715,12 +1087,28 @@ public:
       const ExecutorID& executorId,
       const std::string& data);
 
+  // Forwards the framework messages of the executors of the
+  // frameworks that subscribed over HTTP, for which the slaves are
+  // given the master's pid in place of the framework's.
+  void executorMessage(
+      const process::UPID& from,
+      const SlaveID& slaveId,
+      const FrameworkID& frameworkId,
+      const ExecutorID& executorId,
+      const std::string& data);
+
   void registerSlave(
       const process::UPID& from,
       const SlaveInfo& slaveInfo,
       const std::vector<Resource>& checkpointedResources,
       const std::string& version);
 
+  // Refuses the re-registration of unauthenticated or removed slaves
+  // before parsing their message, which carries all of their tasks.
+  void reregisterSlave(
+      const process::UPID& from,
+      const process::Lazy<ReregisterSlaveMessage>& message);
+
   void reregisterSlave(
       const process::UPID& from,
       const SlaveInfo& slaveInfo,
@@ -738,6 +1126,10 @@ public:
       const StatusUpdate& update,
       const process::UPID& pid);
 
+  void statusUpdates(
+      const process::UPID& from,
+      const std::vector<StatusUpdateMessage>& updates);
+
   void reconcileTasks(
       const process::UPID& from,
       const FrameworkID& frameworkId,
@@ -754,6 +1146,12 @@ public:
       const SlaveID& slaveId,
       const std::vector<Resource>& oversubscribedResources);
 
+  // Invoked by the slave observer when a slave reports the resource
+  // usage of its executors.
+  void updateUsage(
+      const SlaveID& slaveId,
+      const ResourceStatistics& usage);
+
   void shutdownSlave(
       const SlaveID& slaveId,
       const std::string& message);
@@ -809,7 +1207,20 @@ protected:
   virtual void initialize();
   virtual void finalize();
   virtual void exited(const process::UPID& pid);
+
+  // Invoked when the HTTP connection of a framework is closed.
+  void exited(const FrameworkID& frameworkId, const HttpConnection& http);
+
+  // Disconnects the framework and gives it its failover timeout to
+  // reconnect.
+  void _exited(Framework* framework);
+
+  // Bumps the 'version' after serving an event that may have changed
+  // the state of the master.
+  virtual void serve(const process::Event& event);
+
   virtual void visit(const process::MessageEvent& event);
+  virtual void visit(const process::HttpEvent& event);
   virtual void visit(const process::ExitedEvent& event);
 
   // Invoked when the message is ready to be executed after
@@ -833,7 +1244,17 @@ protected:
 
   // Recovers state from the registrar.
   process::Future<Nothing> recover();
-  void recoveredSlavesTimeout(const Registry& registry);
+  void recoveredSlavesTimeout(int total);
+
+  // Returns whether the (re-)registration of the slave at 'pid' is
+  // to be deferred due to '--slave_registration_rate_limit', in
+  // which case the slave has been told when to retry.
+  bool throttle(const process::UPID& pid);
+
+  // Returns whether low priority work (i.e., task reconciliation and
+  // state requests) should be shed because the master is falling
+  // behind, see '--max_event_queue_age'.
+  bool overloaded();
 
   void _registerSlave(
       const SlaveInfo& slaveInfo,
@@ -865,6 +1286,15 @@ protected:
       Framework* framework,
       const std::vector<TaskStatus>& statuses);
 
+  // Sends a reconciliation update to the framework, unless a 'batch'
+  // is given (i.e., the framework has the BATCHED_RECONCILIATION
+  // capability), in which case the update is added to the batch and
+  // the batch is sent once it is full.
+  void sendReconciliation(
+      Framework* framework,
+      const StatusUpdate& update,
+      StatusUpdatesMessage* batch);
+
   // Handles a known re-registering slave by reconciling the master's
   // view of the slave's tasks and executors.
   void reconcile(
@@ -892,6 +1322,13 @@ protected:
   // the event of a scheduler failover.
   void failoverFramework(Framework* framework, const process::UPID& newPid);
 
+  // Replace the scheduler for a framework with a new HTTP connection,
+  // in the event of a scheduler failover.
+  void failoverFramework(Framework* framework, const HttpConnection& http);
+
+  // Common continuation of the above.
+  void _failoverFramework(Framework* framework);
+
   // Kill all of a framework's tasks, delete the framework object, and
   // reschedule offers that were assigned to this framework.
   void removeFramework(Framework* framework);
@@ -958,13 +1395,23 @@ protected:
       const FrameworkID& frameworkId,
       const ExecutorID& executorId);
 
-  // Updates slave's resources by applying the given operation. It
-  // also updates the allocator and sends a CheckpointResourcesMessage
-  // to the slave with slave's current checkpointed resources.
-  void applyOfferOperation(
+  // Updates the resources reserved for the known roles as resources
+  // are added to or removed from the registered slaves.
+  void updateReservations(const Resources& added, const Resources& removed);
+
+  // Updates slave's resources by applying the given operation. The
+  // allocator and the slave only learn about the applied operations
+  // once they get committed, see 'commitOfferOperations'.
+  void applyOfferOperation(Slave* slave, const Offer::Operation& operation);
+
+  // Updates the allocator with the given operations (in order), which
+  // have been applied to the slave's resources, and sends a single
+  // CheckpointResourcesMessage to the slave with slave's current
+  // checkpointed resources.
+  void commitOfferOperations(
       Framework* framework,
       Slave* slave,
-      const Offer::Operation& operation);
+      const std::vector<Offer::Operation>& operations);
 
   // Forwards the update to the framework.
   void forward(
@@ -972,12 +1419,35 @@ protected:
       const process::UPID& acknowledgee,
       Framework* framework);
 
-  // Remove an offer after specified timeout
-  void offerTimeout(const OfferID& offerId);
+  // Sends the acknowledgements batched for the slave.
+  void flushAcknowledgements(const SlaveID& slaveId);
+
+  // Removes the offers that outlived '--offer_timeout'.
+  void expireOffers();
+
+  // Removes and rescinds the offers, recovering their resources.
+  // The offers of a framework with the COMPACT_OFFERS capability are
+  // rescinded with a single message.
+  void rescindOffers(const std::vector<Offer*>& offers);
+
+  // Stops (or resumes) offering the resources of the slaves on the
+  // given hosts if they became unhealthy (or healthy again) according
+  // to the repairer.
+  void updateHealth(const hashset<std::string>& hosts);
 
   // Remove an offer and optionally rescind the offer as well.
   void removeOffer(Offer* offer, bool rescind = false);
 
+  // Appends an event to the history if '--event_history_dir' is set.
+  // The 'id' is the ID of the offer or of the task of the event.
+  void record(
+      EventHistory::Type type,
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId,
+      const std::string& id,
+      const Resources& resources,
+      int state = 0);
+
   Framework* getFramework(const FrameworkID& frameworkId);
   Offer* getOffer(const OfferID& offerId);
 
@@ -998,21 +1468,52 @@ private:
       const Offer::Operation& operation,
       const std::string& message);
 
+  void drop(
+      Framework* framework,
+      const scheduler::Call& call,
+      const std::string& message);
+
   // Call handlers.
   void receive(
       const process::UPID& from,
       const scheduler::Call& call);
 
+  // Handles a call of a known framework, i.e., any call other than
+  // SUBSCRIBE, be it sent as a message or over HTTP.
+  void receive(
+      Framework* framework,
+      const scheduler::Call& call);
+
+  // Handles a SUBSCRIBE call sent over HTTP.
+  void subscribe(
+      const HttpConnection& http,
+      const FrameworkInfo& frameworkInfo);
+
+  void _subscribe(
+      const HttpConnection& http,
+      const FrameworkInfo& frameworkInfo,
+      const process::Future<Option<Error>>& validationError);
+
   void accept(
       Framework* framework,
       const scheduler::Call::Accept& accept);
 
+  void decline(
+      Framework* framework,
+      const scheduler::Call::Decline& decline);
+
   void _accept(
     const FrameworkID& frameworkId,
     const SlaveID& slaveId,
     const Resources& offeredResources,
     const scheduler::Call::Accept& accept,
-    const process::Future<std::list<process::Future<bool>>>& authorizations);
+    const hashmap<std::string, process::Future<bool>>& authorizations);
+
+  // Sends the given messages of a LAUNCH operation to the slave,
+  // batched in a 'RunTasksMessage' if the slave supports it.
+  void sendRunTaskMessages(
+      Slave* slave,
+      const std::vector<RunTaskMessage>& messages);
 
   void reconcile(
       Framework* framework,
@@ -1026,6 +1527,18 @@ private:
       Framework* framework,
       const scheduler::Call::Shutdown& shutdown);
 
+  void acknowledge(
+      Framework* framework,
+      const SlaveID& slaveId,
+      const TaskID& taskId,
+      const std::string& uuid);
+
+  void message(
+      Framework* framework,
+      const SlaveID& slaveId,
+      const ExecutorID& executorId,
+      const std::string& data);
+
   bool elected() const
   {
     return leader.isSome() && leader.get() == info_;
@@ -1042,6 +1555,10 @@ private:
     // desired request handler to get consistent request logging.
     static void log(const process::http::Request& request);
 
+    // /master/events
+    process::Future<process::http::Response> events(
+        const process::http::Request& request) const;
+
     // /master/health
     process::Future<process::http::Response> health(
         const process::http::Request& request) const;
@@ -1058,6 +1575,10 @@ private:
     process::Future<process::http::Response> roles(
         const process::http::Request& request) const;
 
+    // /master/api/v1/scheduler
+    process::Future<process::http::Response> scheduler(
+        const process::http::Request& request) const;
+
     // /master/teardown and /master/shutdown (deprecated).
     process::Future<process::http::Response> teardown(
         const process::http::Request& request) const;
@@ -1078,16 +1599,37 @@ private:
     process::Future<process::http::Response> tasks(
         const process::http::Request& request) const;
 
+    // /master/utilization
+    process::Future<process::http::Response> utilization(
+        const process::http::Request& request) const;
+
+    // /master/memory
+    process::Future<process::http::Response> memory(
+        const process::http::Request& request) const;
+
+    // /master/trace
+    process::Future<process::http::Response> trace(
+        const process::http::Request& request) const;
+
+    // Takes a snapshot of the read-only endpoints above, see
+    // master/snapshot.hpp.
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+    const static std::string EVENTS_HELP;
     const static std::string HEALTH_HELP;
     const static std::string OBSERVE_HELP;
     const static std::string REDIRECT_HELP;
     const static std::string ROLES_HELP;
+    const static std::string SCHEDULER_HELP;
     const static std::string SHUTDOWN_HELP;  // Deprecated.
     const static std::string TEARDOWN_HELP;
     const static std::string SLAVES_HELP;
     const static std::string STATE_HELP;
     const static std::string STATESUMMARY_HELP;
     const static std::string TASKS_HELP;
+    const static std::string UTILIZATION_HELP;
+    const static std::string MEMORY_HELP;
+    const static std::string TRACE_HELP;
 
   private:
     // Helper for doing authentication, returns the credential used if
@@ -1101,12 +1643,29 @@ private:
         const FrameworkID& id,
         bool authorized = true) const;
 
+    // Helpers shared by the endpoints and snapshots.
+    JSON::Object _slaves() const;
+    JSON::Object _stateSummary() const;
+
+    // Returns the tasks of all (including completed) frameworks,
+    // optionally only those of the specified framework and/or role.
+    // The completed tasks are owned by 'completed', which must
+    // outlive the returned tasks.
+    std::vector<const Task*> _tasks(
+        const Option<std::string>& frameworkId,
+        const Option<std::string>& role,
+        std::vector<std::shared_ptr<const Task>>* completed) const;
+
+    // Streams the response of /master/state.json.
+    class StateStream;
+
     Master* master;
   };
 
   Master(const Master&);              // No copying.
   Master& operator = (const Master&); // No assigning.
 
+  friend struct Framework;
   friend struct Metrics;
 
   // NOTE: Since 'getOffer' and 'slaves' are protected,
@@ -1149,7 +1708,12 @@ private:
     // Slaves that have been recovered from the registrar but have yet
     // to re-register. We keep a "reregistrationTimer" above to ensure
     // we remove these slaves if they do not re-register.
-    hashset<SlaveID> recovered;
+    // NOTE: Only the hostnames are kept (rather than the registry or
+    // the full 'SlaveInfo's, which include the resources and
+    // attributes) since that is all that's needed to remove a slave,
+    // which keeps recovery cheap for large registries. The entries are
+    // dropped as the slaves re-register.
+    hashmap<SlaveID, std::string> recovered;
 
     // Slaves that are in the process of registering.
     hashset<process::UPID> registering;
@@ -1245,6 +1809,22 @@ private:
     // a wrapper around libprocess process which is thread safe.
     Option<std::shared_ptr<process::RateLimiter>> limiter;
 
+    // Paces the (re-)registration of the slaves that are not
+    // registered with the master, e.g., all of them after a master
+    // failover (see 'Master::throttle'). A slave exceeding the rate
+    // is given a time slot at which to retry, which is kept until
+    // the slave is admitted or for one 'window' past the slot.
+    struct Admission
+    {
+      Duration interval; // Between two admitted slaves.
+      Duration window; // Over which the rate is enforced.
+      process::Time next; // The earliest slot to give out.
+      hashmap<process::UPID, process::Time> slots;
+      std::deque<std::pair<process::Time, process::UPID>> expirations;
+    };
+
+    Option<Admission> admission;
+
     bool transitioning(const Option<SlaveID>& slaveId)
     {
       if (slaveId.isSome()) {
@@ -1259,6 +1839,9 @@ private:
     }
   } slaves;
 
+  // Totals of the registered slaves for the metrics, see 'SlaveTotals'.
+  SlaveTotals totals;
+
   struct Frameworks
   {
     Frameworks() : completed(MAX_COMPLETED_FRAMEWORKS) {}
@@ -1288,7 +1871,25 @@ private:
   } frameworks;
 
   hashmap<OfferID, Offer*> offers;
-  hashmap<OfferID, process::Timer> offerTimers;
+
+  // The offers in order of creation, with the times at which they
+  // expire due to '--offer_timeout', which lets a single timer
+  // expire all of the offers (see 'expireOffers'). The offers that
+  // are removed before expiring are skipped.
+  std::deque<std::pair<process::Time, OfferID>> offerExpirations;
+  Option<process::Timer> offerTimer;
+
+  // Messages reused to send offers and status updates to frameworks.
+  // Clearing a protobuf keeps its repeated (sub)messages and strings
+  // allocated, which saves allocating them all again for every offer
+  // and update. NOTE: 'send' serializes (or copies) a message before
+  // returning so they can be reused right away.
+  ResourceOffersMessage offersMessage;
+  StatusUpdateMessage statusUpdateMessage;
+
+  // Acknowledgements batched for slaves that batch their status
+  // updates, see 'flushAcknowledgements'.
+  hashmap<SlaveID, StatusUpdateAcknowledgementsMessage> acknowledgements;
 
   hashmap<std::string, Role*> roles;
 
@@ -1357,6 +1958,11 @@ private:
     return static_cast<double>(eventCount<process::HttpEvent>());
   }
 
+  double _event_queue_age_secs()
+  {
+    return eventAge().secs();
+  }
+
   double _tasks_staging();
   double _tasks_starting();
   double _tasks_running();
@@ -1369,6 +1975,37 @@ private:
 
   Option<process::Time> electedTime; // Time when this master is elected.
 
+  // The version of the state of the master, bumped after every event
+  // unless the event is known to only read the state, i.e., a request
+  // with a safe method (see 'visit(const HttpEvent&)') or an event
+  // that sets 'reading'. Spurious bumps (e.g., when reading metrics)
+  // only cost a full response, but a change never goes unnoticed.
+  // Together with the ID of the master it forms the ETag of the
+  // read-only endpoints, see 'etag()'.
+  uint64_t version;
+  bool reading;
+
+  // Returns the ETag of the current version of the state.
+  std::string etag() const;
+
+  // Serves the read-only HTTP endpoints from snapshots if
+  // '--http_snapshot_interval' is set, otherwise NULL.
+  SnapshotProcess* snapshots;
+
+  // Keeps the completed tasks of the frameworks if
+  // '--completed_tasks_dir' is set, otherwise NULL.
+  std::shared_ptr<TaskStore> completedTaskStore;
+
+  // Keeps the history of the offers and tasks if '--event_history_dir'
+  // is set, otherwise NULL.
+  std::shared_ptr<EventHistory> eventHistory;
+
+  // Checks the health of all the registered slaves.
+  SlaveObserver* observer;
+
+  // Traces a sample of the task launches (see '--trace_sampling_rate').
+  Tracer tracer;
+
   // Validates the framework including authorization.
   // Returns None if the framework is valid.
   // Returns Error if the framework is invalid.
@@ -1376,9 +2013,29 @@ private:
   process::Future<Option<Error>> validate(
       const FrameworkInfo& frameworkInfo,
       const process::UPID& from);
+
+  // Validates the role of the framework, including authorization,
+  // which is all that is left to validate for a framework that
+  // subscribed over HTTP (authentication is done per request).
+  process::Future<Option<Error>> validate(
+      const FrameworkInfo& frameworkInfo);
 };
 
 
+template <typename Message>
+void Framework::send(const Message& message)
+{
+  if (http.isSome()) {
+    if (!http.get().send(message)) {
+      LOG(WARNING) << "Unable to send event to framework " << *this
+                   << ": connection closed";
+    }
+  } else {
+    master->send(pid, message);
+  }
+}
+
+
 // Implementation of slave admission Registrar operation.
 class AdmitSlave : public Operation
 {
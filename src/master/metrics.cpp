@@ -93,8 +93,12 @@ Metrics::Metrics(const Master& master)
         "master/messages_deactivate_framework"),
     messages_kill_task(
         "master/messages_kill_task"),
+    messages_kill_tasks(
+        "master/messages_kill_tasks"),
     messages_status_update_acknowledgement(
         "master/messages_status_update_acknowledgement"),
+    messages_status_update_acknowledgements(
+        "master/messages_status_update_acknowledgements"),
     messages_resource_request(
         "master/messages_resource_request"),
     messages_launch_tasks(
@@ -103,6 +107,8 @@ Metrics::Metrics(const Master& master)
         "master/messages_decline_offers"),
     messages_revive_offers(
         "master/messages_revive_offers"),
+    messages_suppress_offers(
+        "master/messages_suppress_offers"),
     messages_reconcile_tasks(
         "master/messages_reconcile_tasks"),
     messages_framework_to_executor(
@@ -115,6 +121,8 @@ Metrics::Metrics(const Master& master)
         "master/messages_unregister_slave"),
     messages_status_update(
         "master/messages_status_update"),
+    messages_status_updates(
+        "master/messages_status_updates"),
     messages_exited_executor(
         "master/messages_exited_executor"),
     messages_update_slave(
@@ -144,10 +152,17 @@ Metrics::Metrics(const Master& master)
     event_queue_http_requests(
         "master/event_queue_http_requests",
         defer(master, &Master::_event_queue_http_requests)),
+    event_queue_age_secs(
+        "master/event_queue_age_secs",
+        defer(master, &Master::_event_queue_age_secs)),
+    shed_requests(
+        "master/shed_requests"),
     slave_registrations(
         "master/slave_registrations"),
     slave_reregistrations(
         "master/slave_reregistrations"),
+    slave_registrations_throttled(
+        "master/slave_registrations_throttled"),
     slave_removals(
         "master/slave_removals"),
     slave_removals_reason_unhealthy(
@@ -161,7 +176,16 @@ Metrics::Metrics(const Master& master)
     slave_shutdowns_completed(
         "master/slave_shutdowns_completed"),
     slave_shutdowns_canceled(
-        "master/slave_shutdowns_canceled")
+        "master/slave_shutdowns_canceled"),
+    slave_ping_rtt(
+        "master/slave_ping_rtt",
+        Hours(1)),
+    accept_offer_validation(
+        "master/accept/offer_validation_us"),
+    accept_authorization(
+        "master/accept/authorization_us"),
+    accept_task_validation(
+        "master/accept/task_validation_us")
 {
   // TODO(dhamon): Check return values of 'add'.
   process::metrics::add(uptime_secs);
@@ -196,11 +220,14 @@ Metrics::Metrics(const Master& master)
   process::metrics::add(messages_unregister_framework);
   process::metrics::add(messages_deactivate_framework);
   process::metrics::add(messages_kill_task);
+  process::metrics::add(messages_kill_tasks);
   process::metrics::add(messages_status_update_acknowledgement);
+  process::metrics::add(messages_status_update_acknowledgements);
   process::metrics::add(messages_resource_request);
   process::metrics::add(messages_launch_tasks);
   process::metrics::add(messages_decline_offers);
   process::metrics::add(messages_revive_offers);
+  process::metrics::add(messages_suppress_offers);
   process::metrics::add(messages_reconcile_tasks);
   process::metrics::add(messages_framework_to_executor);
 
@@ -209,6 +236,7 @@ Metrics::Metrics(const Master& master)
   process::metrics::add(messages_reregister_slave);
   process::metrics::add(messages_unregister_slave);
   process::metrics::add(messages_status_update);
+  process::metrics::add(messages_status_updates);
   process::metrics::add(messages_exited_executor);
   process::metrics::add(messages_update_slave);
 
@@ -229,9 +257,12 @@ Metrics::Metrics(const Master& master)
   process::metrics::add(event_queue_messages);
   process::metrics::add(event_queue_dispatches);
   process::metrics::add(event_queue_http_requests);
+  process::metrics::add(event_queue_age_secs);
+  process::metrics::add(shed_requests);
 
   process::metrics::add(slave_registrations);
   process::metrics::add(slave_reregistrations);
+  process::metrics::add(slave_registrations_throttled);
   process::metrics::add(slave_removals);
   process::metrics::add(slave_removals_reason_unhealthy);
   process::metrics::add(slave_removals_reason_unregistered);
@@ -240,6 +271,11 @@ Metrics::Metrics(const Master& master)
   process::metrics::add(slave_shutdowns_scheduled);
   process::metrics::add(slave_shutdowns_completed);
   process::metrics::add(slave_shutdowns_canceled);
+  process::metrics::add(slave_ping_rtt);
+
+  process::metrics::add(accept_offer_validation);
+  process::metrics::add(accept_authorization);
+  process::metrics::add(accept_task_validation);
 
   // Create resource gauges.
   // TODO(dhamon): Set these up dynamically when adding a slave based on the
@@ -303,11 +339,14 @@ Metrics::~Metrics()
   process::metrics::remove(messages_unregister_framework);
   process::metrics::remove(messages_deactivate_framework);
   process::metrics::remove(messages_kill_task);
+  process::metrics::remove(messages_kill_tasks);
   process::metrics::remove(messages_status_update_acknowledgement);
+  process::metrics::remove(messages_status_update_acknowledgements);
   process::metrics::remove(messages_resource_request);
   process::metrics::remove(messages_launch_tasks);
   process::metrics::remove(messages_decline_offers);
   process::metrics::remove(messages_revive_offers);
+  process::metrics::remove(messages_suppress_offers);
   process::metrics::remove(messages_reconcile_tasks);
   process::metrics::remove(messages_framework_to_executor);
 
@@ -316,6 +355,7 @@ Metrics::~Metrics()
   process::metrics::remove(messages_reregister_slave);
   process::metrics::remove(messages_unregister_slave);
   process::metrics::remove(messages_status_update);
+  process::metrics::remove(messages_status_updates);
   process::metrics::remove(messages_exited_executor);
   process::metrics::remove(messages_update_slave);
 
@@ -336,9 +376,12 @@ Metrics::~Metrics()
   process::metrics::remove(event_queue_messages);
   process::metrics::remove(event_queue_dispatches);
   process::metrics::remove(event_queue_http_requests);
+  process::metrics::remove(event_queue_age_secs);
+  process::metrics::remove(shed_requests);
 
   process::metrics::remove(slave_registrations);
   process::metrics::remove(slave_reregistrations);
+  process::metrics::remove(slave_registrations_throttled);
   process::metrics::remove(slave_removals);
   process::metrics::remove(slave_removals_reason_unhealthy);
   process::metrics::remove(slave_removals_reason_unregistered);
@@ -347,6 +390,11 @@ Metrics::~Metrics()
   process::metrics::remove(slave_shutdowns_scheduled);
   process::metrics::remove(slave_shutdowns_completed);
   process::metrics::remove(slave_shutdowns_canceled);
+  process::metrics::remove(slave_ping_rtt);
+
+  process::metrics::remove(accept_offer_validation);
+  process::metrics::remove(accept_authorization);
+  process::metrics::remove(accept_task_validation);
 
   foreach (const process::metrics::Gauge& gauge, resources_total) {
     process::metrics::remove(gauge);
@@ -24,8 +24,11 @@
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
+#include <process/metrics/histogram.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 
 #include "mesos/mesos.hpp"
@@ -124,11 +127,14 @@ struct Metrics
   process::metrics::Counter messages_unregister_framework;
   process::metrics::Counter messages_deactivate_framework;
   process::metrics::Counter messages_kill_task;
+  process::metrics::Counter messages_kill_tasks;
   process::metrics::Counter messages_status_update_acknowledgement;
+  process::metrics::Counter messages_status_update_acknowledgements;
   process::metrics::Counter messages_resource_request;
   process::metrics::Counter messages_launch_tasks;
   process::metrics::Counter messages_decline_offers;
   process::metrics::Counter messages_revive_offers;
+  process::metrics::Counter messages_suppress_offers;
   process::metrics::Counter messages_reconcile_tasks;
   process::metrics::Counter messages_framework_to_executor;
 
@@ -137,6 +143,7 @@ struct Metrics
   process::metrics::Counter messages_reregister_slave;
   process::metrics::Counter messages_unregister_slave;
   process::metrics::Counter messages_status_update;
+  process::metrics::Counter messages_status_updates;
   process::metrics::Counter messages_exited_executor;
   process::metrics::Counter messages_update_slave;
 
@@ -159,10 +166,15 @@ struct Metrics
   process::metrics::Gauge event_queue_messages;
   process::metrics::Gauge event_queue_dispatches;
   process::metrics::Gauge event_queue_http_requests;
+  process::metrics::Gauge event_queue_age_secs;
+
+  // Task reconciliation and state requests shed while overloaded.
+  process::metrics::Counter shed_requests;
 
   // Successful registry operations.
   process::metrics::Counter slave_registrations;
   process::metrics::Counter slave_reregistrations;
+  process::metrics::Counter slave_registrations_throttled;
   process::metrics::Counter slave_removals;
   process::metrics::Counter slave_removals_reason_unhealthy;
   process::metrics::Counter slave_removals_reason_unregistered;
@@ -172,6 +184,15 @@ struct Metrics
   process::metrics::Counter slave_shutdowns_scheduled;
   process::metrics::Counter slave_shutdowns_completed;
   process::metrics::Counter slave_shutdowns_canceled;
+  process::metrics::Timer<Milliseconds> slave_ping_rtt;
+
+  // Latencies of handling ACCEPT calls (and LaunchTasksMessages), in
+  // microseconds: validating the offers, authorizing the tasks and
+  // validating the tasks. The latencies of the handlers of the
+  // messages are in 'master/messages/<message>/handled_us'.
+  process::metrics::Histogram accept_offer_validation;
+  process::metrics::Histogram accept_authorization;
+  process::metrics::Histogram accept_task_validation;
 
   // Resource metrics.
   std::vector<process::metrics::Gauge> resources_total;
@@ -16,11 +16,16 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <deque>
+#include <list>
+#include <set>
 #include <string>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -34,13 +39,19 @@
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/timer.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
+#include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 
+#include "master/constants.hpp"
 #include "master/registrar.hpp"
 #include "master/registry.hpp"
 
@@ -70,7 +81,10 @@ using process::metrics::Gauge;
 using process::metrics::Timer;
 
 using std::deque;
+using std::list;
+using std::set;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -85,6 +99,8 @@ public:
   RegistrarProcess(const Flags& _flags, State* _state)
     : ProcessBase(process::ID::generate("registrar")),
       metrics(*this),
+      deltasBytes(0),
+      nextDelta(0),
       updating(false),
       flags(_flags),
       state(_state) {}
@@ -182,22 +198,54 @@ private:
   void _recover(
       const MasterInfo& info,
       const Future<Variable<Registry> >& recovery);
-  void __recover(const Future<bool>& recover);
+  Future<list<Variable<Registry::Delta> > > fetch(const set<string>& names);
+  void __recover(
+      const MasterInfo& info,
+      const Future<list<Variable<Registry::Delta> > >& recovery);
+  void ___recover(const Future<bool>& recover);
   Future<bool> _apply(Owned<Operation> operation);
 
   // Helper for updating state (performing store).
   void update();
   void _update(
-      const Future<Option<Variable<Registry> > >& store,
+      const Future<bool>& store,
       deque<Owned<Operation> > operations);
 
+  // Helpers for storing the updated registry, either in full (after
+  // which the deltas get expunged) or as a delta. The returned
+  // futures are false if the version of a variable was no longer
+  // valid.
+  Future<bool> snapshot(const Registry& registry);
+  Future<bool> _snapshot(const Option<Variable<Registry> >& store);
+  Future<bool> expunge();
+  Future<bool> _expunge(bool expunged);
+  Future<bool> append(const Registry& registry, const Registry::Delta& delta);
+  Future<bool> _append(
+      const Registry& registry,
+      const Registry::Delta& delta,
+      const Variable<Registry::Delta>& fetched);
+  Future<bool> __append(
+      const Registry& registry,
+      const Option<Variable<Registry::Delta> >& store);
+
   // Fails all pending operations and transitions the Registrar
   // into an error state in which all subsequent operations will fail.
   // This ensures we don't attempt to re-acquire log leadership by
   // performing more State storage operations.
   void abort(const string& message);
 
+  // The current registry, versioned by when it was last stored in
+  // full (i.e., it includes the changes of the stored deltas).
   Option<Variable<Registry> > variable;
+
+  // The deltas stored since the registry was last stored in full, in
+  // the order they were stored, and their total size.
+  deque<Variable<Registry::Delta> > deltas;
+  size_t deltasBytes;
+
+  // The index of the next delta to store, see 'append'.
+  uint64_t nextDelta;
+
   deque<Owned<Operation> > operations;
   bool updating; // Used to signify fetching (recovering) or storing.
 
@@ -239,6 +287,96 @@ void fail(deque<Owned<Operation> >* operations, const string& message)
 }
 
 
+// Prefix of the names of the variables holding the deltas of the
+// registry, followed by the index of the delta.
+static const string DELTA_PREFIX = "registry_delta_";
+
+
+// Returns the changes from 'before' to 'after'.
+Registry::Delta diff(const Registry& before, const Registry& after)
+{
+  Registry::Delta delta;
+
+  if (after.has_master() &&
+      (!before.has_master() ||
+       !(before.master().info() == after.master().info()))) {
+    delta.mutable_master()->CopyFrom(after.master());
+  }
+
+  hashmap<SlaveID, const SlaveInfo*> slaves;
+  foreach (const Registry::Slave& slave, before.slaves().slaves()) {
+    slaves[slave.info().id()] = &slave.info();
+  }
+
+  foreach (const Registry::Slave& slave, after.slaves().slaves()) {
+    const SlaveID& id = slave.info().id();
+
+    if (!slaves.contains(id) || !(*slaves[id] == slave.info())) {
+      delta.add_slaves()->CopyFrom(slave);
+    }
+
+    slaves.erase(id);
+  }
+
+  foreachkey (const SlaveID& id, slaves) {
+    delta.add_removed()->CopyFrom(id);
+  }
+
+  return delta;
+}
+
+
+// Applies the deltas, in order, to the registry.
+void replay(Registry* registry, const deque<Variable<Registry::Delta> >& deltas)
+{
+  google::protobuf::RepeatedPtrField<Registry::Slave>* slaves =
+    registry->mutable_slaves()->mutable_slaves();
+
+  hashmap<SlaveID, int> indices;
+  for (int i = 0; i < slaves->size(); i++) {
+    indices[slaves->Get(i).info().id()] = i;
+  }
+
+  foreach (const Variable<Registry::Delta>& variable, deltas) {
+    const Registry::Delta delta = variable.get();
+
+    if (delta.has_master()) {
+      registry->mutable_master()->CopyFrom(delta.master());
+    }
+
+    foreach (const Registry::Slave& slave, delta.slaves()) {
+      const SlaveID& id = slave.info().id();
+
+      if (indices.contains(id)) {
+        slaves->Mutable(indices[id])->CopyFrom(slave);
+      } else {
+        slaves->Add()->CopyFrom(slave);
+        indices[id] = slaves->size() - 1;
+      }
+    }
+
+    // Removed slaves get swapped with the last slave, i.e., the order
+    // of the slaves is not preserved.
+    foreach (const SlaveID& id, delta.removed()) {
+      if (!indices.contains(id)) {
+        continue;
+      }
+
+      const int index = indices[id];
+      const int last = slaves->size() - 1;
+
+      if (index != last) {
+        slaves->SwapElements(index, last);
+        indices[slaves->Get(index).info().id()] = index;
+      }
+
+      slaves->RemoveLast();
+      indices.erase(id);
+    }
+  }
+}
+
+
 Future<Response> RegistrarProcess::registry(const Request& request)
 {
   JSON::Object result;
@@ -332,36 +470,112 @@ Future<Registry> RegistrarProcess::recover(const MasterInfo& info)
 void RegistrarProcess::_recover(
     const MasterInfo& info,
     const Future<Variable<Registry> >& recovery)
+{
+  CHECK(!recovery.isPending());
+
+  if (!recovery.isReady()) {
+    updating = false;
+    recovered.get()->fail("Failed to recover registrar: " +
+        (recovery.isFailed() ? recovery.failure() : "discarded"));
+    return;
+  }
+
+  // Save the registry, the deltas get applied to it next.
+  variable = recovery.get();
+
+  state->names()
+    .then(defer(self(), &Self::fetch, lambda::_1))
+    .after(flags.registry_fetch_timeout,
+           lambda::bind(
+               &timeout<list<Variable<Registry::Delta> > >,
+               "fetch",
+               flags.registry_fetch_timeout,
+               lambda::_1))
+    .onAny(defer(self(), &Self::__recover, info, lambda::_1));
+}
+
+
+Future<list<Variable<Registry::Delta> > > RegistrarProcess::fetch(
+    const set<string>& names)
+{
+  // Fetch the deltas in the order of their indices.
+  vector<uint64_t> indices;
+  foreach (const string& name, names) {
+    if (strings::startsWith(name, DELTA_PREFIX)) {
+      Try<uint64_t> index =
+        numify<uint64_t>(strings::remove(name, DELTA_PREFIX, strings::PREFIX));
+
+      if (index.isError()) {
+        return Failure("Invalid registry delta '" + name + "'");
+      }
+
+      indices.push_back(index.get());
+    }
+  }
+
+  std::sort(indices.begin(), indices.end());
+
+  list<Future<Variable<Registry::Delta> > > futures;
+  foreach (uint64_t index, indices) {
+    futures.push_back(
+        state->fetch<Registry::Delta>(DELTA_PREFIX + stringify(index)));
+  }
+
+  if (!indices.empty()) {
+    nextDelta = indices.back() + 1;
+  }
+
+  return process::collect(futures);
+}
+
+
+void RegistrarProcess::__recover(
+    const MasterInfo& info,
+    const Future<list<Variable<Registry::Delta> > >& recovery)
 {
   updating = false;
 
   CHECK(!recovery.isPending());
 
   if (!recovery.isReady()) {
-    recovered.get()->fail("Failed to recover registrar: " +
+    recovered.get()->fail("Failed to recover registrar: "
+        "Failed to fetch the registry deltas: " +
         (recovery.isFailed() ? recovery.failure() : "discarded"));
   } else {
     Duration elapsed = metrics.state_fetch.stop();
 
+    foreach (const Variable<Registry::Delta>& delta, recovery.get()) {
+      deltas.push_back(delta);
+      deltasBytes += delta.get().ByteSize();
+    }
+
     LOG(INFO) << "Successfully fetched the registry"
-              << " (" << Bytes(recovery.get().get().ByteSize()) << ")"
+              << " (" << Bytes(variable.get().get().ByteSize()) << ")"
+              << " and " << deltas.size() << " deltas"
+              << " (" << Bytes(deltasBytes) << ")"
               << " in " << elapsed;
 
-    // Save the registry.
-    variable = recovery.get();
+    // NOTE: Deltas might be left behind by a master that failed
+    // while expunging them, after the registry got stored in full.
+    // Applying them again is harmless since they only set (or
+    // remove) slaves, the latest delta for a slave matches the
+    // stored registry.
+    Registry registry = variable.get().get();
+    replay(&registry, deltas);
+    variable = variable.get().mutate(registry);
 
     // Perform the Recover operation to add the new MasterInfo.
     Owned<Operation> operation(new Recover(info));
     operations.push_back(operation);
     operation->future()
-      .onAny(defer(self(), &Self::__recover, lambda::_1));
+      .onAny(defer(self(), &Self::___recover, lambda::_1));
 
     update();
   }
 }
 
 
-void RegistrarProcess::__recover(const Future<bool>& recover)
+void RegistrarProcess::___recover(const Future<bool>& recover)
 {
   CHECK(!recover.isPending());
 
@@ -445,12 +659,30 @@ void RegistrarProcess::update()
   LOG(INFO) << "Applied " << operations.size() << " operations in "
             << stopwatch.elapsed() << "; attempting to update the 'registry'";
 
-  // Perform the store, and time the operation.
+  // Store only the changes unless the deltas have grown too large
+  // compared to the registry, and time the operation.
   metrics.state_store.start();
-  state->store(variable.get().mutate(registry))
+
+  Future<bool> store;
+
+  if (flags.registry_store_deltas) {
+    Registry::Delta delta = diff(variable.get().get(), registry);
+
+    if (deltas.size() < MAX_REGISTRY_DELTAS &&
+        deltasBytes + delta.ByteSize() <=
+          registry.ByteSize() * REGISTRY_DELTAS_COMPACTION_RATIO) {
+      store = append(registry, delta);
+    } else {
+      store = snapshot(registry);
+    }
+  } else {
+    store = snapshot(registry);
+  }
+
+  store
     .after(flags.registry_store_timeout,
            lambda::bind(
-               &timeout<Option<Variable<Registry> > >,
+               &timeout<bool>,
                "store",
                flags.registry_store_timeout,
                lambda::_1))
@@ -462,13 +694,13 @@ void RegistrarProcess::update()
 
 
 void RegistrarProcess::_update(
-    const Future<Option<Variable<Registry> > >& store,
+    const Future<bool>& store,
     deque<Owned<Operation> > applied)
 {
   updating = false;
 
   // Abort if the storage operation did not succeed.
-  if (!store.isReady() || store.get().isNone()) {
+  if (!store.isReady() || !store.get()) {
     string message = "Failed to update 'registry': ";
 
     if (store.isFailed()) {
@@ -489,8 +721,6 @@ void RegistrarProcess::_update(
 
   LOG(INFO) << "Successfully updated the 'registry' in " << elapsed;
 
-  variable = store.get().get();
-
   // Remove the operations.
   while (!applied.empty()) {
     Owned<Operation> operation = applied.front();
@@ -505,6 +735,91 @@ void RegistrarProcess::_update(
 }
 
 
+Future<bool> RegistrarProcess::snapshot(const Registry& registry)
+{
+  return state->store(variable.get().mutate(registry))
+    .then(defer(self(), &Self::_snapshot, lambda::_1));
+}
+
+
+Future<bool> RegistrarProcess::_snapshot(
+    const Option<Variable<Registry> >& store)
+{
+  if (store.isNone()) {
+    return false;
+  }
+
+  variable = store.get();
+
+  return expunge();
+}
+
+
+Future<bool> RegistrarProcess::expunge()
+{
+  if (deltas.empty()) {
+    return true;
+  }
+
+  // The deltas get expunged one at a time, in order, so that the
+  // deltas left behind on a failure can be applied again (see
+  // '__recover').
+  return state->expunge(deltas.front())
+    .then(defer(self(), &Self::_expunge, lambda::_1));
+}
+
+
+Future<bool> RegistrarProcess::_expunge(bool expunged)
+{
+  if (!expunged) {
+    return Failure("Failed to expunge registry delta");
+  }
+
+  deltasBytes -= deltas.front().get().ByteSize();
+  deltas.pop_front();
+
+  return expunge();
+}
+
+
+Future<bool> RegistrarProcess::append(
+    const Registry& registry,
+    const Registry::Delta& delta)
+{
+  return state->fetch<Registry::Delta>(DELTA_PREFIX + stringify(nextDelta++))
+    .then(defer(self(), &Self::_append, registry, delta, lambda::_1));
+}
+
+
+Future<bool> RegistrarProcess::_append(
+    const Registry& registry,
+    const Registry::Delta& delta,
+    const Variable<Registry::Delta>& fetched)
+{
+  return state->store(fetched.mutate(delta))
+    .then(defer(self(), &Self::__append, registry, lambda::_1));
+}
+
+
+Future<bool> RegistrarProcess::__append(
+    const Registry& registry,
+    const Option<Variable<Registry::Delta> >& store)
+{
+  if (store.isNone()) {
+    return false;
+  }
+
+  deltas.push_back(store.get());
+  deltasBytes += store.get().get().ByteSize();
+
+  // NOTE: The registry keeps the version from when it was last
+  // stored in full.
+  variable = variable.get().mutate(registry);
+
+  return true;
+}
+
+
 void RegistrarProcess::abort(const string& message)
 {
   error = Error(message);
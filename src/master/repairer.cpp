@@ -31,8 +31,32 @@ void Repairer::observe(
     const string& monitor,
     bool isHealthy)
 {
-  LOG(INFO) << "Repairer::observed " << isHealthy << " for monitor '"
-    << monitor << "' on host '" << host << "'";
+  VLOG(1) << "Repairer::observed " << isHealthy << " for monitor '"
+          << monitor << "' on host '" << host << "'";
+
+  if (isHealthy) {
+    if (unhealthy_.contains(host)) {
+      unhealthy_[host].erase(monitor);
+
+      if (unhealthy_[host].empty()) {
+        LOG(INFO) << "Host '" << host << "' is healthy again";
+        unhealthy_.erase(host);
+      }
+    }
+  } else {
+    if (!unhealthy_.contains(host)) {
+      LOG(INFO) << "Host '" << host << "' observed as unhealthy by monitor '"
+                << monitor << "'";
+    }
+
+    unhealthy_[host].insert(monitor);
+  }
+}
+
+
+bool Repairer::isHealthy(const string& host) const
+{
+  return !unhealthy_.contains(host);
 }
 
 
@@ -19,14 +19,24 @@
 #ifndef __MESOS_MASTER_REPAIRER_HPP__
 #define __MESOS_MASTER_REPAIRER_HPP__
 
+#include <string>
+
 #include <mesos/mesos.hpp>
 
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+
 namespace mesos {
 namespace internal {
 namespace master {
 
 // An abstraction for recieve notification of unhealty nodes
 // and automating repairs to them.
+//
+// The observations of the monitors are aggregated into a table of
+// the unhealthy hosts, i.e., a host is unhealthy as long as any of
+// the monitors last observed it as unhealthy. Healthy hosts take no
+// space in the table.
 class Repairer
 {
 public:
@@ -34,7 +44,21 @@ public:
       const std::string& host,
       const std::string& metric,
       bool isHealthy);
+
+  // Returns whether no monitor last observed the host as unhealthy.
+  virtual bool isHealthy(const std::string& host) const;
+
+  // Returns the unhealthy hosts along with the monitors that observed
+  // them as unhealthy.
+  const hashmap<std::string, hashset<std::string>>& unhealthy() const
+  {
+    return unhealthy_;
+  }
+
   virtual ~Repairer();
+
+private:
+  hashmap<std::string, hashset<std::string>> unhealthy_;
 };
 
 } // namespace master {
@@ -0,0 +1,172 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include <process/clock.hpp>
+#include <process/defer.hpp>
+
+#include <stout/numify.hpp>
+#include <stout/result.hpp>
+#include <stout/stringify.hpp>
+
+#include "common/http.hpp"
+
+#include "logging/logging.hpp"
+
+#include "master/constants.hpp"
+#include "master/snapshot.hpp"
+
+using process::Clock;
+using process::Future;
+
+using std::shared_ptr;
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// Pull in definitions from process (rather than from mesos).
+using process::http::Request;
+using process::http::Response;
+
+Future<Response> SnapshotProcess::state(const Request& request)
+{
+  return get()
+    .then(defer(self(), &Self::_state, request, lambda::_1));
+}
+
+
+Future<Response> SnapshotProcess::stateSummary(const Request& request)
+{
+  return get()
+    .then(defer(self(), &Self::_stateSummary, request, lambda::_1));
+}
+
+
+Future<Response> SnapshotProcess::slaves(const Request& request)
+{
+  return get()
+    .then(defer(self(), &Self::_slaves, request, lambda::_1));
+}
+
+
+Future<Response> SnapshotProcess::tasks(const Request& request)
+{
+  return get()
+    .then(defer(self(), &Self::_tasks, request, lambda::_1));
+}
+
+
+Future<shared_ptr<const Snapshot>> SnapshotProcess::get()
+{
+  if (taking.isSome()) {
+    return taking.get();
+  }
+
+  if (snapshot && Clock::now() - snapshot->time < interval) {
+    return snapshot;
+  }
+
+  taking = take();
+  taking.get()
+    .onAny(defer(self(), &Self::taken, lambda::_1));
+
+  return taking.get();
+}
+
+
+void SnapshotProcess::taken(const Future<shared_ptr<const Snapshot>>& future)
+{
+  if (future.isReady()) {
+    snapshot = future.get();
+  } else {
+    LOG(WARNING) << "Failed to take a snapshot of the master: "
+                 << (future.isFailed() ? future.failure() : "discarded");
+  }
+
+  taking = None();
+}
+
+
+Response SnapshotProcess::_state(
+    const Request& request,
+    const shared_ptr<const Snapshot>& snapshot)
+{
+  return cacheable(request, snapshot->state, snapshot->etag);
+}
+
+
+Response SnapshotProcess::_stateSummary(
+    const Request& request,
+    const shared_ptr<const Snapshot>& snapshot)
+{
+  return cacheable(request, snapshot->stateSummary, snapshot->etag);
+}
+
+
+Response SnapshotProcess::_slaves(
+    const Request& request,
+    const shared_ptr<const Snapshot>& snapshot)
+{
+  return cacheable(request, snapshot->slaves, snapshot->etag);
+}
+
+
+Response SnapshotProcess::_tasks(
+    const Request& request,
+    const shared_ptr<const Snapshot>& snapshot)
+{
+  Option<Response> unmodified = notModified(request, snapshot->etag);
+  if (unmodified.isSome()) {
+    return unmodified.get();
+  }
+
+  // Get list options (limit and offset), see Master::Http::tasks.
+  Result<int> result = numify<int>(request.query.get("limit"));
+  size_t limit = result.isSome() ? result.get() : TASK_LIMIT;
+
+  result = numify<int>(request.query.get("offset"));
+  size_t offset = result.isSome() ? result.get() : 0;
+
+  // The tasks of the snapshot are sorted in descending order, hence
+  // the ascending order is obtained by walking them from the back.
+  Option<string> order = request.query.get("order");
+  bool ascending = order.isSome() && (order.get() == "asc");
+
+  const size_t size = snapshot->tasks.size();
+  const size_t end = std::min(offset + limit, size);
+
+  string body = "{\"tasks\":[";
+
+  for (size_t i = offset; i < end; i++) {
+    if (i > offset) {
+      body += ",";
+    }
+    body += snapshot->tasks[ascending ? size - 1 - i : i];
+  }
+
+  body += "]}";
+
+  return cacheable(request, body, snapshot->etag);
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,133 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MASTER_SNAPSHOT_HPP__
+#define __MASTER_SNAPSHOT_HPP__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/id.hpp>
+#include <process/process.hpp>
+#include <process/time.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/lambda.hpp>
+#include <stout/option.hpp>
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// An immutable view of the master as exposed by its read-only HTTP
+// endpoints. The endpoints are serialized when the snapshot is taken
+// so that a snapshot can be shared (and rendered) by any number of
+// requests without accessing the master.
+struct Snapshot
+{
+  process::Time time; // When the snapshot was taken.
+  std::string etag; // The ETag of the version of the master.
+
+  std::string state;        // The body of /master/state.json.
+  std::string stateSummary; // The body of /master/state-summary.
+  std::string slaves;       // The body of /master/slaves.
+
+  // The tasks of /master/tasks.json, each serialized separately and
+  // sorted in descending order (see TaskComparator in http.cpp).
+  std::vector<std::string> tasks;
+};
+
+
+// Serves the read-only endpoints of the master from a snapshot
+// rather than from within the master, i.e., the master only has to
+// take a snapshot at most once per 'interval' no matter how many
+// requests arrive. A snapshot is (re)taken on demand, i.e., when a
+// request arrives and the current snapshot is older than 'interval',
+// and all requests that arrive while a snapshot is being taken get
+// served from that snapshot.
+class SnapshotProcess : public process::Process<SnapshotProcess>
+{
+public:
+  typedef lambda::function<
+    process::Future<std::shared_ptr<const Snapshot>>()> Take;
+
+  SnapshotProcess(const Duration& _interval, const Take& _take)
+    : ProcessBase(process::ID::generate("snapshot")),
+      interval(_interval),
+      take(_take) {}
+
+  virtual ~SnapshotProcess() {}
+
+  // /master/state.json
+  process::Future<process::http::Response> state(
+      const process::http::Request& request);
+
+  // /master/state-summary
+  process::Future<process::http::Response> stateSummary(
+      const process::http::Request& request);
+
+  // /master/slaves
+  process::Future<process::http::Response> slaves(
+      const process::http::Request& request);
+
+  // /master/tasks.json
+  process::Future<process::http::Response> tasks(
+      const process::http::Request& request);
+
+private:
+  // Returns the current snapshot unless it is older than 'interval',
+  // in which case a new snapshot gets taken (unless one is already
+  // being taken).
+  process::Future<std::shared_ptr<const Snapshot>> get();
+
+  // Continuations.
+  process::http::Response _state(
+      const process::http::Request& request,
+      const std::shared_ptr<const Snapshot>& snapshot);
+
+  process::http::Response _stateSummary(
+      const process::http::Request& request,
+      const std::shared_ptr<const Snapshot>& snapshot);
+
+  process::http::Response _slaves(
+      const process::http::Request& request,
+      const std::shared_ptr<const Snapshot>& snapshot);
+
+  process::http::Response _tasks(
+      const process::http::Request& request,
+      const std::shared_ptr<const Snapshot>& snapshot);
+
+  void taken(const process::Future<std::shared_ptr<const Snapshot>>& future);
+
+  const Duration interval;
+  const Take take;
+
+  std::shared_ptr<const Snapshot> snapshot;
+
+  // The snapshot currently being taken, if any.
+  Option<process::Future<std::shared_ptr<const Snapshot>>> taking;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_SNAPSHOT_HPP__
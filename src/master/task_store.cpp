@@ -0,0 +1,254 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <list>
+#include <memory>
+#include <string>
+
+#include <glog/logging.h>
+
+#include <mesos/type_utils.hpp>
+
+#include <stout/check.hpp>
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "master/task_store.hpp"
+
+using std::list;
+using std::shared_ptr;
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// The prefix of the names of the files of a store.
+static const string PREFIX = "tasks.";
+
+
+// A file of the store, which gets removed when the last reference
+// to it goes away.
+struct TaskStore::File
+{
+  File(const string& _path, int _fd) : path(_path), fd(_fd), size(0) {}
+
+  ~File()
+  {
+    os::close(fd);
+
+    Try<Nothing> rm = os::rm(path);
+    if (rm.isError()) {
+      LOG(WARNING) << "Failed to remove completed tasks file '" << path
+                   << "': " << rm.error();
+    }
+  }
+
+  const string path;
+  const int fd;
+  uint64_t size;
+};
+
+
+Try<shared_ptr<TaskStore>> TaskStore::create(
+    const string& directory,
+    size_t capacity)
+{
+  Try<Nothing> mkdir = os::mkdir(directory);
+  if (mkdir.isError()) {
+    return Error(
+        "Failed to create directory '" + directory + "': " + mkdir.error());
+  }
+
+  Try<list<string>> entries = os::ls(directory);
+  if (entries.isError()) {
+    return Error(
+        "Failed to list directory '" + directory + "': " + entries.error());
+  }
+
+  // Remove the files left behind by a previous master.
+  foreach (const string& entry, entries.get()) {
+    if (strings::startsWith(entry, PREFIX)) {
+      Try<Nothing> rm = os::rm(path::join(directory, entry));
+      if (rm.isError()) {
+        return Error(
+            "Failed to remove '" + path::join(directory, entry) + "': " +
+            rm.error());
+      }
+    }
+  }
+
+  return shared_ptr<TaskStore>(new TaskStore(directory, capacity));
+}
+
+
+TaskStore::TaskStore(const string& _directory, size_t _capacity)
+  : directory(_directory),
+    capacity(_capacity),
+    count(0),
+    files(0) {}
+
+
+TaskStore::~TaskStore() {}
+
+
+Try<TaskStore::Record> TaskStore::append(const Task& task)
+{
+  if (current.get() == NULL || count >= capacity) {
+    const string path = path::join(directory, PREFIX + stringify(files++));
+
+    Try<int> fd = os::open(
+        path,
+        O_CREAT | O_TRUNC | O_RDWR | O_APPEND | O_CLOEXEC,
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+    if (fd.isError()) {
+      return Error("Failed to open '" + path + "': " + fd.error());
+    }
+
+    current.reset(new File(path, fd.get()));
+    count = 0;
+  }
+
+  string data;
+  if (!task.SerializeToString(&data)) {
+    return Error("Failed to serialize task " + stringify(task.task_id()));
+  }
+
+  Try<Nothing> write = os::write(current->fd, data);
+  if (write.isError()) {
+    // The size of the file is unknown after a partial write, so the
+    // next task is appended to a new file.
+    const string path = current->path;
+    current.reset();
+
+    return Error("Failed to write to '" + path + "': " + write.error());
+  }
+
+  Record record;
+  record.file = current;
+  record.offset = current->size;
+  record.length = data.size();
+
+  current->size += data.size();
+  count++;
+
+  return record;
+}
+
+
+Try<Task> TaskStore::read(const Record& record)
+{
+  string data(record.length, '\0');
+
+  size_t offset = 0;
+  while (offset < data.size()) {
+    ssize_t length = ::pread(
+        record.file->fd,
+        &data[offset],
+        data.size() - offset,
+        record.offset + offset);
+
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return ErrnoError("Failed to read from '" + record.file->path + "'");
+    } else if (length == 0) {
+      return Error("Failed to read from '" + record.file->path + "': EOF");
+    }
+
+    offset += length;
+  }
+
+  Task task;
+  if (!task.ParseFromString(data)) {
+    return Error("Failed to parse task read from '" + record.file->path + "'");
+  }
+
+  return task;
+}
+
+
+CompletedTask::CompletedTask(const Task& _task)
+  : taskId(_task.task_id()),
+    slaveId(_task.slave_id()),
+    state_(_task.state()),
+    task(new Task(_task)) {}
+
+
+CompletedTask::CompletedTask(
+    const Task& _task,
+    const shared_ptr<TaskStore>& store)
+  : taskId(_task.task_id()),
+    slaveId(_task.slave_id()),
+    state_(_task.state())
+{
+  CHECK_NOTNULL(store.get());
+
+  Try<TaskStore::Record> _record = store->append(_task);
+  if (_record.isError()) {
+    LOG(WARNING) << "Keeping completed task " << _task.task_id()
+                 << " in memory: " << _record.error();
+
+    task.reset(new Task(_task));
+  } else {
+    record = _record.get();
+  }
+}
+
+
+Try<shared_ptr<const Task>> CompletedTask::get() const
+{
+  if (task.get() != NULL) {
+    return task;
+  }
+
+  CHECK_SOME(record);
+
+  Try<Task> _task = TaskStore::read(record.get());
+  if (_task.isError()) {
+    return Error(_task.error());
+  }
+
+  return shared_ptr<const Task>(new Task(_task.get()));
+}
+
+
+size_t CompletedTask::bytes() const
+{
+  size_t bytes = taskId.SpaceUsed() + slaveId.SpaceUsed();
+
+  if (task.get() != NULL) {
+    bytes += task->SpaceUsed();
+  }
+
+  return bytes;
+}
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
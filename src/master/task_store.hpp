@@ -0,0 +1,132 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MASTER_TASK_STORE_HPP__
+#define __MASTER_TASK_STORE_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include <mesos/mesos.hpp>
+
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+#include "messages/messages.hpp"
+
+namespace mesos {
+namespace internal {
+namespace master {
+
+// Forward declarations.
+class CompletedTask;
+
+
+// An append-only on-disk store for the completed tasks of the
+// frameworks, which lets the master keep only a summary of each
+// completed task in memory (see CompletedTask below). The tasks are
+// appended to the current file of the store until it holds
+// 'capacity' tasks, after which a new file is started. A file is
+// removed once none of the tasks in it is referred to anymore, i.e.,
+// the disk used follows the completed tasks that the master retains.
+//
+// NOTE: The store is not meant to survive the master, i.e., it is
+// not synced to disk and any files left behind by a previous master
+// get removed when the store is created.
+class TaskStore
+{
+public:
+  static Try<std::shared_ptr<TaskStore>> create(
+      const std::string& directory,
+      size_t capacity);
+
+  ~TaskStore();
+
+private:
+  friend class CompletedTask;
+
+  struct File;
+
+  // The location of a task in the store.
+  struct Record
+  {
+    std::shared_ptr<File> file;
+    uint64_t offset;
+    uint32_t length;
+  };
+
+  TaskStore(const std::string& directory, size_t capacity);
+
+  Try<Record> append(const Task& task);
+  static Try<Task> read(const Record& record);
+
+  TaskStore(const TaskStore&);
+  TaskStore& operator = (const TaskStore&);
+
+  const std::string directory;
+  const size_t capacity;
+
+  std::shared_ptr<File> current;
+  size_t count; // The number of tasks in the current file.
+  uint64_t files; // The number of files started so far.
+};
+
+
+// A completed task of a framework. If the task was added to a store,
+// only the fields needed to summarize the task are kept in memory
+// and the task itself is read back from the store when asked for.
+// Otherwise (or if writing to the store fails) the whole task is
+// kept in memory, which used to be the case for all tasks.
+class CompletedTask
+{
+public:
+  explicit CompletedTask(const Task& task);
+
+  CompletedTask(
+      const Task& task,
+      const std::shared_ptr<TaskStore>& store);
+
+  const TaskID& task_id() const { return taskId; }
+  const SlaveID& slave_id() const { return slaveId; }
+  TaskState state() const { return state_; }
+
+  // Returns the task, reading it from the store if needed.
+  Try<std::shared_ptr<const Task>> get() const;
+
+  // Returns the (approximate) number of bytes of memory used by the
+  // completed task.
+  size_t bytes() const;
+
+private:
+  TaskID taskId;
+  SlaveID slaveId;
+  TaskState state_;
+
+  // Exactly one of these is set.
+  std::shared_ptr<const Task> task;
+  Option<TaskStore::Record> record;
+};
+
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_TASK_STORE_HPP__
@@ -17,6 +17,7 @@
  */
 
 #include <algorithm>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -308,7 +309,7 @@ Option<Error> validateResources(const TaskInfo& task)
     return Error("Task uses invalid resources: " + error.get().message);
   }
 
-  Resources total = task.resources();
+  Resources total = Resources::trusted(task.resources());
 
   if (task.has_executor()) {
     error = resource::validate(task.executor().resources());
@@ -316,7 +317,7 @@ Option<Error> validateResources(const TaskInfo& task)
       return Error("Executor uses invalid resources: " + error.get().message);
     }
 
-    total += task.executor().resources();
+    total += Resources::trusted(task.executor().resources());
   }
 
   error = resource::validateUniquePersistenceID(total);
@@ -337,7 +338,8 @@ Option<Error> validateResourceUsage(
     Slave* slave,
     const Resources& offered)
 {
-  Resources taskResources = task.resources();
+  // NOTE: The resources have been validated by 'validateResources'.
+  Resources taskResources = Resources::trusted(task.resources());
 
   if (taskResources.empty()) {
     return Error("Task uses no resources");
@@ -345,7 +347,7 @@ Option<Error> validateResourceUsage(
 
   Resources executorResources;
   if (task.has_executor()) {
-    executorResources = task.executor().resources();
+    executorResources = Resources::trusted(task.executor().resources());
   }
 
   // Validate minimal cpus and memory resources of executor and log
@@ -407,15 +409,25 @@ Option<Error> validate(
   // NOTE: The order in which the following validate functions are
   // executed does matter! For example, 'validateResourceUsage'
   // assumes that ExecutorInfo is valid which is verified by
-  // 'validateExecutorInfo'.
+  // 'validateExecutorInfo', and only 'validateResources' validates
+  // the resources of the task (and the executor), the others trust
+  // them.
+  // NOTE: The arguments are bound by reference since this is called
+  // for every task of an ACCEPT call, and copying the task (and the
+  // offered resources) for each validator dominated the cost.
   vector<lambda::function<Option<Error>(void)>> validators = {
-    lambda::bind(validateTaskID, task),
-    lambda::bind(validateUniqueTaskID, task, framework),
-    lambda::bind(validateSlaveID, task, slave),
-    lambda::bind(validateExecutorInfo, task, framework, slave),
+    lambda::bind(validateTaskID, std::cref(task)),
+    lambda::bind(validateUniqueTaskID, std::cref(task), framework),
+    lambda::bind(validateSlaveID, std::cref(task), slave),
+    lambda::bind(validateExecutorInfo, std::cref(task), framework, slave),
     lambda::bind(validateCheckpoint, framework, slave),
-    lambda::bind(validateResources, task),
-    lambda::bind(validateResourceUsage, task, framework, slave, offered)
+    lambda::bind(validateResources, std::cref(task)),
+    lambda::bind(
+        validateResourceUsage,
+        std::cref(task),
+        framework,
+        slave,
+        std::cref(offered))
   };
 
   // TODO(benh): Add a validateHealthCheck function.
@@ -543,9 +555,9 @@ Option<Error> validate(
   CHECK_NOTNULL(framework);
 
   vector<lambda::function<Option<Error>(void)>> validators = {
-    lambda::bind(validateUniqueOfferID, offerIds),
-    lambda::bind(validateFramework, offerIds, master, framework),
-    lambda::bind(validateSlave, offerIds, master)
+    lambda::bind(validateUniqueOfferID, std::cref(offerIds)),
+    lambda::bind(validateFramework, std::cref(offerIds), master, framework),
+    lambda::bind(validateSlave, std::cref(offerIds), master)
   };
 
   foreach (const lambda::function<Option<Error>(void)>& validator, validators) {
@@ -203,6 +203,12 @@ class SchedulerDriver(object):
       dropped (these semantics may be changed in the future).
     """
 
+  def killTasks(self, taskIds):
+    """
+      Kills the specified tasks, like killTask() but with a single
+      message to the master.
+    """
+
   def acceptOffers(self, offerIds, operations, filters=None):
     """
       Accepts the given offers and performs a sequence of operations
@@ -223,6 +229,13 @@ class SchedulerDriver(object):
       callback.
     """
 
+  def declineOffers(self, offerIds, filters=None):
+    """
+      Declines the specified offers, like declineOffer() but with a
+      single message to the master. The offers may belong to different
+      slaves.
+    """
+
   def reviveOffers(self):
     """
       Removes all filters previously set by the framework (via
@@ -230,6 +243,13 @@ class SchedulerDriver(object):
       those filtered slaves.
     """
 
+  def suppressOffers(self):
+    """
+      Informs Mesos to stop sending offers to the framework until
+      reviveOffers() is called, e.g., because the framework has no more
+      work to do.
+    """
+
   def acknowledgeStatusUpdate(self, status):
     """
       Acknowledges the status update. This should only be called
@@ -239,6 +259,12 @@ class SchedulerDriver(object):
       cause the driver to crash.
     """
 
+  def acknowledgeStatusUpdates(self, statuses):
+    """
+      Acknowledges the status updates, like acknowledgeStatusUpdate()
+      but with a single message to the master.
+    """
+
   def sendFrameworkMessage(self, executorId, slaveId, data):
     """
       Sends a message from the framework to one of its executors. These
@@ -242,7 +242,12 @@ PyObject* MesosExecutorDriverImpl_start(MesosExecutorDriverImpl* self)
     return NULL;
   }
 
-  Status status = self->driver->start();
+  // NOTE: Like for the scheduler driver, we release the GIL around
+  // the (possibly blocking) calls into the driver.
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->start();
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets an exception if creating the int fails.
 }
 
@@ -254,7 +259,10 @@ PyObject* MesosExecutorDriverImpl_stop(MesosExecutorDriverImpl* self)
     return NULL;
   }
 
-  Status status = self->driver->stop();
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->stop();
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets an exception if creating the int fails.
 }
 
@@ -266,7 +274,10 @@ PyObject* MesosExecutorDriverImpl_abort(MesosExecutorDriverImpl* self)
     return NULL;
   }
 
-  Status status = self->driver->abort();
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->abort();
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets an exception if creating the int fails.
 }
 
@@ -321,7 +332,10 @@ PyObject* MesosExecutorDriverImpl_sendStatusUpdate(
     return NULL;
   }
 
-  Status status = self->driver->sendStatusUpdate(taskStatus);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->sendStatusUpdate(taskStatus);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets an exception if creating the int fails.
 }
 
@@ -341,7 +355,10 @@ PyObject* MesosExecutorDriverImpl_sendFrameworkMessage(
     return NULL;
   }
 
-  Status status = self->driver->sendFrameworkMessage(string(data, length));
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->sendFrameworkMessage(string(data, length));
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets an exception if creating the int fails.
 }
 
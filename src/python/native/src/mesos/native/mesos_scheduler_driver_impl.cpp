@@ -128,6 +128,11 @@ PyMethodDef MesosSchedulerDriverImpl_methods[] = {
     METH_VARARGS,
     "Kill the task with the given ID"
   },
+  { "killTasks",
+    (PyCFunction) MesosSchedulerDriverImpl_killTasks,
+    METH_VARARGS,
+    "Kill the tasks with the given IDs"
+  },
   { "acceptOffers",
     (PyCFunction) MesosSchedulerDriverImpl_acceptOffers,
     METH_VARARGS,
@@ -138,16 +143,31 @@ PyMethodDef MesosSchedulerDriverImpl_methods[] = {
     METH_VARARGS,
     "Decline a Mesos offer"
   },
+  { "declineOffers",
+    (PyCFunction) MesosSchedulerDriverImpl_declineOffers,
+    METH_VARARGS,
+    "Decline a list of Mesos offers"
+  },
   { "reviveOffers",
     (PyCFunction) MesosSchedulerDriverImpl_reviveOffers,
     METH_NOARGS,
     "Remove all filters and ask Mesos for new offers"
   },
+  { "suppressOffers",
+    (PyCFunction) MesosSchedulerDriverImpl_suppressOffers,
+    METH_NOARGS,
+    "Ask Mesos to stop sending offers until they are revived"
+  },
   { "acknowledgeStatusUpdate",
     (PyCFunction) MesosSchedulerDriverImpl_acknowledgeStatusUpdate,
     METH_VARARGS,
     "Acknowledge a status update"
   },
+  { "acknowledgeStatusUpdates",
+    (PyCFunction) MesosSchedulerDriverImpl_acknowledgeStatusUpdates,
+    METH_VARARGS,
+    "Acknowledge a list of status updates"
+  },
   { "sendFrameworkMessage",
     (PyCFunction) MesosSchedulerDriverImpl_sendFrameworkMessage,
     METH_VARARGS,
@@ -322,7 +342,14 @@ PyObject* MesosSchedulerDriverImpl_start(MesosSchedulerDriverImpl* self)
     return NULL;
   }
 
-  Status status = self->driver->start();
+  // NOTE: We release the GIL around the calls into the driver (here
+  // and below) since they may block, e.g., on the driver's mutex
+  // while a callback is being made, which would otherwise prevent
+  // other Python threads (and the ProxyScheduler) from running.
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->start();
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -341,7 +368,10 @@ PyObject* MesosSchedulerDriverImpl_stop(MesosSchedulerDriverImpl* self,
     return NULL;
   }
 
-  Status status = self->driver->stop(failover);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->stop(failover);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -353,7 +383,10 @@ PyObject* MesosSchedulerDriverImpl_abort(MesosSchedulerDriverImpl* self)
     return NULL;
   }
 
-  Status status = self->driver->abort();
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->abort();
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -423,7 +456,10 @@ PyObject* MesosSchedulerDriverImpl_requestResources(
     requests.push_back(request);
   }
 
-  Status status = self->driver->requestResources(requests);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->requestResources(requests);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -500,7 +536,10 @@ PyObject* MesosSchedulerDriverImpl_launchTasks(MesosSchedulerDriverImpl* self,
     }
   }
 
-  Status status = self->driver->launchTasks(offerIds, tasks, filters);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->launchTasks(offerIds, tasks, filters);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -523,7 +562,57 @@ PyObject* MesosSchedulerDriverImpl_killTask(MesosSchedulerDriverImpl* self,
     return NULL;
   }
 
-  Status status = self->driver->killTask(tid);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->killTask(tid);
+  Py_END_ALLOW_THREADS
+  return PyInt_FromLong(status); // Sets exception if creating long fails.
+}
+
+
+PyObject* MesosSchedulerDriverImpl_killTasks(
+    MesosSchedulerDriverImpl* self,
+    PyObject* args)
+{
+  if (self->driver == NULL) {
+    PyErr_Format(PyExc_Exception, "MesosSchedulerDriverImpl.driver is NULL");
+    return NULL;
+  }
+
+  PyObject* taskIdsObj = NULL;
+  vector<TaskID> taskIds;
+
+  if (!PyArg_ParseTuple(args, "O", &taskIdsObj)) {
+    return NULL;
+  }
+
+  if (!PyList_Check(taskIdsObj)) {
+    PyErr_Format(PyExc_Exception,
+      "Parameter 1 to killTasks is not a list");
+
+    return NULL;
+  }
+
+  Py_ssize_t len = PyList_Size(taskIdsObj);
+  for (int i = 0; i < len; i++) {
+    PyObject* taskIdObj = PyList_GetItem(taskIdsObj, i);
+    if (taskIdObj == NULL) {
+      return NULL;
+    }
+
+    TaskID taskId;
+    if (!readPythonProtobuf(taskIdObj, &taskId)) {
+      PyErr_Format(PyExc_Exception,
+                   "Could not deserialize Python TaskID");
+      return NULL;
+    }
+    taskIds.push_back(taskId);
+  }
+
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->killTasks(taskIds);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -602,7 +691,10 @@ PyObject* MesosSchedulerDriverImpl_acceptOffers(MesosSchedulerDriverImpl* self,
     }
   }
 
-  Status status = self->driver->acceptOffers(offerIds, operations, filters);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->acceptOffers(offerIds, operations, filters);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -637,7 +729,67 @@ PyObject* MesosSchedulerDriverImpl_declineOffer(MesosSchedulerDriverImpl* self,
     }
   }
 
-  Status status = self->driver->declineOffer(offerId, filters);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->declineOffer(offerId, filters);
+  Py_END_ALLOW_THREADS
+  return PyInt_FromLong(status); // Sets exception if creating long fails.
+}
+
+
+PyObject* MesosSchedulerDriverImpl_declineOffers(
+    MesosSchedulerDriverImpl* self,
+    PyObject* args)
+{
+  if (self->driver == NULL) {
+    PyErr_Format(PyExc_Exception, "MesosSchedulerDriverImpl.driver is NULL");
+    return NULL;
+  }
+
+  PyObject* offerIdsObj = NULL;
+  PyObject* filtersObj = NULL;
+  vector<OfferID> offerIds;
+
+  if (!PyArg_ParseTuple(args, "O|O", &offerIdsObj, &filtersObj)) {
+    return NULL;
+  }
+
+  if (!PyList_Check(offerIdsObj)) {
+    PyErr_Format(PyExc_Exception,
+      "Parameter 1 to declineOffers is not a list");
+
+    return NULL;
+  }
+
+  Py_ssize_t len = PyList_Size(offerIdsObj);
+  for (int i = 0; i < len; i++) {
+    PyObject* offerIdObj = PyList_GetItem(offerIdsObj, i);
+    if (offerIdObj == NULL) {
+      return NULL;
+    }
+
+    OfferID offerId;
+    if (!readPythonProtobuf(offerIdObj, &offerId)) {
+      PyErr_Format(PyExc_Exception,
+                   "Could not deserialize Python OfferID");
+      return NULL;
+    }
+    offerIds.push_back(offerId);
+  }
+
+  Filters filters;
+  if (filtersObj != NULL) {
+    if (!readPythonProtobuf(filtersObj, &filters)) {
+      PyErr_Format(PyExc_Exception,
+                   "Could not deserialize Python Filters");
+      return NULL;
+    }
+  }
+
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->declineOffers(offerIds, filters);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -649,7 +801,26 @@ PyObject* MesosSchedulerDriverImpl_reviveOffers(MesosSchedulerDriverImpl* self)
     return NULL;
   }
 
-  Status status = self->driver->reviveOffers();
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->reviveOffers();
+  Py_END_ALLOW_THREADS
+  return PyInt_FromLong(status); // Sets exception if creating long fails.
+}
+
+
+PyObject* MesosSchedulerDriverImpl_suppressOffers(
+    MesosSchedulerDriverImpl* self)
+{
+  if (self->driver == NULL) {
+    PyErr_Format(PyExc_Exception, "MesosSchedulerDriverImpl.driver is NULL");
+    return NULL;
+  }
+
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->suppressOffers();
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -675,12 +846,62 @@ PyObject* MesosSchedulerDriverImpl_acknowledgeStatusUpdate(
     return NULL;
   }
 
-  Status status = self->driver->acknowledgeStatusUpdate(taskStatus);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->acknowledgeStatusUpdate(taskStatus);
+  Py_END_ALLOW_THREADS
 
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
 
+PyObject* MesosSchedulerDriverImpl_acknowledgeStatusUpdates(
+    MesosSchedulerDriverImpl* self,
+    PyObject* args)
+{
+  if (self->driver == NULL) {
+    PyErr_Format(PyExc_Exception, "MesosSchedulerDriverImpl.driver is NULL");
+    return NULL;
+  }
+
+  PyObject* taskStatusesObj = NULL;
+  vector<TaskStatus> taskStatuses;
+
+  if (!PyArg_ParseTuple(args, "O", &taskStatusesObj)) {
+    return NULL;
+  }
+
+  if (!PyList_Check(taskStatusesObj)) {
+    PyErr_Format(PyExc_Exception,
+      "Parameter 1 to acknowledgeStatusUpdates is not a list");
+
+    return NULL;
+  }
+
+  Py_ssize_t len = PyList_Size(taskStatusesObj);
+  for (int i = 0; i < len; i++) {
+    PyObject* taskStatusObj = PyList_GetItem(taskStatusesObj, i);
+    if (taskStatusObj == NULL) {
+      return NULL;
+    }
+
+    TaskStatus taskStatus;
+    if (!readPythonProtobuf(taskStatusObj, &taskStatus)) {
+      PyErr_Format(PyExc_Exception,
+                   "Could not deserialize Python TaskStatus");
+      return NULL;
+    }
+    taskStatuses.push_back(taskStatus);
+  }
+
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->acknowledgeStatusUpdates(taskStatuses);
+  Py_END_ALLOW_THREADS
+  return PyInt_FromLong(status); // Sets exception if creating long fails.
+}
+
+
 PyObject* MesosSchedulerDriverImpl_sendFrameworkMessage(
     MesosSchedulerDriverImpl* self,
     PyObject* args)
@@ -712,8 +933,11 @@ PyObject* MesosSchedulerDriverImpl_sendFrameworkMessage(
     return NULL;
   }
 
-  Status status = self->driver->sendFrameworkMessage(
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->sendFrameworkMessage(
       executorId, slaveId, string(data, length));
+  Py_END_ALLOW_THREADS
 
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
@@ -758,7 +982,10 @@ PyObject* MesosSchedulerDriverImpl_reconcileTasks(
     statuses.push_back(status);
   }
 
-  Status status = self->driver->reconcileTasks(statuses);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->reconcileTasks(statuses);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status);
 }
 
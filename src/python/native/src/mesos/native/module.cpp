@@ -58,6 +58,12 @@ using std::map;
 PyObject* mesos::python::mesos_pb2 = NULL;
 
 
+/**
+ * The Python type of the scheduler API's Event.Offers message.
+ */
+PyObject* mesos::python::offersType = NULL;
+
+
 namespace {
 
 /**
@@ -83,6 +89,23 @@ PyMODINIT_FUNC init_mesos(void)
   if (mesos_pb2 == NULL)
     return;
 
+  // Resolve the Event.Offers message of scheduler_pb2 (with which we
+  // convert the offers of a callback all at once).
+  PyObject* scheduler_pb2 =
+    PyImport_ImportModule("mesos.interface.scheduler_pb2");
+  if (scheduler_pb2 == NULL)
+    return;
+
+  PyObject* event = PyObject_GetAttrString(scheduler_pb2, "Event");
+  Py_DECREF(scheduler_pb2);
+  if (event == NULL)
+    return;
+
+  offersType = PyObject_GetAttrString(event, "Offers");
+  Py_DECREF(event);
+  if (offersType == NULL)
+    return;
+
   // Initialize our Python types.
   if (PyType_Ready(&MesosSchedulerDriverImplType) < 0)
     return;
@@ -37,6 +37,13 @@ namespace mesos { namespace python {
 extern PyObject* mesos_pb2;
 
 
+/**
+ * The Python type of the scheduler API's Event.Offers message (from
+ * scheduler_pb2), used to convert a batch of offers at once.
+ */
+extern PyObject* offersType;
+
+
 /**
  * RAII utility class for acquiring the Python global interpreter lock.
  */
@@ -94,10 +101,35 @@ bool readPythonProtobuf(PyObject* obj, T* t)
 
 
 /**
- * Convert a C++ protocol buffer object into a Python one by serializing
- * it to a string and deserializing the result back in Python. Returns the
- * resulting PyObject* on success or raises a Python exception and returns
- * NULL on failure.
+ * Convert a C++ protocol buffer object into a Python one of the given
+ * type by serializing it to a string and deserializing the result back
+ * in Python. Returns the resulting PyObject* on success or raises a
+ * Python exception and returns NULL on failure.
+ */
+template <typename T>
+PyObject* createPythonProtobuf(
+    const T& t,
+    PyObject* type,
+    const char* typeName)
+{
+  std::string str;
+  if (!t.SerializeToString(&str)) {
+    PyErr_Format(PyExc_Exception, "C++ %s SerializeToString failed", typeName);
+    return NULL;
+  }
+
+  // Propagates any exception that might happen in FromString.
+  return PyObject_CallMethod(type,
+                             (char*) "FromString",
+                             (char*) "s#",
+                             str.data(),
+                             str.size());
+}
+
+
+/**
+ * Convert a C++ protocol buffer object into a Python one of the type
+ * with the given name in mesos_pb2, see above.
  */
 template <typename T>
 PyObject* createPythonProtobuf(const T& t, const char* typeName)
@@ -118,18 +150,7 @@ PyObject* createPythonProtobuf(const T& t, const char* typeName)
     return NULL;
   }
 
-  std::string str;
-  if (!t.SerializeToString(&str)) {
-    PyErr_Format(PyExc_Exception, "C++ %s SerializeToString failed", typeName);
-    return NULL;
-  }
-
-  // Propagates any exception that might happen in FromString.
-  return PyObject_CallMethod(type,
-                             (char*) "FromString",
-                             (char*) "s#",
-                             str.data(),
-                             str.size());
+  return createPythonProtobuf(t, type, typeName);
 }
 
 } // namespace python {
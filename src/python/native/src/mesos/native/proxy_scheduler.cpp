@@ -22,6 +22,8 @@
 
 #include <iostream>
 
+#include <mesos/scheduler/scheduler.hpp>
+
 #include "proxy_scheduler.hpp"
 #include "module.hpp"
 #include "mesos_scheduler_driver_impl.hpp"
@@ -139,21 +141,36 @@ cleanup:
 void ProxyScheduler::resourceOffers(SchedulerDriver* driver,
                                     const vector<Offer>& offers)
 {
+  // Convert the offers into a single Event.Offers message so that
+  // they get deserialized in Python all at once, rather than one
+  // FromString call per offer.
+  scheduler::Event::Offers batch;
+  batch.mutable_offers()->Reserve(offers.size());
+  for (size_t i = 0; i < offers.size(); i++) {
+    batch.add_offers()->CopyFrom(offers[i]);
+  }
+
   InterpreterLock lock;
 
+  PyObject* batchObj = NULL;
+  PyObject* offersObj = NULL;
   PyObject* list = NULL;
   PyObject* res = NULL;
 
-  list = PyList_New(offers.size());
-  if (list == NULL) {
+  batchObj = createPythonProtobuf(batch, offersType, "Event.Offers");
+  if (batchObj == NULL) {
+    goto cleanup; // createPythonProtobuf will have set an exception.
+  }
+
+  offersObj = PyObject_GetAttrString(batchObj, "offers");
+  if (offersObj == NULL) {
     goto cleanup;
   }
-  for (size_t i = 0; i < offers.size(); i++) {
-    PyObject* offer = createPythonProtobuf(offers[i], "Offer");
-    if (offer == NULL) {
-      goto cleanup;
-    }
-    PyList_SetItem(list, i, offer); // Steals the reference to offer.
+
+  // The scheduler expects a list of offers.
+  list = PySequence_List(offersObj);
+  if (list == NULL) {
+    goto cleanup;
   }
 
   res = PyObject_CallMethod(impl->pythonScheduler,
@@ -172,6 +189,8 @@ cleanup:
     PyErr_Print();
     driver->abort();
   }
+  Py_XDECREF(batchObj);
+  Py_XDECREF(offersObj);
   Py_XDECREF(list);
   Py_XDECREF(res);
 }
@@ -101,11 +101,39 @@ public:
         "master. Use the default '" + DEFAULT_AUTHENTICATEE + "', or\n"
         "load an alternate authenticatee module using MESOS_MODULES.",
         DEFAULT_AUTHENTICATEE);
+
+    add(&Flags::callback_threads,
+        "callback_threads",
+        "Number of threads to invoke the scheduler callbacks on, instead of\n"
+        "the thread of the driver, so that a slow callback does not hold up\n"
+        "the driver. The status updates of a task are invoked in order on\n"
+        "the same thread, and all the other callbacks are invoked in order\n"
+        "on the first thread, so the scheduler must support being called\n"
+        "concurrently. Use 0 to invoke all the callbacks on the driver.",
+        0);
+
+    add(&Flags::callback_queue_size,
+        "callback_queue_size",
+        "Maximum number of callbacks queued up for each callback thread\n"
+        "(see --callback_threads), beyond which the driver waits for the\n"
+        "scheduler before handling more events.",
+        1024);
+
+    add(&Flags::share_master_detector,
+        "share_master_detector",
+        "Whether the drivers within this process that detect the leading\n"
+        "master through the same ZooKeeper URL share a single ZooKeeper\n"
+        "session, so that an election results in one read of the leading\n"
+        "master's information instead of one per driver.",
+        false);
   }
 
   Duration registration_backoff_factor;
   Option<Modules> modules;
   std::string authenticatee;
+  size_t callback_threads;
+  size_t callback_queue_size;
+  bool share_master_detector;
 };
 
 } // namespace scheduler {
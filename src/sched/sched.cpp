@@ -25,10 +25,15 @@
 
 #include <arpa/inet.h>
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <string>
 #include <sstream>
+#include <thread>
 
 #include <mesos/mesos.hpp>
 #include <mesos/module.hpp>
@@ -72,6 +77,7 @@
 #include "authentication/cram_md5/authenticatee.hpp"
 
 #include "common/lock.hpp"
+#include "common/protobuf_utils.hpp"
 
 #include "local/flags.hpp"
 #include "local/local.hpp"
@@ -106,6 +112,112 @@ using utils::copy;
 namespace mesos {
 namespace internal {
 
+// Invokes the scheduler callbacks on a pool of threads rather than on
+// the SchedulerProcess (see '--callback_threads'). Each thread invokes
+// the callbacks queued up for it in order: those with a key (i.e., the
+// status updates of a task) always go to the same thread, all the
+// others to the first thread. Adding a callback to a full queue waits
+// for the thread to catch up.
+class CallbackPool
+{
+public:
+  CallbackPool(size_t threads, size_t _capacity)
+    : capacity(_capacity),
+      stopping(false),
+      queues(threads)
+  {
+    CHECK_GT(threads, 0u);
+    CHECK_GT(capacity, 0u);
+
+    for (size_t i = 0; i < threads; i++) {
+      workers.push_back(std::thread(&CallbackPool::run, this, i));
+    }
+  }
+
+  // Waits for the callbacks being invoked and discards the others.
+  ~CallbackPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+
+    foreach (Queue& queue, queues) {
+      queue.notEmpty.notify_all();
+      queue.notFull.notify_all();
+    }
+
+    foreach (std::thread& worker, workers) {
+      worker.join();
+    }
+  }
+
+  void add(
+      const Option<string>& key,
+      const lambda::function<void(void)>& callback)
+  {
+    Queue& queue = key.isSome()
+      ? queues[std::hash<string>()(key.get()) % queues.size()]
+      : queues[0];
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (!stopping && queue.callbacks.size() >= capacity) {
+      queue.notFull.wait(lock);
+    }
+
+    if (stopping) {
+      return;
+    }
+
+    queue.callbacks.push_back(callback);
+    queue.notEmpty.notify_one();
+  }
+
+private:
+  struct Queue
+  {
+    std::deque<lambda::function<void(void)>> callbacks;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+  };
+
+  void run(size_t index)
+  {
+    Queue& queue = queues[index];
+
+    while (true) {
+      lambda::function<void(void)> callback;
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!stopping && queue.callbacks.empty()) {
+          queue.notEmpty.wait(lock);
+        }
+
+        if (stopping) {
+          return;
+        }
+
+        callback = queue.callbacks.front();
+        queue.callbacks.pop_front();
+        queue.notFull.notify_one();
+      }
+
+      callback();
+    }
+  }
+
+  const size_t capacity;
+
+  std::mutex mutex;
+  bool stopping;
+  std::vector<Queue> queues;
+  std::vector<std::thread> workers;
+};
+
+
 // The scheduler process (below) is responsible for interacting with
 // the master and responding to Mesos API calls from scheduler
 // drivers. In order to allow a message to be sent back to the master
@@ -155,10 +267,18 @@ public:
       reauthenticate(false)
   {
     LOG(INFO) << "Version: " << MESOS_VERSION;
+
+    if (flags.callback_threads > 0) {
+      pool.reset(
+          new CallbackPool(flags.callback_threads, flags.callback_queue_size));
+    }
   }
 
   virtual ~SchedulerProcess()
   {
+    // The callbacks being invoked must be done before we are gone.
+    pool.reset();
+
     delete authenticatee;
   }
 
@@ -177,20 +297,22 @@ protected:
         &FrameworkReregisteredMessage::framework_id,
         &FrameworkReregisteredMessage::master_info);
 
-    install<ResourceOffersMessage>(
-        &SchedulerProcess::resourceOffers,
-        &ResourceOffersMessage::offers,
-        &ResourceOffersMessage::pids);
+    install<ResourceOffersMessage>(&SchedulerProcess::resourceOffers);
 
     install<RescindResourceOfferMessage>(
         &SchedulerProcess::rescindOffer,
-        &RescindResourceOfferMessage::offer_id);
+        &RescindResourceOfferMessage::offer_id,
+        &RescindResourceOfferMessage::offer_ids);
 
     install<StatusUpdateMessage>(
         &SchedulerProcess::statusUpdate,
         &StatusUpdateMessage::update,
         &StatusUpdateMessage::pid);
 
+    install<StatusUpdatesMessage>(
+        &SchedulerProcess::statusUpdates,
+        &StatusUpdatesMessage::updates);
+
     install<LostSlaveMessage>(
         &SchedulerProcess::lostSlave,
         &LostSlaveMessage::slave_id);
@@ -238,14 +360,8 @@ protected:
       //   3. The master failed over to the same master.
       // In any case, we will reconnect (possibly immediately), so we
       // must notify schedulers of the disconnection.
-      Stopwatch stopwatch;
-      if (FLAGS_v >= 1) {
-        stopwatch.start();
-      }
-
-      scheduler->disconnected(driver);
-
-      VLOG(1) << "Scheduler::disconnected took " << stopwatch.elapsed();
+      invoke("disconnected",
+             lambda::bind(&Scheduler::disconnected, scheduler, driver));
     }
 
     connected = false;
@@ -452,14 +568,12 @@ protected:
     connected = true;
     failover = false;
 
-    Stopwatch stopwatch;
-    if (FLAGS_v >= 1) {
-      stopwatch.start();
-    }
-
-    scheduler->registered(driver, frameworkId, masterInfo);
-
-    VLOG(1) << "Scheduler::registered took " << stopwatch.elapsed();
+    invoke("registered",
+           lambda::bind(&Scheduler::registered,
+                        scheduler,
+                        driver,
+                        frameworkId,
+                        masterInfo));
   }
 
   void reregistered(
@@ -494,14 +608,11 @@ protected:
     connected = true;
     failover = false;
 
-    Stopwatch stopwatch;
-    if (FLAGS_v >= 1) {
-      stopwatch.start();
-    }
-
-    scheduler->reregistered(driver, masterInfo);
-
-    VLOG(1) << "Scheduler::reregistered took " << stopwatch.elapsed();
+    invoke("reregistered",
+           lambda::bind(&Scheduler::reregistered,
+                        scheduler,
+                        driver,
+                        masterInfo));
   }
 
   void doReliableRegistration(Duration maxBackoff)
@@ -560,8 +671,7 @@ protected:
 
   void resourceOffers(
       const UPID& from,
-      const vector<Offer>& offers,
-      const vector<string>& pids)
+      const ResourceOffersMessage& message)
   {
     if (!running) {
       VLOG(1) << "Ignoring resource offers message because "
@@ -584,6 +694,9 @@ protected:
       return;
     }
 
+    const vector<Offer> offers = protobuf::getOffers(message);
+    const vector<string> pids(message.pids().begin(), message.pids().end());
+
     VLOG(2) << "Received " << offers.size() << " offers";
 
     CHECK(offers.size() == pids.size());
@@ -601,17 +714,17 @@ protected:
       }
     }
 
-    Stopwatch stopwatch;
-    if (FLAGS_v >= 1) {
-      stopwatch.start();
-    }
-
-    scheduler->resourceOffers(driver, offers);
-
-    VLOG(1) << "Scheduler::resourceOffers took " << stopwatch.elapsed();
+    invoke("resourceOffers",
+           lambda::bind(&Scheduler::resourceOffers,
+                        scheduler,
+                        driver,
+                        offers));
   }
 
-  void rescindOffer(const UPID& from, const OfferID& offerId)
+  void rescindOffer(
+      const UPID& from,
+      const OfferID& offerId,
+      const vector<OfferID>& offerIds)
   {
     if (!running) {
       VLOG(1) << "Ignoring rescind offer message because "
@@ -634,18 +747,21 @@ protected:
       return;
     }
 
-    VLOG(1) << "Rescinded offer " << offerId;
+    vector<OfferID> rescinded;
+    rescinded.push_back(offerId);
+    rescinded.insert(rescinded.end(), offerIds.begin(), offerIds.end());
 
-    savedOffers.erase(offerId);
+    foreach (const OfferID& offerId, rescinded) {
+      VLOG(1) << "Rescinded offer " << offerId;
 
-    Stopwatch stopwatch;
-    if (FLAGS_v >= 1) {
-      stopwatch.start();
-    }
-
-    scheduler->offerRescinded(driver, offerId);
+      savedOffers.erase(offerId);
 
-    VLOG(1) << "Scheduler::offerRescinded took " << stopwatch.elapsed();
+      invoke("offerRescinded",
+             lambda::bind(&Scheduler::offerRescinded,
+                          scheduler,
+                          driver,
+                          offerId));
+    }
   }
 
   void statusUpdate(
@@ -707,15 +823,59 @@ protected:
       status.set_uuid(update.uuid());
     }
 
-    Stopwatch stopwatch;
-    if (FLAGS_v >= 1) {
-      stopwatch.start();
+    // The updates of a task are invoked in order on the same thread
+    // of the pool, and acknowledged once the callback returns.
+    if (pool.get() != NULL) {
+      pool->add(
+          status.task_id().value(),
+          lambda::bind(&SchedulerProcess::_statusUpdate,
+                       this,
+                       from,
+                       update,
+                       pid,
+                       status));
+      return;
     }
 
-    scheduler->statusUpdate(driver, status);
+    timed("statusUpdate",
+          lambda::bind(&Scheduler::statusUpdate, scheduler, driver, status));
 
-    VLOG(1) << "Scheduler::statusUpdate took " << stopwatch.elapsed();
+    acknowledge(from, update, pid);
+  }
 
+  // Handles the batched status updates sent by the master during the
+  // reconciliation of a framework with the BATCHED_RECONCILIATION
+  // capability.
+  void statusUpdates(
+      const UPID& from,
+      const vector<StatusUpdateMessage>& updates)
+  {
+    foreach (const StatusUpdateMessage& update, updates) {
+      statusUpdate(from, update.update(), update.pid());
+    }
+  }
+
+  // Invokes the callback of a status update from the callback pool.
+  void _statusUpdate(
+      const UPID& from,
+      const StatusUpdate& update,
+      const UPID& pid,
+      const TaskStatus& status)
+  {
+    _invoke(
+        "statusUpdate",
+        lambda::bind(&Scheduler::statusUpdate, scheduler, driver, status));
+
+    dispatch(self(), &SchedulerProcess::acknowledge, from, update, pid);
+  }
+
+  // Sends the acknowledgement of a status update after its callback
+  // returned, if the driver acknowledges updates implicitly.
+  void acknowledge(
+      const UPID& from,
+      const StatusUpdate& update,
+      const UPID& pid)
+  {
     if (implicitAcknowledgements) {
       // Note that we need to look at the volatile 'running' here
       // so that we don't acknowledge the update if the driver was
@@ -728,8 +888,17 @@ protected:
 
       // Don't acknowledge updates created by the driver or master.
       if (from != UPID() && pid != UPID()) {
-        // We drop updates while we're disconnected.
-        CHECK(connected);
+        // We drop updates while we're disconnected, but the driver
+        // might have disconnected while the callback pool invoked
+        // the callback.
+        if (!connected) {
+          CHECK(pool.get() != NULL);
+
+          VLOG(1) << "Not sending status update acknowledgment message "
+                  << "because the driver is disconnected!";
+          return;
+        }
+
         CHECK_SOME(master);
 
         VLOG(2) << "Sending ACK for status update " << update
@@ -772,14 +941,8 @@ protected:
 
     savedSlavePids.erase(slaveId);
 
-    Stopwatch stopwatch;
-    if (FLAGS_v >= 1) {
-      stopwatch.start();
-    }
-
-    scheduler->slaveLost(driver, slaveId);
-
-    VLOG(1) << "Scheduler::slaveLost took " << stopwatch.elapsed();
+    invoke("slaveLost",
+           lambda::bind(&Scheduler::slaveLost, scheduler, driver, slaveId));
   }
 
   void frameworkMessage(const SlaveID& slaveId,
@@ -795,14 +958,13 @@ protected:
 
     VLOG(2) << "Received framework message";
 
-    Stopwatch stopwatch;
-    if (FLAGS_v >= 1) {
-      stopwatch.start();
-    }
-
-    scheduler->frameworkMessage(driver, executorId, slaveId, data);
-
-    VLOG(1) << "Scheduler::frameworkMessage took " << stopwatch.elapsed();
+    invoke("frameworkMessage",
+           lambda::bind(&Scheduler::frameworkMessage,
+                        scheduler,
+                        driver,
+                        executorId,
+                        slaveId,
+                        data));
   }
 
   void error(const string& message)
@@ -816,14 +978,59 @@ protected:
 
     driver->abort();
 
+    const lambda::function<void(void)> callback =
+      lambda::bind(&Scheduler::error, scheduler, driver, message);
+
+    // NOTE: Unlike the other callbacks, the error is reported after
+    // aborting the driver, so the pool must not drop it (see
+    // '_invoke').
+    if (pool.get() != NULL) {
+      pool->add(
+          None(),
+          lambda::bind(&SchedulerProcess::timed, "error", callback));
+    } else {
+      timed("error", callback);
+    }
+  }
+
+  // Invokes a scheduler callback, on the callback pool if the driver
+  // uses one.
+  void invoke(const string& name, const lambda::function<void(void)>& callback)
+  {
+    if (pool.get() != NULL) {
+      pool->add(
+          None(),
+          lambda::bind(&SchedulerProcess::_invoke, this, name, callback));
+    } else {
+      timed(name, callback);
+    }
+  }
+
+  // Invokes a callback from the callback pool, unless the driver was
+  // stopped or aborted since the callback was queued up.
+  void _invoke(const string& name, const lambda::function<void(void)>& callback)
+  {
+    if (!running) {
+      VLOG(1) << "Not invoking Scheduler::" << name
+              << " because the driver is not running!";
+      return;
+    }
+
+    timed(name, callback);
+  }
+
+  static void timed(
+      const string& name,
+      const lambda::function<void(void)>& callback)
+  {
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
     }
 
-    scheduler->error(driver, message);
+    callback();
 
-    VLOG(1) << "Scheduler::error took " << stopwatch.elapsed();
+    VLOG(1) << "Scheduler::" << name << " took " << stopwatch.elapsed();
   }
 
   void stop(bool failover)
@@ -884,6 +1091,22 @@ protected:
     send(master.get(), message);
   }
 
+  void killTasks(const vector<TaskID>& taskIds)
+  {
+    if (!connected) {
+      VLOG(1) << "Ignoring kill tasks message as master is disconnected";
+      return;
+    }
+
+    KillTasksMessage message;
+    message.mutable_framework_id()->MergeFrom(framework.id());
+    foreach (const TaskID& taskId, taskIds) {
+      message.add_task_ids()->MergeFrom(taskId);
+    }
+    CHECK_SOME(master);
+    send(master.get(), message);
+  }
+
   void requestResources(const vector<Request>& requests)
   {
     if (!connected) {
@@ -1082,6 +1305,32 @@ protected:
     send(master.get(), message);
   }
 
+  void declineOffers(
+      const vector<OfferID>& offerIds,
+      const Filters& filters)
+  {
+    if (!connected) {
+      VLOG(1) << "Ignoring decline offers message as master is disconnected";
+      return;
+    }
+
+    Call message;
+    message.mutable_framework_info()->CopyFrom(framework);
+    message.set_type(Call::DECLINE);
+
+    Call::Decline* decline = message.mutable_decline();
+
+    foreach (const OfferID& offerId, offerIds) {
+      decline->add_offer_ids()->CopyFrom(offerId);
+      savedOffers.erase(offerId);
+    }
+
+    decline->mutable_filters()->CopyFrom(filters);
+
+    CHECK_SOME(master);
+    send(master.get(), message);
+  }
+
   void reviveOffers()
   {
     if (!connected) {
@@ -1095,6 +1344,19 @@ protected:
     send(master.get(), message);
   }
 
+  void suppressOffers()
+  {
+    if (!connected) {
+      VLOG(1) << "Ignoring suppress offers message as master is disconnected";
+      return;
+    }
+
+    SuppressOffersMessage message;
+    message.mutable_framework_id()->MergeFrom(framework.id());
+    CHECK_SOME(master);
+    send(master.get(), message);
+  }
+
   void acknowledgeStatusUpdate(
       const TaskStatus& status)
   {
@@ -1142,6 +1404,42 @@ protected:
     }
   }
 
+  void acknowledgeStatusUpdates(const vector<TaskStatus>& statuses)
+  {
+    // See 'acknowledgeStatusUpdate' above.
+    CHECK(!implicitAcknowledgements);
+
+    if (!connected) {
+      VLOG(1) << "Ignoring explicit status update acknowledgements"
+                 " because the driver is disconnected";
+      return;
+    }
+
+    CHECK_SOME(master);
+
+    StatusUpdateAcknowledgementsMessage message;
+
+    foreach (const TaskStatus& status, statuses) {
+      if (status.has_uuid() && status.has_slave_id()) {
+        StatusUpdateAcknowledgementMessage* acknowledgement =
+          message.add_acknowledgements();
+
+        acknowledgement->mutable_framework_id()->CopyFrom(framework.id());
+        acknowledgement->mutable_slave_id()->CopyFrom(status.slave_id());
+        acknowledgement->mutable_task_id()->CopyFrom(status.task_id());
+        acknowledgement->set_uuid(status.uuid());
+      }
+    }
+
+    VLOG(2) << "Sending " << message.acknowledgements_size()
+            << " ACKs for " << statuses.size() << " status updates to "
+            << master.get();
+
+    if (message.acknowledgements_size() > 0) {
+      send(master.get(), message);
+    }
+  }
+
   void sendFrameworkMessage(const ExecutorID& executorId,
                             const SlaveID& slaveId,
                             const string& data)
@@ -1285,6 +1583,10 @@ private:
 
   Authenticatee* authenticatee;
 
+  // The pool invoking the scheduler callbacks, if any (see
+  // '--callback_threads').
+  Owned<CallbackPool> pool;
+
   // Indicates if an authentication attempt is in progress.
   Option<Future<bool> > authenticating;
 
@@ -1511,8 +1813,19 @@ Status MesosSchedulerDriver::start()
     return status;
   }
 
+  // Load scheduler flags.
+  internal::scheduler::Flags flags;
+  Try<Nothing> load = flags.load("MESOS_");
+
+  if (load.isError()) {
+    status = DRIVER_ABORTED;
+    scheduler->error(this, load.error());
+    return status;
+  }
+
   if (detector == NULL) {
-    Try<MasterDetector*> detector_ = MasterDetector::create(url);
+    Try<MasterDetector*> detector_ = MasterDetector::create(
+        url, flags.share_master_detector);
 
     if (detector_.isError()) {
       status = DRIVER_ABORTED;
@@ -1526,16 +1839,6 @@ Status MesosSchedulerDriver::start()
     detector = detector_.get();
   }
 
-  // Load scheduler flags.
-  internal::scheduler::Flags flags;
-  Try<Nothing> load = flags.load("MESOS_");
-
-  if (load.isError()) {
-    status = DRIVER_ABORTED;
-    scheduler->error(this, load.error());
-    return status;
-  }
-
   // Initialize modules. Note that since other subsystems may depend
   // upon modules, we should initialize modules before anything else.
   if (flags.modules.isSome()) {
@@ -1681,6 +1984,22 @@ Status MesosSchedulerDriver::killTask(const TaskID& taskId)
 }
 
 
+Status MesosSchedulerDriver::killTasks(const vector<TaskID>& taskIds)
+{
+  Lock lock(&mutex);
+
+  if (status != DRIVER_RUNNING) {
+    return status;
+  }
+
+  CHECK(process != NULL);
+
+  dispatch(process, &SchedulerProcess::killTasks, taskIds);
+
+  return status;
+}
+
+
 Status MesosSchedulerDriver::launchTasks(
     const OfferID& offerId,
     const vector<TaskInfo>& tasks,
@@ -1747,6 +2066,24 @@ Status MesosSchedulerDriver::declineOffer(
 }
 
 
+Status MesosSchedulerDriver::declineOffers(
+    const vector<OfferID>& offerIds,
+    const Filters& filters)
+{
+  Lock lock(&mutex);
+
+  if (status != DRIVER_RUNNING) {
+    return status;
+  }
+
+  CHECK(process != NULL);
+
+  dispatch(process, &SchedulerProcess::declineOffers, offerIds, filters);
+
+  return status;
+}
+
+
 Status MesosSchedulerDriver::reviveOffers()
 {
   Lock lock(&mutex);
@@ -1763,6 +2100,22 @@ Status MesosSchedulerDriver::reviveOffers()
 }
 
 
+Status MesosSchedulerDriver::suppressOffers()
+{
+  Lock lock(&mutex);
+
+  if (status != DRIVER_RUNNING) {
+    return status;
+  }
+
+  CHECK(process != NULL);
+
+  dispatch(process, &SchedulerProcess::suppressOffers);
+
+  return status;
+}
+
+
 Status MesosSchedulerDriver::acknowledgeStatusUpdate(
     const TaskStatus& taskStatus)
 {
@@ -1786,6 +2139,29 @@ Status MesosSchedulerDriver::acknowledgeStatusUpdate(
 }
 
 
+Status MesosSchedulerDriver::acknowledgeStatusUpdates(
+    const vector<TaskStatus>& statuses)
+{
+  Lock lock(&mutex);
+
+  if (status != DRIVER_RUNNING) {
+    return status;
+  }
+
+  // TODO(bmahler): Should this use abort() instead?
+  if (implicitAcknowlegements) {
+    ABORT("Cannot call acknowledgeStatusUpdates:"
+          " Implicit acknowledgements are enabled");
+  }
+
+  CHECK(process != NULL);
+
+  dispatch(process, &SchedulerProcess::acknowledgeStatusUpdates, statuses);
+
+  return status;
+}
+
+
 Status MesosSchedulerDriver::sendFrameworkMessage(
     const ExecutorID& executorId,
     const SlaveID& slaveId,
@@ -25,6 +25,7 @@
 
 #include <arpa/inet.h>
 
+#include <deque>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -33,25 +34,24 @@
 #include <mesos/scheduler.hpp>
 #include <mesos/type_utils.hpp>
 
-#include <mesos/authentication/authenticatee.hpp>
-
-#include <mesos/module/authenticatee.hpp>
-
 #include <process/async.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
+#include <process/http.hpp>
 #include <process/id.hpp>
 #include <process/mutex.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
-#include <process/protobuf.hpp>
 
+#include <stout/base64.hpp>
 #include <stout/check.hpp>
 #include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/flags.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/ip.hpp>
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
@@ -59,8 +59,8 @@
 #include <stout/os.hpp>
 #include <stout/uuid.hpp>
 
-#include "authentication/cram_md5/authenticatee.hpp"
-
+#include "common/http.hpp"
+#include "common/recordio.hpp"
 
 #include "master/detector.hpp"
 
@@ -86,10 +86,34 @@ using process::wait; // Necessary on some OS's to disambiguate.
 namespace mesos {
 namespace scheduler {
 
-// The process (below) is responsible for receiving messages
-// (eventually events) from the master and sending messages (via
-// calls) to the master.
-class MesosProcess : public ProtobufProcess<MesosProcess>
+// The flags of the library, loaded from the environment, in addition
+// to those of a local cluster (see 'local::Flags').
+class Flags : public local::Flags
+{
+public:
+  Flags()
+  {
+    add(&Flags::http_basic_authentication,
+        "http_basic_authentication",
+        "Whether to authenticate with the master using HTTP basic\n"
+        "authentication, i.e., by sending the principal and the secret of\n"
+        "the credential in cleartext with every call. Only enable this if\n"
+        "the connection to the master can't be eavesdropped on. Without it\n"
+        "the credential is not sent, i.e., the master must not require\n"
+        "frameworks to authenticate.",
+        false);
+  }
+
+  bool http_basic_authentication;
+};
+
+
+// The process (below) is responsible for receiving events from the
+// master and sending calls to the master, both over the master's
+// scheduler HTTP endpoint. Events are streamed over the (chunked)
+// response to the SUBSCRIBE call in the recordio format, while all
+// other calls are sent as separate (pipelined) requests.
+class MesosProcess : public Process<MesosProcess>
 {
 public:
   MesosProcess(
@@ -104,12 +128,7 @@ public:
       disconnected(_disconnected),
       received(_received),
       local(false),
-      failover(true),
-      detector(NULL),
-      authenticatee(NULL),
-      authenticating(None()),
-      authenticated(false),
-      reauthenticate(false)
+      detector(NULL)
   {
     GOOGLE_PROTOBUF_VERIFY_VERSION;
 
@@ -118,7 +137,7 @@ public:
     // logging::Flags). In the future, just as the TODO in
     // local/main.cpp discusses, we'll probably want a way to load
     // master::Flags and slave::Flags as well.
-    local::Flags flags;
+    Flags flags;
 
     Try<Nothing> load = flags.load("MESOS_");
 
@@ -166,11 +185,27 @@ public:
 
     // Save the detector so we can delete it later.
     detector = create.get();
+
+    // The credential (if any) is only sent along with every request
+    // using HTTP basic authentication if explicitly enabled, since it
+    // goes over the wire in cleartext.
+    if (credential.isSome()) {
+      if (flags.http_basic_authentication) {
+        headers["Authorization"] = "Basic " +
+          base64::encode(
+              credential.get().principal() + ":" + credential.get().secret());
+      } else {
+        LOG(WARNING) << "Not authenticating with the master since"
+                     << " 'MESOS_HTTP_BASIC_AUTHENTICATION' is not enabled";
+      }
+    }
   }
 
   virtual ~MesosProcess()
   {
-    delete authenticatee;
+    if (subscription.isSome()) {
+      subscription.get().reader.close();
+    }
 
     // Check and see if we need to shutdown a local cluster.
     if (local) {
@@ -181,9 +216,6 @@ public:
     mutex.lock().await();
   }
 
-  // TODO(benh): Move this to 'protected'.
-  using ProtobufProcess<MesosProcess>::send;
-
   void send(Call call)
   {
     if (master.isNone()) {
@@ -216,22 +248,13 @@ public:
 
     switch (call.type()) {
       case Call::SUBSCRIBE: {
-        if (!call.framework_info().has_id() ||
-            call.framework_info().id() == "") {
-          RegisterFrameworkMessage message;
-          message.mutable_framework()->CopyFrom(call.framework_info());
-          send(master.get(), message);
-        } else {
-          ReregisterFrameworkMessage message;
-          message.mutable_framework()->CopyFrom(call.framework_info());
-          message.set_failover(failover);
-          send(master.get(), message);
-        }
-        break;
+        subscribe(call);
+        return;
       }
 
-      case Call::TEARDOWN: {
-        send(master.get(), call);
+      case Call::TEARDOWN:
+      case Call::REVIVE:
+      case Call::SUPPRESS: {
         break;
       }
 
@@ -240,11 +263,6 @@ public:
           drop(call, "Expecting 'decline' to be present");
           return;
         }
-        LaunchTasksMessage message;
-        message.mutable_framework_id()->CopyFrom(call.framework_info().id());
-        message.mutable_filters()->CopyFrom(call.decline().filters());
-        message.mutable_offer_ids()->CopyFrom(call.decline().offer_ids());
-        send(master.get(), message);
         break;
       }
 
@@ -272,14 +290,6 @@ public:
             }
           }
         }
-        send(master.get(), call);
-        break;
-      }
-
-      case Call::REVIVE: {
-        ReviveOffersMessage message;
-        message.mutable_framework_id()->CopyFrom(call.framework_info().id());
-        send(master.get(), message);
         break;
       }
 
@@ -288,7 +298,6 @@ public:
           drop(call, "Expecting 'kill' to be present");
           return;
         }
-        send(master.get(), call);
         break;
       }
 
@@ -297,7 +306,6 @@ public:
           drop(call, "Expecting 'shutdown' to be present");
           return;
         }
-        send(master.get(), call);
         break;
       }
 
@@ -306,12 +314,6 @@ public:
           drop(call, "Expecting 'acknowledge' to be present");
           return;
         }
-        StatusUpdateAcknowledgementMessage message;
-        message.mutable_framework_id()->CopyFrom(call.framework_info().id());
-        message.mutable_slave_id()->CopyFrom(call.acknowledge().slave_id());
-        message.mutable_task_id()->CopyFrom(call.acknowledge().task_id());
-        message.set_uuid(call.acknowledge().uuid());
-        send(master.get(), message);
         break;
       }
 
@@ -320,8 +322,6 @@ public:
           drop(call, "Expecting 'reconcile' to be present");
           return;
         }
-
-        send(master.get(), call);
         break;
       }
 
@@ -330,34 +330,28 @@ public:
           drop(call, "Expecting 'message' to be present");
           return;
         }
-        FrameworkToExecutorMessage message;
-        message.mutable_slave_id()->CopyFrom(call.message().slave_id());
-        message.mutable_framework_id()->CopyFrom(call.framework_info().id());
-        message.mutable_executor_id()->CopyFrom(call.message().executor_id());
-        message.set_data(call.message().data());
-        send(master.get(), message);
         break;
       }
 
       default:
         VLOG(1) << "Unexpected call " << stringify(call.type());
-        break;
+        return;
     }
+
+    // NOTE: The requests are pipelined on the connection to the
+    // master, so the calls are received in the order they are sent.
+    process::http::post(
+        master.get(),
+        PATH,
+        headers,
+        serialize(APPLICATION_PROTOBUF, call),
+        APPLICATION_PROTOBUF)
+      .onAny(defer(self(), &Self::_send, call, lambda::_1));
   }
 
 protected:
   virtual void initialize()
   {
-    install<FrameworkRegisteredMessage>(&MesosProcess::receive);
-    install<FrameworkReregisteredMessage>(&MesosProcess::receive);
-    install<ResourceOffersMessage>(&MesosProcess::receive);
-    install<RescindResourceOfferMessage>(&MesosProcess::receive);
-    install<StatusUpdateMessage>(&MesosProcess::receive);
-    install<LostSlaveMessage>(&MesosProcess::receive);
-    install<ExitedExecutorMessage>(&MesosProcess::receive);
-    install<ExecutorToFrameworkMessage>(&MesosProcess::receive);
-    install<FrameworkErrorMessage>(&MesosProcess::receive);
-
     // Start detecting masters.
     detector->detect()
       .onAny(defer(self(), &MesosProcess::detected, lambda::_1));
@@ -372,6 +366,12 @@ protected:
       return;
     }
 
+    // Any subscription was with the previous master.
+    if (subscription.isSome()) {
+      subscription.get().reader.close();
+      subscription = None();
+    }
+
     if (future.get().isNone()) {
       master = None();
 
@@ -385,15 +385,9 @@ protected:
 
       VLOG(1) << "New master detected at " << master.get();
 
-      if (credential.isSome()) {
-        // TODO(vinod): Do pure HTTP Authentication instead of SASL.
-        // Authenticate with the master.
-        authenticate();
-      } else {
-        mutex.lock()
-          .then(defer(self(), &Self::__detected))
-          .onAny(lambda::bind(&Mutex::unlock, mutex));
-      }
+      mutex.lock()
+        .then(defer(self(), &Self::__detected))
+        .onAny(lambda::bind(&Mutex::unlock, mutex));
     }
 
     // Keep detecting masters.
@@ -411,123 +405,142 @@ protected:
     return async(connected);
   }
 
-  void authenticate()
+  void _send(const Call& call, const Future<process::http::Response>& response)
   {
-    authenticated = false;
-
-    // We retry to authenticate and it's possible that we'll get
-    // disconnected while that is happening.
-    if (master.isNone()) {
+    if (!response.isReady()) {
+      drop(call, response.isFailed() ? response.failure() : "discarded");
       return;
     }
 
-    if (authenticating.isSome()) {
-      // Authentication is in progress. Try to cancel it.
-      // Note that it is possible that 'authenticating' is ready
-      // and the dispatch to '_authenticate' is enqueued when we
-      // are here, making the 'discard' here a no-op. This is ok
-      // because we set 'reauthenticate' here which enforces a retry
-      // in '_authenticate'.
-      Future<bool>(authenticating.get()).discard();
-      reauthenticate = true;
-      return;
+    if (response.get().status != process::http::statuses[202]) {
+      drop(call, "Received " + response.get().status + ": " +
+           response.get().body);
     }
-
-    VLOG(1) << "Authenticating with master " << master.get();
-
-    CHECK_SOME(credential);
-
-    CHECK(authenticatee == NULL);
-    authenticatee = new cram_md5::CRAMMD5Authenticatee();
-
-    // NOTE: We do not pass 'Owned<Authenticatee>' here because doing
-    // so could make 'AuthenticateeProcess' responsible for deleting
-    // 'Authenticatee' causing a deadlock because the destructor of
-    // 'Authenticatee' waits on 'AuthenticateeProcess'.
-    // This will happen in the following scenario:
-    // --> 'AuthenticateeProcess' does a 'Future.set()'.
-    // --> '_authenticate()' is dispatched to this process.
-    // --> This process executes '_authenticatee()'.
-    // --> 'AuthenticateeProcess' removes the onAny callback
-    //     from its queue which holds the last reference to
-    //     'Authenticatee'.
-    // --> '~Authenticatee()' is invoked by 'AuthenticateeProcess'.
-    // TODO(vinod): Consider using 'Shared' to 'Owned' upgrade.
-    authenticating =
-      authenticatee->authenticate(master.get(), self(), credential.get())
-        .onAny(defer(self(), &Self::_authenticate));
-
-    delay(Seconds(5),
-          self(),
-          &Self::authenticationTimeout,
-          authenticating.get());
   }
 
-  void _authenticate()
+  void subscribe(const Call& call)
   {
-    delete CHECK_NOTNULL(authenticatee);
-    authenticatee = NULL;
+    // A new subscription replaces any existing one.
+    if (subscription.isSome()) {
+      subscription.get().reader.close();
+      subscription = None();
+    }
 
-    CHECK_SOME(authenticating);
-    const Future<bool>& future = authenticating.get();
+    VLOG(1) << "Subscribing with master " << master.get();
 
-    if (master.isNone()) {
-      VLOG(1) << "Ignoring authentication because no master is detected";
-      authenticating = None();
-
-      // Set it to false because we do not want further retries until
-      // a new master is detected.
-      // We obviously do not need to reauthenticate either even if
-      // 'reauthenticate' is currently true because the master is
-      // lost.
-      reauthenticate = false;
+    headers.erase("Mesos-Stream-Id");
+
+    process::http::streaming::post(
+        master.get(),
+        PATH,
+        headers,
+        serialize(APPLICATION_PROTOBUF, call),
+        APPLICATION_PROTOBUF)
+      .onAny(defer(self(), &Self::_subscribe, master.get(), lambda::_1));
+  }
+
+  void _subscribe(
+      const UPID& pid,
+      const Future<process::http::Response>& response)
+  {
+    if (!response.isReady()) {
+      LOG(WARNING) << "Failed to subscribe with master " << pid << ": "
+                   << (response.isFailed() ? response.failure() : "discarded");
       return;
     }
 
-    if (reauthenticate || !future.isReady()) {
-      VLOG(1)
-        << "Failed to authenticate with master " << master.get() << ": "
-        << (reauthenticate ? "master changed" :
-           (future.isFailed() ? future.failure() : "future discarded"));
+    CHECK_EQ(process::http::Response::PIPE, response.get().type);
+    CHECK_SOME(response.get().reader);
 
-      authenticating = None();
-      reauthenticate = false;
+    process::http::Pipe::Reader reader = response.get().reader.get();
 
-      // TODO(vinod): Add a limit on number of retries.
-      dispatch(self(), &Self::authenticate); // Retry.
+    // Ignore the subscription if the master has changed (or another
+    // subscription was started) in the meantime.
+    if (master != pid || subscription.isSome()) {
+      reader.close();
       return;
     }
 
-    if (!future.get()) {
-      VLOG(1) << "Master " << master.get() << " refused authentication";
-      error("Authentication refused");
+    if (response.get().status != process::http::statuses[200]) {
+      reader.close();
+
+      // Let the scheduler know in case it will never succeed, e.g.,
+      // when it is not authorized.
+      error("Failed to subscribe: received " + response.get().status);
       return;
     }
 
-    VLOG(1) << "Successfully authenticated with master " << master.get();
+    subscription = Subscription(reader);
 
-    authenticated = true;
-    authenticating = None();
+    // The other calls are tied to the subscription by its stream ID.
+    Option<string> streamId = response.get().headers.get("Mesos-Stream-Id");
+    if (streamId.isSome()) {
+      headers["Mesos-Stream-Id"] = streamId.get();
+    }
 
-    mutex.lock()
-      .then(defer(self(), &Self::__authenticate))
-      .onAny(lambda::bind(&Mutex::unlock, mutex));
+    read();
   }
 
-  Future<Nothing> __authenticate()
+  void read()
   {
-    return async(connected);
+    CHECK_SOME(subscription);
+
+    subscription.get().reader.read()
+      .onAny(defer(self(),
+                   &Self::_read,
+                   subscription.get().id,
+                   lambda::_1));
   }
 
-  void authenticationTimeout(Future<bool> future)
+  void _read(const UUID& id, const Future<string>& data)
   {
-    // NOTE: Discarded future results in a retry in '_authenticate()'.
-    // Also note that a 'discard' here is safe even if another
-    // authenticator is in progress because this copy of the future
-    // corresponds to the original authenticator that started the timer.
-    if (future.discard()) { // This is a no-op if the future is already ready.
-      LOG(WARNING) << "Authentication timed out";
+    // Ignore the data of an old subscription.
+    if (subscription.isNone() || subscription.get().id != id) {
+      return;
+    }
+
+    Option<string> failure = None();
+
+    if (!data.isReady()) {
+      failure = data.isFailed() ? data.failure() : "discarded";
+    } else if (data.get().empty()) {
+      failure = "end of stream";
+    } else {
+      Try<std::deque<string>> records = subscription.get().decoder.decode(
+          data.get());
+
+      if (records.isError()) {
+        failure = "failed to decode the events: " + records.error();
+      } else {
+        foreach (const string& record, records.get()) {
+          Try<Event> event = deserialize<Event>(APPLICATION_PROTOBUF, record);
+
+          if (event.isError()) {
+            failure = "failed to deserialize an event: " + event.error();
+            break;
+          }
+
+          receive(master, event.get());
+        }
+      }
+    }
+
+    if (failure.isNone()) {
+      read();
+      return;
     }
+
+    LOG(WARNING) << "Subscription with master " << master.get()
+                 << " ended: " << failure.get();
+
+    subscription.get().reader.close();
+    subscription = None();
+
+    // NOTE: The master remains detected, so the scheduler can simply
+    // subscribe again to reconnect.
+    mutex.lock()
+      .then(defer(self(), &Self::_detected))
+      .onAny(lambda::bind(&Mutex::unlock, mutex));
   }
 
   // NOTE: A None 'from' is possible when an event is injected locally.
@@ -571,143 +584,6 @@ protected:
     return future;
   }
 
-  void receive(const UPID& from, const FrameworkRegisteredMessage& message)
-  {
-    subscribed(from, message.framework_id());
-  }
-
-  void receive(const UPID& from, const FrameworkReregisteredMessage& message)
-  {
-    subscribed(from, message.framework_id());
-  }
-
-  void subscribed(const UPID& from, const FrameworkID& frameworkId)
-  {
-    // We've now registered at least once with the master so we're no
-    // longer failing over. See the comment where 'failover' is
-    // declared for further details.
-    failover = false;
-
-    Event event;
-    event.set_type(Event::SUBSCRIBED);
-
-    Event::Subscribed* subscribed = event.mutable_subscribed();
-
-    subscribed->mutable_framework_id()->CopyFrom(frameworkId);
-
-    receive(from, event);
-  }
-
-  void receive(const UPID& from, const ResourceOffersMessage& message)
-  {
-    Event event;
-    event.set_type(Event::OFFERS);
-
-    Event::Offers* offers = event.mutable_offers();
-
-    offers->mutable_offers()->CopyFrom(message.offers());
-
-    receive(from, event);
-  }
-
-  void receive(const UPID& from, const RescindResourceOfferMessage& message)
-  {
-    Event event;
-    event.set_type(Event::RESCIND);
-
-    Event::Rescind* rescind = event.mutable_rescind();
-
-    rescind->mutable_offer_id()->CopyFrom(message.offer_id());
-
-    receive(from, event);
-  }
-
-  void receive(const UPID& from, const StatusUpdateMessage& message)
-  {
-    Event event;
-    event.set_type(Event::UPDATE);
-
-    Event::Update* update = event.mutable_update();
-
-    update->mutable_status()->CopyFrom(message.update().status());
-
-    if (message.update().has_slave_id()) {
-      update->mutable_status()->mutable_slave_id()->CopyFrom(
-          message.update().slave_id());
-    }
-
-    if (message.update().has_executor_id()) {
-      update->mutable_status()->mutable_executor_id()->CopyFrom(
-          message.update().executor_id());
-    }
-
-    update->mutable_status()->set_timestamp(message.update().timestamp());
-
-    // If the update is generated by the master it doesn't need to be
-    // acknowledged; so we unset the UUID inside TaskStatus.
-    // TODO(vinod): Update master and slave to ensure that 'uuid' is
-    // set accurately by the time it reaches the scheduler.
-    if (UPID(message.pid()) == UPID()) {
-      update->mutable_status()->clear_uuid();
-    } else {
-      update->mutable_status()->set_uuid(message.update().uuid());
-    }
-
-    receive(from, event);
-  }
-
-  void receive(const UPID& from, const LostSlaveMessage& message)
-  {
-    Event event;
-    event.set_type(Event::FAILURE);
-
-    Event::Failure* failure = event.mutable_failure();
-
-    failure->mutable_slave_id()->CopyFrom(message.slave_id());
-
-    receive(from, event);
-  }
-
-  void receive(const UPID& from, const ExitedExecutorMessage& message)
-  {
-    Event event;
-    event.set_type(Event::FAILURE);
-
-    Event::Failure* failure = event.mutable_failure();
-
-    failure->mutable_slave_id()->CopyFrom(message.slave_id());
-    failure->mutable_executor_id()->CopyFrom(message.executor_id());
-    failure->set_status(message.status());
-
-    receive(from, event);
-  }
-
-  void receive(const UPID& from, const ExecutorToFrameworkMessage& _message)
-  {
-    Event event;
-    event.set_type(Event::MESSAGE);
-
-    Event::Message* message = event.mutable_message();
-
-    message->mutable_slave_id()->CopyFrom(_message.slave_id());
-    message->mutable_executor_id()->CopyFrom(_message.executor_id());
-    message->set_data(_message.data());
-
-    receive(from, event);
-  }
-
-  void receive(const UPID& from, const FrameworkErrorMessage& message)
-  {
-    Event event;
-    event.set_type(Event::ERROR);
-
-    Event::Error* error = event.mutable_error();
-
-    error->set_message(message.message());
-
-    receive(from, event);
-  }
-
   // Helper for injecting an ERROR event.
   void error(const string& message)
   {
@@ -746,8 +622,28 @@ protected:
   }
 
 private:
+  // The path of the scheduler endpoint, relative to the master.
+  static const string PATH;
+
+  // The stream of events from the master for the current
+  // subscription.
+  struct Subscription
+  {
+    explicit Subscription(const process::http::Pipe::Reader& _reader)
+      : reader(_reader), id(UUID::random()) {}
+
+    process::http::Pipe::Reader reader;
+    recordio::Decoder decoder;
+
+    // Used to tell the reads of this subscription apart from those
+    // of a previous one.
+    UUID id;
+  };
+
   const Option<Credential> credential;
 
+  hashmap<string, string> headers;
+
   Mutex mutex; // Used to serialize the callback invocations.
 
   lambda::function<void(void)> connected;
@@ -756,29 +652,17 @@ private:
 
   bool local; // Whether or not we launched a local cluster.
 
-  // Whether or not this is the first time we've sent a
-  // REREGISTER. This is to maintain compatibility with what the
-  // master expects from SchedulerProcess. After the first REGISTER or
-  // REREGISTER event we force this to be false.
-  bool failover;
-
   MasterDetector* detector;
 
   queue<Event> events;
 
   Option<UPID> master;
 
-  Authenticatee* authenticatee;
-
-  // Indicates if an authentication attempt is in progress.
-  Option<Future<bool> > authenticating;
+  Option<Subscription> subscription;
+};
 
-  // Indicates if the authentication is successful.
-  bool authenticated;
 
-  // Indicates if a new authentication attempt should be enforced.
-  bool reauthenticate;
-};
+const string MesosProcess::PATH = "api/v1/scheduler";
 
 
 Mesos::Mesos(
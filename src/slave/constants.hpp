@@ -44,6 +44,13 @@ extern const Duration EXECUTOR_SIGNAL_ESCALATION_TIMEOUT;
 extern const Duration RECOVERY_TIMEOUT;
 extern const Duration STATUS_UPDATE_RETRY_INTERVAL_MIN;
 extern const Duration STATUS_UPDATE_RETRY_INTERVAL_MAX;
+
+// Size of the status update journal, or number of status updates
+// files of terminated tasks kept open, from which on the status
+// updates files of the tasks get synced and the journal truncated.
+extern const Bytes STATUS_UPDATE_JOURNAL_CHECKPOINT_SIZE;
+extern const size_t STATUS_UPDATE_JOURNAL_CHECKPOINT_FILES;
+
 extern const Duration GC_DELAY;
 extern const Duration DISK_WATCH_INTERVAL;
 extern const Duration RESOURCE_MONITORING_INTERVAL;
@@ -111,6 +118,11 @@ extern const std::string DEFAULT_AUTHENTICATEE;
 // Default maximum storage space to be used by the fetcher cache.
 const Bytes DEFAULT_FETCHER_CACHE_SIZE = Gigabytes(2);
 
+// Maximum number of containers whose isolators the mesos containerizer
+// cleans up concurrently, e.g., when destroying the orphans found on
+// recovery. The isolators of a container are cleaned up in order.
+const size_t MAX_CONCURRENT_CONTAINER_CLEANUPS = 16;
+
 // If no pings received within this timeout, then the slave will
 // trigger a re-detection of the master to cause a re-registration.
 Duration MASTER_PING_TIMEOUT();
@@ -109,6 +109,14 @@ private:
       vector<Containerizer*>::iterator containerizer,
       bool launched);
 
+  // Returns the first containerizer, starting at 'containerizer',
+  // that does not rule out launching the TaskInfo/ExecutorInfo up
+  // front (see Containerizer::supports).
+  vector<Containerizer*>::iterator next(
+      vector<Containerizer*>::iterator containerizer,
+      const Option<TaskInfo>& taskInfo,
+      const ExecutorInfo& executorInfo);
+
   vector<Containerizer*> containerizers_;
 
   // The states that the composing containerizer cares about for the
@@ -318,9 +326,14 @@ Future<bool> ComposingContainerizerProcess::launch(
                    "' is already launching");
   }
 
-  // Try each containerizer. If none of them handle the
-  // TaskInfo/ExecutorInfo then return a Failure.
-  vector<Containerizer*>::iterator containerizer = containerizers_.begin();
+  // Try each containerizer that supports the ExecutorInfo. If none
+  // of them handle it then return false.
+  vector<Containerizer*>::iterator containerizer =
+    next(containerizers_.begin(), None(), executorInfo);
+
+  if (containerizer == containerizers_.end()) {
+    return false;
+  }
 
   Container* container = new Container();
   container->state = LAUNCHING;
@@ -379,7 +392,7 @@ Future<bool> ComposingContainerizerProcess::_launch(
   }
 
   // Try the next containerizer.
-  ++containerizer;
+  containerizer = next(++containerizer, taskInfo, executorInfo);
 
   if (containerizer == containerizers_.end()) {
     containers_.erase(containerId);
@@ -439,9 +452,14 @@ Future<bool> ComposingContainerizerProcess::launch(
                    "' is already launching");
   }
 
-  // Try each containerizer. If none of them handle the
-  // TaskInfo/ExecutorInfo then return a Failure.
-  vector<Containerizer*>::iterator containerizer = containerizers_.begin();
+  // Try each containerizer that supports the TaskInfo/ExecutorInfo.
+  // If none of them handle it then return false.
+  vector<Containerizer*>::iterator containerizer =
+    next(containerizers_.begin(), taskInfo, executorInfo);
+
+  if (containerizer == containerizers_.end()) {
+    return false;
+  }
 
   Container* container = new Container();
   container->state = LAUNCHING;
@@ -472,6 +490,20 @@ Future<bool> ComposingContainerizerProcess::launch(
 }
 
 
+vector<Containerizer*>::iterator ComposingContainerizerProcess::next(
+    vector<Containerizer*>::iterator containerizer,
+    const Option<TaskInfo>& taskInfo,
+    const ExecutorInfo& executorInfo)
+{
+  while (containerizer != containerizers_.end() &&
+         !(*containerizer)->supports(taskInfo, executorInfo)) {
+    ++containerizer;
+  }
+
+  return containerizer;
+}
+
+
 Future<Nothing> ComposingContainerizerProcess::update(
     const ContainerID& containerId,
     const Resources& resources)
@@ -290,6 +290,13 @@ map<string, string> executorEnvironment(
     env["MESOS_RECOVERY_TIMEOUT"] = stringify(recoveryTimeout);
   }
 
+  // Have the executor talk to the slave over a unix domain socket
+  // rather than TCP if the slave's libprocess accepts the peers on
+  // this host on one. The executor falls back to TCP if it cannot.
+  if (os::hasenv("LIBPROCESS_UNIX_SOCKETS")) {
+    env["LIBPROCESS_UNIX_SOCKETS"] = os::getenv("LIBPROCESS_UNIX_SOCKETS");
+  }
+
   // Include any environment variables from Hooks.
   // TODO(karya): Call environment decorator hook _after_ putting all
   // variables from executorInfo into 'env'. This would prevent the
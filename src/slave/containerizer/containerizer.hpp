@@ -103,6 +103,18 @@ public:
       const process::PID<Slave>& slavePid,
       bool checkpoint) = 0;
 
+  // Returns false if this containerizer is known to decline launching
+  // the TaskInfo (if any) and ExecutorInfo, which lets a composing
+  // containerizer dispatch a launch without first trying (and waiting
+  // on) containerizers that cannot handle it. A containerizer that
+  // returns true may still decline the launch.
+  virtual bool supports(
+      const Option<TaskInfo>& taskInfo,
+      const ExecutorInfo& executorInfo)
+  {
+    return true;
+  }
+
   // Update the resources for a container.
   virtual process::Future<Nothing> update(
       const ContainerID& containerId,
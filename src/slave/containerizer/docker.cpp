@@ -25,9 +25,12 @@
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/io.hpp>
+#include <process/owned.hpp>
 #include <process/reap.hpp>
 #include <process/subprocess.hpp>
 
+#include <process/metrics/metrics.hpp>
+
 #include <stout/fs.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
@@ -121,7 +124,12 @@ Try<DockerContainerizer*> DockerContainerizer::create(
     const Flags& flags,
     Fetcher* fetcher)
 {
-  Try<Docker*> create = Docker::create(flags.docker);
+  Option<string> socket;
+  if (flags.docker_remote_api) {
+    socket = flags.docker_socket;
+  }
+
+  Try<Docker*> create = Docker::create(flags.docker, true, socket);
   if (create.isError()) {
     return Error("Failed to create docker: " + create.error());
   }
@@ -174,6 +182,25 @@ DockerContainerizer::~DockerContainerizer()
 }
 
 
+DockerContainerizerProcess::Metrics::Metrics()
+  : image_pull("containerizer/docker/image_pull", Days(1)),
+    image_pull_errors("containerizer/docker/image_pull_errors"),
+    image_pulls_coalesced("containerizer/docker/image_pulls_coalesced")
+{
+  process::metrics::add(image_pull);
+  process::metrics::add(image_pull_errors);
+  process::metrics::add(image_pulls_coalesced);
+}
+
+
+DockerContainerizerProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(image_pull);
+  process::metrics::remove(image_pull_errors);
+  process::metrics::remove(image_pulls_coalesced);
+}
+
+
 docker::Flags dockerFlags(
   const Flags& flags,
   const string& name,
@@ -353,20 +380,98 @@ Future<Nothing> DockerContainerizerProcess::pull(
 
   string image = container->image();
 
-  Future<Docker::Image> future = docker->pull(
-    container->directory,
-    image,
-    container->forcePullImage());
+  if (!pulls.contains(image)) {
+    pulls[image] = Owned<Pull>(
+        new Pull(container->directory, container->forcePullImage()));
+    queued.push(image);
+  } else {
+    VLOG(1) << "Docker pull " << image << " already in progress";
 
-  containers_[containerId]->pull = future;
+    ++metrics.image_pulls_coalesced;
 
-  return future.then(defer(self(), [=]() {
+    // NOTE: This has no effect if the pull is already running.
+    pulls[image]->force |= container->forcePullImage();
+  }
+
+  Owned<Promise<Docker::Image>> promise(new Promise<Docker::Image>());
+  pulls[image]->promises.push_back(promise);
+
+  _pull();
+
+  containers_[containerId]->pull = promise->future();
+
+  return promise->future().then(defer(self(), [=]() {
     VLOG(1) << "Docker pull " << image << " completed";
     return Nothing();
   }));
 }
 
 
+void DockerContainerizerProcess::_pull()
+{
+  while (!queued.empty() &&
+         (flags.docker_max_concurrent_pulls == 0 ||
+          pulling < flags.docker_max_concurrent_pulls)) {
+    const string image = queued.front();
+    queued.pop();
+
+    CHECK(pulls.contains(image));
+    Owned<Pull> pull = pulls[image];
+
+    // Skip the pull if all the containers waiting for it have been
+    // destroyed meanwhile.
+    bool discarded = true;
+    foreach (const Owned<Promise<Docker::Image>>& promise, pull->promises) {
+      if (!promise->future().hasDiscard()) {
+        discarded = false;
+        break;
+      }
+    }
+
+    if (discarded) {
+      foreach (const Owned<Promise<Docker::Image>>& promise, pull->promises) {
+        promise->discard();
+      }
+      pulls.erase(image);
+      continue;
+    }
+
+    pulling++;
+
+    metrics.image_pull.time(docker->pull(pull->directory, image, pull->force))
+      .onAny(defer(self(), &Self::__pull, image, lambda::_1));
+  }
+}
+
+
+void DockerContainerizerProcess::__pull(
+    const string& image,
+    const Future<Docker::Image>& future)
+{
+  CHECK(pulls.contains(image));
+  Owned<Pull> pull = pulls[image];
+
+  pulls.erase(image);
+  pulling--;
+
+  if (!future.isReady()) {
+    ++metrics.image_pull_errors;
+  }
+
+  foreach (const Owned<Promise<Docker::Image>>& promise, pull->promises) {
+    if (future.isReady()) {
+      promise->set(future.get());
+    } else if (future.isFailed()) {
+      promise->fail(future.failure());
+    } else {
+      promise->discard();
+    }
+  }
+
+  _pull();
+}
+
+
 Try<Nothing> DockerContainerizerProcess::checkpoint(
     const ContainerID& containerId,
     pid_t pid)
@@ -493,6 +598,20 @@ void DockerContainerizer::destroy(const ContainerID& containerId)
 }
 
 
+bool DockerContainerizer::supports(
+    const Option<TaskInfo>& taskInfo,
+    const ExecutorInfo& executorInfo)
+{
+  // NOTE: This mirrors the checks in DockerContainerizerProcess::launch.
+  if (taskInfo.isSome() && taskInfo.get().has_container()) {
+    return taskInfo.get().container().type() == ContainerInfo::DOCKER;
+  }
+
+  return executorInfo.has_container() &&
+    executorInfo.container().type() == ContainerInfo::DOCKER;
+}
+
+
 Future<hashset<ContainerID>> DockerContainerizer::containers()
 {
   return dispatch(process.get(), &DockerContainerizerProcess::containers);
@@ -959,6 +1078,10 @@ Future<pid_t> DockerContainerizerProcess::checkpointExecutor(
         "Failed to checkpoint executor's pid: " + checkpointed.error());
   }
 
+  // Remember the pid so that 'update' and 'usage' don't need to
+  // inspect the container again.
+  containers_[containerId]->pid = pid.get();
+
   return pid.get();
 }
 
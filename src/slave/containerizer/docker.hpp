@@ -19,8 +19,17 @@
 #ifndef __DOCKER_CONTAINERIZER_HPP__
 #define __DOCKER_CONTAINERIZER_HPP__
 
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <process/future.hpp>
+#include <process/owned.hpp>
 #include <process/shared.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/timer.hpp>
+
 #include <stout/flags.hpp>
 #include <stout/hashset.hpp>
 
@@ -93,6 +102,10 @@ public:
       const process::PID<Slave>& slavePid,
       bool checkpoint);
 
+  virtual bool supports(
+      const Option<TaskInfo>& taskInfo,
+      const ExecutorInfo& executorInfo);
+
   virtual process::Future<Nothing> update(
       const ContainerID& containerId,
       const Resources& resources);
@@ -123,7 +136,8 @@ public:
       process::Shared<Docker> _docker)
     : flags(_flags),
       fetcher(_fetcher),
-      docker(_docker) {}
+      docker(_docker),
+      pulling(0) {}
 
   virtual process::Future<Nothing> recover(
       const Option<state::SlaveState>& state);
@@ -236,6 +250,13 @@ private:
       const std::string& containerName,
       const Option<std::string>& executor);
 
+  // Starts the queued pulls, as many as allowed.
+  void _pull();
+
+  void __pull(
+      const std::string& image,
+      const Future<Docker::Image>& future);
+
   const Flags flags;
 
   Fetcher* fetcher;
@@ -461,6 +482,45 @@ private:
   };
 
   hashmap<ContainerID, Container*> containers_;
+
+  // A 'docker pull' of an image that is queued or running, which is
+  // shared by all the containers launched with that image meanwhile.
+  struct Pull
+  {
+    Pull(const std::string& _directory, bool _force)
+      : directory(_directory), force(_force) {}
+
+    const std::string directory;
+    bool force;
+
+    // One promise per container, so that destroying a container
+    // while pulling does not discard the pull of the others.
+    std::vector<process::Owned<process::Promise<Docker::Image>>> promises;
+  };
+
+  hashmap<std::string, process::Owned<Pull>> pulls;
+
+  // The images whose pulls are waiting for one of the running pulls
+  // to complete, see the 'docker_max_concurrent_pulls' flag.
+  std::queue<std::string> queued;
+
+  // The number of running pulls.
+  size_t pulling;
+
+  struct Metrics
+  {
+    Metrics();
+    ~Metrics();
+
+    // Latency of a 'docker pull', excluding the time spent queued.
+    process::metrics::Timer<Milliseconds> image_pull;
+
+    process::metrics::Counter image_pull_errors;
+
+    // Pulls of images that were already being pulled for another
+    // container.
+    process::metrics::Counter image_pulls_coalesced;
+  } metrics;
 };
 
 
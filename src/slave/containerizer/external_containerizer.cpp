@@ -813,6 +813,10 @@ Future<ResourceStatistics> ExternalContainerizerProcess::_usage(
   containerizer::Usage usage;
   usage.mutable_container_id()->CopyFrom(containerId);
 
+  if (flags.containerizer_daemon) {
+    return daemonUsage(usage);
+  }
+
   Try<Subprocess> invoked = invoke(
       "usage",
       usage,
@@ -871,6 +875,103 @@ Future<ResourceStatistics> ExternalContainerizerProcess::__usage(
 }
 
 
+// Reads the answer to a usage request from the daemon.
+static Future<Result<ResourceStatistics>> readStatistics(int fd)
+{
+  Result<ResourceStatistics>(*read)(int, bool, bool) =
+    &::protobuf::read<ResourceStatistics>;
+
+  return async(read, fd, false, false);
+}
+
+
+Future<ResourceStatistics> ExternalContainerizerProcess::daemonUsage(
+    const containerizer::Usage& usage)
+{
+  if (daemon.isNone()) {
+    LOG(INFO) << "Starting external containerizer daemon";
+
+    Try<Subprocess> invoked = invoke("daemon");
+
+    if (invoked.isError()) {
+      return Failure(
+          "Failed to start external containerizer daemon: " +
+          invoked.error());
+    }
+
+    daemon = invoked.get();
+    reading = Nothing();
+
+    invoked.get().status()
+      .onAny(defer(
+          self(),
+          &ExternalContainerizerProcess::daemonExited,
+          invoked.get().pid()));
+  }
+
+  // Transmit the request via stdout towards the daemon, prefixed by
+  // its size like the messages of the other invocations.
+  Try<Nothing> write = ::protobuf::write(daemon.get().in().get(), usage);
+  if (write.isError()) {
+    return Failure(
+        "Failed to write protobuf to external containerizer daemon: " +
+        write.error());
+  }
+
+  Future<Result<ResourceStatistics>> future = reading
+    .then(lambda::bind(&readStatistics, daemon.get().out().get()));
+
+  reading = future
+    .then([]() { return Nothing(); })
+    .repair([](const Future<Nothing>&) { return Nothing(); });
+
+  return future
+    .then(defer(
+        self(),
+        &ExternalContainerizerProcess::_daemonUsage,
+        daemon.get().pid(),
+        lambda::_1));
+}
+
+
+Future<ResourceStatistics> ExternalContainerizerProcess::_daemonUsage(
+    pid_t pid,
+    const Result<ResourceStatistics>& statistics)
+{
+  if (statistics.isSome()) {
+    return statistics.get();
+  }
+
+  // The daemon can not be trusted to answer the subsequent requests
+  // in order any longer, so it gets restarted.
+  if (daemon.isSome() && daemon.get().pid() == pid) {
+    LOG(WARNING) << "Killing external containerizer daemon " << pid;
+    ::kill(pid, SIGKILL);
+  }
+
+  return Failure(
+      "Could not receive any result from external containerizer daemon" +
+      (statistics.isError() ? ": " + statistics.error() : string()));
+}
+
+
+void ExternalContainerizerProcess::daemonExited(pid_t pid)
+{
+  if (daemon.isSome() && daemon.get().pid() == pid) {
+    LOG(WARNING) << "External containerizer daemon " << pid << " exited";
+    daemon = None();
+  }
+}
+
+
+void ExternalContainerizerProcess::finalize()
+{
+  if (daemon.isSome()) {
+    ::kill(daemon.get().pid(), SIGKILL);
+  }
+}
+
+
 void ExternalContainerizerProcess::destroy(const ContainerID& containerId)
 {
   VLOG(1) << "Destroy triggered on container '" << containerId << "'";
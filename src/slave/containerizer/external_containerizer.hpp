@@ -161,6 +161,9 @@ public:
   // Get all active container-id's.
   process::Future<hashset<ContainerID>> containers();
 
+protected:
+  virtual void finalize();
+
 private:
   // Startup flags.
   const Flags flags;
@@ -212,6 +215,15 @@ private:
   // Stores all active containers.
   hashmap<ContainerID, process::Owned<Container>> actives;
 
+  // The external containerizer daemon answering the usage requests
+  // (see '--containerizer_daemon'), started on the first request and
+  // restarted on the request after it exited.
+  Option<process::Subprocess> daemon;
+
+  // The daemon answers the requests in order, so the answer of a
+  // request is read once the answer of the previous one was read.
+  process::Future<Nothing> reading;
+
   process::Future<Nothing> _recover(
       const Option<state::SlaveState>& state,
       const process::Future<Option<int>>& future);
@@ -256,6 +268,16 @@ private:
           process::Future<Result<ResourceStatistics>>,
           process::Future<Option<int>>>>& future);
 
+  // Requests the usage from the external containerizer daemon.
+  process::Future<ResourceStatistics> daemonUsage(
+      const containerizer::Usage& usage);
+
+  process::Future<ResourceStatistics> _daemonUsage(
+      pid_t pid,
+      const Result<ResourceStatistics>& statistics);
+
+  void daemonExited(pid_t pid);
+
   void _destroy(const ContainerID& containerId);
 
   void __destroy(
@@ -16,24 +16,45 @@
  * limitations under the License.
  */
 
+#include <errno.h>
+#include <fcntl.h>
+#include <fts.h>
+#include <pwd.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include <set>
 #include <unordered_map>
+#include <utility>
 
 #include <process/async.hpp>
 #include <process/check.hpp>
 #include <process/collect.hpp>
 #include <process/dispatch.hpp>
 
+#include <stout/hashset.hpp>
 #include <stout/net.hpp>
+#include <stout/numify.hpp>
 #include <stout/path.hpp>
+#include <stout/protobuf.hpp>
+#include <stout/strings.hpp>
+
+#include "common/status_utils.hpp"
 
 #include "hdfs/hdfs.hpp"
 
+#include "messages/messages.hpp"
+
 #include "slave/slave.hpp"
+#include "slave/state.hpp"
 
 #include "slave/containerizer/fetcher.hpp"
 
 using std::list;
 using std::map;
+using std::pair;
+using std::set;
 using std::shared_ptr;
 using std::string;
 using std::transform;
@@ -41,6 +62,10 @@ using std::vector;
 
 using process::Future;
 
+using process::http::BadRequest;
+using process::http::NotFound;
+using process::http::OK;
+
 namespace mesos {
 namespace internal {
 namespace slave {
@@ -50,6 +75,10 @@ static const string FILE_URI_LOCALHOST = "file://localhost";
 
 static const string CACHE_FILE_NAME_PREFIX = "c";
 
+// The name of the file in the cache directory of a slave which holds
+// the index of the cache (see Cache::checkpoint).
+static const string CACHE_INDEX_FILE_NAME = "index";
+
 
 Fetcher::Fetcher() : process(new FetcherProcess())
 {
@@ -57,6 +86,12 @@ Fetcher::Fetcher() : process(new FetcherProcess())
 }
 
 
+Fetcher::Fetcher(const Flags& flags) : process(new FetcherProcess(flags))
+{
+  spawn(process.get());
+}
+
+
 Fetcher::Fetcher(const process::Owned<FetcherProcess>& process)
   : process(process)
 {
@@ -73,9 +108,6 @@ Fetcher::~Fetcher()
 
 Try<Nothing> Fetcher::recover(const SlaveID& slaveId, const Flags& flags)
 {
-  // Good enough for now, simple, least-effort recovery.
-  VLOG(1) << "Clearing fetcher cache";
-
   string cacheDirectory = paths::getSlavePath(flags.fetcher_cache_dir, slaveId);
   Result<string> path = os::realpath(cacheDirectory);
   if (path.isError()) {
@@ -85,6 +117,18 @@ Try<Nothing> Fetcher::recover(const SlaveID& slaveId, const Flags& flags)
     return Error(path.error());
   }
 
+  // Cache files listed in the index of the cache are reused. The
+  // fetcher process loads the index (and deletes any files not listed
+  // in it) once it fetches into the cache (see Cache::recover).
+  if (path.isSome() &&
+      os::exists(path::join(path.get(), CACHE_INDEX_FILE_NAME))) {
+    VLOG(1) << "Keeping fetcher cache at '" << path.get() << "'";
+
+    return Nothing();
+  }
+
+  VLOG(1) << "Clearing fetcher cache";
+
   if (path.isSome() && os::exists(path.get())) {
     Try<Nothing> rmdir = os::rmdir(path.get(), true);
     if (rmdir.isError()) {
@@ -203,6 +247,340 @@ bool Fetcher::isNetUri(const std::string& uri)
 }
 
 
+Try<bool> Fetcher::extract(
+    const string& sourcePath,
+    const string& destinationDirectory)
+{
+  // NOTE: The paths are passed as arguments rather than through a
+  // shell, they come from URIs and may contain anything.
+  vector<string> argv;
+
+  // Extract any .tgz, tar.gz, tar.bz2 or zip files.
+  if (strings::endsWith(sourcePath, ".tgz") ||
+      strings::endsWith(sourcePath, ".tar.gz") ||
+      strings::endsWith(sourcePath, ".tbz2") ||
+      strings::endsWith(sourcePath, ".tar.bz2") ||
+      strings::endsWith(sourcePath, ".txz") ||
+      strings::endsWith(sourcePath, ".tar.xz")) {
+    argv = {"tar", "-C", destinationDirectory, "-xf", sourcePath};
+  } else if (strings::endsWith(sourcePath, ".zip")) {
+    argv = {"unzip", "-d", destinationDirectory, "--", sourcePath};
+  } else {
+    return false;
+  }
+
+  const string command = "[" + strings::join(", ", argv) + "]";
+
+  LOG(INFO) << "Extracting with command: " << command;
+
+  Try<Subprocess> extract = subprocess(
+      argv[0],
+      argv,
+      Subprocess::PATH("/dev/null"),
+      Subprocess::FD(STDOUT_FILENO),
+      Subprocess::FD(STDERR_FILENO));
+
+  if (extract.isError()) {
+    return Error("Failed to extract: failed to run command " + command +
+                 ": " + extract.error());
+  }
+
+  // NOTE: This blocks the calling thread, like 'os::system' would.
+  Future<Option<int>> status = extract.get().status();
+  status.await();
+
+  if (!status.isReady() || status.get().isNone()) {
+    return Error("Failed to extract: failed to reap command " + command);
+  }
+
+  if (status.get().get() != 0) {
+    return Error("Failed to extract: command " + command + " " +
+                 WSTRINGIFY(status.get().get()));
+  }
+
+  LOG(INFO) << "Extracted '" << sourcePath << "' into '"
+            << destinationDirectory << "'";
+
+  return true;
+}
+
+
+Try<string> Fetcher::copy(
+    const string& sourcePath,
+    const string& destinationPath)
+{
+  LOG(INFO) << "Copying resource '" << sourcePath
+            << "' to '" << destinationPath << "'";
+
+  struct stat s;
+  if (::stat(sourcePath.c_str(), &s) < 0) {
+    return ErrnoError("Failed to stat '" + sourcePath + "'");
+  }
+
+  Try<int> source = os::open(sourcePath, O_RDONLY | O_CLOEXEC);
+  if (source.isError()) {
+    return Error("Failed to open '" + sourcePath + "': " + source.error());
+  }
+
+  // Replace rather than overwrite the file of an earlier URI with
+  // the same basename, which might be a link to a cache file (see
+  // 'link()').
+  if (os::exists(destinationPath)) {
+    Try<Nothing> rm = os::rm(destinationPath);
+    if (rm.isError()) {
+      os::close(source.get());
+      return Error("Failed to remove '" + destinationPath + "': " +
+                   rm.error());
+    }
+  }
+
+  // Like 'cp', give the copy the permissions of the original (minus
+  // the umask).
+  Try<int> destination = os::open(
+      destinationPath,
+      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+      s.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO));
+
+  if (destination.isError()) {
+    os::close(source.get());
+    return Error("Failed to open '" + destinationPath + "': " +
+                 destination.error());
+  }
+
+  Option<Error> error = None();
+
+  char buffer[64 * 1024];
+  while (error.isNone()) {
+    ssize_t length = ::read(source.get(), buffer, sizeof(buffer));
+    if (length < 0 && errno == EINTR) {
+      continue;
+    } else if (length < 0) {
+      error = ErrnoError("Failed to read '" + sourcePath + "'");
+    } else if (length == 0) {
+      break;
+    } else {
+      Try<Nothing> write = os::write(destination.get(), string(buffer, length));
+      if (write.isError()) {
+        error = Error("Failed to write '" + destinationPath + "': " +
+                      write.error());
+      }
+    }
+  }
+
+  os::close(source.get());
+  os::close(destination.get());
+
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  return destinationPath;
+}
+
+
+Try<string> Fetcher::link(
+    const string& sourcePath,
+    const string& destinationPath,
+    bool executable)
+{
+  struct stat s;
+  if (::stat(sourcePath.c_str(), &s) < 0) {
+    return ErrnoError("Failed to stat '" + sourcePath + "'");
+  }
+
+  // A cache file must not be shared with a sandbox whose user could
+  // modify it (see 'chown()'), e.g., if it has been chowned already.
+  if (s.st_uid != ::geteuid()) {
+    return Error("Not linking '" + sourcePath + "' which is owned by " +
+                 "user " + stringify(s.st_uid));
+  }
+
+  // Never take away the execute permissions that a link in another
+  // sandbox may depend on.
+  mode_t mode = S_IRUSR | S_IRGRP | S_IROTH;
+  if (executable || (s.st_mode & S_IXUSR)) {
+    mode |= S_IXUSR | S_IXGRP | S_IXOTH;
+  }
+
+  Try<Nothing> chmod = os::chmod(sourcePath, mode);
+  if (chmod.isError()) {
+    return Error("Failed to chmod '" + sourcePath + "': " + chmod.error());
+  }
+
+  // Like 'cp', replace the file of an earlier URI with the same
+  // basename.
+  if (os::exists(destinationPath)) {
+    Try<Nothing> rm = os::rm(destinationPath);
+    if (rm.isError()) {
+      return Error("Failed to remove '" + destinationPath + "': " +
+                   rm.error());
+    }
+  }
+
+  LOG(INFO) << "Linking resource '" << sourcePath
+            << "' to '" << destinationPath << "'";
+
+  if (::link(sourcePath.c_str(), destinationPath.c_str()) < 0) {
+    return ErrnoError("Failed to link '" + sourcePath + "' to '" +
+                      destinationPath + "'");
+  }
+
+  return destinationPath;
+}
+
+
+Try<Nothing> Fetcher::chown(
+    const string& user,
+    const string& sandboxDirectory,
+    const Option<string>& cacheDirectory)
+{
+  if (cacheDirectory.isNone() || !os::exists(cacheDirectory.get())) {
+    return os::chown(user, sandboxDirectory);
+  }
+
+  Try<list<string>> entries = os::ls(cacheDirectory.get());
+  if (entries.isError()) {
+    return Error("Failed to list '" + cacheDirectory.get() + "': " +
+                 entries.error());
+  }
+
+  set<pair<dev_t, ino_t>> cacheFiles;
+  foreach (const string& entry, entries.get()) {
+    struct stat s;
+    if (::lstat(path::join(cacheDirectory.get(), entry).c_str(), &s) == 0 &&
+        S_ISREG(s.st_mode)) {
+      cacheFiles.insert(std::make_pair(s.st_dev, s.st_ino));
+    }
+  }
+
+  passwd* passwd = ::getpwnam(user.c_str());
+  if (passwd == NULL) {
+    return ErrnoError("Failed to get user information for '" + user + "'");
+  }
+
+  char* paths[] = {const_cast<char*>(sandboxDirectory.c_str()), NULL};
+
+  FTS* tree = ::fts_open(paths, FTS_NOCHDIR | FTS_PHYSICAL, NULL);
+  if (tree == NULL) {
+    return ErrnoError("Failed to open '" + sandboxDirectory + "'");
+  }
+
+  Option<Error> error = None();
+
+  while (error.isNone()) {
+    errno = 0;
+    FTSENT* node = ::fts_read(tree);
+    if (node == NULL) {
+      if (errno != 0) {
+        error = ErrnoError("Failed to walk '" + sandboxDirectory + "'");
+      }
+      break;
+    }
+
+    switch (node->fts_info) {
+      case FTS_DP:
+        // Already chowned in preorder.
+        continue;
+      case FTS_DNR:
+      case FTS_ERR:
+      case FTS_NS:
+        error = Error("Failed to read '" + string(node->fts_path) + "': " +
+                      strerror(node->fts_errno));
+        continue;
+      case FTS_F:
+        if (cacheFiles.count(std::make_pair(
+                node->fts_statp->st_dev, node->fts_statp->st_ino)) > 0) {
+          LOG(INFO) << "Not chowning '" << node->fts_path
+                    << "' which is linked from the cache";
+          continue;
+        }
+        break;
+      default:
+        break;
+    }
+
+    if (::lchown(node->fts_path, passwd->pw_uid, passwd->pw_gid) < 0) {
+      error = ErrnoError("Failed to chown '" + string(node->fts_path) + "'");
+    }
+  }
+
+  ::fts_close(tree);
+
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  return Nothing();
+}
+
+
+Try<string> Fetcher::chmodExecutable(const string& filePath)
+{
+  Try<Nothing> chmod = os::chmod(
+      filePath, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH);
+  if (chmod.isError()) {
+    return Error("Failed to chmod executable '" +
+                 filePath + "': " + chmod.error());
+  }
+
+  return filePath;
+}
+
+
+Try<string> Fetcher::retrieve(
+    const FetcherInfo::Item& item,
+    const string& cacheDirectory,
+    const string& sandboxDirectory,
+    bool link)
+{
+  LOG(INFO) << "Fetching from cache";
+
+  Try<string> basename = Fetcher::basename(item.uri().value());
+  if (basename.isError()) {
+    return Error(basename.error());
+  }
+
+  string destinationPath = path::join(sandboxDirectory, basename.get());
+
+  string sourcePath = path::join(cacheDirectory, item.cache_filename());
+
+  if (link && !item.uri().extract()) {
+    Try<string> linked =
+      Fetcher::link(sourcePath, destinationPath, item.uri().executable());
+
+    if (linked.isSome()) {
+      return linked;
+    }
+
+    // E.g., the cache and the sandbox are on different file systems.
+    LOG(WARNING) << "Copying instead of linking resource from the cache: "
+                 << linked.error();
+  }
+
+  if (item.uri().executable()) {
+    Try<string> copied = copy(sourcePath, destinationPath);
+    if (copied.isError()) {
+      return Error(copied.error());
+    }
+
+    return chmodExecutable(copied.get());
+  } else if (item.uri().extract()) {
+    Try<bool> extracted = extract(sourcePath, sandboxDirectory);
+    if (extracted.isError()) {
+      return Error(extracted.error());
+    } else if (extracted.get()) {
+      return sandboxDirectory;
+    } else {
+      LOG(WARNING) << "Copying instead of extracting resource from URI with "
+                   << "'extract' flag, because it does not seem to be an "
+                   << "archive: " << item.uri().value();
+    }
+  }
+
+  return copy(sourcePath, destinationPath);
+}
+
+
 Future<Nothing> Fetcher::fetch(
     const ContainerID& containerId,
     const CommandInfo& commandInfo,
@@ -240,6 +618,44 @@ FetcherProcess::~FetcherProcess()
 }
 
 
+void FetcherProcess::initialize()
+{
+  route("/cache", None(), &FetcherProcess::serve);
+}
+
+
+Future<process::http::Response> FetcherProcess::serve(
+    const process::http::Request& request)
+{
+  if (!servePeers) {
+    return NotFound();
+  }
+
+  Option<string> checksum = request.query.get("checksum");
+  if (checksum.isNone() || checksum.get().empty()) {
+    return BadRequest("Expecting 'checksum=value' in query.\n");
+  }
+
+  Option<shared_ptr<Cache::Entry>> entry = cache.find(checksum.get());
+  if (entry.isNone()) {
+    return NotFound();
+  }
+
+  VLOG(1) << "Serving cache file '" << entry.get()->path().value
+          << "' to peer for checksum " << checksum.get();
+
+  // NOTE: An eviction of the entry while the file is being sent does
+  // not affect the transfer. Should the file be gone before it is
+  // opened the peer falls back to the origin of the URI.
+  OK response;
+  response.type = response.PATH;
+  response.path = entry.get()->path().value;
+  response.headers["Content-Type"] = "application/octet-stream";
+
+  return response;
+}
+
+
 // Find out how large a potential download from the given URI is.
 static Try<Bytes> fetchSize(
     const string& uri,
@@ -315,6 +731,15 @@ Future<Nothing> FetcherProcess::fetch(
   }
 
   string cacheDirectory = paths::getSlavePath(flags.fetcher_cache_dir, slaveId);
+
+  Try<Nothing> recovered =
+    cache.recover(path::join(cacheDirectory, CACHE_INDEX_FILE_NAME));
+
+  if (recovered.isError()) {
+    LOG(WARNING) << "Failed to recover the fetcher cache index: "
+                 << recovered.error();
+  }
+
   if (commandUser.isSome()) {
     // Segregating per-user cache directories.
     cacheDirectory = path::join(cacheDirectory, commandUser.get());
@@ -360,11 +785,13 @@ Future<Nothing> FetcherProcess::fetch(
     // Check if this is already in the cache (but not necessarily
     // downloaded).
     const Option<shared_ptr<Cache::Entry>> entry =
-      cache.get(commandUser, uri.value());
+      cache.get(commandUser, uri);
 
     if (entry.isSome()) {
       entry.get()->reference();
 
+      cache.touch(entry.get());
+
       // Wait for the URI to be downloaded into the cache (or fail)
       entries[uri] = entry.get()->completion()
         .then(defer(self(), [=]() {
@@ -461,6 +888,85 @@ Future<Nothing> FetcherProcess::_fetch(
 }
 
 
+// Does what the mesos-fetcher program does for a RETRIEVE_FROM_CACHE
+// item of the given FetcherInfo.
+static Try<Nothing> retrieveFromCache(
+    const FetcherInfo& info,
+    const FetcherInfo::Item& item)
+{
+  Try<string> retrieved = Fetcher::retrieve(
+      item,
+      info.cache_directory(),
+      info.sandbox_directory(),
+      info.link_from_cache());
+
+  if (retrieved.isError()) {
+    return Error("Failed to fetch '" + item.uri().value() + "': " +
+                 retrieved.error());
+  }
+
+  VLOG(1) << "Fetched '" << item.uri().value()
+          << "' to '" << retrieved.get() << "'";
+
+  return Nothing();
+}
+
+
+// Does what the mesos-fetcher program does once all items of the
+// given FetcherInfo are fetched.
+static Try<Nothing> chownSandbox(const FetcherInfo& info)
+{
+  if (info.has_user()) {
+    Try<Nothing> chown = Fetcher::chown(
+        info.user(),
+        info.sandbox_directory(),
+        info.link_from_cache() ?
+          Option<string>::some(info.cache_directory()) :
+            Option<string>::none());
+
+    if (chown.isError()) {
+      return Error("Failed to chown " + info.sandbox_directory() + ": " +
+                   chown.error());
+    }
+  }
+
+  return Nothing();
+}
+
+
+Future<Nothing> FetcherProcess::retrieve(
+    const ContainerID& containerId,
+    const FetcherInfo& info,
+    int index)
+{
+  if (!retrievals.contains(containerId)) {
+    return Failure("Fetcher for container '" + stringify(containerId) +
+                   "' was killed");
+  }
+
+  const bool last = index == info.items_size();
+
+  Future<Try<Nothing>> retrieved = last
+    ? async([=]() { return chownSandbox(info); })
+    : async([=]() { return retrieveFromCache(info, info.items(index)); });
+
+  return retrieved
+    .then(defer(self(), [=](const Try<Nothing>& retrieved) -> Future<Nothing> {
+      if (retrieved.isError()) {
+        retrievals.erase(containerId);
+        return Failure(retrieved.error());
+      }
+
+      if (last) {
+        retrievals.erase(containerId);
+        return Nothing();
+      }
+
+      return retrieve(containerId, info, index + 1);
+    }));
+}
+
+
 Future<Nothing> FetcherProcess::__fetch(
     const hashmap<CommandInfo::URI, Option<shared_ptr<Cache::Entry>>>& entries,
     const ContainerID& containerId,
@@ -510,9 +1016,46 @@ Future<Nothing> FetcherProcess::__fetch(
     info.set_frameworks_home(flags.frameworks_home);
   }
 
-  return run(containerId, sandboxDirectory, user, info, flags)
+  info.set_concurrent_downloads(flags.fetcher_concurrent_downloads);
+  info.set_link_from_cache(flags.fetcher_cache_links);
+
+  if (flags.fetcher_peers.isSome()) {
+    foreach (const string& peer,
+             strings::tokenize(flags.fetcher_peers.get(), ",")) {
+      // Peers run the same slave binary, so their fetcher process has
+      // the same ID as ours.
+      info.add_peers(strings::contains(peer, "/")
+          ? peer
+          : "http://" + peer + "/" + self().id + "/cache");
+    }
+  }
+
+  // When all URIs are cache hits there is nothing to download. Then
+  // we retrieve them from the cache ourselves (asynchronously) instead
+  // of paying for forking and starting another mesos-fetcher program.
+  bool download = false;
+  foreach (const FetcherInfo::Item& item, info.items()) {
+    if (item.action() != FetcherInfo::Item::RETRIEVE_FROM_CACHE) {
+      download = true;
+      break;
+    }
+  }
+
+  Future<Nothing> fetched;
+  if (download) {
+    fetched = run(containerId, sandboxDirectory, user, info, flags);
+  } else {
+    VLOG(1) << "Retrieving all URIs for container '" << containerId
+            << "' from the cache";
+
+    retrievals.insert(containerId);
+
+    fetched = retrieve(containerId, info);
+  }
+
+  return fetched
     .repair(defer(self(), [=](const Future<Nothing>& future) {
-      LOG(ERROR) << "Failed to run mesos-fetcher: " << future.failure();
+      LOG(ERROR) << "Failed to fetch: " << future.failure();
 
       foreachvalue (const Option<shared_ptr<Cache::Entry>>& entry, entries) {
         if (entry.isSome()) {
@@ -553,6 +1096,8 @@ Future<Nothing> FetcherProcess::__fetch(
         }
       }
 
+      cache.checkpoint();
+
       return Nothing();
     }));
 }
@@ -801,6 +1346,12 @@ Future<Nothing> FetcherProcess::run(
 
 void FetcherProcess::kill(const ContainerID& containerId)
 {
+  // Stops retrieving from the cache after the current URI.
+  if (retrievals.contains(containerId)) {
+    VLOG(1) << "Stopping the retrieval for container '" << containerId << "'";
+    retrievals.erase(containerId);
+  }
+
   if (subprocessPids.contains(containerId)) {
     VLOG(1) << "Killing the fetcher for container '" << containerId << "'";
     // Best effort kill the entire fetcher tree.
@@ -851,9 +1402,17 @@ string FetcherProcess::Cache::nextFilename(const CommandInfo::URI& uri)
 }
 
 
-static string cacheKey(const Option<string>& user, const string& uri)
+// Content with a checksum is identified by it rather than by its URI,
+// so that a cache file is shared by all URIs with the same content.
+static string cacheKey(
+    const Option<string>& user,
+    const CommandInfo::URI& uri)
 {
-  return user.isNone() ? uri : user.get() + "@" + uri;
+  const string key = uri.has_checksum()
+    ? "sha256:" + strings::lower(uri.checksum())
+    : uri.value();
+
+  return user.isNone() ? key : user.get() + "@" + key;
 }
 
 
@@ -862,13 +1421,13 @@ shared_ptr<FetcherProcess::Cache::Entry> FetcherProcess::Cache::create(
     const Option<string>& user,
     const CommandInfo::URI& uri)
 {
-  const string key = cacheKey(user, uri.value());
+  const string key = cacheKey(user, uri);
   const string filename = nextFilename(uri);
 
   auto entry = shared_ptr<Cache::Entry>(
       new Cache::Entry(key, cacheDirectory, filename));
 
-  table.put(key, entry);
+  table.put(key, lru.insert(lru.end(), entry));
 
   VLOG(1) << "Created cache entry '" << key << "' with file: " << filename;
 
@@ -879,17 +1438,39 @@ shared_ptr<FetcherProcess::Cache::Entry> FetcherProcess::Cache::create(
 Option<shared_ptr<FetcherProcess::Cache::Entry>>
 FetcherProcess::Cache::get(
     const Option<string>& user,
-    const string& uri)
+    const CommandInfo::URI& uri)
 {
   const string key = cacheKey(user, uri);
 
-  return table.get(key);
+  if (!table.contains(key)) {
+    return None();
+  }
+
+  return *table[key];
+}
+
+
+Option<shared_ptr<FetcherProcess::Cache::Entry>>
+FetcherProcess::Cache::find(const string& checksum)
+{
+  // See cacheKey().
+  const string suffix = "sha256:" + strings::lower(checksum);
+
+  foreach (const shared_ptr<Cache::Entry>& entry, lru) {
+    if ((entry->key == suffix ||
+         strings::endsWith(entry->key, "@" + suffix)) &&
+        entry->completion().isReady()) {
+      return entry;
+    }
+  }
+
+  return None();
 }
 
 
 bool FetcherProcess::Cache::contains(
     const Option<string>& user,
-    const string& uri)
+    const CommandInfo::URI& uri)
 {
   return get(user, uri).isSome();
 }
@@ -897,12 +1478,130 @@ bool FetcherProcess::Cache::contains(
 
 bool FetcherProcess::Cache::contains(const shared_ptr<Cache::Entry>& entry)
 {
-  Option<shared_ptr<Cache::Entry>> found = table.get(entry->key);
-  if (found.isNone()) {
+  if (!table.contains(entry->key)) {
     return false;
   }
 
-  return found == entry;
+  return *table[entry->key] == entry;
+}
+
+
+void FetcherProcess::Cache::touch(const shared_ptr<Cache::Entry>& entry)
+{
+  CHECK(contains(entry));
+
+  lru.splice(lru.end(), lru, table[entry->key]);
+}
+
+
+Try<Nothing> FetcherProcess::Cache::recover(const string& _indexPath)
+{
+  if (indexPath == _indexPath) {
+    return Nothing();
+  }
+
+  indexPath = _indexPath;
+
+  if (!os::exists(_indexPath)) {
+    return Nothing();
+  }
+
+  Result<FetcherCacheIndex> index =
+    ::protobuf::read<FetcherCacheIndex>(_indexPath);
+
+  if (index.isError()) {
+    return Error("Failed to read '" + _indexPath + "': " + index.error());
+  }
+
+  hashset<string> paths;
+
+  if (index.isSome()) {
+    foreach (const FetcherCacheIndex::Entry& item, index.get().entries()) {
+      if (table.contains(item.key())) {
+        continue;
+      }
+
+      auto entry = shared_ptr<Cache::Entry>(
+          new Cache::Entry(item.key(), item.directory(), item.filename()));
+
+      Try<Bytes> size = os::stat::size(
+          entry->path().value, os::stat::DO_NOT_FOLLOW_SYMLINK);
+
+      if (size.isError() || size.get() != Bytes(item.size())) {
+        LOG(WARNING) << "Dropping fetcher cache entry '" << item.key()
+                     << "' because its file is missing or has changed: "
+                     << entry->path();
+        continue;
+      }
+
+      // Keep the file names of new entries distinct from these ones
+      // (see nextFilename).
+      const vector<string> tokens = strings::tokenize(
+          item.filename().substr(CACHE_FILE_NAME_PREFIX.size()), "-");
+
+      if (!tokens.empty()) {
+        Try<unsigned long> serial = numify<unsigned long>(tokens[0]);
+        if (serial.isSome() && serial.get() > filenameSerial) {
+          filenameSerial = serial.get();
+        }
+      }
+
+      claimSpace(size.get());
+
+      entry->size = size.get();
+      entry->complete();
+
+      table.put(item.key(), lru.insert(lru.end(), entry));
+
+      paths.insert(entry->path().value);
+    }
+  }
+
+  // Delete the cache files that are not listed in the index, e.g.,
+  // those of downloads interrupted by the slave restart.
+  Try<string> directory = os::dirname(_indexPath);
+  CHECK_SOME(directory);
+
+  Try<list<string>> files = os::find(directory.get(), CACHE_FILE_NAME_PREFIX);
+  if (files.isSome()) {
+    foreach (const string& file, files.get()) {
+      if (!paths.contains(file)) {
+        VLOG(1) << "Deleting unindexed fetcher cache file: " << file;
+        os::rm(file);
+      }
+    }
+  }
+
+  LOG(INFO) << "Recovered " << table.size() << " fetcher cache entries from '"
+            << _indexPath << "'";
+
+  return Nothing();
+}
+
+
+void FetcherProcess::Cache::checkpoint()
+{
+  if (indexPath.isNone()) {
+    return;
+  }
+
+  FetcherCacheIndex index;
+
+  foreach (const shared_ptr<Cache::Entry>& entry, lru) {
+    if (entry->completion().isReady()) {
+      FetcherCacheIndex::Entry* item = index.add_entries();
+      item->set_key(entry->key);
+      item->set_directory(entry->directory);
+      item->set_filename(entry->filename);
+      item->set_size(entry->size.bytes());
+    }
+  }
+
+  Try<Nothing> checkpoint = state::checkpoint(indexPath.get(), index);
+  if (checkpoint.isError()) {
+    LOG(WARNING) << "Failed to checkpoint the fetcher cache index to '"
+                 << indexPath.get() << "': " << checkpoint.error();
+  }
 }
 
 
@@ -946,6 +1645,9 @@ Try<Nothing> FetcherProcess::Cache::remove(
 
   CHECK(contains(entry));
 
+  const bool indexed = entry->completion().isReady();
+
+  lru.erase(table[entry->key]);
   table.erase(entry->key);
 
   // We may or may not have started downloading. The download may or may
@@ -969,6 +1671,10 @@ Try<Nothing> FetcherProcess::Cache::remove(
     entry->size = 0;
   }
 
+  if (indexed) {
+    checkpoint();
+  }
+
   return Nothing();
 }
 
@@ -976,14 +1682,12 @@ Try<Nothing> FetcherProcess::Cache::remove(
 Try<list<shared_ptr<FetcherProcess::Cache::Entry>>>
 FetcherProcess::Cache::selectVictims(const Bytes& requiredSpace)
 {
-  // TODO(bernd-mesos): Implement more elaborate selection criteria
-  // (LRU/MRU, etc.).
-
+  // Evict the least recently used entries first.
   list<shared_ptr<FetcherProcess::Cache::Entry>> result;
 
   Bytes space = 0;
 
-  foreachvalue (const shared_ptr<Cache::Entry>& entry, table) {
+  foreach (const shared_ptr<Cache::Entry>& entry, lru) {
     if (!entry->isReferenced()) {
       result.push_back(entry);
 
@@ -19,6 +19,8 @@
 #ifndef __SLAVE_CONTAINERIZER_FETCHER_HPP__
 #define __SLAVE_CONTAINERIZER_FETCHER_HPP__
 
+#include <list>
+#include <memory>
 #include <string>
 
 #include <mesos/mesos.hpp>
@@ -27,10 +29,12 @@
 
 #include <process/id.hpp>
 #include <process/future.hpp>
+#include <process/http.hpp>
 #include <process/process.hpp>
 #include <process/subprocess.hpp>
 
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 
 #include "slave/flags.hpp"
 
@@ -78,8 +82,58 @@ public:
 
   static bool isNetUri(const std::string& uri);
 
+  // Try to extract sourcePath into directory. If sourcePath is
+  // recognized as an archive it will be extracted and true returned;
+  // if not recognized then false will be returned. An Error is
+  // returned if the extraction command fails.
+  static Try<bool> extract(
+      const std::string& sourcePath,
+      const std::string& destinationDirectory);
+
+  static Try<std::string> copy(
+      const std::string& sourcePath,
+      const std::string& destinationPath);
+
+  // Hard links the (cache) file at sourcePath to destinationPath,
+  // replacing any existing file there. As the file is shared it is
+  // made read-only first, and executable if requested (it stays
+  // executable if it already was).
+  static Try<std::string> link(
+      const std::string& sourcePath,
+      const std::string& destinationPath,
+      bool executable);
+
+  // Recursively chowns the sandbox directory to the user, except for
+  // the files linked from the given cache directory: they stay owned
+  // by the slave (and read-only, see 'link()') so that a task cannot
+  // modify a cache file through its link in the sandbox.
+  static Try<Nothing> chown(
+      const std::string& user,
+      const std::string& sandboxDirectory,
+      const Option<std::string>& cacheDirectory);
+
+  // TODO(bernd-mesos): Refactor this into stout so that we can more
+  // easily chmod an exectuable. For example, we could define some
+  // static flags so that someone can do:
+  // os::chmod(path, EXECUTABLE_CHMOD_FLAGS).
+  static Try<std::string> chmodExecutable(const std::string& filePath);
+
+  // Copies, links (see 'FetcherInfo.link_from_cache'), or extracts,
+  // the cache file of a cached item into the sandbox directory.
+  // Returns the resulting file or in case of extraction the
+  // destination directory (for logging). Used by both the
+  // mesos-fetcher program and FetcherProcess, which retrieves cached
+  // items without running the former.
+  static Try<std::string> retrieve(
+      const FetcherInfo::Item& item,
+      const std::string& cacheDirectory,
+      const std::string& sandboxDirectory,
+      bool link);
+
   Fetcher();
 
+  explicit Fetcher(const Flags& flags);
+
   // This is only public for tests.
   Fetcher(const process::Owned<FetcherProcess>& process);
 
@@ -116,7 +170,13 @@ private:
 class FetcherProcess : public process::Process<FetcherProcess>
 {
 public:
-  FetcherProcess() : ProcessBase(process::ID::generate("fetcher")) {}
+  FetcherProcess()
+    : ProcessBase(process::ID::generate("fetcher")),
+      servePeers(false) {}
+
+  explicit FetcherProcess(const Flags& flags)
+    : ProcessBase(process::ID::generate("fetcher")),
+      servePeers(flags.fetcher_serve_peers) {}
 
   virtual ~FetcherProcess();
 
@@ -186,7 +246,7 @@ public:
       // that the slave flags get injected into the fetcher.
       Path path() { return Path(path::join(directory, filename)); }
 
-      // Uniquely identifies a user/URI combination.
+      // Uniquely identifies a user/URI (or user/checksum) combination.
       const std::string key;
 
       // Cache directory where this entry is stored.
@@ -236,17 +296,39 @@ public:
         const CommandInfo::URI& uri);
 
     // Retrieves the cache entry indexed by the parameters, without
-    // changing its reference count.
+    // changing its reference count. URIs with a checksum share the
+    // entry of their content.
     Option<std::shared_ptr<Entry>> get(
         const Option<std::string>& user,
-        const std::string& uri);
+        const CommandInfo::URI& uri);
+
+    // Retrieves a completely downloaded entry holding the content with
+    // the given checksum, regardless of the user it was fetched for.
+    Option<std::shared_ptr<Entry>> find(const std::string& checksum);
 
     // Returns whether an entry for this user and URI is in the cache.
-    bool contains(const Option<std::string>& user, const std::string& uri);
+    bool contains(
+        const Option<std::string>& user,
+        const CommandInfo::URI& uri);
 
     // Returns whether this identical entry is in the cache.
     bool contains(const std::shared_ptr<Cache::Entry>& entry);
 
+    // Marks the entry as the most recently used one, which makes it
+    // the last candidate for eviction.
+    void touch(const std::shared_ptr<Cache::Entry>& entry);
+
+    // Loads the completely downloaded entries listed in the index at
+    // the given path (see 'checkpoint'), unless this index has been
+    // loaded already, and claims their space. Entries whose cache
+    // files are missing or have an unexpected size are dropped.
+    Try<Nothing> recover(const std::string& indexPath);
+
+    // Writes the completely downloaded entries, in least recently used
+    // order, to the index loaded by 'recover' so that they can be
+    // reused after a slave restart. Warns on failure.
+    void checkpoint();
+
     // Completely deletes a cache entry and its file. Warns on failure.
     // Virtual for mock testing.
     virtual Try<Nothing> remove(const std::shared_ptr<Entry>& entry);
@@ -279,9 +361,16 @@ public:
     // Used to generate distinct cache file names simply by counting.
     unsigned long filenameSerial;
 
+    // The path of the index of this cache, if recovered.
+    Option<std::string> indexPath;
+
+    // All cache file entries, least recently used first.
+    std::list<std::shared_ptr<Entry>> lru;
+
     // Maps keys (cache directory / URI combinations) to cache file
-    // entries.
-    hashmap<std::string, std::shared_ptr<Entry>> table;
+    // entries by their position in 'lru', so that entries can be
+    // looked up, touched and removed in constant time.
+    hashmap<std::string, std::list<std::shared_ptr<Entry>>::iterator> table;
   };
 
   // Public and virtual for mock testing.
@@ -310,7 +399,15 @@ public:
   // by cache entries. For testing.
   Bytes availableCacheSpace();
 
+protected:
+  virtual void initialize();
+
 private:
+  // HTTP endpoint which serves cache files to the fetchers of peer
+  // slaves, looked up by the checksum given as query parameter.
+  process::Future<process::http::Response> serve(
+      const process::http::Request& request);
+
   process::Future<Nothing> __fetch(
       const hashmap<CommandInfo::URI,
       Option<std::shared_ptr<Cache::Entry>>>& entries,
@@ -320,6 +417,15 @@ private:
       const Option<std::string>& user,
       const Flags& flags);
 
+  // Retrieves the items of the given FetcherInfo, starting with the
+  // one at 'index', which must all be cache hits, from the cache. The
+  // items are retrieved one at a time (asynchronously) so that killing
+  // the fetcher of the container stops the retrieval, see 'kill()'.
+  process::Future<Nothing> retrieve(
+      const ContainerID& containerId,
+      const FetcherInfo& info,
+      int index = 0);
+
   // Calls Cache::reserve() and returns a ready entry future if successful,
   // else Failure. Claims the space and assigns the entry's size to this
   // amount if and only if successful.
@@ -329,7 +435,14 @@ private:
 
   Cache cache;
 
+  // Whether 'serve' answers peers.
+  const bool servePeers;
+
   hashmap<ContainerID, pid_t> subprocessPids;
+
+  // The containers whose URIs are being retrieved from the cache by
+  // 'retrieve()' rather than by a mesos-fetcher subprocess.
+  hashset<ContainerID> retrievals;
 };
 
 } // namespace slave {
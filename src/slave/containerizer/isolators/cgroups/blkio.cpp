@@ -0,0 +1,508 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mesos/resources.hpp>
+#include <mesos/values.hpp>
+
+#include <process/defer.hpp>
+#include <process/pid.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/check.hpp>
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
+#include <stout/nothing.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+#include <stout/try.hpp>
+
+#include "linux/cgroups.hpp"
+
+#include "slave/containerizer/isolators/cgroups/blkio.hpp"
+#include "slave/containerizer/isolators/cgroups/constants.hpp"
+
+using namespace process;
+
+using std::list;
+using std::string;
+using std::vector;
+
+using mesos::slave::ExecutorRunState;
+using mesos::slave::Isolator;
+using mesos::slave::IsolatorProcess;
+using mesos::slave::Limitation;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// The names of the scalar resources that throttle the block I/O of a
+// container, in MB/s and operations per second respectively.
+static const char DISK_BANDWIDTH[] = "disk_bandwidth";
+static const char DISK_IOPS[] = "disk_iops";
+
+
+// Returns the device (in the 'major:minor' format) of the disk that
+// holds 'path'. The blkio throttling only applies to whole disks so a
+// partition is resolved to the disk it is part of.
+static Try<string> disk(const string& path)
+{
+  struct stat s;
+  if (::stat(path.c_str(), &s) < 0) {
+    return ErrnoError("Failed to stat '" + path + "'");
+  }
+
+  const string device =
+    stringify(major(s.st_dev)) + ":" + stringify(minor(s.st_dev));
+
+  const string sysfs = path::join("/sys/dev/block", device);
+  if (!os::exists(sysfs)) {
+    return Error("'" + path + "' is not on a block device");
+  }
+
+  if (!os::exists(path::join(sysfs, "partition"))) {
+    return device;
+  }
+
+  Try<string> read = os::read(path::join(sysfs, "..", "dev"));
+  if (read.isError()) {
+    return Error(
+        "Failed to determine the disk of partition " + device + ": " +
+        read.error());
+  }
+
+  return strings::trim(read.get());
+}
+
+
+// Returns the total number of bytes (or operations) read and written
+// by the cgroup to the device from a blkio.throttle.io_service_bytes
+// (or blkio.throttle.io_serviced) control, which has lines like
+// '8:0 Read 4096'.
+static Try<std::pair<uint64_t, uint64_t>> serviced(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& control,
+    const string& device)
+{
+  Try<string> read = cgroups::read(hierarchy, cgroup, control);
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  uint64_t reads = 0;
+  uint64_t writes = 0;
+
+  foreach (const string& line, strings::tokenize(read.get(), "\n")) {
+    vector<string> tokens = strings::tokenize(line, " ");
+    if (tokens.size() != 3 || tokens[0] != device) {
+      continue;
+    }
+
+    Try<uint64_t> value = numify<uint64_t>(tokens[2]);
+    if (value.isError()) {
+      return Error("Failed to parse '" + line + "': " + value.error());
+    }
+
+    if (tokens[1] == "Read") {
+      reads += value.get();
+    } else if (tokens[1] == "Write") {
+      writes += value.get();
+    }
+  }
+
+  return std::make_pair(reads, writes);
+}
+
+
+Try<Isolator*> CgroupsBlkioIsolatorProcess::create(const Flags& flags)
+{
+  Try<string> hierarchy = cgroups::prepare(
+      flags.cgroups_hierarchy,
+      "blkio",
+      flags.cgroups_root);
+
+  if (hierarchy.isError()) {
+    return Error("Failed to create blkio cgroup: " + hierarchy.error());
+  }
+
+  Try<string> _device = disk(flags.work_dir);
+  if (_device.isError()) {
+    return Error(
+        "Failed to determine the device of the work directory: " +
+        _device.error());
+  }
+
+  LOG(INFO) << "Isolating block I/O to device " << _device.get()
+            << " of the work directory " << flags.work_dir;
+
+  process::Owned<IsolatorProcess> process(
+      new CgroupsBlkioIsolatorProcess(flags, hierarchy.get(), _device.get()));
+
+  return new Isolator(process);
+}
+
+
+CgroupsBlkioIsolatorProcess::CgroupsBlkioIsolatorProcess(
+    const Flags& _flags,
+    const string& _hierarchy,
+    const string& _device)
+  : flags(_flags),
+    hierarchy(_hierarchy),
+    device(_device) {}
+
+
+CgroupsBlkioIsolatorProcess::~CgroupsBlkioIsolatorProcess() {}
+
+
+Future<Nothing> CgroupsBlkioIsolatorProcess::recover(
+    const list<ExecutorRunState>& states,
+    const hashset<ContainerID>& orphans)
+{
+  foreach (const ExecutorRunState& state, states) {
+    const ContainerID& containerId = state.id;
+    const string cgroup = path::join(flags.cgroups_root, containerId.value());
+
+    Try<bool> exists = cgroups::exists(hierarchy, cgroup);
+    if (exists.isError()) {
+      foreachvalue (Info* info, infos) {
+        delete info;
+      }
+
+      infos.clear();
+      return Failure("Failed to check cgroup " + cgroup +
+                     " for container '" + stringify(containerId) + "'");
+    }
+
+    if (!exists.get()) {
+      // This may occur if the executor is exiting and the isolator has
+      // destroyed the cgroup but the slave dies before noticing this, or
+      // if this isolator is now enabled for a container that was started
+      // without it. Such a container's block I/O simply isn't isolated.
+      VLOG(1) << "Couldn't find blkio cgroup for container " << containerId;
+      continue;
+    }
+
+    infos[containerId] = new Info(containerId, cgroup);
+  }
+
+  // Remove orphan cgroups.
+  Try<vector<string>> cgroups = cgroups::get(hierarchy, flags.cgroups_root);
+  if (cgroups.isError()) {
+    foreachvalue (Info* info, infos) {
+      delete info;
+    }
+
+    infos.clear();
+    return Failure(cgroups.error());
+  }
+
+  foreach (const string& cgroup, cgroups.get()) {
+    // Ignore the slave cgroup (see the --slave_subsystems flag).
+    // TODO(idownes): Remove this when the cgroups layout is updated,
+    // see MESOS-1185.
+    if (cgroup == path::join(flags.cgroups_root, "slave")) {
+      continue;
+    }
+
+    ContainerID containerId;
+    containerId.set_value(os::basename(cgroup).get());
+
+    if (infos.contains(containerId)) {
+      continue;
+    }
+
+    // Known orphan cgroups will be destroyed by the containerizer
+    // using the normal cleanup path. See details in MESOS-2367.
+    if (orphans.contains(containerId)) {
+      infos[containerId] = new Info(containerId, cgroup);
+      continue;
+    }
+
+    LOG(INFO) << "Removing unknown orphaned cgroup '" << cgroup << "'";
+
+    // We don't wait on the destroy as we don't want to block recovery.
+    cgroups::destroy(hierarchy, cgroup, cgroups::DESTROY_TIMEOUT);
+  }
+
+  return Nothing();
+}
+
+
+Future<Option<CommandInfo>> CgroupsBlkioIsolatorProcess::prepare(
+    const ContainerID& containerId,
+    const ExecutorInfo& executorInfo,
+    const string& directory,
+    const Option<string>& rootfs,
+    const Option<string>& user)
+{
+  if (infos.contains(containerId)) {
+    return Failure("Container has already been prepared");
+  }
+
+  Info* info = new Info(
+      containerId,
+      path::join(flags.cgroups_root, containerId.value()));
+
+  infos[containerId] = CHECK_NOTNULL(info);
+
+  // Create a cgroup for this container.
+  Try<bool> exists = cgroups::exists(hierarchy, info->cgroup);
+
+  if (exists.isError()) {
+    return Failure("Failed to prepare isolator: " + exists.error());
+  } else if (exists.get()) {
+    return Failure("Failed to prepare isolator: cgroup already exists");
+  }
+
+  Try<Nothing> create = cgroups::create(hierarchy, info->cgroup);
+  if (create.isError()) {
+    return Failure("Failed to prepare isolator: " + create.error());
+  }
+
+  // Chown the cgroup so the executor can create nested cgroups. Do
+  // not recurse so the control files are still owned by the slave
+  // user and thus cannot be changed by the executor.
+  if (user.isSome()) {
+    Try<Nothing> chown = os::chown(
+        user.get(),
+        path::join(hierarchy, info->cgroup),
+        false);
+
+    if (chown.isError()) {
+      return Failure("Failed to prepare isolator: " + chown.error());
+    }
+  }
+
+  return update(containerId, executorInfo.resources())
+    .then([]() -> Future<Option<CommandInfo>> {
+      return None();
+    });
+}
+
+
+Future<Nothing> CgroupsBlkioIsolatorProcess::isolate(
+    const ContainerID& containerId,
+    pid_t pid)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  Try<Nothing> assign = cgroups::assign(hierarchy, info->cgroup, pid);
+  if (assign.isError()) {
+    return Failure("Failed to assign container '" +
+                   stringify(info->containerId) + "' to its own cgroup '" +
+                   path::join(hierarchy, info->cgroup) +
+                   "' : " + assign.error());
+  }
+
+  return Nothing();
+}
+
+
+Future<Limitation> CgroupsBlkioIsolatorProcess::watch(
+    const ContainerID& containerId)
+{
+  // No resources are limited.
+  return Future<Limitation>();
+}
+
+
+Future<Nothing> CgroupsBlkioIsolatorProcess::update(
+    const ContainerID& containerId,
+    const Resources& resources)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  // NOTE: The proportional weight is only available with the CFQ
+  // (or BFQ) I/O scheduler.
+  if (resources.cpus().isSome() &&
+      os::exists(path::join(hierarchy, info->cgroup, "blkio.weight"))) {
+    uint64_t weight = std::min(
+        std::max(
+            (uint64_t) (BLKIO_WEIGHT_PER_CPU * resources.cpus().get()),
+            MIN_BLKIO_WEIGHT),
+        MAX_BLKIO_WEIGHT);
+
+    Try<Nothing> write = cgroups::write(
+        hierarchy,
+        info->cgroup,
+        "blkio.weight",
+        stringify(weight));
+
+    if (write.isError()) {
+      return Failure("Failed to update 'blkio.weight': " + write.error());
+    }
+
+    LOG(INFO) << "Updated 'blkio.weight' to " << weight
+              << " (cpus " << resources.cpus().get() << ")"
+              << " for container " << containerId;
+  }
+
+  // A limit of 0 removes the limit.
+  uint64_t bps = 0;
+  uint64_t iops = 0;
+
+  Option<Value::Scalar> bandwidth =
+    resources.get<Value::Scalar>(DISK_BANDWIDTH);
+
+  if (bandwidth.isSome()) {
+    bps = (Megabytes(1) * bandwidth.get().value()).bytes();
+  }
+
+  Option<Value::Scalar> operations =
+    resources.get<Value::Scalar>(DISK_IOPS);
+
+  if (operations.isSome()) {
+    iops = (uint64_t) operations.get().value();
+  }
+
+  vector<std::pair<string, uint64_t>> limits = {
+    {"blkio.throttle.read_bps_device", bps},
+    {"blkio.throttle.write_bps_device", bps},
+    {"blkio.throttle.read_iops_device", iops},
+    {"blkio.throttle.write_iops_device", iops}
+  };
+
+  foreach (const auto& limit, limits) {
+    Try<Nothing> write = cgroups::write(
+        hierarchy,
+        info->cgroup,
+        limit.first,
+        device + " " + stringify(limit.second));
+
+    if (write.isError()) {
+      return Failure(
+          "Failed to update '" + limit.first + "': " + write.error());
+    }
+  }
+
+  LOG(INFO) << "Updated the block I/O limits of device " << device
+            << " to " << (bps == 0 ? "unlimited" : stringify(Bytes(bps)))
+            << " per second and "
+            << (iops == 0 ? "unlimited" : stringify(iops))
+            << " operations per second for container " << containerId;
+
+  return Nothing();
+}
+
+
+Future<ResourceStatistics> CgroupsBlkioIsolatorProcess::usage(
+    const ContainerID& containerId)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  ResourceStatistics result;
+
+  // NOTE: Unlike blkio.io_service_bytes, the throttle statistics are
+  // available independent of the I/O scheduler.
+  Try<std::pair<uint64_t, uint64_t>> bytes = serviced(
+      hierarchy,
+      info->cgroup,
+      "blkio.throttle.io_service_bytes",
+      device);
+
+  if (bytes.isError()) {
+    return Failure(
+        "Failed to read 'blkio.throttle.io_service_bytes': " + bytes.error());
+  }
+
+  result.set_disk_read_bytes(bytes.get().first);
+  result.set_disk_write_bytes(bytes.get().second);
+
+  Try<std::pair<uint64_t, uint64_t>> operations = serviced(
+      hierarchy,
+      info->cgroup,
+      "blkio.throttle.io_serviced",
+      device);
+
+  if (operations.isError()) {
+    return Failure(
+        "Failed to read 'blkio.throttle.io_serviced': " + operations.error());
+  }
+
+  result.set_disk_read_ops(operations.get().first);
+  result.set_disk_write_ops(operations.get().second);
+
+  return result;
+}
+
+
+Future<Nothing> CgroupsBlkioIsolatorProcess::cleanup(
+    const ContainerID& containerId)
+{
+  // Multiple calls may occur during test clean up.
+  if (!infos.contains(containerId)) {
+    VLOG(1) << "Ignoring cleanup request for unknown container: "
+            << containerId;
+
+    return Nothing();
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  return cgroups::destroy(hierarchy, info->cgroup, cgroups::DESTROY_TIMEOUT)
+    .then(defer(PID<CgroupsBlkioIsolatorProcess>(this),
+                &CgroupsBlkioIsolatorProcess::_cleanup,
+                containerId));
+}
+
+
+Future<Nothing> CgroupsBlkioIsolatorProcess::_cleanup(
+    const ContainerID& containerId)
+{
+  if (!infos.contains(containerId)) {
+    return Nothing();
+  }
+
+  delete infos[containerId];
+  infos.erase(containerId);
+
+  return Nothing();
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
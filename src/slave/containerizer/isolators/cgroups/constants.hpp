@@ -36,6 +36,12 @@ const Duration MIN_CPU_CFS_QUOTA = Milliseconds(1);
 // Memory subsystem constants.
 const Bytes MIN_MEMORY = Megabytes(32);
 
+
+// Block IO subsystem constants.
+const uint64_t BLKIO_WEIGHT_PER_CPU = 100;
+const uint64_t MIN_BLKIO_WEIGHT = 10;
+const uint64_t MAX_BLKIO_WEIGHT = 1000;
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
@@ -0,0 +1,494 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mesos/resources.hpp>
+
+#include <process/defer.hpp>
+#include <process/pid.hpp>
+
+#include <stout/check.hpp>
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
+#include <stout/nothing.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/try.hpp>
+
+#include "linux/cgroups.hpp"
+#include "linux/numa.hpp"
+
+#include "slave/containerizer/isolators/cgroups/cpuset.hpp"
+
+using namespace process;
+
+using std::list;
+using std::map;
+using std::pair;
+using std::set;
+using std::string;
+using std::vector;
+
+using mesos::slave::ExecutorRunState;
+using mesos::slave::Isolator;
+using mesos::slave::IsolatorProcess;
+using mesos::slave::Limitation;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+Try<Isolator*> CgroupsCpusetIsolatorProcess::create(const Flags& flags)
+{
+  Try<string> hierarchy = cgroups::prepare(
+      flags.cgroups_hierarchy,
+      "cpuset",
+      flags.cgroups_root);
+
+  if (hierarchy.isError()) {
+    return Error("Failed to create cpuset cgroup: " + hierarchy.error());
+  }
+
+  Try<map<int, set<int>>> topology = numa::nodes();
+  if (topology.isError()) {
+    return Error("Failed to determine the NUMA topology: " + topology.error());
+  }
+
+  // Only the cores in the cpuset of the root cgroup can be used.
+  Try<set<int>> available =
+    cgroups::cpuset::cpus(hierarchy.get(), flags.cgroups_root);
+
+  if (available.isError()) {
+    return Error(
+        "Failed to read the cpus of cgroup '" + flags.cgroups_root +
+        "': " + available.error());
+  }
+
+  map<int, set<int>> nodes;
+  foreachpair (int node, const set<int>& cpus, topology.get()) {
+    foreach (int cpu, cpus) {
+      if (available.get().count(cpu) > 0) {
+        nodes[node].insert(cpu);
+      }
+    }
+  }
+
+  if (nodes.empty()) {
+    return Error("No cpus available in cgroup '" + flags.cgroups_root + "'");
+  }
+
+  foreachpair (int node, const set<int>& cpus, nodes) {
+    LOG(INFO) << "Using cpus " << numa::format(cpus)
+              << " of NUMA node " << node;
+  }
+
+  process::Owned<IsolatorProcess> process(
+      new CgroupsCpusetIsolatorProcess(flags, hierarchy.get(), nodes));
+
+  return new Isolator(process);
+}
+
+
+CgroupsCpusetIsolatorProcess::CgroupsCpusetIsolatorProcess(
+    const Flags& _flags,
+    const string& _hierarchy,
+    const map<int, set<int>>& _nodes)
+  : flags(_flags),
+    hierarchy(_hierarchy),
+    nodes(_nodes) {}
+
+
+CgroupsCpusetIsolatorProcess::~CgroupsCpusetIsolatorProcess() {}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::recover(
+    const list<ExecutorRunState>& states,
+    const hashset<ContainerID>& orphans)
+{
+  foreach (const ExecutorRunState& state, states) {
+    const ContainerID& containerId = state.id;
+    const string cgroup = path::join(flags.cgroups_root, containerId.value());
+
+    Try<bool> exists = cgroups::exists(hierarchy, cgroup);
+    if (exists.isError()) {
+      foreachvalue (Info* info, infos) {
+        delete info;
+      }
+
+      infos.clear();
+      used.clear();
+      return Failure("Failed to check cgroup " + cgroup +
+                     " for container '" + stringify(containerId) + "'");
+    }
+
+    if (!exists.get()) {
+      // This may occur if the executor is exiting and the isolator has
+      // destroyed the cgroup but the slave dies before noticing this, or
+      // if this isolator is now enabled for a container that was started
+      // without it. Such a container simply isn't pinned.
+      VLOG(1) << "Couldn't find cpuset cgroup for container " << containerId;
+      continue;
+    }
+
+    Try<set<int>> cpus = cgroups::cpuset::cpus(hierarchy, cgroup);
+    if (cpus.isError()) {
+      foreachvalue (Info* info, infos) {
+        delete info;
+      }
+
+      infos.clear();
+      used.clear();
+      return Failure("Failed to read the cpus of cgroup " + cgroup +
+                     " for container '" + stringify(containerId) + "': " +
+                     cpus.error());
+    }
+
+    Info* info = new Info(containerId, cgroup);
+    info->cpus = cpus.get();
+
+    foreach (int cpu, info->cpus) {
+      used[cpu]++;
+    }
+
+    infos[containerId] = info;
+  }
+
+  // Remove orphan cgroups.
+  Try<vector<string>> cgroups = cgroups::get(hierarchy, flags.cgroups_root);
+  if (cgroups.isError()) {
+    foreachvalue (Info* info, infos) {
+      delete info;
+    }
+
+    infos.clear();
+    used.clear();
+    return Failure(cgroups.error());
+  }
+
+  foreach (const string& cgroup, cgroups.get()) {
+    // Ignore the slave cgroup (see the --slave_subsystems flag).
+    // TODO(idownes): Remove this when the cgroups layout is updated,
+    // see MESOS-1185.
+    if (cgroup == path::join(flags.cgroups_root, "slave")) {
+      continue;
+    }
+
+    ContainerID containerId;
+    containerId.set_value(os::basename(cgroup).get());
+
+    if (infos.contains(containerId)) {
+      continue;
+    }
+
+    // Known orphan cgroups will be destroyed by the containerizer
+    // using the normal cleanup path. See details in MESOS-2367.
+    if (orphans.contains(containerId)) {
+      infos[containerId] = new Info(containerId, cgroup);
+      continue;
+    }
+
+    LOG(INFO) << "Removing unknown orphaned cgroup '" << cgroup << "'";
+
+    // We don't wait on the destroy as we don't want to block recovery.
+    cgroups::destroy(hierarchy, cgroup, cgroups::DESTROY_TIMEOUT);
+  }
+
+  return Nothing();
+}
+
+
+Future<Option<CommandInfo>> CgroupsCpusetIsolatorProcess::prepare(
+    const ContainerID& containerId,
+    const ExecutorInfo& executorInfo,
+    const string& directory,
+    const Option<string>& rootfs,
+    const Option<string>& user)
+{
+  if (infos.contains(containerId)) {
+    return Failure("Container has already been prepared");
+  }
+
+  Info* info = new Info(
+      containerId,
+      path::join(flags.cgroups_root, containerId.value()));
+
+  infos[containerId] = CHECK_NOTNULL(info);
+
+  // Create a cgroup for this container.
+  Try<bool> exists = cgroups::exists(hierarchy, info->cgroup);
+
+  if (exists.isError()) {
+    return Failure("Failed to prepare isolator: " + exists.error());
+  } else if (exists.get()) {
+    return Failure("Failed to prepare isolator: cgroup already exists");
+  }
+
+  Try<Nothing> create = cgroups::create(hierarchy, info->cgroup);
+  if (create.isError()) {
+    return Failure("Failed to prepare isolator: " + create.error());
+  }
+
+  // Migrate the pages of the container to its new memory nodes when
+  // they change upon 'update'.
+  Try<Nothing> write =
+    cgroups::write(hierarchy, info->cgroup, "cpuset.memory_migrate", "1");
+
+  if (write.isError()) {
+    return Failure(
+        "Failed to update 'cpuset.memory_migrate': " + write.error());
+  }
+
+  // Chown the cgroup so the executor can create nested cgroups. Do
+  // not recurse so the control files are still owned by the slave
+  // user and thus cannot be changed by the executor.
+  if (user.isSome()) {
+    Try<Nothing> chown = os::chown(
+        user.get(),
+        path::join(hierarchy, info->cgroup),
+        false);
+
+    if (chown.isError()) {
+      return Failure("Failed to prepare isolator: " + chown.error());
+    }
+  }
+
+  return update(containerId, executorInfo.resources())
+    .then([]() -> Future<Option<CommandInfo>> {
+      return None();
+    });
+}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::isolate(
+    const ContainerID& containerId,
+    pid_t pid)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  Try<Nothing> assign = cgroups::assign(hierarchy, info->cgroup, pid);
+  if (assign.isError()) {
+    return Failure("Failed to assign container '" +
+                   stringify(info->containerId) + "' to its own cgroup '" +
+                   path::join(hierarchy, info->cgroup) +
+                   "' : " + assign.error());
+  }
+
+  return Nothing();
+}
+
+
+Future<Limitation> CgroupsCpusetIsolatorProcess::watch(
+    const ContainerID& containerId)
+{
+  // No resources are limited.
+  return Future<Limitation>();
+}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::update(
+    const ContainerID& containerId,
+    const Resources& resources)
+{
+  if (resources.cpus().isNone()) {
+    return Failure("No cpus resource given");
+  }
+
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  size_t count = std::max(
+      static_cast<size_t>(std::ceil(resources.cpus().get())),
+      static_cast<size_t>(1));
+
+  // No need to move the container if the number of cores is the same.
+  if (count == info->cpus.size()) {
+    return Nothing();
+  }
+
+  release(info->cpus);
+  info->cpus.clear();
+
+  set<int> cpus = allocate(count);
+
+  // NOTE: We update 'info->cpus' before writing the controls so that
+  // the cores are released upon cleanup even if the writes fail.
+  info->cpus = cpus;
+
+  Try<Nothing> write = cgroups::cpuset::cpus(hierarchy, info->cgroup, cpus);
+  if (write.isError()) {
+    return Failure("Failed to update 'cpuset.cpus': " + write.error());
+  }
+
+  write = cgroups::cpuset::mems(hierarchy, info->cgroup, mems(cpus));
+  if (write.isError()) {
+    return Failure("Failed to update 'cpuset.mems': " + write.error());
+  }
+
+  LOG(INFO) << "Updated 'cpuset.cpus' to " << numa::format(cpus)
+            << " and 'cpuset.mems' to " << numa::format(mems(cpus))
+            << " (cpus " << resources.cpus().get() << ")"
+            << " for container " << containerId;
+
+  return Nothing();
+}
+
+
+Future<ResourceStatistics> CgroupsCpusetIsolatorProcess::usage(
+    const ContainerID& containerId)
+{
+  // No statistics are collected.
+  return ResourceStatistics();
+}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::cleanup(
+    const ContainerID& containerId)
+{
+  // Multiple calls may occur during test clean up.
+  if (!infos.contains(containerId)) {
+    VLOG(1) << "Ignoring cleanup request for unknown container: "
+            << containerId;
+
+    return Nothing();
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  return cgroups::destroy(hierarchy, info->cgroup, cgroups::DESTROY_TIMEOUT)
+    .then(defer(PID<CgroupsCpusetIsolatorProcess>(this),
+                &CgroupsCpusetIsolatorProcess::_cleanup,
+                containerId));
+}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::_cleanup(
+    const ContainerID& containerId)
+{
+  if (!infos.contains(containerId)) {
+    return Nothing();
+  }
+
+  release(infos[containerId]->cpus);
+
+  delete infos[containerId];
+  infos.erase(containerId);
+
+  return Nothing();
+}
+
+
+set<int> CgroupsCpusetIsolatorProcess::allocate(size_t count)
+{
+  // Returns the cores sorted by the number of containers using them
+  // (and by id to keep the cores of a container close together).
+  auto sorted = [this](const set<int>& cpus) {
+    vector<pair<size_t, int>> result;
+    foreach (int cpu, cpus) {
+      result.push_back(std::make_pair(used.get(cpu).get(0), cpu));
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+
+  // Pick the node whose 'count' least used cores are used the least.
+  Option<pair<size_t, int>> best; // Cost and node.
+  foreachpair (int node, const set<int>& cpus, nodes) {
+    if (cpus.size() < count) {
+      continue;
+    }
+
+    size_t cost = 0;
+    vector<pair<size_t, int>> candidates = sorted(cpus);
+    for (size_t i = 0; i < count; i++) {
+      cost += candidates[i].first;
+    }
+
+    if (best.isNone() || cost < best.get().first) {
+      best = std::make_pair(cost, node);
+    }
+  }
+
+  vector<pair<size_t, int>> candidates;
+  if (best.isSome()) {
+    candidates = sorted(nodes.at(best.get().second));
+  } else {
+    // The container needs more cores than any node has, span all.
+    set<int> all;
+    foreachvalue (const set<int>& cpus, nodes) {
+      all.insert(cpus.begin(), cpus.end());
+    }
+    candidates = sorted(all);
+  }
+
+  set<int> result;
+  for (size_t i = 0; i < std::min(count, candidates.size()); i++) {
+    result.insert(candidates[i].second);
+    used[candidates[i].second]++;
+  }
+
+  return result;
+}
+
+
+void CgroupsCpusetIsolatorProcess::release(const set<int>& cpus)
+{
+  foreach (int cpu, cpus) {
+    if (used.contains(cpu) && --used[cpu] == 0) {
+      used.erase(cpu);
+    }
+  }
+}
+
+
+set<int> CgroupsCpusetIsolatorProcess::mems(const set<int>& cpus) const
+{
+  set<int> result;
+  foreachpair (int node, const set<int>& _cpus, nodes) {
+    foreach (int cpu, cpus) {
+      if (_cpus.count(cpu) > 0) {
+        result.insert(node);
+        break;
+      }
+    }
+  }
+
+  return result;
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,128 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CPUSET_ISOLATOR_HPP__
+#define __CPUSET_ISOLATOR_HPP__
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+
+#include <mesos/slave/isolator.hpp>
+
+#include <stout/hashmap.hpp>
+
+#include "slave/flags.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Pins each container to ceil(cpus) cores using the cpuset subsystem
+// and restricts its memory to the NUMA nodes of those cores so that
+// memory bandwidth bound tasks don't pay for remote memory accesses.
+// The cores of a container are picked from a single node if possible,
+// preferring the cores used by the least number of containers: a core
+// is only shared between containers once all the cores of the chosen
+// node(s) are in use, e.g., with fractional cpus.
+class CgroupsCpusetIsolatorProcess : public mesos::slave::IsolatorProcess
+{
+public:
+  static Try<mesos::slave::Isolator*> create(const Flags& flags);
+
+  virtual ~CgroupsCpusetIsolatorProcess();
+
+  virtual process::Future<Nothing> recover(
+      const std::list<mesos::slave::ExecutorRunState>& states,
+      const hashset<ContainerID>& orphans);
+
+  virtual process::Future<Option<CommandInfo>> prepare(
+      const ContainerID& containerId,
+      const ExecutorInfo& executorInfo,
+      const std::string& directory,
+      const Option<std::string>& rootfs,
+      const Option<std::string>& user);
+
+  virtual process::Future<Nothing> isolate(
+      const ContainerID& containerId,
+      pid_t pid);
+
+  virtual process::Future<mesos::slave::Limitation> watch(
+      const ContainerID& containerId);
+
+  virtual process::Future<Nothing> update(
+      const ContainerID& containerId,
+      const Resources& resources);
+
+  virtual process::Future<ResourceStatistics> usage(
+      const ContainerID& containerId);
+
+  virtual process::Future<Nothing> cleanup(
+      const ContainerID& containerId);
+
+private:
+  CgroupsCpusetIsolatorProcess(
+      const Flags& flags,
+      const std::string& hierarchy,
+      const std::map<int, std::set<int>>& nodes);
+
+  // Picks 'count' cores for a container (see above) and marks them
+  // as used by the container.
+  std::set<int> allocate(size_t count);
+
+  // Marks the cores as no longer used by a container.
+  void release(const std::set<int>& cpus);
+
+  // Returns the NUMA nodes of the cores.
+  std::set<int> mems(const std::set<int>& cpus) const;
+
+  process::Future<Nothing> _cleanup(const ContainerID& containerId);
+
+  struct Info
+  {
+    Info(const ContainerID& _containerId, const std::string& _cgroup)
+      : containerId(_containerId), cgroup(_cgroup) {}
+
+    const ContainerID containerId;
+    const std::string cgroup;
+
+    // The cores the container is pinned to.
+    std::set<int> cpus;
+  };
+
+  const Flags flags;
+
+  // The path to the cgroups subsystem hierarchy root.
+  const std::string hierarchy;
+
+  // The cores of each NUMA node that can be allocated to containers,
+  // i.e., those that are part of the cpuset of --cgroups_root.
+  const std::map<int, std::set<int>> nodes;
+
+  // The number of containers pinned to each core.
+  hashmap<int, size_t> used;
+
+  hashmap<ContainerID, Info*> infos;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __CPUSET_ISOLATOR_HPP__
@@ -24,6 +24,7 @@
 #include <mesos/type_utils.hpp>
 #include <mesos/values.hpp>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/pid.hpp>
@@ -446,6 +447,39 @@ Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::usage(
 
   Info* info = CHECK_NOTNULL(infos[containerId]);
 
+  if (flags.cgroups_usage_interval == Duration::zero()) {
+    return sample(containerId);
+  }
+
+  // Serve the statistics collected within the interval, or still
+  // being collected, to all callers (i.e., the resource monitor and
+  // any number of HTTP endpoint requests).
+  if (info->usage.isSome() &&
+      (info->usage.get().isPending() ||
+       (info->usage.get().isReady() &&
+        Clock::now() - info->usageTime < flags.cgroups_usage_interval))) {
+    return info->usage.get();
+  }
+
+  const Time time = Clock::now();
+
+  info->usageTime = time;
+  info->usage = sample(containerId)
+    .then([time](ResourceStatistics result) {
+      // Let consumers compute rates from the time of the reading.
+      result.set_timestamp(time.secs());
+      return result;
+    });
+
+  return info->usage.get();
+}
+
+
+Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::sample(
+    const ContainerID& containerId)
+{
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
   ResourceStatistics result;
 
   // TODO(chzhcn): Getting the number of processes and threads is
@@ -23,6 +23,9 @@
 
 #include <mesos/slave/isolator.hpp>
 
+#include <process/future.hpp>
+#include <process/time.hpp>
+
 #include <stout/hashmap.hpp>
 
 #include "slave/flags.hpp"
@@ -78,6 +81,10 @@ private:
       const hashmap<std::string, std::string>& hierarchies,
       const std::vector<std::string>& subsystems);
 
+  // Reads the statistics of the container from its cgroups. Called by
+  // usage() at most once per --cgroups_usage_interval.
+  process::Future<ResourceStatistics> sample(const ContainerID& containerId);
+
   virtual process::Future<std::list<Nothing>> _cleanup(
       const ContainerID& containerId,
       const process::Future<std::list<Nothing>>& future);
@@ -93,6 +100,10 @@ private:
     Option<Resources> resources;
 
     process::Promise<mesos::slave::Limitation> limitation;
+
+    // The last statistics collected for usage() and when.
+    Option<process::Future<ResourceStatistics>> usage;
+    process::Time usageTime;
   };
 
   const Flags flags;
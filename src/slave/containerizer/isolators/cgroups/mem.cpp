@@ -25,6 +25,7 @@
 #include <mesos/type_utils.hpp>
 #include <mesos/values.hpp>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/pid.hpp>
@@ -419,6 +420,39 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
 
   Info* info = CHECK_NOTNULL(infos[containerId]);
 
+  if (flags.cgroups_usage_interval == Duration::zero()) {
+    return sample(containerId);
+  }
+
+  // Serve the statistics collected within the interval, or still
+  // being collected, to all callers (i.e., the resource monitor and
+  // any number of HTTP endpoint requests).
+  if (info->usage.isSome() &&
+      (info->usage.get().isPending() ||
+       (info->usage.get().isReady() &&
+        Clock::now() - info->usageTime < flags.cgroups_usage_interval))) {
+    return info->usage.get();
+  }
+
+  const Time time = Clock::now();
+
+  info->usageTime = time;
+  info->usage = sample(containerId)
+    .then([time](ResourceStatistics result) {
+      // Let consumers compute rates from the time of the reading.
+      result.set_timestamp(time.secs());
+      return result;
+    });
+
+  return info->usage.get();
+}
+
+
+Future<ResourceStatistics> CgroupsMemIsolatorProcess::sample(
+    const ContainerID& containerId)
+{
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
   ResourceStatistics result;
 
   // The rss from memory.stat is wrong in two dimensions:
@@ -528,6 +562,10 @@ Future<Nothing> CgroupsMemIsolatorProcess::cleanup(
     info->oomNotifier.discard();
   }
 
+  foreachvalue (Future<uint64_t> notifier, info->pressureNotifiers) {
+    notifier.discard();
+  }
+
   return cgroups::destroy(hierarchy, info->cgroup, cgroups::DESTROY_TIMEOUT)
     .onAny(defer(PID<CgroupsMemIsolatorProcess>(this),
                  &CgroupsMemIsolatorProcess::_cleanup,
@@ -615,15 +653,23 @@ void CgroupsMemIsolatorProcess::oom(const ContainerID& containerId)
     return;
   }
 
-  Info* info = CHECK_NOTNULL(infos[containerId]);
-
   LOG(INFO) << "OOM detected for container " << containerId;
 
+  limit(containerId, "Memory limit exceeded: ");
+}
+
+
+void CgroupsMemIsolatorProcess::limit(
+    const ContainerID& containerId,
+    const string& reason)
+{
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
   // Construct a "message" string to describe why the isolator
   // destroyed the executor's cgroup (in order to assist in
   // debugging).
   ostringstream message;
-  message << "Memory limit exceeded: ";
+  message << reason;
 
   // Output the requested memory limit.
   // NOTE: If limitSwap is (has been) used then both limit_in_bytes
@@ -695,6 +741,101 @@ void CgroupsMemIsolatorProcess::pressureListen(
                 << "events for container " << containerId;
     }
   }
+
+  if (flags.cgroups_memory_pressure_reaction) {
+    pressureReact(containerId, Level::MEDIUM);
+    pressureReact(containerId, Level::CRITICAL);
+  }
+}
+
+
+void CgroupsMemIsolatorProcess::pressureReact(
+    const ContainerID& containerId,
+    Level level)
+{
+  CHECK(infos.contains(containerId));
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  Future<uint64_t> notifier = cgroups::event::listen(
+      hierarchy,
+      info->cgroup,
+      "memory.pressure_level",
+      stringify(level));
+
+  info->pressureNotifiers[level] = notifier;
+
+  notifier.onAny(defer(
+      PID<CgroupsMemIsolatorProcess>(this),
+      &CgroupsMemIsolatorProcess::pressured,
+      containerId,
+      level,
+      lambda::_1));
+}
+
+
+void CgroupsMemIsolatorProcess::pressured(
+    const ContainerID& containerId,
+    Level level,
+    const Future<uint64_t>& future)
+{
+  if (!infos.contains(containerId)) {
+    return;
+  }
+
+  if (future.isDiscarded()) {
+    LOG(INFO) << "Discarded " << level << " memory pressure notifier for "
+              << "container " << containerId;
+    return;
+  } else if (future.isFailed()) {
+    LOG(ERROR) << "Listening on " << level << " memory pressure events "
+               << "failed for container " << containerId << ": "
+               << future.failure();
+    return;
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  if (level == Level::CRITICAL) {
+    // The kernel is barely able to reclaim memory from the container,
+    // which is about to be killed by the OOM killer (possibly after a
+    // long stall). Report the limitation right away instead.
+    LOG(INFO) << "Critical memory pressure for container " << containerId;
+
+    limit(containerId, "Critical memory pressure: ");
+    return;
+  }
+
+  // Lower the soft limit to the anonymous memory of the container so
+  // that its page cache is reclaimed before the memory of others.
+  // The soft limit is reset upon the next 'update'.
+  Try<hashmap<string, uint64_t>> stat =
+    cgroups::stat(hierarchy, info->cgroup, "memory.stat");
+
+  if (stat.isError()) {
+    LOG(ERROR) << "Failed to read 'memory.stat' for container "
+               << containerId << ": " << stat.error();
+  } else if (stat.get().contains("total_rss")) {
+    Bytes anonymous(stat.get().get("total_rss").get());
+
+    Try<Bytes> current =
+      cgroups::memory::soft_limit_in_bytes(hierarchy, info->cgroup);
+
+    if (current.isSome() && anonymous < current.get()) {
+      Try<Nothing> write = cgroups::memory::soft_limit_in_bytes(
+          hierarchy, info->cgroup, anonymous);
+
+      if (write.isError()) {
+        LOG(ERROR) << "Failed to set 'memory.soft_limit_in_bytes' for "
+                   << "container " << containerId << ": " << write.error();
+      } else {
+        LOG(INFO) << "Lowered 'memory.soft_limit_in_bytes' to " << anonymous
+                  << " upon " << level << " memory pressure for container "
+                  << containerId;
+      }
+    }
+  }
+
+  pressureReact(containerId, level);
 }
 
 } // namespace slave {
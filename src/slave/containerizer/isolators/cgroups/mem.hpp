@@ -23,6 +23,9 @@
 
 #include <mesos/slave/isolator.hpp>
 
+#include <process/future.hpp>
+#include <process/time.hpp>
+
 #include <process/owned.hpp>
 
 #include <stout/hashmap.hpp>
@@ -78,6 +81,10 @@ private:
       const std::string& hierarchy,
       bool limitSwap);
 
+  // Reads the statistics of the container from its cgroups. Called by
+  // usage() at most once per --cgroups_usage_interval.
+  process::Future<ResourceStatistics> sample(const ContainerID& containerId);
+
   process::Future<ResourceStatistics> _usage(
       const ContainerID& containerId,
       ResourceStatistics result,
@@ -99,12 +106,21 @@ private:
 
     process::Promise<mesos::slave::Limitation> limitation;
 
+    // The last statistics collected for usage() and when.
+    Option<process::Future<ResourceStatistics>> usage;
+    process::Time usageTime;
+
     // Used to cancel the OOM listening.
     process::Future<Nothing> oomNotifier;
 
     hashmap<cgroups::memory::pressure::Level,
             process::Owned<cgroups::memory::pressure::Counter>>
       pressureCounters;
+
+    // Used to cancel the memory pressure listening when reacting to
+    // memory pressure (see --cgroups_memory_pressure_reaction).
+    hashmap<cgroups::memory::pressure::Level, process::Future<uint64_t>>
+      pressureNotifiers;
   };
 
   // Start listening on OOM events. This function will create an
@@ -120,9 +136,26 @@ private:
   // This function is invoked when the OOM event happens.
   void oom(const ContainerID& containerId);
 
+  // Reports that the container exceeded its memory limit, describing
+  // its memory usage after 'reason'.
+  void limit(const ContainerID& containerId, const std::string& reason);
+
   // Start listening on memory pressure events.
   void pressureListen(const ContainerID& containerId);
 
+  // Start listening on memory pressure events of the given level in
+  // order to react to them (see --cgroups_memory_pressure_reaction).
+  void pressureReact(
+      const ContainerID& containerId,
+      cgroups::memory::pressure::Level level);
+
+  // This function is invoked when the memory pressure event of the
+  // given level happens (or the listening fails).
+  void pressured(
+      const ContainerID& containerId,
+      cgroups::memory::pressure::Level level,
+      const process::Future<uint64_t>& future);
+
   const Flags flags;
 
   // The path to the cgroups subsystem hierarchy root.
@@ -92,7 +92,12 @@ Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
     events.insert(event);
   }
 
-  if (!perf::valid(events)) {
+  if (flags.perf_counters) {
+    if (!perf::countable(events)) {
+      return Error("Failed to create PerfEvent isolator, events cannot be "
+                   "counted with --perf_counters: " + stringify(events));
+    }
+  } else if (!perf::valid(events)) {
     return Error("Failed to create PerfEvent isolator, invalid events: " +
                  stringify(events));
   }
@@ -106,9 +111,14 @@ Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
     return Error("Failed to create perf_event cgroup: " + hierarchy.error());
   }
 
-  LOG(INFO) << "PerfEvent isolator will profile for " << flags.perf_duration
-            << " every " << flags.perf_interval
-            << " for events: " << stringify(events);
+  if (flags.perf_counters) {
+    LOG(INFO) << "PerfEvent isolator will count events every "
+              << flags.perf_interval << ": " << stringify(events);
+  } else {
+    LOG(INFO) << "PerfEvent isolator will profile for " << flags.perf_duration
+              << " every " << flags.perf_interval
+              << " for events: " << stringify(events);
+  }
 
   process::Owned<IsolatorProcess> process(
       new CgroupsPerfEventIsolatorProcess(flags, hierarchy.get()));
@@ -177,6 +187,8 @@ Future<Nothing> CgroupsPerfEventIsolatorProcess::recover(
     }
 
     infos[containerId] = new Info(containerId, cgroup);
+
+    open(containerId);
   }
 
   // Remove orphan cgroups.
@@ -271,10 +283,36 @@ Future<Option<CommandInfo>> CgroupsPerfEventIsolatorProcess::prepare(
     }
   }
 
+  open(containerId);
+
   return None();
 }
 
 
+void CgroupsPerfEventIsolatorProcess::open(const ContainerID& containerId)
+{
+  if (!flags.perf_counters) {
+    return;
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  // Counting for a container only fails for reasons like running out
+  // of file descriptors, which should not fail its launch. Its perf
+  // statistics will just not be available.
+  Try<Owned<perf::Counters>> counters =
+    perf::Counters::open(events, path::join(hierarchy, info->cgroup));
+
+  if (counters.isError()) {
+    LOG(ERROR) << "Failed to open perf counters for container "
+               << containerId << ": " << counters.error();
+    return;
+  }
+
+  info->counters = counters.get();
+}
+
+
 Future<Nothing> CgroupsPerfEventIsolatorProcess::isolate(
     const ContainerID& containerId,
     pid_t pid)
@@ -347,6 +385,9 @@ Future<Nothing> CgroupsPerfEventIsolatorProcess::cleanup(
 
   info->destroying = true;
 
+  // Close the counters, which reference the cgroup.
+  info->counters.reset();
+
   return cgroups::destroy(hierarchy, info->cgroup)
     .then(defer(PID<CgroupsPerfEventIsolatorProcess>(this),
                 &CgroupsPerfEventIsolatorProcess::_cleanup,
@@ -385,6 +426,30 @@ Future<hashmap<string, PerfStatistics>> discardSample(
 
 void CgroupsPerfEventIsolatorProcess::sample()
 {
+  if (flags.perf_counters) {
+    foreachvalue (Info* info, infos) {
+      CHECK_NOTNULL(info);
+
+      if (info->destroying || info->counters.get() == NULL) {
+        continue;
+      }
+
+      Try<PerfStatistics> statistics = info->counters->read();
+      if (statistics.isError()) {
+        LOG(ERROR) << "Failed to read perf counters for container "
+                   << info->containerId << ": " << statistics.error();
+        continue;
+      }
+
+      info->statistics = statistics.get();
+    }
+
+    delay(flags.perf_interval,
+          PID<CgroupsPerfEventIsolatorProcess>(this),
+          &CgroupsPerfEventIsolatorProcess::sample);
+    return;
+  }
+
   set<string> cgroups;
   foreachvalue (Info* info, infos) {
     CHECK_NOTNULL(info);
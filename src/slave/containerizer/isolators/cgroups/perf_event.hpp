@@ -23,6 +23,7 @@
 
 #include <mesos/slave/isolator.hpp>
 
+#include <process/owned.hpp>
 #include <process/time.hpp>
 
 #include <stout/hashmap.hpp>
@@ -80,6 +81,9 @@ private:
 
   void sample();
 
+  // Opens the counters of the container with --perf_counters.
+  void open(const ContainerID& containerId);
+
   void _sample(
       const process::Time& next,
       const process::Future<hashmap<std::string, PerfStatistics>>& statistics);
@@ -102,6 +106,8 @@ private:
     const ContainerID containerId;
     const std::string cgroup;
     PerfStatistics statistics;
+    // The counters of the cgroup with --perf_counters.
+    process::Owned<perf::Counters> counters;
     // Mark a container when we start destruction so we stop sampling it.
     bool destroying;
   };
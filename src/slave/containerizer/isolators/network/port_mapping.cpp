@@ -20,6 +20,7 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -27,6 +28,7 @@
 
 #include <mesos/mesos.hpp>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/io.hpp>
@@ -135,6 +137,7 @@ static const uint8_t DEFAULT_FILTER_PRIORITY = 4;
 
 
 // The secondary priorities used by filters.
+static const uint8_t HIGHEST = 0;
 static const uint8_t HIGH = 1;
 static const uint8_t NORMAL = 2;
 static const uint8_t LOW = 3;
@@ -150,6 +153,11 @@ static const uint16_t ICMP_FLOWID = 2;
 static const uint16_t CONTAINER_MIN_FLOWID = 3;
 
 
+// The name of the scalar resource (in Mbits/s) that determines the
+// limit of the egress and ingress traffic of a container.
+static const char NETWORK_BANDWIDTH[] = "network_bandwidth";
+
+
 // The well known ports. Used for sanity check.
 static Interval<uint16_t> WELL_KNOWN_PORTS()
 {
@@ -315,6 +323,20 @@ static IntervalSet<uint16_t> getIntervalSet(const Value::Ranges& ranges)
   return set;
 }
 
+// Returns the rate limit (in Bytes/s) specified by the
+// 'network_bandwidth' resource (in Mbits/s), if any.
+static Option<Bytes> getRateLimit(const Resources& resources)
+{
+  Option<Value::Scalar> bandwidth =
+    resources.get<Value::Scalar>(NETWORK_BANDWIDTH);
+
+  if (bandwidth.isNone() || bandwidth.get().value() <= 0) {
+    return None();
+  }
+
+  return Bytes(static_cast<uint64_t>(bandwidth.get().value() * 1000000 / 8));
+}
+
 /////////////////////////////////////////////////
 // Implementation for PortMappingUpdate.
 /////////////////////////////////////////////////
@@ -1946,6 +1968,18 @@ Future<Option<CommandInfo>> PortMappingIsolatorProcess::prepare(
             << " for container " << containerId << " of executor "
             << executorInfo.executor_id();
 
+  // The 'network_bandwidth' resource of the container (if any) takes
+  // precedence over the per container egress rate limit flag.
+  Option<Bytes> rateLimit = getRateLimit(resources);
+  if (rateLimit.isSome()) {
+    LOG(INFO) << "Limiting the network traffic of container "
+              << containerId << " to " << rateLimit.get() << "/s";
+
+    infos[containerId]->rateLimit = rateLimit;
+  } else {
+    infos[containerId]->rateLimit = egressRateLimitPerContainer;
+  }
+
   CommandInfo command;
   command.set_value(scripts(infos[containerId]));
 
@@ -2395,6 +2429,15 @@ Future<Nothing> PortMappingIsolatorProcess::update(
     }
   }
 
+  // NOTE: The rate limit is set up by the script (see 'scripts')
+  // inside the network namespace of the container when it's prepared
+  // and is not changed afterwards.
+  Option<Bytes> rateLimit = getRateLimit(resources);
+  if (rateLimit.isSome() && rateLimit != info->rateLimit) {
+    LOG(WARNING) << "Ignoring the updated " << NETWORK_BANDWIDTH
+                 << " for container " << containerId;
+  }
+
   // No need to proceed if no change to the non-ephemeral ports.
   if (nonEphemeralPorts == info->nonEphemeralPorts) {
     return Nothing();
@@ -2608,9 +2651,35 @@ Future<ResourceStatistics> PortMappingIsolatorProcess::usage(
     return result;
   }
 
+  // Retrieving the socket statistics forks a helper, so we share a
+  // retrieval between concurrent requests and reuse its result for
+  // '--network_socket_statistics_interval'. A failed retrieval is
+  // never reused.
+  if (info->socketStatistics.isNone() ||
+      info->socketStatistics.get().isFailed() ||
+      info->socketStatistics.get().isDiscarded() ||
+      (info->socketStatistics.get().isReady() &&
+       Clock::now() - info->socketStatisticsTime >=
+         flags.network_socket_statistics_interval)) {
+    info->socketStatistics = socketStatistics(info->pid.get());
+    info->socketStatisticsTime = Clock::now();
+  }
+
+  return info->socketStatistics.get()
+    .then([result](const ResourceStatistics& statistics) {
+      ResourceStatistics usage = result;
+      usage.MergeFrom(statistics);
+      return usage;
+    });
+}
+
+
+Future<ResourceStatistics> PortMappingIsolatorProcess::socketStatistics(
+    pid_t pid)
+{
   // Retrieve the socket information from inside the container.
   PortMappingStatistics statistics;
-  statistics.flags.pid = info->pid.get();
+  statistics.flags.pid = pid;
   statistics.flags.enable_socket_statistics_summary =
     flags.network_enable_socket_statistics_summary;
   statistics.flags.enable_socket_statistics_details =
@@ -2642,7 +2711,7 @@ Future<ResourceStatistics> PortMappingIsolatorProcess::usage(
     .then(defer(
         PID<PortMappingIsolatorProcess>(this),
         &PortMappingIsolatorProcess::_usage,
-        result,
+        ResourceStatistics(),
         s.get()));
 }
 
@@ -3461,7 +3530,7 @@ string PortMappingIsolatorProcess::scripts(Info* info)
   script << "tc filter show dev " << eth0 << " parent ffff:\n";
   script << "tc filter show dev " << lo << " parent ffff:\n";
 
-  // If throughput limit for container egress traffic exists, use HTB
+  // If throughput limit for container traffic exists, use HTB
   // qdisc to achieve traffic shaping.
   // TBF has some known issues with GSO packets.
   // https://git.kernel.org/cgit/linux/kernel/git/davem/net.git/:
@@ -3469,10 +3538,10 @@ string PortMappingIsolatorProcess::scripts(Info* info)
   // Additionally, HTB has a simpler interface for just capping the
   // throughput. TBF requires other parameters such as 'burst' that
   // HTB already has default values for.
-  if (egressRateLimitPerContainer.isSome()) {
+  if (info->rateLimit.isSome()) {
     script << "tc qdisc add dev " << eth0 << " root handle 1: htb default 1\n";
     script << "tc class add dev " << eth0 << " parent 1: classid 1:1 htb rate "
-           << egressRateLimitPerContainer.get().bytes() * 8 << "bit\n";
+           << info->rateLimit.get().bytes() * 8 << "bit\n";
 
     // Packets are buffered at the leaf qdisc if we send them faster
     // than the HTB rate limit and may be dropped when the queue is
@@ -3485,6 +3554,22 @@ string PortMappingIsolatorProcess::scripts(Info* info)
     // Display the htb qdisc and class created on eth0.
     script << "tc qdisc show dev " << eth0 << "\n";
     script << "tc class show dev " << eth0 << "\n";
+
+    // Police the ingress traffic of the container with the same
+    // limit. Packets exceeding the limit are dropped (and eventually
+    // retransmitted at a lower rate by TCP), conforming packets
+    // continue to be classified by the filters set up above. We
+    // allow a burst of 100ms worth of traffic.
+    script << "tc filter add dev " << eth0 << " parent ffff: protocol ip"
+           << " prio " << Priority(IP_FILTER_PRIORITY, HIGHEST).get() << " u32"
+           << " flowid ffff:0"
+           << " match u32 0 0"
+           << " action police rate " << info->rateLimit.get().bytes() * 8
+           << "bit burst " << std::max(info->rateLimit.get().bytes() / 10,
+                                       (uint64_t) hostEth0MTU)
+           << " conform-exceed drop/continue\n";
+
+    script << "tc filter show dev " << eth0 << " parent ffff:\n";
   }
 
   return script.str();
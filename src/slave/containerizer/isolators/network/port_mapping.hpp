@@ -29,8 +29,10 @@
 
 #include <mesos/slave/isolator.hpp>
 
+#include <process/future.hpp>
 #include <process/owned.hpp>
 #include <process/subprocess.hpp>
+#include <process/time.hpp>
 
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/counter.hpp>
@@ -208,6 +210,18 @@ private:
 
     Option<pid_t> pid;
     Option<uint16_t> flowId;
+
+    // The limit of the egress and ingress traffic of the container,
+    // in Bytes/s, derived from its 'network_bandwidth' resource (or
+    // the 'egress_rate_limit_per_container' flag). Only known for
+    // containers prepared by this isolator.
+    Option<Bytes> rateLimit;
+
+    // The latest (possibly still pending) retrieval of the socket
+    // statistics of the container and when it was started, see
+    // 'usage'.
+    Option<process::Future<ResourceStatistics>> socketStatistics;
+    process::Time socketStatisticsTime;
   };
 
   // Define the metrics used by the port mapping network isolator.
@@ -287,6 +301,10 @@ private:
       const ContainerID& containerId,
       const process::Future<Option<int>>& status);
 
+  // Retrieves the socket statistics from within the network
+  // namespace of the container using the helper subcommand.
+  process::Future<ResourceStatistics> socketStatistics(pid_t pid);
+
   process::Future<ResourceStatistics> _usage(
       const ResourceStatistics& result,
       const process::Subprocess& s);
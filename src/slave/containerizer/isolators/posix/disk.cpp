@@ -28,6 +28,7 @@
 
 #include <glog/logging.h>
 
+#include <process/async.hpp>
 #include <process/check.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
@@ -44,6 +45,10 @@
 #include <stout/os/exists.hpp>
 #include <stout/os/killtree.hpp>
 
+#ifdef __linux__
+#include "linux/xfs.hpp"
+#endif
+
 #include "slave/containerizer/isolators/posix/disk.hpp"
 
 using namespace process;
@@ -62,10 +67,36 @@ using mesos::slave::Isolator;
 using mesos::slave::IsolatorProcess;
 using mesos::slave::Limitation;
 
+// The range of XFS project IDs given to sandboxes by the 'xfs' disk
+// usage collector.
+// TODO: Make this configurable for hosts which use project
+// quotas for other purposes as well.
+static const uint32_t FIRST_PROJECT_ID = 5000;
+static const uint32_t LAST_PROJECT_ID = 1000000;
+
+
 Try<Isolator*> PosixDiskIsolatorProcess::create(const Flags& flags)
 {
   // TODO(jieyu): Check the availability of command 'du'.
 
+  if (flags.container_disk_usage_collector == "xfs") {
+#ifdef __linux__
+    Try<bool> xfs = xfs::isXfs(flags.work_dir);
+    if (xfs.isError()) {
+      return Error("Failed to check the filesystem of the work directory: " +
+                   xfs.error());
+    } else if (!xfs.get()) {
+      return Error("The 'xfs' disk usage collector requires the work "
+                   "directory '" + flags.work_dir + "' to be on XFS");
+    }
+#else
+    return Error("The 'xfs' disk usage collector is only supported on Linux");
+#endif
+  } else if (flags.container_disk_usage_collector != "du") {
+    return Error("Unknown disk usage collector '" +
+                 flags.container_disk_usage_collector + "'");
+  }
+
   return new Isolator(
       process::Owned<IsolatorProcess>(new PosixDiskIsolatorProcess(flags)));
 }
@@ -78,7 +109,10 @@ PosixDiskIsolatorProcess::Info::PathInfo::~PathInfo()
 
 
 PosixDiskIsolatorProcess::PosixDiskIsolatorProcess(const Flags& _flags)
-  : flags(_flags), collector(flags.container_disk_watch_interval) {}
+  : flags(_flags),
+    collector(
+        flags.container_disk_watch_interval,
+        flags.container_disk_usage_collector == "xfs") {}
 
 
 PosixDiskIsolatorProcess::~PosixDiskIsolatorProcess() {}
@@ -94,7 +128,22 @@ Future<Nothing> PosixDiskIsolatorProcess::recover(
     CHECK(os::exists(state.directory))
       << "Executor work directory " << state.directory << " doesn't exist";
 
-    infos.put(state.id, Owned<Info>(new Info(state.directory)));
+    Owned<Info> info(new Info(state.directory));
+
+#ifdef __linux__
+    if (flags.container_disk_usage_collector == "xfs") {
+      Result<uint32_t> projectId = xfs::getProjectId(state.directory);
+      if (projectId.isError()) {
+        LOG(WARNING) << "Failed to get the project ID of '"
+                     << state.directory << "': " << projectId.error();
+      } else if (projectId.isSome()) {
+        info->projectId = projectId.get();
+        projectIds.insert(projectId.get());
+      }
+    }
+#endif
+
+    infos.put(state.id, info);
   }
 
   return Nothing();
@@ -112,7 +161,36 @@ Future<Option<CommandInfo>> PosixDiskIsolatorProcess::prepare(
     return Failure("Container has already been prepared");
   }
 
-  infos.put(containerId, Owned<Info>(new Info(directory)));
+  Owned<Info> info(new Info(directory));
+
+#ifdef __linux__
+  if (flags.container_disk_usage_collector == "xfs") {
+    Option<uint32_t> projectId;
+    for (uint32_t id = FIRST_PROJECT_ID; id <= LAST_PROJECT_ID; id++) {
+      if (!projectIds.contains(id)) {
+        projectId = id;
+        break;
+      }
+    }
+
+    if (projectId.isNone()) {
+      return Failure("No XFS project ID left for the sandbox");
+    }
+
+    // The sandbox is still empty, so all its files will inherit the
+    // project ID.
+    Try<Nothing> set = xfs::setProjectId(directory, projectId.get());
+    if (set.isError()) {
+      return Failure("Failed to set the XFS project ID of the sandbox: " +
+                     set.error());
+    }
+
+    info->projectId = projectId.get();
+    projectIds.insert(projectId.get());
+  }
+#endif
+
+  infos.put(containerId, info);
 
   return None();
 }
@@ -301,16 +379,54 @@ Future<Nothing> PosixDiskIsolatorProcess::cleanup(
     return Nothing();
   }
 
+  const Option<uint32_t> projectId = infos[containerId]->projectId;
+  const string directory = infos[containerId]->directory;
+
   infos.erase(containerId);
 
+#ifdef __linux__
+  // The files in the sandbox stay accounted to the project until the
+  // sandbox is garbage collected, so the project ID can only be given
+  // to another sandbox once they no longer carry it.
+  if (projectId.isSome()) {
+    async([=]() { return xfs::clearProjectId(directory); })
+      .onAny(defer(
+          PID<PosixDiskIsolatorProcess>(this),
+          &PosixDiskIsolatorProcess::_cleanup,
+          projectId.get(),
+          directory,
+          lambda::_1));
+  }
+#endif
+
   return Nothing();
 }
 
 
+void PosixDiskIsolatorProcess::_cleanup(
+    uint32_t projectId,
+    const string& directory,
+    const Future<Try<Nothing>>& future)
+{
+  if (!future.isReady() || future.get().isError()) {
+    // Keeping the project ID in use, as files might still carry it.
+    LOG(WARNING) << "Failed to clear the XFS project ID " << projectId
+                 << " of '" << directory << "': "
+                 << (!future.isReady()
+                       ? (future.isFailed() ? future.failure() : "discarded")
+                       : future.get().error());
+    return;
+  }
+
+  projectIds.erase(projectId);
+}
+
+
 class DiskUsageCollectorProcess : public Process<DiskUsageCollectorProcess>
 {
 public:
-  DiskUsageCollectorProcess(const Duration& _interval) : interval(_interval) {}
+  DiskUsageCollectorProcess(const Duration& _interval, bool _projectQuotas)
+    : interval(_interval), projectQuotas(_projectQuotas) {}
   virtual ~DiskUsageCollectorProcess() {}
 
   Future<Bytes> usage(const string& path)
@@ -390,6 +506,12 @@ private:
   // for throttling purpose.
   void schedule()
   {
+#ifdef __linux__
+    if (projectQuotas) {
+      collectProjectQuotas();
+    }
+#endif
+
     if (entries.empty()) {
       delay(interval, self(), &Self::schedule);
       return;
@@ -431,6 +553,33 @@ private:
       .onAny(defer(self(), &Self::_schedule, lambda::_1));
   }
 
+#ifdef __linux__
+  // Answers all pending checks of paths with an XFS project ID from
+  // their project quota, which takes a system call rather than a walk
+  // of the tree.
+  void collectProjectQuotas()
+  {
+    for (auto it = entries.begin(); it != entries.end();) {
+      Result<uint32_t> projectId = xfs::getProjectId((*it)->path);
+      if (!projectId.isSome()) {
+        // Leave it to 'du'.
+        ++it;
+        continue;
+      }
+
+      Try<Bytes> usage = xfs::getProjectUsage((*it)->path, projectId.get());
+      if (usage.isError()) {
+        (*it)->promise.fail(
+            "Failed to get the project quota usage: " + usage.error());
+      } else {
+        (*it)->promise.set(usage.get());
+      }
+
+      it = entries.erase(it);
+    }
+  }
+#endif
+
   void _schedule(const Future<std::tuple<
       Future<Option<int>>,
       Future<string>,
@@ -492,14 +641,20 @@ private:
 
   const Duration interval;
 
+  // Whether to read the usage of paths with an XFS project ID from
+  // their project quota.
+  const bool projectQuotas;
+
   // A queue of pending checks.
   deque<Owned<Entry>> entries;
 };
 
 
-DiskUsageCollector::DiskUsageCollector(const Duration& interval)
+DiskUsageCollector::DiskUsageCollector(
+    const Duration& interval,
+    bool projectQuotas)
 {
-  process = new DiskUsageCollectorProcess(interval);
+  process = new DiskUsageCollectorProcess(interval, projectQuotas);
   spawn(process);
 }
 
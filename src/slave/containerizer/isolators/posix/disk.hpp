@@ -19,6 +19,8 @@
 #ifndef __POSIX_DISK_ISOLATOR_HPP__
 #define __POSIX_DISK_ISOLATOR_HPP__
 
+#include <stdint.h>
+
 #include <string>
 
 #include <mesos/slave/isolator.hpp>
@@ -28,6 +30,7 @@
 #include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 
 #include "slave/flags.hpp"
 #include "slave/state.hpp"
@@ -41,11 +44,14 @@ class DiskUsageCollectorProcess;
 
 
 // Responsible for collecting disk usage for paths, while ensuring
-// that an interval elapses between each collection.
+// that an interval elapses between each collection. With
+// 'projectQuotas' the usage of all pending paths which carry an XFS
+// project ID is read from their project quota in each interval, and
+// 'du' is only run for the other paths.
 class DiskUsageCollector
 {
 public:
-  DiskUsageCollector(const Duration& interval);
+  DiskUsageCollector(const Duration& interval, bool projectQuotas = false);
   ~DiskUsageCollector();
 
   // Returns the disk usage rooted at 'path'. The user can discard the
@@ -113,9 +119,19 @@ private:
       const std::string& path,
       const process::Future<Bytes>& future);
 
+  void _cleanup(
+      uint32_t projectId,
+      const std::string& directory,
+      const process::Future<Try<Nothing>>& future);
+
   const Flags flags;
   DiskUsageCollector collector;
 
+  // XFS project IDs of the sandboxes, when using the 'xfs' collector.
+  // An ID stays in use after its container is cleaned up until the
+  // files in the sandbox no longer carry it.
+  hashset<uint32_t> projectIds;
+
   struct Info
   {
     explicit Info(const std::string& _directory) : directory(_directory) {}
@@ -124,6 +140,9 @@ private:
     // to collect disk usage for disk resources without DiskInfo.
     const std::string directory;
 
+    // The XFS project ID of the directory, if any.
+    Option<uint32_t> projectId;
+
     process::Promise<mesos::slave::Limitation> limitation;
 
     // The keys of the hashmaps contain the executor working directory
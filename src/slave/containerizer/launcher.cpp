@@ -45,7 +45,18 @@ namespace slave {
 
 Try<Launcher*> PosixLauncher::create(const Flags& flags)
 {
-  return new PosixLauncher();
+  Owned<ForkServer> forkServer;
+
+  if (flags.launcher_fork_server) {
+    Try<ForkServer*> create = ForkServer::create(flags);
+    if (create.isError()) {
+      return Error("Failed to create fork server: " + create.error());
+    }
+
+    forkServer.reset(create.get());
+  }
+
+  return new PosixLauncher(forkServer);
 }
 
 
@@ -114,6 +125,36 @@ Try<pid_t> PosixLauncher::fork(
                  stringify(containerId));
   }
 
+  // The fork server puts the child in a new session but can't run a
+  // setup function nor redirect I/O to a pipe.
+  if (forkServer.get() != NULL &&
+      setup.isNone() &&
+      !in.isPipe() && !out.isPipe() && !err.isPipe()) {
+    Try<pid_t> pid = forkServer->fork(
+        path,
+        argv,
+        in,
+        out,
+        err,
+        flags,
+        environment,
+        0,
+        None());
+
+    if (pid.isError()) {
+      return Error("Failed to fork a child process: " + pid.error());
+    }
+
+    LOG(INFO) << "Forked child with pid '" << pid.get()
+              << "' for container '" << containerId
+              << "' using the fork server";
+
+    // Store the pid (session id and process group id).
+    pids.put(containerId, pid.get());
+
+    return pid.get();
+  }
+
   Try<Subprocess> child = subprocess(
       path,
       argv,
@@ -30,6 +30,7 @@
 #include <mesos/slave/isolator.hpp>
 
 #include <process/future.hpp>
+#include <process/owned.hpp>
 #include <process/subprocess.hpp>
 
 #include <stout/flags.hpp>
@@ -41,6 +42,8 @@
 
 #include "slave/flags.hpp"
 
+#include "slave/containerizer/mesos/fork_server.hpp"
+
 namespace mesos {
 namespace internal {
 namespace slave {
@@ -107,11 +110,15 @@ public:
   virtual process::Future<Nothing> destroy(const ContainerID& containerId);
 
 private:
-  PosixLauncher() {}
+  explicit PosixLauncher(const process::Owned<ForkServer>& _forkServer)
+    : forkServer(_forkServer) {}
 
   // The 'pid' is the process id of the first process and also the
   // process group id and session id.
   hashmap<ContainerID, pid_t> pids;
+
+  // Used to fork children if enabled with --launcher_fork_server.
+  const process::Owned<ForkServer> forkServer;
 };
 
 } // namespace slave {
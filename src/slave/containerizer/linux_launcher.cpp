@@ -25,11 +25,14 @@
 
 #include <process/collect.hpp>
 
+#include <process/metrics/metrics.hpp>
+
 #include <stout/abort.hpp>
 #include <stout/check.hpp>
 #include <stout/hashset.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
 
 #include "linux/cgroups.hpp"
@@ -69,10 +72,25 @@ static ContainerID container(const string& cgroup)
 LinuxLauncher::LinuxLauncher(
     const Flags& _flags,
     int _namespaces,
-    const string& _hierarchy)
+    const string& _hierarchy,
+    const Owned<ForkServer>& _forkServer)
   : flags(_flags),
     namespaces(_namespaces),
-    hierarchy(_hierarchy) {}
+    hierarchy(_hierarchy),
+    forkServer(_forkServer) {}
+
+
+LinuxLauncher::Metrics::Metrics()
+  : container_destroy("containerizer/linux_launcher/container_destroy_ms")
+{
+  process::metrics::add(container_destroy);
+}
+
+
+LinuxLauncher::Metrics::~Metrics()
+{
+  process::metrics::remove(container_destroy);
+}
 
 
 // An old glibc might not have this symbol.
@@ -128,7 +146,18 @@ Try<Launcher*> LinuxLauncher::create(const Flags& flags)
     namespaces |= CLONE_NEWNS;
   }
 
-  return new LinuxLauncher(flags, namespaces, hierarchy.get());
+  Owned<ForkServer> forkServer;
+
+  if (flags.launcher_fork_server) {
+    Try<ForkServer*> create = ForkServer::create(flags);
+    if (create.isError()) {
+      return Error("Failed to create fork server: " + create.error());
+    }
+
+    forkServer.reset(create.get());
+  }
+
+  return new LinuxLauncher(flags, namespaces, hierarchy.get(), forkServer);
 }
 
 
@@ -294,19 +323,64 @@ Try<pid_t> LinuxLauncher::fork(
   // use CHECK.
   CHECK_EQ(0, ::pipe(pipes));
 
-  Try<Subprocess> child = subprocess(
-      path,
-      argv,
-      in,
-      out,
-      err,
-      flags,
-      environment,
-      lambda::bind(&childSetup, pipes, setup),
-      lambda::bind(&clone, lambda::_1, namespaces));
-
-  if (child.isError()) {
-    return Error("Failed to clone child process: " + child.error());
+  pid_t pid;
+
+  // The fork server can clone the child into the namespaces and block
+  // it on the pipe but can't run a setup function nor redirect I/O to
+  // a pipe.
+  if (forkServer.get() != NULL &&
+      setup.isNone() &&
+      !in.isPipe() && !out.isPipe() && !err.isPipe()) {
+    // The child only inherits the read end, passed as 'sync'.
+    Try<Nothing> cloexec = os::cloexec(pipes[0]);
+    if (cloexec.isSome()) {
+      cloexec = os::cloexec(pipes[1]);
+    }
+
+    if (cloexec.isError()) {
+      os::close(pipes[0]);
+      os::close(pipes[1]);
+      return Error("Failed to cloexec pipe: " + cloexec.error());
+    }
+
+    LOG(INFO) << "Cloning child process with flags = "
+              << ns::stringify(namespaces) << " using the fork server";
+
+    Try<pid_t> forked = forkServer->fork(
+        path,
+        argv,
+        in,
+        out,
+        err,
+        flags,
+        environment,
+        namespaces,
+        pipes[0]);
+
+    if (forked.isError()) {
+      os::close(pipes[0]);
+      os::close(pipes[1]);
+      return Error("Failed to clone child process: " + forked.error());
+    }
+
+    pid = forked.get();
+  } else {
+    Try<Subprocess> child = subprocess(
+        path,
+        argv,
+        in,
+        out,
+        err,
+        flags,
+        environment,
+        lambda::bind(&childSetup, pipes, setup),
+        lambda::bind(&clone, lambda::_1, namespaces));
+
+    if (child.isError()) {
+      return Error("Failed to clone child process: " + child.error());
+    }
+
+    pid = child.get().pid();
   }
 
   // Parent.
@@ -319,14 +393,14 @@ Try<pid_t> LinuxLauncher::fork(
   Try<Nothing> assign = cgroups::assign(
       hierarchy,
       cgroup(containerId),
-      child.get().pid());
+      pid);
 
   if (assign.isError()) {
-    LOG(ERROR) << "Failed to assign process " << child.get().pid()
+    LOG(ERROR) << "Failed to assign process " << pid
                 << " of container '" << containerId << "'"
                 << " to its freezer cgroup: " << assign.error();
 
-    ::kill(child.get().pid(), SIGKILL);
+    ::kill(pid, SIGKILL);
     return Error("Failed to contain process");
   }
 
@@ -341,15 +415,15 @@ Try<pid_t> LinuxLauncher::fork(
 
   if (length != sizeof(dummy)) {
     // Ensure the child is killed.
-    ::kill(child.get().pid(), SIGKILL);
+    ::kill(pid, SIGKILL);
     return Error("Failed to synchronize child process");
   }
 
   if (!pids.contains(containerId)) {
-    pids.put(containerId, child.get().pid());
+    pids.put(containerId, pid);
   }
 
-  return child.get().pid();
+  return pid;
 }
 
 
@@ -374,13 +448,18 @@ Future<Nothing> LinuxLauncher::destroy(const ContainerID& containerId)
     return Nothing();
   }
 
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  Future<Nothing> destroy;
+
   Result<ino_t> containerPidNs =
     NamespacesPidIsolatorProcess::getNamespace(containerId);
 
   if (containerPidNs.isSome()) {
     LOG(INFO) << "Using pid namespace to destroy container " << containerId;
 
-    return ns::pid::destroy(containerPidNs.get())
+    destroy = ns::pid::destroy(containerPidNs.get())
       .then(lambda::bind(
             (Future<Nothing>(*)(const string&,
                                 const string&,
@@ -388,13 +467,20 @@ Future<Nothing> LinuxLauncher::destroy(const ContainerID& containerId)
             hierarchy,
             cgroup(containerId),
             cgroups::DESTROY_TIMEOUT));
+  } else {
+    // Try to clean up using just the freezer cgroup.
+    destroy = cgroups::destroy(
+        hierarchy,
+        cgroup(containerId),
+        cgroups::DESTROY_TIMEOUT);
   }
 
-  // Try to clean up using just the freezer cgroup.
-  return cgroups::destroy(
-      hierarchy,
-      cgroup(containerId),
-      cgroups::DESTROY_TIMEOUT);
+  process::metrics::Histogram histogram = metrics.container_destroy;
+
+  return destroy
+    .onReady([=]() mutable {
+      histogram.record(stopwatch.elapsed().ms());
+    });
 }
 
 
@@ -19,6 +19,8 @@
 #ifndef __LINUX_LAUNCHER_HPP__
 #define __LINUX_LAUNCHER_HPP__
 
+#include <process/metrics/histogram.hpp>
+
 #include "slave/containerizer/launcher.hpp"
 
 namespace mesos {
@@ -54,13 +56,17 @@ private:
   LinuxLauncher(
       const Flags& flags,
       int namespaces,
-      const std::string& hierarchy);
+      const std::string& hierarchy,
+      const process::Owned<ForkServer>& forkServer);
 
   static const std::string subsystem;
   const Flags flags;
   const int namespaces;
   const std::string hierarchy;
 
+  // Used to clone children if enabled with --launcher_fork_server.
+  const process::Owned<ForkServer> forkServer;
+
   std::string cgroup(const ContainerID& containerId);
 
   // The 'pid' is the process id of the child process and also the
@@ -68,6 +74,16 @@ private:
   hashmap<ContainerID, pid_t> pids;
 
   hashset<ContainerID> orphans;
+
+  struct Metrics
+  {
+    Metrics();
+    ~Metrics();
+
+    // Time it takes to kill all the processes of a container and
+    // remove its freezer cgroup.
+    process::metrics::Histogram container_destroy;
+  } metrics;
 };
 
 } // namespace slave {
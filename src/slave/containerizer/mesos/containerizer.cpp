@@ -46,7 +46,9 @@
 #include "slave/containerizer/isolators/posix.hpp"
 #include "slave/containerizer/isolators/posix/disk.hpp"
 #ifdef __linux__
+#include "slave/containerizer/isolators/cgroups/blkio.hpp"
 #include "slave/containerizer/isolators/cgroups/cpushare.hpp"
+#include "slave/containerizer/isolators/cgroups/cpuset.hpp"
 #include "slave/containerizer/isolators/cgroups/mem.hpp"
 #include "slave/containerizer/isolators/cgroups/perf_event.hpp"
 #include "slave/containerizer/isolators/filesystem/shared.hpp"
@@ -58,6 +60,9 @@
 
 #include "slave/containerizer/mesos/containerizer.hpp"
 #include "slave/containerizer/mesos/launch.hpp"
+#ifdef __linux__
+#include "slave/containerizer/mesos/provisioner.hpp"
+#endif // __linux__
 
 using std::list;
 using std::map;
@@ -117,7 +122,9 @@ Try<MesosContainerizer*> MesosContainerizer::create(
   creators["posix/mem"]   = &PosixMemIsolatorProcess::create;
   creators["posix/disk"]  = &PosixDiskIsolatorProcess::create;
 #ifdef __linux__
+  creators["cgroups/blkio"] = &CgroupsBlkioIsolatorProcess::create;
   creators["cgroups/cpu"] = &CgroupsCpushareIsolatorProcess::create;
+  creators["cgroups/cpuset"] = &CgroupsCpusetIsolatorProcess::create;
   creators["cgroups/mem"] = &CgroupsMemIsolatorProcess::create;
   creators["cgroups/perf_event"] = &CgroupsPerfEventIsolatorProcess::create;
   creators["filesystem/shared"] = &SharedFilesystemIsolatorProcess::create;
@@ -128,6 +135,7 @@ Try<MesosContainerizer*> MesosContainerizer::create(
 #endif
 
   vector<Owned<Isolator>> isolators;
+  vector<string> names;
 
   foreach (const string& type, strings::tokenize(isolation, ",")) {
     if (creators.contains(type)) {
@@ -137,6 +145,7 @@ Try<MesosContainerizer*> MesosContainerizer::create(
             "Could not create isolator " + type + ": " + isolator.error());
       } else {
         isolators.push_back(Owned<Isolator>(isolator.get()));
+        names.push_back(type);
       }
     } else if (ModuleManager::contains<Isolator>(type)) {
       Try<Isolator*> isolator = ModuleManager::create<Isolator>(type);
@@ -148,8 +157,10 @@ Try<MesosContainerizer*> MesosContainerizer::create(
           // Filesystem isolator must be the first isolator used for prepare()
           // so any volume mounts are performed before anything else runs.
           isolators.insert(isolators.begin(), Owned<Isolator>(isolator.get()));
+          names.insert(names.begin(), type);
         } else {
           isolators.push_back(Owned<Isolator>(isolator.get()));
+          names.push_back(type);
         }
       }
     } else {
@@ -175,7 +186,12 @@ Try<MesosContainerizer*> MesosContainerizer::create(
   }
 
   return new MesosContainerizer(
-      flags_, local, fetcher, Owned<Launcher>(launcher.get()), isolators);
+      flags_,
+      local,
+      fetcher,
+      Owned<Launcher>(launcher.get()),
+      isolators,
+      names);
 }
 
 
@@ -184,13 +200,15 @@ MesosContainerizer::MesosContainerizer(
     bool local,
     Fetcher* fetcher,
     const Owned<Launcher>& launcher,
-    const vector<Owned<Isolator>>& isolators)
+    const vector<Owned<Isolator>>& isolators,
+    const vector<string>& names)
   : process(new MesosContainerizerProcess(
       flags,
       local,
       fetcher,
       launcher,
-      isolators))
+      isolators,
+      names))
 {
   spawn(process.get());
 }
@@ -300,12 +318,38 @@ void MesosContainerizer::destroy(const ContainerID& containerId)
 }
 
 
+bool MesosContainerizer::supports(
+    const Option<TaskInfo>& taskInfo,
+    const ExecutorInfo& executorInfo)
+{
+  // NOTE: This mirrors the checks in MesosContainerizerProcess::launch.
+  if (taskInfo.isSome() && taskInfo.get().has_container()) {
+    return false;
+  }
+
+  if (executorInfo.has_container() &&
+      executorInfo.container().type() != ContainerInfo::MESOS) {
+    return false;
+  }
+
+  return !executorInfo.command().has_container();
+}
+
+
 Future<hashset<ContainerID>> MesosContainerizer::containers()
 {
   return dispatch(process.get(), &MesosContainerizerProcess::containers);
 }
 
 
+void MesosContainerizerProcess::initialize()
+{
+#ifdef __linux__
+  provisioner = Owned<Provisioner>(new Provisioner(flags));
+#endif // __linux__
+}
+
+
 Future<Nothing> MesosContainerizerProcess::recover(
     const Option<state::SlaveState>& state)
 {
@@ -391,8 +435,8 @@ Future<Nothing> MesosContainerizerProcess::recover(
   }
 
   // Try to recover the launcher first.
-  return launcher->recover(recoverable)
-    .then(defer(self(), &Self::_recover, recoverable, lambda::_1));
+  return metrics.recover.time(launcher->recover(recoverable)
+    .then(defer(self(), &Self::_recover, recoverable, lambda::_1)));
 }
 
 
@@ -400,10 +444,23 @@ Future<Nothing> MesosContainerizerProcess::_recover(
     const list<ExecutorRunState>& recoverable,
     const hashset<ContainerID>& orphans)
 {
-  // Then recover the isolators.
+  // Then recover the isolators (concurrently).
   list<Future<Nothing>> futures;
-  foreach (const Owned<Isolator>& isolator, isolators) {
-    futures.push_back(isolator->recover(recoverable, orphans));
+  for (size_t i = 0; i < isolators.size(); i++) {
+    futures.push_back(
+        metrics.isolator_recover[i].time(
+            isolators[i]->recover(recoverable, orphans)));
+  }
+
+  // Remove the root filesystems of containers which are neither
+  // recovered nor orphans (the latter are cleaned up below).
+  if (provisioner.get() != NULL) {
+    hashset<ContainerID> known = orphans;
+    foreach (const ExecutorRunState& run, recoverable) {
+      known.insert(run.id);
+    }
+
+    futures.push_back(provisioner->recover(known));
   }
 
   // If all isolators recover then continue.
@@ -440,14 +497,16 @@ Future<Nothing> MesosContainerizerProcess::__recover(
     }
   }
 
-  // Destroy all the orphan containers.
+  // Destroy all the orphan containers. The orphans are destroyed
+  // concurrently but their isolators are cleaned up for at most
+  // MAX_CONCURRENT_CONTAINER_CLEANUPS of them at a time.
   // NOTE: We do not fail the recovery if the destroy of orphan
   // containers failed. See MESOS-2367 for details.
   foreach (const ContainerID& containerId, orphans) {
     LOG(INFO) << "Removing orphan container " << containerId;
 
     launcher->destroy(containerId)
-      .then(defer(self(), &Self::cleanupIsolators, containerId))
+      .then(defer(self(), &Self::cleanup, containerId))
       .onAny(defer(self(), &Self::___recover, containerId, lambda::_1));
   }
 
@@ -490,12 +549,13 @@ void MesosContainerizerProcess::___recover(
 
 
 // Launching an executor involves the following steps:
-// 1. Call prepare on each isolator.
+// 1. Provision the root filesystem if the container has image layers,
+//    then call prepare on each isolator and, concurrently, fetch the
+//    executor since fetching only depends on the executor's sandbox.
 // 2. Fork the executor. The forked child is blocked from exec'ing until it has
 //    been isolated.
 // 3. Isolate the executor. Call isolate with the pid for each isolator.
-// 4. Fetch the executor.
-// 5. Exec the executor. The forked child is signalled to continue. It will
+// 4. Exec the executor. The forked child is signalled to continue. It will
 //    first execute any preparation commands from isolators and then exec the
 //    executor.
 Future<bool> MesosContainerizerProcess::launch(
@@ -552,7 +612,26 @@ Future<bool> MesosContainerizerProcess::launch(
   // container resources.
   container->resources = executorInfo.resources();
 
-  return prepare(containerId, executorInfo, directory, user)
+  // NOTE: The isolators are prepared once the root filesystem is
+  // provisioned because they are passed the path to it.
+  Future<list<Option<CommandInfo>>> preparations =
+    metrics.launch_prepare.time(
+        provision(containerId, executorInfo, directory)
+          .then(defer(self(),
+                      &Self::prepare,
+                      containerId,
+                      executorInfo,
+                      directory,
+                      user)));
+
+  // Destroy waits for the preparations, including the provisioning.
+  container->preparations = preparations;
+
+  container->fetching = metrics.launch_fetch.time(
+      fetch(containerId, executorInfo.command(), directory, user, slaveId));
+
+  return metrics.launch.time(container->fetching
+    .then([=]() { return preparations; })
     .then(defer(self(),
                 &Self::_launch,
                 containerId,
@@ -562,7 +641,7 @@ Future<bool> MesosContainerizerProcess::launch(
                 slaveId,
                 slavePid,
                 checkpoint,
-                lambda::_1));
+                lambda::_1)));
 }
 
 
@@ -593,6 +672,42 @@ Future<bool> MesosContainerizerProcess::launch(
 }
 
 
+Future<Nothing> MesosContainerizerProcess::provision(
+    const ContainerID& containerId,
+    const ExecutorInfo& executorInfo,
+    const string& directory)
+{
+  if (!executorInfo.has_container() ||
+      executorInfo.container().mesos().layers_size() == 0) {
+    return Nothing();
+  }
+
+  if (provisioner.get() == NULL) {
+    return Failure("Image layers are only supported on Linux");
+  }
+
+  return provisioner->provision(
+      containerId,
+      executorInfo.container().mesos(),
+      directory)
+    .then(defer(self(), &Self::_provision, containerId, lambda::_1));
+}
+
+
+Future<Nothing> MesosContainerizerProcess::_provision(
+    const ContainerID& containerId,
+    const string& rootfs)
+{
+  if (!containers_.contains(containerId)) {
+    return Failure("Container is already destroyed");
+  }
+
+  containers_[containerId]->rootfs = rootfs;
+
+  return Nothing();
+}
+
+
 static list<Option<CommandInfo>> accumulate(
     list<Option<CommandInfo>> l,
     const Option<CommandInfo>& e)
@@ -604,6 +719,7 @@ static list<Option<CommandInfo>> accumulate(
 
 static Future<list<Option<CommandInfo>>> _prepare(
     const Owned<Isolator>& isolator,
+    metrics::Timer<Milliseconds> timer,
     const ContainerID& containerId,
     const ExecutorInfo& executorInfo,
     const string& directory,
@@ -612,7 +728,8 @@ static Future<list<Option<CommandInfo>>> _prepare(
     const list<Option<CommandInfo>> commands)
 {
   // Propagate any failure.
-  return isolator->prepare(containerId, executorInfo, directory, rootfs, user)
+  return timer.time(
+      isolator->prepare(containerId, executorInfo, directory, rootfs, user))
     .then(lambda::bind(&accumulate, commands, lambda::_1));
 }
 
@@ -630,10 +747,11 @@ Future<list<Option<CommandInfo>>> MesosContainerizerProcess::prepare(
   // filesystem isolator before other isolators.
   Future<list<Option<CommandInfo>>> f = list<Option<CommandInfo>>();
 
-  foreach (const Owned<Isolator>& isolator, isolators) {
+  for (size_t i = 0; i < isolators.size(); i++) {
     // Chain together preparing each isolator.
     f = f.then(lambda::bind(&_prepare,
-                            isolator,
+                            isolators[i],
+                            metrics.isolator_prepare[i],
                             containerId,
                             executorInfo,
                             directory,
@@ -687,15 +805,30 @@ Future<bool> MesosContainerizerProcess::_launch(
     return Failure("Container is currently being destroyed");
   }
 
+  const Option<string>& rootfs = containers_[containerId]->rootfs;
+
+  // The sandbox is bind mounted into a provisioned root filesystem
+  // so the executor sees it at a different path.
+#ifdef __linux__
+  const string sandbox =
+    rootfs.isSome() ? PROVISIONER_SANDBOX_DIRECTORY : directory;
+#else
+  const string sandbox = directory;
+#endif // __linux__
+
   // Prepare environment variables for the executor.
   map<string, string> env = executorEnvironment(
       executorInfo,
-      directory,
+      sandbox,
       slaveId,
       slavePid,
       checkpoint,
       flags.recovery_timeout);
 
+  if (rootfs.isSome()) {
+    env["MESOS_SANDBOX"] = sandbox;
+  }
+
   // Include any enviroment variables from CommandInfo.
   foreach (const Environment::Variable& variable,
            executorInfo.command().environment().variables()) {
@@ -713,7 +846,8 @@ Future<bool> MesosContainerizerProcess::_launch(
   MesosContainerizerLaunch::Flags launchFlags;
 
   launchFlags.command = JSON::Protobuf(executorInfo.command());
-  launchFlags.directory = directory;
+  launchFlags.directory = sandbox;
+  launchFlags.rootfs = rootfs;
   launchFlags.user = user;
   launchFlags.pipe_read = pipes[0];
   launchFlags.pipe_write = pipes[1];
@@ -736,6 +870,8 @@ Future<bool> MesosContainerizerProcess::_launch(
   argv[0] = MESOS_CONTAINERIZER;
   argv[1] = MesosContainerizerLaunch::NAME;
 
+  metrics.launch_fork.start();
+
   Try<pid_t> forked = launcher->fork(
       containerId,
       path::join(flags.launcher_dir, MESOS_CONTAINERIZER),
@@ -749,6 +885,8 @@ Future<bool> MesosContainerizerProcess::_launch(
       env,
       None());
 
+  metrics.launch_fork.stop();
+
   if (forked.isError()) {
     return Failure("Failed to fork executor: " + forked.error());
   }
@@ -783,14 +921,7 @@ Future<bool> MesosContainerizerProcess::_launch(
   status.onAny(defer(self(), &Self::reaped, containerId));
   containers_[containerId]->status = status;
 
-  return isolate(containerId, pid)
-    .then(defer(self(),
-                &Self::fetch,
-                containerId,
-                executorInfo.command(),
-                directory,
-                user,
-                slaveId))
+  return metrics.launch_isolate.time(isolate(containerId, pid))
     .then(defer(self(), &Self::exec, containerId, pipes[1]))
     .onAny(lambda::bind(&os::close, pipes[0]))
     .onAny(lambda::bind(&os::close, pipes[1]));
@@ -816,8 +947,10 @@ Future<bool> MesosContainerizerProcess::isolate(
   // or destroy because we assume there are no dependencies in
   // isolation.
   list<Future<Nothing>> futures;
-  foreach (const Owned<Isolator>& isolator, isolators) {
-    futures.push_back(isolator->isolate(containerId, _pid));
+  for (size_t i = 0; i < isolators.size(); i++) {
+    futures.push_back(
+        metrics.isolator_isolate[i].time(
+            isolators[i]->isolate(containerId, _pid)));
   }
 
   // Wait for all isolators to complete.
@@ -1002,11 +1135,14 @@ void MesosContainerizerProcess::destroy(
 
     container->state = DESTROYING;
 
+    // Stop fetching, which happens while preparing.
+    fetcher->kill(containerId);
+
     Future<Option<int>> status = None();
     // We need to wait for the isolators to finish preparing to prevent
     // a race that the destroy method calls isolators' cleanup before
     // it starts preparing.
-    container->preparations
+    await(container->preparations, container->fetching)
       .onAny(defer(
           self(),
           &Self::___destroy,
@@ -1018,10 +1154,6 @@ void MesosContainerizerProcess::destroy(
     return;
   }
 
-  if (container->state == FETCHING) {
-    fetcher->kill(containerId);
-  }
-
   if (container->state == ISOLATING) {
     VLOG(1) << "Waiting for the isolators to complete for container '"
             << containerId << "'";
@@ -1046,7 +1178,7 @@ void MesosContainerizerProcess::_destroy(
     bool killed)
 {
   // Kill all processes then continue destruction.
-  launcher->destroy(containerId)
+  metrics.destroy_kill.time(launcher->destroy(containerId))
     .onAny(defer(self(), &Self::__destroy, containerId, lambda::_1, killed));
 }
 
@@ -1096,7 +1228,7 @@ void MesosContainerizerProcess::___destroy(
     const Option<string>& message,
     bool killed)
 {
-  cleanupIsolators(containerId)
+  cleanup(containerId)
     .onAny(defer(self(),
                  &Self::____destroy,
                  containerId,
@@ -1222,17 +1354,84 @@ Future<hashset<ContainerID>> MesosContainerizerProcess::containers()
 }
 
 
-MesosContainerizerProcess::Metrics::Metrics()
+MesosContainerizerProcess::Metrics::Metrics(
+    size_t isolators,
+    const vector<string>& names)
   : container_destroy_errors(
-        "containerizer/mesos/container_destroy_errors")
+        "containerizer/mesos/container_destroy_errors"),
+    launch("containerizer/mesos/launch", Days(1)),
+    launch_prepare("containerizer/mesos/launch/prepare", Days(1)),
+    launch_fetch("containerizer/mesos/launch/fetch", Days(1)),
+    launch_fork("containerizer/mesos/launch/fork", Days(1)),
+    launch_isolate("containerizer/mesos/launch/isolate", Days(1)),
+    destroy_kill("containerizer/mesos/destroy/kill", Days(1)),
+    destroy_cleanup("containerizer/mesos/destroy/cleanup", Days(1)),
+    recover("containerizer/mesos/recover", Days(1))
 {
   process::metrics::add(container_destroy_errors);
+
+  process::metrics::add(recover);
+
+  process::metrics::add(launch);
+  process::metrics::add(launch_prepare);
+  process::metrics::add(launch_fetch);
+  process::metrics::add(launch_fork);
+  process::metrics::add(launch_isolate);
+
+  process::metrics::add(destroy_kill);
+  process::metrics::add(destroy_cleanup);
+
+  for (size_t i = 0; i < isolators; i++) {
+    const string prefix = "containerizer/mesos/isolators/" +
+      (names.size() == isolators ? names[i] : stringify(i));
+
+    isolator_recover.push_back(
+        metrics::Timer<Milliseconds>(prefix + "/recover", Days(1)));
+    isolator_prepare.push_back(
+        metrics::Timer<Milliseconds>(prefix + "/prepare", Days(1)));
+    isolator_isolate.push_back(
+        metrics::Timer<Milliseconds>(prefix + "/isolate", Days(1)));
+    isolator_cleanup.push_back(
+        metrics::Timer<Milliseconds>(prefix + "/cleanup", Days(1)));
+
+    process::metrics::add(isolator_recover.back());
+    process::metrics::add(isolator_prepare.back());
+    process::metrics::add(isolator_isolate.back());
+    process::metrics::add(isolator_cleanup.back());
+  }
 }
 
 
 MesosContainerizerProcess::Metrics::~Metrics()
 {
   process::metrics::remove(container_destroy_errors);
+
+  process::metrics::remove(recover);
+
+  process::metrics::remove(launch);
+  process::metrics::remove(launch_prepare);
+  process::metrics::remove(launch_fetch);
+  process::metrics::remove(launch_fork);
+  process::metrics::remove(launch_isolate);
+
+  process::metrics::remove(destroy_kill);
+  process::metrics::remove(destroy_cleanup);
+
+  foreach (const metrics::Timer<Milliseconds>& timer, isolator_recover) {
+    process::metrics::remove(timer);
+  }
+
+  foreach (const metrics::Timer<Milliseconds>& timer, isolator_prepare) {
+    process::metrics::remove(timer);
+  }
+
+  foreach (const metrics::Timer<Milliseconds>& timer, isolator_isolate) {
+    process::metrics::remove(timer);
+  }
+
+  foreach (const metrics::Timer<Milliseconds>& timer, isolator_cleanup) {
+    process::metrics::remove(timer);
+  }
 }
 
 
@@ -1333,6 +1532,25 @@ Try<Nothing> MesosContainerizerProcess::updateVolumes(
 }
 
 
+Future<list<Future<Nothing>>> MesosContainerizerProcess::cleanup(
+    const ContainerID& containerId)
+{
+  const PID<MesosContainerizerProcess> pid = self();
+
+  return concurrentCleanups.run([=]() {
+    return dispatch(pid, &MesosContainerizerProcess::_cleanup, containerId);
+  });
+}
+
+
+Future<list<Future<Nothing>>> MesosContainerizerProcess::_cleanup(
+    const ContainerID& containerId)
+{
+  return metrics.destroy_cleanup.time(cleanupIsolators(containerId)
+    .then(defer(self(), &Self::cleanupProvisioner, containerId, lambda::_1)));
+}
+
+
 static list<Future<Nothing>> __cleanupIsolators(
     const list<Future<Nothing>>& cleanups)
 {
@@ -1342,11 +1560,12 @@ static list<Future<Nothing>> __cleanupIsolators(
 
 static Future<list<Future<Nothing>>> _cleanupIsolators(
     const Owned<Isolator>& isolator,
+    metrics::Timer<Milliseconds> timer,
     const ContainerID& containerId,
     list<Future<Nothing>> cleanups)
 {
   // Accumulate but do not propagate any failure.
-  Future<Nothing> cleanup = isolator->cleanup(containerId);
+  Future<Nothing> cleanup = timer.time(isolator->cleanup(containerId));
   cleanups.push_back(cleanup);
 
   // Wait for the cleanup to complete/fail before returning the list.
@@ -1367,15 +1586,14 @@ Future<list<Future<Nothing>>> MesosContainerizerProcess::cleanupIsolators(
 
   // NOTE: We clean up each isolator in the reverse order they were
   // prepared (see comment in prepare()).
-  for (auto it = isolators.crbegin(); it != isolators.crend(); ++it) {
-    const Owned<Isolator>& isolator = *it;
-
+  for (size_t i = isolators.size(); i > 0; i--) {
     // We'll try to clean up all isolators, waiting for each to
     // complete and continuing if one fails.
     // TODO(jieyu): Technically, we cannot bind 'isolator' here
     // because the ownership will be transferred after the bind.
     f = f.then(lambda::bind(&_cleanupIsolators,
-                            isolator,
+                            isolators[i - 1],
+                            metrics.isolator_cleanup[i - 1],
                             containerId,
                             lambda::_1));
   }
@@ -1383,6 +1601,22 @@ Future<list<Future<Nothing>>> MesosContainerizerProcess::cleanupIsolators(
   return f;
 }
 
+
+Future<list<Future<Nothing>>> MesosContainerizerProcess::cleanupProvisioner(
+    const ContainerID& containerId,
+    list<Future<Nothing>> cleanups)
+{
+  if (provisioner.get() == NULL) {
+    return cleanups;
+  }
+
+  cleanups.push_back(provisioner->destroy(containerId));
+
+  // Like the isolator cleanups the returned future is always ready,
+  // a failure is only reflected in the individual cleanup.
+  return await(cleanups);
+}
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
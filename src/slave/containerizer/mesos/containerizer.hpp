@@ -20,15 +20,19 @@
 #define __MESOS_CONTAINERIZER_HPP__
 
 #include <list>
+#include <string>
 #include <vector>
 
 #include <mesos/slave/isolator.hpp>
 
 #include <process/metrics/counter.hpp>
+#include <process/metrics/timer.hpp>
+#include <process/semaphore.hpp>
 
 #include <stout/hashmap.hpp>
 #include <stout/multihashmap.hpp>
 
+#include "slave/constants.hpp"
 #include "slave/state.hpp"
 
 #include "slave/containerizer/containerizer.hpp"
@@ -40,8 +44,9 @@ namespace slave {
 
 extern const char MESOS_CONTAINERIZER[];
 
-// Forward declaration.
+// Forward declarations.
 class MesosContainerizerProcess;
+class Provisioner;
 
 class MesosContainerizer : public Containerizer
 {
@@ -51,12 +56,15 @@ public:
       bool local,
       Fetcher* fetcher);
 
+  // The (optional) names of the isolators, e.g., 'cgroups/cpu', are
+  // used to name their metrics.
   MesosContainerizer(
       const Flags& flags,
       bool local,
       Fetcher* fetcher,
       const process::Owned<Launcher>& launcher,
-      const std::vector<process::Owned<mesos::slave::Isolator>>& isolators);
+      const std::vector<process::Owned<mesos::slave::Isolator>>& isolators,
+      const std::vector<std::string>& names = std::vector<std::string>());
 
   // Used for testing.
   MesosContainerizer(const process::Owned<MesosContainerizerProcess>& _process);
@@ -85,6 +93,10 @@ public:
       const process::PID<Slave>& slavePid,
       bool checkpoint);
 
+  virtual bool supports(
+      const Option<TaskInfo>& taskInfo,
+      const ExecutorInfo& executorInfo);
+
   virtual process::Future<Nothing> update(
       const ContainerID& containerId,
       const Resources& resources);
@@ -113,15 +125,20 @@ public:
       bool _local,
       Fetcher* _fetcher,
       const process::Owned<Launcher>& _launcher,
-      const std::vector<process::Owned<mesos::slave::Isolator>>& _isolators)
+      const std::vector<process::Owned<mesos::slave::Isolator>>& _isolators,
+      const std::vector<std::string>& _names = std::vector<std::string>())
     : flags(_flags),
       local(_local),
       fetcher(_fetcher),
       launcher(_launcher),
-      isolators(_isolators) {}
+      isolators(_isolators),
+      concurrentCleanups(MAX_CONCURRENT_CONTAINER_CLEANUPS),
+      metrics(_isolators.size(), _names) {}
 
   virtual ~MesosContainerizerProcess() {}
 
+  virtual void initialize();
+
   virtual process::Future<Nothing> recover(
       const Option<state::SlaveState>& state);
 
@@ -176,6 +193,18 @@ private:
       const std::list<mesos::slave::ExecutorRunState>& recovered,
       const hashset<ContainerID>& orphans);
 
+  // Provisions the root filesystem of the container if its
+  // ContainerInfo has image layers.
+  process::Future<Nothing> provision(
+      const ContainerID& containerId,
+      const ExecutorInfo& executorInfo,
+      const std::string& directory);
+
+  // Continues 'provision()' once the root filesystem is provisioned.
+  process::Future<Nothing> _provision(
+      const ContainerID& containerId,
+      const std::string& rootfs);
+
   process::Future<std::list<Option<CommandInfo>>> prepare(
       const ContainerID& containerId,
       const ExecutorInfo& executorInfo,
@@ -244,22 +273,45 @@ private:
       const ContainerID& containerId,
       const Resources& updated);
 
+  // Cleans up the isolators and the provisioner of the container,
+  // bounded by MAX_CONCURRENT_CONTAINER_CLEANUPS across containers.
+  // The returned future is always ready, a failure is only reflected
+  // in the individual cleanups.
+  process::Future<std::list<process::Future<Nothing>>> cleanup(
+      const ContainerID& containerId);
+
+  // Continues 'cleanup()' once the container may be cleaned up.
+  process::Future<std::list<process::Future<Nothing>>> _cleanup(
+      const ContainerID& containerId);
+
   // TODO(jieyu): Consider introducing an Isolators struct and moving
   // all isolator related operations to that struct.
   process::Future<std::list<process::Future<Nothing>>> cleanupIsolators(
       const ContainerID& containerId);
 
+  // Removes the root filesystem of the container (if provisioned)
+  // once the isolators are cleaned up. The result is added to the
+  // 'cleanups' of the isolators.
+  process::Future<std::list<process::Future<Nothing>>> cleanupProvisioner(
+      const ContainerID& containerId,
+      std::list<process::Future<Nothing>> cleanups);
+
   const Flags flags;
   const bool local;
   Fetcher* fetcher;
   const process::Owned<Launcher> launcher;
   const std::vector<process::Owned<mesos::slave::Isolator>> isolators;
 
+  // Only created on Linux since it requires overlayfs.
+  process::Owned<Provisioner> provisioner;
+
+  // Bounds the number of containers being cleaned up concurrently.
+  process::Semaphore concurrentCleanups;
+
   enum State
   {
-    PREPARING,
+    PREPARING, // Preparing the isolators and fetching the executor.
     ISOLATING,
-    FETCHING,
     RUNNING,
     DESTROYING
   };
@@ -279,6 +331,11 @@ private:
     // calling cleanup after all isolators has finished preparing.
     process::Future<std::list<Option<CommandInfo>>> preparations;
 
+    // We keep track of the future that is waiting for the executor to
+    // be fetched, which happens concurrently with the preparations,
+    // so that destroy will only start cleanup after fetching is done.
+    process::Future<Nothing> fetching;
+
     // We keep track of the future that is waiting for all the
     // isolators' isolate futures, so that destroy will only start
     // calling cleanup after all isolators has finished isolating.
@@ -306,10 +363,37 @@ private:
 
   struct Metrics
   {
-    Metrics();
+    // The metrics of the isolators are named after 'names', falling
+    // back to the index of the isolator if no name is known.
+    Metrics(size_t isolators, const std::vector<std::string>& names);
     ~Metrics();
 
     process::metrics::Counter container_destroy_errors;
+
+    // Latencies of launching a container (until the executor is
+    // exec'ed) and of each of its stages.
+    process::metrics::Timer<Milliseconds> launch;
+    process::metrics::Timer<Milliseconds> launch_prepare;
+    process::metrics::Timer<Milliseconds> launch_fetch;
+    process::metrics::Timer<Milliseconds> launch_fork;
+    process::metrics::Timer<Milliseconds> launch_isolate;
+
+    // Latencies of destroying a container, i.e., of killing all its
+    // processes (e.g., destroying its freezer cgroup) and of cleaning
+    // up the isolators (e.g., destroying its other cgroups).
+    process::metrics::Timer<Milliseconds> destroy_kill;
+    process::metrics::Timer<Milliseconds> destroy_cleanup;
+
+    // Latency of recovering the launcher and the isolators.
+    process::metrics::Timer<Milliseconds> recover;
+
+    // Latencies of recovering, and of preparing, isolating and
+    // cleaning up a container for each isolator, in the order of
+    // 'isolators'.
+    std::vector<process::metrics::Timer<Milliseconds>> isolator_recover;
+    std::vector<process::metrics::Timer<Milliseconds>> isolator_prepare;
+    std::vector<process::metrics::Timer<Milliseconds>> isolator_isolate;
+    std::vector<process::metrics::Timer<Milliseconds>> isolator_cleanup;
   } metrics;
 };
 
@@ -0,0 +1,745 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif // __linux__
+
+#include <sys/socket.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif // __linux__
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <iostream>
+#include <list>
+
+#include <glog/logging.h>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/json.hpp>
+#include <stout/none.hpp>
+#include <stout/nothing.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/result.hpp>
+#include <stout/stringify.hpp>
+
+#include <stout/os/execenv.hpp>
+
+#include "slave/containerizer/mesos/containerizer.hpp"
+#include "slave/containerizer/mesos/fork_server.hpp"
+
+using std::cerr;
+using std::endl;
+using std::list;
+using std::map;
+using std::string;
+using std::vector;
+
+using process::Subprocess;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+const string MesosContainerizerForkServer::NAME = "fork-server";
+
+
+// The maximum number of file descriptors passed along with a single
+// request (the kernel allows up to 253, see SCM_MAX_FD).
+static const size_t MAX_FDS = 250;
+
+// The maximum size of a request or response.
+static const uint32_t MAX_MESSAGE_SIZE = 16 * 1024 * 1024;
+
+
+// Messages are sent as their length followed by the message itself.
+// Any file descriptors are passed along with the length.
+static Try<Nothing> sendMessage(
+    int socket,
+    const string& message,
+    const vector<int>& fds)
+{
+  uint32_t length = message.size();
+
+  struct iovec iov;
+  iov.iov_base = &length;
+  iov.iov_len = sizeof(length);
+
+  struct msghdr header;
+  memset(&header, 0, sizeof(header));
+  header.msg_iov = &iov;
+  header.msg_iovlen = 1;
+
+  vector<char> control;
+
+  if (!fds.empty()) {
+    control.resize(CMSG_SPACE(sizeof(int) * fds.size()));
+
+    header.msg_control = control.data();
+    header.msg_controllen = control.size();
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+
+    memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+  }
+
+  ssize_t sent;
+  while ((sent = ::sendmsg(socket, &header, MSG_NOSIGNAL)) == -1 &&
+         errno == EINTR);
+
+  if (sent == -1) {
+    return ErrnoError("Failed to send message header");
+  } else if (sent != sizeof(length)) {
+    return Error("Failed to send message header: Short write");
+  }
+
+  size_t offset = 0;
+  while (offset < message.size()) {
+    ssize_t written = ::send(
+        socket,
+        message.data() + offset,
+        message.size() - offset,
+        MSG_NOSIGNAL);
+
+    if (written == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return ErrnoError("Failed to send message");
+    }
+
+    offset += written;
+  }
+
+  return Nothing();
+}
+
+
+// Returns None if the connection has been closed. Any received file
+// descriptors are close-on-exec and appended to 'fds'.
+static Result<string> receiveMessage(int socket, vector<int>* fds)
+{
+  uint32_t length;
+
+  struct iovec iov;
+  iov.iov_base = &length;
+  iov.iov_len = sizeof(length);
+
+  char control[CMSG_SPACE(sizeof(int) * MAX_FDS)];
+
+  struct msghdr header;
+  memset(&header, 0, sizeof(header));
+  header.msg_iov = &iov;
+  header.msg_iovlen = 1;
+  header.msg_control = control;
+  header.msg_controllen = sizeof(control);
+
+#ifdef __linux__
+  const int options = MSG_CMSG_CLOEXEC;
+#else
+  const int options = 0;
+#endif // __linux__
+
+  ssize_t received;
+  while ((received = ::recvmsg(socket, &header, options)) == -1 &&
+         errno == EINTR);
+
+  if (received == -1) {
+    return ErrnoError("Failed to receive message header");
+  } else if (received == 0) {
+    return None();
+  }
+
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+       cmsg != NULL;
+       cmsg = CMSG_NXTHDR(&header, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      const int* data = (const int*) CMSG_DATA(cmsg);
+      fds->insert(fds->end(), data, data + count);
+    }
+  }
+
+  if (received != sizeof(length)) {
+    return Error("Failed to receive message header: Short read");
+  } else if (header.msg_flags & MSG_CTRUNC) {
+    return Error("Too many file descriptors");
+  } else if (length > MAX_MESSAGE_SIZE) {
+    return Error("Message of " + stringify(length) + " bytes is too large");
+  }
+
+  string message(length, '\0');
+
+  size_t offset = 0;
+  while (offset < length) {
+    ssize_t read = ::recv(socket, &message[offset], length - offset, 0);
+
+    if (read == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return ErrnoError("Failed to receive message");
+    } else if (read == 0) {
+      return Error("Connection closed while receiving message");
+    }
+
+    offset += read;
+  }
+
+  return message;
+}
+
+
+Try<ForkServer*> ForkServer::create(const Flags& flags)
+{
+#ifndef __linux__
+  return Error("The fork server is only supported on Linux");
+#else
+  int sockets[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+    return ErrnoError("Failed to create socket pair");
+  }
+
+  // Only the fork server should inherit its end of the connection.
+  Try<Nothing> cloexec = os::cloexec(sockets[0]);
+  if (cloexec.isError()) {
+    os::close(sockets[0]);
+    os::close(sockets[1]);
+    return Error("Failed to cloexec socket: " + cloexec.error());
+  }
+
+  vector<string> argv(3);
+  argv[0] = MESOS_CONTAINERIZER;
+  argv[1] = MesosContainerizerForkServer::NAME;
+  argv[2] = "--socket=" + stringify(sockets[1]);
+
+  Try<Subprocess> server = process::subprocess(
+      path::join(flags.launcher_dir, MESOS_CONTAINERIZER),
+      argv,
+      Subprocess::FD(STDIN_FILENO),
+      Subprocess::FD(STDOUT_FILENO),
+      Subprocess::FD(STDERR_FILENO));
+
+  os::close(sockets[1]);
+
+  if (server.isError()) {
+    os::close(sockets[0]);
+    return Error("Failed to launch the fork server: " + server.error());
+  }
+
+  LOG(INFO) << "Started fork server with pid " << server.get().pid();
+
+  return new ForkServer(sockets[0], server.get());
+#endif // __linux__
+}
+
+
+ForkServer::ForkServer(int _socket, const Subprocess& _server)
+  : socket(_socket),
+    server(_server) {}
+
+
+ForkServer::~ForkServer()
+{
+  os::close(socket);
+}
+
+
+// Returns the file descriptor to redirect the given I/O to, opening
+// (and adding to 'opened') the file in the PATH mode.
+static Try<int> redirect(
+    const Subprocess::IO& io,
+    bool input,
+    vector<int>* opened)
+{
+  if (io.isFd()) {
+    return io.descriptor().get();
+  }
+
+  CHECK(io.isPath());
+
+  const string& path = io.filename().get();
+
+  Try<int> fd = input
+    ? os::open(path, O_RDONLY | O_CLOEXEC)
+    : os::open(
+          path,
+          O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+          S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  opened->push_back(fd.get());
+
+  return fd.get();
+}
+
+
+Try<pid_t> ForkServer::fork(
+    const string& path,
+    vector<string> argv,
+    const Subprocess::IO& in,
+    const Subprocess::IO& out,
+    const Subprocess::IO& err,
+    const Option<flags::FlagsBase>& flags,
+    const Option<map<string, string>>& environment,
+    int namespaces,
+    const Option<int>& sync)
+{
+  if (in.isPipe() || out.isPipe() || err.isPipe()) {
+    return Error("Redirecting I/O to a pipe is not supported");
+  }
+
+  // Stringify the flags and append them to the arguments, like
+  // 'subprocess()' does.
+  if (flags.isSome()) {
+    foreachpair (const string& name, const flags::Flag& flag, flags.get()) {
+      Option<string> value = flag.stringify(flags.get());
+      if (value.isSome()) {
+        argv.push_back("--" + name + "=" + value.get());
+      }
+    }
+  }
+
+  // The file descriptors to pass to the child and the file
+  // descriptor each of them should become in the child.
+  vector<int> fds;
+  vector<int> targets;
+
+  // The files we opened for the PATH mode, closed once sent.
+  vector<int> opened;
+
+  Try<int> stdinFd = redirect(in, true, &opened);
+  Try<int> stdoutFd = stdinFd.isError()
+    ? Error(stdinFd.error())
+    : redirect(out, false, &opened);
+  Try<int> stderrFd = stdoutFd.isError()
+    ? Error(stdoutFd.error())
+    : redirect(err, false, &opened);
+
+  if (stderrFd.isError()) {
+    foreach (int fd, opened) {
+      os::close(fd);
+    }
+    return Error(stderrFd.error());
+  }
+
+  fds.push_back(stdinFd.get());
+  fds.push_back(stdoutFd.get());
+  fds.push_back(stderrFd.get());
+
+  targets.push_back(STDIN_FILENO);
+  targets.push_back(STDOUT_FILENO);
+  targets.push_back(STDERR_FILENO);
+
+  // The child inherits the file descriptors that a forked child
+  // would inherit, e.g., the pipes used to synchronize with the
+  // 'mesos-containerizer launch' helper.
+  Try<list<string>> entries = os::ls("/proc/self/fd");
+  if (entries.isError()) {
+    foreach (int fd, opened) {
+      os::close(fd);
+    }
+    return Error("Failed to list file descriptors: " + entries.error());
+  }
+
+  foreach (const string& entry, entries.get()) {
+    Try<int> fd = numify<int>(entry);
+    if (fd.isError() ||
+        fd.get() <= STDERR_FILENO ||
+        fd.get() == socket ||
+        (sync.isSome() && fd.get() == sync.get())) {
+      continue;
+    }
+
+    // NOTE: This also skips the file descriptor used to list the
+    // directory, which is closed by now.
+    int flags = ::fcntl(fd.get(), F_GETFD);
+    if (flags == -1 || (flags & FD_CLOEXEC)) {
+      continue;
+    }
+
+    fds.push_back(fd.get());
+    targets.push_back(fd.get());
+  }
+
+  if (sync.isSome()) {
+    fds.push_back(sync.get());
+  }
+
+  if (fds.size() > MAX_FDS) {
+    foreach (int fd, opened) {
+      os::close(fd);
+    }
+    return Error("Too many file descriptors to inherit");
+  }
+
+  JSON::Object request;
+  request.values["path"] = path;
+
+  JSON::Array arguments;
+  foreach (const string& argument, argv) {
+    arguments.values.push_back(argument);
+  }
+  request.values["argv"] = arguments;
+
+  if (environment.isSome()) {
+    JSON::Object variables;
+    foreachpair (const string& name,
+                 const string& value,
+                 environment.get()) {
+      variables.values[name] = value;
+    }
+    request.values["environment"] = variables;
+  }
+
+  JSON::Array descriptors;
+  foreach (int target, targets) {
+    descriptors.values.push_back(target);
+  }
+  request.values["fds"] = descriptors;
+
+  request.values["namespaces"] = namespaces;
+
+  if (sync.isSome()) {
+    request.values["sync"] = JSON::True();
+  } else {
+    request.values["sync"] = JSON::False();
+  }
+
+  Try<Nothing> sent = sendMessage(socket, stringify(request), fds);
+
+  foreach (int fd, opened) {
+    os::close(fd);
+  }
+
+  if (sent.isError()) {
+    return Error("Failed to send request to the fork server: " + sent.error());
+  }
+
+  vector<int> received;
+  Result<string> message = receiveMessage(socket, &received);
+
+  foreach (int fd, received) {
+    os::close(fd);
+  }
+
+  if (!message.isSome()) {
+    return Error(
+        "Failed to receive response from the fork server: " +
+        (message.isError() ? message.error() : "Connection closed"));
+  }
+
+  Try<JSON::Object> response = JSON::parse<JSON::Object>(message.get());
+  if (response.isError()) {
+    return Error("Failed to parse response from the fork server: " +
+                 response.error());
+  }
+
+  Result<JSON::String> error = response.get().find<JSON::String>("error");
+  if (error.isSome()) {
+    return Error(error.get().value);
+  }
+
+  Result<JSON::Number> pid = response.get().find<JSON::Number>("pid");
+  if (!pid.isSome()) {
+    return Error("Unexpected response from the fork server: " +
+                 message.get());
+  }
+
+  return static_cast<pid_t>(pid.get().value);
+}
+
+
+MesosContainerizerForkServer::Flags::Flags()
+{
+  add(&socket,
+      "socket",
+      "The connection to the slave to receive requests from.");
+}
+
+
+#ifdef __linux__
+// Everything the child needs, which is prepared before the clone.
+struct Child
+{
+  string path;
+  vector<string> argv;
+  Option<map<string, string>> environment;
+  vector<int> fds;
+  vector<int> targets;
+  Option<int> sync;
+};
+
+
+// The main entry of the child. NOTE: The fork server is single
+// threaded, so (unlike after forking the slave) there are no
+// restrictions on what the child can do before the exec.
+static int childMain(void* arg)
+{
+  const Child* child = (const Child*) arg;
+
+  // Block until the slave signals us to continue.
+  if (child->sync.isSome()) {
+    char dummy;
+    ssize_t length;
+    while ((length = ::read(child->sync.get(), &dummy, sizeof(dummy))) == -1 &&
+           errno == EINTR);
+
+    if (length != sizeof(dummy)) {
+      cerr << "Failed to synchronize with the slave" << endl;
+      _exit(1);
+    }
+  }
+
+  // Move to a different session (and new process group) so we're
+  // independent from the slave's session.
+  if (::setsid() == -1) {
+    perror("Failed to put child in a new session");
+    _exit(1);
+  }
+
+  // Move the file descriptors out of the way of their targets before
+  // duplicating them onto the targets.
+  int highest = *std::max_element(
+      child->targets.begin(),
+      child->targets.end());
+
+  vector<int> moved;
+  foreach (int fd, child->fds) {
+    int dup = ::fcntl(fd, F_DUPFD_CLOEXEC, highest + 1);
+    if (dup == -1) {
+      perror("Failed to duplicate file descriptor");
+      _exit(1);
+    }
+    moved.push_back(dup);
+  }
+
+  for (size_t i = 0; i < child->targets.size(); i++) {
+    while (::dup2(moved[i], child->targets[i]) == -1) {
+      if (errno != EINTR) {
+        perror("Failed to redirect file descriptor");
+        _exit(1);
+      }
+    }
+  }
+
+  // The received and moved file descriptors are all close-on-exec.
+  char** argv = new char*[child->argv.size() + 1];
+  for (size_t i = 0; i < child->argv.size(); i++) {
+    argv[i] = (char*) child->argv[i].c_str();
+  }
+  argv[child->argv.size()] = NULL;
+
+  // Without an environment the child inherits the environment of the
+  // fork server, i.e., of the slave when it started the fork server.
+  if (child->environment.isSome()) {
+    os::ExecEnv envp(child->environment.get());
+    os::execvpe(child->path.c_str(), argv, envp());
+  } else {
+    ::execvp(child->path.c_str(), argv);
+  }
+
+  perror(("Failed to execute '" + child->path + "'").c_str());
+  _exit(1);
+}
+
+
+// Clones a child as described by the request, using the received
+// file descriptors.
+static Try<pid_t> clone(const string& message, const vector<int>& fds)
+{
+  Try<JSON::Object> request = JSON::parse<JSON::Object>(message);
+  if (request.isError()) {
+    return Error("Failed to parse request: " + request.error());
+  }
+
+  Result<JSON::String> path = request.get().find<JSON::String>("path");
+  Result<JSON::Array> argv = request.get().find<JSON::Array>("argv");
+  Result<JSON::Array> targets = request.get().find<JSON::Array>("fds");
+  Result<JSON::Number> namespaces =
+    request.get().find<JSON::Number>("namespaces");
+  Result<JSON::Boolean> sync = request.get().find<JSON::Boolean>("sync");
+
+  if (!path.isSome() ||
+      !argv.isSome() ||
+      !targets.isSome() ||
+      !namespaces.isSome() ||
+      !sync.isSome()) {
+    return Error("Malformed request");
+  }
+
+  Child child;
+  child.path = path.get().value;
+
+  foreach (const JSON::Value& argument, argv.get().values) {
+    if (!argument.is<JSON::String>()) {
+      return Error("Malformed request: Expecting string arguments");
+    }
+    child.argv.push_back(argument.as<JSON::String>().value);
+  }
+
+  foreach (const JSON::Value& target, targets.get().values) {
+    if (!target.is<JSON::Number>()) {
+      return Error("Malformed request: Expecting numeric descriptors");
+    }
+    child.targets.push_back(
+        static_cast<int>(target.as<JSON::Number>().value));
+  }
+
+  if (child.targets.size() + (sync.get().value ? 1 : 0) != fds.size() ||
+      child.targets.empty()) {
+    return Error("Malformed request: Expecting " +
+                 stringify(child.targets.size()) + " file descriptors" +
+                 " but received " + stringify(fds.size()));
+  }
+
+  child.fds.assign(fds.begin(), fds.begin() + child.targets.size());
+
+  if (sync.get().value) {
+    child.sync = fds.back();
+  }
+
+  Result<JSON::Object> variables =
+    request.get().find<JSON::Object>("environment");
+
+  if (variables.isSome()) {
+    map<string, string> environment;
+    foreachpair (const string& name,
+                 const JSON::Value& value,
+                 variables.get().values) {
+      if (!value.is<JSON::String>()) {
+        return Error("Malformed request: Expecting string variables");
+      }
+      environment[name] = value.as<JSON::String>().value;
+    }
+    child.environment = environment;
+  }
+
+  // Stack for the child.
+  // - unsigned long long used for best alignment.
+  // - static is ok because each child gets their own copy after the clone.
+  static unsigned long long stack[(8*1024*1024)/sizeof(unsigned long long)];
+
+  // Clone the child as a child of the slave rather than of the fork
+  // server so that the slave can reap it.
+  pid_t pid = ::clone(
+      childMain,
+      &stack[sizeof(stack)/sizeof(stack[0]) - 1],  // stack grows down.
+      CLONE_PARENT | static_cast<int>(namespaces.get().value) | SIGCHLD,
+      (void*) &child);
+
+  if (pid == -1) {
+    return ErrnoError("Failed to clone");
+  }
+
+  return pid;
+}
+#endif // __linux__
+
+
+int MesosContainerizerForkServer::execute()
+{
+#ifndef __linux__
+  cerr << "The fork server is only supported on Linux" << endl;
+  return 1;
+#else
+  if (flags.socket.isNone()) {
+    cerr << "Flag --socket is not specified" << endl;
+    return 1;
+  }
+
+  const int socket = flags.socket.get();
+
+  // Don't outlive the slave.
+  if (::prctl(PR_SET_PDEATHSIG, SIGKILL) != 0) {
+    perror("Failed to set the parent death signal");
+    return 1;
+  }
+
+  // Don't leak the connection to the children.
+  Try<Nothing> cloexec = os::cloexec(socket);
+  if (cloexec.isError()) {
+    cerr << "Failed to cloexec socket: " << cloexec.error() << endl;
+    return 1;
+  }
+
+  while (true) {
+    vector<int> fds;
+    Result<string> message = receiveMessage(socket, &fds);
+
+    if (message.isNone()) {
+      // The slave has closed the connection.
+      return 0;
+    }
+
+    JSON::Object response;
+
+    if (message.isError()) {
+      response.values["error"] = message.error();
+    } else {
+      Try<pid_t> pid = clone(message.get(), fds);
+
+      if (pid.isError()) {
+        response.values["error"] = pid.error();
+      } else {
+        response.values["pid"] = pid.get();
+      }
+    }
+
+    foreach (int fd, fds) {
+      os::close(fd);
+    }
+
+    Try<Nothing> sent = sendMessage(socket, stringify(response), vector<int>());
+    if (sent.isError()) {
+      cerr << "Failed to send response: " << sent.error() << endl;
+      return 1;
+    }
+
+    // The message might have been (partially) received, in which
+    // case the connection is out of sync.
+    if (message.isError()) {
+      cerr << "Failed to receive request: " << message.error() << endl;
+      return 1;
+    }
+  }
+#endif // __linux__
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
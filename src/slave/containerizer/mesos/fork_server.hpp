@@ -0,0 +1,113 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MESOS_CONTAINERIZER_FORK_SERVER_HPP__
+#define __MESOS_CONTAINERIZER_FORK_SERVER_HPP__
+
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <process/subprocess.hpp>
+
+#include <stout/flags.hpp>
+#include <stout/option.hpp>
+#include <stout/subcommand.hpp>
+#include <stout/try.hpp>
+
+#include "slave/flags.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// A client for a fork server, i.e., a small helper process (see
+// MesosContainerizerForkServer below) that the launchers can use to
+// fork the processes of containers. Forking a (large) slave is slow
+// since its page tables need to be copied, even with copy-on-write,
+// while the cost of forking the fork server does not depend on the
+// size of the slave. The fork server clones the children with
+// CLONE_PARENT so that they are children of the slave, i.e., the
+// slave can reap them and get their exit status as usual.
+class ForkServer
+{
+public:
+  // Starts a fork server using the 'mesos-containerizer' binary found
+  // in the launcher directory. Only supported on Linux.
+  static Try<ForkServer*> create(const Flags& flags);
+
+  // Closing the connection terminates the fork server.
+  ~ForkServer();
+
+  // Forks a child that execs the binary at 'path' like 'subprocess()'
+  // does, i.e., the child is put in a new session and inherits all
+  // file descriptors of the slave that are not close-on-exec. The
+  // child is cloned into the given 'namespaces' and, if 'sync' is
+  // specified, blocks until a byte is written to (or the write end is
+  // closed for) the pipe whose read end is 'sync'. Redirecting I/O to
+  // a pipe is not supported.
+  Try<pid_t> fork(
+      const std::string& path,
+      std::vector<std::string> argv,
+      const process::Subprocess::IO& in,
+      const process::Subprocess::IO& out,
+      const process::Subprocess::IO& err,
+      const Option<flags::FlagsBase>& flags,
+      const Option<std::map<std::string, std::string>>& environment,
+      int namespaces,
+      const Option<int>& sync);
+
+private:
+  ForkServer(int socket, const process::Subprocess& server);
+
+  ForkServer(const ForkServer&);
+  ForkServer& operator = (const ForkServer&);
+
+  const int socket;
+  const process::Subprocess server;
+};
+
+
+class MesosContainerizerForkServer : public Subcommand
+{
+public:
+  static const std::string NAME;
+
+  struct Flags : public flags::FlagsBase
+  {
+    Flags();
+
+    Option<int> socket;
+  };
+
+  MesosContainerizerForkServer() : Subcommand(NAME) {}
+
+  Flags flags;
+
+protected:
+  virtual int execute();
+  virtual flags::FlagsBase* getFlags() { return &flags; }
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MESOS_CONTAINERIZER_FORK_SERVER_HPP__
@@ -53,7 +53,13 @@ MesosContainerizerLaunch::Flags::Flags()
 
   add(&directory,
       "directory",
-      "The directory to chdir to.");
+      "The directory to chdir to. If --rootfs is specified this\n"
+      "is the directory within the root filesystem.");
+
+  add(&rootfs,
+      "rootfs",
+      "The root filesystem to chroot to (after running the\n"
+      "preparation commands).");
 
   add(&user,
       "user",
@@ -197,6 +203,18 @@ int MesosContainerizerLaunch::execute()
     }
   }
 
+  // Change the root filesystem if provided. Note that we do that
+  // after executing the preparation commands so that those commands
+  // are run in the filesystem of the slave.
+  if (flags.rootfs.isSome()) {
+    Try<Nothing> chroot = os::chroot(flags.rootfs.get());
+    if (chroot.isError()) {
+      cerr << "Failed to chroot into '" << flags.rootfs.get() << "': "
+           << chroot.error() << endl;
+      return 1;
+    }
+  }
+
   // Enter working directory.
   Try<Nothing> chdir = os::chdir(flags.directory.get());
   if (chdir.isError()) {
@@ -19,6 +19,7 @@
 #include <stout/none.hpp>
 #include <stout/subcommand.hpp>
 
+#include "slave/containerizer/mesos/fork_server.hpp"
 #include "slave/containerizer/mesos/launch.hpp"
 
 using namespace mesos::internal::slave;
@@ -30,5 +31,6 @@ int main(int argc, char** argv)
       None(),
       argc,
       argv,
-      new MesosContainerizerLaunch());
+      new MesosContainerizerLaunch(),
+      new MesosContainerizerForkServer());
 }
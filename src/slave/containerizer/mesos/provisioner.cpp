@@ -0,0 +1,485 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/mount.h>
+
+#include <list>
+#include <vector>
+
+#include <process/collect.hpp>
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/io.hpp>
+#include <process/process.hpp>
+#include <process/subprocess.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include <stout/os/rename.hpp>
+
+#include "linux/fs.hpp"
+
+#include "slave/containerizer/mesos/provisioner.hpp"
+
+using std::list;
+using std::string;
+using std::vector;
+
+using namespace process;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+const char PROVISIONER_SANDBOX_DIRECTORY[] = "/mnt/mesos/sandbox";
+
+
+#ifndef MNT_DETACH
+#define MNT_DETACH 2
+#endif
+
+
+class ProvisionerProcess : public Process<ProvisionerProcess>
+{
+public:
+  explicit ProvisionerProcess(const string& _root) : root(_root) {}
+
+  virtual ~ProvisionerProcess() {}
+
+  Future<Nothing> recover(const hashset<ContainerID>& known);
+
+  Future<string> provision(
+      const ContainerID& containerId,
+      const ContainerInfo::MesosInfo& info,
+      const string& directory);
+
+  Future<Nothing> destroy(const ContainerID& containerId);
+
+private:
+  // Continues 'provision()' once all layers are unpacked.
+  Future<string> _provision(
+      const ContainerID& containerId,
+      const vector<string>& digests,
+      const string& directory);
+
+  // Unpacks the layer into the cache unless it's already cached (or
+  // being unpacked for another container).
+  Future<Nothing> unpack(
+      const ContainerInfo::MesosInfo::Layer& layer,
+      const string& digest);
+
+  // Continues 'unpack()' once the checksum of the layer is computed.
+  Future<Nothing> _unpack(
+      const ContainerInfo::MesosInfo::Layer& layer,
+      const string& digest,
+      const string& staging,
+      const string& output);
+
+  // Continues '_unpack()' once the layer is extracted into the
+  // staging directory, which is then moved into the cache.
+  Future<Nothing> __unpack(
+      const string& digest,
+      const string& staging,
+      const Option<int>& status);
+
+  void unpacked(const string& digest, const string& staging);
+
+  string layer(const string& digest) const
+  {
+    return path::join(root, "layers", digest);
+  }
+
+  string container(const ContainerID& containerId) const
+  {
+    return path::join(root, "containers", containerId.value());
+  }
+
+  const string root;
+
+  // The layers which are currently being unpacked, keyed by digest,
+  // so that concurrent provisions of the same layer unpack it once.
+  hashmap<string, Future<Nothing>> unpacking;
+};
+
+
+Try<string> Provisioner::digest(const ContainerInfo::MesosInfo::Layer& layer)
+{
+  // NOTE: The digest is used as the name of the directory of the
+  // layer in the cache as well as within the (':' separated) options
+  // of the overlay mount, hence we only accept hex digests.
+  if (!strings::startsWith(layer.digest(), "sha256:")) {
+    return Error("Unsupported digest '" + layer.digest() + "'");
+  }
+
+  const string digest =
+    strings::lower(strings::remove(layer.digest(), "sha256:", strings::PREFIX));
+
+  if (digest.size() != 64 ||
+      digest.find_first_not_of("0123456789abcdef") != string::npos) {
+    return Error("Invalid digest '" + layer.digest() + "'");
+  }
+
+  return digest;
+}
+
+
+Provisioner::Provisioner(const Flags& flags)
+{
+  process = Owned<ProvisionerProcess>(new ProvisionerProcess(
+      flags.provisioner_dir.get(path::join(flags.work_dir, "provisioner"))));
+
+  spawn(process.get());
+}
+
+
+Provisioner::~Provisioner()
+{
+  terminate(process.get());
+  wait(process.get());
+}
+
+
+Future<Nothing> Provisioner::recover(const hashset<ContainerID>& known)
+{
+  return dispatch(process.get(), &ProvisionerProcess::recover, known);
+}
+
+
+Future<string> Provisioner::provision(
+    const ContainerID& containerId,
+    const ContainerInfo::MesosInfo& info,
+    const string& directory)
+{
+  return dispatch(process.get(),
+                  &ProvisionerProcess::provision,
+                  containerId,
+                  info,
+                  directory);
+}
+
+
+Future<Nothing> Provisioner::destroy(const ContainerID& containerId)
+{
+  return dispatch(process.get(), &ProvisionerProcess::destroy, containerId);
+}
+
+
+Future<Nothing> ProvisionerProcess::recover(const hashset<ContainerID>& known)
+{
+  const string containers = path::join(root, "containers");
+
+  if (!os::exists(containers)) {
+    return Nothing();
+  }
+
+  Try<list<string>> entries = os::ls(containers);
+  if (entries.isError()) {
+    return Failure(
+        "Failed to list '" + containers + "': " + entries.error());
+  }
+
+  list<Future<Nothing>> futures;
+  foreach (const string& entry, entries.get()) {
+    ContainerID containerId;
+    containerId.set_value(entry);
+
+    if (!known.contains(containerId)) {
+      LOG(INFO) << "Removing the root filesystem of unknown container "
+                << containerId;
+
+      futures.push_back(destroy(containerId));
+    }
+  }
+
+  return collect(futures)
+    .then([]() { return Nothing(); });
+}
+
+
+Future<string> ProvisionerProcess::provision(
+    const ContainerID& containerId,
+    const ContainerInfo::MesosInfo& info,
+    const string& directory)
+{
+  if (info.layers_size() == 0) {
+    return Failure("No layers to provision from");
+  }
+
+  vector<string> digests;
+  list<Future<Nothing>> futures;
+
+  foreach (const ContainerInfo::MesosInfo::Layer& layer, info.layers()) {
+    Try<string> digest = Provisioner::digest(layer);
+    if (digest.isError()) {
+      return Failure(digest.error());
+    }
+
+    digests.push_back(digest.get());
+    futures.push_back(unpack(layer, digest.get()));
+  }
+
+  return collect(futures)
+    .then(defer(self(),
+                &Self::_provision,
+                containerId,
+                digests,
+                directory));
+}
+
+
+Future<string> ProvisionerProcess::_provision(
+    const ContainerID& containerId,
+    const vector<string>& digests,
+    const string& directory)
+{
+  const string upper = path::join(container(containerId), "upper");
+  const string work = path::join(container(containerId), "work");
+  const string rootfs = path::join(container(containerId), "rootfs");
+
+  foreach (const string& dir, vector<string>({upper, work, rootfs})) {
+    Try<Nothing> mkdir = os::mkdir(dir);
+    if (mkdir.isError()) {
+      return Failure(
+          "Failed to create directory '" + dir + "': " + mkdir.error());
+    }
+  }
+
+  // Overlayfs expects the lower directories from the top to the
+  // bottom, i.e., in the reverse order of the layers.
+  vector<string> lower;
+  foreach (const string& digest, digests) {
+    lower.insert(lower.begin(), layer(digest));
+  }
+
+  const string options =
+    "lowerdir=" + strings::join(":", lower) +
+    ",upperdir=" + upper +
+    ",workdir=" + work;
+
+  Try<Nothing> mount =
+    fs::mount("overlay", rootfs, "overlay", 0, options.c_str());
+
+  if (mount.isError()) {
+    return Failure(
+        "Failed to mount the root filesystem of container " +
+        stringify(containerId) + ": " + mount.error());
+  }
+
+  // NOTE: The mount point of the sandbox is created in the upper
+  // directory, i.e., the cached layers stay untouched.
+  const string sandbox = path::join(rootfs, PROVISIONER_SANDBOX_DIRECTORY);
+
+  Try<Nothing> mkdir = os::mkdir(sandbox);
+  if (mkdir.isError()) {
+    return Failure(
+        "Failed to create the sandbox mount point '" + sandbox + "': " +
+        mkdir.error());
+  }
+
+  mount = fs::mount(directory, sandbox, None(), MS_BIND, NULL);
+  if (mount.isError()) {
+    return Failure(
+        "Failed to mount the sandbox of container " +
+        stringify(containerId) + ": " + mount.error());
+  }
+
+  LOG(INFO) << "Provisioned the root filesystem of container "
+            << containerId << " at '" << rootfs << "' from "
+            << digests.size() << " layer(s)";
+
+  return rootfs;
+}
+
+
+Future<Nothing> ProvisionerProcess::destroy(const ContainerID& containerId)
+{
+  const string rootfs = path::join(container(containerId), "rootfs");
+
+  if (!os::exists(container(containerId))) {
+    return Nothing();
+  }
+
+  Try<fs::MountInfoTable> table = fs::MountInfoTable::read();
+  if (table.isError()) {
+    return Failure("Failed to read the mount table: " + table.error());
+  }
+
+  // Unmount the sandbox (and anything else mounted below the root
+  // filesystem) before the root filesystem itself, i.e., in the
+  // reverse order of the mounts.
+  for (auto it = table.get().entries.rbegin();
+       it != table.get().entries.rend();
+       ++it) {
+    const fs::MountInfoTable::Entry& entry = *it;
+
+    if (entry.target == rootfs ||
+        strings::startsWith(entry.target, rootfs + "/")) {
+      // Do a lazy unmount in case a process (e.g., one that escaped
+      // the container) still holds a reference to the mount.
+      Try<Nothing> unmount = fs::unmount(entry.target, MNT_DETACH);
+      if (unmount.isError()) {
+        return Failure(
+            "Failed to unmount '" + entry.target + "': " + unmount.error());
+      }
+    }
+  }
+
+  Try<Nothing> rmdir = os::rmdir(container(containerId));
+  if (rmdir.isError()) {
+    return Failure(
+        "Failed to remove the root filesystem of container " +
+        stringify(containerId) + ": " + rmdir.error());
+  }
+
+  return Nothing();
+}
+
+
+Future<Nothing> ProvisionerProcess::unpack(
+    const ContainerInfo::MesosInfo::Layer& layer,
+    const string& digest)
+{
+  if (os::exists(this->layer(digest))) {
+    return Nothing();
+  }
+
+  if (unpacking.contains(digest)) {
+    return unpacking[digest];
+  }
+
+  LOG(INFO) << "Unpacking layer '" << layer.path() << "' into the cache";
+
+  // Extract into a staging directory which is only moved into the
+  // cache once the extraction succeeded, so that a layer in the cache
+  // is always complete (even if the slave fails while unpacking).
+  const string staging = this->layer(digest) + ".partial";
+
+  if (os::exists(staging)) {
+    Try<Nothing> rmdir = os::rmdir(staging);
+    if (rmdir.isError()) {
+      return Failure(
+          "Failed to remove '" + staging + "': " + rmdir.error());
+    }
+  }
+
+  Try<Nothing> mkdir = os::mkdir(staging);
+  if (mkdir.isError()) {
+    return Failure(
+        "Failed to create '" + staging + "': " + mkdir.error());
+  }
+
+  // Verify the layer before unpacking it, the cache is keyed by the
+  // digest so a corrupt layer would be used by all future containers.
+  Try<Subprocess> sha256sum = subprocess(
+      "sha256sum",
+      vector<string>({"sha256sum", layer.path()}),
+      Subprocess::PATH("/dev/null"),
+      Subprocess::PIPE(),
+      Subprocess::FD(STDERR_FILENO));
+
+  if (sha256sum.isError()) {
+    return Failure(
+        "Failed to compute the checksum of layer '" + layer.path() + "': " +
+        sha256sum.error());
+  }
+
+  Future<Nothing> future = io::read(sha256sum.get().out().get())
+    .then(defer(self(), &Self::_unpack, layer, digest, staging, lambda::_1));
+
+  unpacking[digest] = future;
+
+  future.onAny(defer(self(), &Self::unpacked, digest, staging));
+
+  return future;
+}
+
+
+Future<Nothing> ProvisionerProcess::_unpack(
+    const ContainerInfo::MesosInfo::Layer& layer,
+    const string& digest,
+    const string& staging,
+    const string& output)
+{
+  const vector<string> tokens = strings::tokenize(output, " ");
+
+  if (tokens.empty() || tokens[0] != digest) {
+    return Failure(
+        "Checksum mismatch of layer '" + layer.path() + "': expected " +
+        digest + " but got " + (tokens.empty() ? "nothing" : tokens[0]));
+  }
+
+  Try<Subprocess> tar = subprocess(
+      "tar",
+      vector<string>({"tar", "-C", staging, "-xf", layer.path()}),
+      Subprocess::PATH("/dev/null"),
+      Subprocess::FD(STDOUT_FILENO),
+      Subprocess::FD(STDERR_FILENO));
+
+  if (tar.isError()) {
+    return Failure(
+        "Failed to extract layer '" + layer.path() + "': " + tar.error());
+  }
+
+  return tar.get().status()
+    .then(defer(self(), &Self::__unpack, digest, staging, lambda::_1));
+}
+
+
+Future<Nothing> ProvisionerProcess::__unpack(
+    const string& digest,
+    const string& staging,
+    const Option<int>& status)
+{
+  if (status.isNone()) {
+    return Failure("Failed to reap the extraction of layer " + digest);
+  } else if (status.get() != 0) {
+    return Failure(
+        "Failed to extract layer " + digest + ": tar exited with status " +
+        stringify(WEXITSTATUS(status.get())));
+  }
+
+  Try<Nothing> rename = os::rename(staging, layer(digest));
+  if (rename.isError()) {
+    return Failure(
+        "Failed to move layer " + digest + " into the cache: " +
+        rename.error());
+  }
+
+  LOG(INFO) << "Unpacked layer " << digest << " into the cache";
+
+  return Nothing();
+}
+
+
+void ProvisionerProcess::unpacked(const string& digest, const string& staging)
+{
+  unpacking.erase(digest);
+
+  if (os::exists(staging)) {
+    os::rmdir(staging);
+  }
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,103 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MESOS_CONTAINERIZER_PROVISIONER_HPP__
+#define __MESOS_CONTAINERIZER_PROVISIONER_HPP__
+
+#include <string>
+
+#include <mesos/mesos.hpp>
+#include <mesos/type_utils.hpp>
+
+#include <process/future.hpp>
+#include <process/owned.hpp>
+
+#include <stout/hashset.hpp>
+#include <stout/nothing.hpp>
+#include <stout/try.hpp>
+
+#include "slave/flags.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// The path within the root filesystem of a provisioned container to
+// which the container's sandbox is bind mounted.
+extern const char PROVISIONER_SANDBOX_DIRECTORY[];
+
+// Forward declaration.
+class ProvisionerProcess;
+
+// Provisions the root filesystems of containers from image layers
+// (see ContainerInfo::MesosInfo). Each layer is unpacked only once
+// into a cache that is keyed by the digest of the layer, after which
+// the root filesystem of a container is assembled by mounting an
+// overlay filesystem of the cached layers, i.e., without copying
+// anything. The writes of a container go to a per container upper
+// directory which is removed when the container is destroyed.
+//
+// The layout of the provisioner directory is:
+//
+//   <provisioner_dir>/layers/<digest>          Unpacked layers.
+//   <provisioner_dir>/containers/<id>/upper    Writes of the container.
+//   <provisioner_dir>/containers/<id>/work     Used by overlayfs.
+//   <provisioner_dir>/containers/<id>/rootfs   The root filesystem.
+class Provisioner
+{
+public:
+  // Returns the hex encoded SHA-256 of the layer's tarball from the
+  // digest of the layer (i.e., 'sha256:<hex>'), or an error if the
+  // digest is not valid.
+  static Try<std::string> digest(
+      const ContainerInfo::MesosInfo::Layer& layer);
+
+  explicit Provisioner(const Flags& flags);
+
+  virtual ~Provisioner();
+
+  // Removes the root filesystems of all containers which are not
+  // known (i.e., neither recovered nor orphans which are destroyed
+  // separately), e.g., because the slave failed while provisioning.
+  process::Future<Nothing> recover(const hashset<ContainerID>& known);
+
+  // Returns the path to the root filesystem of the container once
+  // all of its layers are unpacked and the filesystem is mounted.
+  // The sandbox 'directory' is bind mounted into the root filesystem
+  // at PROVISIONER_SANDBOX_DIRECTORY.
+  process::Future<std::string> provision(
+      const ContainerID& containerId,
+      const ContainerInfo::MesosInfo& info,
+      const std::string& directory);
+
+  // Unmounts and removes the root filesystem of the container, if
+  // any. The cached layers are kept for future containers.
+  process::Future<Nothing> destroy(const ContainerID& containerId);
+
+private:
+  Provisioner(const Provisioner&);
+  Provisioner& operator = (const Provisioner&);
+
+  process::Owned<ProvisionerProcess> process;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MESOS_CONTAINERIZER_PROVISIONER_HPP__
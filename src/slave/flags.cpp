@@ -47,7 +47,9 @@ mesos::internal::slave::Flags::Flags()
   add(&Flags::isolation,
       "isolation",
       "Isolation mechanisms to use, e.g., 'posix/cpu,posix/mem', or\n"
-      "'cgroups/cpu,cgroups/mem', or network/port_mapping\n"
+      "'cgroups/cpu,cgroups/mem' (optionally with 'cgroups/cpuset' to\n"
+      "pin containers to cores and NUMA nodes and 'cgroups/blkio' to\n"
+      "isolate disk I/O), or network/port_mapping\n"
       "(configure with flag: --with-network-isolator to enable),\n"
       "or 'external', or load an alternate isolator module using\n"
       "the --modules flag. Note that this flag is only relevant\n"
@@ -85,6 +87,34 @@ mesos::internal::slave::Flags::Flags()
       "(one subdirectory per slave).",
       "/tmp/mesos/fetch");
 
+  add(&Flags::fetcher_concurrent_downloads,
+      "fetcher_concurrent_downloads",
+      "Maximum number of URIs of a task that the fetcher downloads\n"
+      "concurrently.",
+      4);
+
+  add(&Flags::fetcher_peers,
+      "fetcher_peers",
+      "Comma separated list of peer slaves ('host:port') that the fetcher\n"
+      "asks for URIs with a checksum before downloading them into the\n"
+      "cache from their origin. Peers need --fetcher_serve_peers.\n"
+      "A peer can also be given as the URL of its fetcher cache endpoint.");
+
+  add(&Flags::fetcher_serve_peers,
+      "fetcher_serve_peers",
+      "Whether to serve completely downloaded fetcher cache files with a\n"
+      "checksum to peer slaves (see --fetcher_peers).",
+      false);
+
+  add(&Flags::fetcher_cache_links,
+      "fetcher_cache_links",
+      "Whether to hard link, rather than copy, fetcher cache files that are\n"
+      "not extracted into sandboxes. The linked files are made read-only\n"
+      "since they are shared with the cache and with other sandboxes.\n"
+      "Files are still copied if the cache directory and the sandbox are\n"
+      "on different file systems.",
+      false);
+
   add(&Flags::work_dir,
       "work_dir",
       "Directory path to place framework work directories\n", "/tmp/mesos");
@@ -94,6 +124,20 @@ mesos::internal::slave::Flags::Flags()
       "Directory path of Mesos binaries",
       PKGLIBEXECDIR);
 
+  add(&Flags::launcher_fork_server,
+      "launcher_fork_server",
+      "Whether to fork the processes of containers from a small helper\n"
+      "process started by the slave (Linux only), rather than from the\n"
+      "slave itself, which gets slower as the slave grows.",
+      false);
+
+  add(&Flags::provisioner_dir,
+      "provisioner_dir",
+      "Directory in which the mesos containerizer caches the unpacked\n"
+      "image layers and assembles the root filesystems of containers\n"
+      "with image layers (Linux only, requires overlayfs).\n"
+      "(default: [work_dir]/provisioner)");
+
   add(&Flags::hadoop_home,
       "hadoop_home",
       "Path to find Hadoop installed (for\n"
@@ -137,6 +181,14 @@ mesos::internal::slave::Flags::Flags()
       "to shut down (e.g., 60secs, 3mins, etc)",
       EXECUTOR_SHUTDOWN_GRACE_PERIOD);
 
+  add(&Flags::command_executor_idle_timeout,
+      "command_executor_idle_timeout",
+      "If set, command executors keep running for this long after their\n"
+      "task terminated (e.g., 30secs). A subsequent command task of the\n"
+      "same framework with the same URIs, environment, user and container\n"
+      "runs in the container of an idle command executor rather than in\n"
+      "a newly launched one.");
+
   add(&Flags::gc_delay,
       "gc_delay",
       "Maximum amount of time to wait before cleaning up\n"
@@ -154,6 +206,25 @@ mesos::internal::slave::Flags::Flags()
       "be a value between 0.0 and 1.0",
       GC_DISK_HEADROOM);
 
+  add(&Flags::gc_bytes_per_sec,
+      "gc_bytes_per_sec",
+      "The maximum rate at which the garbage collector deletes data, in\n"
+      "Bytes/s, to limit the disk I/O it takes away from running tasks.\n"
+      "If not specified or zero, deletion is not throttled.");
+
+  add(&Flags::gc_inodes_per_sec,
+      "gc_inodes_per_sec",
+      "The maximum number of files and directories the garbage collector\n"
+      "deletes per second. If not specified or zero, deletion is not\n"
+      "throttled.");
+
+  add(&Flags::gc_idle_io_priority,
+      "gc_idle_io_priority",
+      "Whether the garbage collector deletes data with the idle I/O\n"
+      "scheduling class, i.e., only when no one else uses the disk\n"
+      "(Linux only).",
+      false);
+
   add(&Flags::disk_watch_interval,
       "disk_watch_interval",
       "Periodic time interval (e.g., 10secs, 2mins, etc)\n"
@@ -165,9 +236,20 @@ mesos::internal::slave::Flags::Flags()
   add(&Flags::resource_monitoring_interval,
       "resource_monitoring_interval",
       "Periodic time interval for monitoring executor\n"
-      "resource usage (e.g., 10secs, 1min, etc)",
+      "resource usage (e.g., 10secs, 1min, etc). Used to\n"
+      "sample the usage history (see --resource_monitoring_window)\n"
+      "and for '/monitor/stream.json' subscriptions.",
       RESOURCE_MONITORING_INTERVAL);
 
+  add(&Flags::resource_monitoring_window,
+      "resource_monitoring_window",
+      "Length of the history of executor resource usage kept by\n"
+      "the slave (e.g., 5mins), sampled every\n"
+      "--resource_monitoring_interval. Windowed rates and\n"
+      "percentiles are exported through '/monitor/history.json'.\n"
+      "The history is disabled if zero.",
+      Seconds(0));
+
   add(&Flags::recover,
       "recover",
       "Whether to recover status updates and reconnect with old executors.\n"
@@ -194,6 +276,43 @@ mesos::internal::slave::Flags::Flags()
       "state as possible is recovered.\n",
       true);
 
+  add(&Flags::recovery_workers,
+      "recovery_workers",
+      "Number of threads the slave uses to read the checkpointed state\n"
+      "of the executors of a framework during recovery.",
+      4);
+
+  add(&Flags::checkpoint_store,
+      "checkpoint_store",
+      "Where the slave keeps the checkpoints of the slave, frameworks,\n"
+      "executors and tasks in its meta directory (the status updates\n"
+      "are always appended to files):\n"
+      "directory: One file per checkpoint.\n"
+      "leveldb  : A leveldb store in the meta directory. The checkpoint\n"
+      "           files of a previous run are migrated into the store.\n"
+      "Switching back to 'directory' migrates the checkpoints in the\n"
+      "store back to files.",
+      "directory");
+
+  add(&Flags::status_update_batch_size,
+      "status_update_batch_size",
+      "Maximum number of status updates the slave forwards to the master\n"
+      "in a single message. Updates are only batched when more of them\n"
+      "are queued for the slave, so this adds no latency when the slave\n"
+      "is not under load. A value of 1 disables batching, which is\n"
+      "required if the master does not support batched status updates.",
+      1);
+
+  add(&Flags::executor_status_update_batch_size,
+      "executor_status_update_batch_size",
+      "Maximum number of status updates an executor sends to the slave\n"
+      "in a single message. As with '--status_update_batch_size', updates\n"
+      "are only batched when more of them are queued for the executor.\n"
+      "A batched non-terminal update that is superseded by a later update\n"
+      "for the same task is not sent at all. A value of 1 disables\n"
+      "batching.",
+      1);
+
 #ifdef __linux__
   add(&Flags::cgroups_hierarchy,
       "cgroups_hierarchy",
@@ -217,12 +336,32 @@ mesos::internal::slave::Flags::Flags()
       "swap instead of just memory.\n",
       false);
 
+  add(&Flags::cgroups_memory_pressure_reaction,
+      "cgroups_memory_pressure_reaction",
+      "Cgroups feature flag to react to the memory pressure of a container\n"
+      "rather than leaving it to the kernel OOM killer. On medium pressure\n"
+      "the soft limit of the container is lowered to its anonymous memory\n"
+      "(until its resources are updated) so that its page cache is\n"
+      "reclaimed first. On critical pressure the container is reported as\n"
+      "having exceeded its memory limit (and destroyed) before it is\n"
+      "killed by the OOM killer.\n",
+      false);
+
   add(&Flags::cgroups_cpu_enable_pids_and_tids_count,
       "cgroups_cpu_enable_pids_and_tids_count",
       "Cgroups feature flag to enable counting of processes and threads\n"
       "inside a container.\n",
       false);
 
+  add(&Flags::cgroups_usage_interval,
+      "cgroups_usage_interval",
+      "Minimum interval between two reads of the cgroup statistics of a\n"
+      "container by the cgroups isolators. Usage requests within the\n"
+      "interval (e.g., from the resource monitor and the\n"
+      "'/monitor/statistics.json' endpoint) are served the last read.\n"
+      "The default of zero reads the statistics for every request.",
+      Seconds(0));
+
   add(&Flags::slave_subsystems,
       "slave_subsystems",
       "List of comma-separated cgroup subsystems to run the slave binary\n"
@@ -255,6 +394,16 @@ mesos::internal::slave::Flags::Flags()
       "that the perf_interval.",
       Seconds(10));
 
+  add(&Flags::perf_counters,
+      "perf_counters",
+      "Whether to count the perf events of each container continuously\n"
+      "with counters opened by perf_event_open(2), read every\n"
+      "perf_interval, instead of running 'perf stat' for perf_duration\n"
+      "every perf_interval. Each sample then covers the whole interval.\n"
+      "Only generic hardware, software and hardware cache events can be\n"
+      "counted this way.",
+      false);
+
   add(&Flags::revocable_cpu_low_priority,
       "revocable_cpu_low_priority",
       "Run containers with revocable CPU at a lower priority than\n"
@@ -283,6 +432,14 @@ mesos::internal::slave::Flags::Flags()
       "The path to the external containerizer executable used when\n"
       "external isolation is activated (--isolation=external).");
 
+  add(&Flags::containerizer_daemon,
+      "containerizer_daemon",
+      "Whether the external containerizer is run as a long lived daemon\n"
+      "(invoked with the 'daemon' command) that answers the usage\n"
+      "requests, rather than being invoked for every usage request.\n"
+      "See docs/external-containerizer.md for the protocol.",
+      false);
+
   add(&Flags::containerizers,
       "containerizers",
       "Comma separated list of containerizer implementations\n"
@@ -343,6 +500,21 @@ mesos::internal::slave::Flags::Flags()
       "path used by the slave's docker image.\n",
       "/var/run/docker.sock");
 
+  add(&Flags::docker_remote_api,
+      "docker_remote_api",
+      "Whether the docker containerizer should inspect, list, stop and\n"
+      "remove containers through the remote API of the docker daemon\n"
+      "listening on --docker_socket, over a persistent connection, rather\n"
+      "than by running the docker CLI.",
+      false);
+
+  add(&Flags::docker_max_concurrent_pulls,
+      "docker_max_concurrent_pulls",
+      "The maximum number of images the docker containerizer pulls at\n"
+      "once, where concurrent pulls of the same image are done only once.\n"
+      "0 means unlimited.",
+      4);
+
   add(&Flags::default_container_info,
       "default_container_info",
       "JSON formatted ContainerInfo that will be included into\n"
@@ -418,6 +590,17 @@ mesos::internal::slave::Flags::Flags()
       "isolator.",
       false);
 
+  add(&Flags::network_socket_statistics_interval,
+      "network_socket_statistics_interval",
+      "The minimum interval between retrievals of the socket statistics\n"
+      "of a container, which requires forking a helper that enters the\n"
+      "network namespace of the container. Usage requests within the\n"
+      "interval report the last retrieved socket statistics (the link\n"
+      "statistics are always current). Concurrent usage requests always\n"
+      "share a single retrieval. This flag is used for the\n"
+      "'network/port_mapping' isolator.",
+      Seconds(0));
+
 #endif // WITH_NETWORK_ISOLATOR
 
   add(&Flags::container_disk_watch_interval,
@@ -426,6 +609,15 @@ mesos::internal::slave::Flags::Flags()
       "used for the 'posix/disk' isolator.",
       Seconds(15));
 
+  add(&Flags::container_disk_usage_collector,
+      "container_disk_usage_collector",
+      "How the 'posix/disk' isolator collects the disk usage of container\n"
+      "sandboxes: 'du' runs 'du' on one sandbox per watch interval; 'xfs'\n"
+      "tags each sandbox with an XFS project ID and reads the usage of all\n"
+      "sandboxes from the project quotas each interval. The latter needs\n"
+      "the work directory on XFS mounted with 'prjquota' (Linux only).",
+      "du");
+
   // TODO(jieyu): Consider enabling this flag by default. Remember
   // to update the user doc if we decide to do so.
   add(&Flags::enforce_container_disk_quota,
@@ -434,6 +626,33 @@ mesos::internal::slave::Flags::Flags()
       "is used for the 'posix/disk' isolator.",
       false);
 
+  add(&Flags::container_logs_max_size,
+      "container_logs_max_size",
+      "The size (e.g., 100MB) at which the 'stdout' and 'stderr' files in\n"
+      "the sandboxes of running executors are rotated. The files are\n"
+      "checked every --container_logs_rotation_interval. If not set, the\n"
+      "files are not rotated and grow until the sandbox is garbage\n"
+      "collected.");
+
+  add(&Flags::container_logs_max_backups,
+      "container_logs_max_backups",
+      "The number of rotated segments (e.g., 'stdout.1', 'stdout.2') of\n"
+      "a container log that are kept. The oldest segment is deleted when\n"
+      "a log is rotated once there are this many.",
+      5);
+
+  add(&Flags::container_logs_compress,
+      "container_logs_compress",
+      "Whether rotated container log segments are compressed with gzip\n"
+      "(e.g., 'stdout.1.gz').",
+      false);
+
+  add(&Flags::container_logs_rotation_interval,
+      "container_logs_rotation_interval",
+      "The interval at which container logs are checked for rotation\n"
+      "(see --container_logs_max_size).",
+      Seconds(30));
+
   // This help message for --modules flag is the same for
   // {master,slave,tests}/flags.hpp and should always be kept in
   // sync.
@@ -497,7 +716,11 @@ mesos::internal::slave::Flags::Flags()
 
   add(&Flags::resource_estimator,
       "resource_estimator",
-      "The name of the resource estimator to use for oversubscription.");
+      "The name of the resource estimator to use for oversubscription.\n"
+      "If not set, no resources are oversubscribed. Set to 'usage' to\n"
+      "oversubscribe the cpus and memory that executors were allocated\n"
+      "but have not used (measured by the 95th percentile of their usage\n"
+      "over the last 5 minutes).");
 
   add(&Flags::oversubscribed_resources_interval,
       "oversubscribed_resources_interval",
@@ -505,4 +728,20 @@ mesos::internal::slave::Flags::Flags()
       "about the total amount of oversubscribed resources that are allocated\n"
       "and available. The interval between updates is controlled by this flag.",
       Seconds(15));
+
+  add(&Flags::qos_controller,
+      "qos_controller",
+      "The name of the QoS Controller to use for oversubscription.\n"
+      "If not set, no corrections are made. Set to 'interference' to kill\n"
+      "revocable executors when the cycles per instruction of a\n"
+      "non-revocable executor indicate interference (requires the\n"
+      "'cgroups/perf_event' isolator).");
+
+  add(&Flags::qos_correction_interval_min,
+      "qos_correction_interval_min",
+      "The slave polls and carries out QoS corrections from the QoS\n"
+      "Controller based on its observed performance of running tasks.\n"
+      "The smallest interval between these corrections is controlled by\n"
+      "this flag.",
+      Seconds(0));
 }
@@ -46,40 +46,57 @@ public:
   Option<std::string> attributes;
   Bytes fetcher_cache_size;
   std::string fetcher_cache_dir;
+  size_t fetcher_concurrent_downloads;
+  Option<std::string> fetcher_peers;
+  bool fetcher_serve_peers;
+  bool fetcher_cache_links;
   std::string work_dir;
   std::string launcher_dir;
+  bool launcher_fork_server;
+  Option<std::string> provisioner_dir;
   std::string hadoop_home; // TODO(benh): Make an Option.
   bool switch_user;
   std::string frameworks_home;  // TODO(benh): Make an Option.
   Duration registration_backoff_factor;
   Duration executor_registration_timeout;
   Duration executor_shutdown_grace_period;
+  Option<Duration> command_executor_idle_timeout;
   Duration gc_delay;
   double gc_disk_headroom;
+  Option<Bytes> gc_bytes_per_sec;
+  Option<size_t> gc_inodes_per_sec;
+  bool gc_idle_io_priority;
   Duration disk_watch_interval;
 
-  // TODO(nnielsen): Deprecate resource_monitoring_interval flag after
-  // Mesos 0.23.0.
   Duration resource_monitoring_interval;
+  Duration resource_monitoring_window;
 
   std::string recover;
   Duration recovery_timeout;
   bool strict;
+  size_t recovery_workers;
+  std::string checkpoint_store;
+  size_t status_update_batch_size;
+  size_t executor_status_update_batch_size;
   Duration register_retry_interval_min;
 #ifdef __linux__
   std::string cgroups_hierarchy;
   std::string cgroups_root;
   bool cgroups_enable_cfs;
   bool cgroups_limit_swap;
+  bool cgroups_memory_pressure_reaction;
   bool cgroups_cpu_enable_pids_and_tids_count;
+  Duration cgroups_usage_interval;
   Option<std::string> slave_subsystems;
   Option<std::string> perf_events;
   Duration perf_interval;
   Duration perf_duration;
+  bool perf_counters;
   bool revocable_cpu_low_priority;
 #endif
   Option<Path> credential;
   Option<std::string> containerizer_path;
+  bool containerizer_daemon;
   std::string containerizers;
   Option<std::string> default_container_image;
   std::string docker;
@@ -90,6 +107,8 @@ public:
   Duration docker_stop_timeout;
   bool docker_kill_orphans;
   std::string docker_socket;
+  bool docker_remote_api;
+  size_t docker_max_concurrent_pulls;
 #ifdef WITH_NETWORK_ISOLATOR
   uint16_t ephemeral_ports_per_container;
   Option<std::string> eth0_name;
@@ -98,14 +117,22 @@ public:
   bool egress_unique_flow_per_container;
   bool network_enable_socket_statistics_summary;
   bool network_enable_socket_statistics_details;
+  Duration network_socket_statistics_interval;
 #endif
   Duration container_disk_watch_interval;
+  std::string container_disk_usage_collector;
   bool enforce_container_disk_quota;
+  Option<Bytes> container_logs_max_size;
+  size_t container_logs_max_backups;
+  bool container_logs_compress;
+  Duration container_logs_rotation_interval;
   Option<Modules> modules;
   std::string authenticatee;
   Option<std::string> hooks;
   Option<std::string> resource_estimator;
   Duration oversubscribed_resources_interval;
+  Option<std::string> qos_controller;
+  Duration qos_correction_interval_min;
 };
 
 } // namespace slave {
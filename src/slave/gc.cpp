@@ -16,22 +16,34 @@
  * limitations under the License.
  */
 
+#include <fts.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif // __linux__
+
+#include <deque>
 #include <list>
 
+#include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
+#include <process/id.hpp>
 
+#include <stout/error.hpp>
 #include <stout/foreach.hpp>
 #include <stout/os.hpp>
 
 #include "logging/logging.hpp"
 
 #include "slave/gc.hpp"
+#include "slave/store.hpp"
 
 using namespace process;
 
 using process::wait; // Necessary on some OS's to disambiguate.
 
+using std::deque;
 using std::list;
 using std::map;
 using std::string;
@@ -40,12 +52,282 @@ namespace mesos {
 namespace internal {
 namespace slave {
 
+// The remover deletes at most this many entries before it yields to
+// other dispatches, and spreads its rate limits over intervals of
+// this length.
+static const size_t REMOVAL_BATCH_SIZE = 1000;
+static const Duration REMOVAL_INTERVAL = Milliseconds(100);
+
+
+#ifdef __linux__
+// See ioprio_set(2); glibc does not provide these.
+static const int IOPRIO_WHO_PROCESS = 1;
+static const int IOPRIO_CLASS_SHIFT = 13;
+static const int IOPRIO_CLASS_IDLE = 3;
+#endif // __linux__
+
+
+// Sets the I/O priority of the calling thread and returns the
+// previous one.
+static Try<int> ioprio(int priority)
+{
+#ifdef __linux__
+  int previous = ::syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0);
+  if (previous < 0) {
+    return ErrnoError("Failed to get the I/O priority");
+  }
+
+  if (::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, priority) < 0) {
+    return ErrnoError("Failed to set the I/O priority");
+  }
+
+  return previous;
+#else
+  return Error("I/O priorities are only supported on Linux");
+#endif // __linux__
+}
+
+
+// Removes paths one after the other, the way 'os::rmdir' does, but
+// in batches of entries so that it neither blocks for long nor
+// exceeds the configured rate limits.
+class RemoverProcess : public Process<RemoverProcess>
+{
+public:
+  RemoverProcess(
+      const Option<Bytes>& _bytesPerSec,
+      const Option<size_t>& _inodesPerSec,
+      bool _idleIOPriority)
+    : ProcessBase(process::ID::generate("gc-remover")),
+      bytesPerSec(_bytesPerSec),
+      inodesPerSec(_inodesPerSec),
+      idleIOPriority(_idleIOPriority),
+      tree(NULL),
+      active(false) {}
+
+  virtual ~RemoverProcess()
+  {
+    if (tree != NULL) {
+      ::fts_close(tree);
+    }
+
+    foreach (const Removal& removal, removals) {
+      removal.promise->discard();
+    }
+  }
+
+  Future<Nothing> remove(const string& path)
+  {
+    Removal removal(path);
+    removals.push_back(removal);
+
+    if (!active) {
+      active = true;
+      dispatch(self(), &Self::work);
+    }
+
+    return removal.promise->future();
+  }
+
+  // Returns the disk space used by each of the given paths.
+  hashmap<string, Bytes> sizes(const list<string>& paths)
+  {
+    hashmap<string, Bytes> result;
+
+    foreach (const string& path, paths) {
+      char* paths_[] = {const_cast<char*>(path.c_str()), NULL};
+
+      FTS* tree = ::fts_open(paths_, FTS_NOCHDIR | FTS_PHYSICAL, NULL);
+      if (tree == NULL) {
+        continue;
+      }
+
+      Bytes size;
+      for (FTSENT* node = ::fts_read(tree);
+           node != NULL;
+           node = ::fts_read(tree)) {
+        if (node->fts_info != FTS_DP && node->fts_statp != NULL &&
+            node->fts_info != FTS_NS && node->fts_info != FTS_NSOK) {
+          size += Bytes(node->fts_statp->st_blocks * 512);
+        }
+      }
+
+      ::fts_close(tree);
+
+      result[path] = size;
+    }
+
+    return result;
+  }
+
+private:
+  struct Removal
+  {
+    explicit Removal(const string& _path)
+      : path(_path), promise(new Promise<Nothing>()) {}
+
+    string path;
+    Owned<Promise<Nothing>> promise;
+    Option<string> error;
+  };
+
+  void work()
+  {
+    // Spread the budget of this interval over the rate limits.
+    const double fraction = REMOVAL_INTERVAL.secs();
+
+    Option<Bytes> bytesBudget = None();
+    if (bytesPerSec.isSome() && bytesPerSec.get() > 0) {
+      bytesBudget = std::max(Bytes(1), bytesPerSec.get() * fraction);
+    }
+
+    size_t inodesBudget = REMOVAL_BATCH_SIZE;
+    if (inodesPerSec.isSome() && inodesPerSec.get() > 0) {
+      inodesBudget = std::min(
+          inodesBudget,
+          std::max((size_t) 1, (size_t) (inodesPerSec.get() * fraction)));
+    }
+
+    const bool throttled = bytesBudget.isSome() ||
+      (inodesPerSec.isSome() && inodesPerSec.get() > 0);
+
+    Option<int> priority = None();
+    if (idleIOPriority) {
+      Try<int> previous = ioprio(IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+      if (previous.isError()) {
+        LOG_FIRST_N(WARNING, 1) << previous.error();
+      } else {
+        priority = previous.get();
+      }
+    }
+
+    Bytes bytes;
+    size_t inodes = 0;
+
+    while (!removals.empty() &&
+           inodes < inodesBudget &&
+           (bytesBudget.isNone() || bytes < bytesBudget.get())) {
+      Removal& removal = removals.front();
+
+      if (tree == NULL) {
+        char* paths[] = {const_cast<char*>(removal.path.c_str()), NULL};
+
+        tree = ::fts_open(paths, FTS_NOCHDIR | FTS_PHYSICAL, NULL);
+        if (tree == NULL) {
+          removal.promise->fail(ErrnoError().message);
+          removals.pop_front();
+          continue;
+        }
+      }
+
+      FTSENT* node = ::fts_read(tree);
+
+      if (node == NULL) {
+        // We are done with this path.
+        ::fts_close(tree);
+        tree = NULL;
+
+        if (removal.error.isSome()) {
+          removal.promise->fail(removal.error.get());
+        } else {
+          removal.promise->set(Nothing());
+        }
+
+        removals.pop_front();
+        continue;
+      }
+
+      switch (node->fts_info) {
+        case FTS_D:
+          // Directories are removed in post-order (FTS_DP).
+          break;
+        case FTS_DP:
+          if (::rmdir(node->fts_path) < 0 && errno != ENOENT) {
+            removal.error = ErrnoError(
+                "Failed to remove directory '" +
+                string(node->fts_path) + "'").message;
+          }
+          ++inodes;
+          break;
+        case FTS_F:
+        case FTS_SL:
+        case FTS_SLNONE:
+        case FTS_DEFAULT:
+          bytes += Bytes(node->fts_statp->st_blocks * 512);
+          if (::unlink(node->fts_path) < 0 && errno != ENOENT) {
+            removal.error = ErrnoError(
+                "Failed to remove '" + string(node->fts_path) + "'").message;
+          }
+          ++inodes;
+          break;
+        case FTS_DNR:
+        case FTS_ERR:
+        case FTS_NS:
+          removal.error = string(node->fts_path) + ": " +
+            ::strerror(node->fts_errno);
+          break;
+        default:
+          break;
+      }
+    }
+
+    if (priority.isSome()) {
+      Try<int> restore = ioprio(priority.get());
+      if (restore.isError()) {
+        LOG_FIRST_N(WARNING, 1) << restore.error();
+      }
+    }
+
+    if (removals.empty()) {
+      active = false;
+    } else if (throttled) {
+      delay(REMOVAL_INTERVAL, self(), &Self::work);
+    } else {
+      dispatch(self(), &Self::work);
+    }
+  }
+
+  const Option<Bytes> bytesPerSec;
+  const Option<size_t> inodesPerSec;
+  const bool idleIOPriority;
+
+  deque<Removal> removals;
+
+  // The traversal of the path currently being removed.
+  FTS* tree;
+
+  // Whether the remover is working through 'removals'.
+  bool active;
+};
+
+
+GarbageCollectorProcess::GarbageCollectorProcess(
+    const Option<Bytes>& bytesPerSec,
+    const Option<size_t>& inodesPerSec,
+    bool idleIOPriority)
+  : remover(new RemoverProcess(bytesPerSec, inodesPerSec, idleIOPriority)) {}
+
 
 GarbageCollectorProcess::~GarbageCollectorProcess()
 {
   foreachvalue (const PathInfo& info, paths) {
     info.promise->discard();
   }
+
+  delete remover;
+}
+
+
+void GarbageCollectorProcess::initialize()
+{
+  spawn(remover);
+}
+
+
+void GarbageCollectorProcess::finalize()
+{
+  terminate(remover);
+  wait(remover);
 }
 
 
@@ -126,23 +408,9 @@ void GarbageCollectorProcess::reset()
 
 void GarbageCollectorProcess::remove(const Timeout& removalTime)
 {
-  // TODO(bmahler): Other dispatches can block waiting for a removal
-  // operation. To fix this, the removal operation can be done
-  // asynchronously in another thread.
   if (paths.count(removalTime) > 0) {
     foreach (const PathInfo& info, paths.get(removalTime)) {
-      LOG(INFO) << "Deleting " << info.path;
-
-      Try<Nothing> rmdir = os::rmdir(info.path);
-
-      if (rmdir.isError()) {
-        LOG(WARNING) << "Failed to delete '" << info.path << "': "
-                     << rmdir.error();
-        info.promise->fail(rmdir.error());
-      } else {
-        LOG(INFO) << "Deleted '" << info.path << "'";
-        info.promise->set(rmdir.get());
-      }
+      _remove(info);
 
       timeouts.erase(info.path);
     }
@@ -160,15 +428,92 @@ void GarbageCollectorProcess::remove(const Timeout& removalTime)
 }
 
 
+void GarbageCollectorProcess::_remove(const PathInfo& info)
+{
+  LOG(INFO) << "Deleting " << info.path;
+
+  dispatch(remover, &RemoverProcess::remove, info.path)
+    .onAny(defer(self(), &Self::__remove, info, lambda::_1));
+}
+
+
+void GarbageCollectorProcess::__remove(
+    const PathInfo& info,
+    const Future<Nothing>& future)
+{
+  if (!future.isReady()) {
+    const string error =
+      future.isFailed() ? future.failure() : "discarded";
+
+    LOG(WARNING) << "Failed to delete '" << info.path << "': " << error;
+    info.promise->fail(error);
+    return;
+  }
+
+  LOG(INFO) << "Deleted '" << info.path << "'";
+
+  // Also delete the checkpoints below the path, if it is a meta
+  // directory whose checkpoints are in a checkpoint store.
+  state::Store* store = state::Store::get(info.path);
+  if (store != NULL) {
+    Try<Nothing> remove = store->remove(info.path);
+    if (remove.isError()) {
+      LOG(WARNING) << "Failed to delete the checkpoints of '"
+                   << info.path << "': " << remove.error();
+    }
+  }
+
+  info.promise->set(Nothing());
+}
+
+
 void GarbageCollectorProcess::prune(const Duration& d)
 {
+  list<PathInfo> infos;
+  list<string> pruned;
+
   foreach (const Timeout& removalTime, paths.keys()) {
     if (removalTime.remaining() <= d) {
       LOG(INFO) << "Pruning directories with remaining removal time "
                 << removalTime.remaining();
-      dispatch(self(), &GarbageCollectorProcess::remove, removalTime);
+
+      foreach (const PathInfo& info, paths.get(removalTime)) {
+        infos.push_back(info);
+        pruned.push_back(info.path);
+        timeouts.erase(info.path);
+      }
+
+      paths.remove(removalTime);
     }
   }
+
+  if (infos.empty()) {
+    return;
+  }
+
+  reset(); // Schedule the timer for next event.
+
+  // Find out how much each path will reclaim before deleting them.
+  dispatch(remover, &RemoverProcess::sizes, pruned)
+    .onAny(defer(self(), &Self::_prune, infos, lambda::_1));
+}
+
+
+void GarbageCollectorProcess::_prune(
+    list<PathInfo> infos,
+    const Future<hashmap<string, Bytes>>& sizes)
+{
+  if (sizes.isReady()) {
+    // Delete the biggest paths first.
+    infos.sort([&sizes](const PathInfo& left, const PathInfo& right) {
+      return sizes.get().get(left.path).get(Bytes(0)) >
+             sizes.get().get(right.path).get(Bytes(0));
+    });
+  }
+
+  foreach (const PathInfo& info, infos) {
+    _remove(info);
+  }
 }
 
 
@@ -179,6 +524,17 @@ GarbageCollector::GarbageCollector()
 }
 
 
+GarbageCollector::GarbageCollector(const Flags& flags)
+{
+  process = new GarbageCollectorProcess(
+      flags.gc_bytes_per_sec,
+      flags.gc_inodes_per_sec,
+      flags.gc_idle_io_priority);
+
+  spawn(process);
+}
+
+
 GarbageCollector::~GarbageCollector()
 {
   terminate(process);
@@ -19,6 +19,7 @@
 #ifndef __SLAVE_GC_HPP__
 #define __SLAVE_GC_HPP__
 
+#include <list>
 #include <string>
 #include <vector>
 
@@ -28,18 +29,23 @@
 #include <process/timeout.hpp>
 #include <process/timer.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/multimap.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/try.hpp>
 
+#include "slave/flags.hpp"
+
 namespace mesos {
 namespace internal {
 namespace slave {
 
 // Forward declarations.
 class GarbageCollectorProcess;
+class RemoverProcess;
 
 // Provides an abstraction for removing files and directories after
 // some point at which they are no longer considered necessary to keep
@@ -52,6 +58,12 @@ class GarbageCollector
 {
 public:
   GarbageCollector();
+
+  // Removes paths at the rate limits given by '--gc_bytes_per_sec'
+  // and '--gc_inodes_per_sec', with idle I/O priority if
+  // '--gc_idle_io_priority' is set.
+  explicit GarbageCollector(const Flags& flags);
+
   virtual ~GarbageCollector();
 
   // Schedules the specified path for removal after the specified
@@ -76,7 +88,9 @@ public:
   virtual process::Future<bool> unschedule(const std::string& path);
 
   // Deletes all the directories, whose scheduled garbage collection time
-  // is within the next 'd' duration of time.
+  // is within the next 'd' duration of time. The directories are
+  // deleted in decreasing order of their size, so that most space is
+  // reclaimed first.
   virtual void prune(const Duration& d);
 
 private:
@@ -88,6 +102,11 @@ class GarbageCollectorProcess :
     public process::Process<GarbageCollectorProcess>
 {
 public:
+  GarbageCollectorProcess(
+      const Option<Bytes>& bytesPerSec = None(),
+      const Option<size_t>& inodesPerSec = None(),
+      bool idleIOPriority = false);
+
   virtual ~GarbageCollectorProcess();
 
   process::Future<Nothing> schedule(
@@ -98,6 +117,10 @@ public:
 
   void prune(const Duration& d);
 
+protected:
+  virtual void initialize();
+  virtual void finalize();
+
 private:
   void reset();
 
@@ -118,6 +141,15 @@ private:
     const process::Owned<process::Promise<Nothing> > promise;
   };
 
+  // Hands a path to the remover and completes its promise once the
+  // path is removed.
+  void _remove(const PathInfo& info);
+  void __remove(const PathInfo& info, const process::Future<Nothing>& future);
+
+  void _prune(
+      std::list<PathInfo> infos,
+      const process::Future<hashmap<std::string, Bytes>>& sizes);
+
   // Store all the timeouts and corresponding paths to delete.
   // NOTE: We are using Multimap here instead of Multihashmap, because
   // we need the keys of the map (deletion time) to be sorted.
@@ -128,6 +160,11 @@ private:
   hashmap<std::string, process::Timeout> timeouts;
 
   process::Timer timer;
+
+  // Deletes the paths off this process so that removing big
+  // directories does not block scheduling, and throttles the
+  // deletion to spare the disk I/O of running tasks.
+  RemoverProcess* remover;
 };
 
 } // namespace slave {
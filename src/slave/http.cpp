@@ -55,6 +55,7 @@ using process::Owned;
 using process::TLDR;
 using process::USAGE;
 
+using process::http::BadRequest;
 using process::http::InternalServerError;
 using process::http::OK;
 
@@ -263,8 +264,27 @@ Future<Response> Slave::Http::health(const Request& request) const
 
 Future<Response> Slave::Http::state(const Request& request) const
 {
+  const string etag = slave->etag();
+
+  Option<Response> unmodified = notModified(request, etag);
+  if (unmodified.isSome()) {
+    return unmodified.get();
+  }
+
+  // Only the frameworks that changed after the 'since' state version
+  // are included if it is given (see 'Slave::stateVersion').
+  Option<uint64_t> since = None();
+  if (request.query.get("since").isSome()) {
+    Try<uint64_t> version = numify<uint64_t>(request.query.get("since").get());
+    if (version.isError()) {
+      return BadRequest("Failed to parse 'since': " + version.error() + ".\n");
+    }
+    since = version.get();
+  }
+
   JSON::Object object;
   object.values["version"] = MESOS_VERSION;
+  object.values["state_version"] = slave->stateVersion;
 
   if (build::GIT_SHA.isSome()) {
     object.values["git_sha"] = build::GIT_SHA.get();
@@ -305,16 +325,27 @@ Future<Response> Slave::Http::state(const Request& request) const
 
   JSON::Array frameworks;
   foreachvalue (Framework* framework, slave->frameworks) {
-    frameworks.values.push_back(model(*framework));
+    if (since.isNone() || framework->version > since.get()) {
+      frameworks.values.push_back(model(*framework));
+    }
   }
   object.values["frameworks"] = frameworks;
 
+  // NOTE: A framework that completed after 'since' shows up here
+  // rather than in 'frameworks'.
   JSON::Array completedFrameworks;
   foreach (const Owned<Framework>& framework, slave->completedFrameworks) {
-    completedFrameworks.values.push_back(model(*framework));
+    if (since.isNone() || framework->version > since.get()) {
+      completedFrameworks.values.push_back(model(*framework));
+    }
   }
   object.values["completed_frameworks"] = completedFrameworks;
 
+  // The flags never change, so there is no need to send them again.
+  if (since.isSome()) {
+    return cacheable(request, stringify(object), etag);
+  }
+
   JSON::Object flags;
   foreachpair (const string& name, const flags::Flag& flag, slave->flags) {
     Option<string> value = flag.stringify(slave->flags);
@@ -324,7 +355,40 @@ Future<Response> Slave::Http::state(const Request& request) const
   }
   object.values["flags"] = flags;
 
-  return OK(object, request.query.get("jsonp"));
+  return cacheable(request, stringify(object), etag);
+}
+
+
+const string Slave::Http::TRACE_HELP = HELP(
+    TLDR(
+        "Spans of the most recently traced task launches."),
+    USAGE(
+        "/slave/trace"),
+    DESCRIPTION(
+        "This endpoint shows the spans the slave recorded for the task",
+        "launches traced by the master (see --trace_sampling_rate on the",
+        "master) as a JSON object, oldest first. A span lasts from the",
+        "end of the previous span of the task (or from the arrival of the",
+        "task) until:",
+        "",
+        "'slave/unschedule': the sandbox is no longer scheduled for",
+        "garbage collection.",
+        "",
+        "'slave/container_launch': the container of the executor is",
+        "launched, including fetching the URIs and preparing isolation.",
+        "",
+        "'slave/executor_registration': the task is sent to the executor",
+        "along with its registration.",
+        "",
+        "'slave/container_update': the task is sent to a running executor",
+        "after its container has been updated.",
+        "",
+        "'executor/task_start': the executor reports the task running."));
+
+
+Future<Response> Slave::Http::trace(const Request& request) const
+{
+  return OK(slave->tracer.json(), request.query.get("jsonp"));
 }
 
 } // namespace slave {
@@ -0,0 +1,314 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <string>
+
+#include <stout/error.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/os.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "slave/logs.hpp"
+
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+namespace logs {
+
+// NOTE: The sandbox (and hence the logs and their backups) is under
+// the control of the task while the slave (usually) runs as root, so
+// we never follow symlinks nor invoke a shell on any of the paths.
+
+
+// Returns whether the path exists, without following symlinks.
+static bool exists(const string& path)
+{
+  struct stat s;
+  return ::lstat(path.c_str(), &s) == 0;
+}
+
+
+// Deletes the file at 'path' if there is one (without following
+// symlinks) and creates a new one for writing.
+static Try<int> create(const string& path)
+{
+  if (::unlink(path.c_str()) != 0 && errno != ENOENT) {
+    return ErrnoError("Failed to delete '" + path + "'");
+  }
+
+  int fd = ::open(
+      path.c_str(),
+      O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd < 0) {
+    return ErrnoError("Failed to create '" + path + "'");
+  }
+
+  return fd;
+}
+
+
+// Reads the next chunk of the file, returns an empty string at EOF.
+static Try<string> read(int fd)
+{
+  char buffer[BUFSIZ];
+
+  while (true) {
+    ssize_t length = ::read(fd, buffer, sizeof(buffer));
+    if (length < 0 && errno == EINTR) {
+      continue;
+    } else if (length < 0) {
+      return ErrnoError();
+    }
+
+    return string(buffer, length);
+  }
+}
+
+
+// Copies the file 'from' (from its start) to 'to' in chunks, so that
+// large log files are not read into memory at once.
+static Try<Nothing> copy(int from, int to)
+{
+  if (::lseek(from, 0, SEEK_SET) < 0) {
+    return ErrnoError("Failed to seek");
+  }
+
+  while (true) {
+    Try<string> data = read(from);
+    if (data.isError()) {
+      return Error("Failed to read: " + data.error());
+    } else if (data.get().empty()) {
+      return Nothing();
+    }
+
+    Try<Nothing> write = os::write(to, data.get());
+    if (write.isError()) {
+      return Error("Failed to write: " + write.error());
+    }
+  }
+}
+
+
+// Compresses the file 'from' (from its start) into 'to' in chunks.
+// Closes 'to'.
+static Try<Nothing> compress(int from, int to)
+{
+  gzFile file = gzdopen(to, "wb");
+  if (file == NULL) {
+    os::close(to);
+    return Error("Failed to initialize compression");
+  }
+
+  if (::lseek(from, 0, SEEK_SET) < 0) {
+    ErrnoError error("Failed to seek");
+    gzclose(file);
+    return error;
+  }
+
+  while (true) {
+    Try<string> data = read(from);
+    if (data.isError()) {
+      gzclose(file);
+      return Error("Failed to read: " + data.error());
+    } else if (data.get().empty()) {
+      break;
+    }
+
+    if (gzwrite(file, data.get().data(), data.get().size()) !=
+        static_cast<int>(data.get().size())) {
+      gzclose(file);
+      return Error("Failed to compress");
+    }
+  }
+
+  if (gzclose(file) != Z_OK) {
+    return Error("Failed to complete compression");
+  }
+
+  return Nothing();
+}
+
+
+// Returns the path of the existing backup with the given index,
+// whether compressed or not.
+static Option<string> backup(const string& path, size_t index)
+{
+  const string file = path + "." + stringify(index);
+
+  if (exists(file)) {
+    return file;
+  } else if (exists(file + ".gz")) {
+    return file + ".gz";
+  }
+
+  return None();
+}
+
+
+// Moves the content of the (open) log to a new backup 'path.1', or
+// 'path.1.gz' if 'compress' is true, and truncates the log.
+static Try<Nothing> _rotate(int fd, const string& path, bool compress)
+{
+  const string target = path + ".1";
+
+  Try<int> out = create(target);
+  if (out.isError()) {
+    return Error(out.error());
+  }
+
+  Try<Nothing> copied = copy(fd, out.get());
+  if (copied.isError()) {
+    os::close(out.get());
+    return Error("Failed to copy '" + path + "' to '" + target + "': " +
+                 copied.error());
+  }
+
+  if (::ftruncate(fd, 0) != 0) {
+    ErrnoError error("Failed to truncate '" + path + "'");
+    os::close(out.get());
+    return error;
+  }
+
+  // Compress only after truncating to keep the window in which
+  // writes get lost small.
+  if (compress) {
+    Try<int> gz = create(target + ".gz");
+    if (gz.isError()) {
+      os::close(out.get());
+      return Error(gz.error());
+    }
+
+    Try<Nothing> compressed = logs::compress(out.get(), gz.get());
+    if (compressed.isError()) {
+      os::close(out.get());
+      return Error("Failed to compress '" + target + "': " +
+                   compressed.error());
+    }
+
+    if (::unlink(target.c_str()) != 0) {
+      ErrnoError error("Failed to delete '" + target + "'");
+      os::close(out.get());
+      return error;
+    }
+  }
+
+  os::close(out.get());
+
+  return Nothing();
+}
+
+
+Try<bool> rotate(
+    const string& path,
+    const Bytes& maxSize,
+    size_t maxBackups,
+    bool compress)
+{
+  // NOTE: We need to be able to write to the log in order to truncate
+  // it. O_NONBLOCK keeps us from blocking on a FIFO, which we reject
+  // below (like anything else that is not a regular file).
+  int fd = ::open(
+      path.c_str(),
+      O_RDWR | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC);
+
+  if (fd < 0 && errno == ENOENT) {
+    return false;
+  } else if (fd < 0) {
+    return ErrnoError("Failed to open '" + path + "'");
+  }
+
+  struct stat s;
+  if (::fstat(fd, &s) != 0) {
+    ErrnoError error("Failed to stat '" + path + "'");
+    os::close(fd);
+    return error;
+  }
+
+  if (!S_ISREG(s.st_mode)) {
+    os::close(fd);
+    return Error("'" + path + "' is not a regular file");
+  }
+
+  if (Bytes(s.st_size) < maxSize) {
+    os::close(fd);
+    return false;
+  }
+
+  if (maxBackups > 0) {
+    // Make room for the new backup by shifting the existing ones,
+    // deleting the oldest. Neither renaming nor deleting follows
+    // symlinks.
+    Option<string> oldest = backup(path, maxBackups);
+    if (oldest.isSome()) {
+      Try<Nothing> rm = os::rm(oldest.get());
+      if (rm.isError()) {
+        os::close(fd);
+        return Error("Failed to delete '" + oldest.get() + "': " + rm.error());
+      }
+    }
+
+    for (size_t index = maxBackups - 1; index >= 1; index--) {
+      Option<string> from = backup(path, index);
+      if (from.isSome()) {
+        const string to = path + "." + stringify(index + 1) +
+          (strings::endsWith(from.get(), ".gz") ? ".gz" : "");
+
+        Try<Nothing> rename = os::rename(from.get(), to);
+        if (rename.isError()) {
+          os::close(fd);
+          return Error("Failed to rename '" + from.get() + "': " +
+                       rename.error());
+        }
+      }
+    }
+
+    Try<Nothing> rotated = _rotate(fd, path, compress);
+    if (rotated.isError()) {
+      os::close(fd);
+      return Error(rotated.error());
+    }
+  } else if (::ftruncate(fd, 0) != 0) {
+    ErrnoError error("Failed to truncate '" + path + "'");
+    os::close(fd);
+    return error;
+  }
+
+  os::close(fd);
+
+  return true;
+}
+
+} // namespace logs {
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
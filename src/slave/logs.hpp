@@ -0,0 +1,55 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SLAVE_LOGS_HPP__
+#define __SLAVE_LOGS_HPP__
+
+#include <string>
+
+#include <stout/bytes.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+namespace logs {
+
+// Rotates the (container log) file at 'path' if it is at least
+// 'maxSize' large: its content is moved to 'path.1', which is
+// compressed to 'path.1.gz' if 'compress' is true, after shifting
+// the existing backups 'path.N' to 'path.N+1' and deleting those
+// beyond 'maxBackups'. Returns whether the file was rotated, or an
+// error if it is not a regular file (e.g., a symlink). Symlinks are
+// not followed for the backups either.
+//
+// NOTE: The file is copied and then truncated rather than renamed
+// because the process writing it (e.g., an executor) keeps its file
+// descriptor, which must have been opened with O_APPEND. Anything
+// written between copying and truncating is lost.
+Try<bool> rotate(
+    const std::string& path,
+    const Bytes& maxSize,
+    size_t maxBackups,
+    bool compress);
+
+} // namespace logs {
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SLAVE_LOGS_HPP__
@@ -22,12 +22,15 @@
 
 #include <mesos/module/anonymous.hpp>
 
+#include <mesos/slave/qos_controller.hpp>
 #include <mesos/slave/resource_estimator.hpp>
 
 #include <stout/check.hpp>
+#include <stout/duration.hpp>
 #include <stout/flags.hpp>
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
@@ -53,6 +56,7 @@ using namespace mesos::internal::slave;
 using mesos::modules::Anonymous;
 using mesos::modules::ModuleManager;
 
+using mesos::slave::QoSController;
 using mesos::slave::ResourceEstimator;
 
 using mesos::SlaveInfo;
@@ -116,6 +120,11 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
+  // The phases of the startup are timed, and logged once logging is
+  // initialized.
+  Stopwatch stopwatch;
+  stopwatch.start();
+
   // Initialize modules. Note that since other subsystems may depend
   // upon modules, we should initialize modules before anything else.
   if (flags.modules.isSome()) {
@@ -133,6 +142,8 @@ int main(int argc, char** argv)
     }
   }
 
+  const Duration modules = stopwatch.elapsed();
+
   // Initialize libprocess.
   if (ip.isSome()) {
     os::setenv("LIBPROCESS_IP", ip.get());
@@ -156,7 +167,22 @@ int main(int argc, char** argv)
     LOG(INFO) << "Git SHA: " << build::GIT_SHA.get();
   }
 
-  Fetcher fetcher;
+  LOG(INFO) << "Loaded modules and hooks in " << modules;
+  LOG(INFO) << "Initialized libprocess in " << stopwatch.elapsed() - modules;
+
+  // The detector is created first so that the ZooKeeper session gets
+  // established while the containerizer is created (e.g., while the
+  // isolators set up the cgroups hierarchies).
+  Try<MasterDetector*> detector = MasterDetector::create(master.get());
+
+  if (detector.isError()) {
+    EXIT(EXIT_FAILURE)
+      << "Failed to create a master detector: " << detector.error();
+  }
+
+  stopwatch.start();
+
+  Fetcher fetcher(flags);
 
   Try<Containerizer*> containerizer =
     Containerizer::create(flags, false, &fetcher);
@@ -166,12 +192,7 @@ int main(int argc, char** argv)
       << "Failed to create a containerizer: " << containerizer.error();
   }
 
-  Try<MasterDetector*> detector = MasterDetector::create(master.get());
-
-  if (detector.isError()) {
-    EXIT(EXIT_FAILURE)
-      << "Failed to create a master detector: " << detector.error();
-  }
+  LOG(INFO) << "Created the containerizer in " << stopwatch.elapsed();
 
   // Create anonymous modules.
   foreach (const string& name, ModuleManager::find<Anonymous>()) {
@@ -191,7 +212,7 @@ int main(int argc, char** argv)
   }
 
   Files files;
-  GarbageCollector gc;
+  GarbageCollector gc(flags);
   StatusUpdateManager statusUpdateManager(flags);
 
   Try<ResourceEstimator*> resourceEstimator =
@@ -203,6 +224,15 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
+  Try<QoSController*> qosController =
+    QoSController::create(flags.qos_controller);
+
+  if (qosController.isError()) {
+    cerr << "Failed to create QoS Controller: "
+         << qosController.error() << endl;
+    return EXIT_FAILURE;
+  }
+
   LOG(INFO) << "Starting Mesos slave";
 
   Slave* slave = new Slave(
@@ -212,7 +242,8 @@ int main(int argc, char** argv)
       &files,
       &gc,
       &statusUpdateManager,
-      resourceEstimator.get());
+      resourceEstimator.get(),
+      qosController.get());
 
   process::spawn(slave);
   process::wait(slave->self());
@@ -221,6 +252,8 @@ int main(int argc, char** argv)
 
   delete resourceEstimator.get();
 
+  delete qosController.get();
+
   delete detector.get();
 
   delete containerizer.get();
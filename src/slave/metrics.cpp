@@ -39,6 +39,16 @@ Metrics::Metrics(const Slave& slave)
         defer(slave, &Slave::_registered)),
     recovery_errors(
         "slave/recovery_errors"),
+    recovery_state(
+        "slave/recovery/state"),
+    recovery_status_update_manager(
+        "slave/recovery/status_update_manager"),
+    recovery_containerizer(
+        "slave/recovery/containerizer"),
+    recovery_executors(
+        "slave/recovery/executors"),
+    recovery_total(
+        "slave/recovery/total"),
     frameworks_active(
         "slave/frameworks_active",
         defer(slave, &Slave::_frameworks_active)),
@@ -70,6 +80,8 @@ Metrics::Metrics(const Slave& slave)
         defer(slave, &Slave::_executors_terminating)),
     executors_terminated(
         "slave/executors_terminated"),
+    executors_preempted(
+        "slave/executors_preempted"),
     valid_status_updates(
         "slave/valid_status_updates"),
     invalid_status_updates(
@@ -87,6 +99,11 @@ Metrics::Metrics(const Slave& slave)
   process::metrics::add(registered);
 
   process::metrics::add(recovery_errors);
+  process::metrics::add(recovery_state);
+  process::metrics::add(recovery_status_update_manager);
+  process::metrics::add(recovery_containerizer);
+  process::metrics::add(recovery_executors);
+  process::metrics::add(recovery_total);
 
   process::metrics::add(frameworks_active);
 
@@ -102,6 +119,7 @@ Metrics::Metrics(const Slave& slave)
   process::metrics::add(executors_running);
   process::metrics::add(executors_terminating);
   process::metrics::add(executors_terminated);
+  process::metrics::add(executors_preempted);
 
   process::metrics::add(valid_status_updates);
   process::metrics::add(invalid_status_updates);
@@ -145,6 +163,11 @@ Metrics::~Metrics()
   process::metrics::remove(registered);
 
   process::metrics::remove(recovery_errors);
+  process::metrics::remove(recovery_state);
+  process::metrics::remove(recovery_status_update_manager);
+  process::metrics::remove(recovery_containerizer);
+  process::metrics::remove(recovery_executors);
+  process::metrics::remove(recovery_total);
 
   process::metrics::remove(frameworks_active);
 
@@ -160,6 +183,7 @@ Metrics::~Metrics()
   process::metrics::remove(executors_running);
   process::metrics::remove(executors_terminating);
   process::metrics::remove(executors_terminated);
+  process::metrics::remove(executors_preempted);
 
   process::metrics::remove(valid_status_updates);
   process::metrics::remove(invalid_status_updates);
@@ -23,6 +23,9 @@
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
+#include <process/metrics/timer.hpp>
+
+#include <stout/duration.hpp>
 
 
 namespace mesos {
@@ -42,6 +45,16 @@ struct Metrics
 
   process::metrics::Counter recovery_errors;
 
+  // Time spent in the phases of the recovery: reading the
+  // checkpointed state, recovering the status update manager and the
+  // containerizer, waiting for the executors to reregister, and the
+  // recovery as a whole.
+  process::metrics::Timer<Milliseconds> recovery_state;
+  process::metrics::Timer<Milliseconds> recovery_status_update_manager;
+  process::metrics::Timer<Milliseconds> recovery_containerizer;
+  process::metrics::Timer<Milliseconds> recovery_executors;
+  process::metrics::Timer<Milliseconds> recovery_total;
+
   process::metrics::Gauge frameworks_active;
 
   process::metrics::Gauge tasks_staging;
@@ -56,6 +69,7 @@ struct Metrics
   process::metrics::Gauge executors_running;
   process::metrics::Gauge executors_terminating;
   process::metrics::Counter executors_terminated;
+  process::metrics::Counter executors_preempted;
 
   process::metrics::Counter valid_status_updates;
   process::metrics::Counter invalid_status_updates;
@@ -19,6 +19,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <mesos/mesos.hpp>
 
@@ -31,6 +32,7 @@
 #include <process/http.hpp>
 #include <process/process.hpp>
 #include <process/statistics.hpp>
+#include <process/timeseries.hpp>
 
 #include <stout/json.hpp>
 #include <stout/lambda.hpp>
@@ -53,6 +55,10 @@ namespace slave {
 using process::wait; // Necessary on some OS's to disambiguate.
 
 
+const Duration MONITORING_TIME_SERIES_WINDOW = Minutes(15);
+const size_t MONITORING_TIME_SERIES_CAPACITY = 1000;
+
+
 Future<Nothing> ResourceMonitorProcess::start(
     const ContainerID& containerId,
     const ExecutorInfo& executorInfo)
@@ -75,6 +81,8 @@ Future<Nothing> ResourceMonitorProcess::stop(
   }
 
   monitored.erase(containerId);
+  samples.erase(containerId);
+  previous.erase(containerId);
 
   return Nothing();
 }
@@ -107,6 +115,126 @@ list<ResourceUsage> ResourceMonitorProcess::_usages(
 }
 
 
+// Returns the change of the cumulative statistics between two
+// samples of a container.
+static JSON::Object delta(
+    const ResourceStatistics& previous,
+    const ResourceStatistics& current)
+{
+  JSON::Object object;
+  object.values["duration_secs"] = current.timestamp() - previous.timestamp();
+  object.values["cpus_user_time_secs"] =
+    current.cpus_user_time_secs() - previous.cpus_user_time_secs();
+  object.values["cpus_system_time_secs"] =
+    current.cpus_system_time_secs() - previous.cpus_system_time_secs();
+  object.values["cpus_nr_periods"] =
+    current.cpus_nr_periods() - previous.cpus_nr_periods();
+  object.values["cpus_nr_throttled"] =
+    current.cpus_nr_throttled() - previous.cpus_nr_throttled();
+  object.values["cpus_throttled_time_secs"] =
+    current.cpus_throttled_time_secs() - previous.cpus_throttled_time_secs();
+
+  return object;
+}
+
+
+void ResourceMonitorProcess::sample()
+{
+  list<ContainerID> containerIds;
+  list<Future<ResourceUsage>> futures;
+
+  foreachkey (const ContainerID& containerId, monitored) {
+    containerIds.push_back(containerId);
+    futures.push_back(usage(containerId));
+  }
+
+  // NOTE: We only schedule the next round once all containers have
+  // been sampled so that a slow containerizer cannot pile up
+  // outstanding usage requests.
+  await(futures)
+    .onAny(defer(self(), &Self::_sample, containerIds, futures));
+}
+
+
+void ResourceMonitorProcess::_sample(
+    const list<ContainerID>& containerIds,
+    const list<Future<ResourceUsage>>& futures)
+{
+  CHECK_EQ(containerIds.size(), futures.size());
+
+  JSON::Array chunk;
+
+  list<ContainerID>::const_iterator containerId = containerIds.begin();
+  foreach (const Future<ResourceUsage>& future, futures) {
+    // The container might have stopped being monitored in the interim.
+    if (future.isReady() && monitored.contains(*containerId)) {
+      const ResourceUsage& usage = future.get();
+
+      if (!subscribers.empty()) {
+        JSON::Object entry;
+        entry.values["framework_id"] =
+          usage.executor_info().framework_id().value();
+        entry.values["executor_id"] =
+          usage.executor_info().executor_id().value();
+        entry.values["statistics"] = JSON::Protobuf(usage.statistics());
+
+        if (previous.contains(*containerId)) {
+          entry.values["delta"] =
+            delta(previous[*containerId], usage.statistics());
+        }
+
+        chunk.values.push_back(entry);
+      }
+
+      previous[*containerId] = usage.statistics();
+
+      if (window > Duration::zero()) {
+        record(*containerId, usage);
+      }
+    }
+
+    ++containerId;
+  }
+
+  if (!subscribers.empty()) {
+    // Every sample is written as a single line of JSON.
+    const string data = stringify(chunk) + "\n";
+
+    // Drop the subscribers that went away.
+    list<http::Pipe::Writer>::iterator subscriber = subscribers.begin();
+    while (subscriber != subscribers.end()) {
+      if (!subscriber->write(data)) {
+        subscriber = subscribers.erase(subscriber);
+      } else {
+        ++subscriber;
+      }
+    }
+  }
+
+  // Keep sampling only as long as anybody is interested.
+  if (window > Duration::zero() || !subscribers.empty()) {
+    delay(interval, self(), &Self::sample);
+  } else {
+    sampling = false;
+  }
+}
+
+
+void ResourceMonitorProcess::record(
+    const ContainerID& containerId,
+    const ResourceUsage& usage)
+{
+  if (!samples.contains(containerId)) {
+    samples.put(
+        containerId,
+        TimeSeries<ResourceStatistics>(
+            window, MONITORING_TIME_SERIES_CAPACITY));
+  }
+
+  samples.at(containerId).set(usage.statistics());
+}
+
+
 Future<ResourceUsage> ResourceMonitorProcess::usage(
     ContainerID containerId)
 {
@@ -193,6 +321,239 @@ Future<http::Response> ResourceMonitorProcess::__statistics(
 }
 
 
+// Returns the percentiles of the given values as a JSON object, or
+// None if there are not enough values.
+static Option<JSON::Object> percentiles(const TimeSeries<double>& values)
+{
+  Option<Statistics<double>> statistics = Statistics<double>::from(values);
+
+  if (statistics.isNone()) {
+    return None();
+  }
+
+  JSON::Object object;
+  object.values["count"] = statistics.get().count;
+  object.values["min"] = statistics.get().min;
+  object.values["max"] = statistics.get().max;
+  object.values["p50"] = statistics.get().p50;
+  object.values["p90"] = statistics.get().p90;
+  object.values["p95"] = statistics.get().p95;
+  object.values["p99"] = statistics.get().p99;
+
+  return object;
+}
+
+
+// Summarizes the samples of a container into windowed rates and
+// percentiles.
+static JSON::Object summarize(
+    const std::vector<TimeSeries<ResourceStatistics>::Value>& values,
+    const Duration& window)
+{
+  // Temporary series holding one derived value per sample (or per
+  // pair of consecutive samples for rates).
+  TimeSeries<double> cpus(window, values.size());
+  TimeSeries<double> throttled(window, values.size());
+  TimeSeries<double> rss(window, values.size());
+
+  for (size_t i = 0; i < values.size(); i++) {
+    const ResourceStatistics& current = values[i].data;
+
+    if (current.has_mem_rss_bytes()) {
+      rss.set(current.mem_rss_bytes(), values[i].time);
+    }
+
+    if (i == 0) {
+      continue;
+    }
+
+    const ResourceStatistics& previous = values[i - 1].data;
+
+    const double elapsed = current.timestamp() - previous.timestamp();
+    if (elapsed > 0) {
+      cpus.set(
+          (current.cpus_user_time_secs() + current.cpus_system_time_secs() -
+           previous.cpus_user_time_secs() - previous.cpus_system_time_secs()) /
+          elapsed,
+          values[i].time);
+    }
+
+    if (current.cpus_nr_periods() > previous.cpus_nr_periods()) {
+      throttled.set(
+          static_cast<double>(
+              current.cpus_nr_throttled() - previous.cpus_nr_throttled()) /
+          (current.cpus_nr_periods() - previous.cpus_nr_periods()),
+          values[i].time);
+    }
+  }
+
+  JSON::Object object;
+  object.values["samples"] = values.size();
+
+  if (values.size() >= 2) {
+    const ResourceStatistics& first = values.front().data;
+    const ResourceStatistics& last = values.back().data;
+
+    const double elapsed = last.timestamp() - first.timestamp();
+    object.values["duration_secs"] = elapsed;
+
+    if (elapsed > 0) {
+      object.values["cpus_usage_rate"] =
+        (last.cpus_user_time_secs() + last.cpus_system_time_secs() -
+         first.cpus_user_time_secs() - first.cpus_system_time_secs()) /
+        elapsed;
+    }
+  }
+
+  Option<JSON::Object> cpus_ = percentiles(cpus);
+  if (cpus_.isSome()) {
+    object.values["cpus_usage"] = cpus_.get();
+  }
+
+  Option<JSON::Object> throttled_ = percentiles(throttled);
+  if (throttled_.isSome()) {
+    object.values["cpus_throttled_ratio"] = throttled_.get();
+  }
+
+  Option<JSON::Object> rss_ = percentiles(rss);
+  if (rss_.isSome()) {
+    object.values["mem_rss_bytes"] = rss_.get();
+  }
+
+  return object;
+}
+
+
+Future<http::Response> ResourceMonitorProcess::history(
+    const http::Request& request)
+{
+  if (window == Duration::zero()) {
+    return http::ServiceUnavailable(
+        "Resource usage history is disabled on this slave");
+  }
+
+  Option<Time> start = None();
+
+  Option<string> duration = request.query.get("window");
+  if (duration.isSome()) {
+    Try<Duration> parse = Duration::parse(duration.get());
+    if (parse.isError()) {
+      return http::BadRequest(
+          "Failed to parse 'window': " + parse.error());
+    }
+
+    start = Clock::now() - parse.get();
+  }
+
+  JSON::Array result;
+
+  foreachpair (const ContainerID& containerId,
+               const TimeSeries<ResourceStatistics>& series,
+               samples) {
+    CHECK(monitored.contains(containerId));
+    const ExecutorInfo& executorInfo = monitored[containerId];
+
+    JSON::Object entry;
+    entry.values["framework_id"] = executorInfo.framework_id().value();
+    entry.values["executor_id"] = executorInfo.executor_id().value();
+    entry.values["executor_name"] = executorInfo.name();
+    entry.values["source"] = executorInfo.source();
+    entry.values["history"] = summarize(series.get(start), window);
+
+    result.values.push_back(entry);
+  }
+
+  return http::OK(result, request.query.get("jsonp"));
+}
+
+
+Future<http::Response> ResourceMonitorProcess::stream(
+    const http::Request& request)
+{
+  http::Pipe pipe;
+
+  http::OK ok;
+  ok.type = http::Response::PIPE;
+  ok.reader = pipe.reader();
+  ok.headers["Content-Type"] = "application/json";
+
+  subscribers.push_back(pipe.writer());
+
+  if (!sampling) {
+    sampling = true;
+    sample();
+  }
+
+  return ok;
+}
+
+
+const string ResourceMonitorProcess::STREAM_HELP = HELP(
+    TLDR(
+        "Stream resource monitoring information."),
+    USAGE(
+        "/stream.json"),
+    DESCRIPTION(
+        "Streams the resource consumption of the containers running",
+        "under this slave, as one line of JSON per sampling interval",
+        "(--resource_monitoring_interval). Besides the statistics, each",
+        "entry contains the change of the cumulative counters since the",
+        "previous sample. All subscribers share a single collection.",
+        "",
+        "Example:",
+        "",
+        "```",
+        "[{",
+        "    \"delta\":",
+        "    {",
+        "        \"cpus_nr_periods\":10,",
+        "        \"cpus_nr_throttled\":1,",
+        "        \"cpus_system_time_secs\":0.02,",
+        "        \"cpus_throttled_time_secs\":0.01,",
+        "        \"cpus_user_time_secs\":0.5,",
+        "        \"duration_secs\":1.0",
+        "    },",
+        "    \"executor_id\":\"executor\",",
+        "    \"framework_id\":\"framework\",",
+        "    \"statistics\":{...}",
+        "}]",
+        "```"));
+
+
+const string ResourceMonitorProcess::HISTORY_HELP = HELP(
+    TLDR(
+        "Retrieve windowed resource usage of containers."),
+    USAGE(
+        "/history.json?window=VALUE"),
+    DESCRIPTION(
+        "Returns rates and percentiles of the resource consumption of",
+        "the containers running under this slave, computed over the",
+        "samples taken within the history window (configured through",
+        "--resource_monitoring_window). The optional 'window' query",
+        "parameter (e.g., 30secs) restricts the computation to the most",
+        "recent samples.",
+        "",
+        "Example:",
+        "",
+        "```",
+        "[{",
+        "    \"executor_id\":\"executor\",",
+        "    \"executor_name\":\"name\",",
+        "    \"framework_id\":\"framework\",",
+        "    \"source\":\"source\",",
+        "    \"history\":",
+        "    {",
+        "        \"cpus_usage\":{\"count\":59,\"max\":1.2,\"min\":0.1,",
+        "                       \"p50\":0.5,\"p90\":0.9,\"p95\":1.0,",
+        "                       \"p99\":1.1},",
+        "        \"cpus_usage_rate\":0.55,",
+        "        \"duration_secs\":59.0,",
+        "        \"samples\":60",
+        "    }",
+        "}]",
+        "```"));
+
+
 const string ResourceMonitorProcess::STATISTICS_HELP = HELP(
     TLDR(
         "Retrieve resource monitoring information."),
@@ -229,9 +590,12 @@ const string ResourceMonitorProcess::STATISTICS_HELP = HELP(
         "```"));
 
 
-ResourceMonitor::ResourceMonitor(Containerizer* containerizer)
+ResourceMonitor::ResourceMonitor(
+    Containerizer* containerizer,
+    const Duration& interval,
+    const Duration& window)
 {
-  process = new ResourceMonitorProcess(containerizer);
+  process = new ResourceMonitorProcess(containerizer, interval, window);
   spawn(process);
 }
 
@@ -19,6 +19,7 @@
 #ifndef __SLAVE_MONITOR_HPP__
 #define __SLAVE_MONITOR_HPP__
 
+#include <list>
 #include <map>
 #include <string>
 
@@ -28,9 +29,11 @@
 #include <mesos/type_utils.hpp>
 
 #include <process/future.hpp>
+#include <process/http.hpp>
 #include <process/limiter.hpp>
 #include <process/owned.hpp>
 #include <process/statistics.hpp>
+#include <process/timeseries.hpp>
 
 #include <stout/cache.hpp>
 #include <stout/duration.hpp>
@@ -39,6 +42,8 @@
 #include <stout/option.hpp>
 #include <stout/try.hpp>
 
+#include "slave/constants.hpp"
+
 namespace mesos {
 namespace internal {
 namespace slave {
@@ -53,12 +58,21 @@ const extern size_t MONITORING_TIME_SERIES_CAPACITY;
 
 
 // Provides resource monitoring for containers. Usage information is
-// also exported via a JSON endpoint.
+// also exported via a JSON endpoint. If a history window is given,
+// the usage of every container is also sampled at the given interval
+// and kept (bounded by MONITORING_TIME_SERIES_CAPACITY samples) so
+// that rates and percentiles over the window can be exported without
+// every consumer polling the containerizer. Consumers can also
+// subscribe to a stream of the samples, which share the same
+// sampling cycle.
 // TODO(bmahler): Forward usage information to the master.
 class ResourceMonitor
 {
 public:
-  explicit ResourceMonitor(Containerizer* containerizer);
+  explicit ResourceMonitor(
+      Containerizer* containerizer,
+      const Duration& interval = RESOURCE_MONITORING_INTERVAL,
+      const Duration& window = Duration::zero());
   ~ResourceMonitor();
 
   // Starts monitoring resources for the given container.
@@ -82,9 +96,15 @@ private:
 class ResourceMonitorProcess : public process::Process<ResourceMonitorProcess>
 {
 public:
-  explicit ResourceMonitorProcess(Containerizer* _containerizer)
+  ResourceMonitorProcess(
+      Containerizer* _containerizer,
+      const Duration& _interval,
+      const Duration& _window)
     : ProcessBase("monitor"),
       containerizer(_containerizer),
+      interval(_interval),
+      window(_window),
+      sampling(false),
       limiter(2, Seconds(1)) {} // 2 permits per second.
 
   virtual ~ResourceMonitorProcess() {}
@@ -104,6 +124,19 @@ protected:
     route("/statistics.json",
           STATISTICS_HELP,
           &ResourceMonitorProcess::statistics);
+
+    route("/history.json",
+          HISTORY_HELP,
+          &ResourceMonitorProcess::history);
+
+    route("/stream.json",
+          STREAM_HELP,
+          &ResourceMonitorProcess::stream);
+
+    if (window > Duration::zero()) {
+      sampling = true;
+      sample();
+    }
   }
 
 private:
@@ -117,6 +150,14 @@ private:
   std::list<ResourceUsage> _usages(
       std::list<process::Future<ResourceUsage>> future);
 
+  // Samples the usage of all monitored containers into their history
+  // and pushes it to the stream subscribers.
+  void sample();
+  void _sample(
+      const std::list<ContainerID>& containerIds,
+      const std::list<process::Future<ResourceUsage>>& futures);
+  void record(const ContainerID& containerId, const ResourceUsage& usage);
+
   // HTTP Endpoints.
   // Returns the monitoring statistics. Requests have no parameters.
   process::Future<process::http::Response> statistics(
@@ -127,15 +168,45 @@ private:
       const process::Future<std::list<ResourceUsage>>& futures,
       const process::http::Request& request);
 
+  // Returns the rates and percentiles of the sampled usage of every
+  // container over the history window (or the optional 'window'
+  // query parameter, if shorter).
+  process::Future<process::http::Response> history(
+      const process::http::Request& request);
+
+  // Streams the usage of every container, and its change since the
+  // previous sample, once per sampling interval.
+  process::Future<process::http::Response> stream(
+      const process::http::Request& request);
+
   static const std::string STATISTICS_HELP;
+  static const std::string HISTORY_HELP;
+  static const std::string STREAM_HELP;
 
   Containerizer* containerizer;
 
+  const Duration interval;
+  const Duration window;
+
+  // Whether a sampling cycle is scheduled.
+  bool sampling;
+
   // Used to rate limit the statistics.json endpoint.
   process::RateLimiter limiter;
 
   // The executor info is stored for each monitored container.
   hashmap<ContainerID, ExecutorInfo> monitored;
+
+  // The sampled usage of each monitored container, if a history
+  // window is configured.
+  hashmap<ContainerID, process::TimeSeries<ResourceStatistics>> samples;
+
+  // The most recent sample of each monitored container, used to
+  // stream the change between two samples.
+  hashmap<ContainerID, ResourceStatistics> previous;
+
+  // The write-ends of the stream subscriptions.
+  std::list<process::http::Pipe::Writer> subscribers;
 };
 
 } // namespace slave {
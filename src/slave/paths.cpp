@@ -45,6 +45,7 @@ namespace paths {
 // File names.
 const char BOOT_ID_FILE[] = "boot_id";
 const char SLAVE_INFO_FILE[] = "slave.info";
+const char STATUS_UPDATES_JOURNAL_FILE[] = "status_updates.journal";
 const char FRAMEWORK_PID_FILE[] = "framework.pid";
 const char FRAMEWORK_INFO_FILE[] = "framework.info";
 const char LIBPROCESS_PID_FILE[] = "libprocess.pid";
@@ -96,6 +97,16 @@ string getSlaveInfoPath(
 }
 
 
+string getStatusUpdatesJournalPath(
+    const string& rootDir,
+    const SlaveID& slaveId)
+{
+  return path::join(
+      getSlavePath(rootDir, slaveId),
+      STATUS_UPDATES_JOURNAL_FILE);
+}
+
+
 Try<list<string>> getFrameworkPaths(
     const string& rootDir,
     const SlaveID& slaveId)
@@ -363,6 +374,34 @@ string getPersistentVolumePath(
 }
 
 
+string getCheckpointStorePath(const string& rootDir)
+{
+  return path::join(rootDir, "checkpoints");
+}
+
+
+bool isCheckpointPath(const string& path)
+{
+  Try<string> basename = os::basename(path);
+  if (basename.isError()) {
+    return false;
+  }
+
+  const string& name = basename.get();
+
+  return name == BOOT_ID_FILE ||
+         name == SLAVE_INFO_FILE ||
+         name == FRAMEWORK_PID_FILE ||
+         name == FRAMEWORK_INFO_FILE ||
+         name == LIBPROCESS_PID_FILE ||
+         name == EXECUTOR_INFO_FILE ||
+         name == EXECUTOR_SENTINEL_FILE ||
+         name == FORKED_PID_FILE ||
+         name == TASK_INFO_FILE ||
+         name == RESOURCES_INFO_FILE;
+}
+
+
 string createExecutorDirectory(
     const string& rootDir,
     const SlaveID& slaveId,
@@ -59,10 +59,12 @@ namespace paths {
 //   |                           |-- latest (symlink)
 //   |                           |-- <container_id> (sandbox)
 //   |-- meta
+//   |   |-- checkpoints (if --checkpoint_store=leveldb)
 //   |   |-- slaves
 //   |       |-- latest (symlink)
 //   |       |-- <slave_id>
 //   |           |-- slave.info
+//   |           |-- status_updates.journal
 //   |           |-- frameworks
 //   |               |-- <framework__id>
 //   |                   |-- framework.info
@@ -110,6 +112,11 @@ std::string getSlaveInfoPath(
     const SlaveID& slaveId);
 
 
+std::string getStatusUpdatesJournalPath(
+    const std::string& rootDir,
+    const SlaveID& slaveId);
+
+
 std::string getSlavePath(
     const std::string& rootDir,
     const SlaveID& slaveId);
@@ -249,6 +256,15 @@ std::string getPersistentVolumePath(
     const std::string& persistenceId);
 
 
+std::string getCheckpointStorePath(const std::string& rootDir);
+
+
+// Returns true if 'path' is one of the checkpoints that are written
+// as a whole using 'state::checkpoint', as opposed to the files that
+// are appended to (e.g., the status updates of a task).
+bool isCheckpointPath(const std::string& path);
+
+
 std::string createExecutorDirectory(
     const std::string& rootDir,
     const SlaveID& slaveId,
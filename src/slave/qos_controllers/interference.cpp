@@ -0,0 +1,328 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <list>
+#include <string>
+
+#include <mesos/resources.hpp>
+#include <mesos/type_utils.hpp>
+
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
+#include <process/future.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
+#include <process/statistics.hpp>
+#include <process/timeseries.hpp>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+#include <stout/option.hpp>
+
+#include "slave/qos_controllers/interference.hpp"
+
+using namespace process;
+
+using std::list;
+using std::string;
+
+using mesos::slave::QoSCorrection;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+const Duration InterferenceQoSController::SAMPLE_INTERVAL = Milliseconds(500);
+const Duration InterferenceQoSController::WINDOW = Minutes(5);
+const double InterferenceQoSController::THRESHOLD = 1.5;
+
+
+// The number of CPI samples needed before an executor's baseline is
+// trusted to detect interference.
+static const size_t MINIMUM_SAMPLES = 10;
+
+
+class InterferenceQoSControllerProcess :
+  public Process<InterferenceQoSControllerProcess>
+{
+public:
+  InterferenceQoSControllerProcess(
+      const lambda::function<Future<list<ResourceUsage>>()>& _usages,
+      const Duration& _interval,
+      const Duration& _window,
+      double _threshold)
+    : usages(_usages),
+      interval(_interval),
+      window(_window),
+      threshold(_threshold) {}
+
+  Future<list<QoSCorrection>> corrections()
+  {
+    if (!pending.empty()) {
+      list<QoSCorrection> result = pending;
+      pending.clear();
+      return result;
+    }
+
+    // Only one outstanding request is expected from the slave.
+    promise.reset(new Promise<list<QoSCorrection>>());
+    return promise->future();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    sample();
+  }
+
+private:
+  struct Samples
+  {
+    explicit Samples(const Duration& window)
+      : revocable(false), cpus(0.0), cpi(window) {}
+
+    bool revocable;
+
+    // The previous cumulative cpu time and the timestamp it was
+    // sampled at, used to compute the current cpu usage rate.
+    Option<double> cpusTime;
+    Option<double> timestamp;
+    double cpus;
+
+    TimeSeries<double> cpi;
+  };
+
+  static string key(const ExecutorInfo& executorInfo)
+  {
+    return executorInfo.framework_id().value() + "/" +
+           executorInfo.executor_id().value();
+  }
+
+  void sample()
+  {
+    usages()
+      .onAny(defer(self(), &Self::_sample, lambda::_1));
+  }
+
+  void _sample(const Future<list<ResourceUsage>>& future)
+  {
+    if (!future.isReady()) {
+      LOG(WARNING) << "Failed to sample resource usage: "
+                   << (future.isFailed() ? future.failure() : "discarded");
+
+      delay(interval, self(), &Self::sample);
+      return;
+    }
+
+    hashset<string> active;
+    hashmap<string, ExecutorInfo> infos;
+    Option<string> interfered;
+
+    foreach (const ResourceUsage& usage, future.get()) {
+      if (!usage.has_executor_info() || !usage.has_statistics()) {
+        continue;
+      }
+
+      const string id = key(usage.executor_info());
+      active.insert(id);
+      infos[id] = usage.executor_info();
+
+      if (!executors.contains(id)) {
+        executors.put(id, Samples(window));
+      }
+
+      if (update(&executors.at(id), usage)) {
+        interfered = id;
+      }
+    }
+
+    // Drop the samples of executors that have terminated.
+    foreach (const string& id, executors.keys()) {
+      if (!active.contains(id)) {
+        executors.erase(id);
+        killed.erase(id);
+      }
+    }
+
+    if (interfered.isSome()) {
+      // Revoke the revocable executor which currently uses the most
+      // cpu, as it is the most likely source of the interference.
+      Option<string> victim;
+      foreachpair (const string& id, const Samples& samples, executors) {
+        if (!samples.revocable || killed.contains(id)) {
+          continue;
+        }
+
+        if (victim.isNone() ||
+            samples.cpus > executors.at(victim.get()).cpus) {
+          victim = id;
+        }
+      }
+
+      if (victim.isSome()) {
+        const ExecutorInfo& executorInfo = infos[victim.get()];
+
+        LOG(INFO) << "Detected interference on executor '"
+                  << infos[interfered.get()].executor_id() << "' of framework "
+                  << infos[interfered.get()].framework_id()
+                  << ", requesting to kill revocable executor '"
+                  << executorInfo.executor_id() << "' of framework "
+                  << executorInfo.framework_id();
+
+        QoSCorrection correction;
+        correction.set_type(QoSCorrection::KILL);
+        correction.mutable_kill()->mutable_framework_id()->CopyFrom(
+            executorInfo.framework_id());
+        correction.mutable_kill()->mutable_executor_id()->CopyFrom(
+            executorInfo.executor_id());
+
+        killed.insert(victim.get());
+
+        if (promise.get() != NULL) {
+          promise->set(list<QoSCorrection>({correction}));
+          promise.reset();
+        } else {
+          pending.push_back(correction);
+        }
+      }
+    }
+
+    delay(interval, self(), &Self::sample);
+  }
+
+  // Updates the samples of an executor and returns whether the
+  // executor is suffering from interference.
+  bool update(Samples* samples, const ResourceUsage& usage)
+  {
+    const ResourceStatistics& statistics = usage.statistics();
+
+    samples->revocable =
+      !Resources(usage.allocated()).revocable().empty() ||
+      !Resources(usage.executor_info().resources()).revocable().empty();
+
+    if (statistics.has_cpus_user_time_secs() &&
+        statistics.has_cpus_system_time_secs()) {
+      const double cpusTime =
+        statistics.cpus_user_time_secs() + statistics.cpus_system_time_secs();
+
+      if (samples->cpusTime.isSome() &&
+          samples->timestamp.isSome() &&
+          statistics.timestamp() > samples->timestamp.get()) {
+        samples->cpus =
+          (cpusTime - samples->cpusTime.get()) /
+          (statistics.timestamp() - samples->timestamp.get());
+      }
+
+      samples->cpusTime = cpusTime;
+      samples->timestamp = statistics.timestamp();
+    }
+
+    // Revocable executors are not protected.
+    if (samples->revocable ||
+        !statistics.has_perf() ||
+        statistics.perf().instructions() == 0) {
+      return false;
+    }
+
+    const double cpi =
+      static_cast<double>(statistics.perf().cycles()) /
+      statistics.perf().instructions();
+
+    Option<Statistics<double>> baseline =
+      Statistics<double>::from(samples->cpi);
+
+    if (baseline.isSome() &&
+        baseline.get().count >= MINIMUM_SAMPLES &&
+        cpi > threshold * baseline.get().p50) {
+      // NOTE: We keep the interfered samples out of the window so
+      // that the baseline reflects the executor running undisturbed.
+      return true;
+    }
+
+    samples->cpi.set(cpi);
+
+    return false;
+  }
+
+  const lambda::function<Future<list<ResourceUsage>>()> usages;
+  const Duration interval;
+  const Duration window;
+  const double threshold;
+
+  hashmap<string, Samples> executors;
+
+  // The revocable executors we have already requested to kill.
+  hashset<string> killed;
+
+  // Corrections that are not yet picked up by the slave.
+  list<QoSCorrection> pending;
+  Owned<Promise<list<QoSCorrection>>> promise;
+};
+
+
+InterferenceQoSController::InterferenceQoSController(
+    const Duration& _interval,
+    const Duration& _window,
+    double _threshold)
+  : interval(_interval),
+    window(_window),
+    threshold(_threshold) {}
+
+
+InterferenceQoSController::~InterferenceQoSController()
+{
+  if (process.get() != NULL) {
+    terminate(process.get());
+    wait(process.get());
+  }
+}
+
+
+Try<Nothing> InterferenceQoSController::initialize(
+    const lambda::function<Future<list<ResourceUsage>>()>& usages)
+{
+  if (process.get() != NULL) {
+    return Error("Interference QoS Controller has already been initialized");
+  }
+
+  process.reset(new InterferenceQoSControllerProcess(
+      usages, interval, window, threshold));
+
+  spawn(process.get());
+
+  return Nothing();
+}
+
+
+Future<list<QoSCorrection>> InterferenceQoSController::corrections()
+{
+  if (process.get() == NULL) {
+    return Failure("Interference QoS Controller is not initialized");
+  }
+
+  return dispatch(
+      process.get(),
+      &InterferenceQoSControllerProcess::corrections);
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,88 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SLAVE_QOS_CONTROLLERS_INTERFERENCE_HPP__
+#define __SLAVE_QOS_CONTROLLERS_INTERFERENCE_HPP__
+
+#include <list>
+
+#include <mesos/slave/qos_controller.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/lambda.hpp>
+
+#include <process/owned.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Forward declaration.
+class InterferenceQoSControllerProcess;
+
+
+// A QoS controller which protects executors running on regular
+// (non-revocable) resources from interference caused by revocable
+// executors. It samples the resource usage of all executors in a
+// tight loop and keeps a moving window of the cycles per instruction
+// (CPI) of every non-revocable executor, as reported by the
+// 'cgroups/perf_event' isolator. When the CPI of an executor rises
+// above the median of its window by more than a given factor, the
+// revocable executor with the highest cpu usage (as accounted by the
+// cpu cgroup) is killed.
+class InterferenceQoSController : public mesos::slave::QoSController
+{
+public:
+  // The interval between two usage samples.
+  static const Duration SAMPLE_INTERVAL;
+
+  // The length of the window the CPI baseline is computed over.
+  static const Duration WINDOW;
+
+  // The factor by which the CPI of an executor needs to exceed its
+  // baseline to be considered as interference.
+  static const double THRESHOLD;
+
+  explicit InterferenceQoSController(
+      const Duration& interval = SAMPLE_INTERVAL,
+      const Duration& window = WINDOW,
+      double threshold = THRESHOLD);
+
+  virtual ~InterferenceQoSController();
+
+  virtual Try<Nothing> initialize(
+      const lambda::function<
+          process::Future<std::list<ResourceUsage>>()>& usages);
+
+  virtual process::Future<std::list<mesos::slave::QoSCorrection>>
+    corrections();
+
+protected:
+  const Duration interval;
+  const Duration window;
+  const double threshold;
+
+  process::Owned<InterferenceQoSControllerProcess> process;
+};
+
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SLAVE_QOS_CONTROLLERS_INTERFERENCE_HPP__
@@ -19,6 +19,7 @@
 #include <stout/error.hpp>
 
 #include "slave/resource_estimators/noop.hpp"
+#include "slave/resource_estimators/usage.hpp"
 
 using std::string;
 
@@ -30,6 +31,8 @@ Try<ResourceEstimator*> ResourceEstimator::create(const Option<string>& type)
   // TODO(jieyu): Support loading resource estimator from module.
   if (type.isNone()) {
     return new internal::slave::NoopResourceEstimator();
+  } else if (type.get() == "usage") {
+    return new internal::slave::UsageResourceEstimator();
   }
 
   return Error("Unsupported resource estimator '" + type.get() + "'");
@@ -0,0 +1,285 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <string>
+
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
+#include <process/process.hpp>
+#include <process/statistics.hpp>
+#include <process/timeseries.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+#include <stout/option.hpp>
+
+#include "slave/resource_estimators/usage.hpp"
+
+using namespace process;
+
+using std::list;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+const Duration UsageResourceEstimator::SAMPLE_INTERVAL = Seconds(5);
+const Duration UsageResourceEstimator::WINDOW = Minutes(5);
+
+
+class UsageResourceEstimatorProcess :
+  public Process<UsageResourceEstimatorProcess>
+{
+public:
+  UsageResourceEstimatorProcess(
+      const lambda::function<Future<list<ResourceUsage>>()>& _usages,
+      const Duration& _interval,
+      const Duration& _window)
+    : usages(_usages),
+      interval(_interval),
+      window(_window) {}
+
+  Future<Resources> oversubscribable()
+  {
+    double cpus = 0.0;
+    Bytes mem = 0;
+
+    foreachvalue (const Samples& samples, executors) {
+      if (samples.revocable) {
+        continue;
+      }
+
+      // NOTE: We need at least two samples in the window before we
+      // estimate anything for an executor.
+      Option<Statistics<double>> cpusUsage = Statistics<double>::from(
+          samples.cpus);
+
+      if (cpusUsage.isSome() && samples.cpusLimit.isSome()) {
+        cpus += std::max(0.0, samples.cpusLimit.get() - cpusUsage.get().p95);
+      }
+
+      Option<Statistics<double>> memUsage = Statistics<double>::from(
+          samples.mem);
+
+      if (memUsage.isSome() && samples.memLimit.isSome()) {
+        const Bytes used = static_cast<uint64_t>(memUsage.get().p95);
+
+        if (samples.memLimit.get() > used) {
+          mem += samples.memLimit.get() - used;
+        }
+      }
+    }
+
+    Resources resources;
+
+    // Round down to avoid forwarding a new estimate to the master
+    // for every negligible change in usage.
+    cpus = floor(cpus * 100.0) / 100.0;
+    if (cpus > 0.0) {
+      resources += revocable("cpus", cpus);
+    }
+
+    if (mem.megabytes() > 0) {
+      resources += revocable("mem", mem.megabytes());
+    }
+
+    return resources;
+  }
+
+protected:
+  virtual void initialize()
+  {
+    sample();
+  }
+
+private:
+  struct Samples
+  {
+    explicit Samples(const Duration& window)
+      : revocable(false), cpus(window), mem(window) {}
+
+    // Whether the executor itself runs on revocable resources, in
+    // which case its slack must not be oversubscribed again.
+    bool revocable;
+
+    Option<double> cpusLimit;
+    Option<Bytes> memLimit;
+
+    // The previous cumulative cpu time and the timestamp it was
+    // sampled at, used to turn cpu times into a usage rate.
+    Option<double> cpusTime;
+    Option<double> timestamp;
+
+    TimeSeries<double> cpus;
+    TimeSeries<double> mem;
+  };
+
+  static Resource revocable(const std::string& name, double value)
+  {
+    Resource resource;
+    resource.set_name(name);
+    resource.set_type(Value::SCALAR);
+    resource.mutable_scalar()->set_value(value);
+    resource.set_role("*");
+    resource.mutable_revocable();
+    return resource;
+  }
+
+  static std::string key(const ExecutorInfo& executorInfo)
+  {
+    return executorInfo.framework_id().value() + "/" +
+           executorInfo.executor_id().value();
+  }
+
+  void sample()
+  {
+    usages()
+      .onAny(defer(self(), &Self::_sample, lambda::_1));
+  }
+
+  void _sample(const Future<list<ResourceUsage>>& future)
+  {
+    if (!future.isReady()) {
+      LOG(WARNING) << "Failed to sample resource usage: "
+                   << (future.isFailed() ? future.failure() : "discarded");
+    } else {
+      hashset<std::string> active;
+
+      foreach (const ResourceUsage& usage, future.get()) {
+        if (!usage.has_executor_info() || !usage.has_statistics()) {
+          continue;
+        }
+
+        const std::string id = key(usage.executor_info());
+        active.insert(id);
+
+        if (!executors.contains(id)) {
+          executors.put(id, Samples(window));
+        }
+
+        update(&executors.at(id), usage);
+      }
+
+      // Drop the samples of executors that have terminated.
+      foreach (const std::string& id, executors.keys()) {
+        if (!active.contains(id)) {
+          executors.erase(id);
+        }
+      }
+    }
+
+    delay(interval, self(), &Self::sample);
+  }
+
+  static void update(Samples* samples, const ResourceUsage& usage)
+  {
+    const ResourceStatistics& statistics = usage.statistics();
+
+    samples->revocable =
+      !Resources(usage.allocated()).revocable().empty() ||
+      !Resources(usage.executor_info().resources()).revocable().empty();
+
+    if (statistics.has_cpus_limit()) {
+      samples->cpusLimit = statistics.cpus_limit();
+    }
+
+    if (statistics.has_mem_limit_bytes()) {
+      samples->memLimit = Bytes(statistics.mem_limit_bytes());
+    }
+
+    if (statistics.has_mem_rss_bytes()) {
+      samples->mem.set(statistics.mem_rss_bytes());
+    }
+
+    if (statistics.has_cpus_user_time_secs() &&
+        statistics.has_cpus_system_time_secs()) {
+      const double cpusTime =
+        statistics.cpus_user_time_secs() + statistics.cpus_system_time_secs();
+
+      if (samples->cpusTime.isSome() &&
+          samples->timestamp.isSome() &&
+          statistics.timestamp() > samples->timestamp.get()) {
+        samples->cpus.set(
+            std::max(0.0, cpusTime - samples->cpusTime.get()) /
+            (statistics.timestamp() - samples->timestamp.get()));
+      }
+
+      samples->cpusTime = cpusTime;
+      samples->timestamp = statistics.timestamp();
+    }
+  }
+
+  const lambda::function<Future<list<ResourceUsage>>()> usages;
+  const Duration interval;
+  const Duration window;
+
+  hashmap<std::string, Samples> executors;
+};
+
+
+UsageResourceEstimator::UsageResourceEstimator(
+    const Duration& _interval,
+    const Duration& _window)
+  : interval(_interval),
+    window(_window) {}
+
+
+UsageResourceEstimator::~UsageResourceEstimator()
+{
+  if (process.get() != NULL) {
+    terminate(process.get());
+    wait(process.get());
+  }
+}
+
+
+Try<Nothing> UsageResourceEstimator::initialize(
+    const lambda::function<Future<list<ResourceUsage>>()>& usages)
+{
+  if (process.get() != NULL) {
+    return Error("Usage resource estimator has already been initialized");
+  }
+
+  process.reset(new UsageResourceEstimatorProcess(usages, interval, window));
+  spawn(process.get());
+
+  return Nothing();
+}
+
+
+Future<Resources> UsageResourceEstimator::oversubscribable()
+{
+  if (process.get() == NULL) {
+    return Failure("Usage resource estimator is not initialized");
+  }
+
+  return dispatch(
+      process.get(),
+      &UsageResourceEstimatorProcess::oversubscribable);
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,77 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SLAVE_RESOURCE_ESTIMATORS_USAGE_HPP__
+#define __SLAVE_RESOURCE_ESTIMATORS_USAGE_HPP__
+
+#include <mesos/slave/resource_estimator.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/lambda.hpp>
+
+#include <process/owned.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Forward declaration.
+class UsageResourceEstimatorProcess;
+
+
+// A resource estimator which periodically samples the resource usage
+// of all executors on the slave and keeps a moving window of their
+// cpu and memory consumption. The resources an executor has been
+// allocated but has not used within the window (measured against a
+// high percentile of its usage rather than the mean, so that bursty
+// executors are not squeezed) are reported as oversubscribable.
+class UsageResourceEstimator : public mesos::slave::ResourceEstimator
+{
+public:
+  // The interval between two usage samples.
+  static const Duration SAMPLE_INTERVAL;
+
+  // The length of the moving window the usage statistics are
+  // computed over.
+  static const Duration WINDOW;
+
+  explicit UsageResourceEstimator(
+      const Duration& interval = SAMPLE_INTERVAL,
+      const Duration& window = WINDOW);
+
+  virtual ~UsageResourceEstimator();
+
+  virtual Try<Nothing> initialize(
+      const lambda::function<
+          process::Future<std::list<ResourceUsage>>()>& usages);
+
+  virtual process::Future<Resources> oversubscribable();
+
+protected:
+  const Duration interval;
+  const Duration window;
+
+  process::Owned<UsageResourceEstimatorProcess> process;
+};
+
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SLAVE_RESOURCE_ESTIMATORS_USAGE_HPP__
@@ -36,6 +36,7 @@
 
 #include <process/async.hpp>
 #include <process/check.hpp>
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
@@ -64,6 +65,7 @@
 
 #ifdef __linux__
 #include "linux/cgroups.hpp"
+#include "linux/numa.hpp"
 #endif // __linux__
 
 #include "authentication/cram_md5/authenticatee.hpp"
@@ -83,10 +85,13 @@
 
 #include "slave/constants.hpp"
 #include "slave/flags.hpp"
+#include "slave/logs.hpp"
 #include "slave/paths.hpp"
 #include "slave/slave.hpp"
 #include "slave/status_update_manager.hpp"
 
+using mesos::slave::QoSController;
+using mesos::slave::QoSCorrection;
 using mesos::slave::ResourceEstimator;
 
 using std::list;
@@ -98,8 +103,11 @@ using std::vector;
 using process::async;
 using process::wait; // Necessary on some OS's to disambiguate.
 using process::Clock;
+using process::collect;
+using process::Event;
 using process::Failure;
 using process::Future;
+using process::HttpEvent;
 using process::Owned;
 using process::Time;
 using process::UPID;
@@ -118,19 +126,27 @@ Slave::Slave(const slave::Flags& _flags,
              Files* _files,
              GarbageCollector* _gc,
              StatusUpdateManager* _statusUpdateManager,
-             ResourceEstimator* _resourceEstimator)
+             ResourceEstimator* _resourceEstimator,
+             QoSController* _qosController)
   : ProcessBase(process::ID::generate("slave")),
     state(RECOVERING),
     flags(_flags),
     completedFrameworks(MAX_COMPLETED_FRAMEWORKS),
+    stateVersion(0),
+    reading(false),
     detector(_detector),
     containerizer(_containerizer),
     files(_files),
     metrics(*this),
     gc(_gc),
-    monitor(containerizer),
+    monitor(
+        containerizer,
+        flags.resource_monitoring_interval,
+        flags.resource_monitoring_window),
     statusUpdateManager(_statusUpdateManager),
+    summarizing(false),
     metaDir(paths::getMetaRootDir(flags.work_dir)),
+    store(NULL),
     recoveryErrors(0),
     credential(None()),
     authenticatee(NULL),
@@ -138,7 +154,8 @@ Slave::Slave(const slave::Flags& _flags,
     authenticated(false),
     reauthenticate(false),
     executorDirectoryMaxAllowedAge(age(0)),
-    resourceEstimator(_resourceEstimator) {}
+    resourceEstimator(_resourceEstimator),
+    qosController(_qosController) {}
 
 
 Slave::~Slave()
@@ -153,6 +170,11 @@ Slave::~Slave()
   }
 
   delete authenticatee;
+
+  if (store != NULL) {
+    state::Store::uninstall(store);
+    delete store;
+  }
 }
 
 
@@ -323,14 +345,21 @@ void Slave::initialize()
             << "' for --gc_disk_headroom. Must be between 0.0 and 1.0.";
   }
 
-  Try<Nothing> initialize = resourceEstimator->initialize(
-      lambda::bind(&ResourceMonitor::usages, &monitor));
+  Try<Nothing> initialize =
+    resourceEstimator->initialize(defer(self(), &Self::usages));
 
   if (initialize.isError()) {
     EXIT(1) << "Failed to initialize the resource estimator: "
             << initialize.error();
   }
 
+  initialize = qosController->initialize(defer(self(), &Self::usages));
+
+  if (initialize.isError()) {
+    EXIT(1) << "Failed to initialize the QoS controller: "
+            << initialize.error();
+  }
+
   // Ensure slave work directory exists.
   CHECK_SOME(os::mkdir(flags.work_dir))
     << "Failed to create slave work directory '" << flags.work_dir << "'";
@@ -346,6 +375,36 @@ void Slave::initialize()
     attributes = Attributes::parse(flags.attributes.get());
   }
 
+#ifdef __linux__
+  // Advertise the NUMA topology of the machine so that frameworks can
+  // place memory bandwidth sensitive tasks accordingly (the cpuset
+  // isolator keeps the cpus of a container within a node if it can).
+  // Attributes specified with --attributes take precedence.
+  if (strings::contains(flags.isolation, "cgroups/cpuset")) {
+    Try<map<int, set<int>>> nodes = numa::nodes();
+    if (nodes.isError()) {
+      LOG(WARNING) << "Failed to determine the NUMA topology: "
+                   << nodes.error();
+    } else {
+      hashmap<string, string> topology;
+      topology["numa_nodes"] = stringify(nodes.get().size());
+      topology["numa_cpus_per_node"] =
+        stringify(nodes.get().begin()->second.size());
+
+      foreachpair (const string& name, const string& value, topology) {
+        bool specified = false;
+        foreach (const Attribute& attribute, attributes) {
+          specified = specified || attribute.name() == name;
+        }
+
+        if (!specified) {
+          attributes.add(Attributes::parse(name, value));
+        }
+      }
+    }
+  }
+#endif // __linux__
+
   // Determine our hostname or use the hostname provided.
   string hostname;
 
@@ -384,6 +443,12 @@ void Slave::initialize()
   // a very large disk_watch_interval).
   delay(flags.disk_watch_interval, self(), &Slave::checkDiskUsage);
 
+  if (flags.container_logs_max_size.isSome()) {
+    delay(flags.container_logs_rotation_interval,
+          self(),
+          &Slave::rotateContainerLogs);
+  }
+
   startTime = Clock::now();
 
   // Install protobuf handlers.
@@ -396,6 +461,10 @@ void Slave::initialize()
       &SlaveReregisteredMessage::slave_id,
       &SlaveReregisteredMessage::reconciliations);
 
+  install<SlaveRegistrationThrottledMessage>(
+      &Slave::registrationThrottled,
+      &SlaveRegistrationThrottledMessage::retry_after);
+
   install<RunTaskMessage>(
       &Slave::runTask,
       &RunTaskMessage::framework,
@@ -403,6 +472,14 @@ void Slave::initialize()
       &RunTaskMessage::pid,
       &RunTaskMessage::task);
 
+  install<RunTasksMessage>(
+      &Slave::runTasks,
+      &RunTasksMessage::framework,
+      &RunTasksMessage::framework_id,
+      &RunTasksMessage::pid,
+      &RunTasksMessage::tasks,
+      &RunTasksMessage::traces);
+
   install<KillTaskMessage>(
       &Slave::killTask,
       &KillTaskMessage::framework_id,
@@ -440,10 +517,15 @@ void Slave::initialize()
       &StatusUpdateAcknowledgementMessage::task_id,
       &StatusUpdateAcknowledgementMessage::uuid);
 
+  install<StatusUpdateAcknowledgementsMessage>(
+      &Slave::statusUpdateAcknowledgements,
+      &StatusUpdateAcknowledgementsMessage::acknowledgements);
+
   install<RegisterExecutorMessage>(
       &Slave::registerExecutor,
       &RegisterExecutorMessage::framework_id,
-      &RegisterExecutorMessage::executor_id);
+      &RegisterExecutorMessage::executor_id,
+      &RegisterExecutorMessage::accepts_queued_tasks);
 
   install<ReregisterExecutorMessage>(
       &Slave::reregisterExecutor,
@@ -457,6 +539,10 @@ void Slave::initialize()
       &StatusUpdateMessage::update,
       &StatusUpdateMessage::pid);
 
+  install<StatusUpdatesMessage>(
+      &Slave::statusUpdates,
+      &StatusUpdatesMessage::updates);
+
   install<ExecutorToFrameworkMessage>(
       &Slave::executorMessage,
       &ExecutorToFrameworkMessage::slave_id,
@@ -491,6 +577,12 @@ void Slave::initialize()
           Http::log(request);
           return http.state(request);
         });
+  route("/trace",
+        Http::TRACE_HELP,
+        [http](const http::Request& request) {
+          Http::log(request);
+          return http.trace(request);
+        });
 
   // Expose the log file for the webui. Fall back to 'log_dir' if
   // an explicit file was not specified.
@@ -537,10 +629,62 @@ void Slave::initialize()
     EXIT(1) << "Failed to set sigaction: " << strerror(errno);
   }
 
+  // Set up the checkpoint store before recovering the checkpoints.
+  if (flags.checkpoint_store == "leveldb") {
+    Try<state::Store*> create = state::Store::create(metaDir);
+    if (create.isError()) {
+      EXIT(1) << "Failed to create checkpoint store: " << create.error();
+    }
+
+    store = create.get();
+
+    Try<size_t> import = store->import();
+    if (import.isError()) {
+      EXIT(1) << "Failed to import checkpoints into the checkpoint store: "
+              << import.error();
+    }
+
+    state::Store::install(store);
+  } else if (flags.checkpoint_store == "directory") {
+    // Migrate the checkpoints of a previous run with a checkpoint
+    // store back to files.
+    const string& path = paths::getCheckpointStorePath(metaDir);
+
+    if (os::exists(path)) {
+      Try<state::Store*> create = state::Store::create(metaDir);
+      if (create.isError()) {
+        EXIT(1) << "Failed to open checkpoint store: " << create.error();
+      }
+
+      Try<size_t> unpack = create.get()->unpack();
+      delete create.get();
+
+      if (unpack.isError()) {
+        EXIT(1) << "Failed to unpack checkpoint store: " << unpack.error();
+      }
+
+      Try<Nothing> rmdir = os::rmdir(path);
+      if (rmdir.isError()) {
+        EXIT(1) << "Failed to remove checkpoint store '" << path << "': "
+                << rmdir.error();
+      }
+
+      LOG(INFO) << "Unpacked " << unpack.get() << " checkpoints from '"
+                << path << "'";
+    }
+  } else {
+    EXIT(1) << "Unknown checkpoint store '" << flags.checkpoint_store << "'";
+  }
+
   // Do recovery.
-  async(&state::recover, metaDir, flags.strict)
-    .then(defer(self(), &Slave::recover, lambda::_1))
-    .then(defer(self(), &Slave::_recover))
+  metrics.recovery_total.time(
+      metrics.recovery_state.time(
+          async(&state::recover,
+                metaDir,
+                flags.strict,
+                flags.recovery_workers))
+        .then(defer(self(), &Slave::recover, lambda::_1))
+        .then(defer(self(), &Slave::_recover)))
     .onAny(defer(self(), &Slave::__recover, lambda::_1));
 }
 
@@ -653,6 +797,9 @@ void Slave::detected(const Future<Option<MasterInfo>>& _master)
 
   Option<MasterInfo> latest;
 
+  // A new master has its own (re-)registration rate limit, if any.
+  throttledUntil = None();
+
   if (_master.isDiscarded()) {
     LOG(INFO) << "Re-detecting master";
     latest = None();
@@ -892,6 +1039,34 @@ void Slave::registered(const UPID& from, const SlaveID& slaveId)
 }
 
 
+void Slave::registrationThrottled(const UPID& from, double retryAfter)
+{
+  if (master != from) {
+    LOG(WARNING) << "Ignoring registration throttled message from " << from
+                 << " because it is not the expected master: "
+                 << (master.isSome() ? stringify(master.get()) : "None");
+    return;
+  }
+
+  if (state != DISCONNECTED) {
+    return;
+  }
+
+  Try<Duration> duration = Duration::create(retryAfter);
+  if (duration.isError()) {
+    LOG(WARNING) << "Ignoring registration throttled message from " << from
+                 << " because of an invalid retry after " << retryAfter
+                 << ": " << duration.error();
+    return;
+  }
+
+  LOG(INFO) << "Master " << from << " throttled the (re-)registration;"
+            << " retrying in " << duration.get();
+
+  throttledUntil = Clock::now() + duration.get();
+}
+
+
 void Slave::reregistered(
     const UPID& from,
     const SlaveID& slaveId,
@@ -1017,6 +1192,19 @@ void Slave::doReliableRegistration(Duration maxBackoff)
 
   CHECK_NE("cleanup", flags.recover);
 
+  // Retry once the master is ready to admit us, with the same
+  // backoff as this attempt would have used.
+  if (throttledUntil.isSome() && Clock::now() < throttledUntil.get()) {
+    Duration delay = throttledUntil.get() - Clock::now();
+
+    VLOG(1) << "Will retry registration in " << delay
+            << " as asked by the master";
+
+    process::delay(
+        delay, self(), &Slave::doReliableRegistration, maxBackoff);
+    return;
+  }
+
   if (!info.has_id()) {
     // Registering for the first time.
     RegisterSlaveMessage message;
@@ -1238,7 +1426,21 @@ void Slave::runTask(
     }
   }
 
-  const ExecutorInfo& executorInfo = getExecutorInfo(frameworkId, task);
+  ExecutorInfo executorInfo = getExecutorInfo(frameworkId, task);
+
+  // Reuse the container of an idle command executor if possible,
+  // see '--command_executor_idle_timeout'.
+  if (task.has_command() && flags.command_executor_idle_timeout.isSome()) {
+    Executor* executor = framework->getIdleExecutor(executorInfo);
+    if (executor != NULL) {
+      LOG(INFO) << "Reusing idle command executor '" << executor->id
+                << "' for task " << task.task_id()
+                << " of framework " << frameworkId;
+
+      executorInfo = executor->info;
+    }
+  }
+
   const ExecutorID& executorId = executorInfo.executor_id();
 
   // We add the task to 'pending' to ensure the framework is not
@@ -1290,6 +1492,8 @@ void Slave::_runTask(
   LOG(INFO) << "Launching task " << task.task_id()
             << " for framework " << frameworkId;
 
+  tracer.record(frameworkId, task.task_id(), "slave/unschedule");
+
   Framework* framework = getFramework(frameworkId);
   if (framework == NULL) {
      LOG(WARNING) << "Ignoring run task " << task.task_id()
@@ -1298,14 +1502,33 @@ void Slave::_runTask(
      return;
   }
 
-  const ExecutorInfo& executorInfo = getExecutorInfo(frameworkId, task);
-  const ExecutorID& executorId = executorInfo.executor_id();
+  // NOTE: The executor was chosen in 'runTask()', which might have
+  // been an idle command executor rather than the one generated for
+  // the task (see '--command_executor_idle_timeout').
+  Option<ExecutorID> pending = None();
+  foreachkey (const ExecutorID& executorId, framework->pending) {
+    if (framework->pending[executorId].contains(task.task_id())) {
+      pending = executorId;
+      break;
+    }
+  }
 
-  if (framework->pending.contains(executorId) &&
-      framework->pending[executorId].contains(task.task_id())) {
-    framework->pending[executorId].erase(task.task_id());
-    if (framework->pending[executorId].empty()) {
-        framework->pending.erase(executorId);
+  ExecutorInfo executorInfo = getExecutorInfo(frameworkId, task);
+
+  if (pending.isSome()) {
+    framework->pending[pending.get()].erase(task.task_id());
+    if (framework->pending[pending.get()].empty()) {
+        framework->pending.erase(pending.get());
+    }
+
+    // Use the idle command executor unless it has terminated in the
+    // meantime (e.g., because it timed out), in which case we launch
+    // a new command executor instead.
+    Executor* executor = framework->getExecutor(pending.get());
+    if (!(pending.get() == executorInfo.executor_id()) &&
+        executor != NULL &&
+        executor->state == Executor::RUNNING) {
+      executorInfo = executor->info;
     }
   } else {
     LOG(WARNING) << "Ignoring run task " << task.task_id()
@@ -1396,6 +1619,8 @@ void Slave::_runTask(
 
   CHECK(framework->state == Framework::RUNNING) << framework->state;
 
+  const ExecutorID& executorId = executorInfo.executor_id();
+
   // Either send the task to an executor or start a new executor
   // and queue the task until the executor has started.
   Executor* executor = framework->getExecutor(executorId);
@@ -1438,6 +1663,7 @@ void Slave::_runTask(
                   << " of framework '" << frameworkId;
 
       executor->queuedTasks[task.task_id()] = task;
+      framework->changed();
       break;
     case Executor::RUNNING: {
       // Checkpoint the task before we do anything else.
@@ -1452,28 +1678,21 @@ void Slave::_runTask(
                   << " of framework '" << frameworkId;
 
       executor->queuedTasks[task.task_id()] = task;
+      framework->changed();
 
-      // Update the resource limits for the container. Note that the
-      // resource limits include the currently queued tasks because we
-      // want the container to have enough resources to hold the
-      // upcoming tasks.
-      Resources resources = executor->resources;
-
-      // TODO(jieyu): Use foreachvalue instead once LinkedHashmap
-      // supports it.
-      foreach (const TaskInfo& task, executor->queuedTasks.values()) {
-        resources += task.resources();
-      }
+      // The containerizer is updated once for all the tasks that are
+      // queued for the executor before '_runTasks()' runs, e.g., the
+      // tasks of a 'RunTasksMessage'.
+      executor->batchedTasks.push_back(task);
 
-      containerizer->update(executor->containerId, resources)
-        .onAny(defer(
+      if (executor->batchedTasks.size() == 1) {
+        dispatch(
             self(),
-            &Self::runTasks,
-            lambda::_1,
+            &Self::_runTasks,
             frameworkId,
             executorId,
-            executor->containerId,
-            list<TaskInfo>({task})));
+            executor->containerId);
+      }
       break;
     }
     default:
@@ -1486,6 +1705,87 @@ void Slave::_runTask(
 
 
 void Slave::runTasks(
+    const UPID& from,
+    const FrameworkInfo& frameworkInfo,
+    const FrameworkID& frameworkId,
+    const string& pid,
+    const vector<TaskInfo>& tasks,
+    const vector<RunTasksMessage::Trace>& traces)
+{
+  LOG(INFO) << "Got assigned " << tasks.size() << " tasks for framework "
+            << frameworkId;
+
+  foreach (const RunTasksMessage::Trace& trace, traces) {
+    tracer.start(
+        frameworkId, trace.task_id(), trace.trace_id(), Clock::now());
+  }
+
+  // NOTE: The tasks are handled one by one just like the tasks of
+  // 'RunTaskMessage's, but since 'runTask()' continues asynchronously
+  // the tasks for the same running executor end up sharing a single
+  // update of the executor's container, see '_runTasks()'.
+  foreach (const TaskInfo& task, tasks) {
+    runTask(from, frameworkInfo, frameworkId, pid, task);
+  }
+}
+
+
+void Slave::_runTasks(
+    const FrameworkID& frameworkId,
+    const ExecutorID& executorId,
+    const ContainerID& containerId)
+{
+  Framework* framework = getFramework(frameworkId);
+  if (framework == NULL) {
+    return;
+  }
+
+  // NOTE: The batched tasks are gone along with the executor.
+  Executor* executor = framework->getExecutor(executorId);
+  if (executor == NULL || executor->containerId != containerId) {
+    return;
+  }
+
+  // The batched tasks are picked up once the executor has been sent
+  // its registration (see '_registerExecutor()').
+  if (executor->registrationPending) {
+    return;
+  }
+
+  list<TaskInfo> tasks;
+  std::swap(tasks, executor->batchedTasks);
+
+  // The queued tasks of a terminating executor are handled once it
+  // terminated (see 'executorTerminated()').
+  if (executor->state != Executor::RUNNING) {
+    return;
+  }
+
+  // Update the resource limits for the container. Note that the
+  // resource limits include the currently queued tasks because we
+  // want the container to have enough resources to hold the
+  // upcoming tasks.
+  Resources resources = executor->resources;
+
+  // TODO(jieyu): Use foreachvalue instead once LinkedHashmap
+  // supports it.
+  foreach (const TaskInfo& task, executor->queuedTasks.values()) {
+    resources += task.resources();
+  }
+
+  containerizer->update(containerId, resources)
+    .onAny(defer(
+        self(),
+        &Self::__runTasks,
+        lambda::_1,
+        frameworkId,
+        executorId,
+        containerId,
+        tasks));
+}
+
+
+void Slave::__runTasks(
     const Future<Nothing>& future,
     const FrameworkID& frameworkId,
     const ExecutorID& executorId,
@@ -1585,6 +1885,8 @@ void Slave::runTasks(
     // Add the task and send it to the executor.
     executor->addTask(task);
 
+    tracer.record(frameworkId, task.task_id(), "slave/container_update");
+
     LOG(INFO) << "Sending queued task '" << task.task_id()
               << "' to executor '" << executor->id
               << "' of framework " << framework->id();
@@ -2110,6 +2412,22 @@ void Slave::statusUpdateAcknowledgement(
 }
 
 
+void Slave::statusUpdateAcknowledgements(
+    const UPID& from,
+    const vector<StatusUpdateAcknowledgementMessage>& acknowledgements)
+{
+  foreach (const StatusUpdateAcknowledgementMessage& acknowledgement,
+           acknowledgements) {
+    statusUpdateAcknowledgement(
+        from,
+        acknowledgement.slave_id(),
+        acknowledgement.framework_id(),
+        acknowledgement.task_id(),
+        acknowledgement.uuid());
+  }
+}
+
+
 void Slave::_statusUpdateAcknowledgement(
     const Future<bool>& future,
     const TaskID& taskId,
@@ -2183,7 +2501,8 @@ void Slave::_statusUpdateAcknowledgement(
 void Slave::registerExecutor(
     const UPID& from,
     const FrameworkID& frameworkId,
-    const ExecutorID& executorId)
+    const ExecutorID& executorId,
+    bool acceptsQueuedTasks)
 {
   LOG(INFO) << "Got registration for executor '" << executorId
             << "' of framework " << frameworkId << " from "
@@ -2276,14 +2595,25 @@ void Slave::registerExecutor(
         CHECK_SOME(state::checkpoint(path, executor->pid));
       }
 
-      // Tell executor it's registered and give it any queued tasks.
-      ExecutorRegisteredMessage message;
-      message.mutable_executor_info()->MergeFrom(executor->info);
-      message.mutable_framework_id()->MergeFrom(framework->id());
-      message.mutable_framework_info()->MergeFrom(framework->info);
-      message.mutable_slave_id()->MergeFrom(info.id());
-      message.mutable_slave_info()->MergeFrom(info);
-      send(executor->pid, message);
+      // The executor is only told that it is registered once the
+      // container holds the resources of the queued tasks, so that
+      // the queued tasks can be sent along in the same message.
+      // Until then the tasks for the now running executor are held
+      // back in 'batchedTasks' (see '_runTasks()').
+      executor->registrationPending = true;
+
+      list<TaskInfo> tasks = executor->queuedTasks.values();
+
+      if (tasks.empty()) {
+        _registerExecutor(
+            Nothing(),
+            frameworkId,
+            executorId,
+            executor->containerId,
+            tasks,
+            acceptsQueuedTasks);
+        break;
+      }
 
       // Update the resource limits for the container. Note that the
       // resource limits include the currently queued tasks because we
@@ -2291,21 +2621,20 @@ void Slave::registerExecutor(
       // upcoming tasks.
       Resources resources = executor->resources;
 
-      // TODO(jieyu): Use foreachvalue instead once LinkedHashmap
-      // supports it.
-      foreach (const TaskInfo& task, executor->queuedTasks.values()) {
+      foreach (const TaskInfo& task, tasks) {
         resources += task.resources();
       }
 
       containerizer->update(executor->containerId, resources)
         .onAny(defer(
             self(),
-            &Self::runTasks,
+            &Self::_registerExecutor,
             lambda::_1,
             frameworkId,
             executorId,
             executor->containerId,
-            executor->queuedTasks.values()));
+            tasks,
+            acceptsQueuedTasks));
       break;
     }
     default:
@@ -2317,6 +2646,99 @@ void Slave::registerExecutor(
 }
 
 
+void Slave::_registerExecutor(
+    const Future<Nothing>& future,
+    const FrameworkID& frameworkId,
+    const ExecutorID& executorId,
+    const ContainerID& containerId,
+    const list<TaskInfo>& tasks,
+    bool acceptsQueuedTasks)
+{
+  if (!future.isReady()) {
+    LOG(ERROR) << "Failed to update resources for container " << containerId
+               << " of executor '" << executorId
+               << "' of framework " << frameworkId
+               << ", destroying container: "
+               << (future.isFailed() ? future.failure() : "discarded");
+
+    containerizer->destroy(containerId);
+    return;
+  }
+
+  Framework* framework = getFramework(frameworkId);
+  if (framework == NULL || framework->state == Framework::TERMINATING) {
+    return;
+  }
+
+  // NOTE: If the executor is terminating the queued tasks are handled
+  // once it terminated (see 'executorTerminated()').
+  Executor* executor = framework->getExecutor(executorId);
+  if (executor == NULL ||
+      executor->containerId != containerId ||
+      executor->state != Executor::RUNNING) {
+    return;
+  }
+
+  executor->registrationPending = false;
+
+  ExecutorRegisteredMessage message;
+  message.mutable_executor_info()->MergeFrom(executor->info);
+  message.mutable_framework_id()->MergeFrom(framework->id());
+  message.mutable_framework_info()->MergeFrom(framework->info);
+  message.mutable_slave_id()->MergeFrom(info.id());
+  message.mutable_slave_info()->MergeFrom(info);
+  message.set_status_update_batch_size(
+      flags.executor_status_update_batch_size);
+
+  // Older executor drivers are sent the tasks separately.
+  list<TaskInfo> separately;
+  foreach (const TaskInfo& task, tasks) {
+    // This is the case where the task is killed. No need to send
+    // status update because it should be handled in 'killTask'.
+    if (!executor->queuedTasks.contains(task.task_id())) {
+      continue;
+    }
+
+    executor->queuedTasks.erase(task.task_id());
+    executor->addTask(task);
+
+    LOG(INFO) << "Sending queued task '" << task.task_id()
+              << "' to executor '" << executor->id
+              << "' of framework " << framework->id();
+
+    tracer.record(frameworkId, task.task_id(), "slave/executor_registration");
+
+    if (acceptsQueuedTasks) {
+      message.add_tasks()->MergeFrom(task);
+    } else {
+      separately.push_back(task);
+    }
+  }
+
+  send(executor->pid, message);
+
+  foreach (const TaskInfo& task, separately) {
+    RunTaskMessage runTaskMessage;
+    runTaskMessage.mutable_framework_id()->MergeFrom(framework->id());
+    runTaskMessage.mutable_framework()->MergeFrom(framework->info);
+    runTaskMessage.set_pid(framework->pid);
+    runTaskMessage.mutable_task()->MergeFrom(task);
+    send(executor->pid, runTaskMessage);
+  }
+
+  // Handle the tasks that were held back while the executor was
+  // waiting for this message.
+  if (!executor->batchedTasks.empty()) {
+    dispatch(
+        self(),
+        &Self::_runTasks,
+        frameworkId,
+        executorId,
+        containerId);
+  }
+}
+
+
 void _monitor(
     const Future<Nothing>& monitor,
     const FrameworkID& frameworkId,
@@ -2395,6 +2817,8 @@ void Slave::reregisterExecutor(
       ExecutorReregisteredMessage message;
       message.mutable_slave_id()->MergeFrom(info.id());
       message.mutable_slave_info()->MergeFrom(info);
+      message.set_status_update_batch_size(
+          flags.executor_status_update_batch_size);
       send(executor->pid, message);
 
       // Handle all the pending updates.
@@ -2549,6 +2973,14 @@ void Slave::reregisterExecutorTimeout()
 // reliable delivery of status updates. Since executor driver caches
 // unacked updates it is important that whoever sent the update gets
 // acknowledgement for it.
+void Slave::statusUpdates(const vector<StatusUpdateMessage>& updates)
+{
+  foreach (const StatusUpdateMessage& update, updates) {
+    statusUpdate(update.update(), update.pid());
+  }
+}
+
+
 void Slave::statusUpdate(StatusUpdate update, const UPID& pid)
 {
   LOG(INFO) << "Handling status update " << update << " from " << pid;
@@ -2584,6 +3016,14 @@ void Slave::statusUpdate(StatusUpdate update, const UPID& pid)
 
   TaskStatus status = update.status();
 
+  // A traced launch ends once the task is running (or terminal).
+  if (status.state() == TASK_RUNNING) {
+    tracer.record(framework->id(), status.task_id(), "executor/task_start");
+    tracer.stop(framework->id(), status.task_id());
+  } else if (protobuf::isTerminalState(status.state())) {
+    tracer.stop(framework->id(), status.task_id());
+  }
+
   Executor* executor = framework->getExecutor(status.task_id());
   if (executor == NULL) {
     LOG(WARNING)  << "Could not find the executor for "
@@ -2822,7 +3262,53 @@ void Slave::forward(StatusUpdate update)
   message.mutable_update()->MergeFrom(update);
   message.set_pid(self()); // The ACK will be first received by the slave.
 
-  send(master.get(), message);
+  if (flags.status_update_batch_size <= 1) {
+    send(master.get(), message);
+    return;
+  }
+
+  // Batch the updates that are forwarded before the dispatched flush,
+  // i.e., the ones already queued for the slave. This bounds the added
+  // latency by the length of the slave's queue when it is under load,
+  // and adds none otherwise.
+  if (forwardedUpdates.updates_size() == 0) {
+    dispatch(self(), &Slave::flushStatusUpdates);
+  }
+
+  forwardedUpdates.add_updates()->CopyFrom(message);
+
+  if (forwardedUpdates.updates_size() >=
+      static_cast<int>(flags.status_update_batch_size)) {
+    flushStatusUpdates();
+  }
+}
+
+
+void Slave::flushStatusUpdates()
+{
+  if (forwardedUpdates.updates_size() == 0) {
+    return;
+  }
+
+  // NOTE: The status update manager retries the updates dropped here.
+  if (state != RUNNING) {
+    LOG(WARNING) << "Dropping " << forwardedUpdates.updates_size()
+                 << " status updates because the slave is in "
+                 << state << " state";
+  } else {
+    CHECK_SOME(master);
+
+    VLOG(1) << "Forwarding " << forwardedUpdates.updates_size()
+            << " status updates to " << master.get();
+
+    if (forwardedUpdates.updates_size() == 1) {
+      send(master.get(), forwardedUpdates.updates(0));
+    } else {
+      send(master.get(), forwardedUpdates);
+    }
+  }
+
+  forwardedUpdates.Clear();
 }
 
 
@@ -2884,6 +3370,10 @@ void Slave::pingOld(const UPID& from, const string& body)
 {
   VLOG(1) << "Received ping from " << from;
 
+  // A ping leaves the state unchanged (a forced re-registration
+  // changes it in events of its own), see 'serve()'.
+  reading = true;
+
   if (!body.empty()) {
     // This must be a ping from 0.21.0 master.
     PingSlaveMessage message;
@@ -2915,7 +3405,18 @@ void Slave::pingOld(const UPID& from, const string& body)
       &Slave::pingTimeout,
       detection);
 
-  send(from, "PONG");
+  // The pong carries the most recent usage summary, if any, and a
+  // new summary is computed for the next pong.
+  PongSlaveMessage message;
+  if (usageSummary.isSome()) {
+    message.mutable_usage()->CopyFrom(usageSummary.get());
+  }
+
+  string data;
+  CHECK(message.SerializeToString(&data));
+  send(from, "PONG", data.data(), data.size());
+
+  summarize();
 }
 
 
@@ -2923,6 +3424,10 @@ void Slave::ping(const UPID& from, bool connected)
 {
   VLOG(1) << "Received ping from " << from;
 
+  // A ping leaves the state unchanged (a forced re-registration
+  // changes it in events of its own), see 'serve()'.
+  reading = true;
+
   if (!connected && state == RUNNING) {
     // This could happen if there is a one way partition between
     // the master and slave, causing the master to get an exited
@@ -2947,7 +3452,14 @@ void Slave::ping(const UPID& from, bool connected)
       &Slave::pingTimeout,
       detection);
 
-  send(from, PongSlaveMessage());
+  PongSlaveMessage message;
+  if (usageSummary.isSome()) {
+    message.mutable_usage()->CopyFrom(usageSummary.get());
+  }
+
+  send(from, message);
+
+  summarize();
 }
 
 
@@ -2977,6 +3489,37 @@ void Slave::exited(const UPID& pid)
 }
 
 
+void Slave::serve(const Event& event)
+{
+  reading = false;
+
+  Process<Slave>::serve(event);
+
+  if (!reading) {
+    ++stateVersion;
+  }
+}
+
+
+void Slave::visit(const HttpEvent& event)
+{
+  // A request with a safe method only reads the state, see
+  // 'Master::visit(const HttpEvent&)'.
+  reading = event.request->method == "GET" || event.request->method == "HEAD";
+
+  Process<Slave>::visit(event);
+}
+
+
+string Slave::etag() const
+{
+  // The start time tells apart the versions of different runs of the
+  // slave, which all start from the same version.
+  return "\"" + stringify(startTime.duration().ns()) + "-" +
+         stringify(stateVersion) + "\"";
+}
+
+
 Framework* Slave::getFramework(const FrameworkID& frameworkId)
 {
   if (frameworks.count(frameworkId) > 0) {
@@ -3077,6 +3620,14 @@ ExecutorInfo Slave::getExecutorInfo(
 
     if (path.isSome()) {
       executor.mutable_command()->set_value(path.get());
+
+      // Keep the executor running after its task terminated so that
+      // it can run subsequent tasks, see 'Framework::getIdleExecutor'.
+      if (flags.command_executor_idle_timeout.isSome()) {
+        executor.mutable_command()->set_value(
+            path.get() + " --idle_timeout=" +
+            stringify(flags.command_executor_idle_timeout.get()));
+      }
     } else {
       executor.mutable_command()->set_value(
           "echo '" +
@@ -3114,6 +3665,55 @@ ExecutorInfo Slave::getExecutorInfo(
 }
 
 
+Future<bool> Slave::launchContainer(
+    const FrameworkID& frameworkId,
+    const ExecutorID& executorId,
+    const ContainerID& containerId,
+    const Option<TaskInfo>& task,
+    const ExecutorInfo& executorInfo,
+    const Option<string>& user,
+    const string& directory)
+{
+  // Don't launch a container nobody is going to destroy, i.e., if
+  // the framework or executor has gone away or is terminating.
+  Framework* framework = getFramework(frameworkId);
+  if (framework == NULL || framework->state == Framework::TERMINATING) {
+    return Failure("Framework is no longer running");
+  }
+
+  Executor* executor = framework->getExecutor(executorId);
+  if (executor == NULL ||
+      executor->containerId != containerId ||
+      executor->state == Executor::TERMINATING) {
+    return Failure("Executor terminated before its container was launched");
+  }
+
+  files->attach(directory, directory)
+    .onAny(defer(self(), &Self::fileAttached, lambda::_1, directory));
+
+  if (task.isSome()) {
+    return containerizer->launch(
+        containerId,
+        task.get(),
+        executorInfo,
+        directory,
+        user,
+        info.id(),
+        self(),
+        framework->info.checkpoint());
+  }
+
+  return containerizer->launch(
+      containerId,
+      executorInfo,
+      directory,
+      user,
+      info.id(),
+      self(),
+      framework->info.checkpoint());
+}
+
+
 void Slave::executorLaunched(
     const FrameworkID& frameworkId,
     const ExecutorID& executorId,
@@ -3193,6 +3793,10 @@ void Slave::executorLaunched(
       break;
     case Executor::REGISTERING:
     case Executor::RUNNING:
+      foreach (const TaskInfo& task, executor->queuedTasks.values()) {
+        tracer.record(frameworkId, task.task_id(), "slave/container_launch");
+      }
+
       LOG(INFO) << "Monitoring executor '" << executorId
                 << "' of framework '" << frameworkId
                 << "' in container '" << containerId << "'";
@@ -3449,6 +4053,8 @@ void Slave::removeFramework(Framework* framework)
 
   LOG(INFO)<< "Cleaning up framework " << framework->id();
 
+  tracer.stop(framework->id());
+
   CHECK(framework->state == Framework::RUNNING ||
         framework->state == Framework::TERMINATING);
 
@@ -3482,6 +4088,9 @@ void Slave::removeFramework(Framework* framework)
 
   frameworks.erase(framework->id());
 
+  // The framework moves to 'completed_frameworks' of the state.
+  framework->changed();
+
   // Pass ownership of the framework pointer.
   completedFrameworks.push_back(Owned<Framework>(framework));
 
@@ -3767,6 +4376,48 @@ void Slave::_checkDiskUsage(const Future<double>& usage)
 }
 
 
+void Slave::rotateContainerLogs()
+{
+  CHECK_SOME(flags.container_logs_max_size);
+
+  vector<string> paths;
+  foreachvalue (Framework* framework, frameworks) {
+    foreachvalue (Executor* executor, framework->executors) {
+      if (executor->state == Executor::REGISTERING ||
+          executor->state == Executor::RUNNING) {
+        paths.push_back(path::join(executor->directory, "stdout"));
+        paths.push_back(path::join(executor->directory, "stderr"));
+      }
+    }
+  }
+
+  const Bytes maxSize = flags.container_logs_max_size.get();
+  const size_t maxBackups = flags.container_logs_max_backups;
+  const bool compress = flags.container_logs_compress;
+
+  // Copying (and compressing) large files takes a while, so we do
+  // it off the slave's actor.
+  async([=]() {
+    foreach (const string& path, paths) {
+      Try<bool> rotated = logs::rotate(path, maxSize, maxBackups, compress);
+      if (rotated.isError()) {
+        LOG(WARNING) << "Failed to rotate container log '" << path
+                     << "': " << rotated.error();
+      } else if (rotated.get()) {
+        VLOG(1) << "Rotated container log '" << path << "'";
+      }
+    }
+
+    return Nothing();
+  })
+  .onAny(defer(self(), [=]() {
+    delay(flags.container_logs_rotation_interval,
+          self(),
+          &Slave::rotateContainerLogs);
+  }));
+}
+
+
 Future<Nothing> Slave::recover(const Result<state::State>& state)
 {
   if (state.isError()) {
@@ -3852,15 +4503,18 @@ Future<Nothing> Slave::recover(const Result<state::State>& state)
     }
   }
 
-  return statusUpdateManager->recover(metaDir, slaveState)
-    .then(defer(self(), &Slave::_recoverContainerizer, slaveState));
-}
+  // The status update manager and the containerizer don't depend on
+  // each other's recovery, hence they are recovered concurrently.
+  list<Future<Nothing>> futures;
 
+  futures.push_back(metrics.recovery_status_update_manager.time(
+      statusUpdateManager->recover(metaDir, slaveState)));
 
-Future<Nothing> Slave::_recoverContainerizer(
-    const Option<state::SlaveState>& state)
-{
-  return containerizer->recover(state);
+  futures.push_back(metrics.recovery_containerizer.time(
+      containerizer->recover(slaveState)));
+
+  return collect(futures)
+    .then([]() { return Nothing(); });
 }
 
 
@@ -3918,7 +4572,7 @@ Future<Nothing> Slave::_recover()
     // We set 'recovered' flag inside reregisterExecutorTimeout(),
     // so that when the slave re-registers with master it can
     // correctly inform the master about the launched tasks.
-    return recovered.future();
+    return metrics.recovery_executors.time(recovered.future());
   }
 
   return Nothing();
@@ -3999,6 +4653,9 @@ void Slave::__recover(const Future<Nothing>& future)
 
     // Forward oversubscribed resources.
     forwardOversubscribed();
+
+    // Start acting on corrections from the QoS controller.
+    qosCorrections();
   } else {
     // Slave started in cleanup mode.
     CHECK_EQ("cleanup", flags.recover);
@@ -4160,6 +4817,197 @@ void Slave::_forwardOversubscribed(const Future<Resources>& oversubscribable)
 }
 
 
+Future<list<ResourceUsage>> Slave::usages()
+{
+  return monitor.usages()
+    .then(defer(self(), &Self::_usages, lambda::_1));
+}
+
+
+list<ResourceUsage> Slave::_usages(const list<ResourceUsage>& usages)
+{
+  list<ResourceUsage> result;
+
+  foreach (ResourceUsage usage, usages) {
+    const ExecutorInfo& executorInfo = usage.executor_info();
+
+    Framework* framework = getFramework(executorInfo.framework_id());
+    if (framework != NULL) {
+      Executor* executor = framework->getExecutor(executorInfo.executor_id());
+      if (executor != NULL) {
+        usage.mutable_allocated()->CopyFrom(executor->resources);
+      }
+    }
+
+    result.push_back(usage);
+  }
+
+  return result;
+}
+
+
+void Slave::summarize()
+{
+  if (summarizing) {
+    return;
+  }
+
+  summarizing = true;
+
+  monitor.usages()
+    .onAny(defer(self(), &Self::_summarize, lambda::_1));
+}
+
+
+void Slave::_summarize(const Future<list<ResourceUsage>>& usages)
+{
+  summarizing = false;
+
+  // Only the summary is updated, see 'serve()'.
+  reading = true;
+
+  if (!usages.isReady()) {
+    LOG(WARNING) << "Failed to get the resource usage of the executors: "
+                 << (usages.isFailed() ? usages.failure() : "discarded");
+    return;
+  }
+
+  // Only the fields that can be summed up across executors are kept
+  // to keep the summary (and hence the pongs) compact.
+  ResourceStatistics summary;
+  summary.set_timestamp(Clock::now().secs());
+  summary.set_cpus_limit(0.0);
+  summary.set_cpus_user_time_secs(0.0);
+  summary.set_cpus_system_time_secs(0.0);
+  summary.set_mem_rss_bytes(0);
+  summary.set_mem_limit_bytes(0);
+
+  foreach (const ResourceUsage& usage, usages.get()) {
+    if (!usage.has_statistics()) {
+      continue;
+    }
+
+    const ResourceStatistics& statistics = usage.statistics();
+
+    summary.set_cpus_limit(
+        summary.cpus_limit() + statistics.cpus_limit());
+    summary.set_cpus_user_time_secs(
+        summary.cpus_user_time_secs() + statistics.cpus_user_time_secs());
+    summary.set_cpus_system_time_secs(
+        summary.cpus_system_time_secs() + statistics.cpus_system_time_secs());
+    summary.set_mem_rss_bytes(
+        summary.mem_rss_bytes() + statistics.mem_rss_bytes());
+    summary.set_mem_limit_bytes(
+        summary.mem_limit_bytes() + statistics.mem_limit_bytes());
+  }
+
+  usageSummary = summary;
+}
+
+
+void Slave::qosCorrections()
+{
+  qosController->corrections()
+    .onAny(defer(self(), &Self::_qosCorrections, lambda::_1));
+}
+
+
+void Slave::_qosCorrections(const Future<list<QoSCorrection>>& future)
+{
+  // Make sure the correction handler is scheduled again.
+  delay(flags.qos_correction_interval_min, self(), &Self::qosCorrections);
+
+  CHECK(state == RECOVERING || state == DISCONNECTED ||
+        state == RUNNING || state == TERMINATING)
+    << state;
+
+  if (state == RECOVERING || state == TERMINATING) {
+    LOG(WARNING) << "Cannot perform QoS corrections because the slave is "
+                 << state;
+    return;
+  }
+
+  if (!future.isReady()) {
+    LOG(WARNING) << "Failed to get corrections from the QoS controller: "
+                 << (future.isFailed() ? future.failure() : "discarded");
+    return;
+  }
+
+  VLOG(1) << "Received " << future.get().size() << " QoS corrections";
+
+  foreach (const QoSCorrection& correction, future.get()) {
+    if (correction.type() != QoSCorrection::KILL) {
+      LOG(WARNING) << "QoS correction type " << correction.type()
+                   << " is not supported";
+      continue;
+    }
+
+    const QoSCorrection::Kill& kill = correction.kill();
+
+    if (!kill.has_framework_id() || !kill.has_executor_id()) {
+      LOG(WARNING) << "Ignoring QoS correction KILL: "
+                   << "framework or executor id not specified";
+      continue;
+    }
+
+    const FrameworkID& frameworkId = kill.framework_id();
+    const ExecutorID& executorId = kill.executor_id();
+
+    Framework* framework = getFramework(frameworkId);
+    if (framework == NULL || framework->state == Framework::TERMINATING) {
+      LOG(WARNING) << "Ignoring QoS correction KILL on executor '"
+                   << executorId << "' of framework " << frameworkId
+                   << ": framework cannot be found or is terminating";
+      continue;
+    }
+
+    Executor* executor = framework->getExecutor(executorId);
+    if (executor == NULL) {
+      LOG(WARNING) << "Ignoring QoS correction KILL on executor '"
+                   << executorId << "' of framework " << frameworkId
+                   << ": executor cannot be found";
+      continue;
+    }
+
+    // Only best-effort work may be revoked, i.e., executors that at
+    // least partly run on revocable resources.
+    if (executor->resources.revocable().empty()) {
+      LOG(WARNING) << "Ignoring QoS correction KILL on executor '"
+                   << executorId << "' of framework " << frameworkId
+                   << ": executor does not use revocable resources";
+      continue;
+    }
+
+    switch (executor->state) {
+      case Executor::REGISTERING:
+      case Executor::RUNNING:
+        LOG(INFO) << "Killing executor '" << executorId
+                  << "' of framework " << frameworkId
+                  << " as QoS correction";
+
+        executor->state = Executor::TERMINATING;
+        executor->reason = TaskStatus::REASON_EXECUTOR_PREEMPTED;
+
+        containerizer->destroy(executor->containerId);
+
+        ++metrics.executors_preempted;
+        break;
+      case Executor::TERMINATING:
+      case Executor::TERMINATED:
+        LOG(WARNING) << "Ignoring QoS correction KILL on executor '"
+                     << executorId << "' of framework " << frameworkId
+                     << ": executor is terminating/terminated";
+        break;
+      default:
+        LOG(FATAL) << "Executor '" << executor->id
+                   << "' of framework " << framework->id()
+                   << " is in unexpected state " << executor->state;
+        break;
+    }
+  }
+}
+
+
 // TODO(dhamon): Move these to their own metrics.hpp|cpp.
 double Slave::_tasks_staging()
 {
@@ -4273,7 +5121,9 @@ void Slave::sendExecutorTerminatedStatusUpdate(
   mesos::TaskState taskState = TASK_LOST;
   TaskStatus::Reason reason = TaskStatus::REASON_EXECUTOR_TERMINATED;
 
-  if (termination.isReady() && termination.get().killed()) {
+  if (executor->reason.isSome()) {
+    reason = executor->reason.get();
+  } else if (termination.isReady() && termination.get().killed()) {
     taskState = TASK_FAILED;
     // TODO(dhamon): MESOS-2035: Add 'reason' to containerizer::Termination.
     reason = TaskStatus::REASON_MEMORY_LIMIT;
@@ -4348,7 +5198,8 @@ Framework::Framework(
     slave(_slave),
     info(_info),
     pid(_pid),
-    completedExecutors(MAX_COMPLETED_EXECUTORS_PER_FRAMEWORK)
+    completedExecutors(MAX_COMPLETED_EXECUTORS_PER_FRAMEWORK),
+    version(++slave->stateVersion)
 {
   if (info.checkpoint() && slave->state != slave->RECOVERING) {
     // Checkpoint the framework info.
@@ -4407,14 +5258,14 @@ Executor* Framework::launchExecutor(
     }
   }
 
-  // Create a directory for the executor.
-  const string& directory = paths::createExecutorDirectory(
+  // The directory of the executor is created asynchronously (see
+  // below), its path is known upfront though.
+  const string directory = paths::getExecutorRunPath(
       slave->flags.work_dir,
       slave->info.id(),
       id(),
       executorInfo.executor_id(),
-      containerId,
-      user);
+      containerId);
 
   Executor* executor = new Executor(
       slave, id(), executorInfo, containerId, directory, info.checkpoint());
@@ -4428,16 +5279,12 @@ Executor* Framework::launchExecutor(
 
   executors[executorInfo.executor_id()] = executor;
 
+  changed();
+
   LOG(INFO) << "Launching executor " << executorInfo.executor_id()
             << " of framework " << id()
             << " in work directory '" << directory << "'";
 
-  slave->files->attach(executor->directory, executor->directory)
-    .onAny(defer(slave,
-                 &Slave::fileAttached,
-                 lambda::_1,
-                 executor->directory));
-
   // Tell the containerizer to launch the executor.
   // NOTE: We modify the ExecutorInfo to include the task's
   // resources when launching the executor so that the containerizer
@@ -4448,40 +5295,43 @@ Executor* Framework::launchExecutor(
   resources += taskInfo.resources();
   executorInfo_.mutable_resources()->CopyFrom(resources);
 
-  // Launch the container.
-  Future<bool> launch;
-  if (!executor->isCommandExecutor()) {
-    // If the executor is _not_ a command executor, this means that
-    // the task will include the executor to run. The actual task to
-    // run will be enqueued and subsequently handled by the executor
-    // when it has registered to the slave.
-    launch = slave->containerizer->launch(
-        containerId,
-        executorInfo_, // Modified to include the task's resources, see above.
-        executor->directory,
-        user,
-        slave->info.id(),
-        slave->self(),
-        info.checkpoint());
-  } else {
-    // An executor has _not_ been provided by the task and will
-    // instead define a command and/or container to run. Right now,
-    // these tasks will require an executor anyway and the slave
-    // creates a command executor. However, it is up to the
-    // containerizer how to execute those tasks and the generated
-    // executor info works as a placeholder.
-    // TODO(nnielsen): Obsolete the requirement for executors to run
-    // one-off tasks.
-    launch = slave->containerizer->launch(
-        containerId,
-        taskInfo,
-        executorInfo_, // Modified to include the task's resources, see above.
-        executor->directory,
-        user,
-        slave->info.id(),
-        slave->self(),
-        info.checkpoint());
-  }
+  // If the executor is _not_ a command executor, this means that
+  // the task will include the executor to run. The actual task to
+  // run will be enqueued and subsequently handled by the executor
+  // when it has registered to the slave. Otherwise an executor has
+  // _not_ been provided by the task and will instead define a
+  // command and/or container to run. Right now, these tasks will
+  // require an executor anyway and the slave creates a command
+  // executor. However, it is up to the containerizer how to execute
+  // those tasks and the generated executor info works as a
+  // placeholder.
+  // TODO(nnielsen): Obsolete the requirement for executors to run
+  // one-off tasks.
+  Option<TaskInfo> task = None();
+  if (executor->isCommandExecutor()) {
+    task = taskInfo;
+  }
+
+  // Create the directory (including setting its ownership) off the
+  // slave actor, so that the slave doesn't wait on the file system
+  // for every launch, and launch the container once it exists.
+  Future<bool> launch = async(
+      &paths::createExecutorDirectory,
+      slave->flags.work_dir,
+      slave->info.id(),
+      id(),
+      executorInfo.executor_id(),
+      containerId,
+      user)
+    .then(defer(slave,
+                &Slave::launchContainer,
+                id(),
+                executor->id,
+                containerId,
+                task,
+                executorInfo_, // Includes the task's resources, see above.
+                user,
+                lambda::_1));
 
   launch.onAny(defer(slave,
                &Slave::executorLaunched,
@@ -4510,10 +5360,18 @@ void Framework::destroyExecutor(const ExecutorID& executorId)
 
     // Pass ownership of the executor pointer.
     completedExecutors.push_back(Owned<Executor>(executor));
+
+    changed();
   }
 }
 
 
+void Framework::changed()
+{
+  version = ++slave->stateVersion;
+}
+
+
 Executor* Framework::getExecutor(const ExecutorID& executorId)
 {
   if (executors.contains(executorId)) {
@@ -4524,6 +5382,27 @@ Executor* Framework::getExecutor(const ExecutorID& executorId)
 }
 
 
+Executor* Framework::getIdleExecutor(const ExecutorInfo& executorInfo)
+{
+  // NOTE: The command of a generated command executor captures the
+  // URIs, environment and user of its (first) task, the container
+  // has to match as well since it's already set up.
+  foreachvalue (Executor* executor, executors) {
+    if (executor->isCommandExecutor() &&
+        executor->state == Executor::RUNNING &&
+        executor->queuedTasks.empty() &&
+        executor->launchedTasks.empty() &&
+        !pending.contains(executor->id) &&
+        executor->info.command() == executorInfo.command() &&
+        executor->info.container().SerializeAsString() ==
+          executorInfo.container().SerializeAsString()) {
+      return executor;
+    }
+  }
+  return NULL;
+}
+
+
 Executor* Framework::getExecutor(const TaskID& taskId)
 {
   foreachvalue (Executor* executor, executors) {
@@ -4679,6 +5558,7 @@ Executor::Executor(
     checkpoint(_checkpoint),
     pid(UPID()),
     resources(_info.resources()),
+    registrationPending(false),
     completedTasks(MAX_COMPLETED_TASKS_PER_EXECUTOR)
 {
   CHECK_NOTNULL(slave);
@@ -4720,6 +5600,8 @@ Task* Executor::addTask(const TaskInfo& task)
 
   resources += task.resources();
 
+  changed();
+
   return t;
 }
 
@@ -4764,6 +5646,8 @@ void Executor::terminateTask(
 
   // TODO(dhamon): Update source/reason metrics.
   terminatedTasks[taskId] = CHECK_NOTNULL(task);
+
+  changed();
 }
 
 
@@ -4777,6 +5661,17 @@ void Executor::completeTask(const TaskID& taskId)
   Task* task = terminatedTasks[taskId];
   completedTasks.push_back(std::shared_ptr<Task>(task));
   terminatedTasks.erase(taskId);
+
+  changed();
+}
+
+
+void Executor::changed()
+{
+  Framework* framework = slave->getFramework(frameworkId);
+  if (framework != NULL) {
+    framework->changed();
+  }
 }
 
 
@@ -4868,6 +5763,8 @@ void Executor::updateTaskState(const TaskStatus& status)
     }
     task->add_statuses()->CopyFrom(status);
     task->set_state(status.state());
+
+    changed();
   }
 }
 
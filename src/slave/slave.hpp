@@ -33,6 +33,7 @@
 
 #include <mesos/module/authenticatee.hpp>
 
+#include <mesos/slave/qos_controller.hpp>
 #include <mesos/slave/resource_estimator.hpp>
 
 #include <process/http.hpp>
@@ -63,6 +64,7 @@
 
 #include "common/attributes.hpp"
 #include "common/protobuf_utils.hpp"
+#include "common/tracer.hpp"
 
 #include "files/files.hpp"
 
@@ -91,7 +93,8 @@ public:
         Files* files,
         GarbageCollector* gc,
         StatusUpdateManager* statusUpdateManager,
-        mesos::slave::ResourceEstimator* resourceEstimator);
+        mesos::slave::ResourceEstimator* resourceEstimator,
+        mesos::slave::QoSController* qosController);
 
   virtual ~Slave();
 
@@ -106,6 +109,8 @@ public:
 
   void doReliableRegistration(Duration maxBackoff);
 
+  void registrationThrottled(const process::UPID& from, double retryAfter);
+
   // Made 'virtual' for Slave mocking.
   virtual void runTask(
       const process::UPID& from,
@@ -121,6 +126,15 @@ public:
       const std::string& pid,
       const TaskInfo& task);
 
+  // Multi-task version of 'runTask', see 'RunTasksMessage'.
+  void runTasks(
+      const process::UPID& from,
+      const FrameworkInfo& frameworkInfo,
+      const FrameworkID& frameworkId,
+      const std::string& pid,
+      const std::vector<TaskInfo>& tasks,
+      const std::vector<RunTasksMessage::Trace>& traces);
+
   process::Future<bool> unschedule(const std::string& path);
 
   // Made 'virtual' for Slave mocking.
@@ -151,7 +165,18 @@ public:
   void registerExecutor(
       const process::UPID& from,
       const FrameworkID& frameworkId,
-      const ExecutorID& executorId);
+      const ExecutorID& executorId,
+      bool acceptsQueuedTasks);
+
+  // Sends the executor its registration along with the queued tasks
+  // once the container was updated to hold their resources.
+  void _registerExecutor(
+      const process::Future<Nothing>& future,
+      const FrameworkID& frameworkId,
+      const ExecutorID& executorId,
+      const ContainerID& containerId,
+      const std::list<TaskInfo>& tasks,
+      bool acceptsQueuedTasks);
 
   // Called when an executor re-registers with a recovering slave.
   // 'tasks' : Unacknowledged tasks (i.e., tasks that the executor
@@ -193,6 +218,10 @@ public:
   // to ensure source field is set.
   void statusUpdate(StatusUpdate update, const process::UPID& pid);
 
+  // Handles a batch of status updates sent by an executor, see
+  // '--executor_status_update_batch_size'.
+  void statusUpdates(const std::vector<StatusUpdateMessage>& updates);
+
   // Continue handling the status update after optionally updating the
   // container's resources.
   void _statusUpdate(
@@ -216,6 +245,9 @@ public:
   // added to the update before forwarding.
   void forward(StatusUpdate update);
 
+  // Sends the status updates batched by 'forward' to the master.
+  void flushStatusUpdates();
+
   void statusUpdateAcknowledgement(
       const process::UPID& from,
       const SlaveID& slaveId,
@@ -223,12 +255,29 @@ public:
       const TaskID& taskId,
       const std::string& uuid);
 
+  void statusUpdateAcknowledgements(
+      const process::UPID& from,
+      const std::vector<StatusUpdateAcknowledgementMessage>& acknowledgements);
+
   void _statusUpdateAcknowledgement(
       const process::Future<bool>& future,
       const TaskID& taskId,
       const FrameworkID& frameworkId,
       const UUID& uuid);
 
+  // Launches the container of an executor once its directory has
+  // been created, see 'Framework::launchExecutor()'. Fails if the
+  // executor has been terminated in the meantime. The task is only
+  // set if the executor is a command executor.
+  process::Future<bool> launchContainer(
+      const FrameworkID& frameworkId,
+      const ExecutorID& executorId,
+      const ContainerID& containerId,
+      const Option<TaskInfo>& task,
+      const ExecutorInfo& executorInfo,
+      const Option<std::string>& user,
+      const std::string& directory);
+
   void executorLaunched(
       const FrameworkID& frameworkId,
       const ExecutorID& executorId,
@@ -268,13 +317,22 @@ public:
   virtual void finalize();
   virtual void exited(const process::UPID& pid);
 
+  // Bumps the 'stateVersion' after serving an event that may have
+  // changed the state of the slave.
+  virtual void serve(const process::Event& event);
+  virtual void visit(const process::HttpEvent& event);
+
+  // Updates the resource limits of the container for the tasks that
+  // were queued for a running executor since the last update.
+  void _runTasks(
+      const FrameworkID& frameworkId,
+      const ExecutorID& executorId,
+      const ContainerID& containerId);
+
   // This is called when the resource limits of the container have
   // been updated for the given tasks. If the update is successful, we
   // flush the given tasks to the executor by sending RunTaskMessages.
-  // TODO(jieyu): Consider renaming it to '__runTasks' once the slave
-  // starts to support launching multiple tasks in one call (i.e.,
-  // multi-tasks version of 'runTask').
-  void runTasks(
+  void __runTasks(
       const process::Future<Nothing>& future,
       const FrameworkID& frameworkId,
       const ExecutorID& executorId,
@@ -317,6 +375,10 @@ public:
   // Checks the current disk usage and schedules for gc as necessary.
   void checkDiskUsage();
 
+  // Rotates the 'stdout' and 'stderr' files of the running executors
+  // that exceed --container_logs_max_size (in the background).
+  void rotateContainerLogs();
+
   // Recovers the slave, status update manager and isolator.
   process::Future<Nothing> recover(const Result<state::State>& state);
 
@@ -325,12 +387,6 @@ public:
   // executors. Otherwise, the slave attempts to shutdown/kill them.
   process::Future<Nothing> _recover();
 
-  // This is a helper to call recover() on the containerizer at the end of
-  // recover() and before __recover().
-  // TODO(idownes): Remove this when we support defers to objects.
-  process::Future<Nothing> _recoverContainerizer(
-      const Option<state::SlaveState>& state);
-
   // This is called when recovery finishes.
   // Made 'virtual' for Slave mocking.
   virtual void __recover(const process::Future<Nothing>& future);
@@ -388,7 +444,12 @@ private:
     process::Future<process::http::Response> state(
         const process::http::Request& request) const;
 
+    // /slave/trace
+    process::Future<process::http::Response> trace(
+        const process::http::Request& request) const;
+
     static const std::string HEALTH_HELP;
+    static const std::string TRACE_HELP;
 
   private:
     Slave* slave;
@@ -438,6 +499,24 @@ private:
   void _forwardOversubscribed(
       const process::Future<Resources>& oversubscribable);
 
+  // Returns the resource usage of all executors, including the
+  // resources allocated to them. Used by the resource estimator and
+  // the QoS controller.
+  process::Future<std::list<ResourceUsage>> usages();
+  std::list<ResourceUsage> _usages(const std::list<ResourceUsage>& usages);
+
+  // Aggregates the resource usage of all executors into
+  // 'usageSummary', which is piggybacked on the pongs to the master.
+  void summarize();
+  void _summarize(const process::Future<std::list<ResourceUsage>>& usages);
+
+  // Carries out the corrections (e.g., killing revocable executors)
+  // requested by the QoS controller.
+  void qosCorrections();
+  void _qosCorrections(
+      const process::Future<std::list<
+          mesos::slave::QoSCorrection>>& correction);
+
   const Flags flags;
 
   SlaveInfo info;
@@ -451,6 +530,21 @@ private:
 
   boost::circular_buffer<process::Owned<Framework>> completedFrameworks;
 
+  // Incremented whenever a framework (including its executors and
+  // tasks) changes, see 'Framework::changed()'. This allows clients
+  // of the state endpoint to only ask for what changed.
+  //
+  // It is also bumped after every event unless the event is known to
+  // only read the state, i.e., a request with a safe method (see
+  // 'visit(const HttpEvent&)'), so that it versions the entire state
+  // of the slave. Together with the start time of the slave it forms
+  // the ETag of the state endpoint, see 'etag()'.
+  uint64_t stateVersion;
+  bool reading;
+
+  // Returns the ETag of the current version of the state.
+  std::string etag() const;
+
   MasterDetector* detector;
 
   Containerizer* containerizer;
@@ -478,6 +572,17 @@ private:
   // the master.
   process::Timer pingTimer;
 
+  // The aggregated resource usage of all executors as of the last
+  // summary (see 'summarize()'), reported to the master in the pongs.
+  Option<ResourceStatistics> usageSummary;
+
+  // Indicates if a summary is being computed.
+  bool summarizing;
+
+  // Records the spans of the task launches traced by the master (see
+  // 'RunTasksMessage.traces').
+  Tracer tracer;
+
   // Flag to indicate if recovery, including reconciling (i.e., reconnect/kill)
   // with executors is finished.
   process::Promise<Nothing> recovered;
@@ -485,6 +590,12 @@ private:
   // Root meta directory containing checkpointed data.
   const std::string metaDir;
 
+  // Store for the checkpoints in 'metaDir' (--checkpoint_store=leveldb).
+  state::Store* store;
+
+  // Status updates batched for the master (--status_update_batch_size).
+  StatusUpdatesMessage forwardedUpdates;
+
   // Indicates the number of errors ignored in "--no-strict" recovery mode.
   unsigned int recoveryErrors;
 
@@ -504,6 +615,10 @@ private:
   // Indicates if a new authentication attempt should be enforced.
   bool reauthenticate;
 
+  // The time before which the master asked us not to retry the
+  // (re-)registration, see '--slave_registration_rate_limit'.
+  Option<process::Time> throttledUntil;
+
   // Maximum age of executor directories. Will be recomputed
   // periodically every flags.disk_watch_interval.
   Duration executorDirectoryMaxAllowedAge;
@@ -513,6 +628,8 @@ private:
   // The most recent estimate of the total amount of oversubscribed
   // (allocated and oversubscribable) resources.
   Resources oversubscribedResources;
+
+  mesos::slave::QoSController* qosController;
 };
 
 
@@ -571,11 +688,23 @@ struct Executor
   // Currently consumed resources.
   Resources resources;
 
+  // The reason the slave is killing this executor, if any, which is
+  // reported in the status updates of its remaining tasks.
+  Option<TaskStatus::Reason> reason;
+
   // Tasks can be found in one of the following four data structures:
 
   // Not yet launched.
   LinkedHashMap<TaskID, TaskInfo> queuedTasks;
 
+  // The queued tasks of a running executor whose resources are not
+  // yet part of an update of the container (see 'Slave::_runTasks').
+  std::list<TaskInfo> batchedTasks;
+
+  // Whether the executor registered but has not yet been sent its
+  // 'ExecutorRegisteredMessage' (see 'Slave::registerExecutor').
+  bool registrationPending;
+
   // Running.
   LinkedHashMap<TaskID, Task*> launchedTasks;
 
@@ -592,6 +721,9 @@ private:
   Executor(const Executor&);              // No copying.
   Executor& operator = (const Executor&); // No assigning.
 
+  // Records a change of the executor with its framework.
+  void changed();
+
   bool commandExecutor;
 };
 
@@ -612,8 +744,18 @@ struct Framework
   void destroyExecutor(const ExecutorID& executorId);
   Executor* getExecutor(const ExecutorID& executorId);
   Executor* getExecutor(const TaskID& taskId);
+
+  // Returns a running command executor without any (queued,
+  // launched or pending) tasks whose container can be reused for a
+  // task with the given generated executor info, if any.
+  Executor* getIdleExecutor(const ExecutorInfo& executorInfo);
+
   void recoverExecutor(const state::ExecutorState& state);
 
+  // Records that the framework, one of its executors or one of
+  // their tasks changed, see 'Slave::stateVersion'.
+  void changed();
+
   const FrameworkID id() const { return info.id(); }
 
   enum State {
@@ -638,6 +780,10 @@ struct Framework
 
   // Up to MAX_COMPLETED_EXECUTORS_PER_FRAMEWORK completed executors.
   boost::circular_buffer<process::Owned<Executor>> completedExecutors;
+
+  // The 'Slave::stateVersion' of the last change of this framework.
+  uint64_t version;
+
 private:
   Framework(const Framework&);              // No copying.
   Framework& operator = (const Framework&); // No assigning.
@@ -1,24 +1,33 @@
+#include <errno.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include <process/pid.hpp>
 
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
 #include <stout/format.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/none.hpp>
 #include <stout/numify.hpp>
 #include <stout/os.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
 #include "messages/messages.hpp"
 
 #include "slave/paths.hpp"
 #include "slave/state.hpp"
+#include "slave/store.hpp"
 
 namespace mesos {
 namespace internal {
@@ -28,9 +37,95 @@ namespace state {
 using std::list;
 using std::string;
 using std::max;
+using std::vector;
 
 
-Result<State> recover(const string& rootDir, bool strict)
+// The checkpoints that are written as a whole are read from the
+// checkpoint store (see slave/store.hpp) if there is one, falling
+// back to the directory layout for the checkpoints that are not in
+// the store.
+static bool checkpointed(const string& path)
+{
+  Store* store = Store::get(path);
+
+  if (store != NULL && !store->read(path).isNone()) {
+    // NOTE: An error is surfaced when reading the checkpoint.
+    return true;
+  }
+
+  return os::exists(path);
+}
+
+
+static Try<string> readCheckpoint(const string& path)
+{
+  Store* store = Store::get(path);
+
+  if (store != NULL) {
+    Result<string> data = store->read(path);
+    if (data.isError()) {
+      return Error(data.error());
+    } else if (data.isSome()) {
+      return data.get();
+    }
+  }
+
+  return os::read(path);
+}
+
+
+// Parses the message at '*offset' of 'data', which is in the format
+// written by '::protobuf::write', and advances '*offset' past it.
+// Returns None at the end of 'data'.
+template <typename T>
+static Result<T> parse(const string& data, size_t* offset)
+{
+  uint32_t size;
+
+  if (*offset == data.size()) {
+    return None();
+  } else if (data.size() - *offset < sizeof(size)) {
+    return Error("Failed to read size: possible corruption");
+  }
+
+  memcpy((void*) &size, (void*) (data.data() + *offset), sizeof(size));
+
+  if (data.size() - *offset - sizeof(size) < size) {
+    return Error("Failed to read message of size " + stringify(size) +
+                 " bytes: possible corruption");
+  }
+
+  T message;
+  if (!message.ParseFromArray(data.data() + *offset + sizeof(size), size)) {
+    return Error("Failed to deserialize message");
+  }
+
+  *offset += sizeof(size) + size;
+
+  return message;
+}
+
+
+template <typename T>
+static Result<T> readCheckpoint(const string& path)
+{
+  Store* store = Store::get(path);
+
+  if (store != NULL) {
+    Result<string> data = store->read(path);
+    if (data.isError()) {
+      return Error(data.error());
+    } else if (data.isSome()) {
+      size_t offset = 0;
+      return parse<T>(data.get(), &offset);
+    }
+  }
+
+  return ::protobuf::read<T>(path);
+}
+
+
+Result<State> recover(const string& rootDir, bool strict, size_t workers)
 {
   LOG(INFO) << "Recovering state from '" << rootDir << "'";
 
@@ -56,8 +151,8 @@ Result<State> recover(const string& rootDir, bool strict)
 
   // Did the machine reboot? No need to recover slave state if the
   // machine has rebooted.
-  if (os::exists(paths::getBootIdPath(rootDir))) {
-    Try<string> read = os::read(paths::getBootIdPath(rootDir));
+  if (checkpointed(paths::getBootIdPath(rootDir))) {
+    Try<string> read = readCheckpoint(paths::getBootIdPath(rootDir));
     if (read.isSome()) {
       Try<string> id = os::bootId();
       CHECK_SOME(id);
@@ -91,7 +186,8 @@ Result<State> recover(const string& rootDir, bool strict)
   SlaveID slaveId;
   slaveId.set_value(os::basename(directory.get()).get());
 
-  Try<SlaveState> slave = SlaveState::recover(rootDir, slaveId, strict);
+  Try<SlaveState> slave =
+    SlaveState::recover(rootDir, slaveId, strict, workers);
   if (slave.isError()) {
     return Error(slave.error());
   }
@@ -105,21 +201,22 @@ Result<State> recover(const string& rootDir, bool strict)
 Try<SlaveState> SlaveState::recover(
     const string& rootDir,
     const SlaveID& slaveId,
-    bool strict)
+    bool strict,
+    size_t workers)
 {
   SlaveState state;
   state.id = slaveId;
 
   // Read the slave info.
   const string& path = paths::getSlaveInfoPath(rootDir, slaveId);
-  if (!os::exists(path)) {
+  if (!checkpointed(path)) {
     // This could happen if the slave died before it registered with
     // the master.
     LOG(WARNING) << "Failed to find slave info file '" << path << "'";
     return state;
   }
 
-  const Result<SlaveInfo>& slaveInfo = ::protobuf::read<SlaveInfo>(path);
+  const Result<SlaveInfo>& slaveInfo = readCheckpoint<SlaveInfo>(path);
 
   if (slaveInfo.isError()) {
     const string& message = "Failed to read slave info from '" + path + "': " +
@@ -156,7 +253,7 @@ Try<SlaveState> SlaveState::recover(
     frameworkId.set_value(os::basename(path).get());
 
     Try<FrameworkState> framework =
-      FrameworkState::recover(rootDir, slaveId, frameworkId, strict);
+      FrameworkState::recover(rootDir, slaveId, frameworkId, strict, workers);
 
     if (framework.isError()) {
       return Error("Failed to recover framework " + frameworkId.value() +
@@ -167,15 +264,177 @@ Try<SlaveState> SlaveState::recover(
     state.errors += framework.get().errors;
   }
 
+  // Replay the status update journal.
+  Try<Nothing> replay = replayStatusUpdateJournal(
+      rootDir, slaveId, &state, strict);
+
+  if (replay.isError()) {
+    return Error("Failed to replay status update journal for slave " +
+                 slaveId.value() + ": " + replay.error());
+  }
+
   return state;
 }
 
 
+// The status update journal (see StatusUpdateJournal) might contain
+// records that did not make it to the status updates files of the
+// tasks before the slave died. These get appended to the status
+// updates files (which are synced) and added to the task states.
+Try<Nothing> SlaveState::replayStatusUpdateJournal(
+    const string& rootDir,
+    const SlaveID& slaveId,
+    SlaveState* state,
+    bool strict)
+{
+  const string& path = paths::getStatusUpdatesJournalPath(rootDir, slaveId);
+  if (!os::exists(path)) {
+    return Nothing();
+  }
+
+  string message;
+
+  Try<int> fd = os::open(path, O_RDONLY | O_CLOEXEC);
+
+  if (fd.isError()) {
+    message = "Failed to open status update journal '" + path +
+              "': " + fd.error();
+
+    if (strict) {
+      return Error(message);
+    } else {
+      LOG(WARNING) << message;
+      state->errors++;
+      return Nothing();
+    }
+  }
+
+  // The status updates files appended to, by path.
+  hashmap<string, int> files;
+
+  Result<StatusUpdateJournalRecord> record = None();
+  while (true) {
+    // Ignore errors due to partial protobuf read, the partial record
+    // was not committed.
+    record = ::protobuf::read<StatusUpdateJournalRecord>(fd.get(), true, true);
+
+    if (!record.isSome()) {
+      break;
+    }
+
+    const FrameworkID& frameworkId = record.get().framework_id();
+    const ExecutorID& executorId = record.get().executor_id();
+    const ContainerID& containerId = record.get().container_id();
+    const TaskID& taskId = record.get().task_id();
+
+    if (!state->frameworks.contains(frameworkId) ||
+        !state->frameworks[frameworkId].executors.contains(executorId) ||
+        !state->frameworks[frameworkId].executors[executorId]
+          .runs.contains(containerId) ||
+        !state->frameworks[frameworkId].executors[executorId]
+          .runs[containerId].tasks.contains(taskId)) {
+      // This could happen if the task got removed (e.g., garbage
+      // collected) since the record was journaled.
+      VLOG(1) << "Skipping status update journal record for unknown task "
+              << taskId << " of framework " << frameworkId;
+      continue;
+    }
+
+    TaskState& task = state->frameworks[frameworkId]
+      .executors[executorId].runs[containerId].tasks[taskId];
+
+    const StatusUpdateRecord& update = record.get().record();
+
+    // Skip the records that made it to the status updates file.
+    if (update.type() == StatusUpdateRecord::UPDATE) {
+      bool found = false;
+      foreach (const StatusUpdate& _update, task.updates) {
+        if (_update.uuid() == update.update().uuid()) {
+          found = true;
+          break;
+        }
+      }
+
+      if (found) {
+        continue;
+      }
+    } else if (task.acks.contains(UUID::fromBytes(update.uuid()))) {
+      continue;
+    }
+
+    const string& updates = paths::getTaskUpdatesPath(
+        rootDir, slaveId, frameworkId, executorId, containerId, taskId);
+
+    if (!files.contains(updates)) {
+      Try<int> _fd = os::open(
+          updates,
+          O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC,
+          S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+      if (_fd.isError()) {
+        message = "Failed to open status updates file '" + updates +
+                  "': " + _fd.error();
+        break;
+      }
+
+      files[updates] = _fd.get();
+    }
+
+    Try<Nothing> write = ::protobuf::write(files[updates], update);
+
+    if (write.isError()) {
+      message = "Failed to write status updates file '" + updates +
+                "': " + write.error();
+      break;
+    }
+
+    LOG(INFO) << "Replayed " << update.type() << " for task " << taskId
+              << " of framework " << frameworkId
+              << " from the status update journal";
+
+    if (update.type() == StatusUpdateRecord::UPDATE) {
+      task.updates.push_back(update.update());
+    } else {
+      task.acks.insert(UUID::fromBytes(update.uuid()));
+    }
+  }
+
+  os::close(fd.get());
+
+  // Sync the status updates files so that the journal can be truncated.
+  foreachpair (const string& updates, int _fd, files) {
+    if (message.empty() && fsync(_fd) != 0) {
+      message = "Failed to sync status updates file '" + updates +
+                "': " + strerror(errno);
+    }
+
+    os::close(_fd);
+  }
+
+  if (message.empty() && record.isError()) {
+    message = "Failed to read status update journal '" + path +
+              "': " + record.error();
+  }
+
+  if (!message.empty()) {
+    if (strict) {
+      return Error(message);
+    } else {
+      LOG(WARNING) << message;
+      state->errors++;
+    }
+  }
+
+  return Nothing();
+}
+
+
 Try<FrameworkState> FrameworkState::recover(
     const string& rootDir,
     const SlaveID& slaveId,
     const FrameworkID& frameworkId,
-    bool strict)
+    bool strict,
+    size_t workers)
 {
   FrameworkState state;
   state.id = frameworkId;
@@ -183,7 +442,7 @@ Try<FrameworkState> FrameworkState::recover(
 
   // Read the framework info.
   string path = paths::getFrameworkInfoPath(rootDir, slaveId, frameworkId);
-  if (!os::exists(path)) {
+  if (!checkpointed(path)) {
     // This could happen if the slave died after creating the
     // framework directory but before it checkpointed the framework
     // info.
@@ -192,7 +451,7 @@ Try<FrameworkState> FrameworkState::recover(
   }
 
   const Result<FrameworkInfo>& frameworkInfo =
-    ::protobuf::read<FrameworkInfo>(path);
+    readCheckpoint<FrameworkInfo>(path);
 
   if (frameworkInfo.isError()) {
     message = "Failed to read framework info from '" + path + "': " +
@@ -218,14 +477,14 @@ Try<FrameworkState> FrameworkState::recover(
 
   // Read the framework pid.
   path = paths::getFrameworkPidPath(rootDir, slaveId, frameworkId);
-  if (!os::exists(path)) {
+  if (!checkpointed(path)) {
     // This could happen if the slave died after creating the
     // framework info but before it checkpointed the framework pid.
     LOG(WARNING) << "Failed to framework pid file '" << path << "'";
     return state;
   }
 
-  Try<string> pid = os::read(path);
+  Try<string> pid = readCheckpoint(path);
 
   if (pid.isError()) {
     message =
@@ -259,20 +518,49 @@ Try<FrameworkState> FrameworkState::recover(
         ": " + executors.error());
   }
 
-  // Recover the executors.
+  vector<ExecutorID> executorIds;
   foreach (const string& path, executors.get()) {
     ExecutorID executorId;
     executorId.set_value(os::basename(path).get());
+    executorIds.push_back(executorId);
+  }
 
-    Try<ExecutorState> executor =
-      ExecutorState::recover(rootDir, slaveId, frameworkId, executorId, strict);
+  // Recover the executors, each thread picking the next executor
+  // that is yet to be recovered.
+  // NOTE: The threads only read the (distinct) checkpoints of the
+  // executors and write to distinct elements of 'recovered'.
+  vector<Option<Try<ExecutorState> > > recovered(executorIds.size());
+  std::atomic<size_t> next(0);
+
+  auto recover = [&]() {
+    for (size_t i = next++; i < executorIds.size(); i = next++) {
+      recovered[i] = ExecutorState::recover(
+          rootDir, slaveId, frameworkId, executorIds[i], strict);
+    }
+  };
+
+  vector<std::thread> threads;
+  for (size_t i = 1; i < std::min(workers, executorIds.size()); i++) {
+    threads.push_back(std::thread(recover));
+  }
+
+  recover();
+
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
+
+  for (size_t i = 0; i < executorIds.size(); i++) {
+    CHECK_SOME(recovered[i]);
+
+    const Try<ExecutorState>& executor = recovered[i].get();
 
     if (executor.isError()) {
-      return Error("Failed to recover executor " + executorId.value() +
+      return Error("Failed to recover executor " + executorIds[i].value() +
                    ": " + executor.error());
     }
 
-    state.executors[executorId] = executor.get();
+    state.executors[executorIds[i]] = executor.get();
     state.errors += executor.get().errors;
   }
 
@@ -303,7 +591,7 @@ Try<ExecutorState> ExecutorState::recover(
                  "': " + runs.error());
   }
 
-  // Recover the runs.
+  // Find the latest run first, see below.
   foreach (const string& path, runs.get()) {
     if (os::basename(path).get() == paths::LATEST_SYMLINK) {
       const Result<string>& latest = os::realpath(path);
@@ -320,10 +608,30 @@ Try<ExecutorState> ExecutorState::recover(
       ContainerID containerId;
       containerId.set_value(os::basename(latest.get()).get());
       state.latest = containerId;
-    } else {
+    }
+  }
+
+  // Recover the runs.
+  foreach (const string& path, runs.get()) {
+    if (os::basename(path).get() != paths::LATEST_SYMLINK) {
       ContainerID containerId;
       containerId.set_value(os::basename(path).get());
 
+      // The slave only garbage collects the runs other than the
+      // latest one, so we skip recovering the tasks of the completed
+      // ones (there might be lots of them if they are not yet
+      // garbage collected).
+      if (state.latest != containerId &&
+          checkpointed(paths::getExecutorSentinelPath(
+              rootDir, slaveId, frameworkId, executorId, containerId))) {
+        RunState run;
+        run.id = containerId;
+        run.completed = true;
+
+        state.runs[containerId] = run;
+        continue;
+      }
+
       Try<RunState> run = RunState::recover(
           rootDir, slaveId, frameworkId, executorId, containerId, strict);
 
@@ -351,7 +659,7 @@ Try<ExecutorState> ExecutorState::recover(
   // Read the executor info.
   const string& path =
     paths::getExecutorInfoPath(rootDir, slaveId, frameworkId, executorId);
-  if (!os::exists(path)) {
+  if (!checkpointed(path)) {
     // This could happen if the slave died after creating the executor
     // directory but before it checkpointed the executor info.
     LOG(WARNING) << "Failed to find executor info file '" << path << "'";
@@ -359,7 +667,7 @@ Try<ExecutorState> ExecutorState::recover(
   }
 
   const Result<ExecutorInfo>& executorInfo =
-    ::protobuf::read<ExecutorInfo>(path);
+    readCheckpoint<ExecutorInfo>(path);
 
   if (executorInfo.isError()) {
     message = "Failed to read executor info from '" + path + "': " +
@@ -406,7 +714,7 @@ Try<RunState> RunState::recover(
   string path = paths::getExecutorSentinelPath(
       rootDir, slaveId, frameworkId, executorId, containerId);
 
-  state.completed = os::exists(path);
+  state.completed = checkpointed(path);
 
   // Find the tasks.
   Try<list<string> > tasks = paths::getTaskPaths(
@@ -442,14 +750,14 @@ Try<RunState> RunState::recover(
   // Read the forked pid.
   path = paths::getForkedPidPath(
       rootDir, slaveId, frameworkId, executorId, containerId);
-  if (!os::exists(path)) {
+  if (!checkpointed(path)) {
     // This could happen if the slave died before the isolator
     // checkpointed the forked pid.
     LOG(WARNING) << "Failed to find executor forked pid file '" << path << "'";
     return state;
   }
 
-  Try<string> pid = os::read(path);
+  Try<string> pid = readCheckpoint(path);
 
   if (pid.isError()) {
     message = "Failed to read executor forked pid from '" + path +
@@ -483,7 +791,7 @@ Try<RunState> RunState::recover(
   path = paths::getLibprocessPidPath(
       rootDir, slaveId, frameworkId, executorId, containerId);
 
-  if (!os::exists(path)) {
+  if (!checkpointed(path)) {
     // This could happen if the slave died before the executor
     // registered with the slave.
     LOG(WARNING)
@@ -491,7 +799,7 @@ Try<RunState> RunState::recover(
     return state;
   }
 
-  pid = os::read(path);
+  pid = readCheckpoint(path);
 
   if (pid.isError()) {
     message = "Failed to read executor libprocess pid from '" + path +
@@ -535,14 +843,14 @@ Try<TaskState> TaskState::recover(
   // Read the task info.
   string path = paths::getTaskInfoPath(
       rootDir, slaveId, frameworkId, executorId, containerId, taskId);
-  if (!os::exists(path)) {
+  if (!checkpointed(path)) {
     // This could happen if the slave died after creating the task
     // directory but before it checkpointed the task info.
     LOG(WARNING) << "Failed to find task info file '" << path << "'";
     return state;
   }
 
-  const Result<Task>& task = ::protobuf::read<Task>(path);
+  const Result<Task>& task = readCheckpoint<Task>(path);
 
   if (task.isError()) {
     message = "Failed to read task info from '" + path + "': " + task.error();
@@ -667,11 +975,48 @@ Try<ResourcesState> ResourcesState::recover(
   ResourcesState state;
 
   const string& path = paths::getResourcesInfoPath(rootDir);
-  if (!os::exists(path)) {
+  if (!checkpointed(path)) {
     LOG(INFO) << "Failed to find resources file '" << path << "'";
     return state;
   }
 
+  // The resources in the checkpoint store are written atomically, so
+  // unlike the resources file there is no partial write to ignore.
+  Store* store = Store::get(path);
+
+  if (store != NULL) {
+    Result<string> data = store->read(path);
+
+    Result<Resource> resource = None();
+    size_t offset = 0;
+
+    while (data.isSome()) {
+      resource = parse<Resource>(data.get(), &offset);
+      if (!resource.isSome()) {
+        break;
+      }
+
+      state.resources += resource.get();
+    }
+
+    if (data.isError() || resource.isError()) {
+      string message = "Failed to read resources from '" + path + "': " +
+                       (data.isError() ? data.error() : resource.error());
+
+      if (strict) {
+        return Error(message);
+      } else {
+        LOG(WARNING) << message;
+        state.errors++;
+        return state;
+      }
+    }
+
+    if (data.isSome()) {
+      return state;
+    }
+  }
+
   Try<int> fd = os::open(path, O_RDWR | O_CLOEXEC);
   if (fd.isError()) {
     string message =
@@ -39,6 +39,9 @@
 
 #include "messages/messages.hpp"
 
+#include "slave/paths.hpp"
+#include "slave/store.hpp"
+
 namespace mesos {
 namespace internal {
 namespace slave {
@@ -65,7 +68,12 @@ struct TaskState;
 // includes the 'errors' encountered recursively. In other words,
 // 'State.errors' is the sum total of all recovery errors. If the
 // machine has rebooted since the last slave run, None is returned.
-Result<State> recover(const std::string& rootDir, bool strict);
+// The executors of a framework are recovered using up to 'workers'
+// threads.
+Result<State> recover(
+    const std::string& rootDir,
+    bool strict,
+    size_t workers = 1);
 
 
 namespace internal {
@@ -103,6 +111,40 @@ inline Try<Nothing> checkpoint(
   return checkpoint(path, messages);
 }
 
+
+// Serializes the checkpoint the same way as 'internal::checkpoint'
+// writes it to a file, for the checkpoint store.
+inline std::string serialize(const std::string& message)
+{
+  return message;
+}
+
+
+inline std::string serialize(const google::protobuf::Message& message)
+{
+  uint32_t size = message.ByteSize();
+  return std::string((char*) &size, sizeof(size)) +
+         message.SerializeAsString();
+}
+
+
+template <typename T>
+std::string serialize(const google::protobuf::RepeatedPtrField<T>& messages)
+{
+  std::string result;
+  foreach (const T& message, messages) {
+    result += serialize(message);
+  }
+  return result;
+}
+
+
+inline std::string serialize(const Resources& resources)
+{
+  const google::protobuf::RepeatedPtrField<Resource>& messages = resources;
+  return serialize(messages);
+}
+
 }  // namespace internal {
 
 
@@ -117,7 +159,8 @@ inline Try<Nothing> checkpoint(
 //
 // NOTE: We provide atomic (all-or-nothing) semantics here by always
 // writing to a temporary file first then use os::rename to atomically
-// move it to the desired path.
+// move it to the desired path. Writes to the checkpoint store (see
+// slave/store.hpp) are atomic as well.
 template <typename T>
 Try<Nothing> checkpoint(const std::string& path, const T& t)
 {
@@ -133,6 +176,16 @@ Try<Nothing> checkpoint(const std::string& path, const T& t)
                  "': " + mkdir.error());
   }
 
+  // Checkpoints under the root directory of an installed checkpoint
+  // store are written to the store rather than to their own file.
+  // NOTE: The base directory is still created above since recovery
+  // walks the directory layout.
+  Store* store = Store::get(path);
+
+  if (store != NULL && paths::isCheckpointPath(path)) {
+    return store->write(path, internal::serialize(t));
+  }
+
   // NOTE: We create the temporary file at 'base/XXXXXX' to make sure
   // rename below does not cross devices (MESOS-2319).
   //
@@ -246,7 +299,8 @@ struct FrameworkState
       const std::string& rootDir,
       const SlaveID& slaveId,
       const FrameworkID& frameworkId,
-      bool strict);
+      bool strict,
+      size_t workers = 1);
 
   FrameworkID id;
   Option<FrameworkInfo> info;
@@ -276,6 +330,15 @@ struct SlaveState
   static Try<SlaveState> recover(
       const std::string& rootDir,
       const SlaveID& slaveId,
+      bool strict,
+      size_t workers = 1);
+
+  // Replays the status update journal of the slave into the status
+  // updates of the recovered tasks.
+  static Try<Nothing> replayStatusUpdateJournal(
+      const std::string& rootDir,
+      const SlaveID& slaveId,
+      SlaveState* state,
       bool strict);
 
   SlaveID id;
@@ -16,7 +16,9 @@
  * limitations under the License.
  */
 
+#include <process/defer.hpp>
 #include <process/delay.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/timer.hpp>
 
@@ -34,6 +36,7 @@
 
 #include "slave/constants.hpp"
 #include "slave/flags.hpp"
+#include "slave/paths.hpp"
 #include "slave/slave.hpp"
 #include "slave/state.hpp"
 #include "slave/status_update_manager.hpp"
@@ -45,7 +48,9 @@ using std::string;
 using process::wait; // Necessary on some OS's to disambiguate.
 using process::Failure;
 using process::Future;
+using process::Owned;
 using process::PID;
+using process::Promise;
 using process::Timeout;
 using process::UPID;
 
@@ -106,6 +111,25 @@ private:
       const Option<ExecutorID>& executorId,
       const Option<ContainerID>& containerId);
 
+  // Continuation of '_update' once the update is checkpointed.
+  Future<Nothing> __update(
+      const TaskID& taskId,
+      const FrameworkID& frameworkId);
+
+  // Continuation of 'acknowledgement' once the ACK is checkpointed.
+  Future<bool> _acknowledgement(
+      const TaskID& taskId,
+      const FrameworkID& frameworkId,
+      bool terminated);
+
+  // Returns a future that is satisfied once all the records
+  // journaled so far are committed (i.e., durable). The journals are
+  // committed at once after the events that are already queued
+  // have been processed, so that a burst of updates and ACKs (across
+  // all the tasks) is synced to disk together.
+  Future<Nothing> commit();
+  void _commit();
+
   // Status update timeout.
   void timeout(const Duration& duration);
 
@@ -115,6 +139,10 @@ private:
   // ACK (e.g updates from the executor).
   Timeout forward(const StatusUpdate& update, const Duration& duration);
 
+  // Forwards the next pending status update of the stream, if any,
+  // unless an update of the stream is already awaiting its ACK.
+  Try<Nothing> flush(const TaskID& taskId, const FrameworkID& frameworkId);
+
   // Helper functions.
 
   // Creates a new status update stream (opening the updates file, if path is
@@ -141,6 +169,13 @@ private:
   function<void(StatusUpdate)> forward_;
 
   hashmap<FrameworkID, hashmap<TaskID, StatusUpdateStream*> > streams;
+
+  // The journals of the checkpointing streams (there is usually
+  // only one, unless the slave gets a new ID).
+  hashmap<SlaveID, StatusUpdateJournal*> journals;
+
+  // Pending commit of the journals, if any.
+  Option<Owned<Promise<Nothing> > > committing;
 };
 
 
@@ -156,6 +191,16 @@ StatusUpdateManagerProcess::~StatusUpdateManagerProcess()
     }
   }
   streams.clear();
+
+  // NOTE: The journals must outlive the streams.
+  foreachvalue (StatusUpdateJournal* journal, journals) {
+    delete journal;
+  }
+  journals.clear();
+
+  if (committing.isSome()) {
+    committing.get()->fail("Status update manager is terminating");
+  }
 }
 
 
@@ -178,6 +223,9 @@ void StatusUpdateManagerProcess::resume()
   LOG(INFO) << "Resuming sending status updates";
   paused = false;
 
+  // Only resend checkpointed updates.
+  _commit();
+
   foreachkey (const FrameworkID& frameworkId, streams) {
     foreachvalue (StatusUpdateStream* stream, streams[frameworkId]) {
       if (!stream->pending.empty()) {
@@ -340,22 +388,36 @@ Future<Nothing> StatusUpdateManagerProcess::_update(
   }
 
   // We don't return a failed future here so that the slave can re-ack
-  // the duplicate update.
+  // the duplicate update (once the original update is checkpointed).
   if (!result.get()) {
+    if (checkpoint) {
+      return commit();
+    }
+
     return Nothing();
   }
 
+  if (checkpoint) {
+    return commit()
+      .then(defer(self(),
+                  &StatusUpdateManagerProcess::__update,
+                  taskId,
+                  frameworkId));
+  }
+
+  return __update(taskId, frameworkId);
+}
+
+
+Future<Nothing> StatusUpdateManagerProcess::__update(
+    const TaskID& taskId,
+    const FrameworkID& frameworkId)
+{
   // Forward the status update to the master if this is the first in the stream.
   // Subsequent status updates will get sent in 'acknowledgement()'.
-  if (!paused && stream->pending.size() == 1) {
-    CHECK(stream->timeout.isNone());
-    const Result<StatusUpdate>& next = stream->next();
-    if (next.isError()) {
-      return Failure(next.error());
-    }
-
-    CHECK_SOME(next);
-    stream->timeout = forward(next.get(), STATUS_UPDATE_RETRY_INTERVAL_MIN);
+  Try<Nothing> flush = this->flush(taskId, frameworkId);
+  if (flush.isError()) {
+    return Failure(flush.error());
   }
 
   return Nothing();
@@ -436,6 +498,7 @@ Future<bool> StatusUpdateManagerProcess::acknowledgement(
     return Failure(next.error());
   }
 
+  bool checkpoint = stream->checkpoint;
   bool terminated = stream->terminated;
 
   if (terminated) {
@@ -445,15 +508,107 @@ Future<bool> StatusUpdateManagerProcess::acknowledgement(
                    << " but updates are still pending";
     }
     cleanupStatusUpdateStream(taskId, frameworkId);
-  } else if (!paused && next.isSome()) {
+  }
+
+  if (checkpoint) {
+    return commit()
+      .then(defer(self(),
+                  &StatusUpdateManagerProcess::_acknowledgement,
+                  taskId,
+                  frameworkId,
+                  terminated));
+  }
+
+  return _acknowledgement(taskId, frameworkId, terminated);
+}
+
+
+Future<bool> StatusUpdateManagerProcess::_acknowledgement(
+    const TaskID& taskId,
+    const FrameworkID& frameworkId,
+    bool terminated)
+{
+  if (!terminated) {
     // Forward the next queued status update.
-    stream->timeout = forward(next.get(), STATUS_UPDATE_RETRY_INTERVAL_MIN);
+    Try<Nothing> flush = this->flush(taskId, frameworkId);
+    if (flush.isError()) {
+      return Failure(flush.error());
+    }
   }
 
   return !terminated;
 }
 
 
+Future<Nothing> StatusUpdateManagerProcess::commit()
+{
+  if (committing.isNone()) {
+    bool pending = false;
+    foreachvalue (StatusUpdateJournal* journal, journals) {
+      pending = pending || journal->pending();
+    }
+
+    if (!pending) {
+      return Nothing();
+    }
+
+    committing = Owned<Promise<Nothing> >(new Promise<Nothing>());
+
+    dispatch(self(), &StatusUpdateManagerProcess::_commit);
+  }
+
+  return committing.get()->future();
+}
+
+
+void StatusUpdateManagerProcess::_commit()
+{
+  // The journals might have been committed already (e.g., before
+  // resending the pending updates).
+  if (committing.isNone()) {
+    return;
+  }
+
+  Owned<Promise<Nothing> > promise = committing.get();
+  committing = None();
+
+  foreachvalue (StatusUpdateJournal* journal, journals) {
+    Try<Nothing> commit = journal->commit();
+    if (commit.isError()) {
+      promise->fail(commit.error());
+      return;
+    }
+  }
+
+  promise->set(Nothing());
+}
+
+
+Try<Nothing> StatusUpdateManagerProcess::flush(
+    const TaskID& taskId,
+    const FrameworkID& frameworkId)
+{
+  StatusUpdateStream* stream = getStatusUpdateStream(taskId, frameworkId);
+
+  // The stream might have been cleaned up (e.g., if the framework
+  // got removed) while the update was being checkpointed.
+  if (stream == NULL || paused || stream->timeout.isSome()) {
+    return Nothing();
+  }
+
+  const Result<StatusUpdate>& next = stream->next();
+  if (next.isError()) {
+    return Error(next.error());
+  }
+
+  if (next.isSome()) {
+    stream->timeout = forward(next.get(), STATUS_UPDATE_RETRY_INTERVAL_MIN);
+  }
+
+  return Nothing();
+}
+
+
 // TODO(vinod): There should be a limit on the retries.
 void StatusUpdateManagerProcess::timeout(const Duration& duration)
 {
@@ -461,6 +616,9 @@ void StatusUpdateManagerProcess::timeout(const Duration& duration)
     return;
   }
 
+  // Only resend checkpointed updates.
+  _commit();
+
   // Check and see if we should resend any status updates.
   foreachkey (const FrameworkID& frameworkId, streams) {
     foreachvalue (StatusUpdateStream* stream, streams[frameworkId]) {
@@ -494,8 +652,27 @@ StatusUpdateStream* StatusUpdateManagerProcess::createStatusUpdateStream(
   VLOG(1) << "Creating StatusUpdate stream for task " << taskId
           << " of framework " << frameworkId;
 
+  StatusUpdateJournal* journal = NULL;
+
+  if (checkpoint) {
+    if (!journals.contains(slaveId)) {
+      journals[slaveId] = new StatusUpdateJournal(
+          paths::getStatusUpdatesJournalPath(
+              paths::getMetaRootDir(flags.work_dir), slaveId));
+    }
+
+    journal = journals[slaveId];
+  }
+
   StatusUpdateStream* stream = new StatusUpdateStream(
-      taskId, frameworkId, slaveId, flags, checkpoint, executorId, containerId);
+      taskId,
+      frameworkId,
+      slaveId,
+      flags,
+      checkpoint,
+      executorId,
+      containerId,
+      journal);
 
   streams[frameworkId][taskId] = stream;
   return stream;
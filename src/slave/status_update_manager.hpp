@@ -19,6 +19,9 @@
 #ifndef __STATUS_UPDATE_MANAGER_HPP__
 #define __STATUS_UPDATE_MANAGER_HPP__
 
+#include <errno.h>
+#include <unistd.h>
+
 #include <ostream>
 #include <queue>
 #include <string>
@@ -31,6 +34,8 @@
 #include <process/protobuf.hpp>
 #include <process/timeout.hpp>
 
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
@@ -47,7 +52,9 @@
 
 #include "messages/messages.hpp"
 
+#include "slave/constants.hpp"
 #include "slave/flags.hpp"
+#include "slave/paths.hpp"
 
 namespace mesos {
 namespace internal {
@@ -62,6 +69,7 @@ struct SlaveState;
 }
 
 class StatusUpdateManagerProcess;
+class StatusUpdateJournal;
 struct StatusUpdateStream;
 
 
@@ -138,9 +146,189 @@ private:
 };
 
 
+// StatusUpdateJournal is a write-ahead journal of the status update
+// and acknowledgement records of all the checkpointing status update
+// streams of a slave. The records are buffered and written out with
+// a single fsync on 'commit', so that the streams can write the
+// status updates files of the tasks without syncing each write: a
+// record is durable once it is committed, and 'state::recover'
+// replays the journal into the status updates files. Once the journal
+// gets large, the status updates files get synced and the journal is
+// truncated (see 'checkpoint').
+class StatusUpdateJournal
+{
+public:
+  explicit StatusUpdateJournal(const std::string& _path)
+    : path(_path), size(0) {}
+
+  ~StatusUpdateJournal()
+  {
+    // NOTE: We don't sync the status updates files here, the records
+    // which might not have made it to disk are still in the journal.
+    foreach (int _fd, released) {
+      os::close(_fd);
+    }
+
+    if (fd.isSome()) {
+      os::close(fd.get());
+    }
+  }
+
+  // Buffers the record, which was also written (but not synced) to
+  // the status updates file with the specified file descriptor,
+  // until the next 'commit'.
+  Try<Nothing> append(const StatusUpdateJournalRecord& record, int _fd)
+  {
+    if (error.isSome()) {
+      return Error(error.get());
+    }
+
+    if (!record.IsInitialized()) {
+      return Error(record.InitializationErrorString() +
+                   " is required but not initialized");
+    }
+
+    // NOTE: This is the same format as '::protobuf::write'.
+    uint32_t length = record.ByteSize();
+    buffer.append((char*) &length, sizeof(length));
+    record.AppendToString(&buffer);
+
+    dirty.insert(_fd);
+
+    return Nothing();
+  }
+
+  // Returns true if there are records to be committed.
+  bool pending() const
+  {
+    return !buffer.empty();
+  }
+
+  // Writes out the buffered records and syncs the journal.
+  Try<Nothing> commit()
+  {
+    if (error.isSome()) {
+      return Error(error.get());
+    }
+
+    if (buffer.empty()) {
+      return Nothing();
+    }
+
+    if (fd.isNone()) {
+      Try<Nothing> directory = os::mkdir(os::dirname(path).get());
+      if (directory.isError()) {
+        error = "Failed to create " + os::dirname(path).get();
+        return Error(error.get());
+      }
+
+      Try<int> result = os::open(
+          path,
+          O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC,
+          S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+      if (result.isError()) {
+        error = "Failed to open '" + path + "' for status updates";
+        return Error(error.get());
+      }
+
+      fd = result.get();
+
+      // The journal might still contain the records of a previous
+      // run of the slave (replayed by 'state::recover').
+      off_t offset = lseek(fd.get(), 0, SEEK_END);
+      size = offset > 0 ? offset : 0;
+    }
+
+    Try<Nothing> write = os::write(fd.get(), buffer);
+    if (write.isError()) {
+      error = "Failed to write status updates to '" + path + "': " +
+              write.error();
+      return Error(error.get());
+    }
+
+    if (fsync(fd.get()) != 0) {
+      error = "Failed to sync '" + path + "': " + strerror(errno);
+      return Error(error.get());
+    }
+
+    size += buffer.size();
+    buffer.clear();
+
+    if (size >= STATUS_UPDATE_JOURNAL_CHECKPOINT_SIZE.bytes() ||
+        released.size() >= STATUS_UPDATE_JOURNAL_CHECKPOINT_FILES) {
+      Try<Nothing> checkpoint = this->checkpoint();
+      if (checkpoint.isError()) {
+        // The records are still in the journal.
+        LOG(WARNING) << "Failed to checkpoint the status update journal '"
+                     << path << "': " << checkpoint.error();
+      }
+    }
+
+    return Nothing();
+  }
+
+  // Takes over the file descriptor of a status updates file that is
+  // no longer written to, which gets closed once it is synced.
+  void release(int _fd)
+  {
+    if (dirty.contains(_fd)) {
+      released.insert(_fd);
+    } else {
+      os::close(_fd);
+    }
+  }
+
+private:
+  // Syncs the status updates files written since the last checkpoint
+  // and truncates the journal.
+  Try<Nothing> checkpoint()
+  {
+    CHECK(buffer.empty());
+    CHECK_SOME(fd);
+
+    foreach (int _fd, dirty) {
+      if (fsync(_fd) != 0) {
+        return ErrnoError("Failed to sync status updates file");
+      }
+    }
+
+    foreach (int _fd, released) {
+      os::close(_fd);
+    }
+
+    dirty.clear();
+    released.clear();
+
+    if (ftruncate(fd.get(), 0) != 0 || fsync(fd.get()) != 0) {
+      return ErrnoError("Failed to truncate");
+    }
+
+    size = 0;
+
+    return Nothing();
+  }
+
+  const std::string path;
+  Option<int> fd; // File descriptor to the journal.
+  size_t size; // Size of the journal.
+
+  // Records that are not yet committed.
+  std::string buffer;
+
+  // File descriptors of the status updates files written to since
+  // the last checkpoint and the ones among them that are released.
+  hashset<int> dirty;
+  hashset<int> released;
+
+  Option<std::string> error; // Potential non-retryable error.
+};
+
+
 // StatusUpdateStream handles the status updates and acknowledgements
-// of a task, checkpointing them if necessary. It also holds the information
-// about received, acknowledged and pending status updates.
+// of a task, checkpointing them if necessary (in which case they are
+// durable once the journal gets committed). It also holds the
+// information about received, acknowledged and pending status updates.
 // NOTE: A task is expected to have a globally unique ID across the lifetime
 // of a framework. In other words the tuple (taskId, frameworkId) should be
 // always unique.
@@ -151,19 +339,24 @@ struct StatusUpdateStream
                      const SlaveID& _slaveId,
                      const Flags& _flags,
                      bool _checkpoint,
-                     const Option<ExecutorID>& executorId,
-                     const Option<ContainerID>& containerId)
+                     const Option<ExecutorID>& _executorId,
+                     const Option<ContainerID>& _containerId,
+                     StatusUpdateJournal* _journal)
     : checkpoint(_checkpoint),
       terminated(false),
       taskId(_taskId),
       frameworkId(_frameworkId),
       slaveId(_slaveId),
+      executorId(_executorId),
+      containerId(_containerId),
       flags(_flags),
+      journal(_journal),
       error(None())
   {
     if (checkpoint) {
       CHECK_SOME(executorId);
       CHECK_SOME(containerId);
+      CHECK_NOTNULL(journal);
 
       path = paths::getTaskUpdatesPath(
           paths::getMetaRootDir(flags.work_dir),
@@ -180,10 +373,11 @@ struct StatusUpdateStream
         return;
       }
 
-      // Open the updates file.
+      // Open the updates file. NOTE: The writes are not synchronous,
+      // the journal makes them durable.
       Try<int> result = os::open(
           path.get(),
-          O_CREAT | O_WRONLY | O_APPEND | O_SYNC | O_CLOEXEC,
+          O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC,
           S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
 
       if (result.isError()) {
@@ -199,13 +393,9 @@ struct StatusUpdateStream
 
   ~StatusUpdateStream()
   {
+    // The journal closes the file once it is synced.
     if (fd.isSome()) {
-      Try<Nothing> close = os::close(fd.get());
-      if (close.isError()) {
-        CHECK_SOME(path);
-        LOG(ERROR) << "Failed to close file '" << path.get() << "': "
-                   << close.error();
-      }
+      journal->release(fd.get());
     }
   }
 
@@ -329,12 +519,8 @@ struct StatusUpdateStream
   std::queue<StatusUpdate> pending;
 
 private:
-  // Handles the status update and writes it to disk, if necessary.
-  // TODO(vinod): The write has to be asynchronous to avoid status updates that
-  // are being checkpointed, blocking the processing of other updates.
-  // One solution is to wrap the protobuf::write inside async, but its probably
-  // too much of an overhead to spin up a new libprocess per status update?
-  // A better solution might be to be have async write capability for file io.
+  // Handles the status update and writes it to disk (without syncing
+  // it, see StatusUpdateJournal), if necessary.
   Try<Nothing> handle(
       const StatusUpdate& update,
       const StatusUpdateRecord::Type& type)
@@ -362,6 +548,20 @@ private:
                 " to '" + path.get() + "': " + write.error();
         return Error(error.get());
       }
+
+      StatusUpdateJournalRecord entry;
+      entry.mutable_framework_id()->CopyFrom(frameworkId);
+      entry.mutable_executor_id()->CopyFrom(executorId.get());
+      entry.mutable_container_id()->CopyFrom(containerId.get());
+      entry.mutable_task_id()->CopyFrom(taskId);
+      entry.mutable_record()->CopyFrom(record);
+
+      Try<Nothing> append = journal->append(entry, fd.get());
+      if (append.isError()) {
+        error = "Failed to journal status update " + stringify(update) +
+                ": " + append.error();
+        return Error(error.get());
+      }
     }
 
     // Now actually handle the update.
@@ -396,9 +596,13 @@ private:
   const TaskID taskId;
   const FrameworkID frameworkId;
   const SlaveID slaveId;
+  const Option<ExecutorID> executorId;
+  const Option<ContainerID> containerId;
 
   const Flags flags;
 
+  StatusUpdateJournal* journal; // Not owned.
+
   hashset<UUID> received;
   hashset<UUID> acknowledged;
 
@@ -0,0 +1,344 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glog/logging.h>
+
+#include <leveldb/db.h>
+#include <leveldb/write_batch.h>
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <vector>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/none.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/strings.hpp>
+#include <stout/synchronized.hpp>
+
+#include "slave/paths.hpp"
+#include "slave/state.hpp"
+#include "slave/store.hpp"
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+namespace state {
+
+// The installed stores, see 'Store::install'.
+static std::mutex mutex;
+static vector<Store*> stores;
+
+
+// Collects the checkpoint files below 'directory' into 'files'.
+// NOTE: We do not follow symlinks (i.e., the "latest" symlinks) so
+// that every file is visited exactly once.
+static Try<Nothing> collect(
+    const string& directory,
+    const string& excluded,
+    list<string>* files)
+{
+  Try<list<string>> entries = os::ls(directory);
+  if (entries.isError()) {
+    return Error(
+        "Failed to list '" + directory + "': " + entries.error());
+  }
+
+  foreach (const string& entry, entries.get()) {
+    const string path = path::join(directory, entry);
+
+    if (os::stat::islink(path) || path == excluded) {
+      continue;
+    }
+
+    if (os::stat::isdir(path)) {
+      Try<Nothing> found = collect(path, excluded, files);
+      if (found.isError()) {
+        return found;
+      }
+    } else if (paths::isCheckpointPath(path)) {
+      files->push_back(path);
+    }
+  }
+
+  return Nothing();
+}
+
+
+Try<Store*> Store::create(const string& rootDir)
+{
+  const string path = paths::getCheckpointStorePath(rootDir);
+
+  Try<Nothing> mkdir = os::mkdir(rootDir);
+  if (mkdir.isError()) {
+    return Error(
+        "Failed to create directory '" + rootDir + "': " + mkdir.error());
+  }
+
+  leveldb::Options options;
+  options.create_if_missing = true;
+
+  leveldb::DB* db = NULL;
+  leveldb::Status status = leveldb::DB::Open(options, path, &db);
+
+  if (!status.ok()) {
+    return Error(
+        "Failed to open checkpoint store '" + path + "': " +
+        status.ToString());
+  }
+
+  return new Store(rootDir, db);
+}
+
+
+void Store::install(Store* store)
+{
+  synchronized (mutex) {
+    foreach (Store* installed, stores) {
+      CHECK_NE(installed->rootDir, store->rootDir)
+        << "A checkpoint store is already installed for '"
+        << store->rootDir << "'";
+    }
+
+    stores.push_back(store);
+  }
+}
+
+
+void Store::uninstall(Store* store)
+{
+  synchronized (mutex) {
+    stores.erase(
+        std::remove(stores.begin(), stores.end(), store),
+        stores.end());
+  }
+}
+
+
+Store* Store::get(const string& path)
+{
+  synchronized (mutex) {
+    foreach (Store* store, stores) {
+      if (strings::startsWith(path, store->rootDir + "/")) {
+        return store;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+
+Store::Store(const string& _rootDir, leveldb::DB* _db)
+  : rootDir(_rootDir),
+    db(_db) {}
+
+
+Store::~Store()
+{
+  delete db;
+}
+
+
+Try<Nothing> Store::write(const string& path, const string& data)
+{
+  // NOTE: Like a checkpoint file, which is renamed into place without
+  // an fsync, the write survives a crash of the slave but not
+  // necessarily of the host.
+  leveldb::Status status = db->Put(leveldb::WriteOptions(), key(path), data);
+
+  if (!status.ok()) {
+    return Error(status.ToString());
+  }
+
+  return Nothing();
+}
+
+
+Result<string> Store::read(const string& path)
+{
+  string data;
+  leveldb::Status status = db->Get(leveldb::ReadOptions(), key(path), &data);
+
+  if (status.IsNotFound()) {
+    return None();
+  } else if (!status.ok()) {
+    return Error(status.ToString());
+  }
+
+  return data;
+}
+
+
+Try<Nothing> Store::remove(const string& path)
+{
+  const string prefix = key(path);
+
+  leveldb::WriteBatch batch;
+
+  leveldb::Iterator* iterator = db->NewIterator(leveldb::ReadOptions());
+
+  for (iterator->Seek(prefix); iterator->Valid(); iterator->Next()) {
+    const string key = iterator->key().ToString();
+
+    if (key != prefix && !strings::startsWith(key, prefix + "/")) {
+      break;
+    }
+
+    batch.Delete(key);
+  }
+
+  leveldb::Status status = iterator->status();
+
+  delete iterator;
+
+  if (!status.ok()) {
+    return Error(status.ToString());
+  }
+
+  status = db->Write(leveldb::WriteOptions(), &batch);
+
+  if (!status.ok()) {
+    return Error(status.ToString());
+  }
+
+  return Nothing();
+}
+
+
+Try<size_t> Store::import()
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  list<string> files;
+  Try<Nothing> found =
+    collect(rootDir, paths::getCheckpointStorePath(rootDir), &files);
+
+  if (found.isError()) {
+    return Error(found.error());
+  }
+
+  if (files.empty()) {
+    return 0;
+  }
+
+  leveldb::WriteBatch batch;
+
+  foreach (const string& file, files) {
+    Try<string> data = os::read(file);
+    if (data.isError()) {
+      return Error("Failed to read '" + file + "': " + data.error());
+    }
+
+    batch.Put(key(file), data.get());
+  }
+
+  // The files are only removed once their contents are durable in
+  // the store. If the slave dies in between, the files are simply
+  // imported again.
+  leveldb::WriteOptions options;
+  options.sync = true;
+
+  leveldb::Status status = db->Write(options, &batch);
+
+  if (!status.ok()) {
+    return Error(status.ToString());
+  }
+
+  foreach (const string& file, files) {
+    Try<Nothing> rm = os::rm(file);
+    if (rm.isError()) {
+      return Error("Failed to remove '" + file + "': " + rm.error());
+    }
+  }
+
+  LOG(INFO) << "Imported " << files.size() << " checkpoint files into '"
+            << paths::getCheckpointStorePath(rootDir) << "' in "
+            << stopwatch.elapsed();
+
+  return files.size();
+}
+
+
+Try<size_t> Store::unpack()
+{
+  CHECK(Store::get(paths::getCheckpointStorePath(rootDir)) != this)
+    << "The checkpoint store must not be installed while unpacking";
+
+  size_t count = 0;
+
+  leveldb::WriteBatch batch;
+
+  leveldb::Iterator* iterator = db->NewIterator(leveldb::ReadOptions());
+
+  for (iterator->SeekToFirst(); iterator->Valid(); iterator->Next()) {
+    const string key = iterator->key().ToString();
+
+    Try<Nothing> checkpoint = state::checkpoint(
+        path::join(rootDir, key),
+        iterator->value().ToString());
+
+    if (checkpoint.isError()) {
+      delete iterator;
+      return Error(
+          "Failed to unpack checkpoint '" + key + "': " + checkpoint.error());
+    }
+
+    batch.Delete(key);
+    count++;
+  }
+
+  leveldb::Status status = iterator->status();
+
+  delete iterator;
+
+  if (!status.ok()) {
+    return Error(status.ToString());
+  }
+
+  status = db->Write(leveldb::WriteOptions(), &batch);
+
+  if (!status.ok()) {
+    return Error(status.ToString());
+  }
+
+  return count;
+}
+
+
+string Store::key(const string& path) const
+{
+  CHECK(strings::startsWith(path, rootDir + "/"))
+    << "'" << path << "' is not in '" << rootDir << "'";
+
+  return path.substr(rootDir.size() + 1);
+}
+
+} // namespace state {
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,104 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SLAVE_STORE_HPP__
+#define __SLAVE_STORE_HPP__
+
+#include <string>
+
+#include <stout/nothing.hpp>
+#include <stout/result.hpp>
+#include <stout/try.hpp>
+
+// Forward declaration.
+namespace leveldb {
+class DB;
+}
+
+namespace mesos {
+namespace internal {
+namespace slave {
+namespace state {
+
+// An embedded (leveldb) store for the checkpoints that the slave
+// writes as a whole (see 'paths::isCheckpointPath'), keyed by their
+// path relative to the meta directory. Once a store is installed,
+// 'state::checkpoint' writes these checkpoints to the store instead
+// of creating a file for each of them, and recovery reads them back
+// from the store. The directories of the layout (and the status
+// updates files, which are appended to) are left as is, so recovery
+// walks the same tree with or without a store.
+class Store
+{
+public:
+  // Opens the store in the meta directory 'rootDir', creating it if
+  // it does not exist.
+  static Try<Store*> create(const std::string& rootDir);
+
+  // Makes 'store' the store for the checkpoints under its root
+  // directory. Multiple stores can be installed (e.g., for multiple
+  // slaves in tests) as long as their root directories differ.
+  static void install(Store* store);
+  static void uninstall(Store* store);
+
+  // Returns the installed store whose root directory contains 'path'
+  // or NULL if there is none.
+  static Store* get(const std::string& path);
+
+  ~Store();
+
+  // Atomically replaces the checkpoint at 'path' with 'data'.
+  Try<Nothing> write(const std::string& path, const std::string& data);
+
+  // Returns the checkpoint at 'path' or None if it is not stored.
+  Result<std::string> read(const std::string& path);
+
+  // Removes the checkpoints at and below 'path' (e.g., when the
+  // directory 'path' gets garbage collected).
+  Try<Nothing> remove(const std::string& path);
+
+  // One-shot migration of the checkpoint files in the directory
+  // layout into the store. The files are removed once the store
+  // holds their contents. Returns the number of migrated files.
+  Try<size_t> import();
+
+  // Migrates the checkpoints back to files in the directory layout
+  // and empties the store (e.g., before switching back to
+  // '--checkpoint_store=directory'). Returns the number of files.
+  Try<size_t> unpack();
+
+  const std::string rootDir;
+
+private:
+  Store(const std::string& rootDir, leveldb::DB* db);
+
+  Store(const Store&); // Not copyable.
+  Store& operator = (const Store&); // Not assignable.
+
+  // Returns the key of 'path', i.e., its path relative to 'rootDir'.
+  std::string key(const std::string& path) const;
+
+  leveldb::DB* db;
+};
+
+} // namespace state {
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SLAVE_STORE_HPP__
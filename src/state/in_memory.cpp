@@ -1,10 +1,13 @@
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/option.hpp>
 #include <stout/uuid.hpp>
@@ -45,6 +48,26 @@ public:
     return true;
   }
 
+  bool setBatch(const std::vector<std::pair<Entry, UUID> >& batch)
+  {
+    typedef std::pair<Entry, UUID> Pair;
+
+    foreach (const Pair& pair, batch) {
+      const Option<Entry>& option = entries.get(pair.first.name());
+
+      if (option.isSome() &&
+          UUID::fromBytes(option.get().uuid()) != pair.second) {
+        return false;
+      }
+    }
+
+    foreach (const Pair& pair, batch) {
+      entries.put(pair.first.name(), pair.first);
+    }
+
+    return true;
+  }
+
   bool expunge(const Entry& entry)
   {
     const Option<Entry>& option = entries.get(entry.name());
@@ -61,6 +84,28 @@ public:
     return true;
   }
 
+  bool expungeBatch(const std::vector<Entry>& batch)
+  {
+    foreach (const Entry& entry, batch) {
+      const Option<Entry>& option = entries.get(entry.name());
+
+      if (option.isNone()) {
+        return false;
+      }
+
+      if (UUID::fromBytes(option.get().uuid()) !=
+          UUID::fromBytes(entry.uuid())) {
+        return false;
+      }
+    }
+
+    foreach (const Entry& entry, batch) {
+      entries.erase(entry.name());
+    }
+
+    return true;
+  }
+
   std::set<string> names() // Use std:: to disambiguate 'set' member.
   {
     const hashset<string>& keys = entries.keys();
@@ -100,12 +145,25 @@ Future<bool> InMemoryStorage::set(const Entry& entry, const UUID& uuid)
 }
 
 
+Future<bool> InMemoryStorage::setBatch(
+    const std::vector<std::pair<Entry, UUID> >& entries)
+{
+  return dispatch(process, &InMemoryStorageProcess::setBatch, entries);
+}
+
+
 Future<bool> InMemoryStorage::expunge(const Entry& entry)
 {
   return dispatch(process, &InMemoryStorageProcess::expunge, entry);
 }
 
 
+Future<bool> InMemoryStorage::expungeBatch(const std::vector<Entry>& entries)
+{
+  return dispatch(process, &InMemoryStorageProcess::expungeBatch, entries);
+}
+
+
 Future<std::set<string> > InMemoryStorage::names()
 {
   return dispatch(process, &InMemoryStorageProcess::names);
@@ -1,4 +1,5 @@
 #include <leveldb/db.h>
+#include <leveldb/write_batch.h>
 
 #include <google/protobuf/message.h>
 
@@ -6,12 +7,15 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/process.hpp>
 
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/some.hpp>
@@ -29,7 +33,9 @@ using namespace process;
 
 // Note that we don't add 'using std::set' here because we need
 // 'std::' to disambiguate the 'set' member.
+using std::pair;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -49,6 +55,9 @@ public:
   Future<bool> set(const Entry& entry, const UUID& uuid);
   Future<bool> expunge(const Entry& entry);
   Future<std::set<string> > names();
+  Future<vector<Option<Entry> > > getBatch(const vector<string>& names);
+  Future<bool> setBatch(const vector<pair<Entry, UUID> >& entries);
+  Future<bool> expungeBatch(const vector<Entry>& entries);
 
 private:
   // Helpers for interacting with leveldb.
@@ -204,6 +213,118 @@ Future<bool> LevelDBStorageProcess::expunge(const Entry& entry)
 }
 
 
+Future<vector<Option<Entry> > > LevelDBStorageProcess::getBatch(
+    const vector<string>& names)
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  }
+
+  vector<Option<Entry> > entries;
+
+  foreach (const string& name, names) {
+    Try<Option<Entry> > option = read(name);
+
+    if (option.isError()) {
+      return Failure(option.error());
+    }
+
+    entries.push_back(option.get());
+  }
+
+  return entries;
+}
+
+
+Future<bool> LevelDBStorageProcess::setBatch(
+    const vector<pair<Entry, UUID> >& entries)
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  }
+
+  // Like 'set', but all of the entries are written with a single
+  // (atomic) write.
+  leveldb::WriteBatch batch;
+
+  typedef pair<Entry, UUID> Pair;
+
+  foreach (const Pair& pair, entries) {
+    Try<Option<Entry> > option = read(pair.first.name());
+
+    if (option.isError()) {
+      return Failure(option.error());
+    }
+
+    if (option.get().isSome() &&
+        UUID::fromBytes(option.get().get().uuid()) != pair.second) {
+      return false;
+    }
+
+    string value;
+
+    if (!pair.first.SerializeToString(&value)) {
+      return Failure("Failed to serialize Entry");
+    }
+
+    batch.Put(pair.first.name(), value);
+  }
+
+  leveldb::WriteOptions options;
+  options.sync = true;
+
+  leveldb::Status status = db->Write(options, &batch);
+
+  if (!status.ok()) {
+    return Failure(status.ToString());
+  }
+
+  return true;
+}
+
+
+Future<bool> LevelDBStorageProcess::expungeBatch(const vector<Entry>& entries)
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  }
+
+  // Like 'expunge', but all of the entries are deleted with a single
+  // (atomic) write.
+  leveldb::WriteBatch batch;
+
+  foreach (const Entry& entry, entries) {
+    Try<Option<Entry> > option = read(entry.name());
+
+    if (option.isError()) {
+      return Failure(option.error());
+    }
+
+    if (option.get().isNone()) {
+      return false;
+    }
+
+    if (UUID::fromBytes(option.get().get().uuid()) !=
+        UUID::fromBytes(entry.uuid())) {
+      return false;
+    }
+
+    batch.Delete(entry.name());
+  }
+
+  leveldb::WriteOptions options;
+  options.sync = true;
+
+  leveldb::Status status = db->Write(options, &batch);
+
+  if (!status.ok()) {
+    return Failure(status.ToString());
+  }
+
+  return true;
+}
+
+
 Try<Option<Entry> > LevelDBStorageProcess::read(const string& name)
 {
   CHECK(error.isNone());
@@ -293,6 +414,26 @@ Future<std::set<string> > LevelDBStorage::names()
   return dispatch(process, &LevelDBStorageProcess::names);
 }
 
+
+Future<vector<Option<Entry> > > LevelDBStorage::getBatch(
+    const vector<string>& names)
+{
+  return dispatch(process, &LevelDBStorageProcess::getBatch, names);
+}
+
+
+Future<bool> LevelDBStorage::setBatch(
+    const vector<pair<Entry, UUID> >& entries)
+{
+  return dispatch(process, &LevelDBStorageProcess::setBatch, entries);
+}
+
+
+Future<bool> LevelDBStorage::expungeBatch(const vector<Entry>& entries)
+{
+  return dispatch(process, &LevelDBStorageProcess::expungeBatch, entries);
+}
+
 } // namespace state {
 } // namespace internal {
 } // namespace mesos {
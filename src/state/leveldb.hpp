@@ -3,6 +3,8 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/future.hpp>
 
@@ -33,6 +35,12 @@ public:
   virtual process::Future<bool> set(const Entry& entry, const UUID& uuid);
   virtual process::Future<bool> expunge(const Entry& entry);
   virtual process::Future<std::set<std::string> > names();
+  virtual process::Future<std::vector<Option<Entry> > > getBatch(
+      const std::vector<std::string>& names);
+  virtual process::Future<bool> setBatch(
+      const std::vector<std::pair<Entry, UUID> >& entries);
+  virtual process::Future<bool> expungeBatch(
+      const std::vector<Entry>& entries);
 
 private:
   LevelDBStorageProcess* process;
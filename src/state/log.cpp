@@ -3,8 +3,11 @@
 #include <google/protobuf/io/zero_copy_stream_impl.h> // For ArrayInputStream.
 
 #include <list>
+#include <map>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
@@ -35,7 +38,9 @@ using namespace process;
 // Note that we don't add 'using std::set' here because we need
 // 'std::' to disambiguate the 'set' member.
 using std::list;
+using std::pair;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -53,6 +58,15 @@ namespace state {
 // implying the operation was not atomic and subsequent operations
 // will re-'start()' which will again read all positions to make sure
 // operations are consistent.
+//
+// To keep the log (and hence the time to read it on 'start()')
+// proportional to the size of the state rather than to its history
+// the log gets compacted once it holds more than
+// 'compactionThreshold' entries that are not needed to rebuild the
+// state (e.g., snapshots of entries that have since been overwritten
+// but that can not be truncated because an older snapshot of another
+// entry is still in use): the current snapshots are appended again
+// and everything before them gets truncated.
 // TODO(benh): Log demotion does not necessarily imply a non-atomic
 // read/modify/write. An alternative strategy might be to retry after
 // restarting via 'start' (and holding on to the mutex so no other
@@ -60,7 +74,10 @@ namespace state {
 class LogStorageProcess : public Process<LogStorageProcess>
 {
 public:
-  LogStorageProcess(Log* log, size_t diffsBetweenSnapshots);
+  LogStorageProcess(
+      Log* log,
+      size_t diffsBetweenSnapshots,
+      size_t compactionThreshold);
 
   virtual ~LogStorageProcess();
 
@@ -69,6 +86,9 @@ public:
   Future<bool> set(const state::Entry& entry, const UUID& uuid);
   Future<bool> expunge(const state::Entry& entry);
   Future<std::set<string> > names();
+  Future<vector<Option<state::Entry> > > getBatch(const vector<string>& names);
+  Future<bool> setBatch(const vector<pair<state::Entry, UUID> >& entries);
+  Future<bool> expungeBatch(const vector<state::Entry>& entries);
 
 protected:
   virtual void finalize();
@@ -90,6 +110,15 @@ private:
       const Log::Position& minimum,
       const Option<Log::Position>& position);
 
+  // Helpers for compacting the log, i.e., appending the snapshots
+  // with the specified names again (in order).
+  bool fragmented();
+  Future<Nothing> compact(list<string> names);
+  Future<Nothing> _compact(
+      const list<string>& names,
+      const string& name,
+      const Option<Log::Position>& position);
+
   // Continuations.
   Future<Option<state::Entry> > _get(const string& name);
 
@@ -108,10 +137,30 @@ private:
 
   Future<std::set<string> > _names();
 
+  Future<vector<Option<state::Entry> > > _getBatch(
+      const vector<string>& names);
+
+  Future<bool> _setBatch(const vector<pair<state::Entry, UUID> >& entries);
+  Future<bool> __setBatch(const vector<pair<state::Entry, UUID> >& entries);
+
+  Future<bool> _expungeBatch(const vector<state::Entry>& entries);
+  Future<bool> __expungeBatch(const vector<state::Entry>& entries);
+
+  // Appends a BATCH operation and applies it once it was appended.
+  Future<bool> batch(const Operation& operation);
+  Future<bool> _batch(
+      const Operation& operation,
+      const Option<Log::Position>& position);
+
+  // Helper for updating the snapshots with a SNAPSHOT or EXPUNGE
+  // operation that was appended at 'position'.
+  void update(const Operation& operation, const Log::Position& position);
+
   Log::Reader reader;
   Log::Writer writer;
 
   const size_t diffsBetweenSnapshots;
+  const size_t compactionThreshold;
 
   // Used to serialize Log::Writer::append/truncate operations.
   Mutex mutex;
@@ -125,6 +174,10 @@ private:
   // Last position in the log up to which we've truncated.
   Option<Log::Position> truncated;
 
+  // Number of log entries we've read or written, used to determine
+  // how many entries the log holds from a snapshot on.
+  uint64_t sequence;
+
   // Note that while it would be nice to just use Operation::Snapshot
   // modified to include a required field called 'position' we don't
   // know the position (nor can we determine it) before we've done the
@@ -132,9 +185,11 @@ private:
   struct Snapshot
   {
     Snapshot(const Log::Position& position,
+             uint64_t sequence,
              const state::Entry& entry,
              size_t diffs = 0)
       : position(position),
+        sequence(sequence),
         entry(entry),
         diffs(diffs) {}
 
@@ -156,7 +211,7 @@ private:
       Entry entry(diff.entry());
       entry.set_value(patch.get());
 
-      return Snapshot(position, entry, diffs + 1);
+      return Snapshot(position, sequence, entry, diffs + 1);
     }
 
     // Position in the log where this snapshot is located. NOTE: if
@@ -164,6 +219,9 @@ private:
     // the snapshot, not the last DIFF record in the log.
     const Log::Position position;
 
+    // The 'sequence' number of the entry at 'position'.
+    const uint64_t sequence;
+
     // TODO(benh): Rather than storing the entire state::Entry we
     // should just store the position, name, and UUID and cache the
     // data so we don't use too much memory.
@@ -198,10 +256,15 @@ private:
 };
 
 
-LogStorageProcess::LogStorageProcess(Log* log, size_t diffsBetweenSnapshots)
+LogStorageProcess::LogStorageProcess(
+    Log* log,
+    size_t diffsBetweenSnapshots,
+    size_t compactionThreshold)
   : reader(log),
     writer(log),
-    diffsBetweenSnapshots(diffsBetweenSnapshots) {}
+    diffsBetweenSnapshots(diffsBetweenSnapshots),
+    compactionThreshold(compactionThreshold),
+    sequence(0) {}
 
 
 LogStorageProcess::~LogStorageProcess() {}
@@ -300,13 +363,12 @@ Future<Nothing> LogStorageProcess::apply(const list<Log::Entry>& entries)
         return Failure("Failed to deserialize Operation");
       }
 
+      sequence++;
+
       switch (operation.type()) {
         case Operation::SNAPSHOT: {
           CHECK(operation.has_snapshot());
-
-          // Add or update (override) the snapshot.
-          Snapshot snapshot(entry.position, operation.snapshot().entry());
-          snapshots.put(snapshot.entry.name(), snapshot);
+          update(operation, entry.position);
           break;
         }
 
@@ -331,7 +393,23 @@ Future<Nothing> LogStorageProcess::apply(const list<Log::Entry>& entries)
 
         case Operation::EXPUNGE: {
           CHECK(operation.has_expunge());
-          snapshots.erase(operation.expunge().name());
+          update(operation, entry.position);
+          break;
+        }
+
+        case Operation::BATCH: {
+          CHECK(operation.has_batch());
+
+          foreach (const Operation& batched, operation.batch().operations()) {
+            if (batched.type() != Operation::SNAPSHOT &&
+                batched.type() != Operation::EXPUNGE) {
+              return Failure(
+                  "Unexpected operation in batch: " +
+                  stringify(batched.type()));
+            }
+
+            update(batched, entry.position);
+          }
           break;
         }
 
@@ -347,14 +425,40 @@ Future<Nothing> LogStorageProcess::apply(const list<Log::Entry>& entries)
 }
 
 
+void LogStorageProcess::update(
+    const Operation& operation,
+    const Log::Position& position)
+{
+  switch (operation.type()) {
+    case Operation::SNAPSHOT: {
+      CHECK(operation.has_snapshot());
+
+      // Add or update (override) the snapshot.
+      Snapshot snapshot(position, sequence, operation.snapshot().entry());
+      snapshots.put(snapshot.entry.name(), snapshot);
+      break;
+    }
+
+    case Operation::EXPUNGE: {
+      CHECK(operation.has_expunge());
+      snapshots.erase(operation.expunge().name());
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected operation: " << operation.type();
+  }
+}
+
+
 // TODO(benh): Truncation could be optimized by saving the "oldest"
 // snapshot and only doing a truncation if/when we update that
 // snapshot.
-// TODO(benh): Truncation is not enough to keep the log size small as
-// the log could get very fragmented. We'll need a way to defragment
-// the log as some state entries might not get set over a long period
-// of time and their associated snapshots are causing the log to grow
-// very big.
+// NOTE: Truncation alone is not enough to keep the log size small as
+// the log could get very fragmented, e.g., if some state entries
+// don't get set over a long period of time their associated
+// snapshots keep the log from being truncated. Hence we compact a
+// fragmented log first (see 'fragmented' and 'compact').
 void LogStorageProcess::truncate()
 {
   // We lock the truncation since it includes a call to
@@ -368,6 +472,28 @@ void LogStorageProcess::truncate()
 
 Future<Nothing> LogStorageProcess::_truncate()
 {
+  if (fragmented()) {
+    // Append the snapshots again from the oldest to the newest, the
+    // truncation happens once they've all been appended.
+    std::multimap<Log::Position, string> positions;
+
+    foreachvalue (const Snapshot& snapshot, snapshots) {
+      positions.insert(
+          std::make_pair(snapshot.position, snapshot.entry.name()));
+    }
+
+    list<string> names;
+
+    foreachvalue (const string& name, positions) {
+      names.push_back(name);
+    }
+
+    VLOG(1) << "Compacting the log by appending " << names.size()
+            << " snapshots";
+
+    return compact(names);
+  }
+
   // Determine the minimum necessary position for all the snapshots.
   Option<Log::Position> minimum = None();
 
@@ -415,6 +541,89 @@ Future<Nothing> LogStorageProcess::__truncate(
 }
 
 
+bool LogStorageProcess::fragmented()
+{
+  if (snapshots.empty()) {
+    return false;
+  }
+
+  // Determine the oldest snapshot and the number of entries needed
+  // to rebuild the state (i.e., the snapshots and their diffs).
+  uint64_t oldest = sequence;
+  uint64_t needed = 0;
+
+  foreachvalue (const Snapshot& snapshot, snapshots) {
+    oldest = std::min(oldest, snapshot.sequence);
+    needed += 1 + snapshot.diffs;
+  }
+
+  // All the entries from the oldest snapshot on can not be truncated.
+  const uint64_t entries = sequence - oldest + 1;
+  const uint64_t obsolete = entries > needed ? entries - needed : 0;
+
+  // NOTE: We also wait for at least as many obsolete entries as
+  // there are needed ones since compacting appends all of the
+  // snapshots again, i.e., the cost of compacting is amortized over
+  // the operations that made the entries obsolete.
+  return obsolete > std::max<uint64_t>(compactionThreshold, needed);
+}
+
+
+Future<Nothing> LogStorageProcess::compact(list<string> names)
+{
+  if (names.empty()) {
+    // All the snapshots have been appended again, now we can truncate
+    // everything before them.
+    return _truncate();
+  }
+
+  const string name = names.front();
+  names.pop_front();
+
+  Option<Snapshot> snapshot = snapshots.get(name);
+  CHECK_SOME(snapshot);
+
+  // NOTE: Any diffs get folded into the full snapshot.
+  Operation operation;
+  operation.set_type(Operation::SNAPSHOT);
+  operation.mutable_snapshot()->mutable_entry()->CopyFrom(
+      snapshot.get().entry);
+
+  string value;
+  if (!operation.SerializeToString(&value)) {
+    return Failure("Failed to serialize SNAPSHOT Operation");
+  }
+
+  return writer.append(value)
+    .then(defer(self(), &Self::_compact, names, name, lambda::_1));
+}
+
+
+Future<Nothing> LogStorageProcess::_compact(
+    const list<string>& names,
+    const string& name,
+    const Option<Log::Position>& position)
+{
+  // Like truncation, don't bother retrying a compaction if we're
+  // demoted, we'll just try again the next time 'truncate()' gets
+  // called (after we've done what's necessary to append again).
+  if (position.isNone()) {
+    starting = None(); // Reset 'starting' so we try again.
+    return Nothing();
+  }
+
+  index = max(index, position);
+  sequence++;
+
+  CHECK(snapshots.contains(name));
+
+  Snapshot snapshot(position.get(), sequence, snapshots.get(name).get().entry);
+  snapshots.put(name, snapshot);
+
+  return compact(names);
+}
+
+
 Future<Option<state::Entry> > LogStorageProcess::get(const string& name)
 {
   return start()
@@ -537,17 +746,21 @@ Future<bool> LogStorageProcess::___set(
   // Update index so we don't bother reading anything before this
   // position again (if we don't have to).
   index = max(index, position);
+  sequence++;
 
   // Determine the position that represents the snapshot: if we just
   // wrote a diff then we want to use the existing position of the
   // snapshot, otherwise we just overwrote the snapshot so we should
   // use the returned position (i.e., do nothing).
+  uint64_t _sequence = sequence;
+
   if (diffs > 0) {
     CHECK(snapshots.contains(entry.name()));
     position = snapshots.get(entry.name()).get().position;
+    _sequence = snapshots.get(entry.name()).get().sequence;
   }
 
-  Snapshot snapshot(position.get(), entry, diffs);
+  Snapshot snapshot(position.get(), _sequence, entry, diffs);
   snapshots.put(snapshot.entry.name(), snapshot);
 
   // And truncate the log if necessary.
@@ -610,6 +823,9 @@ Future<bool> LogStorageProcess::___expunge(
     return false;
   }
 
+  index = max(index, position);
+  sequence++;
+
   // Remove from snapshots and truncate the log if possible.
   CHECK(snapshots.contains(entry.name()));
   snapshots.erase(entry.name());
@@ -633,9 +849,166 @@ Future<std::set<string> > LogStorageProcess::_names()
 }
 
 
-LogStorage::LogStorage(Log* log, size_t diffsBetweenSnapshots)
+Future<vector<Option<state::Entry> > > LogStorageProcess::getBatch(
+    const vector<string>& names)
 {
-  process = new LogStorageProcess(log, diffsBetweenSnapshots);
+  return start()
+    .then(defer(self(), &Self::_getBatch, names));
+}
+
+
+Future<vector<Option<state::Entry> > > LogStorageProcess::_getBatch(
+    const vector<string>& names)
+{
+  vector<Option<state::Entry> > entries;
+
+  foreach (const string& name, names) {
+    Option<Snapshot> snapshot = snapshots.get(name);
+
+    if (snapshot.isNone()) {
+      entries.push_back(None());
+    } else {
+      entries.push_back(snapshot.get().entry);
+    }
+  }
+
+  return entries;
+}
+
+
+Future<bool> LogStorageProcess::setBatch(
+    const vector<pair<state::Entry, UUID> >& entries)
+{
+  return mutex.lock()
+    .then(defer(self(), &Self::_setBatch, entries))
+    .onAny(lambda::bind(&Mutex::unlock, mutex));
+}
+
+
+Future<bool> LogStorageProcess::_setBatch(
+    const vector<pair<state::Entry, UUID> >& entries)
+{
+  return start()
+    .then(defer(self(), &Self::__setBatch, entries));
+}
+
+
+Future<bool> LogStorageProcess::__setBatch(
+    const vector<pair<state::Entry, UUID> >& entries)
+{
+  // NOTE: We always write full snapshots in a batch.
+  Operation operation;
+  operation.set_type(Operation::BATCH);
+
+  typedef pair<state::Entry, UUID> Pair;
+
+  foreach (const Pair& pair, entries) {
+    Option<Snapshot> snapshot = snapshots.get(pair.first.name());
+
+    // Check the version first (if we've already got a snapshot).
+    if (snapshot.isSome() &&
+        UUID::fromBytes(snapshot.get().entry.uuid()) != pair.second) {
+      return false;
+    }
+
+    Operation* batched = operation.mutable_batch()->add_operations();
+    batched->set_type(Operation::SNAPSHOT);
+    batched->mutable_snapshot()->mutable_entry()->CopyFrom(pair.first);
+  }
+
+  return batch(operation);
+}
+
+
+Future<bool> LogStorageProcess::expungeBatch(
+    const vector<state::Entry>& entries)
+{
+  return mutex.lock()
+    .then(defer(self(), &Self::_expungeBatch, entries))
+    .onAny(lambda::bind(&Mutex::unlock, mutex));
+}
+
+
+Future<bool> LogStorageProcess::_expungeBatch(
+    const vector<state::Entry>& entries)
+{
+  return start()
+    .then(defer(self(), &Self::__expungeBatch, entries));
+}
+
+
+Future<bool> LogStorageProcess::__expungeBatch(
+    const vector<state::Entry>& entries)
+{
+  Operation operation;
+  operation.set_type(Operation::BATCH);
+
+  foreach (const state::Entry& entry, entries) {
+    Option<Snapshot> snapshot = snapshots.get(entry.name());
+
+    if (snapshot.isNone()) {
+      return false;
+    }
+
+    // Check the version first.
+    if (UUID::fromBytes(snapshot.get().entry.uuid()) !=
+        UUID::fromBytes(entry.uuid())) {
+      return false;
+    }
+
+    Operation* batched = operation.mutable_batch()->add_operations();
+    batched->set_type(Operation::EXPUNGE);
+    batched->mutable_expunge()->set_name(entry.name());
+  }
+
+  return batch(operation);
+}
+
+
+Future<bool> LogStorageProcess::batch(const Operation& operation)
+{
+  string value;
+  if (!operation.SerializeToString(&value)) {
+    return Failure("Failed to serialize BATCH Operation");
+  }
+
+  return writer.append(value)
+    .then(defer(self(), &Self::_batch, operation, lambda::_1));
+}
+
+
+Future<bool> LogStorageProcess::_batch(
+    const Operation& operation,
+    const Option<Log::Position>& position)
+{
+  if (position.isNone()) {
+    starting = None(); // Reset 'starting' so we try again.
+    return false;
+  }
+
+  index = max(index, position);
+  sequence++;
+
+  foreach (const Operation& batched, operation.batch().operations()) {
+    update(batched, position.get());
+  }
+
+  // And truncate the log if necessary.
+  truncate();
+
+  return true;
+}
+
+
+LogStorage::LogStorage(
+    Log* log,
+    size_t diffsBetweenSnapshots,
+    size_t compactionThreshold)
+{
+  process = new LogStorageProcess(
+      log,
+      diffsBetweenSnapshots,
+      compactionThreshold);
   spawn(process);
 }
 
@@ -671,6 +1044,26 @@ Future<std::set<string> > LogStorage::names()
   return dispatch(process, &LogStorageProcess::names);
 }
 
+
+Future<vector<Option<state::Entry> > > LogStorage::getBatch(
+    const vector<string>& names)
+{
+  return dispatch(process, &LogStorageProcess::getBatch, names);
+}
+
+
+Future<bool> LogStorage::setBatch(
+    const vector<pair<state::Entry, UUID> >& entries)
+{
+  return dispatch(process, &LogStorageProcess::setBatch, entries);
+}
+
+
+Future<bool> LogStorage::expungeBatch(const vector<state::Entry>& entries)
+{
+  return dispatch(process, &LogStorageProcess::expungeBatch, entries);
+}
+
 } // namespace state {
 } // namespace internal {
 } // namespace mesos {
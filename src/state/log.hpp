@@ -3,6 +3,8 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/future.hpp>
 
@@ -26,7 +28,13 @@ class LogStorageProcess;
 class LogStorage : public Storage
 {
 public:
-  LogStorage(log::Log* log, size_t diffsBetweenSnapshots = 0);
+  // The log gets compacted once it holds more than
+  // 'compactionThreshold' entries that are not needed to rebuild the
+  // state (see LogStorageProcess).
+  LogStorage(
+      log::Log* log,
+      size_t diffsBetweenSnapshots = 0,
+      size_t compactionThreshold = 1000);
 
   virtual ~LogStorage();
 
@@ -35,6 +43,12 @@ public:
   virtual process::Future<bool> set(const Entry& entry, const UUID& uuid);
   virtual process::Future<bool> expunge(const Entry& entry);
   virtual process::Future<std::set<std::string> > names();
+  virtual process::Future<std::vector<Option<Entry> > > getBatch(
+      const std::vector<std::string>& names);
+  virtual process::Future<bool> setBatch(
+      const std::vector<std::pair<Entry, UUID> >& entries);
+  virtual process::Future<bool> expungeBatch(
+      const std::vector<Entry>& entries);
 
 private:
   LogStorageProcess* process;
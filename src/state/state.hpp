@@ -21,10 +21,13 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/deferred.hpp> // TODO(benh): This is required by Clang.
 #include <process/future.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
@@ -113,6 +116,20 @@ public:
   // Returns the collection of variable names in the state.
   process::Future<std::set<std::string> > names();
 
+  // Batched versions of 'fetch', 'store' and 'expunge', which let the
+  // storage fetch, store or expunge many variables at once (e.g., in
+  // a single round trip or log write). Either all of the variables
+  // are stored (expunged) or, if the version of any of them was no
+  // longer valid, none of them is. A variable can only be stored or
+  // expunged once per batch.
+  process::Future<std::vector<Variable> > fetch(
+      const std::vector<std::string>& names);
+
+  process::Future<Option<std::vector<Variable> > > store(
+      const std::vector<Variable>& variables);
+
+  process::Future<bool> expunge(const std::vector<Variable>& variables);
+
 private:
   // Helpers to handle future results from fetch and swap. We make
   // these static members of State for friend access to Variable's
@@ -125,6 +142,14 @@ private:
       const Entry& entry,
       const bool& b); // TODO(benh): Remove 'const &' after fixing libprocess.
 
+  static process::Future<std::vector<Variable> > _fetchBatch(
+      const std::vector<std::string>& names,
+      const std::vector<Option<Entry> >& options);
+
+  static process::Future<Option<std::vector<Variable> > > _storeBatch(
+      const std::vector<Entry>& entries,
+      const bool& b); // TODO(benh): Remove 'const &' after fixing libprocess.
+
   Storage* storage;
 };
 
@@ -183,12 +208,103 @@ inline process::Future<Option<Variable > > State::_store(
 }
 
 
+inline process::Future<std::vector<Variable> > State::fetch(
+    const std::vector<std::string>& names)
+{
+  return storage->getBatch(names)
+    .then(lambda::bind(&State::_fetchBatch, names, lambda::_1));
+}
+
+
+inline process::Future<std::vector<Variable> > State::_fetchBatch(
+    const std::vector<std::string>& names,
+    const std::vector<Option<Entry> >& options)
+{
+  if (options.size() != names.size()) {
+    return process::Failure("Unexpected number of entries");
+  }
+
+  std::vector<Variable> variables;
+  for (size_t i = 0; i < names.size(); i++) {
+    // NOTE: '_fetch' always returns a ready future.
+    variables.push_back(_fetch(names[i], options[i]).get());
+  }
+
+  return variables;
+}
+
+
+inline process::Future<Option<std::vector<Variable> > > State::store(
+    const std::vector<Variable>& variables)
+{
+  std::vector<std::pair<Entry, UUID> > batch;
+  std::vector<Entry> entries;
+  std::set<std::string> names;
+
+  foreach (const Variable& variable, variables) {
+    if (!names.insert(variable.entry.name()).second) {
+      return process::Failure(
+          "Variable '" + variable.entry.name() + "' is in the batch twice");
+    }
+
+    // See 'store' above.
+    Entry entry;
+    entry.set_name(variable.entry.name());
+    entry.set_uuid(UUID::random().toBytes());
+    entry.set_value(variable.entry.value());
+
+    batch.push_back(
+        std::make_pair(entry, UUID::fromBytes(variable.entry.uuid())));
+    entries.push_back(entry);
+  }
+
+  return storage->setBatch(batch)
+    .then(lambda::bind(&State::_storeBatch, entries, lambda::_1));
+}
+
+
+inline process::Future<Option<std::vector<Variable> > > State::_storeBatch(
+    const std::vector<Entry>& entries,
+    const bool& b) // TODO(benh): Remove 'const &' after fixing libprocess.
+{
+  if (!b) {
+    return None();
+  }
+
+  std::vector<Variable> variables;
+  foreach (const Entry& entry, entries) {
+    variables.push_back(Variable(entry));
+  }
+
+  return Some(variables);
+}
+
+
 inline process::Future<bool> State::expunge(const Variable& variable)
 {
   return storage->expunge(variable.entry);
 }
 
 
+inline process::Future<bool> State::expunge(
+    const std::vector<Variable>& variables)
+{
+  std::vector<Entry> entries;
+  std::set<std::string> names;
+
+  foreach (const Variable& variable, variables) {
+    if (!names.insert(variable.entry.name()).second) {
+      return process::Failure(
+          "Variable '" + variable.entry.name() + "' is in the batch twice");
+    }
+
+    entries.push_back(variable.entry);
+  }
+
+  return storage->expungeBatch(entries);
+}
+
+
 inline process::Future<std::set<std::string> > State::names()
 {
   return storage->names();
@@ -19,11 +19,17 @@
 #ifndef __STATE_STORAGE_HPP__
 #define __STATE_STORAGE_HPP__
 
+#include <list>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include <process/collect.hpp>
 #include <process/future.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/lambda.hpp>
 #include <stout/option.hpp>
 #include <stout/uuid.hpp>
 
@@ -51,6 +57,43 @@ public:
 
   // Returns the collection of variable names in the state.
   virtual process::Future<std::set<std::string> > names() = 0;
+
+  // Batched versions of 'get', 'set' and 'expunge'. The entries are
+  // returned in the order of the names. A batch of entries is set
+  // (expunged) atomically, i.e., either all of the entries are set
+  // (expunged) or none of them is (when the existing entry of any of
+  // them does not have the specified UUID). By default the entries
+  // are fetched one by one and setting or expunging a batch is not
+  // supported.
+  virtual process::Future<std::vector<Option<Entry> > > getBatch(
+      const std::vector<std::string>& names)
+  {
+    std::list<process::Future<Option<Entry> > > futures;
+    foreach (const std::string& name, names) {
+      futures.push_back(get(name));
+    }
+
+    return process::collect(futures)
+      .then(lambda::bind(&Storage::_getBatch, lambda::_1));
+  }
+
+  virtual process::Future<bool> setBatch(
+      const std::vector<std::pair<Entry, UUID> >& entries)
+  {
+    return process::Failure("Setting a batch of entries is not supported");
+  }
+
+  virtual process::Future<bool> expungeBatch(const std::vector<Entry>& entries)
+  {
+    return process::Failure("Expunging a batch of entries is not supported");
+  }
+
+private:
+  static std::vector<Option<Entry> > _getBatch(
+      const std::list<Option<Entry> >& entries)
+  {
+    return std::vector<Option<Entry> >(entries.begin(), entries.end());
+  }
 };
 
 } // namespace state {
@@ -5,6 +5,7 @@
 #include <queue>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <process/dispatch.hpp>
@@ -13,10 +14,13 @@
 
 #include <stout/duration.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/result.hpp>
 #include <stout/some.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 #include <stout/uuid.hpp>
@@ -36,6 +40,7 @@ using namespace process;
 
 // Note that we don't add 'using std::set' here because we need
 // 'std::' to disambiguate the 'set' member.
+using std::pair;
 using std::queue;
 using std::string;
 using std::vector;
@@ -64,6 +69,9 @@ public:
   Future<bool> set(const Entry& entry, const UUID& uuid);
   virtual Future<bool> expunge(const Entry& entry);
   Future<std::set<string> > names();
+  Future<vector<Option<Entry> > > getBatch(const vector<string>& names);
+  Future<bool> setBatch(const vector<pair<Entry, UUID> >& entries);
+  Future<bool> expungeBatch(const vector<Entry>& entries);
 
   // ZooKeeper events.
   // Note that events from previous sessions are dropped.
@@ -80,6 +88,43 @@ private:
   Result<Option<Entry> > doGet(const string& name);
   Result<bool> doSet(const Entry& entry, const UUID& uuid);
   Result<bool> doExpunge(const Entry& entry);
+  Result<vector<Option<Entry> > > doGetBatch(const vector<string>& names);
+  Result<bool> doSetBatch(const vector<pair<Entry, UUID> >& entries);
+  Result<bool> doExpungeBatch(const vector<Entry>& entries);
+
+  // Creates the znodes of the path 'znode' as necessary.
+  Result<bool> doCreatePath();
+
+  // Parses the data of the znode of an entry, where an empty znode
+  // stands for an entry that is being created (see 'doSet').
+  Try<Option<Entry> > parse(const string& data);
+
+  // Returns the paths of the chunks of a chunked entry.
+  vector<string> chunks(const Entry& entry);
+
+  // An operation of a ZooKeeper 'multi'.
+  struct Op
+  {
+    enum Type {
+      CREATE,
+      SET,
+      REMOVE,
+    };
+
+    Op(Type _type,
+       const string& _path,
+       const string& _data = "",
+       int _version = -1)
+      : type(_type), path(_path), data(_data), version(_version) {}
+
+    Type type;
+    string path;
+    string data;
+    int version;
+  };
+
+  // Atomically performs the operations.
+  int multi(const vector<Op>& ops);
 
   const string servers;
 
@@ -131,6 +176,31 @@ private:
     Promise<bool> promise;
   };
 
+  struct GetBatch
+  {
+    explicit GetBatch(const vector<string>& _names) : names(_names) {}
+
+    vector<string> names;
+    Promise<vector<Option<Entry> > > promise;
+  };
+
+  struct SetBatch
+  {
+    explicit SetBatch(const vector<pair<Entry, UUID> >& _entries)
+      : entries(_entries) {}
+
+    vector<pair<Entry, UUID> > entries;
+    Promise<bool> promise;
+  };
+
+  struct ExpungeBatch
+  {
+    explicit ExpungeBatch(const vector<Entry>& _entries) : entries(_entries) {}
+
+    vector<Entry> entries;
+    Promise<bool> promise;
+  };
+
   // TODO(benh): Make pending a single queue of "operations" that can
   // be "invoked" (C++11 lambdas would help).
   struct {
@@ -138,12 +208,22 @@ private:
     queue<Get*> gets;
     queue<Set*> sets;
     queue<Expunge*> expunges;
+    queue<GetBatch*> getBatches;
+    queue<SetBatch*> setBatches;
+    queue<ExpungeBatch*> expungeBatches;
   } pending;
 
   Option<string> error;
 };
 
 
+// The size of the chunks of entries that are too big for a single
+// znode (the data of a znode is limited to 1 MB by default), which
+// leaves plenty of room for the overhead of the requests. This also
+// bounds the size of a batch, which is set with a single request.
+static const size_t CHUNK_SIZE = 512 * 1024;
+
+
 // Helper for failing a queue of promises.
 template <typename T>
 void fail(queue<T*>* queue, const string& message)
@@ -180,6 +260,9 @@ ZooKeeperStorageProcess::~ZooKeeperStorageProcess()
   fail(&pending.names, "No longer managing storage");
   fail(&pending.gets, "No longer managing storage");
   fail(&pending.sets, "No longer managing storage");
+  fail(&pending.getBatches, "No longer managing storage");
+  fail(&pending.setBatches, "No longer managing storage");
+  fail(&pending.expungeBatches, "No longer managing storage");
 
   delete zk;
   delete watcher;
@@ -291,6 +374,80 @@ Future<bool> ZooKeeperStorageProcess::expunge(const Entry& entry)
 }
 
 
+Future<vector<Option<Entry> > > ZooKeeperStorageProcess::getBatch(
+    const vector<string>& names)
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  } else if (state != CONNECTED) {
+    GetBatch* getBatch = new GetBatch(names);
+    pending.getBatches.push(getBatch);
+    return getBatch->promise.future();
+  }
+
+  Result<vector<Option<Entry> > > result = doGetBatch(names);
+
+  if (result.isNone()) { // Try again later.
+    GetBatch* getBatch = new GetBatch(names);
+    pending.getBatches.push(getBatch);
+    return getBatch->promise.future();
+  } else if (result.isError()) {
+    return Failure(result.error());
+  }
+
+  return result.get();
+}
+
+
+Future<bool> ZooKeeperStorageProcess::setBatch(
+    const vector<pair<Entry, UUID> >& entries)
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  } else if (state != CONNECTED) {
+    SetBatch* setBatch = new SetBatch(entries);
+    pending.setBatches.push(setBatch);
+    return setBatch->promise.future();
+  }
+
+  Result<bool> result = doSetBatch(entries);
+
+  if (result.isNone()) { // Try again later.
+    SetBatch* setBatch = new SetBatch(entries);
+    pending.setBatches.push(setBatch);
+    return setBatch->promise.future();
+  } else if (result.isError()) {
+    return Failure(result.error());
+  }
+
+  return result.get();
+}
+
+
+Future<bool> ZooKeeperStorageProcess::expungeBatch(const vector<Entry>& entries)
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  } else if (state != CONNECTED) {
+    ExpungeBatch* expungeBatch = new ExpungeBatch(entries);
+    pending.expungeBatches.push(expungeBatch);
+    return expungeBatch->promise.future();
+  }
+
+  Result<bool> result = doExpungeBatch(entries);
+
+  if (result.isNone()) { // Try again later.
+    ExpungeBatch* expungeBatch = new ExpungeBatch(entries);
+    pending.expungeBatches.push(expungeBatch);
+    return expungeBatch->promise.future();
+  } else if (result.isError()) {
+    return Failure(result.error());
+  }
+
+  return result.get();
+}
+
+
 void ZooKeeperStorageProcess::connected(int64_t sessionId, bool reconnect)
 {
   if (sessionId != zk->getSessionId()) {
@@ -355,6 +512,62 @@ void ZooKeeperStorageProcess::connected(int64_t sessionId, bool reconnect)
     pending.sets.pop();
     delete set;
   }
+
+  while (!pending.getBatches.empty()) {
+    GetBatch* getBatch = pending.getBatches.front();
+    Result<vector<Option<Entry> > > result = doGetBatch(getBatch->names);
+    if (result.isNone()) {
+      return; // Try again later.
+    } else if (result.isError()) {
+      getBatch->promise.fail(result.error());
+    } else {
+      getBatch->promise.set(result.get());
+    }
+    pending.getBatches.pop();
+    delete getBatch;
+  }
+
+  while (!pending.setBatches.empty()) {
+    SetBatch* setBatch = pending.setBatches.front();
+    Result<bool> result = doSetBatch(setBatch->entries);
+    if (result.isNone()) {
+      return; // Try again later.
+    } else if (result.isError()) {
+      setBatch->promise.fail(result.error());
+    } else {
+      setBatch->promise.set(result.get());
+    }
+    pending.setBatches.pop();
+    delete setBatch;
+  }
+
+  while (!pending.expunges.empty()) {
+    Expunge* expunge = pending.expunges.front();
+    Result<bool> result = doExpunge(expunge->entry);
+    if (result.isNone()) {
+      return; // Try again later.
+    } else if (result.isError()) {
+      expunge->promise.fail(result.error());
+    } else {
+      expunge->promise.set(result.get());
+    }
+    pending.expunges.pop();
+    delete expunge;
+  }
+
+  while (!pending.expungeBatches.empty()) {
+    ExpungeBatch* expungeBatch = pending.expungeBatches.front();
+    Result<bool> result = doExpungeBatch(expungeBatch->entries);
+    if (result.isNone()) {
+      return; // Try again later.
+    } else if (result.isError()) {
+      expungeBatch->promise.fail(result.error());
+    } else {
+      expungeBatch->promise.set(result.get());
+    }
+    pending.expungeBatches.pop();
+    delete expungeBatch;
+  }
 }
 
 
@@ -429,31 +642,83 @@ Result<Option<Entry> > ZooKeeperStorageProcess::doGet(const string& name)
   CHECK(error.isNone()) << ": " << error.get();
   CHECK(state == CONNECTED);
 
-  string result;
-  Stat stat;
+  // The version of the znode of the entry when some of its chunks
+  // were found to be missing.
+  Option<int32_t> version = None();
 
-  int code = zk->get(znode + "/" + name, false, &result, &stat);
+  while (true) {
+    string result;
+    Stat stat;
 
-  if (code == ZNONODE) {
-    return Option<Entry>::none();
-  } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
-    CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
-    return None(); // Try again later.
-  } else if (code != ZOK) {
-    return Error(
-        "Failed to get '" + znode + "/" + name +
-        "' in ZooKeeper: " + zk->message(code));
-  }
+    int code = zk->get(znode + "/" + name, false, &result, &stat);
 
-  google::protobuf::io::ArrayInputStream stream(result.data(), result.size());
+    if (code == ZNONODE) {
+      return Option<Entry>::none();
+    } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+      CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+      return None(); // Try again later.
+    } else if (code != ZOK) {
+      return Error(
+          "Failed to get '" + znode + "/" + name +
+          "' in ZooKeeper: " + zk->message(code));
+    }
 
-  Entry entry;
+    Try<Option<Entry> > entry = parse(result);
 
-  if (!entry.ParseFromZeroCopyStream(&stream)) {
-    return Error("Failed to deserialize Entry");
-  }
+    if (entry.isError()) {
+      return Error(entry.error());
+    } else if (entry.get().isNone() || !entry.get().get().has_chunks()) {
+      return entry.get();
+    }
 
-  return Some(entry);
+    // Get all of the chunks at once.
+    vector<string> results;
+    vector<Stat> stats;
+    vector<int> codes = zk->get(chunks(entry.get().get()), &results, &stats);
+
+    bool missing = false;
+
+    foreach (int code, codes) {
+      if (code == ZNONODE) {
+        missing = true;
+      } else if (code == ZINVALIDSTATE ||
+                 (code != ZOK && zk->retryable(code))) {
+        CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+        return None(); // Try again later.
+      } else if (code != ZOK) {
+        return Error(
+            "Failed to get the chunks of '" + znode + "/" + name +
+            "' in ZooKeeper: " + zk->message(code));
+      }
+    }
+
+    if (!missing) {
+      string data;
+      foreach (const string& chunk, results) {
+        data += chunk;
+      }
+
+      entry = parse(data);
+
+      if (entry.isError()) {
+        return Error(entry.error());
+      } else if (entry.get().isNone()) {
+        return Error("Failed to deserialize Entry: No chunks");
+      }
+
+      return entry.get();
+    }
+
+    // The chunks of an entry are removed once the entry has been
+    // replaced (see 'doSet'), in which case we try again.
+    if (version.isSome() && version.get() == stat.version) {
+      return Error(
+          "Failed to get the chunks of '" + znode + "/" + name +
+          "' in ZooKeeper: Some chunks are missing");
+    }
+
+    version = stat.version;
+  }
 }
 
 
@@ -463,47 +728,34 @@ Result<bool> ZooKeeperStorageProcess::doSet(const Entry& entry,
   CHECK(error.isNone()) << ": " << error.get();
   CHECK(state == CONNECTED);
 
-  // Serialize to make sure we're under the 1 MB limit.
   string data;
 
   if (!entry.SerializeToString(&data)) {
     return Error("Failed to serialize Entry");
   }
 
-  if (data.size() > 1024 * 1024) { // 1 MB
-    // TODO(benh): Use stout/gzip.hpp for compression.
-    return Error("Serialized data is too big (> 1 MB)");
-  }
+  const string path = znode + "/" + entry.name();
+
+  // Entries that are too big for a single znode are split into
+  // chunks, which are stored as children of the znode of the entry
+  // (see below).
+  const bool chunked = data.size() > CHUNK_SIZE;
 
   string result;
   Stat stat;
 
-  int code = zk->get(znode + "/" + entry.name(), false, &result, &stat);
+  int code = zk->get(path, false, &result, &stat);
 
   if (code == ZNONODE) {
-    // Create directory path znodes as necessary.
-    CHECK(znode.size() == 0 || znode.at(znode.size() - 1) != '/');
-    size_t index = znode.find("/", 0);
-
-    while (index < string::npos) {
-      // Get out the prefix to create.
-      index = znode.find("/", index + 1);
-      string prefix = znode.substr(0, index);
-
-      // Create the znode (even if it already exists).
-      code = zk->create(prefix, "", acl, 0, NULL);
-
-      if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
-        CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
-        return None(); // Try again later.
-      } else if (code != ZOK && code != ZNODEEXISTS) {
-        return Error(
-            "Failed to create '" + prefix +
-            "' in ZooKeeper: " + zk->message(code));
-      }
+    Result<bool> created = doCreatePath();
+    if (created.isNone() || created.isError()) {
+      return created;
     }
 
-    code = zk->create(znode + "/" + entry.name(), data, acl, 0, NULL);
+    // A chunked entry starts out as an empty znode, which stands for
+    // an entry that does not exist yet, so that its chunks can be
+    // created underneath it.
+    code = zk->create(path, chunked ? "" : data, acl, 0, NULL);
 
     if (code == ZNODEEXISTS) {
       return false; // Lost a race with someone else.
@@ -512,44 +764,104 @@ Result<bool> ZooKeeperStorageProcess::doSet(const Entry& entry,
       return None(); // Try again later.
     } else if (code != ZOK) {
       return Error(
-          "Failed to create '" + znode + "/" + entry.name() +
+          "Failed to create '" + path +
           "' in ZooKeeper: " + zk->message(code));
     }
 
-    return true;
+    if (!chunked) {
+      return true;
+    }
+
+    result.clear();
+    stat.version = 0;
   } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
     CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
     return None(); // Try again later.
   } else if (code != ZOK) {
     return Error(
-        "Failed to get '" + znode + "/" + entry.name() +
-        "' in ZooKeeper: " + zk->message(code));
+        "Failed to get '" + path + "' in ZooKeeper: " + zk->message(code));
   }
 
-  google::protobuf::io::ArrayInputStream stream(result.data(), result.size());
+  Try<Option<Entry> > current = parse(result);
 
-  Entry current;
+  if (current.isError()) {
+    return Error(current.error());
+  } else if (current.get().isSome() &&
+             UUID::fromBytes(current.get().get().uuid()) != uuid) {
+    return false;
+  }
 
-  if (!current.ParseFromZeroCopyStream(&stream)) {
-    return Error("Failed to deserialize Entry");
+  // The chunks of the current entry (if any) get removed along with
+  // setting the entry.
+  vector<string> removes;
+  if (current.get().isSome()) {
+    removes = chunks(current.get().get());
   }
 
-  if (UUID::fromBytes(current.uuid()) != uuid) {
-    return false;
+  vector<string> creates;
+
+  if (chunked) {
+    Entry manifest;
+    manifest.set_name(entry.name());
+    manifest.set_uuid(entry.uuid());
+    manifest.set_value("");
+    manifest.set_chunks((data.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+
+    creates = chunks(manifest);
+
+    for (size_t i = 0; i < creates.size(); i++) {
+      const string chunk = data.substr(i * CHUNK_SIZE, CHUNK_SIZE);
+
+      code = zk->create(creates[i], chunk, acl, 0, NULL);
+
+      if (code == ZNODEEXISTS) {
+        // Created by an earlier attempt to set this entry.
+        code = zk->set(creates[i], chunk, -1);
+      }
+
+      if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+        CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+        return None(); // Try again later.
+      } else if (code != ZOK) {
+        return Error(
+            "Failed to create '" + creates[i] +
+            "' in ZooKeeper: " + zk->message(code));
+      }
+    }
+
+    // The znode of the entry just points to the chunks.
+    if (!manifest.SerializeToString(&data)) {
+      return Error("Failed to serialize Entry");
+    }
   }
 
   // Okay, do the set, we get atomicity by requiring 'stat.version'.
-  code = zk->set(znode + "/" + entry.name(), data, stat.version);
+  if (removes.empty()) {
+    code = zk->set(path, data, stat.version);
+  } else {
+    vector<Op> ops;
+    ops.push_back(Op(Op::SET, path, data, stat.version));
+    foreach (const string& remove, removes) {
+      ops.push_back(Op(Op::REMOVE, remove));
+    }
+
+    code = multi(ops);
+  }
 
   if (code == ZBADVERSION) {
+    // Remove the chunks we created (best effort, any chunks left
+    // behind are removed along with the entry).
+    foreach (const string& create, creates) {
+      zk->remove(create, -1);
+    }
+
     return false;
   } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
     CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
     return None(); // Try again later.
   } else if (code != ZOK) {
     return Error(
-        "Failed to set '" + znode + "/" + entry.name() +
-        "' in ZooKeeper: " + zk->message(code));
+        "Failed to set '" + path + "' in ZooKeeper: " + zk->message(code));
   }
 
   return true;
@@ -561,10 +873,12 @@ Result<bool> ZooKeeperStorageProcess::doExpunge(const Entry& entry)
   CHECK(error.isNone()) << ": " << error.get();
   CHECK(state == CONNECTED);
 
+  const string path = znode + "/" + entry.name();
+
   string result;
   Stat stat;
 
-  int code = zk->get(znode + "/" + entry.name(), false, &result, &stat);
+  int code = zk->get(path, false, &result, &stat);
 
   if (code == ZNONODE) {
     return false;
@@ -573,33 +887,227 @@ Result<bool> ZooKeeperStorageProcess::doExpunge(const Entry& entry)
     return None(); // Try again later.
   } else if (code != ZOK) {
     return Error(
-        "Failed to get '" + znode + "/" + entry.name() +
-        "' in ZooKeeper: " + zk->message(code));
+        "Failed to get '" + path + "' in ZooKeeper: " + zk->message(code));
   }
 
-  google::protobuf::io::ArrayInputStream stream(result.data(), result.size());
+  Try<Option<Entry> > current = parse(result);
 
-  Entry current;
+  if (current.isError()) {
+    return Error(current.error());
+  } else if (current.get().isNone()) {
+    return false;
+  }
 
-  if (!current.ParseFromZeroCopyStream(&stream)) {
-    return Error("Failed to deserialize Entry");
+  if (UUID::fromBytes(current.get().get().uuid()) !=
+      UUID::fromBytes(entry.uuid())) {
+    return false;
   }
 
-  if (UUID::fromBytes(current.uuid()) != UUID::fromBytes(entry.uuid())) {
+  // Get the children of the znode, which are the chunks of the entry
+  // plus any chunks left behind by failed attempts to set it.
+  vector<string> children;
+
+  code = zk->getChildren(path, false, &children);
+
+  if (code == ZNONODE) {
     return false;
+  } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+    CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+    return None(); // Try again later.
+  } else if (code != ZOK) {
+    return Error(
+        "Failed to get children of '" + path +
+        "' in ZooKeeper: " + zk->message(code));
   }
 
   // Okay, do the remove, we get atomicity by requiring 'stat.version'.
-  code = zk->remove(znode + "/" + entry.name(), stat.version);
+  if (children.empty()) {
+    code = zk->remove(path, stat.version);
+  } else {
+    vector<Op> ops;
+    foreach (const string& child, children) {
+      ops.push_back(Op(Op::REMOVE, path + "/" + child));
+    }
+    ops.push_back(Op(Op::REMOVE, path, "", stat.version));
 
-  if (code == ZBADVERSION) {
+    code = multi(ops);
+  }
+
+  // A chunk is missing (or a new one was added) only if the entry was
+  // replaced concurrently.
+  if (code == ZBADVERSION || code == ZNONODE || code == ZNOTEMPTY) {
     return false;
   } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
     CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
     return None(); // Try again later.
   } else if (code != ZOK) {
     return Error(
-        "Failed to remove '" + znode + "/" + entry.name() +
+        "Failed to remove '" + path + "' in ZooKeeper: " + zk->message(code));
+  }
+
+  return true;
+}
+
+
+Result<vector<Option<Entry> > > ZooKeeperStorageProcess::doGetBatch(
+    const vector<string>& names)
+{
+  CHECK(error.isNone()) << ": " << error.get();
+  CHECK(state == CONNECTED);
+
+  vector<string> paths;
+  foreach (const string& name, names) {
+    paths.push_back(znode + "/" + name);
+  }
+
+  vector<string> results;
+  vector<Stat> stats;
+  vector<int> codes = zk->get(paths, &results, &stats);
+
+  vector<Option<Entry> > entries;
+
+  for (size_t i = 0; i < names.size(); i++) {
+    if (codes[i] == ZNONODE) {
+      entries.push_back(None());
+      continue;
+    } else if (codes[i] == ZINVALIDSTATE ||
+               (codes[i] != ZOK && zk->retryable(codes[i]))) {
+      CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+      return None(); // Try again later.
+    } else if (codes[i] != ZOK) {
+      return Error(
+          "Failed to get '" + paths[i] +
+          "' in ZooKeeper: " + zk->message(codes[i]));
+    }
+
+    Try<Option<Entry> > entry = parse(results[i]);
+
+    if (entry.isError()) {
+      return Error(entry.error());
+    } else if (entry.get().isSome() && entry.get().get().has_chunks()) {
+      // Chunked entries are big anyway, so we just get them one by
+      // one.
+      Result<Option<Entry> > chunked = doGet(names[i]);
+
+      if (chunked.isNone()) {
+        return None(); // Try again later.
+      } else if (chunked.isError()) {
+        return Error(chunked.error());
+      }
+
+      entries.push_back(chunked.get());
+    } else {
+      entries.push_back(entry.get());
+    }
+  }
+
+  return entries;
+}
+
+
+Result<bool> ZooKeeperStorageProcess::doSetBatch(
+    const vector<pair<Entry, UUID> >& entries)
+{
+  CHECK(error.isNone()) << ": " << error.get();
+  CHECK(state == CONNECTED);
+
+  if (entries.empty()) {
+    return true;
+  }
+
+  vector<string> paths;
+  vector<string> datas;
+  hashset<string> names;
+  size_t size = 0;
+
+  typedef pair<Entry, UUID> Pair;
+
+  foreach (const Pair& pair, entries) {
+    const string& name = pair.first.name();
+
+    if (names.contains(name)) {
+      return Error("Entry '" + name + "' is in the batch more than once");
+    }
+
+    names.insert(name);
+
+    string data;
+
+    if (!pair.first.SerializeToString(&data)) {
+      return Error("Failed to serialize Entry");
+    }
+
+    size += data.size();
+
+    paths.push_back(znode + "/" + name);
+    datas.push_back(data);
+  }
+
+  // The batch is set with a single request, which is subject to the
+  // same limit as the data of a single znode, so we can not chunk it.
+  if (size > CHUNK_SIZE) {
+    return Error(
+        "Serialized entries are too big (> " + stringify(CHUNK_SIZE) +
+        " bytes) to be set in a batch");
+  }
+
+  vector<string> results;
+  vector<Stat> stats;
+  vector<int> codes = zk->get(paths, &results, &stats);
+
+  vector<Op> ops;
+  bool create = false;
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (codes[i] == ZNONODE) {
+      ops.push_back(Op(Op::CREATE, paths[i], datas[i]));
+      create = true;
+      continue;
+    } else if (codes[i] == ZINVALIDSTATE ||
+               (codes[i] != ZOK && zk->retryable(codes[i]))) {
+      CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+      return None(); // Try again later.
+    } else if (codes[i] != ZOK) {
+      return Error(
+          "Failed to get '" + paths[i] +
+          "' in ZooKeeper: " + zk->message(codes[i]));
+    }
+
+    Try<Option<Entry> > current = parse(results[i]);
+
+    if (current.isError()) {
+      return Error(current.error());
+    } else if (current.get().isSome()) {
+      if (UUID::fromBytes(current.get().get().uuid()) != entries[i].second) {
+        return false;
+      }
+
+      foreach (const string& chunk, chunks(current.get().get())) {
+        ops.push_back(Op(Op::REMOVE, chunk));
+      }
+    }
+
+    // We get atomicity by requiring 'stat.version'.
+    ops.push_back(Op(Op::SET, paths[i], datas[i], stats[i].version));
+  }
+
+  if (create) {
+    Result<bool> created = doCreatePath();
+    if (created.isNone() || created.isError()) {
+      return created;
+    }
+  }
+
+  int code = multi(ops);
+
+  if (code == ZBADVERSION || code == ZNODEEXISTS || code == ZNONODE) {
+    return false; // Lost a race with someone else.
+  } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+    CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+    return None(); // Try again later.
+  } else if (code != ZOK) {
+    return Error(
+        "Failed to set entries in '" + znode +
         "' in ZooKeeper: " + zk->message(code));
   }
 
@@ -607,6 +1115,183 @@ Result<bool> ZooKeeperStorageProcess::doExpunge(const Entry& entry)
 }
 
 
+Result<bool> ZooKeeperStorageProcess::doExpungeBatch(
+    const vector<Entry>& entries)
+{
+  CHECK(error.isNone()) << ": " << error.get();
+  CHECK(state == CONNECTED);
+
+  if (entries.empty()) {
+    return true;
+  }
+
+  vector<string> paths;
+  foreach (const Entry& entry, entries) {
+    paths.push_back(znode + "/" + entry.name());
+  }
+
+  vector<string> results;
+  vector<Stat> stats;
+  vector<int> codes = zk->get(paths, &results, &stats);
+
+  vector<Op> ops;
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (codes[i] == ZNONODE) {
+      return false;
+    } else if (codes[i] == ZINVALIDSTATE ||
+               (codes[i] != ZOK && zk->retryable(codes[i]))) {
+      CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+      return None(); // Try again later.
+    } else if (codes[i] != ZOK) {
+      return Error(
+          "Failed to get '" + paths[i] +
+          "' in ZooKeeper: " + zk->message(codes[i]));
+    }
+
+    Try<Option<Entry> > current = parse(results[i]);
+
+    if (current.isError()) {
+      return Error(current.error());
+    } else if (current.get().isNone()) {
+      return false;
+    }
+
+    if (UUID::fromBytes(current.get().get().uuid()) !=
+        UUID::fromBytes(entries[i].uuid())) {
+      return false;
+    }
+
+    // NOTE: Unlike 'doExpunge' we only remove the chunks of the
+    // current entry, any chunks left behind by failed attempts to set
+    // the entry make the batch fail (see below).
+    foreach (const string& chunk, chunks(current.get().get())) {
+      ops.push_back(Op(Op::REMOVE, chunk));
+    }
+
+    // We get atomicity by requiring 'stat.version'.
+    ops.push_back(Op(Op::REMOVE, paths[i], "", stats[i].version));
+  }
+
+  int code = multi(ops);
+
+  if (code == ZBADVERSION || code == ZNONODE) {
+    return false; // Lost a race with someone else.
+  } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+    CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+    return None(); // Try again later.
+  } else if (code != ZOK) {
+    return Error(
+        "Failed to remove entries in '" + znode +
+        "' in ZooKeeper: " + zk->message(code));
+  }
+
+  return true;
+}
+
+
+Result<bool> ZooKeeperStorageProcess::doCreatePath()
+{
+  CHECK(znode.size() == 0 || znode.at(znode.size() - 1) != '/');
+  size_t index = znode.find("/", 0);
+
+  while (index < string::npos) {
+    // Get out the prefix to create.
+    index = znode.find("/", index + 1);
+    string prefix = znode.substr(0, index);
+
+    // Create the znode (even if it already exists).
+    int code = zk->create(prefix, "", acl, 0, NULL);
+
+    if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+      CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+      return None(); // Try again later.
+    } else if (code != ZOK && code != ZNODEEXISTS) {
+      return Error(
+          "Failed to create '" + prefix +
+          "' in ZooKeeper: " + zk->message(code));
+    }
+  }
+
+  return true;
+}
+
+
+Try<Option<Entry> > ZooKeeperStorageProcess::parse(const string& data)
+{
+  if (data.empty()) {
+    return Option<Entry>::none();
+  }
+
+  google::protobuf::io::ArrayInputStream stream(data.data(), data.size());
+
+  Entry entry;
+
+  if (!entry.ParseFromZeroCopyStream(&stream)) {
+    return Error("Failed to deserialize Entry");
+  }
+
+  return Some(entry);
+}
+
+
+vector<string> ZooKeeperStorageProcess::chunks(const Entry& entry)
+{
+  // The chunks are named after the UUID of the entry so that the
+  // chunks of different versions of an entry do not collide.
+  const string prefix = znode + "/" + entry.name() + "/" +
+    UUID::fromBytes(entry.uuid()).toString() + "_";
+
+  vector<string> paths;
+  for (uint32_t i = 0; i < entry.chunks(); i++) {
+    paths.push_back(prefix + stringify(i));
+  }
+
+  return paths;
+}
+
+
+int ZooKeeperStorageProcess::multi(const vector<Op>& ops)
+{
+  CHECK(!ops.empty());
+
+  vector<zoo_op_t> zops(ops.size());
+  vector<zoo_op_result_t> results(ops.size());
+
+  for (size_t i = 0; i < ops.size(); i++) {
+    const Op& op = ops[i];
+
+    switch (op.type) {
+      case Op::CREATE:
+        zoo_create_op_init(
+            &zops[i],
+            op.path.c_str(),
+            op.data.data(),
+            op.data.size(),
+            &acl,
+            0,
+            NULL,
+            0);
+        break;
+      case Op::SET:
+        zoo_set_op_init(
+            &zops[i],
+            op.path.c_str(),
+            op.data.data(),
+            op.data.size(),
+            op.version,
+            NULL);
+        break;
+      case Op::REMOVE:
+        zoo_delete_op_init(&zops[i], op.path.c_str(), op.version);
+        break;
+    }
+  }
+
+  return zk->multi(zops.size(), zops.data(), results.data());
+}
+
+
 ZooKeeperStorage::ZooKeeperStorage(
     const string& servers,
     const Duration& timeout,
@@ -649,6 +1334,26 @@ Future<std::set<string> > ZooKeeperStorage::names()
   return dispatch(process, &ZooKeeperStorageProcess::names);
 }
 
+
+Future<vector<Option<Entry> > > ZooKeeperStorage::getBatch(
+    const vector<string>& names)
+{
+  return dispatch(process, &ZooKeeperStorageProcess::getBatch, names);
+}
+
+
+Future<bool> ZooKeeperStorage::setBatch(
+    const vector<pair<Entry, UUID> >& entries)
+{
+  return dispatch(process, &ZooKeeperStorageProcess::setBatch, entries);
+}
+
+
+Future<bool> ZooKeeperStorage::expungeBatch(const vector<Entry>& entries)
+{
+  return dispatch(process, &ZooKeeperStorageProcess::expungeBatch, entries);
+}
+
 } // namespace state {
 } // namespace internal {
 } // namespace mesos {
@@ -351,6 +351,42 @@ TEST_F(AuthorizationTest, PrincipalNotOfferedAnyRoleRestrictive)
   AWAIT_EXPECT_EQ(false, authorizer.get()->authorize(request3));
 }
 
+
+// This test verifies that the decisions cached by the authorizer are
+// not shared between actions, even for requests that are identical
+// on the wire, and that repeated requests get the same decision.
+TEST_F(AuthorizationTest, CachedDecisionsPerAction)
+{
+  ACLs acls;
+  acls.set_permissive(false);
+
+  // Principal "foo" can register with role "bar".
+  mesos::ACL::RegisterFramework* acl = acls.add_register_frameworks();
+  acl->mutable_principals()->add_values("foo");
+  acl->mutable_roles()->add_values("bar");
+
+  // Principal "foo" cannot shutdown the frameworks of principal "bar".
+  mesos::ACL::ShutdownFramework* acl2 = acls.add_shutdown_frameworks();
+  acl2->mutable_principals()->add_values("foo");
+  acl2->mutable_framework_principals()->set_type(mesos::ACL::Entity::NONE);
+
+  Try<Owned<LocalAuthorizer> > authorizer = LocalAuthorizer::create(acls);
+  ASSERT_SOME(authorizer);
+
+  mesos::ACL::RegisterFramework request;
+  request.mutable_principals()->add_values("foo");
+  request.mutable_roles()->add_values("bar");
+
+  mesos::ACL::ShutdownFramework request2;
+  request2.mutable_principals()->add_values("foo");
+  request2.mutable_framework_principals()->add_values("bar");
+
+  for (int i = 0; i < 2; i++) {
+    AWAIT_EXPECT_EQ(true, authorizer.get()->authorize(request));
+    AWAIT_EXPECT_EQ(false, authorizer.get()->authorize(request2));
+  }
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -28,6 +28,7 @@
 
 #include <mesos/master/allocator.hpp>
 
+#include <mesos/slave/qos_controller.hpp>
 #include <mesos/slave/resource_estimator.hpp>
 
 #include <process/clock.hpp>
@@ -173,7 +174,8 @@ public:
         const Option<slave::GarbageCollector*>& gc = None(),
         const Option<slave::StatusUpdateManager*>& statusUpdateManager = None(),
         const Option<mesos::slave::ResourceEstimator*>& resourceEstimator =
-          None());
+          None(),
+        const Option<mesos::slave::QoSController*>& qosController = None());
 
     // Stops and cleans up a slave at the specified PID. If 'shutdown'
     // is true than the slave is sent a shutdown message instead of
@@ -202,6 +204,7 @@ public:
       bool createdContainerizer; // Whether we own the containerizer.
 
       process::Owned<mesos::slave::ResourceEstimator> resourceEstimator;
+      process::Owned<mesos::slave::QoSController> qosController;
       process::Owned<slave::Fetcher> fetcher;
       process::Owned<slave::StatusUpdateManager> statusUpdateManager;
       process::Owned<slave::GarbageCollector> gc;
@@ -535,7 +538,8 @@ inline Try<process::PID<slave::Slave>> Cluster::Slaves::start(
     const Option<MasterDetector*>& detector,
     const Option<slave::GarbageCollector*>& gc,
     const Option<slave::StatusUpdateManager*>& statusUpdateManager,
-    const Option<mesos::slave::ResourceEstimator*>& resourceEstimator)
+    const Option<mesos::slave::ResourceEstimator*>& resourceEstimator,
+    const Option<mesos::slave::QoSController*>& qosController)
 {
   // TODO(benh): Create a work directory if using the default.
 
@@ -564,6 +568,14 @@ inline Try<process::PID<slave::Slave>> Cluster::Slaves::start(
     slave.resourceEstimator.reset(_resourceEstimator.get());
   }
 
+  if (qosController.isNone()) {
+    Try<mesos::slave::QoSController*> _qosController =
+      mesos::slave::QoSController::create(flags.qos_controller);
+
+    CHECK_SOME(_qosController);
+    slave.qosController.reset(_qosController.get());
+  }
+
   // Get a detector for the master(s) if one wasn't provided.
   if (detector.isNone()) {
     slave.detector = masters->detector();
@@ -571,7 +583,7 @@ inline Try<process::PID<slave::Slave>> Cluster::Slaves::start(
 
   // Create a garbage collector if one wasn't provided.
   if (gc.isNone()) {
-    slave.gc.reset(new slave::GarbageCollector());
+    slave.gc.reset(new slave::GarbageCollector(flags));
   }
 
   // Create a status update manager if one wasn't provided.
@@ -588,7 +600,8 @@ inline Try<process::PID<slave::Slave>> Cluster::Slaves::start(
       &cluster->files,
       gc.get(slave.gc.get()),
       statusUpdateManager.get(slave.statusUpdateManager.get()),
-      resourceEstimator.get(slave.resourceEstimator.get()));
+      resourceEstimator.get(slave.resourceEstimator.get()),
+      qosController.get(slave.qosController.get()));
 
   process::PID<slave::Slave> pid = process::spawn(slave.slave);
 
@@ -0,0 +1,94 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <string>
+
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+#include <stout/try.hpp>
+
+#include "common/recordio.hpp"
+
+using std::deque;
+using std::string;
+
+using namespace mesos::internal;
+
+TEST(RecordIOTest, Encode)
+{
+  EXPECT_EQ("5\nhello", recordio::encode("hello"));
+  EXPECT_EQ("0\n", recordio::encode(""));
+}
+
+
+TEST(RecordIOTest, Decode)
+{
+  recordio::Decoder decoder;
+
+  const string data =
+    recordio::encode("hello") +
+    recordio::encode("") +
+    recordio::encode("world!");
+
+  Try<deque<string>> records = decoder.decode(data);
+
+  ASSERT_SOME(records);
+  ASSERT_EQ(3u, records.get().size());
+  EXPECT_EQ("hello", records.get()[0]);
+  EXPECT_EQ("", records.get()[1]);
+  EXPECT_EQ("world!", records.get()[2]);
+}
+
+
+// Records may be split arbitrarily across the data that is passed to
+// the decoder (e.g., the chunks of an HTTP response).
+TEST(RecordIOTest, DecodePartial)
+{
+  recordio::Decoder decoder;
+
+  const string data =
+    recordio::encode("hello") +
+    recordio::encode("world!");
+
+  deque<string> records;
+
+  foreach (char c, data) {
+    Try<deque<string>> decode = decoder.decode(string(1, c));
+    ASSERT_SOME(decode);
+
+    records.insert(records.end(), decode.get().begin(), decode.get().end());
+  }
+
+  ASSERT_EQ(2u, records.size());
+  EXPECT_EQ("hello", records[0]);
+  EXPECT_EQ("world!", records[1]);
+}
+
+
+TEST(RecordIOTest, DecodeFailure)
+{
+  recordio::Decoder decoder;
+
+  EXPECT_ERROR(decoder.decode("NaN\nhello"));
+
+  // The decoder cannot be used after a failure.
+  EXPECT_ERROR(decoder.decode(recordio::encode("hello")));
+}
@@ -52,6 +52,12 @@ class ComposingContainerizerTest : public MesosTest {};
 class MockContainerizer : public slave::Containerizer
 {
 public:
+  MockContainerizer()
+  {
+    EXPECT_CALL(*this, supports(_, _))
+      .WillRepeatedly(Return(true));
+  }
+
   MOCK_METHOD1(
       recover,
       process::Future<Nothing>(
@@ -80,6 +86,10 @@ public:
           const process::PID<Slave>&,
           bool));
 
+  MOCK_METHOD2(
+      supports,
+      bool(const Option<TaskInfo>&, const ExecutorInfo&));
+
   MOCK_METHOD2(
       update,
       process::Future<Nothing>(
@@ -166,6 +176,67 @@ TEST_F(ComposingContainerizerTest, DestroyWhileLaunching)
   AWAIT_FAILED(launch);
 }
 
+
+// This test checks that the composing containerizer does not try
+// (and wait on) a containerizer that does not support the launch.
+TEST_F(ComposingContainerizerTest, SkipUnsupported)
+{
+  vector<Containerizer*> containerizers;
+
+  MockContainerizer* mockContainerizer = new MockContainerizer();
+  MockContainerizer* mockContainerizer2 = new MockContainerizer();
+
+  containerizers.push_back(mockContainerizer);
+  containerizers.push_back(mockContainerizer2);
+
+  ComposingContainerizer containerizer(containerizers);
+  ContainerID containerId;
+  containerId.set_value("container");
+  TaskInfo taskInfo;
+  ExecutorInfo executorInfo;
+  SlaveID slaveId;
+  PID<Slave> slavePid;
+
+  EXPECT_CALL(*mockContainerizer, supports(_, _))
+    .WillRepeatedly(Return(false));
+
+  EXPECT_CALL(*mockContainerizer, launch(_, _, _, _, _, _, _, _))
+    .Times(0);
+
+  EXPECT_CALL(*mockContainerizer2, launch(_, _, _, _, _, _, _, _))
+    .WillOnce(Return(true));
+
+  Future<bool> launch = containerizer.launch(
+      containerId,
+      taskInfo,
+      executorInfo,
+      "dir",
+      "user",
+      slaveId,
+      slavePid,
+      false);
+
+  AWAIT_EXPECT_EQ(true, launch);
+
+  // The launch is rejected up front if no containerizer supports it.
+  EXPECT_CALL(*mockContainerizer2, supports(_, _))
+    .WillRepeatedly(Return(false));
+
+  containerId.set_value("container2");
+
+  launch = containerizer.launch(
+      containerId,
+      taskInfo,
+      executorInfo,
+      "dir",
+      "user",
+      slaveId,
+      slavePid,
+      false);
+
+  AWAIT_EXPECT_EQ(false, launch);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -30,6 +30,8 @@
 #include <process/future.hpp>
 #include <process/owned.hpp>
 
+#include <stout/os.hpp>
+#include <stout/path.hpp>
 #include <stout/strings.hpp>
 
 #include "slave/flags.hpp"
@@ -324,6 +326,57 @@ TEST_F(MesosContainerizerExecuteTest, IoRedirection)
 }
 
 
+#ifdef __linux__
+// Tests that the executor is launched through the fork server, with
+// its std{err,out} redirected, and that the containerizer can still
+// reap it.
+TEST_F(MesosContainerizerExecuteTest, ForkServer)
+{
+  string directory = os::getcwd(); // We're inside a temporary sandbox.
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+  flags.launcher_fork_server = true;
+
+  Fetcher fetcher;
+
+  Try<MesosContainerizer*> containerizer =
+    MesosContainerizer::create(flags, false, &fetcher);
+  ASSERT_SOME(containerizer);
+
+  ContainerID containerId;
+  containerId.set_value("test_container");
+
+  string outMsg = "this is stdout";
+  string command = "echo '" + outMsg + "' && exit 3";
+
+  process::Future<bool> launch = containerizer.get()->launch(
+      containerId,
+      CREATE_EXECUTOR_INFO("executor", command),
+      directory,
+      None(),
+      SlaveID(),
+      process::PID<Slave>(),
+      false);
+
+  AWAIT_READY(launch);
+
+  process::Future<containerizer::Termination> wait =
+    containerizer.get()->wait(containerId);
+  AWAIT_READY(wait);
+
+  // The exit status is only known if the slave reaped the executor.
+  ASSERT_TRUE(wait.get().has_status());
+  EXPECT_TRUE(WIFEXITED(wait.get().status()));
+  EXPECT_EQ(3, WEXITSTATUS(wait.get().status()));
+
+  EXPECT_SOME_EQ(outMsg + "\n", os::read(path::join(directory, "stdout")));
+
+  delete containerizer.get();
+}
+#endif // __linux__
+
+
 class MesosContainerizerDestroyTest : public MesosTest {};
 
 
@@ -643,6 +696,103 @@ TEST_F(MesosContainerizerDestroyTest, LauncherDestroyFailure)
 }
 
 
+class MesosContainerizerLaunchTest : public MesosTest {};
+
+
+// This test verifies that the executor is fetched while the isolators
+// are preparing, and that the latencies of the launch stages are
+// exposed as metrics.
+TEST_F(MesosContainerizerLaunchTest, FetchWhilePreparing)
+{
+  slave::Flags flags = CreateSlaveFlags();
+  Try<Launcher*> launcher = PosixLauncher::create(flags);
+  ASSERT_SOME(launcher);
+  vector<Owned<Isolator>> isolators;
+
+  MockIsolatorProcess* isolatorProcess = new MockIsolatorProcess();
+
+  Owned<Isolator> isolator(
+      new Isolator(Owned<IsolatorProcess>((IsolatorProcess*)isolatorProcess)));
+
+  isolators.push_back(isolator);
+
+  Future<Nothing> prepare;
+  Promise<Option<CommandInfo>> promise;
+  // Simulate a long prepare from the isolator.
+  EXPECT_CALL(*isolatorProcess, prepare(_, _, _, _, _))
+    .WillOnce(DoAll(FutureSatisfy(&prepare),
+                    Return(promise.future())));
+
+  Fetcher fetcher;
+
+  MesosContainerizer containerizer(
+      flags,
+      true,
+      &fetcher,
+      Owned<Launcher>(launcher.get()),
+      isolators,
+      vector<string>(1, "test/mock"));
+
+  string file = path::join(os::getcwd(), "file");
+  ASSERT_SOME(os::write(file, "data"));
+
+  string directory = path::join(os::getcwd(), "sandbox");
+  ASSERT_SOME(os::mkdir(directory));
+
+  ExecutorInfo executorInfo = CREATE_EXECUTOR_INFO("executor", "sleep 1000");
+  executorInfo.mutable_command()->add_uris()->set_value("file://" + file);
+
+  ContainerID containerId;
+  containerId.set_value("test_container");
+
+  Future<bool> launch = containerizer.launch(
+      containerId,
+      executorInfo,
+      directory,
+      None(),
+      SlaveID(),
+      process::PID<Slave>(),
+      false);
+
+  AWAIT_READY(prepare);
+
+  // The executor should get fetched while the isolator is preparing.
+  Duration waited = Duration::zero();
+  while (!os::exists(path::join(directory, "file")) && waited < Seconds(15)) {
+    os::sleep(Milliseconds(10));
+    waited += Milliseconds(10);
+  }
+
+  ASSERT_TRUE(os::exists(path::join(directory, "file")));
+  EXPECT_TRUE(launch.isPending());
+
+  // Need to help the compiler to disambiguate between overloads.
+  Option<CommandInfo> option = None();
+  promise.set(option);
+
+  AWAIT_EXPECT_EQ(true, launch);
+
+  JSON::Object metrics = Metrics();
+
+  EXPECT_EQ(1u, metrics.values.count("containerizer/mesos/launch_ms"));
+  EXPECT_EQ(1u, metrics.values.count("containerizer/mesos/launch/fetch_ms"));
+  EXPECT_EQ(
+      1u,
+      metrics.values.count("containerizer/mesos/launch/prepare_ms"));
+
+  const string prefix = "containerizer/mesos/isolators/test/mock";
+
+  EXPECT_EQ(1u, metrics.values.count(prefix + "/prepare_ms"));
+  EXPECT_EQ(1u, metrics.values.count(prefix + "/isolate_ms"));
+
+  Future<containerizer::Termination> wait = containerizer.wait(containerId);
+
+  containerizer.destroy(containerId);
+
+  AWAIT_READY(wait);
+}
+
+
 class MesosContainerizerRecoverTest : public MesosTest {};
 
 
@@ -122,6 +122,170 @@ TYPED_TEST(CRAMMD5Authentication, success)
 }
 
 
+// With tickets enabled, re-authenticating with the same authenticator
+// should use the ticket handed out by the previous authentication
+// rather than going through the SASL exchange, while another
+// authenticator should refuse the ticket and fall back to the SASL
+// exchange. Tickets can only be enabled on the default authenticator.
+TYPED_TEST(CRAMMD5Authentication, ticket)
+{
+  // Launch a dummy process (somebody to send the AuthenticateMessage).
+  UPID pid = spawn(new ProcessBase(), true);
+
+  Credential credential1;
+  credential1.set_principal("benh");
+  credential1.set_secret("secret");
+
+  Credentials credentials;
+  Credential* credential2 = credentials.add_credentials();
+  credential2->set_principal(credential1.principal());
+  credential2->set_secret(credential1.secret());
+
+  Try<Authenticator*> authenticator = new CRAMMD5Authenticator(true);
+
+  EXPECT_SOME(authenticator.get()->initialize(credentials));
+
+  // First authentication, which hands out a ticket.
+  Future<Message> message =
+    FUTURE_MESSAGE(Eq(AuthenticateMessage().GetTypeName()), _, _);
+
+  Future<AuthenticationCompletedMessage> completed =
+    FUTURE_PROTOBUF(AuthenticationCompletedMessage(), _, _);
+
+  Try<Authenticatee*> authenticatee = TypeParam::TypeAuthenticatee::create();
+  CHECK_SOME(authenticatee);
+
+  Future<bool> client =
+    authenticatee.get()->authenticate(pid, UPID(), credential1);
+
+  AWAIT_READY(message);
+
+  Future<Option<string>> principal =
+    authenticator.get()->authenticate(message.get().from);
+
+  AWAIT_EQ(true, client);
+  AWAIT_EXPECT_EQ(Option<string>("benh"), principal);
+
+  AWAIT_READY(completed);
+  EXPECT_TRUE(completed.get().has_ticket());
+
+  delete authenticatee.get();
+
+  // Second authentication, with the ticket.
+  message = FUTURE_MESSAGE(Eq(AuthenticateMessage().GetTypeName()), _, _);
+
+  Future<AuthenticationStartMessage> start =
+    FUTURE_PROTOBUF(AuthenticationStartMessage(), _, _);
+
+  authenticatee = TypeParam::TypeAuthenticatee::create();
+  CHECK_SOME(authenticatee);
+
+  client = authenticatee.get()->authenticate(pid, UPID(), credential1);
+
+  AWAIT_READY(message);
+
+  principal = authenticator.get()->authenticate(message.get().from);
+
+  AWAIT_READY(start);
+  EXPECT_EQ("TICKET", start.get().mechanism());
+
+  AWAIT_EQ(true, client);
+  AWAIT_EXPECT_EQ(Option<string>("benh"), principal);
+
+  delete authenticatee.get();
+  delete authenticator.get();
+
+  // Third authentication, with another authenticator which does not
+  // know the ticket.
+  authenticator = new CRAMMD5Authenticator(true);
+
+  EXPECT_SOME(authenticator.get()->initialize(credentials));
+
+  message = FUTURE_MESSAGE(Eq(AuthenticateMessage().GetTypeName()), _, _);
+
+  Future<AuthenticationStepMessage> step =
+    FUTURE_PROTOBUF(AuthenticationStepMessage(), _, _);
+
+  authenticatee = TypeParam::TypeAuthenticatee::create();
+  CHECK_SOME(authenticatee);
+
+  client = authenticatee.get()->authenticate(pid, UPID(), credential1);
+
+  AWAIT_READY(message);
+
+  principal = authenticator.get()->authenticate(message.get().from);
+
+  AWAIT_READY(step);
+
+  AWAIT_EQ(true, client);
+  AWAIT_EXPECT_EQ(Option<string>("benh"), principal);
+
+  terminate(pid);
+
+  delete authenticator.get();
+  delete authenticatee.get();
+}
+
+// Tickets are disabled by default: no ticket gets handed out and a
+// re-authentication goes through the SASL exchange again.
+TYPED_TEST(CRAMMD5Authentication, TicketsDisabledByDefault)
+{
+  // Launch a dummy process (somebody to send the AuthenticateMessage).
+  UPID pid = spawn(new ProcessBase(), true);
+
+  Credential credential1;
+  credential1.set_principal("benh");
+  credential1.set_secret("secret");
+
+  Credentials credentials;
+  Credential* credential2 = credentials.add_credentials();
+  credential2->set_principal(credential1.principal());
+  credential2->set_secret(credential1.secret());
+
+  Try<Authenticator*> authenticator = TypeParam::TypeAuthenticator::create();
+  CHECK_SOME(authenticator);
+
+  EXPECT_SOME(authenticator.get()->initialize(credentials));
+
+  for (int i = 0; i < 2; i++) {
+    Future<Message> message =
+      FUTURE_MESSAGE(Eq(AuthenticateMessage().GetTypeName()), _, _);
+
+    Future<AuthenticationStepMessage> step =
+      FUTURE_PROTOBUF(AuthenticationStepMessage(), _, _);
+
+    Future<AuthenticationCompletedMessage> completed =
+      FUTURE_PROTOBUF(AuthenticationCompletedMessage(), _, _);
+
+    Try<Authenticatee*> authenticatee =
+      TypeParam::TypeAuthenticatee::create();
+    CHECK_SOME(authenticatee);
+
+    Future<bool> client =
+      authenticatee.get()->authenticate(pid, UPID(), credential1);
+
+    AWAIT_READY(message);
+
+    Future<Option<string>> principal =
+      authenticator.get()->authenticate(message.get().from);
+
+    AWAIT_READY(step);
+
+    AWAIT_EQ(true, client);
+    AWAIT_EXPECT_EQ(Option<string>("benh"), principal);
+
+    AWAIT_READY(completed);
+    EXPECT_FALSE(completed.get().has_ticket());
+
+    delete authenticatee.get();
+  }
+
+  terminate(pid);
+
+  delete authenticator.get();
+}
+
+
 // Bad password should return an authentication failure.
 TYPED_TEST(CRAMMD5Authentication, failed1)
 {
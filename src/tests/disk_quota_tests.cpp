@@ -143,6 +143,22 @@ TEST_F(DiskUsageCollectorTest, SymbolicLink)
 }
 
 
+// This test verifies that paths without an XFS project ID are still
+// checked with 'du' when project quotas are used.
+TEST_F(DiskUsageCollectorTest, ProjectQuotasWithoutProjectId)
+{
+  string file = path::join(os::getcwd(), "file");
+  ASSERT_SOME(os::write(file, string(Kilobytes(8).bytes(), 'x')));
+
+  DiskUsageCollector collector(Milliseconds(1), true);
+
+  Future<Bytes> usage = collector.usage(os::getcwd());
+  AWAIT_READY(usage);
+
+  EXPECT_GE(usage.get(), Kilobytes(8));
+}
+
+
 class DiskQuotaTest : public MesosTest {};
 
 
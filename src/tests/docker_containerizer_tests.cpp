@@ -2581,6 +2581,98 @@ TEST_F(DockerContainerizerTest, ROOT_DOCKER_DestroyWhilePulling)
 }
 
 
+// This test checks that concurrent launches of containers with the
+// same image share a single 'docker pull'.
+TEST_F(DockerContainerizerTest, ROOT_DOCKER_CoalescePulls)
+{
+  slave::Flags flags = CreateSlaveFlags();
+
+  MockDocker* mockDocker = new MockDocker(tests::flags.docker);
+  Shared<Docker> docker(mockDocker);
+
+  Fetcher fetcher;
+
+  // The docker containerizer will free the process, so we must
+  // allocate on the heap.
+  MockDockerContainerizerProcess* process =
+    new MockDockerContainerizerProcess(flags, &fetcher, docker);
+
+  DockerContainerizer dockerContainerizer(
+      (Owned<DockerContainerizerProcess>(process)));
+
+  Future<Nothing> pull1;
+  Future<Nothing> pull2;
+  EXPECT_CALL(*process, pull(_))
+    .WillOnce(DoAll(FutureSatisfy(&pull1),
+                    Invoke(process, &MockDockerContainerizerProcess::_pull)))
+    .WillOnce(DoAll(FutureSatisfy(&pull2),
+                    Invoke(process, &MockDockerContainerizerProcess::_pull)));
+
+  // Pause the 'docker pull' until both containers are pulling.
+  Promise<Docker::Image> promise;
+  EXPECT_CALL(*mockDocker, pull(_, "busybox", _))
+    .WillOnce(Return(promise.future()));
+
+  ContainerInfo containerInfo;
+  containerInfo.set_type(ContainerInfo::DOCKER);
+
+  ContainerInfo::DockerInfo dockerInfo;
+  dockerInfo.set_image("busybox");
+  containerInfo.mutable_docker()->CopyFrom(dockerInfo);
+
+  ExecutorInfo executorInfo;
+  executorInfo.mutable_executor_id()->set_value("executor");
+  executorInfo.mutable_command()->set_value("sleep 1000");
+  executorInfo.mutable_container()->CopyFrom(containerInfo);
+
+  SlaveID slaveId;
+  slaveId.set_value("slave");
+
+  ContainerID containerId1;
+  containerId1.set_value("container1");
+
+  ContainerID containerId2;
+  containerId2.set_value("container2");
+
+  // The test runs in a temporary directory.
+  const string directory1 = path::join(os::getcwd(), "container1");
+  ASSERT_SOME(os::mkdir(directory1));
+
+  const string directory2 = path::join(os::getcwd(), "container2");
+  ASSERT_SOME(os::mkdir(directory2));
+
+  Future<bool> launch1 = dockerContainerizer.launch(
+      containerId1,
+      executorInfo,
+      directory1,
+      None(),
+      slaveId,
+      PID<Slave>(),
+      false);
+
+  Future<bool> launch2 = dockerContainerizer.launch(
+      containerId2,
+      executorInfo,
+      directory2,
+      None(),
+      slaveId,
+      PID<Slave>(),
+      false);
+
+  AWAIT_READY(pull1);
+  AWAIT_READY(pull2);
+
+  // Both launches fail once the single 'docker pull' fails.
+  promise.fail("Failed to pull");
+
+  AWAIT_FAILED(launch1);
+  AWAIT_FAILED(launch2);
+
+  dockerContainerizer.destroy(containerId1);
+  dockerContainerizer.destroy(containerId2);
+}
+
+
 // This test checks that when a docker containerizer update failed
 // and the container failed before the executor started, the executor
 // is properly killed and cleaned up.
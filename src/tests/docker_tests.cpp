@@ -16,17 +16,28 @@
  * limitations under the License.
  */
 
+#include <string.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
 #include <gtest/gtest.h>
 
 #include <process/future.hpp>
 #include <process/gtest.hpp>
+#include <process/http.hpp>
 #include <process/owned.hpp>
 #include <process/subprocess.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/format.hpp>
 #include <stout/option.hpp>
+#include <stout/os.hpp>
 #include <stout/gtest.hpp>
+#include <stout/path.hpp>
+#include <stout/strings.hpp>
 
+#include "docker/client.hpp"
 #include "docker/docker.hpp"
 
 #include "mesos/resources.hpp"
@@ -317,6 +328,214 @@ TEST(DockerTest, ROOT_DOCKER_CancelPull)
   AWAIT_DISCARDED(future);
 }
 
+
+// Tests parsing the kinds of responses sent by the remote API.
+TEST(DockerClientTest, Parse)
+{
+  string data =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 2\r\n"
+    "\r\n"
+    "{}"
+    "HTTP/1.1 200 OK\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n"
+    "3\r\n[1,\r\n"
+    "2\r\n2]\r\n"
+    "0\r\n"
+    "\r\n"
+    "HTTP/1.1 204 No Content\r\n"
+    "\r\n"
+    "HTTP/1.1 404 Not Found\r\n"
+    "\r\n"
+    "no such id";
+
+  Result<http::Response> response = DockerClient::parse(&data, false);
+  ASSERT_SOME(response);
+  EXPECT_EQ("200 OK", response.get().status);
+  EXPECT_SOME_EQ("application/json",
+                 response.get().headers.get("Content-Type"));
+  EXPECT_EQ("{}", response.get().body);
+
+  response = DockerClient::parse(&data, false);
+  ASSERT_SOME(response);
+  EXPECT_EQ("200 OK", response.get().status);
+  EXPECT_EQ("[1,2]", response.get().body);
+
+  response = DockerClient::parse(&data, false);
+  ASSERT_SOME(response);
+  EXPECT_EQ("204 No Content", response.get().status);
+  EXPECT_EQ("", response.get().body);
+
+  // The body of the last response ends with the connection.
+  EXPECT_NONE(DockerClient::parse(&data, false));
+
+  response = DockerClient::parse(&data, true);
+  ASSERT_SOME(response);
+  EXPECT_EQ("404 Not Found", response.get().status);
+  EXPECT_EQ("no such id", response.get().body);
+  EXPECT_EQ("", data);
+
+  // Incomplete responses need more data, or are an error if the
+  // connection has been closed.
+  data = "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nshort";
+  EXPECT_NONE(DockerClient::parse(&data, false));
+  EXPECT_ERROR(DockerClient::parse(&data, true));
+
+  data = "garbage\r\n\r\n";
+  EXPECT_ERROR(DockerClient::parse(&data, false));
+}
+
+
+// Reads a request from 'fd' and responds with its request line.
+static void respond(int fd)
+{
+  string request;
+  char buffer[1024];
+  while (request.find("\r\n\r\n") == string::npos) {
+    ssize_t length = ::read(fd, buffer, sizeof(buffer));
+    ASSERT_LT(0, length);
+    request.append(buffer, length);
+  }
+
+  const string line = request.substr(0, request.find("\r\n"));
+  const string response =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Length: " + stringify(line.size()) + "\r\n"
+    "\r\n" + line;
+
+  ASSERT_EQ((ssize_t) response.size(),
+            ::write(fd, response.data(), response.size()));
+}
+
+
+// Tests that the client sends its requests over a single connection
+// and reconnects once the daemon closes it.
+TEST(DockerClientTest, KeepAlive)
+{
+  Try<string> directory = environment->mkdtemp();
+  ASSERT_SOME(directory);
+
+  const string socket = path::join(directory.get(), "docker.sock");
+
+  // Act as the docker daemon.
+  int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_NE(-1, server);
+
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, socket.c_str(), sizeof(address.sun_path) - 1);
+
+  ASSERT_EQ(0, ::bind(server, (struct sockaddr*) &address, sizeof(address)));
+  ASSERT_EQ(0, ::listen(server, 8));
+
+  DockerClient client(socket);
+
+  Future<http::Response> response = client.get("/containers/json");
+
+  int connection = ::accept(server, NULL, NULL);
+  ASSERT_NE(-1, connection);
+
+  respond(connection);
+
+  AWAIT_READY(response);
+  EXPECT_EQ("GET /containers/json HTTP/1.1", response.get().body);
+
+  response = client.del("/containers/foo?force=1");
+
+  // The request is sent over the same connection.
+  respond(connection);
+
+  AWAIT_READY(response);
+  EXPECT_EQ("DELETE /containers/foo?force=1 HTTP/1.1", response.get().body);
+
+  // Once the daemon closes the connection the client reconnects.
+  os::close(connection);
+
+  response = client.post("/containers/foo/stop?t=0");
+
+  connection = ::accept(server, NULL, NULL);
+  ASSERT_NE(-1, connection);
+
+  respond(connection);
+
+  AWAIT_READY(response);
+  EXPECT_EQ("POST /containers/foo/stop?t=0 HTTP/1.1", response.get().body);
+
+  os::close(connection);
+  os::close(server);
+}
+
+
+// Tests that those waiting for a container are notified once the
+// daemon reports an event for it, or once the events stream closes.
+TEST(DockerClientTest, Changed)
+{
+  Try<string> directory = environment->mkdtemp();
+  ASSERT_SOME(directory);
+
+  const string socket = path::join(directory.get(), "docker.sock");
+
+  // Act as the docker daemon.
+  int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_NE(-1, server);
+
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, socket.c_str(), sizeof(address.sun_path) - 1);
+
+  ASSERT_EQ(0, ::bind(server, (struct sockaddr*) &address, sizeof(address)));
+  ASSERT_EQ(0, ::listen(server, 8));
+
+  DockerClient client(socket);
+
+  Future<Nothing> foo = client.changed("foo");
+  Future<Nothing> bar = client.changed("bar");
+
+  int connection = ::accept(server, NULL, NULL);
+  ASSERT_NE(-1, connection);
+
+  string request;
+  char buffer[1024];
+  while (request.find("\r\n\r\n") == string::npos) {
+    ssize_t length = ::read(connection, buffer, sizeof(buffer));
+    ASSERT_LT(0, length);
+    request.append(buffer, length);
+  }
+
+  EXPECT_TRUE(strings::startsWith(request, "GET /events HTTP/1.1\r\n"));
+
+  // Send an event for 'foo' split across two chunks.
+  const string event =
+    "{\"status\":\"start\",\"id\":\"0123\","
+    "\"Actor\":{\"ID\":\"0123\",\"Attributes\":{\"name\":\"foo\"}}}\n";
+
+  const string response =
+    "HTTP/1.1 200 OK\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n" +
+    strings::format("%x", 10).get() + "\r\n" + event.substr(0, 10) +
+    "\r\n" +
+    strings::format("%x", event.size() - 10).get() + "\r\n" +
+    event.substr(10) + "\r\n";
+
+  ASSERT_EQ((ssize_t) response.size(),
+            ::write(connection, response.data(), response.size()));
+
+  AWAIT_READY(foo);
+  EXPECT_TRUE(bar.isPending());
+
+  // Once the events stream closes everyone else is notified.
+  os::close(connection);
+
+  AWAIT_READY(bar);
+
+  os::close(server);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -0,0 +1,231 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <mesos/mesos.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/gtest.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+
+#include "master/event_history.hpp"
+
+#include "tests/utils.hpp"
+
+using mesos::internal::master::EventHistory;
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+
+class EventHistoryTest : public TemporaryDirectoryTest
+{
+protected:
+  static EventHistory::Event createEvent(int64_t timestamp)
+  {
+    EventHistory::Event event;
+    event.type = EventHistory::LAUNCH;
+    event.timestamp = timestamp;
+    event.frameworkId = "framework-" + stringify(timestamp % 3);
+    event.slaveId = "slave-" + stringify(timestamp % 5);
+    event.id = "task-" + stringify(timestamp);
+    event.cpus = 0.5;
+    event.mem = 128;
+    return event;
+  }
+
+  // Returns all the events of the cursor.
+  static vector<EventHistory::Event> drain(
+      const shared_ptr<EventHistory::Cursor>& cursor)
+  {
+    vector<EventHistory::Event> events;
+
+    while (true) {
+      Try<Option<vector<EventHistory::Event>>> next = cursor->next();
+      CHECK_SOME(next);
+
+      if (next.get().isNone()) {
+        return events;
+      }
+
+      events.insert(events.end(), next.get().get().begin(),
+                    next.get().get().end());
+    }
+  }
+};
+
+
+TEST_F(EventHistoryTest, EncodeDecode)
+{
+  vector<EventHistory::Event> events;
+
+  EventHistory::Event offer;
+  offer.type = EventHistory::OFFER;
+  offer.timestamp = 1400000000000000;
+  offer.frameworkId = "framework";
+  offer.slaveId = "slave";
+  offer.id = "offer";
+  offer.cpus = 2.25;
+  offer.mem = 1024;
+  events.push_back(offer);
+
+  EventHistory::Event terminal;
+  terminal.type = EventHistory::TERMINAL;
+  terminal.timestamp = offer.timestamp + 5;
+  terminal.frameworkId = "framework";
+  terminal.slaveId = "other";
+  terminal.id = "task";
+  terminal.cpus = 0.001;
+  terminal.mem = 32;
+  terminal.state = TASK_FAILED;
+  events.push_back(terminal);
+
+  // Timestamps may go backwards, e.g., if the clock gets adjusted.
+  events.push_back(createEvent(offer.timestamp - 10));
+
+  Try<vector<EventHistory::Event>> decoded =
+    EventHistory::decode(EventHistory::encode(events));
+
+  ASSERT_SOME(decoded);
+  ASSERT_EQ(events.size(), decoded.get().size());
+
+  for (size_t i = 0; i < events.size(); i++) {
+    EXPECT_EQ(events[i].type, decoded.get()[i].type);
+    EXPECT_EQ(events[i].timestamp, decoded.get()[i].timestamp);
+    EXPECT_EQ(events[i].frameworkId, decoded.get()[i].frameworkId);
+    EXPECT_EQ(events[i].slaveId, decoded.get()[i].slaveId);
+    EXPECT_EQ(events[i].id, decoded.get()[i].id);
+    EXPECT_DOUBLE_EQ(events[i].cpus, decoded.get()[i].cpus);
+    EXPECT_DOUBLE_EQ(events[i].mem, decoded.get()[i].mem);
+    EXPECT_EQ(events[i].state, decoded.get()[i].state);
+  }
+
+  // A truncated block fails to decode.
+  const string data = EventHistory::encode(events);
+  EXPECT_ERROR(EventHistory::decode(data.substr(0, data.size() - 1)));
+}
+
+
+// This test verifies that both the events written to disk and the
+// buffered ones are returned in order, and only those in range.
+TEST_F(EventHistoryTest, Range)
+{
+  Try<shared_ptr<EventHistory>> history =
+    EventHistory::create("events", Megabytes(16));
+  ASSERT_SOME(history);
+
+  const int64_t count = EventHistory::EVENTS_PER_BLOCK * 2 + 10;
+
+  for (int64_t i = 0; i < count; i++) {
+    history.get()->append(createEvent(i));
+  }
+
+  EXPECT_TRUE(os::exists(path::join("events", "events.0")));
+
+  vector<EventHistory::Event> events =
+    drain(history.get()->events(0, count));
+
+  ASSERT_EQ(static_cast<size_t>(count), events.size());
+  for (int64_t i = 0; i < count; i++) {
+    EXPECT_EQ(i, events[i].timestamp);
+  }
+
+  events = drain(history.get()->events(100, count - 5));
+
+  ASSERT_EQ(static_cast<size_t>(count - 104), events.size());
+  EXPECT_EQ(100, events.front().timestamp);
+  EXPECT_EQ(count - 5, events.back().timestamp);
+
+  EXPECT_TRUE(drain(history.get()->events(count + 1, count + 10)).empty());
+}
+
+
+// This test verifies that the oldest files are removed once the
+// history exceeds its capacity, but not while a cursor uses them.
+TEST_F(EventHistoryTest, Retention)
+{
+  Try<shared_ptr<EventHistory>> history =
+    EventHistory::create("events", Kilobytes(64));
+  ASSERT_SOME(history);
+
+  // Keep a cursor over the first block around.
+  for (size_t i = 0; i < EventHistory::EVENTS_PER_BLOCK; i++) {
+    history.get()->append(createEvent(i));
+  }
+
+  shared_ptr<EventHistory::Cursor> cursor =
+    history.get()->events(0, EventHistory::EVENTS_PER_BLOCK);
+
+  for (size_t i = EventHistory::EVENTS_PER_BLOCK;
+       i < EventHistory::EVENTS_PER_BLOCK * 64;
+       i++) {
+    history.get()->append(createEvent(i));
+  }
+
+  // The first file is retired from the history.
+  EXPECT_TRUE(drain(
+      history.get()->events(0, EventHistory::EVENTS_PER_BLOCK - 1)).empty());
+
+  // But can still be read through the cursor.
+  EXPECT_TRUE(os::exists(path::join("events", "events.0")));
+  EXPECT_EQ(EventHistory::EVENTS_PER_BLOCK, drain(cursor).size());
+
+  cursor.reset();
+
+  EXPECT_FALSE(os::exists(path::join("events", "events.0")));
+
+  // The most recent events are retained.
+  EXPECT_EQ(
+      1u,
+      drain(history.get()->events(
+          EventHistory::EVENTS_PER_BLOCK * 64 - 1,
+          EventHistory::EVENTS_PER_BLOCK * 64 - 1)).size());
+}
+
+
+// This test verifies that the files left behind by a previous
+// history are removed when a history is created.
+TEST_F(EventHistoryTest, Create)
+{
+  ASSERT_SOME(os::mkdir("events"));
+  ASSERT_SOME(os::write(path::join("events", "events.0"), "stale"));
+  ASSERT_SOME(os::write(path::join("events", "other"), "other"));
+
+  Try<shared_ptr<EventHistory>> history =
+    EventHistory::create("events", Megabytes(1));
+  ASSERT_SOME(history);
+
+  EXPECT_FALSE(os::exists(path::join("events", "events.0")));
+  EXPECT_TRUE(os::exists(path::join("events", "other")));
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
@@ -18,6 +18,8 @@
 
 #include <unistd.h>
 
+#include <sys/stat.h>
+
 #include <gmock/gmock.h>
 
 #include <list>
@@ -588,6 +590,40 @@ TEST_F(FetcherCacheTest, LocalCached)
 }
 
 
+// Tests that only the first task, which downloads into the cache,
+// runs the mesos-fetcher program. The cache hits of the subsequent
+// tasks are retrieved by the fetcher process itself.
+TEST_F(FetcherCacheTest, LocalCachedWithoutSubprocess)
+{
+  startSlave();
+  driver->start();
+
+  EXPECT_CALL(*fetcherProcess, run(_, _, _, _, _))
+    .WillOnce(Invoke(fetcherProcess, &MockFetcherProcess::unmocked_run));
+
+  for (size_t i = 0; i < 3; i++) {
+    CommandInfo::URI uri;
+    uri.set_value(commandPath);
+    uri.set_executable(true);
+    uri.set_cache(true);
+
+    CommandInfo commandInfo;
+    commandInfo.set_value("./" + COMMAND_NAME + " " + taskName(i));
+    commandInfo.add_uris()->CopyFrom(uri);
+
+    const Task task = launchTask(commandInfo, i);
+
+    AWAIT_READY(awaitFinished(task));
+
+    const string path = path::join(task.runDirectory.value, COMMAND_NAME);
+    EXPECT_TRUE(isExecutable(path));
+    EXPECT_TRUE(os::exists(path + taskName(i)));
+
+    EXPECT_EQ(1u, fetcherProcess->cacheSize());
+  }
+}
+
+
 // Tests falling back on bypassing the cache when fetching the download
 // size of a URI that is supposed to be cached fails.
 TEST_F(FetcherCacheTest, CachedFallback)
@@ -18,6 +18,7 @@
 
 #include <unistd.h>
 
+#include <list>
 #include <map>
 #include <string>
 
@@ -27,6 +28,7 @@
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
 #include <process/http.hpp>
+#include <process/owned.hpp>
 #include <process/subprocess.hpp>
 
 #include <stout/gtest.hpp>
@@ -55,10 +57,12 @@ using namespace process;
 using mesos::fetcher::FetcherInfo;
 
 using mesos::internal::slave::Fetcher;
+using mesos::internal::slave::FetcherProcess;
 
 using process::Subprocess;
 using process::Future;
 
+using std::list;
 using std::map;
 using std::string;
 
@@ -173,6 +177,311 @@ TEST_F(FetcherTest, NonExistingFile)
 }
 
 
+// Negative test: the fetched file does not match the checksum given
+// in the URI. So we check for fetch failure and that no corrupt file
+// is left in the sandbox.
+TEST_F(FetcherTest, ChecksumMismatch)
+{
+  string fromDir = path::join(os::getcwd(), "from");
+  ASSERT_SOME(os::mkdir(fromDir));
+  string testFile = path::join(fromDir, "test");
+  EXPECT_SOME(os::write(testFile, "data"));
+
+  string localFile = path::join(os::getcwd(), "test");
+  EXPECT_FALSE(os::exists(localFile));
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value("file://" + testFile);
+  uri->set_checksum(string(64, '0'));
+
+  Fetcher fetcher;
+  SlaveID slaveId;
+
+  Future<Nothing> fetch = fetcher.fetch(
+      containerId, commandInfo, os::getcwd(), None(), slaveId, flags);
+  AWAIT_FAILED(fetch);
+
+  EXPECT_FALSE(os::exists(localFile));
+
+  // With the right checksum the same URI is fetched.
+  uri->set_checksum(
+      "3a6eb0790f39ac87c94f3856b2dd2c5d110e6811602261a9a923d3bb23adc8b7");
+
+  fetch = fetcher.fetch(
+      containerId, commandInfo, os::getcwd(), None(), slaveId, flags);
+  AWAIT_READY(fetch);
+
+  EXPECT_TRUE(os::exists(localFile));
+}
+
+
+// Tests that several URIs are all fetched when they are downloaded
+// concurrently.
+TEST_F(FetcherTest, ConcurrentDownloads)
+{
+  string fromDir = path::join(os::getcwd(), "from");
+  ASSERT_SOME(os::mkdir(fromDir));
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+  flags.fetcher_concurrent_downloads = 4;
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  CommandInfo commandInfo;
+
+  const int uris = 10;
+  for (int i = 0; i < uris; i++) {
+    string testFile = path::join(fromDir, "test" + stringify(i));
+    EXPECT_SOME(os::write(testFile, "data" + stringify(i)));
+
+    CommandInfo::URI* uri = commandInfo.add_uris();
+    uri->set_value("file://" + testFile);
+  }
+
+  Fetcher fetcher;
+  SlaveID slaveId;
+
+  Future<Nothing> fetch = fetcher.fetch(
+      containerId, commandInfo, os::getcwd(), None(), slaveId, flags);
+  AWAIT_READY(fetch);
+
+  for (int i = 0; i < uris; i++) {
+    string localFile = path::join(os::getcwd(), "test" + stringify(i));
+    EXPECT_SOME_EQ("data" + stringify(i), os::read(localFile));
+  }
+}
+
+
+// Tests that a fetcher downloads a URI with a checksum from the cache
+// of a peer which already holds the content, instead of its origin.
+TEST_F(FetcherTest, Peers)
+{
+  string fromDir = path::join(os::getcwd(), "from");
+  ASSERT_SOME(os::mkdir(fromDir));
+  string testFile = path::join(fromDir, "test");
+  EXPECT_SOME(os::write(testFile, "data"));
+
+  const string checksum =
+    "3a6eb0790f39ac87c94f3856b2dd2c5d110e6811602261a9a923d3bb23adc8b7";
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  // Fill the cache of the peer.
+  slave::Flags peerFlags;
+  peerFlags.launcher_dir = path::join(tests::flags.build_dir, "src");
+  peerFlags.fetcher_cache_dir = path::join(os::getcwd(), "cache");
+  peerFlags.fetcher_serve_peers = true;
+
+  Owned<FetcherProcess> peerProcess(new FetcherProcess(peerFlags));
+  Fetcher peer(peerProcess);
+
+  SlaveID peerId;
+  peerId.set_value("peer");
+
+  string peerSandbox = path::join(os::getcwd(), "peer");
+  ASSERT_SOME(os::mkdir(peerSandbox));
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value("file://" + testFile);
+  uri->set_checksum(checksum);
+  uri->set_cache(true);
+
+  Future<Nothing> fetch = peer.fetch(
+      containerId, commandInfo, peerSandbox, None(), peerId, peerFlags);
+  AWAIT_READY(fetch);
+
+  // Let the origin of the URI disappear, then fetch the same content
+  // from a URI on another slave which has the first one as its peer.
+  ASSERT_SOME(os::rm(testFile));
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+  flags.fetcher_cache_dir = path::join(os::getcwd(), "cache");
+  flags.fetcher_peers = "http://" + stringify(peerProcess->self().address) +
+    "/" + peerProcess->self().id + "/cache";
+
+  Fetcher fetcher;
+
+  SlaveID slaveId;
+  slaveId.set_value("slave");
+
+  fetch = fetcher.fetch(
+      containerId, commandInfo, os::getcwd(), None(), slaveId, flags);
+  AWAIT_READY(fetch);
+
+  EXPECT_SOME_EQ("data", os::read(path::join(os::getcwd(), "test")));
+}
+
+
+// Tests that a fetcher serves its cache to peers as soon as it has
+// been created, i.e., before it has fetched anything itself.
+TEST_F(FetcherTest, ServePeersBeforeFetch)
+{
+  slave::Flags flags;
+  flags.fetcher_serve_peers = true;
+
+  Owned<FetcherProcess> fetcherProcess(new FetcherProcess(flags));
+  Fetcher fetcher(fetcherProcess);
+
+  // A request without a checksum is only rejected as malformed (rather
+  // than not found) if the fetcher serves peers.
+  Future<http::Response> response = http::get(fetcherProcess->self(), "cache");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::BadRequest().status, response);
+
+  response = http::get(fetcherProcess->self(), "cache", "checksum=unknown");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::NotFound().status, response);
+}
+
+
+// Tests that cache files are reused after a restart of the slave,
+// i.e., after recovering a new fetcher from the index of the cache.
+TEST_F(FetcherTest, RecoverCache)
+{
+  string fromDir = path::join(os::getcwd(), "from");
+  ASSERT_SOME(os::mkdir(fromDir));
+  string testFile = path::join(fromDir, "test");
+  EXPECT_SOME(os::write(testFile, "data"));
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+  flags.fetcher_cache_dir = path::join(os::getcwd(), "cache");
+
+  SlaveID slaveId;
+  slaveId.set_value("slave");
+
+  string sandbox = path::join(os::getcwd(), "sandbox");
+  ASSERT_SOME(os::mkdir(sandbox));
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value("file://" + testFile);
+  uri->set_cache(true);
+
+  {
+    Fetcher fetcher;
+
+    Future<Nothing> fetch = fetcher.fetch(
+        containerId, commandInfo, sandbox, None(), slaveId, flags);
+    AWAIT_READY(fetch);
+  }
+
+  // Let the origin of the URI disappear, then fetch it again after
+  // "restarting" the slave.
+  ASSERT_SOME(os::rm(testFile));
+
+  ASSERT_SOME(Fetcher::recover(slaveId, flags));
+
+  Owned<FetcherProcess> fetcherProcess(new FetcherProcess());
+  Fetcher fetcher(fetcherProcess);
+
+  Future<Nothing> fetch = fetcher.fetch(
+      containerId, commandInfo, os::getcwd(), None(), slaveId, flags);
+  AWAIT_READY(fetch);
+
+  EXPECT_SOME_EQ("data", os::read(path::join(os::getcwd(), "test")));
+  EXPECT_EQ(1u, fetcherProcess->cacheSize());
+}
+
+
+// Tests that the user who owns a sandbox cannot modify a cache file
+// through its link in the sandbox, which would poison the content
+// that is served to other tasks and peers under the same checksum.
+TEST_F(FetcherTest, ROOT_CachedLinks)
+{
+  // The user must be able to reach the sandbox.
+  ASSERT_SOME(os::chmod(
+      os::getcwd(), S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH));
+
+  string fromDir = path::join(os::getcwd(), "from");
+  ASSERT_SOME(os::mkdir(fromDir));
+  string testFile = path::join(fromDir, "test");
+  EXPECT_SOME(os::write(testFile, "data"));
+
+  const string user = "nobody";
+
+  Result<uid_t> uid = os::getuid(user);
+  ASSERT_SOME(uid);
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+  flags.fetcher_cache_dir = path::join(os::getcwd(), "cache");
+  flags.fetcher_cache_links = true;
+
+  SlaveID slaveId;
+  slaveId.set_value("slave");
+
+  string sandbox = path::join(os::getcwd(), "sandbox");
+  ASSERT_SOME(os::mkdir(sandbox));
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value("file://" + testFile);
+  uri->set_cache(true);
+
+  Owned<FetcherProcess> fetcherProcess(new FetcherProcess());
+  Fetcher fetcher(fetcherProcess);
+
+  Future<Nothing> fetch = fetcher.fetch(
+      containerId, commandInfo, sandbox, user, slaveId, flags);
+  AWAIT_READY(fetch);
+
+  const string path = path::join(sandbox, "test");
+
+  Try<list<Path>> cacheFiles = fetcherProcess->cacheFiles(slaveId, flags);
+  ASSERT_SOME(cacheFiles);
+  ASSERT_EQ(1u, cacheFiles.get().size());
+
+  const string cacheFile = cacheFiles.get().front().value;
+
+  struct stat s;
+  ASSERT_EQ(0, ::stat(path.c_str(), &s));
+
+  struct stat c;
+  ASSERT_EQ(0, ::stat(cacheFile.c_str(), &c));
+
+  // The resource is still linked, but not owned by the user.
+  EXPECT_EQ(c.st_ino, s.st_ino);
+  EXPECT_NE(uid.get(), s.st_uid);
+
+  // The sandbox itself does belong to the user.
+  ASSERT_EQ(0, ::stat(sandbox.c_str(), &s));
+  EXPECT_EQ(uid.get(), s.st_uid);
+
+  // Now try to modify the resource as the user.
+  Try<Subprocess> modify = subprocess(
+      "chmod u+w '" + path + "' && echo poisoned >> '" + path + "'",
+      Subprocess::FD(STDIN_FILENO),
+      Subprocess::FD(STDOUT_FILENO),
+      Subprocess::FD(STDERR_FILENO),
+      None(),
+      [=]() { return os::su(user).isSome() ? 0 : 1; });
+
+  ASSERT_SOME(modify);
+  AWAIT_READY(modify.get().status());
+  ASSERT_SOME(modify.get().status().get());
+  EXPECT_NE(0, modify.get().status().get().get());
+
+  EXPECT_SOME_EQ("data", os::read(cacheFile));
+}
+
+
 // Negative test: malformed URI, missing path.
 TEST_F(FetcherTest, MalformedURI)
 {
@@ -486,6 +795,209 @@ TEST_F(FetcherTest, ExtractNotExecutable)
 }
 
 
+// The paths of URIs may contain anything, hence copying and
+// extracting must not pass them through a shell.
+TEST_F(FetcherTest, CopyAndExtractQuotedPath)
+{
+  ASSERT_SOME(os::write("file", "hello world"));
+  ASSERT_SOME(os::tar("file", "file.tar.gz"));
+  ASSERT_SOME(os::rm("file"));
+
+  const string directory = path::join(os::getcwd(), "it's $(touch injected)");
+  ASSERT_SOME(os::mkdir(directory));
+
+  const string archive = path::join(directory, "file.tar.gz");
+  EXPECT_SOME_EQ(archive, Fetcher::copy("file.tar.gz", archive));
+
+  EXPECT_SOME_TRUE(Fetcher::extract(archive, directory));
+  EXPECT_SOME_EQ("hello world", os::read(path::join(directory, "file")));
+
+  EXPECT_FALSE(os::exists("injected"));
+  EXPECT_FALSE(os::exists(path::join(directory, "injected")));
+}
+
+
+// Serves the given archive, after responding with an error to the
+// first 'failures' requests.
+class ArchiveProcess : public Process<ArchiveProcess>
+{
+public:
+  explicit ArchiveProcess(const string& _archive, int _failures = 0)
+    : archive(_archive),
+      failures(_failures)
+  {
+    route("/archive.tar.gz", None(), &ArchiveProcess::serve);
+  }
+
+  Future<http::Response> serve(const http::Request& request)
+  {
+    if (failures > 0) {
+      failures--;
+      return http::ServiceUnavailable();
+    }
+
+    Try<string> read = os::read(archive);
+    if (read.isError()) {
+      return http::InternalServerError(read.error());
+    }
+
+    return http::OK(read.get());
+  }
+
+private:
+  const string archive;
+  int failures;
+};
+
+
+// Tests that a tar archive fetched over HTTP is extracted while it is
+// being downloaded, i.e., without writing the archive to the sandbox.
+TEST_F(FetcherTest, ExtractWhileDownloading)
+{
+  Try<string> path = os::mktemp();
+
+  ASSERT_SOME(path);
+
+  ASSERT_SOME(os::write(path.get(), "hello world"));
+
+  ASSERT_SOME(os::tar(path.get(), path.get() + ".tar.gz"));
+
+  ArchiveProcess process(path.get() + ".tar.gz");
+
+  spawn(process);
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value("http://" + stringify(process.self().address) + "/" +
+                 process.self().id + "/archive.tar.gz");
+  uri->set_executable(false);
+  uri->set_extract(true);
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+
+  Fetcher fetcher;
+  SlaveID slaveId;
+
+  Future<Nothing> fetch = fetcher.fetch(
+      containerId, commandInfo, os::getcwd(), None(), slaveId, flags);
+
+  AWAIT_READY(fetch);
+
+  ASSERT_SOME_EQ("hello world", os::read(path::join(".", path.get())));
+
+  EXPECT_FALSE(os::exists(path::join(os::getcwd(), "archive.tar.gz")));
+
+  terminate(process);
+  wait(process);
+
+  ASSERT_SOME(os::rm(path.get()));
+  ASSERT_SOME(os::rm(path.get() + ".tar.gz"));
+}
+
+
+// Tests that an error response is not streamed into 'tar' and that
+// the archive is then downloaded into the sandbox and extracted.
+TEST_F(FetcherTest, ExtractWhileDownloadingFallback)
+{
+  Try<string> path = os::mktemp();
+
+  ASSERT_SOME(path);
+
+  ASSERT_SOME(os::write(path.get(), "hello world"));
+
+  ASSERT_SOME(os::tar(path.get(), path.get() + ".tar.gz"));
+
+  // Fail the streaming download only.
+  ArchiveProcess process(path.get() + ".tar.gz", 1);
+
+  spawn(process);
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value("http://" + stringify(process.self().address) + "/" +
+                 process.self().id + "/archive.tar.gz");
+  uri->set_executable(false);
+  uri->set_extract(true);
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+
+  Fetcher fetcher;
+  SlaveID slaveId;
+
+  Future<Nothing> fetch = fetcher.fetch(
+      containerId, commandInfo, os::getcwd(), None(), slaveId, flags);
+
+  AWAIT_READY(fetch);
+
+  ASSERT_SOME_EQ("hello world", os::read(path::join(".", path.get())));
+
+  EXPECT_TRUE(os::exists(path::join(os::getcwd(), "archive.tar.gz")));
+
+  terminate(process);
+  wait(process);
+
+  ASSERT_SOME(os::rm(path.get()));
+  ASSERT_SOME(os::rm(path.get() + ".tar.gz"));
+}
+
+
+// Tests that the fetcher survives 'tar' exiting while the download is
+// still being written to it (which would raise SIGPIPE), and falls
+// back to downloading the archive into the sandbox.
+TEST_F(FetcherTest, ExtractWhileDownloadingCorruptArchive)
+{
+  Try<string> path = os::mktemp();
+
+  ASSERT_SOME(path);
+
+  // Larger than a pipe buffer, so that 'tar' exits before all of the
+  // content has been written to it.
+  ASSERT_SOME(os::write(path.get(), string(4 * 1024 * 1024, 'x')));
+
+  ArchiveProcess process(path.get());
+
+  spawn(process);
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value("http://" + stringify(process.self().address) + "/" +
+                 process.self().id + "/archive.tar.gz");
+  uri->set_executable(false);
+  uri->set_extract(true);
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+
+  Fetcher fetcher;
+  SlaveID slaveId;
+
+  Future<Nothing> fetch = fetcher.fetch(
+      containerId, commandInfo, os::getcwd(), None(), slaveId, flags);
+
+  // Extracting the downloaded archive fails too, but the fetcher
+  // must not have been killed before getting there.
+  AWAIT_FAILED(fetch);
+
+  EXPECT_TRUE(os::exists(path::join(os::getcwd(), "archive.tar.gz")));
+
+  terminate(process);
+  wait(process);
+
+  ASSERT_SOME(os::rm(path.get()));
+}
+
+
 // Tests fetching via the local HDFS client. Since we cannot rely on
 // Hadoop being installed, we use our own mock version that works on
 // the local file system only, but this lets us exercise the exact
@@ -27,6 +27,7 @@
 #include <process/process.hpp>
 
 #include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/json.hpp>
 #include <stout/os.hpp>
 #include <stout/stringify.hpp>
@@ -40,6 +41,7 @@ using process::Future;
 using process::http::BadRequest;
 using process::http::NotFound;
 using process::http::OK;
+using process::http::Pipe;
 using process::http::Response;
 
 using std::string;
@@ -136,6 +138,157 @@ TEST_F(FilesTest, ReadTest)
 }
 
 
+TEST_F(FilesTest, ReadRawTest)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  ASSERT_SOME(os::write("file", "0123456789"));
+  AWAIT_EXPECT_READY(files.attach("file", "myname"));
+
+  Future<Response> response =
+    process::http::get(upid, "read.json", "path=myname&raw=true");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("0123456789", response);
+
+  // Request a byte range of the file.
+  hashmap<string, string> headers;
+  headers["Range"] = "bytes=4-7";
+
+  response =
+    process::http::get(upid, "read.json", "path=myname&raw=true", headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::statuses[206], response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("4567", response);
+
+  // Offsets are expected in the 'Range' header for raw reads.
+  response =
+    process::http::get(upid, "read.json", "path=myname&raw=true&offset=4");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(BadRequest().status, response);
+}
+
+
+TEST_F(FilesTest, ReadFollowTest)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  ASSERT_SOME(os::write("file", "body"));
+  AWAIT_EXPECT_READY(files.attach("file", "myname"));
+
+  Future<Response> response = process::http::streaming::get(
+      upid,
+      "read.json",
+      "path=myname&follow=true&offset=0");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_EQ(Response::PIPE, response.get().type);
+  ASSERT_SOME(response.get().reader);
+
+  Pipe::Reader reader = response.get().reader.get();
+
+  AWAIT_EXPECT_EQ("body", reader.read());
+
+  // Data appended to the file is streamed to the client.
+  Future<string> read = reader.read();
+
+  Try<int> fd = os::open("file", O_WRONLY | O_APPEND | O_CLOEXEC);
+  ASSERT_SOME(fd);
+  ASSERT_SOME(os::write(fd.get(), " and more"));
+  ASSERT_SOME(os::close(fd.get()));
+
+  AWAIT_EXPECT_EQ(" and more", read);
+
+  EXPECT_TRUE(reader.close());
+}
+
+
+// Reads the whole body of a streaming response.
+static Future<string> readAll(Pipe::Reader reader, const string& body = "")
+{
+  return reader.read()
+    .then([=](const string& data) -> Future<string> {
+      if (data.empty()) {
+        return body;
+      }
+      return readAll(reader, body + data);
+    });
+}
+
+
+TEST_F(FilesTest, SearchTest)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  // Write multiple megabytes of lines, so that the line index gets
+  // checkpoints in the middle of the file.
+  string data;
+  for (int i = 1; i <= 50000; i++) {
+    data += string(64, '.') + "\n";
+    data += "line " + stringify(i) + (i % 10000 == 0 ? " error" : "") + "\n";
+  }
+  data += "unterminated error";
+
+  ASSERT_SOME(os::write("file", data));
+  AWAIT_EXPECT_READY(files.attach("file", "myname"));
+
+  Future<Response> response =
+    process::http::streaming::get(upid, "search.json", "path=myname");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(BadRequest().status, response);
+
+  // Returns the expected search result for the given line.
+  auto result = [&data](size_t line) {
+    string prefix = "line " + stringify(line) + " ";
+
+    JSON::Object object;
+    object.values["offset"] = data.find(prefix);
+    object.values["line"] = line * 2;
+    object.values["data"] = prefix + "error";
+    return stringify(object) + "\n";
+  };
+
+  JSON::Object last;
+  last.values["offset"] = data.rfind("unterminated");
+  last.values["line"] = 100001;
+  last.values["data"] = "unterminated error";
+
+  // Search twice from the middle of the file: once scanning the file
+  // from the start and once using the line index.
+  for (int i = 0; i < 2; i++) {
+    response = process::http::streaming::get(
+        upid,
+        "search.json",
+        "path=myname&pattern=error&offset=" +
+        stringify(data.find("line 25000\n")));
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+    ASSERT_SOME(response.get().reader);
+
+    AWAIT_EXPECT_EQ(
+        result(30000) + result(40000) + result(50000) +
+        stringify(last) + "\n",
+        readAll(response.get().reader.get()));
+  }
+
+  // The number of results can be limited.
+  response = process::http::streaming::get(
+      upid,
+      "search.json",
+      "path=myname&pattern=error&limit=2");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_SOME(response.get().reader);
+
+  AWAIT_EXPECT_EQ(
+      result(10000) + result(20000),
+      readAll(response.get().reader.get()));
+}
+
+
 TEST_F(FilesTest, ResolveTest)
 {
   Files files;
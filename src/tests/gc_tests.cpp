@@ -246,6 +246,92 @@ TEST_F(GarbageCollectorTest, Prune)
 }
 
 
+// This test verifies that the garbage collector throttles deletion
+// to the configured number of inodes per second.
+TEST_F(GarbageCollectorTest, RateLimit)
+{
+  slave::Flags flags;
+  flags.gc_inodes_per_sec = 10; // I.e., a single inode per 100ms.
+
+  GarbageCollector gc(flags);
+
+  const string& directory = "directory";
+
+  ASSERT_SOME(os::mkdir(directory));
+  for (int i = 0; i < 4; i++) {
+    ASSERT_SOME(os::touch(path::join(directory, "file" + stringify(i))));
+  }
+
+  Clock::pause();
+
+  Future<Nothing> schedule = gc.schedule(Seconds(0), directory);
+
+  Clock::settle();
+
+  // Only the first file has been deleted so far.
+  ASSERT_TRUE(schedule.isPending());
+  EXPECT_TRUE(os::exists(directory));
+
+  // Delete the remaining files and the directory itself.
+  for (int i = 0; i < 5; i++) {
+    Clock::advance(Milliseconds(100));
+    Clock::settle();
+  }
+
+  AWAIT_READY(schedule);
+
+  EXPECT_FALSE(os::exists(directory));
+
+  Clock::resume();
+}
+
+
+// This test verifies that pruning deletes the paths that reclaim the
+// most space first.
+TEST_F(GarbageCollectorTest, PruneBiggestFirst)
+{
+  slave::Flags flags;
+  flags.gc_inodes_per_sec = 10; // I.e., a single inode per 100ms.
+
+  GarbageCollector gc(flags);
+
+  const string& small = "small";
+  const string& big = "big";
+
+  ASSERT_SOME(os::touch(small));
+  ASSERT_SOME(os::mkdir(big));
+  ASSERT_SOME(os::write(
+      path::join(big, "file"),
+      string(Kilobytes(64).bytes(), 'x')));
+
+  Clock::pause();
+
+  Future<Nothing> schedule1 = gc.schedule(Seconds(10), small);
+  Future<Nothing> schedule2 = gc.schedule(Seconds(10), big);
+
+  gc.prune(Seconds(10));
+
+  Clock::settle();
+
+  // The big directory is being deleted before the small file.
+  EXPECT_FALSE(os::exists(path::join(big, "file")));
+  EXPECT_TRUE(os::exists(small));
+
+  for (int i = 0; i < 5; i++) {
+    Clock::advance(Milliseconds(100));
+    Clock::settle();
+  }
+
+  AWAIT_READY(schedule1);
+  AWAIT_READY(schedule2);
+
+  EXPECT_FALSE(os::exists(small));
+  EXPECT_FALSE(os::exists(big));
+
+  Clock::resume();
+}
+
+
 class GarbageCollectorIntegrationTest : public MesosTest {};
 
 
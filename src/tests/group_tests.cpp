@@ -106,13 +106,16 @@ TEST_F(GroupTest, GroupJoinWithDisconnect)
 
 TEST_F(GroupTest, GroupDataWithDisconnect)
 {
-  Group group(server->connectString(), NO_TIMEOUT, "/test/");
+  Group group1(server->connectString(), NO_TIMEOUT, "/test/");
+  Group group2(server->connectString(), NO_TIMEOUT, "/test/");
 
-  Future<Group::Membership> membership = group.join("hello world");
+  Future<Group::Membership> membership = group1.join("hello world");
 
   AWAIT_READY(membership);
 
-  Future<std::set<Group::Membership> > memberships = group.watch();
+  // We read the data through a group that does not own the
+  // membership because the data of owned memberships is cached.
+  Future<std::set<Group::Membership> > memberships = group2.watch();
 
   AWAIT_READY(memberships);
   EXPECT_EQ(1u, memberships.get().size());
@@ -120,7 +123,7 @@ TEST_F(GroupTest, GroupDataWithDisconnect)
 
   server->shutdownNetwork();
 
-  Future<Option<string> > data = group.data(membership.get());
+  Future<Option<string> > data = group2.data(membership.get());
 
   EXPECT_TRUE(data.isPending());
 
@@ -131,6 +134,52 @@ TEST_F(GroupTest, GroupDataWithDisconnect)
 }
 
 
+// Tests that the data of a membership is only read from ZooKeeper
+// once and is forgotten once the membership is gone.
+TEST_F(GroupTest, GroupDataCached)
+{
+  Group group1(server->connectString(), NO_TIMEOUT, "/test/");
+  Group group2(server->connectString(), NO_TIMEOUT, "/test/");
+
+  Future<Group::Membership> membership = group1.join("hello world");
+
+  AWAIT_READY(membership);
+
+  Future<std::set<Group::Membership> > memberships = group2.watch();
+
+  AWAIT_READY(memberships);
+  EXPECT_EQ(1u, memberships.get().size());
+
+  Future<Option<string> > data = group2.data(membership.get());
+
+  AWAIT_READY(data);
+  EXPECT_SOME_EQ("hello world", data.get());
+
+  // The cached data is returned even though ZooKeeper can not be
+  // reached.
+  server->shutdownNetwork();
+
+  data = group2.data(membership.get());
+
+  AWAIT_READY(data);
+  EXPECT_SOME_EQ("hello world", data.get());
+
+  server->startNetwork();
+
+  AWAIT_EXPECT_EQ(true, group1.cancel(membership.get()));
+
+  memberships = group2.watch(memberships.get());
+
+  AWAIT_READY(memberships);
+  EXPECT_EQ(0u, memberships.get().size());
+
+  data = group2.data(membership.get());
+
+  AWAIT_READY(data);
+  EXPECT_NONE(data.get());
+}
+
+
 TEST_F(GroupTest, GroupDataWithRemovedMembership)
 {
   Group group(server->connectString(), NO_TIMEOUT, "/test/");
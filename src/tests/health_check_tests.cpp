@@ -22,6 +22,7 @@
 #include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/pid.hpp>
+#include <process/socket.hpp>
 
 #include "slave/slave.hpp"
 
@@ -44,6 +45,9 @@ using process::Clock;
 using process::Future;
 using process::PID;
 
+using process::network::Address;
+using process::network::Socket;
+
 using testing::_;
 using testing::AtMost;
 using testing::Eq;
@@ -304,6 +308,80 @@ TEST_F(HealthCheckTest, HealthyTaskNonShell)
 }
 
 
+// Same as above, but use a TCP health check which the command
+// executor performs in-process.
+TEST_F(HealthCheckTest, HealthyTaskTCP)
+{
+  // Something for the health check to connect to.
+  Try<Socket> server = Socket::create();
+  ASSERT_SOME(server);
+
+  Try<Address> address = server.get().bind();
+  ASSERT_SOME(address);
+  ASSERT_SOME(server.get().listen(1));
+
+  Try<PID<Master> > master = StartMaster();
+  ASSERT_SOME(master);
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.isolation = "posix/cpu,posix/mem";
+
+  Fetcher fetcher;
+
+  Try<MesosContainerizer*> containerizer =
+    MesosContainerizer::create(flags, false, &fetcher);
+  CHECK_SOME(containerizer);
+
+  Try<PID<Slave> > slave = StartSlave(containerizer.get());
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+    &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  vector<TaskInfo> tasks =
+    populateTasks("sleep 120", "exit 0", offers.get()[0]);
+
+  HealthCheck* healthCheck = tasks[0].mutable_health_check();
+  healthCheck->clear_command();
+  healthCheck->mutable_tcp()->set_port(address.get().port);
+
+  Future<TaskStatus> statusRunning;
+  Future<TaskStatus> statusHealth;
+
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&statusRunning))
+    .WillOnce(FutureArg<1>(&statusHealth));
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(statusRunning);
+  EXPECT_EQ(TASK_RUNNING, statusRunning.get().state());
+
+  AWAIT_READY(statusHealth);
+  EXPECT_EQ(TASK_RUNNING, statusHealth.get().state());
+  EXPECT_TRUE(statusHealth.get().healthy());
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 // Testing health status change reporting to scheduler.
 TEST_F(HealthCheckTest, HealthStatusChange)
 {
@@ -16,10 +16,15 @@
  * limitations under the License.
  */
 
+#include <unistd.h>
+
 #include <gmock/gmock.h>
 
+#include <algorithm>
+#include <mutex>
 #include <string>
 #include <queue>
+#include <utility>
 #include <vector>
 
 #include <mesos/master/allocator.hpp>
@@ -33,8 +38,12 @@
 #include <stout/gtest.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/utils.hpp>
 
+#include "common/attributes.hpp"
+
 #include "master/constants.hpp"
 #include "master/flags.hpp"
 
@@ -53,10 +62,13 @@ using process::Clock;
 using process::Future;
 using process::Shared;
 
+using std::pair;
 using std::queue;
 using std::string;
 using std::vector;
 
+using testing::WithParamInterface;
+
 namespace mesos {
 namespace internal {
 namespace tests {
@@ -450,6 +462,62 @@ TEST_F(HierarchicalAllocatorTest, CoarseGrained)
 }
 
 
+// Checks that a framework with constraints is only allocated the
+// resources of the slaves whose attributes satisfy them.
+TEST_F(HierarchicalAllocatorTest, Constraints)
+{
+  // Pausing the clock ensures that the batch allocation does not
+  // influence this test.
+  Clock::pause();
+
+  initialize(vector<string>{"role1"});
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  SlaveInfo slave1 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  *(slave1.mutable_attributes()) = Attributes::parse("rack:a;gpu:1");
+  allocator->addSlave(slave1.id(), slave1, slave1.resources(), EMPTY);
+
+  SlaveInfo slave2 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  *(slave2.mutable_attributes()) = Attributes::parse("rack:c;gpu:1");
+  allocator->addSlave(slave2.id(), slave2, slave2.resources(), EMPTY);
+
+  // The framework wants slaves with a GPU on rack 'a' or 'b'.
+  FrameworkInfo framework = createFrameworkInfo("role1");
+
+  FrameworkInfo::Constraint* constraint = framework.add_constraints();
+  constraint->set_attribute("rack");
+  constraint->add_values("a");
+  constraint->add_values("b");
+
+  framework.add_constraints()->set_attribute("gpu");
+
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  Future<Allocation> allocation = queue.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  ASSERT_EQ(1u, allocation.get().resources.size());
+  EXPECT_TRUE(allocation.get().resources.contains(slave1.id()));
+
+  // A slave without a GPU is not allocated to the framework.
+  SlaveInfo slave3 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  *(slave3.mutable_attributes()) = Attributes::parse("rack:b");
+  allocator->addSlave(slave3.id(), slave3, slave3.resources(), EMPTY);
+
+  SlaveInfo slave4 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  *(slave4.mutable_attributes()) = Attributes::parse("rack:b;gpu:1");
+  allocator->addSlave(slave4.id(), slave4, slave4.resources(), EMPTY);
+
+  allocation = queue.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  ASSERT_EQ(1u, allocation.get().resources.size());
+  EXPECT_TRUE(allocation.get().resources.contains(slave4.id()));
+}
+
+
 // This test ensures that frameworks that have the same share get an
 // equal number of allocations over time (rather than the same
 // framework getting all the allocations because it's name is
@@ -617,6 +685,108 @@ TEST_F(HierarchicalAllocatorTest, RecoverResources)
 }
 
 
+// Checks that resources that were filtered by a framework get
+// offered again by a batch allocation once the filter expires, even
+// if nothing else changed on the slave.
+TEST_F(HierarchicalAllocatorTest, FilterExpiration)
+{
+  Clock::pause();
+
+  initialize(vector<string>{"role1"});
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  SlaveInfo slave = createSlaveInfo("cpus:1;mem:512;disk:0");
+  allocator->addSlave(slave.id(), slave, slave.resources(), EMPTY);
+
+  FrameworkInfo framework = createFrameworkInfo("role1");
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  Future<Allocation> allocation = queue.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(slave.resources(), Resources::sum(allocation.get().resources));
+
+  // Decline the resources for longer than a batch allocation.
+  Filters filters;
+  filters.set_refuse_seconds(
+      (flags.allocation_interval * 3).secs());
+
+  allocator->recoverResources(
+      framework.id(),
+      slave.id(),
+      slave.resources(),
+      filters);
+
+  allocation = queue.get();
+
+  // The resources are filtered during the next batch allocation.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  ASSERT_TRUE(allocation.isPending());
+
+  // Once the filter expires the resources are offered again in the
+  // next batch allocation.
+  Clock::advance(flags.allocation_interval * 3);
+  Clock::settle();
+
+  Clock::advance(flags.allocation_interval);
+
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(slave.resources(), Resources::sum(allocation.get().resources));
+}
+
+
+// This test ensures that a framework that suppressed offers is not
+// allocated any resources until it revives offers.
+TEST_F(HierarchicalAllocatorTest, SuppressOffers)
+{
+  Clock::pause();
+
+  initialize(vector<string>{"role1"});
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  SlaveInfo slave = createSlaveInfo("cpus:1;mem:512;disk:0");
+  allocator->addSlave(slave.id(), slave, slave.resources(), EMPTY);
+
+  FrameworkInfo framework = createFrameworkInfo("role1");
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  Future<Allocation> allocation = queue.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(slave.resources(), Resources::sum(allocation.get().resources));
+
+  allocator->suppressOffers(framework.id());
+
+  // Decline the resources without a filter.
+  allocator->recoverResources(
+      framework.id(),
+      slave.id(),
+      slave.resources(),
+      None());
+
+  allocation = queue.get();
+
+  // The resources are not offered to the suppressed framework.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  ASSERT_TRUE(allocation.isPending());
+
+  allocator->reviveOffers(framework.id());
+
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(slave.resources(), Resources::sum(allocation.get().resources));
+}
+
+
 TEST_F(HierarchicalAllocatorTest, Allocatable)
 {
   // Pausing the clock is not necessary, but ensures that the test
@@ -948,6 +1118,391 @@ TEST_F(HierarchicalAllocatorTest, Whitelist)
   EXPECT_EQ(slave.resources(), Resources::sum(allocation.get().resources));
 }
 
+
+// This test verifies that a framework with a task shape is only
+// offered whole multiples of its shape, leaving the rest of the
+// slave to the other frameworks.
+TEST_F(HierarchicalAllocatorTest, TaskShapes)
+{
+  Clock::pause();
+
+  initialize(vector<string>{"role1"});
+
+  FrameworkInfo framework1 = createFrameworkInfo("role1");
+  FrameworkInfo::TaskShape* shape = framework1.add_task_shapes();
+  shape->mutable_resources()->CopyFrom(
+      Resources::parse("cpus:1;mem:512").get());
+
+  allocator->addFramework(
+      framework1.id(), framework1, hashmap<SlaveID, Resources>());
+
+  FrameworkInfo framework2 = createFrameworkInfo("role1");
+  allocator->addFramework(
+      framework2.id(), framework2, hashmap<SlaveID, Resources>());
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  SlaveInfo slave = createSlaveInfo("cpus:3;mem:1024;disk:0");
+  allocator->addSlave(slave.id(), slave, slave.resources(), EMPTY);
+
+  // Two tasks of the shape fit in the memory of the slave.
+  Future<Allocation> allocation = queue.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework1.id(), allocation.get().frameworkId);
+  EXPECT_EQ(Resources::parse("cpus:2;mem:1024;disk:0").get(),
+            Resources::sum(allocation.get().resources));
+
+  allocation = queue.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework2.id(), allocation.get().frameworkId);
+  EXPECT_EQ(Resources::parse("cpus:1").get(),
+            Resources::sum(allocation.get().resources));
+}
+
+// Checks that allocations triggered while the allocator is busy are
+// coalesced into a single allocation of all the slaves added in the
+// meantime, rather than one allocation per slave.
+TEST_F(HierarchicalAllocatorTest, CoalescedAllocation)
+{
+  Clock::pause();
+
+  roles["*"].set_name("*");
+
+  // The test holds this lock to keep the allocator process blocked
+  // in the offer callback while it adds more slaves.
+  std::mutex mutex;
+
+  allocator->initialize(
+      flags.allocation_interval,
+      [this, &mutex](
+          const FrameworkID& frameworkId,
+          const hashmap<SlaveID, Resources>& resources) {
+        Allocation allocation;
+        allocation.frameworkId = frameworkId;
+        allocation.resources = resources;
+        queue.put(allocation);
+
+        std::lock_guard<std::mutex> lock(mutex);
+      },
+      roles);
+
+  FrameworkInfo framework = createFrameworkInfo("*");
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  mutex.lock();
+
+  SlaveInfo slave1 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(slave1.id(), slave1, slave1.resources(), EMPTY);
+
+  Future<Allocation> allocation = queue.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(1u, allocation.get().resources.size());
+
+  // These slaves are all added while the allocation of 'slave1' is
+  // still in progress.
+  SlaveInfo slave2 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(slave2.id(), slave2, slave2.resources(), EMPTY);
+
+  SlaveInfo slave3 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(slave3.id(), slave3, slave3.resources(), EMPTY);
+
+  SlaveInfo slave4 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(slave4.id(), slave4, slave4.resources(), EMPTY);
+
+  mutex.unlock();
+
+  // The three slaves are offered in a single allocation, without
+  // waiting for the batch allocation.
+  allocation = queue.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(3u, allocation.get().resources.size());
+  EXPECT_TRUE(allocation.get().resources.contains(slave2.id()));
+  EXPECT_TRUE(allocation.get().resources.contains(slave3.id()));
+  EXPECT_TRUE(allocation.get().resources.contains(slave4.id()));
+
+  Clock::settle();
+
+  EXPECT_TRUE(queue.get().isPending());
+}
+
+
+// Checks that once an allocation takes longer than the allocation
+// interval, events no longer trigger allocations and slaves are only
+// offered by the batch allocation, until allocations are fast again.
+TEST_F(HierarchicalAllocatorTest, AllocationBackOff)
+{
+  Clock::pause();
+
+  flags.allocation_interval = Milliseconds(10);
+
+  roles["*"].set_name("*");
+
+  // The test holds this lock to make the allocation of the first
+  // slave take longer than the allocation interval.
+  std::mutex mutex;
+
+  allocator->initialize(
+      flags.allocation_interval,
+      [this, &mutex](
+          const FrameworkID& frameworkId,
+          const hashmap<SlaveID, Resources>& resources) {
+        Allocation allocation;
+        allocation.frameworkId = frameworkId;
+        allocation.resources = resources;
+        queue.put(allocation);
+
+        std::lock_guard<std::mutex> lock(mutex);
+      },
+      roles);
+
+  FrameworkInfo framework = createFrameworkInfo("*");
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  mutex.lock();
+
+  SlaveInfo slave1 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(slave1.id(), slave1, slave1.resources(), EMPTY);
+
+  Future<Allocation> allocation = queue.get();
+  AWAIT_READY(allocation);
+
+  // NOTE: The allocator measures the duration of an allocation in
+  // real time, so the paused clock does not affect it.
+  os::sleep(Milliseconds(50));
+
+  mutex.unlock();
+
+  Clock::settle();
+
+  SlaveInfo slave2 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(slave2.id(), slave2, slave2.resources(), EMPTY);
+
+  SlaveInfo slave3 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(slave3.id(), slave3, slave3.resources(), EMPTY);
+
+  // The allocator is backing off, so adding slaves does not trigger
+  // an allocation.
+  Clock::settle();
+
+  allocation = queue.get();
+  EXPECT_TRUE(allocation.isPending());
+
+  // The batch allocation offers both slaves at once.
+  Clock::advance(flags.allocation_interval);
+
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(2u, allocation.get().resources.size());
+  EXPECT_TRUE(allocation.get().resources.contains(slave2.id()));
+  EXPECT_TRUE(allocation.get().resources.contains(slave3.id()));
+
+  // The batch allocation was fast, so a new slave triggers an
+  // allocation again.
+  SlaveInfo slave4 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(slave4.id(), slave4, slave4.resources(), EMPTY);
+
+  allocation = queue.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(1u, allocation.get().resources.size());
+  EXPECT_TRUE(allocation.get().resources.contains(slave4.id()));
+}
+
+
+class HierarchicalAllocator_BENCHMARK_Test
+  : public HierarchicalAllocatorTest,
+    public WithParamInterface<pair<size_t, size_t>>
+{
+public:
+  // Records the allocations of the allocator. This is called by the
+  // allocator process while the test only looks at the allocations
+  // once the clock is settled.
+  void allocated(
+      const FrameworkID& frameworkId,
+      const hashmap<SlaveID, Resources>& resources)
+  {
+    Allocation allocation;
+    allocation.frameworkId = frameworkId;
+    allocation.resources = resources;
+
+    allocations.push_back(allocation);
+  }
+
+protected:
+  vector<Allocation> allocations;
+};
+
+
+// The allocator benchmark tests are parameterized by the number of
+// slaves and the number of frameworks.
+INSTANTIATE_TEST_CASE_P(
+    SlaveAndFrameworkCount,
+    HierarchicalAllocator_BENCHMARK_Test,
+    ::testing::Values(
+        std::make_pair(1000U, 10U),
+        std::make_pair(5000U, 100U),
+        std::make_pair(10000U, 1000U),
+        std::make_pair(20000U, 1000U),
+        std::make_pair(50000U, 5000U)));
+
+
+// This benchmark simulates a cluster with weighted roles, some
+// reserved resources and frameworks that decline all their offers,
+// half of them with a filter, and measures the batch allocations.
+TEST_P(HierarchicalAllocator_BENCHMARK_Test, DeclineOffers)
+{
+  const size_t slaveCount = GetParam().first;
+  const size_t frameworkCount = GetParam().second;
+  const size_t roleCount = 10;
+
+  // Allocations are only made when the test advances the clock.
+  Clock::pause();
+
+  hashmap<string, RoleInfo> roles;
+
+  // NOTE: The master always adds this default role.
+  RoleInfo info;
+  info.set_name("*");
+  roles["*"] = info;
+
+  for (size_t i = 0; i < roleCount; i++) {
+    info.set_name("role" + stringify(i));
+    info.set_weight(i + 1);
+    roles[info.name()] = info;
+  }
+
+  allocator->initialize(
+      flags.allocation_interval,
+      lambda::bind(
+          &HierarchicalAllocator_BENCHMARK_Test::allocated,
+          this,
+          lambda::_1,
+          lambda::_2),
+      roles);
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < frameworkCount; i++) {
+    FrameworkInfo framework;
+    framework.set_user("user");
+    framework.set_name("framework" + stringify(i));
+    framework.mutable_id()->set_value(framework.name());
+    framework.set_role("role" + stringify(i % roleCount));
+
+    allocator->addFramework(
+        framework.id(), framework, hashmap<SlaveID, Resources>());
+  }
+
+  Clock::settle();
+
+  LOG(INFO) << "Added " << frameworkCount << " frameworks in "
+            << watch.elapsed();
+
+  const Resources unreserved =
+    Resources::parse("cpus:24;mem:4096;disk:4096").get();
+
+  watch.start();
+
+  for (size_t i = 0; i < slaveCount; i++) {
+    SlaveInfo slave;
+    slave.mutable_id()->set_value("slave" + stringify(i));
+    slave.set_hostname(slave.id().value());
+
+    Resources resources = unreserved;
+
+    // Every tenth slave has some of its resources reserved.
+    if (i % 10 == 0) {
+      resources += Resources::parse(
+          "cpus:8;mem:1024", "role" + stringify(i / 10 % roleCount)).get();
+    }
+
+    slave.mutable_resources()->CopyFrom(resources);
+
+    allocator->addSlave(
+        slave.id(), slave, slave.resources(), hashmap<FrameworkID, Resources>());
+  }
+
+  Clock::settle();
+
+  LOG(INFO) << "Added " << slaveCount << " slaves in " << watch.elapsed();
+
+  // Filters outlive a few batch allocations, so that both filtering
+  // and expiring filters are part of the allocations.
+  Filters filters;
+  filters.set_refuse_seconds((flags.allocation_interval * 5).secs());
+
+  const size_t allocationCount = 50;
+
+  vector<Duration> durations;
+  size_t offerCount = 0;
+
+  for (size_t i = 0; i < allocationCount; i++) {
+    size_t declined = 0;
+    foreach (const Allocation& allocation, allocations) {
+      foreachpair (const SlaveID& slaveId,
+                   const Resources& resources,
+                   allocation.resources) {
+        allocator->recoverResources(
+            allocation.frameworkId,
+            slaveId,
+            resources,
+            (declined++ % 2 == 0) ? Option<Filters>(filters) : None());
+      }
+    }
+
+    allocations.clear();
+
+    Clock::settle();
+
+    watch.start();
+
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+
+    durations.push_back(watch.elapsed());
+
+    foreach (const Allocation& allocation, allocations) {
+      offerCount += allocation.resources.size();
+    }
+  }
+
+  std::sort(durations.begin(), durations.end());
+
+  Duration total = Duration::zero();
+  foreach (const Duration& duration, durations) {
+    total += duration;
+  }
+
+  LOG(INFO) << "Made " << allocationCount << " batch allocations for "
+            << slaveCount << " slaves and " << frameworkCount
+            << " frameworks in " << total << " (p50 "
+            << durations[allocationCount * 50 / 100] << ", p90 "
+            << durations[allocationCount * 90 / 100] << ", p99 "
+            << durations[allocationCount * 99 / 100] << ", max "
+            << durations.back() << ") for " << offerCount << " offers ("
+            << offerCount / total.secs() << " offers/sec)";
+
+  RecordProperty(
+      "allocation_p50_ms",
+      stringify(durations[allocationCount * 50 / 100].ms()));
+  RecordProperty(
+      "allocation_p99_ms",
+      stringify(durations[allocationCount * 99 / 100].ms()));
+  RecordProperty("offers_per_sec", stringify(offerCount / total.secs()));
+
+  Result<os::Process> process = os::process(::getpid());
+  if (process.isSome() && process.get().rss.isSome()) {
+    LOG(INFO) << "Resident memory: " << process.get().rss.get();
+  }
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
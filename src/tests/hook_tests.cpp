@@ -22,6 +22,8 @@
 #include <process/gmock.hpp>
 #include <process/pid.hpp>
 
+#include <stout/duration.hpp>
+#include <stout/json.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/try.hpp>
@@ -45,6 +47,7 @@
 #include "tests/containerizer.hpp"
 #include "tests/flags.hpp"
 #include "tests/mesos.hpp"
+#include "tests/utils.hpp"
 
 using std::string;
 
@@ -80,6 +83,7 @@ const char* testLabelValue = "ApacheMesos";
 const char* testRemoveLabelKey = "MESOS_Test_Remove_Label";
 const char* testRemoveLabelValue = "FooBar";
 const char* testEnvironmentVariableName = "MESOS_TEST_ENVIRONMENT_VARIABLE";
+const char* testSleepEnvironmentVariableName = "MESOS_TEST_HOOK_SLEEP";
 
 class HookTest : public MesosTest
 {
@@ -252,6 +256,53 @@ TEST_F(HookTest, VerifySlaveExecutorEnvironmentDecorator)
 }
 
 
+// Test that the result of a slow hook is abandoned after a bounded
+// amount of time, that invocations queued behind it are abandoned
+// too, and that the module is invoked again once the hook returns.
+TEST_F(HookTest, SlowHookAbandoned)
+{
+  const string abandoned =
+    "hooks/" + string(HOOK_MODULE_NAME) + "/abandoned";
+
+  ExecutorInfo slow = CREATE_EXECUTOR_INFO("executor", "exit 0");
+  Environment::Variable* variable =
+    slow.mutable_command()->mutable_environment()->add_variables();
+  variable->set_name(testSleepEnvironmentVariableName);
+  variable->set_value("3secs");
+
+  // The slow hook does not get to add "FOO" to the environment.
+  Environment environment =
+    HookManager::slaveExecutorEnvironmentDecorator(slow);
+
+  ASSERT_EQ(1, environment.variables_size());
+  EXPECT_EQ(testSleepEnvironmentVariableName,
+            environment.variables(0).name());
+
+  // The worker of the module is still busy with the slow hook, so
+  // this invocation is abandoned as well.
+  ExecutorInfo fast = CREATE_EXECUTOR_INFO("executor", "exit 0");
+
+  environment = HookManager::slaveExecutorEnvironmentDecorator(fast);
+  EXPECT_EQ(0, environment.variables_size());
+
+  JSON::Object metrics = Metrics();
+  ASSERT_EQ(1u, metrics.values.count(abandoned));
+  EXPECT_EQ(2u, metrics.values[abandoned]);
+
+  // Once the slow hook returns, the module is invoked again.
+  os::sleep(Seconds(2));
+
+  environment = HookManager::slaveExecutorEnvironmentDecorator(fast);
+
+  ASSERT_EQ(1, environment.variables_size());
+  EXPECT_EQ("FOO", environment.variables(0).name());
+  EXPECT_EQ("bar", environment.variables(0).value());
+
+  metrics = Metrics();
+  EXPECT_EQ(2u, metrics.values[abandoned]);
+}
+
+
 // Test executor environment decorator hook and remove executor hook
 // for slave. We expect the environment-decorator hook to create a
 // temporary file and the remove-executor hook to delete that file.
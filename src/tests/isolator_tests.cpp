@@ -30,6 +30,7 @@
 
 #include <mesos/slave/isolator.hpp>
 
+#include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/owned.hpp>
 #include <process/reap.hpp>
@@ -38,8 +39,10 @@
 #include <stout/gtest.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
+#include <stout/strings.hpp>
 
 #ifdef __linux__
+#include "linux/cgroups.hpp"
 #include "linux/ns.hpp"
 #include "linux/sched.hpp"
 #endif // __linux__
@@ -51,6 +54,7 @@
 #include "slave/slave.hpp"
 
 #ifdef __linux__
+#include "slave/containerizer/isolators/cgroups/blkio.hpp"
 #include "slave/containerizer/isolators/cgroups/cpushare.hpp"
 #include "slave/containerizer/isolators/cgroups/mem.hpp"
 #include "slave/containerizer/isolators/cgroups/perf_event.hpp"
@@ -77,6 +81,7 @@ using namespace process;
 
 using mesos::internal::master::Master;
 #ifdef __linux__
+using mesos::internal::slave::CgroupsBlkioIsolatorProcess;
 using mesos::internal::slave::CgroupsCpushareIsolatorProcess;
 using mesos::internal::slave::CgroupsMemIsolatorProcess;
 using mesos::internal::slave::CgroupsPerfEventIsolatorProcess;
@@ -819,6 +824,209 @@ TYPED_TEST(MemIsolatorTest, MemUsage)
 
 
 #ifdef __linux__
+class UsageIntervalIsolatorTest : public MesosTest {};
+
+
+// Tests that with --cgroups_usage_interval the statistics of a
+// container are read at most once per interval, and carry the time of
+// the read as their timestamp.
+TEST_F(UsageIntervalIsolatorTest, ROOT_CGROUPS_MemUsage)
+{
+  slave::Flags flags;
+  flags.cgroups_usage_interval = Seconds(10);
+
+  Try<Isolator*> isolator = CgroupsMemIsolatorProcess::create(flags);
+  CHECK_SOME(isolator);
+
+  ExecutorInfo executorInfo;
+  executorInfo.mutable_resources()->CopyFrom(
+      Resources::parse("mem:1024").get());
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  // Use a relative temporary directory so it gets cleaned up
+  // automatically with the test.
+  Try<string> dir = os::mkdtemp(path::join(os::getcwd(), "XXXXXX"));
+  ASSERT_SOME(dir);
+
+  AWAIT_READY(isolator.get()->prepare(
+      containerId,
+      executorInfo,
+      dir.get(),
+      None(),
+      None()));
+
+  MemoryTestHelper helper;
+  ASSERT_SOME(helper.spawn());
+  ASSERT_SOME(helper.pid());
+
+  // Set up the reaper to wait on the subprocess.
+  Future<Option<int>> status = process::reap(helper.pid().get());
+
+  // Isolate the subprocess.
+  AWAIT_READY(isolator.get()->isolate(containerId, helper.pid().get()));
+
+  Clock::pause();
+
+  Future<ResourceStatistics> usage1 = isolator.get()->usage(containerId);
+  AWAIT_READY(usage1);
+
+  const Bytes allocation = Megabytes(128);
+  EXPECT_SOME(helper.increaseRSS(allocation));
+
+  // Within the interval the same statistics are returned.
+  Future<ResourceStatistics> usage2 = isolator.get()->usage(containerId);
+  AWAIT_READY(usage2);
+
+  EXPECT_EQ(usage1.get().timestamp(), usage2.get().timestamp());
+  EXPECT_EQ(usage1.get().mem_rss_bytes(), usage2.get().mem_rss_bytes());
+
+  // After the interval the statistics are read again.
+  Clock::advance(flags.cgroups_usage_interval);
+
+  Future<ResourceStatistics> usage3 = isolator.get()->usage(containerId);
+  AWAIT_READY(usage3);
+
+  Clock::resume();
+
+  EXPECT_DOUBLE_EQ(
+      usage1.get().timestamp() + flags.cgroups_usage_interval.secs(),
+      usage3.get().timestamp());
+
+  EXPECT_GE(usage3.get().mem_rss_bytes(),
+            usage1.get().mem_rss_bytes() + allocation.bytes());
+
+  // Ensure the process is killed.
+  helper.cleanup();
+
+  // Make sure the subprocess was reaped.
+  AWAIT_READY(status);
+
+  // Let the isolator clean up.
+  AWAIT_READY(isolator.get()->cleanup(containerId));
+
+  delete isolator.get();
+}
+
+
+class MemPressureIsolatorTest : public MesosTest {};
+
+
+// Tests that the memory isolator counts the memory pressure events of
+// a container and, with --cgroups_memory_pressure_reaction, lowers
+// the soft limit of the container to its anonymous memory upon medium
+// pressure (until the next update).
+TEST_F(MemPressureIsolatorTest, ROOT_CGROUPS_PressureReaction)
+{
+  slave::Flags flags;
+  flags.cgroups_memory_pressure_reaction = true;
+
+  Try<Isolator*> isolator = CgroupsMemIsolatorProcess::create(flags);
+  CHECK_SOME(isolator);
+
+  const Resources resources = Resources::parse("mem:64").get();
+
+  ExecutorInfo executorInfo;
+  executorInfo.mutable_resources()->CopyFrom(resources);
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  // Use a relative temporary directory so it gets cleaned up
+  // automatically with the test.
+  Try<string> dir = os::mkdtemp(path::join(os::getcwd(), "XXXXXX"));
+  ASSERT_SOME(dir);
+
+  AWAIT_READY(isolator.get()->prepare(
+      containerId,
+      executorInfo,
+      dir.get(),
+      None(),
+      None()));
+
+  MemoryTestHelper helper;
+  ASSERT_SOME(helper.spawn());
+  ASSERT_SOME(helper.pid());
+
+  // Set up the reaper to wait on the subprocess.
+  Future<Option<int>> status = process::reap(helper.pid().get());
+
+  // Isolate the subprocess.
+  AWAIT_READY(isolator.get()->isolate(containerId, helper.pid().get()));
+
+  Result<string> hierarchy = cgroups::hierarchy("memory");
+  ASSERT_SOME(hierarchy);
+
+  const string cgroup = path::join(flags.cgroups_root, containerId.value());
+
+  EXPECT_SOME_EQ(
+      Megabytes(64),
+      cgroups::memory::soft_limit_in_bytes(hierarchy.get(), cgroup));
+
+  // Lock most of the memory of the container (which can't be
+  // reclaimed), then add page cache until the kernel has a hard time
+  // reclaiming memory from the container.
+  ASSERT_SOME(helper.increaseRSS(Megabytes(48)));
+
+  Option<ResourceStatistics> statistics;
+  for (int i = 0; i < 256 && statistics.isNone(); i++) {
+    ASSERT_SOME(helper.increasePageCache(Megabytes(1)));
+
+    Future<ResourceStatistics> usage = isolator.get()->usage(containerId);
+    AWAIT_READY(usage);
+
+    if (usage.get().mem_medium_pressure_counter() > 0) {
+      statistics = usage.get();
+    }
+  }
+
+  ASSERT_SOME(statistics);
+
+  EXPECT_GE(statistics.get().mem_low_pressure_counter(),
+            statistics.get().mem_medium_pressure_counter());
+  EXPECT_GE(statistics.get().mem_medium_pressure_counter(),
+            statistics.get().mem_critical_pressure_counter());
+
+  // The soft limit is lowered asynchronously, to the 48 MB of locked
+  // memory (plus the memory of the helper itself).
+  Try<Bytes> softLimit = Error("Not read");
+  Duration waited = Duration::zero();
+  do {
+    softLimit = cgroups::memory::soft_limit_in_bytes(hierarchy.get(), cgroup);
+    ASSERT_SOME(softLimit);
+
+    if (softLimit.get() < Megabytes(64)) {
+      break;
+    }
+
+    os::sleep(Milliseconds(100));
+    waited += Milliseconds(100);
+  } while (waited < Seconds(5));
+
+  EXPECT_GT(Megabytes(64), softLimit.get());
+  EXPECT_LE(Megabytes(48), softLimit.get());
+
+  // The next update restores the soft limit.
+  AWAIT_READY(isolator.get()->update(containerId, resources));
+
+  EXPECT_SOME_EQ(
+      Megabytes(64),
+      cgroups::memory::soft_limit_in_bytes(hierarchy.get(), cgroup));
+
+  // Ensure the process is killed.
+  helper.cleanup();
+
+  // Make sure the subprocess was reaped.
+  AWAIT_READY(status);
+
+  // Let the isolator clean up.
+  AWAIT_READY(isolator.get()->cleanup(containerId));
+
+  delete isolator.get();
+}
+
+
 class PerfEventIsolatorTest : public MesosTest {};
 
 
@@ -898,6 +1106,138 @@ TEST_F(PerfEventIsolatorTest, ROOT_CGROUPS_Sample)
 }
 
 
+class BlkioIsolatorTest : public MesosTest {};
+
+
+// Tests that the block I/O limits of a container are set (and
+// removed) for the device of the work directory, and that the I/O of
+// the container to that device shows up in its usage statistics.
+TEST_F(BlkioIsolatorTest, ROOT_CGROUPS_Blkio)
+{
+  slave::Flags flags;
+
+  // The isolator needs the work directory to be on a block device,
+  // which is more likely for the test sandbox than for the default.
+  flags.work_dir = os::getcwd();
+
+  Try<Isolator*> isolator = CgroupsBlkioIsolatorProcess::create(flags);
+  CHECK_SOME(isolator);
+
+  Try<Launcher*> launcher = LinuxLauncher::create(flags);
+  CHECK_SOME(launcher);
+
+  // 10 MB/s and 100 operations per second.
+  ExecutorInfo executorInfo;
+  executorInfo.mutable_resources()->CopyFrom(
+      Resources::parse("cpus:1;disk_bandwidth:10;disk_iops:100").get());
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  // Use a relative temporary directory so it gets cleaned up
+  // automatically with the test.
+  Try<string> dir = os::mkdtemp(path::join(os::getcwd(), "XXXXXX"));
+  ASSERT_SOME(dir);
+
+  AWAIT_READY(isolator.get()->prepare(
+      containerId,
+      executorInfo,
+      dir.get(),
+      None(),
+      None()));
+
+  Result<string> hierarchy = cgroups::hierarchy("blkio");
+  ASSERT_SOME(hierarchy);
+
+  const string cgroup = path::join(flags.cgroups_root, containerId.value());
+
+  Try<string> bps =
+    cgroups::read(hierarchy.get(), cgroup, "blkio.throttle.write_bps_device");
+  ASSERT_SOME(bps);
+  EXPECT_TRUE(strings::contains(bps.get(), " 10485760"));
+
+  Try<string> iops =
+    cgroups::read(hierarchy.get(), cgroup, "blkio.throttle.read_iops_device");
+  ASSERT_SOME(iops);
+  EXPECT_TRUE(strings::contains(iops.get(), " 100"));
+
+  // Write 1 MB in 16 operations, bypassing the page cache so that the
+  // writes are accounted to the container.
+  string command =
+    "dd if=/dev/zero of=" + path::join(dir.get(), "file") +
+    " bs=64k count=16 oflag=direct,sync";
+
+  int pipes[2];
+  ASSERT_NE(-1, ::pipe(pipes));
+
+  vector<string> argv(3);
+  argv[0] = "sh";
+  argv[1] = "-c";
+  argv[2] = command;
+
+  Try<pid_t> pid = launcher.get()->fork(
+      containerId,
+      "/bin/sh",
+      argv,
+      Subprocess::FD(STDIN_FILENO),
+      Subprocess::FD(STDOUT_FILENO),
+      Subprocess::FD(STDERR_FILENO),
+      None(),
+      None(),
+      lambda::bind(&childSetup, pipes));
+
+  ASSERT_SOME(pid);
+
+  // Reap the forked child.
+  Future<Option<int> > status = process::reap(pid.get());
+
+  // Continue in the parent.
+  ASSERT_SOME(os::close(pipes[0]));
+
+  // Isolate the forked child.
+  AWAIT_READY(isolator.get()->isolate(containerId, pid.get()));
+
+  // Now signal the child to continue.
+  char dummy;
+  ASSERT_LT(0, ::write(pipes[1], &dummy, sizeof(dummy)));
+
+  ASSERT_SOME(os::close(pipes[1]));
+
+  // Wait for the command to complete.
+  AWAIT_READY(status);
+  EXPECT_SOME_EQ(0, status.get());
+
+  Future<ResourceStatistics> usage = isolator.get()->usage(containerId);
+  AWAIT_READY(usage);
+
+  EXPECT_LE(Megabytes(1).bytes(), usage.get().disk_write_bytes());
+  EXPECT_LE(16u, usage.get().disk_write_ops());
+
+  // Without the resources the limits are removed.
+  AWAIT_READY(isolator.get()->update(
+      containerId,
+      Resources::parse("cpus:1").get()));
+
+  bps =
+    cgroups::read(hierarchy.get(), cgroup, "blkio.throttle.write_bps_device");
+  ASSERT_SOME(bps);
+  EXPECT_FALSE(strings::contains(bps.get(), " 10485760"));
+
+  // Ensure all processes are killed.
+  AWAIT_READY(launcher.get()->destroy(containerId));
+
+  // Let the isolator clean up.
+  AWAIT_READY(isolator.get()->cleanup(containerId));
+
+  Try<bool> exists = cgroups::exists(hierarchy.get(), cgroup);
+  ASSERT_SOME(exists);
+  EXPECT_FALSE(exists.get());
+
+  delete isolator.get();
+  delete launcher.get();
+}
+
+
 class SharedFilesystemIsolatorTest : public MesosTest {};
 
 
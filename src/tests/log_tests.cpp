@@ -35,11 +35,13 @@
 #include <process/shared.hpp>
 
 #include <stout/gtest.hpp>
+#include <stout/json.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 #include "log/catchup.hpp"
@@ -49,6 +51,7 @@
 #include "log/network.hpp"
 #include "log/storage.hpp"
 #include "log/recover.hpp"
+#include "log/repair.hpp"
 #include "log/replica.hpp"
 #include "log/tool/initialize.hpp"
 
@@ -522,6 +525,169 @@ TEST_F(ReplicaTest, Restore)
 }
 
 
+// This test verifies that reading a range of positions returns the
+// written actions (skipping the holes) both from a replica that has
+// the actions cached and from a restored replica that has to read
+// them from the storage.
+TEST_F(ReplicaTest, ReadRange)
+{
+  const string path = os::getcwd() + "/.log";
+  initializer.flags.path = path;
+  initializer.execute();
+
+  Replica replica1(path);
+
+  const uint64_t proposal = 1;
+
+  PromiseRequest request1;
+  request1.set_proposal(proposal);
+
+  Future<PromiseResponse> future1 =
+    protocol::promise(replica1.pid(), request1);
+
+  AWAIT_READY(future1);
+  EXPECT_TRUE(future1.get().okay());
+
+  // Leave a hole at position 3.
+  const uint64_t positions[] = {1, 2, 4, 5};
+
+  foreach (uint64_t position, positions) {
+    WriteRequest request2;
+    request2.set_proposal(proposal);
+    request2.set_position(position);
+    request2.set_type(Action::APPEND);
+    request2.mutable_append()->set_bytes(stringify(position));
+
+    Future<WriteResponse> future2 =
+      protocol::write(replica1.pid(), request2);
+
+    AWAIT_READY(future2);
+    EXPECT_TRUE(future2.get().okay());
+  }
+
+  Future<list<Action> > actions1 = replica1.read(1, 5);
+
+  AWAIT_READY(actions1);
+  ASSERT_EQ(4u, actions1.get().size());
+
+  Replica replica2(path);
+
+  Future<list<Action> > actions2 = replica2.read(1, 5);
+
+  AWAIT_READY(actions2);
+  ASSERT_EQ(4u, actions2.get().size());
+
+  list<Action>::const_iterator action1 = actions1.get().begin();
+  list<Action>::const_iterator action2 = actions2.get().begin();
+
+  foreach (uint64_t position, positions) {
+    EXPECT_EQ(position, action1->position());
+    EXPECT_EQ(stringify(position), action1->append().bytes());
+
+    EXPECT_EQ(position, action2->position());
+    EXPECT_EQ(stringify(position), action2->append().bytes());
+
+    ++action1;
+    ++action2;
+  }
+
+  // Reading a subrange only returns the actions within it.
+  Future<list<Action> > actions3 = replica2.read(2, 4);
+
+  AWAIT_READY(actions3);
+  ASSERT_EQ(2u, actions3.get().size());
+  EXPECT_EQ(2u, actions3.get().front().position());
+  EXPECT_EQ(4u, actions3.get().back().position());
+}
+
+
+// This test verifies that writes received back to back, which the
+// replica persists in a single batch, are all acknowledged and all
+// durable.
+TEST_F(ReplicaTest, BatchedWrites)
+{
+  const string path = os::getcwd() + "/.log";
+  initializer.flags.path = path;
+  initializer.execute();
+
+  LevelDBStorage::Options options;
+  options.bloomFilterBitsPerKey = 10;
+  options.compactOnRestore = false;
+
+  Owned<Replica> replica1(new Replica(path, options));
+
+  const uint64_t proposal = 1;
+
+  PromiseRequest request1;
+  request1.set_proposal(proposal);
+
+  Future<PromiseResponse> future1 =
+    protocol::promise(replica1->pid(), request1);
+
+  AWAIT_READY(future1);
+  EXPECT_TRUE(future1.get().okay());
+
+  // Send all the writes before waiting for any of the responses.
+  list<Future<WriteResponse> > futures;
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    WriteRequest request2;
+    request2.set_proposal(proposal);
+    request2.set_position(position);
+    request2.set_type(Action::APPEND);
+    request2.mutable_append()->set_bytes(stringify(position));
+
+    futures.push_back(protocol::write(replica1->pid(), request2));
+  }
+
+  foreach (const Future<WriteResponse>& future2, futures) {
+    AWAIT_READY(future2);
+    EXPECT_TRUE(future2.get().okay());
+  }
+
+  AWAIT_EXPECT_EQ(10u, replica1->ending());
+
+  replica1.reset();
+
+  Replica replica2(path, options);
+
+  Future<list<Action> > actions = replica2.read(1, 10);
+
+  AWAIT_READY(actions);
+  ASSERT_EQ(10u, actions.get().size());
+
+  uint64_t position = 1;
+  foreach (const Action& action, actions.get()) {
+    EXPECT_EQ(position, action.position());
+    EXPECT_EQ(stringify(position), action.append().bytes());
+    position++;
+  }
+}
+
+
+// This test verifies that the metrics of the storage of replicas
+// with different paths don't collide.
+TEST_F(ReplicaTest, StorageMetrics)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  const string path2 = os::getcwd() + "/.log2";
+
+  Replica replica1(path1);
+  Replica replica2(path2);
+
+  // Wait for both replicas to restore their storage.
+  AWAIT_READY(replica1.status());
+  AWAIT_READY(replica2.status());
+
+  JSON::Object metrics = Metrics();
+
+  EXPECT_EQ(1u, metrics.values.count(
+      "log/leveldb/" + strings::trim(path1, "/") + "/write_stalls"));
+  EXPECT_EQ(1u, metrics.values.count(
+      "log/leveldb/" + strings::trim(path2, "/") + "/write_stalls"));
+}
+
+
 // This test verifies that a non-VOTING replica does not reply to
 // promise or write requests.
 TEST_F(ReplicaTest, NonVoting)
@@ -1196,6 +1362,58 @@ TEST_F(CoordinatorTest, MultipleAppends)
 }
 
 
+TEST_F(CoordinatorTest, PipelinedAppends)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  // Start all the appends before any of them completes.
+  list<Future<Option<uint64_t> > > appendings;
+  for (uint64_t position = 1; position <= 10; position++) {
+    appendings.push_back(coord.append(stringify(position)));
+  }
+
+  uint64_t position = 1;
+  foreach (const Future<Option<uint64_t> >& appending, appendings) {
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position++, appending.get());
+  }
+
+  {
+    Future<list<Action> > actions = replica1->read(1, 10);
+    AWAIT_READY(actions);
+    EXPECT_EQ(10u, actions.get().size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+}
+
+
 TEST_F(CoordinatorTest, MultipleAppendsNotLearnedFill)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -1673,11 +1891,19 @@ TEST_F(RecoverTest, CatchupRetry)
   // promise phase even if replica1 reemerges later.
   DROP_MESSAGE(Eq(PromiseRequest().GetTypeName()), _, Eq(replica1->pid()));
 
+  // Drop the fetch requests so that the catch-up process has to fall
+  // back to Paxos (after the fetching times out).
+  DROP_MESSAGES(Eq(FetchRequest().GetTypeName()), _, _);
+
   Future<Nothing> catching =
     catchup(2, replica3, network2, None(), positions, Seconds(10));
 
   Clock::pause();
 
+  // Wait for the fetching to time out.
+  Clock::settle();
+  Clock::advance(Seconds(10));
+
   // Wait for the retry timer in 'catchup' to be setup.
   Clock::settle();
 
@@ -1699,6 +1925,83 @@ TEST_F(RecoverTest, CatchupRetry)
 }
 
 
+// This test verifies that the catch-up process fetches the actions
+// that have been learned by other replicas rather than running a
+// Paxos round for every position.
+TEST_F(RecoverTest, CatchupFetch)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  const string path3 = os::getcwd() + "/.log3";
+  initializer.flags.path = path3;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  IntervalSet<uint64_t> positions;
+
+  for (uint64_t position = 1; position <= 100; position++) {
+    Future<Option<uint64_t> > appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+    positions += position;
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  // All the positions have been learned by replica1 (and replica2)
+  // hence no Paxos round should be needed.
+  EXPECT_NO_FUTURE_MESSAGES(Eq(PromiseRequest().GetTypeName()), _, _);
+
+  Future<Nothing> catching =
+    catchup(2, replica3, network2, None(), positions, Seconds(10));
+
+  AWAIT_READY(catching);
+
+  Future<IntervalSet<uint64_t> > missing = replica3->missing(1, 100);
+  AWAIT_READY(missing);
+  EXPECT_TRUE(missing.get().empty());
+
+  Future<list<Action> > actions = replica3->read(1, 100);
+  AWAIT_READY(actions);
+  ASSERT_EQ(100u, actions.get().size());
+
+  uint64_t position = 1;
+  foreach (const Action& action, actions.get()) {
+    EXPECT_EQ(position, action.position());
+    EXPECT_TRUE(action.learned());
+    ASSERT_TRUE(action.has_append());
+    EXPECT_EQ(stringify(position), action.append().bytes());
+    position++;
+  }
+}
+
+
 TEST_F(RecoverTest, AutoInitialization)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -1837,6 +2140,95 @@ TEST_F(RecoverTest, AutoInitializationRetry)
 }
 
 
+class RepairTest : public TemporaryDirectoryTest
+{
+protected:
+  // For initializing the log.
+  tool::Initialize initializer;
+};
+
+
+// This test verifies that a VOTING replica that missed writes gets
+// repaired in the background by fetching the learned actions from
+// another replica, without running any Paxos round.
+TEST_F(RepairTest, Holes)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  const string path3 = os::getcwd() + "/.log3";
+  initializer.flags.path = path3;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+  Shared<Replica> replica3(new Replica(path3));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  for (uint64_t position = 1; position <= 100; position++) {
+    Future<Option<uint64_t> > appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+  }
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  // The repair must not interfere with the coordinator.
+  EXPECT_NO_FUTURE_MESSAGES(Eq(PromiseRequest().GetTypeName()), _, _);
+
+  Clock::pause();
+
+  Repairer repairer(replica3, network2, Megabytes(1), Seconds(10));
+
+  // Wait for the round of repair to start.
+  Clock::advance(Seconds(10));
+  Clock::settle();
+
+  // Wait for the throttling of the fetched actions.
+  Clock::advance(Seconds(1));
+  Clock::settle();
+
+  Clock::resume();
+
+  Future<IntervalSet<uint64_t> > missing = replica3->missing(1, 100);
+  AWAIT_READY(missing);
+  EXPECT_TRUE(missing.get().empty());
+
+  Future<list<Action> > actions = replica3->read(1, 100);
+  AWAIT_READY(actions);
+  ASSERT_EQ(100u, actions.get().size());
+
+  uint64_t position = 1;
+  foreach (const Action& action, actions.get()) {
+    EXPECT_EQ(position, action.position());
+    EXPECT_TRUE(action.learned());
+    ASSERT_TRUE(action.has_append());
+    EXPECT_EQ(stringify(position), action.append().bytes());
+    position++;
+  }
+}
+
+
 class LogTest : public TemporaryDirectoryTest
 {
 protected:
@@ -291,6 +291,78 @@ TEST_F(MasterAuthorizationTest, KillTask)
 }
 
 
+// This test verifies that the tasks launched as the same user by a
+// single ACCEPT call are authorized with a single request.
+TEST_F(MasterAuthorizationTest, AuthorizedTasksSameUser)
+{
+  MockAuthorizer authorizer;
+  Try<PID<Master> > master = StartMaster(&authorizer);
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave> > slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  Resources resources = Resources::parse("cpus:1;mem:128").get();
+
+  vector<TaskInfo> tasks;
+  tasks.push_back(createTask(
+      offers.get()[0].slave_id(), resources, "", DEFAULT_EXECUTOR_ID));
+  tasks.push_back(createTask(
+      offers.get()[0].slave_id(), resources, "", DEFAULT_EXECUTOR_ID));
+
+  // Both tasks are launched as the framework's user.
+  EXPECT_CALL(authorizer, authorize(An<const mesos::ACL::RunTask&>()))
+    .WillOnce(Return(true));
+
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .Times(1);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1.get().state());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_RUNNING, status2.get().state());
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
 // This test verifies that a slave removal that comes before
 // '_launchTasks()' is called results in TASK_LOST.
 TEST_F(MasterAuthorizationTest, SlaveRemoved)
@@ -246,6 +246,114 @@ TEST_F(ZooKeeperMasterContenderDetectorTest, MasterContender)
 }
 
 
+// Verifies that a contender and a detector can share a group, i.e.,
+// a single ZooKeeper session, as done by the master.
+TEST_F(ZooKeeperMasterContenderDetectorTest, ContenderDetectorSharedGroup)
+{
+  Try<zookeeper::URL> url = zookeeper::URL::parse(
+      "zk://" + server->connectString() + "/mesos");
+
+  ASSERT_SOME(url);
+
+  Owned<zookeeper::Group> group(
+      new Group(url.get(), MASTER_CONTENDER_ZK_SESSION_TIMEOUT));
+
+  ZooKeeperMasterContender contender(group);
+  ZooKeeperMasterDetector detector(group);
+
+  PID<Master> pid;
+  pid.address.ip = net::IP(10000000);
+  pid.address.port = 10000;
+
+  MasterInfo master = internal::protobuf::createMasterInfo(pid);
+
+  contender.initialize(master);
+  Future<Future<Nothing> > contended = contender.contend();
+  AWAIT_READY(contended);
+
+  Future<Option<MasterInfo> > leader = detector.detect();
+
+  AWAIT_READY(leader);
+  EXPECT_SOME_EQ(master, leader.get());
+
+  // A session expiration is observed by both of them.
+  Future<Nothing> lostCandidacy = contended.get();
+  leader = detector.detect(leader.get());
+
+  Future<Option<int64_t> > sessionId = group.get()->session();
+  AWAIT_READY(sessionId);
+  server->expireSession(sessionId.get().get());
+
+  AWAIT_READY(lostCandidacy);
+  AWAIT_READY(leader);
+  EXPECT_NONE(leader.get());
+
+  // Both recover on the new session.
+  contended = contender.contend();
+  AWAIT_READY(contended);
+
+  leader = detector.detect(leader.get());
+
+  AWAIT_READY(leader);
+  EXPECT_SOME_EQ(master, leader.get());
+}
+
+
+// Verifies that shared detectors for the same URL detect the leading
+// master and keep doing so when the other detectors are gone.
+TEST_F(ZooKeeperMasterContenderDetectorTest, SharedMasterDetectors)
+{
+  Try<zookeeper::URL> url = zookeeper::URL::parse(
+      "zk://" + server->connectString() + "/mesos");
+
+  ASSERT_SOME(url);
+
+  Owned<zookeeper::Group> group(
+      new Group(url.get(), MASTER_CONTENDER_ZK_SESSION_TIMEOUT));
+
+  ZooKeeperMasterContender contender(group);
+
+  PID<Master> pid;
+  pid.address.ip = net::IP(10000000);
+  pid.address.port = 10000;
+
+  MasterInfo master = internal::protobuf::createMasterInfo(pid);
+
+  contender.initialize(master);
+  Future<Future<Nothing> > contended = contender.contend();
+  AWAIT_READY(contended);
+
+  ZooKeeperMasterDetector detector1(url.get(), true);
+
+  Future<Option<MasterInfo> > leader1 = detector1.detect();
+
+  Owned<ZooKeeperMasterDetector> detector2(
+      new ZooKeeperMasterDetector(url.get(), true));
+
+  Future<Option<MasterInfo> > leader2 = detector2->detect();
+
+  AWAIT_READY(leader1);
+  EXPECT_SOME_EQ(master, leader1.get());
+
+  AWAIT_READY(leader2);
+  EXPECT_SOME_EQ(master, leader2.get());
+
+  // The remaining detector still detects leadership changes once the
+  // other one is gone.
+  detector2.reset();
+
+  leader1 = detector1.detect(leader1.get());
+  ASSERT_TRUE(leader1.isPending());
+
+  Future<Option<int64_t> > sessionId = group.get()->session();
+  AWAIT_READY(sessionId);
+  server->expireSession(sessionId.get().get());
+
+  AWAIT_READY(leader1);
+  EXPECT_NONE(leader1.get());
+}
+
+
 // Verifies that contender does not recontend if the current election
 // is still pending.
 TEST_F(ZooKeeperMasterContenderDetectorTest, ContenderPendingElection)
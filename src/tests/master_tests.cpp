@@ -20,8 +20,10 @@
 
 #include <gmock/gmock.h>
 
+#include <list>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <mesos/executor.hpp>
@@ -30,10 +32,13 @@
 #include <mesos/master/allocator.hpp>
 
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/http.hpp>
 #include <process/pid.hpp>
+#include <process/process.hpp>
+#include <process/protobuf.hpp>
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/metrics.hpp>
@@ -42,10 +47,12 @@
 #include <stout/net.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 #include "common/build.hpp"
+#include "common/protobuf_utils.hpp"
 
 #include "master/flags.hpp"
 #include "master/master.hpp"
@@ -73,9 +80,13 @@ using mesos::internal::slave::MesosContainerizerProcess;
 
 using process::Clock;
 using process::Future;
+using process::Message;
 using process::PID;
 using process::Promise;
+using process::UPID;
 
+using std::list;
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::vector;
@@ -87,6 +98,7 @@ using testing::Eq;
 using testing::Not;
 using testing::Return;
 using testing::SaveArg;
+using testing::WithParamInterface;
 
 namespace mesos {
 namespace internal {
@@ -365,6 +377,93 @@ TEST_F(MasterTest, KillTask)
 }
 
 
+// This test ensures that tasks can be killed in bulk through a
+// single KillTasksMessage.
+TEST_F(MasterTest, KillTasks)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave>> slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskID taskId;
+  taskId.set_value("1");
+
+  TaskInfo task;
+  task.set_name("");
+  task.mutable_task_id()->MergeFrom(taskId);
+  task.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+  task.mutable_resources()->MergeFrom(offers.get()[0].resources());
+  task.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+
+  vector<TaskInfo> tasks;
+  tasks.push_back(task);
+
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .Times(1);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  EXPECT_CALL(exec, killTask(_, _))
+    .WillOnce(SendStatusUpdateFromTaskID(TASK_KILLED));
+
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  Future<KillTasksMessage> killTasksMessage =
+    FUTURE_PROTOBUF(KillTasksMessage(), _, master.get());
+
+  vector<TaskID> taskIds;
+  taskIds.push_back(taskId);
+
+  driver.killTasks(taskIds);
+
+  AWAIT_READY(killTasksMessage);
+  EXPECT_EQ(1, killTasksMessage.get().task_ids_size());
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_KILLED, status.get().state());
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 // This test ensures that a killTask for an unknown task results in a
 // TASK_LOST when there are no slaves in transitionary states.
 TEST_F(MasterTest, KillUnknownTask)
@@ -921,8 +1020,15 @@ TEST_F(MasterTest, MultipleExecutors)
     .WillOnce(FutureArg<1>(&status1))
     .WillOnce(FutureArg<1>(&status2));
 
+  // Both tasks are sent to the slave at once.
+  Future<RunTasksMessage> runTasksMessage =
+    FUTURE_PROTOBUF(RunTasksMessage(), master.get(), slave.get());
+
   driver.launchTasks(offers.get()[0].id(), tasks);
 
+  AWAIT_READY(runTasksMessage);
+  EXPECT_EQ(2, runTasksMessage.get().tasks_size());
+
   AWAIT_READY(exec1Task);
   EXPECT_EQ(task1.task_id(), exec1Task.get().task_id());
 
@@ -1524,12 +1630,16 @@ TEST_F(MasterTest, MetricsInMetricsEndpoint)
   EXPECT_EQ(1u, snapshot.values.count("master/messages_unregister_framework"));
   EXPECT_EQ(1u, snapshot.values.count("master/messages_deactivate_framework"));
   EXPECT_EQ(1u, snapshot.values.count("master/messages_kill_task"));
+  EXPECT_EQ(1u, snapshot.values.count("master/messages_kill_tasks"));
   EXPECT_EQ(1u, snapshot.values.count(
       "master/messages_status_update_acknowledgement"));
+  EXPECT_EQ(1u, snapshot.values.count(
+      "master/messages_status_update_acknowledgements"));
   EXPECT_EQ(1u, snapshot.values.count("master/messages_resource_request"));
   EXPECT_EQ(1u, snapshot.values.count("master/messages_launch_tasks"));
   EXPECT_EQ(1u, snapshot.values.count("master/messages_decline_offers"));
   EXPECT_EQ(1u, snapshot.values.count("master/messages_revive_offers"));
+  EXPECT_EQ(1u, snapshot.values.count("master/messages_suppress_offers"));
   EXPECT_EQ(1u, snapshot.values.count("master/messages_reconcile_tasks"));
   EXPECT_EQ(1u, snapshot.values.count("master/messages_framework_to_executor"));
 
@@ -1584,6 +1694,36 @@ TEST_F(MasterTest, MetricsInMetricsEndpoint)
 }
 
 
+// Ensures that the latencies of handling messages are sampled.
+TEST_F(MasterTest, MessageLatenciesInMetricsEndpoint)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  JSON::Object snapshot = Metrics();
+
+  // The first message of each type is sampled.
+  const string prefix = "master/messages/mesos.internal.RegisterSlaveMessage";
+
+  EXPECT_EQ(1u, snapshot.values.count(prefix + "/queued_us"));
+  EXPECT_EQ(1u, snapshot.values.count(prefix + "/queued_us/p50"));
+  EXPECT_EQ(1u, snapshot.values.count(prefix + "/handled_us"));
+  EXPECT_EQ(1u, snapshot.values.count(prefix + "/handled_us/p50"));
+
+  EXPECT_EQ(1u, snapshot.values.count("master/accept/authorization_us"));
+
+  Shutdown();
+}
+
+
 // Ensures that an empty response arrives if information about
 // registered slaves is requested from a master where no slaves
 // have been registered.
@@ -1664,157 +1804,108 @@ TEST_F(MasterTest, SlavesEndpointTwoSlaves)
 }
 
 
-// This test ensures that when a slave is recovered from the registry
-// but does not re-register with the master, it is removed from the
-// registry and the framework is informed that the slave is lost, and
-// the slave is refused re-registration.
-TEST_F(MasterTest, RecoveredSlaveDoesNotReregister)
+// This test verifies that the resource usage a slave piggybacks on
+// its pongs is exposed by /master/utilization.
+TEST_F(MasterTest, UtilizationEndpoint)
 {
-  // Step 1: Start a master.
-  master::Flags masterFlags = CreateMasterFlags();
-  Try<PID<Master>> master = StartMaster(masterFlags);
+  Try<PID<Master>> master = StartMaster();
   ASSERT_SOME(master);
 
-  // Step 2: Start a slave.
-  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
-    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
-
-  // Reuse slaveFlags so both StartSlave() use the same work_dir.
-  slave::Flags slaveFlags = this->CreateSlaveFlags();
+  Future<Message> pong = FUTURE_MESSAGE(Eq("PONG"), _, master.get());
 
-  Try<PID<Slave>> slave = StartSlave(slaveFlags);
+  Try<PID<Slave>> slave = StartSlave();
   ASSERT_SOME(slave);
 
-  AWAIT_READY(slaveRegisteredMessage);
-
-  // Step 3: Stop the slave while the master is down.
-  this->Stop(master.get());
-
-  this->Stop(slave.get());
+  // The first pong precedes the first summary of the slave.
+  AWAIT_READY(pong);
 
-  // Step 4: Restart the master.
-  master = StartMaster(masterFlags);
-  ASSERT_SOME(master);
+  Clock::pause();
+  Clock::settle();
 
-  // Step 5: Start a scheduler.
-  MockScheduler sched;
-  MesosSchedulerDriver driver(
-    &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+  Future<http::Response> response = http::get(master.get(), "utilization");
+  AWAIT_READY(response);
 
-  Future<Nothing> registered;
-  EXPECT_CALL(sched, registered(&driver, _, _))
-    .WillOnce(FutureSatisfy(&registered));
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
 
-  driver.start();
+  Result<JSON::Array> slaves = parse.get().find<JSON::Array>("slaves");
+  ASSERT_SOME(slaves);
+  EXPECT_TRUE(slaves.get().values.empty());
 
-  AWAIT_READY(registered);
+  pong = FUTURE_MESSAGE(Eq("PONG"), _, master.get());
 
-  // Step 6: Advance the clock until the re-registration timeout
-  // elapses, and expect the slave / task to be lost!
-  Future<Nothing> slaveLost;
-  EXPECT_CALL(sched, slaveLost(&driver, _))
-    .WillOnce(FutureSatisfy(&slaveLost));
+  Clock::advance(master::SLAVE_PING_TIMEOUT);
 
-  Clock::pause();
-  Clock::advance(masterFlags.slave_reregister_timeout);
+  AWAIT_READY(pong);
 
-  AWAIT_READY(slaveLost);
+  PongSlaveMessage message;
+  ASSERT_TRUE(message.ParseFromString(pong.get().body));
+  EXPECT_TRUE(message.has_usage());
 
-  JSON::Object stats = Metrics();
-  EXPECT_EQ(1, stats.values["master/slave_removals"]);
-  EXPECT_EQ(1, stats.values["master/slave_removals/reason_unhealthy"]);
+  Clock::settle();
 
-  Clock::resume();
+  response = http::get(master.get(), "utilization");
+  AWAIT_READY(response);
 
-  // Step 7: Ensure the slave cannot re-register!
-  Future<ShutdownMessage> shutdownMessage =
-    FUTURE_PROTOBUF(ShutdownMessage(), master.get(), _);
+  parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
 
-  slave = StartSlave(slaveFlags);
-  ASSERT_SOME(slave);
+  slaves = parse.get().find<JSON::Array>("slaves");
+  ASSERT_SOME(slaves);
+  EXPECT_EQ(1u, slaves.get().values.size());
 
-  AWAIT_READY(shutdownMessage);
+  EXPECT_SOME(parse.get().find<JSON::Number>("total.mem_rss_bytes"));
 
-  driver.stop();
-  driver.join();
+  Clock::resume();
 
   Shutdown();
 }
 
 
-// This test ensures that a non-strict registry is write-only by
-// inducing a slave removal during recovery. After which, we expect
-// that the framework is *not* informed, and we expect that the
-// slave can re-register successfully.
-TEST_F(MasterTest, NonStrictRegistryWriteOnly)
+// This test verifies that the memory endpoint accounts for the
+// frameworks, offers and slaves of the master.
+TEST_F(MasterTest, MemoryEndpoint)
 {
-  // Step 1: Start a master.
-  master::Flags masterFlags = CreateMasterFlags();
-  masterFlags.registry_strict = false;
-
-  Try<PID<Master>> master = StartMaster(masterFlags);
+  Try<PID<Master>> master = StartMaster();
   ASSERT_SOME(master);
 
-  // Step 2: Start a slave.
-  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
-    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
-
-  // Reuse slaveFlags so both StartSlave() use the same work_dir.
-  slave::Flags slaveFlags = this->CreateSlaveFlags();
-
-  Try<PID<Slave>> slave = StartSlave(slaveFlags);
+  Try<PID<Slave>> slave = StartSlave();
   ASSERT_SOME(slave);
 
-  AWAIT_READY(slaveRegisteredMessage);
-
-  // Step 3: Stop the slave while the master is down.
-  this->Stop(master.get());
-
-  this->Stop(slave.get());
-
-  // Step 4: Restart the master.
-  master = StartMaster(masterFlags);
-  ASSERT_SOME(master);
-
-  // Step 5: Start a scheduler.
   MockScheduler sched;
   MesosSchedulerDriver driver(
-    &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
 
-  Future<Nothing> registered;
-  EXPECT_CALL(sched, registered(&driver, _, _))
-    .WillOnce(FutureSatisfy(&registered));
+  EXPECT_CALL(sched, registered(&driver, _, _));
 
+  Future<vector<Offer>> offers;
   EXPECT_CALL(sched, resourceOffers(&driver, _))
-    .WillRepeatedly(Return()); // Ignore offers.
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
 
   driver.start();
 
-  AWAIT_READY(registered);
-
-  // Step 6: Advance the clock and make sure the slave is not
-  // removed!
-  Future<Nothing> slaveLost;
-  EXPECT_CALL(sched, slaveLost(&driver, _))
-    .WillRepeatedly(FutureSatisfy(&slaveLost));
-
-  Clock::pause();
-  Clock::advance(masterFlags.slave_reregister_timeout);
-  Clock::settle();
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
 
-  ASSERT_TRUE(slaveLost.isPending());
+  Future<http::Response> response = http::get(master.get(), "memory");
+  AWAIT_READY(response);
 
-  Clock::resume();
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
 
-  // Step 7: Now expect the slave to be able to re-register,
-  // according to the non-strict semantics.
-  Future<SlaveReregisteredMessage> slaveReregisteredMessage =
-    FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), _);
+  EXPECT_SOME_EQ(1u, parse.get().find<JSON::Number>("frameworks.count"));
+  EXPECT_SOME_EQ(1u, parse.get().find<JSON::Number>("offers.count"));
+  EXPECT_SOME_EQ(1u, parse.get().find<JSON::Number>("slaves.count"));
+  EXPECT_SOME_EQ(0u, parse.get().find<JSON::Number>("tasks.count"));
 
-  slave = StartSlave(slaveFlags);
-  ASSERT_SOME(slave);
+  Result<JSON::Number> bytes = parse.get().find<JSON::Number>("offers.bytes");
+  ASSERT_SOME(bytes);
+  EXPECT_LT(0u, bytes.get().value);
 
-  AWAIT_READY(slaveReregisteredMessage);
+  bytes = parse.get().find<JSON::Number>("total_bytes");
+  ASSERT_SOME(bytes);
+  EXPECT_LT(0u, bytes.get().value);
 
   driver.stop();
   driver.join();
@@ -1823,73 +1914,103 @@ TEST_F(MasterTest, NonStrictRegistryWriteOnly)
 }
 
 
-// This test ensures that slave removals during master recovery
-// are rate limited.
-TEST_F(MasterTest, RateLimitRecoveredSlaveRemoval)
+// This test verifies that a traced task launch is recorded by both
+// the master and the slave under the same trace ID.
+TEST_F(MasterTest, TraceEndpoint)
 {
-  // Start a master.
   master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.trace_sampling_rate = 1.0;
+
   Try<PID<Master>> master = StartMaster(masterFlags);
   ASSERT_SOME(master);
 
-  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
-    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
 
-  // Start a slave.
-  Try<PID<Slave>> slave = StartSlave();
+  Try<PID<Slave>> slave = StartSlave(&exec);
   ASSERT_SOME(slave);
 
-  AWAIT_READY(slaveRegisteredMessage);
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
 
-  // Stop the slave while the master is down.
-  this->Stop(master.get());
-  this->Stop(slave.get());
+  EXPECT_CALL(sched, registered(&driver, _, _));
 
-  shared_ptr<MockRateLimiter> slaveRemovalLimiter(new MockRateLimiter());
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 1, 1, 16, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
 
-  // Return a pending future from the rate limiter.
-  Future<Nothing> acquire;
-  Promise<Nothing> promise;
-  EXPECT_CALL(*slaveRemovalLimiter, acquire())
-    .WillOnce(DoAll(FutureSatisfy(&acquire),
-                    Return(promise.future())));
-
-  // Restart the master.
-  master = StartMaster(slaveRemovalLimiter, masterFlags);
-  ASSERT_SOME(master);
+  EXPECT_CALL(exec, registered(_, _, _, _));
 
-  // Start a scheduler to ensure the master would notify
-  // a framework about slave removal.
-  MockScheduler sched;
-  MesosSchedulerDriver driver(
-    &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
 
-  Future<Nothing> registered;
-  EXPECT_CALL(sched, registered(&driver, _, _))
-    .WillOnce(FutureSatisfy(&registered));
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
 
-  Future<Nothing> slaveLost;
-  EXPECT_CALL(sched, slaveLost(&driver, _))
-    .WillRepeatedly(FutureSatisfy(&slaveLost));
+  // The trace is passed on to the slave even for a single task.
+  Future<RunTasksMessage> runTasksMessage =
+    FUTURE_PROTOBUF(RunTasksMessage(), master.get(), slave.get());
 
   driver.start();
 
-  AWAIT_READY(registered);
+  AWAIT_READY(runTasksMessage);
+  ASSERT_EQ(1, runTasksMessage.get().traces_size());
 
-  // Trigger the slave re-registration timeout.
-  Clock::pause();
-  Clock::advance(masterFlags.slave_reregister_timeout);
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
 
-  // The master should attempt to acquire a permit.
-  AWAIT_READY(acquire);
+  Future<http::Response> response = http::get(master.get(), "trace");
+  AWAIT_READY(response);
 
-  // The removal should not occur before the permit is satisfied.
-  Clock::settle();
-  ASSERT_TRUE(slaveLost.isPending());
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
 
-  // Once the permit is satisfied, the slave should be removed.
-  promise.set(Nothing());
-  AWAIT_READY(slaveLost);
+  Result<JSON::Array> spans = parse.get().find<JSON::Array>("spans");
+  ASSERT_SOME(spans);
+  EXPECT_EQ(2u, spans.get().values.size());
+
+  EXPECT_SOME_EQ(
+      JSON::String("master/accept"),
+      parse.get().find<JSON::String>("spans[0].name"));
+  EXPECT_SOME_EQ(
+      JSON::String("task/launch"),
+      parse.get().find<JSON::String>("spans[1].name"));
+
+  Result<JSON::String> traceId =
+    parse.get().find<JSON::String>("spans[0].trace_id");
+  ASSERT_SOME(traceId);
+
+  EXPECT_SOME_EQ(
+      traceId.get(),
+      parse.get().find<JSON::String>("spans[1].trace_id"));
+
+  response = http::get(slave.get(), "trace");
+  AWAIT_READY(response);
+
+  parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  spans = parse.get().find<JSON::Array>("spans");
+  ASSERT_SOME(spans);
+  ASSERT_FALSE(spans.get().values.empty());
+
+  // The slave records its spans under the trace ID of the master.
+  const size_t last = spans.get().values.size() - 1;
+  for (size_t i = 0; i <= last; i++) {
+    EXPECT_SOME_EQ(
+        traceId.get(),
+        parse.get().find<JSON::String>(
+            "spans[" + stringify(i) + "].trace_id"));
+  }
+
+  EXPECT_SOME_EQ(
+      JSON::String("executor/task_start"),
+      parse.get().find<JSON::String>(
+          "spans[" + stringify(last) + "].name"));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
 
   driver.stop();
   driver.join();
@@ -1898,45 +2019,93 @@ TEST_F(MasterTest, RateLimitRecoveredSlaveRemoval)
 }
 
 
-// This test ensures that slave removals that get scheduled during
-// master recovery can be canceled if the slave re-registers.
-TEST_F(MasterTest, CancelRecoveredSlaveRemoval)
+// This test ensures that a slave that (re-)registers in excess of
+// '--slave_registration_rate_limit' is told when to retry and gets
+// registered once it retries at that time.
+TEST_F(MasterTest, SlaveRegistrationRateLimit)
 {
-  // Start a master.
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.slave_registration_rate_limit = "1/1mins";
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slave1RegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+  Try<PID<Slave>> slave1 = StartSlave();
+  ASSERT_SOME(slave1);
+
+  AWAIT_READY(slave1RegisteredMessage);
+
+  Clock::pause();
+
+  Future<SlaveRegistrationThrottledMessage> throttledMessage =
+    FUTURE_PROTOBUF(SlaveRegistrationThrottledMessage(), master.get(), _);
+
+  Future<SlaveRegisteredMessage> slave2RegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), Not(slave1.get()));
+
+  slave::Flags slaveFlags = CreateSlaveFlags();
+  Try<PID<Slave>> slave2 = StartSlave(slaveFlags);
+  ASSERT_SOME(slave2);
+
+  Clock::advance(slaveFlags.registration_backoff_factor);
+
+  AWAIT_READY(throttledMessage);
+
+  Try<Duration> retryAfter =
+    Duration::create(throttledMessage.get().retry_after());
+  ASSERT_SOME(retryAfter);
+  EXPECT_LT(Duration::zero(), retryAfter.get());
+  EXPECT_GE(Minutes(1), retryAfter.get());
+
+  // The slave is not registered before the time it was given.
+  Clock::settle();
+  EXPECT_TRUE(slave2RegisteredMessage.isPending());
+
+  Clock::advance(retryAfter.get());
+
+  AWAIT_READY(slave2RegisteredMessage);
+
+  Clock::resume();
+
+  Shutdown();
+}
+
+
+// This test ensures that when a slave is recovered from the registry
+// but does not re-register with the master, it is removed from the
+// registry and the framework is informed that the slave is lost, and
+// the slave is refused re-registration.
+TEST_F(MasterTest, RecoveredSlaveDoesNotReregister)
+{
+  // Step 1: Start a master.
   master::Flags masterFlags = CreateMasterFlags();
   Try<PID<Master>> master = StartMaster(masterFlags);
   ASSERT_SOME(master);
 
+  // Step 2: Start a slave.
   Future<SlaveRegisteredMessage> slaveRegisteredMessage =
     FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
 
   // Reuse slaveFlags so both StartSlave() use the same work_dir.
-  slave::Flags slaveFlags = CreateSlaveFlags();
+  slave::Flags slaveFlags = this->CreateSlaveFlags();
 
   Try<PID<Slave>> slave = StartSlave(slaveFlags);
   ASSERT_SOME(slave);
 
   AWAIT_READY(slaveRegisteredMessage);
 
-  // Stop the slave while the master is down.
+  // Step 3: Stop the slave while the master is down.
   this->Stop(master.get());
-  this->Stop(slave.get());
-
-  shared_ptr<MockRateLimiter> slaveRemovalLimiter(new MockRateLimiter());
 
-  // Return a pending future from the rate limiter.
-  Future<Nothing> acquire;
-  Promise<Nothing> promise;
-  EXPECT_CALL(*slaveRemovalLimiter, acquire())
-    .WillOnce(DoAll(FutureSatisfy(&acquire),
-                    Return(promise.future())));
+  this->Stop(slave.get());
 
-  // Restart the master.
-  master = StartMaster(slaveRemovalLimiter, masterFlags);
+  // Step 4: Restart the master.
+  master = StartMaster(masterFlags);
   ASSERT_SOME(master);
 
-  // Start a scheduler to ensure the master would notify
-  // a framework about slave removal.
+  // Step 5: Start a scheduler.
   MockScheduler sched;
   MesosSchedulerDriver driver(
     &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
@@ -1945,42 +2114,35 @@ TEST_F(MasterTest, CancelRecoveredSlaveRemoval)
   EXPECT_CALL(sched, registered(&driver, _, _))
     .WillOnce(FutureSatisfy(&registered));
 
-  Future<Nothing> slaveLost;
-  EXPECT_CALL(sched, slaveLost(&driver, _))
-    .WillRepeatedly(FutureSatisfy(&slaveLost));
-
   driver.start();
 
   AWAIT_READY(registered);
 
-  // Trigger the slave re-registration timeout.
+  // Step 6: Advance the clock until the re-registration timeout
+  // elapses, and expect the slave / task to be lost!
+  Future<Nothing> slaveLost;
+  EXPECT_CALL(sched, slaveLost(&driver, _))
+    .WillOnce(FutureSatisfy(&slaveLost));
+
   Clock::pause();
   Clock::advance(masterFlags.slave_reregister_timeout);
 
-  // The master should attempt to acquire a permit.
-  AWAIT_READY(acquire);
+  AWAIT_READY(slaveLost);
 
-  // The removal should not occur before the permit is satisfied.
-  Clock::settle();
-  ASSERT_TRUE(slaveLost.isPending());
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(1, stats.values["master/slave_removals"]);
+  EXPECT_EQ(1, stats.values["master/slave_removals/reason_unhealthy"]);
 
-  // Ignore resource offers from the re-registered slave.
-  EXPECT_CALL(sched, resourceOffers(&driver, _))
-    .WillRepeatedly(Return());
+  Clock::resume();
 
-  Future<SlaveReregisteredMessage> slaveReregisteredMessage =
-    FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), _);
+  // Step 7: Ensure the slave cannot re-register!
+  Future<ShutdownMessage> shutdownMessage =
+    FUTURE_PROTOBUF(ShutdownMessage(), master.get(), _);
 
-  // Restart the slave.
   slave = StartSlave(slaveFlags);
   ASSERT_SOME(slave);
 
-  AWAIT_READY(slaveReregisteredMessage);
-
-  // Satisfy the rate limit permit. Ensure a removal does not occur!
-  promise.set(Nothing());
-  Clock::settle();
-  ASSERT_TRUE(slaveLost.isPending());
+  AWAIT_READY(shutdownMessage);
 
   driver.stop();
   driver.join();
@@ -1989,13 +2151,16 @@ TEST_F(MasterTest, CancelRecoveredSlaveRemoval)
 }
 
 
-// This test ensures that when a slave is recovered from the registry
-// and re-registers with the master, it is *not* removed after the
-// re-registration timeout elapses.
-TEST_F(MasterTest, RecoveredSlaveReregisters)
+// This test ensures that a non-strict registry is write-only by
+// inducing a slave removal during recovery. After which, we expect
+// that the framework is *not* informed, and we expect that the
+// slave can re-register successfully.
+TEST_F(MasterTest, NonStrictRegistryWriteOnly)
 {
   // Step 1: Start a master.
   master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.registry_strict = false;
+
   Try<PID<Master>> master = StartMaster(masterFlags);
   ASSERT_SOME(master);
 
@@ -2020,8 +2185,7 @@ TEST_F(MasterTest, RecoveredSlaveReregisters)
   master = StartMaster(masterFlags);
   ASSERT_SOME(master);
 
-  // Step 5: Start a scheduler to ensure the master would notify
-  // a framework, were a slave to be lost.
+  // Step 5: Start a scheduler.
   MockScheduler sched;
   MesosSchedulerDriver driver(
     &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
@@ -2030,27 +2194,13 @@ TEST_F(MasterTest, RecoveredSlaveReregisters)
   EXPECT_CALL(sched, registered(&driver, _, _))
     .WillOnce(FutureSatisfy(&registered));
 
-  // Ignore all offer related calls. The scheduler might receive
-  // offerRescinded calls because the slave might re-register due to
-  // ping timeout.
   EXPECT_CALL(sched, resourceOffers(&driver, _))
-    .WillRepeatedly(Return());
-
-  EXPECT_CALL(sched, offerRescinded(&driver, _))
-    .WillRepeatedly(Return());
+    .WillRepeatedly(Return()); // Ignore offers.
 
   driver.start();
 
   AWAIT_READY(registered);
 
-  Future<SlaveReregisteredMessage> slaveReregisteredMessage =
-    FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), _);
-
-  slave = StartSlave(slaveFlags);
-  ASSERT_SOME(slave);
-
-  AWAIT_READY(slaveReregisteredMessage);
-
   // Step 6: Advance the clock and make sure the slave is not
   // removed!
   Future<Nothing> slaveLost;
@@ -2063,6 +2213,18 @@ TEST_F(MasterTest, RecoveredSlaveReregisters)
 
   ASSERT_TRUE(slaveLost.isPending());
 
+  Clock::resume();
+
+  // Step 7: Now expect the slave to be able to re-register,
+  // according to the non-strict semantics.
+  Future<SlaveReregisteredMessage> slaveReregisteredMessage =
+    FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), _);
+
+  slave = StartSlave(slaveFlags);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveReregisteredMessage);
+
   driver.stop();
   driver.join();
 
@@ -2070,29 +2232,276 @@ TEST_F(MasterTest, RecoveredSlaveReregisters)
 }
 
 
-#ifdef MESOS_HAS_JAVA
+// This test ensures that slave removals during master recovery
+// are rate limited.
+TEST_F(MasterTest, RateLimitRecoveredSlaveRemoval)
+{
+  // Start a master.
+  master::Flags masterFlags = CreateMasterFlags();
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
 
-class MasterZooKeeperTest : public MesosZooKeeperTest {};
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
 
-// This test verifies that when the ZooKeeper cluster is lost,
-// master, slave & scheduler all get informed.
-TEST_F(MasterZooKeeperTest, LostZooKeeperCluster)
-{
-  ASSERT_SOME(StartMaster());
+  // Start a slave.
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
 
-  Future<process::Message> slaveRegisteredMessage =
-    FUTURE_MESSAGE(Eq(SlaveRegisteredMessage().GetTypeName()), _, _);
+  AWAIT_READY(slaveRegisteredMessage);
 
-  ASSERT_SOME(StartSlave());
+  // Stop the slave while the master is down.
+  this->Stop(master.get());
+  this->Stop(slave.get());
+
+  shared_ptr<MockRateLimiter> slaveRemovalLimiter(new MockRateLimiter());
+
+  // Return a pending future from the rate limiter.
+  Future<Nothing> acquire;
+  Promise<Nothing> promise;
+  EXPECT_CALL(*slaveRemovalLimiter, acquire())
+    .WillOnce(DoAll(FutureSatisfy(&acquire),
+                    Return(promise.future())));
+
+  // Restart the master.
+  master = StartMaster(slaveRemovalLimiter, masterFlags);
+  ASSERT_SOME(master);
 
+  // Start a scheduler to ensure the master would notify
+  // a framework about slave removal.
   MockScheduler sched;
   MesosSchedulerDriver driver(
-      &sched, DEFAULT_FRAMEWORK_INFO, stringify(url.get()), DEFAULT_CREDENTIAL);
+    &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
 
+  Future<Nothing> registered;
   EXPECT_CALL(sched, registered(&driver, _, _))
-    .Times(1);
+    .WillOnce(FutureSatisfy(&registered));
 
-  EXPECT_CALL(sched, resourceOffers(&driver, _))
+  Future<Nothing> slaveLost;
+  EXPECT_CALL(sched, slaveLost(&driver, _))
+    .WillRepeatedly(FutureSatisfy(&slaveLost));
+
+  driver.start();
+
+  AWAIT_READY(registered);
+
+  // Trigger the slave re-registration timeout.
+  Clock::pause();
+  Clock::advance(masterFlags.slave_reregister_timeout);
+
+  // The master should attempt to acquire a permit.
+  AWAIT_READY(acquire);
+
+  // The removal should not occur before the permit is satisfied.
+  Clock::settle();
+  ASSERT_TRUE(slaveLost.isPending());
+
+  // Once the permit is satisfied, the slave should be removed.
+  promise.set(Nothing());
+  AWAIT_READY(slaveLost);
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// This test ensures that slave removals that get scheduled during
+// master recovery can be canceled if the slave re-registers.
+TEST_F(MasterTest, CancelRecoveredSlaveRemoval)
+{
+  // Start a master.
+  master::Flags masterFlags = CreateMasterFlags();
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+
+  // Reuse slaveFlags so both StartSlave() use the same work_dir.
+  slave::Flags slaveFlags = CreateSlaveFlags();
+
+  Try<PID<Slave>> slave = StartSlave(slaveFlags);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // Stop the slave while the master is down.
+  this->Stop(master.get());
+  this->Stop(slave.get());
+
+  shared_ptr<MockRateLimiter> slaveRemovalLimiter(new MockRateLimiter());
+
+  // Return a pending future from the rate limiter.
+  Future<Nothing> acquire;
+  Promise<Nothing> promise;
+  EXPECT_CALL(*slaveRemovalLimiter, acquire())
+    .WillOnce(DoAll(FutureSatisfy(&acquire),
+                    Return(promise.future())));
+
+  // Restart the master.
+  master = StartMaster(slaveRemovalLimiter, masterFlags);
+  ASSERT_SOME(master);
+
+  // Start a scheduler to ensure the master would notify
+  // a framework about slave removal.
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+    &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureSatisfy(&registered));
+
+  Future<Nothing> slaveLost;
+  EXPECT_CALL(sched, slaveLost(&driver, _))
+    .WillRepeatedly(FutureSatisfy(&slaveLost));
+
+  driver.start();
+
+  AWAIT_READY(registered);
+
+  // Trigger the slave re-registration timeout.
+  Clock::pause();
+  Clock::advance(masterFlags.slave_reregister_timeout);
+
+  // The master should attempt to acquire a permit.
+  AWAIT_READY(acquire);
+
+  // The removal should not occur before the permit is satisfied.
+  Clock::settle();
+  ASSERT_TRUE(slaveLost.isPending());
+
+  // Ignore resource offers from the re-registered slave.
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillRepeatedly(Return());
+
+  Future<SlaveReregisteredMessage> slaveReregisteredMessage =
+    FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), _);
+
+  // Restart the slave.
+  slave = StartSlave(slaveFlags);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveReregisteredMessage);
+
+  // Satisfy the rate limit permit. Ensure a removal does not occur!
+  promise.set(Nothing());
+  Clock::settle();
+  ASSERT_TRUE(slaveLost.isPending());
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// This test ensures that when a slave is recovered from the registry
+// and re-registers with the master, it is *not* removed after the
+// re-registration timeout elapses.
+TEST_F(MasterTest, RecoveredSlaveReregisters)
+{
+  // Step 1: Start a master.
+  master::Flags masterFlags = CreateMasterFlags();
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  // Step 2: Start a slave.
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+
+  // Reuse slaveFlags so both StartSlave() use the same work_dir.
+  slave::Flags slaveFlags = this->CreateSlaveFlags();
+
+  Try<PID<Slave>> slave = StartSlave(slaveFlags);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // Step 3: Stop the slave while the master is down.
+  this->Stop(master.get());
+
+  this->Stop(slave.get());
+
+  // Step 4: Restart the master.
+  master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  // Step 5: Start a scheduler to ensure the master would notify
+  // a framework, were a slave to be lost.
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+    &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureSatisfy(&registered));
+
+  // Ignore all offer related calls. The scheduler might receive
+  // offerRescinded calls because the slave might re-register due to
+  // ping timeout.
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillRepeatedly(Return());
+
+  EXPECT_CALL(sched, offerRescinded(&driver, _))
+    .WillRepeatedly(Return());
+
+  driver.start();
+
+  AWAIT_READY(registered);
+
+  Future<SlaveReregisteredMessage> slaveReregisteredMessage =
+    FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), _);
+
+  slave = StartSlave(slaveFlags);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveReregisteredMessage);
+
+  // Step 6: Advance the clock and make sure the slave is not
+  // removed!
+  Future<Nothing> slaveLost;
+  EXPECT_CALL(sched, slaveLost(&driver, _))
+    .WillRepeatedly(FutureSatisfy(&slaveLost));
+
+  Clock::pause();
+  Clock::advance(masterFlags.slave_reregister_timeout);
+  Clock::settle();
+
+  ASSERT_TRUE(slaveLost.isPending());
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+#ifdef MESOS_HAS_JAVA
+
+class MasterZooKeeperTest : public MesosZooKeeperTest {};
+
+// This test verifies that when the ZooKeeper cluster is lost,
+// master, slave & scheduler all get informed.
+TEST_F(MasterZooKeeperTest, LostZooKeeperCluster)
+{
+  ASSERT_SOME(StartMaster());
+
+  Future<process::Message> slaveRegisteredMessage =
+    FUTURE_MESSAGE(Eq(SlaveRegisteredMessage().GetTypeName()), _, _);
+
+  ASSERT_SOME(StartSlave());
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, stringify(url.get()), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
     .WillRepeatedly(Return()); // Ignore offers.
 
   Future<process::Message> frameworkRegisteredMessage =
@@ -2467,36 +2876,107 @@ TEST_F(MasterTest, OfferTimeout)
 }
 
 
-// Offer should not be rescinded if it's accepted.
-TEST_F(MasterTest, OfferNotRescindedOnceUsed)
+// This test verifies that the offers of a framework with the
+// COMPACT_OFFERS capability that expire at once are rescinded with a
+// single message, and that the driver rescinds each of them.
+TEST_F(MasterTest, OfferTimeoutCompactOffers)
 {
   master::Flags masterFlags = MesosTest::CreateMasterFlags();
   masterFlags.offer_timeout = Seconds(30);
   Try<PID<Master>> master = StartMaster(masterFlags);
   ASSERT_SOME(master);
 
-  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  Future<SlaveRegisteredMessage> slave1RegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+  Try<PID<Slave>> slave1 = StartSlave();
+  ASSERT_SOME(slave1);
 
-  TestContainerizer containerizer(&exec);
+  AWAIT_READY(slave1RegisteredMessage);
 
-  Try<PID<Slave>> slave = StartSlave(&containerizer);
-  ASSERT_SOME(slave);
+  Future<SlaveRegisteredMessage> slave2RegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), Not(slave1.get()));
+  Try<PID<Slave>> slave2 = StartSlave();
+  ASSERT_SOME(slave2);
+
+  AWAIT_READY(slave2RegisteredMessage);
+
+  FrameworkInfo framework = DEFAULT_FRAMEWORK_INFO;
+  framework.add_capabilities()->set_type(
+      FrameworkInfo::Capability::COMPACT_OFFERS);
 
   MockScheduler sched;
   MesosSchedulerDriver driver(
-    &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+    &sched, framework, master.get(), DEFAULT_CREDENTIAL);
 
-  Future<Nothing> registered;
-  EXPECT_CALL(sched, registered(&driver, _, _))
-    .WillOnce(FutureSatisfy(&registered));
+  EXPECT_CALL(sched, registered(&driver, _, _));
 
-  EXPECT_CALL(sched, resourceOffers(_, _))
-    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 1, 1, 64, "*"))
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
     .WillRepeatedly(Return()); // Ignore subsequent offers.
 
-  EXPECT_CALL(exec, registered(_, _, _, _));
+  Future<OfferID> offerRescinded1;
+  Future<OfferID> offerRescinded2;
+  EXPECT_CALL(sched, offerRescinded(&driver, _))
+    .WillOnce(FutureArg<1>(&offerRescinded1))
+    .WillOnce(FutureArg<1>(&offerRescinded2));
 
-  EXPECT_CALL(exec, launchTask(_, _))
+  Future<RescindResourceOfferMessage> rescindResourceOfferMessage =
+    FUTURE_PROTOBUF(RescindResourceOfferMessage(), master.get(), _);
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_EQ(2u, offers.get().size());
+
+  Clock::pause();
+  Clock::advance(masterFlags.offer_timeout.get());
+  Clock::resume();
+
+  AWAIT_READY(rescindResourceOfferMessage);
+  EXPECT_EQ(1, rescindResourceOfferMessage.get().offer_ids_size());
+
+  AWAIT_READY(offerRescinded1);
+  AWAIT_READY(offerRescinded2);
+  EXPECT_FALSE(offerRescinded1.get() == offerRescinded2.get());
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// Offer should not be rescinded if it's accepted.
+TEST_F(MasterTest, OfferNotRescindedOnceUsed)
+{
+  master::Flags masterFlags = MesosTest::CreateMasterFlags();
+  masterFlags.offer_timeout = Seconds(30);
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+    &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureSatisfy(&registered));
+
+  EXPECT_CALL(sched, resourceOffers(_, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 1, 1, 64, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
     .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
 
   Future<TaskStatus> status;
@@ -2938,6 +3418,284 @@ TEST_F(MasterTest, StateSummaryEndpoint)
 }
 
 
+// This test verifies that the state-summary endpoint responds to a
+// conditional request with '304 Not Modified' until the summary
+// changes.
+TEST_F(MasterTest, StateSummaryEndpointNotModified)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  // Wait for the master to finish its recovery, i.e., for its state
+  // to stop changing.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  Future<http::Response> response =
+    http::get(master.get(), "state-summary");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Option<string> etag = response.get().headers.get("ETag");
+  ASSERT_SOME(etag);
+
+  hashmap<string, string> headers;
+  headers["If-None-Match"] = etag.get();
+
+  response = http::get(master.get(), "state-summary", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::NotModified().status, response);
+  EXPECT_TRUE(response.get().body.empty());
+  EXPECT_SOME_EQ(etag.get(), response.get().headers.get("ETag"));
+
+  // Registering a slave changes the summary.
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  response = http::get(master.get(), "state-summary", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  EXPECT_NE(etag, response.get().headers.get("ETag"));
+
+  Shutdown();
+}
+
+
+// This test verifies that the (streamed) state endpoint responds to
+// a conditional request with '304 Not Modified' until the state of
+// the master changes, and that streaming the state does not count as
+// a change.
+TEST_F(MasterTest, StateEndpointNotModified)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  Future<http::Response> response = http::get(master.get(), "state.json");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  ASSERT_SOME(JSON::parse<JSON::Object>(response.get().body));
+
+  Option<string> etag = response.get().headers.get("ETag");
+  ASSERT_SOME(etag);
+
+  hashmap<string, string> headers;
+  headers["If-None-Match"] = etag.get();
+
+  response = http::get(master.get(), "state.json", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::NotModified().status, response);
+  EXPECT_SOME_EQ(etag.get(), response.get().headers.get("ETag"));
+
+  // The other endpoints share the version of the master.
+  response = http::get(master.get(), "tasks.json", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::NotModified().status, response);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  response = http::get(master.get(), "state.json", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  EXPECT_NE(etag, response.get().headers.get("ETag"));
+
+  Shutdown();
+}
+
+
+// This test verifies the filtering and projection query parameters
+// of the tasks.json endpoint.
+TEST_F(MasterTest, TasksEndpointFilters)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave>> slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task;
+  task.set_name("");
+  task.mutable_task_id()->set_value("1");
+  task.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+  task.mutable_resources()->MergeFrom(offers.get()[0].resources());
+  task.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+
+  vector<TaskInfo> tasks;
+  tasks.push_back(task);
+
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .Times(1);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  // Only the requested fields should be included.
+  Future<http::Response> response = http::get(
+      master.get(),
+      "tasks.json",
+      "framework_id=" + frameworkId.get().value() +
+      "&state=TASK_RUNNING&fields=id,state");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> array = parse.get().find<JSON::Array>("tasks");
+  ASSERT_SOME(array);
+  ASSERT_EQ(1u, array.get().values.size());
+
+  JSON::Object expected;
+  expected.values["id"] = "1";
+  expected.values["state"] = "TASK_RUNNING";
+
+  EXPECT_EQ(JSON::Value(expected), array.get().values[0]);
+
+  // None of the tasks should match these filters.
+  hashmap<string, string> queries;
+  queries["state"] = "state=TASK_FINISHED";
+  queries["role"] = "role=unknown";
+  queries["framework_id"] = "framework_id=unknown";
+
+  foreachvalue (const string& query, queries) {
+    response = http::get(master.get(), "tasks.json", query);
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+    parse = JSON::parse<JSON::Object>(response.get().body);
+    ASSERT_SOME(parse);
+    EXPECT_SOME_EQ(JSON::Array(), parse.get().find<JSON::Array>("tasks"));
+  }
+
+  response = http::get(master.get(), "tasks.json", "state=BOGUS");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::BadRequest().status, response);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// This test verifies that the read-only endpoints are served from a
+// snapshot (which is only refreshed once it is older than the
+// snapshot interval) when '--http_snapshot_interval' is set.
+TEST_F(MasterTest, HttpSnapshot)
+{
+  master::Flags flags = CreateMasterFlags();
+  flags.http_snapshot_interval = Seconds(10);
+
+  Try<PID<Master>> master = StartMaster(flags);
+  ASSERT_SOME(master);
+
+  Future<http::Response> response = http::get(master.get(), "slaves");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+  EXPECT_SOME_EQ(JSON::Array(), parse.get().find<JSON::Array>("slaves"));
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // The snapshot is not older than the interval yet, hence the
+  // slave should not be included.
+  response = http::get(master.get(), "state.json");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  EXPECT_SOME_EQ(
+      "application/json",
+      response.get().headers.get("Content-Type"));
+
+  parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+  EXPECT_SOME_EQ(JSON::Array(), parse.get().find<JSON::Array>("slaves"));
+
+  Clock::pause();
+  Clock::advance(flags.http_snapshot_interval.get());
+
+  response = http::get(master.get(), "state.json");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+  Result<JSON::Array> slaves = parse.get().find<JSON::Array>("slaves");
+  ASSERT_SOME(slaves);
+  EXPECT_EQ(1u, slaves.get().values.size());
+
+  // JSONP should be supported by the snapshots as well.
+  response = http::get(master.get(), "tasks.json", "jsonp=callback");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("callback({\"tasks\":[]});", response);
+
+  EXPECT_SOME_EQ(
+      "text/javascript",
+      response.get().headers.get("Content-Type"));
+
+  Clock::resume();
+
+  Shutdown();
+}
+
+
 // This test ensures that the web UI of a framework is included in the
 // state.json endpoint, if provided by the framework.
 TEST_F(MasterTest, FrameworkWebUIUrl)
@@ -2946,42 +3704,113 @@ TEST_F(MasterTest, FrameworkWebUIUrl)
   ASSERT_SOME(master);
 
   FrameworkInfo framework = DEFAULT_FRAMEWORK_INFO;
-  framework.set_webui_url("http://localhost:8080/");
+  framework.set_webui_url("http://localhost:8080/");
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, framework, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureSatisfy(&registered));
+
+  driver.start();
+
+  AWAIT_READY(registered);
+
+  Future<http::Response> masterState = http::get(master.get(), "state.json");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, masterState);
+
+  Try<JSON::Object> masterStateObject =
+    JSON::parse<JSON::Object>(masterState.get().body);
+  ASSERT_SOME(masterStateObject);
+
+  // We need a mutable copy of masterStateObject to use [].
+  JSON::Object masterStateObject_ = masterStateObject.get();
+
+  EXPECT_EQ(1u, masterStateObject_.values.count("frameworks"));
+  JSON::Array frameworks =
+    masterStateObject_.values["frameworks"].as<JSON::Array>();
+
+  EXPECT_EQ(1u, frameworks.values.size());
+  JSON::Object framework_ = frameworks.values.front().as<JSON::Object>();
+
+  EXPECT_EQ(1u, framework_.values.count("webui_url"));
+  JSON::String webui_url =
+    framework_.values["webui_url"].as<JSON::String>();
+
+  EXPECT_EQ("http://localhost:8080/", webui_url.value);
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// This test verifies that a framework with the COMPACT_OFFERS
+// capability gets the attributes of its offers once per distinct
+// set of attributes, and that the driver adds them back to the
+// offers handed to the scheduler.
+TEST_F(MasterTest, CompactOffers)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  slave::Flags flags1 = CreateSlaveFlags();
+  flags1.attributes = "rack:abc;host:1";
+
+  Future<SlaveRegisteredMessage> slave1RegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+  Try<PID<Slave>> slave1 = StartSlave(flags1);
+  ASSERT_SOME(slave1);
+
+  AWAIT_READY(slave1RegisteredMessage);
+
+  slave::Flags flags2 = CreateSlaveFlags();
+  flags2.attributes = flags1.attributes;
+
+  Future<SlaveRegisteredMessage> slave2RegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), Not(slave1.get()));
+  Try<PID<Slave>> slave2 = StartSlave(flags2);
+  ASSERT_SOME(slave2);
+
+  AWAIT_READY(slave2RegisteredMessage);
+
+  FrameworkInfo framework = DEFAULT_FRAMEWORK_INFO;
+  framework.add_capabilities()->set_type(
+      FrameworkInfo::Capability::COMPACT_OFFERS);
 
   MockScheduler sched;
   MesosSchedulerDriver driver(
       &sched, framework, master.get(), DEFAULT_CREDENTIAL);
 
-  Future<Nothing> registered;
-  EXPECT_CALL(sched, registered(&driver, _, _))
-    .WillOnce(FutureSatisfy(&registered));
-
-  driver.start();
-
-  AWAIT_READY(registered);
-
-  Future<http::Response> masterState = http::get(master.get(), "state.json");
-  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, masterState);
-
-  Try<JSON::Object> masterStateObject =
-    JSON::parse<JSON::Object>(masterState.get().body);
-  ASSERT_SOME(masterStateObject);
+  EXPECT_CALL(sched, registered(&driver, _, _));
 
-  // We need a mutable copy of masterStateObject to use [].
-  JSON::Object masterStateObject_ = masterStateObject.get();
+  Future<ResourceOffersMessage> resourceOffersMessage =
+    FUTURE_PROTOBUF(ResourceOffersMessage(), master.get(), _);
 
-  EXPECT_EQ(1u, masterStateObject_.values.count("frameworks"));
-  JSON::Array frameworks =
-    masterStateObject_.values["frameworks"].as<JSON::Array>();
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
 
-  EXPECT_EQ(1u, frameworks.values.size());
-  JSON::Object framework_ = frameworks.values.front().as<JSON::Object>();
+  driver.start();
 
-  EXPECT_EQ(1u, framework_.values.count("webui_url"));
-  JSON::String webui_url =
-    framework_.values["webui_url"].as<JSON::String>();
+  AWAIT_READY(resourceOffersMessage);
+  ASSERT_EQ(2, resourceOffersMessage.get().offers_size());
+  EXPECT_EQ(0, resourceOffersMessage.get().offers(0).attributes_size());
+  EXPECT_EQ(0, resourceOffersMessage.get().offers(1).attributes_size());
+  ASSERT_EQ(1, resourceOffersMessage.get().attributes_size());
+  EXPECT_EQ(2, resourceOffersMessage.get().attributes(0).attributes_size());
+  ASSERT_EQ(2, resourceOffersMessage.get().attributes_indices_size());
+  EXPECT_EQ(0u, resourceOffersMessage.get().attributes_indices(0));
+  EXPECT_EQ(0u, resourceOffersMessage.get().attributes_indices(1));
 
-  EXPECT_EQ("http://localhost:8080/", webui_url.value);
+  AWAIT_READY(offers);
+  ASSERT_EQ(2u, offers.get().size());
+  EXPECT_EQ(2, offers.get()[0].attributes_size());
+  EXPECT_EQ(2, offers.get()[1].attributes_size());
 
   driver.stop();
   driver.join();
@@ -3129,6 +3958,186 @@ TEST_F(MasterTest, TaskLabels)
 }
 
 
+// This test verifies that the master keeps a summary of each status
+// of a task (see 'protobuf::createTaskStatusSummary') for running as
+// well as terminal tasks: the states and timestamps are exposed by
+// the endpoints and the health is reported by reconciliation.
+TEST_F(MasterTest, TaskStatusSummaries)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  vector<TaskInfo> tasks;
+  tasks.push_back(task);
+
+  Future<ExecutorDriver*> execDriver;
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .WillOnce(FutureArg<0>(&execDriver));
+
+  Future<TaskInfo> launchTask;
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(FutureArg<1>(&launchTask));
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(execDriver);
+  AWAIT_READY(launchTask);
+
+  // The statuses sent by the executor carry a message and data which
+  // the master does not keep.
+  TaskStatus running;
+  running.mutable_task_id()->CopyFrom(task.task_id());
+  running.set_state(TASK_RUNNING);
+  running.set_message("running");
+  running.set_data(string(1024 * 1024, 'x'));
+  running.set_healthy(true);
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  Future<Nothing> _statusUpdateAcknowledgement =
+    FUTURE_DISPATCH(slave.get(), &Slave::_statusUpdateAcknowledgement);
+
+  execDriver.get()->sendStatusUpdate(running);
+
+  // The scheduler gets the entire status.
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+  EXPECT_EQ(running.data(), status.get().data());
+
+  AWAIT_READY(_statusUpdateAcknowledgement);
+
+  const double runningTimestamp = status.get().timestamp();
+
+  Future<http::Response> response = http::get(master.get(), "state.json");
+  AWAIT_READY(response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> statuses =
+    parse.get().find<JSON::Array>("frameworks[0].tasks[0].statuses");
+  ASSERT_SOME(statuses);
+  EXPECT_EQ(1u, statuses.get().values.size());
+
+  EXPECT_SOME_EQ(
+      JSON::String("TASK_RUNNING"),
+      parse.get().find<JSON::String>(
+          "frameworks[0].tasks[0].statuses[0].state"));
+
+  Result<JSON::Number> timestamp = parse.get().find<JSON::Number>(
+      "frameworks[0].tasks[0].statuses[0].timestamp");
+  ASSERT_SOME(timestamp);
+  EXPECT_NEAR(runningTimestamp, timestamp.get().value, 0.001);
+
+  // The health of the running task is kept in its summary.
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.reconcileTasks(vector<TaskStatus>());
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+  EXPECT_EQ(TaskStatus::REASON_RECONCILIATION, status.get().reason());
+  ASSERT_TRUE(status.get().has_healthy());
+  EXPECT_TRUE(status.get().healthy());
+
+  TaskStatus finished = running;
+  finished.set_state(TASK_FINISHED);
+  finished.set_message("finished");
+  finished.set_healthy(false);
+
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  _statusUpdateAcknowledgement =
+    FUTURE_DISPATCH(slave.get(), &Slave::_statusUpdateAcknowledgement);
+
+  execDriver.get()->sendStatusUpdate(finished);
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_FINISHED, status.get().state());
+  EXPECT_EQ(finished.data(), status.get().data());
+
+  // Once acknowledged the terminal task is moved to the completed
+  // tasks of the framework, with the summaries of both statuses.
+  AWAIT_READY(_statusUpdateAcknowledgement);
+
+  const double finishedTimestamp = status.get().timestamp();
+
+  response = http::get(master.get(), "state.json");
+  AWAIT_READY(response);
+
+  parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> runningTasks =
+    parse.get().find<JSON::Array>("frameworks[0].tasks");
+  ASSERT_SOME(runningTasks);
+  EXPECT_TRUE(runningTasks.get().values.empty());
+
+  statuses = parse.get().find<JSON::Array>(
+      "frameworks[0].completed_tasks[0].statuses");
+  ASSERT_SOME(statuses);
+  EXPECT_EQ(2u, statuses.get().values.size());
+
+  EXPECT_SOME_EQ(
+      JSON::String("TASK_RUNNING"),
+      parse.get().find<JSON::String>(
+          "frameworks[0].completed_tasks[0].statuses[0].state"));
+
+  timestamp = parse.get().find<JSON::Number>(
+      "frameworks[0].completed_tasks[0].statuses[0].timestamp");
+  ASSERT_SOME(timestamp);
+  EXPECT_NEAR(runningTimestamp, timestamp.get().value, 0.001);
+
+  EXPECT_SOME_EQ(
+      JSON::String("TASK_FINISHED"),
+      parse.get().find<JSON::String>(
+          "frameworks[0].completed_tasks[0].statuses[1].state"));
+
+  timestamp = parse.get().find<JSON::Number>(
+      "frameworks[0].completed_tasks[0].statuses[1].timestamp");
+  ASSERT_SOME(timestamp);
+  EXPECT_NEAR(finishedTimestamp, timestamp.get().value, 0.001);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
 // This tests the 'active' field in slave entries from state.json. We
 // first verify an active slave, deactivate it and verify that the
 // 'active' field is false.
@@ -3498,6 +4507,389 @@ TEST_F(MasterTest, MasterFailoverLongLivedExecutor)
   Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
 }
 
+
+// A lightweight stand-in for a slave, which only speaks the slave's
+// side of the master protocol: it (re-)registers, answers pings and
+// reports the tasks it gets as running (and finished when asked to).
+class FakeSlave : public ProtobufProcess<FakeSlave>
+{
+public:
+  FakeSlave(const UPID& _master, const SlaveInfo& _info)
+    : ProcessBase(process::ID::generate("fake-slave")),
+      master(_master),
+      info(_info) {}
+
+  Future<Nothing> registered() { return registered_.future(); }
+  Future<Nothing> reregistered() { return reregistered_.future(); }
+
+  void reregister(const UPID& _master)
+  {
+    master = _master;
+
+    ReregisterSlaveMessage message;
+    message.set_version(MESOS_VERSION);
+    message.mutable_slave()->CopyFrom(info);
+    send(master, message);
+  }
+
+  // Reports all the tasks of the slave as finished.
+  void finishTasks()
+  {
+    foreach (const Task& task, tasks) {
+      update(task.framework_id(), task.task_id(), TASK_FINISHED);
+    }
+
+    tasks.clear();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    install<SlaveRegisteredMessage>(
+        &FakeSlave::_registered,
+        &SlaveRegisteredMessage::slave_id);
+
+    install<SlaveReregisteredMessage>(&FakeSlave::_reregistered);
+
+    install<PingSlaveMessage>(
+        &FakeSlave::ping,
+        &PingSlaveMessage::connected);
+
+    install<RunTaskMessage>(
+        &FakeSlave::runTask,
+        &RunTaskMessage::framework,
+        &RunTaskMessage::task);
+
+    RegisterSlaveMessage message;
+    message.set_version(MESOS_VERSION);
+    message.mutable_slave()->CopyFrom(info);
+    send(master, message);
+  }
+
+private:
+  void _registered(const SlaveID& slaveId)
+  {
+    info.mutable_id()->CopyFrom(slaveId);
+    registered_.set(Nothing());
+  }
+
+  void _reregistered(const SlaveReregisteredMessage&)
+  {
+    reregistered_.set(Nothing());
+  }
+
+  void ping(const UPID& from, bool)
+  {
+    send(from, PongSlaveMessage());
+  }
+
+  void runTask(const FrameworkInfo& frameworkInfo, const TaskInfo& taskInfo)
+  {
+    tasks.push_back(protobuf::createTask(
+        taskInfo, TASK_RUNNING, frameworkInfo.id()));
+
+    update(frameworkInfo.id(), taskInfo.task_id(), TASK_RUNNING);
+  }
+
+  void update(
+      const FrameworkID& frameworkId,
+      const TaskID& taskId,
+      const TaskState& state)
+  {
+    StatusUpdateMessage message;
+    message.mutable_update()->CopyFrom(protobuf::createStatusUpdate(
+        frameworkId,
+        info.id(),
+        taskId,
+        state,
+        TaskStatus::SOURCE_SLAVE));
+    message.set_pid(self());
+
+    send(master, message);
+  }
+
+  UPID master;
+  SlaveInfo info;
+  list<Task> tasks;
+
+  Promise<Nothing> registered_;
+  Promise<Nothing> reregistered_;
+};
+
+
+// A lightweight stand-in for a scheduler (and its driver), which
+// launches as many tasks as the offers it gets fit until it launched
+// the given number of tasks, and acknowledges the status updates.
+class FakeScheduler : public ProtobufProcess<FakeScheduler>
+{
+public:
+  FakeScheduler(const UPID& _master, const string& name, size_t _tasks)
+    : ProcessBase(process::ID::generate("fake-scheduler")),
+      master(_master),
+      tasks(_tasks),
+      launched(0),
+      running(0),
+      finished(0)
+  {
+    info.set_user("user");
+    info.set_name(name);
+  }
+
+  Future<Nothing> registered() { return registered_.future(); }
+  Future<Nothing> allRunning() { return allRunning_.future(); }
+  Future<Nothing> allFinished() { return allFinished_.future(); }
+
+protected:
+  virtual void initialize()
+  {
+    install<FrameworkRegisteredMessage>(
+        &FakeScheduler::_registered,
+        &FrameworkRegisteredMessage::framework_id);
+
+    install<ResourceOffersMessage>(&FakeScheduler::resourceOffers);
+
+    install<StatusUpdateMessage>(
+        &FakeScheduler::statusUpdate,
+        &StatusUpdateMessage::update);
+
+    RegisterFrameworkMessage message;
+    message.mutable_framework()->CopyFrom(info);
+    send(master, message);
+  }
+
+private:
+  void _registered(const FrameworkID& frameworkId)
+  {
+    info.mutable_id()->CopyFrom(frameworkId);
+    registered_.set(Nothing());
+  }
+
+  void resourceOffers(const ResourceOffersMessage& offers)
+  {
+    const Resources resources =
+      Resources::parse("cpus:1;mem:128").get();
+
+    foreach (const Offer& offer, protobuf::getOffers(offers)) {
+      LaunchTasksMessage message;
+      message.mutable_framework_id()->CopyFrom(info.id());
+      message.add_offer_ids()->CopyFrom(offer.id());
+
+      Resources remaining = offer.resources();
+      while (launched < tasks && remaining.contains(resources)) {
+        TaskInfo* task = message.add_tasks();
+        task->set_name("task");
+        task->mutable_task_id()->set_value(stringify(launched++));
+        task->mutable_slave_id()->CopyFrom(offer.slave_id());
+        task->mutable_resources()->CopyFrom(resources);
+        task->mutable_command()->set_value("sleep 1000");
+
+        remaining -= resources;
+      }
+
+      // Decline the offers that are of no use for good.
+      if (message.tasks_size() == 0) {
+        message.mutable_filters()->set_refuse_seconds(Days(1).secs());
+      } else {
+        message.mutable_filters()->CopyFrom(Filters());
+      }
+
+      send(master, message);
+    }
+  }
+
+  void statusUpdate(const StatusUpdate& update)
+  {
+    if (update.status().state() == TASK_RUNNING && ++running == tasks) {
+      allRunning_.set(Nothing());
+    } else if (update.status().state() == TASK_FINISHED &&
+               ++finished == tasks) {
+      allFinished_.set(Nothing());
+    }
+
+    StatusUpdateAcknowledgementMessage message;
+    message.mutable_framework_id()->CopyFrom(info.id());
+    message.mutable_slave_id()->CopyFrom(update.slave_id());
+    message.mutable_task_id()->CopyFrom(update.status().task_id());
+    message.set_uuid(update.uuid());
+    send(master, message);
+  }
+
+  const UPID master;
+  FrameworkInfo info;
+
+  const size_t tasks;
+  size_t launched;
+  size_t running;
+  size_t finished;
+
+  Promise<Nothing> registered_;
+  Promise<Nothing> allRunning_;
+  Promise<Nothing> allFinished_;
+};
+
+
+class Master_BENCHMARK_Test : public MesosTest,
+                              public WithParamInterface<pair<size_t, size_t>>
+{};
+
+
+// The master benchmark tests are parameterized by the number of
+// slaves and the number of frameworks.
+INSTANTIATE_TEST_CASE_P(
+    SlaveAndFrameworkCount,
+    Master_BENCHMARK_Test,
+    ::testing::Values(
+        std::make_pair(1000U, 10U),
+        std::make_pair(5000U, 100U),
+        std::make_pair(10000U, 1000U)));
+
+
+// This benchmark measures how long a real master takes to register
+// all the (fake) slaves at once, to launch tasks on all of them
+// (until the frameworks got all the TASK_RUNNING updates), to serve
+// 'state.json' with all the tasks running, to get the tasks finished
+// (until the frameworks got all the TASK_FINISHED updates) and to get
+// all the slaves re-registered after a failover. The measurements are
+// also recorded as properties of the test, see the 'bench' target.
+TEST_P(Master_BENCHMARK_Test, Throughput)
+{
+  const size_t slaveCount = GetParam().first;
+  const size_t frameworkCount = GetParam().second;
+  const size_t tasksPerFramework = slaveCount * 4 / frameworkCount;
+
+  // Nothing is of interest for more than the duration of the test.
+  const Duration timeout = Minutes(10);
+
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.authenticate_frameworks = false;
+  masterFlags.authenticate_slaves = false;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  SlaveInfo info;
+  info.set_hostname("localhost");
+  info.mutable_resources()->CopyFrom(
+      Resources::parse("cpus:16;mem:4096;disk:4096").get());
+
+  Stopwatch watch;
+  watch.start();
+
+  vector<FakeSlave*> slaves;
+  list<Future<Nothing>> futures;
+  for (size_t i = 0; i < slaveCount; i++) {
+    FakeSlave* slave = new FakeSlave(master.get(), info);
+    futures.push_back(slave->registered());
+    process::spawn(slave);
+    slaves.push_back(slave);
+  }
+
+  AWAIT_READY_FOR(process::collect(futures), timeout);
+
+  Duration elapsed = watch.elapsed();
+  LOG(INFO) << "Registered " << slaveCount << " slaves in " << elapsed;
+  RecordProperty("slave_registration_ms", stringify(elapsed.ms()));
+
+  vector<FakeScheduler*> schedulers;
+  list<Future<Nothing>> registered;
+  list<Future<Nothing>> running;
+  list<Future<Nothing>> finished;
+  for (size_t i = 0; i < frameworkCount; i++) {
+    FakeScheduler* scheduler = new FakeScheduler(
+        master.get(), "framework" + stringify(i), tasksPerFramework);
+
+    registered.push_back(scheduler->registered());
+    running.push_back(scheduler->allRunning());
+    finished.push_back(scheduler->allFinished());
+
+    process::spawn(scheduler);
+    schedulers.push_back(scheduler);
+  }
+
+  watch.start();
+
+  AWAIT_READY_FOR(process::collect(registered), timeout);
+
+  elapsed = watch.elapsed();
+  LOG(INFO) << "Registered " << frameworkCount << " frameworks in "
+            << elapsed;
+  RecordProperty("framework_registration_ms", stringify(elapsed.ms()));
+
+  AWAIT_READY_FOR(process::collect(running), timeout);
+
+  elapsed = watch.elapsed();
+  LOG(INFO) << "Launched " << frameworkCount * tasksPerFramework
+            << " tasks in " << elapsed << " ("
+            << frameworkCount * tasksPerFramework / elapsed.secs()
+            << " tasks/sec)";
+  RecordProperty(
+      "task_launches_per_sec",
+      stringify(frameworkCount * tasksPerFramework / elapsed.secs()));
+
+  watch.start();
+
+  Future<http::Response> state = http::get(master.get(), "state.json");
+  AWAIT_READY_FOR(state, timeout);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, state);
+
+  elapsed = watch.elapsed();
+  LOG(INFO) << "Served state.json of " << state.get().body.size()
+            << " bytes in " << elapsed;
+  RecordProperty("state_json_ms", stringify(elapsed.ms()));
+
+  watch.start();
+
+  foreach (FakeSlave* slave, slaves) {
+    process::dispatch(slave, &FakeSlave::finishTasks);
+  }
+
+  AWAIT_READY_FOR(process::collect(finished), timeout);
+
+  elapsed = watch.elapsed();
+  LOG(INFO) << "Finished " << frameworkCount * tasksPerFramework
+            << " tasks in " << elapsed << " ("
+            << frameworkCount * tasksPerFramework / elapsed.secs()
+            << " status updates/sec)";
+  RecordProperty(
+      "status_updates_per_sec",
+      stringify(frameworkCount * tasksPerFramework / elapsed.secs()));
+
+  // Fail over the master, which recovers the slaves from the registry.
+  Stop(master.get());
+
+  watch.start();
+
+  master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  futures.clear();
+  foreach (FakeSlave* slave, slaves) {
+    futures.push_back(slave->reregistered());
+    process::dispatch(slave, &FakeSlave::reregister, master.get());
+  }
+
+  AWAIT_READY_FOR(process::collect(futures), timeout);
+
+  elapsed = watch.elapsed();
+  LOG(INFO) << "Re-registered " << slaveCount << " slaves after a failover in "
+            << elapsed;
+  RecordProperty("slave_reregistration_ms", stringify(elapsed.ms()));
+
+  foreach (FakeScheduler* scheduler, schedulers) {
+    process::terminate(scheduler);
+    process::wait(scheduler);
+    delete scheduler;
+  }
+
+  foreach (FakeSlave* slave, slaves) {
+    process::terminate(slave);
+    process::wait(slave);
+    delete slave;
+  }
+
+  Shutdown();
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -332,6 +332,37 @@ Try<PID<slave::Slave>> MesosTest::StartSlave(
 }
 
 
+Try<PID<slave::Slave>> MesosTest::StartSlave(
+    mesos::slave::QoSController* qosController,
+    const Option<slave::Flags>& flags)
+{
+  return cluster.slaves.start(
+      flags.isNone() ? CreateSlaveFlags() : flags.get(),
+      None(),
+      None(),
+      None(),
+      None(),
+      None(),
+      qosController);
+}
+
+
+Try<PID<slave::Slave>> MesosTest::StartSlave(
+    mesos::slave::ResourceEstimator* resourceEstimator,
+    mesos::slave::QoSController* qosController,
+    const Option<slave::Flags>& flags)
+{
+  return cluster.slaves.start(
+      flags.isNone() ? CreateSlaveFlags() : flags.get(),
+      None(),
+      None(),
+      None(),
+      None(),
+      resourceEstimator,
+      qosController);
+}
+
+
 void MesosTest::Stop(const PID<master::Master>& pid)
 {
   cluster.masters.stop(pid);
@@ -383,7 +414,8 @@ MockSlave::MockSlave(const slave::Flags& flags,
       &files,
       &gc,
       statusUpdateManager = new slave::StatusUpdateManager(flags),
-      &resourceEstimator)
+      &resourceEstimator,
+      &qosController)
 {
   // Set up default behaviors, calling the original methods.
   EXPECT_CALL(*this, runTask(_, _, _, _, _))
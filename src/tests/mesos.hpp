@@ -32,6 +32,7 @@
 
 #include <mesos/fetcher/fetcher.hpp>
 
+#include <mesos/slave/qos_controller.hpp>
 #include <mesos/slave/resource_estimator.hpp>
 
 #include <process/future.hpp>
@@ -184,6 +185,18 @@ protected:
       mesos::slave::ResourceEstimator* resourceEstimator,
       const Option<slave::Flags>& flags = None());
 
+  // Starts a slave with the specified QoS Controller and flags.
+  virtual Try<process::PID<slave::Slave>> StartSlave(
+      mesos::slave::QoSController* qosController,
+      const Option<slave::Flags>& flags = None());
+
+  // Starts a slave with the specified resource estimator, QoS
+  // Controller and flags.
+  virtual Try<process::PID<slave::Slave>> StartSlave(
+      mesos::slave::ResourceEstimator* resourceEstimator,
+      mesos::slave::QoSController* qosController,
+      const Option<slave::Flags>& flags = None());
+
   // Stop the specified master.
   virtual void Stop(
       const process::PID<master::Master>& pid);
@@ -740,6 +753,37 @@ public:
 };
 
 
+class MockQoSController : public mesos::slave::QoSController
+{
+public:
+  MockQoSController()
+  {
+    ON_CALL(*this, initialize(_))
+      .WillByDefault(Return(Nothing()));
+    EXPECT_CALL(*this, initialize(_))
+      .WillRepeatedly(DoDefault());
+
+    ON_CALL(*this, corrections())
+      .WillByDefault(
+          Return(process::Future<std::list<mesos::slave::QoSCorrection>>()));
+    EXPECT_CALL(*this, corrections())
+      .WillRepeatedly(DoDefault());
+  }
+
+  virtual ~MockQoSController() {}
+
+  MOCK_METHOD1(
+      initialize,
+      Try<Nothing>(
+          const lambda::function<
+              process::Future<std::list<ResourceUsage>>()>&));
+
+  MOCK_METHOD0(
+      corrections,
+      process::Future<std::list<mesos::slave::QoSCorrection>>());
+};
+
+
 // Definition of a mock Slave to be used in tests with gmock, covering
 // potential races between runTask and killTask.
 class MockSlave : public slave::Slave
@@ -804,6 +848,7 @@ private:
   Files files;
   MockGarbageCollector gc;
   MockResourceEstimator resourceEstimator;
+  MockQoSController qosController;
   slave::StatusUpdateManager* statusUpdateManager;
 };
 
@@ -987,6 +1032,12 @@ ACTION_P(InvokeReviveOffers, allocator)
 }
 
 
+ACTION_P(InvokeSuppressOffers, allocator)
+{
+  allocator->real->suppressOffers(arg0);
+}
+
+
 template <typename T = master::allocator::HierarchicalDRFAllocator>
 mesos::master::allocator::Allocator* createAllocator()
 {
@@ -1088,6 +1139,11 @@ public:
       .WillByDefault(InvokeReviveOffers(this));
     EXPECT_CALL(*this, reviveOffers(_))
       .WillRepeatedly(DoDefault());
+
+    ON_CALL(*this, suppressOffers(_))
+      .WillByDefault(InvokeSuppressOffers(this));
+    EXPECT_CALL(*this, suppressOffers(_))
+      .WillRepeatedly(DoDefault());
   }
 
   virtual ~TestAllocator() {}
@@ -1152,6 +1208,8 @@ public:
 
   MOCK_METHOD1(reviveOffers, void(const FrameworkID&));
 
+  MOCK_METHOD1(suppressOffers, void(const FrameworkID&));
+
   process::Owned<mesos::master::allocator::Allocator> real;
 };
 
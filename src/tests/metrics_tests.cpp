@@ -91,12 +91,16 @@ TEST_F(MetricsTest, Master)
   EXPECT_EQ(1u, stats.values.count("master/messages_unregister_framework"));
   EXPECT_EQ(1u, stats.values.count("master/messages_deactivate_framework"));
   EXPECT_EQ(1u, stats.values.count("master/messages_kill_task"));
+  EXPECT_EQ(1u, stats.values.count("master/messages_kill_tasks"));
   EXPECT_EQ(1u, stats.values.count(
       "master/messages_status_update_acknowledgement"));
+  EXPECT_EQ(1u, stats.values.count(
+      "master/messages_status_update_acknowledgements"));
   EXPECT_EQ(1u, stats.values.count("master/messages_resource_request"));
   EXPECT_EQ(1u, stats.values.count("master/messages_launch_tasks"));
   EXPECT_EQ(1u, stats.values.count("master/messages_decline_offers"));
   EXPECT_EQ(1u, stats.values.count("master/messages_revive_offers"));
+  EXPECT_EQ(1u, stats.values.count("master/messages_suppress_offers"));
   EXPECT_EQ(1u, stats.values.count("master/messages_reconcile_tasks"));
   EXPECT_EQ(1u, stats.values.count("master/messages_framework_to_executor"));
 
@@ -194,6 +198,7 @@ TEST_F(MetricsTest, Slave)
   EXPECT_EQ(1u, stats.values.count("slave/executors_running"));
   EXPECT_EQ(1u, stats.values.count("slave/executors_terminating"));
   EXPECT_EQ(1u, stats.values.count("slave/executors_terminated"));
+  EXPECT_EQ(1u, stats.values.count("slave/executors_preempted"));
 
   EXPECT_EQ(1u, stats.values.count("slave/valid_status_updates"));
   EXPECT_EQ(1u, stats.values.count("slave/invalid_status_updates"));
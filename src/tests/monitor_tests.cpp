@@ -31,6 +31,7 @@
 #include <process/pid.hpp>
 #include <process/process.hpp>
 
+#include <stout/json.hpp>
 #include <stout/nothing.hpp>
 
 #include "slave/constants.hpp"
@@ -234,6 +235,149 @@ TEST(MonitorTest, UsageFailure)
   AWAIT_EXPECT_RESPONSE_BODY_EQ("[]", response);
 }
 
+
+// This test verifies that the monitor samples the usage of monitored
+// containers and exports windowed rates and percentiles.
+TEST(MonitorTest, History)
+{
+  ResourceStatistics statistics1;
+  statistics1.set_timestamp(0);
+  statistics1.set_cpus_user_time_secs(0);
+  statistics1.set_cpus_system_time_secs(0);
+  statistics1.set_mem_rss_bytes(1024);
+
+  ResourceStatistics statistics2 = statistics1;
+  statistics2.set_timestamp(1);
+  statistics2.set_cpus_user_time_secs(0.5);
+
+  ResourceStatistics statistics3 = statistics2;
+  statistics3.set_timestamp(2);
+  statistics3.set_cpus_user_time_secs(1);
+  statistics3.set_cpus_system_time_secs(0.5);
+
+  TestContainerizer containerizer;
+
+  EXPECT_CALL(containerizer, usage(DEFAULT_CONTAINER_ID))
+    .WillOnce(Return(statistics1))
+    .WillOnce(Return(statistics2))
+    .WillRepeatedly(Return(statistics3));
+
+  // Pause the clock so that samples are only taken when we advance it.
+  Clock::pause();
+
+  slave::ResourceMonitor monitor(&containerizer, Seconds(1), Minutes(1));
+
+  AWAIT_READY(monitor.start(DEFAULT_CONTAINER_ID, DEFAULT_EXECUTOR_INFO));
+
+  for (int i = 0; i < 3; i++) {
+    Clock::advance(Seconds(1));
+    Clock::settle();
+  }
+
+  process::UPID upid("monitor", process::address());
+
+  Future<Response> response = process::http::get(upid, "history.json");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Array> parse = JSON::parse<JSON::Array>(response.get().body);
+  ASSERT_SOME(parse);
+  ASSERT_EQ(1u, parse.get().values.size());
+
+  const JSON::Object& entry = parse.get().values.front().as<JSON::Object>();
+
+  EXPECT_SOME_EQ(3u, entry.find<JSON::Number>("history.samples"));
+  EXPECT_SOME_EQ(2.0, entry.find<JSON::Number>("history.duration_secs"));
+  EXPECT_SOME_EQ(0.75, entry.find<JSON::Number>("history.cpus_usage_rate"));
+  EXPECT_SOME_EQ(0.5, entry.find<JSON::Number>("history.cpus_usage.min"));
+  EXPECT_SOME_EQ(1.0, entry.find<JSON::Number>("history.cpus_usage.max"));
+  EXPECT_SOME_EQ(1024, entry.find<JSON::Number>("history.mem_rss_bytes.p99"));
+
+  // A window shorter than the sampling interval leaves a single
+  // sample, from which no rates can be computed.
+  response = process::http::get(upid, "history.json", "window=1ns");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  parse = JSON::parse<JSON::Array>(response.get().body);
+  ASSERT_SOME(parse);
+  ASSERT_EQ(1u, parse.get().values.size());
+
+  EXPECT_NONE(parse.get().values.front().as<JSON::Object>()
+                .find<JSON::Number>("history.cpus_usage"));
+
+  Clock::resume();
+}
+
+
+// This test verifies that subscribers of the stream endpoint receive
+// the usage of monitored containers, and its change since the
+// previous sample, once per sampling interval.
+TEST(MonitorTest, Stream)
+{
+  ResourceStatistics statistics1;
+  statistics1.set_timestamp(0);
+  statistics1.set_cpus_user_time_secs(0);
+  statistics1.set_cpus_system_time_secs(0);
+
+  ResourceStatistics statistics2 = statistics1;
+  statistics2.set_timestamp(1);
+  statistics2.set_cpus_user_time_secs(0.5);
+
+  TestContainerizer containerizer;
+
+  EXPECT_CALL(containerizer, usage(DEFAULT_CONTAINER_ID))
+    .WillOnce(Return(statistics1))
+    .WillRepeatedly(Return(statistics2));
+
+  Clock::pause();
+
+  slave::ResourceMonitor monitor(&containerizer, Seconds(1));
+
+  AWAIT_READY(monitor.start(DEFAULT_CONTAINER_ID, DEFAULT_EXECUTOR_INFO));
+
+  process::UPID upid("monitor", process::address());
+
+  Future<Response> response =
+    process::http::streaming::get(upid, "stream.json");
+
+  AWAIT_READY(response);
+  ASSERT_EQ(Response::PIPE, response.get().type);
+  ASSERT_SOME(response.get().reader);
+
+  process::http::Pipe::Reader reader = response.get().reader.get();
+
+  // The first sample is taken as soon as somebody subscribes.
+  Future<string> read = reader.read();
+  AWAIT_READY(read);
+
+  Try<JSON::Array> parse = JSON::parse<JSON::Array>(read.get());
+  ASSERT_SOME(parse);
+  ASSERT_EQ(1u, parse.get().values.size());
+
+  EXPECT_NONE(parse.get().values.front().as<JSON::Object>()
+                .find<JSON::Object>("delta"));
+
+  read = reader.read();
+
+  Clock::advance(Seconds(1));
+
+  AWAIT_READY(read);
+
+  parse = JSON::parse<JSON::Array>(read.get());
+  ASSERT_SOME(parse);
+  ASSERT_EQ(1u, parse.get().values.size());
+
+  const JSON::Object& entry = parse.get().values.front().as<JSON::Object>();
+
+  EXPECT_SOME_EQ(1.0, entry.find<JSON::Number>("delta.duration_secs"));
+  EXPECT_SOME_EQ(0.5, entry.find<JSON::Number>("delta.cpus_user_time_secs"));
+
+  EXPECT_TRUE(reader.close());
+
+  Clock::resume();
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
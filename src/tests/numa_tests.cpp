@@ -0,0 +1,83 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+#include <set>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+
+#include "linux/numa.hpp"
+
+using std::map;
+using std::set;
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+TEST(NumaTest, Parse)
+{
+  Try<set<int>> cpus = numa::parse("0-3,8,10-11\n");
+  ASSERT_SOME(cpus);
+
+  set<int> expected = {0, 1, 2, 3, 8, 10, 11};
+  EXPECT_EQ(expected, cpus.get());
+
+  cpus = numa::parse("");
+  ASSERT_SOME(cpus);
+  EXPECT_TRUE(cpus.get().empty());
+
+  EXPECT_ERROR(numa::parse("3-1"));
+  EXPECT_ERROR(numa::parse("0-1-2"));
+  EXPECT_ERROR(numa::parse("a"));
+}
+
+
+TEST(NumaTest, Format)
+{
+  EXPECT_EQ("0-3,8,10-11", numa::format({0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_EQ("5", numa::format({5}));
+  EXPECT_EQ("", numa::format(set<int>()));
+}
+
+
+TEST(NumaTest, Nodes)
+{
+  Try<map<int, set<int>>> nodes = numa::nodes();
+  ASSERT_SOME(nodes);
+  ASSERT_FALSE(nodes.get().empty());
+
+  // Every node has cpus and no cpu belongs to more than one node.
+  set<int> cpus;
+  foreachvalue (const set<int>& _cpus, nodes.get()) {
+    EXPECT_FALSE(_cpus.empty());
+
+    foreach (int cpu, _cpus) {
+      EXPECT_TRUE(cpus.insert(cpu).second);
+    }
+  }
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
@@ -16,6 +16,7 @@
  * limitations under the License.
  */
 
+#include <list>
 #include <string>
 #include <vector>
 
@@ -38,6 +39,10 @@
 #include "slave/flags.hpp"
 #include "slave/slave.hpp"
 
+#include "slave/qos_controllers/interference.hpp"
+
+#include "slave/resource_estimators/usage.hpp"
+
 #include "tests/mesos.hpp"
 #include "tests/utils.hpp"
 
@@ -45,8 +50,13 @@ using namespace process;
 
 using mesos::internal::master::Master;
 
+using mesos::internal::slave::InterferenceQoSController;
 using mesos::internal::slave::Slave;
+using mesos::internal::slave::UsageResourceEstimator;
 
+using mesos::slave::QoSCorrection;
+
+using std::list;
 using std::string;
 using std::vector;
 
@@ -291,6 +301,221 @@ TEST_F(OversubscriptionTest, RescindRevocableOffer)
   Shutdown();
 }
 
+
+// This test verifies that the usage based resource estimator reports
+// the part of an executor's allocation it has not used within the
+// window as oversubscribable.
+TEST_F(OversubscriptionTest, UsageResourceEstimator)
+{
+  ExecutorInfo executorInfo = DEFAULT_EXECUTOR_INFO;
+  executorInfo.mutable_framework_id()->set_value("framework");
+
+  ResourceUsage usage;
+  usage.mutable_executor_info()->CopyFrom(executorInfo);
+
+  ResourceStatistics* statistics = usage.mutable_statistics();
+  statistics->set_timestamp(0);
+  statistics->set_cpus_limit(2);
+  statistics->set_cpus_user_time_secs(0);
+  statistics->set_cpus_system_time_secs(0);
+  statistics->set_mem_limit_bytes(Megabytes(1024).bytes());
+  statistics->set_mem_rss_bytes(Megabytes(256).bytes());
+
+  Clock::pause();
+
+  UsageResourceEstimator resourceEstimator(Seconds(1), Minutes(1));
+
+  ASSERT_SOME(resourceEstimator.initialize(
+      [&usage]() -> Future<list<ResourceUsage>> {
+        return list<ResourceUsage>({usage});
+      }));
+
+  Clock::settle();
+
+  // Nothing can be estimated from a single sample.
+  AWAIT_EXPECT_EQ(Resources(), resourceEstimator.oversubscribable());
+
+  // Let the executor use half a cpu over the next samples.
+  for (int i = 1; i <= 3; i++) {
+    statistics->set_timestamp(i);
+    statistics->set_cpus_user_time_secs(0.25 * i);
+    statistics->set_cpus_system_time_secs(0.25 * i);
+
+    Clock::advance(Seconds(1));
+    Clock::settle();
+  }
+
+  AWAIT_EXPECT_EQ(
+      createRevocableResources("cpus", "1.5") +
+        createRevocableResources("mem", "768"),
+      resourceEstimator.oversubscribable());
+
+  Clock::resume();
+}
+
+
+// This test verifies that the slave kills a revocable executor when
+// the QoS controller asks for it, and that its tasks are reported as
+// lost due to preemption.
+TEST_F(OversubscriptionTest, QoSCorrectionKill)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockResourceEstimator resourceEstimator;
+
+  EXPECT_CALL(resourceEstimator, initialize(_));
+
+  Queue<Resources> estimations;
+  EXPECT_CALL(resourceEstimator, oversubscribable())
+    .WillOnce(Invoke(&estimations, &Queue<Resources>::get))
+    .WillRepeatedly(Return(Future<Resources>()));
+
+  MockQoSController controller;
+
+  EXPECT_CALL(controller, initialize(_));
+
+  Queue<list<QoSCorrection>> corrections;
+  EXPECT_CALL(controller, corrections())
+    .WillOnce(Invoke(&corrections, &Queue<list<QoSCorrection>>::get))
+    .WillRepeatedly(Return(Future<list<QoSCorrection>>()));
+
+  slave::Flags flags = CreateSlaveFlags();
+
+  Try<PID<Slave>> slave = StartSlave(&resourceEstimator, &controller, flags);
+  ASSERT_SOME(slave);
+
+  FrameworkInfo framework = DEFAULT_FRAMEWORK_INFO;
+  framework.add_capabilities()->set_type(
+      FrameworkInfo::Capability::REVOCABLE_RESOURCES);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, framework, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  Future<vector<Offer>> offers1;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers1));
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+  AWAIT_READY(offers1);
+
+  Future<vector<Offer>> offers2;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers2))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Resources resources =
+    createRevocableResources("cpus", "1") +
+    createRevocableResources("mem", "32");
+
+  estimations.put(resources);
+
+  AWAIT_READY(offers2);
+  EXPECT_NE(0u, offers2.get().size());
+  EXPECT_EQ(resources, Resources(offers2.get()[0].resources()));
+
+  TaskInfo task = createTask(offers2.get()[0], "sleep 1000");
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  driver.launchTasks(offers2.get()[0].id(), {task});
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1.get().state());
+
+  // The command executor has the same id as its task.
+  QoSCorrection correction;
+  correction.set_type(QoSCorrection::KILL);
+  correction.mutable_kill()->mutable_framework_id()->CopyFrom(
+      frameworkId.get());
+  correction.mutable_kill()->mutable_executor_id()->set_value(
+      task.task_id().value());
+
+  corrections.put({correction});
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_LOST, status2.get().state());
+  EXPECT_EQ(TaskStatus::REASON_EXECUTOR_PREEMPTED, status2.get().reason());
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// This test verifies that the interference QoS controller asks to
+// kill the revocable executor when the cycles per instruction of a
+// non-revocable executor rise above its baseline.
+TEST_F(OversubscriptionTest, InterferenceQoSController)
+{
+  ResourceUsage regular;
+  regular.mutable_executor_info()->CopyFrom(DEFAULT_EXECUTOR_INFO);
+  regular.mutable_executor_info()->mutable_framework_id()->set_value("1");
+  regular.mutable_allocated()->CopyFrom(Resources::parse("cpus:1").get());
+
+  ResourceStatistics* statistics = regular.mutable_statistics();
+  statistics->set_timestamp(0);
+  statistics->mutable_perf()->set_timestamp(0);
+  statistics->mutable_perf()->set_duration(1);
+  statistics->mutable_perf()->set_cycles(1000);
+  statistics->mutable_perf()->set_instructions(1000);
+
+  ResourceUsage revocable;
+  revocable.mutable_executor_info()->CopyFrom(
+      CREATE_EXECUTOR_INFO("revocable", "exit 1"));
+  revocable.mutable_executor_info()->mutable_framework_id()->set_value("2");
+  revocable.mutable_allocated()->CopyFrom(
+      createRevocableResources("cpus", "1"));
+  revocable.mutable_statistics()->set_timestamp(0);
+
+  Clock::pause();
+
+  InterferenceQoSController controller(Seconds(1), Minutes(1), 1.5);
+
+  ASSERT_SOME(controller.initialize(
+      [&regular, &revocable]() -> Future<list<ResourceUsage>> {
+        return list<ResourceUsage>({regular, revocable});
+      }));
+
+  Future<list<QoSCorrection>> corrections = controller.corrections();
+
+  // Build up the baseline.
+  for (int i = 0; i < 10; i++) {
+    Clock::advance(Seconds(1));
+    Clock::settle();
+  }
+
+  EXPECT_TRUE(corrections.isPending());
+
+  // Double the cycles per instruction of the regular executor.
+  statistics->mutable_perf()->set_cycles(2000);
+
+  Clock::advance(Seconds(1));
+  Clock::settle();
+
+  AWAIT_READY(corrections);
+  ASSERT_EQ(1u, corrections.get().size());
+
+  const QoSCorrection& correction = corrections.get().front();
+  EXPECT_EQ(QoSCorrection::KILL, correction.type());
+  EXPECT_EQ("2", correction.kill().framework_id().value());
+  EXPECT_EQ("revocable", correction.kill().executor_id().value());
+
+  Clock::resume();
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
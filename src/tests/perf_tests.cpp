@@ -57,6 +57,26 @@ TEST_F(PerfTest, ROOT_Events)
 }
 
 
+TEST_F(PerfTest, Countable)
+{
+  set<string> events;
+  // Generic hardware, software and hardware cache events.
+  events.insert("cycles");
+  events.insert("task-clock");
+  events.insert("context-switches");
+  events.insert("L1-dcache-load-misses");
+  events.insert("LLC-stores");
+  EXPECT_TRUE(perf::countable(events));
+
+  // Add an event which is not generic.
+  events.insert("this-is-an-invalid-event");
+  EXPECT_FALSE(perf::countable(events));
+
+  // A cache with an operation that does not exist.
+  EXPECT_FALSE(perf::countable({"llc-sleeps"}));
+}
+
+
 TEST_F(PerfTest, Parse)
 {
   // uint64 and floats should be parsed.
@@ -89,9 +89,9 @@ protected:
 };
 
 
-// This test verifies that CheckpointResourcesMessages are sent to the
+// This test verifies that a CheckpointResourcesMessage is sent to the
 // slave when the framework creates/destroys persistent volumes, and
-// the resources in the messages correctly reflect the resources that
+// the resources in the message correctly reflect the resources that
 // need to be checkpointed on the slave.
 TEST_F(PersistentVolumeTest, SendingCheckpointResourcesMessage)
 {
@@ -125,13 +125,7 @@ TEST_F(PersistentVolumeTest, SendingCheckpointResourcesMessage)
 
   Offer offer = offers.get()[0];
 
-  Future<CheckpointResourcesMessage> message3 =
-    FUTURE_PROTOBUF(CheckpointResourcesMessage(), _, _);
-
-  Future<CheckpointResourcesMessage> message2 =
-    FUTURE_PROTOBUF(CheckpointResourcesMessage(), _, _);
-
-  Future<CheckpointResourcesMessage> message1 =
+  Future<CheckpointResourcesMessage> message =
     FUTURE_PROTOBUF(CheckpointResourcesMessage(), _, _);
 
   Resources volume1 = createPersistentVolume(
@@ -152,16 +146,11 @@ TEST_F(PersistentVolumeTest, SendingCheckpointResourcesMessage)
        CREATE(volume2),
        DESTROY(volume1)});
 
-  // NOTE: Currently, we send one message per operation. But this is
-  // an implementation detail which is subject to change.
-  AWAIT_READY(message1);
-  EXPECT_EQ(Resources(message1.get().resources()), volume1);
-
-  AWAIT_READY(message2);
-  EXPECT_EQ(Resources(message2.get().resources()), volume1 + volume2);
-
-  AWAIT_READY(message3);
-  EXPECT_EQ(Resources(message3.get().resources()), volume2);
+  // NOTE: Currently, the operations of an accept call (up to the
+  // first launch) are checkpointed in one message. But this is an
+  // implementation detail which is subject to change.
+  AWAIT_READY(message);
+  EXPECT_EQ(Resources(message.get().resources()), volume2);
 
   driver.stop();
   driver.join();
@@ -1569,6 +1569,113 @@ TEST_F(PortMappingIsolatorTest, ROOT_SmallEgressLimit)
 }
 
 
+// Test that the 'network_bandwidth' resource of a container installs
+// the HTB rate limit on the egress and the police filter on the
+// ingress of the container's eth0, and that both go away together
+// with the container.
+TEST_F(PortMappingIsolatorTest, ROOT_NetworkBandwidth)
+{
+  Try<Isolator*> isolator = PortMappingIsolatorProcess::create(flags);
+  CHECK_SOME(isolator);
+
+  Try<Launcher*> launcher = LinuxLauncher::create(flags);
+  CHECK_SOME(launcher);
+
+  // Set the executor's resources, including 8 Mbits/s (1 MB/s) of
+  // network bandwidth.
+  Try<Resources> resources =
+    Resources::parse(string(container1Ports) + ";network_bandwidth:8");
+  ASSERT_SOME(resources);
+
+  ExecutorInfo executorInfo;
+  executorInfo.mutable_resources()->CopyFrom(resources.get());
+
+  ContainerID containerId;
+  containerId.set_value("container1");
+
+  // Use a relative temporary directory so it gets cleaned up
+  // automatically with the test.
+  Try<string> dir = os::mkdtemp(path::join(os::getcwd(), "XXXXXX"));
+  ASSERT_SOME(dir);
+
+  Future<Option<CommandInfo> > preparation1 =
+    isolator.get()->prepare(
+        containerId,
+        executorInfo,
+        dir.get(),
+        None(),
+        None());
+
+  AWAIT_READY(preparation1);
+  ASSERT_SOME(preparation1.get());
+
+  // Dump the traffic control setup of eth0 from inside the container.
+  const string tc = path::join(os::getcwd(), "tc");
+
+  ostringstream command1;
+  command1 << "tc class show dev " << eth0 << " > " << tc << " && ";
+  command1 << "tc filter show dev " << eth0 << " parent ffff: >> "
+           << tc << " && ";
+  command1 << "touch " << container1Ready << " && ";
+  command1 << "sleep 1000";
+
+  int pipes[2];
+  ASSERT_NE(-1, ::pipe(pipes));
+
+  Try<pid_t> pid = launchHelper(
+      launcher.get(),
+      pipes,
+      containerId,
+      command1.str(),
+      preparation1.get());
+
+  ASSERT_SOME(pid);
+
+  // Reap the forked child.
+  Future<Option<int> > reap = process::reap(pid.get());
+
+  // Continue in the parent.
+  ::close(pipes[0]);
+
+  // Isolate the forked child.
+  AWAIT_READY(isolator.get()->isolate(containerId, pid.get()));
+
+  // Now signal the child to continue.
+  char dummy;
+  ASSERT_LT(0, ::write(pipes[1], &dummy, sizeof(dummy)));
+  ::close(pipes[1]);
+
+  ASSERT_TRUE(waitForFileCreation(container1Ready));
+
+  Try<string> read = os::read(tc);
+  ASSERT_SOME(read);
+
+  // Both the HTB class (egress) and the police action (ingress) use
+  // the rate of the resource.
+  EXPECT_TRUE(strings::contains(read.get(), "htb"));
+  EXPECT_TRUE(strings::contains(read.get(), "police"));
+  EXPECT_LE(3u, strings::split(read.get(), "rate 8Mbit").size());
+
+  // The host end of the veth pair of the container exists as long as
+  // the container does.
+  const string veth = PORT_MAPPING_VETH_PREFIX() + stringify(pid.get());
+  EXPECT_SOME_TRUE(link::exists(veth));
+
+  // Ensure all processes are killed.
+  AWAIT_READY(launcher.get()->destroy(containerId));
+
+  // Let the isolator clean up.
+  AWAIT_READY(isolator.get()->cleanup(containerId));
+
+  // The qdiscs and filters of the container went with its network
+  // namespace, and the veth pair has been removed from the host.
+  EXPECT_SOME_FALSE(link::exists(veth));
+
+  delete isolator.get();
+  delete launcher.get();
+}
+
+
 bool HasTCPSocketsCount(const JSON::Object& object)
 {
   return object.find<JSON::Number>(NET_TCP_ACTIVE_CONNECTIONS).isSome() &&
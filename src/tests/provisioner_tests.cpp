@@ -0,0 +1,199 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <mesos/mesos.hpp>
+
+#include <process/gtest.hpp>
+
+#include <stout/gtest.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/strings.hpp>
+
+#include "slave/flags.hpp"
+
+#include "slave/containerizer/mesos/provisioner.hpp"
+
+#include "tests/utils.hpp"
+
+using std::string;
+
+using mesos::internal::slave::Provisioner;
+using mesos::internal::slave::PROVISIONER_SANDBOX_DIRECTORY;
+
+using process::Future;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+class ProvisionerTest : public TemporaryDirectoryTest
+{
+protected:
+  // Creates a layer (tarball) whose '/etc/hostname' contains
+  // 'hostname' and returns it.
+  ContainerInfo::MesosInfo::Layer layer(
+      const string& name,
+      const string& hostname)
+  {
+    const string directory = path::join(os::getcwd(), name);
+
+    EXPECT_SOME(os::mkdir(path::join(directory, "etc")));
+    EXPECT_SOME(os::write(path::join(directory, "etc/hostname"), hostname));
+
+    const string tarball = directory + ".tar";
+
+    EXPECT_EQ(0, os::system(
+        "tar -C '" + directory + "' -cf '" + tarball + "' ."));
+
+    std::ostringstream out;
+    EXPECT_SOME_EQ(0, os::shell(&out, "sha256sum '%s'", tarball.c_str()));
+
+    ContainerInfo::MesosInfo::Layer layer;
+    layer.set_path(tarball);
+    layer.set_digest("sha256:" + strings::tokenize(out.str(), " ")[0]);
+
+    return layer;
+  }
+};
+
+
+TEST_F(ProvisionerTest, Digest)
+{
+  ContainerInfo::MesosInfo::Layer layer;
+  layer.set_path("layer.tar");
+
+  const string digest(64, 'a');
+
+  layer.set_digest("sha256:" + digest);
+  EXPECT_SOME_EQ(digest, Provisioner::digest(layer));
+
+  layer.set_digest("sha256:" + strings::upper(digest));
+  EXPECT_SOME_EQ(digest, Provisioner::digest(layer));
+
+  layer.set_digest(digest);
+  EXPECT_ERROR(Provisioner::digest(layer));
+
+  layer.set_digest("md5:" + digest);
+  EXPECT_ERROR(Provisioner::digest(layer));
+
+  layer.set_digest("sha256:" + digest.substr(1));
+  EXPECT_ERROR(Provisioner::digest(layer));
+
+  layer.set_digest("sha256:" + digest.substr(1) + ":");
+  EXPECT_ERROR(Provisioner::digest(layer));
+}
+
+
+// Provisions two containers from the same layers and verifies that
+// the upper layer overlays the base layer, that writes are private
+// to each container and that the root filesystem is removed (but the
+// cached layers are kept) once the container is destroyed.
+TEST_F(ProvisionerTest, ROOT_Provision)
+{
+  slave::Flags flags;
+  flags.work_dir = os::getcwd();
+
+  ContainerInfo::MesosInfo info;
+  info.add_layers()->CopyFrom(layer("base", "base"));
+  info.add_layers()->CopyFrom(layer("top", "top"));
+
+  const string sandbox1 = path::join(os::getcwd(), "sandbox1");
+  const string sandbox2 = path::join(os::getcwd(), "sandbox2");
+
+  ASSERT_SOME(os::mkdir(sandbox1));
+  ASSERT_SOME(os::mkdir(sandbox2));
+  ASSERT_SOME(os::write(path::join(sandbox1, "stdout"), "output"));
+
+  Provisioner provisioner(flags);
+
+  ContainerID containerId1;
+  containerId1.set_value("container1");
+
+  ContainerID containerId2;
+  containerId2.set_value("container2");
+
+  Future<string> rootfs1 =
+    provisioner.provision(containerId1, info, sandbox1);
+
+  Future<string> rootfs2 =
+    provisioner.provision(containerId2, info, sandbox2);
+
+  AWAIT_READY(rootfs1);
+  AWAIT_READY(rootfs2);
+
+  EXPECT_SOME_EQ("top", os::read(path::join(rootfs1.get(), "etc/hostname")));
+
+  EXPECT_SOME_EQ("output", os::read(path::join(
+      rootfs1.get(), PROVISIONER_SANDBOX_DIRECTORY, "stdout")));
+
+  ASSERT_SOME(os::write(path::join(rootfs1.get(), "etc/hostname"), "mine"));
+
+  EXPECT_SOME_EQ("mine", os::read(path::join(rootfs1.get(), "etc/hostname")));
+  EXPECT_SOME_EQ("top", os::read(path::join(rootfs2.get(), "etc/hostname")));
+
+  AWAIT_READY(provisioner.destroy(containerId1));
+  AWAIT_READY(provisioner.destroy(containerId2));
+
+  EXPECT_FALSE(os::exists(rootfs1.get()));
+  EXPECT_FALSE(os::exists(rootfs2.get()));
+
+  // The sandbox is only unmounted.
+  EXPECT_SOME_EQ("output", os::read(path::join(sandbox1, "stdout")));
+
+  // The layers stay cached.
+  Try<string> digest = Provisioner::digest(info.layers(0));
+  ASSERT_SOME(digest);
+
+  EXPECT_SOME_EQ("base", os::read(path::join(
+      flags.work_dir, "provisioner", "layers", digest.get(), "etc/hostname")));
+}
+
+
+// Verifies that a layer whose tarball doesn't match its digest is
+// not unpacked into the cache.
+TEST_F(ProvisionerTest, ROOT_ChecksumMismatch)
+{
+  slave::Flags flags;
+  flags.work_dir = os::getcwd();
+
+  ContainerInfo::MesosInfo info;
+  info.add_layers()->CopyFrom(layer("base", "base"));
+  info.mutable_layers(0)->set_digest("sha256:" + string(64, '0'));
+
+  Provisioner provisioner(flags);
+
+  ContainerID containerId;
+  containerId.set_value("container");
+
+  AWAIT_FAILED(provisioner.provision(containerId, info, os::getcwd()));
+
+  EXPECT_FALSE(os::exists(
+      path::join(flags.work_dir, "provisioner", "layers", string(64, '0'))));
+
+  AWAIT_READY(provisioner.destroy(containerId));
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
@@ -330,6 +330,70 @@ TEST_F(RateLimitingTest, RateLimitingEnabled)
 }
 
 
+// Verify that a message is throttled according to the weight of its
+// type.
+TEST_F(RateLimitingTest, WeightedMessages)
+{
+  master::Flags flags = CreateMasterFlags();
+
+  // Each RegisterFrameworkMessage counts as two queries.
+  RateLimit::Weight* weight =
+    flags.rate_limits.get().mutable_limits(0)->add_weights();
+  weight->set_message(RegisterFrameworkMessage().GetTypeName());
+  weight->set_weight(2);
+
+  Try<PID<Master> > master = StartMaster(flags);
+  ASSERT_SOME(master);
+
+  Clock::pause();
+
+  // Settle to make sure master is ready for incoming requests, i.e.,
+  // '_recover()' completes.
+  Clock::settle();
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  // Grab the stuff we need to replay the RegisterFrameworkMessage.
+  Future<RegisterFrameworkMessage> registerFrameworkMessage = FUTURE_PROTOBUF(
+      RegisterFrameworkMessage(), _, master.get());
+  Future<process::Message> frameworkRegisteredMessage = FUTURE_MESSAGE(
+      Eq(FrameworkRegisteredMessage().GetTypeName()), master.get(), _);
+
+  ASSERT_EQ(DRIVER_RUNNING, driver.start());
+
+  AWAIT_READY(registerFrameworkMessage);
+  AWAIT_READY(frameworkRegisteredMessage);
+
+  const process::UPID schedulerPid = frameworkRegisteredMessage.get().to;
+
+  // Unlike in 'RateLimitingEnabled' the first duplicate message is
+  // throttled too, as it needs a second permit.
+  Future<process::Message> duplicateFrameworkRegisteredMessage =
+    FUTURE_MESSAGE(Eq(FrameworkRegisteredMessage().GetTypeName()),
+                   master.get(),
+                   _);
+
+  process::post(schedulerPid, master.get(), registerFrameworkMessage.get());
+
+  Clock::settle();
+
+  EXPECT_TRUE(duplicateFrameworkRegisteredMessage.isPending());
+
+  Clock::advance(Seconds(1));
+  AWAIT_READY(duplicateFrameworkRegisteredMessage);
+
+  EXPECT_EQ(DRIVER_STOPPED, driver.stop());
+  EXPECT_EQ(DRIVER_STOPPED, driver.join());
+
+  Shutdown();
+}
+
+
 // Verify that framework message counters and rate limiters work with
 // frameworks of different principals which are throttled at
 // different rates.
@@ -533,6 +533,85 @@ TEST_F(ReconciliationTest, ImplicitNonTerminalTask)
 }
 
 
+// This test verifies that the master sends the updates of a
+// reconciliation in a batch to a framework with the
+// BATCHED_RECONCILIATION capability.
+TEST_F(ReconciliationTest, ImplicitBatchedReconciliation)
+{
+  Try<PID<Master> > master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave> > slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  FrameworkInfo frameworkInfo = DEFAULT_FRAMEWORK_INFO;
+  frameworkInfo.add_capabilities()->set_type(
+      FrameworkInfo::Capability::BATCHED_RECONCILIATION);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+    &sched, frameworkInfo, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 2, 1, 256, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> update1;
+  Future<TaskStatus> update2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&update1))
+    .WillOnce(FutureArg<1>(&update2));
+
+  driver.start();
+
+  AWAIT_READY(update1);
+  AWAIT_READY(update2);
+
+  // Both running tasks are sent back in a single message.
+  Future<StatusUpdatesMessage> batch =
+    FUTURE_PROTOBUF(StatusUpdatesMessage(), master.get(), _);
+
+  Future<TaskStatus> update3;
+  Future<TaskStatus> update4;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&update3))
+    .WillOnce(FutureArg<1>(&update4));
+
+  vector<TaskStatus> statuses;
+  driver.reconcileTasks(statuses);
+
+  AWAIT_READY(batch);
+  EXPECT_EQ(2, batch.get().updates_size());
+
+  AWAIT_READY(update3);
+  EXPECT_EQ(TASK_RUNNING, update3.get().state());
+  EXPECT_EQ(TaskStatus::REASON_RECONCILIATION, update3.get().reason());
+
+  AWAIT_READY(update4);
+  EXPECT_EQ(TASK_RUNNING, update4.get().state());
+  EXPECT_EQ(TaskStatus::REASON_RECONCILIATION, update4.get().reason());
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
 // This test ensures that the master does not send updates for
 // terminal tasks during an implicit reconciliation request.
 // TODO(bmahler): Soon the master will keep non-acknowledged
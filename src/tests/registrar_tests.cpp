@@ -17,6 +17,8 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <list>
 #include <map>
 #include <set>
 #include <string>
@@ -24,12 +26,15 @@
 
 #include <mesos/type_utils.hpp>
 
+#include <process/collect.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
 
 #include <stout/bytes.hpp>
+#include <stout/lambda.hpp>
+#include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/uuid.hpp>
 
@@ -47,11 +52,17 @@
 #include "master/master.hpp"
 #include "master/registrar.hpp"
 
+#include "state/in_memory.hpp"
+#include "state/leveldb.hpp"
 #include "state/log.hpp"
 #include "state/protobuf.hpp"
 #include "state/storage.hpp"
+#include "state/zookeeper.hpp"
 
 #include "tests/utils.hpp"
+#ifdef MESOS_HAS_JAVA
+#include "tests/zookeeper.hpp"
+#endif
 
 using namespace mesos::internal::master;
 
@@ -60,6 +71,7 @@ using namespace process;
 using mesos::internal::log::Log;
 using mesos::internal::log::Replica;
 
+using std::list;
 using std::map;
 using std::set;
 using std::string;
@@ -79,8 +91,13 @@ namespace internal {
 namespace tests {
 
 using state::Entry;
+using state::InMemoryStorage;
+using state::LevelDBStorage;
 using state::LogStorage;
 using state::Storage;
+#ifdef MESOS_HAS_JAVA
+using state::ZooKeeperStorage;
+#endif
 
 using state::protobuf::State;
 
@@ -348,6 +365,61 @@ TEST_P(RegistrarTest, bootstrap)
 }
 
 
+TEST_P(RegistrarTest, deltas)
+{
+  flags.registry_store_deltas = true;
+
+  SlaveID id2;
+  id2.set_value("2");
+
+  SlaveInfo info2;
+  info2.set_hostname("localhost");
+  info2.mutable_id()->CopyFrom(id2);
+
+  // Run 1 stores the changes to the registry as deltas.
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    AWAIT_EQ(true, registrar.apply(Owned<Operation>(new AdmitSlave(slave))));
+    AWAIT_EQ(true, registrar.apply(Owned<Operation>(new AdmitSlave(info2))));
+    AWAIT_EQ(true, registrar.apply(Owned<Operation>(new RemoveSlave(slave))));
+
+    Future<set<string> > names = state->names();
+    AWAIT_READY(names);
+    EXPECT_EQ(1u, names.get().count("registry_delta_0"));
+  }
+
+  // Run 2 should see the changes of the deltas.
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+
+    AWAIT_READY(registry);
+    ASSERT_EQ(1, registry.get().slaves().slaves().size());
+    EXPECT_EQ(info2, registry.get().slaves().slaves(0).info());
+  }
+
+  // Run 3 stores the whole registry, expunging the deltas.
+  flags.registry_store_deltas = false;
+
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+
+    AWAIT_READY(registry);
+    ASSERT_EQ(1, registry.get().slaves().slaves().size());
+    EXPECT_EQ(info2, registry.get().slaves().slaves(0).info());
+
+    Future<set<string> > names = state->names();
+    AWAIT_READY(names);
+    EXPECT_EQ(set<string>({"registry"}), names.get());
+  }
+}
+
+
 class MockStorage : public Storage
 {
 public:
@@ -399,6 +471,10 @@ TEST_P(RegistrarTest, storeTimeout)
   EXPECT_CALL(storage, get(_))
     .WillOnce(Return(None()));
 
+  // No registry deltas.
+  EXPECT_CALL(storage, names())
+    .WillOnce(Return(std::set<string>()));
+
   Future<Nothing> set;
   EXPECT_CALL(storage, set(_, _))
     .WillOnce(DoAll(FutureSatisfy(&set),
@@ -429,6 +505,10 @@ TEST_P(RegistrarTest, abort)
   EXPECT_CALL(storage, get(_))
     .WillOnce(Return(None()));
 
+  // No registry deltas.
+  EXPECT_CALL(storage, names())
+    .WillOnce(Return(std::set<string>()));
+
   EXPECT_CALL(storage, set(_, _))
     .WillOnce(Return(Future<bool>(true)))              // Recovery.
     .WillOnce(Return(Future<bool>::failed("failure"))) // Failure.
@@ -444,22 +524,97 @@ TEST_P(RegistrarTest, abort)
 }
 
 
-class Registrar_BENCHMARK_Test : public RegistrarTestBase,
-                                 public WithParamInterface<size_t>
-{};
+// A storage that counts the bytes of the entries set in the storage
+// it wraps, used to report the bytes written by the benchmarks.
+class CountingStorage : public Storage
+{
+public:
+  explicit CountingStorage(Storage* _storage)
+    : storage(_storage), written(0) {}
 
+  virtual Future<Option<Entry> > get(const string& name)
+  {
+    return storage->get(name);
+  }
 
-// The Registrar benchmark tests are parameterized by the number of slaves.
-INSTANTIATE_TEST_CASE_P(
-    SlaveCount,
-    Registrar_BENCHMARK_Test,
-    ::testing::Values(10000U, 20000U, 30000U, 50000U));
+  virtual Future<bool> set(const Entry& entry, const UUID& uuid)
+  {
+    written += entry.ByteSize();
+    return storage->set(entry, uuid);
+  }
 
+  virtual Future<bool> expunge(const Entry& entry)
+  {
+    return storage->expunge(entry);
+  }
 
-TEST_P(Registrar_BENCHMARK_Test, performance)
+  virtual Future<std::set<string> > names()
+  {
+    return storage->names();
+  }
+
+  Storage* storage;
+  std::atomic<uint64_t> written;
+};
+
+
+// Applies the operations all at once (as the master does when slaves
+// (re-)register after a failover) and logs the latency percentiles of
+// the operations and the bytes written to the storage.
+void measure(
+    const string& name,
+    Registrar* registrar,
+    const vector<Owned<Operation> >& operations,
+    CountingStorage* storage)
 {
-  Registrar registrar(flags, state);
-  AWAIT_READY(registrar.recover(master));
+  vector<Stopwatch> stopwatches(operations.size());
+  list<Future<bool> > futures;
+
+  const uint64_t written = storage->written;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < operations.size(); i++) {
+    stopwatches[i].start();
+
+    Future<bool> future = registrar->apply(operations[i]);
+    future.onAny(lambda::bind(&Stopwatch::stop, &stopwatches[i]));
+
+    futures.push_back(future);
+  }
+
+  // NOTE: The stopwatches have been stopped once 'collect' completes
+  // since the callbacks of a future are invoked in order.
+  AWAIT_READY_FOR(collect(futures), Minutes(5));
+
+  Duration elapsed = watch.elapsed();
+
+  vector<Duration> latencies;
+  foreach (const Stopwatch& stopwatch, stopwatches) {
+    latencies.push_back(stopwatch.elapsed());
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  LOG(INFO) << name << " " << operations.size() << " slaves in " << elapsed
+            << ", latency p50 " << latencies[latencies.size() * 50 / 100]
+            << " p90 " << latencies[latencies.size() * 90 / 100]
+            << " p99 " << latencies[latencies.size() * 99 / 100]
+            << " max " << latencies.back()
+            << ", wrote " << Bytes(storage->written - written);
+}
+
+
+// Benchmarks the admission, readmission and removal of 'slaveCount'
+// slaves against the storage.
+void benchmark(Storage* _storage, const Flags& flags, size_t slaveCount)
+{
+  CountingStorage storage(_storage);
+  State state(&storage);
+
+  MasterInfo master =
+    protobuf::createMasterInfo(UPID("master@127.0.0.1:5050"));
 
   vector<SlaveInfo> infos;
 
@@ -467,8 +622,6 @@ TEST_P(Registrar_BENCHMARK_Test, performance)
   Resources resources =
     Resources::parse("cpus(*):1.0;mem(*):512;disk(*):2048").get();
 
-  size_t slaveCount = GetParam();
-
   // Create slaves.
   for (size_t i = 0; i < slaveCount; ++i) {
     // Simulate real slave information.
@@ -481,37 +634,41 @@ TEST_P(Registrar_BENCHMARK_Test, performance)
     infos.push_back(info);
   }
 
-  // Admit slaves.
-  Stopwatch watch;
-  watch.start();
-  Future<bool> result;
-  foreach (const SlaveInfo& info, infos) {
-    result = registrar.apply(Owned<Operation>(new AdmitSlave(info)));
-  }
-  AWAIT_READY_FOR(result, Minutes(5));
-  LOG(INFO) << "Admitted " << slaveCount << " slaves in " << watch.elapsed();
+  vector<Owned<Operation> > operations;
 
-  // Shuffle the slaves so we are readmitting them in random order (
-  // same as in production).
-  std::random_shuffle(infos.begin(), infos.end());
+  {
+    Registrar registrar(flags, &state);
+    AWAIT_READY(registrar.recover(master));
 
-  // Readmit slaves.
-  watch.start();
-  foreach (const SlaveInfo& info, infos) {
-    result = registrar.apply(Owned<Operation>(new ReadmitSlave(info)));
+    // Admit slaves.
+    foreach (const SlaveInfo& info, infos) {
+      operations.push_back(Owned<Operation>(new AdmitSlave(info)));
+    }
+
+    measure("Admitted", &registrar, operations, &storage);
+
+    // Shuffle the slaves so we are readmitting them in random order
+    // (same as in production).
+    std::random_shuffle(infos.begin(), infos.end());
+
+    // Readmit slaves.
+    operations.clear();
+    foreach (const SlaveInfo& info, infos) {
+      operations.push_back(Owned<Operation>(new ReadmitSlave(info)));
+    }
+
+    measure("Readmitted", &registrar, operations, &storage);
   }
-  AWAIT_READY_FOR(result, Minutes(5));
-  LOG(INFO) << "Readmitted " << slaveCount << " slaves in " << watch.elapsed();
 
   // Recover slaves.
-  Registrar registrar2(flags, state);
+  Registrar registrar(flags, &state);
+
+  Stopwatch watch;
   watch.start();
-  MasterInfo info;
-  info.set_id("master");
-  info.set_ip(10000000);
-  info.set_port(5050);
-  Future<Registry> registry = registrar2.recover(info);
-  AWAIT_READY(registry);
+
+  Future<Registry> registry = registrar.recover(master);
+  AWAIT_READY_FOR(registry, Minutes(5));
+
   LOG(INFO) << "Recovered " << slaveCount << " slaves ("
             << Bytes(registry.get().ByteSize()) << ") in " << watch.elapsed();
 
@@ -520,13 +677,72 @@ TEST_P(Registrar_BENCHMARK_Test, performance)
   std::random_shuffle(infos.begin(), infos.end());
 
   // Remove slaves.
-  watch.start();
+  operations.clear();
   foreach (const SlaveInfo& info, infos) {
-    result = registrar2.apply(Owned<Operation>(new RemoveSlave(info)));
+    operations.push_back(Owned<Operation>(new RemoveSlave(info)));
   }
-  AWAIT_READY_FOR(result, Minutes(5));
-  LOG(INFO) << "Removed " << slaveCount << " slaves in " << watch.elapsed();
+
+  measure("Removed", &registrar, operations, &storage);
+}
+
+
+class Registrar_BENCHMARK_Test : public RegistrarTestBase,
+                                 public WithParamInterface<size_t>
+{};
+
+
+// The Registrar benchmark tests are parameterized by the number of slaves.
+INSTANTIATE_TEST_CASE_P(
+    SlaveCount,
+    Registrar_BENCHMARK_Test,
+    ::testing::Values(1000U, 10000U, 50000U, 100000U));
+
+
+// Uses the replicated log storage (the default).
+TEST_P(Registrar_BENCHMARK_Test, performance)
+{
+  benchmark(storage, flags, GetParam());
+}
+
+
+TEST_P(Registrar_BENCHMARK_Test, InMemory)
+{
+  InMemoryStorage storage;
+  benchmark(&storage, flags, GetParam());
+}
+
+
+TEST_P(Registrar_BENCHMARK_Test, LevelDB)
+{
+  LevelDBStorage storage(os::getcwd() + "/.state");
+  benchmark(&storage, flags, GetParam());
+}
+
+
+#ifdef MESOS_HAS_JAVA
+class RegistrarZooKeeper_BENCHMARK_Test : public ZooKeeperTest,
+                                          public WithParamInterface<size_t>
+{};
+
+
+// NOTE: ZooKeeper limits the size of a znode to 1MB by default, which
+// a registry of more than about 5000 slaves exceeds.
+INSTANTIATE_TEST_CASE_P(
+    SlaveCount,
+    RegistrarZooKeeper_BENCHMARK_Test,
+    ::testing::Values(1000U, 5000U));
+
+
+TEST_P(RegistrarZooKeeper_BENCHMARK_Test, performance)
+{
+  ZooKeeperStorage storage(server->connectString(), NO_TIMEOUT, "/registry/");
+
+  Flags flags;
+  flags.registry_store_timeout = Seconds(10);
+
+  benchmark(&storage, flags, GetParam());
 }
+#endif // MESOS_HAS_JAVA
 
 } // namespace tests {
 } // namespace internal {
@@ -19,6 +19,8 @@
 #include <string>
 #include <vector>
 
+#include <mesos/scheduler.hpp>
+
 #include <process/future.hpp>
 #include <process/gtest.hpp>
 #include <process/http.hpp>
@@ -30,6 +32,7 @@
 #include "tests/mesos.hpp"
 
 using mesos::internal::master::Master;
+using mesos::internal::slave::Slave;
 
 using process::Future;
 using process::PID;
@@ -42,6 +45,7 @@ using std::string;
 using std::vector;
 
 using testing::_;
+using testing::Return;
 
 namespace mesos {
 namespace internal {
@@ -199,6 +203,82 @@ TEST_F(HealthTest, ObserveEndpoint)
   Shutdown();
 }
 
+
+// This test verifies that a batch of observations can be posted as
+// JSON and that the resources of a slave are not offered while its
+// host is unhealthy.
+TEST_F(HealthTest, BatchedObservations)
+{
+  Try<PID<Master> > master = StartMaster();
+  ASSERT_SOME(master);
+
+  Try<PID<Slave> > slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers));
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_EQ(1u, offers.get().size());
+
+  const string hostname = offers.get()[0].hostname();
+
+  Future<Nothing> offerRescinded;
+  EXPECT_CALL(sched, offerRescinded(&driver, offers.get()[0].id()))
+    .WillOnce(FutureSatisfy(&offerRescinded));
+
+  // A malformed batch is rejected as a whole.
+  Future<Response> response = process::http::post(
+      master.get(),
+      "observe",
+      None(),
+      "{\"observations\": [{\"monitor\": \"a\"}]}",
+      "application/json");
+  VALIDATE_BAD_RESPONSE(response, "Missing value for 'hosts'.");
+
+  response = process::http::post(
+      master.get(),
+      "observe",
+      None(),
+      "{\"observations\": ["
+      " {\"monitor\": \"a\", \"hosts\": [\"" + hostname + "\", \"b\"],"
+      "  \"level\": \"critical\"},"
+      " {\"monitor\": \"c\", \"hosts\": [\"b\"], \"level\": \"ok\"}]}",
+      "application/json");
+  VALIDATE_GOOD_RESPONSE(response, "{\"observations\":2}");
+
+  AWAIT_READY(offerRescinded);
+
+  // The slave is offered again once its host is healthy.
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  response = process::http::post(
+      master.get(),
+      "observe",
+      None(),
+      "monitor=a&hosts=" + hostname + "&level=ok");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  AWAIT_READY(offers);
+  EXPECT_EQ(1u, offers.get().size());
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -16,6 +16,7 @@
  * limitations under the License.
  */
 
+#include <iterator>
 #include <sstream>
 #include <string>
 
@@ -23,6 +24,7 @@
 
 #include <stout/bytes.hpp>
 #include <stout/gtest.hpp>
+#include <stout/stopwatch.hpp>
 
 #include "master/master.hpp"
 
@@ -262,6 +264,40 @@ TEST(ResourcesTest, BadResourcesNotAllocatable)
 }
 
 
+// This test verifies that trusted resources are combined and empty
+// ones ignored, like when constructing Resources.
+TEST(ResourcesTest, Trusted)
+{
+  google::protobuf::RepeatedPtrField<Resource> resources;
+  resources.Add()->CopyFrom(Resources::parse("cpus", "1", "*").get());
+  resources.Add()->CopyFrom(Resources::parse("mem", "0", "*").get());
+  resources.Add()->CopyFrom(Resources::parse("cpus", "2", "*").get());
+
+  Resources trusted = Resources::trusted(resources);
+
+  EXPECT_EQ(Resources(resources), trusted);
+  EXPECT_EQ(1, std::distance(trusted.begin(), trusted.end()));
+  EXPECT_EQ(3, trusted.get<Value::Scalar>("cpus").get().value());
+}
+
+
+// This test verifies that copies of Resources are not affected by
+// the mutation of each other.
+TEST(ResourcesTest, Copies)
+{
+  Resources r1 = Resources::parse("cpus:1;mem:512;ports:[1-10]").get();
+  Resources r2 = r1;
+  Resources r3 = r1;
+
+  r2 += Resources::parse("cpus:1").get();
+  r3 -= Resources::parse("mem:512").get();
+
+  EXPECT_EQ(Resources::parse("cpus:1;mem:512;ports:[1-10]").get(), r1);
+  EXPECT_EQ(Resources::parse("cpus:2;mem:512;ports:[1-10]").get(), r2);
+  EXPECT_EQ(Resources::parse("cpus:1;ports:[1-10]").get(), r3);
+}
+
+
 TEST(ResourcesTest, ScalarEquals)
 {
   Resource cpus = Resources::parse("cpus", "3", "*").get();
@@ -1313,6 +1349,41 @@ TEST(RevocableResourceTest, Filter)
   EXPECT_EQ(r1, (r1 + r2).revocable());
 }
 
+
+// This benchmark measures the arithmetic the allocator and the master
+// do on every allocation, i.e., adding, subtracting and checking
+// containment of (mostly scalar) resources.
+TEST(Resources_BENCHMARK_Test, Arithmetic)
+{
+  const Resources total = Resources::parse(
+      "cpus:24;mem:65536;disk:1048576;ports:[31000-32000]").get();
+
+  const Resources reserved = Resources::parse(
+      "cpus(role):8;mem(role):16384", "*").get();
+
+  const Resources task = Resources::parse(
+      "cpus:0.5;mem:512;disk:1024;ports:[31000-31000]").get();
+
+  const size_t iterations = 50000;
+
+  Resources available = total + reserved;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < iterations; i++) {
+    ASSERT_TRUE(available.contains(task));
+
+    available -= task;
+    available += task;
+  }
+
+  LOG(INFO) << "Took " << watch.elapsed() << " to perform " << iterations
+            << " additions, subtractions and containment checks";
+
+  EXPECT_EQ(total + reserved, available);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -18,6 +18,7 @@
 
 #include <gmock/gmock.h>
 
+#include <deque>
 #include <memory>
 #include <string>
 #include <queue>
@@ -38,11 +39,18 @@
 
 #include <process/metrics/metrics.hpp>
 
+#include <stout/base64.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/json.hpp>
 #include <stout/lambda.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
 #include <stout/try.hpp>
 #include <stout/uuid.hpp>
 
+#include "common/http.hpp"
+#include "common/recordio.hpp"
+
 #include "master/master.hpp"
 
 #include "tests/containerizer.hpp"
@@ -63,7 +71,12 @@ using process::PID;
 using process::Promise;
 using process::Queue;
 
+using process::http::Accepted;
+using process::http::BadRequest;
+using process::http::Forbidden;
 using process::http::OK;
+using process::http::Pipe;
+using process::http::Response;
 
 using process::metrics::internal::MetricsProcess;
 
@@ -84,6 +97,21 @@ namespace tests {
 class SchedulerTest : public MesosTest
 {
 protected:
+  virtual void SetUp()
+  {
+    MesosTest::SetUp();
+
+    // The library only sends the credential if asked to.
+    os::setenv("MESOS_HTTP_BASIC_AUTHENTICATION", "true");
+  }
+
+  virtual void TearDown()
+  {
+    os::unsetenv("MESOS_HTTP_BASIC_AUTHENTICATION");
+
+    MesosTest::TearDown();
+  }
+
   // Helper class for using EXPECT_CALL since the Mesos scheduler API
   // is callback based.
   class Callbacks
@@ -660,6 +688,230 @@ TEST_F(SchedulerTest, Teardown)
 // master to slave when Event::Update was generated locally.
 
 
+// Tests of the master's scheduler endpoint itself, i.e., without the
+// scheduler library.
+class SchedulerEndpointTest : public MesosTest
+{
+protected:
+  static hashmap<string, string> authorization(const Credential& credential)
+  {
+    hashmap<string, string> headers;
+    headers["Authorization"] = "Basic " +
+      base64::encode(credential.principal() + ":" + credential.secret());
+    return headers;
+  }
+
+  static Future<Response> post(
+      const PID<Master>& master,
+      const hashmap<string, string>& headers,
+      const Call& call)
+  {
+    return process::http::post(
+        master,
+        "api/v1/scheduler",
+        headers,
+        serialize(APPLICATION_PROTOBUF, call),
+        APPLICATION_PROTOBUF);
+  }
+
+  static Future<Response> subscribe(
+      const PID<Master>& master,
+      const hashmap<string, string>& headers,
+      const FrameworkInfo& frameworkInfo)
+  {
+    Call call;
+    call.mutable_framework_info()->CopyFrom(frameworkInfo);
+    call.set_type(Call::SUBSCRIBE);
+
+    return process::http::streaming::post(
+        master,
+        "api/v1/scheduler",
+        headers,
+        serialize(APPLICATION_PROTOBUF, call),
+        APPLICATION_PROTOBUF);
+  }
+
+  // Returns the next event streamed over the subscription.
+  static Try<Event> next(
+      Pipe::Reader reader,
+      recordio::Decoder* decoder,
+      std::deque<string>* records)
+  {
+    while (records->empty()) {
+      Future<string> data = reader.read();
+      if (!data.await(Seconds(15)) || !data.isReady() || data.get().empty()) {
+        return Error("Failed to read the subscription");
+      }
+
+      Try<std::deque<string>> decode = decoder->decode(data.get());
+      if (decode.isError()) {
+        return Error(decode.error());
+      }
+
+      records->insert(
+          records->end(), decode.get().begin(), decode.get().end());
+    }
+
+    string record = records->front();
+    records->pop_front();
+
+    return deserialize<Event>(APPLICATION_PROTOBUF, record);
+  }
+
+  // Returns a REVIVE call of the framework.
+  static Call revive(const FrameworkID& frameworkId)
+  {
+    Call call;
+    call.mutable_framework_info()->CopyFrom(DEFAULT_FRAMEWORK_INFO);
+    call.mutable_framework_info()->mutable_id()->CopyFrom(frameworkId);
+    call.set_type(Call::REVIVE);
+    return call;
+  }
+};
+
+
+// This test verifies that the calls of a framework subscribed over
+// HTTP are only accepted with the stream ID of its subscription,
+// i.e., knowing the ID of the framework does not suffice to make
+// calls on its behalf.
+TEST_F(SchedulerEndpointTest, CallsRequireStreamId)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  hashmap<string, string> headers = authorization(DEFAULT_CREDENTIAL);
+
+  Future<Response> response =
+    subscribe(master.get(), headers, DEFAULT_FRAMEWORK_INFO);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_EQ(Response::PIPE, response.get().type);
+  ASSERT_SOME(response.get().reader);
+
+  Option<string> streamId = response.get().headers.get("Mesos-Stream-Id");
+  ASSERT_SOME(streamId);
+
+  Pipe::Reader reader = response.get().reader.get();
+  recordio::Decoder decoder;
+  std::deque<string> records;
+
+  Try<Event> event = next(reader, &decoder, &records);
+  ASSERT_SOME(event);
+  ASSERT_EQ(Event::SUBSCRIBED, event.get().type());
+
+  const FrameworkID frameworkId = event.get().subscribed().framework_id();
+
+  // A call without a stream ID is rejected.
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      BadRequest().status,
+      post(master.get(), headers, revive(frameworkId)));
+
+  // So is a call with the stream ID of another subscription.
+  headers["Mesos-Stream-Id"] = "0123456789abcdef0123456789abcdef";
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      Forbidden().status,
+      post(master.get(), headers, revive(frameworkId)));
+
+  headers["Mesos-Stream-Id"] = streamId.get();
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      Accepted().status,
+      post(master.get(), headers, revive(frameworkId)));
+
+  reader.close();
+
+  Shutdown();
+}
+
+
+// This test verifies that another principal can neither make calls
+// for a framework subscribed over HTTP nor fail it over.
+TEST_F(SchedulerEndpointTest, WrongPrincipal)
+{
+  Credential other;
+  other.set_principal("other-principal");
+  other.set_secret("other-secret");
+
+  master::Flags flags = CreateMasterFlags();
+
+  // Allow both principals to authenticate.
+  Credentials credentials;
+  credentials.add_credentials()->CopyFrom(DEFAULT_CREDENTIAL);
+  credentials.add_credentials()->CopyFrom(other);
+
+  const string path = path::join(os::getcwd(), "credentials");
+  ASSERT_SOME(os::write(path, stringify(JSON::Protobuf(credentials))));
+
+  flags.credentials = path;
+
+  Try<PID<Master>> master = StartMaster(flags);
+  ASSERT_SOME(master);
+
+  hashmap<string, string> headers = authorization(DEFAULT_CREDENTIAL);
+
+  Future<Response> response =
+    subscribe(master.get(), headers, DEFAULT_FRAMEWORK_INFO);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_SOME(response.get().reader);
+
+  Option<string> streamId = response.get().headers.get("Mesos-Stream-Id");
+  ASSERT_SOME(streamId);
+
+  Pipe::Reader reader = response.get().reader.get();
+  recordio::Decoder decoder;
+  std::deque<string> records;
+
+  Try<Event> event = next(reader, &decoder, &records);
+  ASSERT_SOME(event);
+  ASSERT_EQ(Event::SUBSCRIBED, event.get().type());
+
+  const FrameworkID frameworkId = event.get().subscribed().framework_id();
+
+  // The other principal can't make calls for the framework, even
+  // with the stream ID of its subscription.
+  hashmap<string, string> otherHeaders = authorization(other);
+  otherHeaders["Mesos-Stream-Id"] = streamId.get();
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      Forbidden().status,
+      post(master.get(), otherHeaders, revive(frameworkId)));
+
+  // Nor can it fail over the framework.
+  FrameworkInfo frameworkInfo = DEFAULT_FRAMEWORK_INFO;
+  frameworkInfo.mutable_id()->CopyFrom(frameworkId);
+  frameworkInfo.clear_principal();
+
+  Future<Response> failover =
+    subscribe(master.get(), authorization(other), frameworkInfo);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, failover);
+  ASSERT_SOME(failover.get().reader);
+
+  Pipe::Reader failoverReader = failover.get().reader.get();
+  recordio::Decoder failoverDecoder;
+  std::deque<string> failoverRecords;
+
+  event = next(failoverReader, &failoverDecoder, &failoverRecords);
+  ASSERT_SOME(event);
+  EXPECT_EQ(Event::ERROR, event.get().type());
+
+  failoverReader.close();
+
+  // The framework is still subscribed through its own connection.
+  headers["Mesos-Stream-Id"] = streamId.get();
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      Accepted().status,
+      post(master.get(), headers, revive(frameworkId)));
+
+  reader.close();
+
+  Shutdown();
+}
+
+
 class MesosSchedulerDriverTest : public MesosTest {};
 
 
@@ -705,6 +957,64 @@ TEST_F(MesosSchedulerDriverTest, MetricsEndpoint)
 }
 
 
+// Ensures that a driver invoking the callbacks on a pool of threads
+// (see '--callback_threads') delivers them and implicitly acknowledges
+// status updates once their callback returned.
+TEST_F(MesosSchedulerDriverTest, CallbackThreads)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  // The driver loads its flags from the environment.
+  os::setenv("MESOS_CALLBACK_THREADS", "2");
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 1, 1, 16, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  Future<StatusUpdateAcknowledgementMessage> acknowledgement =
+    FUTURE_PROTOBUF(StatusUpdateAcknowledgementMessage(), _ , master.get());
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.start();
+
+  os::unsetenv("MESOS_CALLBACK_THREADS");
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  AWAIT_READY(acknowledgement);
+  EXPECT_EQ(status.get().task_id(), acknowledgement.get().task_id());
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 // This action calls driver stop() followed by abort().
 ACTION(StopAndAbort)
 {
@@ -50,6 +50,8 @@
 #include "slave/paths.hpp"
 #include "slave/slave.hpp"
 #include "slave/state.hpp"
+#include "slave/status_update_manager.hpp"
+#include "slave/store.hpp"
 
 #include "slave/containerizer/containerizer.hpp"
 #include "slave/containerizer/fetcher.hpp"
@@ -130,6 +132,380 @@ TEST_F(SlaveStateTest, CheckpointRepeatedProtobufMessages)
 }
 
 
+// This test verifies that the status update records which only made
+// it to the status update journal are recovered.
+TEST_F(SlaveStateTest, ReplayStatusUpdateJournal)
+{
+  const string rootDir = os::getcwd();
+
+  SlaveID slaveId;
+  slaveId.set_value("slave");
+
+  FrameworkID frameworkId;
+  frameworkId.set_value("framework");
+
+  ExecutorID executorId;
+  executorId.set_value("executor");
+
+  ContainerID containerId;
+  containerId.set_value("container");
+
+  TaskID taskId;
+  taskId.set_value("task");
+
+  SlaveInfo slaveInfo;
+  slaveInfo.set_hostname("localhost");
+
+  ASSERT_SOME(slave::state::checkpoint(
+      paths::getSlaveInfoPath(rootDir, slaveId), slaveInfo));
+
+  FrameworkInfo frameworkInfo = DEFAULT_FRAMEWORK_INFO;
+  frameworkInfo.mutable_id()->CopyFrom(frameworkId);
+
+  ASSERT_SOME(slave::state::checkpoint(
+      paths::getFrameworkInfoPath(rootDir, slaveId, frameworkId),
+      frameworkInfo));
+
+  ASSERT_SOME(slave::state::checkpoint(
+      paths::getFrameworkPidPath(rootDir, slaveId, frameworkId),
+      "scheduler@127.0.0.1:5050"));
+
+  TaskInfo taskInfo;
+  taskInfo.set_name("");
+  taskInfo.mutable_task_id()->CopyFrom(taskId);
+  taskInfo.mutable_slave_id()->CopyFrom(slaveId);
+  taskInfo.mutable_executor()->CopyFrom(DEFAULT_EXECUTOR_INFO);
+  taskInfo.mutable_executor()->mutable_executor_id()->CopyFrom(executorId);
+
+  ASSERT_SOME(slave::state::checkpoint(
+      paths::getTaskInfoPath(
+          rootDir, slaveId, frameworkId, executorId, containerId, taskId),
+      protobuf::createTask(taskInfo, TASK_STAGING, frameworkId)));
+
+  StatusUpdate update1 = protobuf::createStatusUpdate(
+      frameworkId,
+      slaveId,
+      taskId,
+      TASK_RUNNING,
+      TaskStatus::SOURCE_EXECUTOR);
+
+  StatusUpdate update2 = protobuf::createStatusUpdate(
+      frameworkId,
+      slaveId,
+      taskId,
+      TASK_FINISHED,
+      TaskStatus::SOURCE_EXECUTOR);
+
+  StatusUpdateJournalRecord record;
+  record.mutable_framework_id()->CopyFrom(frameworkId);
+  record.mutable_executor_id()->CopyFrom(executorId);
+  record.mutable_container_id()->CopyFrom(containerId);
+  record.mutable_task_id()->CopyFrom(taskId);
+
+  // Only the first update made it to the status updates file, the
+  // ACK for it and the second update only made it to the journal.
+  Try<int> fd = os::open(
+      paths::getTaskUpdatesPath(
+          rootDir, slaveId, frameworkId, executorId, containerId, taskId),
+      O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  ASSERT_SOME(fd);
+
+  record.mutable_record()->set_type(StatusUpdateRecord::UPDATE);
+  record.mutable_record()->mutable_update()->CopyFrom(update1);
+
+  ASSERT_SOME(::protobuf::write(fd.get(), record.record()));
+
+  {
+    StatusUpdateJournal journal(
+        paths::getStatusUpdatesJournalPath(rootDir, slaveId));
+
+    ASSERT_SOME(journal.append(record, fd.get()));
+
+    record.mutable_record()->set_type(StatusUpdateRecord::ACK);
+    record.mutable_record()->clear_update();
+    record.mutable_record()->set_uuid(update1.uuid());
+
+    ASSERT_SOME(journal.append(record, fd.get()));
+
+    record.mutable_record()->set_type(StatusUpdateRecord::UPDATE);
+    record.mutable_record()->clear_uuid();
+    record.mutable_record()->mutable_update()->CopyFrom(update2);
+
+    ASSERT_SOME(journal.append(record, fd.get()));
+    ASSERT_SOME(journal.commit());
+
+    journal.release(fd.get());
+  }
+
+  // Recovering twice verifies that the records are only replayed
+  // once into the status updates file.
+  for (int i = 0; i < 2; i++) {
+    Try<slave::state::SlaveState> state =
+      slave::state::SlaveState::recover(rootDir, slaveId, true);
+
+    ASSERT_SOME(state);
+    EXPECT_EQ(0u, state.get().errors);
+
+    ASSERT_TRUE(state.get().frameworks.contains(frameworkId));
+
+    // NOTE: Copied since 'hashmap::get' returns a temporary.
+    const slave::state::TaskState task = state.get()
+      .frameworks.get(frameworkId).get()
+      .executors.get(executorId).get()
+      .runs.get(containerId).get()
+      .tasks.get(taskId).get();
+
+    ASSERT_EQ(2u, task.updates.size());
+    EXPECT_EQ(update1.uuid(), task.updates[0].uuid());
+    EXPECT_EQ(update2.uuid(), task.updates[1].uuid());
+
+    EXPECT_EQ(1u, task.acks.size());
+    EXPECT_TRUE(task.acks.contains(UUID::fromBytes(update1.uuid())));
+  }
+}
+
+
+// This test verifies that the executors of a framework are recovered
+// using multiple threads, and that the tasks of completed runs other
+// than the latest one are not recovered.
+TEST_F(SlaveStateTest, RecoverExecutors)
+{
+  const string rootDir = os::getcwd();
+
+  SlaveID slaveId;
+  slaveId.set_value("slave");
+
+  FrameworkID frameworkId;
+  frameworkId.set_value("framework");
+
+  SlaveInfo slaveInfo;
+  slaveInfo.set_hostname("localhost");
+
+  ASSERT_SOME(slave::state::checkpoint(
+      paths::getSlaveInfoPath(rootDir, slaveId), slaveInfo));
+
+  FrameworkInfo frameworkInfo = DEFAULT_FRAMEWORK_INFO;
+  frameworkInfo.mutable_id()->CopyFrom(frameworkId);
+
+  ASSERT_SOME(slave::state::checkpoint(
+      paths::getFrameworkInfoPath(rootDir, slaveId, frameworkId),
+      frameworkInfo));
+
+  ASSERT_SOME(slave::state::checkpoint(
+      paths::getFrameworkPidPath(rootDir, slaveId, frameworkId),
+      "scheduler@127.0.0.1:5050"));
+
+  ContainerID completed;
+  completed.set_value("completed");
+
+  ContainerID current;
+  current.set_value("current");
+
+  TaskID taskId;
+  taskId.set_value("task");
+
+  const size_t executors = 10;
+
+  for (size_t i = 0; i < executors; i++) {
+    ExecutorID executorId;
+    executorId.set_value("executor" + stringify(i));
+
+    ExecutorInfo executorInfo = DEFAULT_EXECUTOR_INFO;
+    executorInfo.mutable_executor_id()->CopyFrom(executorId);
+
+    ASSERT_SOME(slave::state::checkpoint(
+        paths::getExecutorInfoPath(
+            rootDir, slaveId, frameworkId, executorId),
+        executorInfo));
+
+    // The completed run has a corrupted task info, which fails a
+    // strict recovery if the run is not skipped.
+    paths::createExecutorDirectory(
+        rootDir, slaveId, frameworkId, executorId, completed);
+
+    ASSERT_SOME(slave::state::checkpoint(
+        paths::getExecutorSentinelPath(
+            rootDir, slaveId, frameworkId, executorId, completed),
+        ""));
+
+    ASSERT_SOME(slave::state::checkpoint(
+        paths::getTaskInfoPath(
+            rootDir, slaveId, frameworkId, executorId, completed, taskId),
+        "corrupted"));
+
+    paths::createExecutorDirectory(
+        rootDir, slaveId, frameworkId, executorId, current);
+
+    TaskInfo taskInfo;
+    taskInfo.set_name("");
+    taskInfo.mutable_task_id()->CopyFrom(taskId);
+    taskInfo.mutable_slave_id()->CopyFrom(slaveId);
+    taskInfo.mutable_executor()->CopyFrom(executorInfo);
+
+    ASSERT_SOME(slave::state::checkpoint(
+        paths::getTaskInfoPath(
+            rootDir, slaveId, frameworkId, executorId, current, taskId),
+        protobuf::createTask(taskInfo, TASK_STAGING, frameworkId)));
+  }
+
+  Try<slave::state::SlaveState> state =
+    slave::state::SlaveState::recover(rootDir, slaveId, true, 4);
+
+  ASSERT_SOME(state);
+  EXPECT_EQ(0u, state.get().errors);
+
+  ASSERT_TRUE(state.get().frameworks.contains(frameworkId));
+
+  // NOTE: Copied since 'hashmap::get' returns a temporary.
+  const slave::state::FrameworkState framework =
+    state.get().frameworks.get(frameworkId).get();
+
+  ASSERT_EQ(executors, framework.executors.size());
+
+  foreachvalue (const slave::state::ExecutorState& executor,
+                framework.executors) {
+    EXPECT_SOME_EQ(current, executor.latest);
+    ASSERT_EQ(2u, executor.runs.size());
+
+    const slave::state::RunState run1 = executor.runs.get(completed).get();
+    EXPECT_TRUE(run1.completed);
+    EXPECT_TRUE(run1.tasks.empty());
+
+    const slave::state::RunState run2 = executor.runs.get(current).get();
+    EXPECT_FALSE(run2.completed);
+    EXPECT_TRUE(run2.tasks.contains(taskId));
+  }
+}
+
+
+// This test verifies that the checkpoint files are migrated into a
+// checkpoint store, that checkpoints are then written to and
+// recovered from the store, and that they can be migrated back.
+TEST_F(SlaveStateTest, CheckpointStore)
+{
+  const string rootDir = os::getcwd();
+
+  SlaveID slaveId;
+  slaveId.set_value("slave");
+
+  FrameworkID frameworkId;
+  frameworkId.set_value("framework");
+
+  ExecutorID executorId;
+  executorId.set_value("executor");
+
+  ContainerID containerId;
+  containerId.set_value("container");
+
+  SlaveInfo slaveInfo;
+  slaveInfo.set_hostname("localhost");
+
+  const string slaveInfoPath = paths::getSlaveInfoPath(rootDir, slaveId);
+  ASSERT_SOME(slave::state::checkpoint(slaveInfoPath, slaveInfo));
+
+  FrameworkInfo frameworkInfo = DEFAULT_FRAMEWORK_INFO;
+  frameworkInfo.mutable_id()->CopyFrom(frameworkId);
+
+  ASSERT_SOME(slave::state::checkpoint(
+      paths::getFrameworkInfoPath(rootDir, slaveId, frameworkId),
+      frameworkInfo));
+
+  ASSERT_SOME(slave::state::checkpoint(
+      paths::getFrameworkPidPath(rootDir, slaveId, frameworkId),
+      "scheduler@127.0.0.1:5050"));
+
+  ExecutorInfo executorInfo = DEFAULT_EXECUTOR_INFO;
+  executorInfo.mutable_executor_id()->CopyFrom(executorId);
+
+  ASSERT_SOME(slave::state::checkpoint(
+      paths::getExecutorInfoPath(rootDir, slaveId, frameworkId, executorId),
+      executorInfo));
+
+  paths::createExecutorDirectory(
+      rootDir, slaveId, frameworkId, executorId, containerId);
+
+  Resources resources = Resources::parse("cpus:2;mem:1024").get();
+
+  ASSERT_SOME(slave::state::checkpoint(
+      paths::getResourcesInfoPath(rootDir), resources));
+
+  Try<slave::state::Store*> store = slave::state::Store::create(rootDir);
+  ASSERT_SOME(store);
+
+  // The status updates files are not migrated.
+  TaskID taskId;
+  taskId.set_value("task");
+
+  const string updatesPath = paths::getTaskUpdatesPath(
+      rootDir, slaveId, frameworkId, executorId, containerId, taskId);
+  ASSERT_SOME(os::mkdir(os::dirname(updatesPath).get()));
+  ASSERT_SOME(os::touch(updatesPath));
+
+  EXPECT_SOME_EQ(5u, store.get()->import());
+
+  EXPECT_FALSE(os::exists(slaveInfoPath));
+  EXPECT_TRUE(os::exists(updatesPath));
+
+  slave::state::Store::install(store.get());
+
+  // Checkpoints are now written to the store.
+  const string forkedPidPath = paths::getForkedPidPath(
+      rootDir, slaveId, frameworkId, executorId, containerId);
+  ASSERT_SOME(slave::state::checkpoint(forkedPidPath, "1234"));
+
+  EXPECT_FALSE(os::exists(forkedPidPath));
+  EXPECT_SOME_EQ("1234", store.get()->read(forkedPidPath));
+
+  Try<slave::state::SlaveState> state =
+    slave::state::SlaveState::recover(rootDir, slaveId, true);
+
+  ASSERT_SOME(state);
+  EXPECT_EQ(0u, state.get().errors);
+  EXPECT_SOME_EQ(slaveInfo, state.get().info);
+
+  ASSERT_TRUE(state.get().frameworks.contains(frameworkId));
+
+  // NOTE: Copied since 'hashmap::get' returns a temporary.
+  const slave::state::FrameworkState framework =
+    state.get().frameworks.get(frameworkId).get();
+
+  EXPECT_SOME_EQ(frameworkInfo, framework.info);
+  ASSERT_TRUE(framework.executors.contains(executorId));
+
+  const slave::state::ExecutorState executor =
+    framework.executors.get(executorId).get();
+
+  EXPECT_SOME_EQ(executorInfo, executor.info);
+  ASSERT_TRUE(executor.runs.contains(containerId));
+  EXPECT_SOME_EQ(1234, executor.runs.get(containerId).get().forkedPid);
+
+  Try<slave::state::ResourcesState> resourcesState =
+    slave::state::ResourcesState::recover(rootDir, true);
+
+  ASSERT_SOME(resourcesState);
+  EXPECT_EQ(resources, resourcesState.get().resources);
+
+  // Removing a directory removes the checkpoints below it.
+  ASSERT_SOME(store.get()->remove(
+      paths::getExecutorPath(rootDir, slaveId, frameworkId, executorId)));
+  EXPECT_NONE(store.get()->read(forkedPidPath));
+
+  slave::state::Store::uninstall(store.get());
+
+  EXPECT_SOME_EQ(4u, store.get()->unpack());
+  EXPECT_TRUE(os::exists(slaveInfoPath));
+
+  delete store.get();
+
+  state = slave::state::SlaveState::recover(rootDir, slaveId, true);
+
+  ASSERT_SOME(state);
+  EXPECT_SOME_EQ(slaveInfo, state.get().info);
+}
+
+
 template <typename T>
 class SlaveRecoveryTest : public ContainerizerTest<T>
 {
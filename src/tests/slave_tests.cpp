@@ -35,8 +35,12 @@
 #include <process/pid.hpp>
 #include <process/subprocess.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/fs.hpp>
+#include <stout/gzip.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/try.hpp>
 
 #include "common/build.hpp"
@@ -48,6 +52,8 @@
 #include "slave/constants.hpp"
 #include "slave/gc.hpp"
 #include "slave/flags.hpp"
+#include "slave/logs.hpp"
+#include "slave/paths.hpp"
 #include "slave/slave.hpp"
 
 #include "slave/containerizer/fetcher.hpp"
@@ -539,6 +545,273 @@ TEST_F(SlaveTest, ComamndTaskWithArguments)
 }
 
 
+// With '--command_executor_idle_timeout' a command task reuses the
+// idle command executor of a previous task with the same command,
+// and runs in a directory of its own which leaves the files of the
+// previous task in place.
+TEST_F(SlaveTest, CommandExecutorReuse)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.isolation = "posix/cpu,posix/mem";
+  flags.command_executor_idle_timeout = Minutes(1);
+
+  Fetcher fetcher;
+
+  Try<MesosContainerizer*> containerizer =
+    MesosContainerizer::create(flags, false, &fetcher);
+  CHECK_SOME(containerizer);
+
+  Try<PID<Slave>> slave = StartSlave(containerizer.get(), flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  Future<vector<Offer>> offers1;
+  Future<vector<Offer>> offers2;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers1))
+    .WillOnce(FutureArg<1>(&offers2))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Future<TaskStatus> statusRunning1;
+  Future<TaskStatus> statusFinished1;
+  Future<TaskStatus> statusRunning2;
+  Future<TaskStatus> statusFinished2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&statusRunning1))
+    .WillOnce(FutureArg<1>(&statusFinished1))
+    .WillOnce(FutureArg<1>(&statusRunning2))
+    .WillOnce(FutureArg<1>(&statusFinished2));
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+
+  AWAIT_READY(offers1);
+  EXPECT_NE(0u, offers1.get().size());
+
+  const Resources resources = Resources::parse("cpus:1;mem:128").get();
+
+  TaskInfo task1 = createTask(
+      offers1.get()[0].slave_id(), resources, "touch created", None(), "", "1");
+
+  driver.launchTasks(offers1.get()[0].id(), {task1});
+
+  AWAIT_READY(statusRunning1);
+  EXPECT_EQ(TASK_RUNNING, statusRunning1.get().state());
+
+  AWAIT_READY(statusFinished1);
+  EXPECT_EQ(TASK_FINISHED, statusFinished1.get().state());
+
+  // The second task has the same command, i.e., it gets launched on
+  // the now idle command executor of the first task.
+  AWAIT_READY(offers2);
+  EXPECT_NE(0u, offers2.get().size());
+
+  TaskInfo task2 = createTask(
+      offers2.get()[0].slave_id(), resources, "touch created", None(), "", "2");
+
+  driver.launchTasks(offers2.get()[0].id(), {task2});
+
+  AWAIT_READY(statusRunning2);
+  EXPECT_EQ(TASK_RUNNING, statusRunning2.get().state());
+
+  AWAIT_READY(statusFinished2);
+  EXPECT_EQ(TASK_FINISHED, statusFinished2.get().state());
+
+  Future<hashset<ContainerID>> containers = containerizer.get()->containers();
+  AWAIT_READY(containers);
+  EXPECT_EQ(1u, containers.get().size());
+
+  // The command executor is named after its first task.
+  ExecutorID executorId;
+  executorId.set_value(task1.task_id().value());
+
+  const string directory = paths::getExecutorLatestRunPath(
+      flags.work_dir,
+      offers1.get()[0].slave_id(),
+      frameworkId.get(),
+      executorId);
+
+  EXPECT_TRUE(os::exists(path::join(directory, "tasks", "1", "created")));
+  EXPECT_TRUE(os::exists(path::join(directory, "tasks", "2", "created")));
+  EXPECT_TRUE(os::exists(path::join(directory, "tasks", "2", "stdout")));
+  EXPECT_FALSE(os::exists(path::join(directory, "created")));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
+// An idle command executor shuts down once no task was launched on
+// it within '--command_executor_idle_timeout'.
+TEST_F(SlaveTest, CommandExecutorIdleTimeout)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.isolation = "posix/cpu,posix/mem";
+  flags.command_executor_idle_timeout = Milliseconds(100);
+
+  Fetcher fetcher;
+
+  Try<MesosContainerizer*> containerizer =
+    MesosContainerizer::create(flags, false, &fetcher);
+  CHECK_SOME(containerizer);
+
+  Try<PID<Slave>> slave = StartSlave(containerizer.get(), flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Future<TaskStatus> statusRunning;
+  Future<TaskStatus> statusFinished;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&statusRunning))
+    .WillOnce(FutureArg<1>(&statusFinished));
+
+  Future<ExitedExecutorMessage> exitedExecutor =
+    FUTURE_PROTOBUF(ExitedExecutorMessage(), _, _);
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "exit 0");
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(statusRunning);
+  EXPECT_EQ(TASK_RUNNING, statusRunning.get().state());
+
+  AWAIT_READY(statusFinished);
+  EXPECT_EQ(TASK_FINISHED, statusFinished.get().state());
+
+  // The executor exits by itself, rather than being shut down.
+  AWAIT_READY(exitedExecutor);
+  EXPECT_TRUE(WIFEXITED(exitedExecutor.get().status()));
+  EXPECT_EQ(0, WEXITSTATUS(exitedExecutor.get().status()));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
+// If the idle timer of a command executor fires just as the slave
+// picks the executor for a task (i.e., before the executor gets the
+// task), the executor exits and the task fails rather than waiting
+// for an executor which is gone.
+TEST_F(SlaveTest, CommandExecutorIdleTimeoutRace)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.isolation = "posix/cpu,posix/mem";
+  flags.command_executor_idle_timeout = Seconds(1);
+
+  Fetcher fetcher;
+
+  Try<MesosContainerizer*> containerizer =
+    MesosContainerizer::create(flags, false, &fetcher);
+  CHECK_SOME(containerizer);
+
+  Try<PID<Slave>> slave = StartSlave(containerizer.get(), flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers1;
+  Future<vector<Offer>> offers2;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers1))
+    .WillOnce(FutureArg<1>(&offers2))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Future<TaskStatus> statusRunning1;
+  Future<TaskStatus> statusFinished1;
+  Future<TaskStatus> statusFailed2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&statusRunning1))
+    .WillOnce(FutureArg<1>(&statusFinished1))
+    .WillOnce(FutureArg<1>(&statusFailed2));
+
+  driver.start();
+
+  AWAIT_READY(offers1);
+  EXPECT_NE(0u, offers1.get().size());
+
+  const Resources resources = Resources::parse("cpus:1;mem:128").get();
+
+  TaskInfo task1 = createTask(
+      offers1.get()[0].slave_id(), resources, "exit 0", None(), "", "1");
+
+  driver.launchTasks(offers1.get()[0].id(), {task1});
+
+  AWAIT_READY(statusRunning1);
+  EXPECT_EQ(TASK_RUNNING, statusRunning1.get().state());
+
+  AWAIT_READY(statusFinished1);
+  EXPECT_EQ(TASK_FINISHED, statusFinished1.get().state());
+
+  AWAIT_READY(offers2);
+  EXPECT_NE(0u, offers2.get().size());
+
+  // Drop the second task on its way from the slave to the idle
+  // executor, as if the idle timer fired before the executor got it.
+  Future<RunTaskMessage> runTask =
+    DROP_PROTOBUF(RunTaskMessage(), slave.get(), _);
+
+  TaskInfo task2 = createTask(
+      offers2.get()[0].slave_id(), resources, "exit 0", None(), "", "2");
+
+  driver.launchTasks(offers2.get()[0].id(), {task2});
+
+  AWAIT_READY(runTask);
+  EXPECT_EQ(task2.task_id(), runTask.get().task().task_id());
+
+  AWAIT_READY(statusFailed2);
+  EXPECT_EQ(task2.task_id(), statusFailed2.get().task_id());
+  EXPECT_EQ(TASK_FAILED, statusFailed2.get().state());
+  EXPECT_EQ(TaskStatus::SOURCE_SLAVE, statusFailed2.get().source());
+  EXPECT_EQ(TaskStatus::REASON_COMMAND_EXECUTOR_FAILED,
+            statusFailed2.get().reason());
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
 // Don't let args from the CommandInfo struct bleed over into
 // mesos-executor forking. For more details of this see MESOS-1873.
 TEST_F(SlaveTest, GetExecutorInfo)
@@ -1020,6 +1293,155 @@ TEST_F(SlaveTest, StateEndpoint)
 }
 
 
+// This test verifies that the state endpoint only includes the
+// frameworks that changed after the state version given by 'since'.
+TEST_F(SlaveTest, StateEndpointSince)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(_, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "sleep 1000", exec.id);
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  Future<http::Response> response = http::get(slave.get(), "state.json");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Object> state = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(state);
+
+  Result<JSON::Number> stateVersion =
+    state.get().find<JSON::Number>("state_version");
+  ASSERT_SOME(stateVersion);
+
+  Result<JSON::Array> frameworks = state.get().find<JSON::Array>("frameworks");
+  ASSERT_SOME(frameworks);
+  EXPECT_EQ(1u, frameworks.get().values.size());
+
+  const string version =
+    stringify(static_cast<uint64_t>(stateVersion.get().value));
+
+  // Nothing changed since.
+  response = http::get(slave.get(), "state.json", "since=" + version);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  state = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(state);
+
+  frameworks = state.get().find<JSON::Array>("frameworks");
+  ASSERT_SOME(frameworks);
+  EXPECT_TRUE(frameworks.get().values.empty());
+  EXPECT_EQ(0u, state.get().values.count("flags"));
+
+  // Everything changed since the beginning.
+  response = http::get(slave.get(), "state.json", "since=0");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  state = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(state);
+
+  frameworks = state.get().find<JSON::Array>("frameworks");
+  ASSERT_SOME(frameworks);
+  EXPECT_EQ(1u, frameworks.get().values.size());
+
+  response = http::get(slave.get(), "state.json", "since=abc");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::BadRequest().status, response);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
+// This test verifies that the state endpoint responds to a
+// conditional request with '304 Not Modified' until the state of the
+// slave changes.
+TEST_F(SlaveTest, StateEndpointNotModified)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  Future<http::Response> response = http::get(slave.get(), "state.json");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Option<string> etag = response.get().headers.get("ETag");
+  ASSERT_SOME(etag);
+
+  hashmap<string, string> headers;
+  headers["If-None-Match"] = etag.get();
+
+  response = http::get(slave.get(), "state.json", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::NotModified().status, response);
+  EXPECT_TRUE(response.get().body.empty());
+  EXPECT_SOME_EQ(etag.get(), response.get().headers.get("ETag"));
+
+  // The slave notices that the master went away.
+  Stop(master.get());
+
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  response = http::get(slave.get(), "state.json", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  EXPECT_NE(etag, response.get().headers.get("ETag"));
+
+  Shutdown();
+}
+
+
 // This test ensures that when a slave is shutting down, it will not
 // try to re-register with the master.
 TEST_F(SlaveTest, TerminatingSlaveDoesNotReregister)
@@ -1274,9 +1696,70 @@ TEST_F(SlaveTest, ContainerUpdatedBeforeTaskReachesExecutor)
 }
 
 
-// This test verifies the slave will destroy a container if updating
-// the container's resources fails during task launch.
-TEST_F(SlaveTest, TaskLaunchContainerizerUpdateFails)
+// This test verifies that the tasks queued for a registering
+// executor are sent along with its registration rather than as
+// separate messages.
+TEST_F(SlaveTest, QueuedTasksSentWithExecutorRegistration)
+{
+  // Start a master.
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  // Start a slave.
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(_, _, _));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 1, "1", "128", "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Future<ExecutorRegisteredMessage> executorRegisteredMessage =
+    FUTURE_PROTOBUF(ExecutorRegisteredMessage(), slave.get(), _);
+
+  EXPECT_NO_FUTURE_PROTOBUFS(RunTaskMessage(), slave.get(), _);
+
+  Sequence sequence;
+
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .InSequence(sequence);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .InSequence(sequence)
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.start();
+
+  AWAIT_READY(executorRegisteredMessage);
+  ASSERT_EQ(1, executorRegisteredMessage.get().tasks_size());
+  EXPECT_EQ("1", executorRegisteredMessage.get().tasks(0).task_id().value());
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// This test verifies the slave will destroy a container if updating
+// the container's resources fails during task launch.
+TEST_F(SlaveTest, TaskLaunchContainerizerUpdateFails)
 {
   // Start a master.
   Try<PID<Master>> master = StartMaster();
@@ -1897,6 +2380,401 @@ TEST_F(SlaveTest, TaskLabels)
   Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
 }
 
+
+// This test verifies that the master handles a batch of status
+// updates from a slave and forwards the acknowledgements back.
+TEST_F(SlaveTest, BatchedStatusUpdates)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+  Offer offer = offers.get()[0];
+
+  vector<TaskInfo> tasks;
+
+  tasks.push_back(createTask(
+      offer.slave_id(),
+      Resources::parse("cpus:0.1;mem:32").get(),
+      "sleep 1000",
+      exec.id));
+
+  tasks.push_back(createTask(
+      offer.slave_id(),
+      Resources::parse("cpus:0.1;mem:32").get(),
+      "sleep 1000",
+      exec.id));
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  // Drop the updates forwarded by the slave so that they can be sent
+  // to the master as a single batch below.
+  Future<StatusUpdateMessage> update1 =
+    DROP_PROTOBUF(StatusUpdateMessage(), slave.get(), master.get());
+
+  Future<StatusUpdateMessage> update2 =
+    DROP_PROTOBUF(StatusUpdateMessage(), slave.get(), master.get());
+
+  driver.launchTasks(offer.id(), tasks);
+
+  AWAIT_READY(update1);
+  AWAIT_READY(update2);
+
+  Future<TaskStatus> status1, status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  Future<Nothing> acknowledgement1 =
+    FUTURE_DISPATCH(_, &Slave::_statusUpdateAcknowledgement);
+
+  Future<Nothing> acknowledgement2 =
+    FUTURE_DISPATCH(_, &Slave::_statusUpdateAcknowledgement);
+
+  StatusUpdatesMessage updates;
+  updates.add_updates()->CopyFrom(update1.get());
+  updates.add_updates()->CopyFrom(update2.get());
+
+  process::post(slave.get(), master.get(), updates);
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1.get().state());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_RUNNING, status2.get().state());
+
+  // The acknowledgements for both updates reach the slave, batched or
+  // not depending on when the master receives them.
+  AWAIT_READY(acknowledgement1);
+  AWAIT_READY(acknowledgement2);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
+// This test verifies that the status updates an executor sends in a
+// burst are batched, and that a superseded non-terminal update is
+// never sent to the slave.
+TEST_F(SlaveTest, BatchedExecutorStatusUpdates)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.executor_status_update_batch_size = 10;
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer, flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  // The updates are sent while the executor is still handling the
+  // task, so they are both batched.
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(Invoke([](ExecutorDriver* driver, const TaskInfo& task) {
+      TaskStatus status;
+      status.mutable_task_id()->CopyFrom(task.task_id());
+
+      status.set_state(TASK_RUNNING);
+      driver->sendStatusUpdate(status);
+
+      status.set_state(TASK_FINISHED);
+      driver->sendStatusUpdate(status);
+    }));
+
+  Future<StatusUpdateMessage> update =
+    FUTURE_PROTOBUF(StatusUpdateMessage(), _, slave.get());
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  // Only the TASK_FINISHED update reaches the slave.
+  AWAIT_READY(update);
+  EXPECT_EQ(TASK_FINISHED, update.get().update().status().state());
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_FINISHED, status.get().state());
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
+// Tests that container logs are rotated once they reach the maximum
+// size and that only the configured number of segments is kept.
+TEST_F(SlaveTest, RotateContainerLogs)
+{
+  const string path = path::join(os::getcwd(), "stdout");
+
+  ASSERT_SOME(os::write(path, "1234"));
+
+  // Too small to be rotated.
+  EXPECT_SOME_FALSE(slave::logs::rotate(path, Bytes(5), 2, false));
+
+  ASSERT_SOME(os::write(path, "12345"));
+  EXPECT_SOME_TRUE(slave::logs::rotate(path, Bytes(5), 2, false));
+
+  EXPECT_SOME_EQ("", os::read(path));
+  EXPECT_SOME_EQ("12345", os::read(path + ".1"));
+
+  ASSERT_SOME(os::write(path, "abcde"));
+  EXPECT_SOME_TRUE(slave::logs::rotate(path, Bytes(5), 2, false));
+
+  ASSERT_SOME(os::write(path, "ABCDE"));
+  EXPECT_SOME_TRUE(slave::logs::rotate(path, Bytes(5), 2, false));
+
+  EXPECT_SOME_EQ("ABCDE", os::read(path + ".1"));
+  EXPECT_SOME_EQ("abcde", os::read(path + ".2"));
+  EXPECT_FALSE(os::exists(path + ".3"));
+}
+
+
+// Tests that rotating container logs doesn't touch files outside of
+// the sandbox that the task points the logs or their backups to.
+TEST_F(SlaveTest, RotateContainerLogsSymlinks)
+{
+  const string target = path::join(os::getcwd(), "target");
+  ASSERT_SOME(os::write(target, "precious"));
+
+  // Quotes in the path must not matter either.
+  const string sandbox = path::join(os::getcwd(), "sand'box");
+  ASSERT_SOME(os::mkdir(sandbox));
+
+  const string path = path::join(sandbox, "stdout");
+
+  // The log itself is a symlink.
+  ASSERT_SOME(fs::symlink(target, path));
+
+  EXPECT_ERROR(slave::logs::rotate(path, Bytes(5), 2, false));
+  EXPECT_SOME_EQ("precious", os::read(target));
+  EXPECT_FALSE(os::exists(path + ".1"));
+
+  // The backups are symlinks.
+  ASSERT_SOME(os::rm(path));
+  ASSERT_SOME(os::write(path, "12345"));
+  ASSERT_SOME(fs::symlink(target, path + ".1"));
+  ASSERT_SOME(fs::symlink(target, path + ".1.gz"));
+
+  EXPECT_SOME_TRUE(slave::logs::rotate(path, Bytes(5), 1, true));
+  EXPECT_SOME_EQ("precious", os::read(target));
+  EXPECT_SOME_EQ("", os::read(path));
+  EXPECT_FALSE(os::exists(path + ".1"));
+
+  Try<string> compressed = os::read(path + ".1.gz");
+  ASSERT_SOME(compressed);
+  EXPECT_SOME_EQ("12345", gzip::decompress(compressed.get()));
+
+  EXPECT_FALSE(os::stat::islink(path + ".1.gz"));
+}
+
+
+class Slave_BENCHMARK_Test : public MesosTest {};
+
+
+// This benchmark measures how long a slave takes from being started
+// until it is registered with the master, both when started afresh
+// and when restarted, i.e., when it also recovers its checkpointed
+// state before re-registering.
+TEST_F(Slave_BENCHMARK_Test, Startup)
+{
+  const size_t restarts = 10;
+
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  slave::Flags flags = CreateSlaveFlags();
+
+  Future<SlaveRegisteredMessage> registered =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+
+  Stopwatch watch;
+  watch.start();
+
+  Try<PID<Slave>> slave = StartSlave(flags);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(registered);
+
+  Duration elapsed = watch.elapsed();
+  LOG(INFO) << "Registered the slave in " << elapsed;
+  RecordProperty("slave_registration_ms", stringify(elapsed.ms()));
+
+  elapsed = Duration::zero();
+  for (size_t i = 0; i < restarts; i++) {
+    Stop(slave.get());
+
+    Future<SlaveReregisteredMessage> reregistered =
+      FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), _);
+
+    watch.start();
+
+    slave = StartSlave(flags);
+    ASSERT_SOME(slave);
+
+    AWAIT_READY(reregistered);
+
+    elapsed += watch.elapsed();
+  }
+
+  LOG(INFO) << "Re-registered the restarted slave in "
+            << elapsed / restarts << " on average over "
+            << restarts << " restarts";
+  RecordProperty(
+      "slave_reregistration_ms", stringify((elapsed / restarts).ms()));
+
+  Shutdown();
+}
+
+
+// This benchmark measures how many tasks a slave launches per second
+// when they are all launched at once on the same executor, i.e.,
+// from the tasks being sent to the master until the scheduler got
+// all the TASK_RUNNING updates.
+TEST_F(Slave_BENCHMARK_Test, LaunchThroughput)
+{
+  const size_t taskCount = 1000;
+
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  slave::Flags flags = CreateSlaveFlags();
+  flags.resources = "cpus:" + stringify(taskCount) +
+                    ";mem:" + stringify(taskCount * 32);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer, flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_EQ(1u, offers.get().size());
+
+  vector<TaskInfo> tasks;
+  for (size_t i = 0; i < taskCount; i++) {
+    TaskInfo task;
+    task.set_name("");
+    task.mutable_task_id()->set_value(stringify(i));
+    task.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+    task.mutable_resources()->MergeFrom(
+        Resources::parse("cpus:1;mem:32").get());
+    task.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+
+    tasks.push_back(task);
+  }
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  // The scheduler driver invokes the callbacks one at a time.
+  size_t running = 0;
+  Promise<Nothing> allRunning;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillRepeatedly(Invoke([&](SchedulerDriver*, const TaskStatus& status) {
+      if (status.state() == TASK_RUNNING && ++running == taskCount) {
+        allRunning.set(Nothing());
+      }
+    }));
+
+  Stopwatch watch;
+  watch.start();
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY_FOR(allRunning.future(), Minutes(5));
+
+  Duration elapsed = watch.elapsed();
+  LOG(INFO) << "Launched " << taskCount << " tasks in " << elapsed
+            << " (" << taskCount / elapsed.secs() << " tasks/sec)";
+  RecordProperty(
+      "task_launches_per_sec", stringify(taskCount / elapsed.secs()));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
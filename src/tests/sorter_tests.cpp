@@ -27,16 +27,22 @@
 #include <mesos/resources.hpp>
 
 #include <stout/gtest.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 
+#include "master/allocator/sorter/bucketed/sorter.hpp"
 #include "master/allocator/sorter/drf/sorter.hpp"
 
 #include "tests/mesos.hpp"
 
+using mesos::internal::master::allocator::BucketedDRFSorter;
 using mesos::internal::master::allocator::DRFSorter;
 
 using std::list;
 using std::string;
 
+using testing::WithParamInterface;
+
 namespace mesos {
 namespace internal {
 namespace tests {
@@ -407,6 +413,164 @@ TEST(SorterTest, RevocableResources)
   EXPECT_EQ("b", sorted.back());
 }
 
+
+// This test verifies that the bucketed sorter sorts the clients by
+// their share, up to its resolution, and the clients with the same
+// (approximate) share by when they were last allocated to.
+TEST(SorterTest, BucketedDRFSorter)
+{
+  // Shares are approximated to a multiple of 0.01.
+  BucketedDRFSorter sorter(100);
+
+  SlaveID slaveId;
+  slaveId.set_value("slaveId");
+
+  sorter.add(slaveId, Resources::parse("cpus:100;mem:100").get());
+
+  sorter.add("a");
+  sorter.allocated("a", slaveId, Resources::parse("cpus:5;mem:5").get());
+
+  sorter.add("b");
+  sorter.allocated("b", slaveId, Resources::parse("cpus:1;mem:1").get());
+
+  sorter.add("c");
+  sorter.allocated("c", slaveId, Resources::parse("cpus:3;mem:1").get());
+
+  // shares: a = .05, b = .01, c = .03
+  EXPECT_EQ(list<string>({"b", "c", "a"}), sorter.sort());
+
+  // Shares that differ by less than the resolution are considered
+  // the same, so "c" goes after "a" as it was allocated to last.
+  sorter.allocated("c", slaveId, Resources::parse("cpus:2.5").get());
+
+  // shares: a = .05, b = .01, c = .055
+  EXPECT_EQ(list<string>({"b", "a", "c"}), sorter.sort());
+
+  // Now "a" was allocated to last, despite its smaller share.
+  sorter.allocated("a", slaveId, Resources::parse("cpus:0.1").get());
+
+  // shares: a = .051, b = .01, c = .055
+  EXPECT_EQ(list<string>({"b", "c", "a"}), sorter.sort());
+
+  // A change of the total resources recalculates all shares.
+  sorter.add(slaveId, Resources::parse("cpus:100;mem:100").get());
+
+  // shares: a = .0255, b = .005, c = .0275
+  EXPECT_EQ(list<string>({"b", "c", "a"}), sorter.sort());
+
+  sorter.unallocated("c", slaveId, Resources::parse("cpus:5").get());
+
+  // shares: a = .0255, b = .005, c = .005
+  EXPECT_EQ(list<string>({"b", "c", "a"}), sorter.sort());
+
+  sorter.deactivate("b");
+  EXPECT_EQ(list<string>({"c", "a"}), sorter.sort());
+
+  sorter.activate("b");
+  EXPECT_EQ(list<string>({"b", "c", "a"}), sorter.sort());
+
+  sorter.remove("c");
+  EXPECT_FALSE(sorter.contains("c"));
+  EXPECT_EQ(2, sorter.count());
+  EXPECT_EQ(list<string>({"b", "a"}), sorter.sort());
+}
+
+
+class Sorter_BENCHMARK_Test : public ::testing::Test,
+                              public WithParamInterface<size_t>
+{};
+
+
+// The sorter benchmark tests are parameterized by the number of clients.
+INSTANTIATE_TEST_CASE_P(
+    ClientCount,
+    Sorter_BENCHMARK_Test,
+    ::testing::Values(1000U, 5000U, 10000U));
+
+
+// This benchmark simulates the allocator making one allocation after
+// every sort as well as recalculating all of the shares after the
+// total resources have changed.
+template <typename T>
+static void fullSort(size_t clientCount)
+{
+  T sorter;
+
+  const size_t slaveCount = 1000;
+
+  Resources total = Resources::parse("cpus:24;mem:4096;disk:4096").get();
+
+  for (size_t i = 0; i < slaveCount; i++) {
+    SlaveID slaveId;
+    slaveId.set_value("slave" + stringify(i));
+
+    sorter.add(slaveId, total);
+  }
+
+  Resources resources = Resources::parse("cpus:1;mem:128;disk:128").get();
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < clientCount; i++) {
+    const string name = "framework" + stringify(i);
+
+    SlaveID slaveId;
+    slaveId.set_value("slave" + stringify(i % slaveCount));
+
+    sorter.add(name);
+    sorter.allocated(name, slaveId, resources);
+  }
+
+  LOG(INFO) << "Added " << clientCount << " clients in " << watch.elapsed();
+
+  watch.start();
+
+  const size_t allocationCount = 1000;
+
+  for (size_t i = 0; i < allocationCount; i++) {
+    list<string> sorted = sorter.sort();
+    ASSERT_EQ(clientCount, sorted.size());
+
+    SlaveID slaveId;
+    slaveId.set_value("slave" + stringify(i % slaveCount));
+
+    sorter.allocated(sorted.front(), slaveId, resources);
+  }
+
+  LOG(INFO) << "Sorted " << clientCount << " clients " << allocationCount
+            << " times in " << watch.elapsed();
+
+  watch.start();
+
+  const size_t updateCount = 100;
+
+  for (size_t i = 0; i < updateCount; i++) {
+    SlaveID slaveId;
+    slaveId.set_value("slave" + stringify(i % slaveCount));
+
+    sorter.update(slaveId, i % 2 == 0 ? total + resources : total);
+
+    list<string> sorted = sorter.sort();
+    ASSERT_EQ(clientCount, sorted.size());
+  }
+
+  LOG(INFO) << "Recalculated shares for " << clientCount << " clients "
+            << updateCount << " times in " << watch.elapsed();
+}
+
+
+TEST_P(Sorter_BENCHMARK_Test, FullSort)
+{
+  fullSort<DRFSorter>(GetParam());
+}
+
+
+TEST_P(Sorter_BENCHMARK_Test, FullSortBucketed)
+{
+  fullSort<BucketedDRFSorter>(GetParam());
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -326,6 +326,88 @@ void Names(State* state)
 }
 
 
+void FetchAndStoreBatch(state::State* state)
+{
+  vector<string> names;
+  names.push_back("slaves");
+  names.push_back("frameworks");
+
+  Future<vector<state::Variable> > future1 = state->fetch(names);
+  AWAIT_READY(future1);
+  ASSERT_EQ(2u, future1.get().size());
+  EXPECT_EQ("", future1.get()[0].value());
+  EXPECT_EQ("", future1.get()[1].value());
+
+  vector<state::Variable> variables;
+  variables.push_back(future1.get()[0].mutate("1"));
+  variables.push_back(future1.get()[1].mutate("2"));
+
+  Future<Option<vector<state::Variable> > > future2 = state->store(variables);
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+  ASSERT_EQ(2u, future2.get().get().size());
+
+  // The second variable is stale, so neither of them gets stored.
+  vector<state::Variable> stale;
+  stale.push_back(future2.get().get()[0].mutate("3"));
+  stale.push_back(variables[1].mutate("4"));
+
+  future2 = state->store(stale);
+  AWAIT_READY(future2);
+  EXPECT_NONE(future2.get());
+
+  future1 = state->fetch(names);
+  AWAIT_READY(future1);
+  ASSERT_EQ(2u, future1.get().size());
+  EXPECT_EQ("1", future1.get()[0].value());
+  EXPECT_EQ("2", future1.get()[1].value());
+}
+
+
+void StoreAndExpungeBatch(state::State* state)
+{
+  vector<string> names;
+  names.push_back("slaves");
+  names.push_back("frameworks");
+
+  Future<vector<state::Variable> > future1 = state->fetch(names);
+  AWAIT_READY(future1);
+  ASSERT_EQ(2u, future1.get().size());
+
+  vector<state::Variable> variables;
+  variables.push_back(future1.get()[0].mutate("1"));
+  variables.push_back(future1.get()[1].mutate("2"));
+
+  Future<Option<vector<state::Variable> > > future2 = state->store(variables);
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  // The second variable is stale, so neither of them gets expunged.
+  vector<state::Variable> stale;
+  stale.push_back(future2.get().get()[0]);
+  stale.push_back(variables[1]);
+
+  Future<bool> future3 = state->expunge(stale);
+  AWAIT_READY(future3);
+  EXPECT_FALSE(future3.get());
+
+  future3 = state->expunge(future2.get().get());
+  AWAIT_READY(future3);
+  EXPECT_TRUE(future3.get());
+
+  Future<set<string> > future4 = state->names();
+  AWAIT_READY(future4);
+  EXPECT_TRUE(future4.get().empty());
+
+  // A variable can only be in a batch once.
+  variables.clear();
+  variables.push_back(future1.get()[0]);
+  variables.push_back(future1.get()[0]);
+
+  AWAIT_FAILED(state->store(variables));
+}
+
+
 class InMemoryStateTest : public ::testing::Test
 {
 public:
@@ -393,6 +475,18 @@ TEST_F(InMemoryStateTest, Names)
 }
 
 
+TEST_F(InMemoryStateTest, FetchAndStoreBatch)
+{
+  FetchAndStoreBatch(state);
+}
+
+
+TEST_F(InMemoryStateTest, StoreAndExpungeBatch)
+{
+  StoreAndExpungeBatch(state);
+}
+
+
 class LevelDBStateTest : public ::testing::Test
 {
 public:
@@ -466,6 +560,18 @@ TEST_F(LevelDBStateTest, Names)
 }
 
 
+TEST_F(LevelDBStateTest, FetchAndStoreBatch)
+{
+  FetchAndStoreBatch(state);
+}
+
+
+TEST_F(LevelDBStateTest, StoreAndExpungeBatch)
+{
+  StoreAndExpungeBatch(state);
+}
+
+
 class LogStateTest : public TemporaryDirectoryTest
 {
 public:
@@ -565,6 +671,18 @@ TEST_F(LogStateTest, Names)
 }
 
 
+TEST_F(LogStateTest, FetchAndStoreBatch)
+{
+  FetchAndStoreBatch(state);
+}
+
+
+TEST_F(LogStateTest, StoreAndExpungeBatch)
+{
+  StoreAndExpungeBatch(state);
+}
+
+
 Future<Option<Variable<Slaves> > > timeout(
     Future<Option<Variable<Slaves> > > future)
 {
@@ -686,6 +804,90 @@ TEST_F(LogStateTest, Diff)
 }
 
 
+// This test verifies that the log gets compacted when an entry that
+// doesn't get set keeps the log from being truncated, and that the
+// state can still be read after compacting.
+TEST_F(LogStateTest, Compaction)
+{
+  // Replace the storage with one that compacts after 10 obsolete
+  // entries (and doesn't write any diffs).
+  delete state;
+  delete storage;
+
+  storage = new state::LogStorage(log, 0, 10);
+  state = new State(storage);
+
+  Slaves slaves;
+  slaves.add_slaves()->mutable_info()->set_hostname("old");
+
+  Future<Variable<Slaves> > future1 = state->fetch<Slaves>("old");
+  AWAIT_READY(future1);
+
+  Future<Option<Variable<Slaves> > > future2 =
+    state->store(future1.get().mutate(slaves));
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  Future<Variable<Slaves> > future3 = state->fetch<Slaves>("new");
+  AWAIT_READY(future3);
+
+  Variable<Slaves> variable = future3.get();
+
+  for (size_t i = 0; i < 50; i++) {
+    slaves.mutable_slaves(0)->mutable_info()->set_hostname(
+        "new" + stringify(i));
+
+    Future<Option<Variable<Slaves> > > future4 =
+      state->store(variable.mutate(slaves));
+    AWAIT_READY(future4);
+    ASSERT_SOME(future4.get());
+
+    variable = future4.get().get();
+  }
+
+  // Wait for any asynchronous truncation (see the 'Diff' test).
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  Log::Reader reader(log);
+
+  Future<Log::Position> beginning = reader.beginning();
+  Future<Log::Position> ending = reader.ending();
+
+  AWAIT_READY(beginning);
+  AWAIT_READY(ending);
+
+  Future<list<Log::Entry> > entries =
+    reader.read(beginning.get(), ending.get());
+
+  AWAIT_READY(entries);
+
+  // Without compacting the log would hold all 51 snapshots since the
+  // snapshot of "old" keeps it from being truncated. With compacting
+  // it holds at most the 2 needed snapshots and 11 obsolete ones.
+  EXPECT_GE(13u, entries.get().size());
+
+  // A new storage must recover the latest values from the compacted
+  // log.
+  delete state;
+  delete storage;
+
+  storage = new state::LogStorage(log);
+  state = new State(storage);
+
+  Future<Variable<Slaves> > future5 = state->fetch<Slaves>("old");
+  AWAIT_READY(future5);
+  ASSERT_EQ(1, future5.get().get().slaves().size());
+  EXPECT_EQ("old", future5.get().get().slaves(0).info().hostname());
+
+  Future<Variable<Slaves> > future6 = state->fetch<Slaves>("new");
+  AWAIT_READY(future6);
+  ASSERT_EQ(1, future6.get().get().slaves().size());
+  EXPECT_EQ("new49", future6.get().get().slaves(0).info().hostname());
+}
+
+
 #ifdef MESOS_HAS_JAVA
 class ZooKeeperStateTest : public tests::ZooKeeperTest
 {
@@ -757,6 +959,61 @@ TEST_F(ZooKeeperStateTest, Names)
 {
   Names(state);
 }
+
+
+TEST_F(ZooKeeperStateTest, FetchAndStoreBatch)
+{
+  FetchAndStoreBatch(state);
+}
+
+
+TEST_F(ZooKeeperStateTest, StoreAndExpungeBatch)
+{
+  StoreAndExpungeBatch(state);
+}
+
+
+// Tests that values that do not fit in a single znode get stored.
+TEST_F(ZooKeeperStateTest, LargeValue)
+{
+  state::State* state = this->state;
+
+  Future<state::Variable> future1 = state->fetch("large");
+  AWAIT_READY(future1);
+
+  const string value(3 * 1024 * 1024, 'x');
+
+  Future<Option<state::Variable> > future2 =
+    state->store(future1.get().mutate(value));
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  future1 = state->fetch("large");
+  AWAIT_READY(future1);
+  EXPECT_EQ(value, future1.get().value());
+
+  // Replace the value with a small one.
+  future2 = state->store(future1.get().mutate("small"));
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  future1 = state->fetch("large");
+  AWAIT_READY(future1);
+  EXPECT_EQ("small", future1.get().value());
+
+  // Now large again, which can then be expunged.
+  future2 = state->store(future1.get().mutate(value));
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  Future<bool> future3 = state->expunge(future2.get().get());
+  AWAIT_READY(future3);
+  EXPECT_TRUE(future3.get());
+
+  Future<std::set<string> > names = state->names();
+  AWAIT_READY(names);
+  EXPECT_TRUE(names.get().empty());
+}
 #endif // MESOS_HAS_JAVA
 
 } // namespace tests {
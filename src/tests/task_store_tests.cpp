@@ -0,0 +1,161 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+
+#include <gmock/gmock.h>
+
+#include <mesos/type_utils.hpp>
+
+#include <stout/gtest.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+
+#include "master/task_store.hpp"
+
+#include "messages/messages.hpp"
+
+#include "tests/utils.hpp"
+
+using mesos::internal::master::CompletedTask;
+using mesos::internal::master::TaskStore;
+
+using std::shared_ptr;
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+
+class TaskStoreTest : public TemporaryDirectoryTest
+{
+protected:
+  static Task createTask(const string& id)
+  {
+    Task task;
+    task.set_name("test-task");
+    task.mutable_task_id()->set_value(id);
+    task.mutable_framework_id()->set_value("framework");
+    task.mutable_slave_id()->set_value("slave");
+    task.set_state(TASK_FINISHED);
+
+    TaskStatus* status = task.add_statuses();
+    status->mutable_task_id()->set_value(id);
+    status->set_state(TASK_FINISHED);
+    status->set_data(string(1024, 'x'));
+
+    return task;
+  }
+};
+
+
+TEST_F(TaskStoreTest, Get)
+{
+  Try<shared_ptr<TaskStore>> store = TaskStore::create("tasks", 10);
+  ASSERT_SOME(store);
+
+  const Task task1 = createTask("1");
+  const Task task2 = createTask("2");
+
+  CompletedTask completed1(task1, store.get());
+  CompletedTask completed2(task2, store.get());
+
+  EXPECT_EQ(task1.task_id(), completed1.task_id());
+  EXPECT_EQ(task1.slave_id(), completed1.slave_id());
+  EXPECT_EQ(TASK_FINISHED, completed1.state());
+
+  Try<shared_ptr<const Task>> task = completed2.get();
+  ASSERT_SOME(task);
+  EXPECT_EQ(task2.SerializeAsString(), task.get()->SerializeAsString());
+
+  task = completed1.get();
+  ASSERT_SOME(task);
+  EXPECT_EQ(task1.SerializeAsString(), task.get()->SerializeAsString());
+
+  // A task that is kept in memory is returned as is.
+  CompletedTask completed3(task1);
+
+  task = completed3.get();
+  ASSERT_SOME(task);
+  EXPECT_EQ(task1.SerializeAsString(), task.get()->SerializeAsString());
+}
+
+
+// This test verifies that a file of the store is removed once none
+// of the tasks in it is referred to anymore.
+TEST_F(TaskStoreTest, RemoveFiles)
+{
+  shared_ptr<TaskStore> store;
+
+  {
+    Try<shared_ptr<TaskStore>> create = TaskStore::create("tasks", 2);
+    ASSERT_SOME(create);
+    store = create.get();
+  }
+
+  shared_ptr<CompletedTask> completed1(
+      new CompletedTask(createTask("1"), store));
+  shared_ptr<CompletedTask> completed2(
+      new CompletedTask(createTask("2"), store));
+  shared_ptr<CompletedTask> completed3(
+      new CompletedTask(createTask("3"), store));
+
+  EXPECT_TRUE(os::exists(path::join("tasks", "tasks.0")));
+  EXPECT_TRUE(os::exists(path::join("tasks", "tasks.1")));
+
+  completed1.reset();
+
+  EXPECT_TRUE(os::exists(path::join("tasks", "tasks.0")));
+
+  completed2.reset();
+
+  EXPECT_FALSE(os::exists(path::join("tasks", "tasks.0")));
+  EXPECT_TRUE(os::exists(path::join("tasks", "tasks.1")));
+
+  // The current file is kept by the store.
+  completed3.reset();
+
+  EXPECT_TRUE(os::exists(path::join("tasks", "tasks.1")));
+
+  store.reset();
+
+  EXPECT_FALSE(os::exists(path::join("tasks", "tasks.1")));
+}
+
+
+// This test verifies that the files left behind by a previous store
+// are removed when a store is created.
+TEST_F(TaskStoreTest, Create)
+{
+  ASSERT_SOME(os::mkdir("tasks"));
+  ASSERT_SOME(os::write(path::join("tasks", "tasks.0"), "stale"));
+  ASSERT_SOME(os::write(path::join("tasks", "other"), "other"));
+
+  Try<shared_ptr<TaskStore>> store = TaskStore::create("tasks", 10);
+  ASSERT_SOME(store);
+
+  EXPECT_FALSE(os::exists(path::join("tasks", "tasks.0")));
+  EXPECT_TRUE(os::exists(path::join("tasks", "other")));
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
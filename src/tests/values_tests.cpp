@@ -102,6 +102,32 @@ TEST(ValuesTest, SetSubtraction)
   EXPECT_EQ(set3, parse("{sda4}").get().set());
 }
 
+
+TEST(ValuesTest, RangesArithmetic)
+{
+  Value::Ranges ranges = parse("[1-10, 20-30, 11-12]").get().ranges();
+
+  // Adjacent and overlapping ranges are coalesced.
+  Value::Ranges sum = ranges + parse("[5-6, 25-40]").get().ranges();
+
+  ASSERT_EQ(2, sum.range_size());
+  EXPECT_EQ(1u, sum.range(0).begin());
+  EXPECT_EQ(12u, sum.range(0).end());
+  EXPECT_EQ(20u, sum.range(1).begin());
+  EXPECT_EQ(40u, sum.range(1).end());
+
+  EXPECT_EQ(parse("[1-4, 7-12, 20-24]").get().ranges(),
+            ranges - parse("[5-6, 25-40]").get().ranges());
+
+  EXPECT_TRUE(parse("[2-12]").get().ranges() <= ranges);
+  EXPECT_FALSE(parse("[2-15]").get().ranges() <= ranges);
+
+  ranges -= parse("[1-12]").get().ranges();
+  ranges += parse("[31-31]").get().ranges();
+
+  EXPECT_EQ(parse("[20-31]").get().ranges(), ranges);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
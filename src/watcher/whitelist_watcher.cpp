@@ -16,6 +16,8 @@
  * limitations under the License.
  */
 
+#include <time.h>
+
 #include <string>
 #include <vector>
 
@@ -26,6 +28,7 @@
 
 #include <stout/foreach.hpp>
 #include <stout/os.hpp>
+#include <stout/os/stat.hpp>
 #include <stout/path.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
@@ -95,12 +98,23 @@ void WhitelistWatcher::watch()
   Option<hashset<string>> whitelist;
 
   CHECK_SOME(path);
+
+  // Skip reading the file if it has not changed since the last read,
+  // in which case the whitelist has not changed either.
+  Option<Stamp> current = stamp();
+
+  if (current.isSome() && current == lastStamp) {
+    delay(watchInterval, self(), &WhitelistWatcher::watch);
+    return;
+  }
+
   Try<string> read = os::read(path.get().value);
 
   if (read.isError()) {
     LOG(ERROR) << "Error reading whitelist file: " << read.error() << ". "
                << "Retrying";
     whitelist = lastWhitelist;
+    current = None();
   } else if (read.get().empty()) {
     VLOG(1) << "Empty whitelist file " << path.get().value;
     whitelist = hashset<string>();
@@ -120,8 +134,38 @@ void WhitelistWatcher::watch()
 
   // Schedule the next check.
   lastWhitelist = whitelist;
+  lastStamp = current;
   delay(watchInterval, self(), &WhitelistWatcher::watch);
 }
 
+Option<WhitelistWatcher::Stamp> WhitelistWatcher::stamp() const
+{
+  CHECK_SOME(path);
+
+  Stamp stamp;
+
+  Try<ino_t> inode = os::stat::inode(path.get().value);
+  Try<long> mtime = os::stat::mtime(path.get().value);
+  Try<Bytes> size = os::stat::size(path.get().value);
+
+  if (inode.isError() || mtime.isError() || size.isError()) {
+    return None();
+  }
+
+  // The modification time has a granularity of a second, so the file
+  // could be modified again in the second it was last modified (and
+  // read) without changing its stamp. We only rely on the stamp once
+  // that second has passed.
+  if (mtime.get() >= ::time(NULL)) {
+    return None();
+  }
+
+  stamp.inode = inode.get();
+  stamp.mtime = mtime.get();
+  stamp.size = size.get();
+
+  return stamp;
+}
+
 } // namespace internal {
 } // namespace mesos {
@@ -19,10 +19,13 @@
 #ifndef __WATCHER_WHITELIST_WATCHER_HPP__
 #define __WATCHER_WHITELIST_WATCHER_HPP__
 
+#include <sys/types.h>
+
 #include <string>
 
 #include <process/process.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
@@ -64,11 +67,31 @@ protected:
   void watch();
 
 private:
+  // Identifies a version of the whitelist file, so that the file is
+  // only read (and parsed) again once it has changed.
+  struct Stamp
+  {
+    bool operator == (const Stamp& that) const
+    {
+      return inode == that.inode && mtime == that.mtime && size == that.size;
+    }
+
+    ino_t inode;
+    long mtime;
+    Bytes size;
+  };
+
+  // Returns the stamp of the whitelist file, or none if the file
+  // cannot be stat'ed or might be modified again without changing
+  // its stamp (see 'watch').
+  Option<Stamp> stamp() const;
+
   const Option<Path> path;
   const Duration watchInterval;
   lambda::function<void(const Option<hashset<std::string>>& whitelist)>
     subscriber;
   Option<hashset<std::string>> lastWhitelist;
+  Option<Stamp> lastStamp;
 };
 
 } // namespace internal {
@@ -26,6 +26,10 @@
   }
 
 
+  // The number of (most recent) tasks shown on the home page.
+  var HOME_TASKS_LIMIT = 1000;
+
+
   function updateInterval(num_slaves) {
     // TODO(bmahler): Increasing the update interval for large clusters
     // is done purely to mitigate webui performance issues. Ideally we can
@@ -50,14 +54,38 @@
   }
 
 
-  // Update the outermost scope with the new state.
-  function update($scope, $timeout, data) {
+  // Whether a task is in a terminal state.
+  function isTerminal(task) {
+    return _.contains(
+        ['TASK_FINISHED', 'TASK_FAILED', 'TASK_KILLED', 'TASK_LOST',
+         'TASK_ERROR'],
+        task.state);
+  }
+
+
+  // Sums the given (JSON modeled) resources.
+  function sumResources(a, b) {
+    var sum = {};
+    _.each(['cpus', 'mem', 'disk'], function(name) {
+      sum[name] = (a[name] || 0) + (b[name] || 0);
+    });
+    return sum;
+  }
+
+
+  // Update the outermost scope with the new state, which consists of
+  // the 'summary' of the state (see /master/state-summary) and, if the
+  // current view needs them, the 'details' of the state (either the
+  // possibly filtered /master/state.json, or /master/tasks.json).
+  function update($scope, $timeout, summary, details) {
+    var data = summary + (details !== null ? details : '');
+
     // Don't do anything if the data hasn't changed.
     if ($scope.data == data) {
       return true; // Continue polling.
     }
 
-    $scope.state = JSON.parse(data);
+    $scope.state = JSON.parse(summary);
 
     // Determine if there is a leader (and redirect if not the leader).
     if ($scope.state.leader) {
@@ -123,12 +151,12 @@
     $scope.offered_cpus = 0;
     $scope.offered_mem = 0;
 
-    $scope.staged_tasks = $scope.state.staged_tasks;
-    $scope.started_tasks = $scope.state.started_tasks;
-    $scope.finished_tasks = $scope.state.finished_tasks;
-    $scope.killed_tasks = $scope.state.killed_tasks;
-    $scope.failed_tasks = $scope.state.failed_tasks;
-    $scope.lost_tasks = $scope.state.lost_tasks;
+    $scope.staged_tasks = 0;
+    $scope.started_tasks = 0;
+    $scope.finished_tasks = 0;
+    $scope.killed_tasks = 0;
+    $scope.failed_tasks = 0;
+    $scope.lost_tasks = 0;
 
     $scope.activated_slaves = $scope.state.activated_slaves;
     $scope.deactivated_slaves = $scope.state.deactivated_slaves;
@@ -139,30 +167,23 @@
       $scope.total_mem += slave.resources.mem;
     });
 
-    var setTaskMetadata = function(task) {
-      if (!task.executor_id) {
-        task.executor_id = task.id;
-      }
-      if (task.statuses.length > 0) {
-        task.start_time = task.statuses[0].timestamp * 1000;
-        task.finish_time =
-          task.statuses[task.statuses.length - 1].timestamp * 1000;
-      }
-    };
-
     _.each($scope.state.frameworks, function(framework) {
       $scope.frameworks[framework.id] = framework;
 
-      _.each(framework.offers, function(offer) {
-        $scope.offers[offer.id] = offer;
-        $scope.offered_cpus += offer.resources.cpus;
-        $scope.offered_mem += offer.resources.mem;
-        offer.framework_name = $scope.frameworks[offer.framework_id].name;
-        offer.hostname = $scope.slaves[offer.slave_id].hostname;
-      });
+      framework.resources =
+        sumResources(framework.used_resources, framework.offered_resources);
+
+      $scope.used_cpus += framework.used_resources.cpus;
+      $scope.used_mem += framework.used_resources.mem;
+      $scope.offered_cpus += framework.offered_resources.cpus;
+      $scope.offered_mem += framework.offered_resources.mem;
 
-      $scope.used_cpus += framework.resources.cpus;
-      $scope.used_mem += framework.resources.mem;
+      $scope.staged_tasks += framework.TASK_STAGING;
+      $scope.started_tasks += framework.TASK_STARTING + framework.TASK_RUNNING;
+      $scope.finished_tasks += framework.TASK_FINISHED;
+      $scope.killed_tasks += framework.TASK_KILLED;
+      $scope.failed_tasks += framework.TASK_FAILED;
+      $scope.lost_tasks += framework.TASK_LOST;
 
       framework.cpus_share = 0;
       if ($scope.total_cpus > 0) {
@@ -175,30 +196,69 @@
       }
 
       framework.max_share = Math.max(framework.cpus_share, framework.mem_share);
+    });
 
-      // If the executor ID is empty, this is a command executor with an
-      // internal executor ID generated from the task ID.
-      // TODO(brenden): Remove this once
-      // https://issues.apache.org/jira/browse/MESOS-527 is fixed.
-      _.each(framework.tasks, setTaskMetadata);
-      _.each(framework.completed_tasks, setTaskMetadata);
+    $scope.idle_cpus = $scope.total_cpus - ($scope.offered_cpus + $scope.used_cpus);
+    $scope.idle_mem = $scope.total_mem - ($scope.offered_mem + $scope.used_mem);
 
-      $scope.active_tasks = $scope.active_tasks.concat(framework.tasks);
-      $scope.completed_tasks =
-        $scope.completed_tasks.concat(framework.completed_tasks);
-    });
+    if (details !== null) {
+      details = JSON.parse(details);
 
-    _.each($scope.state.completed_frameworks, function(framework) {
-      $scope.completed_frameworks[framework.id] = framework;
+      var setTaskMetadata = function(task) {
+        if (!task.executor_id) {
+          task.executor_id = task.id;
+        }
+        if (task.statuses.length > 0) {
+          task.start_time = task.statuses[0].timestamp * 1000;
+          task.finish_time =
+            task.statuses[task.statuses.length - 1].timestamp * 1000;
+        }
+      };
 
-      _.each(framework.completed_tasks, setTaskMetadata);
-    });
+      // The (most recent) tasks of /master/tasks.json.
+      _.each(details.tasks, function(task) {
+        setTaskMetadata(task);
 
-    $scope.used_cpus -= $scope.offered_cpus;
-    $scope.used_mem -= $scope.offered_mem;
+        if (isTerminal(task)) {
+          $scope.completed_tasks.push(task);
+        } else {
+          $scope.active_tasks.push(task);
+        }
+      });
 
-    $scope.idle_cpus = $scope.total_cpus - ($scope.offered_cpus + $scope.used_cpus);
-    $scope.idle_mem = $scope.total_mem - ($scope.offered_mem + $scope.used_mem);
+      // The frameworks of /master/state.json, which add the tasks and
+      // offers (among other things) to the summarized frameworks.
+      _.each(details.frameworks, function(framework) {
+        if (framework.id in $scope.frameworks) {
+          framework = _.extend($scope.frameworks[framework.id], framework);
+        } else {
+          $scope.frameworks[framework.id] = framework;
+        }
+
+        _.each(framework.offers, function(offer) {
+          $scope.offers[offer.id] = offer;
+          offer.framework_name = framework.name;
+          offer.hostname = $scope.slaves[offer.slave_id].hostname;
+        });
+
+        // If the executor ID is empty, this is a command executor with an
+        // internal executor ID generated from the task ID.
+        // TODO(brenden): Remove this once
+        // https://issues.apache.org/jira/browse/MESOS-527 is fixed.
+        _.each(framework.tasks, setTaskMetadata);
+        _.each(framework.completed_tasks, setTaskMetadata);
+
+        $scope.active_tasks = $scope.active_tasks.concat(framework.tasks);
+        $scope.completed_tasks =
+          $scope.completed_tasks.concat(framework.completed_tasks);
+      });
+
+      _.each(details.completed_frameworks, function(framework) {
+        $scope.completed_frameworks[framework.id] = framework;
+
+        _.each(framework.completed_tasks, setTaskMetadata);
+      });
+    }
 
     $scope.time_since_update = 0;
     $scope.$broadcast('state_updated');
@@ -214,8 +274,8 @@
   // active controller/view to easily access anything in scope (e.g.,
   // the state).
   mesosApp.controller('MainCntl', [
-      '$scope', '$http', '$location', '$timeout', '$modal',
-      function($scope, $http, $location, $timeout, $modal) {
+      '$scope', '$http', '$location', '$q', '$timeout', '$modal',
+      function($scope, $http, $location, $q, $timeout, $modal) {
     $scope.doneLoading = true;
 
     // Adding bindings into scope so that they can be used from within
@@ -275,16 +335,79 @@
       if (!matched) $scope.navbarActiveTab = null;
     });
 
+    // The last response (and its ETag) of each of the endpoints polled,
+    // keyed by URL, so that unchanged responses need not be sent again.
+    var responses = {};
+
+    // Fetches the endpoint with a conditional request, i.e., returns a
+    // promise for the body of the last response if the endpoint
+    // responds with '304 Not Modified'.
+    var fetch = function(url, params) {
+      var key = url + '?' + JSON.stringify(params);
+      var headers = {};
+
+      if (key in responses) {
+        headers['If-None-Match'] = responses[key].etag;
+      }
+
+      return $http.get(url, {
+          params: params,
+          headers: headers,
+          transformResponse: function(data) { return data; }
+        })
+        .then(function(response) {
+          var etag = response.headers('ETag');
+          if (etag) {
+            responses[key] = {etag: etag, data: response.data};
+          }
+          return response.data;
+        }, function(response) {
+          if (response.status === 304 && key in responses) {
+            return responses[key].data;
+          }
+          return $q.reject(response);
+        });
+    };
+
+    // The details of the state needed by the current view (if any), see
+    // 'requireDetails' below.
+    var details = null;
+    var summary = null;
+
+    // Lets a view request the details of the state (e.g., the tasks) it
+    // shows, which are then polled along with the summary of the state
+    // for as long as the view is shown. The 'url' is either
+    // 'master/state.json' or 'master/tasks.json', optionally filtered by
+    // 'params' (e.g., by a 'framework_id').
+    $scope.requireDetails = function(url, params) {
+      details = {url: url, params: params || {}};
+
+      // Fetch the details right away rather than on the next poll.
+      if (summary !== null) {
+        fetch(details.url, details.params)
+          .then(function(data) {
+            update($scope, $timeout, summary, data);
+          });
+      }
+    };
+
+    // The details are only polled while the view that needs them is shown.
+    $scope.$on('$routeChangeStart', function() {
+      details = null;
+    });
+
     var poll = function() {
-      $http.get('master/state.json',
-                {transformResponse: function(data) { return data; }})
-        .success(function(data) {
-          if (update($scope, $timeout, data)) {
+      fetch('master/state-summary', {})
+        .then(function(data) {
+          summary = data;
+          return details !== null ? fetch(details.url, details.params) : null;
+        })
+        .then(function(data) {
+          if (update($scope, $timeout, summary, data)) {
             $scope.delay = updateInterval(_.size($scope.slaves));
             $timeout(poll, $scope.delay);
           }
-        })
-        .error(function() {
+        }, function() {
           if ($scope.delay >= 128000) {
             $scope.delay = 2000;
           } else {
@@ -339,6 +462,10 @@
 
 
   mesosApp.controller('HomeCtrl', function($dialog, $scope) {
+    // Only the most recent tasks are shown rather than fetching the whole
+    // state of the master for them.
+    $scope.requireDetails('master/tasks.json', {limit: HOME_TASKS_LIMIT});
+
     $scope.log = function($event) {
       if (!$scope.state.external_log_file && !$scope.state.log_dir) {
         $dialog.messageBox(
@@ -355,11 +482,18 @@
     };
   });
 
-  mesosApp.controller('FrameworksCtrl', function() {});
+  mesosApp.controller('FrameworksCtrl', function($scope) {
+    $scope.requireDetails('master/state.json');
+  });
 
-  mesosApp.controller('OffersCtrl', function() {});
+  mesosApp.controller('OffersCtrl', function($scope) {
+    $scope.requireDetails('master/state.json');
+  });
 
   mesosApp.controller('FrameworkCtrl', function($scope, $routeParams) {
+    $scope.requireDetails(
+        'master/state.json', {framework_id: $routeParams.id});
+
     var update = function() {
       if ($routeParams.id in $scope.completed_frameworks) {
         $scope.framework = $scope.completed_frameworks[$routeParams.id];
@@ -368,6 +502,7 @@
         $('#framework').show();
       } else if ($routeParams.id in $scope.frameworks) {
         $scope.framework = $scope.frameworks[$routeParams.id];
+        $('#alert').hide();
         $('#framework').show();
       } else {
         $scope.alert_message = 'No framework found with ID: ' + $routeParams.id;
@@ -85,7 +85,8 @@ GroupProcess::GroupProcess(
     watcher(NULL),
     zk(NULL),
     state(DISCONNECTED),
-    retrying(false)
+    retrying(false),
+    refreshing(false)
 {}
 
 
@@ -105,7 +106,8 @@ GroupProcess::GroupProcess(
     watcher(NULL),
     zk(NULL),
     state(DISCONNECTED),
-    retrying(false)
+    retrying(false),
+    refreshing(false)
 {}
 
 
@@ -214,6 +216,8 @@ Future<Option<string> > GroupProcess::data(const Group::Membership& membership)
 {
   if (error.isSome()) {
     return Failure(error.get());
+  } else if (datas.contains(membership.id())) {
+    return Some(datas[membership.id()]);
   } else if (state != READY) {
     Data* data = new Data(membership);
     pending.datas.push(data);
@@ -282,6 +286,9 @@ Future<set<Group::Membership> > GroupProcess::watch(
 
   CHECK_SOME(memberships);
 
+  // The memberships might have just been re-cached above.
+  update();
+
   if (memberships.get() == expected) { // Just wait for updates.
     Watch* watch = new Watch(expected);
     pending.watches.push(watch);
@@ -494,6 +501,7 @@ void GroupProcess::expired(int64_t sessionId)
   // Invalidate the cache so that we'll sync with ZK after
   // reconnection.
   memberships = None();
+  datas.clear();
 
   // Set all owned memberships as cancelled.
   foreachpair (int32_t sequence, Promise<bool>* cancelled, utils::copy(owned)) {
@@ -528,6 +536,24 @@ void GroupProcess::updated(int64_t sessionId, const string& path)
 
   CHECK_EQ(znode, path);
 
+  // Rather than doing a roll call for each event we coalesce the
+  // events that arrive before the roll call is done (e.g., when many
+  // memberships change at once during a failover).
+  if (!refreshing) {
+    refreshing = true;
+    dispatch(self(), &GroupProcess::refresh, sessionId);
+  }
+}
+
+
+void GroupProcess::refresh(int64_t sessionId)
+{
+  refreshing = false;
+
+  if (error.isSome() || sessionId != zk->getSessionId()) {
+    return;
+  }
+
   Try<bool> cached = cache(); // Update cache (will invalidate first).
 
   if (cached.isError()) {
@@ -606,6 +632,8 @@ Result<Group::Membership> GroupProcess::doJoin(
   Promise<bool>* cancelled = new Promise<bool>();
   owned[sequence.get()] = cancelled;
 
+  datas[sequence.get()] = data;
+
   return Group::Membership(sequence.get(), label, cancelled->future());
 }
 
@@ -645,6 +673,8 @@ Result<bool> GroupProcess::doCancel(const Group::Membership& membership)
   owned.erase(membership.id());
   delete cancelled;
 
+  datas.erase(membership.id());
+
   return true;
 }
 
@@ -654,6 +684,10 @@ Result<Option<string> > GroupProcess::doData(
 {
   CHECK_EQ(state, READY);
 
+  if (datas.contains(membership.id())) {
+    return Some(datas[membership.id()]);
+  }
+
   string path = path::join(znode, zkBasename(membership));
 
   LOG(INFO) << "Trying to get '" << path << "' in ZooKeeper";
@@ -674,6 +708,8 @@ Result<Option<string> > GroupProcess::doData(
         "' in ZooKeeper: " + zk->message(code));
   }
 
+  datas[membership.id()] = result;
+
   return Some(result);
 }
 
@@ -722,6 +758,13 @@ Try<bool> GroupProcess::cache()
     sequences[sequence.get()] = label;
   }
 
+  // Drop the data of the memberships that are gone.
+  foreach (int32_t sequence, datas.keys()) {
+    if (!sequences.contains(sequence)) {
+      datas.erase(sequence);
+    }
+  }
+
   // Cache current memberships, cancelling those that are now missing.
   set<Group::Membership> current;
 
@@ -11,6 +11,7 @@
 
 #include <stout/check.hpp>
 #include <stout/duration.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/try.hpp>
@@ -192,6 +193,9 @@ public:
   void deleted(int64_t sessionId, const std::string& path);
 
 private:
+  // Re-caches the memberships after one or more 'updated' events.
+  void refresh(int64_t sessionId);
+
   Result<Group::Membership> doJoin(
       const std::string& data,
       const Option<std::string>& label);
@@ -322,6 +326,17 @@ private:
   // cache and 'Some' represents a valid cache.
   Option<std::set<Group::Membership> > memberships;
 
+  // Cache of the data of memberships, keyed by sequence number. The
+  // data of a membership is written once when it joins and sequence
+  // numbers are never reused, so an entry stays valid until the
+  // membership is gone (i.e., until a roll call no longer finds it).
+  // The cache is dropped when the session expires.
+  hashmap<int32_t, std::string> datas;
+
+  // Indicates there is a pending 'refresh', in which case subsequent
+  // 'updated' events are coalesced into it.
+  bool refreshing;
+
   // The timer that determines whether we should quit waiting for the
   // connection to be restored.
   Option<process::Timer> timer;
@@ -357,6 +357,25 @@ public:
     return future;
   }
 
+  Future<int> multi(int count, const zoo_op_t* ops, zoo_op_result_t* results)
+  {
+    Promise<int>* promise = new Promise<int>();
+
+    Future<int> future = promise->future();
+
+    tuple<Promise<int>*>* args = new tuple<Promise<int>*>(promise);
+
+    int ret = zoo_amulti(zh, count, ops, results, voidCompletion, args);
+
+    if (ret != ZOK) {
+      delete promise;
+      delete args;
+      return ret;
+    }
+
+    return future;
+  }
+
   Future<int> set(const string& path, const string& data, int version)
   {
     Promise<int>* promise = new Promise<int>();
@@ -643,6 +662,47 @@ int ZooKeeper::set(const string& path, const string& data, int version)
 }
 
 
+vector<int> ZooKeeper::get(
+    const vector<string>& paths,
+    vector<string>* results,
+    vector<Stat>* stats)
+{
+  results->assign(paths.size(), string());
+  stats->assign(paths.size(), Stat());
+
+  // Dispatch all of the gets before waiting for any of them so that
+  // the requests are pipelined.
+  vector<Future<int> > futures;
+  for (size_t i = 0; i < paths.size(); i++) {
+    futures.push_back(dispatch(
+        process,
+        &ZooKeeperProcess::get,
+        paths[i],
+        false,
+        &(*results)[i],
+        &(*stats)[i]));
+  }
+
+  vector<int> codes;
+  foreach (const Future<int>& future, futures) {
+    codes.push_back(future.get());
+  }
+
+  return codes;
+}
+
+
+int ZooKeeper::multi(int count, const zoo_op_t* ops, zoo_op_result_t* results)
+{
+  return dispatch(
+      process,
+      &ZooKeeperProcess::multi,
+      count,
+      ops,
+      results).get();
+}
+
+
 string ZooKeeper::message(int code) const
 {
   return string(zerror(code));
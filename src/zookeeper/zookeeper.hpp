@@ -304,6 +304,44 @@ public:
    */
   int set(const std::string& path, const std::string& data, int version);
 
+  /**
+   * \brief gets the data associated with several nodes at once.
+   *
+   * The requests are all sent before waiting for any response, so
+   * getting the data of many nodes takes about one round trip rather
+   * than one per node. No watches are set.
+   *
+   * \param paths the names of the nodes.
+   * \param results the data returned by the server for each path.
+   * \param stats the stat returned by the server for each path.
+   * \return the return code for each path (see get above).
+   */
+  std::vector<int> get(
+      const std::vector<std::string>& paths,
+      std::vector<std::string>* results,
+      std::vector<Stat>* stats);
+
+  /**
+   * \brief atomically performs a set of operations.
+   *
+   * Either all of the operations (initialized with zoo_create_op_init,
+   * zoo_delete_op_init, zoo_set_op_init or zoo_check_op_init) succeed
+   * or none of them does. Note that the size of the whole request is
+   * subject to the same limit (1 MB by default) as a single node.
+   *
+   * \param count the number of operations.
+   * \param ops the operations.
+   * \param results the result of each operation, which tells which
+   *   operation failed (if any).
+   * \return the return code for the function call, i.e., the code of
+   *   the first operation that failed, if any.
+   * ZOK operation completed succesfully
+   * ZBADARGUMENTS - invalid input parameters
+   * ZINVALIDSTATE - zhandle state is either ZOO_SESSION_EXPIRED_STATE or ZOO_AUTH_FAILED_STATE
+   * ZMARSHALLINGERROR - failed to marshall a request; possibly, out of memory
+   */
+  int multi(int count, const zoo_op_t* ops, zoo_op_result_t* results);
+
   /**
    * \brief return a message describing the return code.
    *